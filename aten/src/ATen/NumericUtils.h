@@ -1,3 +1,6 @@
+#include <c10/util/BFloat16.h>
+#include <c10/util/Half.h>
+
 #include <cmath>
 #include <type_traits>
 
@@ -19,4 +22,12 @@ inline bool _isnan(T val) {
   return std::isnan(val);
 }
 
+inline bool _isnan(at::Half val) {
+  return std::isnan(static_cast<float>(val));
+}
+
+inline bool _isnan(at::BFloat16 val) {
+  return std::isnan(static_cast<float>(val));
+}
+
 } // namespace at
@@ -2,9 +2,20 @@
 
 #include <ATen/Config.h>
 #include <ATen/Version.h>
+#include <c10/core/thread_budget.h>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #ifdef TH_BLAS_MKL
 #include <mkl.h>
@@ -13,62 +24,97 @@
 namespace at {
 
 namespace {
-// Number of threads set by the user
-std::atomic<int> num_threads(-1);
+const char* get_env_var(const char* var_name) {
+  const char* value = std::getenv(var_name);
+  return value ? value : "[not set]";
+}
 }
 
-void init_num_threads() {
-  auto nthreads = num_threads.load();
-  if (nthreads > 0) {
-    set_num_threads(nthreads);
-  } else {
-#if defined(_OPENMP) && defined(TH_BLAS_MKL)
-  // If we are using MKL an OpenMP make sure the number of threads match.
-  // Otherwise, MKL and our OpenMP-enabled functions will keep changing the
-  // size of the OpenMP thread pool, resulting in worse performance (and memory
-  // leaks in GCC 5.4)
-  omp_set_num_threads(mkl_get_max_threads());
-#endif
-  }
+namespace {
+constexpr int kNumLoopCosts = static_cast<int>(LoopCost::VeryExpensive) + 1;
+
+// How many times more time an element of each cost class takes than an
+// element of a cheap loop, with internal::GRAIN_SIZE for the default class
+constexpr int64_t kRelativeCost[kNumLoopCosts] = {1, 2, 32, 128};
+constexpr int64_t kMinGrainSize = 64;
+
+std::atomic<int64_t>* grain_sizes() {
+  static std::atomic<int64_t> sizes[kNumLoopCosts];
+  static bool initialized = [] {
+    for (int i = 0; i < kNumLoopCosts; ++i) {
+      sizes[i] = 2 * internal::GRAIN_SIZE / kRelativeCost[i];
+    }
+    return true;
+  }();
+  (void)initialized;
+  return sizes;
 }
 
-void set_num_threads(size_t nthreads) {
-  if (nthreads == 0) {
-    return;
+void set_grain_sizes(int64_t cheap_grain_size) {
+  for (int i = 0; i < kNumLoopCosts; ++i) {
+    grain_sizes()[i] =
+        std::max(cheap_grain_size / kRelativeCost[i], kMinGrainSize);
   }
-  num_threads.store(nthreads);
-#ifdef _OPENMP
-  omp_set_num_threads(nthreads);
-#endif
-#ifdef TH_BLAS_MKL
-  mkl_set_num_threads(nthreads);
-
-  // because PyTorch uses OpenMP outside of MKL invocations
-  // as well, we want this flag to be false, so that
-  // threads aren't destroyed and recreated across every
-  // MKL / non-MKL boundary of OpenMP usage
-  // See https://github.com/pytorch/pytorch/issues/13757
-  mkl_set_dynamic(false);
-#endif
 }
 
-// Explicitly calling omp_get_max_threads() as the size of the parallel
-// region might be different in the new thread;
-// Use init_num_threads() during thread initialization to ensure
-// consistent size of parallel region in different threads
-size_t get_num_threads() {
-#ifdef _OPENMP
-  return omp_get_max_threads();
-#else
-  return 1;
-#endif
+double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(
+             std::chrono::steady_clock::now() - start)
+      .count();
 }
+} // namespace
 
-namespace {
-const char* get_env_var(const char* var_name) {
-  const char* value = std::getenv(var_name);
-  return value ? value : "[not set]";
+int64_t grain_size(LoopCost cost) {
+  static std::once_flag calibrated;
+  std::call_once(calibrated, [] {
+    if (std::getenv("ATEN_CALIBRATE_GRAIN_SIZE")) {
+      calibrate_grain_sizes();
+    }
+  });
+  return grain_sizes()[static_cast<int>(cost)].load(std::memory_order_relaxed);
 }
+
+void set_grain_size(LoopCost cost, int64_t grain_size) {
+  AT_CHECK(grain_size > 0, "grain size must be positive, got ", grain_size);
+  grain_sizes()[static_cast<int>(cost)] = grain_size;
+}
+
+void calibrate_grain_sizes() {
+  const int64_t num_threads = get_num_threads();
+  if (num_threads == 1 || in_parallel_region()) {
+    return;
+  }
+
+  // the cost of handing one element to every thread
+  constexpr int kRegions = 64;
+  at::parallel_for(0, num_threads, 1, [](int64_t, int64_t) {});
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRegions; ++i) {
+    at::parallel_for(0, num_threads, 1, [](int64_t, int64_t) {});
+  }
+  const double region_time = seconds_since(start) / kRegions;
+
+  // the time of an element of a cheap loop, over a range that fits in cache
+  constexpr int64_t kElements = 1 << 14;
+  constexpr int kRepeats = 64;
+  std::vector<float> data(kElements, 1.f);
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < kRepeats; ++r) {
+    float* ptr = data.data();
+    for (int64_t i = 0; i < kElements; ++i) {
+      ptr[i] = ptr[i] * 0.5f + 1.f;
+    }
+  }
+  const double element_time =
+      seconds_since(start) / (kElements * kRepeats) + 1e-12;
+  volatile float sink = data[kElements - 1];
+  (void)sink;
+
+  // A chunk takes ten times longer than it takes to hand it to a thread
+  const auto cheap_grain_size = static_cast<int64_t>(
+      10 * region_time / element_time);
+  set_grain_sizes(std::min(
+      std::max(cheap_grain_size, int64_t(1) << 10), int64_t(1) << 20));
 }
 
 std::string get_parallel_info() {
@@ -76,6 +122,13 @@ std::string get_parallel_info() {
 
   ss << "ATen/Parallel:\n\tat::get_num_threads() : "
      << at::get_num_threads() << std::endl;
+#if AT_PARALLEL_OPENMP
+  ss << "\tATen parallel backend: OpenMP" << std::endl;
+#elif AT_PARALLEL_NATIVE
+  ss << "\tATen parallel backend: native thread pool" << std::endl;
+#endif
+
+  ss << "\t" << c10::ThreadBudget::get().summary() << std::endl;
 
   ss << at::get_openmp_version() << std::endl;
 #ifdef _OPENMP
@@ -89,12 +142,19 @@ std::string get_parallel_info() {
 
   ss << at::get_mkldnn_version() << std::endl;
 
+  ss << "Grain sizes (cheap, default, expensive, very expensive) : "
+     << grain_size(LoopCost::Cheap) << ", " << grain_size(LoopCost::Default)
+     << ", " << grain_size(LoopCost::Expensive) << ", "
+     << grain_size(LoopCost::VeryExpensive) << std::endl;
+
   ss << "std::thread::hardware_concurrency() : "
      << std::thread::hardware_concurrency() << std::endl;
 
   ss << "Environment variables:" << std::endl;
   ss << "\tOMP_NUM_THREADS : " << get_env_var("OMP_NUM_THREADS") << std::endl;
   ss << "\tMKL_NUM_THREADS : " << get_env_var("MKL_NUM_THREADS") << std::endl;
+  ss << "\tATEN_CALIBRATE_GRAIN_SIZE : "
+     << get_env_var("ATEN_CALIBRATE_GRAIN_SIZE") << std::endl;
 
   return ss.str();
 }
@@ -106,17 +166,48 @@ PTThreadPool::PTThreadPool(
 
 void PTThreadPool::init_thread() {
   c10::setThreadName("PTThreadPool");
+  c10::ThreadBudget::get().bindNextWorker(c10::ThreadPoolKind::InterOp);
   at::init_num_threads();
 }
 
+InterOpStats get_inter_op_stats() {
+  InterOpStats stats;
+  auto& pool = c10::global_work_queue();
+  stats.num_threads = pool.size();
+  stats.num_idle = pool.numAvailable();
+  if (auto ws_pool = dynamic_cast<c10::WorkStealingThreadPool*>(&pool)) {
+    stats.num_queued = ws_pool->numPending();
+    stats.max_queued = ws_pool->maxPending();
+    stats.num_steals = ws_pool->numSteals();
+  }
+  return stats;
+}
+
+void set_thread_budget(size_t total_threads, int numa_node_id) {
+  auto& budget = c10::ThreadBudget::get();
+  budget.setTotalThreads(total_threads);
+  budget.setNUMANode(numa_node_id);
+  init_num_threads();
+}
+
 namespace {
 
 std::shared_ptr<TaskThreadPoolBase> createC10ThreadPool(
     int device_id,
     int pool_size,
     bool create_new) {
+  // Work stealing rather than a single shared queue: forks and their
+  // continuations are pushed onto the deque of the worker that made them,
+  // so they don't all contend on one lock and a waiting continuation tends
+  // to resume on the worker that completed its future.
   static std::shared_ptr<TaskThreadPoolBase> pool =
-      std::make_shared<PTThreadPool>(pool_size);
+      std::make_shared<c10::WorkStealingThreadPool>(
+          pool_size, /*numa_node_id=*/-1, []() {
+            c10::setThreadName("PTThreadPool");
+            c10::ThreadBudget::get().bindNextWorker(
+                c10::ThreadPoolKind::InterOp);
+            at::init_num_threads();
+          });
   // For now, the only accepted device id is 0
   // for the JIT inter-op pool (CPU),
   AT_ASSERT(device_id == 0);
@@ -1,16 +1,9 @@
 #pragma once
 #include <ATen/ATen.h>
+#include <ATen/Config.h>
 #include <c10/core/thread_pool.h>
 
-#include <atomic>
 #include <cstddef>
-#include <exception>
-
-#ifdef _OPENMP
-#define INTRA_OP_PARALLEL
-
-#include <omp.h>
-#endif
 
 namespace at {
 namespace internal {
@@ -22,6 +15,33 @@ namespace internal {
 constexpr int64_t GRAIN_SIZE = 32768;
 } // namespace internal
 
+// How much work a loop does per element, from which its grain size is
+// chosen. Cheap loops (add, mul, abs, ...) are bound by memory bandwidth and
+// only win from extra threads on large inputs, while transcendental
+// functions (exp, erf, tan, ...) amortize the cost of a parallel region
+// over far fewer elements.
+enum class LoopCost {
+  Cheap,         // a few instructions per element, e.g. add, neg
+  Default,       // e.g. a division or a comparison, internal::GRAIN_SIZE
+  Expensive,     // a vectorized transcendental function, e.g. exp, sigmoid
+  VeryExpensive, // e.g. erf, tan or an unvectorized libm call
+};
+
+// Returns the grain size parallel loops of the given cost should use.
+// The defaults scale internal::GRAIN_SIZE by the cost class. When the
+// ATEN_CALIBRATE_GRAIN_SIZE environment variable is set, they are measured
+// on first use instead, see calibrate_grain_sizes().
+CAFFE2_API int64_t grain_size(LoopCost cost);
+
+// Overrides the grain size of loops of the given cost.
+CAFFE2_API void set_grain_size(LoopCost cost, int64_t grain_size);
+
+// Chooses the grain sizes from the overhead of a parallel region on this
+// machine, measured against the time of a cheap loop, so that a chunk does
+// about ten times more work than it costs to hand it to a thread. Has to be
+// called outside of a parallel region, e.g. at startup.
+CAFFE2_API void calibrate_grain_sizes();
+
 inline int64_t divup(int64_t x, int64_t y) {
   return (x + y - 1) / y;
 }
@@ -37,56 +57,29 @@ CAFFE2_API size_t get_num_threads();
 
 // Returns the current thread number (starting from 0)
 // in the current parallel region, or 0 in the sequential region
-inline int get_thread_num() {
-#ifdef _OPENMP
-  return omp_get_thread_num();
-#else
-  return 0;
-#endif
-}
+CAFFE2_API int get_thread_num();
 
-inline bool in_parallel_region() {
-#ifdef _OPENMP
-  return omp_in_parallel();
-#else
-  return false;
-#endif
-}
+// Checks whether the code runs in parallel region
+CAFFE2_API bool in_parallel_region();
+
+/*
+parallel_for
 
+begin: index at which to start applying user function
+
+end: index at which to stop applying user function
+
+grain_size: number of elements per chunk. impacts the degree of parallelization
+
+f: user function applied in parallel to the chunks, signature:
+  void f(int64_t begin, int64_t end)
+*/
 template <class F>
 inline void parallel_for(
     const int64_t begin,
     const int64_t end,
     const int64_t grain_size,
-    const F& f) {
-#ifdef _OPENMP
-  std::atomic_flag err_flag = ATOMIC_FLAG_INIT;
-  std::exception_ptr eptr;
-#pragma omp parallel if (!omp_in_parallel() && ((end - begin) >= grain_size))
-  {
-    int64_t num_threads = omp_get_num_threads();
-    int64_t tid = omp_get_thread_num();
-    int64_t chunk_size = divup((end - begin), num_threads);
-    int64_t begin_tid = begin + tid * chunk_size;
-    if (begin_tid < end) {
-      try {
-        f(begin_tid, std::min(end, chunk_size + begin_tid));
-      } catch (...) {
-        if (!err_flag.test_and_set()) {
-          eptr = std::current_exception();
-        }
-      }
-    }
-  }
-  if (eptr) {
-    std::rethrow_exception(eptr);
-  }
-#else
-  if (begin < end) {
-    f(begin, end);
-  }
-#endif
-}
+    const F& f);
 
 /*
 parallel_reduce
@@ -128,26 +121,34 @@ inline scalar_t parallel_reduce(
     const int64_t grain_size,
     const scalar_t ident,
     const F f,
-    const SF sf) {
-  if (in_parallel_region() || get_num_threads() == 1) {
-    return f(begin, end, ident);
-  } else {
-    const int64_t num_results = divup((end - begin), grain_size);
-    std::vector<scalar_t> results(num_results);
-    scalar_t* results_data = results.data();
-#pragma omp parallel for if ((end - begin) >= grain_size)
-    for (int64_t id = 0; id < num_results; id++) {
-      int64_t i = begin + id * grain_size;
-      results_data[id] = f(i, i + std::min(end - i, grain_size), ident);
-    }
-    return std::accumulate(
-        results_data, results_data + results.size(), ident, sf);
-  }
-}
+    const SF sf);
+
+// Sets a process-wide budget of total_threads threads shared by the
+// intra-op, inter-op and Caffe2 thread pools, optionally binding all their
+// workers to one NUMA node (see c10/core/thread_budget.h), and applies the
+// intra-op share to the calling thread. Has to be called before any
+// parallel work is started.
+CAFFE2_API void set_thread_budget(size_t total_threads, int numa_node_id = -1);
 
 // Returns a detailed string describing parallelization settings
 CAFFE2_API std::string get_parallel_info();
 
+// Counters of the inter-op thread pool (c10::global_work_queue()), which
+// runs TorchScript forks and the continuations that wait on them. Queue
+// and steal counts are only kept by the default work-stealing pool.
+struct InterOpStats {
+  size_t num_threads = 0;
+  size_t num_idle = 0;
+  // tasks queued but not started, and the most seen at once
+  size_t num_queued = 0;
+  size_t max_queued = 0;
+  // tasks taken by a worker from another worker's deque
+  size_t num_steals = 0;
+};
+
+// Starts the inter-op pool if it isn't running yet.
+CAFFE2_API InterOpStats get_inter_op_stats();
+
 class CAFFE2_API PTThreadPool : public c10::ThreadPool {
  public:
   explicit PTThreadPool(
@@ -158,3 +159,9 @@ class CAFFE2_API PTThreadPool : public c10::ThreadPool {
 };
 
 } // namespace at
+
+#if AT_PARALLEL_OPENMP
+#include <ATen/ParallelOpenMP.h>
+#elif AT_PARALLEL_NATIVE
+#include <ATen/ParallelNative.h>
+#endif
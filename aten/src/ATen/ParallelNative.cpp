@@ -0,0 +1,226 @@
+#include <ATen/Config.h>
+#if AT_PARALLEL_NATIVE
+#include <ATen/Parallel.h>
+#include <c10/core/thread_budget.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef TH_BLAS_MKL
+#include <mkl.h>
+#endif
+
+namespace at {
+
+namespace {
+// Number of threads set by the user
+std::atomic<int> num_threads(-1);
+
+// Whether the intra-op pool has been created; its size is fixed from then on
+std::atomic<bool> pool_started(false);
+
+// Number of chunks handed out per participating thread. Several chunks per
+// thread let the threads that finish early take over the tail of a skewed
+// loop, while keeping each chunk at least grain_size elements.
+constexpr int64_t kChunksPerThread = 4;
+
+thread_local bool in_parallel_region_ = false;
+thread_local int thread_num_ = 0;
+
+size_t default_num_threads() {
+  return c10::ThreadBudget::get().numThreads(
+      c10::ThreadPoolKind::IntraOp,
+      std::max<size_t>(std::thread::hardware_concurrency(), 1));
+}
+
+// Marks the current thread as running chunk work for the given thread id
+struct ParallelRegionGuard {
+  explicit ParallelRegionGuard(int thread_num)
+      : prev_in_parallel_region_(in_parallel_region_),
+        prev_thread_num_(thread_num_) {
+    in_parallel_region_ = true;
+    thread_num_ = thread_num;
+  }
+
+  ~ParallelRegionGuard() {
+    in_parallel_region_ = prev_in_parallel_region_;
+    thread_num_ = prev_thread_num_;
+  }
+
+ private:
+  bool prev_in_parallel_region_;
+  int prev_thread_num_;
+};
+
+// Worker 0 of the intra-op budget is the thread calling parallel_for
+std::atomic<size_t> next_intraop_worker(1);
+
+void init_intraop_thread() {
+  c10::setThreadName("IntraOpPool");
+  c10::ThreadBudget::get().bindWorker(
+      c10::ThreadPoolKind::IntraOp, next_intraop_worker++);
+#ifdef _OPENMP
+  // OpenMP regions entered from a chunk (e.g. inside MKL) would
+  // oversubscribe the cores that are already owned by this pool.
+  omp_set_num_threads(1);
+#endif
+}
+
+// The calling thread always participates, so the pool holds one thread
+// fewer than the requested parallelism.
+size_t initial_pool_size() {
+  pool_started = true;
+  return get_num_threads() - 1;
+}
+
+c10::WorkStealingThreadPool& intraop_pool() {
+  static c10::WorkStealingThreadPool pool(
+      initial_pool_size(), -1, init_intraop_thread);
+  return pool;
+}
+
+// Shared between the calling thread and the helper tasks. Helpers may only
+// get scheduled after the loop has been drained and the caller has returned,
+// so they hold the state by shared_ptr and only touch fn while a chunk they
+// claimed is outstanding.
+struct ParallelState {
+  ParallelState(
+      int64_t begin,
+      int64_t end,
+      int64_t chunk_size,
+      const std::function<void(int64_t, int64_t)>* fn)
+      : begin(begin),
+        end(end),
+        chunk_size(chunk_size),
+        num_chunks(divup(end - begin, chunk_size)),
+        fn(fn),
+        next_chunk(0),
+        remaining(num_chunks) {}
+
+  const int64_t begin;
+  const int64_t end;
+  const int64_t chunk_size;
+  const int64_t num_chunks;
+  const std::function<void(int64_t, int64_t)>* fn;
+
+  std::atomic<int64_t> next_chunk;
+  std::atomic<int64_t> remaining;
+  std::mutex mutex;
+  std::condition_variable done;
+
+  std::atomic_flag err_flag = ATOMIC_FLAG_INIT;
+  std::atomic<bool> failed{false};
+  std::exception_ptr eptr;
+};
+
+void run_chunks(const std::shared_ptr<ParallelState>& state, int thread_num) {
+  ParallelRegionGuard guard(thread_num);
+  for (;;) {
+    int64_t chunk = state->next_chunk.fetch_add(1);
+    if (chunk >= state->num_chunks) {
+      return;
+    }
+    // Once a chunk has failed the remaining ones are only accounted for.
+    if (!state->failed) {
+      int64_t chunk_begin = state->begin + chunk * state->chunk_size;
+      int64_t chunk_end = std::min(state->end, chunk_begin + state->chunk_size);
+      try {
+        (*state->fn)(chunk_begin, chunk_end);
+      } catch (...) {
+        if (!state->err_flag.test_and_set()) {
+          state->eptr = std::current_exception();
+          state->failed = true;
+        }
+      }
+    }
+    if (--state->remaining == 0) {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->done.notify_all();
+    }
+  }
+}
+
+} // namespace
+
+namespace internal {
+
+void _parallel_run(
+    const int64_t begin,
+    const int64_t end,
+    const int64_t grain_size,
+    const std::function<void(int64_t, int64_t)>& f) {
+  auto& pool = intraop_pool();
+  const int64_t range = end - begin;
+  int64_t nthreads = std::min<int64_t>(get_num_threads(), pool.size() + 1);
+  const int64_t chunk_size = std::max<int64_t>(
+      std::max<int64_t>(grain_size, 1),
+      divup(range, nthreads * kChunksPerThread));
+  auto state = std::make_shared<ParallelState>(begin, end, chunk_size, &f);
+  nthreads = std::min(nthreads, state->num_chunks);
+
+  for (int thread_num = 1; thread_num < nthreads; ++thread_num) {
+    pool.run([state, thread_num]() { run_chunks(state, thread_num); });
+  }
+  run_chunks(state, 0);
+
+  {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&state]() { return state->remaining == 0; });
+  }
+  if (state->eptr) {
+    std::rethrow_exception(state->eptr);
+  }
+}
+
+} // namespace internal
+
+void init_num_threads() {
+#ifdef _OPENMP
+  // The intra-op pool replaces the OpenMP team; keep OpenMP regions in
+  // third-party code from spawning a second set of workers.
+  omp_set_num_threads(1);
+#endif
+}
+
+void set_num_threads(size_t nthreads) {
+  if (nthreads == 0) {
+    return;
+  }
+  AT_CHECK(
+      !pool_started || nthreads <= intraop_pool().size() + 1,
+      "Cannot raise the number of threads to ", nthreads,
+      " after parallel work has started with the native parallel backend "
+      "(pool size is ", intraop_pool().size() + 1, ")");
+  num_threads.store(nthreads);
+  c10::ThreadBudget::get().setNumThreads(
+      c10::ThreadPoolKind::IntraOp, nthreads);
+#ifdef TH_BLAS_MKL
+  mkl_set_num_threads(nthreads);
+  mkl_set_dynamic(false);
+#endif
+}
+
+size_t get_num_threads() {
+  auto nthreads = num_threads.load();
+  return nthreads > 0 ? nthreads : default_num_threads();
+}
+
+int get_thread_num() {
+  return thread_num_;
+}
+
+bool in_parallel_region() {
+  return in_parallel_region_;
+}
+
+} // namespace at
+#endif
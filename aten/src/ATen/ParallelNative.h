@@ -0,0 +1,69 @@
+#pragma once
+#include <ATen/ATen.h>
+
+#include <cstddef>
+#include <functional>
+#include <numeric>
+
+namespace at {
+namespace internal {
+
+// Runs f over [begin, end) on the intra-op work-stealing pool. The range is
+// cut into at least grain_size-sized chunks which the calling thread and the
+// pool workers claim dynamically, so a slow chunk does not hold up the
+// others. The first exception thrown by f is rethrown on the calling thread.
+CAFFE2_API void _parallel_run(
+    const int64_t begin,
+    const int64_t end,
+    const int64_t grain_size,
+    const std::function<void(int64_t, int64_t)>& f);
+
+} // namespace internal
+
+template <class F>
+inline void parallel_for(
+    const int64_t begin,
+    const int64_t end,
+    const int64_t grain_size,
+    const F& f) {
+  if (begin >= end) {
+    return;
+  }
+  if ((end - begin) < grain_size || get_num_threads() == 1 ||
+      in_parallel_region()) {
+    f(begin, end);
+    return;
+  }
+  internal::_parallel_run(
+      begin, end, grain_size, [&f](int64_t chunk_begin, int64_t chunk_end) {
+        f(chunk_begin, chunk_end);
+      });
+}
+
+template <class scalar_t, class F, class SF>
+inline scalar_t parallel_reduce(
+    const int64_t begin,
+    const int64_t end,
+    const int64_t grain_size,
+    const scalar_t ident,
+    const F f,
+    const SF sf) {
+  if ((end - begin) < grain_size || get_num_threads() == 1 ||
+      in_parallel_region()) {
+    return f(begin, end, ident);
+  }
+  const int64_t num_results = divup((end - begin), grain_size);
+  std::vector<scalar_t> results(num_results);
+  scalar_t* results_data = results.data();
+  internal::_parallel_run(
+      0, num_results, 1, [&](int64_t first_result, int64_t last_result) {
+        for (int64_t id = first_result; id < last_result; id++) {
+          int64_t i = begin + id * grain_size;
+          results_data[id] = f(i, i + std::min(end - i, grain_size), ident);
+        }
+      });
+  return std::accumulate(
+      results_data, results_data + results.size(), ident, sf);
+}
+
+} // namespace at
@@ -0,0 +1,77 @@
+#pragma once
+
+// Philox4x32-10, the counter-based random number generator of "Parallel
+// Random Numbers: As Easy as 1, 2, 3" (Salmon et al., SC'11), which curand
+// uses on CUDA.
+//
+// A counter-based generator has no state to advance: the n-th output of the
+// stream of a seed is a function of the seed and n. Random tensors can then
+// be filled in chunks on any number of threads, each chunk starting at the
+// offset of its first element, and get the same values as a serial fill.
+
+#include <array>
+#include <cstdint>
+
+namespace at {
+
+class Philox4x32 {
+ public:
+  using Output = std::array<uint32_t, 4>;
+  using Key = std::array<uint32_t, 2>;
+
+  // The stream of `seed` from its `offset`-th output
+  explicit Philox4x32(uint64_t seed, uint64_t offset = 0)
+      : key_{{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}},
+        counter_{{static_cast<uint32_t>(offset),
+                  static_cast<uint32_t>(offset >> 32),
+                  0,
+                  0}} {}
+
+  // The 4 random words of the current output; moves to the next one.
+  Output operator()() {
+    Output out = apply(counter_, key_);
+    for (auto& word : counter_) {
+      if (++word != 0) {
+        break;
+      }
+    }
+    return out;
+  }
+
+  // The 10 rounds mapping a 128-bit counter to its output
+  static Output apply(Output ctr, Key key) {
+    for (int round = 0; round < 10; round++) {
+      uint64_t p0 = static_cast<uint64_t>(kM0) * ctr[0];
+      uint64_t p1 = static_cast<uint64_t>(kM1) * ctr[2];
+      ctr = {{static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0],
+              static_cast<uint32_t>(p1),
+              static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1],
+              static_cast<uint32_t>(p0)}};
+      key[0] += kW0;
+      key[1] += kW1;
+    }
+    return ctr;
+  }
+
+ private:
+  static constexpr uint32_t kM0 = 0xD2511F53;
+  static constexpr uint32_t kM1 = 0xCD9E8D57;
+  static constexpr uint32_t kW0 = 0x9E3779B9;
+  static constexpr uint32_t kW1 = 0xBB67AE85;
+
+  Key key_;
+  Output counter_;
+};
+
+// Uniform numbers in [0, 1) from random words: a float takes the 24 high bits
+// of a word, a double the 53 high bits of two words.
+inline float philox_uniform_float(uint32_t word) {
+  return (word >> 8) * (1.0f / (1u << 24));
+}
+
+inline double philox_uniform_double(uint32_t hi, uint32_t lo) {
+  uint64_t bits = (static_cast<uint64_t>(hi) << 32 | lo) >> 11;
+  return bits * (1.0 / (static_cast<uint64_t>(1) << 53));
+}
+
+} // namespace at
@@ -30,6 +30,8 @@ _(aten, _argmin) \
 _(aten, _asin) \
 _(aten, _atan) \
 _(aten, _baddbmm_mkl) \
+_(aten, _bitmask_dropout) \
+_(aten, _bitmask_scale) \
 _(aten, _cast_Byte) \
 _(aten, _cast_Char) \
 _(aten, _cast_Double) \
@@ -46,6 +48,10 @@ _(aten, _convolution_nogroup) \
 _(aten, _copy_ignoring_overlaps) \
 _(aten, _cos) \
 _(aten, _cosh) \
+_(aten, _cpu_fft_clear_plan_cache) \
+_(aten, _cpu_fft_get_plan_cache_max_size) \
+_(aten, _cpu_fft_get_plan_cache_size) \
+_(aten, _cpu_fft_set_plan_cache_max_size) \
 _(aten, _ctc_loss) \
 _(aten, _ctc_loss_backward) \
 _(aten, _cudnn_ctc_loss) \
@@ -76,6 +82,8 @@ _(aten, _expm1) \
 _(aten, _fft_with_size) \
 _(aten, _fill) \
 _(aten, _floor) \
+_(aten, _fused_bias_dropout_add) \
+_(aten, _fused_bias_dropout_add_backward) \
 _(aten, _fused_dropout) \
 _(aten, _ger) \
 _(aten, _indexCopy) \
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <ATen/core/function_schema.h>
-#include <c10/util/LeftRight.h>
 #include <c10/util/Metaprogramming.h>
 #include <c10/util/flat_hash_map.h>
 #include <ATen/core/ivalue.h>
@@ -150,8 +149,26 @@ class DispatchTable final {
    * @return Kernel function pointing to the right kernel for the given arguments.
    */
    const DispatchTableEntry& lookup(const Stack* stack) const {
+     return lookup(dispatchKey(stack));
+   }
+
+  /**
+   * Get the dispatch key the given arguments dispatch on. For an operator
+   * without tensor arguments, this is TensorTypeIds::undefined(), which
+   * selects the fallback kernel.
+   */
+   TensorTypeId dispatchKey(const Stack* stack) const {
+     if (C10_LIKELY(dispatch_strategy_.is_valid_)) {
+       return dispatch_strategy_.get_dispatch_key(stack);
+     }
+     return TensorTypeIds::undefined();
+   }
+
+  /**
+   * Find the kernel to call for a dispatch key returned by dispatchKey().
+   */
+   const DispatchTableEntry& lookup(TensorTypeId dispatch_key) const {
      if (C10_LIKELY(dispatch_strategy_.is_valid_)) {
-       TensorTypeId dispatch_key = dispatch_strategy_.get_dispatch_key(stack);
        auto found = kernels_.lookup(dispatch_key);
        if (nullptr != found) {
          return *found;
@@ -173,10 +173,46 @@ private:
   explicit OperatorHandle(std::list<Dispatcher::OperatorDef>::iterator operatorIterator)
   : operatorIterator_(std::move(operatorIterator)) {}
   friend class Dispatcher;
+  friend class CachedOpKernel;
 
   std::list<Dispatcher::OperatorDef>::iterator operatorIterator_;
 };
 
+/**
+ * An OpKernel for a single call site that follows the dispatcher.
+ *
+ * An OpKernel from Dispatcher::lookup() is bound to the kernel it was looked up
+ * for. CachedOpKernel instead looks up the kernel again whenever the dispatch
+ * key of the arguments differs from the previous call, or kernels for the
+ * operator were registered or deregistered in the meantime, and otherwise
+ * calls the cached kernel directly. Checking for the latter only loads the
+ * operator's dispatch table pointer, which is written on (de)registration
+ * only, so calls from many threads don't contend on a shared cache line.
+ *
+ * Like OpKernel, CachedOpKernel is not threadsafe. Use one per call site
+ * and thread.
+ */
+class CAFFE2_API CachedOpKernel final {
+public:
+  explicit CachedOpKernel(OperatorHandle op);
+  CachedOpKernel(CachedOpKernel&&) noexcept = default;
+  CachedOpKernel& operator=(CachedOpKernel&&) noexcept = default;
+  CachedOpKernel(const CachedOpKernel&) = delete;
+  CachedOpKernel& operator=(const CachedOpKernel&) = delete;
+
+  /**
+   * Call the operator kernel for the given arguments.
+   */
+  void call(Stack* stack);
+
+private:
+  OperatorHandle op_;
+  const DispatchTable* dispatchTable_;
+  TensorTypeId dispatchKey_;
+  KernelFunction* kernel_;
+  std::unique_ptr<c10::KernelCache> cache_;
+};
+
 struct CAFFE2_API SchemaRegistrationHandleRAII final {
   const OperatorHandle& opHandle() const {
     return opHandle_;
@@ -197,4 +233,26 @@ inline OpKernel Dispatcher::lookup(const OperatorHandle& op, const Stack* stack)
   return OpKernel(kernel.kernel_func, kernel.cache_creator_func);
 }
 
+inline CachedOpKernel::CachedOpKernel(OperatorHandle op)
+: op_(std::move(op))
+, dispatchTable_(nullptr)
+, dispatchKey_(TensorTypeIds::undefined())
+, kernel_(nullptr)
+, cache_() {}
+
+inline void CachedOpKernel::call(Stack* stack) {
+  const DispatchTable* dispatchTable = op_.operatorIterator_->op.dispatchTable();
+  const TensorTypeId dispatchKey = dispatchTable->dispatchKey(stack);
+  if (C10_UNLIKELY(dispatchTable != dispatchTable_ || dispatchKey != dispatchKey_)) {
+    // Even if the kernel function didn't change, it may have been registered
+    // with a different cache creator, so always start with a new cache.
+    const DispatchTableEntry& kernel = dispatchTable->lookup(dispatchKey);
+    kernel_ = kernel.kernel_func;
+    cache_ = kernel.cache_creator_func();
+    dispatchTable_ = dispatchTable;
+    dispatchKey_ = dispatchKey;
+  }
+  (*kernel_)(stack, cache_.get());
+}
+
 } // namespace c10
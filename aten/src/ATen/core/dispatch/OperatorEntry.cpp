@@ -5,17 +5,19 @@ namespace impl {
 
 OperatorEntry::OperatorEntry(FunctionSchema&& schema)
 : schema_(std::move(schema))
-, dispatchTable_(schema_)
-, kernels_() {}
+, dispatchTable_(nullptr)
+, dispatchTables_()
+, kernels_() {
+  dispatchTables_.push_back(guts::make_unique<DispatchTable>(schema_));
+  dispatchTable_.store(dispatchTables_.back().get(), std::memory_order_release);
+}
 
 void OperatorEntry::prepareForDeregistration() {
-  return dispatchTable_.read([&] (const DispatchTable& dispatchTable) {
-    if (!dispatchTable.isEmpty()) {
-      std::ostringstream str;
-      str << schema_;
-      AT_ERROR("Tried to deregister op schema for an operator that still has kernels registered. The operator schema is ", str.str());
-    }
-  });
+  if (!dispatchTable()->isEmpty()) {
+    std::ostringstream str;
+    str << schema_;
+    AT_ERROR("Tried to deregister op schema for an operator that still has kernels registered. The operator schema is ", str.str());
+  }
   AT_ASSERTM(kernels_.size() == 0, "If the dispatch table is empty, then the invariant says there can't be any kernels");
 }
 
@@ -43,15 +45,16 @@ void OperatorEntry::updateDispatchTable_(TensorTypeId dispatch_key) {
 
   auto k = kernels_.find(dispatch_key);
 
+  auto newDispatchTable = guts::make_unique<DispatchTable>(*dispatchTable());
   if (k == kernels_.end()) {
-    dispatchTable_.write([&] (DispatchTable& dispatchTable) {
-      dispatchTable.removeKernelIfExists(dispatch_key);
-    });
+    newDispatchTable->removeKernelIfExists(dispatch_key);
   } else {
-    dispatchTable_.write([&] (DispatchTable& dispatchTable) {
-      dispatchTable.setKernel(dispatch_key, k->second.front());
-    });
+    newDispatchTable->setKernel(dispatch_key, k->second.front());
   }
+  // Keep the old table alive for readers that are still using it,
+  // see the comment at dispatchTable_.
+  dispatchTables_.push_back(std::move(newDispatchTable));
+  dispatchTable_.store(dispatchTables_.back().get(), std::memory_order_release);
 }
 
 void OperatorEntry::deregisterKernel_(TensorTypeId dispatch_key, std::list<DispatchTableEntry>::iterator kernel) {
@@ -2,7 +2,10 @@
 
 #include <ATen/core/dispatch/DispatchTable.h>
 #include <ATen/core/dispatch/RegistrationHandleRAII.h>
+#include <atomic>
 #include <list>
+#include <memory>
+#include <vector>
 
 namespace c10 {
 namespace impl {
@@ -22,10 +25,16 @@ public:
     return schema_;
   }
 
-  DispatchTableEntry lookupKernel(const Stack* stack) const {
-    return dispatchTable_.read([&] (const DispatchTable& dispatchTable) {
-      return dispatchTable.lookup(stack);
-    });
+  const DispatchTableEntry& lookupKernel(const Stack* stack) const {
+    return dispatchTable()->lookup(stack);
+  }
+
+  // The current dispatch table. The returned table is never modified and
+  // stays alive as long as this OperatorEntry, but a (de)registration
+  // publishes a new table, so callers that held on to the pointer can
+  // compare it with a new call to see whether they have to look up again.
+  const DispatchTable* dispatchTable() const {
+    return dispatchTable_.load(std::memory_order_acquire);
   }
 
   void prepareForDeregistration();
@@ -39,8 +48,16 @@ private:
 
   FunctionSchema schema_;
 
-  // The dispatchTable stores the current kernel for each dispatch key
-  LeftRight<DispatchTable> dispatchTable_;
+  // The dispatchTable stores the current kernel for each dispatch key.
+  // It is read on every op call, possibly from many threads, so readers only
+  // load this pointer and never write to shared memory. Writers (holding
+  // kernelsMutex_) copy the current table, modify the copy and publish it.
+  // Replaced tables can't be freed since a reader might still be using them,
+  // so they're kept in dispatchTables_ until the operator is deregistered.
+  // Kernels are only (de)registered when libraries are loaded or unloaded,
+  // so there are only ever a few of them.
+  std::atomic<const DispatchTable*> dispatchTable_;
+  std::vector<std::unique_ptr<DispatchTable>> dispatchTables_;
 
   // The kernels map stores all registered kernels for a certain dispatch key.
   // If an operator library gets loaded that overwrites already existing kernels,
@@ -74,6 +74,7 @@ namespace c10 {
   _(prim, ConstantChunk)           \
   _(prim, MMTreeReduce)            \
   _(prim, MMBatchSide)             \
+  _(prim, BatchedLinear)           \
   _(prim, min)                     \
   _(prim, max)                     \
   _(prim, abs)                     \
@@ -93,6 +94,9 @@ namespace c10 {
   _(prim, profile)                 \
   _(prim, AddStatValue)            \
   _(prim, TimePoint)               \
+  _(prim, MemoryArena)             \
+  _(prim, ArenaTensor)             \
+  _(prim, ObserveHistogram)        \
   _(aten, append)                  \
   _(aten, item)                    \
   _(aten, format)                  \
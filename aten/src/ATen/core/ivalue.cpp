@@ -11,6 +11,89 @@ CAFFE2_API c10::intrusive_ptr<ConstantString> ConstantString::create(
   return c10::make_intrusive<ConstantString>(std::move(str_));
 }
 
+namespace detail {
+namespace {
+
+// Lists of all element types, and Tuples, have the same size: that of the
+// vector holding their elements plus the intrusive_ptr_target header. Only
+// blocks of that size are cached, at most kMaxCachedListBlocks per thread;
+// lists freed on other threads than the one that created them may end up in
+// either thread's cache.
+constexpr size_t kListBlockSize = sizeof(GenericList);
+constexpr size_t kMaxCachedListBlocks = 1024;
+
+struct ListMemoryCache {
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  ~ListMemoryCache() {
+    while (free_list) {
+      FreeBlock* next = free_list->next;
+      ::operator delete(free_list);
+      free_list = next;
+    }
+  }
+
+  FreeBlock* free_list = nullptr;
+  size_t num_cached = 0;
+};
+
+// Lists can be freed while thread locals are destroyed, so the cache is only
+// reached through a pointer that is reset when the cache goes away.
+thread_local ListMemoryCache* current_list_cache = nullptr;
+thread_local bool list_cache_destroyed = false;
+
+struct ListMemoryCacheHolder {
+  ListMemoryCacheHolder() {
+    current_list_cache = &cache;
+  }
+  ~ListMemoryCacheHolder() {
+    current_list_cache = nullptr;
+    list_cache_destroyed = true;
+  }
+  ListMemoryCache cache;
+};
+
+ListMemoryCache* get_list_cache() {
+  if (!current_list_cache && !list_cache_destroyed) {
+    static thread_local ListMemoryCacheHolder holder;
+  }
+  return current_list_cache;
+}
+
+static_assert(
+    sizeof(IntList) == kListBlockSize && sizeof(Tuple) == kListBlockSize,
+    "all lists are expected to have the same size");
+
+} // namespace
+
+void* allocateListMemory(size_t size) {
+  ListMemoryCache* cache = get_list_cache();
+  if (size != kListBlockSize || !cache || !cache->free_list) {
+    return ::operator new(size);
+  }
+  auto* block = cache->free_list;
+  cache->free_list = block->next;
+  --cache->num_cached;
+  return block;
+}
+
+void deallocateListMemory(void* ptr, size_t size) noexcept {
+  ListMemoryCache* cache = current_list_cache;
+  if (size != kListBlockSize || !cache ||
+      cache->num_cached == kMaxCachedListBlocks) {
+    ::operator delete(ptr);
+    return;
+  }
+  auto* block = static_cast<ListMemoryCache::FreeBlock*>(ptr);
+  block->next = cache->free_list;
+  cache->free_list = block;
+  ++cache->num_cached;
+}
+
+} // namespace detail
+
 } // namespace ivalue
 
 namespace {
@@ -40,6 +40,14 @@ struct CAFFE2_API ConstantString final : c10::intrusive_ptr_target {
       const ConstantString& v);
 };
 
+namespace detail {
+// The interpreter creates and frees a List or Tuple for about every list
+// literal, shape and tuple return, so their memory is recycled through a
+// thread local free list. See ivalue.cpp.
+CAFFE2_API void* allocateListMemory(size_t size);
+CAFFE2_API void deallocateListMemory(void* ptr, size_t size) noexcept;
+} // namespace detail
+
 template <typename Elem>
 struct CAFFE2_API List : c10::intrusive_ptr_target {
  private:
@@ -48,6 +56,13 @@ struct CAFFE2_API List : c10::intrusive_ptr_target {
  public:
   typedef Elem ElemType;
 
+  static void* operator new(size_t size) {
+    return detail::allocateListMemory(size);
+  }
+  static void operator delete(void* ptr, size_t size) noexcept {
+    detail::deallocateListMemory(ptr, size);
+  }
+
   List(std::vector<Elem> elements_) : elements_(std::move(elements_)) {}
   static c10::intrusive_ptr<List<Elem>> create(std::vector<Elem> elements_) {
     return c10::make_intrusive<List<Elem>>(std::move(elements_));
@@ -462,6 +477,11 @@ struct CAFFE2_API IValue final {
     return static_cast<at::Layout>(toInt());
   }
 
+  // MemoryFormat
+  at::MemoryFormat toMemoryFormat() const {
+    return static_cast<at::MemoryFormat>(toInt());
+  }
+
   // for debugging
   std::string tagKind() const {
     switch(tag) {
@@ -812,6 +832,7 @@ DEFINE_TO(IValue, toIValue)
 DEFINE_TO(c10::Device, toDevice)
 DEFINE_TO(at::ScalarType, toScalarType)
 DEFINE_TO(at::Layout, toLayout)
+DEFINE_TO(at::MemoryFormat, toMemoryFormat)
 
 template <typename T>
 struct _fake_type {};
@@ -385,6 +385,59 @@ TEST(OperatorRegistrationTest, givenKernelsWithSameFallbackDispatchKey_whenNewer
   }, "Didn't find kernel to dispatch to for operator '_test::dummy'");
 }
 
+TEST(OperatorRegistrationTest, givenCachedOpKernel_whenCallingWithDifferentDispatchKeys_thenCallsCorrectKernels) {
+  bool called_kernel1 = false;
+  bool called_kernel2 = false;
+  auto registrar = c10::RegisterOperators()
+    .op("_test::dummy(Tensor dummy) -> ()", kernel<MockKernel>(&called_kernel1), dispatchKey(TensorType1()))
+    .op("_test::dummy(Tensor dummy) -> ()", kernel<MockKernel>(&called_kernel2), dispatchKey(TensorType2()));
+
+  auto op = Dispatcher::singleton().findSchema("_test::dummy", "");
+  ASSERT_TRUE(op.has_value());
+  c10::CachedOpKernel cached(*op);
+
+  auto stack = makeStack(dummyTensor(TensorType1()));
+  cached.call(&stack);
+  EXPECT_TRUE(called_kernel1);
+  EXPECT_FALSE(called_kernel2);
+
+  called_kernel1 = false;
+  stack = makeStack(dummyTensor(TensorType2()));
+  cached.call(&stack);
+  EXPECT_FALSE(called_kernel1);
+  EXPECT_TRUE(called_kernel2);
+}
+
+TEST(OperatorRegistrationTest, givenCachedOpKernel_whenKernelsChange_thenCallsCurrentKernel) {
+  bool called_kernel1 = false;
+  bool called_kernel2 = false;
+  auto registrar1 = c10::RegisterOperators().op("_test::dummy(Tensor dummy) -> ()", kernel<MockKernel>(&called_kernel1), dispatchKey(TensorType1()));
+
+  auto op = Dispatcher::singleton().findSchema("_test::dummy", "");
+  ASSERT_TRUE(op.has_value());
+  c10::CachedOpKernel cached(*op);
+
+  auto stack = makeStack(dummyTensor(TensorType1()));
+  cached.call(&stack);
+  EXPECT_TRUE(called_kernel1);
+
+  // a newer kernel for the same dispatch key takes over
+  called_kernel1 = false;
+  auto registrar2 = c10::RegisterOperators().op("_test::dummy(Tensor dummy) -> ()", kernel<MockKernel>(&called_kernel2), dispatchKey(TensorType1()));
+  stack = makeStack(dummyTensor(TensorType1()));
+  cached.call(&stack);
+  EXPECT_FALSE(called_kernel1);
+  EXPECT_TRUE(called_kernel2);
+
+  // and once it's gone, the older kernel is called again
+  called_kernel2 = false;
+  registrar2 = c10::RegisterOperators(); // destruct the registrar
+  stack = makeStack(dummyTensor(TensorType1()));
+  cached.call(&stack);
+  EXPECT_TRUE(called_kernel1);
+  EXPECT_FALSE(called_kernel2);
+}
+
 
 
 /**
@@ -159,6 +159,9 @@ public:
   T& operator[](int idx) {
     return values[idx];
   }
+  // The unary functions below call std functions through lambdas, instead of
+  // passing them to map directly, so that types that convert to float, like
+  // Half and BFloat16, use the float overloads.
   Vec256<T> map(T (*f)(T)) const {
     Vec256<T> ret;
     for (int64_t i = 0; i != size(); i++) {
@@ -174,52 +177,52 @@ public:
     return ret;
   }
   Vec256<T> acos() const {
-    return map(std::acos);
+    return map([](T x) -> T { return std::acos(x); });
   }
   Vec256<T> asin() const {
-    return map(std::asin);
+    return map([](T x) -> T { return std::asin(x); });
   }
   Vec256<T> atan() const {
-    return map(std::atan);
+    return map([](T x) -> T { return std::atan(x); });
   }
   Vec256<T> erf() const {
-    return map(std::erf);
+    return map([](T x) -> T { return std::erf(x); });
   }
   Vec256<T> erfc() const {
-    return map(std::erfc);
+    return map([](T x) -> T { return std::erfc(x); });
   }
   Vec256<T> exp() const {
-    return map(std::exp);
+    return map([](T x) -> T { return std::exp(x); });
   }
   Vec256<T> expm1() const {
-    return map(std::expm1);
+    return map([](T x) -> T { return std::expm1(x); });
   }
   Vec256<T> frac() const {
     return *this - this->trunc();
   }
   Vec256<T> log() const {
-    return map(std::log);
+    return map([](T x) -> T { return std::log(x); });
   }
   Vec256<T> log10() const {
-    return map(std::log10);
+    return map([](T x) -> T { return std::log10(x); });
   }
   Vec256<T> log1p() const {
-    return map(std::log1p);
+    return map([](T x) -> T { return std::log1p(x); });
   }
   Vec256<T> log2() const {
-    return map(std::log2);
+    return map([](T x) -> T { return std::log2(x); });
   }
   Vec256<T> ceil() const {
-    return map(std::ceil);
+    return map([](T x) -> T { return std::ceil(x); });
   }
   Vec256<T> cos() const {
-    return map(std::cos);
+    return map([](T x) -> T { return std::cos(x); });
   }
   Vec256<T> cosh() const {
-    return map(std::cosh);
+    return map([](T x) -> T { return std::cosh(x); });
   }
   Vec256<T> floor() const {
-    return map(std::floor);
+    return map([](T x) -> T { return std::floor(x); });
   }
   Vec256<T> neg() const {
     // NB: the trailing return type is needed because we need to coerce the
@@ -228,31 +231,31 @@ public:
     return map([](T x) -> T { return -x; });
   }
   Vec256<T> round() const {
-    return map(std::nearbyint);
+    return map([](T x) -> T { return std::nearbyint(x); });
   }
   Vec256<T> sin() const {
-    return map(std::sin);
+    return map([](T x) -> T { return std::sin(x); });
   }
   Vec256<T> sinh() const {
-    return map(std::sinh);
+    return map([](T x) -> T { return std::sinh(x); });
   }
   Vec256<T> tan() const {
-    return map(std::tan);
+    return map([](T x) -> T { return std::tan(x); });
   }
   Vec256<T> tanh() const {
-    return map(std::tanh);
+    return map([](T x) -> T { return std::tanh(x); });
   }
   Vec256<T> trunc() const {
-    return map(std::trunc);
+    return map([](T x) -> T { return std::trunc(x); });
   }
   Vec256<T> sqrt() const {
-    return map(std::sqrt);
+    return map([](T x) -> T { return std::sqrt(x); });
   }
   Vec256<T> reciprocal() const {
     return map([](T x) { return (T)(1) / x; });
   }
   Vec256<T> rsqrt() const {
-    return map([](T x) { return 1 / std::sqrt(x); });
+    return map([](T x) -> T { return 1 / std::sqrt(x); });
   }
   Vec256<T> pow(const Vec256<T> &exp) const {
     Vec256<T> ret;
@@ -0,0 +1,350 @@
+#pragma once
+
+#include <ATen/cpu/vec256/intrinsics.h>
+#include <ATen/cpu/vec256/vec256_base.h>
+#include <ATen/cpu/vec256/vec256_float.h>
+#include <c10/util/BFloat16.h>
+#include <c10/util/Half.h>
+
+namespace at {
+namespace vec256 {
+// See Note [Acceptable use of anonymous namespace in header]
+namespace {
+
+#if defined(__AVX2__) && !defined(_MSC_VER)
+
+// Vec256<BFloat16> and Vec256<Half> hold 16 values in a __m256i. They are
+// a storage format only: every arithmetic operation converts the values to
+// two Vec256<float>, computes in float and rounds the results back, so that
+// kernels read and write half the bytes of their float versions while
+// computing with (almost) float accuracy.
+
+// ReducedFloatCvt<T> converts 16 values of T to and from two __m256.
+template <typename T>
+struct ReducedFloatCvt;
+
+template <>
+struct ReducedFloatCvt<BFloat16> {
+  static inline void to_fp32(const __m256i& a, __m256& lo, __m256& hi) {
+    // A BFloat16 is the upper half of the float with the same value.
+    lo = _mm256_castsi256_ps(_mm256_slli_epi32(
+        _mm256_cvtepu16_epi32(_mm256_castsi256_si128(a)), 16));
+    hi = _mm256_castsi256_ps(_mm256_slli_epi32(
+        _mm256_cvtepu16_epi32(_mm256_extracti128_si256(a, 1)), 16));
+  }
+  static inline __m256i round(const __m256& a) {
+    // Round to nearest even, as c10::detail::round_to_nearest_even does, and
+    // replace NaNs by the canonical quiet NaN instead of rounding them.
+    const __m256i ones = _mm256_set1_epi32(0x1);
+    const __m256i bias = _mm256_set1_epi32(0x7FFF);
+    const __m256i nan = _mm256_set1_epi32(0x7FC0);
+    __m256i bits = _mm256_castps_si256(a);
+    __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), ones);
+    __m256i rounded = _mm256_srli_epi32(
+        _mm256_add_epi32(bits, _mm256_add_epi32(lsb, bias)), 16);
+    __m256i ordered = _mm256_castps_si256(_mm256_cmp_ps(a, a, _CMP_ORD_Q));
+    return _mm256_blendv_epi8(nan, rounded, ordered);
+  }
+  static inline __m256i from_fp32(const __m256& lo, const __m256& hi) {
+    // packus works within 128-bit lanes; the permute puts the four groups of
+    // four values back in order.
+    return _mm256_permute4x64_epi64(
+        _mm256_packus_epi32(round(lo), round(hi)), 0xD8);
+  }
+};
+
+#if defined(__F16C__)
+template <>
+struct ReducedFloatCvt<Half> {
+  static inline void to_fp32(const __m256i& a, __m256& lo, __m256& hi) {
+    lo = _mm256_cvtph_ps(_mm256_castsi256_si128(a));
+    hi = _mm256_cvtph_ps(_mm256_extracti128_si256(a, 1));
+  }
+  static inline __m256i from_fp32(const __m256& lo, const __m256& hi) {
+    return _mm256_inserti128_si256(
+        _mm256_castsi128_si256(
+            _mm256_cvtps_ph(lo, (_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC))),
+        _mm256_cvtps_ph(hi, (_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)),
+        1);
+  }
+};
+#endif
+
+template <typename T>
+class Vec256ReducedFloat {
+protected:
+  __m256i values;
+  using Cvt = ReducedFloatCvt<T>;
+
+  template <typename Op>
+  Vec256<T> map_fp32(const Op& op) const {
+    __m256 lo, hi;
+    Cvt::to_fp32(values, lo, hi);
+    return Cvt::from_fp32(op(Vec256<float>(lo)), op(Vec256<float>(hi)));
+  }
+  template <typename Op>
+  Vec256<T> compare_fp32(const Vec256<T>& other, const Op& op) const {
+    __m256 a_lo, a_hi, b_lo, b_hi;
+    Cvt::to_fp32(values, a_lo, a_hi);
+    Cvt::to_fp32(other, b_lo, b_hi);
+    // The comparison results are all-ones or all-zeros floats, so packing
+    // them with signed saturation keeps all-ones or all-zeros 16-bit values.
+    __m256i lo = _mm256_castps_si256(op(Vec256<float>(a_lo), Vec256<float>(b_lo)));
+    __m256i hi = _mm256_castps_si256(op(Vec256<float>(a_hi), Vec256<float>(b_hi)));
+    return _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+  }
+public:
+  static constexpr int size() {
+    return 16;
+  }
+  Vec256ReducedFloat() {}
+  Vec256ReducedFloat(__m256i v) : values(v) {}
+  Vec256ReducedFloat(T val) {
+    values = _mm256_set1_epi16(static_cast<int16_t>(val.x));
+  }
+  operator __m256i() const {
+    return values;
+  }
+  template <int64_t mask>
+  static Vec256<T> blend(const Vec256<T>& a, const Vec256<T>& b) {
+    __at_align32__ T tmp_a[16];
+    __at_align32__ T tmp_b[16];
+    a.store(tmp_a);
+    b.store(tmp_b);
+    for (int64_t i = 0; i < size(); i++) {
+      if (mask & (int64_t(1) << i)) {
+        tmp_a[i] = tmp_b[i];
+      }
+    }
+    return loadu(tmp_a);
+  }
+  static Vec256<T> blendv(const Vec256<T>& a, const Vec256<T>& b,
+                          const Vec256<T>& mask) {
+    return _mm256_blendv_epi8(a.values, b.values, mask.values);
+  }
+  static Vec256<T> arange(T base = static_cast<T>(0), T step = static_cast<T>(1)) {
+    float base_f = base;
+    float step_f = step;
+    return Cvt::from_fp32(
+        Vec256<float>::arange(base_f, step_f),
+        Vec256<float>::arange(base_f + 8 * step_f, step_f));
+  }
+  static Vec256<T> set(const Vec256<T>& a, const Vec256<T>& b,
+                       int64_t count = size()) {
+    if (count >= size()) {
+      return b;
+    }
+    __at_align32__ T tmp_a[16];
+    __at_align32__ T tmp_b[16];
+    a.store(tmp_a);
+    b.store(tmp_b);
+    std::memcpy(tmp_a, tmp_b, count * sizeof(T));
+    return loadu(tmp_a);
+  }
+  static Vec256<T> loadu(const void* ptr) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+  }
+  static Vec256<T> loadu(const void* ptr, int64_t count) {
+    __at_align32__ T tmp_values[16];
+    std::memset(tmp_values, 0, sizeof(tmp_values));
+    std::memcpy(tmp_values, ptr, count * sizeof(T));
+    return loadu(tmp_values);
+  }
+  void store(void* ptr, int count = size()) const {
+    if (count == size()) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), values);
+    } else if (count > 0) {
+      __at_align32__ T tmp_values[16];
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(tmp_values), values);
+      std::memcpy(ptr, tmp_values, count * sizeof(T));
+    }
+  }
+  const T& operator[](int idx) const  = delete;
+  T& operator[](int idx) = delete;
+  Vec256<T> map(T (*f)(T)) const {
+    __at_align32__ T tmp[16];
+    store(tmp);
+    for (int64_t i = 0; i < size(); i++) {
+      tmp[i] = f(tmp[i]);
+    }
+    return loadu(tmp);
+  }
+  Vec256<T> abs() const {
+    return _mm256_and_si256(values, _mm256_set1_epi16(0x7FFF));
+  }
+  Vec256<T> neg() const {
+    return _mm256_xor_si256(values, _mm256_set1_epi16(static_cast<int16_t>(0x8000)));
+  }
+#define DEFINE_FP32_UNARY_OP(op)                                              \
+  Vec256<T> op() const {                                                      \
+    return map_fp32([](const Vec256<float>& x) { return x.op(); });           \
+  }
+  DEFINE_FP32_UNARY_OP(acos)
+  DEFINE_FP32_UNARY_OP(asin)
+  DEFINE_FP32_UNARY_OP(atan)
+  DEFINE_FP32_UNARY_OP(erf)
+  DEFINE_FP32_UNARY_OP(erfc)
+  DEFINE_FP32_UNARY_OP(exp)
+  DEFINE_FP32_UNARY_OP(expm1)
+  DEFINE_FP32_UNARY_OP(frac)
+  DEFINE_FP32_UNARY_OP(log)
+  DEFINE_FP32_UNARY_OP(log10)
+  DEFINE_FP32_UNARY_OP(log1p)
+  DEFINE_FP32_UNARY_OP(log2)
+  DEFINE_FP32_UNARY_OP(ceil)
+  DEFINE_FP32_UNARY_OP(cos)
+  DEFINE_FP32_UNARY_OP(cosh)
+  DEFINE_FP32_UNARY_OP(floor)
+  DEFINE_FP32_UNARY_OP(round)
+  DEFINE_FP32_UNARY_OP(sin)
+  DEFINE_FP32_UNARY_OP(sinh)
+  DEFINE_FP32_UNARY_OP(tan)
+  DEFINE_FP32_UNARY_OP(tanh)
+  DEFINE_FP32_UNARY_OP(trunc)
+  DEFINE_FP32_UNARY_OP(sqrt)
+  DEFINE_FP32_UNARY_OP(reciprocal)
+  DEFINE_FP32_UNARY_OP(rsqrt)
+#undef DEFINE_FP32_UNARY_OP
+  Vec256<T> pow(const Vec256<T>& exp) const {
+    __m256 a_lo, a_hi, b_lo, b_hi;
+    Cvt::to_fp32(values, a_lo, a_hi);
+    Cvt::to_fp32(exp, b_lo, b_hi);
+    return Cvt::from_fp32(
+        Vec256<float>(a_lo).pow(b_lo), Vec256<float>(a_hi).pow(b_hi));
+  }
+#define DEFINE_FP32_COMP(binary_pred)                                         \
+  Vec256<T> operator binary_pred(const Vec256<T>& other) const {              \
+    return compare_fp32(                                                      \
+        other, [](const Vec256<float>& a, const Vec256<float>& b) {           \
+          return a binary_pred b;                                             \
+        });                                                                   \
+  }
+  DEFINE_FP32_COMP(==)
+  DEFINE_FP32_COMP(!=)
+  DEFINE_FP32_COMP(<)
+  DEFINE_FP32_COMP(<=)
+  DEFINE_FP32_COMP(>)
+  DEFINE_FP32_COMP(>=)
+#undef DEFINE_FP32_COMP
+};
+
+template <>
+class Vec256<BFloat16> : public Vec256ReducedFloat<BFloat16> {
+public:
+  using Vec256ReducedFloat::Vec256ReducedFloat;
+  Vec256() {}
+};
+
+#if defined(__F16C__)
+template <>
+class Vec256<Half> : public Vec256ReducedFloat<Half> {
+public:
+  using Vec256ReducedFloat::Vec256ReducedFloat;
+  Vec256() {}
+};
+#endif
+
+template <typename T, typename Op>
+Vec256<T> inline binary_op_as_fp32(const Vec256<T>& a, const Vec256<T>& b, const Op& op) {
+  __m256 a_lo, a_hi, b_lo, b_hi;
+  ReducedFloatCvt<T>::to_fp32(a, a_lo, a_hi);
+  ReducedFloatCvt<T>::to_fp32(b, b_lo, b_hi);
+  return ReducedFloatCvt<T>::from_fp32(op(a_lo, b_lo), op(a_hi, b_hi));
+}
+
+#define DEFINE_REDUCED_FLOAT_OPS(T)                                                    \
+template <>                                                                            \
+Vec256<T> inline operator+(const Vec256<T>& a, const Vec256<T>& b) {                   \
+  return binary_op_as_fp32(a, b, [](const __m256& x, const __m256& y) {                \
+    return _mm256_add_ps(x, y);                                                        \
+  });                                                                                  \
+}                                                                                      \
+template <>                                                                            \
+Vec256<T> inline operator-(const Vec256<T>& a, const Vec256<T>& b) {                   \
+  return binary_op_as_fp32(a, b, [](const __m256& x, const __m256& y) {                \
+    return _mm256_sub_ps(x, y);                                                        \
+  });                                                                                  \
+}                                                                                      \
+template <>                                                                            \
+Vec256<T> inline operator*(const Vec256<T>& a, const Vec256<T>& b) {                   \
+  return binary_op_as_fp32(a, b, [](const __m256& x, const __m256& y) {                \
+    return _mm256_mul_ps(x, y);                                                        \
+  });                                                                                  \
+}                                                                                      \
+template <>                                                                            \
+Vec256<T> inline operator/(const Vec256<T>& a, const Vec256<T>& b) {                   \
+  return binary_op_as_fp32(a, b, [](const __m256& x, const __m256& y) {                \
+    return _mm256_div_ps(x, y);                                                        \
+  });                                                                                  \
+}                                                                                      \
+/* Propagates NaN like maximum and minimum of Vec256<float>. */                       \
+template <>                                                                            \
+Vec256<T> inline maximum(const Vec256<T>& a, const Vec256<T>& b) {                     \
+  return binary_op_as_fp32(a, b, [](const __m256& x, const __m256& y) {                \
+    return static_cast<__m256>(maximum(Vec256<float>(x), Vec256<float>(y)));           \
+  });                                                                                  \
+}                                                                                      \
+template <>                                                                            \
+Vec256<T> inline minimum(const Vec256<T>& a, const Vec256<T>& b) {                     \
+  return binary_op_as_fp32(a, b, [](const __m256& x, const __m256& y) {                \
+    return static_cast<__m256>(minimum(Vec256<float>(x), Vec256<float>(y)));           \
+  });                                                                                  \
+}                                                                                      \
+template <>                                                                            \
+Vec256<T> inline fmadd(const Vec256<T>& a, const Vec256<T>& b, const Vec256<T>& c) {   \
+  __m256 a_lo, a_hi, b_lo, b_hi, c_lo, c_hi;                                           \
+  ReducedFloatCvt<T>::to_fp32(a, a_lo, a_hi);                                          \
+  ReducedFloatCvt<T>::to_fp32(b, b_lo, b_hi);                                          \
+  ReducedFloatCvt<T>::to_fp32(c, c_lo, c_hi);                                          \
+  return ReducedFloatCvt<T>::from_fp32(                                                \
+      _mm256_fmadd_ps(a_lo, b_lo, c_lo), _mm256_fmadd_ps(a_hi, b_hi, c_hi));           \
+}                                                                                      \
+template <>                                                                            \
+Vec256<T> inline operator&(const Vec256<T>& a, const Vec256<T>& b) {                   \
+  return _mm256_and_si256(a, b);                                                       \
+}                                                                                      \
+template <>                                                                            \
+Vec256<T> inline operator|(const Vec256<T>& a, const Vec256<T>& b) {                   \
+  return _mm256_or_si256(a, b);                                                        \
+}                                                                                      \
+template <>                                                                            \
+Vec256<T> inline operator^(const Vec256<T>& a, const Vec256<T>& b) {                   \
+  return _mm256_xor_si256(a, b);                                                       \
+}                                                                                      \
+template <>                                                                            \
+void convert(const T* src, float* dst, int64_t n) {                                    \
+  int64_t i;                                                                           \
+  for (i = 0; i <= (n - Vec256<T>::size()); i += Vec256<T>::size()) {                  \
+    __m256 lo, hi;                                                                     \
+    ReducedFloatCvt<T>::to_fp32(                                                       \
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), lo, hi);        \
+    _mm256_storeu_ps(dst + i, lo);                                                     \
+    _mm256_storeu_ps(dst + i + Vec256<float>::size(), hi);                             \
+  }                                                                                    \
+  for (; i < n; i++) {                                                                 \
+    dst[i] = static_cast<float>(src[i]);                                               \
+  }                                                                                    \
+}                                                                                      \
+template <>                                                                            \
+void convert(const float* src, T* dst, int64_t n) {                                    \
+  int64_t i;                                                                           \
+  for (i = 0; i <= (n - Vec256<T>::size()); i += Vec256<T>::size()) {                  \
+    __m256i values = ReducedFloatCvt<T>::from_fp32(                                    \
+        _mm256_loadu_ps(src + i), _mm256_loadu_ps(src + i + Vec256<float>::size()));   \
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), values);                  \
+  }                                                                                    \
+  for (; i < n; i++) {                                                                 \
+    dst[i] = static_cast<T>(src[i]);                                                   \
+  }                                                                                    \
+}
+
+DEFINE_REDUCED_FLOAT_OPS(BFloat16)
+#if defined(__F16C__)
+DEFINE_REDUCED_FLOAT_OPS(Half)
+#endif
+
+#undef DEFINE_REDUCED_FLOAT_OPS
+
+#endif
+
+}}}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <ATen/cpu/vec256/vec256.h>
+
+#include <ATen/cpu/vec512/vec512_base.h>
+#include <ATen/cpu/vec512/vec512_float.h>
+#include <ATen/cpu/vec512/vec512_double.h>
+#include <ATen/cpu/vec512/vec512_int.h>
+
+namespace at {
+namespace vec256 {
+// See Note [Acceptable use of anonymous namespace in header]
+namespace {
+
+// `Vectorized<T>` is the widest vector type of the instruction set that a
+// kernel is compiled for: `Vec512<T>` for the AVX512 CPU capability and
+// `Vec256<T>` for the others. Kernels that only use the element-wise
+// operations common to both (as the TensorIterator loops in
+// native/cpu/Loops.h do) should be written against it, so that the AVX512
+// build uses the full width of the registers.
+#if defined(CPU_CAPABILITY_AVX512)
+template <typename T>
+using Vectorized = Vec512<T>;
+#else
+template <typename T>
+using Vectorized = Vec256<T>;
+#endif
+
+}}}
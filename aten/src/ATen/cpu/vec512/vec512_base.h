@@ -0,0 +1,210 @@
+#pragma once
+
+#include <ATen/cpu/vec256/vec256.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__GNUC__)
+#define __at_align64__ __attribute__((aligned(64)))
+#elif defined(_WIN32)
+#define __at_align64__ __declspec(align(64))
+#else
+#define __at_align64__
+#endif
+
+// The 512-bit vector types live in the `vec256` namespace too, so that kernels
+// that say `using namespace vec256;` (or call `vec256::fmadd`) find them.
+namespace at {
+namespace vec256 {
+// See Note [Acceptable use of anonymous namespace in header]
+namespace {
+
+// NOTE: If you specialize on a type, you must define all operations!
+
+// emulates 512-bit vectors with a pair of Vec256s, so that every type, and
+// every build without AVX-512 intrinsics, gets a working Vec512
+template <class T>
+struct Vec512 {
+private:
+  Vec256<T> low_;
+  Vec256<T> high_;
+  static constexpr int half_size() {
+    return Vec256<T>::size();
+  }
+public:
+  // See Note [constexpr static function to avoid odr-usage compiler bug]
+  static constexpr int size() {
+    return 2 * Vec256<T>::size();
+  }
+  Vec512() {}
+  Vec512(T val) : low_(val), high_(val) {}
+  Vec512(const Vec256<T>& low, const Vec256<T>& high) : low_(low), high_(high) {}
+  const Vec256<T>& low() const {
+    return low_;
+  }
+  const Vec256<T>& high() const {
+    return high_;
+  }
+  template <int64_t mask_>
+  static Vec512<T> blend(const Vec512<T>& a, const Vec512<T>& b) {
+    static constexpr int64_t low_mask =
+        mask_ & ((int64_t(1) << Vec256<T>::size()) - 1);
+    static constexpr int64_t high_mask = mask_ >> Vec256<T>::size();
+    return Vec512<T>(
+        Vec256<T>::template blend<low_mask>(a.low_, b.low_),
+        Vec256<T>::template blend<high_mask>(a.high_, b.high_));
+  }
+  static Vec512<T> blendv(const Vec512<T>& a, const Vec512<T>& b,
+                          const Vec512<T>& mask) {
+    return Vec512<T>(
+        Vec256<T>::blendv(a.low_, b.low_, mask.low_),
+        Vec256<T>::blendv(a.high_, b.high_, mask.high_));
+  }
+  static Vec512<T> arange(T base = static_cast<T>(0), T step = static_cast<T>(1)) {
+    return Vec512<T>(
+        Vec256<T>::arange(base, step),
+        Vec256<T>::arange(base + half_size() * step, step));
+  }
+  static Vec512<T> set(const Vec512<T>& a, const Vec512<T>& b, int64_t count = size()) {
+    return Vec512<T>(
+        Vec256<T>::set(a.low_, b.low_, std::min<int64_t>(count, half_size())),
+        Vec256<T>::set(a.high_, b.high_, std::max<int64_t>(count - half_size(), 0)));
+  }
+  static Vec512<T> loadu(const void* ptr, int64_t count = size()) {
+    const T* values = reinterpret_cast<const T*>(ptr);
+    if (count == size()) {
+      return Vec512<T>(
+          Vec256<T>::loadu(values), Vec256<T>::loadu(values + half_size()));
+    }
+    // Never read past the `count` values, which may end a page.
+    __at_align64__ T tmp_values[size()] = {0};
+    std::memcpy(tmp_values, values, count * sizeof(T));
+    return Vec512<T>(
+        Vec256<T>::loadu(tmp_values), Vec256<T>::loadu(tmp_values + half_size()));
+  }
+  void store(void* ptr, int count = size()) const {
+    T* values = reinterpret_cast<T*>(ptr);
+    if (count >= half_size()) {
+      low_.store(values);
+      high_.store(values + half_size(), count - half_size());
+    } else {
+      low_.store(values, count);
+    }
+  }
+  const T& operator[](int idx) const {
+    return idx < half_size() ? low_[idx] : high_[idx - half_size()];
+  }
+  T& operator[](int idx) {
+    return idx < half_size() ? low_[idx] : high_[idx - half_size()];
+  }
+  Vec512<T> map(T (*f)(T)) const {
+    return Vec512<T>(low_.map(f), high_.map(f));
+  }
+  Vec512<T> pow(const Vec512<T>& exp) const {
+    return Vec512<T>(low_.pow(exp.low_), high_.pow(exp.high_));
+  }
+#define DEFINE_UNARY_OP(op)                                                   \
+  Vec512<T> op() const {                                                      \
+    return Vec512<T>(low_.op(), high_.op());                                  \
+  }
+  DEFINE_UNARY_OP(abs)
+  DEFINE_UNARY_OP(acos)
+  DEFINE_UNARY_OP(asin)
+  DEFINE_UNARY_OP(atan)
+  DEFINE_UNARY_OP(erf)
+  DEFINE_UNARY_OP(erfc)
+  DEFINE_UNARY_OP(exp)
+  DEFINE_UNARY_OP(expm1)
+  DEFINE_UNARY_OP(frac)
+  DEFINE_UNARY_OP(log)
+  DEFINE_UNARY_OP(log10)
+  DEFINE_UNARY_OP(log1p)
+  DEFINE_UNARY_OP(log2)
+  DEFINE_UNARY_OP(ceil)
+  DEFINE_UNARY_OP(cos)
+  DEFINE_UNARY_OP(cosh)
+  DEFINE_UNARY_OP(floor)
+  DEFINE_UNARY_OP(neg)
+  DEFINE_UNARY_OP(round)
+  DEFINE_UNARY_OP(sin)
+  DEFINE_UNARY_OP(sinh)
+  DEFINE_UNARY_OP(tan)
+  DEFINE_UNARY_OP(tanh)
+  DEFINE_UNARY_OP(trunc)
+  DEFINE_UNARY_OP(sqrt)
+  DEFINE_UNARY_OP(reciprocal)
+  DEFINE_UNARY_OP(rsqrt)
+#undef DEFINE_UNARY_OP
+#define DEFINE_COMP(binary_pred)                                              \
+  Vec512<T> operator binary_pred(const Vec512<T>& other) const {              \
+    return Vec512<T>(low_ binary_pred other.low_, high_ binary_pred other.high_); \
+  }
+  DEFINE_COMP(==)
+  DEFINE_COMP(!=)
+  DEFINE_COMP(>=)
+  DEFINE_COMP(<=)
+  DEFINE_COMP(>)
+  DEFINE_COMP(<)
+#undef DEFINE_COMP
+};
+
+#define DEFINE_BINARY_OP(op)                                                  \
+template <class T>                                                            \
+Vec512<T> inline operator op(const Vec512<T>& a, const Vec512<T>& b) {        \
+  return Vec512<T>(a.low() op b.low(), a.high() op b.high());                 \
+}
+DEFINE_BINARY_OP(+)
+DEFINE_BINARY_OP(-)
+DEFINE_BINARY_OP(*)
+DEFINE_BINARY_OP(/)
+DEFINE_BINARY_OP(||)
+DEFINE_BINARY_OP(&)
+DEFINE_BINARY_OP(|)
+DEFINE_BINARY_OP(^)
+#undef DEFINE_BINARY_OP
+
+// Implements the IEEE 754 201X `maximum` operation, which propagates NaN if
+// either input is a NaN.
+template <class T>
+Vec512<T> inline maximum(const Vec512<T>& a, const Vec512<T>& b) {
+  return Vec512<T>(maximum(a.low(), b.low()), maximum(a.high(), b.high()));
+}
+
+// Implements the IEEE 754 201X `minimum` operation, which propagates NaN if
+// either input is a NaN.
+template <class T>
+Vec512<T> inline minimum(const Vec512<T>& a, const Vec512<T>& b) {
+  return Vec512<T>(minimum(a.low(), b.low()), minimum(a.high(), b.high()));
+}
+
+template <class T>
+Vec512<T> inline fmadd(const Vec512<T>& a, const Vec512<T>& b, const Vec512<T>& c) {
+  return Vec512<T>(
+      fmadd(a.low(), b.low(), c.low()), fmadd(a.high(), b.high(), c.high()));
+}
+
+// Cast a given vector to another type without changing the bits representation.
+template <typename dst_t, typename src_t>
+Vec512<dst_t> cast(const Vec512<src_t>& src) {
+  src_t src_arr[Vec512<src_t>::size()];
+  src.store(static_cast<void*>(src_arr));
+  return Vec512<dst_t>::loadu(static_cast<const void*>(src_arr));
+}
+
+template <typename T>
+std::ostream& operator<<(std::ostream& stream, const Vec512<T>& vec) {
+  T buf[Vec512<T>::size()];
+  vec.store(buf);
+  stream << "vec[";
+  for (int i = 0; i != Vec512<T>::size(); i++) {
+    if (i != 0) {
+      stream << ", ";
+    }
+    stream << buf[i];
+  }
+  stream << "]";
+  return stream;
+}
+
+}}}
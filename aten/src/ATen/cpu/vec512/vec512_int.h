@@ -0,0 +1,291 @@
+#pragma once
+
+#include <ATen/cpu/vec256/intrinsics.h>
+#include <ATen/cpu/vec512/vec512_base.h>
+
+namespace at {
+namespace vec256 {
+namespace {
+
+#if defined(__AVX512F__) && !defined(_MSC_VER)
+
+struct Vec512i {
+protected:
+  __m512i values;
+public:
+  Vec512i() {}
+  Vec512i(__m512i v) : values(v) {}
+  operator __m512i() const {
+    return values;
+  }
+};
+
+template <>
+struct Vec512<int64_t> : public Vec512i {
+private:
+  static __mmask8 first(int64_t count) {
+    return static_cast<__mmask8>((1u << count) - 1);
+  }
+public:
+  static constexpr int size() {
+    return 8;
+  }
+  using Vec512i::Vec512i;
+  Vec512() {}
+  Vec512(int64_t v) { values = _mm512_set1_epi64(v); }
+  Vec512(const Vec256<int64_t>& low, const Vec256<int64_t>& high) {
+    values = _mm512_inserti64x4(_mm512_castsi256_si512(low), high, 1);
+  }
+  Vec256<int64_t> low() const {
+    return _mm512_castsi512_si256(values);
+  }
+  Vec256<int64_t> high() const {
+    return _mm512_extracti64x4_epi64(values, 1);
+  }
+  template <int64_t mask>
+  static Vec512<int64_t> blend(Vec512<int64_t> a, Vec512<int64_t> b) {
+    return _mm512_mask_blend_epi64(static_cast<__mmask8>(mask), a.values, b.values);
+  }
+  static Vec512<int64_t> blendv(const Vec512<int64_t>& a, const Vec512<int64_t>& b,
+                                const Vec512<int64_t>& mask) {
+    return _mm512_mask_blend_epi64(_mm512_movepi64_mask(mask.values), a.values, b.values);
+  }
+  static Vec512<int64_t> arange(int64_t base = 0, int64_t step = 1) {
+    return _mm512_add_epi64(
+        _mm512_set1_epi64(base),
+        _mm512_mullo_epi64(
+            _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7), _mm512_set1_epi64(step)));
+  }
+  static Vec512<int64_t>
+  set(Vec512<int64_t> a, Vec512<int64_t> b, int64_t count = size()) {
+    if (count >= size()) {
+      return b;
+    }
+    return _mm512_mask_blend_epi64(first(count), a.values, b.values);
+  }
+  static Vec512<int64_t> loadu(const void* ptr) {
+    return _mm512_loadu_si512(ptr);
+  }
+  static Vec512<int64_t> loadu(const void* ptr, int64_t count) {
+    return _mm512_maskz_loadu_epi64(first(count), ptr);
+  }
+  void store(void* ptr, int count = size()) const {
+    if (count == size()) {
+      _mm512_storeu_si512(ptr, values);
+    } else if (count > 0) {
+      _mm512_mask_storeu_epi64(ptr, first(count), values);
+    }
+  }
+  const int64_t& operator[](int idx) const  = delete;
+  int64_t& operator[](int idx)  = delete;
+  Vec512<int64_t> abs() const {
+    return _mm512_abs_epi64(values);
+  }
+  Vec512<int64_t> frac() const;
+  Vec512<int64_t> neg() const;
+  Vec512<int64_t> operator==(const Vec512<int64_t>& other) const {
+    return _mm512_movm_epi64(_mm512_cmpeq_epi64_mask(values, other.values));
+  }
+  Vec512<int64_t> operator!=(const Vec512<int64_t>& other) const {
+    return _mm512_movm_epi64(_mm512_cmpneq_epi64_mask(values, other.values));
+  }
+  Vec512<int64_t> operator<(const Vec512<int64_t>& other) const {
+    return _mm512_movm_epi64(_mm512_cmplt_epi64_mask(values, other.values));
+  }
+  Vec512<int64_t> operator<=(const Vec512<int64_t>& other) const {
+    return _mm512_movm_epi64(_mm512_cmple_epi64_mask(values, other.values));
+  }
+  Vec512<int64_t> operator>(const Vec512<int64_t>& other) const {
+    return _mm512_movm_epi64(_mm512_cmpgt_epi64_mask(values, other.values));
+  }
+  Vec512<int64_t> operator>=(const Vec512<int64_t>& other) const {
+    return _mm512_movm_epi64(_mm512_cmpge_epi64_mask(values, other.values));
+  }
+};
+
+template <>
+struct Vec512<int32_t> : public Vec512i {
+private:
+  static __mmask16 first(int64_t count) {
+    return static_cast<__mmask16>((1u << count) - 1);
+  }
+public:
+  static constexpr int size() {
+    return 16;
+  }
+  using Vec512i::Vec512i;
+  Vec512() {}
+  Vec512(int32_t v) { values = _mm512_set1_epi32(v); }
+  Vec512(const Vec256<int32_t>& low, const Vec256<int32_t>& high) {
+    values = _mm512_inserti32x8(_mm512_castsi256_si512(low), high, 1);
+  }
+  Vec256<int32_t> low() const {
+    return _mm512_castsi512_si256(values);
+  }
+  Vec256<int32_t> high() const {
+    return _mm512_extracti32x8_epi32(values, 1);
+  }
+  template <int64_t mask>
+  static Vec512<int32_t> blend(Vec512<int32_t> a, Vec512<int32_t> b) {
+    return _mm512_mask_blend_epi32(static_cast<__mmask16>(mask), a.values, b.values);
+  }
+  static Vec512<int32_t> blendv(const Vec512<int32_t>& a, const Vec512<int32_t>& b,
+                                const Vec512<int32_t>& mask) {
+    return _mm512_mask_blend_epi32(_mm512_movepi32_mask(mask.values), a.values, b.values);
+  }
+  static Vec512<int32_t> arange(int32_t base = 0, int32_t step = 1) {
+    return _mm512_add_epi32(
+        _mm512_set1_epi32(base),
+        _mm512_mullo_epi32(
+            _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+            _mm512_set1_epi32(step)));
+  }
+  static Vec512<int32_t>
+  set(Vec512<int32_t> a, Vec512<int32_t> b, int64_t count = size()) {
+    if (count >= size()) {
+      return b;
+    }
+    return _mm512_mask_blend_epi32(first(count), a.values, b.values);
+  }
+  static Vec512<int32_t> loadu(const void* ptr) {
+    return _mm512_loadu_si512(ptr);
+  }
+  static Vec512<int32_t> loadu(const void* ptr, int64_t count) {
+    return _mm512_maskz_loadu_epi32(first(count), ptr);
+  }
+  void store(void* ptr, int count = size()) const {
+    if (count == size()) {
+      _mm512_storeu_si512(ptr, values);
+    } else if (count > 0) {
+      _mm512_mask_storeu_epi32(ptr, first(count), values);
+    }
+  }
+  const int32_t& operator[](int idx) const  = delete;
+  int32_t& operator[](int idx)  = delete;
+  Vec512<int32_t> abs() const {
+    return _mm512_abs_epi32(values);
+  }
+  Vec512<int32_t> frac() const;
+  Vec512<int32_t> neg() const;
+  Vec512<int32_t> operator==(const Vec512<int32_t>& other) const {
+    return _mm512_movm_epi32(_mm512_cmpeq_epi32_mask(values, other.values));
+  }
+  Vec512<int32_t> operator!=(const Vec512<int32_t>& other) const {
+    return _mm512_movm_epi32(_mm512_cmpneq_epi32_mask(values, other.values));
+  }
+  Vec512<int32_t> operator<(const Vec512<int32_t>& other) const {
+    return _mm512_movm_epi32(_mm512_cmplt_epi32_mask(values, other.values));
+  }
+  Vec512<int32_t> operator<=(const Vec512<int32_t>& other) const {
+    return _mm512_movm_epi32(_mm512_cmple_epi32_mask(values, other.values));
+  }
+  Vec512<int32_t> operator>(const Vec512<int32_t>& other) const {
+    return _mm512_movm_epi32(_mm512_cmpgt_epi32_mask(values, other.values));
+  }
+  Vec512<int32_t> operator>=(const Vec512<int32_t>& other) const {
+    return _mm512_movm_epi32(_mm512_cmpge_epi32_mask(values, other.values));
+  }
+};
+
+template <>
+Vec512<int64_t> inline operator+(const Vec512<int64_t>& a, const Vec512<int64_t>& b) {
+  return _mm512_add_epi64(a, b);
+}
+
+template <>
+Vec512<int32_t> inline operator+(const Vec512<int32_t>& a, const Vec512<int32_t>& b) {
+  return _mm512_add_epi32(a, b);
+}
+
+template <>
+Vec512<int64_t> inline operator-(const Vec512<int64_t>& a, const Vec512<int64_t>& b) {
+  return _mm512_sub_epi64(a, b);
+}
+
+template <>
+Vec512<int32_t> inline operator-(const Vec512<int32_t>& a, const Vec512<int32_t>& b) {
+  return _mm512_sub_epi32(a, b);
+}
+
+// Negation. Defined here so we can utilize operator-
+Vec512<int64_t> Vec512<int64_t>::neg() const {
+  return Vec512<int64_t>(0) - *this;
+}
+
+Vec512<int32_t> Vec512<int32_t>::neg() const {
+  return Vec512<int32_t>(0) - *this;
+}
+
+// Unlike AVX2, AVX-512 (with DQ) multiplies 64-bit integers natively.
+template <>
+Vec512<int64_t> inline operator*(const Vec512<int64_t>& a, const Vec512<int64_t>& b) {
+  return _mm512_mullo_epi64(a, b);
+}
+
+template <>
+Vec512<int32_t> inline operator*(const Vec512<int32_t>& a, const Vec512<int32_t>& b) {
+  return _mm512_mullo_epi32(a, b);
+}
+
+template <>
+Vec512<int64_t> inline minimum(const Vec512<int64_t>& a, const Vec512<int64_t>& b) {
+  return _mm512_min_epi64(a, b);
+}
+
+template <>
+Vec512<int32_t> inline minimum(const Vec512<int32_t>& a, const Vec512<int32_t>& b) {
+  return _mm512_min_epi32(a, b);
+}
+
+template <>
+Vec512<int64_t> inline maximum(const Vec512<int64_t>& a, const Vec512<int64_t>& b) {
+  return _mm512_max_epi64(a, b);
+}
+
+template <>
+Vec512<int32_t> inline maximum(const Vec512<int32_t>& a, const Vec512<int32_t>& b) {
+  return _mm512_max_epi32(a, b);
+}
+
+template <>
+Vec512<int64_t> inline fmadd(const Vec512<int64_t>& a, const Vec512<int64_t>& b, const Vec512<int64_t>& c) {
+  return a * b + c;
+}
+
+template <>
+Vec512<int32_t> inline fmadd(const Vec512<int32_t>& a, const Vec512<int32_t>& b, const Vec512<int32_t>& c) {
+  return a * b + c;
+}
+
+template <typename T>
+Vec512<T> inline intdiv_512(const Vec512<T>& a, const Vec512<T>& b) {
+  T values_a[Vec512<T>::size()];
+  T values_b[Vec512<T>::size()];
+  a.store(values_a);
+  b.store(values_b);
+  for (int i = 0; i != Vec512<T>::size(); i++) {
+    values_a[i] /= values_b[i];
+  }
+  return Vec512<T>::loadu(values_a);
+}
+
+#define DEFINE_INTEGER_BINARY_OP(op, func)                                                \
+template <>                                                                               \
+Vec512<int64_t> inline operator op(const Vec512<int64_t>& a, const Vec512<int64_t>& b) {  \
+  return func(a, b);                                                                      \
+}                                                                                         \
+template <>                                                                               \
+Vec512<int32_t> inline operator op(const Vec512<int32_t>& a, const Vec512<int32_t>& b) {  \
+  return func(a, b);                                                                      \
+}
+
+DEFINE_INTEGER_BINARY_OP(/, intdiv_512)
+DEFINE_INTEGER_BINARY_OP(&, _mm512_and_si512)
+DEFINE_INTEGER_BINARY_OP(|, _mm512_or_si512)
+DEFINE_INTEGER_BINARY_OP(^, _mm512_xor_si512)
+
+#undef DEFINE_INTEGER_BINARY_OP
+
+#endif
+
+}}}
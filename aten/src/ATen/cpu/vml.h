@@ -55,15 +55,19 @@ using namespace vec256;
 
 template <typename scalar_t>
 inline void vrsqrt(scalar_t* out, scalar_t* in, int64_t size) {
-  parallel_for(0, size, 2048, [out, in](int64_t begin, int64_t end) {
-    map(
-        [](const Vec256<scalar_t>& x) {
-          return Vec256<scalar_t>((scalar_t)(1)) / x.sqrt();
-        },
-        out + begin,
-        in + begin,
-        end - begin);
-  });
+  parallel_for(
+      0,
+      size,
+      grain_size(LoopCost::Default),
+      [out, in](int64_t begin, int64_t end) {
+        map(
+            [](const Vec256<scalar_t>& x) {
+              return Vec256<scalar_t>((scalar_t)(1)) / x.sqrt();
+            },
+            out + begin,
+            in + begin,
+            end - begin);
+      });
 }
 
 // NB: We ignore numerical errors by convention and leave them to the user
@@ -74,55 +78,64 @@ inline void vrsqrt(scalar_t* out, scalar_t* in, int64_t size) {
 // this. This duplication is also necessary since not all functions (e.g. rsqrt)
 // might be part of cmath.
 
-#define IMPLEMENT_VML_BUG(op)                                          \
+// cost is the LoopCost of op, which picks the grain size of the loop.
+#define IMPLEMENT_VML_BUG(op, cost)                                     \
   template <typename scalar_t>                                          \
   inline void v##op(scalar_t* out, const scalar_t* in, int64_t size) {  \
     DL_RUNTIME_BUG(op, scalar_t)                                        \
-    parallel_for(0, size, 2048, [out, in](int64_t begin, int64_t end) { \
-      map([](const Vec256<scalar_t>& x) { return x.op(); },             \
-          out + begin,                                                  \
-          in + begin,                                                   \
-          end - begin);                                                 \
-    });                                                                 \
+    parallel_for(                                                       \
+        0,                                                              \
+        size,                                                           \
+        grain_size(LoopCost::cost),                                     \
+        [out, in](int64_t begin, int64_t end) {                         \
+          map([](const Vec256<scalar_t>& x) { return x.op(); },         \
+              out + begin,                                              \
+              in + begin,                                               \
+              end - begin);                                             \
+        });                                                             \
   }
 
-#define IMPLEMENT_VML(op)                                              \
+#define IMPLEMENT_VML(op, cost)                                         \
   template <typename scalar_t>                                          \
   inline void v##op(scalar_t* out, const scalar_t* in, int64_t size) {  \
-    parallel_for(0, size, 2048, [out, in](int64_t begin, int64_t end) { \
-      map([](const Vec256<scalar_t>& x) { return x.op(); },             \
-          out + begin,                                                  \
-          in + begin,                                                   \
-          end - begin);                                                 \
-    });                                                                 \
+    parallel_for(                                                       \
+        0,                                                              \
+        size,                                                           \
+        grain_size(LoopCost::cost),                                     \
+        [out, in](int64_t begin, int64_t end) {                         \
+          map([](const Vec256<scalar_t>& x) { return x.op(); },         \
+              out + begin,                                              \
+              in + begin,                                               \
+              end - begin);                                             \
+        });                                                             \
   }
 
-IMPLEMENT_VML_BUG(abs)
-IMPLEMENT_VML_BUG(acos)
-IMPLEMENT_VML_BUG(asin)
-IMPLEMENT_VML_BUG(atan)
-IMPLEMENT_VML_BUG(ceil)
-IMPLEMENT_VML_BUG(cos)
-// IMPLEMENT_VML_BUG(cosh)
-IMPLEMENT_VML_BUG(erf)
-IMPLEMENT_VML_BUG(erfc)
-IMPLEMENT_VML_BUG(exp)
-IMPLEMENT_VML_BUG(expm1)
-IMPLEMENT_VML_BUG(floor)
-IMPLEMENT_VML(reciprocal)
-IMPLEMENT_VML_BUG(log)
-IMPLEMENT_VML_BUG(log10)
-IMPLEMENT_VML_BUG(log1p)
-IMPLEMENT_VML_BUG(log2)
-IMPLEMENT_VML(neg)
-IMPLEMENT_VML_BUG(sin)
-// IMPLEMENT_VML_BUG(sinh)
-IMPLEMENT_VML_BUG(sqrt)
-IMPLEMENT_VML_BUG(round)
-IMPLEMENT_VML(rsqrt)
-IMPLEMENT_VML_BUG(tan)
-IMPLEMENT_VML_BUG(tanh)
-IMPLEMENT_VML_BUG(trunc)
+IMPLEMENT_VML_BUG(abs, Cheap)
+IMPLEMENT_VML_BUG(acos, VeryExpensive)
+IMPLEMENT_VML_BUG(asin, VeryExpensive)
+IMPLEMENT_VML_BUG(atan, VeryExpensive)
+IMPLEMENT_VML_BUG(ceil, Cheap)
+IMPLEMENT_VML_BUG(cos, Expensive)
+// IMPLEMENT_VML_BUG(cosh, Expensive)
+IMPLEMENT_VML_BUG(erf, VeryExpensive)
+IMPLEMENT_VML_BUG(erfc, VeryExpensive)
+IMPLEMENT_VML_BUG(exp, Expensive)
+IMPLEMENT_VML_BUG(expm1, VeryExpensive)
+IMPLEMENT_VML_BUG(floor, Cheap)
+IMPLEMENT_VML(reciprocal, Default)
+IMPLEMENT_VML_BUG(log, Expensive)
+IMPLEMENT_VML_BUG(log10, Expensive)
+IMPLEMENT_VML_BUG(log1p, VeryExpensive)
+IMPLEMENT_VML_BUG(log2, Expensive)
+IMPLEMENT_VML(neg, Cheap)
+IMPLEMENT_VML_BUG(sin, Expensive)
+// IMPLEMENT_VML_BUG(sinh, Expensive)
+IMPLEMENT_VML_BUG(sqrt, Default)
+IMPLEMENT_VML_BUG(round, Cheap)
+IMPLEMENT_VML(rsqrt, Default)
+IMPLEMENT_VML_BUG(tan, VeryExpensive)
+IMPLEMENT_VML_BUG(tanh, Expensive)
+IMPLEMENT_VML_BUG(trunc, Cheap)
 
 #if AT_MKL_ENABLED() && !defined(__APPLE__)
 
@@ -0,0 +1,107 @@
+#include <ATen/cuda/CUDAGraph.h>
+#include <ATen/cuda/Exceptions.h>
+#include <c10/cuda/CUDAGuard.h>
+#include <c10/util/Exception.h>
+
+namespace at { namespace cuda {
+
+namespace CachingAllocator = c10::cuda::CUDACachingAllocator;
+
+#if !defined(__HIP_PLATFORM_HCC__) && CUDA_VERSION >= 10010
+
+CUDAGraph::~CUDAGraph() {
+  if (capturing_) {
+    // Ends the capture so the stream is usable again, discarding the graph
+    cudaGraph_t graph = nullptr;
+    cudaStreamEndCapture(capture_stream_->stream(), &graph);
+    if (graph) {
+      cudaGraphDestroy(graph);
+    }
+    CachingAllocator::setStreamPool(*capture_stream_, CachingAllocator::kDefaultMempool);
+    capturing_ = false;
+  }
+  reset();
+}
+
+void CUDAGraph::capture_begin() {
+  AT_CHECK(!has_graph_ && !capturing_,
+      "CUDAGraph::capture_begin: the graph was already captured, call reset() first");
+  auto stream = getCurrentCUDAStream();
+  AT_CHECK(stream != getDefaultCUDAStream(),
+      "CUDAGraph::capture_begin: cannot capture the default stream, "
+      "capture on a side stream instead");
+
+  mempool_ = CachingAllocator::createPrivatePool();
+  CachingAllocator::setStreamPool(stream, mempool_);
+  capture_stream_ = stream;
+  // Relaxed, so the caching allocator can still cudaMalloc segments for the
+  // private pool while the stream is captured
+  cudaError_t err = cudaStreamBeginCapture(stream.stream(), cudaStreamCaptureModeRelaxed);
+  if (err != cudaSuccess) {
+    CachingAllocator::setStreamPool(stream, CachingAllocator::kDefaultMempool);
+    CachingAllocator::releasePrivatePool(mempool_);
+    mempool_ = CachingAllocator::kDefaultMempool;
+    capture_stream_ = c10::nullopt;
+    AT_CUDA_CHECK(err);
+  }
+  capturing_ = true;
+}
+
+void CUDAGraph::capture_end() {
+  AT_CHECK(capturing_, "CUDAGraph::capture_end: capture_begin() was not called");
+  auto stream = *capture_stream_;
+  AT_CHECK(getCurrentCUDAStream() == stream,
+      "CUDAGraph::capture_end: the capture must end on the stream it began on");
+  capturing_ = false;
+  capture_stream_ = c10::nullopt;
+  CachingAllocator::setStreamPool(stream, CachingAllocator::kDefaultMempool);
+
+  AT_CUDA_CHECK(cudaStreamEndCapture(stream.stream(), &graph_));
+  AT_CHECK(graph_ != nullptr, "CUDAGraph::capture_end: the capture was invalidated");
+  AT_CUDA_CHECK(cudaGraphInstantiate(&graph_exec_, graph_, nullptr, nullptr, 0));
+  has_graph_ = true;
+}
+
+void CUDAGraph::replay() {
+  AT_CHECK(has_graph_, "CUDAGraph::replay: the graph was not captured");
+  AT_CUDA_CHECK(cudaGraphLaunch(graph_exec_, getCurrentCUDAStream().stream()));
+}
+
+void CUDAGraph::reset() {
+  AT_CHECK(!capturing_, "CUDAGraph::reset: cannot reset the graph while capturing");
+  if (graph_exec_) {
+    AT_CUDA_CHECK(cudaGraphExecDestroy(graph_exec_));
+    graph_exec_ = nullptr;
+  }
+  if (graph_) {
+    AT_CUDA_CHECK(cudaGraphDestroy(graph_));
+    graph_ = nullptr;
+  }
+  if (mempool_ != CachingAllocator::kDefaultMempool) {
+    CachingAllocator::releasePrivatePool(mempool_);
+    mempool_ = CachingAllocator::kDefaultMempool;
+  }
+  has_graph_ = false;
+}
+
+#else // CUDA_VERSION >= 10010
+
+CUDAGraph::~CUDAGraph() {}
+
+void CUDAGraph::capture_begin() {
+  AT_ERROR("CUDA graphs require CUDA 10.1 or later");
+}
+
+void CUDAGraph::capture_end() {
+  AT_ERROR("CUDA graphs require CUDA 10.1 or later");
+}
+
+void CUDAGraph::replay() {
+  AT_ERROR("CUDA graphs require CUDA 10.1 or later");
+}
+
+void CUDAGraph::reset() {}
+
+#endif // CUDA_VERSION >= 10010
+
+}} // namespace at::cuda
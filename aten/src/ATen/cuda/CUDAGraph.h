@@ -0,0 +1,57 @@
+#pragma once
+
+#include <ATen/cuda/ATenCUDAGeneral.h>
+#include <ATen/cuda/CUDAContext.h>
+#include <c10/cuda/CUDACachingAllocator.h>
+#include <c10/cuda/CUDAStream.h>
+#include <c10/util/Optional.h>
+
+#include <cuda_runtime_api.h>
+
+namespace at { namespace cuda {
+
+/*
+* CUDAGraph records the kernels launched on the current stream between
+* capture_begin() and capture_end() into a CUDA graph, and replay() launches
+* all of them again with a single call.
+*
+* Replays read and write the same memory as the captured kernels did, so
+* tensors allocated during the capture are served from a private pool of the
+* caching allocator. That pool is neither shared with the rest of the program
+* nor returned to the driver until the graph is reset, which keeps the
+* intermediate buffers of the captured kernels valid for every replay. Inputs
+* must be written into, and outputs read from, the tensors used during the
+* capture.
+*
+* The capture must run on a stream other than the default stream, and needs
+* CUDA 10.1 or later.
+*/
+struct AT_CUDA_API CUDAGraph {
+  CUDAGraph() = default;
+  ~CUDAGraph();
+
+  CUDAGraph(const CUDAGraph&) = delete;
+  CUDAGraph& operator=(const CUDAGraph&) = delete;
+
+  void capture_begin();
+  void capture_end();
+  void replay();
+  // Destroys the graph and releases its private memory pool.
+  void reset();
+
+  bool has_graph() const { return has_graph_; }
+
+ private:
+#if !defined(__HIP_PLATFORM_HCC__) && CUDA_VERSION >= 10010
+  cudaGraph_t graph_ = nullptr;
+  cudaGraphExec_t graph_exec_ = nullptr;
+#endif
+  bool has_graph_ = false;
+  bool capturing_ = false;
+  c10::cuda::CUDACachingAllocator::MempoolId_t mempool_ =
+      c10::cuda::CUDACachingAllocator::kDefaultMempool;
+  // The stream of the capture, set while capturing_
+  c10::optional<CUDAStream> capture_stream_;
+};
+
+}} // namespace at::cuda
@@ -110,12 +110,19 @@ void FilterDescriptor::set(const at::Tensor &t, int64_t pad) {
     throw std::runtime_error("cuDNN supports only up to " STR(CUDNN_DIM_MAX) " dimensions");
 #undef _STR
 #undef STR
+  // A channels last filter is described to cuDNN as NHWC; filters of any
+  // other layout must be contiguous.
+  cudnnTensorFormat_t filter_format = CUDNN_TENSOR_NCHW;
   if (!t.is_contiguous()) {
-    // NB: It is possible for this test to be insufficient, because the
-    // Tensor passed in to set the filter descriptor may not be the actual
-    // Tensor whose data pointer is passed to cuDNN.  Nevertheless,
-    // that is the common case, so we can catch most client errors with this test.
-    throw std::runtime_error("cuDNN filters (a.k.a. weights) must be contiguous");
+    if (t.is_contiguous(at::MemoryFormat::ChannelsLast)) {
+      filter_format = CUDNN_TENSOR_NHWC;
+    } else {
+      // NB: It is possible for this test to be insufficient, because the
+      // Tensor passed in to set the filter descriptor may not be the actual
+      // Tensor whose data pointer is passed to cuDNN.  Nevertheless,
+      // that is the common case, so we can catch most client errors with this test.
+      throw std::runtime_error("cuDNN filters (a.k.a. weights) must be contiguous");
+    }
   }
   int size[CUDNN_DIM_MAX];
   for (int i = 0; i < dim; ++i) {
@@ -125,7 +132,7 @@ void FilterDescriptor::set(const at::Tensor &t, int64_t pad) {
     size[i] = (int) 1;
   }
   dim = std::max(dim, pad);
-  set(getDataType(t), (int) dim, size);
+  set(getDataType(t), (int) dim, size, filter_format);
 }
 
 }}
@@ -177,6 +177,8 @@ generators = {
 def backend_to_devicetype(backend):
     if backend == 'QuantizedCPU':
         return 'CPU'
+    if backend == 'Vulkan':
+        return 'VULKAN'
     return backend
 
 backends = ['CPU', 'CUDA']
@@ -184,7 +186,7 @@ densities = ['Dense', 'Sparse', 'Mkldnn']  # TODO: layout instead of densities?
 
 quantized_backends = ['QuantizedCPU']
 
-extension_backends = ['MSNPU', 'XLA']
+extension_backends = ['MSNPU', 'XLA', 'Vulkan']
 
 # scalar_name, c_type, accreal, is_floating_type
 quantized_scalar_types = [
@@ -269,6 +269,10 @@ namespace {
 
     if (output_size[0] == 1 && output_size[1] == 1) {
 //in this case, adaptive pooling is just computing mean over hw dimensions, which can be done more efficiently
+       if (input.suggest_memory_format() == MemoryFormat::ChannelsLast) {
+         // reduce the strided input directly instead of making an NCHW copy
+         return input.mean({-2, -1}, /*keepdim=*/true);
+       }
        int64_t mean_size = input.size(-1) * input.size(-2);
        Tensor out = input.contiguous().view({-1, mean_size}).mean(-1);
        return input.ndimension() == 3 ? out.view({input.size(0), 1, 1}) : out.view({input.size(0), input.size(1), 1, 1});
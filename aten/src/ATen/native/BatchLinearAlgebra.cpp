@@ -3,11 +3,14 @@
 #include <ATen/Dispatch.h>
 #include <ATen/NativeFunctions.h>
 #include <ATen/LegacyTHFunctions.h>
+#include <ATen/Parallel.h>
 
 #include <ATen/native/LinearAlgebraUtils.h>
+#include <ATen/native/SmallLinearAlgebra.h>
 
 #include <TH/TH.h>  // for USE_LAPACK
 
+#include <algorithm>
 #include <vector>
 
 // First the required LAPACK implementations are registered here.
@@ -128,6 +131,19 @@ template<> void lapackTriangularSolve<float>(char uplo, char trans, char diag, i
 // Below of the definitions of the functions operating on a batch that are going to be dispatched
 // in the main helper functions for the linear algebra operations
 
+// The matrices of a batch are independent, so they are split between threads
+// in tasks of roughly GRAIN_SIZE flops. An error stops the task it occurs in.
+template <typename F>
+static void parallel_for_batch(int64_t batch_size, int64_t n, const F& f) {
+  int64_t matrix_flops = std::max<int64_t>(1, n * n * n);
+  at::parallel_for(0, batch_size, std::max<int64_t>(1, internal::GRAIN_SIZE / matrix_flops), f);
+}
+
+// Small matrices skip LAPACK, see native/SmallLinearAlgebra.h
+static inline bool useSmallKernels(int64_t n) {
+  return n > 0 && n <= small_linalg::kMaxSize;
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ solve ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 template<typename scalar_t>
@@ -137,30 +153,29 @@ static void apply_solve(Tensor& b, Tensor& A, std::vector<int64_t>& infos) {
 #else
   auto A_data = A.data<scalar_t>();
   auto b_data = b.data<scalar_t>();
+  auto A_mat_stride = matrixStride(A);
+  auto b_mat_stride = matrixStride(b);
+  auto batch_size = batchCount(A);
   auto n = A.size(-2);
   auto nrhs = b.size(-1);
 
-  auto ipiv = at::empty({n}, b.options().dtype(kInt));
-
-  int info;
-  if (b.dim() == 2) {
-    lapackSolve<scalar_t>(n, nrhs, A_data, n, ipiv.data<int>(), b_data, n, &info);
-    infos[0] = info;
-  } else {
-    auto A_mat_stride = matrixStride(A);
-    auto b_mat_stride = matrixStride(b);
-    auto batch_size = batchCount(A);
-
-    for (int64_t i = 0; i < batch_size; i++) {
+  parallel_for_batch(batch_size, n, [&](int64_t start, int64_t end) {
+    std::vector<int> ipiv(n);
+    for (int64_t i = start; i < end; i++) {
       scalar_t* A_working_ptr = &A_data[i * A_mat_stride];
       scalar_t* b_working_ptr = &b_data[i * b_mat_stride];
-      lapackSolve<scalar_t>(n, nrhs, A_working_ptr, n, ipiv.data<int>(), b_working_ptr, n, &info);
+      int info;
+      if (useSmallKernels(n)) {
+        info = small_linalg::solve<scalar_t>(n, A_working_ptr, ipiv.data(), b_working_ptr, nrhs);
+      } else {
+        lapackSolve<scalar_t>(n, nrhs, A_working_ptr, n, ipiv.data(), b_working_ptr, n, &info);
+      }
       infos[i] = info;
       if (info != 0) {
         return;
       }
     }
-  }
+  });
 #endif
 }
 
@@ -211,34 +226,45 @@ static void apply_inverse(Tensor& self, std::vector<int64_t>& infos) {
   auto batch_size = batchCount(self);
   auto n = self.size(-2);
 
-  auto ipiv = at::empty({n}, self.options().dtype(kInt));
-  int lwork;
-  scalar_t wkopt;
-  Tensor work;
-
-  for (int64_t i = 0; i < batch_size; i++) {
-    int info;
-    scalar_t* self_working_ptr = &self_data[i * self_matrix_stride];
-    lapackLu<scalar_t>(n, n, self_working_ptr, n, ipiv.data<int>(), &info);
-    infos[i] = info;
-    if (info != 0) {
-      return;
-    }
-
-    // Run twice, first to get the optimum work size
-    lwork = -1;
-    lapackGetri<scalar_t>(n, self_working_ptr, n, ipiv.data<int>(), &wkopt, lwork, &info);
+  if (useSmallKernels(n)) {
+    parallel_for_batch(batch_size, n, [&](int64_t start, int64_t end) {
+      for (int64_t i = start; i < end; i++) {
+        infos[i] = small_linalg::inverse<scalar_t>(n, &self_data[i * self_matrix_stride]);
+        if (infos[i] != 0) {
+          return;
+        }
+      }
+    });
+    return;
+  }
 
-    lwork = static_cast<int>(wkopt);
-    work = at::empty({lwork}, self.options());
+  // The optimum work size only depends on n, so it is queried once
+  int query_info;
+  int lwork = -1;
+  scalar_t wkopt;
+  std::vector<int> query_ipiv(n);
+  lapackGetri<scalar_t>(n, self_data, n, query_ipiv.data(), &wkopt, lwork, &query_info);
+  lwork = static_cast<int>(wkopt);
+
+  parallel_for_batch(batch_size, n, [&](int64_t start, int64_t end) {
+    std::vector<int> ipiv(n);
+    std::vector<scalar_t> work(lwork);
+    for (int64_t i = start; i < end; i++) {
+      int info;
+      scalar_t* self_working_ptr = &self_data[i * self_matrix_stride];
+      lapackLu<scalar_t>(n, n, self_working_ptr, n, ipiv.data(), &info);
+      infos[i] = info;
+      if (info != 0) {
+        return;
+      }
 
-    // now to compute the actual inverse
-    lapackGetri<scalar_t>(n, self_working_ptr, n, ipiv.data<int>(), work.data<scalar_t>(), lwork, &info);
-    infos[i] = info;
-    if (info != 0) {
-      return;
+      lapackGetri<scalar_t>(n, self_working_ptr, n, ipiv.data(), work.data(), lwork, &info);
+      infos[i] = info;
+      if (info != 0) {
+        return;
+      }
     }
-  }
+  });
 #endif
 }
 
@@ -282,27 +308,24 @@ static void apply_cholesky_solve(Tensor& b, Tensor& A, bool upper, std::vector<i
 
   auto A_data = A.data<scalar_t>();
   auto b_data = b.data<scalar_t>();
+  auto A_mat_stride = matrixStride(A);
+  auto b_mat_stride = matrixStride(b);
+  auto batch_size = batchCount(A);
   auto n = A.size(-2);
   auto nrhs = b.size(-1);
 
-  int info;
-  if (b.dim() == 2) {
-    lapackCholeskySolve<scalar_t>(uplo, n, nrhs, A_data, n, b_data, n, &info);
-    infos[0] = info;
-  } else {
-    auto A_mat_stride = matrixStride(A);
-    auto b_mat_stride = matrixStride(b);
-    auto batch_size = batchCount(A);
-    for (int64_t i = 0; i < batch_size; i++) {
+  parallel_for_batch(batch_size, n, [&](int64_t start, int64_t end) {
+    for (int64_t i = start; i < end; i++) {
       scalar_t* A_working_ptr = &A_data[i * A_mat_stride];
       scalar_t* b_working_ptr = &b_data[i * b_mat_stride];
+      int info;
       lapackCholeskySolve<scalar_t>(uplo, n, nrhs, A_working_ptr, n, b_working_ptr, n, &info);
       infos[i] = info;
       if (info != 0) {
         return;
       }
     }
-  }
+  });
 #endif
 }
 
@@ -349,24 +372,25 @@ static void apply_cholesky(Tensor& self, bool upper, std::vector<int64_t>& infos
   char uplo = upper ? 'U' : 'L';
 
   auto self_data = self.data<scalar_t>();
+  auto self_matrix_stride = matrixStride(self);
+  auto batch_size = batchCount(self);
   auto n = self.size(-2);
 
-  int info;
-  if (self.dim() == 2) {
-    lapackCholesky<scalar_t>(uplo, n, self_data, n, &info);
-    infos[0] = info;
-  } else {
-    auto self_matrix_stride = matrixStride(self);
-    auto batch_size = batchCount(self);
-    for (int64_t i = 0; i < batch_size; i++) {
+  parallel_for_batch(batch_size, n, [&](int64_t start, int64_t end) {
+    for (int64_t i = start; i < end; i++) {
       scalar_t* self_working_ptr = &self_data[i * self_matrix_stride];
-      lapackCholesky<scalar_t>(uplo, n, self_working_ptr, n, &info);
+      int info;
+      if (useSmallKernels(n)) {
+        info = small_linalg::cholesky<scalar_t>(n, self_working_ptr, upper);
+      } else {
+        lapackCholesky<scalar_t>(uplo, n, self_working_ptr, n, &info);
+      }
       infos[i] = info;
       if (info != 0) {
         return;
       }
     }
-  }
+  });
 #endif
 }
 
@@ -417,21 +441,23 @@ static void apply_lu(Tensor& self, Tensor& pivots, Tensor& infos) {
   auto pivots_data = pivots.data<int>();
   auto infos_data = infos.data<int>();
 
+  auto self_matrix_stride = matrixStride(self);
+  auto pivots_matrix_stride = pivots.size(-1);
+  auto batch_size = batchCount(self);
   auto n = self.size(-1);
 
-  if (self.dim() == 2) {
-    lapackLu<scalar_t>(n, n, self_data, n, pivots_data, infos_data);
-  } else {
-    auto self_matrix_stride = matrixStride(self);
-    auto batch_size = batchCount(self);
-    auto pivots_matrix_stride = pivots.size(-1);
-    for (int64_t i = 0; i < batch_size; i++) {
+  parallel_for_batch(batch_size, n, [&](int64_t start, int64_t end) {
+    for (int64_t i = start; i < end; i++) {
       scalar_t* self_working_ptr = &self_data[i * self_matrix_stride];
       int* pivots_working_ptr = &pivots_data[i * pivots_matrix_stride];
       int* infos_working_ptr = &infos_data[i];
-      lapackLu<scalar_t>(n, n, self_working_ptr, n, pivots_working_ptr, infos_working_ptr);
+      if (useSmallKernels(n)) {
+        *infos_working_ptr = small_linalg::lu<scalar_t>(n, self_working_ptr, pivots_working_ptr);
+      } else {
+        lapackLu<scalar_t>(n, n, self_working_ptr, n, pivots_working_ptr, infos_working_ptr);
+      }
     }
-  }
+  });
 #endif
 }
 
@@ -619,22 +645,20 @@ static void apply_triangular_solve(Tensor& b, Tensor& A, bool upper, bool transp
 
   auto A_data = A.data<scalar_t>();
   auto b_data = b.data<scalar_t>();
+  auto A_mat_stride = matrixStride(A);
+  auto b_mat_stride = matrixStride(b);
+  auto batch_size = batchCount(A);
   auto n = A.size(-2);
   auto nrhs = b.size(-1);
 
-  int info;
-  if (b.dim() == 2) {
-    lapackTriangularSolve<scalar_t>(uplo, trans, diag, n, nrhs, A_data, n, b_data, n, &info);
-  } else {
-    auto A_mat_stride = matrixStride(A);
-    auto b_mat_stride = matrixStride(b);
-    auto batch_size = batchCount(A);
-    for (int64_t i = 0; i < batch_size; i++) {
+  parallel_for_batch(batch_size, n, [&](int64_t start, int64_t end) {
+    for (int64_t i = start; i < end; i++) {
       scalar_t* A_working_ptr = &A_data[i * A_mat_stride];
       scalar_t* b_working_ptr = &b_data[i * b_mat_stride];
+      int info;
       lapackTriangularSolve<scalar_t>(uplo, trans, diag, n, nrhs, A_working_ptr, n, b_working_ptr, n, &info);
     }
-  }
+  });
 #endif
 }
 
@@ -1,12 +1,18 @@
 #include <ATen/ATen.h>
 #include <ATen/NativeFunctions.h>
+#include <ATen/native/DepthwiseConvolution.h>
 #include <ATen/native/utils/ParamUtils.h>
+#include <ATen/native/utils/ParamsHash.h>
 
 #include <ATen/Config.h>
 #if AT_NNPACK_ENABLED()
 #include "nnpack.h"
 #endif
 
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
 static const int MIOPEN_DIM_MAX = 4;
 
 namespace at { namespace native {
@@ -34,7 +40,10 @@ struct ConvParams {
   bool use_miopen(const at::Tensor& input) const;
   bool use_mkldnn(const at::Tensor& input) const;
   bool use_nnpack(const at::Tensor& input) const;
+  bool nnpack_supported(const at::Tensor& input) const;
   bool is_depthwise(const at::Tensor& input, const at::Tensor& weight) const;
+  bool use_cpu_depthwise(const at::Tensor& input, const at::Tensor& weight) const;
+  bool use_grouped_mm(const at::Tensor& input) const;
 };
 
 std::ostream& operator<<(std::ostream & out, const ConvParams& params) {
@@ -158,6 +167,14 @@ auto ConvParams::use_mkldnn(const at::Tensor& input) const -> bool {
   return false;
 }
 auto ConvParams::use_nnpack(const at::Tensor& input) const -> bool {
+  return nnpack_supported(input)
+#if !defined(C10_MOBILE) && !defined(CAFFE2_FB_LIMITED_MOBILE_CAPABILITY)
+         && input.size(0) >= 16 // ensure large enough batch size to ensure perf, tuneable
+#endif
+     ;
+}
+
+auto ConvParams::nnpack_supported(const at::Tensor& input) const -> bool {
 #if AT_NNPACK_ENABLED()
   return at::_nnpack_available() &&
          input.type().backend() == at::Backend::CPU &&
@@ -165,11 +182,7 @@ auto ConvParams::use_nnpack(const at::Tensor& input) const -> bool {
          !is_strided() && // doesn't support strides
          !is_dilated() && // or dilation
          !transposed &&   // or transposed tensors
-         input.ndimension() == 4 // must be in NCHW format
-#if !defined(C10_MOBILE) && !defined(CAFFE2_FB_LIMITED_MOBILE_CAPABILITY)
-         && input.size(0) >= 16 // ensure large enough batch size to ensure perf, tuneable
-#endif
-     ;
+         input.ndimension() == 4; // must be in NCHW format
 #endif
   return false;
 }
@@ -187,6 +200,32 @@ auto ConvParams::is_depthwise(
          weight.size(0) % input.size(1) == 0; // output channels must be a multiple of input channels
 }
 
+// The direct CPU kernels of depthwise convolutions, used when there is no
+// mkldnn (or for doubles): the 3x3 and 5x5 filters of stride 1 and 2 of
+// MobileNet-style networks.
+auto ConvParams::use_cpu_depthwise(
+        const at::Tensor& input, const at::Tensor& weight) const -> bool {
+  return input.type().backend() == at::Backend::CPU &&
+         (input.scalar_type() == kFloat || input.scalar_type() == kDouble) &&
+         !transposed &&
+         !is_dilated() &&
+         input.ndimension() == 4 &&
+         input.size(1) == groups &&
+         groups > 1 &&
+         weight.size(0) % input.size(1) == 0 &&
+         depthwise_convolution_supported(weight.sizes().slice(2), stride);
+}
+
+// Other grouped 2d convolutions on CPU are computed as one batch of GEMMs
+// over the im2col columns of the whole input, rather than as one convolution
+// per group.
+auto ConvParams::use_grouped_mm(const at::Tensor& input) const -> bool {
+  return input.type().backend() == at::Backend::CPU &&
+         !transposed &&
+         input.ndimension() == 4 &&
+         groups > 1;
+}
+
 static void check_shape_forward(const at::Tensor& input,
                                 const at::Tensor& weight, const at::Tensor& bias,
                                 const ConvParams& params, bool input_is_mkldnn) {
@@ -304,6 +343,209 @@ static at::Tensor subtensor(at::Tensor& tensor, int dim, int groups, int g) {
   return tensor.narrow(dim, n * g, n).contiguous();
 }
 
+// The rows of the im2col columns of a group are contiguous, so the columns
+// viewed as batch x groups x (in_channels / groups * kH * kW) x (oH * oW) are
+// multiplied by the weight of each group with a single batched matmul.
+static at::Tensor grouped_convolution_mm(
+    const at::Tensor& input, const at::Tensor& weight, const at::Tensor& bias,
+    const ConvParams& params) {
+  auto kernel_size = weight.sizes().slice(2);
+  int64_t batch_size = input.size(0);
+  int64_t out_channels = weight.size(0);
+  int64_t groups = params.groups;
+  std::vector<int64_t> output_size(2);
+  for (int d = 0; d < 2; d++) {
+    output_size[d] = (input.size(d + 2) + 2 * params.padding[d] -
+                      (params.dilation[d] * (kernel_size[d] - 1) + 1)) / params.stride[d] + 1;
+  }
+
+  auto columns = at::thnn_im2col(input, kernel_size, params.dilation, params.padding, params.stride);
+  auto output = at::matmul(
+      weight.reshape({groups, out_channels / groups, -1}),
+      columns.view({batch_size, groups, -1, columns.size(2)}));
+  output = output.view({batch_size, out_channels, output_size[0], output_size[1]});
+  if (bias.defined()) {
+    output = output + bias.view({1, out_channels, 1, 1});
+  }
+  return output;
+}
+
+// The convolutions of the backends that do not implement groups themselves:
+// one convolution, the batched GEMM of grouped_convolution_mm, or one
+// convolution per group.
+static at::Tensor convolution_nogroup_or_per_group(
+    const at::Tensor& input_r, const at::Tensor& weight_r, const at::Tensor& bias_r,
+    const ConvParams& params) {
+  auto input = input_r;
+  auto weight = weight_r;
+  auto bias = bias_r;
+  if (params.groups == 1) {
+    return at::_convolution_nogroup(
+        input, weight, bias, params.stride, params.padding, params.dilation, params.transposed, params.output_padding);
+  } else if (params.use_grouped_mm(input)) {
+    return grouped_convolution_mm(input, weight, bias, params);
+  }
+  std::vector<Tensor> outputs(params.groups);
+  for (int g = 0; g < params.groups; ++g) {
+    auto input_g = subtensor(input, 1, params.groups, g);
+    auto weight_g = subtensor(weight, 0, params.groups, g);
+    auto bias_g = subtensor(bias, 0, params.groups, g);
+    outputs[g] = at::_convolution_nogroup(
+        input_g, weight_g, bias_g, params.stride, params.padding, params.dilation, params.transposed, params.output_padding);
+  }
+  return at::cat(outputs, 1);
+}
+
+// The algorithms of dense CPU convolutions. Without benchmark mode, the use_*
+// heuristics of ConvParams choose between mkldnn, the direct depthwise kernels
+// and the THNN kernels (kDefault, which may use NNPACK). With it, as with
+// cudnn, every algorithm that supports the convolution is timed the first
+// time its shape is seen, and the fastest one is used from then on.
+enum class CpuConvAlgorithm { kDefault, kIm2colGemm, kNnpack, kMkldnn, kDirect };
+
+constexpr int cpu_conv_max_dim = 3;
+
+// The key of the benchmark cache
+struct CpuConvolutionParams {
+  ScalarType dtype;
+  int64_t input_size[2 + cpu_conv_max_dim];
+  int64_t weight_size[2 + cpu_conv_max_dim];
+  int64_t padding[cpu_conv_max_dim];
+  int64_t stride[cpu_conv_max_dim];
+  int64_t dilation[cpu_conv_max_dim];
+  int64_t output_padding[cpu_conv_max_dim];
+  int64_t groups;
+  bool transposed;
+  bool has_bias;
+};
+
+static CpuConvolutionParams cpu_convolution_params(
+    const at::Tensor& input, const at::Tensor& weight, const at::Tensor& bias,
+    const ConvParams& params) {
+  CpuConvolutionParams key;
+  // zero the padding bytes too, the key is hashed and compared as memory
+  memset(&key, 0, sizeof(key));
+  key.dtype = input.scalar_type();
+  for (int64_t i = 0; i < input.dim(); i++) {
+    key.input_size[i] = input.size(i);
+    key.weight_size[i] = weight.size(i);
+  }
+  for (size_t i = 0; i < params.padding.size(); i++) {
+    key.padding[i] = params.padding[i];
+    key.stride[i] = params.stride[i];
+    key.dilation[i] = params.dilation[i];
+    key.output_padding[i] = params.output_padding[i];
+  }
+  key.groups = params.groups;
+  key.transposed = params.transposed;
+  key.has_bias = bias.defined();
+  return key;
+}
+
+struct CpuConvBenchmarkCache {
+  std::mutex mutex;
+  std::unordered_map<CpuConvolutionParams, CpuConvAlgorithm,
+                     ParamsHash<CpuConvolutionParams>, ParamsEqual<CpuConvolutionParams>> map;
+};
+
+static CpuConvBenchmarkCache cpu_conv_benchmark_cache;
+
+static at::Tensor cpu_convolution(
+    CpuConvAlgorithm algorithm,
+    const at::Tensor& input_r, const at::Tensor& weight, const at::Tensor& bias,
+    const ConvParams& params) {
+  // of these, only mkldnn reads channels last inputs directly
+  auto input = algorithm == CpuConvAlgorithm::kMkldnn ? input_r : input_r.contiguous();
+  switch (algorithm) {
+    case CpuConvAlgorithm::kMkldnn:
+#if AT_MKLDNN_ENABLED()
+      AT_CHECK(input.type() == weight.type(),
+               "Input type (", input.type().toString(), ") and weight type (", weight.type().toString(),
+               ") should be the same");
+      AT_CHECK(!bias.defined() || (input.type() == bias.type()),
+               "Input type (", input.type().toString(), ") and bias type (", bias.type().toString(),
+               ") should be the same");
+      return at::mkldnn_convolution(input, weight.contiguous(), bias.defined() ? bias.contiguous() : bias,
+                                    params.padding, params.stride, params.dilation, params.groups);
+#endif
+      break;
+    case CpuConvAlgorithm::kNnpack:
+#if AT_NNPACK_ENABLED()
+      return at::_nnpack_spatial_convolution(input, weight, bias, params.padding);
+#endif
+      break;
+    case CpuConvAlgorithm::kDirect:
+      return at::_depthwise_convolution(input, weight, bias, params.padding, params.stride);
+    case CpuConvAlgorithm::kIm2colGemm:
+      // the THNN kernel that _convolution_nogroup would use if it did not pick NNPACK
+      if (params.groups == 1 && !params.transposed && input.dim() == 4 && !params.is_dilated()) {
+        return at::thnn_conv2d(input, weight, weight.sizes().slice(2), bias, params.stride, params.padding);
+      }
+      return convolution_nogroup_or_per_group(input, weight, bias, params);
+    case CpuConvAlgorithm::kDefault:
+      return convolution_nogroup_or_per_group(input, weight, bias, params);
+  }
+  AT_ERROR("unsupported CPU convolution algorithm");
+}
+
+static CpuConvAlgorithm default_cpu_conv_algorithm(
+    const at::Tensor& input, const at::Tensor& weight, const ConvParams& params) {
+  if (params.use_mkldnn(input)) {
+    return CpuConvAlgorithm::kMkldnn;
+  } else if (params.use_cpu_depthwise(input, weight)) {
+    return CpuConvAlgorithm::kDirect;
+  }
+  return CpuConvAlgorithm::kDefault;
+}
+
+static CpuConvAlgorithm find_cpu_conv_algorithm(
+    const at::Tensor& input, const at::Tensor& weight, const at::Tensor& bias,
+    const ConvParams& params) {
+  auto key = cpu_convolution_params(input, weight, bias, params);
+  {
+    std::lock_guard<std::mutex> guard(cpu_conv_benchmark_cache.mutex);
+    auto it = cpu_conv_benchmark_cache.map.find(key);
+    if (it != cpu_conv_benchmark_cache.map.end()) {
+      return it->second;
+    }
+  }
+
+  std::vector<CpuConvAlgorithm> algorithms = {CpuConvAlgorithm::kIm2colGemm};
+  if (params.groups == 1 && params.nnpack_supported(input)) {
+    algorithms.push_back(CpuConvAlgorithm::kNnpack);
+  }
+  if (params.use_mkldnn(input)) {
+    algorithms.push_back(CpuConvAlgorithm::kMkldnn);
+  }
+  if (params.use_cpu_depthwise(input, weight)) {
+    algorithms.push_back(CpuConvAlgorithm::kDirect);
+  }
+
+  auto best = algorithms[0];
+  if (algorithms.size() > 1) {
+    // detached, so that the trial runs are not recorded by autograd
+    auto input_d = input.detach();
+    auto weight_d = weight.detach();
+    auto bias_d = bias.defined() ? bias.detach() : bias;
+    auto best_time = std::chrono::steady_clock::duration::max();
+    for (auto algorithm : algorithms) {
+      // the first run allocates the buffers and primitives of the algorithm
+      cpu_convolution(algorithm, input_d, weight_d, bias_d, params);
+      auto start = std::chrono::steady_clock::now();
+      cpu_convolution(algorithm, input_d, weight_d, bias_d, params);
+      auto time = std::chrono::steady_clock::now() - start;
+      if (time < best_time) {
+        best_time = time;
+        best = algorithm;
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> guard(cpu_conv_benchmark_cache.mutex);
+  cpu_conv_benchmark_cache.map[key] = best;
+  return best;
+}
+
 
 at::Tensor conv1d(
     const Tensor& input, const Tensor& weight, const Tensor& bias,
@@ -364,9 +606,14 @@ at::Tensor _convolution(
     bool benchmark, bool deterministic, bool cudnn_enabled) {
 
   const bool input_is_mkldnn = input_r.is_mkldnn();
+  // A channels last input stays channels last: it is handed as is to the
+  // backends that convolve NHWC natively, and the output of the others is
+  // converted back to channels last, so that NHWC networks never see their
+  // activations flip back to NCHW.
+  const auto memory_format = input_r.suggest_memory_format();
   auto input = input_r;
   if (!input_is_mkldnn) {
-    input = input.contiguous();
+    input = input.contiguous(memory_format);
   }
   auto weight = weight_r;
   auto bias = bias_r;
@@ -399,6 +646,13 @@ at::Tensor _convolution(
     weight = view4d(weight);
   }
 
+  // Only the cudnn forward and the dense mkldnn kernels read NHWC directly.
+  const bool channels_last_native = !params.is_depthwise(input, weight) &&
+      ((params.use_cudnn(input) && !params.transposed) || params.use_mkldnn(input));
+  if (memory_format == MemoryFormat::ChannelsLast && !channels_last_native) {
+    input = input.contiguous();
+  }
+
   Tensor output;
   if (params.is_depthwise(input, weight)) {
       /* output.resize_(output_size(input, weight)); */
@@ -442,7 +696,11 @@ at::Tensor _convolution(
           input, weight, bias,
           params.padding, params.stride, params.dilation, params.groups, params.benchmark, params.deterministic);
     }
-  } else if (params.use_mkldnn(input)) {
+  } else if (input.type().backend() == at::Backend::CPU && !input_is_mkldnn) {
+    auto algorithm = params.benchmark ? find_cpu_conv_algorithm(input, weight, bias, params)
+                                      : default_cpu_conv_algorithm(input, weight, params);
+    output = cpu_convolution(algorithm, input, weight, bias, params);
+  } else if (input_is_mkldnn) {
 #if AT_MKLDNN_ENABLED()
     AT_CHECK(input.type() == weight.type(),
              "Input type (", input.type().toString(), ") and weight type (", weight.type().toString(),
@@ -450,30 +708,16 @@ at::Tensor _convolution(
     AT_CHECK(!bias.defined() || (input.type() == bias.type()),
              "Input type (", input.type().toString(), ") and bias type (", bias.type().toString(),
              ") should be the same");
-    if (!input_is_mkldnn) {
-      output = at::mkldnn_convolution(input, weight.contiguous(), bias.defined() ? bias.contiguous() : bias,
-                                      params.padding, params.stride, params.dilation, params.groups);
-    } else {
-      // do not call contiguous on mkldnn tensor
-      output = at::mkldnn_convolution(input, weight, bias,
-                                      params.padding, params.stride, params.dilation, params.groups);
-    }
+    // do not call contiguous on mkldnn tensor
+    output = at::mkldnn_convolution(input, weight, bias,
+                                    params.padding, params.stride, params.dilation, params.groups);
 #endif
   } else {
-    if (params.groups == 1) {
-      output = at::_convolution_nogroup(
-          input, weight, bias, params.stride, params.padding, params.dilation, params.transposed, params.output_padding);
-    } else {
-      std::vector<Tensor> outputs(params.groups);
-      for (int g = 0; g < params.groups; ++g) {
-        auto input_g = subtensor(input, 1, params.groups, g);
-        auto weight_g = subtensor(weight, 0, params.groups, g);
-        auto bias_g = subtensor(bias, 0, params.groups, g);
-        outputs[g] = at::_convolution_nogroup(
-            input_g, weight_g, bias_g, params.stride, params.padding, params.dilation, params.transposed, params.output_padding);
-      }
-      output = at::cat(outputs, 1);
-    }
+    output = convolution_nogroup_or_per_group(input, weight, bias, params);
+  }
+
+  if (memory_format == MemoryFormat::ChannelsLast) {
+    output = output.contiguous(memory_format);
   }
 
   if (k == 3) {
@@ -0,0 +1,72 @@
+#include <ATen/native/DepthwiseConvolution.h>
+
+#include <ATen/NativeFunctions.h>
+
+namespace at { namespace native {
+
+DEFINE_DISPATCH(depthwise_conv2d_stub);
+DEFINE_DISPATCH(depthwise_conv2d_backward_input_stub);
+DEFINE_DISPATCH(depthwise_conv2d_backward_weight_stub);
+
+static void check_depthwise_convolution(
+    const Tensor& self, const Tensor& weight, IntArrayRef padding, IntArrayRef stride) {
+  AT_CHECK(self.dim() == 4 && weight.dim() == 4,
+           "_depthwise_convolution: expected a 4-D input and weight, but got input of size ",
+           self.sizes(), " and weight of size ", weight.sizes());
+  AT_CHECK(weight.size(1) == 1 && weight.size(0) % self.size(1) == 0,
+           "_depthwise_convolution: expected a weight of size [k * ", self.size(1),
+           ", 1, kH, kW] for an input with ", self.size(1), " channels, but got ", weight.sizes());
+  AT_CHECK(self.scalar_type() == weight.scalar_type(),
+           "_depthwise_convolution: expected input and weight of the same type, but got ",
+           self.scalar_type(), " and ", weight.scalar_type());
+  AT_CHECK(padding.size() == 2 && padding[0] >= 0 && padding[1] >= 0,
+           "_depthwise_convolution: expected 2 non-negative paddings, but got ", padding);
+  AT_CHECK(depthwise_convolution_supported(weight.sizes().slice(2), stride),
+           "_depthwise_convolution: only supports 3x3 and 5x5 filters with stride 1 or 2, but got filters of size ",
+           weight.sizes().slice(2), " and stride ", stride);
+}
+
+Tensor depthwise_convolution_cpu(
+    const Tensor& self, const Tensor& weight, const Tensor& bias,
+    IntArrayRef padding, IntArrayRef stride) {
+  check_depthwise_convolution(self, weight, padding, stride);
+  AT_CHECK(!bias.defined() || (bias.dim() == 1 && bias.size(0) == weight.size(0)),
+           "_depthwise_convolution: expected a bias of size [", weight.size(0), "], but got ", bias.sizes());
+
+  int64_t output_height = (self.size(2) + 2 * padding[0] - weight.size(2)) / stride[0] + 1;
+  int64_t output_width = (self.size(3) + 2 * padding[1] - weight.size(3)) / stride[1] + 1;
+  AT_CHECK(output_height > 0 && output_width > 0,
+           "_depthwise_convolution: input of size ", self.sizes(),
+           " is too small for filters of size ", weight.sizes().slice(2));
+
+  auto output = at::empty({self.size(0), weight.size(0), output_height, output_width}, self.options());
+  depthwise_conv2d_stub(
+      kCPU, output, self.contiguous(), weight.contiguous(),
+      bias.defined() ? bias.contiguous() : bias, padding, stride);
+  return output;
+}
+
+std::tuple<Tensor, Tensor, Tensor> depthwise_convolution_backward_cpu(
+    const Tensor& grad_output_r, const Tensor& self, const Tensor& weight,
+    IntArrayRef padding, IntArrayRef stride, std::array<bool, 3> output_mask) {
+  check_depthwise_convolution(self, weight, padding, stride);
+  auto grad_output = grad_output_r.contiguous();
+
+  Tensor grad_input, grad_weight, grad_bias;
+  if (output_mask[0]) {
+    grad_input = at::empty(self.sizes(), self.options());
+    depthwise_conv2d_backward_input_stub(
+        kCPU, grad_input, grad_output, weight.contiguous(), padding, stride);
+  }
+  if (output_mask[1]) {
+    grad_weight = at::empty(weight.sizes(), weight.options());
+    depthwise_conv2d_backward_weight_stub(
+        kCPU, grad_weight, grad_output, self.contiguous(), padding, stride);
+  }
+  if (output_mask[2]) {
+    grad_bias = grad_output.sum({0, 2, 3});
+  }
+  return std::make_tuple(grad_input, grad_weight, grad_bias);
+}
+
+}} // namespace at::native
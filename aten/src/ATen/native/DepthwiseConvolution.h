@@ -0,0 +1,35 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+namespace at { namespace native {
+
+// Direct CPU kernels of the 2d depthwise convolution: each input channel is
+// convolved with its own weight.size(0) / input.size(1) filters of one
+// channel, as a convolution with groups == input.size(1). There is no im2col
+// buffer and no GEMM, which have little to work with for a single channel.
+//
+// The forward kernel is specialized for square 3x3 and 5x5 filters with
+// stride 1 or 2 and no dilation (the layers of MobileNet-style networks),
+// see depthwise_convolution_supported. All tensors are contiguous.
+
+// (output, input, weight, bias (may be undefined), padding, stride)
+using depthwise_conv2d_fn = void(*)(Tensor&, const Tensor&, const Tensor&, const Tensor&, IntArrayRef, IntArrayRef);
+// (grad_input, grad_output, weight, padding, stride)
+using depthwise_conv2d_backward_input_fn = void(*)(Tensor&, const Tensor&, const Tensor&, IntArrayRef, IntArrayRef);
+// (grad_weight, grad_output, input, padding, stride)
+using depthwise_conv2d_backward_weight_fn = void(*)(Tensor&, const Tensor&, const Tensor&, IntArrayRef, IntArrayRef);
+
+DECLARE_DISPATCH(depthwise_conv2d_fn, depthwise_conv2d_stub);
+DECLARE_DISPATCH(depthwise_conv2d_backward_input_fn, depthwise_conv2d_backward_input_stub);
+DECLARE_DISPATCH(depthwise_conv2d_backward_weight_fn, depthwise_conv2d_backward_weight_stub);
+
+inline bool depthwise_convolution_supported(IntArrayRef kernel_size, IntArrayRef stride) {
+  return kernel_size.size() == 2 && kernel_size[0] == kernel_size[1] &&
+         (kernel_size[0] == 3 || kernel_size[0] == 5) &&
+         stride.size() == 2 && stride[0] == stride[1] &&
+         (stride[0] == 1 || stride[0] == 2);
+}
+
+}} // namespace at::native
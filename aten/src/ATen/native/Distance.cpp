@@ -4,6 +4,8 @@
 
 #include <ATen/native/Distance.h>
 
+#include <limits>
+
 namespace at { namespace native {
 
 DEFINE_DISPATCH(pdist_forward_stub);
@@ -24,13 +26,78 @@ Tensor pdist(const Tensor& self, const double p) {
   return at::_pdist_forward(self.contiguous(), p);
 }
 
-Tensor cdist(const Tensor& x1, const Tensor& x2, const double p) {
+namespace {
+
+// The number of elements of the distance tiles of the GEMM-based cdist and of
+// cdist_topk, which bounds the memory they use besides their results.
+constexpr int64_t cdist_tile_elements = 1 << 24;
+
+// The modes of cdist for p = 2
+constexpr int64_t cdist_mm_if_necessary = 0;
+constexpr int64_t cdist_mm = 1;
+constexpr int64_t cdist_no_mm = 2;
+
+// Squared distances that are smaller than this many epsilons of the sum of
+// the squared norms have lost most of their digits to cancellation in
+// ||x1||^2 + ||x2||^2 - 2 x1 x2^T.
+constexpr double cdist_cancellation_epsilons = 1024;
+
+// cdist for p = 2 from ||x1||^2 + ||x2||^2 - 2 x1 x2^T, with a GEMM per tile
+// of rows of x1. The distances lost to cancellation are computed again from
+// the differences of their rows.
+void euclidean_dist_mm(Tensor& result, const Tensor& x1, const Tensor& x2) {
+  const int64_t r1 = x1.size(0);
+  const int64_t r2 = x2.size(0);
+  const double eps = x1.scalar_type() == kDouble
+      ? std::numeric_limits<double>::epsilon()
+      : std::numeric_limits<float>::epsilon();
+  Tensor x1_norm = x1.pow(2).sum(1, /*keepdim=*/true);
+  Tensor x2_norm = x2.pow(2).sum(1, /*keepdim=*/true).t();
+  Tensor x2_t = x2.t();
+  const int64_t tile_rows = std::max<int64_t>(1, cdist_tile_elements / r2);
+  for (int64_t start = 0; start < r1; start += tile_rows) {
+    const int64_t rows = std::min(tile_rows, r1 - start);
+    Tensor x1_tile = x1.narrow(0, start, rows);
+    Tensor tile = result.narrow(0, start, rows);
+    Tensor norms = x1_norm.narrow(0, start, rows) + x2_norm;
+    at::addmm_out(tile, norms, x1_tile, x2_t, /*beta=*/1, /*alpha=*/-2);
+    tile.clamp_min_(0);
+    Tensor pairs = (tile < norms.mul_(cdist_cancellation_epsilons * eps)).nonzero();
+    if (pairs.size(0) > 0) {
+      Tensor i1 = pairs.select(1, 0);
+      Tensor i2 = pairs.select(1, 1);
+      Tensor exact = (x1_tile.index_select(0, i1) - x2.index_select(0, i2)).pow_(2).sum(1);
+      tile.index_put_({i1, i2}, exact);
+    }
+    tile.sqrt_();
+  }
+}
+
+bool use_euclidean_dist_mm(const Tensor& x1, const Tensor& x2, double p, c10::optional<int64_t> compute_mode) {
+  int64_t mode = compute_mode.value_or(cdist_mm_if_necessary);
+  AT_CHECK(mode == cdist_mm_if_necessary || mode == cdist_mm || mode == cdist_no_mm,
+      "cdist got an invalid compute_mode: ", mode);
+  if (p != 2 || mode == cdist_no_mm ||
+      (x1.scalar_type() != kFloat && x1.scalar_type() != kDouble)) {
+    return false;
+  }
+  return mode == cdist_mm || x1.size(0) > 25 || x2.size(0) > 25;
+}
+
+} // namespace
+
+// compute_mode picks how the distances are computed for p = 2: by default
+// (compute_mode None or 0) with a GEMM when either input has more than 25
+// rows, always with a GEMM for 1, and never for 2. The GEMM is much faster for
+// large inputs, but less accurate for the distances of close rows, which are
+// computed again without it.
+Tensor cdist(const Tensor& x1, const Tensor& x2, const double p, c10::optional<int64_t> compute_mode) {
   AT_CHECK(x1.dim() == 2, "cdist only supports 2D tensors, X1 got: ", x1.dim(), "D");
   AT_CHECK(at::isFloatingType(x1.scalar_type()), "cdist only supports floating-point dtypes, X1 got: ", x1.scalar_type());
   auto device1 = x1.type().device_type();
   AT_CHECK(device1 == kCPU || device1 == kCUDA, "cdist only supports CPU and CUDA devices, X1 got: ", device1);
   AT_CHECK(x2.dim() == 2, "cdist only supports 2D tensors, X2 got: ", x2.dim(), "D");
-  AT_CHECK(at::isFloatingType(x1.scalar_type()), "cdist only supports floating-point dtypes, X2 got: ", x2.scalar_type());
+  AT_CHECK(at::isFloatingType(x2.scalar_type()), "cdist only supports floating-point dtypes, X2 got: ", x2.scalar_type());
   auto device2 = x2.type().device_type();
   AT_CHECK(device2 == kCPU || device2 == kCUDA, "cdist only supports CPU and CUDA devices, X2 got: ", device2);
   AT_CHECK(p >= 0, "cdist only supports non-negative p values");
@@ -46,6 +113,8 @@ Tensor cdist(const Tensor& x1, const Tensor& x2, const double p) {
   if (r1 > 0 && r2 > 0) {
     if (c1 == 0) {
       result.fill_(0);
+    } else if (use_euclidean_dist_mm(x1, x2, p, compute_mode)) {
+      euclidean_dist_mm(result, x1, x2);
     } else {
       cdist_stub(device1, result, x1.contiguous(), x2.contiguous(), p);
     }
@@ -53,6 +122,53 @@ Tensor cdist(const Tensor& x1, const Tensor& x2, const double p) {
   return result;
 }
 
+// The k smallest distances of each row of x1 to the rows of x2, and the
+// indices of these rows, in increasing distances. The distances are computed
+// by tiles of x2 rows, whose k smallest are merged with the ones of the
+// previous tiles, so that the r1 x r2 distances are never all in memory.
+std::tuple<Tensor, Tensor> cdist_topk(const Tensor& x1, const Tensor& x2, int64_t k, const double p, c10::optional<int64_t> compute_mode) {
+  AT_CHECK(x1.dim() == 2, "cdist_topk only supports 2D tensors, X1 got: ", x1.dim(), "D");
+  AT_CHECK(x2.dim() == 2, "cdist_topk only supports 2D tensors, X2 got: ", x2.dim(), "D");
+  const int64_t r1 = x1.size(0);
+  const int64_t r2 = x2.size(0);
+  AT_CHECK(k >= 0 && k <= r2, "cdist_topk expects k to be in [0, ", r2, "], but got k=", k);
+  if (r1 == 0 || k == 0) {
+    return std::make_tuple(
+        at::empty({r1, k}, x1.options()), at::empty({r1, k}, x1.options().dtype(kLong)));
+  }
+  const int64_t tile_cols = std::max(k, std::min<int64_t>(r2, 4096));
+  const int64_t tile_rows = std::max<int64_t>(1, cdist_tile_elements / tile_cols);
+  std::vector<Tensor> values;
+  std::vector<Tensor> indices;
+  for (int64_t row = 0; row < r1; row += tile_rows) {
+    Tensor x1_tile = x1.narrow(0, row, std::min(tile_rows, r1 - row));
+    Tensor best_values;
+    Tensor best_indices;
+    for (int64_t col = 0; col < r2; col += tile_cols) {
+      const int64_t cols = std::min(tile_cols, r2 - col);
+      Tensor dist = at::cdist(x1_tile, x2.narrow(0, col, cols), p, compute_mode);
+      Tensor tile_values, tile_indices;
+      std::tie(tile_values, tile_indices) =
+          dist.topk(std::min(k, cols), 1, /*largest=*/false, /*sorted=*/true);
+      tile_indices.add_(col);
+      if (!best_values.defined()) {
+        best_values = tile_values;
+        best_indices = tile_indices;
+      } else {
+        Tensor merged_values = at::cat({best_values, tile_values}, 1);
+        Tensor merged_indices = at::cat({best_indices, tile_indices}, 1);
+        Tensor order;
+        std::tie(best_values, order) =
+            merged_values.topk(k, 1, /*largest=*/false, /*sorted=*/true);
+        best_indices = merged_indices.gather(1, order);
+      }
+    }
+    values.push_back(best_values);
+    indices.push_back(best_indices);
+  }
+  return std::make_tuple(at::cat(values, 0), at::cat(indices, 0));
+}
+
 Tensor _cdist_backward(const Tensor& grad, const Tensor& x1, const Tensor& x2, const double p, const Tensor& cdist) {
   AT_CHECK(x1.is_contiguous(), "_cdist_backward requires X1 to be contiguous");
   AT_CHECK(x2.is_contiguous(), "_cdist_backward requires X2 to be contiguous");
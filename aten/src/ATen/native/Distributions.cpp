@@ -4,11 +4,13 @@
 #include <ATen/Dispatch.h>
 #include <ATen/ExpandUtils.h>
 #include <ATen/NativeFunctions.h>
+#include <ATen/Parallel.h>
 #include <c10/util/Exception.h>
 
 #include <ATen/CPUGenerator.h>
 #include <ATen/CheckGenerator.h>
 #include <ATen/core/Generator.h>
+#include <ATen/core/PhiloxRNGEngine.h>
 #include <ATen/native/Distributions.h>
 #include <ATen/native/DispatchStub.h>
 #include <ATen/native/UnaryOps.h>
@@ -110,6 +112,70 @@ int64_t sample_poisson(double lambda, THGenerator* generator) {
 namespace at {
 namespace native {
 
+namespace {
+
+// The random fills below are made of the stream of a Philox generator
+// (see ATen/core/PhiloxRNGEngine.h) whose seed is drawn from the generator of
+// the call. The generator is only locked to draw the seed, and each chunk of
+// a parallel fill starts at the offset of its first element in the stream, so
+// the fills use all threads, and give the same values for any number of them.
+
+uint64_t philox_seed(Generator* gen) {
+  THGenerator* generator = get_generator(gen);
+  std::lock_guard<std::mutex> lock(generator->mutex);
+  return THRandom_random64(generator);
+}
+
+// Calls sample(words, i, n) to make the elements [i, i + n) of a fill of
+// numel elements from the 4 words of the (i / per_counter)-th output of the
+// stream of seed, where n is per_counter but for the last elements.
+template <int64_t per_counter, typename sample_t>
+void philox_parallel_fill(int64_t numel, uint64_t seed, const sample_t& sample) {
+  int64_t counters = (numel + per_counter - 1) / per_counter;
+  at::parallel_for(0, counters, 800 / per_counter, [&](int64_t begin, int64_t end) {
+    Philox4x32 rng(seed, begin);
+    for (int64_t counter = begin; counter < end; counter++) {
+      int64_t i = counter * per_counter;
+      sample(rng(), i, std::min(per_counter, numel - i));
+    }
+  });
+}
+
+// Calls fill on self, or on a contiguous tensor that is then copied to self.
+template <typename fill_t>
+void philox_fill_contiguous(Tensor& self, const fill_t& fill) {
+  if (self.is_contiguous()) {
+    fill(self);
+  } else {
+    Tensor out = at::empty(self.sizes(), self.options());
+    fill(out);
+    self.copy_(out);
+  }
+}
+
+// The uniform numbers in [0, 1) of an output of the stream: 4 floats or 2
+// doubles.
+template <typename scalar_t>
+struct PhiloxUniform;
+
+template <>
+struct PhiloxUniform<float> {
+  static constexpr int64_t per_counter = 4;
+  static float get(const Philox4x32::Output& words, int64_t j) {
+    return philox_uniform_float(words[j]);
+  }
+};
+
+template <>
+struct PhiloxUniform<double> {
+  static constexpr int64_t per_counter = 2;
+  static double get(const Philox4x32::Output& words, int64_t j) {
+    return philox_uniform_double(words[2 * j], words[2 * j + 1]);
+  }
+};
+
+} // namespace
+
 Tensor bernoulli(const Tensor& self, Generator* gen) {
   return at::empty_like(self).bernoulli_(self, gen);
 }
@@ -127,25 +193,26 @@ Tensor& bernoulli_out(Tensor& result, const Tensor& self, Generator* gen) {
 
 Tensor& bernoulli_tensor_cpu_(Tensor& self, const Tensor& p_, Generator* gen) {
   AT_DISPATCH_ALL_TYPES(self.scalar_type(), "bernoulli_tensor_cpu_self_", [&] {
-    THGenerator* generator = get_generator(gen);
-    std::lock_guard<std::mutex> lock(generator->mutex);
     using self_t = scalar_t;
-    if (p_.scalar_type() == kDouble) {
-      auto p = std::get<0>(expand_inplace(self, p_.to(kCPU)));
-      CPU_tensor_apply2<self_t, double>(
-        self, p, [generator](self_t& ret_val, double& p_val) {
-          ret_val = static_cast<self_t>(THRandom_bernoulli(generator, p_val));
-        });
-    } else {
-      AT_DISPATCH_FLOATING_TYPES(p_.scalar_type(), "bernoulli_tensor_cpu_p_", [&] {
-        auto p = std::get<0>(expand_inplace(self, p_.to(kCPU)));
-        using p_t = scalar_t;
-        CPU_tensor_apply2<self_t, p_t>(
-          self, p, [generator](self_t& ret_val, p_t& p_val) {
-            ret_val = static_cast<self_t>(THRandom_bernoulliFloat(generator, static_cast<p_t>(p_val)));
+    AT_DISPATCH_FLOATING_TYPES(p_.scalar_type(), "bernoulli_tensor_cpu_p_", [&] {
+      using p_t = scalar_t;
+      Tensor p = std::get<0>(expand_inplace(self, p_.to(kCPU))).contiguous();
+      const p_t* p_data = p.data<p_t>();
+      uint64_t seed = philox_seed(gen);
+      philox_fill_contiguous(self, [&](Tensor& out) {
+        self_t* out_data = out.data<self_t>();
+        philox_parallel_fill<2>(out.numel(), seed,
+          [=](const Philox4x32::Output& words, int64_t i, int64_t n) {
+            for (int64_t j = 0; j < n; j++) {
+              double p_val = static_cast<double>(p_data[i + j]);
+              AT_CHECK(0 <= p_val && p_val <= 1,
+                  "bernoulli_ expects all elements of p to be in [0, 1], but got ", p_val);
+              out_data[i + j] = static_cast<self_t>(
+                  philox_uniform_double(words[2 * j], words[2 * j + 1]) < p_val);
+            }
           });
       });
-    }
+    });
   });
   return self;
 }
@@ -161,12 +228,59 @@ Tensor& bernoulli_scalar_cpu_(Tensor& self, double p, Generator* gen) {
   }
 #endif
   AT_DISPATCH_ALL_TYPES(self.scalar_type(), "bernoulli_scalar_cpu_", [&] {
-    THGenerator* generator = get_generator(gen);
-    std::lock_guard<std::mutex> lock(generator->mutex);
-    CPU_tensor_apply1<scalar_t>(
-        self, [generator, p](scalar_t& ret_val) {
-          ret_val = static_cast<scalar_t>(THRandom_bernoulli(generator, p));
+    uint64_t seed = philox_seed(gen);
+    philox_fill_contiguous(self, [&](Tensor& out) {
+      scalar_t* out_data = out.data<scalar_t>();
+      philox_parallel_fill<2>(out.numel(), seed,
+        [=](const Philox4x32::Output& words, int64_t i, int64_t n) {
+          for (int64_t j = 0; j < n; j++) {
+            out_data[i + j] = static_cast<scalar_t>(
+                philox_uniform_double(words[2 * j], words[2 * j + 1]) < p);
+          }
+        });
+    });
+  });
+  return self;
+}
+
+Tensor& uniform_cpu_(Tensor& self, double from, double to, Generator* gen) {
+  AT_DISPATCH_FLOATING_TYPES(self.scalar_type(), "uniform_cpu_", [&] {
+    using uniform = PhiloxUniform<scalar_t>;
+    uint64_t seed = philox_seed(gen);
+    philox_fill_contiguous(self, [&](Tensor& out) {
+      scalar_t* out_data = out.data<scalar_t>();
+      const scalar_t from_ = static_cast<scalar_t>(from);
+      const scalar_t range = static_cast<scalar_t>(to - from);
+      philox_parallel_fill<uniform::per_counter>(out.numel(), seed,
+        [=](const Philox4x32::Output& words, int64_t i, int64_t n) {
+          for (int64_t j = 0; j < n; j++) {
+            out_data[i + j] = uniform::get(words, j) * range + from_;
+          }
+        });
+    });
+  });
+  return self;
+}
+
+Tensor& normal_cpu_(Tensor& self, double mean, double stdv, Generator* gen) {
+  AT_CHECK(stdv > 0, "normal_ expects std > 0, but got std=", stdv);
+  AT_DISPATCH_FLOATING_TYPES(self.scalar_type(), "normal_cpu_", [&] {
+    uint64_t seed = philox_seed(gen);
+    philox_fill_contiguous(self, [&](Tensor& out) {
+      scalar_t* out_data = out.data<scalar_t>();
+      // Box-Muller: each output of the stream makes a pair of elements.
+      philox_parallel_fill<2>(out.numel(), seed,
+        [=](const Philox4x32::Output& words, int64_t i, int64_t n) {
+          double u1 = philox_uniform_double(words[0], words[1]);
+          double u2 = philox_uniform_double(words[2], words[3]);
+          double rho = std::sqrt(-2. * std::log(1. - u1));
+          double theta = 2. * M_PI * u2;
+          out_data[i] = static_cast<scalar_t>(rho * std::cos(theta) * stdv + mean);
+          if (n > 1) {
+            out_data[i + 1] = static_cast<scalar_t>(rho * std::sin(theta) * stdv + mean);
+          }
         });
+    });
   });
   return self;
 }
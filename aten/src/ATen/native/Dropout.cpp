@@ -1,5 +1,11 @@
 #include <ATen/ATen.h>
 #include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/core/PhiloxRNGEngine.h>
+#include <ATen/native/Distributions.h>
+#include <ATen/native/Dropout.h>
+
+#include <TH/THRandom.h>
 
 namespace at { namespace native {
 
@@ -21,7 +27,9 @@ Tensor make_feature_noise(const Tensor& input) {
 }
 
 bool is_fused_kernel_acceptable(const Tensor& input, double p) {
-  return input.is_cuda() && p > 0 && p < 1;
+  bool has_kernel = input.is_cuda() ||
+      (input.device().is_cpu() && (input.scalar_type() == kFloat || input.scalar_type() == kDouble));
+  return has_kernel && input.layout() == kStrided && p > 0 && p < 1;
 }
 
 // NB: sure, we could have used different overloads here, but I would feel insecure
@@ -79,11 +87,113 @@ ALIAS_SPECIALIZATION(_feature_dropout,       true,  false)
 ALIAS_SPECIALIZATION(_alpha_dropout,         false, true )
 ALIAS_SPECIALIZATION(_feature_alpha_dropout, true,  true )
 
+// Drops the elements of a dropout of numel elements with probability p: calls
+// kept(i) or dropped(i) for each element i and returns its bitmask. The 8
+// elements of a byte of the mask are drawn from 2 outputs of a Philox stream,
+// whose seed is drawn from the generator.
+template <typename kept_t, typename dropped_t>
+Tensor bitmask_dropout_cpu_kernel(
+    int64_t numel, const TensorOptions& options, double p, Generator* gen,
+    const kept_t& kept, const dropped_t& dropped) {
+  Tensor mask = at::empty({bitmask_size(numel)}, options.dtype(kByte));
+  uint64_t seed;
+  {
+    THGenerator* generator = get_generator(gen);
+    std::lock_guard<std::mutex> lock(generator->mutex);
+    seed = THRandom_random64(generator);
+  }
+  const float keep = 1 - p;
+  uint8_t* mask_data = mask.data<uint8_t>();
+  at::parallel_for(0, mask.numel(), 100, [&](int64_t begin, int64_t end) {
+    Philox4x32 rng(seed, 2 * begin);
+    for (int64_t byte = begin; byte < end; byte++) {
+      const Philox4x32::Output words[2] = {rng(), rng()};
+      uint8_t bits = 0;
+      for (int64_t j = 0; j < 8 && byte * 8 + j < numel; j++) {
+        if (philox_uniform_float(words[j / 4][j % 4]) < keep) {
+          bits |= static_cast<uint8_t>(1 << j);
+          kept(byte * 8 + j);
+        } else {
+          dropped(byte * 8 + j);
+        }
+      }
+      mask_data[byte] = bits;
+    }
+  });
+  return mask;
+}
+
 } // anomymous namepsace
 
+std::tuple<Tensor, Tensor> bitmask_dropout_cpu(const Tensor& self, double p, Generator* gen) {
+  AT_CHECK(p >= 0 && p <= 1, "dropout probability has to be between 0 and 1, but got ", p);
+  Tensor input = self.contiguous();
+  Tensor output = at::empty_like(input);
+  Tensor mask;
+  AT_DISPATCH_FLOATING_TYPES(input.scalar_type(), "bitmask_dropout_cpu", [&] {
+    const scalar_t* input_data = input.data<scalar_t>();
+    scalar_t* output_data = output.data<scalar_t>();
+    const scalar_t scale = dropout_scale(p);
+    mask = bitmask_dropout_cpu_kernel(input.numel(), input.options(), p, gen,
+        [=](int64_t i) { output_data[i] = input_data[i] * scale; },
+        [=](int64_t i) { output_data[i] = 0; });
+  });
+  return std::make_tuple(output, mask);
+}
+
+std::tuple<Tensor, Tensor> fused_bias_dropout_add_cpu(
+    const Tensor& self, const Tensor& bias, const Tensor& residual, double p, Generator* gen) {
+  check_fused_bias_dropout_add(self, bias, residual, p);
+  Tensor input = self.contiguous();
+  Tensor bias_ = bias.contiguous();
+  Tensor residual_ = residual.contiguous();
+  Tensor output = at::empty_like(input);
+  Tensor mask;
+  AT_DISPATCH_FLOATING_TYPES(input.scalar_type(), "fused_bias_dropout_add_cpu", [&] {
+    const scalar_t* input_data = input.data<scalar_t>();
+    const scalar_t* bias_data = bias_.data<scalar_t>();
+    const scalar_t* residual_data = residual_.data<scalar_t>();
+    scalar_t* output_data = output.data<scalar_t>();
+    const scalar_t scale = dropout_scale(p);
+    const int64_t bias_size = bias_.numel();
+    mask = bitmask_dropout_cpu_kernel(input.numel(), input.options(), p, gen,
+        [=](int64_t i) {
+          output_data[i] = (input_data[i] + bias_data[i % bias_size]) * scale + residual_data[i];
+        },
+        [=](int64_t i) { output_data[i] = residual_data[i]; });
+  });
+  return std::make_tuple(output, mask);
+}
+
+std::tuple<Tensor, Tensor> _fused_bias_dropout_add_backward(const Tensor& grad, const Tensor& mask, double p) {
+  Tensor grad_input = at::_bitmask_scale(grad, mask, dropout_scale(p));
+  Tensor grad_bias = grad_input.view({-1, grad_input.size(-1)}).sum(0);
+  return std::make_tuple(grad_input, grad_bias);
+}
+
+Tensor bitmask_scale_cpu(const Tensor& self, const Tensor& mask, double scale) {
+  check_bitmask(self, mask);
+  Tensor input = self.contiguous();
+  Tensor mask_ = mask.contiguous();
+  Tensor ret = at::empty_like(input);
+  AT_DISPATCH_FLOATING_TYPES(input.scalar_type(), "bitmask_scale_cpu", [&] {
+    const scalar_t* input_data = input.data<scalar_t>();
+    const uint8_t* mask_data = mask_.data<uint8_t>();
+    scalar_t* ret_data = ret.data<scalar_t>();
+    const scalar_t scale_ = scale;
+    at::parallel_for(0, input.numel(), 800, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        ret_data[i] = (mask_data[i / 8] >> (i % 8) & 1) ? input_data[i] * scale_ : scalar_t(0);
+      }
+    });
+  });
+  return ret;
+}
+
+
 Tensor dropout(const Tensor& input, double p, bool train) {
   if (train && is_fused_kernel_acceptable(input, p)) {
-    return std::get<0>(at::_fused_dropout(input, 1 - p));
+    return std::get<0>(at::_bitmask_dropout(input, p));
   }
   return _dropout<false>(input, p, train);
 }
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <ATen/ATen.h>
+
+namespace at {
+namespace native {
+
+// The scale of the kept elements of dropout; all of them are dropped for p = 1
+inline double dropout_scale(double p) {
+  return p < 1 ? 1. / (1. - p) : 0.;
+}
+
+// _fused_bias_dropout_add adds a bias of the size of the last dimension of
+// self, and a residual of the sizes of self.
+inline void check_fused_bias_dropout_add(
+    const Tensor& self, const Tensor& bias, const Tensor& residual, double p) {
+  AT_CHECK(p >= 0 && p <= 1, "dropout probability has to be between 0 and 1, but got ", p);
+  AT_CHECK(self.dim() >= 1 && bias.dim() == 1 && bias.size(0) == self.size(-1),
+      "_fused_bias_dropout_add expects a bias of the size of the last dimension of the input (",
+      self.sizes(), "), but got a bias of sizes ", bias.sizes());
+  AT_CHECK(residual.sizes() == self.sizes(),
+      "_fused_bias_dropout_add expects a residual of the sizes of the input (", self.sizes(),
+      "), but got ", residual.sizes());
+  AT_CHECK(bias.scalar_type() == self.scalar_type() && residual.scalar_type() == self.scalar_type(),
+      "_fused_bias_dropout_add expects the input, bias and residual to have the same dtype");
+}
+
+// The masks of _bitmask_dropout and _fused_bias_dropout_add have one bit per
+// element, in bytes: element i is kept if bit i % 8 of byte i / 8 is set. They
+// are padded to a multiple of 8 bytes, which are written as warp ballots of 32
+// or 64 bits by the CUDA kernels.
+inline int64_t bitmask_size(int64_t numel) {
+  return (numel + 63) / 64 * 8;
+}
+
+inline void check_bitmask(const Tensor& self, const Tensor& mask) {
+  AT_CHECK(mask.scalar_type() == at::ScalarType::Byte, "mask should be torch.uint8 dtype");
+  AT_CHECK(mask.numel() == bitmask_size(self.numel()),
+      "_bitmask_scale expects a mask of one bit per element of self");
+}
+
+} // namespace native
+} // namespace at
@@ -6,7 +6,10 @@
 #include <TH/THBlasUtils.h>
 
 #include <caffe2/perfkernels/embedding_lookup.h>
+#include <caffe2/perfkernels/fused_8bit_rowwise_embedding_lookup.h>
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <iostream>
 #include <memory>
@@ -36,11 +39,11 @@ static void make_offset2bag(const Tensor &offsets, const Tensor &indices, Tensor
 namespace {
 
 bool isFastPathIndexSelect(const Tensor& src, Tensor& output) {
-  return src.scalar_type() == kFloat && src.stride(1) == 1 && output.stride(1) == 1;
+  return src.scalar_type() == kFloat && src.is_contiguous() && output.is_contiguous();
 }
 
 bool isFastPathIndexSelectScale(const Tensor& src, const Tensor& scale, Tensor& output) {
-  return src.scalar_type() == kFloat && src.stride(1) == 1 && output.stride(1) == 1 && scale.stride(0) == 1;
+  return src.scalar_type() == kFloat && src.is_contiguous() && output.is_contiguous() && scale.stride(0) == 1;
 }
 
 // This function combines index_select (using select_indices as the index) and
@@ -71,57 +74,6 @@ void index_select_add(const Tensor &select_indices,
   }
 }
 
-template<>
-void index_select_add<float>(const Tensor &select_indices,
-                             const Tensor &add_indices,
-                             const Tensor &src,
-                             Tensor &output,
-                             const Tensor& offsets) {
-  int64_t ddim = src.size(1);
-  auto src_data = src.data<float>();
-  auto select_indices_data = select_indices.data<int64_t>();
-  auto output_data = output.data<float>();
-
-  if (isFastPathIndexSelect(src, output)) {
-    auto accessor = offsets.accessor<int64_t, 1>();
-    std::vector<int> lengths;
-
-    int64_t lower = accessor[0];
-    for (size_t i = 1; i < offsets.numel(); ++i) {
-      lengths.push_back(accessor[i] - lower);
-      lower = accessor[i];
-    }
-    lengths.push_back(select_indices.numel() - lower);
-
-    caffe2::EmbeddingLookup(
-      /*block_size=*/ddim,
-      /*output_size=*/lengths.size(),
-      /*index_size=*/select_indices.numel(),
-      /*data_size=*/src.size(0),
-      /*input=*/src_data,
-      /*indices=*/select_indices_data,
-      /*lengths=*/lengths.data(),
-      /*weights=*/nullptr,
-      /*scale_bias=*/nullptr,
-      /*normalize_by_lengths=*/false,
-      /*out=*/output_data
-    );
-  } else {
-    AT_ASSERT(select_indices.numel() == add_indices.numel());
-    auto add_indices_data = add_indices.data<int64_t>();
-    auto src_stride0 = src.stride(0);
-    auto src_stride1 = src.stride(1);
-    auto output_stride0 = output.stride(0);
-    auto output_stride1 = output.stride(1);
-    auto numel = add_indices.numel();
-    for (int64_t i = 0; i < numel; i++) {
-      THBlas_axpy<float>(ddim, 1,
-              src_data + src_stride0 * select_indices_data[i], src_stride1,
-              output_data + output_stride0 * add_indices_data[i], output_stride1);
-    }
-  }
-}
-
 // This function fuses the following three fns:
 // index_select (using select_indices as the index)
 // mul (scaling by per_sample_weights)
@@ -158,63 +110,51 @@ static void index_select_scale_add(const Tensor &select_indices,
   }
 }
 
-template<>
-void index_select_scale_add<float>(const Tensor &select_indices,
-                                          const Tensor &add_indices,
-                                          const Tensor &scale,
-                                          const Tensor &src,
-                                          Tensor &output,
-                                          const Tensor& offsets) {
-  int64_t ddim = src.size(1);
-  auto* scale_data = scale.data<float>();
-  auto select_indices_data = select_indices.data<int64_t>();
-  auto src_data = src.data<float>();
-  auto output_data = output.data<float>();
-
-  if (isFastPathIndexSelectScale(src, scale, output)) {
-    auto accessor = offsets.accessor<int64_t, 1>();
-    std::vector<int> lengths;
-
-    int64_t lower = accessor[0];
-    for (size_t i = 1; i < offsets.numel(); ++i) {
-      lengths.push_back(accessor[i] - lower);
-      lower = accessor[i];
-    }
-    lengths.push_back(select_indices.numel() - lower);
+// Sums (or averages, with normalize_by_lengths) the rows of the contiguous
+// float src in every bag with the Caffe2 perfkernels, without offset2bag.
+// The bags are reduced in parallel, in chunks of about GRAIN_SIZE weights.
+void embedding_lookup_fast_path(const Tensor &indices,
+                                const Tensor &offsets,
+                                const Tensor &per_sample_weights,
+                                const Tensor &src,
+                                bool normalize_by_lengths,
+                                Tensor &output) {
+  const int64_t ddim = src.size(1);
+  const int64_t num_bags = offsets.numel();
+  const int64_t num_indices = indices.numel();
+  const auto* offsets_data = offsets.data<int64_t>();
+  std::vector<int> lengths(num_bags);
+  for (int64_t b = 0; b < num_bags; b++) {
+    const int64_t upper = b + 1 < num_bags ? offsets_data[b + 1] : num_indices;
+    lengths[b] = upper - offsets_data[b];
+  }
 
+  const auto* src_data = src.data<float>();
+  const auto* indices_data = indices.data<int64_t>();
+  const float* weights_data =
+      per_sample_weights.defined() ? per_sample_weights.data<float>() : nullptr;
+  auto* output_data = output.data<float>();
+  const int64_t indices_per_bag =
+      std::max<int64_t>(num_indices / std::max<int64_t>(num_bags, 1), 1);
+  const int64_t grain_size = std::max<int64_t>(
+      internal::GRAIN_SIZE / std::max<int64_t>(ddim * indices_per_bag, 1), 1);
+  parallel_for(0, num_bags, grain_size, [&](int64_t begin, int64_t end) {
+    const int64_t first = offsets_data[begin];
+    const int64_t last = end < num_bags ? offsets_data[end] : num_indices;
     caffe2::EmbeddingLookup(
       /*block_size=*/ddim,
-      /*output_size=*/lengths.size(),
-      /*index_size=*/select_indices.numel(),
+      /*output_size=*/end - begin,
+      /*index_size=*/last - first,
       /*data_size=*/src.size(0),
       /*input=*/src_data,
-      /*indices=*/select_indices_data,
-      /*lengths=*/lengths.data(),
-      /*weights=*/scale_data,
+      /*indices=*/indices_data + first,
+      /*lengths=*/lengths.data() + begin,
+      /*weights=*/weights_data == nullptr ? nullptr : weights_data + first,
       /*scale_bias=*/nullptr,
-      /*normalize_by_lengths=*/false,
-      /*out=*/output_data
+      /*normalize_by_lengths=*/normalize_by_lengths,
+      /*out=*/output_data + begin * ddim
     );
-  } else {
-    AT_ASSERT(select_indices.numel() == add_indices.numel());
-    auto add_indices_data = add_indices.data<int64_t>();
-    auto src_stride0 = src.stride(0);
-    auto src_stride1 = src.stride(1);
-    auto output_stride0 = output.stride(0);
-    auto output_stride1 = output.stride(1);
-    auto scale_stride = scale.stride(0);
-    auto numel = add_indices.numel();
-
-
-    for (int64_t i = 0; i < numel; i++) {
-      auto* src_base = src_data + src_stride0 * select_indices_data[i];
-      auto* output_base = output_data + output_stride0 * add_indices_data[i];
-      auto scale = scale_data[i * scale_stride];
-      for (int64_t j = 0; j < ddim; j++) {
-        output_base[j * output_stride1] += src_base[j * src_stride1] * scale;
-      }
-    }
-  }
+  });
 }
 
 }  // namespace
@@ -357,9 +297,12 @@ _embedding_bag_cpu(const Tensor &weight, const Tensor &indices,
   auto output = at::zeros({offsets.size(0), weight.size(1)}, weight.options());
 
   // To save compute, if we are going to go down the fast path case for the 'sum'
-  // mode, we skip calculating offset2bag, since it is not going to be used.
-  auto fast_path_sum = [&weight, &per_sample_weights, &output]() {
-    if (per_sample_weights.defined()) {
+  // and 'mean' modes, we skip calculating offset2bag, since it is not going to
+  // be used.
+  auto fast_path = [&weight, &per_sample_weights, &output, mode]() {
+    if (mode == MODE_MAX) {
+      return false;
+    } else if (per_sample_weights.defined()) {
       return isFastPathIndexSelectScale(weight, per_sample_weights, output);
     } else {
       return isFastPathIndexSelect(weight, output);
@@ -370,7 +313,7 @@ _embedding_bag_cpu(const Tensor &weight, const Tensor &indices,
   // creation of offset2bag because autograd chokes when trying to use an
   // undefined tensor as an input to a backward op.
   Tensor offset2bag = at::empty({0}, offsets.options());
-  if (mode == MODE_MEAN || mode == MODE_MAX || !fast_path_sum()) {
+  if (!fast_path()) {
     // If the last entries are empty, that the last offsets are irrelevant as they
     // won't change anything in the assignment of ID -> bag, but index_add would
     // throw out of bounds error. So to keep it simple we just add one more
@@ -383,7 +326,11 @@ _embedding_bag_cpu(const Tensor &weight, const Tensor &indices,
     offset2bag.resize_({indices.sizes()[0]});
   }
 
-  if (mode == MODE_MEAN || mode == MODE_SUM) {
+  if (fast_path()) {
+    embedding_lookup_fast_path(indices, offsets, per_sample_weights, weight,
+                               /*normalize_by_lengths=*/mode == MODE_MEAN, output);
+    return std::tuple<Tensor, Tensor, Tensor, Tensor>(output, offset2bag, bag_size, bag_size);
+  } else if (mode == MODE_MEAN || mode == MODE_SUM) {
     AT_DISPATCH_FLOATING_TYPES(weight.scalar_type(), "embedding_bag_cpu", [&]() {
       if (per_sample_weights.defined()) {
         AT_ASSERT(mode == MODE_SUM);
@@ -719,5 +666,241 @@ Tensor _embedding_bag_sparse_backward(
   return native::embedding_backward(index_grad, indices, num_weights, -1,
                                     scale_grad_by_freq, true);
 }
+
+// NOTE [ Row-wise quantized embedding_bag ]
+// The weights are quantized row by row, in the fused formats of Caffe2, so
+// that the rows of 8-bit weights can be reduced by the perfkernels:
+//   8 bits: D uint8 values, then the scale and the bias of the row as floats
+//   4 bits: D / 2 bytes of two values each, the value of the even column in
+//           the low 4 bits, then the scale and the bias of the row as halves
+// A value q of a row stands for scale * q + bias.
+
+namespace {
+
+int64_t rowwise_quantized_row_bytes(int64_t embedding_dim, int64_t bits) {
+  return bits == 8 ? embedding_dim + 2 * sizeof(float)
+                   : embedding_dim / 2 + 2 * sizeof(at::Half);
+}
+
+int64_t rowwise_quantized_embedding_dim(int64_t row_bytes, int64_t bits) {
+  return bits == 8 ? row_bytes - 2 * static_cast<int64_t>(sizeof(float))
+                   : 2 * (row_bytes - 2 * static_cast<int64_t>(sizeof(at::Half)));
+}
+
+void check_rowwise_quantized_bits(int64_t bits) {
+  AT_CHECK(bits == 8 || bits == 4,
+      "embedding_bag_rowwise: expected bits to be 8 or 4, but got ", bits);
+}
+
+} // namespace
+
+Tensor _embedding_bag_rowwise_quantize_cpu(const Tensor& weight_, int64_t bits) {
+  check_rowwise_quantized_bits(bits);
+  auto weight_arg = TensorArg(weight_, "weight", 1);
+  checkScalarType("embedding_bag_rowwise_quantize", weight_arg, kFloat);
+  checkDim("embedding_bag_rowwise_quantize", weight_arg, 2);
+  const Tensor weight = weight_.contiguous();
+  const int64_t num_rows = weight.size(0);
+  const int64_t dim = weight.size(1);
+  AT_CHECK(bits == 8 || dim % 2 == 0,
+      "embedding_bag_rowwise_quantize: expected an even embedding dimension "
+      "for 4 bits, but got ", dim);
+  const int64_t row_bytes = rowwise_quantized_row_bytes(dim, bits);
+  Tensor output = at::empty({num_rows, row_bytes}, weight.options().dtype(kByte));
+  const float* weight_data = weight.data<float>();
+  uint8_t* output_data = output.data<uint8_t>();
+
+  parallel_for(0, num_rows, std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(dim, 1), 1),
+      [&](int64_t begin, int64_t end) {
+    for (int64_t row = begin; row < end; row++) {
+      const float* x = weight_data + row * dim;
+      uint8_t* q = output_data + row * row_bytes;
+      float minimum = dim > 0 ? *std::min_element(x, x + dim) : 0;
+      float maximum = dim > 0 ? *std::max_element(x, x + dim) : 0;
+      if (bits == 8) {
+        // like FloatToFused8BitRowwiseQuantized in Caffe2
+        const float range = maximum - minimum;
+        const float scale = range / 255;
+        const float inverse_scale = 255.0f / (range + 1e-8f);
+        for (int64_t k = 0; k < dim; k++) {
+          q[k] = std::lrintf((x[k] - minimum) * inverse_scale);
+        }
+        std::memcpy(q + dim, &scale, sizeof(float));
+        std::memcpy(q + dim + sizeof(float), &minimum, sizeof(float));
+      } else {
+        // the scale and the bias are rounded to half before the values are
+        // quantized with them
+        const at::Half bias = minimum;
+        at::Half scale = (maximum - static_cast<float>(bias)) / 15;
+        if (static_cast<float>(scale) == 0 || std::isinf(static_cast<float>(scale))) {
+          scale = 1.0f;
+        }
+        const float inverse_scale = 1.0f / static_cast<float>(scale);
+        std::memset(q, 0, dim / 2);
+        for (int64_t k = 0; k < dim; k++) {
+          long value = std::lrintf((x[k] - static_cast<float>(bias)) * inverse_scale);
+          value = std::min<long>(std::max<long>(value, 0), 15);
+          q[k / 2] |= value << ((k % 2) * 4);
+        }
+        std::memcpy(q + dim / 2, &scale, sizeof(at::Half));
+        std::memcpy(q + dim / 2 + sizeof(at::Half), &bias, sizeof(at::Half));
+      }
+    }
+  });
+  return output;
+}
+
+Tensor _embedding_bag_rowwise_dequantize_cpu(const Tensor& packed_weight_, int64_t bits) {
+  check_rowwise_quantized_bits(bits);
+  auto packed_weight_arg = TensorArg(packed_weight_, "packed_weight", 1);
+  checkScalarType("embedding_bag_rowwise_dequantize", packed_weight_arg, kByte);
+  checkDim("embedding_bag_rowwise_dequantize", packed_weight_arg, 2);
+  const Tensor packed_weight = packed_weight_.contiguous();
+  const int64_t num_rows = packed_weight.size(0);
+  const int64_t row_bytes = packed_weight.size(1);
+  const int64_t dim = rowwise_quantized_embedding_dim(row_bytes, bits);
+  AT_CHECK(dim >= 0, "embedding_bag_rowwise_dequantize: rows of ", row_bytes,
+      " bytes are too short for ", bits, "-bit weights");
+  Tensor output = at::empty({num_rows, dim}, packed_weight.options().dtype(kFloat));
+  const uint8_t* packed_weight_data = packed_weight.data<uint8_t>();
+  float* output_data = output.data<float>();
+
+  parallel_for(0, num_rows, std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(dim, 1), 1),
+      [&](int64_t begin, int64_t end) {
+    for (int64_t row = begin; row < end; row++) {
+      const uint8_t* q = packed_weight_data + row * row_bytes;
+      float* x = output_data + row * dim;
+      if (bits == 8) {
+        float scale, bias;
+        std::memcpy(&scale, q + dim, sizeof(float));
+        std::memcpy(&bias, q + dim + sizeof(float), sizeof(float));
+        for (int64_t k = 0; k < dim; k++) {
+          x[k] = scale * q[k] + bias;
+        }
+      } else {
+        at::Half scale, bias;
+        std::memcpy(&scale, q + dim / 2, sizeof(at::Half));
+        std::memcpy(&bias, q + dim / 2 + sizeof(at::Half), sizeof(at::Half));
+        for (int64_t k = 0; k < dim; k++) {
+          x[k] = static_cast<float>(scale) * ((q[k / 2] >> ((k % 2) * 4)) & 0xf) +
+              static_cast<float>(bias);
+        }
+      }
+    }
+  });
+  return output;
+}
+
+// The bags are reduced in parallel. 8-bit rows are reduced by the Caffe2
+// perfkernels, which also check the indices, and 4-bit rows are unpacked as
+// they are accumulated.
+Tensor _embedding_bag_rowwise_quantized_cpu(
+    const Tensor& packed_weight_, const Tensor& indices_,
+    const Tensor& offsets_, int64_t bits, int64_t mode,
+    const Tensor& per_sample_weights_) {
+  check_rowwise_quantized_bits(bits);
+  auto packed_weight_arg = TensorArg(packed_weight_, "packed_weight", 1);
+  checkScalarType("embedding_bag_rowwise_quantized", packed_weight_arg, kByte);
+  checkDim("embedding_bag_rowwise_quantized", packed_weight_arg, 2);
+  auto indices_arg = TensorArg(indices_, "indices", 2);
+  checkScalarType("embedding_bag_rowwise_quantized", indices_arg, kLong);
+  checkDim("embedding_bag_rowwise_quantized", indices_arg, 1);
+  auto offsets_arg = TensorArg(offsets_, "offsets", 3);
+  checkScalarType("embedding_bag_rowwise_quantized", offsets_arg, kLong);
+  checkDim("embedding_bag_rowwise_quantized", offsets_arg, 1);
+  AT_CHECK(mode == MODE_SUM || mode == MODE_MEAN,
+      "embedding_bag_rowwise_quantized: only the 'sum' and 'mean' modes are supported");
+  if (per_sample_weights_.defined()) {
+    AT_CHECK(mode == MODE_SUM,
+        "embedding_bag: per_sample_weights only supported with mode='sum'");
+    auto per_sample_weights_arg = TensorArg(per_sample_weights_, "per_sample_weights", 6);
+    checkScalarType("embedding_bag_rowwise_quantized", per_sample_weights_arg, kFloat);
+    AT_CHECK(per_sample_weights_.dim() == 1 && per_sample_weights_.numel() == indices_.numel(),
+        "embedding_bag_rowwise_quantized: expected per_sample_weights to have the shape of indices");
+  }
+
+  const Tensor packed_weight = packed_weight_.contiguous();
+  const Tensor indices = indices_.contiguous();
+  const Tensor offsets = offsets_.contiguous();
+  const Tensor per_sample_weights = per_sample_weights_.defined()
+      ? per_sample_weights_.contiguous() : per_sample_weights_;
+  const int64_t num_rows = packed_weight.size(0);
+  const int64_t row_bytes = packed_weight.size(1);
+  const int64_t dim = rowwise_quantized_embedding_dim(row_bytes, bits);
+  AT_CHECK(dim >= 0, "embedding_bag_rowwise_quantized: rows of ", row_bytes,
+      " bytes are too short for ", bits, "-bit weights");
+  const int64_t num_bags = offsets.numel();
+  const int64_t num_indices = indices.numel();
+
+  const int64_t* offsets_data = offsets.data<int64_t>();
+  std::vector<int> lengths(num_bags);
+  for (int64_t b = 0; b < num_bags; b++) {
+    const int64_t end = b + 1 < num_bags ? offsets_data[b + 1] : num_indices;
+    AT_CHECK(offsets_data[b] >= 0 && offsets_data[b] <= end && end <= num_indices,
+        "embedding_bag_rowwise_quantized: expected offsets to be increasing "
+        "and at most the number of indices, but got ", offsets_data[b], " for bag ", b);
+    lengths[b] = end - offsets_data[b];
+  }
+
+  Tensor output = at::zeros({num_bags, dim}, packed_weight.options().dtype(kFloat));
+  const uint8_t* packed_weight_data = packed_weight.data<uint8_t>();
+  const int64_t* indices_data = indices.data<int64_t>();
+  const float* per_sample_weights_data =
+      per_sample_weights.defined() ? per_sample_weights.data<float>() : nullptr;
+  float* output_data = output.data<float>();
+
+  // about GRAIN_SIZE weights to reduce per task
+  const int64_t indices_per_bag = std::max<int64_t>(num_indices / std::max<int64_t>(num_bags, 1), 1);
+  const int64_t grain_size = std::max<int64_t>(
+      internal::GRAIN_SIZE / std::max<int64_t>(dim * indices_per_bag, 1), 1);
+  parallel_for(0, num_bags, grain_size, [&](int64_t begin, int64_t end) {
+    if (bits == 8) {
+      const int64_t first = offsets_data[begin];
+      const int64_t last = end < num_bags ? offsets_data[end] : num_indices;
+      caffe2::Fused8BitRowwiseEmbeddingLookup<int64_t, uint8_t, float>(
+        /*block_size=*/dim,
+        /*output_size=*/end - begin,
+        /*index_size=*/last - first,
+        /*data_size=*/num_rows,
+        /*input=*/packed_weight_data,
+        /*indices=*/indices_data + first,
+        /*lengths=*/lengths.data() + begin,
+        /*weights=*/per_sample_weights_data == nullptr ? nullptr : per_sample_weights_data + first,
+        /*normalize_by_lengths=*/mode == MODE_MEAN,
+        /*out=*/output_data + begin * dim
+      );
+      return;
+    }
+    for (int64_t b = begin; b < end; b++) {
+      float* out = output_data + b * dim;
+      const int64_t bag_begin = offsets_data[b];
+      const int64_t bag_end = bag_begin + lengths[b];
+      for (int64_t i = bag_begin; i < bag_end; i++) {
+        const int64_t index = indices_data[i];
+        AT_CHECK(index >= 0 && index < num_rows,
+            "embedding_bag_rowwise_quantized: index ", index,
+            " is out of bounds for ", num_rows, " rows");
+        const uint8_t* q = packed_weight_data + index * row_bytes;
+        at::Half scale, bias;
+        std::memcpy(&scale, q + dim / 2, sizeof(at::Half));
+        std::memcpy(&bias, q + dim / 2 + sizeof(at::Half), sizeof(at::Half));
+        const float weight = per_sample_weights_data == nullptr ? 1 : per_sample_weights_data[i];
+        const float weighted_scale = weight * static_cast<float>(scale);
+        const float weighted_bias = weight * static_cast<float>(bias);
+        for (int64_t k = 0; k < dim / 2; k++) {
+          out[2 * k] += weighted_scale * (q[k] & 0xf) + weighted_bias;
+          out[2 * k + 1] += weighted_scale * (q[k] >> 4) + weighted_bias;
+        }
+      }
+      if (mode == MODE_MEAN && lengths[b] > 0) {
+        const float inverse_length = 1.0f / lengths[b];
+        for (int64_t k = 0; k < dim; k++) {
+          out[k] *= inverse_length;
+        }
+      }
+    }
+  });
+  return output;
+}
 }
 } // namespace at::native
@@ -0,0 +1,358 @@
+#pragma once
+
+// Portable one-dimensional FFTs, used by the CPU FFT when ATen is built
+// without MKL. See _fft_portable in native/SpectralOpsCPU.cpp.
+
+// define constants like M_PI and C keywords for MSVC
+#ifdef _MSC_VER
+#define _USE_MATH_DEFINES
+#include <math.h>
+#endif
+
+#include <c10/util/Exception.h>
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace at { namespace native { namespace fft {
+
+// Radices larger than this are not done by the generic O(p^2) butterfly;
+// signals with such a prime factor use Bluestein's algorithm instead.
+constexpr int64_t kMaxGenericRadix = 31;
+
+// A complex-to-complex transform of a fixed size and direction:
+//
+//     out[k] = sum_j in[j] * exp(-+ 2 * pi * i * j * k / n)
+//
+// with the minus sign for forward and the plus sign for inverse transforms.
+// Nothing is normalized. Sizes whose prime factors are at most
+// kMaxGenericRadix use a mixed-radix Cooley-Tukey decimation in time, others
+// Bluestein's algorithm on top of a power of two transform.
+//
+// A plan is immutable once created, so one plan can execute several
+// transforms concurrently.
+template <typename T>
+class ComplexPlan {
+ public:
+  using complex_t = std::complex<T>;
+
+  ComplexPlan(int64_t n, bool inverse) : n_(n), inverse_(inverse) {
+    AT_ASSERT(n > 0);
+    twiddles_.resize(n);
+    const double sign = inverse ? 1 : -1;
+    for (int64_t k = 0; k < n; ++k) {
+      const double angle = sign * 2 * M_PI * k / n;
+      twiddles_[k] = complex_t(std::cos(angle), std::sin(angle));
+    }
+
+    int64_t rest = n;
+    while (rest % 4 == 0) {
+      factors_.push_back(4);
+      rest /= 4;
+    }
+    while (rest % 2 == 0) {
+      factors_.push_back(2);
+      rest /= 2;
+    }
+    for (int64_t p = 3; p * p <= rest; p += 2) {
+      while (rest % p == 0) {
+        factors_.push_back(p);
+        rest /= p;
+      }
+    }
+    if (rest > 1 || factors_.empty()) {
+      factors_.push_back(rest);
+    }
+    if (*std::max_element(factors_.begin(), factors_.end()) > kMaxGenericRadix) {
+      init_bluestein();
+    }
+  }
+
+  int64_t size() const {
+    return n_;
+  }
+
+  // `in` holds the n elements in[0], in[in_stride], ..., and `out` must have
+  // room for n contiguous elements that do not overlap the input.
+  void execute(const complex_t* in, int64_t in_stride, complex_t* out) const {
+    if (bluestein_forward_) {
+      execute_bluestein(in, in_stride, out);
+    } else {
+      work(out, in, in_stride, 1, 0, n_);
+    }
+  }
+
+ private:
+  // Transforms the n elements in[0], in[in_stride], ... into out[0:n], with
+  // the radices factors_[factor:] and twiddles_[k * fstride] taking the roles
+  // of the n-th roots of unity.
+  void work(
+      complex_t* out,
+      const complex_t* in,
+      int64_t in_stride,
+      int64_t fstride,
+      size_t factor,
+      int64_t n) const {
+    const int64_t p = factors_[factor];
+    const int64_t m = n / p;
+    if (m == 1) {
+      for (int64_t q = 0; q < p; ++q) {
+        out[q] = in[q * in_stride];
+      }
+    } else {
+      // decimate in time: the q-th subsequence goes to out[q * m:(q + 1) * m]
+      for (int64_t q = 0; q < p; ++q) {
+        work(out + q * m, in + q * in_stride, in_stride * p, fstride * p,
+             factor + 1, m);
+      }
+    }
+    switch (p) {
+      case 2:
+        butterfly2(out, fstride, m);
+        break;
+      case 4:
+        butterfly4(out, fstride, m);
+        break;
+      default:
+        butterfly(out, fstride, p, m);
+    }
+  }
+
+  void butterfly2(complex_t* out, int64_t fstride, int64_t m) const {
+    for (int64_t k = 0; k < m; ++k) {
+      const complex_t t = out[k + m] * twiddles_[k * fstride];
+      out[k + m] = out[k] - t;
+      out[k] += t;
+    }
+  }
+
+  void butterfly4(complex_t* out, int64_t fstride, int64_t m) const {
+    for (int64_t k = 0; k < m; ++k) {
+      const complex_t a0 = out[k];
+      const complex_t a1 = out[k + m] * twiddles_[k * fstride];
+      const complex_t a2 = out[k + 2 * m] * twiddles_[2 * k * fstride];
+      const complex_t a3 = out[k + 3 * m] * twiddles_[3 * k * fstride];
+      const complex_t b0 = a0 + a2;
+      const complex_t b1 = a0 - a2;
+      const complex_t b2 = a1 + a3;
+      // b3 times -i for forward, or i for inverse transforms
+      const complex_t b3 = inverse_ ? complex_t(-(a1 - a3).imag(), (a1 - a3).real())
+                                    : complex_t((a1 - a3).imag(), -(a1 - a3).real());
+      out[k] = b0 + b2;
+      out[k + m] = b1 + b3;
+      out[k + 2 * m] = b0 - b2;
+      out[k + 3 * m] = b1 - b3;
+    }
+  }
+
+  void butterfly(complex_t* out, int64_t fstride, int64_t p, int64_t m) const {
+    std::vector<complex_t> scratch(p);
+    for (int64_t k = 0; k < m; ++k) {
+      for (int64_t q = 0; q < p; ++q) {
+        scratch[q] = out[k + q * m] * twiddles_[(q * k * fstride) % n_];
+      }
+      // exp(-+ 2 * pi * i * q * s / p) is twiddles_[q * s * fstride * m]
+      for (int64_t s = 0; s < p; ++s) {
+        complex_t sum = scratch[0];
+        for (int64_t q = 1; q < p; ++q) {
+          sum += scratch[q] * twiddles_[(q * s * fstride * m) % n_];
+        }
+        out[k + s * m] = sum;
+      }
+    }
+  }
+
+  // Bluestein's algorithm writes the transform as a convolution,
+  //
+  //     out[k] = chirp[k] * sum_j (in[j] * chirp[j]) * conj(chirp[k - j]),
+  //     chirp[j] = exp(-+ pi * i * j^2 / n),
+  //
+  // which is done by power of two transforms of size >= 2n - 1.
+  void init_bluestein() {
+    int64_t m = 1;
+    while (m < 2 * n_ - 1) {
+      m *= 2;
+    }
+    bluestein_forward_.reset(new ComplexPlan(m, /*inverse=*/false));
+    bluestein_inverse_.reset(new ComplexPlan(m, /*inverse=*/true));
+
+    const double sign = inverse_ ? 1 : -1;
+    chirp_.resize(n_);
+    for (int64_t j = 0; j < n_; ++j) {
+      // j^2 mod 2n keeps the angle small, and precise
+      const int64_t j2 = (j * j) % (2 * n_);
+      const double angle = sign * M_PI * j2 / n_;
+      chirp_[j] = complex_t(std::cos(angle), std::sin(angle));
+    }
+    std::vector<complex_t> kernel(m, complex_t(0));
+    kernel[0] = std::conj(chirp_[0]);
+    for (int64_t j = 1; j < n_; ++j) {
+      kernel[j] = kernel[m - j] = std::conj(chirp_[j]);
+    }
+    // fold in the 1 / m of the inverse transform of the convolution
+    kernel_fft_.resize(m);
+    bluestein_forward_->execute(kernel.data(), 1, kernel_fft_.data());
+    for (auto& value : kernel_fft_) {
+      value /= static_cast<T>(m);
+    }
+  }
+
+  void execute_bluestein(
+      const complex_t* in,
+      int64_t in_stride,
+      complex_t* out) const {
+    const int64_t m = bluestein_forward_->size();
+    std::vector<complex_t> a(m, complex_t(0));
+    std::vector<complex_t> b(m);
+    for (int64_t j = 0; j < n_; ++j) {
+      a[j] = in[j * in_stride] * chirp_[j];
+    }
+    bluestein_forward_->execute(a.data(), 1, b.data());
+    for (int64_t j = 0; j < m; ++j) {
+      b[j] *= kernel_fft_[j];
+    }
+    bluestein_inverse_->execute(b.data(), 1, a.data());
+    for (int64_t k = 0; k < n_; ++k) {
+      out[k] = a[k] * chirp_[k];
+    }
+  }
+
+  int64_t n_;
+  bool inverse_;
+  std::vector<int64_t> factors_;
+  std::vector<complex_t> twiddles_;
+
+  std::unique_ptr<ComplexPlan> bluestein_forward_;
+  std::unique_ptr<ComplexPlan> bluestein_inverse_;
+  std::vector<complex_t> chirp_;
+  std::vector<complex_t> kernel_fft_;
+};
+
+// A real-to-complex (forward) or complex-to-real (inverse) transform of n
+// real values, of which only the n / 2 + 1 first complex values are stored,
+// the others following by conjugate symmetry. See NOTE [ Fourier Transform
+// Conjugate Symmetry ] in native/SpectralOpsUtils.h. Like ComplexPlan,
+// nothing is normalized.
+//
+// Even sizes are done by a complex transform of size n / 2 on the even and
+// odd values packed as the real and imaginary parts, and odd sizes by a
+// complex transform of size n.
+template <typename T>
+class RealPlan {
+ public:
+  using complex_t = std::complex<T>;
+
+  RealPlan(int64_t n, bool inverse)
+      : n_(n),
+        inverse_(inverse),
+        complex_plan_(n % 2 == 0 ? n / 2 : n, inverse) {
+    if (n % 2 == 0) {
+      const double sign = inverse ? 1 : -1;
+      twiddles_.resize(n / 2 + 1);
+      for (int64_t k = 0; k <= n / 2; ++k) {
+        const double angle = sign * 2 * M_PI * k / n;
+        twiddles_[k] = complex_t(std::cos(angle), std::sin(angle));
+      }
+    }
+  }
+
+  int64_t size() const {
+    return n_;
+  }
+
+  // Forward: n real values in[0], in[in_stride], ... to n / 2 + 1
+  // contiguous complex values.
+  void execute(const T* in, int64_t in_stride, complex_t* out) const {
+    AT_ASSERT(!inverse_);
+    const int64_t half = n_ / 2;
+    if (n_ % 2 != 0) {
+      std::vector<complex_t> a(n_);
+      std::vector<complex_t> b(n_);
+      for (int64_t j = 0; j < n_; ++j) {
+        a[j] = complex_t(in[j * in_stride], 0);
+      }
+      complex_plan_.execute(a.data(), 1, b.data());
+      std::copy(b.begin(), b.begin() + half + 1, out);
+      return;
+    }
+    std::vector<complex_t> z(half);
+    std::vector<complex_t> transformed(half);
+    for (int64_t j = 0; j < half; ++j) {
+      z[j] = complex_t(in[2 * j * in_stride], in[(2 * j + 1) * in_stride]);
+    }
+    complex_plan_.execute(z.data(), 1, transformed.data());
+    // With E and O the transforms of the even and odd values,
+    //   X[k] = E[k] + w^k O[k],
+    //   E[k] = (Z[k] + conj(Z[half - k])) / 2,
+    //   O[k] = (Z[k] - conj(Z[half - k])) / 2i.
+    for (int64_t k = 0; k <= half; ++k) {
+      const complex_t zk = transformed[k % half];
+      const complex_t znk = std::conj(transformed[(half - k) % half]);
+      const complex_t even = (zk + znk) * static_cast<T>(0.5);
+      const complex_t diff = (zk - znk) * static_cast<T>(0.5);
+      const complex_t odd(diff.imag(), -diff.real());
+      out[k] = even + twiddles_[k] * odd;
+    }
+  }
+
+  // Inverse: n / 2 + 1 complex values in[0], in[in_stride], ... to n
+  // real values out[0], out[out_stride], ... The imaginary parts that
+  // conjugate symmetry requires to be zero are ignored.
+  void execute_inverse(
+      const complex_t* in,
+      int64_t in_stride,
+      T* out,
+      int64_t out_stride) const {
+    AT_ASSERT(inverse_);
+    const int64_t half = n_ / 2;
+    if (n_ % 2 != 0) {
+      std::vector<complex_t> a(n_);
+      std::vector<complex_t> b(n_);
+      for (int64_t k = 0; k <= half; ++k) {
+        a[k] = in[k * in_stride];
+      }
+      for (int64_t k = half + 1; k < n_; ++k) {
+        a[k] = std::conj(a[n_ - k]);
+      }
+      a[0].imag(0);
+      complex_plan_.execute(a.data(), 1, b.data());
+      for (int64_t j = 0; j < n_; ++j) {
+        out[j * out_stride] = b[j].real();
+      }
+      return;
+    }
+    // The inverse of the forward packing above, scaled by 2 so that the
+    // transform of size n / 2 comes out unnormalized for size n.
+    std::vector<complex_t> z(half);
+    std::vector<complex_t> transformed(half);
+    for (int64_t k = 0; k < half; ++k) {
+      complex_t xk = in[k * in_stride];
+      complex_t xnk = std::conj(in[(half - k) * in_stride]);
+      if (k == 0) {
+        xk.imag(0);
+        xnk.imag(0);
+      }
+      const complex_t even = xk + xnk;
+      const complex_t odd = (xk - xnk) * twiddles_[k];
+      z[k] = even + complex_t(-odd.imag(), odd.real());
+    }
+    complex_plan_.execute(z.data(), 1, transformed.data());
+    for (int64_t j = 0; j < half; ++j) {
+      out[2 * j * out_stride] = transformed[j].real();
+      out[(2 * j + 1) * out_stride] = transformed[j].imag();
+    }
+  }
+
+ private:
+  int64_t n_;
+  bool inverse_;
+  ComplexPlan<T> complex_plan_;
+  // exp(-+ 2 * pi * i * k / n), k <= n / 2, for even n
+  std::vector<complex_t> twiddles_;
+};
+
+}}} // namespace at::native::fft
@@ -0,0 +1,127 @@
+#pragma once
+// Please note that this file is
+// used across both CPU and GPU.
+
+#include <c10/macros/Macros.h>
+#if defined(__CUDACC__)
+#include <ATen/native/cuda/DeviceSqrt.cuh>
+#elif defined(__HIPCC__)
+#include <ATen/native/hip/DeviceSqrt.cuh>
+#else
+#include <cmath>
+#define device_sqrt std::sqrt
+#endif
+
+namespace at { namespace native {
+
+// The element-wise updates of the fused optimizer steps. ptrs holds the
+// element i of every list in the order of the fused_*_step arguments, and
+// the pointers of the lists that are not used are null. The math is done in
+// acc_t.
+
+template <typename scalar_t, typename acc_t>
+struct SGDStepOp {
+  acc_t lr;
+  acc_t weight_decay;
+  acc_t momentum;
+  acc_t dampening;
+  bool nesterov;
+
+  // ptrs: param, grad, momentum buffer
+  C10_HOST_DEVICE void operator()(scalar_t* const* ptrs, int64_t i) const {
+    acc_t param = ptrs[0][i];
+    acc_t grad = ptrs[1][i];
+    bool grad_changed = false;
+    if (weight_decay > 0) {
+      grad += weight_decay * param;
+      grad_changed = true;
+    }
+    acc_t update = grad;
+    if (ptrs[2] != nullptr) {
+      acc_t buf = momentum * static_cast<acc_t>(ptrs[2][i]) + dampening * grad;
+      ptrs[2][i] = buf;
+      if (nesterov) {
+        grad += momentum * buf;
+        grad_changed = true;
+        update = grad;
+      } else {
+        update = buf;
+      }
+    }
+    if (grad_changed) {
+      ptrs[1][i] = grad;
+    }
+    ptrs[0][i] = param - lr * update;
+  }
+};
+
+template <typename scalar_t, typename acc_t>
+struct AdamStepOp {
+  acc_t step_size;
+  acc_t beta1;
+  acc_t beta2;
+  acc_t eps;
+  acc_t weight_decay;
+
+  // ptrs: param, grad, exp_avg, exp_avg_sq, max_exp_avg_sq
+  C10_HOST_DEVICE void operator()(scalar_t* const* ptrs, int64_t i) const {
+    acc_t param = ptrs[0][i];
+    acc_t grad = ptrs[1][i];
+    if (weight_decay > 0) {
+      grad += weight_decay * param;
+      ptrs[1][i] = grad;
+    }
+    acc_t exp_avg = beta1 * static_cast<acc_t>(ptrs[2][i]) + (1 - beta1) * grad;
+    acc_t exp_avg_sq = beta2 * static_cast<acc_t>(ptrs[3][i]) + (1 - beta2) * grad * grad;
+    ptrs[2][i] = exp_avg;
+    ptrs[3][i] = exp_avg_sq;
+    acc_t denom = exp_avg_sq;
+    if (ptrs[4] != nullptr) {
+      acc_t max_exp_avg_sq = ptrs[4][i];
+      if (exp_avg_sq > max_exp_avg_sq) {
+        max_exp_avg_sq = exp_avg_sq;
+      }
+      ptrs[4][i] = max_exp_avg_sq;
+      denom = max_exp_avg_sq;
+    }
+    ptrs[0][i] = param - step_size * exp_avg / (device_sqrt(denom) + eps);
+  }
+};
+
+template <typename scalar_t, typename acc_t>
+struct RMSpropStepOp {
+  acc_t lr;
+  acc_t alpha;
+  acc_t eps;
+  acc_t weight_decay;
+  acc_t momentum;
+
+  // ptrs: param, grad, square_avg, grad_avg, momentum buffer
+  C10_HOST_DEVICE void operator()(scalar_t* const* ptrs, int64_t i) const {
+    acc_t param = ptrs[0][i];
+    acc_t grad = ptrs[1][i];
+    if (weight_decay > 0) {
+      grad += weight_decay * param;
+      ptrs[1][i] = grad;
+    }
+    acc_t square_avg = alpha * static_cast<acc_t>(ptrs[2][i]) + (1 - alpha) * grad * grad;
+    ptrs[2][i] = square_avg;
+    acc_t avg;
+    if (ptrs[3] != nullptr) {
+      acc_t grad_avg = alpha * static_cast<acc_t>(ptrs[3][i]) + (1 - alpha) * grad;
+      ptrs[3][i] = grad_avg;
+      avg = device_sqrt(square_avg - grad_avg * grad_avg) + eps;
+    } else {
+      avg = device_sqrt(square_avg) + eps;
+    }
+    if (ptrs[4] != nullptr) {
+      acc_t buf = momentum * static_cast<acc_t>(ptrs[4][i]) + grad / avg;
+      ptrs[4][i] = buf;
+      ptrs[0][i] = param - lr * buf;
+    } else {
+      ptrs[0][i] = param - lr * grad / avg;
+    }
+  }
+};
+
+}} // namespace at::native
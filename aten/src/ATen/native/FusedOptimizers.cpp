@@ -0,0 +1,102 @@
+#include <ATen/native/FusedOptimizers.h>
+
+#include <ATen/ATen.h>
+#include <ATen/DeviceGuard.h>
+
+#include <initializer_list>
+
+namespace at { namespace native {
+
+DEFINE_DISPATCH(fused_sgd_stub);
+DEFINE_DISPATCH(fused_adam_stub);
+DEFINE_DISPATCH(fused_rmsprop_stub);
+
+bool can_use_fused_optimizer_step(TensorList tensors) {
+  if (tensors.empty() || !tensors[0].defined()) {
+    return false;
+  }
+  const auto device = tensors[0].device();
+  const auto dtype = tensors[0].scalar_type();
+  if (!(device.is_cpu() || device.is_cuda()) ||
+      !(dtype == kFloat || dtype == kDouble || (dtype == kHalf && device.is_cuda()))) {
+    return false;
+  }
+  for (const auto& t : tensors) {
+    if (!t.defined() || t.layout() != kStrided || t.device() != device ||
+        t.scalar_type() != dtype || !t.is_contiguous()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void check_fused_lists(
+    const char* name, TensorList params,
+    std::initializer_list<TensorList> required,
+    std::initializer_list<TensorList> optional) {
+  std::vector<Tensor> tensors(params.begin(), params.end());
+  auto check_list = [&](TensorList list) {
+    AT_CHECK(list.size() == params.size(), name, ": expected lists of ",
+             params.size(), " tensors, but got one of ", list.size());
+    for (size_t i = 0; i < list.size(); i++) {
+      AT_CHECK(list[i].numel() == params[i].numel(), name, ": expected tensor ",
+               i, " of every list to have ", params[i].numel(),
+               " elements, but got ", list[i].numel());
+      tensors.push_back(list[i]);
+    }
+  };
+  for (const auto& list : required) {
+    check_list(list);
+  }
+  for (const auto& list : optional) {
+    if (!list.empty()) {
+      check_list(list);
+    }
+  }
+  AT_CHECK(can_use_fused_optimizer_step(tensors), name,
+           ": expected contiguous dense tensors of the same floating point "
+           "dtype on the same CPU or CUDA device");
+}
+
+void fused_sgd_step(
+    TensorList params, TensorList grads, TensorList momentum_buffers,
+    double lr, double weight_decay, double momentum, double dampening,
+    bool nesterov) {
+  if (params.empty()) {
+    return;
+  }
+  check_fused_lists("fused_sgd_step", params, {grads}, {momentum_buffers});
+  const OptionalDeviceGuard device_guard(device_of(params[0]));
+  fused_sgd_stub(params[0].device().type(), params, grads, momentum_buffers,
+                 lr, weight_decay, momentum, dampening, nesterov);
+}
+
+void fused_adam_step(
+    TensorList params, TensorList grads, TensorList exp_avgs,
+    TensorList exp_avg_sqs, TensorList max_exp_avg_sqs, double step_size,
+    double beta1, double beta2, double eps, double weight_decay) {
+  if (params.empty()) {
+    return;
+  }
+  check_fused_lists("fused_adam_step", params, {grads, exp_avgs, exp_avg_sqs}, {max_exp_avg_sqs});
+  const OptionalDeviceGuard device_guard(device_of(params[0]));
+  fused_adam_stub(params[0].device().type(), params, grads, exp_avgs,
+                  exp_avg_sqs, max_exp_avg_sqs, step_size, beta1, beta2, eps,
+                  weight_decay);
+}
+
+void fused_rmsprop_step(
+    TensorList params, TensorList grads, TensorList square_avgs,
+    TensorList grad_avgs, TensorList momentum_buffers, double lr,
+    double alpha, double eps, double weight_decay, double momentum) {
+  if (params.empty()) {
+    return;
+  }
+  check_fused_lists("fused_rmsprop_step", params, {grads, square_avgs}, {grad_avgs, momentum_buffers});
+  const OptionalDeviceGuard device_guard(device_of(params[0]));
+  fused_rmsprop_stub(params[0].device().type(), params, grads, square_avgs,
+                     grad_avgs, momentum_buffers, lr, alpha, eps,
+                     weight_decay, momentum);
+}
+
+}} // namespace at::native
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+namespace at { namespace native {
+
+// Optimizer steps that update a whole list of parameters in a single pass
+// over the elements of each, instead of launching one kernel per operation
+// and parameter. On CUDA, the parameters are processed in chunks of tensors
+// per kernel launch. The lists of state an option does not use are empty,
+// the others match params one to one. Gradients that the step modifies, like
+// with weight decay, are updated in place as the unfused steps would.
+using fused_sgd_fn = void(*)(
+    TensorList params, TensorList grads, TensorList momentum_buffers,
+    double lr, double weight_decay, double momentum, double dampening,
+    bool nesterov);
+using fused_adam_fn = void(*)(
+    TensorList params, TensorList grads, TensorList exp_avgs,
+    TensorList exp_avg_sqs, TensorList max_exp_avg_sqs, double step_size,
+    double beta1, double beta2, double eps, double weight_decay);
+using fused_rmsprop_fn = void(*)(
+    TensorList params, TensorList grads, TensorList square_avgs,
+    TensorList grad_avgs, TensorList momentum_buffers, double lr,
+    double alpha, double eps, double weight_decay, double momentum);
+
+DECLARE_DISPATCH(fused_sgd_fn, fused_sgd_stub);
+DECLARE_DISPATCH(fused_adam_fn, fused_adam_stub);
+DECLARE_DISPATCH(fused_rmsprop_fn, fused_rmsprop_stub);
+
+// Whether the fused steps support these tensors: they must be dense and
+// contiguous, and share a floating point dtype and a CPU or CUDA device.
+CAFFE2_API bool can_use_fused_optimizer_step(TensorList tensors);
+
+// SGD with momentum when momentum_buffers is not empty. dampening is the
+// factor of the gradient in the momentum update, it is 1 on the first step.
+CAFFE2_API void fused_sgd_step(
+    TensorList params, TensorList grads, TensorList momentum_buffers,
+    double lr, double weight_decay, double momentum, double dampening,
+    bool nesterov);
+// Adam, and AMSGrad when max_exp_avg_sqs is not empty. step_size includes
+// the bias corrections.
+CAFFE2_API void fused_adam_step(
+    TensorList params, TensorList grads, TensorList exp_avgs,
+    TensorList exp_avg_sqs, TensorList max_exp_avg_sqs, double step_size,
+    double beta1, double beta2, double eps, double weight_decay);
+// RMSprop, centered when grad_avgs is not empty and with momentum when
+// momentum_buffers is not empty.
+CAFFE2_API void fused_rmsprop_step(
+    TensorList params, TensorList grads, TensorList square_avgs,
+    TensorList grad_avgs, TensorList momentum_buffers, double lr,
+    double alpha, double eps, double weight_decay, double momentum);
+
+}} // namespace at::native
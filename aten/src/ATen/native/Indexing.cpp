@@ -65,6 +65,10 @@ namespace at { namespace native {
 
 DEFINE_DISPATCH(index_stub);
 DEFINE_DISPATCH(index_put_stub);
+DEFINE_DISPATCH(index_select_rows_stub);
+DEFINE_DISPATCH(index_add_rows_stub);
+DEFINE_DISPATCH(gather_lastdim_stub);
+DEFINE_DISPATCH(scatter_lastdim_stub);
 
 [[noreturn]]
 static void invalid_mask(const Tensor & self, int64_t idx, const Tensor & mask, int64_t maskIdx) {
@@ -431,11 +435,28 @@ static std::unique_ptr<TensorIterator> make_index_put_iterator(const AdvancedInd
   return builder.build();
 }
 
+// x[index] with a single LongTensor index into the first dimension of a
+// contiguous CPU tensor selects whole rows, see index_select_rows_stub.
+static bool can_select_rows(const Tensor& self, TensorList indices) {
+  return self.device().type() == kCPU && self.dim() > 0 && self.is_contiguous() &&
+      indices.size() == 1 && indices[0].defined() &&
+      indices[0].scalar_type() == kLong && indices[0].device() == self.device();
+}
+
 Tensor index(const Tensor & self, TensorList indices) {
   if (indices.size() > (size_t)self.dim()) {
     AT_INDEX_ERROR("too many indices for tensor of dimension ", self.dim(), " (got ", indices.size(), ")");
   }
 
+  if (can_select_rows(self, indices)) {
+    auto index = indices[0].contiguous();
+    auto sizes = index.sizes().vec();
+    sizes.insert(sizes.end(), self.sizes().begin() + 1, self.sizes().end());
+    auto result = at::empty(sizes, self.options());
+    index_select_rows_stub(kCPU, result, self, index, /*wrap_negative=*/true);
+    return result;
+  }
+
   auto info = make_info(self, indices);
   auto iter = make_index_iterator(info);
   index_stub(iter->device_type(), *iter, info.indexed_sizes, info.indexed_strides);
@@ -456,6 +477,19 @@ Tensor & index_put_(Tensor & self, TensorList indices, const Tensor & value, boo
     std::tie(expandedValue) = expand_inplace(linearIndex, value);
     return src.put_(linearIndex, expandedValue, true);
   }
+  if (accumulate && can_select_rows(self, indices)) {
+    // the rows are accumulated in parallel, see index_add_rows_stub
+    auto index = indices[0].contiguous();
+    auto sizes = index.sizes().vec();
+    sizes.insert(sizes.end(), self.sizes().begin() + 1, self.sizes().end());
+    if (!is_expandable_to(value.sizes(), sizes)) {
+      AT_ERROR("shape mismatch: value tensor of shape ", value.sizes(),
+               " cannot be broadcast to indexing result of shape ", IntArrayRef(sizes));
+    }
+    auto source = value.to(self.options()).expand(sizes).contiguous();
+    index_add_rows_stub(kCPU, self, index, source, /*wrap_negative=*/true);
+    return self;
+  }
   auto info = make_info(self, indices);
   auto iter = make_index_put_iterator(info, value);
   index_put_stub(iter->device_type(), *iter, info.indexed_sizes, info.indexed_strides, accumulate);
@@ -503,6 +537,128 @@ Tensor & index_copy_(Tensor & self, int64_t dim, const Tensor & index, const Ten
   return at::legacy::th::_th_index_copy_(self, dim, index, source);
 }
 
+static bool can_use_index_select_rows(const Tensor & self, int64_t dim, const Tensor & index) {
+  return self.device().type() == kCPU && index.device().type() == kCPU &&
+      self.dim() > 0 && (dim == 0 || dim == -self.dim()) && self.is_contiguous() &&
+      index.scalar_type() == kLong && index.dim() <= 1;
+}
+
+Tensor & index_select_out(Tensor & result, const Tensor & self, int64_t dim, const Tensor & index) {
+  if (can_use_index_select_rows(self, dim, index) && result.scalar_type() == self.scalar_type()) {
+    auto sizes = self.sizes().vec();
+    sizes[0] = index.numel();
+    result.resize_(sizes);
+    if (result.is_contiguous()) {
+      index_select_rows_stub(kCPU, result, self, index.contiguous(), /*wrap_negative=*/false);
+      return result;
+    }
+  }
+  return at::legacy::th::_th_index_select_out(result, self, dim, index);
+}
+
+Tensor index_select(const Tensor & self, int64_t dim, const Tensor & index) {
+  if (can_use_index_select_rows(self, dim, index)) {
+    Tensor result = at::empty({0}, self.options());
+    return at::native::index_select_out(result, self, dim, index);
+  }
+  return at::legacy::th::_th_index_select(self, dim, index);
+}
+
+// gather/scatter along the last dimension of contiguous CPU tensors whose
+// other dimensions match, see gather_lastdim_stub and scatter_lastdim_stub.
+// Everything else, including the error reporting for mismatched shapes, is
+// left to TH.
+static bool can_use_lastdim_kernel(const Tensor & self, int64_t dim, const Tensor & index) {
+  if (self.device().type() != kCPU || index.device().type() != kCPU ||
+      self.dim() == 0 || index.dim() != self.dim() || index.numel() == 0 ||
+      index.scalar_type() != kLong || (dim != self.dim() - 1 && dim != -1) ||
+      !self.is_contiguous() || !index.is_contiguous()) {
+    return false;
+  }
+  for (int64_t d = 0; d < self.dim() - 1; d++) {
+    if (index.size(d) != self.size(d)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool can_use_scatter_lastdim_kernel(const Tensor & self, int64_t dim, const Tensor & index, const Tensor & src) {
+  if (!can_use_lastdim_kernel(self, dim, index) || src.scalar_type() != self.scalar_type() ||
+      src.dim() != self.dim() || !src.is_contiguous() || src.size(-1) < index.size(-1)) {
+    return false;
+  }
+  for (int64_t d = 0; d < self.dim() - 1; d++) {
+    if (src.size(d) != self.size(d)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Tensor & gather_out(Tensor & result, const Tensor & self, int64_t dim, const Tensor & index, bool sparse_grad) {
+  if (can_use_lastdim_kernel(self, dim, index) && result.scalar_type() == self.scalar_type()) {
+    result.resize_(index.sizes());
+    if (result.is_contiguous()) {
+      gather_lastdim_stub(kCPU, result, self, index);
+      return result;
+    }
+  }
+  return at::legacy::th::_th_gather_out(result, self, dim, index);
+}
+
+Tensor gather(const Tensor & self, int64_t dim, const Tensor & index, bool sparse_grad) {
+  if (can_use_lastdim_kernel(self, dim, index)) {
+    Tensor result = at::empty(index.sizes(), self.options());
+    gather_lastdim_stub(kCPU, result, self, index);
+    return result;
+  }
+  return at::legacy::th::_th_gather(self, dim, index);
+}
+
+Tensor & scatter_(Tensor& self, int64_t dim, const Tensor & index, const Tensor & src) {
+  if (can_use_scatter_lastdim_kernel(self, dim, index, src)) {
+    scatter_lastdim_stub(kCPU, self, index, src, /*accumulate=*/false);
+    return self;
+  }
+  return at::legacy::th::_th_scatter_(self, dim, index, src);
+}
+
+Tensor & scatter_add_(Tensor& self, int64_t dim, const Tensor & index, const Tensor & src) {
+  if (can_use_scatter_lastdim_kernel(self, dim, index, src)) {
+    scatter_lastdim_stub(kCPU, self, index, src, /*accumulate=*/true);
+    return self;
+  }
+  return at::legacy::th::_th_scatter_add_(self, dim, index, src);
+}
+
+// index_add_ along the first dimension of contiguous CPU tensors, see
+// index_add_rows_stub. Everything else, including the error reporting for
+// mismatched shapes, is left to TH.
+static bool can_use_index_add_rows(const Tensor & self, int64_t dim, const Tensor & index, const Tensor & source) {
+  if (self.device().type() != kCPU || index.device().type() != kCPU || source.device().type() != kCPU ||
+      self.dim() == 0 || maybe_wrap_dim(dim, self.dim()) != 0 || index.dim() > 1 ||
+      index.scalar_type() != kLong || source.scalar_type() != self.scalar_type() ||
+      source.dim() != self.dim() || source.size(0) != index.numel() ||
+      !self.is_contiguous() || !source.is_contiguous()) {
+    return false;
+  }
+  for (int64_t d = 1; d < self.dim(); d++) {
+    if (source.size(d) != self.size(d)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Tensor & index_add_(Tensor & self, int64_t dim, const Tensor & index, const Tensor & source) {
+  if (can_use_index_add_rows(self, dim, index, source)) {
+    index_add_rows_stub(kCPU, self, index.contiguous(), source, /*wrap_negative=*/false);
+    return self;
+  }
+  return at::legacy::th::_th_index_add_(self, dim, index, source);
+}
+
 Tensor index_copy(const Tensor & self, int64_t dim, const Tensor & index, const Tensor & source) {
   return self.clone().index_copy_(dim, index, source);
 }
@@ -13,8 +13,18 @@ namespace at { namespace native {
 
 using index_fn = void(*)(TensorIterator &, IntArrayRef indexed_sizes, IntArrayRef indexed_strides);
 using index_put_fn = void(*)(TensorIterator &, IntArrayRef indexed_sizes, IntArrayRef indexed_strides, bool accumulate);
+// Fast paths for contiguous tensors, see the helpers in Indexing.cpp for when
+// they apply.
+using index_select_rows_fn = void(*)(Tensor & result, const Tensor & self, const Tensor & index, bool wrap_negative);
+using index_add_rows_fn = void(*)(Tensor & self, const Tensor & index, const Tensor & source, bool wrap_negative);
+using gather_lastdim_fn = void(*)(Tensor & result, const Tensor & self, const Tensor & index);
+using scatter_lastdim_fn = void(*)(Tensor & self, const Tensor & index, const Tensor & src, bool accumulate);
 
 DECLARE_DISPATCH(index_fn, index_stub);
 DECLARE_DISPATCH(index_put_fn, index_put_stub);
+DECLARE_DISPATCH(index_select_rows_fn, index_select_rows_stub);
+DECLARE_DISPATCH(index_add_rows_fn, index_add_rows_stub);
+DECLARE_DISPATCH(gather_lastdim_fn, gather_lastdim_stub);
+DECLARE_DISPATCH(scatter_lastdim_fn, scatter_lastdim_stub);
 
 }} // namespace at::native
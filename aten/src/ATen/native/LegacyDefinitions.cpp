@@ -93,10 +93,6 @@ Tensor & put_(Tensor& self, const Tensor & index, const Tensor & source, bool ac
   return at::legacy::th::_th_put_(self, index, source, accumulate);
 }
 
-Tensor & index_add_(Tensor& self, int64_t dim, const Tensor & index, const Tensor & source) {
-  return at::legacy::th::_th_index_add_(self, dim, index, source);
-}
-
 Tensor & index_fill_(Tensor& self, int64_t dim, const Tensor & index, Scalar value) {
   return at::legacy::th::_th_index_fill_(self, dim, index, value);
 }
@@ -105,18 +101,10 @@ Tensor & index_fill_(Tensor& self, int64_t dim, const Tensor & index, const Tens
   return at::legacy::th::_th_index_fill_(self, dim, index, value);
 }
 
-Tensor & scatter_(Tensor& self, int64_t dim, const Tensor & index, const Tensor & src) {
-  return at::legacy::th::_th_scatter_(self, dim, index, src);
-}
-
 Tensor & scatter_(Tensor& self, int64_t dim, const Tensor & index, Scalar value) {
   return at::legacy::th::_th_scatter_(self, dim, index, value);
 }
 
-Tensor & scatter_add_(Tensor& self, int64_t dim, const Tensor & index, const Tensor & src) {
-  return at::legacy::th::_th_scatter_add_(self, dim, index, src);
-}
-
 Tensor & lt_(Tensor& self, Scalar other) {
   return at::legacy::th::_th_lt_(self, other);
 }
@@ -249,11 +237,11 @@ Tensor & random_(Tensor& self, Generator * generator) {
   return at::legacy::th::_th_random_(self, generator);
 }
 
-Tensor & uniform_(Tensor& self, double from, double to, Generator * generator) {
+Tensor & uniform_cuda_(Tensor& self, double from, double to, Generator * generator) {
   return at::legacy::th::_th_uniform_(self, from, to, generator);
 }
 
-Tensor & normal_(Tensor& self, double mean, double std, Generator * generator) {
+Tensor & normal_cuda_(Tensor& self, double mean, double std, Generator * generator) {
   return at::legacy::th::_th_normal_(self, mean, std, generator);
 }
 
@@ -391,14 +379,6 @@ Tensor take(const Tensor & self, const Tensor & index) {
   return at::legacy::th::_th_take(self, index);
 }
 
-Tensor & index_select_out(Tensor & result, const Tensor & self, int64_t dim, const Tensor & index) {
-  return at::legacy::th::_th_index_select_out(result, self, dim, index);
-}
-
-Tensor index_select(const Tensor & self, int64_t dim, const Tensor & index) {
-  return at::legacy::th::_th_index_select(self, dim, index);
-}
-
 Tensor & masked_select_out(Tensor & result, const Tensor & self, const Tensor & mask) {
   return at::legacy::th::_th_masked_select_out(result, self, mask);
 }
@@ -419,14 +399,6 @@ Tensor nonzero(const Tensor & self) {
   return at::legacy::th::_th_nonzero(self);
 }
 
-Tensor & gather_out(Tensor & result, const Tensor & self, int64_t dim, const Tensor & index, bool sparse_grad) {
-  return at::legacy::th::_th_gather_out(result, self, dim, index);
-}
-
-Tensor gather(const Tensor & self, int64_t dim, const Tensor & index, bool sparse_grad) {
-  return at::legacy::th::_th_gather(self, dim, index);
-}
-
 Tensor & addcmul_out(Tensor & result, const Tensor & self, const Tensor & tensor1, const Tensor & tensor2, Scalar value) {
   return at::legacy::th::_th_addcmul_out(result, self, tensor1, tensor2, value);
 }
@@ -590,14 +562,6 @@ Tensor atan2(const Tensor & self, const Tensor & other) {
   return at::legacy::th::_th_atan2(self, other);
 }
 
-Tensor & _histc_out_cpu(Tensor & result, const Tensor & self, int64_t bins, Scalar min, Scalar max) {
-  return at::legacy::th::_th_histc_out(result, self, bins, min, max);
-}
-
-Tensor _histc_cpu(const Tensor & self, int64_t bins, Scalar min, Scalar max) {
-  return at::legacy::th::_th_histc(self, bins, min, max);
-}
-
 Tensor & sign_out(Tensor & result, const Tensor & self) {
   return at::legacy::th::_th_sign_out(result, self);
 }
@@ -661,26 +625,6 @@ Tensor max(const Tensor & self) {
   return at::legacy::th::_th_max(self);
 }
 
-std::tuple<Tensor &,Tensor &> sort_out(Tensor & values, Tensor & indices, const Tensor & self, int64_t dim, bool descending) {
-  return at::legacy::th::_th_sort_out(values, indices, self, dim, descending);
-}
-
-std::tuple<Tensor,Tensor> sort(const Tensor & self, int64_t dim, bool descending) {
-  return at::legacy::th::_th_sort(self, dim, descending);
-}
-
-Tensor argsort(const Tensor & self, int64_t dim, bool descending) {
-  return std::get<1>(at::legacy::th::_th_sort(self, dim, descending));
-}
-
-std::tuple<Tensor &,Tensor &> topk_out(Tensor & values, Tensor & indices, const Tensor & self, int64_t k, int64_t dim, bool largest, bool sorted) {
-  return at::legacy::th::_th_topk_out(values, indices, self, k, dim, largest, sorted);
-}
-
-std::tuple<Tensor,Tensor> topk(const Tensor & self, int64_t k, int64_t dim, bool largest, bool sorted) {
-  return at::legacy::th::_th_topk(self, k, dim, largest, sorted);
-}
-
 Tensor & renorm_out(Tensor & result, const Tensor & self, Scalar p, int64_t dim, Scalar maxnorm) {
   return at::legacy::th::_th_renorm_out(result, self, p, dim, maxnorm);
 }
@@ -4,6 +4,7 @@
 #include <ATen/NativeFunctions.h>
 #include <ATen/LegacyTHFunctions.h>
 #include <ATen/native/LinearAlgebraUtils.h>
+#include <ATen/native/SmallGemm.h>
 #include <ATen/TensorUtils.h>
 #include <ATen/Parallel.h>
 #include <functional>
@@ -14,6 +15,8 @@
 namespace at {
 namespace native {
 
+DEFINE_DISPATCH(small_bmm_stub);
+
 // Helper function for det methods.
 // For pivoted LU factorization A = P * L * U. Since we always have det(L) = 1,
 // det(P) = \pm 1, this method returns a 3-tuple:
@@ -255,6 +258,10 @@ inline void baddbmm_cpu_kernel(const Tensor& result, const Tensor& self, const T
 }
 
 // This tries to apply some optimizations to bmm/baddbmm:
+// - When the matrices are floating point and at most kSmallGemmMaxSize in every
+//   dimension, a register blocked, vectorized kernel is applied to the matrices
+//   in parallel (see small_bmm_stub), since BLAS calls cost more than the
+//   arithmetic of such matrices.
 // - When the operand size is small, computation are parallelized over the batch
 //   dimension using OMP and naive matrix multiplication is applied.
 // - When the operand size is larger than the threshold, if compiled with MKL, MKL's batch gemm is used.
@@ -301,7 +308,9 @@ static inline Tensor& bmm_out_or_baddbmm_(Tensor& self_or_result, const Tensor&
             || (t.stride(1) == 1 && t.stride(2) >= t.size(1));
   };
 
-  if (contraction_size * res_rows * res_cols < 400) {
+  if (can_use_small_bmm(self_or_result, batch1, batch2)) {
+    small_bmm_stub(kCPU, self_or_result, batch1, batch2, beta, alpha, is_bmm_out);
+  } else if (contraction_size * res_rows * res_cols < 400) {
     if (is_bmm_out) {
       AT_DISPATCH_ALL_TYPES(batch1.scalar_type(), "bmm", [&] {
           baddbmm_cpu_kernel<scalar_t, true>(self_or_result, batch1, batch2, beta, alpha);
@@ -8,8 +8,10 @@
 
 #include <ATen/ATen.h>
 #include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
 #include <ATen/TensorUtils.h>
 
+#include <algorithm>
 #include <numeric>
 #include <type_traits>
 
@@ -28,6 +30,31 @@ static inline int64_t get_target_prime(target_t* target, int64_t offset, int64_t
   }
 }
 
+// Collects the augmented targets of a batch item, and for each s the log of whether the lattice has the transition
+// from s-2 to s (0 if it has, neginf if the two labels are the same or s < 2), so that the recursions can add it to the
+// skipped summand instead of branching on it.
+template<typename target_t, typename scalar_t>
+static inline void init_lattice(target_t* target, int64_t offset, int64_t stride, int64_t num_states, int64_t BLANK,
+                                std::vector<int64_t>& target_primes, std::vector<scalar_t>& skip_penalty) {
+  constexpr scalar_t neginf = -std::numeric_limits<scalar_t>::infinity();
+  target_primes.resize(num_states);
+  skip_penalty.resize(num_states);
+  for (int64_t s = 0; s < num_states; s++) {
+    target_primes[s] = get_target_prime(target, offset, stride, s, BLANK);
+    skip_penalty[s] = (s > 1 && target_primes[s-2] != target_primes[s]) ? 0 : neginf;
+  }
+}
+
+// log(exp(a)+exp(b)+exp(c)), keeping track of the maximum so that the exps cannot overflow
+template<typename scalar_t>
+static inline scalar_t log_sum_exp3(scalar_t a, scalar_t b, scalar_t c) {
+  constexpr scalar_t neginf = -std::numeric_limits<scalar_t>::infinity();
+  scalar_t m = std::max(a, std::max(b, c));
+  if (m == neginf) // cannot do neginf-neginf
+    m = 0;
+  return std::log(std::exp(a-m)+std::exp(b-m)+std::exp(c-m))+m;
+}
+
 // This kernel is a relatively straightforward implementation of the alpha calculation in the forward backward algorithm (section 4.1).
 // A (minor) twist is that we are using log-calculations to enhance numerical stability (log_probs and log_alpha).
 // The function returns the loss and the alphas, the alphas are kept for the backward step. The wrapper (ctc_loss below) hides
@@ -99,60 +126,48 @@ std::tuple<Tensor, Tensor> ctc_loss_cpu_template(const Tensor& log_probs, const
   // alpha calculation for the first row, the three equations for alpha_1 above eq (6)
   // first the default
   log_alpha.narrow(1, 0, 1).fill_(neginf);
-  #pragma omp parallel for
-  for (int64_t b = 0; b < batch_size; b++) {
-    int64_t input_length = input_lengths[b];
-    int64_t target_length = target_lengths[b];
-    auto log_probs_a = log_probs_a_global[b];
-    auto log_alpha_a = log_alpha_a_global[b];
-    int64_t tg_batch_offset = tg_batch_offsets[b];
-
-    // the first two items of alpha_t above eq (6)
-    log_alpha_a[0][0] = log_probs_a[0][BLANK];
-    if (target_length > 0)
-      log_alpha_a[0][1] = log_probs_a[0][get_target_prime(targets_data, tg_batch_offset, tg_target_stride, 1, BLANK)];
-
-    // now the loop over the inputs
-    for (int64_t t=1; t<input_length; t++) {
-      for (int64_t s=0; s<2*target_length+1; s++) {
-        auto current_target_prime = get_target_prime(targets_data, tg_batch_offset, tg_target_stride, s, BLANK);
-        // this loop over s could be parallel/vectorized, too, but the required items are one index apart
-        // alternatively, one might consider moving s to the outer loop to cache current_target_prime more (but then it needs to be descending)
-        // for the cuda implementation, that gave a speed boost.
-        // This is eq (6) and (7), la1,2,3 are the three summands. We keep track of the maximum for the logsumexp calculation.
-
-        scalar_t la1 = log_alpha_a[t-1][s];
-        scalar_t lamax = la1;
-        scalar_t la2, la3;
-        if (s > 0) {
-          la2 = log_alpha_a[t-1][s-1];
-          if (la2 > lamax)
-            lamax = la2;
-        } else {
-          la2 = neginf;
-        }
-        if ((s > 1) && (get_target_prime(targets_data, tg_batch_offset, tg_target_stride, s-2, BLANK) !=
-                        current_target_prime)) {
-          la3 = log_alpha_a[t-1][s-2];
-          if (la3 > lamax)
-            lamax = la3;
-        } else {
-          la3 = neginf;
+  at::parallel_for(0, batch_size, 1, [&](int64_t start, int64_t end) {
+    std::vector<int64_t> target_primes;
+    std::vector<scalar_t> skip_penalty;
+    for (int64_t b = start; b < end; b++) {
+      int64_t input_length = input_lengths[b];
+      int64_t target_length = target_lengths[b];
+      auto log_probs_a = log_probs_a_global[b];
+      auto log_alpha_a = log_alpha_a_global[b];
+      int64_t tg_batch_offset = tg_batch_offsets[b];
+      int64_t num_states = 2*target_length+1;
+      init_lattice(targets_data, tg_batch_offset, tg_target_stride, num_states, BLANK, target_primes, skip_penalty);
+
+      // the first two items of alpha_t above eq (6)
+      log_alpha_a[0][0] = log_probs_a[0][BLANK];
+      if (target_length > 0)
+        log_alpha_a[0][1] = log_probs_a[0][target_primes[1]];
+
+      // now the loop over the inputs
+      for (int64_t t=1; t<input_length; t++) {
+        // This is eq (6) and (7), la1,2,3 are the three summands.
+        // The alphas of a row only depend on the previous row, so all s are independent; with the
+        // transitions from s-2 masked by skip_penalty, the loop over s >= 2 has no branches.
+        const scalar_t* la_prev = &log_alpha_a[t-1][0];
+        scalar_t* la = &log_alpha_a[t][0];
+        auto log_probs_t = log_probs_a[t];
+        la[0] = la_prev[0] + log_probs_t[BLANK];
+        if (num_states > 1)
+          la[1] = log_sum_exp3(la_prev[1], la_prev[0], neginf) + log_probs_t[target_primes[1]];
+        for (int64_t s=2; s<num_states; s++) {
+          // this is the assignment of eq (6)
+          la[s] = log_sum_exp3(la_prev[s], la_prev[s-1], la_prev[s-2] + skip_penalty[s]) + log_probs_t[target_primes[s]];
         }
-        if (lamax == neginf) // cannot do neginf-neginf
-          lamax = 0;
-        // this is the assignment of eq (6)
-        log_alpha_a[t][s] = std::log(std::exp(la1-lamax)+std::exp(la2-lamax)+std::exp(la3-lamax))+lamax + log_probs_a[t][current_target_prime];
       }
+      // the likelihood is the the sum of the last two alphas, eq (8), the loss is the negative log likelihood
+      scalar_t l1 = log_alpha_a[input_length-1][target_length*2];
+      scalar_t l2 = log_alpha_a[input_length-1][target_length*2-1];
+      scalar_t m = std::max(l1, l2);
+      m = ((m == neginf) ? 0 : m);
+      scalar_t log_likelihood = std::log(std::exp(l1-m)+std::exp(l2-m))+m;
+      neg_log_likelihood_a[b] = -log_likelihood;
     }
-    // the likelihood is the the sum of the last two alphas, eq (8), the loss is the negative log likelihood
-    scalar_t l1 = log_alpha_a[input_length-1][target_length*2];
-    scalar_t l2 = log_alpha_a[input_length-1][target_length*2-1];
-    scalar_t m = std::max(l1, l2);
-    m = ((m == neginf) ? 0 : m);
-    scalar_t log_likelihood = std::log(std::exp(l1-m)+std::exp(l2-m))+m;
-    neg_log_likelihood_a[b] = -log_likelihood;
-  }
+  });
 
   return std::make_tuple(neg_log_likelihood, log_alpha);
 }
@@ -205,101 +220,99 @@ Tensor ctc_loss_backward_cpu_template(const Tensor& grad_out, const Tensor& log_
   auto grad_a_global = gp.accessor<scalar_t, 3>();
   auto targets_data = targets.data<target_t>();
 
-  #pragma omp parallel for
-  for (int64_t b = 0; b < batch_size; b++) {
-    scalar_t nll = neg_log_likelihood.accessor<scalar_t, 1>()[b];
-    if (zero_infinity &&  nll == std::numeric_limits<scalar_t>::infinity()) {
-      grad.narrow(1, b, 1).zero_();
-      continue;
-    }
-
-    auto log_probs_a = log_probs_a_global[b];
-    auto log_alpha_a = log_alpha_a_global[b];
-    auto log_beta_a = log_beta_a_global[b];
-    auto grad_a = grad_a_global[b];
-    int64_t input_length = input_lengths[b];
-    int64_t target_length = target_lengths[b];
-    int64_t tg_batch_offset = tg_batch_offsets[b];
-
-    // the initialization of beta before eq (10)
-    // here we do the fill for each batch item separately, as the input lengths will differ, so the t in which
-    // we start varies
-    if (input_length > 0) {
-      log_beta.narrow(0, b, 1).narrow(1, input_length-1, 1).fill_(neginf);
-      log_beta_a[input_length-1][2*target_length] = log_probs_a[input_length-1][BLANK];
-      grad_a[input_length-1][BLANK] = log_alpha_a[input_length-1][2*target_length] + log_beta_a[input_length-1][2*target_length];
-
-      if (target_length > 0) {
-        auto current_target_prime = get_target_prime(targets_data, tg_batch_offset, tg_target_stride, 2*target_length-1, BLANK);
-        log_beta_a[input_length-1][2*target_length-1] = log_probs_a[input_length-1][current_target_prime];
-
-        // the first two are a blank and a non-blank, so we know they are different and we don't need to do log+
-        grad_a[input_length-1][current_target_prime] = log_alpha_a[input_length-1][2*target_length-1] + log_beta_a[input_length-1][2*target_length-1];
+  auto neg_log_likelihood_a = neg_log_likelihood.accessor<scalar_t, 1>();
+  auto grad_out_a = grad_out.accessor<scalar_t, 1>();
+
+  at::parallel_for(0, batch_size, 1, [&](int64_t start, int64_t end) {
+    std::vector<int64_t> target_primes;
+    std::vector<scalar_t> skip_penalty;
+    for (int64_t b = start; b < end; b++) {
+      scalar_t nll = neg_log_likelihood_a[b];
+      auto grad_a = grad_a_global[b];
+      if (zero_infinity &&  nll == std::numeric_limits<scalar_t>::infinity()) {
+        for (int64_t t = 0; t < max_input_length; t++) {
+          std::fill_n(&grad_a[t][0], num_labels, scalar_t(0));
+        }
+        continue;
       }
-    }
 
-    // now loop applying eq (10) / (11)
-    for (int64_t t=input_length-2; t>=0; t--) {
-      // this loop over s could be parallel/vectorized and doesn't really need to be descending...
-      // alternatively, one might consider moving s to the outer loop to cache current_target_prime more (but then it needs to be descending)
-      // for the cuda implementation, that gave a speed boost.
-      for (int64_t s=2*target_length; s>=0; s--) {
-        scalar_t lb1 = log_beta_a[t+1][s];
-        scalar_t lbmax = lb1;
-        scalar_t lb2, lb3;
-        auto current_target_prime = get_target_prime(targets_data, tg_batch_offset, tg_target_stride, s, BLANK);
-        if (s < 2*target_length) {
-          lb2 = log_beta_a[t+1][s+1];
-          if (lb2 > lbmax)
-            lbmax = lb2;
-        } else {
-          lb2 = neginf;
+      auto log_probs_a = log_probs_a_global[b];
+      auto log_alpha_a = log_alpha_a_global[b];
+      auto log_beta_a = log_beta_a_global[b];
+      int64_t input_length = input_lengths[b];
+      int64_t target_length = target_lengths[b];
+      int64_t tg_batch_offset = tg_batch_offsets[b];
+      int64_t num_states = 2*target_length+1;
+      init_lattice(targets_data, tg_batch_offset, tg_target_stride, num_states, BLANK, target_primes, skip_penalty);
+
+      // the initialization of beta before eq (10)
+      // here we do the fill for each batch item separately, as the input lengths will differ, so the t in which
+      // we start varies
+      if (input_length > 0) {
+        std::fill_n(&log_beta_a[input_length-1][0], log_beta.size(2), neginf);
+        log_beta_a[input_length-1][2*target_length] = log_probs_a[input_length-1][BLANK];
+        grad_a[input_length-1][BLANK] = log_alpha_a[input_length-1][2*target_length] + log_beta_a[input_length-1][2*target_length];
+
+        if (target_length > 0) {
+          auto current_target_prime = target_primes[2*target_length-1];
+          log_beta_a[input_length-1][2*target_length-1] = log_probs_a[input_length-1][current_target_prime];
+
+          // the first two are a blank and a non-blank, so we know they are different and we don't need to do log+
+          grad_a[input_length-1][current_target_prime] = log_alpha_a[input_length-1][2*target_length-1] + log_beta_a[input_length-1][2*target_length-1];
         }
-        if ((s < 2*target_length-1) && (get_target_prime(targets_data, tg_batch_offset, tg_target_stride, s+2, BLANK) !=
-                                        current_target_prime)) {
-          lb3 = log_beta_a[t+1][s+2];
-          if (lb3 > lbmax)
-            lbmax = lb3;
-        } else {
-          lb3 = neginf;
+      }
+
+      // now loop applying eq (10) / (11)
+      for (int64_t t=input_length-2; t>=0; t--) {
+        // As for the alphas, the betas of a row only depend on the next row. The transition from s+2 is
+        // allowed when the one from s to s+2 is in the forward, so skip_penalty[s+2] masks it.
+        const scalar_t* lb_next = &log_beta_a[t+1][0];
+        scalar_t* lb = &log_beta_a[t][0];
+        auto log_probs_t = log_probs_a[t];
+        int64_t last = num_states-1;
+        lb[last] = lb_next[last] + log_probs_t[BLANK];
+        if (last > 0)
+          lb[last-1] = log_sum_exp3(lb_next[last-1], lb_next[last], neginf) + log_probs_t[target_primes[last-1]];
+        for (int64_t s=0; s<last-1; s++) {
+          lb[s] = log_sum_exp3(lb_next[s], lb_next[s+1], lb_next[s+2] + skip_penalty[s+2]) + log_probs_t[target_primes[s]];
         }
-        if (lbmax == neginf)
-          lbmax = 0;
 
-        log_beta_a[t][s] = std::log(std::exp(lb1-lbmax)+std::exp(lb2-lbmax)+std::exp(lb3-lbmax))+lbmax + log_probs_a[t][current_target_prime];
-        // one might check whether one can vectorize this better when done after the t-loop...
         // now that we have beta, we fill in the sum of alpha*beta in eq (16)
         // in contrast to the cuda implementation, we only parallelize over the batch, so we don't have a concurrency
         // issue (several s can map to the same target character)
         // collected[b, t, target'[s]] "log+=" log_alpha[t, s]+log_beta[t, s]
-        scalar_t log_alpha_beta =  log_alpha_a[t][s] + log_beta_a[t][s];
-        scalar_t &lcab = grad_a[t][current_target_prime];
-        if (lcab == neginf) {
-          lcab = log_alpha_beta;
-        } else {
-          scalar_t max = std::max(lcab, log_alpha_beta);
-          lcab = std::log(std::exp(lcab-max)+std::exp(log_alpha_beta-max))+max;
+        auto log_alpha_t = log_alpha_a[t];
+        auto grad_t = grad_a[t];
+        for (int64_t s=0; s<num_states; s++) {
+          scalar_t log_alpha_beta =  log_alpha_t[s] + lb[s];
+          scalar_t &lcab = grad_t[target_primes[s]];
+          if (lcab == neginf) {
+            lcab = log_alpha_beta;
+          } else {
+            scalar_t max = std::max(lcab, log_alpha_beta);
+            lcab = std::log(std::exp(lcab-max)+std::exp(log_alpha_beta-max))+max;
+          }
         }
       }
-    }
 
-    // now grad has the sum of eq (16)
-    // now we wrap up the calculation by adding in the remaining items of eq (16)
-    // this could be a great target for further vectorization.
-    // grad is the output gradient, nll is the loss. Note that the likelihood -nll is the Z of eq (16)
-    scalar_t gr =  grad_out.accessor<scalar_t, 1>()[b];
-    for (int64_t t = 0; t < input_length; t++) { // or go for the full thing?
-      for (int64_t c = 0; c < num_labels; c++) {
-        scalar_t& res = grad_a[t][c];
-        scalar_t lp = log_probs_a[t][c];
-        res = (std::exp(lp)-std::exp(res + nll - lp)) * gr;
+      // now grad has the sum of eq (16)
+      // now we wrap up the calculation by adding in the remaining items of eq (16)
+      // grad is the output gradient, nll is the loss. Note that the likelihood -nll is the Z of eq (16)
+      scalar_t gr = grad_out_a[b];
+      for (int64_t t = 0; t < input_length; t++) { // or go for the full thing?
+        scalar_t* grad_t = &grad_a[t][0];
+        auto log_probs_t = log_probs_a[t];
+        for (int64_t c = 0; c < num_labels; c++) {
+          scalar_t lp = log_probs_t[c];
+          grad_t[c] = (std::exp(lp)-std::exp(grad_t[c] + nll - lp)) * gr;
+        }
+      }
+      // zero the remainder
+      for (int64_t t = input_length; t < max_input_length; t++) {
+        std::fill_n(&grad_a[t][0], num_labels, scalar_t(0));
       }
     }
-    // zero the remainder
-    if (input_length < max_input_length) {
-      grad.narrow(0, input_length, max_input_length - input_length).narrow(1, b, 1).zero_();
-    }
-  }
+  });
   return grad;
 }
 
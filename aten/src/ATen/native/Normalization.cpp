@@ -1,9 +1,9 @@
 #include <ATen/ATen.h>
 #include <ATen/NativeFunctions.h>
 #include <ATen/AccumulateType.h>
-#include <ATen/CPUApplyUtils.h>
 #include <ATen/Parallel.h>
 #include <ATen/Config.h>
+#include <ATen/native/Normalization.h>
 
 #include <ATen/detail/CUDAHooksInterface.h>
 
@@ -13,6 +13,15 @@ static const int MIOPEN_DIM_MAX = 4;
 
 namespace at { namespace native {
 
+DEFINE_DISPATCH(batch_norm_collect_stats_stub);
+DEFINE_DISPATCH(batch_norm_transform_stub);
+DEFINE_DISPATCH(batch_norm_backward_reduce_stub);
+DEFINE_DISPATCH(batch_norm_backward_elemt_stub);
+DEFINE_DISPATCH(layer_norm_stub);
+DEFINE_DISPATCH(layer_norm_backward_stub);
+DEFINE_DISPATCH(group_norm_stub);
+DEFINE_DISPATCH(group_norm_backward_stub);
+
 namespace {
   void check_dims_match_num_input_features(const char* arg_name, int64_t expected, int64_t actual){
     AT_CHECK(actual == expected,
@@ -54,97 +63,35 @@ struct Var {
   }
 };
 
-/// A fast path for CPU inference when all tensors are contiguous.
-/// This code achieves machine bandwidth peak without AVX support.
-/// If this changes for future architectures, we can move it to the cpu/
-/// directory.
-template<typename scalar_t>
-void batch_norm_cpu_inference_contiguous(Tensor& output, const Tensor& input,
-    const Tensor& weight /* optional */, const Tensor& bias /* optional */,
-    const Tensor& mean, const Tensor& variance, double eps) {
+/// The layout the batch norm kernels run on (see Normalization.h): the
+/// memory format of the input, which other layouts are copied into. A
+/// contiguous input with a single element per channel and sample, e.g. the
+/// [N, C] input of BatchNorm1d, is also channels last.
+static MemoryFormat batch_norm_cpu_memory_format(const Tensor& input, bool& channels_last) {
   int64_t n_batch = input.size(0);
   int64_t n_channel = input.size(1);
-  int64_t image_size = input.numel() / n_batch / n_channel;
-
-  scalar_t* output_data = output.data<scalar_t>();
-  const scalar_t* input_data = input.data<scalar_t>();
-  const scalar_t* weight_data = weight.defined() ? weight.data<scalar_t>() : nullptr;
-  const scalar_t* bias_data = bias.defined() ? bias.data<scalar_t>() : nullptr;
-  const scalar_t* mean_data = mean.data<scalar_t>();
-  const scalar_t* var_data = variance.data<scalar_t>();
-
-  /// Collect the linear and constant terms regarding the input.
-  /// output(n, c, h, w)
-  ///     = (input(n, c, h, w) - mean(c)) / sqrt(var(c) + eps) * weight(c)
-  ///         + bias(c)
-  ///     = input(n, c, h, w) * inv_var(c) * weight(c) +
-  ///         - mean(c) * inv_var(c) * weight(c) + bias(c),
-  /// where inv_var(c) = 1 / sqrt(var(c) + eps).
-  /// So the linear term, alpha(c) = inv_var(c) * weight(c),
-  ///   the constant term beta(c) = bias(c) - mean(c) * inv_var(c) * weight(c)
-  /// Note that this is only a good idea if (input_size >> c), in degenerate
-  /// cases where image_size == 1 && batch_size == 1, it is slow.
-  Tensor alpha = at::empty_like(mean);
-  Tensor beta = at::empty_like(mean);
-  scalar_t* alpha_data = alpha.data<scalar_t>();
-  scalar_t* beta_data = beta.data<scalar_t>();
-  for (int64_t c = 0; c < n_channel; c++) {
-    scalar_t inv_var = 1 / std::sqrt(var_data[c] + static_cast<scalar_t>(eps));
-    scalar_t weight_v = weight_data ? weight_data[c] : 1;
-    scalar_t bias_v = bias_data ? bias_data[c] : 0;
-    alpha_data[c] = inv_var * weight_v;
-    beta_data[c] = bias_v - mean_data[c] * inv_var * weight_v;
-  }
-
-  // Apply the linear terms to the input,
-  // output(n, c, h, w) = input(n, c, h, w) * alpha(c) + beta(c)
-  // No need to use parallel_for as this function is supposed to be
-  // memory-limited.
-  // Keep the loop struture simple to make sure compiler vetorization kicks in.
-  if (image_size != 1) {
-    for (int64_t n = 0; n < n_batch; ++n) {
-      for (int64_t c = 0; c < n_channel; ++c) {
-        for (int64_t i = 0; i < image_size; ++i) {
-          // Keep all the offset calculation within the inner loop for
-          // simplicity. Compilers are very good at hoisting the common part
-          // outside.
-          int64_t offset = n * n_channel * image_size + c * image_size + i;
-          output_data[offset] = input_data[offset] * alpha_data[c] +
-              beta_data[c];
-        }
-      }
-    }
-  } else {
-    // image_size == 1
-    for (int64_t n = 0; n < n_batch; ++n) {
-      for (int64_t c = 0; c < n_channel; ++c) {
-        int64_t offset = n * n_channel + c;
-        output_data[offset] = input_data[offset] * alpha_data[c] + beta_data[c];
-      }
-    }
-  }
+  int64_t image_size = n_batch * n_channel == 0 ? 0 : input.numel() / n_batch / n_channel;
+  auto memory_format = input.suggest_memory_format();
+  channels_last = memory_format == MemoryFormat::ChannelsLast || image_size == 1;
+  return memory_format;
 }
 
 template<typename scalar_t>
 std::tuple<Tensor,Tensor,Tensor> batch_norm_cpu_transform_input_template(
-    const Tensor& input, const Tensor& weight, const Tensor& bias,
+    const Tensor& input_, const Tensor& weight, const Tensor& bias,
     const Tensor& save_mean /* optional */, const Tensor& save_invstd /* optional */,
     const Tensor& running_mean /* optional */, const Tensor& running_var /* optional */,
     bool train, double eps) {
 
-  Tensor output = at::empty_like(input);
+  bool channels_last;
+  auto memory_format = batch_norm_cpu_memory_format(input_, channels_last);
+  Tensor input = input_.contiguous(memory_format);
+  // The output keeps the memory format of the input.
+  Tensor output = at::empty(input.sizes(), input.options(), memory_format);
 
-  // Check if we should use the fast path.
-  if (!train && input.is_contiguous()
-      && (!weight.defined() || weight.is_contiguous())
-      && (!bias.defined() || bias.is_contiguous())
-      && running_mean.is_contiguous()
-      && running_var.is_contiguous()) {
-    batch_norm_cpu_inference_contiguous<scalar_t>(output, input, weight, bias,
-      running_mean, running_var, eps);
-    return std::make_tuple(output, save_mean, save_invstd);
-  }
+  int64_t n_batch = input.size(0);
   int64_t n_input = input.size(1);
+  int64_t image_size = input.numel() == 0 ? 0 : input.numel() / n_batch / n_input;
 
   auto save_mean_a = conditional_accessor_1d<scalar_t>(save_mean);
   auto save_invstd_a = conditional_accessor_1d<scalar_t>(save_invstd);
@@ -152,95 +99,98 @@ std::tuple<Tensor,Tensor,Tensor> batch_norm_cpu_transform_input_template(
   auto running_mean_a = conditional_accessor_1d<scalar_t>(running_mean);
   auto running_var_a = conditional_accessor_1d<scalar_t>(running_var);
 
-  parallel_for(0, n_input, 1, [&](int64_t b_begin, int64_t b_end) {
-    for (int64_t f = b_begin; f < b_end; ++f) {
-      Tensor in = input.select(1, f);
-      Tensor out = output.select(1, f);
-
-      scalar_t mean, invstd;
-      if (train) {
-        mean = save_mean_a[f];
-        invstd = save_invstd_a[f];
-      } else {
-        mean = running_mean_a[f];
-        invstd = 1 / std::sqrt(running_var_a[f] + eps);
-      }
-
-      // compute output
-      scalar_t w = weight.defined() ? weight.data<scalar_t>()[f * weight.stride(0)] : 1;
-      scalar_t b = bias.defined() ? bias.data<scalar_t>()[f * bias.stride(0)] : 0;
-
-      CPU_tensor_apply2<scalar_t,scalar_t>(out, in, [&](scalar_t& o, const scalar_t& i) {
-        o = ((i - mean) * invstd) * w + b;
-      });
+  /// Collect the linear and constant terms regarding the input.
+  /// output(n, c, h, w)
+  ///     = (input(n, c, h, w) - mean(c)) / sqrt(var(c) + eps) * weight(c)
+  ///         + bias(c)
+  ///     = input(n, c, h, w) * inv_var(c) * weight(c) +
+  ///         - mean(c) * inv_var(c) * weight(c) + bias(c),
+  /// where inv_var(c) = 1 / sqrt(var(c) + eps).
+  /// So the linear term, alpha(c) = inv_var(c) * weight(c),
+  ///   the constant term beta(c) = bias(c) - mean(c) * inv_var(c) * weight(c)
+  Tensor alpha = at::empty({n_input}, input.options());
+  Tensor beta = at::empty({n_input}, input.options());
+  scalar_t* alpha_data = alpha.data<scalar_t>();
+  scalar_t* beta_data = beta.data<scalar_t>();
+  for (int64_t f = 0; f < n_input; f++) {
+    scalar_t mean, invstd;
+    if (train) {
+      mean = save_mean_a[f];
+      invstd = save_invstd_a[f];
+    } else {
+      mean = running_mean_a[f];
+      invstd = 1 / std::sqrt(running_var_a[f] + eps);
     }
-  });
+    scalar_t w = weight.defined() ? weight.data<scalar_t>()[f * weight.stride(0)] : 1;
+    scalar_t b = bias.defined() ? bias.data<scalar_t>()[f * bias.stride(0)] : 0;
+    alpha_data[f] = invstd * w;
+    beta_data[f] = b - mean * invstd * w;
+  }
+
+  batch_norm_transform_stub(kCPU, input, alpha, beta, n_batch, n_input,
+    image_size, channels_last, output);
   return std::make_tuple(output, save_mean, save_invstd);
 }
 
 template<typename scalar_t, template<typename T> class VarTransform>
 std::tuple<Tensor,Tensor> batch_norm_cpu_update_stats_template(
-    const Tensor& input, const Tensor& running_mean, const Tensor& running_var,
+    const Tensor& input_, const Tensor& running_mean, const Tensor& running_var,
     double momentum, double eps) {
 
-  using accscalar_t = at::acc_type<scalar_t, false>;
+  bool channels_last;
+  auto memory_format = batch_norm_cpu_memory_format(input_, channels_last);
+  Tensor input = input_.contiguous(memory_format);
 
+  int64_t n_batch = input.size(0);
   int64_t n_input = input.size(1);
   int64_t n = input.numel() / n_input;
+  int64_t image_size = n_batch == 0 ? 0 : n / n_batch;
 
   Tensor save_mean = at::empty({n_input}, input.options());
+  Tensor save_var = at::empty({n_input}, input.options());
+  batch_norm_collect_stats_stub(kCPU, input, n_batch, n_input, image_size,
+    channels_last, save_mean, save_var);
+
   Tensor save_var_transform = at::empty({n_input}, input.options());
   auto save_mean_a = save_mean.accessor<scalar_t, 1>();
+  auto save_var_a = save_var.accessor<scalar_t, 1>();
   auto save_var_transform_a = save_var_transform.accessor<scalar_t, 1>();
 
   auto running_mean_a = conditional_accessor_1d<scalar_t>(running_mean);
   auto running_var_a = conditional_accessor_1d<scalar_t>(running_var);
 
-  parallel_for(0, n_input, 1, [&](int64_t b_begin, int64_t b_end) {
-    for (int64_t f = b_begin; f < b_end; ++f) {
-      Tensor in = input.select(1, f);
-
-      // compute mean per input
-      accscalar_t sum = 0;
-      CPU_tensor_apply1<scalar_t>(in, [&] (const scalar_t& i) {
-          sum += i;
-        });
-      scalar_t mean = sum / n;
-      save_mean_a[f] = mean;
-
-      // compute variance per input
-      accscalar_t var_sum = 0;
-      CPU_tensor_apply1<scalar_t>(in, [&] (const scalar_t& i) {
-        var_sum += (i - mean) * (i - mean);
-      });
-      save_var_transform_a[f] = VarTransform<accscalar_t>{}(var_sum / n, eps);
-
-      // update running averages
-      if (running_mean.defined()) {
-        running_mean_a[f] = momentum * mean + (1 - momentum) * running_mean_a[f];
-      }
-      if (running_var.defined()) {
-        accscalar_t unbiased_var = var_sum / (n - 1);
-        running_var_a[f] = momentum * unbiased_var + (1 - momentum) * running_var_a[f];
-      }
+  for (int64_t f = 0; f < n_input; ++f) {
+    scalar_t mean = save_mean_a[f];
+    save_var_transform_a[f] = VarTransform<scalar_t>{}(save_var_a[f], eps);
+
+    // update running averages
+    if (running_mean.defined()) {
+      running_mean_a[f] = momentum * mean + (1 - momentum) * running_mean_a[f];
+    }
+    if (running_var.defined()) {
+      scalar_t unbiased_var = save_var_a[f] * n / (n - 1);
+      running_var_a[f] = momentum * unbiased_var + (1 - momentum) * running_var_a[f];
     }
-  });
+  }
   return std::make_tuple(save_mean, save_var_transform);
 }
 
 
 template<typename scalar_t>
-std::tuple<Tensor, Tensor, Tensor> batch_norm_backward_cpu_template(const Tensor& grad_out_, const Tensor& input, const Tensor& weight,
+std::tuple<Tensor, Tensor, Tensor> batch_norm_backward_cpu_template(const Tensor& grad_out_, const Tensor& input_, const Tensor& weight,
                                                                     const Tensor& running_mean, const Tensor& running_var, const Tensor& save_mean, const Tensor& save_invstd,
                                                                     bool train, double eps, std::array<bool,3> grad_input_mask) {
 
-  using accscalar_t = at::acc_type<scalar_t, false>;
+  bool channels_last;
+  auto memory_format = batch_norm_cpu_memory_format(input_, channels_last);
+  Tensor input = input_.contiguous(memory_format);
+  Tensor grad_out = grad_out_.contiguous(memory_format);
 
   Tensor grad_input;
   Tensor grad_weight;
   Tensor grad_bias;
   if (grad_input_mask[0]) {
-    grad_input = at::empty_like(input);
+    grad_input = at::empty(input.sizes(), input.options(), memory_format);
   }
   if (grad_input_mask[1]) {
     grad_weight = at::empty_like(weight);
@@ -253,8 +203,10 @@ std::tuple<Tensor, Tensor, Tensor> batch_norm_backward_cpu_template(const Tensor
   auto grad_weight_a = conditional_accessor_1d<scalar_t>(grad_weight);
   auto grad_bias_a = conditional_accessor_1d<scalar_t>(grad_bias);
 
+  int64_t n_batch = input.size(0);
   int64_t n_input = input.size(1);
   int64_t n = input.numel() / n_input;
+  int64_t image_size = n_batch == 0 ? 0 : n / n_batch;
 
   auto save_mean_a = conditional_accessor_1d<scalar_t>(save_mean);
   auto save_invstd_a = conditional_accessor_1d<scalar_t>(save_invstd);
@@ -262,73 +214,75 @@ std::tuple<Tensor, Tensor, Tensor> batch_norm_backward_cpu_template(const Tensor
   auto running_mean_a = conditional_accessor_1d<scalar_t>(running_mean);
   auto running_var_a = conditional_accessor_1d<scalar_t>(running_var);
 
+  Tensor mean = at::empty({n_input}, input.options());
+  Tensor invstd = at::empty({n_input}, input.options());
+  auto mean_a = mean.accessor<scalar_t, 1>();
+  auto invstd_a = invstd.accessor<scalar_t, 1>();
+  for (int64_t f = 0; f < n_input; ++f) {
+    if (train) {
+      mean_a[f] = save_mean_a[f];
+      invstd_a[f] = save_invstd_a[f];
+    } else {
+      mean_a[f] = running_mean_a[f];
+      invstd_a[f] = 1 / std::sqrt(running_var_a[f] + eps);
+    }
+  }
+
+  // sum over all gradOutput in feature plane, and dot product of the Q(X)
+  // and gradOutput; not needed by the input gradient in evaluation mode
+  Tensor sum = at::empty({n_input}, input.options());
+  Tensor dotp = at::empty({n_input}, input.options());
+  if (train || grad_input_mask[1] || grad_input_mask[2]) {
+    batch_norm_backward_reduce_stub(kCPU, grad_out, input, mean, n_batch,
+      n_input, image_size, channels_last, sum, dotp);
+  }
+  auto sum_a = sum.accessor<scalar_t, 1>();
+  auto dotp_a = dotp.accessor<scalar_t, 1>();
 
-  parallel_for(0, n_input, 1, [&](int64_t b_begin, int64_t b_end) {
-      for (int64_t f = b_begin; f < b_end; ++f) {
-        Tensor in = input.select(1, f);
-        Tensor grad_out = grad_out_.select(1, f);
-
-        scalar_t w = weight.defined() ? weight_a[f] : 1;
-
-        scalar_t mean, invstd;
-        if (train) {
-          mean = save_mean_a[f];
-          invstd = save_invstd_a[f];
-        } else {
-          mean = running_mean_a[f];
-          invstd = 1 / std::sqrt(running_var_a[f] + eps);
-        }
-
-        // sum over all gradOutput in feature plane
-        accscalar_t sum = 0;
-        CPU_tensor_apply1<scalar_t>(grad_out, [&](const scalar_t& g) {
-            sum += g;
-          });
-
-        // dot product of the Q(X) and gradOuput
-        accscalar_t dotp = 0;
-        CPU_tensor_apply2<scalar_t,scalar_t>(in, grad_out, [&](const scalar_t& i, const scalar_t& go) {
-            dotp += (i - mean) * go;
-          });
-
-        if (grad_input_mask[0]) {
-          Tensor grad_in = grad_input.select(1, f);
-          if (train) {
-            // when in training mode
-            // Q(X) = X - E[x] ; i.e. input centered to zero mean
-            // Y = Q(X) / σ    ; i.e. BN output before weight and bias
-            // dL/dX = (Q(dL/dY) - dot(Y, dL/dY) * Y) / σ * w
-
-            // projection of gradOutput on to output scaled by std
-            scalar_t k = (scalar_t) dotp * invstd * invstd / n;
-
-            CPU_tensor_apply2<scalar_t,scalar_t>(grad_in, in, [&](scalar_t& gi, const scalar_t& i) {
-                gi = (i - mean)* k;
-              });
-
-            accscalar_t grad_mean = sum / n;
-            CPU_tensor_apply2<scalar_t,scalar_t>(grad_in, grad_out, [&](scalar_t& gi, const scalar_t& go) {
-            gi = (go - grad_mean - gi) * invstd * w;
-              });
-          } else {
-            // when in evaluation mode
-            // Q(X) = X - running_mean  ; i.e. input centered to zero mean
-            // Y = Q(X) / running_std    ; i.e. BN output before weight and bias
-            // dL/dX = w / running_std
-            CPU_tensor_apply2<scalar_t,scalar_t>(grad_in, grad_out, [&](scalar_t& gi, const scalar_t& go) {
-                gi = go * invstd * w;
-              });
-          }
-        }
-        if (grad_input_mask[1]) {
-          grad_weight_a[f] = dotp * invstd;
-        }
-
-        if (grad_input_mask[2]) {
-          grad_bias_a[f] = sum;
-        }
+  if (grad_input_mask[0]) {
+    // dL/dX = gradOutput * a(c) + X * b(c) + c(c)
+    Tensor a = at::empty({n_input}, input.options());
+    Tensor b = at::zeros({n_input}, input.options());
+    Tensor c = at::zeros({n_input}, input.options());
+    auto a_a = a.accessor<scalar_t, 1>();
+    auto b_a = b.accessor<scalar_t, 1>();
+    auto c_a = c.accessor<scalar_t, 1>();
+    for (int64_t f = 0; f < n_input; ++f) {
+      scalar_t w = weight.defined() ? weight_a[f] : 1;
+      a_a[f] = invstd_a[f] * w;
+      if (train) {
+        // when in training mode
+        // Q(X) = X - E[x] ; i.e. input centered to zero mean
+        // Y = Q(X) / σ    ; i.e. BN output before weight and bias
+        // dL/dX = (Q(dL/dY) - dot(Y, dL/dY) * Y) / σ * w
+
+        // projection of gradOutput on to output scaled by std
+        scalar_t k = dotp_a[f] * invstd_a[f] * invstd_a[f] / n;
+        scalar_t grad_mean = sum_a[f] / n;
+        b_a[f] = -k * a_a[f];
+        c_a[f] = (mean_a[f] * k - grad_mean) * a_a[f];
       }
-    });
+      // when in evaluation mode
+      // Q(X) = X - running_mean  ; i.e. input centered to zero mean
+      // Y = Q(X) / running_std    ; i.e. BN output before weight and bias
+      // dL/dX = w / running_std
+    }
+    if (train) {
+      batch_norm_backward_elemt_stub(kCPU, grad_out, input, a, b, c, n_batch,
+        n_input, image_size, channels_last, grad_input);
+    } else {
+      batch_norm_transform_stub(kCPU, grad_out, a, b, n_batch, n_input,
+        image_size, channels_last, grad_input);
+    }
+  }
+  for (int64_t f = 0; f < n_input; ++f) {
+    if (grad_input_mask[1]) {
+      grad_weight_a[f] = dotp_a[f] * invstd_a[f];
+    }
+    if (grad_input_mask[2]) {
+      grad_bias_a[f] = sum_a[f];
+    }
+  }
   return std::make_tuple(grad_input, grad_weight, grad_bias);
 }
 
@@ -370,14 +324,16 @@ std::tuple<Tensor, Tensor, Tensor, int64_t> _batch_norm_impl_index(
                && cudnn_enabled && detail::getCUDAHooks().versionCuDNN() >= 5110L);
 
   if (use_cudnn && eps >= detail::getCUDAHooks().batchnormMinEpsilonCuDNN()) {
-    return std::tuple_cat(
-             at::cudnn_batch_norm(
-               input.contiguous(), weight.contiguous(),
-               bias.contiguous(),
-               running_mean.defined() ? running_mean.contiguous() : running_mean,
-               running_var.defined() ? running_var.contiguous() : running_var,
-               training, momentum, eps),
-             std::make_tuple(1));
+    auto result = at::cudnn_batch_norm(
+        input.contiguous(), weight.contiguous(),
+        bias.contiguous(),
+        running_mean.defined() ? running_mean.contiguous() : running_mean,
+        running_var.defined() ? running_var.contiguous() : running_var,
+        training, momentum, eps);
+    // cudnn_batch_norm works on NCHW only; hand a channels last input's
+    // output back in channels last so that the layout of the network holds.
+    std::get<0>(result) = std::get<0>(result).contiguous(input.suggest_memory_format());
+    return std::tuple_cat(result, std::make_tuple(1));
   }
 
   bool use_miopen = (input.is_cuda()
@@ -415,7 +371,7 @@ std::tuple<Tensor, Tensor, Tensor> _batch_norm_impl_index_backward(
   if (impl_index == 0) {
     return at::native_batch_norm_backward(grad_output, input, weight, running_mean, running_var, save_mean, save_var_transform, train, epsilon, output_mask);
   } else if (impl_index == 1) {
-    return at::cudnn_batch_norm_backward(input, grad_output, weight, running_mean, running_var, save_mean, save_var_transform, epsilon);
+    return at::cudnn_batch_norm_backward(input.contiguous(), grad_output.contiguous(), weight, running_mean, running_var, save_mean, save_var_transform, epsilon);
   } else if (impl_index == 2) {
     return at::miopen_batch_norm_backward(input, grad_output, weight, running_mean, running_var, save_mean, save_var_transform, epsilon);
   }
@@ -497,27 +453,70 @@ Tensor layer_norm(const Tensor& input, IntArrayRef normalized_shape,
       AT_ERROR(ss.str());
     }
 
-    int64_t n = 1;
+    int64_t M = 1;
     for (int64_t i = 0; i < input_ndim - normalized_ndim; i++) {
-      n *= input_shape[i];
+      M *= input_shape[i];
+    }
+    int64_t N = 1;
+    for (auto size : normalized_shape) {
+      N *= size;
     }
 
-    // Apply layer norm
-    auto input_reshaped = input.contiguous().view({1, n, -1});
+    // Apply layer norm; weight and bias are passed with the [N] shape the
+    // fused kernels expect, so that their gradients are reshaped back
+    auto gamma = weight.defined() ? weight.reshape({N}) : weight;
+    auto beta = bias.defined() ? bias.reshape({N}) : bias;
+    return std::get<0>(at::native_layer_norm(input, gamma, beta, M, N, eps));
+}
 
-    auto out = at::batch_norm(input_reshaped, {}, {}, {}, {}, true, 0, eps,
-                              cudnn_enabled);
-    out = out.view(input_shape);
+std::tuple<Tensor, Tensor, Tensor> native_layer_norm(
+    const Tensor& input, const Tensor& weight /* optional */,
+    const Tensor& bias /* optional */, int64_t M, int64_t N, double eps) {
+  AT_CHECK(input.numel() == M * N,
+           "Expected input with M * N = ", M * N, " elements, but got input ",
+           "of size ", input.sizes());
+  AT_CHECK(!weight.defined() || (weight.dim() == 1 && weight.size(0) == N),
+           "Expected weight to be a vector of size N = ", N, ", but got ",
+           "weight of shape ", weight.sizes());
+  AT_CHECK(!bias.defined() || (bias.dim() == 1 && bias.size(0) == N),
+           "Expected bias to be a vector of size N = ", N, ", but got ",
+           "bias of shape ", bias.sizes());
+  auto X = input.contiguous();
+  auto gamma = weight.defined() ? weight.contiguous() : weight;
+  auto beta = bias.defined() ? bias.contiguous() : bias;
+  Tensor Y = at::empty_like(X);
+  Tensor mean = at::empty({M}, X.options());
+  Tensor rstd = at::empty({M}, X.options());
+  if (M > 0) {
+    layer_norm_stub(X.device().type(), X, gamma, beta, M, N, eps, Y, mean, rstd);
+  }
+  return std::make_tuple(Y, mean, rstd);
+}
 
-    if (weight.defined() && bias.defined()) {
-      return bias.addcmul(out, weight, 1);
-    } else if (weight.defined()) {
-      return out.mul(weight);
-    } else if (bias.defined()) {
-      return out.add(bias);
-    } else {
-      return out;
-    }
+std::tuple<Tensor, Tensor, Tensor> native_layer_norm_backward(
+    const Tensor& grad_out, const Tensor& input, const Tensor& mean,
+    const Tensor& rstd, const Tensor& weight /* optional */, int64_t M,
+    int64_t N, std::array<bool, 3> grad_input_mask) {
+  auto dY = grad_out.contiguous();
+  auto X = input.contiguous();
+  auto gamma = weight.defined() ? weight.contiguous() : weight;
+  Tensor dX;
+  Tensor dgamma;
+  Tensor dbeta;
+  if (grad_input_mask[0]) {
+    dX = at::empty_like(X);
+  }
+  if (grad_input_mask[1]) {
+    dgamma = M > 0 ? at::empty({N}, X.options()) : at::zeros({N}, X.options());
+  }
+  if (grad_input_mask[2]) {
+    dbeta = M > 0 ? at::empty({N}, X.options()) : at::zeros({N}, X.options());
+  }
+  if (M > 0) {
+    layer_norm_backward_stub(
+        X.device().type(), dY, X, mean, rstd, gamma, M, N, dX, dgamma, dbeta);
+  }
+  return std::make_tuple(dX, dgamma, dbeta);
 }
 
 Tensor group_norm(const Tensor& input, int64_t num_groups,
@@ -543,26 +542,69 @@ Tensor group_norm(const Tensor& input, int64_t num_groups,
              " and input of shape ", input.sizes());
 
     // Apply group norm
-    auto input_reshaped = input.contiguous().view({1, b * num_groups, -1});
-
-    auto out = at::batch_norm(input_reshaped, {}, {}, {}, {}, true, 0, eps,
-                              cudnn_enabled);
-    out = out.view(input_shape);
-
-    if (!weight.defined() && !bias.defined()) {
-      return out;
+    int64_t HxW = 1;
+    for (int64_t i = 2; i < input.dim(); i++) {
+      HxW *= input_shape[i];
     }
+    return std::get<0>(at::native_group_norm(input, weight, bias, b, c, HxW,
+                                             num_groups, eps));
+}
 
-    std::vector<int64_t> affine_param_shape(input.dim(), 1);
-    affine_param_shape[1] = c;
+std::tuple<Tensor, Tensor, Tensor> native_group_norm(
+    const Tensor& input, const Tensor& weight /* optional */,
+    const Tensor& bias /* optional */, int64_t N, int64_t C, int64_t HxW,
+    int64_t group, double eps) {
+  AT_CHECK(input.numel() == N * C * HxW,
+           "Expected input with N * C * HxW = ", N * C * HxW, " elements, ",
+           "but got input of size ", input.sizes());
+  AT_CHECK(group > 0 && C % group == 0,
+           "Expected number of channels C = ", C, " to be divisible by ",
+           "group = ", group);
+  AT_CHECK(!weight.defined() || (weight.dim() == 1 && weight.size(0) == C),
+           "Expected weight to be a vector of size C = ", C, ", but got ",
+           "weight of shape ", weight.sizes());
+  AT_CHECK(!bias.defined() || (bias.dim() == 1 && bias.size(0) == C),
+           "Expected bias to be a vector of size C = ", C, ", but got ",
+           "bias of shape ", bias.sizes());
+  auto X = input.contiguous();
+  auto gamma = weight.defined() ? weight.contiguous() : weight;
+  auto beta = bias.defined() ? bias.contiguous() : bias;
+  Tensor Y = at::empty_like(X);
+  Tensor mean = at::empty({N, group}, X.options());
+  Tensor rstd = at::empty({N, group}, X.options());
+  if (N > 0) {
+    group_norm_stub(
+        X.device().type(), X, gamma, beta, N, C, HxW, group, eps, Y, mean,
+        rstd);
+  }
+  return std::make_tuple(Y, mean, rstd);
+}
 
-    if (weight.defined() && bias.defined()) {
-      return bias.view(affine_param_shape).addcmul(out, weight.view(affine_param_shape), 1);
-    } else if (weight.defined()) {
-      return out.mul(weight.view(affine_param_shape));
-    } else {
-      return out.add(bias.view(affine_param_shape));
-    }
+std::tuple<Tensor, Tensor, Tensor> native_group_norm_backward(
+    const Tensor& grad_out, const Tensor& input, const Tensor& mean,
+    const Tensor& rstd, const Tensor& weight /* optional */, int64_t N,
+    int64_t C, int64_t HxW, int64_t group, std::array<bool, 3> grad_input_mask) {
+  auto dY = grad_out.contiguous();
+  auto X = input.contiguous();
+  auto gamma = weight.defined() ? weight.contiguous() : weight;
+  Tensor dX;
+  Tensor dgamma;
+  Tensor dbeta;
+  if (grad_input_mask[0]) {
+    dX = at::empty_like(X);
+  }
+  if (grad_input_mask[1]) {
+    dgamma = N > 0 ? at::empty({C}, X.options()) : at::zeros({C}, X.options());
+  }
+  if (grad_input_mask[2]) {
+    dbeta = N > 0 ? at::empty({C}, X.options()) : at::zeros({C}, X.options());
+  }
+  if (N > 0) {
+    group_norm_backward_stub(
+        X.device().type(), dY, X, mean, rstd, gamma, N, C, HxW, group, dX,
+        dgamma, dbeta);
+  }
+  return std::make_tuple(dX, dgamma, dbeta);
 }
 
 std::tuple<Tensor, Tensor> batch_norm_update_stats_cpu(
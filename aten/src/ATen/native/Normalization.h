@@ -0,0 +1,62 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+namespace at { namespace native {
+
+// Fused layer norm over the last N elements of each of the M rows of the
+// contiguous X, and group norm of the contiguous [N, C, HxW] X with group
+// groups. The forward kernels compute the mean and the reciprocal of the
+// standard deviation (rstd) of every row or group in one pass, and the
+// backward kernels only need those. gamma and beta may be undefined, and the
+// backward kernels only compute the gradients that are defined.
+using layer_norm_fn = void(*)(
+    const Tensor& X, const Tensor& gamma, const Tensor& beta, int64_t M,
+    int64_t N, double eps, Tensor& Y, Tensor& mean, Tensor& rstd);
+using layer_norm_backward_fn = void(*)(
+    const Tensor& dY, const Tensor& X, const Tensor& mean, const Tensor& rstd,
+    const Tensor& gamma, int64_t M, int64_t N, Tensor& dX, Tensor& dgamma,
+    Tensor& dbeta);
+using group_norm_fn = void(*)(
+    const Tensor& X, const Tensor& gamma, const Tensor& beta, int64_t N,
+    int64_t C, int64_t HxW, int64_t group, double eps, Tensor& Y,
+    Tensor& mean, Tensor& rstd);
+using group_norm_backward_fn = void(*)(
+    const Tensor& dY, const Tensor& X, const Tensor& mean, const Tensor& rstd,
+    const Tensor& gamma, int64_t N, int64_t C, int64_t HxW, int64_t group,
+    Tensor& dX, Tensor& dgamma, Tensor& dbeta);
+
+// Batch norm over the channels of X, which is either a contiguous
+// [N, C, HxW] tensor or, if channels_last, a contiguous [N, HxW, C] one. The
+// kernels split both the channels and the elements of every channel between
+// threads. collect_stats computes the mean and the biased variance of every
+// channel with Welford's algorithm, transform computes
+// Y = X * alpha[c] + beta[c], backward_reduce computes sum(dY) and
+// sum(dY * (X - mean[c])) of every channel, and backward_elemt computes
+// dX = dY * a[c] + X * b[c] + c[c]. Y and dX have the layout of X.
+using batch_norm_collect_stats_fn = void(*)(
+    const Tensor& X, int64_t N, int64_t C, int64_t HxW, bool channels_last,
+    Tensor& mean, Tensor& var);
+using batch_norm_transform_fn = void(*)(
+    const Tensor& X, const Tensor& alpha, const Tensor& beta, int64_t N,
+    int64_t C, int64_t HxW, bool channels_last, Tensor& Y);
+using batch_norm_backward_reduce_fn = void(*)(
+    const Tensor& dY, const Tensor& X, const Tensor& mean, int64_t N,
+    int64_t C, int64_t HxW, bool channels_last, Tensor& sum_dy,
+    Tensor& sum_dy_xmu);
+using batch_norm_backward_elemt_fn = void(*)(
+    const Tensor& dY, const Tensor& X, const Tensor& a, const Tensor& b,
+    const Tensor& c, int64_t N, int64_t C, int64_t HxW, bool channels_last,
+    Tensor& dX);
+
+DECLARE_DISPATCH(batch_norm_collect_stats_fn, batch_norm_collect_stats_stub);
+DECLARE_DISPATCH(batch_norm_transform_fn, batch_norm_transform_stub);
+DECLARE_DISPATCH(batch_norm_backward_reduce_fn, batch_norm_backward_reduce_stub);
+DECLARE_DISPATCH(batch_norm_backward_elemt_fn, batch_norm_backward_elemt_stub);
+DECLARE_DISPATCH(layer_norm_fn, layer_norm_stub);
+DECLARE_DISPATCH(layer_norm_backward_fn, layer_norm_backward_stub);
+DECLARE_DISPATCH(group_norm_fn, group_norm_stub);
+DECLARE_DISPATCH(group_norm_backward_fn, group_norm_backward_stub);
+
+}} // namespace at::native
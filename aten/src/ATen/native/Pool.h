@@ -0,0 +1,53 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+namespace at { namespace native {
+
+// The arguments of a 2d or 3d max/average pooling, as a 3d pooling: 2d
+// poolings have a depth of 1, with a kernel of 1 and no padding along it.
+// Dimensions are ordered (depth, height, width).
+struct PoolingParams {
+  int64_t nbatch;
+  int64_t channels;
+  int64_t input_size[3];
+  int64_t output_size[3];
+  int64_t kernel[3];
+  int64_t stride[3];
+  int64_t padding[3];
+  int64_t dilation[3];
+  bool count_include_pad;
+  // The input and the output are channels last (N, H, W, C) rather than
+  // contiguous (N, C, D, H, W). Only for 2d poolings.
+  bool channels_last;
+};
+
+// (output, indices, input, params). indices may be undefined, to compute
+// only the output; otherwise it is a contiguous int64 tensor of the output's
+// sizes, and receives the flat index in its input plane of every maximum, as
+// max_pool2d_with_indices_backward expects.
+using max_pool_fn = void(*)(Tensor&, Tensor&, const Tensor&, const PoolingParams&);
+// (output, input, params)
+using avg_pool_fn = void(*)(Tensor&, const Tensor&, const PoolingParams&);
+
+DECLARE_DISPATCH(max_pool_fn, max_pool_kernel);
+DECLARE_DISPATCH(avg_pool_fn, avg_pool_kernel);
+
+// Same as THNN's pooling_output_shape.
+static inline int64_t pooling_output_shape(
+    int64_t input_size, int64_t kernel_size, int64_t pad, int64_t stride,
+    int64_t dilation, bool ceil_mode) {
+  int64_t output_size = (input_size + 2 * pad - dilation * (kernel_size - 1) - 1
+      + (ceil_mode ? stride - 1 : 0)) / stride + 1;
+  if (pad) {
+    // ensure that the last pooling starts inside the image
+    // needed to avoid problems in ceil mode
+    if ((output_size - 1) * stride >= input_size + pad) {
+      --output_size;
+    }
+  }
+  return output_size;
+}
+
+}} // namespace at::native
@@ -2,12 +2,17 @@
 
 #include <ATen/NativeFunctions.h>
 #include <ATen/TensorUtils.h>
+#include <ATen/native/Pool.h>
 #include <c10/util/Exception.h>
 
 #include <tuple>
+#include <vector>
 
 namespace at { namespace native {
 
+DEFINE_DISPATCH(max_pool_kernel);
+DEFINE_DISPATCH(avg_pool_kernel);
+
 static void check1d(
     const char* function_name,
     const char* argument_name,
@@ -118,9 +123,16 @@ Tensor max_pool2d(
     return at::mkldnn_max_pool2d(
         self, kernel_size, stride, padding, dilation, ceil_mode);
   }
+  // Without backward, the indices are wasted work
+  if (self.device().is_cpu() && !self.requires_grad()) {
+    return at::_max_pool2d_inference(
+        self, kernel_size, stride, padding, dilation, ceil_mode);
+  }
   auto output_and_indices = at::max_pool2d_with_indices(
       self, kernel_size, stride, padding, dilation, ceil_mode);
-  return std::get<0>(output_and_indices);
+  // max_pool2d_with_indices computes in NCHW; keep a channels last input's
+  // output in channels last so the following layers see the same layout.
+  return std::get<0>(output_and_indices).contiguous(self.suggest_memory_format());
 }
 
 Tensor max_pool3d(
@@ -130,9 +142,315 @@ Tensor max_pool3d(
     IntArrayRef padding,
     IntArrayRef dilation,
     bool ceil_mode) {
+  if (self.device().is_cpu() && !self.requires_grad()) {
+    return at::_max_pool3d_inference(
+        self, kernel_size, stride, padding, dilation, ceil_mode);
+  }
   auto output_and_indices = at::max_pool3d_with_indices(
       self, kernel_size, stride, padding, dilation, ceil_mode);
   return std::get<0>(output_and_indices);
 }
+
+// CPU max and average poolings, see cpu/PoolingKernel.cpp. They replace the
+// THNN kernels, and take the same arguments and make the same checks.
+namespace {
+
+// The value of dimension i of a pooling argument given for every spatial
+// dimension, or once for all of them.
+int64_t pooling_arg(
+    const char* function_name, const char* argument_name,
+    IntArrayRef arg, int64_t spatial_dims, int64_t i) {
+  AT_CHECK(
+      arg.size() == 1 || static_cast<int64_t>(arg.size()) == spatial_dims,
+      function_name, "() argument '", argument_name, "' should contain one or ",
+      spatial_dims, " ints (got ", arg.size(), ")");
+  return arg.size() == 1 ? arg[0] : arg[i];
+}
+
+PoolingParams pooling_params(
+    const char* function_name, const Tensor& input, int64_t spatial_dims,
+    IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding,
+    IntArrayRef dilation, bool ceil_mode, bool count_include_pad) {
+  const int64_t dim = input.dim();
+  AT_CHECK(
+      input.numel() > 0 && (dim == spatial_dims + 1 || dim == spatial_dims + 2),
+      function_name, "(): non-empty ", spatial_dims + 1, "D or ",
+      spatial_dims + 2, "D input tensor expected but got sizes ", input.sizes());
+  if (stride.empty()) {
+    stride = kernel_size;
+  }
+  PoolingParams p;
+  p.nbatch = dim == spatial_dims + 2 ? input.size(0) : 1;
+  p.channels = input.size(-spatial_dims - 1);
+  p.count_include_pad = count_include_pad;
+  p.channels_last = false;
+  // 2d poolings are 3d poolings of depth 1
+  const int64_t offset = 3 - spatial_dims;
+  for (int64_t i = 0; i < 3; i++) {
+    if (i < offset) {
+      p.input_size[i] = p.output_size[i] = 1;
+      p.kernel[i] = p.stride[i] = p.dilation[i] = 1;
+      p.padding[i] = 0;
+      continue;
+    }
+    const int64_t j = i - offset;
+    p.input_size[i] = input.size(dim - spatial_dims + j);
+    p.kernel[i] = pooling_arg(function_name, "kernel_size", kernel_size, spatial_dims, j);
+    p.stride[i] = pooling_arg(function_name, "stride", stride, spatial_dims, j);
+    p.padding[i] = pooling_arg(function_name, "padding", padding, spatial_dims, j);
+    p.dilation[i] = pooling_arg(function_name, "dilation", dilation, spatial_dims, j);
+    AT_CHECK(p.kernel[i] > 0, function_name,
+             "(): kernel size should be greater than zero, but got ", kernel_size);
+    AT_CHECK(p.stride[i] > 0, function_name,
+             "(): stride should be greater than zero, but got ", stride);
+    AT_CHECK(p.dilation[i] > 0, function_name,
+             "(): dilation should be greater than zero, but got ", dilation);
+    AT_CHECK(p.kernel[i] / 2 >= p.padding[i], function_name,
+             "(): pad should be smaller than half of kernel size, but got padding ",
+             padding, " and kernel size ", kernel_size);
+    p.output_size[i] = pooling_output_shape(
+        p.input_size[i], p.kernel[i], p.padding[i], p.stride[i], p.dilation[i], ceil_mode);
+    AT_CHECK(p.output_size[i] >= 1, function_name, "(): given input size ",
+             input.sizes(), ", the calculated output size is too small");
+  }
+  return p;
+}
+
+std::vector<int64_t> pooling_output_sizes(const Tensor& input, const PoolingParams& p, int64_t spatial_dims) {
+  auto sizes = input.sizes().vec();
+  for (int64_t j = 0; j < spatial_dims; j++) {
+    sizes[input.dim() - spatial_dims + j] = p.output_size[3 - spatial_dims + j];
+  }
+  return sizes;
+}
+
+// Channels last 2d inputs are pooled in channels last, when the output is
+// channels last too.
+bool pool_channels_last(const Tensor& input, const Tensor& output, int64_t spatial_dims) {
+  return spatial_dims == 2 && input.dim() == 4 &&
+      input.suggest_memory_format() == MemoryFormat::ChannelsLast &&
+      output.is_contiguous(MemoryFormat::ChannelsLast);
+}
+
+// Poolings output in a new tensor of channels last 2d inputs that is channels
+// last too, so that the following layers see the same layout.
+Tensor pooling_empty_output(const Tensor& input, const PoolingParams& p, int64_t spatial_dims) {
+  if (spatial_dims == 2 && input.dim() == 4 &&
+      input.suggest_memory_format() == MemoryFormat::ChannelsLast) {
+    return at::empty(pooling_output_sizes(input, p, spatial_dims),
+                     input.options(), MemoryFormat::ChannelsLast);
+  }
+  return at::empty({0}, input.options());
+}
+
+// indices is undefined for the inference variant of max pooling
+void max_pool_out_cpu_template(
+    const char* function_name, Tensor& output, Tensor& indices,
+    const Tensor& input_, int64_t spatial_dims, IntArrayRef kernel_size,
+    IntArrayRef stride, IntArrayRef padding, IntArrayRef dilation,
+    bool ceil_mode) {
+  auto p = pooling_params(function_name, input_, spatial_dims, kernel_size, stride,
+                          padding, dilation, ceil_mode, /*count_include_pad=*/false);
+  const auto sizes = pooling_output_sizes(input_, p, spatial_dims);
+  output.resize_(sizes);
+  if (!indices.defined() && pool_channels_last(input_, output, spatial_dims)) {
+    p.channels_last = true;
+    max_pool_kernel(kCPU, output, indices, input_.contiguous(MemoryFormat::ChannelsLast), p);
+    return;
+  }
+  const auto input = input_.contiguous();
+  Tensor result = output.is_contiguous() ? output : at::empty(sizes, output.options());
+  Tensor result_indices;
+  if (indices.defined()) {
+    indices.resize_(sizes);
+    result_indices = indices.is_contiguous() ? indices : at::empty(sizes, indices.options());
+  }
+  max_pool_kernel(kCPU, result, result_indices, input, p);
+  if (!result.is_same(output)) {
+    output.copy_(result);
+  }
+  if (indices.defined() && !result_indices.is_same(indices)) {
+    indices.copy_(result_indices);
+  }
+}
+
+void avg_pool_out_cpu_template(
+    const char* function_name, Tensor& output, const Tensor& input_,
+    int64_t spatial_dims, IntArrayRef kernel_size, IntArrayRef stride,
+    IntArrayRef padding, bool ceil_mode, bool count_include_pad) {
+  auto p = pooling_params(function_name, input_, spatial_dims, kernel_size, stride,
+                          padding, /*dilation=*/1, ceil_mode, count_include_pad);
+  const auto sizes = pooling_output_sizes(input_, p, spatial_dims);
+  output.resize_(sizes);
+  if (pool_channels_last(input_, output, spatial_dims)) {
+    p.channels_last = true;
+    avg_pool_kernel(kCPU, output, input_.contiguous(MemoryFormat::ChannelsLast), p);
+    return;
+  }
+  const auto input = input_.contiguous();
+  Tensor result = output.is_contiguous() ? output : at::empty(sizes, output.options());
+  avg_pool_kernel(kCPU, result, input, p);
+  if (!result.is_same(output)) {
+    output.copy_(result);
+  }
+}
+
+std::tuple<Tensor, Tensor> max_pool_with_indices_cpu(
+    const char* function_name, const Tensor& self, int64_t spatial_dims,
+    IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding,
+    IntArrayRef dilation, bool ceil_mode) {
+  Tensor output = at::empty({0}, self.options());
+  Tensor indices = at::empty({0}, self.options().dtype(kLong));
+  max_pool_out_cpu_template(function_name, output, indices, self, spatial_dims,
+                            kernel_size, stride, padding, dilation, ceil_mode);
+  return std::make_tuple(output, indices);
+}
+
+Tensor max_pool_inference_cpu(
+    const char* function_name, const Tensor& self, int64_t spatial_dims,
+    IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding,
+    IntArrayRef dilation, bool ceil_mode) {
+  const auto p = pooling_params(function_name, self, spatial_dims, kernel_size, stride,
+                                padding, dilation, ceil_mode, /*count_include_pad=*/false);
+  Tensor output = pooling_empty_output(self, p, spatial_dims);
+  Tensor no_indices;
+  max_pool_out_cpu_template(function_name, output, no_indices, self, spatial_dims,
+                            kernel_size, stride, padding, dilation, ceil_mode);
+  return output;
+}
+
+Tensor avg_pool_cpu(
+    const char* function_name, const Tensor& self, int64_t spatial_dims,
+    IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding,
+    bool ceil_mode, bool count_include_pad) {
+  const auto p = pooling_params(function_name, self, spatial_dims, kernel_size, stride,
+                                padding, /*dilation=*/1, ceil_mode, count_include_pad);
+  Tensor output = pooling_empty_output(self, p, spatial_dims);
+  avg_pool_out_cpu_template(function_name, output, self, spatial_dims, kernel_size,
+                            stride, padding, ceil_mode, count_include_pad);
+  return output;
+}
+
+} // namespace
+
+std::tuple<Tensor&, Tensor&> max_pool2d_with_indices_out_cpu(
+    Tensor& output,
+    Tensor& indices,
+    const Tensor& self,
+    IntArrayRef kernel_size,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    bool ceil_mode) {
+  max_pool_out_cpu_template("max_pool2d_with_indices", output, indices, self, 2,
+                            kernel_size, stride, padding, dilation, ceil_mode);
+  return std::tuple<Tensor&, Tensor&>(output, indices);
+}
+
+std::tuple<Tensor, Tensor> max_pool2d_with_indices_cpu(
+    const Tensor& self,
+    IntArrayRef kernel_size,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    bool ceil_mode) {
+  return max_pool_with_indices_cpu("max_pool2d_with_indices", self, 2,
+                                   kernel_size, stride, padding, dilation, ceil_mode);
+}
+
+std::tuple<Tensor&, Tensor&> max_pool3d_with_indices_out_cpu(
+    Tensor& output,
+    Tensor& indices,
+    const Tensor& self,
+    IntArrayRef kernel_size,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    bool ceil_mode) {
+  max_pool_out_cpu_template("max_pool3d_with_indices", output, indices, self, 3,
+                            kernel_size, stride, padding, dilation, ceil_mode);
+  return std::tuple<Tensor&, Tensor&>(output, indices);
+}
+
+std::tuple<Tensor, Tensor> max_pool3d_with_indices_cpu(
+    const Tensor& self,
+    IntArrayRef kernel_size,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    bool ceil_mode) {
+  return max_pool_with_indices_cpu("max_pool3d_with_indices", self, 3,
+                                   kernel_size, stride, padding, dilation, ceil_mode);
+}
+
+Tensor max_pool2d_inference_cpu(
+    const Tensor& self,
+    IntArrayRef kernel_size,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    bool ceil_mode) {
+  return max_pool_inference_cpu("max_pool2d", self, 2, kernel_size, stride,
+                                padding, dilation, ceil_mode);
+}
+
+Tensor max_pool3d_inference_cpu(
+    const Tensor& self,
+    IntArrayRef kernel_size,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    bool ceil_mode) {
+  return max_pool_inference_cpu("max_pool3d", self, 3, kernel_size, stride,
+                                padding, dilation, ceil_mode);
+}
+
+Tensor& avg_pool2d_out_cpu(
+    Tensor& output,
+    const Tensor& self,
+    IntArrayRef kernel_size,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    bool ceil_mode,
+    bool count_include_pad) {
+  avg_pool_out_cpu_template("avg_pool2d", output, self, 2, kernel_size, stride,
+                            padding, ceil_mode, count_include_pad);
+  return output;
+}
+
+Tensor avg_pool2d_cpu(
+    const Tensor& self,
+    IntArrayRef kernel_size,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    bool ceil_mode,
+    bool count_include_pad) {
+  return avg_pool_cpu("avg_pool2d", self, 2, kernel_size, stride, padding,
+                      ceil_mode, count_include_pad);
+}
+
+Tensor& avg_pool3d_out_cpu(
+    Tensor& output,
+    const Tensor& self,
+    IntArrayRef kernel_size,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    bool ceil_mode,
+    bool count_include_pad) {
+  avg_pool_out_cpu_template("avg_pool3d", output, self, 3, kernel_size, stride,
+                            padding, ceil_mode, count_include_pad);
+  return output;
+}
+
+Tensor avg_pool3d_cpu(
+    const Tensor& self,
+    IntArrayRef kernel_size,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    bool ceil_mode,
+    bool count_include_pad) {
+  return avg_pool_cpu("avg_pool3d", self, 3, kernel_size, stride, padding,
+                      ceil_mode, count_include_pad);
+}
 } // namespace native
 } // namespace at
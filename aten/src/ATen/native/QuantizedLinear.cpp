@@ -1,13 +1,16 @@
 #include "ATen/ATen.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/Parallel.h"
 #include "ATen/WrapDimUtilsMulti.h"
 #include "ATen/cpp_custom_type_hack.h"
 
 #ifdef USE_FBGEMM
 #include "fbgemm/Fbgemm.h"
+#include "fbgemm/FbgemmFP16.h"
 #include "fbgemm/QuantUtils.h"
 #endif // USE_FBGEMM
 
+#include <algorithm>
 #include <array>
 #include <cctype>
 #include <cmath>
@@ -22,6 +25,7 @@ namespace caffe2 {
 #ifdef USE_FBGEMM
 // Required for cpp_custom_type_hack to work
 CAFFE_KNOWN_TYPE(fbgemm::PackBMatrix<int8_t>);
+CAFFE_KNOWN_TYPE(fbgemm::PackedGemmMatrixFP16);
 #endif // USE_FBGEMM
 }
 
@@ -82,25 +86,6 @@ Tensor fbgemm_linear_int8_weight(
 
   q_params.precision = precision;
 
-  // This operation does the following:
-  // 1) Quantizes the input matrix given the statistics we've calculated above
-  // 2) Creates a "row buffer" vector with offset values that must be added
-  //    to the integer matrix multiplication operation to ensure correctness
-  // 3) Packs the resulting quantized matrix into vector-register and cache
-  //    friendly tiles.
-  //
-  //  Note this is not executed eagerly, but rather within the fbgemmPacked call
-  //  below.
-  fbgemm::PackAWithQuantRowOffset<uint8_t> packA(
-      /*trans=*/fbgemm::matrix_op_t::NoTranspose,
-      /*nRow=*/M,
-      /*nCol=*/K,
-      /*smat=*/input_ptr,
-      /*ld=*/K,
-      /*pmat=*/nullptr, // packA manages ownership of `pmat`
-      /*scale=*/q_params.scale,
-      /*zero_pt=*/q_params.zero_point);
-
   // ReQuantizeForFloat requires pointers to the scale and zero point values,
   // since in the case of rowwise quantization these will be arrays rather than
   // scalars. But in this case, we're doing whole-tensor quantization so we just
@@ -110,27 +95,8 @@ Tensor fbgemm_linear_int8_weight(
   int32_t weight_zero_point_int32 =
       static_cast<int32_t>(weight_zero_point.to<int64_t>());
 
-  // This is the end of the pipeline, pass the resulting matrix through
-  fbgemm::DoNothing<float, float> doNothingObj{};
-
   auto bias_contig = bias.contiguous();
 
-  // After the uint8 * int8 matrix multiplication is performed, this operation
-  // does:
-  //  1) Add in row and column offsets to the rows and columns, respectively
-  //  2) Dequantize the results into floating point
-  //  3) Add in the bias term
-  fbgemm::ReQuantizeForFloat<false /* FUSE_RELU*/> outputProcObj(
-      /*nextop=*/doNothingObj,
-      /*Aq_scale=*/q_params.scale,
-      /*Bq_scale=*/&weight_scale_float,
-      /*Aq_zero_point=*/q_params.zero_point,
-      /*Bq_zero_point=*/&weight_zero_point_int32,
-      /*row_offsets=*/packA.getRowOffsetBuffer(),
-      /*col_offsets=*/col_offsets.data<int32_t>(),
-      /*bias=*/bias_contig.data<float>(),
-      /*ncol=*/N);
-
   // Allocate output Tensor and a buffer for fbgemmPacked to use
   auto output = at::zeros({M, N}, bias.options().dtype(at::kFloat));
   auto buffer = at::zeros_like(output, output.options().dtype(at::kInt));
@@ -138,16 +104,61 @@ Tensor fbgemm_linear_int8_weight(
   // Pull out the PackBMatrix instance from the owning tensor
   auto& packB = cpp_custom_type_hack::cast<fbgemm::PackBMatrix<int8_t>>(packed);
 
-  // Do the GEMM
-  fbgemm::fbgemmPacked(
-      /*packA=*/packA,
-      /*packB=*/packB,
-      /*C=*/output.data<float>(),
-      /*C_buffer=*/buffer.data<int32_t>(),
-      /*ldc=*/N,
-      /*outProcess=*/outputProcObj,
-      /*thread_id=*/0,
-      /*num_threads=*/1);
+  // fbgemmPacked splits the rows of the input between num_tasks calls, each
+  // packing and quantizing its own rows with the shared quantization params.
+  const int64_t num_tasks = std::max<int64_t>(std::min<int64_t>(get_num_threads(), M), 1);
+  parallel_for(0, num_tasks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t task = begin; task < end; task++) {
+      // This operation does the following:
+      // 1) Quantizes the input matrix given the statistics we've calculated above
+      // 2) Creates a "row buffer" vector with offset values that must be added
+      //    to the integer matrix multiplication operation to ensure correctness
+      // 3) Packs the resulting quantized matrix into vector-register and cache
+      //    friendly tiles.
+      //
+      //  Note this is not executed eagerly, but rather within the fbgemmPacked call
+      //  below.
+      fbgemm::PackAWithQuantRowOffset<uint8_t> packA(
+          /*trans=*/fbgemm::matrix_op_t::NoTranspose,
+          /*nRow=*/M,
+          /*nCol=*/K,
+          /*smat=*/input_ptr,
+          /*ld=*/K,
+          /*pmat=*/nullptr, // packA manages ownership of `pmat`
+          /*scale=*/q_params.scale,
+          /*zero_pt=*/q_params.zero_point);
+
+      // This is the end of the pipeline, pass the resulting matrix through
+      fbgemm::DoNothing<float, float> doNothingObj{};
+
+      // After the uint8 * int8 matrix multiplication is performed, this operation
+      // does:
+      //  1) Add in row and column offsets to the rows and columns, respectively
+      //  2) Dequantize the results into floating point
+      //  3) Add in the bias term
+      fbgemm::ReQuantizeForFloat<false /* FUSE_RELU*/> outputProcObj(
+          /*nextop=*/doNothingObj,
+          /*Aq_scale=*/q_params.scale,
+          /*Bq_scale=*/&weight_scale_float,
+          /*Aq_zero_point=*/q_params.zero_point,
+          /*Bq_zero_point=*/&weight_zero_point_int32,
+          /*row_offsets=*/packA.getRowOffsetBuffer(),
+          /*col_offsets=*/col_offsets.data<int32_t>(),
+          /*bias=*/bias_contig.data<float>(),
+          /*ncol=*/N);
+
+      // Do the GEMM
+      fbgemm::fbgemmPacked(
+          /*packA=*/packA,
+          /*packB=*/packB,
+          /*C=*/output.data<float>(),
+          /*C_buffer=*/buffer.data<int32_t>(),
+          /*ldc=*/N,
+          /*outProcess=*/outputProcObj,
+          /*thread_id=*/task,
+          /*num_threads=*/num_tasks);
+    }
+  });
 
   // The resulting matrix here is 2-D, let's view it with the original
   // left hand dimensions of the input.
@@ -252,6 +263,73 @@ Tensor fbgemm_pack_quantized_matrix(
   return cpp_custom_type_hack::create(std::move(ptr), weight.options());
 }
 
+Tensor fbgemm_pack_gemm_matrix_fp16(const Tensor& weight) {
+  // We make a strong guarantee that models using these operators will have the
+  // same numerics across different machines. Therefore, we do not provide a
+  // fallback path and rather fail loudly if we cannot run FBGEMM.
+  AT_ASSERTM(fbgemm::fbgemmSupportedCPU(), "Your CPU does not support FBGEMM.");
+  AT_ASSERT(weight.dim() == 2);
+  const int64_t K = weight.size(1);
+  const int64_t N = weight.size(0);
+  auto weight_contig = weight.to(at::kFloat).contiguous();
+  // The weight is rounded to fp16 once here; the GEMM converts it back to
+  // fp32 in registers and accumulates in fp32.
+  auto ptr = guts::make_unique<fbgemm::PackedGemmMatrixFP16>(
+      /*trans=*/fbgemm::matrix_op_t::Transpose,
+      /*nrow=*/K,
+      /*ncol=*/N,
+      /*alpha=*/1.0f,
+      /*smat=*/weight_contig.data<float>());
+  return cpp_custom_type_hack::create(std::move(ptr), weight.options());
+}
+
+Tensor fbgemm_linear_fp16_weight(
+    const Tensor& input,
+    const Tensor& packed_weight,
+    const Tensor& bias) {
+  // We make a strong guarantee that models using these operators will have the
+  // same numerics across different machines. Therefore, we do not provide a
+  // fallback path and rather fail loudly if we cannot run FBGEMM.
+  AT_ASSERTM(fbgemm::fbgemmSupportedCPU(), "Your CPU does not support FBGEMM.");
+
+  auto input_contig = input.to(at::kFloat).contiguous();
+  const float* input_ptr = input_contig.data<float>();
+
+  // Pull out the PackedGemmMatrixFP16 instance from the owning tensor
+  const auto& packed =
+      cpp_custom_type_hack::cast<fbgemm::PackedGemmMatrixFP16>(packed_weight);
+
+  AT_ASSERT(input.dim() >= 2);
+  const int64_t K = input.size(input.dim() - 1);
+  AT_ASSERT(K == packed.numRows());
+  const int64_t M = input.numel() / K;
+  const int64_t N = packed.numCols();
+  AT_ASSERT(bias.dim() == 1);
+  AT_ASSERT(bias.size(0) == N);
+
+  // Start from the bias and accumulate the product onto it
+  auto output = bias.to(at::kFloat).expand({M, N}).contiguous();
+  float* output_ptr = output.data<float>();
+
+  // Each chunk of rows is an independent GEMM against the shared packed weight
+  parallel_for(0, M, std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(N * K, 1), 1),
+      [&](int64_t begin, int64_t end) {
+    fbgemm::cblas_gemm_compute(
+        /*transa=*/fbgemm::matrix_op_t::NoTranspose,
+        /*m=*/end - begin,
+        /*A=*/input_ptr + begin * K,
+        /*Bp=*/packed,
+        /*beta=*/1.0f,
+        /*C=*/output_ptr + begin * N);
+  });
+
+  // The resulting matrix here is 2-D, let's view it with the original
+  // left hand dimensions of the input.
+  std::vector<int64_t> out_sizes = input.sizes().vec();
+  out_sizes.back() = N;
+  return output.view(out_sizes);
+}
+
 #else // USE_FBGEMM
 
 Tensor fbgemm_linear_int8_weight(
@@ -289,6 +367,25 @@ Tensor fbgemm_pack_quantized_matrix(
       false, "This PyTorch installation was not built with FBGEMM operators");
 }
 
+Tensor fbgemm_pack_gemm_matrix_fp16(const Tensor& /*weight*/) {
+  // We make a strong guarantee that models using these operators will have the
+  // same numerics across different machines. Therefore, we do not provide a
+  // fallback path and rather fail loudly if we cannot run FBGEMM.
+  AT_ASSERTM(
+      false, "This PyTorch installation was not built with FBGEMM operators");
+}
+
+Tensor fbgemm_linear_fp16_weight(
+    const Tensor& /*input*/,
+    const Tensor& /*packed_weight*/,
+    const Tensor& /*bias*/) {
+  // We make a strong guarantee that models using these operators will have the
+  // same numerics across different machines. Therefore, we do not provide a
+  // fallback path and rather fail loudly if we cannot run FBGEMM.
+  AT_ASSERTM(
+      false, "This PyTorch installation was not built with FBGEMM operators");
+}
+
 bool fbgemm_is_cpu_supported() {
   return false;
 }
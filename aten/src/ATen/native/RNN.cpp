@@ -3,6 +3,8 @@
 #include <ATen/ATen.h>
 #include <ATen/NativeFunctions.h>
 
+#include <algorithm>
+
 namespace at { namespace native {
 
 namespace {
@@ -592,13 +594,89 @@ std::tuple<io_type, Tensor, Tensor> _lstm_impl(
   return std::make_tuple(result.outputs, at::stack(hy, 0), at::stack(cy, 0));
 }
 
+// Persistent RNNs
+//
+// For small batches on CUDA, the per-step kernel launches of cuDNN and of the
+// implementation above dominate the runtime. When the recurrent weights fit in
+// the shared memory of the device, _persistent_rnn runs all steps of a layer
+// in a single launch instead, see PersistentRNN.cu. It has no backward, so it
+// is only used when train is false and either backward is unsupported anyway
+// (cuDNN would have been used, and it can't backward in inference) or nothing
+// requires grad.
+bool use_persistent_rnn(
+      const Tensor& input, TensorList hx, TensorList params,
+      bool train, bool batch_first, int64_t mode) {
+  if (train || !input.is_cuda() || input.dim() != 3 || params.size() < 2) {
+    return false;
+  }
+  if (!at::cudnn_is_acceptable(input)) {
+    auto requires_grad = [](const Tensor& t) { return t.defined() && t.requires_grad(); };
+    if (requires_grad(input) ||
+        std::any_of(hx.begin(), hx.end(), requires_grad) ||
+        std::any_of(params.begin(), params.end(), requires_grad)) {
+      return false;
+    }
+  }
+  // weight_hh_l0 is [gates * hidden_size, hidden_size]
+  return at::_persistent_rnn_is_acceptable(
+      batch_first ? input.transpose(0, 1) : input, params[1].size(1), mode);
+}
+
+// Runs the layers and directions one after another, each with one GEMM for
+// the input gates of the whole sequence and one _persistent_rnn launch.
+// input is [seq_length, batch, input_size]; cx is only given for LSTMs.
+std::tuple<Tensor, Tensor, Tensor> _persistent_rnn_impl(
+      const Tensor& input, TensorList params, bool has_biases,
+      const Tensor& hx, const Tensor& cx, int64_t mode,
+      int64_t num_layers, bool bidirectional) {
+  int64_t num_directions = bidirectional ? 2 : 1;
+  int64_t params_stride = has_biases ? 4 : 2;
+  AT_CHECK(params.size() == static_cast<size_t>(num_layers * num_directions * params_stride),
+           "got an incorrect number of RNN parameters");
+  bool is_lstm = mode == PERSISTENT_RNN_LSTM;
+  auto layer_hx = hx.unbind(0);
+  auto layer_cx = is_lstm ? cx.unbind(0) : std::vector<Tensor>{};
+
+  Tensor layer_input = input;
+  std::vector<Tensor> hy, cy;
+  for (int64_t layer = 0; layer < num_layers; ++layer) {
+    std::vector<Tensor> outputs;
+    for (int64_t direction = 0; direction < num_directions; ++direction) {
+      int64_t index = layer * num_directions + direction;
+      const Tensor* p = &params[index * params_stride];
+      Tensor input_gates = at::matmul(layer_input, p[0].t());
+      Tensor bias_hh;
+      if (has_biases) {
+        input_gates.add_(p[2]);
+        // The recurrent bias of the new gate of a GRU is scaled by the reset
+        // gate, so it can't be folded into the input gates
+        if (mode == PERSISTENT_RNN_GRU) {
+          bias_hh = p[3];
+        } else {
+          input_gates.add_(p[3]);
+        }
+      }
+      auto result = at::_persistent_rnn(
+          input_gates, p[1], bias_hh, layer_hx[index],
+          is_lstm ? layer_cx[index] : Tensor(), mode, /*reverse=*/direction == 1);
+      outputs.push_back(std::get<0>(result));
+      hy.push_back(std::get<1>(result));
+      if (is_lstm) {
+        cy.push_back(std::get<2>(result));
+      }
+    }
+    layer_input = num_directions == 1 ? outputs[0] : at::cat(outputs, 2);
+  }
+  return std::make_tuple(layer_input, at::stack(hy, 0), is_lstm ? at::stack(cy, 0) : Tensor());
+}
+
 } // anonymous namespace
 
 ////////////////////////////////////////////////////////////////////////////////
 // PUBLIC FUNCTIONS
 ////////////////////////////////////////////////////////////////////////////////
 
-#define ONE_HIDDEN_RNN(NAME, CELL)                                             \
+#define ONE_HIDDEN_RNN(NAME, CELL, MODE)                                       \
 DEFINE_DISPATCH(NAME##_cudnn_stub);                                            \
 DEFINE_DISPATCH(NAME##_packed_cudnn_stub);                                     \
 REGISTER_NO_CPU_DISPATCH(NAME##_cudnn_stub, rnn_fn);                           \
@@ -608,6 +686,15 @@ std::tuple<Tensor, Tensor> NAME(                                               \
       const Tensor& _input, const Tensor& hx,                                  \
       TensorList _params, bool has_biases,                                     \
       int64_t num_layers, double dropout_p, bool train, bool bidirectional, bool batch_first) { \
+  if (use_persistent_rnn(_input, hx, _params, train, batch_first, MODE)) {     \
+    check_device(_input, _params, hx);                                         \
+    auto input = batch_first ? _input.transpose(0, 1) : _input;                \
+    auto results = _persistent_rnn_impl(input, _params, has_biases, hx, Tensor(), \
+            MODE, num_layers, bidirectional);                                  \
+    auto output = std::get<0>(results);                                        \
+    return std::make_tuple(batch_first ? output.transpose(0, 1) : output,     \
+                           std::get<1>(results));                              \
+  }                                                                            \
   if (at::cudnn_is_acceptable(_input)) {                                       \
     Tensor output, hy;                                                         \
     NAME##_cudnn_stub(_input.type().device_type(), output, hy, _input, hx, _params, has_biases, \
@@ -643,11 +730,11 @@ std::tuple<Tensor, Tensor> NAME(                                               \
   return std::make_tuple(packed_output.data, std::get<1>(result));             \
 }
 
-ONE_HIDDEN_RNN(gru, GRUCell<CellParams>)
+ONE_HIDDEN_RNN(gru, GRUCell<CellParams>, PERSISTENT_RNN_GRU)
 using tanf_cell_type = SimpleCell<tanh_f, CellParams>;
-ONE_HIDDEN_RNN(rnn_tanh, tanf_cell_type)
+ONE_HIDDEN_RNN(rnn_tanh, tanf_cell_type, PERSISTENT_RNN_TANH)
 using relu_cell_type = SimpleCell<relu_f, CellParams>;
-ONE_HIDDEN_RNN(rnn_relu, relu_cell_type);
+ONE_HIDDEN_RNN(rnn_relu, relu_cell_type, PERSISTENT_RNN_RELU);
 
 DEFINE_DISPATCH(lstm_cudnn_stub);
 DEFINE_DISPATCH(lstm_packed_cudnn_stub);
@@ -659,6 +746,16 @@ std::tuple<Tensor, Tensor, Tensor> lstm(
       TensorList _params, bool has_biases,
       int64_t num_layers, double dropout_p, bool train, bool bidirectional, bool batch_first) {
   AT_CHECK(hx.size() == 2, "lstm expects two hidden states");
+  if (use_persistent_rnn(_input, hx, _params, train, batch_first, PERSISTENT_RNN_LSTM)) {
+    check_device(_input, _params, hx);
+    auto input = batch_first ? _input.transpose(0, 1) : _input;
+    auto results = _persistent_rnn_impl(input, _params, has_biases, hx[0], hx[1],
+            PERSISTENT_RNN_LSTM, num_layers, bidirectional);
+    if (batch_first) {
+      std::get<0>(results) = std::get<0>(results).transpose(0, 1);
+    }
+    return results;
+  }
   if (at::cudnn_is_acceptable(_input)) {
     Tensor output, hy, cy;
     lstm_cudnn_stub(_input.type().device_type(), output, hy, cy, _input, hx, _params, has_biases,
@@ -724,7 +821,10 @@ Tensor rnn_relu_cell(
 //
 // These implementations use FBGEMM to do the i2h and h2h linear layers with
 // an int8 quantized weight. This is advantageous in small-batch-size scenarios
-// where runtime is dominated by memory fetches of the weight matrix.
+// where runtime is dominated by memory fetches of the weight matrix. The
+// activations are quantized on every call from their own range, and the
+// products are accumulated and returned in fp32, so only the weights need to
+// be quantized ahead of time.
 
 std::tuple<Tensor, Tensor, Tensor> quantized_lstm(
       const Tensor& _input, TensorList hx,
@@ -749,6 +849,51 @@ std::tuple<Tensor, Tensor, Tensor> quantized_lstm(
   return results;
 }
 
+std::tuple<Tensor, Tensor, Tensor> quantized_lstm(
+      const Tensor& data, const Tensor& batch_sizes, TensorList hx,
+      TensorList _params, bool has_biases,
+      int64_t num_layers, double dropout_p, bool train, bool bidirectional) {
+  AT_CHECK(hx.size() == 2, "lstm expects two hidden states");
+  AT_CHECK(has_biases, "quantized LSTM requires biases");
+  PackedSequence input { data, batch_sizes };
+  auto params = gather_quantized_params(_params);
+  auto result = _lstm_impl<PackedLayer, PackedBidirectionalLayer>(
+      input, params, hx[0], hx[1], num_layers, dropout_p, train, bidirectional);
+  auto & packed_output = std::get<0>(result);
+  return std::make_tuple(packed_output.data, std::get<1>(result), std::get<2>(result));
+}
+
+using quantized_gru_type = GRUCell<QuantizedCellParams>;
+
+std::tuple<Tensor, Tensor> quantized_gru(
+      const Tensor& _input, const Tensor& hx,
+      TensorList _params, bool has_biases,
+      int64_t num_layers, double dropout_p, bool train, bool bidirectional, bool batch_first) {
+  check_device(_input, _params, hx);
+  AT_CHECK(has_biases, "quantized GRU requires biases");
+  auto input = batch_first ? _input.transpose(0, 1) : _input;
+  auto params = gather_quantized_params(_params);
+  auto results = _rnn_impl_with_concat<quantized_gru_type, FullLayer, FullBidirectionalLayer>(
+      input, params, hx.unbind(0), num_layers, dropout_p, train, bidirectional);
+  if (batch_first) {
+    std::get<0>(results) = std::get<0>(results).transpose(0, 1);
+  }
+  return results;
+}
+
+std::tuple<Tensor, Tensor> quantized_gru(
+      const Tensor& data, const Tensor& batch_sizes, const Tensor& hx,
+      TensorList _params, bool has_biases,
+      int64_t num_layers, double dropout_p, bool train, bool bidirectional) {
+  AT_CHECK(has_biases, "quantized GRU requires biases");
+  PackedSequence input { data, batch_sizes };
+  auto params = gather_quantized_params(_params);
+  auto result = _rnn_impl_with_concat<quantized_gru_type, PackedLayer, PackedBidirectionalLayer>(
+      input, params, hx.unbind(0), num_layers, dropout_p, train, bidirectional);
+  auto & packed_output = std::get<0>(result);
+  return std::make_tuple(packed_output.data, std::get<1>(result));
+}
+
 #define DEFINE_QUANTIZED_RNN_CELL(name, hx_type, cell_type, return_type, prepare_hx_fn) \
 return_type name( \
     const Tensor& input, \
@@ -19,6 +19,14 @@ DECLARE_DISPATCH(rnn_packed_fn, gru_packed_cudnn_stub);
 DECLARE_DISPATCH(rnn_packed_fn, rnn_tanh_packed_cudnn_stub);
 DECLARE_DISPATCH(rnn_packed_fn, rnn_relu_packed_cudnn_stub);
 
+// Cell types of _persistent_rnn, numbered like cudnnRNNMode_t
+enum PersistentRNNMode : int64_t {
+  PERSISTENT_RNN_RELU = 0,
+  PERSISTENT_RNN_TANH = 1,
+  PERSISTENT_RNN_LSTM = 2,
+  PERSISTENT_RNN_GRU = 3,
+};
+
 inline void check_device(const Tensor& input, const TensorList& params, const TensorList& hiddens) {
   auto input_device = input.device();
 
@@ -0,0 +1,102 @@
+#include <ATen/ATen.h>
+#include <ATen/NativeFunctions.h>
+
+#include <ATen/native/SegmentReduce.h>
+
+namespace at { namespace native {
+
+DEFINE_DISPATCH(segment_reduce_stub);
+
+SegmentReduction get_segment_reduction(const std::string& reduce) {
+  if (reduce == "sum") {
+    return SEGMENT_REDUCE_SUM;
+  } else if (reduce == "mean") {
+    return SEGMENT_REDUCE_MEAN;
+  } else if (reduce == "max") {
+    return SEGMENT_REDUCE_MAX;
+  } else if (reduce == "min") {
+    return SEGMENT_REDUCE_MIN;
+  }
+  AT_ERROR("segment_reduce: expected reduce to be one of sum, mean, max or min, but got ", reduce);
+}
+
+// The lengths of the segments, shaped to broadcast against the result
+static Tensor segment_lengths(const Tensor& offsets, int64_t dim) {
+  int64_t num_segments = offsets.size(0) - 1;
+  std::vector<int64_t> sizes(dim, 1);
+  sizes[0] = num_segments;
+  return (offsets.narrow(0, 1, num_segments) - offsets.narrow(0, 0, num_segments)).view(sizes);
+}
+
+Tensor segment_reduce(const Tensor& data, const Tensor& offsets, std::string reduce) {
+  auto reduction = get_segment_reduction(reduce);
+  AT_CHECK(data.dim() >= 1, "segment_reduce: expected data to have at least one dimension");
+  AT_CHECK(offsets.dim() == 1 && offsets.size(0) >= 1,
+           "segment_reduce: expected offsets to be a non-empty 1-D tensor, but got sizes ", offsets.sizes());
+  AT_CHECK(offsets.scalar_type() == kLong,
+           "segment_reduce: expected offsets to be a Long tensor, but got ", offsets.scalar_type());
+  AT_CHECK(offsets.device() == data.device(),
+           "segment_reduce: expected offsets on the device of data (", data.device(), "), but got ", offsets.device());
+
+  int64_t num_segments = offsets.size(0) - 1;
+  auto sizes = data.sizes().vec();
+  sizes[0] = num_segments;
+  Tensor result = at::empty(sizes, data.options());
+  if (num_segments == 0 || result.numel() == 0) {
+    return result.zero_();
+  }
+
+  auto data_ = data.contiguous();
+  auto offsets_ = offsets.contiguous();
+  int64_t inner_size = result.numel() / num_segments;
+  Tensor result_2d = result.view({num_segments, inner_size});
+  segment_reduce_stub(data.device().type(), result_2d, data_.view({data.size(0), inner_size}), offsets_, reduction);
+
+  auto lengths = segment_lengths(offsets_, data.dim());
+  if (reduction == SEGMENT_REDUCE_MEAN) {
+    result.div_(lengths.clamp_min(1).to(result.scalar_type()));
+  } else if (reduction == SEGMENT_REDUCE_MAX || reduction == SEGMENT_REDUCE_MIN) {
+    result.masked_fill_((lengths == 0).expand_as(result), 0);
+  }
+  return result;
+}
+
+Tensor segment_reduce_backward(const Tensor& grad, const Tensor& data, const Tensor& offsets,
+                               std::string reduce, const Tensor& result) {
+  auto reduction = get_segment_reduction(reduce);
+  int64_t num_segments = offsets.size(0) - 1;
+  Tensor grad_input = at::zeros_like(data);
+  if (num_segments == 0 || data.numel() == 0) {
+    return grad_input;
+  }
+
+  // The rows outside [offsets[0], offsets[-1]) belong to no segment
+  int64_t begin = offsets[0].item<int64_t>();
+  int64_t end = offsets[num_segments].item<int64_t>();
+  auto lengths = segment_lengths(offsets, data.dim());
+  auto segment_ids = at::repeat_interleave(
+      at::arange(num_segments, offsets.options()), lengths.view({num_segments}));
+  auto grad_rows = grad_input.narrow(0, begin, end - begin);
+
+  switch (reduction) {
+    case SEGMENT_REDUCE_SUM:
+      grad_rows.copy_(grad.index_select(0, segment_ids));
+      break;
+    case SEGMENT_REDUCE_MEAN:
+      grad_rows.copy_((grad / lengths.clamp_min(1).to(grad.scalar_type())).index_select(0, segment_ids));
+      break;
+    case SEGMENT_REDUCE_MAX:
+    case SEGMENT_REDUCE_MIN: {
+      // Ties share the gradient of their segment evenly
+      auto rows = data.narrow(0, begin, end - begin);
+      auto mask = (rows == result.index_select(0, segment_ids)).to(grad.scalar_type());
+      auto shifted_offsets = offsets - begin;
+      auto counts = at::segment_reduce(mask, shifted_offsets, "sum");
+      grad_rows.copy_((grad / counts.clamp_min(1)).index_select(0, segment_ids) * mask);
+      break;
+    }
+  }
+  return grad_input;
+}
+
+}} // namespace at::native
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+#include <string>
+
+namespace at { namespace native {
+
+enum SegmentReduction { SEGMENT_REDUCE_SUM, SEGMENT_REDUCE_MEAN, SEGMENT_REDUCE_MAX, SEGMENT_REDUCE_MIN };
+
+SegmentReduction get_segment_reduction(const std::string& reduce);
+
+// Reduces the rows [offsets[s], offsets[s + 1]) of the contiguous
+// [num_rows, inner_size] data into row s of the contiguous
+// [num_segments, inner_size] result. Mean is reduced as a sum and rows of
+// empty segments are left at the identity of the reduction; segment_reduce
+// fixes both up afterwards.
+using segment_reduce_fn = void(*)(Tensor& result, const Tensor& data, const Tensor& offsets, SegmentReduction reduction);
+
+DECLARE_DISPATCH(segment_reduce_fn, segment_reduce_stub);
+
+}} // namespace at::native
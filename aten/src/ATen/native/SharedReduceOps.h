@@ -128,6 +128,35 @@ struct MeanOps {
   }
 };
 
+// Like MeanOps, but for inputs of a reduced precision type (Half, BFloat16):
+// the values are accumulated in acc_t and only the result is rounded back to
+// scalar_t. With factor 1 it computes the sum.
+template <typename scalar_t, typename acc_t>
+struct ReducedPrecisionMeanOps {
+  acc_t factor;
+
+  inline C10_DEVICE acc_t reduce(acc_t acc, scalar_t data) const {
+    return acc + static_cast<acc_t>(data);
+  }
+
+  inline C10_DEVICE acc_t combine(acc_t a, acc_t b) const {
+    return a + b;
+  }
+
+  inline C10_DEVICE scalar_t project(acc_t a) const {
+    return static_cast<scalar_t>(a * factor);
+  }
+
+#if defined(__CUDACC__) || defined(__HIPCC__)
+  inline C10_DEVICE acc_t warp_shfl_down(acc_t data, int offset) const {
+    return WARP_SHFL_DOWN(data, offset);
+  }
+#endif
+
+  ReducedPrecisionMeanOps(acc_t factor): factor(factor) {
+  }
+};
+
 template <typename acc_t>
 struct AbsMinOps {
 
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+namespace at { namespace native {
+
+// Batched GEMM of matrices small enough that the overhead of calling BLAS
+// for every matrix (or MKL's batched GEMM) costs more than the arithmetic:
+// result[b] = beta * result[b] + alpha * batch1[b] @ batch2[b], or just
+// batch1[b] @ batch2[b] if is_bmm. The matrices are split between threads
+// along the batch dimension.
+using small_bmm_fn = void(*)(
+    Tensor& result, const Tensor& batch1, const Tensor& batch2,
+    Scalar beta, Scalar alpha, bool is_bmm);
+
+DECLARE_DISPATCH(small_bmm_fn, small_bmm_stub);
+
+// The largest size of any dimension of the matrices of small_bmm_stub.
+constexpr int64_t kSmallGemmMaxSize = 64;
+
+// Whether small_bmm_stub handles the arguments of bmm/baddbmm: floating
+// point matrices of at most kSmallGemmMaxSize in every dimension, and a
+// result with contiguous rows.
+inline bool can_use_small_bmm(const Tensor& result, const Tensor& batch1, const Tensor& batch2) {
+  auto type = result.scalar_type();
+  return (type == kFloat || type == kDouble)
+      && batch1.scalar_type() == type && batch2.scalar_type() == type
+      && batch1.size(1) <= kSmallGemmMaxSize
+      && batch1.size(2) <= kSmallGemmMaxSize
+      && batch2.size(2) <= kSmallGemmMaxSize
+      && (result.stride(2) == 1 || result.size(2) == 1);
+}
+
+}} // namespace at::native
@@ -0,0 +1,181 @@
+#pragma once
+
+// Factorizations and solves of matrices small enough that calling LAPACK
+// costs more than the arithmetic. The size of the matrices is a template
+// parameter, so the loops below are unrolled by the compiler.
+//
+// Matrices are column-major with a leading dimension of their size, like the
+// LAPACK inputs of BatchLinearAlgebra.cpp, and the functions here compute
+// the same outputs and `info` as their LAPACK counterparts.
+
+#include <c10/util/Exception.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace at { namespace native { namespace small_linalg {
+
+// The largest size with a specialized kernel.
+constexpr int64_t kMaxSize = 8;
+
+// Like getrf: LU factorization with partial pivoting, A = P * L * U, with L
+// unit lower triangular. ipiv holds the 1-based pivot rows.
+template <typename scalar_t, int64_t N>
+int lu(scalar_t* a, int* ipiv) {
+  int info = 0;
+  for (int64_t j = 0; j < N; j++) {
+    int64_t p = j;
+    scalar_t pmax = std::abs(a[j + j * N]);
+    for (int64_t i = j + 1; i < N; i++) {
+      scalar_t v = std::abs(a[i + j * N]);
+      if (v > pmax) {
+        pmax = v;
+        p = i;
+      }
+    }
+    ipiv[j] = static_cast<int>(p + 1);
+    if (a[p + j * N] != 0) {
+      if (p != j) {
+        for (int64_t k = 0; k < N; k++) {
+          std::swap(a[j + k * N], a[p + k * N]);
+        }
+      }
+      scalar_t inv_pivot = 1 / a[j + j * N];
+      for (int64_t i = j + 1; i < N; i++) {
+        a[i + j * N] *= inv_pivot;
+      }
+    } else if (info == 0) {
+      info = static_cast<int>(j + 1);
+    }
+    for (int64_t k = j + 1; k < N; k++) {
+      scalar_t f = a[j + k * N];
+      for (int64_t i = j + 1; i < N; i++) {
+        a[i + k * N] -= a[i + j * N] * f;
+      }
+    }
+  }
+  return info;
+}
+
+// Like getrs: solves A * X = B in place of the N x nrhs matrix b, given the
+// output of lu.
+template <typename scalar_t, int64_t N>
+void lu_solve(const scalar_t* lu, const int* ipiv, scalar_t* b, int64_t nrhs) {
+  for (int64_t c = 0; c < nrhs; c++) {
+    scalar_t* x = b + c * N;
+    for (int64_t j = 0; j < N; j++) {
+      int64_t p = ipiv[j] - 1;
+      if (p != j) {
+        std::swap(x[j], x[p]);
+      }
+    }
+    for (int64_t j = 0; j < N; j++) {
+      for (int64_t i = j + 1; i < N; i++) {
+        x[i] -= lu[i + j * N] * x[j];
+      }
+    }
+    for (int64_t j = N - 1; j >= 0; j--) {
+      x[j] /= lu[j + j * N];
+      for (int64_t i = 0; i < j; i++) {
+        x[i] -= lu[i + j * N] * x[j];
+      }
+    }
+  }
+}
+
+// Like gesv: overwrites a with its LU factorization and b with the solution.
+template <typename scalar_t, int64_t N>
+int solve(scalar_t* a, int* ipiv, scalar_t* b, int64_t nrhs) {
+  int info = lu<scalar_t, N>(a, ipiv);
+  if (info == 0) {
+    lu_solve<scalar_t, N>(a, ipiv, b, nrhs);
+  }
+  return info;
+}
+
+// Like getrf followed by getri: overwrites a with its inverse.
+template <typename scalar_t, int64_t N>
+int inverse(scalar_t* a) {
+  int ipiv[N];
+  int info = lu<scalar_t, N>(a, ipiv);
+  if (info != 0) {
+    return info;
+  }
+  scalar_t inv[N * N] = {};
+  for (int64_t i = 0; i < N; i++) {
+    inv[i + i * N] = 1;
+  }
+  lu_solve<scalar_t, N>(a, ipiv, inv, N);
+  std::copy(inv, inv + N * N, a);
+  return 0;
+}
+
+// Like potrf: Cholesky factorization of the lower (A = L * L^T) or upper
+// (A = U^T * U) triangle of a, leaving the other triangle untouched.
+template <typename scalar_t, int64_t N>
+int cholesky(scalar_t* a, bool upper) {
+  // the factor is computed as L, which for upper is stored transposed
+  auto l = [&](int64_t i, int64_t j) -> scalar_t& {
+    return upper ? a[j + i * N] : a[i + j * N];
+  };
+  for (int64_t j = 0; j < N; j++) {
+    scalar_t d = l(j, j);
+    for (int64_t k = 0; k < j; k++) {
+      d -= l(j, k) * l(j, k);
+    }
+    if (!(d > 0)) {
+      l(j, j) = d;
+      return static_cast<int>(j + 1);
+    }
+    d = std::sqrt(d);
+    l(j, j) = d;
+    for (int64_t i = j + 1; i < N; i++) {
+      scalar_t s = l(i, j);
+      for (int64_t k = 0; k < j; k++) {
+        s -= l(i, k) * l(j, k);
+      }
+      l(i, j) = s / d;
+    }
+  }
+  return 0;
+}
+
+// Calls fn<scalar_t, n>(...) for a runtime n between 1 and kMaxSize.
+#define AT_SMALL_LINALG_DISPATCH(n, fn, ...)                         \
+  switch (n) {                                                       \
+    case 1: return small_linalg::fn<scalar_t, 1>(__VA_ARGS__);       \
+    case 2: return small_linalg::fn<scalar_t, 2>(__VA_ARGS__);       \
+    case 3: return small_linalg::fn<scalar_t, 3>(__VA_ARGS__);       \
+    case 4: return small_linalg::fn<scalar_t, 4>(__VA_ARGS__);       \
+    case 5: return small_linalg::fn<scalar_t, 5>(__VA_ARGS__);       \
+    case 6: return small_linalg::fn<scalar_t, 6>(__VA_ARGS__);       \
+    case 7: return small_linalg::fn<scalar_t, 7>(__VA_ARGS__);       \
+    case 8: return small_linalg::fn<scalar_t, 8>(__VA_ARGS__);       \
+    default:                                                         \
+      AT_ERROR(#fn, ": no small matrix kernel for size ", n);        \
+  }
+
+template <typename scalar_t>
+int lu(int64_t n, scalar_t* a, int* ipiv) {
+  AT_SMALL_LINALG_DISPATCH(n, lu, a, ipiv)
+}
+
+template <typename scalar_t>
+int solve(int64_t n, scalar_t* a, int* ipiv, scalar_t* b, int64_t nrhs) {
+  AT_SMALL_LINALG_DISPATCH(n, solve, a, ipiv, b, nrhs)
+}
+
+template <typename scalar_t>
+int inverse(int64_t n, scalar_t* a) {
+  AT_SMALL_LINALG_DISPATCH(n, inverse, a)
+}
+
+template <typename scalar_t>
+int cholesky(int64_t n, scalar_t* a, bool upper) {
+  AT_SMALL_LINALG_DISPATCH(n, cholesky, a, upper)
+}
+
+#undef AT_SMALL_LINALG_DISPATCH
+
+}}} // namespace at::native::small_linalg
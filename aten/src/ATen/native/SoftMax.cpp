@@ -8,113 +8,6 @@
 
 namespace at {
 namespace native {
-namespace {
-
-template <typename scalar_t, bool LogSoftMax>
-void host_softmax(Tensor output, const Tensor& input, const int64_t dim) {
-  int64_t outer_size = 1;
-  int64_t dim_size = input.size(dim);
-  int64_t inner_size = 1;
-  for (int64_t i = 0; i < dim; ++i)
-    outer_size *= input.size(i);
-  for (int64_t i = dim + 1; i < input.dim(); ++i)
-    inner_size *= input.size(i);
-  int64_t dim_stride = inner_size;
-  int64_t outer_stride = dim_size * dim_stride;
-  scalar_t* input_data_base = input.data<scalar_t>();
-  scalar_t* output_data_base = output.data<scalar_t>();
-  int64_t grain_size = std::min(internal::GRAIN_SIZE / dim_size, (int64_t)1);
-  parallel_for(
-      0, outer_size * inner_size, grain_size,
-      [&](int64_t begin, int64_t end) {
-        for (int64_t i = begin; i < end; i++) {
-          int64_t outer_idx = i / inner_size;
-          int64_t inner_idx = i % inner_size;
-          scalar_t* input_data =
-              input_data_base + outer_idx * outer_stride + inner_idx;
-          scalar_t* output_data =
-              output_data_base + outer_idx * outer_stride + inner_idx;
-          scalar_t max_input = input_data[0];
-          for (int64_t d = 1; d < dim_size; d++)
-            max_input = std::max(max_input, input_data[d * dim_stride]);
-
-          scalar_t tmpsum = 0;
-          for (int64_t d = 0; d < dim_size; d++) {
-            scalar_t z = std::exp(input_data[d * dim_stride] - max_input);
-            if (!LogSoftMax) {
-              output_data[d * dim_stride] = z;
-            }
-            tmpsum += z;
-          }
-
-          if (LogSoftMax)
-            tmpsum = std::log(tmpsum);
-          else
-            tmpsum = 1 / tmpsum;
-
-          for (int64_t d = 0; d < dim_size; d++)
-            if (LogSoftMax)
-              output_data[d * dim_stride] =
-                  input_data[d * dim_stride] - max_input - tmpsum;
-            else
-              output_data[d * dim_stride] *= tmpsum;
-        }
-      });
-}
-
-template <typename scalar_t, bool LogSoftMax>
-void host_softmax_backward(
-    Tensor& gI,
-    const Tensor& grad,
-    const Tensor& output,
-    int64_t dim) {
-
-  int64_t outer_size = 1;
-  int64_t dim_size = grad.size(dim);
-  int64_t inner_size = 1;
-  for (int64_t i = 0; i < dim; ++i)
-    outer_size *= grad.size(i);
-  for (int64_t i = dim + 1; i < grad.dim(); ++i)
-    inner_size *= grad.size(i);
-  int64_t dim_stride = inner_size;
-  int64_t outer_stride = dim_size * dim_stride;
-  scalar_t* gradInput_data_base = gI.data<scalar_t>();
-  scalar_t* output_data_base = output.data<scalar_t>();
-  scalar_t* gradOutput_data_base = grad.data<scalar_t>();
-  int64_t grain_size = std::min(internal::GRAIN_SIZE / dim_size, (int64_t)1);
-  parallel_for(
-      0, outer_size * inner_size, grain_size, [&](int64_t begin, int64_t end) {
-        for (int64_t i = begin; i < end; i++) {
-          int64_t outer_idx = i / inner_size;
-          int64_t inner_idx = i % inner_size;
-          scalar_t* gradInput_data =
-              gradInput_data_base + outer_idx * outer_stride + inner_idx;
-          scalar_t* output_data =
-              output_data_base + outer_idx * outer_stride + inner_idx;
-          const scalar_t* gradOutput_data =
-              gradOutput_data_base + outer_idx * outer_stride + inner_idx;
-
-          scalar_t sum = 0; // TODO was accreal here
-          for (int64_t d = 0; d < dim_size; d++)
-            if (LogSoftMax)
-              sum += gradOutput_data[d * dim_stride];
-            else
-              sum +=
-                  gradOutput_data[d * dim_stride] * output_data[d * dim_stride];
-
-          for (int64_t d = 0; d < dim_size; d++) {
-            if (LogSoftMax) {
-              gradInput_data[d * dim_stride] = gradOutput_data[d * dim_stride] -
-                  std::exp(output_data[d * dim_stride]) * sum;
-            } else {
-              gradInput_data[d * dim_stride] = output_data[d * dim_stride] *
-                  (gradOutput_data[d * dim_stride] - sum);
-            }
-          }
-        }
-      });
-}
-} // namespace
 
 Tensor softmax_cpu(const Tensor& input_, const int64_t dim_, const bool half_to_float) {
   AT_ASSERTM(!half_to_float, "softmax with half to float conversion is not supported on CPU");
@@ -133,9 +26,7 @@ Tensor softmax_cpu(const Tensor& input_, const int64_t dim_, const bool half_to_
   if (input.ndimension() > 0 && dim == input.ndimension() - 1) {
     softmax_lastdim_kernel(kCPU, output, input);
   } else {
-    AT_DISPATCH_FLOATING_TYPES(input.scalar_type(), "softmax", [&] {
-      host_softmax<scalar_t, false>(output, input, dim);
-    });
+    softmax_kernel(kCPU, output, input, dim);
   }
   return output;
 }
@@ -157,9 +48,7 @@ Tensor log_softmax_cpu(const Tensor& input_, const int64_t dim_, const bool half
   if (input.ndimension() > 0 && dim == input.ndimension() - 1) {
     log_softmax_lastdim_kernel(kCPU, output, input);
   } else {
-    AT_DISPATCH_FLOATING_TYPES(input.scalar_type(), "log_softmax", [&] {
-      host_softmax<scalar_t, true>(output, input, dim);
-    });
+    log_softmax_kernel(kCPU, output, input, dim);
   }
   return output;
 }
@@ -189,9 +78,7 @@ Tensor softmax_backward_cpu(
   if (grad.ndimension() > 0 && dim == grad.ndimension() - 1) {
     softmax_backward_lastdim_kernel(kCPU, grad_input, grad, output);
   } else {
-    AT_DISPATCH_FLOATING_TYPES(grad.scalar_type(), "softmax_backward", [&] {
-      host_softmax_backward<scalar_t, false>(grad_input, grad, output, dim);
-    });
+    softmax_backward_kernel(kCPU, grad_input, grad, output, dim);
   }
   return grad_input;
 }
@@ -221,13 +108,40 @@ Tensor log_softmax_backward_cpu(
   if (grad.ndimension() > 0 && dim == grad.ndimension() - 1) {
     log_softmax_backward_lastdim_kernel(kCPU, grad_input, grad, output);
   } else {
-    AT_DISPATCH_FLOATING_TYPES(grad.scalar_type(), "log_softmax_backward", [&] {
-      host_softmax_backward<scalar_t, true>(grad_input, grad, output, dim);
-    });
+    log_softmax_backward_kernel(kCPU, grad_input, grad, output, dim);
   }
   return grad_input;
 }
 
+Tensor masked_softmax_cpu(const Tensor& input_, const Tensor& mask_, const int64_t dim_) {
+  AT_CHECK(
+      mask_.scalar_type() == ScalarType::Bool ||
+          mask_.scalar_type() == ScalarType::Byte || mask_.is_floating_point(),
+      "masked_softmax: expected a boolean mask or a floating point mask to add "
+      "to the input, got a mask of type ", mask_.scalar_type());
+  auto input = input_.contiguous();
+  Tensor output = at::native::empty_like(input);
+  int64_t dim = maybe_wrap_dim(dim_, input.dim());
+
+  if (input.numel() == 0) {
+    return output;
+  }
+  if (input.dim() == 0)
+    input = input.view(1);
+  AT_CHECK(
+      dim >= 0 && dim < input.dim(),
+      "dim must be non-negative and less than input dimensions");
+  // The kernel reads the mask through its broadcast strides, so expanding it
+  // does not copy anything.
+  Tensor mask = mask_;
+  if (mask.is_floating_point() && mask.scalar_type() != input.scalar_type()) {
+    mask = mask.to(input.scalar_type());
+  }
+  mask = mask.expand(input.sizes());
+  masked_softmax_kernel(kCPU, output, input, mask, dim);
+  return output;
+}
+
 Tensor softmax(const Tensor& input_, const int64_t dim_) {
   return at::_softmax(input_, dim_, false);
 }
@@ -256,6 +170,11 @@ DEFINE_DISPATCH(softmax_lastdim_kernel);
 DEFINE_DISPATCH(log_softmax_lastdim_kernel);
 DEFINE_DISPATCH(softmax_backward_lastdim_kernel);
 DEFINE_DISPATCH(log_softmax_backward_lastdim_kernel);
+DEFINE_DISPATCH(softmax_kernel);
+DEFINE_DISPATCH(log_softmax_kernel);
+DEFINE_DISPATCH(softmax_backward_kernel);
+DEFINE_DISPATCH(log_softmax_backward_kernel);
+DEFINE_DISPATCH(masked_softmax_kernel);
 
 }
 }
@@ -1,7 +1,10 @@
 #include <ATen/ATen.h>
+#include <ATen/LegacyTHFunctions.h>
+#include <ATen/NativeFunctions.h>
 #include <ATen/NumericUtils.h>
 #include <ATen/Parallel.h>
 #include <ATen/WrapDimUtils.h>
+#include <ATen/native/Sorting.h>
 #include <ATen/native/SortingUtils.h>
 
 namespace at {
@@ -31,41 +34,6 @@ namespace {
 constexpr int64_t MAX_LEVELS = 300;
 constexpr int64_t M_SMALL = 10; // Limit for small subfiles
 
-template <typename Fn>
-void dim_apply(TensorList tensors, int64_t dim, Fn f) {
-  AT_ASSERT(tensors.size() > 0);
-  auto t = tensors[0];
-  auto sizes = t.sizes();
-  int64_t ndim = t.dim();
-  int64_t itersize = 1;
-  for (int64_t i = 0; i < ndim; i++) {
-    if (i != dim) {
-      itersize *= t.size(i);
-    }
-  }
-  parallel_for(0, itersize, 1, [&](int64_t i_begin, int64_t i_end) {
-    std::vector<Tensor> narrowed_tensors;
-    narrowed_tensors.reserve(tensors.size());
-    for (int64_t it = i_begin; it < i_end; it++) {
-      narrowed_tensors.clear();
-      for (auto ti : tensors) {
-        int64_t i = it;
-        Tensor nt = ti;
-        for (size_t d = 0; d < ndim; d++) {
-          if (d != dim) {
-            // this could be avoided for slower-changing dimensions if done
-            // better
-            nt = nt.select((d > dim ? 1 : 0), i % sizes[d]);
-            i = i / sizes[d];
-          }
-        }
-        narrowed_tensors.emplace_back(nt);
-      }
-      f(it, narrowed_tensors);
-    }
-  });
-}
-
 template <typename scalar_t, typename Comp, typename Fn>
 void quick_select_template(
     TensorAccessor<scalar_t, 1> arr,
@@ -125,8 +93,94 @@ void quick_select_template(
   } while (1);
 }
 
+// sort and topk use the radix kernels in cpu/SortingKernel.cpp for CPU tensors
+// of the types below; everything else, including the error reporting for bad
+// outputs, is left to TH.
+bool can_use_radix_kernel(const Tensor& self) {
+  return self.device().type() == kCPU && self.dim() > 0 &&
+      (isIntegralType(self.scalar_type()) || self.scalar_type() == kFloat ||
+       self.scalar_type() == kDouble);
+}
+
+bool can_use_radix_kernel_out(const Tensor& values, const Tensor& indices, const Tensor& self) {
+  return can_use_radix_kernel(self) && values.type() == self.type() &&
+      indices.scalar_type() == kLong && indices.device().type() == kCPU;
+}
+
 } // namespace
 
+std::tuple<Tensor&, Tensor&> sort_out(
+    Tensor& values,
+    Tensor& indices,
+    const Tensor& self,
+    int64_t dim_,
+    bool descending) {
+  if (!can_use_radix_kernel_out(values, indices, self)) {
+    return at::legacy::th::_th_sort_out(values, indices, self, dim_, descending);
+  }
+  int64_t dim = maybe_wrap_dim(dim_, self.dim());
+  Tensor input = values.is_alias_of(self) || indices.is_alias_of(self) ? self.clone() : self;
+  values.resize_(self.sizes());
+  indices.resize_(self.sizes());
+  sort_stub(kCPU, values, indices, input, dim, descending);
+  return std::forward_as_tuple(values, indices);
+}
+
+std::tuple<Tensor, Tensor> sort(
+    const Tensor& self,
+    int64_t dim,
+    bool descending) {
+  if (!can_use_radix_kernel(self)) {
+    return at::legacy::th::_th_sort(self, dim, descending);
+  }
+  Tensor values = at::empty(self.sizes(), self.options());
+  Tensor indices = at::empty(self.sizes(), self.options().dtype(kLong));
+  sort_stub(kCPU, values, indices, self, maybe_wrap_dim(dim, self.dim()), descending);
+  return std::make_tuple(values, indices);
+}
+
+Tensor argsort(const Tensor& self, int64_t dim, bool descending) {
+  return std::get<1>(at::native::sort(self, dim, descending));
+}
+
+std::tuple<Tensor&, Tensor&> topk_out(
+    Tensor& values,
+    Tensor& indices,
+    const Tensor& self,
+    int64_t k,
+    int64_t dim_,
+    bool largest,
+    bool sorted) {
+  if (!can_use_radix_kernel_out(values, indices, self)) {
+    return at::legacy::th::_th_topk_out(values, indices, self, k, dim_, largest, sorted);
+  }
+  int64_t dim = maybe_wrap_dim(dim_, self.dim());
+  AT_CHECK(k >= 0 && k <= self.size(dim), "k not in range for dimension");
+  auto sizes = self.sizes().vec();
+  sizes[dim] = k;
+  // an output aliasing the input is resized and written slice by slice
+  Tensor input = values.is_alias_of(self) || indices.is_alias_of(self) ? self.clone() : self;
+  values.resize_(sizes);
+  indices.resize_(sizes);
+  topk_stub(kCPU, values, indices, input, k, dim, largest, sorted);
+  return std::forward_as_tuple(values, indices);
+}
+
+std::tuple<Tensor, Tensor> topk(
+    const Tensor& self,
+    int64_t k,
+    int64_t dim,
+    bool largest,
+    bool sorted) {
+  if (!can_use_radix_kernel(self)) {
+    return at::legacy::th::_th_topk(self, k, dim, largest, sorted);
+  }
+  Tensor values = at::empty({0}, self.options());
+  Tensor indices = at::empty({0}, self.options().dtype(kLong));
+  at::native::topk_out(values, indices, self, k, dim, largest, sorted);
+  return std::make_tuple(values, indices);
+}
+
 std::tuple<Tensor&, Tensor&> kthvalue_out_cpu(
     Tensor& values,
     Tensor& indices,
@@ -146,43 +200,19 @@ std::tuple<Tensor&, Tensor&> kthvalue_out_cpu(
       k > 0 && k <= (self.dim() > 0 ? self.size(dim) : 1),
       "selected index k out of range");
 
+  // the outputs are resized and kthvalue_stub writes them as it goes, so an
+  // output aliasing the input needs a copy of it
+  bool aliased = (values.defined() && values.is_alias_of(self)) ||
+      (indices.defined() && indices.is_alias_of(self));
+  Tensor input = aliased ? self.clone() : self;
   _reduction_with_indices_allocate_or_resize_output(
       values, indices, self, dim_, keepdim);
   if (self.dim() == 0 && self.numel() == 1) {
-    values.copy_(self);
+    values.copy_(input);
     indices.zero_();
     return std::forward_as_tuple(values, indices);
   }
-  auto tmp_values = self.clone();
-  auto tmp_indices = at::empty(self.sizes(), self.options().dtype(kLong));
-  AT_DISPATCH_ALL_TYPES(self.scalar_type(), "kthvalue_cpu", [&] {
-    dim_apply(
-        {tmp_values, tmp_indices, values, indices},
-        dim,
-        [&](int64_t i, TensorList tl) {
-          auto tmp_values = tl[0].accessor<scalar_t, 1>();
-          auto tmp_indices = tl[1].accessor<int64_t, 1>();
-          scalar_t* mode_value = tl[2].data<scalar_t>();
-          int64_t* mode_index = tl[3].data<int64_t>();
-          for (int64_t j = 0; j < tmp_indices.size(0); j++) {
-            tmp_indices[j] = j;
-          }
-          // we want NaN to be sorted as top for numpy compatibility
-          quick_select_template(
-              tmp_values,
-              k - 1,
-              [](scalar_t x, scalar_t y) -> bool {
-                return (
-                    (_isnan<scalar_t>(x) && !_isnan<scalar_t>(y)) || (x > y));
-              },
-              [&](int64_t i, int64_t j) {
-                std::swap(tmp_values[i], tmp_values[j]);
-                std::swap(tmp_indices[i], tmp_indices[j]);
-              });
-          *mode_value = tmp_values[k - 1];
-          *mode_index = tmp_indices[k - 1];
-        });
-  });
+  kthvalue_stub(kCPU, values, indices, input, k, dim);
   if (!keepdim) {
     values.squeeze_(dim);
     indices.squeeze_(dim);
@@ -249,5 +279,9 @@ Tensor median_cpu(const Tensor& self) {
   return result.view({});
 }
 
+DEFINE_DISPATCH(sort_stub);
+DEFINE_DISPATCH(topk_stub);
+DEFINE_DISPATCH(kthvalue_stub);
+
 } // namespace native
 } // namespace at
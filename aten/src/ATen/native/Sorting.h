@@ -0,0 +1,19 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+namespace at { namespace native {
+
+// Radix sort and radix select along dim. values and indices are allocated by
+// the caller: with the sizes of self for sort, with size k along dim for topk
+// and with size 1 along dim for kthvalue (k is 1-based).
+using sort_fn = void(*)(Tensor& values, Tensor& indices, const Tensor& self, int64_t dim, bool descending);
+using topk_fn = void(*)(Tensor& values, Tensor& indices, const Tensor& self, int64_t k, int64_t dim, bool largest, bool sorted);
+using kthvalue_fn = void(*)(Tensor& values, Tensor& indices, const Tensor& self, int64_t k, int64_t dim);
+
+DECLARE_DISPATCH(sort_fn, sort_stub);
+DECLARE_DISPATCH(topk_fn, topk_stub);
+DECLARE_DISPATCH(kthvalue_fn, kthvalue_stub);
+
+}} // namespace at::native
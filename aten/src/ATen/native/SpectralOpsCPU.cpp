@@ -0,0 +1,363 @@
+#include <ATen/ATen.h>
+#include <ATen/Config.h>
+#include <ATen/Dispatch.h>
+#include <ATen/NativeFunctions.h>
+#include <ATen/Parallel.h>
+#include <ATen/native/FFTPlan.h>
+#include <ATen/native/SpectralOpsCPU.h>
+#include <ATen/native/SpectralOpsUtils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <memory>
+#include <vector>
+
+namespace at { namespace native {
+
+namespace detail {
+
+CPUFFTPlanCache& cpu_fft_plan_cache() {
+  static CPUFFTPlanCache cache;
+  return cache;
+}
+
+} // namespace detail
+
+int64_t _cpu_fft_get_plan_cache_size() {
+  return detail::cpu_fft_plan_cache().size();
+}
+
+int64_t _cpu_fft_get_plan_cache_max_size() {
+  return detail::cpu_fft_plan_cache().max_size();
+}
+
+void _cpu_fft_set_plan_cache_max_size(int64_t max_size) {
+  detail::cpu_fft_plan_cache().resize(max_size);
+}
+
+void _cpu_fft_clear_plan_cache() {
+  detail::cpu_fft_plan_cache().clear();
+}
+
+Tensor _fft_cpu(const Tensor& self, int64_t signal_ndim,
+                bool complex_input, bool complex_output,
+                bool inverse, IntArrayRef checked_signal_sizes,
+                bool normalized, bool onesided,
+                IntArrayRef output_sizes) {
+#if AT_MKL_ENABLED()
+  return _fft_mkl(self, signal_ndim, complex_input, complex_output, inverse,
+                  checked_signal_sizes, normalized, onesided, output_sizes);
+#else
+  return _fft_portable(self, signal_ndim, complex_input, complex_output, inverse,
+                       checked_signal_sizes, normalized, onesided, output_sizes);
+#endif
+}
+
+// In real-to-complex transform, the CPU backends only fill half of the values
+// due to conjugate symmetry. See native/SpectralUtils.h for more details.
+// The following structs are used to fill in the other half with symmetry in
+// case of real-to-complex transform with onesided=False flag.
+// See NOTE [ Fourier Transform Conjugate Symmetry ] in native/SpectralOpsUtils.h.
+
+template <typename scalar_t>
+static inline void _fft_fill_with_conjugate_symmetry_slice(Tensor& output,
+                       int64_t signal_ndim, int64_t size_last_dim,
+                       int64_t start_last_dim_idx, int64_t i, int64_t num) {
+  scalar_t *data = output.data<scalar_t>();
+
+  // A slice means a slice of last dimension (of size size_last_dim)
+
+  // This function iterates through the slices to fill, i.e. to_slice_data
+  // (basically data_slices[i:i+num]), and keeps track of the slices it reads
+  // data from, i.e., from_slice_data, using from_slice_indices, a vector
+  // containing the index of the from_slice_data slice.
+
+  // Compute the indices for the first from_slice_data
+  std::vector<int64_t> from_slice_indices(signal_ndim);  // up to before last signal dim
+  int64_t remainder = i;
+  // set last signal dim values
+  int64_t from_slice_offset = 0;
+  for (int64_t d = signal_ndim - 1; d >= 0; d--) {
+    int64_t dim_size = output.size(d);
+    int64_t dim_idx = remainder % dim_size;
+    remainder = remainder / dim_size;
+    from_slice_indices[d] = dim_idx;
+    if (d == 0) {
+      from_slice_offset += dim_idx * output.stride(d);
+    } else if (dim_idx != 0) {
+      from_slice_offset += (dim_size - dim_idx) * output.stride(d);
+    }
+  }
+
+  // First to_slice_data and from_slice_data
+  scalar_t *to_slice_data = data + i * size_last_dim * 2;
+  scalar_t *from_slice_data = data + from_slice_offset;
+
+  while (num > 0) {
+    // Fill to_slice_data from values in from_slice_data
+    for (int64_t j = start_last_dim_idx; j < size_last_dim; j++) {
+      // multiply index by 2 because of the last complex dim has size 2
+      int64_t to_idx = j * 2;
+      int64_t from_idx = (size_last_dim - j) * 2;
+      to_slice_data[to_idx] = from_slice_data[from_idx];
+      to_slice_data[to_idx + 1] = -from_slice_data[from_idx + 1];
+    }
+    // Compute the next to_slice_data and from_slice_data slices
+    to_slice_data += size_last_dim * 2;
+    for (int64_t d = signal_ndim - 1; d >= 0; d--) {
+      // Compute the next index at this dimension using conjugate symmetry
+      // Break out of this loop if nothing carries over
+      from_slice_indices[d] = (from_slice_indices[d] + 1) % output.size(d);
+      if (d > 0) {
+        // At d > 0 nonbatch dim, to get next from_slice_data offset
+        //   1. if this dim idx becomes 1, will need to add (size - 1) * stride
+        //   2. otherwise, will need to subtract stride
+        if (from_slice_indices[d] == 0) {
+          // Substract. Carries over to previous dimension
+          from_slice_data -= output.stride(d);
+        } else if (from_slice_indices[d] == 1) {
+          // Dimension index becomes 1
+          // Doesn't carry over to previous dimension
+          from_slice_data += (output.size(d) - 1) * output.stride(d);
+          break;
+        } else {
+          // Substract. Doesn't carry over to previous dimension
+          from_slice_data -= output.stride(d);
+          break;
+        }
+      } else {
+        // At d = 0 nonbatch dim, it means that to_slice_data ise now at a the
+        // beginning of a data sample. It maps to itself by conjugate symmetry.
+        from_slice_data = to_slice_data;
+      }
+    }
+    num--;
+  }
+}
+
+void _fft_fill_with_conjugate_symmetry_(Tensor& input,
+                      int64_t signal_ndim, int64_t size_last_dim,
+                      int64_t last_dim_start_slice) {
+  if (last_dim_start_slice >= size_last_dim) {
+    return;
+  }
+
+  int64_t num = 1;
+  for (int64_t d = 0; d < signal_ndim; d++) {
+    num *= input.size(d);
+  }
+  AT_DISPATCH_FLOATING_TYPES(input.scalar_type(), "_fft_fill_with_conjugate_symmetry", [&] {
+    at::parallel_for(0, num, 500, [&](int64_t start, int64_t end) {
+      _fft_fill_with_conjugate_symmetry_slice<scalar_t>(input, signal_ndim, size_last_dim,
+          last_dim_start_slice, start, end - start);
+    });
+  });
+}
+
+namespace {
+
+// The 1-D plans of a transform without MKL: a complex plan for each signal
+// dimension, except for the last dimension of real-to-complex and
+// complex-to-real transforms, which is done by the real plan.
+template <typename scalar_t>
+struct PortableFFTPlan : public detail::CPUFFTPlan {
+  std::vector<std::unique_ptr<fft::ComplexPlan<scalar_t>>> complex_plans;
+  std::unique_ptr<fft::RealPlan<scalar_t>> real_plan;
+};
+
+// Calls fn(src_offset, dst_offset, buffer) on every line along dimension
+// `dim` of a tensor of sizes `sizes`, where the offsets are those of the
+// first element of the line in two tensors of strides `src_strides` and
+// `dst_strides`. Lines are split between threads, and `buffer` is scratch
+// space of `buffer_size` elements owned by the calling thread.
+template <typename scalar_t, typename Fn>
+void parallel_for_each_line(
+    IntArrayRef sizes, IntArrayRef src_strides, IntArrayRef dst_strides,
+    int64_t dim, int64_t buffer_size, const Fn& fn) {
+  int64_t num_lines = 1;
+  for (int64_t d = 0; d < static_cast<int64_t>(sizes.size()); d++) {
+    if (d != dim) {
+      num_lines *= sizes[d];
+    }
+  }
+  // tasks of roughly 32K elements
+  const int64_t grain_size = std::max<int64_t>(1, 32768 / std::max<int64_t>(1, sizes[dim]));
+  at::parallel_for(0, num_lines, grain_size, [&](int64_t begin, int64_t end) {
+    std::vector<std::complex<scalar_t>> buffer(buffer_size);
+    for (int64_t line = begin; line < end; line++) {
+      int64_t remainder = line;
+      int64_t src_offset = 0, dst_offset = 0;
+      for (int64_t d = sizes.size() - 1; d >= 0; d--) {
+        if (d == dim) {
+          continue;
+        }
+        int64_t idx = remainder % sizes[d];
+        remainder /= sizes[d];
+        src_offset += idx * src_strides[d];
+        dst_offset += idx * dst_strides[d];
+      }
+      fn(src_offset, dst_offset, buffer.data());
+    }
+  });
+}
+
+// Complex-to-complex transforms along the signal dimensions 1 to `end_dim`
+// (excluded) of the complex view `data` of sizes `sizes`, in place.
+template <typename scalar_t>
+void complex_transforms_inplace(
+    const PortableFFTPlan<scalar_t>& plan, std::complex<scalar_t>* data,
+    IntArrayRef sizes, IntArrayRef strides, int64_t end_dim) {
+  for (int64_t d = 1; d < end_dim; d++) {
+    const auto& complex_plan = *plan.complex_plans[d - 1];
+    const int64_t n = sizes[d], stride = strides[d];
+    parallel_for_each_line<scalar_t>(sizes, strides, strides, d, n,
+        [&](int64_t offset, int64_t, std::complex<scalar_t>* buffer) {
+          complex_plan.execute(data + offset, stride, buffer);
+          for (int64_t j = 0; j < n; j++) {
+            data[offset + j * stride] = buffer[j];
+          }
+        });
+  }
+}
+
+// Strides of the complex view of a tensor whose last dimension holds the
+// real and imaginary parts.
+std::vector<int64_t> complex_strides(const Tensor& t) {
+  std::vector<int64_t> strides(t.strides().begin(), t.strides().end() - 1);
+  for (auto& s : strides) {
+    s /= 2;
+  }
+  return strides;
+}
+
+template <typename scalar_t>
+Tensor _fft_portable_impl(const Tensor& self, int64_t signal_ndim,
+                                 bool complex_input, bool complex_output,
+                                 bool inverse, IntArrayRef checked_signal_sizes,
+                                 IntArrayRef output_sizes) {
+  using complex_t = std::complex<scalar_t>;
+  const bool real_last_dim = !complex_input || !complex_output;
+
+  detail::CPUFFTParams params;
+  detail::setCPUFFTParams(&params, self.scalar_type(), signal_ndim,
+                          complex_input, complex_output, inverse, checked_signal_sizes);
+  auto cached = detail::cpu_fft_plan_cache().get(params, [&]() -> detail::CPUFFTPlanCache::plan_t {
+    auto plan = std::make_shared<PortableFFTPlan<scalar_t>>();
+    for (int64_t d = 0; d < signal_ndim; d++) {
+      if (real_last_dim && d == signal_ndim - 1) {
+        plan->real_plan.reset(new fft::RealPlan<scalar_t>(checked_signal_sizes[d], inverse));
+      } else {
+        plan->complex_plans.emplace_back(new fft::ComplexPlan<scalar_t>(checked_signal_sizes[d], inverse));
+      }
+    }
+    return plan;
+  });
+  const auto& plan = static_cast<const PortableFFTPlan<scalar_t>&>(*cached);
+
+  Tensor input = self;
+  // real/imag dimension must aligned when viewed as of complex type
+  if (complex_input) {
+    bool need_contiguous = input.stride(-1) != 1;
+    for (int64_t i = 0; !need_contiguous && i <= signal_ndim; i++) {
+      need_contiguous |= input.stride(i) % 2 != 0;
+    }
+    if (need_contiguous) {
+      input = input.contiguous();
+    }
+  }
+  Tensor output = at::empty(output_sizes, input.options());
+
+  const int64_t last_dim = signal_ndim;
+  const int64_t last_size = checked_signal_sizes[signal_ndim - 1];
+
+  if (complex_input && complex_output) {
+    // The last signal dimension is transformed into the output first, then
+    // the other ones in place.
+    auto in_strides = complex_strides(input);
+    auto out_strides = complex_strides(output);
+    IntArrayRef sizes(output_sizes.data(), signal_ndim + 1);
+    auto in_data = reinterpret_cast<const complex_t*>(input.data<scalar_t>());
+    auto out_data = reinterpret_cast<complex_t*>(output.data<scalar_t>());
+    const auto& complex_plan = *plan.complex_plans[signal_ndim - 1];
+    const int64_t in_stride = in_strides[last_dim];
+    parallel_for_each_line<scalar_t>(sizes, in_strides, out_strides, last_dim, 0,
+        [&](int64_t src_offset, int64_t dst_offset, complex_t*) {
+          complex_plan.execute(in_data + src_offset, in_stride, out_data + dst_offset);
+        });
+    complex_transforms_inplace(plan, out_data, sizes, out_strides, last_dim);
+  } else if (complex_output) {
+    // Real-to-complex: the real plan computes the first half of the last
+    // signal dimension, the other dimensions are transformed on that half,
+    // and the rest follows by conjugate symmetry.
+    auto out_strides = complex_strides(output);
+    std::vector<int64_t> sizes(output_sizes.begin(), output_sizes.end() - 1);
+    sizes[last_dim] = infer_ft_real_to_complex_onesided_size(last_size);
+    auto in_data = input.data<scalar_t>();
+    auto out_data = reinterpret_cast<complex_t*>(output.data<scalar_t>());
+    const int64_t in_stride = input.stride(last_dim);
+    parallel_for_each_line<scalar_t>(sizes, input.strides(), out_strides, last_dim, 0,
+        [&](int64_t src_offset, int64_t dst_offset, complex_t*) {
+          plan.real_plan->execute(in_data + src_offset, in_stride, out_data + dst_offset);
+        });
+    complex_transforms_inplace(plan, out_data, sizes, out_strides, last_dim);
+    if (output_sizes[last_dim] != sizes[last_dim]) {
+      _fft_fill_with_conjugate_symmetry_(output, signal_ndim, last_size, sizes[last_dim]);
+    }
+  } else {
+    // Complex-to-real: the signal dimensions but the last one are transformed
+    // on a copy of the first half of the last dimension, which the real plan
+    // then transforms into the output.
+    Tensor half = input.narrow(last_dim, 0, infer_ft_real_to_complex_onesided_size(last_size));
+    if (signal_ndim > 1) {
+      Tensor copy = at::empty(half.sizes(), half.options());
+      copy.copy_(half);
+      half = copy;
+    }
+    auto half_strides = complex_strides(half);
+    std::vector<int64_t> sizes(half.sizes().begin(), half.sizes().end() - 1);
+    auto half_data = reinterpret_cast<complex_t*>(half.data<scalar_t>());
+    complex_transforms_inplace(plan, half_data, sizes, half_strides, last_dim);
+    auto out_data = output.data<scalar_t>();
+    const int64_t half_stride = half_strides[last_dim];
+    const int64_t out_stride = output.stride(last_dim);
+    parallel_for_each_line<scalar_t>(sizes, half_strides, output.strides(), last_dim, 0,
+        [&](int64_t src_offset, int64_t dst_offset, complex_t*) {
+          plan.real_plan->execute_inverse(half_data + src_offset, half_stride,
+                                          out_data + dst_offset, out_stride);
+        });
+  }
+  return output;
+}
+
+} // anonymous namespace
+
+// Mixed-radix FFTs of native/FFTPlan.h, used when ATen is built without MKL.
+// Plans are cached per signal sizes and direction, and the transforms of the
+// lines of each signal dimension are split between threads.
+Tensor _fft_portable(const Tensor& self, int64_t signal_ndim,
+                     bool complex_input, bool complex_output,
+                     bool inverse, IntArrayRef checked_signal_sizes,
+                     bool normalized, bool onesided,
+                     IntArrayRef output_sizes) {
+  AT_CHECK(signal_ndim >= 1 && signal_ndim <= detail::cpu_fft_max_rank,
+           "fft: expected signal_ndim between 1 and ", detail::cpu_fft_max_rank,
+           ", but got ", signal_ndim);
+  Tensor output;
+  AT_DISPATCH_FLOATING_TYPES(self.scalar_type(), "_fft_portable", [&] {
+    output = _fft_portable_impl<scalar_t>(self, signal_ndim, complex_input, complex_output,
+                                          inverse, checked_signal_sizes, output_sizes);
+  });
+  // rescale if needed by normalized flag or inverse transform
+  if (normalized || inverse) {
+    auto signal_numel = at::prod_intlist(checked_signal_sizes);
+    if (normalized) {
+      output.mul_(1.0 / std::sqrt(static_cast<double>(signal_numel)));
+    } else {
+      output.mul_(1.0 / static_cast<double>(signal_numel));
+    }
+  }
+  return output;
+}
+
+}} // namespace at::native
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/utils/ParamsHash.h>
+
+#include <cstring>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace at { namespace native {
+
+// The CPU backends of _fft_with_size. _fft_mkl is only defined when ATen is
+// built with MKL.
+Tensor _fft_mkl(const Tensor& input, int64_t signal_ndim,
+                bool complex_input, bool complex_output,
+                bool inverse, IntArrayRef checked_signal_sizes,
+                bool normalized, bool onesided,
+                IntArrayRef output_sizes);
+Tensor _fft_portable(const Tensor& input, int64_t signal_ndim,
+                     bool complex_input, bool complex_output,
+                     bool inverse, IntArrayRef checked_signal_sizes,
+                     bool normalized, bool onesided,
+                     IntArrayRef output_sizes);
+
+// `input` is a contiguous batched tensor of the size of full (twosided)
+// signals, of which only the first `last_dim_start_slice` values of the last
+// signal dimension are computed. Fills in the others in place using
+// conjugate symmetry. See NOTE [ Fourier Transform Conjugate Symmetry ] in
+// native/SpectralOpsUtils.h.
+void _fft_fill_with_conjugate_symmetry_(Tensor& input,
+                      int64_t signal_ndim, int64_t size_last_dim,
+                      int64_t last_dim_start_slice);
+
+namespace detail {
+
+constexpr int64_t cpu_fft_max_rank = 3;
+
+// This POD struct is the **key** to the CPU plan cache, like CuFFTParams is
+// for cuFFT plans.
+struct CPUFFTParams
+{
+  at::ScalarType scalar_type_;
+  uint8_t signal_ndim_;  // between 1 and cpu_fft_max_rank
+  bool complex_input_;
+  bool complex_output_;
+  bool inverse_;
+  int64_t signal_sizes_[cpu_fft_max_rank];
+  // The batched input and how it is scaled, for plans that depend on them
+  // (i.e. MKL descriptors). Zero for other plans.
+  int64_t input_sizes_[cpu_fft_max_rank + 2];
+  int64_t input_strides_[cpu_fft_max_rank + 2];
+  bool normalized_;
+  bool onesided_;
+};
+
+// NB: This can't be a constructor, because then CPUFFTParams would not be a
+// POD anymore.
+static inline void setCPUFFTParams(CPUFFTParams* params,
+    ScalarType scalar_type, int64_t signal_ndim, bool complex_input,
+    bool complex_output, bool inverse, IntArrayRef checked_signal_sizes) {
+  memset(params, 0, sizeof(CPUFFTParams));
+  params->scalar_type_ = scalar_type;
+  params->signal_ndim_ = (uint8_t) signal_ndim;
+  params->complex_input_ = complex_input;
+  params->complex_output_ = complex_output;
+  params->inverse_ = inverse;
+  for (size_t i = 0; i != checked_signal_sizes.size(); ++i) {
+    params->signal_sizes_[i] = checked_signal_sizes[i];
+  }
+}
+
+// The **values** of the CPU plan cache derive from this.
+struct CPUFFTPlan {
+  virtual ~CPUFFTPlan() = default;
+};
+
+// The default max cache size is arbitrary, like CUFFT_DEFAULT_CACHE_SIZE.
+// Users can always configure it via torch.backends.cpu.fft_plan_cache.
+constexpr size_t CPU_FFT_DEFAULT_CACHE_SIZE = 4096;
+
+// LRU cache of CPU FFT plans, the counterpart of CuFFTParamsLRUCache. Unlike
+// it, this cache is thread-safe, and hands out shared plans that stay valid
+// after they are evicted, so that plans can be executed without holding a
+// lock.
+class CPUFFTPlanCache {
+public:
+  using plan_t = std::shared_ptr<const CPUFFTPlan>;
+
+  CPUFFTPlanCache() : _max_size(CPU_FFT_DEFAULT_CACHE_SIZE) {}
+
+  // If params are in this cache, return the cached plan. Otherwise, create
+  // the plan with create(), and put it in this cache if its max_size is
+  // positive.
+  template <typename Create>
+  plan_t get(const CPUFFTParams& params, const Create& create) {
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+      auto map_it = _cache_map.find(params);
+      if (map_it != _cache_map.end()) {
+        _usage_list.splice(_usage_list.begin(), _usage_list, map_it->second);
+        return map_it->second->second;
+      }
+    }
+
+    // Plans can take a while to create, so do not block other lookups.
+    plan_t plan = create();
+
+    std::lock_guard<std::mutex> guard(_mutex);
+    if (_max_size == 0) {
+      return plan;
+    }
+    auto map_it = _cache_map.find(params);
+    if (map_it != _cache_map.end()) {
+      // another thread created the same plan in the meantime
+      return map_it->second->second;
+    }
+    if (_usage_list.size() >= _max_size) {
+      _cache_map.erase(_usage_list.back().first);
+      _usage_list.pop_back();
+    }
+    _usage_list.emplace_front(params, plan);
+    _cache_map.emplace(_usage_list.front().first, _usage_list.begin());
+    return plan;
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> guard(_mutex);
+    _cache_map.clear();
+    _usage_list.clear();
+  }
+
+  void resize(int64_t new_size) {
+    AT_CHECK(new_size >= 0,
+             "CPU FFT plan cache size must be non-negative, but got ", new_size);
+    std::lock_guard<std::mutex> guard(_mutex);
+    _max_size = static_cast<size_t>(new_size);
+    while (_usage_list.size() > _max_size) {
+      _cache_map.erase(_usage_list.back().first);
+      _usage_list.pop_back();
+    }
+  }
+
+  size_t size() {
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _cache_map.size();
+  }
+
+  size_t max_size() {
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _max_size;
+  }
+
+private:
+  using kv_t = std::pair<CPUFFTParams, plan_t>;
+  using map_t = std::unordered_map<std::reference_wrapper<const CPUFFTParams>,
+                                   std::list<kv_t>::iterator,
+                                   ParamsHash<CPUFFTParams>,
+                                   ParamsEqual<CPUFFTParams>>;
+
+  std::mutex _mutex;
+  std::list<kv_t> _usage_list;
+  map_t _cache_map;
+  size_t _max_size;
+};
+
+// The plan cache shared by the CPU FFTs of all threads.
+CPUFFTPlanCache& cpu_fft_plan_cache();
+
+}}} // namespace at::native::detail
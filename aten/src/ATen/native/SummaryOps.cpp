@@ -2,14 +2,68 @@
 
 #include <ATen/ATen.h>
 #include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
 
+#include <algorithm>
 #include <tuple>
+#include <vector>
 
 namespace at { namespace native {
 
-///////////////// bincount /////////////////
 namespace {
 
+// Adds weight(i) to output[bin(i)] for the n elements, skipping the ones
+// whose bin is negative. The elements are split between threads that each
+// add to their own copy of the bins, which are summed at the end. Since
+// zeroing and summing the copies takes nbins per thread, there are only as
+// many threads as there are nbins elements.
+template <typename output_t, typename bin_fn_t, typename weight_fn_t>
+void parallel_histogram(
+    output_t* output,
+    int64_t nbins,
+    int64_t n,
+    const bin_fn_t& bin_fn,
+    const weight_fn_t& weight_fn) {
+  const int64_t chunks = std::min<int64_t>(
+      {static_cast<int64_t>(at::get_num_threads()),
+       divup(n, internal::GRAIN_SIZE),
+       n / std::max<int64_t>(nbins, 1)});
+  if (chunks <= 1) {
+    for (int64_t i = 0; i < n; i++) {
+      const int64_t bin = bin_fn(i);
+      if (bin >= 0) {
+        output[bin] += weight_fn(i);
+      }
+    }
+    return;
+  }
+
+  const int64_t chunk_size = divup(n, chunks);
+  std::vector<output_t> partial(chunks * nbins, output_t(0));
+  at::parallel_for(0, chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      output_t* hist = partial.data() + c * nbins;
+      const int64_t last = std::min(n, (c + 1) * chunk_size);
+      for (int64_t i = c * chunk_size; i < last; i++) {
+        const int64_t bin = bin_fn(i);
+        if (bin >= 0) {
+          hist[bin] += weight_fn(i);
+        }
+      }
+    }
+  });
+  at::parallel_for(0, nbins, std::max<int64_t>(internal::GRAIN_SIZE / chunks, 1), [&](int64_t begin, int64_t end) {
+    for (int64_t bin = begin; bin < end; bin++) {
+      output_t sum = output[bin];
+      for (int64_t c = 0; c < chunks; c++) {
+        sum += partial[c * nbins + bin];
+      }
+      output[bin] = sum;
+    }
+  });
+}
+
+///////////////// bincount /////////////////
 template <typename input_t, typename weights_t>
 Tensor _bincount_cpu_template(
     const Tensor& self,
@@ -35,22 +89,64 @@ Tensor _bincount_cpu_template(
   nbins = std::max(nbins, minlength); // at least minlength # of bins
 
   const input_t* self_p = self.data<input_t>();
+  const auto bin_fn = [self_p](int64_t i) {
+    return static_cast<int64_t>(self_p[i]);
+  };
   if (has_weights) {
     output = native::zeros({nbins}, weights.options());
-    weights_t* output_p = output.data<weights_t>();
     const weights_t* weights_p = weights.data<weights_t>();
-    for (int64_t i = 0; i < self.size(0); i++) {
-      output_p[self_p[i]] += weights_p[i];
-    }
+    parallel_histogram(
+        output.data<weights_t>(), nbins, self.size(0), bin_fn,
+        [weights_p](int64_t i) { return weights_p[i]; });
   } else {
     output = native::zeros({nbins}, kLong);
-    int64_t* output_p = output.data<int64_t>();
-    for (int64_t i = 0; i < self.size(0); i++) {
-      output_p[self_p[i]] += 1L;
-    }
+    parallel_histogram(
+        output.data<int64_t>(), nbins, self.size(0), bin_fn,
+        [](int64_t) { return 1L; });
   }
   return output;
 }
+
+///////////////// histc /////////////////
+template <typename input_t>
+void _histc_cpu_template(
+    Tensor& hist,
+    const Tensor& self,
+    int64_t nbins,
+    input_t min,
+    input_t max) {
+  if (nbins <= 0) {
+    AT_ERROR("bins must be > 0");
+  }
+  hist.resize_({nbins});
+  hist.zero_();
+  input_t minvalue = min;
+  input_t maxvalue = max;
+  if (min == max) {
+    minvalue = self.min().item<input_t>();
+    maxvalue = self.max().item<input_t>();
+  }
+  if (minvalue == maxvalue) {
+    minvalue = minvalue - 1;
+    maxvalue = maxvalue + 1;
+  }
+
+  Tensor input = self.contiguous();
+  const input_t* input_p = input.data<input_t>();
+  parallel_histogram(
+      hist.data<input_t>(), nbins, input.numel(),
+      [=](int64_t i) -> int64_t {
+        const input_t value = input_p[i];
+        if (!(value >= minvalue && value <= maxvalue)) {
+          return -1;
+        }
+        // the last bin also holds maxvalue
+        const int64_t bin = static_cast<int64_t>(
+            (value - minvalue) / (maxvalue - minvalue) * nbins);
+        return std::min(bin, nbins - 1);
+      },
+      [](int64_t) { return input_t(1); });
+}
 } // namespace
 
 Tensor
@@ -64,4 +160,20 @@ _bincount_cpu(const Tensor& self, const Tensor& weights, int64_t minlength) {
   });
 }
 
+Tensor& _histc_out_cpu(Tensor& result, const Tensor& self, int64_t bins, Scalar min, Scalar max) {
+  AT_CHECK(
+      result.scalar_type() == self.scalar_type(),
+      "histc: expected out to have dtype ", self.scalar_type(),
+      " but got ", result.scalar_type());
+  AT_DISPATCH_FLOATING_TYPES(self.scalar_type(), "histc_cpu", [&] {
+    _histc_cpu_template<scalar_t>(result, self, bins, min.to<scalar_t>(), max.to<scalar_t>());
+  });
+  return result;
+}
+
+Tensor _histc_cpu(const Tensor& self, int64_t bins, Scalar min, Scalar max) {
+  Tensor result = at::empty({0}, self.options());
+  return native::_histc_out_cpu(result, self, bins, min, max);
+}
+
 }} // namespace at::native
@@ -11,6 +11,7 @@
 #include <ATen/NativeFunctions.h>
 #include <ATen/LegacyTHFunctions.h>
 #include <ATen/LegacyTHDispatcher.h>
+#include <c10/core/CPUAllocator.h>
 #include <c10/core/ScalarType.h>
 #include <c10/util/Deprecated.h>
 #include <ATen/native/Resize.h>
@@ -91,7 +92,7 @@ Tensor _dim_arange(const Tensor& like, int64_t dim) {
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ empty ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-Tensor empty_cpu(IntArrayRef size, const TensorOptions& options) {
+Tensor empty_cpu(IntArrayRef size, const TensorOptions& options, c10::optional<c10::MemoryFormat> optional_memory_format) {
   AT_ASSERT(options.backend() == Backend::CPU);
   AT_ASSERT(!options.is_variable());  // is_variable should have been 'unpacked'  // TODO: remove this when Variable and Tensor are merged
   check_size_nonnegative(size);
@@ -117,6 +118,9 @@ Tensor empty_cpu(IntArrayRef size, const TensorOptions& options) {
   if (size.size() != 1 || size[0] != 0) {
     tensor.unsafeGetTensorImpl()->set_sizes_contiguous(size);
   }
+  if (optional_memory_format.has_value()) {
+    tensor.unsafeGetTensorImpl()->empty_tensor_restride(*optional_memory_format);
+  }
   return tensor;
 }
 
@@ -127,7 +131,13 @@ Tensor empty_strided_cpu(IntArrayRef size, IntArrayRef stride, const TensorOptio
   return t;
 }
 
-Tensor& empty_out(Tensor& result, IntArrayRef size) {
+Tensor& empty_out(
+    Tensor& result,
+    IntArrayRef size,
+    c10::optional<c10::MemoryFormat> optional_memory_format) {
+  AT_CHECK(
+      !optional_memory_format.has_value(),
+      "'memory_format' argument is incompatible with 'out' tensor argument");
   check_size_nonnegative(size);
   if (result.is_sparse()) {
     result.sparse_resize_and_clear_(size, size.size(), 0);
@@ -573,6 +583,26 @@ Tensor triu_indices_cpu(
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ zeros ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 Tensor zeros(IntArrayRef size, const TensorOptions& options) {
+  // Large CPU tensors are allocated from pages the OS zeroes on first touch,
+  // and aren't filled.
+  if (options.backend() == Backend::CPU && !options.pinned_memory() &&
+      !options.is_variable()) {
+    check_size_nonnegative(size);
+    int64_t nelements = prod_intlist(size);
+    auto dtype = options.dtype();
+    auto data = c10::try_alloc_zeroed_cpu(nelements * dtype.itemsize());
+    if (data) {
+      auto storage_impl = c10::make_intrusive<StorageImpl>(
+        dtype,
+        nelements,
+        std::move(data),
+        at::getCPUAllocator(),
+        /*resizeable=*/true);
+      auto tensor = detail::make_tensor<TensorImpl>(storage_impl, at::CPUTensorId());
+      tensor.unsafeGetTensorImpl()->set_sizes_contiguous(size);
+      return tensor;
+    }
+  }
   auto result = at::empty(size, options);
   return result.zero_();
 }
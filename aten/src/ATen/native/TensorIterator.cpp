@@ -1,6 +1,7 @@
 #include <ATen/native/TensorIterator.h>
 
 #include <array>
+#include <list>
 #include <ATen/ExpandUtils.h>
 #include <ATen/Parallel.h>
 
@@ -349,18 +350,19 @@ static loop2d_t loop_wrapper(const loop_t& loop) {
   };
 }
 
-void TensorIterator::for_each(const loop_t& loop) {
-  for_each(loop_wrapper(loop));
+void TensorIterator::for_each(const loop_t& loop, LoopCost cost) {
+  for_each(loop_wrapper(loop), cost);
 }
 
-void TensorIterator::for_each(const loop2d_t& loop) {
+void TensorIterator::for_each(const loop2d_t& loop, LoopCost cost) {
   int64_t numel = this->numel();
+  int64_t grain_size = at::grain_size(cost);
   if (numel == 0) {
     return;
-  } else if (numel < internal::GRAIN_SIZE || at::get_num_threads() == 1) {
+  } else if (numel < grain_size || at::get_num_threads() == 1) {
     return serial_for_each(loop, {0, numel});
   } else {
-    at::parallel_for(0, numel, internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+    at::parallel_for(0, numel, grain_size, [&](int64_t begin, int64_t end) {
       serial_for_each(loop, {begin, end});
     });
   }
@@ -476,14 +478,14 @@ std::unique_ptr<TensorIterator> TensorIterator::binary_op(Tensor& out, const Ten
   builder.add_input(a);
   builder.add_input(b);
   builder.iter_->allow_cpu_scalars_ = true;
-  return builder.build();
+  return builder.build_cached();
 }
 
 std::unique_ptr<TensorIterator> TensorIterator::unary_op(Tensor& out, const Tensor& a) {
   auto builder = TensorIterator::Builder();
   builder.add_output(out);
   builder.add_input(a);
-  return builder.build();
+  return builder.build_cached();
 }
 
 std::unique_ptr<TensorIterator> TensorIterator::reduce_op(Tensor& out, const Tensor& a) {
@@ -494,7 +496,7 @@ std::unique_ptr<TensorIterator> TensorIterator::reduce_op(Tensor& out, const Ten
   builder.iter_->promote_gpu_output_dtypes_ = true;
   builder.iter_->resize_outputs_ = false;
   builder.iter_->is_reduction_ = true;
-  return builder.build();
+  return builder.build_cached();
 }
 
 void TensorIterator::mark_outputs() {
@@ -655,6 +657,130 @@ std::unique_ptr<TensorIterator> TensorIterator::Builder::build() {
   return std::move(iter_);
 }
 
+namespace {
+
+// The number of plans every thread keeps for build_cached()
+constexpr size_t kPlanCacheSize = 8;
+
+using PlanKey = SmallVector<int64_t, 32>;
+
+// A built iterator without its tensors, and the sizes and strides of the
+// outputs it allocated.
+struct IteratorPlan {
+  PlanKey key;
+  size_t hash;
+  TensorIterator iter;
+  SmallVector<std::pair<DimVector, DimVector>, 1> output_geometry;
+};
+
+// Most recently used first
+thread_local std::list<IteratorPlan> plan_cache;
+
+size_t hash_key(const PlanKey& key) {
+  size_t hash = 0;
+  for (auto value : key) {
+    hash = hash * 31 + static_cast<size_t>(value);
+  }
+  return hash;
+}
+
+} // namespace
+
+std::unique_ptr<TensorIterator> TensorIterator::Builder::build_cached() {
+  auto& operands = iter_->operands_;
+  int num_outputs = iter_->num_outputs_;
+
+  // The plan only depends on the flags of the iterator, the types, shapes and
+  // strides of the operands, and which outputs are also inputs.
+  PlanKey key;
+  key.push_back(num_outputs);
+  key.push_back(iter_->compute_common_dtype_ | iter_->resize_outputs_ << 1 |
+      iter_->is_reduction_ << 2 | iter_->allow_cpu_scalars_ << 3 |
+      iter_->promote_gpu_output_dtypes_ << 4);
+  for (int arg = 0; arg < iter_->ntensors(); arg++) {
+    auto& op = operands[arg];
+    key.push_back(static_cast<int64_t>(op.backend));
+    key.push_back(static_cast<int64_t>(op.dtype));
+    auto& tensor = op.tensor;
+    if (!tensor.defined()) {
+      key.push_back(-1);
+      continue;
+    }
+    if (tensor.layout() != kStrided) {
+      return build();
+    }
+    key.push_back(static_cast<int64_t>(tensor.type().backend()));
+    key.push_back(static_cast<int64_t>(tensor.scalar_type()));
+    key.push_back(tensor.unsafeGetTensorImpl()->is_wrapped_number());
+    key.push_back(tensor.dim());
+    key.append(tensor.sizes().begin(), tensor.sizes().end());
+    key.append(tensor.strides().begin(), tensor.strides().end());
+    if (arg < num_outputs) {
+      for (int input = num_outputs; input < iter_->ntensors(); input++) {
+        key.push_back(tensor.is_same(operands[input].tensor));
+      }
+    }
+  }
+  auto hash = hash_key(key);
+
+  for (auto it = plan_cache.begin(); it != plan_cache.end(); ++it) {
+    if (it->hash != hash || !(it->key == key)) {
+      continue;
+    }
+    plan_cache.splice(plan_cache.begin(), plan_cache, it);
+    auto tensors = SmallVector<Tensor, 4>();
+    for (auto& op : operands) {
+      tensors.push_back(std::move(op.tensor));
+    }
+    *iter_ = it->iter;
+    for (int arg = 0; arg < iter_->ntensors(); arg++) {
+      auto& op = iter_->operands_[arg];
+      op.tensor = std::move(tensors[arg]);
+      if (!op.tensor.defined()) {
+        auto& geometry = it->output_geometry[arg];
+        op.tensor = at::empty_strided(geometry.first, geometry.second, op.options());
+      } else if (!op.is_output && !op.is_type_equal(op.tensor.type().backend(), op.tensor.scalar_type())) {
+        // the 0-dim inputs converted by compute_types()
+        op.tensor = op.tensor.to(op.options());
+      }
+      op.data = op.tensor.data_ptr();
+    }
+    return std::move(iter_);
+  }
+
+  // The sizes of the outputs provided, which compute_shape() may resize in
+  // place
+  auto output_sizes = SmallVector<c10::optional<DimVector>, 1>();
+  for (int arg = 0; arg < num_outputs; arg++) {
+    auto& tensor = operands[arg].tensor;
+    output_sizes.push_back(tensor.defined()
+        ? c10::optional<DimVector>(DimVector(tensor.sizes()))
+        : c10::nullopt);
+  }
+  auto iter = build();
+
+  IteratorPlan plan;
+  for (int arg = 0; arg < num_outputs; arg++) {
+    auto& tensor = iter->operands_[arg].tensor;
+    if (output_sizes[arg] && !tensor.sizes().equals(*output_sizes[arg])) {
+      return iter;
+    }
+    plan.output_geometry.emplace_back(DimVector(tensor.sizes()), DimVector(tensor.strides()));
+  }
+  plan.key = std::move(key);
+  plan.hash = hash;
+  plan.iter = *iter;
+  for (auto& op : plan.iter.operands_) {
+    op.tensor.reset();
+    op.data = nullptr;
+  }
+  if (plan_cache.size() == kPlanCacheSize) {
+    plan_cache.pop_back();
+  }
+  plan_cache.push_front(std::move(plan));
+  return iter;
+}
+
 /// SplitUntil32Bit. Recursively splits an iterator into sub-iterators that
 /// can use 32-bit indexing.
 
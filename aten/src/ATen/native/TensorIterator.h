@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ATen/ATen.h>
+#include <ATen/Parallel.h>
 #include <c10/util/SmallVector.h>
 #include <ATen/core/Range.h>
 #include <ATen/detail/ScalarTypeConversions.h>
@@ -205,11 +206,23 @@ struct CAFFE2_API TensorIterator {
     return at::detail::load<T>(op.data, op.tensor.scalar_type());
   }
 
-  void for_each(const loop_t& loop);
-  void for_each(const loop2d_t& loop);
+  /// Runs the loop over the whole iteration space, in parallel chunks of
+  /// at::grain_size(cost) elements. Iterations smaller than a chunk run on
+  /// the calling thread.
+  void for_each(const loop_t& loop, LoopCost cost = LoopCost::Default);
+  void for_each(const loop2d_t& loop, LoopCost cost = LoopCost::Default);
 
   void parallel_reduce(const loop2d_t& loop);
 
+  /// Whether a parallel reduction should split a reduced dimension between
+  /// threads, each reducing into its own copy of the output, instead of
+  /// splitting the output elements. True for full reductions, and for
+  /// reductions into a few contiguous outputs that could not keep every
+  /// thread busy, e.g. summing the rows of a [B, C] tensor with a small C.
+  bool use_two_pass_reduction() const;
+  /// The reduced dimension the two pass reduction splits between threads
+  int reduced_dim_to_split() const;
+
   void serial_for_each(const loop_t& loop, Range range) const;
   void serial_for_each(const loop2d_t& loop, Range range) const;
 
@@ -295,6 +308,12 @@ struct TensorIterator::Builder {
 
   std::unique_ptr<TensorIterator> build();
 
+  /// Like build(), but reuses the shape, strides and types computed by a
+  /// recent build on this thread with the same flags and operands of the same
+  /// types, shapes and strides, instead of computing them again. Outputs
+  /// that would be resized are not cached.
+  std::unique_ptr<TensorIterator> build_cached();
+
 protected:
   std::unique_ptr<TensorIterator> iter_;
 };
@@ -9,9 +9,9 @@ namespace at {
 
 using loop2d_t = TensorIterator::loop2d_t;
 
-static bool use_two_pass_reduction(TensorIterator& iter);
 static void two_pass_reduction(TensorIterator& iter, const loop2d_t& loop);
 static void parallel_dim_reduction(TensorIterator& iter, const loop2d_t& loop);
+static int find_split_dim(const TensorIterator& iter);
 
 void TensorIterator::parallel_reduce(const loop2d_t& loop) {
   AT_CHECK(ntensors() == 2, "parallel_reduce only supports one input and one output");
@@ -19,15 +19,50 @@ void TensorIterator::parallel_reduce(const loop2d_t& loop) {
   if (numel < at::internal::GRAIN_SIZE || at::get_num_threads() == 1 ||
       at::in_parallel_region()) {
     serial_for_each(loop, {0, numel});
-  } else if (use_two_pass_reduction(*this)) {
+  } else if (use_two_pass_reduction()) {
     two_pass_reduction(*this, loop);
   } else {
     parallel_dim_reduction(*this, loop);
   }
 }
 
-static bool use_two_pass_reduction(TensorIterator& iter) {
-  return iter.tensor(0).numel() == 1;
+bool TensorIterator::use_two_pass_reduction() const {
+  const auto& dst = tensor(0);
+  if (dst.numel() == 1) {
+    return true;
+  }
+  // The per-thread copies of the output are indexed like the output itself,
+  // so it has to be contiguous, and they should stay small next to the input.
+  int num_threads = at::get_num_threads();
+  if (!dst.is_contiguous() || dst.numel() * num_threads * 16 > numel()) {
+    return false;
+  }
+  // Number of pieces parallel_dim_reduction could split the outputs into
+  int dim = find_split_dim(*this);
+  int64_t cols = shape_[dim];
+  int element_size = this->element_size(/*arg=*/1);
+  if (strides(1)[dim] == element_size) {
+    cols = divup(cols, 128 / element_size);
+  }
+  return cols < num_threads;
+}
+
+int TensorIterator::reduced_dim_to_split() const {
+  // like find_split_dim, but over the reduced dimensions
+  int num_threads = at::get_num_threads();
+  int best_dim = -1;
+  for (int dim = ndim() - 1; dim >= 0; dim--) {
+    if (!is_dim_reduced(dim)) {
+      continue;
+    }
+    if (shape_[dim] >= num_threads) {
+      return dim;
+    } else if (best_dim < 0 || shape_[dim] > shape_[best_dim]) {
+      best_dim = dim;
+    }
+  }
+  AT_ASSERT(best_dim >= 0);
+  return best_dim;
 }
 
 static void two_pass_reduction(TensorIterator& iter, const loop2d_t& loop) {
@@ -41,14 +76,25 @@ static void two_pass_reduction(TensorIterator& iter, const loop2d_t& loop) {
   std::unique_ptr<bool[]> written(new bool[max_threads]);
   std::fill(written.get(), written.get() + max_threads, false);
 
-  at::parallel_for(0, iter.numel(), internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+  // Every thread reduces a slice of the reduced dimension over all the
+  // outputs, so the inner loops stay the same as for a serial reduction.
+  int dim = iter.reduced_dim_to_split();
+  int64_t size = iter.shape()[dim];
+  int64_t grain_size = std::max<int64_t>(internal::GRAIN_SIZE / (iter.numel() / size), 1);
+  auto dst_offset = (char*)iter.data_ptr(0) - (char*)dst.data_ptr();
+  at::parallel_for(0, size, grain_size, [&](int64_t begin, int64_t end) {
     int thread_num = at::get_thread_num();
-    written[thread_num] = true;
     auto slice = buffer[thread_num];
-    slice.copy_(dst);
+    if (!written[thread_num]) {
+      slice.copy_(dst);
+      written[thread_num] = true;
+    }
 
-    auto sub_iter = TensorIterator::reduce_op(slice, iter.tensor(1));
-    sub_iter->serial_for_each(loop, {begin, end});
+    auto sub_iter = TensorIterator(iter);
+    sub_iter.narrow(dim, begin, end - begin);
+    auto strides = DimVector(sub_iter.strides(0));
+    sub_iter.replace_operand(0, (char*)slice.data_ptr() + dst_offset, strides);
+    sub_iter.serial_for_each(loop, {0, sub_iter.numel()});
   });
 
   // fill any unwritten slices of the buffer with the identity
@@ -65,7 +111,7 @@ static void two_pass_reduction(TensorIterator& iter, const loop2d_t& loop) {
 
 /// Chooses a dimension over which to parallelize. Prefers the outer-most
 /// dimension thats larger than the number of available threads.
-static int find_split_dim(TensorIterator& iter) {
+static int find_split_dim(const TensorIterator& iter) {
   int num_threads = at::get_num_threads();
   auto shape = iter.shape();
 
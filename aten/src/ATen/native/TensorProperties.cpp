@@ -52,11 +52,17 @@ Tensor & detach_(Tensor & self) {
   return self;
 }
 
-Tensor contiguous(const Tensor & self) {
-  if (self.is_contiguous()) {
+Tensor contiguous(const Tensor & self, MemoryFormat memory_format) {
+  if (self.is_contiguous(memory_format)) {
     return self;
   }
-  return self.clone();
+  AT_CHECK(
+      memory_format != MemoryFormat::Any,
+      "preserve memory format is unsupported by the contiguous operator");
+  if (memory_format == MemoryFormat::Contiguous) {
+    return self.clone();
+  }
+  return at::empty(self.sizes(), self.options(), memory_format).copy_(self);
 }
 
 }
@@ -10,6 +10,7 @@
 #include <c10/util/Exception.h>
 #include <c10/util/Optional.h>
 #include <ATen/native/Resize.h>
+#include <ATen/native/cpu/CatKernel.h>
 #include <ATen/SparseTensorUtils.h>
 #include <ATen/quantized/QTensorImpl.h>
 #include <algorithm>
@@ -45,12 +46,6 @@ static void check_cat_no_zero_dim(TensorList tensors) {
   }
 }
 
-Tensor & cat_out(Tensor & result, TensorList tensors, int64_t dim) {
-  check_cat_no_zero_dim(tensors);
-  dim = legacy_cat_wrap_dim(dim, tensors);
-  return at::legacy::th::_th_cat_out(result, tensors, dim);
-}
-
 static bool sizes_match_except(IntArrayRef s1, IntArrayRef s2, int64_t dim_except /* should already be wrapped */) {
   if (s1.size() != s2.size()) {
     return false;
@@ -63,6 +58,52 @@ static bool sizes_match_except(IntArrayRef s1, IntArrayRef s2, int64_t dim_excep
   return true;
 }
 
+DEFINE_DISPATCH(cat_contiguous_stub);
+
+// Returns the size of the result if the tensors can be concatenated by
+// cat_contiguous_stub: dense, contiguous CPU tensors of one dtype whose sizes
+// match except in `dim`. Everything else, including the error reporting, is
+// left to the legacy implementation.
+static c10::optional<std::vector<int64_t>> native_cat_size(TensorList tensors, int64_t dim) {
+  // like TH, skip the legacy empty tensors of size [0]
+  auto should_skip = [](const Tensor& t) { return t.numel() == 0 && t.dim() == 1; };
+  auto first = std::find_if_not(tensors.begin(), tensors.end(), should_skip);
+  if (first == tensors.end() || dim >= first->dim()) {
+    return c10::nullopt;
+  }
+  std::vector<int64_t> size = first->sizes().vec();
+  size[dim] = 0;
+  for (const Tensor& t : tensors) {
+    if (t.type().backend() != Backend::CPU || t.scalar_type() != first->scalar_type()) {
+      return c10::nullopt;
+    }
+    if (should_skip(t)) {
+      continue;
+    }
+    if (!t.is_contiguous() || !sizes_match_except(t.sizes(), first->sizes(), dim)) {
+      return c10::nullopt;
+    }
+    size[dim] += t.size(dim);
+  }
+  return size;
+}
+
+Tensor & cat_out(Tensor & result, TensorList tensors, int64_t dim) {
+  check_cat_no_zero_dim(tensors);
+  dim = legacy_cat_wrap_dim(dim, tensors);
+  auto size = native_cat_size(tensors, dim);
+  if (size && result.type().backend() == Backend::CPU &&
+      result.scalar_type() == tensors[0].scalar_type()) {
+    // resizing keeps the buffer of a result that already has the right size
+    result.resize_(*size);
+    if (result.is_contiguous()) {
+      cat_contiguous_stub(kCPU, result, tensors, dim);
+      return result;
+    }
+  }
+  return at::legacy::th::_th_cat_out(result, tensors, dim);
+}
+
 // Check to see if the shape of tensors is compatible
 // for being concatenated along a given dimension.
 static void check_cat_sparse_dims(Tensor const &t,
@@ -178,6 +219,11 @@ Tensor cat(TensorList tensors, int64_t dim) {
   }
   check_cat_no_zero_dim(tensors);
   dim = legacy_cat_wrap_dim(dim, tensors);
+  if (auto size = native_cat_size(tensors, dim)) {
+    Tensor result = at::empty(*size, tensors[0].options());
+    cat_contiguous_stub(kCPU, result, tensors, dim);
+    return result;
+  }
   return at::legacy::th::_th_cat(tensors, dim);
 }
 
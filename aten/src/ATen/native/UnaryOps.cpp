@@ -86,10 +86,19 @@ Tensor& _clamp_min_out_cpu(Tensor& result, const Tensor& self, Scalar min) {
 }
 
 Tensor& fill_(Tensor& self, Scalar value) {
+  if (self.scalar_type() == ScalarType::BFloat16) {
+    // TH has no BFloat16; broadcast a float and let the copy kernel round it.
+    return self.copy_(at::empty({}, self.options().dtype(kFloat)).fill_(value));
+  }
   return at::legacy::th::_th_fill_(self, value);
 }
 
 Tensor& fill_(Tensor& self, const Tensor& value) {
+  if (self.scalar_type() == ScalarType::BFloat16) {
+    AT_CHECK(value.dim() == 0, "fill_ only supports 0-dimension value tensor but got tensor with ",
+             value.dim(), " dimensions.");
+    return self.copy_(value);
+  }
   return at::legacy::th::_th_fill_(self, value);
 }
 
@@ -2,17 +2,45 @@
 
 #include <ATen/ATen.h>
 #include <ATen/Dispatch.h>
+#include <ATen/NumericUtils.h>
+#include <ATen/Parallel.h>
+#include <c10/util/flat_hash_map.h>
 
-#include <set>
+#include <algorithm>
+#include <numeric>
 #include <tuple>
-#include <unordered_map>
-#include <unordered_set>
 
 namespace at {
 namespace native{
 
 namespace {
 
+// NaNs are a single value for unique, and -0 and 0 hash alike.
+template <typename scalar_t>
+struct UniqueHash {
+  size_t operator()(scalar_t v) const {
+    return (v == 0 || _isnan(v)) ? 0 : std::hash<scalar_t>()(v);
+  }
+};
+
+template <typename scalar_t>
+struct UniqueEqual {
+  bool operator()(scalar_t a, scalar_t b) const {
+    return a == b || (_isnan(a) && _isnan(b));
+  }
+};
+
+template <typename scalar_t>
+using UniqueMap = ska::flat_hash_map<scalar_t, int64_t, UniqueHash<scalar_t>, UniqueEqual<scalar_t>>;
+
+// Number of chunks the input is split into for the parallel passes
+inline int64_t unique_num_chunks(int64_t numel) {
+  if (numel < internal::GRAIN_SIZE) {
+    return 1;
+  }
+  return std::min<int64_t>(get_num_threads(), divup(numel, internal::GRAIN_SIZE));
+}
+
 template <typename scalar_t>
 std::tuple<Tensor, Tensor, Tensor> unique_cpu_template(
     const Tensor& self,
@@ -22,49 +50,61 @@ std::tuple<Tensor, Tensor, Tensor> unique_cpu_template(
   const Tensor& input = self.contiguous();
   const scalar_t* input_data = input.data<scalar_t>();
   int64_t numel = input.numel();
-  Tensor output;
   Tensor inverse_indices = at::empty({0}, self.options().dtype(kLong));
   Tensor counts = at::empty({0}, self.options().dtype(kLong));
 
-  std::unordered_set<scalar_t> set(input_data, input_data + numel);
-  output = at::empty({static_cast<int64_t>(set.size())}, input.options());
-  scalar_t *output_data = output.data<scalar_t>();
+  // Every chunk counts its values in its own map, the maps are then merged
+  // into the first one.
+  int64_t num_chunks = unique_num_chunks(numel);
+  int64_t chunk_size = divup(numel, num_chunks);
+  std::vector<UniqueMap<scalar_t>> partial_counts(num_chunks);
+  parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      auto& map = partial_counts[c];
+      int64_t last = std::min(numel, (c + 1) * chunk_size);
+      for (int64_t i = c * chunk_size; i < last; i++) {
+        map[input_data[i]]++;
+      }
+    }
+  });
+  auto& map = partial_counts[0];
+  for (int64_t c = 1; c < num_chunks; c++) {
+    for (const auto& it : partial_counts[c]) {
+      map[it.first] += it.second;
+    }
+    UniqueMap<scalar_t>().swap(partial_counts[c]);
+  }
 
+  Tensor output = at::empty({static_cast<int64_t>(map.size())}, input.options());
+  scalar_t* output_data = output.data<scalar_t>();
+  int64_t num_unique = output.numel();
+  std::transform(map.begin(), map.end(), output_data,
+      [](const std::pair<scalar_t, int64_t>& it) { return it.first; });
   if (sorted) {
-    std::vector<scalar_t> vec(set.begin(), set.end());
-    std::sort(vec.begin(), vec.end());
-    std::copy(vec.begin(), vec.end(), output_data);
-  } else {
-    std::copy(set.begin(), set.end(), output_data);
+    std::sort(output_data, output_data + num_unique, [](scalar_t a, scalar_t b) {
+      return _isnan(b) ? !_isnan(a) : a < b;
+    });
   }
 
-  if (return_inverse || return_counts) {
-    inverse_indices.resize_(input.sizes());
-    int64_t* inverse_indices_data = inverse_indices.data<int64_t>();
-    std::unordered_map<scalar_t, int64_t> inverse_map;
-    inverse_map.reserve(output.numel());
-    for (int64_t i = 0; i < output.numel(); ++i) {
-      inverse_map[output_data[i]] = i;
+  if (return_counts) {
+    counts.resize_({num_unique});
+    int64_t* counts_data = counts.data<int64_t>();
+    for (int64_t i = 0; i < num_unique; i++) {
+      counts_data[i] = map[output_data[i]];
     }
-    for(int64_t i = 0; i < numel; ++i) {
-      inverse_indices_data[i] = inverse_map[input_data[i]];
+  }
+  if (return_inverse) {
+    // the map now holds the position of every value in output
+    for (int64_t i = 0; i < num_unique; i++) {
+      map[output_data[i]] = i;
     }
-    if (return_counts) {
-      std::unordered_map<scalar_t, int64_t> counts_map;
-      counts_map.reserve(output.numel());
-      for (int64_t i = 0; i < output.numel(); ++i) {
-        counts_map[output_data[i]] = 0;
-      }
-      for(int64_t i = 0; i < numel; i++) {
-        counts_map[input_data[i]] += 1;
-      }
-      counts.resize_(output.sizes());
-      counts.fill_(0);
-      int64_t *counts_data = counts.data<int64_t>();
-      for(int64_t i = 0; i < output.numel(); i++) {
-        counts_data[i] = counts_map[output_data[i]];
+    inverse_indices.resize_(input.sizes());
+    int64_t* inverse_indices_data = inverse_indices.data<int64_t>();
+    parallel_for(0, numel, internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        inverse_indices_data[i] = map.find(input_data[i])->second;
       }
-    }
+    });
   }
   return std::make_tuple(output, inverse_indices, counts);
 }
@@ -77,46 +117,73 @@ std::tuple<Tensor, Tensor, Tensor> unique_consecutive_cpu_template(
   const Tensor& input = self.contiguous();
   const scalar_t* input_data = input.data<scalar_t>();
   int64_t numel = input.numel();
-  Tensor output = at::empty({numel}, input.options());
   Tensor inverse_indices = at::empty({0}, self.options().dtype(kLong));
   Tensor counts = at::empty({0}, self.options().dtype(kLong));
-
-  scalar_t *output_data = output.data<scalar_t>();
-  int64_t *inverse_data = nullptr;
-  int64_t *counts_data = nullptr;
-  if (numel > 0) {
-    *output_data = *input_data;
+  if (numel == 0) {
+    if (return_inverse) {
+      inverse_indices.resize_(input.sizes());
+    }
+    return std::make_tuple(at::empty({0}, input.options()), inverse_indices, counts);
   }
+
+  // A new group starts at every element that differs from the previous one.
+  // The first pass counts the starts in every chunk, the second one writes the
+  // groups of every chunk from the offset given by the chunks before it.
+  int64_t num_chunks = unique_num_chunks(numel);
+  int64_t chunk_size = divup(numel, num_chunks);
+  std::vector<int64_t> chunk_groups(num_chunks + 1, 0);
+  parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      int64_t last = std::min(numel, (c + 1) * chunk_size);
+      int64_t groups = 0;
+      for (int64_t i = std::max<int64_t>(c * chunk_size, 1); i < last; i++) {
+        groups += input_data[i] != input_data[i - 1];
+      }
+      chunk_groups[c + 1] = groups;
+    }
+  });
+  std::partial_sum(chunk_groups.begin(), chunk_groups.end(), chunk_groups.begin());
+  int64_t num_groups = chunk_groups[num_chunks] + 1;
+
+  Tensor output = at::empty({num_groups}, input.options());
+  scalar_t* output_data = output.data<scalar_t>();
+  int64_t* inverse_data = nullptr;
+  int64_t* counts_data = nullptr;
   if (return_inverse) {
     inverse_indices.resize_(input.sizes());
     inverse_data = inverse_indices.data<int64_t>();
   }
   if (return_counts) {
-    counts.resize_(input.sizes());
+    counts.resize_({num_groups});
     counts_data = counts.data<int64_t>();
   }
-  scalar_t *p = output_data;
-  int64_t *q = counts_data;
-  int64_t last = 0;
-  for (int64_t i = 0; i < numel; i++) {
-    if (input_data[i] != *p) {
-      *(++p) = input_data[i];
-      if (return_counts) {
-        *(q++) = i - last;
-        last = i;
+  parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      int64_t first = c * chunk_size;
+      int64_t last = std::min(numel, (c + 1) * chunk_size);
+      // group of the element before the chunk; the first element starts one
+      int64_t group = c == 0 ? -1 : chunk_groups[c];
+      for (int64_t i = first; i < last; i++) {
+        if (i == 0 || input_data[i] != input_data[i - 1]) {
+          group++;
+          output_data[group] = input_data[i];
+          if (return_counts) {
+            // start of the group, turned into the count below
+            counts_data[group] = i;
+          }
+        }
+        if (return_inverse) {
+          inverse_data[i] = group;
+        }
       }
     }
-    if (return_inverse) {
-      inverse_data[i] = p - output_data;
+  });
+  if (return_counts) {
+    for (int64_t g = 0; g < num_groups; g++) {
+      int64_t next = g + 1 < num_groups ? counts_data[g + 1] : numel;
+      counts_data[g] = next - counts_data[g];
     }
   }
-  int64_t output_size = p - output_data + 1;
-  if (return_counts && numel > 0) {
-    *q = numel - last;
-    counts.resize_({output_size});
-  }
-  output.resize_({output_size});
-
   return std::make_tuple(output, inverse_indices, counts);
 }
 
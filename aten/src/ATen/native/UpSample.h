@@ -1,6 +1,10 @@
 #include <math.h>
 
+#include <algorithm>
+#include <vector>
+
 #include <ATen/ATen.h>
+#include <ATen/Parallel.h>
 
 namespace at {
 namespace native {
@@ -193,6 +197,80 @@ static inline int64_t nearest_neighbor_compute_source_index(
   return src_index;
 }
 
+// The channels last kernels compute the source indices and weights of each
+// output column once, and apply them to all rows and all channels of a pixel,
+// which are contiguous.
+
+// The two source pixels of a linearly interpolated output index, as in the
+// NCHW kernels: index1 is index0 + 1, except at the last input pixel.
+template <typename scalar_t>
+struct LinearInterpolationTaps {
+  int64_t index0;
+  int64_t index1;
+  scalar_t lambda0;
+  scalar_t lambda1;
+};
+
+template <typename scalar_t>
+static inline std::vector<LinearInterpolationTaps<scalar_t>> compute_linear_interpolation_taps(
+    int64_t input_size,
+    int64_t output_size,
+    bool align_corners) {
+  const scalar_t scale = area_pixel_compute_scale<scalar_t>(
+      input_size, output_size, align_corners);
+  std::vector<LinearInterpolationTaps<scalar_t>> taps(output_size);
+  for (int64_t i = 0; i < output_size; ++i) {
+    const scalar_t real_index = area_pixel_compute_source_index<scalar_t>(
+        scale, i, align_corners, /*cubic=*/false);
+    auto& tap = taps[i];
+    tap.index0 = real_index;
+    tap.index1 = tap.index0 + ((tap.index0 < input_size - 1) ? 1 : 0);
+    tap.lambda1 = real_index - tap.index0;
+    tap.lambda0 = static_cast<scalar_t>(1.) - tap.lambda1;
+  }
+  return taps;
+}
+
+static inline std::vector<int64_t> compute_nearest_neighbor_indices(
+    int64_t input_size,
+    int64_t output_size) {
+  const float scale = (float)input_size / (float)output_size;
+  std::vector<int64_t> indices(output_size);
+  for (int64_t i = 0; i < output_size; ++i) {
+    indices[i] = nearest_neighbor_compute_source_index(scale, i, input_size);
+  }
+  return indices;
+}
+
+// The result of a 2d upsampling, channels last for channels last inputs so
+// that the kernels can write it directly. Invalid sizes get an empty tensor,
+// and are reported by the shape checks of the kernels.
+static inline Tensor upsample_2d_empty_output(
+    const Tensor& input,
+    IntArrayRef output_size) {
+  if (input.dim() == 4 && output_size.size() == 2 &&
+      output_size[0] > 0 && output_size[1] > 0 &&
+      input.suggest_memory_format() == MemoryFormat::ChannelsLast) {
+    return at::empty(
+        {input.size(0), input.size(1), output_size[0], output_size[1]},
+        input.options(),
+        MemoryFormat::ChannelsLast);
+  }
+  return at::empty({0}, input.options());
+}
+
+// Same for the gradient of the input of a 2d upsampling
+static inline Tensor upsample_2d_empty_grad_input(
+    const Tensor& grad_output,
+    IntArrayRef input_size) {
+  if (input_size.size() == 4 &&
+      std::all_of(input_size.begin(), input_size.end(), [](int64_t size) { return size > 0; }) &&
+      grad_output.suggest_memory_format() == MemoryFormat::ChannelsLast) {
+    return at::empty(input_size, grad_output.options(), MemoryFormat::ChannelsLast);
+  }
+  return at::empty({0}, grad_output.options());
+}
+
 template <typename scalar_t>
 static scalar_t upsample_get_value_bounded(
     scalar_t* data,
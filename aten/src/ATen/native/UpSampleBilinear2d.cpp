@@ -118,40 +118,143 @@ static void upsample_bilinear2d_backward_out_frame(
   const scalar_t rwidth = area_pixel_compute_scale<scalar_t>(
       input_width, output_width, align_corners);
 
-  for (int64_t h2 = 0; h2 < output_height; ++h2) {
-    const scalar_t h1r = area_pixel_compute_source_index<scalar_t>(
-        rheight, h2, align_corners, /*cubic=*/false);
+  // output pixels scatter to overlapping input rows, so this is parallel over
+  // the planes, which are independent
+  const int64_t plane_size = output_height * output_width;
+  at::parallel_for(0, channels, at::divup(at::internal::GRAIN_SIZE, plane_size), [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; ++c) {
+      scalar_t* iplane = idata + c * input_height * input_width;
+      const scalar_t* oplane = odata + c * plane_size;
 
-    const int64_t h1 = h1r;
-    const int64_t h1p = (h1 < input_height - 1) ? 1 : 0;
+      for (int64_t h2 = 0; h2 < output_height; ++h2) {
+        const scalar_t h1r = area_pixel_compute_source_index<scalar_t>(
+            rheight, h2, align_corners, /*cubic=*/false);
 
-    const scalar_t h1lambda = h1r - h1;
-    const scalar_t h0lambda = static_cast<scalar_t>(1.) - h1lambda;
+        const int64_t h1 = h1r;
+        const int64_t h1p = (h1 < input_height - 1) ? 1 : 0;
 
-    for (int64_t w2 = 0; w2 < output_width; ++w2) {
-      const scalar_t w1r = area_pixel_compute_source_index<scalar_t>(
-          rwidth, w2, align_corners, /*cubic=*/false);
+        const scalar_t h1lambda = h1r - h1;
+        const scalar_t h0lambda = static_cast<scalar_t>(1.) - h1lambda;
 
-      const int64_t w1 = w1r;
-      const int64_t w1p = (w1 < input_width - 1) ? 1 : 0;
+        for (int64_t w2 = 0; w2 < output_width; ++w2) {
+          const scalar_t w1r = area_pixel_compute_source_index<scalar_t>(
+              rwidth, w2, align_corners, /*cubic=*/false);
 
-      const scalar_t w1lambda = w1r - w1;
-      const scalar_t w0lambda = static_cast<scalar_t>(1.) - w1lambda;
+          const int64_t w1 = w1r;
+          const int64_t w1p = (w1 < input_width - 1) ? 1 : 0;
 
-      scalar_t* pos1 = &idata[h1 * input_width + w1];
+          const scalar_t w1lambda = w1r - w1;
+          const scalar_t w0lambda = static_cast<scalar_t>(1.) - w1lambda;
 
-      const scalar_t* pos2 = &odata[h2 * output_width + w2];
+          scalar_t* pos1 = &iplane[h1 * input_width + w1];
+          const scalar_t val = oplane[h2 * output_width + w2];
 
-      for (int64_t c = 0; c < channels; ++c) {
-        pos1[0] += h0lambda * w0lambda * pos2[0];
-        pos1[w1p] += h0lambda * w1lambda * pos2[0];
-        pos1[h1p * input_width] += h1lambda * w0lambda * pos2[0];
-        pos1[h1p * input_width + w1p] += h1lambda * w1lambda * pos2[0];
-        pos1 += input_width * input_height;
-        pos2 += output_width * output_height;
+          pos1[0] += h0lambda * w0lambda * val;
+          pos1[w1p] += h0lambda * w1lambda * val;
+          pos1[h1p * input_width] += h1lambda * w0lambda * val;
+          pos1[h1p * input_width + w1p] += h1lambda * w1lambda * val;
+        }
       }
     }
-  }
+  });
+}
+
+// Channels last: the output pixels of a row are independent, and read all
+// their channels from the same four input pixels with the same weights.
+template <typename scalar_t>
+static void upsample_bilinear2d_out_frame_channels_last(
+    scalar_t* odata,
+    const scalar_t* idata,
+    int64_t input_height,
+    int64_t input_width,
+    int64_t output_height,
+    int64_t output_width,
+    int64_t nbatch,
+    int64_t channels,
+    bool align_corners) {
+  const auto h_taps = compute_linear_interpolation_taps<scalar_t>(
+      input_height, output_height, align_corners);
+  const auto w_taps = compute_linear_interpolation_taps<scalar_t>(
+      input_width, output_width, align_corners);
+
+  const int64_t row_size = output_width * channels;
+  at::parallel_for(0, nbatch * output_height, at::divup(at::internal::GRAIN_SIZE, row_size), [&](int64_t begin, int64_t end) {
+    for (int64_t row = begin; row < end; ++row) {
+      const int64_t n = row / output_height;
+      const auto& h_tap = h_taps[row % output_height];
+      const scalar_t* irow0 = idata + (n * input_height + h_tap.index0) * input_width * channels;
+      const scalar_t* irow1 = idata + (n * input_height + h_tap.index1) * input_width * channels;
+      scalar_t* orow = odata + row * row_size;
+
+      for (int64_t w2 = 0; w2 < output_width; ++w2) {
+        const auto& w_tap = w_taps[w2];
+        const scalar_t* p00 = irow0 + w_tap.index0 * channels;
+        const scalar_t* p01 = irow0 + w_tap.index1 * channels;
+        const scalar_t* p10 = irow1 + w_tap.index0 * channels;
+        const scalar_t* p11 = irow1 + w_tap.index1 * channels;
+        const scalar_t l00 = h_tap.lambda0 * w_tap.lambda0;
+        const scalar_t l01 = h_tap.lambda0 * w_tap.lambda1;
+        const scalar_t l10 = h_tap.lambda1 * w_tap.lambda0;
+        const scalar_t l11 = h_tap.lambda1 * w_tap.lambda1;
+        scalar_t* out = orow + w2 * channels;
+
+        for (int64_t c = 0; c < channels; ++c) {
+          out[c] = l00 * p00[c] + l01 * p01[c] + l10 * p10[c] + l11 * p11[c];
+        }
+      }
+    }
+  });
+}
+
+// Channels last backward: every channel scatters to the same pixels, so the
+// channels are split between threads.
+template <typename scalar_t>
+static void upsample_bilinear2d_backward_out_frame_channels_last(
+    const scalar_t* odata,
+    scalar_t* idata,
+    int64_t input_height,
+    int64_t input_width,
+    int64_t output_height,
+    int64_t output_width,
+    int64_t nbatch,
+    int64_t channels,
+    bool align_corners) {
+  const auto h_taps = compute_linear_interpolation_taps<scalar_t>(
+      input_height, output_height, align_corners);
+  const auto w_taps = compute_linear_interpolation_taps<scalar_t>(
+      input_width, output_width, align_corners);
+
+  const int64_t channel_work = nbatch * output_height * output_width;
+  at::parallel_for(0, channels, at::divup(at::internal::GRAIN_SIZE, channel_work), [&](int64_t begin, int64_t end) {
+    for (int64_t n = 0; n < nbatch; ++n) {
+      for (int64_t h2 = 0; h2 < output_height; ++h2) {
+        const auto& h_tap = h_taps[h2];
+        scalar_t* irow0 = idata + (n * input_height + h_tap.index0) * input_width * channels;
+        scalar_t* irow1 = idata + (n * input_height + h_tap.index1) * input_width * channels;
+        const scalar_t* orow = odata + (n * output_height + h2) * output_width * channels;
+
+        for (int64_t w2 = 0; w2 < output_width; ++w2) {
+          const auto& w_tap = w_taps[w2];
+          scalar_t* p00 = irow0 + w_tap.index0 * channels;
+          scalar_t* p01 = irow0 + w_tap.index1 * channels;
+          scalar_t* p10 = irow1 + w_tap.index0 * channels;
+          scalar_t* p11 = irow1 + w_tap.index1 * channels;
+          const scalar_t l00 = h_tap.lambda0 * w_tap.lambda0;
+          const scalar_t l01 = h_tap.lambda0 * w_tap.lambda1;
+          const scalar_t l10 = h_tap.lambda1 * w_tap.lambda0;
+          const scalar_t l11 = h_tap.lambda1 * w_tap.lambda1;
+          const scalar_t* out = orow + w2 * channels;
+
+          for (int64_t c = begin; c < end; ++c) {
+            p00[c] += l00 * out[c];
+            p01[c] += l01 * out[c];
+            p10[c] += l10 * out[c];
+            p11[c] += l11 * out[c];
+          }
+        }
+      }
+    }
+  });
 }
 
 static void upsample_bilinear2d_out_cpu_template(
@@ -182,15 +285,33 @@ static void upsample_bilinear2d_out_cpu_template(
       output_height,
       output_width);
 
-  auto input = input_.contiguous();
-
   output.resize_({nbatch, channels, output_height, output_width});
-  output.zero_();
 
   AT_ASSERT(
       input_height > 0 && input_width > 0 && output_height > 0 &&
       output_width > 0);
 
+  if (input_.suggest_memory_format() == MemoryFormat::ChannelsLast &&
+      output.is_contiguous(MemoryFormat::ChannelsLast)) {
+    auto input = input_.contiguous(MemoryFormat::ChannelsLast);
+    AT_DISPATCH_FLOATING_TYPES_AND_HALF(input.scalar_type(), "upsample_bilinear2d_channels_last", [&] {
+      upsample_bilinear2d_out_frame_channels_last<scalar_t>(
+          output.data<scalar_t>(),
+          input.data<scalar_t>(),
+          input_height,
+          input_width,
+          output_height,
+          output_width,
+          nbatch,
+          channels,
+          align_corners);
+    });
+    return;
+  }
+
+  auto input = input_.contiguous();
+  output.zero_();
+
   AT_DISPATCH_FLOATING_TYPES_AND_HALF(input.scalar_type(), "upsample_bilinear2d", [&] {
     auto* idata = input.data<scalar_t>();
     auto* odata = output.data<scalar_t>();
@@ -242,11 +363,30 @@ static void upsample_bilinear2d_backward_out_cpu_template(
       output_height,
       output_width);
 
-  auto grad_output = grad_output_.contiguous();
-
   grad_input.resize_({nbatch, channels, input_height, input_width});
   grad_input.zero_();
 
+  if (grad_output_.suggest_memory_format() == MemoryFormat::ChannelsLast &&
+      grad_input.is_contiguous(MemoryFormat::ChannelsLast)) {
+    auto grad_output = grad_output_.contiguous(MemoryFormat::ChannelsLast);
+    AT_DISPATCH_FLOATING_TYPES_AND_HALF(
+        grad_output.scalar_type(), "upsample_bilinear2d_backward_channels_last", [&] {
+          upsample_bilinear2d_backward_out_frame_channels_last<scalar_t>(
+              grad_output.data<scalar_t>(),
+              grad_input.data<scalar_t>(),
+              input_height,
+              input_width,
+              output_height,
+              output_width,
+              nbatch,
+              channels,
+              align_corners);
+        });
+    return;
+  }
+
+  auto grad_output = grad_output_.contiguous();
+
   AT_DISPATCH_FLOATING_TYPES_AND_HALF(
       grad_output.scalar_type(), "upsample_bilinear2d_backward", [&] {
         scalar_t* idata = grad_input.data<scalar_t>();
@@ -280,7 +420,7 @@ Tensor upsample_bilinear2d_cpu(
     const Tensor& input,
     IntArrayRef output_size,
     bool align_corners) {
-  auto output = at::empty({0}, input.options());
+  auto output = upsample_2d_empty_output(input, output_size);
   upsample_bilinear2d_out_cpu_template(
       output, input, output_size, align_corners);
   return output;
@@ -302,7 +442,7 @@ Tensor upsample_bilinear2d_backward_cpu(
     IntArrayRef output_size,
     IntArrayRef input_size,
     bool align_corners) {
-  auto grad_input = at::zeros(input_size, grad_output.options());
+  auto grad_input = upsample_2d_empty_grad_input(grad_output, input_size);
   upsample_bilinear2d_backward_out_cpu_template(
       grad_input, grad_output, output_size, input_size, align_corners);
   return grad_input;
@@ -96,23 +96,87 @@ static void upsample_nearest2d_backward_out_frame(
     return;
   }
 
-  for (int64_t h2 = 0; h2 < output_height; ++h2) {
-    const int64_t h1 =
-        nearest_neighbor_compute_source_index(height_scale, h2, input_height);
+  // output pixels scatter to overlapping input pixels, so this is parallel
+  // over the planes, which are independent
+  const int64_t plane_size = output_height * output_width;
+  at::parallel_for(0, channels, at::divup(at::internal::GRAIN_SIZE, plane_size), [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; ++c) {
+      scalar_t* iplane = idata + c * input_height * input_width;
+      const scalar_t* oplane = odata + c * plane_size;
+
+      for (int64_t h2 = 0; h2 < output_height; ++h2) {
+        const int64_t h1 =
+            nearest_neighbor_compute_source_index(height_scale, h2, input_height);
+
+        for (int64_t w2 = 0; w2 < output_width; ++w2) {
+          const int64_t w1 =
+              nearest_neighbor_compute_source_index(width_scale, w2, input_width);
+          iplane[h1 * input_width + w1] += oplane[h2 * output_width + w2];
+        }
+      }
+    }
+  });
+}
 
-    for (int64_t w2 = 0; w2 < output_width; ++w2) {
-      const int64_t w1 =
-          nearest_neighbor_compute_source_index(width_scale, w2, input_width);
-      scalar_t* pos1 = &idata[h1 * input_width + w1];
-      const scalar_t* pos2 = &odata[h2 * output_width + w2];
+// Channels last: an output pixel copies all its channels from one input pixel.
+template <typename scalar_t>
+static void upsample_nearest2d_out_frame_channels_last(
+    scalar_t* odata,
+    const scalar_t* idata,
+    int64_t input_height,
+    int64_t input_width,
+    int64_t output_height,
+    int64_t output_width,
+    int64_t nbatch,
+    int64_t channels) {
+  const auto h_indices = compute_nearest_neighbor_indices(input_height, output_height);
+  const auto w_indices = compute_nearest_neighbor_indices(input_width, output_width);
+
+  const int64_t row_size = output_width * channels;
+  at::parallel_for(0, nbatch * output_height, at::divup(at::internal::GRAIN_SIZE, row_size), [&](int64_t begin, int64_t end) {
+    for (int64_t row = begin; row < end; ++row) {
+      const int64_t n = row / output_height;
+      const scalar_t* irow = idata +
+          (n * input_height + h_indices[row % output_height]) * input_width * channels;
+      scalar_t* orow = odata + row * row_size;
+      for (int64_t w2 = 0; w2 < output_width; ++w2) {
+        std::copy_n(irow + w_indices[w2] * channels, channels, orow + w2 * channels);
+      }
+    }
+  });
+}
 
-      for (int64_t c = 0; c < channels; ++c) {
-        pos1[0] += pos2[0];
-        pos1 += input_height * input_width;
-        pos2 += output_height * output_width;
+// Channels last backward: every channel scatters to the same pixels, so the
+// channels are split between threads.
+template <typename scalar_t>
+static void upsample_nearest2d_backward_out_frame_channels_last(
+    const scalar_t* odata,
+    scalar_t* idata,
+    int64_t input_height,
+    int64_t input_width,
+    int64_t output_height,
+    int64_t output_width,
+    int64_t nbatch,
+    int64_t channels) {
+  const auto h_indices = compute_nearest_neighbor_indices(input_height, output_height);
+  const auto w_indices = compute_nearest_neighbor_indices(input_width, output_width);
+
+  const int64_t channel_work = nbatch * output_height * output_width;
+  at::parallel_for(0, channels, at::divup(at::internal::GRAIN_SIZE, channel_work), [&](int64_t begin, int64_t end) {
+    for (int64_t n = 0; n < nbatch; ++n) {
+      for (int64_t h2 = 0; h2 < output_height; ++h2) {
+        scalar_t* irow = idata + (n * input_height + h_indices[h2]) * input_width * channels;
+        const scalar_t* orow = odata + (n * output_height + h2) * output_width * channels;
+        for (int64_t w2 = 0; w2 < output_width; ++w2) {
+          scalar_t* in = irow + w_indices[w2] * channels;
+          const scalar_t* out = orow + w2 * channels;
+          for (int64_t c = begin; c < end; ++c) {
+            in[c] += out[c];
+          }
+        }
       }
     }
-  }
+  });
 }
 
 static void upsample_nearest2d_out_cpu_template(
@@ -142,13 +206,30 @@ static void upsample_nearest2d_out_cpu_template(
       output_height,
       output_width);
 
-  auto input = input_.contiguous();
-
   output.resize_({nbatch, channels, output_height, output_width});
-  output.zero_();
 
   AT_ASSERT(input_width > 0 && output_width > 0);
 
+  if (input_.suggest_memory_format() == MemoryFormat::ChannelsLast &&
+      output.is_contiguous(MemoryFormat::ChannelsLast)) {
+    auto input = input_.contiguous(MemoryFormat::ChannelsLast);
+    AT_DISPATCH_FLOATING_TYPES_AND_HALF(input.scalar_type(), "upsample_nearest2d_channels_last", [&] {
+      upsample_nearest2d_out_frame_channels_last<scalar_t>(
+          output.data<scalar_t>(),
+          input.data<scalar_t>(),
+          input_height,
+          input_width,
+          output_height,
+          output_width,
+          nbatch,
+          channels);
+    });
+    return;
+  }
+
+  auto input = input_.contiguous();
+  output.zero_();
+
   AT_DISPATCH_FLOATING_TYPES_AND_HALF(input.scalar_type(), "upsample_nearest2d", [&] {
     auto* idata = input.data<scalar_t>();
     auto* odata = output.data<scalar_t>();
@@ -201,6 +282,24 @@ static void upsample_nearest2d_backward_out_cpu_template(
   grad_input.resize_({nbatch, channels, input_height, input_width});
   grad_input.zero_();
 
+  if (grad_output_.suggest_memory_format() == MemoryFormat::ChannelsLast &&
+      grad_input.is_contiguous(MemoryFormat::ChannelsLast)) {
+    auto grad_output = grad_output_.contiguous(MemoryFormat::ChannelsLast);
+    AT_DISPATCH_FLOATING_TYPES_AND_HALF(
+        grad_output.scalar_type(), "upsample_nearest2d_backward_channels_last", [&] {
+          upsample_nearest2d_backward_out_frame_channels_last<scalar_t>(
+              grad_output.data<scalar_t>(),
+              grad_input.data<scalar_t>(),
+              input_height,
+              input_width,
+              output_height,
+              output_width,
+              nbatch,
+              channels);
+        });
+    return;
+  }
+
   auto grad_output = grad_output_.contiguous();
 
   AT_DISPATCH_FLOATING_TYPES_AND_HALF(
@@ -230,7 +329,7 @@ Tensor& upsample_nearest2d_out_cpu(
 }
 
 Tensor upsample_nearest2d_cpu(const Tensor& input, IntArrayRef output_size) {
-  auto output = at::empty({0}, input.options());
+  auto output = upsample_2d_empty_output(input, output_size);
   upsample_nearest2d_out_cpu_template(output, input, output_size);
   return output;
 }
@@ -249,7 +348,7 @@ Tensor upsample_nearest2d_backward_cpu(
     const Tensor& grad_output,
     IntArrayRef output_size,
     IntArrayRef input_size) {
-  auto grad_input = at::zeros(input_size, grad_output.options());
+  auto grad_input = upsample_2d_empty_grad_input(grad_output, input_size);
   upsample_nearest2d_backward_out_cpu_template(
       grad_input, grad_output, output_size, input_size);
   return grad_input;
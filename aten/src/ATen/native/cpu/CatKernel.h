@@ -0,0 +1,14 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+namespace at { namespace native {
+
+// Concatenates contiguous tensors of the result's dtype into the contiguous
+// result, which already has the concatenated size. Inputs of size [0] are
+// skipped like in the legacy implementation.
+using cat_contiguous_fn = void(*)(Tensor &, TensorList, int64_t);
+DECLARE_DISPATCH(cat_contiguous_fn, cat_contiguous_stub);
+
+}} // namespace at::native
@@ -1,9 +1,14 @@
 #include <ATen/native/cpu/CopyKernel.h>
 
+#include <algorithm>
+#include <vector>
+
 #include <ATen/ATen.h>
 #include <ATen/CPUApplyUtils.h>
 #include <ATen/Dispatch.h>
-#include <ATen/cpu/vec256/vec256.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec256/intrinsics.h>
+#include <ATen/cpu/vec512/vec512.h>
 #include <ATen/native/TensorIterator.h>
 #include <ATen/native/cpu/Loops.h>
 #include <ATen/native/Copy.h>
@@ -21,8 +26,9 @@ void copy_kernel_cast_t_impl(Tensor& self, const Tensor& src) {
   builder.dont_compute_common_dtype();
   auto iter = builder.build();
 
-  AT_DISPATCH_ALL_TYPES_AND2(
+  AT_DISPATCH_ALL_TYPES_AND3(
       at::ScalarType::Half,
+      at::ScalarType::BFloat16,
       at::ScalarType::Bool,
       src.scalar_type(),
       "copy_kernel_cast",
@@ -35,28 +41,280 @@ void copy_kernel_cast_t_impl(Tensor& self, const Tensor& src) {
 }
 
 static void copy_kernel_cast_impl(Tensor& self, const Tensor& src) {
-  AT_DISPATCH_ALL_TYPES_AND2(at::ScalarType::Half, at::ScalarType::Bool,
+  AT_DISPATCH_ALL_TYPES_AND3(at::ScalarType::Half, at::ScalarType::BFloat16, at::ScalarType::Bool,
       self.scalar_type(), "copy_kernel_cast", [&]() { copy_kernel_cast_t_impl<scalar_t>(self, src); });
 }
 
+// Permutation copy
+//
+// Copies a strided src into a contiguous self of the same number of elements
+// when the dimension that is contiguous in src is not the last one, e.g.
+// NCHW <-> NHWC or splitting attention heads with permute + contiguous.
+// TensorIterator walks such copies along the last dimension, so one of the
+// two sides is always read or written with a large stride. Here the
+// dimensions are coalesced first, which turns the copy into a batch of 2-d
+// transposes: rows are contiguous in src, columns are contiguous in self. The
+// transposes are done in TILE x TILE tiles that fit in L1, with an
+// in-register transpose of the inner blocks for 4 and 8 byte elements, and the
+// tiles of all the batches are distributed over threads.
+//
+// The copy only moves bytes, so it is instantiated on unsigned integers of the
+// element size.
+
+constexpr int64_t TILE = 32;
+
+// dst[i * dst_stride + j] = src[i + j * src_stride] for i < rows, j < cols
+template <typename T>
+inline void transpose_block_scalar(
+    const T* src, int64_t src_stride, T* dst, int64_t dst_stride,
+    int64_t rows, int64_t cols) {
+  for (int64_t i = 0; i < rows; i++) {
+    for (int64_t j = 0; j < cols; j++) {
+      dst[i * dst_stride + j] = src[i + j * src_stride];
+    }
+  }
+}
+
+template <typename T>
+inline void transpose_block(
+    const T* src, int64_t src_stride, T* dst, int64_t dst_stride,
+    int64_t rows, int64_t cols) {
+  transpose_block_scalar(src, src_stride, dst, dst_stride, rows, cols);
+}
+
+#if defined(__AVX__) && !defined(_MSC_VER)
+
+template <>
+inline void transpose_block<uint32_t>(
+    const uint32_t* src, int64_t src_stride, uint32_t* dst, int64_t dst_stride,
+    int64_t rows, int64_t cols) {
+  int64_t i = 0;
+  for (; i + 8 <= rows; i += 8) {
+    int64_t j = 0;
+    for (; j + 8 <= cols; j += 8) {
+      const float* s = reinterpret_cast<const float*>(src + i + j * src_stride);
+      float* d = reinterpret_cast<float*>(dst + i * dst_stride + j);
+      // r[c] holds column j + c, i.e. elements (i .. i + 7, j + c)
+      __m256 r0 = _mm256_loadu_ps(s);
+      __m256 r1 = _mm256_loadu_ps(s + src_stride);
+      __m256 r2 = _mm256_loadu_ps(s + 2 * src_stride);
+      __m256 r3 = _mm256_loadu_ps(s + 3 * src_stride);
+      __m256 r4 = _mm256_loadu_ps(s + 4 * src_stride);
+      __m256 r5 = _mm256_loadu_ps(s + 5 * src_stride);
+      __m256 r6 = _mm256_loadu_ps(s + 6 * src_stride);
+      __m256 r7 = _mm256_loadu_ps(s + 7 * src_stride);
+      __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+      __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+      __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+      __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+      __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+      __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+      __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+      __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+      r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+      r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+      r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+      r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+      r4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+      r5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+      r6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+      r7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+      _mm256_storeu_ps(d, _mm256_permute2f128_ps(r0, r4, 0x20));
+      _mm256_storeu_ps(d + dst_stride, _mm256_permute2f128_ps(r1, r5, 0x20));
+      _mm256_storeu_ps(d + 2 * dst_stride, _mm256_permute2f128_ps(r2, r6, 0x20));
+      _mm256_storeu_ps(d + 3 * dst_stride, _mm256_permute2f128_ps(r3, r7, 0x20));
+      _mm256_storeu_ps(d + 4 * dst_stride, _mm256_permute2f128_ps(r0, r4, 0x31));
+      _mm256_storeu_ps(d + 5 * dst_stride, _mm256_permute2f128_ps(r1, r5, 0x31));
+      _mm256_storeu_ps(d + 6 * dst_stride, _mm256_permute2f128_ps(r2, r6, 0x31));
+      _mm256_storeu_ps(d + 7 * dst_stride, _mm256_permute2f128_ps(r3, r7, 0x31));
+    }
+    if (j < cols) {
+      transpose_block_scalar(
+          src + i + j * src_stride, src_stride, dst + i * dst_stride + j,
+          dst_stride, 8, cols - j);
+    }
+  }
+  if (i < rows) {
+    transpose_block_scalar(
+        src + i, src_stride, dst + i * dst_stride, dst_stride, rows - i, cols);
+  }
+}
+
+template <>
+inline void transpose_block<uint64_t>(
+    const uint64_t* src, int64_t src_stride, uint64_t* dst, int64_t dst_stride,
+    int64_t rows, int64_t cols) {
+  int64_t i = 0;
+  for (; i + 4 <= rows; i += 4) {
+    int64_t j = 0;
+    for (; j + 4 <= cols; j += 4) {
+      const double* s = reinterpret_cast<const double*>(src + i + j * src_stride);
+      double* d = reinterpret_cast<double*>(dst + i * dst_stride + j);
+      __m256d r0 = _mm256_loadu_pd(s);
+      __m256d r1 = _mm256_loadu_pd(s + src_stride);
+      __m256d r2 = _mm256_loadu_pd(s + 2 * src_stride);
+      __m256d r3 = _mm256_loadu_pd(s + 3 * src_stride);
+      __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+      __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+      __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+      __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+      _mm256_storeu_pd(d, _mm256_permute2f128_pd(t0, t2, 0x20));
+      _mm256_storeu_pd(d + dst_stride, _mm256_permute2f128_pd(t1, t3, 0x20));
+      _mm256_storeu_pd(d + 2 * dst_stride, _mm256_permute2f128_pd(t0, t2, 0x31));
+      _mm256_storeu_pd(d + 3 * dst_stride, _mm256_permute2f128_pd(t1, t3, 0x31));
+    }
+    if (j < cols) {
+      transpose_block_scalar(
+          src + i + j * src_stride, src_stride, dst + i * dst_stride + j,
+          dst_stride, 4, cols - j);
+    }
+  }
+  if (i < rows) {
+    transpose_block_scalar(
+        src + i, src_stride, dst + i * dst_stride, dst_stride, rows - i, cols);
+  }
+}
+
+#endif
+
+// sizes, src_strides and dst_strides describe the coalesced copy; dimension
+// row_dim is contiguous in src and the last dimension is contiguous in dst.
+template <typename T>
+void permute_copy_kernel(
+    T* dst, const T* src, const std::vector<int64_t>& sizes,
+    const std::vector<int64_t>& src_strides,
+    const std::vector<int64_t>& dst_strides, int64_t row_dim) {
+  int64_t ndim = sizes.size();
+  int64_t rows = sizes[row_dim];
+  int64_t cols = sizes[ndim - 1];
+  int64_t src_col_stride = src_strides[ndim - 1];
+  int64_t dst_row_stride = dst_strides[row_dim];
+
+  std::vector<int64_t> batch_dims;
+  int64_t batches = 1;
+  for (int64_t d = 0; d < ndim - 1; d++) {
+    if (d != row_dim) {
+      batch_dims.push_back(d);
+      batches *= sizes[d];
+    }
+  }
+  int64_t row_tiles = divup(rows, TILE);
+  int64_t col_tiles = divup(cols, TILE);
+
+  parallel_for(
+      0, batches * row_tiles * col_tiles,
+      std::max<int64_t>(internal::GRAIN_SIZE / (TILE * TILE), 1),
+      [&](int64_t begin, int64_t end) {
+        for (int64_t t = begin; t < end; t++) {
+          int64_t col = (t % col_tiles) * TILE;
+          int64_t row = (t / col_tiles % row_tiles) * TILE;
+          int64_t batch = t / (col_tiles * row_tiles);
+          int64_t src_offset = row + col * src_col_stride;
+          int64_t dst_offset = row * dst_row_stride + col;
+          for (int64_t i = batch_dims.size() - 1; i >= 0; i--) {
+            int64_t d = batch_dims[i];
+            int64_t idx = batch % sizes[d];
+            batch /= sizes[d];
+            src_offset += idx * src_strides[d];
+            dst_offset += idx * dst_strides[d];
+          }
+          transpose_block(
+              src + src_offset, src_col_stride, dst + dst_offset,
+              dst_row_stride, std::min(TILE, rows - row),
+              std::min(TILE, cols - col));
+        }
+      });
+}
+
+// Returns false if the copy is not a batched transpose, in which case the
+// caller falls back to TensorIterator. self must be contiguous; it is indexed
+// like src, so any contiguous self of the same number of elements works.
+static bool permute_copy(Tensor& self, const Tensor& src) {
+  if (!self.is_contiguous() || self.numel() != src.numel() ||
+      src.numel() < TILE * TILE) {
+    return false;
+  }
+  // Drop the size 1 dimensions and merge the dimensions that are contiguous
+  // with respect to each other in src; they always are in self.
+  std::vector<int64_t> sizes;
+  std::vector<int64_t> src_strides;
+  for (int64_t d = 0; d < src.dim(); d++) {
+    if (src.size(d) == 1) {
+      continue;
+    }
+    if (!sizes.empty() &&
+        src_strides.back() == src.stride(d) * src.size(d)) {
+      sizes.back() *= src.size(d);
+      src_strides.back() = src.stride(d);
+    } else {
+      sizes.push_back(src.size(d));
+      src_strides.push_back(src.stride(d));
+    }
+  }
+  int64_t ndim = sizes.size();
+  if (ndim < 2 || src_strides[ndim - 1] == 1) {
+    return false;
+  }
+  auto row_dim = std::find(src_strides.begin(), src_strides.end(), 1) -
+      src_strides.begin();
+  if (row_dim == ndim) {
+    return false;
+  }
+  std::vector<int64_t> dst_strides(ndim);
+  dst_strides[ndim - 1] = 1;
+  for (int64_t d = ndim - 2; d >= 0; d--) {
+    dst_strides[d] = dst_strides[d + 1] * sizes[d + 1];
+  }
+
+  switch (self.element_size()) {
+    case 1:
+      permute_copy_kernel(
+          static_cast<uint8_t*>(self.data_ptr()),
+          static_cast<const uint8_t*>(src.data_ptr()), sizes, src_strides,
+          dst_strides, row_dim);
+      return true;
+    case 2:
+      permute_copy_kernel(
+          static_cast<uint16_t*>(self.data_ptr()),
+          static_cast<const uint16_t*>(src.data_ptr()), sizes, src_strides,
+          dst_strides, row_dim);
+      return true;
+    case 4:
+      permute_copy_kernel(
+          static_cast<uint32_t*>(self.data_ptr()),
+          static_cast<const uint32_t*>(src.data_ptr()), sizes, src_strides,
+          dst_strides, row_dim);
+      return true;
+    case 8:
+      permute_copy_kernel(
+          static_cast<uint64_t*>(self.data_ptr()),
+          static_cast<const uint64_t*>(src.data_ptr()), sizes, src_strides,
+          dst_strides, row_dim);
+      return true;
+    default:
+      return false;
+  }
+}
+
 static void copy_kernel_same_type_impl(Tensor& self, const Tensor& src) {
+  if (permute_copy(self, src)) {
+    return;
+  }
+
   auto builder = TensorIterator::Builder();
   builder.add_output(self);
   builder.add_input(src);
   builder.dont_resize_outputs();
   auto iter = builder.build();
 
-  if (self.scalar_type() == at::ScalarType::Half) {
-    unary_kernel(*iter, [=](at::Half a) -> at::Half { return a; });
-  } else {
-    AT_DISPATCH_ALL_TYPES_AND(
-        at::ScalarType::Bool, self.scalar_type(), "copy_kernel_same_type", [&] {
-          unary_kernel_vec(
-              *iter,
-              [=](scalar_t a) -> scalar_t { return a; },
-              [=](Vec256<scalar_t> a) { return a; });
-        });
-  }
+  AT_DISPATCH_ALL_TYPES_AND3(
+      at::ScalarType::Half, at::ScalarType::BFloat16, at::ScalarType::Bool,
+      self.scalar_type(), "copy_kernel_same_type", [&] {
+        unary_kernel_vec(
+            *iter,
+            [=](scalar_t a) -> scalar_t { return a; },
+            [=](Vectorized<scalar_t> a) { return a; });
+      });
 }
 
 } // anonymous namespace
@@ -0,0 +1,258 @@
+#include <ATen/native/DepthwiseConvolution.h>
+
+#include <algorithm>
+#include <tuple>
+
+#include <ATen/AccumulateType.h>
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec256/vec256.h>
+
+namespace at { namespace native { namespace {
+
+// The outputs o in [begin, end) whose tap o * stride + offset is inside an
+// input of size input_size.
+static inline std::pair<int64_t, int64_t> tap_range(
+    int64_t output_size, int64_t input_size, int64_t stride, int64_t offset) {
+  int64_t begin = offset >= 0 ? 0 : (-offset + stride - 1) / stride;
+  int64_t last = input_size - 1 - offset;
+  int64_t end = last < 0 ? 0 : last / stride + 1;
+  begin = std::min(begin, output_size);
+  return {begin, std::max(begin, std::min(end, output_size))};
+}
+
+// One output plane of the convolution of one input plane with a K x K filter.
+// The row of outputs is split into the interior, where all K taps of a row
+// are inside the input, and the borders, where some of them are in the
+// padding. The interior has no bounds checks, and for stride 1 is computed
+// Vec::size() outputs at a time.
+template <typename scalar_t, int64_t K, int64_t S>
+void depthwise_conv2d_plane(
+    const scalar_t* input, int64_t input_height, int64_t input_width,
+    const scalar_t* weight, scalar_t bias,
+    scalar_t* output, int64_t output_height, int64_t output_width,
+    int64_t pad_height, int64_t pad_width) {
+  using Vec = vec256::Vec256<scalar_t>;
+  int64_t ox_begin = tap_range(output_width, input_width, S, -pad_width).first;
+  int64_t ox_end = std::max(ox_begin, tap_range(output_width, input_width, S, K - 1 - pad_width).second);
+
+  Vec weight_vec[K * K];
+  for (int64_t k = 0; k < K * K; k++) {
+    weight_vec[k] = Vec(weight[k]);
+  }
+
+  for (int64_t oy = 0; oy < output_height; oy++) {
+    int64_t iy0 = oy * S - pad_height;
+    int64_t ky_begin = std::max<int64_t>(0, -iy0);
+    int64_t ky_end = std::min<int64_t>(K, input_height - iy0);
+    scalar_t* out = output + oy * output_width;
+
+    auto border = [&](int64_t ox) {
+      int64_t ix0 = ox * S - pad_width;
+      int64_t kx_begin = std::max<int64_t>(0, -ix0);
+      int64_t kx_end = std::min<int64_t>(K, input_width - ix0);
+      scalar_t sum = bias;
+      for (int64_t ky = ky_begin; ky < ky_end; ky++) {
+        const scalar_t* in = input + (iy0 + ky) * input_width + ix0;
+        for (int64_t kx = kx_begin; kx < kx_end; kx++) {
+          sum += weight[ky * K + kx] * in[kx];
+        }
+      }
+      out[ox] = sum;
+    };
+    for (int64_t ox = 0; ox < ox_begin; ox++) {
+      border(ox);
+    }
+    for (int64_t ox = ox_end; ox < output_width; ox++) {
+      border(ox);
+    }
+
+    int64_t ox = ox_begin;
+    if (S == 1) {
+      for (; ox + Vec::size() <= ox_end; ox += Vec::size()) {
+        Vec sum(bias);
+        for (int64_t ky = ky_begin; ky < ky_end; ky++) {
+          const scalar_t* in = input + (iy0 + ky) * input_width + ox - pad_width;
+          for (int64_t kx = 0; kx < K; kx++) {
+            sum = vec256::fmadd(weight_vec[ky * K + kx], Vec::loadu(in + kx), sum);
+          }
+        }
+        sum.store(out + ox);
+      }
+    }
+    for (; ox < ox_end; ox++) {
+      scalar_t sum = bias;
+      for (int64_t ky = ky_begin; ky < ky_end; ky++) {
+        const scalar_t* in = input + (iy0 + ky) * input_width + ox * S - pad_width;
+        for (int64_t kx = 0; kx < K; kx++) {
+          sum += weight[ky * K + kx] * in[kx];
+        }
+      }
+      out[ox] = sum;
+    }
+  }
+}
+
+template <typename scalar_t, int64_t K, int64_t S>
+void depthwise_conv2d_impl(
+    Tensor& output, const Tensor& input, const Tensor& weight, const Tensor& bias,
+    IntArrayRef padding) {
+  int64_t channels = input.size(1);
+  int64_t input_height = input.size(2);
+  int64_t input_width = input.size(3);
+  int64_t out_channels = output.size(1);
+  int64_t output_height = output.size(2);
+  int64_t output_width = output.size(3);
+  int64_t multiplier = out_channels / channels;
+
+  const scalar_t* input_data = input.data<scalar_t>();
+  const scalar_t* weight_data = weight.data<scalar_t>();
+  const scalar_t* bias_data = bias.defined() ? bias.data<scalar_t>() : nullptr;
+  scalar_t* output_data = output.data<scalar_t>();
+
+  int64_t plane_cost = output_height * output_width * K * K;
+  parallel_for(0, output.size(0) * out_channels, std::max<int64_t>(1, internal::GRAIN_SIZE / plane_cost),
+               [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      int64_t n = i / out_channels;
+      int64_t c = i % out_channels;
+      depthwise_conv2d_plane<scalar_t, K, S>(
+          input_data + (n * channels + c / multiplier) * input_height * input_width,
+          input_height, input_width,
+          weight_data + c * K * K, bias_data ? bias_data[c] : scalar_t(0),
+          output_data + i * output_height * output_width, output_height, output_width,
+          padding[0], padding[1]);
+    }
+  });
+}
+
+void depthwise_conv2d_kernel(
+    Tensor& output, const Tensor& input, const Tensor& weight, const Tensor& bias,
+    IntArrayRef padding, IntArrayRef stride) {
+  AT_DISPATCH_FLOATING_TYPES(input.scalar_type(), "depthwise_conv2d", [&] {
+    if (weight.size(2) == 3) {
+      if (stride[0] == 1) {
+        depthwise_conv2d_impl<scalar_t, 3, 1>(output, input, weight, bias, padding);
+      } else {
+        depthwise_conv2d_impl<scalar_t, 3, 2>(output, input, weight, bias, padding);
+      }
+    } else {
+      if (stride[0] == 1) {
+        depthwise_conv2d_impl<scalar_t, 5, 1>(output, input, weight, bias, padding);
+      } else {
+        depthwise_conv2d_impl<scalar_t, 5, 2>(output, input, weight, bias, padding);
+      }
+    }
+  });
+}
+
+// The gradient of an input plane scatters each tap of the filters of its
+// channel back from the outputs, over the outputs that have the tap inside
+// the input. Planes are independent, so there are no races.
+void depthwise_conv2d_backward_input_kernel(
+    Tensor& grad_input, const Tensor& grad_output, const Tensor& weight,
+    IntArrayRef padding, IntArrayRef stride) {
+  AT_DISPATCH_FLOATING_TYPES(grad_output.scalar_type(), "depthwise_conv2d_backward_input", [&] {
+    int64_t channels = grad_input.size(1);
+    int64_t input_height = grad_input.size(2);
+    int64_t input_width = grad_input.size(3);
+    int64_t out_channels = grad_output.size(1);
+    int64_t output_height = grad_output.size(2);
+    int64_t output_width = grad_output.size(3);
+    int64_t kernel_height = weight.size(2);
+    int64_t kernel_width = weight.size(3);
+    int64_t multiplier = out_channels / channels;
+
+    const scalar_t* grad_output_data = grad_output.data<scalar_t>();
+    const scalar_t* weight_data = weight.data<scalar_t>();
+    scalar_t* grad_input_data = grad_input.data<scalar_t>();
+
+    parallel_for(0, grad_input.size(0) * channels, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        int64_t n = i / channels;
+        int64_t c = i % channels;
+        scalar_t* gi = grad_input_data + i * input_height * input_width;
+        std::fill_n(gi, input_height * input_width, scalar_t(0));
+        for (int64_t oc = c * multiplier; oc < (c + 1) * multiplier; oc++) {
+          const scalar_t* go = grad_output_data + (n * out_channels + oc) * output_height * output_width;
+          const scalar_t* w = weight_data + oc * kernel_height * kernel_width;
+          for (int64_t ky = 0; ky < kernel_height; ky++) {
+            int64_t oy_begin, oy_end;
+            std::tie(oy_begin, oy_end) = tap_range(output_height, input_height, stride[0], ky - padding[0]);
+            for (int64_t kx = 0; kx < kernel_width; kx++) {
+              int64_t ox_begin, ox_end;
+              std::tie(ox_begin, ox_end) = tap_range(output_width, input_width, stride[1], kx - padding[1]);
+              scalar_t wv = w[ky * kernel_width + kx];
+              for (int64_t oy = oy_begin; oy < oy_end; oy++) {
+                scalar_t* gi_row = gi + (oy * stride[0] + ky - padding[0]) * input_width + kx - padding[1];
+                const scalar_t* go_row = go + oy * output_width;
+                for (int64_t ox = ox_begin; ox < ox_end; ox++) {
+                  gi_row[ox * stride[1]] += wv * go_row[ox];
+                }
+              }
+            }
+          }
+        }
+      }
+    });
+  });
+}
+
+// The gradient of a filter tap is the sum over the batch of the products of
+// the output gradients with the inputs the tap read.
+void depthwise_conv2d_backward_weight_kernel(
+    Tensor& grad_weight, const Tensor& grad_output, const Tensor& input,
+    IntArrayRef padding, IntArrayRef stride) {
+  AT_DISPATCH_FLOATING_TYPES(grad_output.scalar_type(), "depthwise_conv2d_backward_weight", [&] {
+    using accscalar_t = acc_type<scalar_t, false>;
+    int64_t batch = input.size(0);
+    int64_t channels = input.size(1);
+    int64_t input_height = input.size(2);
+    int64_t input_width = input.size(3);
+    int64_t out_channels = grad_output.size(1);
+    int64_t output_height = grad_output.size(2);
+    int64_t output_width = grad_output.size(3);
+    int64_t kernel_height = grad_weight.size(2);
+    int64_t kernel_width = grad_weight.size(3);
+    int64_t multiplier = out_channels / channels;
+
+    const scalar_t* grad_output_data = grad_output.data<scalar_t>();
+    const scalar_t* input_data = input.data<scalar_t>();
+    scalar_t* grad_weight_data = grad_weight.data<scalar_t>();
+
+    parallel_for(0, out_channels, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t oc = begin; oc < end; oc++) {
+        int64_t c = oc / multiplier;
+        for (int64_t ky = 0; ky < kernel_height; ky++) {
+          int64_t oy_begin, oy_end;
+          std::tie(oy_begin, oy_end) = tap_range(output_height, input_height, stride[0], ky - padding[0]);
+          for (int64_t kx = 0; kx < kernel_width; kx++) {
+            int64_t ox_begin, ox_end;
+            std::tie(ox_begin, ox_end) = tap_range(output_width, input_width, stride[1], kx - padding[1]);
+            accscalar_t sum = 0;
+            for (int64_t n = 0; n < batch; n++) {
+              const scalar_t* go = grad_output_data + (n * out_channels + oc) * output_height * output_width;
+              const scalar_t* in = input_data + (n * channels + c) * input_height * input_width;
+              for (int64_t oy = oy_begin; oy < oy_end; oy++) {
+                const scalar_t* go_row = go + oy * output_width;
+                const scalar_t* in_row = in + (oy * stride[0] + ky - padding[0]) * input_width + kx - padding[1];
+                for (int64_t ox = ox_begin; ox < ox_end; ox++) {
+                  sum += static_cast<accscalar_t>(go_row[ox]) * in_row[ox * stride[1]];
+                }
+              }
+            }
+            grad_weight_data[(oc * kernel_height + ky) * kernel_width + kx] = static_cast<scalar_t>(sum);
+          }
+        }
+      }
+    });
+  });
+}
+
+}  // anonymous namespace
+
+REGISTER_DISPATCH(depthwise_conv2d_stub, &depthwise_conv2d_kernel);
+REGISTER_DISPATCH(depthwise_conv2d_backward_input_stub, &depthwise_conv2d_backward_input_kernel);
+REGISTER_DISPATCH(depthwise_conv2d_backward_weight_stub, &depthwise_conv2d_backward_weight_kernel);
+
+}}  // namespace at::native
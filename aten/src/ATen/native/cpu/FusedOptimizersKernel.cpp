@@ -0,0 +1,75 @@
+#include <ATen/native/FusedOptimizers.h>
+
+#include <array>
+
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/native/FusedOptimizerOps.h>
+
+namespace at { namespace native { namespace {
+
+// Calls op(ptrs, i) for every element i of every tensor of lists[0], in
+// parallel over the elements of each tensor.
+template <size_t depth, typename scalar_t, typename Op>
+void apply_fused_step(const std::array<TensorList, depth>& lists, const Op& op) {
+  for (size_t t = 0; t < lists[0].size(); t++) {
+    std::array<scalar_t*, depth> ptrs;
+    for (size_t d = 0; d < depth; d++) {
+      ptrs[d] = lists[d].empty() ? nullptr : lists[d][t].data<scalar_t>();
+    }
+    parallel_for(0, lists[0][t].numel(), internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        op(ptrs.data(), i);
+      }
+    });
+  }
+}
+
+void fused_sgd_kernel(
+    TensorList params, TensorList grads, TensorList momentum_buffers,
+    double lr, double weight_decay, double momentum, double dampening,
+    bool nesterov) {
+  AT_DISPATCH_FLOATING_TYPES(params[0].scalar_type(), "fused_sgd_step", [&] {
+    SGDStepOp<scalar_t, scalar_t> op{
+        static_cast<scalar_t>(lr), static_cast<scalar_t>(weight_decay),
+        static_cast<scalar_t>(momentum), static_cast<scalar_t>(dampening),
+        nesterov};
+    apply_fused_step<3, scalar_t>({{params, grads, momentum_buffers}}, op);
+  });
+}
+
+void fused_adam_kernel(
+    TensorList params, TensorList grads, TensorList exp_avgs,
+    TensorList exp_avg_sqs, TensorList max_exp_avg_sqs, double step_size,
+    double beta1, double beta2, double eps, double weight_decay) {
+  AT_DISPATCH_FLOATING_TYPES(params[0].scalar_type(), "fused_adam_step", [&] {
+    AdamStepOp<scalar_t, scalar_t> op{
+        static_cast<scalar_t>(step_size), static_cast<scalar_t>(beta1),
+        static_cast<scalar_t>(beta2), static_cast<scalar_t>(eps),
+        static_cast<scalar_t>(weight_decay)};
+    apply_fused_step<5, scalar_t>(
+        {{params, grads, exp_avgs, exp_avg_sqs, max_exp_avg_sqs}}, op);
+  });
+}
+
+void fused_rmsprop_kernel(
+    TensorList params, TensorList grads, TensorList square_avgs,
+    TensorList grad_avgs, TensorList momentum_buffers, double lr,
+    double alpha, double eps, double weight_decay, double momentum) {
+  AT_DISPATCH_FLOATING_TYPES(params[0].scalar_type(), "fused_rmsprop_step", [&] {
+    RMSpropStepOp<scalar_t, scalar_t> op{
+        static_cast<scalar_t>(lr), static_cast<scalar_t>(alpha),
+        static_cast<scalar_t>(eps), static_cast<scalar_t>(weight_decay),
+        static_cast<scalar_t>(momentum)};
+    apply_fused_step<5, scalar_t>(
+        {{params, grads, square_avgs, grad_avgs, momentum_buffers}}, op);
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(fused_sgd_stub, &fused_sgd_kernel);
+REGISTER_DISPATCH(fused_adam_stub, &fused_adam_kernel);
+REGISTER_DISPATCH(fused_rmsprop_stub, &fused_rmsprop_kernel);
+
+}} // namespace at::native
@@ -1,7 +1,11 @@
 #include <ATen/native/Indexing.h>
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <iostream>
+#include <numeric>
+#include <vector>
 #include <ATen/Dispatch.h>
 #include <ATen/native/TensorIterator.h>
 #include <ATen/Parallel.h>
@@ -116,10 +120,219 @@ void index_put_kernel(TensorIterator& iter, IntArrayRef index_size, IntArrayRef
   });
 }
 
+// result[i] = self[index[i]] for the rows of a contiguous self. Every index
+// copies a whole row with one memcpy instead of computing an offset per
+// element, which is what embedding-like lookups boil down to.
+void index_select_rows_kernel(Tensor& result, const Tensor& self, const Tensor& index, bool wrap_negative) {
+  int64_t size = self.size(0);
+  int64_t row_size = 1;
+  for (int64_t d = 1; d < self.dim(); d++) {
+    row_size *= self.size(d);
+  }
+  int64_t row_bytes = row_size * self.dtype().itemsize();
+  int64_t numel = index.numel();
+  if (numel == 0) {
+    return;
+  }
+  const int64_t* index_data = index.data<int64_t>();
+  const char* src = static_cast<const char*>(self.data_ptr());
+  char* dst = static_cast<char*>(result.data_ptr());
+  int64_t grain_size = std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(row_size, 1), 1);
+  parallel_for(0, numel, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      int64_t value = index_data[i];
+      if (value >= size || value < (wrap_negative ? -size : 0)) {
+        // advanced indexing raises IndexError, index_select a RuntimeError
+        if (wrap_negative) {
+          AT_INDEX_ERROR("index ", value, " is out of bounds for dimension 0 with size ", size);
+        }
+        AT_ERROR("index_select(): index ", value, " is out of range for dimension 0 with size ", size);
+      }
+      if (value < 0) {
+        value += size;
+      }
+      if (row_bytes > 0) {
+        std::memcpy(dst + i * row_bytes, src + value * row_bytes, row_bytes);
+      }
+    }
+  });
+}
+
+// self[index[i]] += source[i] for the rows of contiguous self and source.
+// The indices are stably sorted by destination row and split between threads
+// at row boundaries, so that every row is only updated by one thread, in the
+// order of its indices: the result is the same as the serial one whatever
+// the number of threads.
+void index_add_rows_kernel(Tensor& self, const Tensor& index, const Tensor& source, bool wrap_negative) {
+  int64_t size = self.size(0);
+  int64_t row_size = 1;
+  for (int64_t d = 1; d < self.dim(); d++) {
+    row_size *= self.size(d);
+  }
+  int64_t numel = index.numel();
+  if (numel == 0 || row_size == 0) {
+    return;
+  }
+  // check all the indices before updating anything
+  const int64_t* index_data = index.data<int64_t>();
+  std::vector<int64_t> rows(index_data, index_data + numel);
+  for (auto& value : rows) {
+    if (value >= size || value < (wrap_negative ? -size : 0)) {
+      if (wrap_negative) {
+        AT_INDEX_ERROR("index ", value, " is out of bounds for dimension 0 with size ", size);
+      }
+      AT_ERROR("index_add_(): index ", value, " is out of range for dimension 0 with size ", size);
+    }
+    if (value < 0) {
+      value += size;
+    }
+  }
+
+  AT_DISPATCH_ALL_TYPES_AND2(at::ScalarType::Half, at::ScalarType::Bool, self.scalar_type(), "index_add_cpu", [&] {
+    scalar_t* self_data = self.data<scalar_t>();
+    const scalar_t* source_data = source.data<scalar_t>();
+    auto add_row = [&](int64_t i) {
+      scalar_t* dst = self_data + rows[i] * row_size;
+      const scalar_t* src = source_data + i * row_size;
+      for (int64_t j = 0; j < row_size; j++) {
+        dst[j] += src[j];
+      }
+    };
+    if (numel * row_size < internal::GRAIN_SIZE || at::get_num_threads() == 1) {
+      for (int64_t i = 0; i < numel; i++) {
+        add_row(i);
+      }
+      return;
+    }
+
+    std::vector<int64_t> order(numel);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+      return rows[a] < rows[b];
+    });
+    auto same_row = [&](int64_t k) {
+      return rows[order[k]] == rows[order[k - 1]];
+    };
+    int64_t grain_size = std::max<int64_t>(internal::GRAIN_SIZE / row_size, 1);
+    parallel_for(0, numel, grain_size, [&](int64_t begin, int64_t end) {
+      // a row belongs to the range in which its first index is
+      while (begin > 0 && begin < numel && same_row(begin)) {
+        begin++;
+      }
+      while (end < numel && same_row(end)) {
+        end++;
+      }
+      for (int64_t k = begin; k < end; k++) {
+        add_row(order[k]);
+      }
+    });
+  });
+}
+
+template <typename scalar_t>
+inline void gather_row(scalar_t* dst, const scalar_t* src, const int64_t* index, int64_t n) {
+  for (int64_t i = 0; i < n; i++) {
+    dst[i] = src[index[i]];
+  }
+}
+
+#if defined(__AVX2__) && !defined(_MSC_VER)
+template <>
+inline void gather_row<float>(float* dst, const float* src, const int64_t* index, int64_t n) {
+  int64_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i vindex = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index + i));
+    _mm_storeu_ps(dst + i, _mm256_i64gather_ps(src, vindex, sizeof(float)));
+  }
+  for (; i < n; i++) {
+    dst[i] = src[index[i]];
+  }
+}
+
+template <>
+inline void gather_row<double>(double* dst, const double* src, const int64_t* index, int64_t n) {
+  int64_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i vindex = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index + i));
+    _mm256_storeu_pd(dst + i, _mm256_i64gather_pd(src, vindex, sizeof(double)));
+  }
+  for (; i < n; i++) {
+    dst[i] = src[index[i]];
+  }
+}
+#endif
+
+static void check_lastdim_indices(const int64_t* index, int64_t n, int64_t size, const char* name) {
+  for (int64_t i = 0; i < n; i++) {
+    if (index[i] < 0 || index[i] >= size) {
+      AT_ERROR("Invalid index in ", name, ": index ", index[i],
+               " is out of bounds for the last dimension with size ", size);
+    }
+  }
+}
+
+// gather along the last dimension of contiguous tensors, parallelized over the
+// rows; the rows of index and result may be shorter than the rows of self.
+void gather_lastdim_kernel(Tensor& result, const Tensor& self, const Tensor& index) {
+  int64_t self_row = self.size(-1);
+  int64_t index_row = index.size(-1);
+  int64_t num_rows = index.numel() / index_row;
+  int64_t grain_size = std::max<int64_t>(internal::GRAIN_SIZE / index_row, 1);
+  AT_DISPATCH_ALL_TYPES_AND2(at::ScalarType::Half, at::ScalarType::Bool, self.scalar_type(), "gather_cpu", [&] {
+    const scalar_t* self_data = self.data<scalar_t>();
+    const int64_t* index_data = index.data<int64_t>();
+    scalar_t* result_data = result.data<scalar_t>();
+    parallel_for(0, num_rows, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t r = begin; r < end; r++) {
+        const int64_t* row_index = index_data + r * index_row;
+        check_lastdim_indices(row_index, index_row, self_row, "gather");
+        gather_row(result_data + r * index_row, self_data + r * self_row, row_index, index_row);
+      }
+    });
+  });
+}
+
+// scatter_/scatter_add_ along the last dimension of contiguous tensors. Each
+// row only writes to its own row of self, so the rows can be processed in
+// parallel even when accumulating.
+void scatter_lastdim_kernel(Tensor& self, const Tensor& index, const Tensor& src, bool accumulate) {
+  int64_t self_row = self.size(-1);
+  int64_t index_row = index.size(-1);
+  int64_t src_row = src.size(-1);
+  int64_t num_rows = index.numel() / index_row;
+  int64_t grain_size = std::max<int64_t>(internal::GRAIN_SIZE / index_row, 1);
+  AT_DISPATCH_ALL_TYPES_AND2(at::ScalarType::Half, at::ScalarType::Bool, self.scalar_type(), "scatter_cpu", [&] {
+    scalar_t* self_data = self.data<scalar_t>();
+    const int64_t* index_data = index.data<int64_t>();
+    const scalar_t* src_data = src.data<scalar_t>();
+    parallel_for(0, num_rows, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t r = begin; r < end; r++) {
+        const int64_t* row_index = index_data + r * index_row;
+        scalar_t* self_row_data = self_data + r * self_row;
+        const scalar_t* src_row_data = src_data + r * src_row;
+        check_lastdim_indices(row_index, index_row, self_row, accumulate ? "scatter_add" : "scatter");
+        if (accumulate) {
+          for (int64_t i = 0; i < index_row; i++) {
+            self_row_data[row_index[i]] += src_row_data[i];
+          }
+        } else {
+          for (int64_t i = 0; i < index_row; i++) {
+            self_row_data[row_index[i]] = src_row_data[i];
+          }
+        }
+      }
+    });
+  });
+}
+
 } // anonymous namespace
 
 
 REGISTER_DISPATCH(index_stub, &index_kernel);
 REGISTER_DISPATCH(index_put_stub, &index_put_kernel);
+REGISTER_DISPATCH(index_select_rows_stub, &index_select_rows_kernel);
+REGISTER_DISPATCH(index_add_rows_stub, &index_add_rows_kernel);
+REGISTER_DISPATCH(gather_lastdim_stub, &gather_lastdim_kernel);
+REGISTER_DISPATCH(scatter_lastdim_stub, &scatter_lastdim_kernel);
 
 }} // namespace at::native
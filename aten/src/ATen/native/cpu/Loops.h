@@ -3,7 +3,7 @@
 #include <stdint.h>
 #include <ATen/detail/FunctionTraits.h>
 #include <ATen/native/TensorIterator.h>
-#include <ATen/cpu/vec256/vec256.h>
+#include <ATen/cpu/vec512/vec512.h>
 
 namespace at { namespace native { namespace {
 
@@ -65,7 +65,7 @@ static inline bool is_reduction(char** data, const int64_t* strides) {
 #define UNARY_VEC_HEADER(func_t) \
   using traits = unary_function_traits<func_t>; \
   using scalar_t = typename traits::result_type; \
-  using Vec = Vec256<scalar_t>;
+  using Vec = Vectorized<scalar_t>;
 
 #define UNARY_VEC_LOOP_HEADER(func_t, data) \
   UNARY_VEC_HEADER(func_t) \
@@ -85,7 +85,7 @@ static inline bool is_reduction(char** data, const int64_t* strides) {
 #define VEC_HEADER(func_t) \
   using traits = binary_function_traits<func_t>; \
   using scalar_t = typename traits::result_type; \
-  using Vec = Vec256<scalar_t>;
+  using Vec = Vectorized<scalar_t>;
 
 #define VEC_LOOP_HEADER(func_t, data) \
   VEC_HEADER(func_t) \
@@ -252,15 +252,31 @@ template <typename func_t, typename vec_func_t>
 static inline void vectorized_outer_reduction(char** data, int64_t inner_stride, int64_t size0, int64_t size1, func_t op, vec_func_t vop) {
   VEC_HEADER(func_t)
 
-  // reduce down each column of 4 * Vec::size() elements (128 bytes)
-  int64_t outer_stride[2] = { 128, 128 };
+  // reduce down each column of 4 * Vec::size() elements (128 bytes, or 256
+  // bytes with AVX512)
+  int64_t vector_stride = 4 * Vec::size() * sizeof(scalar_t);
+  int64_t outer_stride[2] = { vector_stride, vector_stride };
   UNARY_OUTER_LOOP(data, outer_stride, size1 / (4 * Vec::size()), [&] {
     reduction128(data, size0, inner_stride, op, vop, /*reduce=*/false);
   });
 
-  // reduce down the remaining columns
-  int64_t step[] = { sizeof(scalar_t), sizeof(scalar_t) };
+  // reduce down the remaining columns one vector at a time, which covers
+  // reductions into fewer than 4 * Vec::size() outputs
   int64_t remaining = size1 % (4 * Vec::size());
+  int64_t vec_step[] = { Vec::size() * sizeof(scalar_t), Vec::size() * sizeof(scalar_t) };
+  UNARY_OUTER_LOOP(data, vec_step, remaining / Vec::size(), [&] {
+    const char* in_ptr = data[1];
+    Vec acc = Vec::loadu(in_ptr);
+    for (int64_t i = 1; i < size0; i++) {
+      acc = vop(acc, Vec::loadu(in_ptr + inner_stride * i));
+    }
+    acc = vop(acc, Vec::loadu(data[0]));
+    acc.store(data[0]);
+  });
+
+  // and the last ones one at a time
+  int64_t step[] = { sizeof(scalar_t), sizeof(scalar_t) };
+  remaining = remaining % Vec::size();
   UNARY_OUTER_LOOP(data, step, remaining, [&] {
     char* ptrs[3] = { data[0], data[0], data[1] };
     int64_t strides[] = { 0, 0, inner_stride };
@@ -268,8 +284,10 @@ static inline void vectorized_outer_reduction(char** data, int64_t inner_stride,
   });
 }
 
+// The kernels below run in parallel chunks of at::grain_size(cost) elements,
+// `cost` being how much work op does per element.
 template <typename func_t>
-void unary_kernel(TensorIterator& iter, func_t op) {
+void unary_kernel(TensorIterator& iter, func_t op, LoopCost cost = LoopCost::Default) {
   using traits = unary_function_traits<func_t>;
 
   iter.for_each([&](int ntensor, char** data, const int64_t* strides, int64_t n) {
@@ -281,11 +299,11 @@ void unary_kernel(TensorIterator& iter, func_t op) {
     } else {
       unary_loop(data, strides, 0, n, op);
     }
-  });
+  }, cost);
 }
 
 template <typename func_t, typename vec_func_t>
-void unary_kernel_vec(TensorIterator& iter, func_t op, vec_func_t vop) {
+void unary_kernel_vec(TensorIterator& iter, func_t op, vec_func_t vop, LoopCost cost = LoopCost::Default) {
   using traits = unary_function_traits<func_t>;
   static_assert(
     std::is_same<typename traits::result_type, typename traits::arg1_t>::value,
@@ -300,11 +318,11 @@ void unary_kernel_vec(TensorIterator& iter, func_t op, vec_func_t vop) {
         } else {
           unary_loop(data, strides, 0, n, op);
         }
-      });
+      }, cost);
 }
 
 template <typename func_t>
-void binary_kernel(TensorIterator& iter, func_t op) {
+void binary_kernel(TensorIterator& iter, func_t op, LoopCost cost = LoopCost::Default) {
   using traits = binary_function_traits<func_t>;
 
   iter.for_each([&](int ntensor, char** data, const int64_t* strides, int64_t n) {
@@ -318,11 +336,11 @@ void binary_kernel(TensorIterator& iter, func_t op) {
     } else {
       binary_loop(data, strides, 0, n, op);
     }
-  });
+  }, cost);
 }
 
 template <typename func_t, typename vec_func_t>
-void binary_kernel_vec(TensorIterator& iter, func_t op, vec_func_t vop) {
+void binary_kernel_vec(TensorIterator& iter, func_t op, vec_func_t vop, LoopCost cost = LoopCost::Default) {
   using traits = binary_function_traits<func_t>;
   static_assert(
     std::is_same<typename traits::result_type, typename traits::arg1_t>::value,
@@ -341,7 +359,7 @@ void binary_kernel_vec(TensorIterator& iter, func_t op, vec_func_t vop) {
     } else {
       binary_loop(data, strides, 0, n, op);
     }
-  });
+  }, cost);
 }
 
 }}}  // namespace at::native::<anonymous>
@@ -0,0 +1,837 @@
+#include <ATen/native/Normalization.h>
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec256/vec256.h>
+
+namespace at { namespace native { namespace {
+
+using namespace vec256;
+
+// Mean and biased variance of the n elements of X in one pass. Every lane of
+// a vector runs Welford's algorithm over its own strided part of X, and the
+// lanes are merged with the parallel form of the update.
+template <typename T>
+std::pair<T, T> RowwiseMoments(const T* X, int64_t n) {
+  using Vec = Vec256<T>;
+  constexpr int64_t K = Vec::size();
+  const int64_t m = n / K;
+  Vec mean_vec(T(0));
+  Vec m2_vec(T(0));
+  for (int64_t i = 0; i < m; i++) {
+    Vec x = Vec::loadu(X + i * K);
+    Vec delta = x - mean_vec;
+    mean_vec = mean_vec + delta * Vec(T(1) / T(i + 1));
+    m2_vec = m2_vec + delta * (x - mean_vec);
+  }
+  int64_t count = 0;
+  T mean = 0;
+  T m2 = 0;
+  if (m > 0) {
+    T mean_arr[K];
+    T m2_arr[K];
+    mean_vec.store(mean_arr);
+    m2_vec.store(m2_arr);
+    for (int64_t k = 0; k < K; k++) {
+      int64_t new_count = count + m;
+      T delta = mean_arr[k] - mean;
+      T ratio = T(m) / T(new_count);
+      mean += delta * ratio;
+      m2 += m2_arr[k] + delta * delta * T(count) * ratio;
+      count = new_count;
+    }
+  }
+  for (int64_t i = m * K; i < n; i++) {
+    count++;
+    T delta = X[i] - mean;
+    mean += delta / T(count);
+    m2 += delta * (X[i] - mean);
+  }
+  return std::make_pair(mean, n > 0 ? m2 / T(n) : T(0));
+}
+
+template <typename T>
+T ComputeRstd(T var, T eps) {
+  return T(1) / std::sqrt(std::max(var, T(0)) + eps);
+}
+
+// Returns (sum(dY * X), sum(dY)) over n elements
+template <typename T>
+std::pair<T, T> RowwiseInternalGradients(const T* dY, const T* X, int64_t n) {
+  using Vec = Vec256<T>;
+  constexpr int64_t K = Vec::size();
+  Vec ds_vec(T(0));
+  Vec db_vec(T(0));
+  int64_t i = 0;
+  for (; i + K <= n; i += K) {
+    Vec dy = Vec::loadu(dY + i);
+    ds_vec = ds_vec + dy * Vec::loadu(X + i);
+    db_vec = db_vec + dy;
+  }
+  T ds_arr[K];
+  T db_arr[K];
+  ds_vec.store(ds_arr);
+  db_vec.store(db_arr);
+  T ds = 0;
+  T db = 0;
+  for (int64_t k = 0; k < K; k++) {
+    ds += ds_arr[k];
+    db += db_arr[k];
+  }
+  for (; i < n; i++) {
+    ds += dY[i] * X[i];
+    db += dY[i];
+  }
+  return std::make_pair(ds, db);
+}
+
+// Y = X * scale + bias over n elements
+template <typename T>
+void ApplyScaleBias(const T* X, T scale, T bias, int64_t n, T* Y) {
+  using Vec = Vec256<T>;
+  const Vec scale_vec(scale);
+  const Vec bias_vec(bias);
+  int64_t i = 0;
+  for (; i + Vec::size() <= n; i += Vec::size()) {
+    (Vec::loadu(X + i) * scale_vec + bias_vec).store(Y + i);
+  }
+  for (; i < n; i++) {
+    Y[i] = X[i] * scale + bias;
+  }
+}
+
+// Merges the moments (count_b, mean_b, m2_b) of a part of the elements into
+// (count, mean, m2), m2 being the sum of the squared differences to the mean.
+template <typename T>
+void CombineMoments(
+    int64_t count_b, T mean_b, T m2_b, int64_t* count, T* mean, T* m2) {
+  if (count_b == 0) {
+    return;
+  }
+  const int64_t new_count = *count + count_b;
+  const T delta = mean_b - *mean;
+  const T ratio = T(count_b) / T(new_count);
+  *mean += delta * ratio;
+  *m2 += m2_b + delta * delta * T(*count) * ratio;
+  *count = new_count;
+}
+
+// Returns (sum(dY * (X - mean)), sum(dY)) over n elements
+template <typename T>
+std::pair<T, T> RowwiseCenteredGradients(
+    const T* dY, const T* X, T mean, int64_t n) {
+  using Vec = Vec256<T>;
+  constexpr int64_t K = Vec::size();
+  const Vec mean_vec(mean);
+  Vec dot_vec(T(0));
+  Vec sum_vec(T(0));
+  int64_t i = 0;
+  for (; i + K <= n; i += K) {
+    Vec dy = Vec::loadu(dY + i);
+    dot_vec = dot_vec + dy * (Vec::loadu(X + i) - mean_vec);
+    sum_vec = sum_vec + dy;
+  }
+  T dot_arr[K];
+  T sum_arr[K];
+  dot_vec.store(dot_arr);
+  sum_vec.store(sum_arr);
+  T dot = 0;
+  T sum = 0;
+  for (int64_t k = 0; k < K; k++) {
+    dot += dot_arr[k];
+    sum += sum_arr[k];
+  }
+  for (; i < n; i++) {
+    dot += dY[i] * (X[i] - mean);
+    sum += dY[i];
+  }
+  return std::make_pair(dot, sum);
+}
+
+// The batch norm kernels of a contiguous [N, C, HxW] X split the HxW
+// elements of every sample of a channel into segments, so that there are
+// enough of them to keep every thread busy when N * C is small, e.g. a
+// batch of a few large images with few channels.
+int64_t BatchNormSegmentSize(int64_t N, int64_t C, int64_t HxW) {
+  constexpr int64_t kMinSegmentSize = 4096;
+  const int64_t rows = std::max<int64_t>(N * C, 1);
+  const int64_t segments = std::max<int64_t>(
+      std::min(
+          divup(4 * at::get_num_threads(), rows),
+          divup(HxW, kMinSegmentSize)),
+      1);
+  return std::max<int64_t>(divup(HxW, segments), 1);
+}
+
+// The kernels of a channels last X split its N * HxW rows into at most a few
+// blocks per thread, each of which accumulates all the channels of its rows
+// into its own buffer.
+int64_t BatchNormNumBlocks(int64_t M, int64_t C) {
+  return std::max<int64_t>(
+      std::min<int64_t>(
+          {M,
+           divup(M * C, internal::GRAIN_SIZE),
+           4 * static_cast<int64_t>(at::get_num_threads())}),
+      1);
+}
+
+template <typename T>
+void BatchNormCollectStatsContiguous(
+    const T* X, int64_t N, int64_t C, int64_t HxW, T* mean, T* var) {
+  const int64_t segment_size = BatchNormSegmentSize(N, C, HxW);
+  const int64_t segments = divup(HxW, segment_size);
+  const int64_t items = N * C * segments;
+  std::vector<T> item_mean(items);
+  std::vector<T> item_m2(items);
+  parallel_for(0, items, std::max<int64_t>(internal::GRAIN_SIZE / segment_size, 1), [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      const int64_t offset = (i % segments) * segment_size;
+      const int64_t n = std::min(segment_size, HxW - offset);
+      auto moments = RowwiseMoments(X + (i / segments) * HxW + offset, n);
+      item_mean[i] = moments.first;
+      item_m2[i] = moments.second * T(n);
+    }
+  });
+  parallel_for(0, C, std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(N * segments, 1), 1), [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      int64_t count = 0;
+      T mean_val = 0;
+      T m2 = 0;
+      for (int64_t n = 0; n < N; n++) {
+        for (int64_t s = 0; s < segments; s++) {
+          const int64_t i = (n * C + c) * segments + s;
+          const int64_t size = std::min(segment_size, HxW - s * segment_size);
+          CombineMoments(size, item_mean[i], item_m2[i], &count, &mean_val, &m2);
+        }
+      }
+      mean[c] = mean_val;
+      var[c] = count > 0 ? m2 / T(count) : T(0);
+    }
+  });
+}
+
+// Every block runs Welford's algorithm over its rows for all the channels at
+// once: the count is the same for every channel, so the update vectorizes
+// along the channels.
+template <typename T>
+void BatchNormCollectStatsChannelsLast(
+    const T* X, int64_t M, int64_t C, T* mean, T* var) {
+  using Vec = Vec256<T>;
+  constexpr int64_t K = Vec::size();
+  const int64_t num_blocks = BatchNormNumBlocks(M, C);
+  const int64_t block_size = divup(M, num_blocks);
+  std::vector<T> block_mean(num_blocks * C, T(0));
+  std::vector<T> block_m2(num_blocks * C, T(0));
+  parallel_for(0, num_blocks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; b++) {
+      T* mean_ptr = block_mean.data() + b * C;
+      T* m2_ptr = block_m2.data() + b * C;
+      const int64_t row_begin = b * block_size;
+      const int64_t row_end = std::min(M, row_begin + block_size);
+      for (int64_t r = row_begin; r < row_end; r++) {
+        const T* X_ptr = X + r * C;
+        const T ratio = T(1) / T(r - row_begin + 1);
+        const Vec ratio_vec(ratio);
+        int64_t c = 0;
+        for (; c + K <= C; c += K) {
+          Vec x = Vec::loadu(X_ptr + c);
+          Vec mean_vec = Vec::loadu(mean_ptr + c);
+          Vec delta = x - mean_vec;
+          mean_vec = mean_vec + delta * ratio_vec;
+          (Vec::loadu(m2_ptr + c) + delta * (x - mean_vec)).store(m2_ptr + c);
+          mean_vec.store(mean_ptr + c);
+        }
+        for (; c < C; c++) {
+          const T delta = X_ptr[c] - mean_ptr[c];
+          mean_ptr[c] += delta * ratio;
+          m2_ptr[c] += delta * (X_ptr[c] - mean_ptr[c]);
+        }
+      }
+    }
+  });
+  for (int64_t c = 0; c < C; c++) {
+    int64_t count = 0;
+    T mean_val = 0;
+    T m2 = 0;
+    for (int64_t b = 0; b < num_blocks; b++) {
+      const int64_t size = std::max<int64_t>(
+          std::min(M, (b + 1) * block_size) - b * block_size, 0);
+      CombineMoments(size, block_mean[b * C + c], block_m2[b * C + c], &count, &mean_val, &m2);
+    }
+    mean[c] = mean_val;
+    var[c] = count > 0 ? m2 / T(count) : T(0);
+  }
+}
+
+void BatchNormCollectStatsKernelImpl(
+    const Tensor& X, int64_t N, int64_t C, int64_t HxW, bool channels_last,
+    Tensor& mean, Tensor& var) {
+  AT_DISPATCH_FLOATING_TYPES(X.scalar_type(), "batch_norm_collect_stats_cpu", [&] {
+    if (channels_last) {
+      BatchNormCollectStatsChannelsLast<scalar_t>(
+          X.data<scalar_t>(), N * HxW, C, mean.data<scalar_t>(), var.data<scalar_t>());
+    } else {
+      BatchNormCollectStatsContiguous<scalar_t>(
+          X.data<scalar_t>(), N, C, HxW, mean.data<scalar_t>(), var.data<scalar_t>());
+    }
+  });
+}
+
+template <typename T>
+void BatchNormTransformInternal(
+    const T* X, const T* alpha, const T* beta, int64_t N, int64_t C,
+    int64_t HxW, bool channels_last, T* Y) {
+  using Vec = Vec256<T>;
+  if (channels_last) {
+    const int64_t M = N * HxW;
+    parallel_for(0, M, std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(C, 1), 1), [&](int64_t begin, int64_t end) {
+      for (int64_t r = begin; r < end; r++) {
+        const T* X_ptr = X + r * C;
+        T* Y_ptr = Y + r * C;
+        int64_t c = 0;
+        for (; c + Vec::size() <= C; c += Vec::size()) {
+          Vec y = Vec::loadu(X_ptr + c) * Vec::loadu(alpha + c) + Vec::loadu(beta + c);
+          y.store(Y_ptr + c);
+        }
+        for (; c < C; c++) {
+          Y_ptr[c] = X_ptr[c] * alpha[c] + beta[c];
+        }
+      }
+    });
+    return;
+  }
+  // the range of a thread may start and end in the middle of a channel
+  parallel_for(0, N * C * HxW, internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end;) {
+      const int64_t c = (i / HxW) % C;
+      const int64_t n = std::min(HxW - i % HxW, end - i);
+      ApplyScaleBias(X + i, alpha[c], beta[c], n, Y + i);
+      i += n;
+    }
+  });
+}
+
+void BatchNormTransformKernelImpl(
+    const Tensor& X, const Tensor& alpha, const Tensor& beta, int64_t N,
+    int64_t C, int64_t HxW, bool channels_last, Tensor& Y) {
+  AT_DISPATCH_FLOATING_TYPES(X.scalar_type(), "batch_norm_transform_cpu", [&] {
+    BatchNormTransformInternal<scalar_t>(
+        X.data<scalar_t>(), alpha.data<scalar_t>(), beta.data<scalar_t>(), N,
+        C, HxW, channels_last, Y.data<scalar_t>());
+  });
+}
+
+template <typename T>
+void BatchNormBackwardReduceContiguous(
+    const T* dY, const T* X, const T* mean, int64_t N, int64_t C,
+    int64_t HxW, T* sum_dy, T* sum_dy_xmu) {
+  const int64_t segment_size = BatchNormSegmentSize(N, C, HxW);
+  const int64_t segments = divup(HxW, segment_size);
+  const int64_t items = N * C * segments;
+  std::vector<T> item_dot(items);
+  std::vector<T> item_sum(items);
+  parallel_for(0, items, std::max<int64_t>(internal::GRAIN_SIZE / segment_size, 1), [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      const int64_t row = i / segments;
+      const int64_t offset = row * HxW + (i % segments) * segment_size;
+      const int64_t n = std::min(segment_size, (row + 1) * HxW - offset);
+      std::tie(item_dot[i], item_sum[i]) = RowwiseCenteredGradients(dY + offset, X + offset, mean[row % C], n);
+    }
+  });
+  for (int64_t c = 0; c < C; c++) {
+    T dot = 0;
+    T sum = 0;
+    for (int64_t n = 0; n < N; n++) {
+      for (int64_t s = 0; s < segments; s++) {
+        const int64_t i = (n * C + c) * segments + s;
+        dot += item_dot[i];
+        sum += item_sum[i];
+      }
+    }
+    sum_dy[c] = sum;
+    sum_dy_xmu[c] = dot;
+  }
+}
+
+template <typename T>
+void BatchNormBackwardReduceChannelsLast(
+    const T* dY, const T* X, const T* mean, int64_t M, int64_t C,
+    T* sum_dy, T* sum_dy_xmu) {
+  using Vec = Vec256<T>;
+  constexpr int64_t K = Vec::size();
+  const int64_t num_blocks = BatchNormNumBlocks(M, C);
+  const int64_t block_size = divup(M, num_blocks);
+  std::vector<T> block_sum(num_blocks * C, T(0));
+  std::vector<T> block_dot(num_blocks * C, T(0));
+  parallel_for(0, num_blocks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; b++) {
+      T* sum_ptr = block_sum.data() + b * C;
+      T* dot_ptr = block_dot.data() + b * C;
+      const int64_t row_end = std::min(M, (b + 1) * block_size);
+      for (int64_t r = b * block_size; r < row_end; r++) {
+        const T* dY_ptr = dY + r * C;
+        const T* X_ptr = X + r * C;
+        int64_t c = 0;
+        for (; c + K <= C; c += K) {
+          Vec dy = Vec::loadu(dY_ptr + c);
+          (Vec::loadu(sum_ptr + c) + dy).store(sum_ptr + c);
+          Vec dot = Vec::loadu(dot_ptr + c) + dy * (Vec::loadu(X_ptr + c) - Vec::loadu(mean + c));
+          dot.store(dot_ptr + c);
+        }
+        for (; c < C; c++) {
+          sum_ptr[c] += dY_ptr[c];
+          dot_ptr[c] += dY_ptr[c] * (X_ptr[c] - mean[c]);
+        }
+      }
+    }
+  });
+  for (int64_t c = 0; c < C; c++) {
+    T dot = 0;
+    T sum = 0;
+    for (int64_t b = 0; b < num_blocks; b++) {
+      dot += block_dot[b * C + c];
+      sum += block_sum[b * C + c];
+    }
+    sum_dy[c] = sum;
+    sum_dy_xmu[c] = dot;
+  }
+}
+
+void BatchNormBackwardReduceKernelImpl(
+    const Tensor& dY, const Tensor& X, const Tensor& mean, int64_t N,
+    int64_t C, int64_t HxW, bool channels_last, Tensor& sum_dy,
+    Tensor& sum_dy_xmu) {
+  AT_DISPATCH_FLOATING_TYPES(X.scalar_type(), "batch_norm_backward_reduce_cpu", [&] {
+    if (channels_last) {
+      BatchNormBackwardReduceChannelsLast<scalar_t>(
+          dY.data<scalar_t>(), X.data<scalar_t>(), mean.data<scalar_t>(),
+          N * HxW, C, sum_dy.data<scalar_t>(), sum_dy_xmu.data<scalar_t>());
+    } else {
+      BatchNormBackwardReduceContiguous<scalar_t>(
+          dY.data<scalar_t>(), X.data<scalar_t>(), mean.data<scalar_t>(), N,
+          C, HxW, sum_dy.data<scalar_t>(), sum_dy_xmu.data<scalar_t>());
+    }
+  });
+}
+
+template <typename T>
+void BatchNormBackwardElemtInternal(
+    const T* dY, const T* X, const T* a, const T* b, const T* c, int64_t N,
+    int64_t C, int64_t HxW, bool channels_last, T* dX) {
+  using Vec = Vec256<T>;
+  constexpr int64_t K = Vec::size();
+  if (channels_last) {
+    const int64_t M = N * HxW;
+    parallel_for(0, M, std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(C, 1), 1), [&](int64_t begin, int64_t end) {
+      for (int64_t r = begin; r < end; r++) {
+        const int64_t offset = r * C;
+        int64_t j = 0;
+        for (; j + K <= C; j += K) {
+          Vec dx = Vec::loadu(dY + offset + j) * Vec::loadu(a + j) +
+              Vec::loadu(X + offset + j) * Vec::loadu(b + j) + Vec::loadu(c + j);
+          dx.store(dX + offset + j);
+        }
+        for (; j < C; j++) {
+          dX[offset + j] = dY[offset + j] * a[j] + X[offset + j] * b[j] + c[j];
+        }
+      }
+    });
+    return;
+  }
+  parallel_for(0, N * C * HxW, internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end;) {
+      const int64_t channel = (i / HxW) % C;
+      const int64_t n = std::min(HxW - i % HxW, end - i);
+      const Vec a_vec(a[channel]);
+      const Vec b_vec(b[channel]);
+      const Vec c_vec(c[channel]);
+      int64_t j = 0;
+      for (; j + K <= n; j += K) {
+        Vec dx = Vec::loadu(dY + i + j) * a_vec + Vec::loadu(X + i + j) * b_vec + c_vec;
+        dx.store(dX + i + j);
+      }
+      for (; j < n; j++) {
+        dX[i + j] = dY[i + j] * a[channel] + X[i + j] * b[channel] + c[channel];
+      }
+      i += n;
+    }
+  });
+}
+
+void BatchNormBackwardElemtKernelImpl(
+    const Tensor& dY, const Tensor& X, const Tensor& a, const Tensor& b,
+    const Tensor& c, int64_t N, int64_t C, int64_t HxW, bool channels_last,
+    Tensor& dX) {
+  AT_DISPATCH_FLOATING_TYPES(X.scalar_type(), "batch_norm_backward_elemt_cpu", [&] {
+    BatchNormBackwardElemtInternal<scalar_t>(
+        dY.data<scalar_t>(), X.data<scalar_t>(), a.data<scalar_t>(),
+        b.data<scalar_t>(), c.data<scalar_t>(), N, C, HxW, channels_last,
+        dX.data<scalar_t>());
+  });
+}
+
+template <typename T>
+void LayerNormKernelImplInternal(
+    const Tensor& X, const Tensor& gamma, const Tensor& beta, int64_t M,
+    int64_t N, T eps, Tensor& Y, Tensor& mean, Tensor& rstd) {
+  using Vec = Vec256<T>;
+  const T* X_data = X.data<T>();
+  const T* gamma_data = gamma.defined() ? gamma.data<T>() : nullptr;
+  const T* beta_data = beta.defined() ? beta.data<T>() : nullptr;
+  T* Y_data = Y.data<T>();
+  T* mean_data = mean.data<T>();
+  T* rstd_data = rstd.data<T>();
+  int64_t grain_size = std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(N, 1), 1);
+  parallel_for(0, M, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      const T* X_ptr = X_data + i * N;
+      T* Y_ptr = Y_data + i * N;
+      auto moments = RowwiseMoments(X_ptr, N);
+      const T mean_val = moments.first;
+      const T rstd_val = ComputeRstd(moments.second, eps);
+      mean_data[i] = mean_val;
+      rstd_data[i] = rstd_val;
+      const T bias = -mean_val * rstd_val;
+      if (gamma_data == nullptr && beta_data == nullptr) {
+        ApplyScaleBias(X_ptr, rstd_val, bias, N, Y_ptr);
+        continue;
+      }
+      // Y = (X - mean) * rstd * gamma + beta
+      const Vec scale_vec(rstd_val);
+      const Vec bias_vec(bias);
+      int64_t j = 0;
+      for (; j + Vec::size() <= N; j += Vec::size()) {
+        Vec y = Vec::loadu(X_ptr + j) * scale_vec + bias_vec;
+        if (gamma_data != nullptr) {
+          y = y * Vec::loadu(gamma_data + j);
+        }
+        if (beta_data != nullptr) {
+          y = y + Vec::loadu(beta_data + j);
+        }
+        y.store(Y_ptr + j);
+      }
+      for (; j < N; j++) {
+        T y = X_ptr[j] * rstd_val + bias;
+        if (gamma_data != nullptr) {
+          y *= gamma_data[j];
+        }
+        if (beta_data != nullptr) {
+          y += beta_data[j];
+        }
+        Y_ptr[j] = y;
+      }
+    }
+  });
+}
+
+void LayerNormKernelImpl(
+    const Tensor& X, const Tensor& gamma, const Tensor& beta, int64_t M,
+    int64_t N, double eps, Tensor& Y, Tensor& mean, Tensor& rstd) {
+  AT_DISPATCH_FLOATING_TYPES(X.scalar_type(), "layer_norm_cpu", [&] {
+    LayerNormKernelImplInternal<scalar_t>(
+        X, gamma, beta, M, N, static_cast<scalar_t>(eps), Y, mean, rstd);
+  });
+}
+
+// With xhat = (X - mean) * rstd and dxhat = dY * gamma,
+//   dX = rstd * (dxhat - E[dxhat] - xhat * E[dxhat * xhat])
+//      = rstd * gamma * dY + c1 * X + c2
+// where E is the mean over the normalized elements, and
+//   c1 = (db * mean - ds) * rstd^3 / N, c2 = -c1 * mean - db * rstd / N
+// for ds = sum(dY * gamma * X) and db = sum(dY * gamma).
+template <typename T>
+void LayerNormBackwardKernelImplInternal(
+    const Tensor& dY, const Tensor& X, const Tensor& mean, const Tensor& rstd,
+    const Tensor& gamma, int64_t M, int64_t N, Tensor& dX, Tensor& dgamma,
+    Tensor& dbeta) {
+  using Vec = Vec256<T>;
+  constexpr int64_t K = Vec::size();
+  const T* dY_data = dY.data<T>();
+  const T* X_data = X.data<T>();
+  const T* mean_data = mean.data<T>();
+  const T* rstd_data = rstd.data<T>();
+  const T* gamma_data = gamma.defined() ? gamma.data<T>() : nullptr;
+  T* dX_data = dX.defined() ? dX.data<T>() : nullptr;
+  const T scale = T(1) / T(std::max<int64_t>(N, 1));
+  const bool gamma_beta_grad = dgamma.defined() || dbeta.defined();
+  // every thread sums the gradients of gamma and beta over its rows into its
+  // own part of the buffer
+  const int num_threads = at::get_num_threads();
+  std::vector<T> buffer(gamma_beta_grad ? 2 * num_threads * N : 0, T(0));
+  int64_t grain_size = std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(N, 1), 1);
+  parallel_for(0, M, grain_size, [&](int64_t begin, int64_t end) {
+    T* dgamma_buf = buffer.data() + 2 * at::get_thread_num() * N;
+    T* dbeta_buf = dgamma_buf + N;
+    for (int64_t i = begin; i < end; i++) {
+      const T* dY_ptr = dY_data + i * N;
+      const T* X_ptr = X_data + i * N;
+      const T mean_val = mean_data[i];
+      const T rstd_val = rstd_data[i];
+      if (gamma_beta_grad) {
+        const Vec mean_vec(mean_val);
+        const Vec rstd_vec(rstd_val);
+        int64_t j = 0;
+        for (; j + K <= N; j += K) {
+          Vec dy = Vec::loadu(dY_ptr + j);
+          Vec dg = Vec::loadu(dgamma_buf + j) + dy * (Vec::loadu(X_ptr + j) - mean_vec) * rstd_vec;
+          dg.store(dgamma_buf + j);
+          (Vec::loadu(dbeta_buf + j) + dy).store(dbeta_buf + j);
+        }
+        for (; j < N; j++) {
+          dgamma_buf[j] += dY_ptr[j] * (X_ptr[j] - mean_val) * rstd_val;
+          dbeta_buf[j] += dY_ptr[j];
+        }
+      }
+      if (dX_data == nullptr) {
+        continue;
+      }
+      T* dX_ptr = dX_data + i * N;
+      T ds = 0;
+      T db = 0;
+      if (gamma_data == nullptr) {
+        std::tie(ds, db) = RowwiseInternalGradients(dY_ptr, X_ptr, N);
+      } else {
+        Vec ds_vec(T(0));
+        Vec db_vec(T(0));
+        int64_t j = 0;
+        for (; j + K <= N; j += K) {
+          Vec dxhat = Vec::loadu(dY_ptr + j) * Vec::loadu(gamma_data + j);
+          ds_vec = ds_vec + dxhat * Vec::loadu(X_ptr + j);
+          db_vec = db_vec + dxhat;
+        }
+        T ds_arr[K];
+        T db_arr[K];
+        ds_vec.store(ds_arr);
+        db_vec.store(db_arr);
+        for (int64_t k = 0; k < K; k++) {
+          ds += ds_arr[k];
+          db += db_arr[k];
+        }
+        for (; j < N; j++) {
+          T dxhat = dY_ptr[j] * gamma_data[j];
+          ds += dxhat * X_ptr[j];
+          db += dxhat;
+        }
+      }
+      const T c1 = (db * mean_val - ds) * rstd_val * rstd_val * rstd_val * scale;
+      const T c2 = -c1 * mean_val - db * rstd_val * scale;
+      if (gamma_data == nullptr) {
+        // dX = rstd * dY + c1 * X + c2
+        const Vec rstd_vec(rstd_val);
+        const Vec c1_vec(c1);
+        const Vec c2_vec(c2);
+        int64_t j = 0;
+        for (; j + K <= N; j += K) {
+          Vec dx = rstd_vec * Vec::loadu(dY_ptr + j) + c1_vec * Vec::loadu(X_ptr + j) + c2_vec;
+          dx.store(dX_ptr + j);
+        }
+        for (; j < N; j++) {
+          dX_ptr[j] = rstd_val * dY_ptr[j] + c1 * X_ptr[j] + c2;
+        }
+      } else {
+        const Vec rstd_vec(rstd_val);
+        const Vec c1_vec(c1);
+        const Vec c2_vec(c2);
+        int64_t j = 0;
+        for (; j + K <= N; j += K) {
+          Vec dx = rstd_vec * Vec::loadu(gamma_data + j) * Vec::loadu(dY_ptr + j) +
+              c1_vec * Vec::loadu(X_ptr + j) + c2_vec;
+          dx.store(dX_ptr + j);
+        }
+        for (; j < N; j++) {
+          dX_ptr[j] = rstd_val * gamma_data[j] * dY_ptr[j] + c1 * X_ptr[j] + c2;
+        }
+      }
+    }
+  });
+
+  if (gamma_beta_grad) {
+    T* dgamma_data = dgamma.defined() ? dgamma.data<T>() : nullptr;
+    T* dbeta_data = dbeta.defined() ? dbeta.data<T>() : nullptr;
+    parallel_for(0, N, internal::GRAIN_SIZE / std::max(num_threads, 1), [&](int64_t begin, int64_t end) {
+      for (int64_t j = begin; j < end; j++) {
+        T dg = 0;
+        T db = 0;
+        for (int t = 0; t < num_threads; t++) {
+          dg += buffer[2 * t * N + j];
+          db += buffer[2 * t * N + N + j];
+        }
+        if (dgamma_data != nullptr) {
+          dgamma_data[j] = dg;
+        }
+        if (dbeta_data != nullptr) {
+          dbeta_data[j] = db;
+        }
+      }
+    });
+  }
+}
+
+void LayerNormBackwardKernelImpl(
+    const Tensor& dY, const Tensor& X, const Tensor& mean, const Tensor& rstd,
+    const Tensor& gamma, int64_t M, int64_t N, Tensor& dX, Tensor& dgamma,
+    Tensor& dbeta) {
+  AT_DISPATCH_FLOATING_TYPES(X.scalar_type(), "layer_norm_backward_cpu", [&] {
+    LayerNormBackwardKernelImplInternal<scalar_t>(
+        dY, X, mean, rstd, gamma, M, N, dX, dgamma, dbeta);
+  });
+}
+
+template <typename T>
+void GroupNormKernelImplInternal(
+    const Tensor& X, const Tensor& gamma, const Tensor& beta, int64_t N,
+    int64_t C, int64_t HxW, int64_t group, T eps, Tensor& Y, Tensor& mean,
+    Tensor& rstd) {
+  const int64_t D = C / group;
+  const T* X_data = X.data<T>();
+  const T* gamma_data = gamma.defined() ? gamma.data<T>() : nullptr;
+  const T* beta_data = beta.defined() ? beta.data<T>() : nullptr;
+  T* Y_data = Y.data<T>();
+  T* mean_data = mean.data<T>();
+  T* rstd_data = rstd.data<T>();
+  int64_t grain_size = std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(D * HxW, 1), 1);
+  parallel_for(0, N * group, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      const T* X_ptr = X_data + i * D * HxW;
+      T* Y_ptr = Y_data + i * D * HxW;
+      auto moments = RowwiseMoments(X_ptr, D * HxW);
+      const T mean_val = moments.first;
+      const T rstd_val = ComputeRstd(moments.second, eps);
+      mean_data[i] = mean_val;
+      rstd_data[i] = rstd_val;
+      const int64_t g = i % group;
+      for (int64_t d = 0; d < D; d++) {
+        const int64_t c = g * D + d;
+        const T scale = rstd_val * (gamma_data == nullptr ? T(1) : gamma_data[c]);
+        const T bias = -scale * mean_val + (beta_data == nullptr ? T(0) : beta_data[c]);
+        ApplyScaleBias(X_ptr + d * HxW, scale, bias, HxW, Y_ptr + d * HxW);
+      }
+    }
+  });
+}
+
+void GroupNormKernelImpl(
+    const Tensor& X, const Tensor& gamma, const Tensor& beta, int64_t N,
+    int64_t C, int64_t HxW, int64_t group, double eps, Tensor& Y,
+    Tensor& mean, Tensor& rstd) {
+  AT_DISPATCH_FLOATING_TYPES(X.scalar_type(), "group_norm_cpu", [&] {
+    GroupNormKernelImplInternal<scalar_t>(
+        X, gamma, beta, N, C, HxW, group, static_cast<scalar_t>(eps), Y,
+        mean, rstd);
+  });
+}
+
+// Same as the layer norm backward, with the sums over the group taken from
+// per channel sums of dY * X and dY.
+template <typename T>
+void GroupNormBackwardKernelImplInternal(
+    const Tensor& dY, const Tensor& X, const Tensor& mean, const Tensor& rstd,
+    const Tensor& gamma, int64_t N, int64_t C, int64_t HxW, int64_t group,
+    Tensor& dX, Tensor& dgamma, Tensor& dbeta) {
+  const int64_t D = C / group;
+  const T* dY_data = dY.data<T>();
+  const T* X_data = X.data<T>();
+  const T* mean_data = mean.data<T>();
+  const T* rstd_data = rstd.data<T>();
+  const T* gamma_data = gamma.defined() ? gamma.data<T>() : nullptr;
+  const T scale = T(1) / T(std::max<int64_t>(D * HxW, 1));
+
+  // sum(dY * X) and sum(dY) of every channel of every sample
+  std::vector<T> ds(N * C);
+  std::vector<T> db(N * C);
+  int64_t grain_size = std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(HxW, 1), 1);
+  parallel_for(0, N * C, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      std::tie(ds[i], db[i]) = RowwiseInternalGradients(dY_data + i * HxW, X_data + i * HxW, HxW);
+    }
+  });
+
+  if (dX.defined()) {
+    T* dX_data = dX.data<T>();
+    grain_size = std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(D * HxW, 1), 1);
+    parallel_for(0, N * group, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        const int64_t g = i % group;
+        const T mean_val = mean_data[i];
+        const T rstd_val = rstd_data[i];
+        T ds_val = 0;
+        T db_val = 0;
+        for (int64_t d = 0; d < D; d++) {
+          const T gamma_val = gamma_data == nullptr ? T(1) : gamma_data[g * D + d];
+          ds_val += ds[i * D + d] * gamma_val;
+          db_val += db[i * D + d] * gamma_val;
+        }
+        const T c1 = (db_val * mean_val - ds_val) * rstd_val * rstd_val * rstd_val * scale;
+        const T c2 = -c1 * mean_val - db_val * rstd_val * scale;
+        for (int64_t d = 0; d < D; d++) {
+          const int64_t offset = (i * D + d) * HxW;
+          const T gamma_val = gamma_data == nullptr ? T(1) : gamma_data[g * D + d];
+          const T c0 = rstd_val * gamma_val;
+          using Vec = Vec256<T>;
+          const Vec c0_vec(c0);
+          const Vec c1_vec(c1);
+          const Vec c2_vec(c2);
+          int64_t j = 0;
+          for (; j + Vec::size() <= HxW; j += Vec::size()) {
+            Vec dx = c0_vec * Vec::loadu(dY_data + offset + j) +
+                c1_vec * Vec::loadu(X_data + offset + j) + c2_vec;
+            dx.store(dX_data + offset + j);
+          }
+          for (; j < HxW; j++) {
+            dX_data[offset + j] = c0 * dY_data[offset + j] + c1 * X_data[offset + j] + c2;
+          }
+        }
+      }
+    });
+  }
+
+  if (dgamma.defined() || dbeta.defined()) {
+    T* dgamma_data = dgamma.defined() ? dgamma.data<T>() : nullptr;
+    T* dbeta_data = dbeta.defined() ? dbeta.data<T>() : nullptr;
+    for (int64_t c = 0; c < C; c++) {
+      const int64_t g = c / D;
+      T dg = 0;
+      T dbeta_val = 0;
+      for (int64_t n = 0; n < N; n++) {
+        const int64_t ng = n * group + g;
+        dg += (ds[n * C + c] - db[n * C + c] * mean_data[ng]) * rstd_data[ng];
+        dbeta_val += db[n * C + c];
+      }
+      if (dgamma_data != nullptr) {
+        dgamma_data[c] = dg;
+      }
+      if (dbeta_data != nullptr) {
+        dbeta_data[c] = dbeta_val;
+      }
+    }
+  }
+}
+
+void GroupNormBackwardKernelImpl(
+    const Tensor& dY, const Tensor& X, const Tensor& mean, const Tensor& rstd,
+    const Tensor& gamma, int64_t N, int64_t C, int64_t HxW, int64_t group,
+    Tensor& dX, Tensor& dgamma, Tensor& dbeta) {
+  AT_DISPATCH_FLOATING_TYPES(X.scalar_type(), "group_norm_backward_cpu", [&] {
+    GroupNormBackwardKernelImplInternal<scalar_t>(
+        dY, X, mean, rstd, gamma, N, C, HxW, group, dX, dgamma, dbeta);
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(batch_norm_collect_stats_stub, &BatchNormCollectStatsKernelImpl);
+REGISTER_DISPATCH(batch_norm_transform_stub, &BatchNormTransformKernelImpl);
+REGISTER_DISPATCH(batch_norm_backward_reduce_stub, &BatchNormBackwardReduceKernelImpl);
+REGISTER_DISPATCH(batch_norm_backward_elemt_stub, &BatchNormBackwardElemtKernelImpl);
+REGISTER_DISPATCH(layer_norm_stub, &LayerNormKernelImpl);
+REGISTER_DISPATCH(layer_norm_backward_stub, &LayerNormBackwardKernelImpl);
+REGISTER_DISPATCH(group_norm_stub, &GroupNormKernelImpl);
+REGISTER_DISPATCH(group_norm_backward_stub, &GroupNormBackwardKernelImpl);
+
+}} // namespace at::native
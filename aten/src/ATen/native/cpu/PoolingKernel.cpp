@@ -0,0 +1,376 @@
+#include <ATen/native/Pool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec256/vec256.h>
+
+namespace at { namespace native { namespace {
+
+using namespace vec256;
+
+// The first and last (exclusive) input positions of the window of output
+// position o of a max pooling, whose positions are begin + i * dilation.
+inline void max_pool_window(
+    int64_t o, int64_t input_size, int64_t kernel, int64_t stride,
+    int64_t padding, int64_t dilation, int64_t& begin, int64_t& end) {
+  begin = o * stride - padding;
+  end = std::min(begin + (kernel - 1) * dilation + 1, input_size);
+  while (begin < 0) {
+    begin += dilation;
+  }
+}
+
+// The window of output position o of an average pooling, clipped to the
+// input, and its size including the padding.
+inline int64_t avg_pool_window(
+    int64_t o, int64_t input_size, int64_t kernel, int64_t stride,
+    int64_t padding, int64_t& begin, int64_t& end) {
+  begin = o * stride - padding;
+  end = std::min(begin + kernel, input_size + padding);
+  const int64_t padded_size = end - begin;
+  begin = std::max<int64_t>(begin, 0);
+  end = std::min(end, input_size);
+  return padded_size;
+}
+
+// The output positions along a dimension whose windows lie within the input.
+inline void inner_outputs(
+    int64_t output_size, int64_t input_size, int64_t extent, int64_t padding,
+    int64_t& begin, int64_t& end) {
+  begin = std::min(padding, output_size);
+  end = std::max(begin, std::min(input_size + padding - extent + 1, output_size));
+}
+
+template <typename scalar_t>
+inline void max_update(scalar_t val, int64_t index, scalar_t& maxval, int64_t& maxindex) {
+  if ((val > maxval) || std::isnan(val)) {
+    maxval = val;
+    maxindex = index;
+  }
+}
+
+// Max pooling of the contiguous planes [begin, end) of the input, with
+// indices: the maxima are tracked one output at a time, as in THNN.
+template <typename scalar_t>
+void max_pool_planes_with_indices(
+    scalar_t* output_data, int64_t* indices_data, const scalar_t* input_data,
+    const PoolingParams& p, int64_t begin, int64_t end) {
+  const int64_t input_plane = p.input_size[0] * p.input_size[1] * p.input_size[2];
+  const int64_t output_plane = p.output_size[0] * p.output_size[1] * p.output_size[2];
+  for (int64_t plane = begin; plane < end; plane++) {
+    const scalar_t* in = input_data + plane * input_plane;
+    scalar_t* out = output_data + plane * output_plane;
+    int64_t* ind = indices_data + plane * output_plane;
+    for (int64_t od = 0; od < p.output_size[0]; od++) {
+      int64_t d0, d1;
+      max_pool_window(od, p.input_size[0], p.kernel[0], p.stride[0], p.padding[0], p.dilation[0], d0, d1);
+      for (int64_t oh = 0; oh < p.output_size[1]; oh++) {
+        int64_t h0, h1;
+        max_pool_window(oh, p.input_size[1], p.kernel[1], p.stride[1], p.padding[1], p.dilation[1], h0, h1);
+        for (int64_t ow = 0; ow < p.output_size[2]; ow++) {
+          int64_t w0, w1;
+          max_pool_window(ow, p.input_size[2], p.kernel[2], p.stride[2], p.padding[2], p.dilation[2], w0, w1);
+          scalar_t maxval = -std::numeric_limits<scalar_t>::infinity();
+          int64_t maxindex = -1;
+          for (int64_t d = d0; d < d1; d += p.dilation[0]) {
+            for (int64_t h = h0; h < h1; h += p.dilation[1]) {
+              for (int64_t w = w0; w < w1; w += p.dilation[2]) {
+                const int64_t index = (d * p.input_size[1] + h) * p.input_size[2] + w;
+                max_update(in[index], index, maxval, maxindex);
+              }
+            }
+          }
+          *out++ = maxval;
+          *ind++ = maxindex;
+        }
+      }
+    }
+  }
+}
+
+// Max pooling of the contiguous planes [begin, end) of the input, without
+// indices. For every output row, the input rows of its window are first
+// reduced into one row with vectorized maxima; the window is then only slid
+// along that row, in vectors of outputs where the stride is 1.
+template <typename scalar_t>
+void max_pool_planes(
+    scalar_t* output_data, const scalar_t* input_data,
+    const PoolingParams& p, int64_t begin, int64_t end) {
+  using Vec = Vec256<scalar_t>;
+  const int64_t input_width = p.input_size[2];
+  const int64_t output_width = p.output_size[2];
+  const int64_t input_plane = p.input_size[0] * p.input_size[1] * input_width;
+  const int64_t output_plane = p.output_size[0] * p.output_size[1] * output_width;
+  const int64_t kernel_w = p.kernel[2];
+  const int64_t dilation_w = p.dilation[2];
+  const scalar_t lowest = -std::numeric_limits<scalar_t>::infinity();
+  int64_t inner_begin = 0, inner_end = 0;
+  if (p.stride[2] == 1) {
+    inner_outputs(output_width, input_width, (kernel_w - 1) * dilation_w + 1,
+                  p.padding[2], inner_begin, inner_end);
+  }
+  std::vector<scalar_t> row(input_width);
+  for (int64_t plane = begin; plane < end; plane++) {
+    const scalar_t* in = input_data + plane * input_plane;
+    scalar_t* out = output_data + plane * output_plane;
+    for (int64_t od = 0; od < p.output_size[0]; od++) {
+      int64_t d0, d1;
+      max_pool_window(od, p.input_size[0], p.kernel[0], p.stride[0], p.padding[0], p.dilation[0], d0, d1);
+      for (int64_t oh = 0; oh < p.output_size[1]; oh++, out += output_width) {
+        int64_t h0, h1;
+        max_pool_window(oh, p.input_size[1], p.kernel[1], p.stride[1], p.padding[1], p.dilation[1], h0, h1);
+        bool first = true;
+        for (int64_t d = d0; d < d1; d += p.dilation[0]) {
+          for (int64_t h = h0; h < h1; h += p.dilation[1]) {
+            const scalar_t* src = in + (d * p.input_size[1] + h) * input_width;
+            if (first) {
+              std::copy(src, src + input_width, row.begin());
+              first = false;
+              continue;
+            }
+            int64_t w = 0;
+            for (; w + Vec::size() <= input_width; w += Vec::size()) {
+              maximum(Vec::loadu(row.data() + w), Vec::loadu(src + w)).store(row.data() + w);
+            }
+            for (; w < input_width; w++) {
+              if ((src[w] > row[w]) || std::isnan(src[w])) {
+                row[w] = src[w];
+              }
+            }
+          }
+        }
+        if (first) {
+          std::fill(row.begin(), row.end(), lowest);
+        }
+
+        int64_t ow = 0;
+        auto scalar_outputs = [&](int64_t ow_end) {
+          for (; ow < ow_end; ow++) {
+            int64_t w0, w1;
+            max_pool_window(ow, input_width, kernel_w, p.stride[2], p.padding[2], dilation_w, w0, w1);
+            scalar_t maxval = lowest;
+            int64_t unused = -1;
+            for (int64_t w = w0; w < w1; w += dilation_w) {
+              max_update(row[w], w, maxval, unused);
+            }
+            out[ow] = maxval;
+          }
+        };
+        scalar_outputs(inner_begin);
+        for (; ow + Vec::size() <= inner_end; ow += Vec::size()) {
+          const scalar_t* src = row.data() + ow - p.padding[2];
+          Vec acc = Vec::loadu(src);
+          for (int64_t k = 1; k < kernel_w; k++) {
+            acc = maximum(acc, Vec::loadu(src + k * dilation_w));
+          }
+          acc.store(out + ow);
+        }
+        scalar_outputs(output_width);
+      }
+    }
+  }
+}
+
+// Same as max_pool_planes, for average pooling.
+template <typename scalar_t>
+void avg_pool_planes(
+    scalar_t* output_data, const scalar_t* input_data,
+    const PoolingParams& p, int64_t begin, int64_t end) {
+  using Vec = Vec256<scalar_t>;
+  const int64_t input_width = p.input_size[2];
+  const int64_t output_width = p.output_size[2];
+  const int64_t input_plane = p.input_size[0] * p.input_size[1] * input_width;
+  const int64_t output_plane = p.output_size[0] * p.output_size[1] * output_width;
+  const int64_t kernel_w = p.kernel[2];
+  int64_t inner_begin = 0, inner_end = 0;
+  if (p.stride[2] == 1) {
+    inner_outputs(output_width, input_width, kernel_w, p.padding[2], inner_begin, inner_end);
+  }
+  std::vector<scalar_t> row(input_width);
+  for (int64_t plane = begin; plane < end; plane++) {
+    const scalar_t* in = input_data + plane * input_plane;
+    scalar_t* out = output_data + plane * output_plane;
+    for (int64_t od = 0; od < p.output_size[0]; od++) {
+      int64_t d0, d1;
+      const int64_t padded_d = avg_pool_window(od, p.input_size[0], p.kernel[0], p.stride[0], p.padding[0], d0, d1);
+      for (int64_t oh = 0; oh < p.output_size[1]; oh++, out += output_width) {
+        int64_t h0, h1;
+        const int64_t padded_h = avg_pool_window(oh, p.input_size[1], p.kernel[1], p.stride[1], p.padding[1], h0, h1);
+        std::fill(row.begin(), row.end(), scalar_t(0));
+        for (int64_t d = d0; d < d1; d++) {
+          for (int64_t h = h0; h < h1; h++) {
+            const scalar_t* src = in + (d * p.input_size[1] + h) * input_width;
+            int64_t w = 0;
+            for (; w + Vec::size() <= input_width; w += Vec::size()) {
+              (Vec::loadu(row.data() + w) + Vec::loadu(src + w)).store(row.data() + w);
+            }
+            for (; w < input_width; w++) {
+              row[w] += src[w];
+            }
+          }
+        }
+        const int64_t padded_dh = padded_d * padded_h;
+        const int64_t valid_dh = (d1 - d0) * (h1 - h0);
+
+        int64_t ow = 0;
+        auto scalar_outputs = [&](int64_t ow_end) {
+          for (; ow < ow_end; ow++) {
+            int64_t w0, w1;
+            const int64_t padded_w = avg_pool_window(ow, input_width, kernel_w, p.stride[2], p.padding[2], w0, w1);
+            scalar_t sum = 0;
+            for (int64_t w = w0; w < w1; w++) {
+              sum += row[w];
+            }
+            const int64_t divide_factor = p.count_include_pad
+                ? padded_dh * padded_w : valid_dh * (w1 - w0);
+            out[ow] = sum / divide_factor;
+          }
+        };
+        scalar_outputs(inner_begin);
+        const Vec divide_factor(static_cast<scalar_t>(
+            (p.count_include_pad ? padded_dh : valid_dh) * kernel_w));
+        for (; ow + Vec::size() <= inner_end; ow += Vec::size()) {
+          const scalar_t* src = row.data() + ow - p.padding[2];
+          Vec acc = Vec::loadu(src);
+          for (int64_t k = 1; k < kernel_w; k++) {
+            acc = acc + Vec::loadu(src + k);
+          }
+          (acc / divide_factor).store(out + ow);
+        }
+        scalar_outputs(output_width);
+      }
+    }
+  }
+}
+
+// Max pooling of the channels last output pixels [begin, end), vectorized
+// over the channels, which are contiguous.
+template <typename scalar_t>
+void max_pool_channels_last(
+    scalar_t* output_data, const scalar_t* input_data,
+    const PoolingParams& p, int64_t begin, int64_t end) {
+  using Vec = Vec256<scalar_t>;
+  const int64_t channels = p.channels;
+  const int64_t input_height = p.input_size[1];
+  const int64_t input_width = p.input_size[2];
+  const int64_t output_pixels = p.output_size[1] * p.output_size[2];
+  const Vec lowest(-std::numeric_limits<scalar_t>::infinity());
+  for (int64_t pixel = begin; pixel < end; pixel++) {
+    const int64_t n = pixel / output_pixels;
+    const int64_t oh = (pixel % output_pixels) / p.output_size[2];
+    const int64_t ow = pixel % p.output_size[2];
+    int64_t h0, h1, w0, w1;
+    max_pool_window(oh, input_height, p.kernel[1], p.stride[1], p.padding[1], p.dilation[1], h0, h1);
+    max_pool_window(ow, input_width, p.kernel[2], p.stride[2], p.padding[2], p.dilation[2], w0, w1);
+    const scalar_t* in = input_data + n * input_height * input_width * channels;
+    scalar_t* out = output_data + pixel * channels;
+    for (int64_t c = 0; c < channels; c += Vec::size()) {
+      const int64_t count = std::min<int64_t>(channels - c, Vec::size());
+      Vec acc = lowest;
+      for (int64_t h = h0; h < h1; h += p.dilation[1]) {
+        for (int64_t w = w0; w < w1; w += p.dilation[2]) {
+          acc = maximum(acc, Vec::loadu(in + (h * input_width + w) * channels + c, count));
+        }
+      }
+      acc.store(out + c, count);
+    }
+  }
+}
+
+// Same as max_pool_channels_last, for average pooling.
+template <typename scalar_t>
+void avg_pool_channels_last(
+    scalar_t* output_data, const scalar_t* input_data,
+    const PoolingParams& p, int64_t begin, int64_t end) {
+  using Vec = Vec256<scalar_t>;
+  const int64_t channels = p.channels;
+  const int64_t input_height = p.input_size[1];
+  const int64_t input_width = p.input_size[2];
+  const int64_t output_pixels = p.output_size[1] * p.output_size[2];
+  for (int64_t pixel = begin; pixel < end; pixel++) {
+    const int64_t n = pixel / output_pixels;
+    const int64_t oh = (pixel % output_pixels) / p.output_size[2];
+    const int64_t ow = pixel % p.output_size[2];
+    int64_t h0, h1, w0, w1;
+    const int64_t padded_h = avg_pool_window(oh, input_height, p.kernel[1], p.stride[1], p.padding[1], h0, h1);
+    const int64_t padded_w = avg_pool_window(ow, input_width, p.kernel[2], p.stride[2], p.padding[2], w0, w1);
+    const Vec divide_factor(static_cast<scalar_t>(p.count_include_pad
+        ? padded_h * padded_w : (h1 - h0) * (w1 - w0)));
+    const scalar_t* in = input_data + n * input_height * input_width * channels;
+    scalar_t* out = output_data + pixel * channels;
+    for (int64_t c = 0; c < channels; c += Vec::size()) {
+      const int64_t count = std::min<int64_t>(channels - c, Vec::size());
+      Vec acc(0);
+      for (int64_t h = h0; h < h1; h++) {
+        for (int64_t w = w0; w < w1; w++) {
+          acc = acc + Vec::loadu(in + (h * input_width + w) * channels + c, count);
+        }
+      }
+      (acc / divide_factor).store(out + c, count);
+    }
+  }
+}
+
+// Work items of the parallel loops: planes, or output pixels of every image
+// for channels last, and the cost of one item.
+inline void pooling_work(const PoolingParams& p, int64_t& items, int64_t& grain_size) {
+  const int64_t window = p.kernel[0] * p.kernel[1] * p.kernel[2];
+  int64_t cost;
+  if (p.channels_last) {
+    items = p.nbatch * p.output_size[1] * p.output_size[2];
+    cost = p.channels * window;
+  } else {
+    items = p.nbatch * p.channels;
+    cost = p.output_size[0] * p.output_size[1] * p.output_size[2] * window;
+  }
+  grain_size = std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(cost, 1), 1);
+}
+
+void max_pool_kernel_impl(Tensor& output, Tensor& indices, const Tensor& input,
+                          const PoolingParams& p) {
+  AT_ASSERT(!(p.channels_last && indices.defined()));
+  int64_t items, grain_size;
+  pooling_work(p, items, grain_size);
+  AT_DISPATCH_FLOATING_TYPES(input.scalar_type(), "max_pool", [&] {
+    scalar_t* output_data = output.data<scalar_t>();
+    const scalar_t* input_data = input.data<scalar_t>();
+    int64_t* indices_data = indices.defined() ? indices.data<int64_t>() : nullptr;
+    parallel_for(0, items, grain_size, [&](int64_t begin, int64_t end) {
+      if (p.channels_last) {
+        max_pool_channels_last(output_data, input_data, p, begin, end);
+      } else if (indices_data) {
+        max_pool_planes_with_indices(output_data, indices_data, input_data, p, begin, end);
+      } else {
+        max_pool_planes(output_data, input_data, p, begin, end);
+      }
+    });
+  });
+}
+
+void avg_pool_kernel_impl(Tensor& output, const Tensor& input, const PoolingParams& p) {
+  int64_t items, grain_size;
+  pooling_work(p, items, grain_size);
+  AT_DISPATCH_FLOATING_TYPES(input.scalar_type(), "avg_pool", [&] {
+    scalar_t* output_data = output.data<scalar_t>();
+    const scalar_t* input_data = input.data<scalar_t>();
+    parallel_for(0, items, grain_size, [&](int64_t begin, int64_t end) {
+      if (p.channels_last) {
+        avg_pool_channels_last(output_data, input_data, p, begin, end);
+      } else {
+        avg_pool_planes(output_data, input_data, p, begin, end);
+      }
+    });
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(max_pool_kernel, &max_pool_kernel_impl);
+REGISTER_DISPATCH(avg_pool_kernel, &avg_pool_kernel_impl);
+
+}} // namespace at::native
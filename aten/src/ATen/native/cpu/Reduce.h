@@ -54,6 +54,58 @@ struct all_same : c10::guts::conjunction<
 //
 // If, on the other hand, there is only one, then we split the input into
 // into several pieces, reduce each separately, and then combine them.
+// The same goes for a few contiguous outputs (see
+// TensorIterator::use_two_pass_reduction): every thread then reduces a slice
+// of the reduced dimension into its own accumulator for each output.
+
+template <typename acc_t, typename data_t, typename ops_t>
+void binary_kernel_reduce_two_pass(TensorIterator& iter, const ops_t& ops, acc_t init) {
+  static_assert(
+    !std::is_same<acc_t, bool>::value,
+    "Concurrently modifying different references into std::vector<bool> is UB."
+  );
+  int max_threads = at::get_num_threads();
+  int64_t num_outputs = iter.tensor(0).numel();
+  std::vector<acc_t> buffer(max_threads * num_outputs, init);
+  // the output is contiguous, so offsets from its start index the accumulators
+  char* out_data = (char*)iter.data_ptr(0);
+
+  int dim = iter.reduced_dim_to_split();
+  int64_t size = iter.shape()[dim];
+  int64_t grain_size = std::max<int64_t>(internal::GRAIN_SIZE / (iter.numel() / size), 1);
+  at::parallel_for(0, size, grain_size, [&](int64_t begin, int64_t end) {
+    acc_t* accs = buffer.data() + at::get_thread_num() * num_outputs;
+    auto sub_iter = TensorIterator(iter);
+    sub_iter.narrow(dim, begin, end - begin);
+    sub_iter.serial_for_each([&](int ntensors, char** data, const int64_t* strides, int64_t size) {
+      AT_ASSERT(ntensors == 2);
+      char *out = data[0];
+      char *in = data[1];
+      if (strides[0] == 0) {
+        acc_t& acc = accs[(out - out_data) / sizeof(data_t)];
+        for (int64_t i = 0; i < size; ++i) {
+          acc = ops.reduce(acc, *(data_t*)in);
+          in += strides[1];
+        }
+      } else {
+        for (int64_t i = 0; i < size; ++i) {
+          acc_t& acc = accs[(out - out_data) / sizeof(data_t)];
+          acc = ops.reduce(acc, *(data_t*)in);
+          out += strides[0];
+          in += strides[1];
+        }
+      }
+    }, {0, sub_iter.numel()});
+  });
+
+  for (int64_t i = 0; i < num_outputs; i++) {
+    acc_t total_acc = buffer[i];
+    for (int thread = 1; thread < max_threads; ++thread) {
+      total_acc = ops.combine(total_acc, buffer[thread * num_outputs + i]);
+    }
+    ((data_t*)out_data)[i] = ops.project(total_acc);
+  }
+}
 
 template <typename ops_t, typename init_t>
 void binary_kernel_reduce(TensorIterator& iter, ops_t ops, init_t init) {
@@ -82,6 +134,11 @@ void binary_kernel_reduce(TensorIterator& iter, ops_t ops, init_t init) {
     std::is_default_constructible<acc_t>::value,
     "the accumulate type must be default-constructible"
   );
+  if (iter.num_output_elements() > 1 && iter.numel() >= at::internal::GRAIN_SIZE &&
+      at::get_num_threads() > 1 && !at::in_parallel_region() &&
+      iter.use_two_pass_reduction()) {
+    return binary_kernel_reduce_two_pass<acc_t, data_t>(iter, ops, init);
+  }
   iter.foreach_reduced_elt([&](TensorIterator &sub_iter) {
     auto reduction_body = [&](acc_t acc, int64_t begin, int64_t end) -> acc_t {
       sub_iter.serial_for_each([&acc, &ops](int ntensors, char** data, const int64_t* strides, int64_t size) {
@@ -3,7 +3,7 @@
 #include <algorithm>
 
 #include <ATen/Dispatch.h>
-#include <ATen/cpu/vec256/vec256.h>
+#include <ATen/cpu/vec512/vec512.h>
 #include <ATen/native/ReduceOps.h>
 #include <ATen/native/TensorIterator.h>
 #include <ATen/native/SharedReduceOps.h>
@@ -14,16 +14,36 @@ namespace at { namespace native { namespace {
 
 using namespace vec256;
 
+// Summing in Half or BFloat16 would round every partial sum to 8 or 11 bits
+// of mantissa, so these accumulate in float.
+static void reduced_precision_sum_kernel_impl(TensorIterator& iter, float factor) {
+  AT_DISPATCH_FLOATING_TYPES_AND2(at::ScalarType::Half, at::ScalarType::BFloat16,
+      iter.dtype(), "sum_cpu", [&] {
+    binary_kernel_reduce(
+      iter,
+      ReducedPrecisionMeanOps<scalar_t, float> {factor},
+      float(0)
+    );
+  });
+}
+
 static void sum_kernel_impl(TensorIterator& iter) {
+  if (iter.dtype() == ScalarType::Half || iter.dtype() == ScalarType::BFloat16) {
+    return reduced_precision_sum_kernel_impl(iter, 1.f);
+  }
   AT_DISPATCH_ALL_TYPES(iter.dtype(), "sum_cpu", [&] {
     binary_kernel_reduce_vec(
       iter,
       [=](scalar_t a, scalar_t b) -> scalar_t { return a + b; },
-      [=](Vec256<scalar_t> a, Vec256<scalar_t> b) { return a + b; });
+      [=](Vectorized<scalar_t> a, Vectorized<scalar_t> b) { return a + b; });
   });
 }
 
 static void mean_kernel_impl(TensorIterator& iter) {
+  if (iter.dtype() == ScalarType::Half || iter.dtype() == ScalarType::BFloat16) {
+    return reduced_precision_sum_kernel_impl(
+        iter, float(iter.num_output_elements()) / iter.numel());
+  }
   AT_DISPATCH_ALL_TYPES(iter.dtype(), "mean_cpu", [&] {
     scalar_t factor = scalar_t(iter.num_output_elements()) / iter.numel();
     binary_kernel_reduce(
@@ -35,7 +55,8 @@ static void mean_kernel_impl(TensorIterator& iter) {
 }
 
 static void std_var_kernel_impl(TensorIterator &iter, bool unbiased, bool take_sqrt) {
-  AT_DISPATCH_FLOATING_TYPES_AND_HALF(iter.dtype(), "std_cpu", [&] {
+  AT_DISPATCH_FLOATING_TYPES_AND2(at::ScalarType::Half, at::ScalarType::BFloat16,
+      iter.dtype(), "std_cpu", [&] {
     binary_kernel_reduce(
       iter,
       WelfordOps<scalar_t, double, int64_t, double> { unbiased, take_sqrt },
@@ -49,7 +70,7 @@ static void prod_kernel_impl(TensorIterator& iter) {
     binary_kernel_reduce_vec(
       iter,
       [=](scalar_t a, scalar_t b) -> scalar_t { return a * b; },
-      [=](Vec256<scalar_t> a, Vec256<scalar_t> b) { return a * b; },
+      [=](Vectorized<scalar_t> a, Vectorized<scalar_t> b) { return a * b; },
       /*identity=*/1);
   });
 }
@@ -114,7 +135,7 @@ static void and_kernel_impl(TensorIterator& iter) {
   binary_kernel_reduce_vec(
     iter,
     [=](uint8_t a, uint8_t b) -> uint8_t { return a && b; },
-    [=](Vec256<uint8_t> a, Vec256<uint8_t> b) {
+    [=](Vectorized<uint8_t> a, Vectorized<uint8_t> b) {
       // Adding the implementation here instead of in vec256_base to avoid
       // return value inconsistency. Other comparison operators in vec256_base
       // return -1/0 (all bit 1 / all bit 0) as true/false to follow the AVX2
@@ -125,8 +146,8 @@ static void and_kernel_impl(TensorIterator& iter) {
       //
       // In this method, users would expect, e.g., all(), to return 1/0 as
       // true/false.
-      Vec256<uint8_t> c = Vec256<uint8_t>();
-      for (int i = 0; i != Vec256<uint8_t>::size(); i++) {
+      Vectorized<uint8_t> c = Vectorized<uint8_t>();
+      for (int i = 0; i != Vectorized<uint8_t>::size(); i++) {
         c[i] = a[i] && b[i];
       }
       return c;
@@ -138,9 +159,9 @@ static void or_kernel_impl(TensorIterator& iter) {
   binary_kernel_reduce_vec(
     iter,
     [=](uint8_t a, uint8_t b) -> uint8_t { return a || b; },
-    [=](Vec256<uint8_t> a, Vec256<uint8_t> b) {
-      Vec256<uint8_t> c = Vec256<uint8_t>();
-      for (int i = 0; i != Vec256<uint8_t>::size(); i++) {
+    [=](Vectorized<uint8_t> a, Vectorized<uint8_t> b) {
+      Vectorized<uint8_t> c = Vectorized<uint8_t>();
+      for (int i = 0; i != Vectorized<uint8_t>::size(); i++) {
         c[i] = a[i] || b[i];
       }
       return c;
@@ -149,20 +170,22 @@ static void or_kernel_impl(TensorIterator& iter) {
 }
 
 static void min_values_kernel_impl(TensorIterator& iter) {
-  AT_DISPATCH_ALL_TYPES(iter.dtype(), "min_values_cpu", [&iter] {
+  AT_DISPATCH_ALL_TYPES_AND2(at::ScalarType::Half, at::ScalarType::BFloat16,
+      iter.dtype(), "min_values_cpu", [&iter] {
     binary_kernel_reduce_vec(
       iter,
       [](scalar_t a, scalar_t b) -> scalar_t { return std::min(a, b); },
-      [](Vec256<scalar_t> a, Vec256<scalar_t> b) { return minimum(a, b); });
+      [](Vectorized<scalar_t> a, Vectorized<scalar_t> b) { return minimum(a, b); });
   });
 }
 
 static void max_values_kernel_impl(TensorIterator& iter) {
-  AT_DISPATCH_ALL_TYPES(iter.dtype(), "max_values_cpu", [&iter] {
+  AT_DISPATCH_ALL_TYPES_AND2(at::ScalarType::Half, at::ScalarType::BFloat16,
+      iter.dtype(), "max_values_cpu", [&iter] {
     binary_kernel_reduce_vec(
       iter,
       [](scalar_t a, scalar_t b) -> scalar_t { return std::max(a, b); },
-      [](Vec256<scalar_t> a, Vec256<scalar_t> b) { return maximum(a, b); });
+      [](Vectorized<scalar_t> a, Vectorized<scalar_t> b) { return maximum(a, b); });
   });
 }
 
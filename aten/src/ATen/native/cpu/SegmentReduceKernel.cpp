@@ -0,0 +1,73 @@
+#include <ATen/native/SegmentReduce.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+
+namespace at { namespace native { namespace {
+
+template <typename scalar_t, typename acc_t, typename op_t>
+static void apply_segment_reduce(Tensor& result, const Tensor& data, const Tensor& offsets,
+                                 acc_t ident, const op_t& op) {
+  int64_t num_segments = offsets.numel() - 1;
+  int64_t inner_size = result.size(1);
+  const scalar_t* data_ptr = data.data<scalar_t>();
+  const int64_t* offsets_ptr = offsets.data<int64_t>();
+  scalar_t* result_ptr = result.data<scalar_t>();
+
+  parallel_for(0, num_segments, 1, [&](int64_t start, int64_t end) {
+    std::vector<acc_t> acc(inner_size);
+    for (int64_t s = start; s < end; s++) {
+      std::fill(acc.begin(), acc.end(), ident);
+      for (int64_t row = offsets_ptr[s]; row < offsets_ptr[s + 1]; row++) {
+        const scalar_t* row_ptr = data_ptr + row * inner_size;
+        for (int64_t i = 0; i < inner_size; i++) {
+          acc[i] = op(acc[i], static_cast<acc_t>(row_ptr[i]));
+        }
+      }
+      scalar_t* out_ptr = result_ptr + s * inner_size;
+      for (int64_t i = 0; i < inner_size; i++) {
+        out_ptr[i] = static_cast<scalar_t>(acc[i]);
+      }
+    }
+  });
+}
+
+static void segment_reduce_kernel_impl(Tensor& result, const Tensor& data, const Tensor& offsets,
+                                       SegmentReduction reduction) {
+  int64_t num_rows = data.size(0);
+  const int64_t* offsets_ptr = offsets.data<int64_t>();
+  for (int64_t s = 0; s + 1 < offsets.numel(); s++) {
+    AT_CHECK(offsets_ptr[s] >= 0 && offsets_ptr[s] <= offsets_ptr[s + 1] && offsets_ptr[s + 1] <= num_rows,
+             "segment_reduce: expected offsets to be non-decreasing and within [0, ", num_rows,
+             "], but got offsets[", s, "] = ", offsets_ptr[s], " and offsets[", s + 1, "] = ", offsets_ptr[s + 1]);
+  }
+
+  AT_DISPATCH_FLOATING_TYPES(data.scalar_type(), "segment_reduce_cpu", [&] {
+    switch (reduction) {
+      case SEGMENT_REDUCE_SUM:
+      case SEGMENT_REDUCE_MEAN:
+        apply_segment_reduce<scalar_t>(result, data, offsets, scalar_t(0),
+            [](scalar_t a, scalar_t b) { return a + b; });
+        break;
+      case SEGMENT_REDUCE_MAX:
+        apply_segment_reduce<scalar_t>(result, data, offsets, -std::numeric_limits<scalar_t>::infinity(),
+            [](scalar_t a, scalar_t b) { return (std::isnan(a) || a > b) ? a : b; });
+        break;
+      case SEGMENT_REDUCE_MIN:
+        apply_segment_reduce<scalar_t>(result, data, offsets, std::numeric_limits<scalar_t>::infinity(),
+            [](scalar_t a, scalar_t b) { return (std::isnan(a) || a < b) ? a : b; });
+        break;
+    }
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(segment_reduce_stub, &segment_reduce_kernel_impl);
+
+}} // namespace at::native
@@ -0,0 +1,152 @@
+#include <ATen/native/SmallGemm.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec256/vec256.h>
+
+namespace at { namespace native { namespace {
+
+using namespace vec256;
+
+// Rows of the result computed together by the micro kernel.
+constexpr int64_t kBlockRows = 4;
+// Vectors of columns of the result computed together by the micro kernel.
+constexpr int64_t kBlockVecs = 2;
+
+// Computes the rows x (vecs * Vec::size()) block of c = alpha * a @ b (+ beta
+// * c if accumulate), keeping the block in registers over the k loop. b is
+// packed with rows of ldb elements, zero padded to whole vectors, so only the
+// first n columns of the block are stored.
+template <typename scalar_t, int64_t rows, int64_t vecs>
+inline void micro_kernel(
+    int64_t k_size, const scalar_t* a, int64_t a_stride0, int64_t a_stride1,
+    const scalar_t* b, int64_t ldb, scalar_t* c, int64_t ldc, int64_t n,
+    scalar_t alpha, scalar_t beta, bool accumulate) {
+  using Vec = Vec256<scalar_t>;
+  Vec acc[rows][vecs];
+  for (int64_t i = 0; i < rows; i++) {
+    for (int64_t v = 0; v < vecs; v++) {
+      acc[i][v] = Vec(0);
+    }
+  }
+  for (int64_t k = 0; k < k_size; k++) {
+    Vec b_vec[vecs];
+    for (int64_t v = 0; v < vecs; v++) {
+      b_vec[v] = Vec::loadu(b + k * ldb + v * Vec::size());
+    }
+    for (int64_t i = 0; i < rows; i++) {
+      const Vec a_vec(a[i * a_stride0 + k * a_stride1]);
+      for (int64_t v = 0; v < vecs; v++) {
+        acc[i][v] = fmadd(a_vec, b_vec[v], acc[i][v]);
+      }
+    }
+  }
+  const Vec alpha_vec(alpha);
+  const Vec beta_vec(beta);
+  for (int64_t i = 0; i < rows; i++) {
+    for (int64_t v = 0; v < vecs; v++) {
+      const int64_t count = std::min<int64_t>(n - v * Vec::size(), Vec::size());
+      if (count <= 0) {
+        break;
+      }
+      scalar_t* out = c + i * ldc + v * Vec::size();
+      Vec r = acc[i][v] * alpha_vec;
+      if (accumulate) {
+        r = r + Vec::loadu(out, count) * beta_vec;
+      }
+      r.store(out, count);
+    }
+  }
+}
+
+template <typename scalar_t, int64_t vecs>
+inline void micro_kernel_rows(int64_t rows, int64_t k_size, const scalar_t* a,
+    int64_t a_stride0, int64_t a_stride1, const scalar_t* b, int64_t ldb,
+    scalar_t* c, int64_t ldc, int64_t n, scalar_t alpha, scalar_t beta,
+    bool accumulate) {
+  switch (rows) {
+    case 4:
+      return micro_kernel<scalar_t, 4, vecs>(k_size, a, a_stride0, a_stride1, b, ldb, c, ldc, n, alpha, beta, accumulate);
+    case 3:
+      return micro_kernel<scalar_t, 3, vecs>(k_size, a, a_stride0, a_stride1, b, ldb, c, ldc, n, alpha, beta, accumulate);
+    case 2:
+      return micro_kernel<scalar_t, 2, vecs>(k_size, a, a_stride0, a_stride1, b, ldb, c, ldc, n, alpha, beta, accumulate);
+    default:
+      return micro_kernel<scalar_t, 1, vecs>(k_size, a, a_stride0, a_stride1, b, ldb, c, ldc, n, alpha, beta, accumulate);
+  }
+}
+
+template <typename scalar_t>
+void small_bmm_kernel_impl(
+    Tensor& result, const Tensor& batch1, const Tensor& batch2,
+    scalar_t beta, scalar_t alpha, bool is_bmm) {
+  using Vec = Vec256<scalar_t>;
+  const int64_t batch_size = result.size(0);
+  const int64_t m = result.size(1);
+  const int64_t n = result.size(2);
+  const int64_t k_size = batch1.size(2);
+  const int64_t ldb = divup(n, Vec::size()) * Vec::size();
+  // beta = 0 ignores the result, like BLAS, so that it may be uninitialized
+  const bool accumulate = !is_bmm && beta != scalar_t(0);
+  if (is_bmm) {
+    alpha = 1;
+  }
+
+  const scalar_t* a_data = batch1.data<scalar_t>();
+  const scalar_t* b_data = batch2.data<scalar_t>();
+  scalar_t* c_data = result.data<scalar_t>();
+  const int64_t a_strides[3] = {batch1.stride(0), batch1.stride(1), batch1.stride(2)};
+  const int64_t b_strides[3] = {batch2.stride(0), batch2.stride(1), batch2.stride(2)};
+  const int64_t c_strides[2] = {result.stride(0), result.stride(1)};
+
+  const int64_t grain_size = std::max<int64_t>(internal::GRAIN_SIZE / (m * n * k_size), 1);
+  parallel_for(0, batch_size, grain_size, [&](int64_t begin, int64_t end) {
+    // b packed in rows of whole vectors, whatever its strides
+    std::vector<scalar_t> packed(k_size * ldb, scalar_t(0));
+    for (int64_t batch = begin; batch < end; batch++) {
+      const scalar_t* a = a_data + batch * a_strides[0];
+      const scalar_t* b = b_data + batch * b_strides[0];
+      scalar_t* c = c_data + batch * c_strides[0];
+      for (int64_t k = 0; k < k_size; k++) {
+        for (int64_t j = 0; j < n; j++) {
+          packed[k * ldb + j] = b[k * b_strides[1] + j * b_strides[2]];
+        }
+      }
+      for (int64_t j = 0; j < n; j += kBlockVecs * Vec::size()) {
+        const int64_t cols = std::min<int64_t>(n - j, kBlockVecs * Vec::size());
+        for (int64_t i = 0; i < m; i += kBlockRows) {
+          const int64_t rows = std::min<int64_t>(m - i, kBlockRows);
+          const scalar_t* a_block = a + i * a_strides[1];
+          scalar_t* c_block = c + i * c_strides[1] + j;
+          if (cols > Vec::size()) {
+            micro_kernel_rows<scalar_t, kBlockVecs>(
+                rows, k_size, a_block, a_strides[1], a_strides[2], packed.data() + j, ldb,
+                c_block, c_strides[1], cols, alpha, beta, accumulate);
+          } else {
+            micro_kernel_rows<scalar_t, 1>(
+                rows, k_size, a_block, a_strides[1], a_strides[2], packed.data() + j, ldb,
+                c_block, c_strides[1], cols, alpha, beta, accumulate);
+          }
+        }
+      }
+    }
+  });
+}
+
+void small_bmm_kernel(
+    Tensor& result, const Tensor& batch1, const Tensor& batch2,
+    Scalar beta, Scalar alpha, bool is_bmm) {
+  AT_DISPATCH_FLOATING_TYPES(result.scalar_type(), "small_bmm", [&] {
+    small_bmm_kernel_impl<scalar_t>(
+        result, batch1, batch2, beta.to<scalar_t>(), alpha.to<scalar_t>(), is_bmm);
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(small_bmm_stub, &small_bmm_kernel);
+
+}} // namespace at::native
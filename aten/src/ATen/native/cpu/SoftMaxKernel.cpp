@@ -2,7 +2,9 @@
 
 #include <algorithm>
 #include <iterator>
+#include <limits>
 #include <numeric>
+#include <vector>
 
 #include <ATen/Dispatch.h>
 #include <ATen/Parallel.h>
@@ -126,6 +128,103 @@ inline void _vec_softmax_lastdim(
       });
 }
 
+// Half and BFloat16 rows are widened to float, computed with the float vectors
+// and rounded back once, instead of rounding every intermediate result.
+template <typename scalar_t, bool LogSoftMax>
+inline void _vec_reduced_float_softmax_lastdim(
+    scalar_t* input_data_base,
+    scalar_t* output_data_base,
+    int64_t outer_size,
+    int64_t dim_size) {
+  using Vec = vec256::Vec256<float>;
+  int64_t grain_size = internal::GRAIN_SIZE / (16 * dim_size);
+  if (grain_size < 1)
+    grain_size = 1;
+
+  parallel_for(
+      0,
+      outer_size,
+      grain_size,
+      [&](int64_t begin, int64_t end) {
+        std::vector<float> buffer(dim_size);
+        float* row = buffer.data();
+        for (int64_t i = begin; i < end; i++) {
+          vec256::convert(input_data_base + i * dim_size, row, dim_size);
+          float max_input = vec256::reduce_all<float>(
+              [](Vec& x, Vec& y) { return vec256::maximum(x, y); },
+              row,
+              dim_size);
+          if (LogSoftMax) {
+            float tmp_sum = vec256::map_reduce_all<float>(
+                [max_input](Vec x) { return (x - Vec(max_input)).exp(); },
+                [](Vec x, Vec y) { return x + y; },
+                row,
+                dim_size);
+            // See [Note AVX-SSE transitions] for why this calls the
+            // vectorized log.
+            vec256::map(
+                [](Vec x) { return x.log(); }, &tmp_sum, &tmp_sum, 1);
+            float shift = max_input + tmp_sum;
+            vec256::map(
+                [shift](Vec x) { return x - Vec(shift); }, row, row, dim_size);
+          } else {
+            vec256::map(
+                [max_input](Vec x) { return (x - Vec(max_input)).exp(); },
+                row,
+                row,
+                dim_size);
+            float tmp_sum = vec256::reduce_all<float>(
+                [](Vec x, Vec y) { return x + y; }, row, dim_size);
+            tmp_sum = 1 / tmp_sum;
+            vec256::map(
+                [tmp_sum](Vec x) { return x * Vec(tmp_sum); },
+                row,
+                row,
+                dim_size);
+          }
+          vec256::convert(
+              static_cast<const float*>(row),
+              output_data_base + i * dim_size,
+              dim_size);
+        }
+      });
+}
+
+template <bool LogSoftMax, typename scalar_t>
+inline void _vec_host_softmax_lastdim(
+    scalar_t* input_data_base,
+    scalar_t* output_data_base,
+    int64_t outer_size,
+    int64_t dim_size) {
+  if (LogSoftMax) {
+    _vec_log_softmax_lastdim(
+        input_data_base, output_data_base, outer_size, dim_size);
+  } else {
+    _vec_softmax_lastdim(
+        input_data_base, output_data_base, outer_size, dim_size);
+  }
+}
+
+template <bool LogSoftMax>
+inline void _vec_host_softmax_lastdim(
+    at::Half* input_data_base,
+    at::Half* output_data_base,
+    int64_t outer_size,
+    int64_t dim_size) {
+  _vec_reduced_float_softmax_lastdim<at::Half, LogSoftMax>(
+      input_data_base, output_data_base, outer_size, dim_size);
+}
+
+template <bool LogSoftMax>
+inline void _vec_host_softmax_lastdim(
+    at::BFloat16* input_data_base,
+    at::BFloat16* output_data_base,
+    int64_t outer_size,
+    int64_t dim_size) {
+  _vec_reduced_float_softmax_lastdim<at::BFloat16, LogSoftMax>(
+      input_data_base, output_data_base, outer_size, dim_size);
+}
+
 template <typename scalar_t, bool log_softmax>
 inline void _vec_host_softmax_backward_lastdim(
     scalar_t* grad_input_data_base,
@@ -178,6 +277,340 @@ inline void _vec_host_softmax_backward_lastdim(
       });
 }
 
+// Softmax over a dimension that is not the last one. Consecutive elements of
+// the inner dimensions belong to different softmax rows, so the vectors span
+// Vec::size() rows and step through the softmax dimension with a stride of
+// inner_size instead of being reduced horizontally.
+template <typename scalar_t, bool LogSoftMax>
+inline void _vec_softmax(
+    scalar_t* input_data_base,
+    scalar_t* output_data_base,
+    int64_t outer_size,
+    int64_t inner_size,
+    int64_t dim_size) {
+  using Vec = vec256::Vec256<scalar_t>;
+  int64_t dim_stride = inner_size;
+  int64_t outer_stride = dim_size * dim_stride;
+  int64_t num_chunks = divup(inner_size, Vec::size());
+  int64_t grain_size = internal::GRAIN_SIZE / (16 * dim_size * Vec::size());
+  if (grain_size < 1)
+    grain_size = 1;
+
+  parallel_for(
+      0,
+      outer_size * num_chunks,
+      grain_size,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+          int64_t outer_idx = i / num_chunks;
+          int64_t inner_idx = (i % num_chunks) * Vec::size();
+          int64_t len = std::min<int64_t>(Vec::size(), inner_size - inner_idx);
+          scalar_t* input_data =
+              input_data_base + outer_idx * outer_stride + inner_idx;
+          scalar_t* output_data =
+              output_data_base + outer_idx * outer_stride + inner_idx;
+          Vec max_input = Vec::loadu(input_data, len);
+          for (int64_t d = 1; d < dim_size; d++) {
+            max_input = vec256::maximum(
+                max_input, Vec::loadu(input_data + d * dim_stride, len));
+          }
+          Vec tmp_sum(0);
+          for (int64_t d = 0; d < dim_size; d++) {
+            Vec z = (Vec::loadu(input_data + d * dim_stride, len) - max_input)
+                        .exp();
+            if (!LogSoftMax) {
+              z.store(output_data + d * dim_stride, len);
+            }
+            tmp_sum = tmp_sum + z;
+          }
+          if (LogSoftMax) {
+            tmp_sum = tmp_sum.log() + max_input;
+            for (int64_t d = 0; d < dim_size; d++) {
+              (Vec::loadu(input_data + d * dim_stride, len) - tmp_sum)
+                  .store(output_data + d * dim_stride, len);
+            }
+          } else {
+            tmp_sum = Vec(1) / tmp_sum;
+            for (int64_t d = 0; d < dim_size; d++) {
+              (Vec::loadu(output_data + d * dim_stride, len) * tmp_sum)
+                  .store(output_data + d * dim_stride, len);
+            }
+          }
+        }
+      });
+}
+
+template <typename scalar_t, bool LogSoftMax>
+inline void _vec_softmax_backward(
+    scalar_t* grad_input_data_base,
+    scalar_t* grad_data_base,
+    scalar_t* output_data_base,
+    int64_t outer_size,
+    int64_t inner_size,
+    int64_t dim_size) {
+  using Vec = vec256::Vec256<scalar_t>;
+  int64_t dim_stride = inner_size;
+  int64_t outer_stride = dim_size * dim_stride;
+  int64_t num_chunks = divup(inner_size, Vec::size());
+  int64_t grain_size = internal::GRAIN_SIZE / (16 * dim_size * Vec::size());
+  if (grain_size < 1)
+    grain_size = 1;
+
+  parallel_for(
+      0,
+      outer_size * num_chunks,
+      grain_size,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+          int64_t outer_idx = i / num_chunks;
+          int64_t inner_idx = (i % num_chunks) * Vec::size();
+          int64_t len = std::min<int64_t>(Vec::size(), inner_size - inner_idx);
+          int64_t offset = outer_idx * outer_stride + inner_idx;
+          scalar_t* grad_input_data = grad_input_data_base + offset;
+          scalar_t* grad_data = grad_data_base + offset;
+          scalar_t* output_data = output_data_base + offset;
+          Vec sum(0);
+          for (int64_t d = 0; d < dim_size; d++) {
+            Vec grad = Vec::loadu(grad_data + d * dim_stride, len);
+            if (LogSoftMax) {
+              sum = sum + grad;
+            } else {
+              sum = sum + grad * Vec::loadu(output_data + d * dim_stride, len);
+            }
+          }
+          for (int64_t d = 0; d < dim_size; d++) {
+            Vec grad = Vec::loadu(grad_data + d * dim_stride, len);
+            Vec output = Vec::loadu(output_data + d * dim_stride, len);
+            if (LogSoftMax) {
+              (grad - output.exp() * sum)
+                  .store(grad_input_data + d * dim_stride, len);
+            } else {
+              ((grad - sum) * output)
+                  .store(grad_input_data + d * dim_stride, len);
+            }
+          }
+        }
+      });
+}
+
+// Turns a mask element into the value added to the input: boolean masks
+// remove the positions that are set, floating point masks are added as is.
+template <typename scalar_t, typename mask_t>
+struct AdditiveMask {
+  static constexpr bool is_additive = false;
+  static scalar_t apply(mask_t m) {
+    return m ? -std::numeric_limits<scalar_t>::infinity() : scalar_t(0);
+  }
+};
+
+template <typename scalar_t>
+struct AdditiveMask<scalar_t, scalar_t> {
+  static constexpr bool is_additive = true;
+  static scalar_t apply(scalar_t m) {
+    return m;
+  }
+};
+
+// Maps the [outer_size, dim_size, inner_size] view of the input to offsets
+// into a mask that has been expanded to the input's sizes. The mask is read
+// through its strides, so broadcast masks (e.g. a [N, 1, 1, S] padding mask
+// of [N, H, T, S] attention scores) are never materialized.
+struct MaskIndexer {
+  MaskIndexer(const Tensor& mask, int64_t dim)
+      : sizes_(mask.sizes().begin(), mask.sizes().begin() + dim),
+        strides_(mask.strides().begin(), mask.strides().begin() + dim),
+        dim_stride(mask.stride(dim)),
+        inner_contiguous(true) {
+    int64_t inner_size = 1;
+    for (int64_t k = mask.dim() - 1; k > dim; k--) {
+      if (mask.size(k) != 1 && mask.stride(k) != inner_size) {
+        inner_contiguous = false;
+      }
+      inner_size *= mask.size(k);
+    }
+    if (!inner_contiguous) {
+      inner_offsets.resize(inner_size);
+      for (int64_t i = 0; i < inner_size; i++) {
+        int64_t linear = i;
+        int64_t offset = 0;
+        for (int64_t k = mask.dim() - 1; k > dim; k--) {
+          offset += (linear % mask.size(k)) * mask.stride(k);
+          linear /= mask.size(k);
+        }
+        inner_offsets[i] = offset;
+      }
+    }
+  }
+
+  int64_t outer_offset(int64_t outer_idx) const {
+    int64_t offset = 0;
+    for (int64_t k = sizes_.size() - 1; k >= 0; k--) {
+      offset += (outer_idx % sizes_[k]) * strides_[k];
+      outer_idx /= sizes_[k];
+    }
+    return offset;
+  }
+
+  int64_t inner_offset(int64_t inner_idx) const {
+    return inner_contiguous ? inner_idx : inner_offsets[inner_idx];
+  }
+
+ private:
+  std::vector<int64_t> sizes_;
+  std::vector<int64_t> strides_;
+
+ public:
+  int64_t dim_stride;
+  bool inner_contiguous;
+  std::vector<int64_t> inner_offsets;
+};
+
+// Softmax of input + mask over the last dimension. The masked input is written
+// to the output and the later passes work in place on the cached row, so the
+// mask is read once.
+// Rows without a single unmasked element produce zeros instead of NaNs.
+template <typename scalar_t, typename mask_t>
+inline void _vec_masked_softmax_lastdim(
+    scalar_t* input_data_base,
+    scalar_t* output_data_base,
+    mask_t* mask_data_base,
+    const MaskIndexer& indexer,
+    int64_t outer_size,
+    int64_t dim_size) {
+  using Vec = vec256::Vec256<scalar_t>;
+  using Mask = AdditiveMask<scalar_t, mask_t>;
+  int64_t grain_size = internal::GRAIN_SIZE / (16 * dim_size);
+  if (grain_size < 1)
+    grain_size = 1;
+
+  parallel_for(
+      0,
+      outer_size,
+      grain_size,
+      [&](int64_t begin, int64_t end) {
+        std::vector<scalar_t> mask_buffer;
+        for (int64_t i = begin; i < end; i++) {
+          scalar_t* input_data = input_data_base + i * dim_size;
+          scalar_t* output_data = output_data_base + i * dim_size;
+          mask_t* mask_data = mask_data_base + indexer.outer_offset(i);
+          scalar_t* mask_row;
+          if (Mask::is_additive && indexer.dim_stride == 1) {
+            mask_row = reinterpret_cast<scalar_t*>(mask_data);
+          } else {
+            mask_buffer.resize(dim_size);
+            for (int64_t d = 0; d < dim_size; d++) {
+              mask_buffer[d] = Mask::apply(mask_data[d * indexer.dim_stride]);
+            }
+            mask_row = mask_buffer.data();
+          }
+
+          vec256::map2(
+              [](Vec x, Vec m) { return x + m; },
+              output_data,
+              input_data,
+              mask_row,
+              dim_size);
+          scalar_t max_input = vec256::reduce_all<scalar_t>(
+              [](Vec& x, Vec& y) { return vec256::maximum(x, y); },
+              output_data,
+              dim_size);
+          if (max_input == -std::numeric_limits<scalar_t>::infinity()) {
+            std::fill(output_data, output_data + dim_size, scalar_t(0));
+            continue;
+          }
+
+          vec256::map(
+              [max_input](Vec x) { return (x - Vec(max_input)).exp(); },
+              output_data,
+              output_data,
+              dim_size);
+          scalar_t tmp_sum = vec256::reduce_all<scalar_t>(
+              [](Vec x, Vec y) { return x + y; }, output_data, dim_size);
+          tmp_sum = 1 / tmp_sum;
+          vec256::map(
+              [tmp_sum](Vec x) { return x * Vec(tmp_sum); },
+              output_data,
+              output_data,
+              dim_size);
+        }
+      });
+}
+
+// Masked softmax over a dimension that is not the last one, vectorized across
+// the inner dimensions like _vec_softmax.
+template <typename scalar_t, typename mask_t>
+inline void _vec_masked_softmax(
+    scalar_t* input_data_base,
+    scalar_t* output_data_base,
+    mask_t* mask_data_base,
+    const MaskIndexer& indexer,
+    int64_t outer_size,
+    int64_t inner_size,
+    int64_t dim_size) {
+  using Vec = vec256::Vec256<scalar_t>;
+  using Mask = AdditiveMask<scalar_t, mask_t>;
+  int64_t dim_stride = inner_size;
+  int64_t outer_stride = dim_size * dim_stride;
+  int64_t num_chunks = divup(inner_size, Vec::size());
+  int64_t grain_size = internal::GRAIN_SIZE / (16 * dim_size * Vec::size());
+  if (grain_size < 1)
+    grain_size = 1;
+
+  parallel_for(
+      0,
+      outer_size * num_chunks,
+      grain_size,
+      [&](int64_t begin, int64_t end) {
+        scalar_t mask_arr[Vec::size()];
+        for (int64_t i = begin; i < end; i++) {
+          int64_t outer_idx = i / num_chunks;
+          int64_t inner_idx = (i % num_chunks) * Vec::size();
+          int64_t len = std::min<int64_t>(Vec::size(), inner_size - inner_idx);
+          scalar_t* input_data =
+              input_data_base + outer_idx * outer_stride + inner_idx;
+          scalar_t* output_data =
+              output_data_base + outer_idx * outer_stride + inner_idx;
+          mask_t* mask_data = mask_data_base + indexer.outer_offset(outer_idx);
+
+          Vec max_input(-std::numeric_limits<scalar_t>::infinity());
+          for (int64_t d = 0; d < dim_size; d++) {
+            mask_t* mask_slice = mask_data + d * indexer.dim_stride;
+            Vec mask;
+            if (Mask::is_additive && indexer.inner_contiguous) {
+              mask = Vec::loadu(mask_slice + inner_idx, len);
+            } else {
+              for (int64_t j = 0; j < len; j++) {
+                mask_arr[j] =
+                    Mask::apply(mask_slice[indexer.inner_offset(inner_idx + j)]);
+              }
+              mask = Vec::loadu(mask_arr, len);
+            }
+            Vec z = Vec::loadu(input_data + d * dim_stride, len) + mask;
+            z.store(output_data + d * dim_stride, len);
+            max_input = vec256::maximum(max_input, z);
+          }
+          // Fully masked rows have a maximum of -inf; shifting them by zero
+          // instead makes every exp vanish and the zero sum is caught below.
+          max_input = Vec::blendv(
+              max_input,
+              Vec(0),
+              max_input == Vec(-std::numeric_limits<scalar_t>::infinity()));
+          Vec tmp_sum(0);
+          for (int64_t d = 0; d < dim_size; d++) {
+            Vec z = (Vec::loadu(output_data + d * dim_stride, len) - max_input)
+                        .exp();
+            z.store(output_data + d * dim_stride, len);
+            tmp_sum = tmp_sum + z;
+          }
+          tmp_sum = Vec::blendv(Vec(1) / tmp_sum, Vec(0), tmp_sum == Vec(0));
+          for (int64_t d = 0; d < dim_size; d++) {
+            (Vec::loadu(output_data + d * dim_stride, len) * tmp_sum)
+                .store(output_data + d * dim_stride, len);
+          }
+        }
+      });
+}
+
 template <typename scalar_t, bool LogSoftMax>
 struct vec_host_softmax_lastdim {
   static void apply(Tensor& output, const Tensor& input) {
@@ -187,13 +620,8 @@ struct vec_host_softmax_lastdim {
       outer_size *= input.size(i);
     scalar_t* input_data_base = input.data<scalar_t>();
     scalar_t* output_data_base = output.data<scalar_t>();
-    if (LogSoftMax) {
-      _vec_log_softmax_lastdim(
-          input_data_base, output_data_base, outer_size, dim_size);
-    } else {
-      _vec_softmax_lastdim(
-          input_data_base, output_data_base, outer_size, dim_size);
-    }
+    _vec_host_softmax_lastdim<LogSoftMax>(
+        input_data_base, output_data_base, outer_size, dim_size);
   }
 };
 
@@ -217,8 +645,92 @@ struct vec_host_softmax_backward_lastdim {
   }
 };
 
+template <typename scalar_t, bool LogSoftMax>
+struct vec_softmax {
+  static void apply(Tensor& output, const Tensor& input, int64_t dim) {
+    int64_t outer_size = 1;
+    int64_t dim_size = input.size(dim);
+    int64_t inner_size = 1;
+    for (int64_t i = 0; i < dim; ++i)
+      outer_size *= input.size(i);
+    for (int64_t i = dim + 1; i < input.dim(); ++i)
+      inner_size *= input.size(i);
+    scalar_t* input_data_base = input.data<scalar_t>();
+    scalar_t* output_data_base = output.data<scalar_t>();
+    _vec_softmax<scalar_t, LogSoftMax>(
+        input_data_base, output_data_base, outer_size, inner_size, dim_size);
+  }
+};
+
+template <typename scalar_t, bool LogSoftMax>
+struct vec_softmax_backward {
+  static void apply(
+      Tensor& grad_input,
+      const Tensor& grad,
+      const Tensor& output,
+      int64_t dim) {
+    int64_t outer_size = 1;
+    int64_t dim_size = grad.size(dim);
+    int64_t inner_size = 1;
+    for (int64_t i = 0; i < dim; ++i)
+      outer_size *= grad.size(i);
+    for (int64_t i = dim + 1; i < grad.dim(); ++i)
+      inner_size *= grad.size(i);
+    scalar_t* grad_input_data_base = grad_input.data<scalar_t>();
+    scalar_t* grad_data_base = grad.data<scalar_t>();
+    scalar_t* output_data_base = output.data<scalar_t>();
+    _vec_softmax_backward<scalar_t, LogSoftMax>(
+        grad_input_data_base,
+        grad_data_base,
+        output_data_base,
+        outer_size,
+        inner_size,
+        dim_size);
+  }
+};
+
+template <typename scalar_t, typename mask_t>
+struct vec_masked_softmax {
+  static void apply(
+      Tensor& output,
+      const Tensor& input,
+      const Tensor& mask,
+      int64_t dim) {
+    int64_t outer_size = 1;
+    int64_t dim_size = input.size(dim);
+    int64_t inner_size = 1;
+    for (int64_t i = 0; i < dim; ++i)
+      outer_size *= input.size(i);
+    for (int64_t i = dim + 1; i < input.dim(); ++i)
+      inner_size *= input.size(i);
+    scalar_t* input_data_base = input.data<scalar_t>();
+    scalar_t* output_data_base = output.data<scalar_t>();
+    mask_t* mask_data_base = mask.data<mask_t>();
+    MaskIndexer indexer(mask, dim);
+    if (inner_size == 1) {
+      _vec_masked_softmax_lastdim(
+          input_data_base,
+          output_data_base,
+          mask_data_base,
+          indexer,
+          outer_size,
+          dim_size);
+    } else {
+      _vec_masked_softmax(
+          input_data_base,
+          output_data_base,
+          mask_data_base,
+          indexer,
+          outer_size,
+          inner_size,
+          dim_size);
+    }
+  }
+};
+
 static void softmax_lastdim_kernel_impl(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.scalar_type(), "softmax_lastdim_kernel_impl", [&] {
+  AT_DISPATCH_FLOATING_TYPES_AND2(at::ScalarType::Half, at::ScalarType::BFloat16,
+      self.scalar_type(), "softmax_lastdim_kernel_impl", [&] {
     vec_host_softmax_lastdim<scalar_t, false>::apply(result, self);
   });
 }
@@ -226,7 +738,7 @@ static void softmax_lastdim_kernel_impl(Tensor& result, const Tensor& self) {
 static void log_softmax_lastdim_kernel_impl(
     Tensor& result,
     const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(
+  AT_DISPATCH_FLOATING_TYPES_AND2(at::ScalarType::Half, at::ScalarType::BFloat16,
       self.scalar_type(), "log_softmax_lastdim_kernel_impl", [&] {
         vec_host_softmax_lastdim<scalar_t, true>::apply(result, self);
       });
@@ -254,6 +766,67 @@ static void log_softmax_backward_lastdim_kernel_impl(
       });
 }
 
+static void softmax_kernel_impl(
+    Tensor& result,
+    const Tensor& self,
+    int64_t dim) {
+  AT_DISPATCH_FLOATING_TYPES(self.scalar_type(), "softmax_kernel_impl", [&] {
+    vec_softmax<scalar_t, false>::apply(result, self, dim);
+  });
+}
+
+static void log_softmax_kernel_impl(
+    Tensor& result,
+    const Tensor& self,
+    int64_t dim) {
+  AT_DISPATCH_FLOATING_TYPES(
+      self.scalar_type(), "log_softmax_kernel_impl", [&] {
+        vec_softmax<scalar_t, true>::apply(result, self, dim);
+      });
+}
+
+static void softmax_backward_kernel_impl(
+    Tensor& grad_input,
+    const Tensor& grad,
+    const Tensor& output,
+    int64_t dim) {
+  AT_DISPATCH_FLOATING_TYPES(
+      grad.scalar_type(), "softmax_backward_kernel_impl", [&] {
+        vec_softmax_backward<scalar_t, false>::apply(
+            grad_input, grad, output, dim);
+      });
+}
+
+static void log_softmax_backward_kernel_impl(
+    Tensor& grad_input,
+    const Tensor& grad,
+    const Tensor& output,
+    int64_t dim) {
+  AT_DISPATCH_FLOATING_TYPES(
+      grad.scalar_type(), "log_softmax_backward_kernel_impl", [&] {
+        vec_softmax_backward<scalar_t, true>::apply(
+            grad_input, grad, output, dim);
+      });
+}
+
+static void masked_softmax_kernel_impl(
+    Tensor& result,
+    const Tensor& self,
+    const Tensor& mask,
+    int64_t dim) {
+  AT_DISPATCH_FLOATING_TYPES(
+      self.scalar_type(), "masked_softmax_kernel_impl", [&] {
+        if (mask.scalar_type() == ScalarType::Bool) {
+          vec_masked_softmax<scalar_t, bool>::apply(result, self, mask, dim);
+        } else if (mask.scalar_type() == ScalarType::Byte) {
+          vec_masked_softmax<scalar_t, uint8_t>::apply(result, self, mask, dim);
+        } else {
+          vec_masked_softmax<scalar_t, scalar_t>::apply(
+              result, self, mask, dim);
+        }
+      });
+}
+
 } // anonymous namespace
 
 REGISTER_DISPATCH(softmax_lastdim_kernel, &softmax_lastdim_kernel_impl);
@@ -264,5 +837,12 @@ REGISTER_DISPATCH(
 REGISTER_DISPATCH(
     log_softmax_backward_lastdim_kernel,
     &log_softmax_backward_lastdim_kernel_impl);
+REGISTER_DISPATCH(softmax_kernel, &softmax_kernel_impl);
+REGISTER_DISPATCH(log_softmax_kernel, &log_softmax_kernel_impl);
+REGISTER_DISPATCH(softmax_backward_kernel, &softmax_backward_kernel_impl);
+REGISTER_DISPATCH(
+    log_softmax_backward_kernel,
+    &log_softmax_backward_kernel_impl);
+REGISTER_DISPATCH(masked_softmax_kernel, &masked_softmax_kernel_impl);
 
 }} // namespace at::native
@@ -8,11 +8,26 @@ namespace native {
 
 using forward_fn = void(*)(Tensor &, const Tensor &);
 using backward_fn = void(*)(Tensor &, const Tensor &, const Tensor&);
+using forward_fn_with_dim = void(*)(Tensor &, const Tensor &, int64_t);
+using backward_fn_with_dim =
+    void(*)(Tensor &, const Tensor &, const Tensor &, int64_t);
+// (output, input, mask, dim); the mask has been expanded to the input's sizes
+// and is either Bool/Byte or of the input's floating point type.
+using masked_softmax_fn =
+    void(*)(Tensor &, const Tensor &, const Tensor &, int64_t);
 
 DECLARE_DISPATCH(forward_fn, softmax_lastdim_kernel);
 DECLARE_DISPATCH(forward_fn, log_softmax_lastdim_kernel);
 DECLARE_DISPATCH(backward_fn, softmax_backward_lastdim_kernel);
 DECLARE_DISPATCH(backward_fn, log_softmax_backward_lastdim_kernel);
 
+// Softmax over any dimension but the last one.
+DECLARE_DISPATCH(forward_fn_with_dim, softmax_kernel);
+DECLARE_DISPATCH(forward_fn_with_dim, log_softmax_kernel);
+DECLARE_DISPATCH(backward_fn_with_dim, softmax_backward_kernel);
+DECLARE_DISPATCH(backward_fn_with_dim, log_softmax_backward_kernel);
+
+DECLARE_DISPATCH(masked_softmax_fn, masked_softmax_kernel);
+
 }
 }
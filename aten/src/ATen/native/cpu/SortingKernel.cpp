@@ -0,0 +1,299 @@
+#include <ATen/native/Sorting.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+
+namespace at { namespace native { namespace {
+
+// Maps a value to an unsigned key whose order is the order of the values, with
+// NaN above everything else, like TopKTypeConfig in cuda/SortingRadixSelect.cuh.
+// Sorting and selecting on the keys then only needs 8-bit histograms.
+template <typename scalar_t, bool is_floating = std::is_floating_point<scalar_t>::value>
+struct RadixKey {
+  using type = typename std::make_unsigned<scalar_t>::type;
+
+  static type convert(scalar_t v) {
+    type x = static_cast<type>(v);
+    if (std::is_signed<scalar_t>::value) {
+      x ^= type(1) << (sizeof(type) * 8 - 1);
+    }
+    return x;
+  }
+};
+
+template <typename scalar_t>
+struct RadixKey<scalar_t, true> {
+  using type = typename std::conditional<sizeof(scalar_t) == 4, uint32_t, uint64_t>::type;
+
+  static type convert(scalar_t v) {
+    if (v != v) {
+      return std::numeric_limits<type>::max();
+    }
+    if (v == 0) {
+      // -0 and 0 compare equal, keep them in index order
+      v = 0;
+    }
+    type x;
+    std::memcpy(&x, &v, sizeof(x));
+    type sign = type(1) << (sizeof(type) * 8 - 1);
+    return (x & sign) ? ~x : (x ^ sign);
+  }
+};
+
+constexpr int RADIX_BITS = 8;
+constexpr int RADIX_SIZE = 1 << RADIX_BITS;
+constexpr int RADIX_MASK = RADIX_SIZE - 1;
+// Rows shorter than this are insertion sorted
+constexpr int64_t RADIX_SORT_MIN_SIZE = 64;
+
+// Stable sort of (keys, values) by keys. keys_tmp and values_tmp are scratch
+// buffers of n elements.
+template <typename key_t>
+void radix_sort_pairs(
+    key_t* keys, int64_t* values, key_t* keys_tmp, int64_t* values_tmp,
+    int64_t n) {
+  if (n < RADIX_SORT_MIN_SIZE) {
+    for (int64_t i = 1; i < n; i++) {
+      key_t key = keys[i];
+      int64_t value = values[i];
+      int64_t j = i;
+      for (; j > 0 && keys[j - 1] > key; j--) {
+        keys[j] = keys[j - 1];
+        values[j] = values[j - 1];
+      }
+      keys[j] = key;
+      values[j] = value;
+    }
+    return;
+  }
+  key_t* src_keys = keys;
+  int64_t* src_values = values;
+  key_t* dst_keys = keys_tmp;
+  int64_t* dst_values = values_tmp;
+  for (int shift = 0; shift < static_cast<int>(sizeof(key_t) * 8); shift += RADIX_BITS) {
+    int64_t offsets[RADIX_SIZE] = {0};
+    for (int64_t i = 0; i < n; i++) {
+      offsets[(src_keys[i] >> shift) & RADIX_MASK]++;
+    }
+    // all the keys share this digit
+    if (offsets[(src_keys[0] >> shift) & RADIX_MASK] == n) {
+      continue;
+    }
+    int64_t total = 0;
+    for (int d = 0; d < RADIX_SIZE; d++) {
+      int64_t count = offsets[d];
+      offsets[d] = total;
+      total += count;
+    }
+    for (int64_t i = 0; i < n; i++) {
+      int64_t pos = offsets[(src_keys[i] >> shift) & RADIX_MASK]++;
+      dst_keys[pos] = src_keys[i];
+      dst_values[pos] = src_values[i];
+    }
+    std::swap(src_keys, dst_keys);
+    std::swap(src_values, dst_values);
+  }
+  if (src_keys != keys) {
+    std::memcpy(keys, src_keys, n * sizeof(key_t));
+    std::memcpy(values, src_values, n * sizeof(int64_t));
+  }
+}
+
+// Finds the k-th smallest (1-based) of the n keys one digit at a time, from
+// the most significant one, keeping only the keys that match the digits found
+// so far in buf. On return k is the rank of the result among the keys equal
+// to it, so the input has exactly (k on entry) - (k on return) smaller keys.
+template <typename key_t>
+key_t radix_select(const key_t* keys, key_t* buf, int64_t n, int64_t& k) {
+  const key_t* cur = keys;
+  key_t desired = 0;
+  for (int shift = sizeof(key_t) * 8 - RADIX_BITS; shift >= 0; shift -= RADIX_BITS) {
+    int64_t counts[RADIX_SIZE] = {0};
+    for (int64_t i = 0; i < n; i++) {
+      counts[(cur[i] >> shift) & RADIX_MASK]++;
+    }
+    int digit = 0;
+    for (; counts[digit] < k; digit++) {
+      k -= counts[digit];
+    }
+    desired |= static_cast<key_t>(digit) << shift;
+    if (counts[digit] == n) {
+      continue;
+    }
+    int64_t m = 0;
+    for (int64_t i = 0; i < n; i++) {
+      if (((cur[i] >> shift) & RADIX_MASK) == static_cast<key_t>(digit)) {
+        buf[m++] = cur[i];
+      }
+    }
+    cur = buf;
+    n = m;
+  }
+  return desired;
+}
+
+// Scratch buffers, reused for all the slices a thread handles
+template <typename key_t>
+struct RadixScratch {
+  std::vector<key_t> keys;
+  std::vector<int64_t> order;
+  std::vector<key_t> top_keys;
+  std::vector<int64_t> top_order;
+};
+
+// Calls f(scratch, self_data, values_data, indices_data) for every slice of
+// self along dim and the matching slices of values and indices, in parallel
+// over slices.
+template <typename scalar_t, typename Fn>
+void parallel_slices(
+    const Tensor& self, Tensor& values, Tensor& indices, int64_t dim,
+    const Fn& f) {
+  int64_t ndim = self.dim();
+  int64_t slice_size = self.size(dim);
+  int64_t slices = slice_size == 0 ? 0 : self.numel() / slice_size;
+  if (slices == 0) {
+    return;
+  }
+  const scalar_t* self_data = self.data<scalar_t>();
+  scalar_t* values_data = values.data<scalar_t>();
+  int64_t* indices_data = indices.data<int64_t>();
+  int64_t grain_size = std::max<int64_t>(internal::GRAIN_SIZE / slice_size, 1);
+  parallel_for(0, slices, grain_size, [&](int64_t begin, int64_t end) {
+    RadixScratch<typename RadixKey<scalar_t>::type> scratch;
+    for (int64_t s = begin; s < end; s++) {
+      int64_t idx = s;
+      int64_t self_offset = 0;
+      int64_t values_offset = 0;
+      int64_t indices_offset = 0;
+      for (int64_t d = ndim - 1; d >= 0; d--) {
+        if (d == dim) {
+          continue;
+        }
+        int64_t i = idx % self.size(d);
+        idx /= self.size(d);
+        self_offset += i * self.stride(d);
+        values_offset += i * values.stride(d);
+        indices_offset += i * indices.stride(d);
+      }
+      f(scratch, self_data + self_offset, values_data + values_offset,
+        indices_data + indices_offset);
+    }
+  });
+}
+
+static void sort_kernel(
+    Tensor& values, Tensor& indices, const Tensor& self, int64_t dim,
+    bool descending) {
+  AT_DISPATCH_ALL_TYPES(self.scalar_type(), "sort_cpu", [&] {
+    using key_t = typename RadixKey<scalar_t>::type;
+    int64_t n = self.size(dim);
+    int64_t self_stride = self.stride(dim);
+    int64_t values_stride = values.stride(dim);
+    int64_t indices_stride = indices.stride(dim);
+    parallel_slices<scalar_t>(self, values, indices, dim,
+        [&](RadixScratch<key_t>& scratch, const scalar_t* self_data,
+            scalar_t* values_data, int64_t* indices_data) {
+      auto& keys = scratch.keys;
+      auto& order = scratch.order;
+      keys.resize(2 * n);
+      order.resize(2 * n);
+      for (int64_t i = 0; i < n; i++) {
+        key_t key = RadixKey<scalar_t>::convert(self_data[i * self_stride]);
+        keys[i] = descending ? static_cast<key_t>(~key) : key;
+        order[i] = i;
+      }
+      radix_sort_pairs(keys.data(), order.data(), keys.data() + n, order.data() + n, n);
+      for (int64_t i = 0; i < n; i++) {
+        values_data[i * values_stride] = self_data[order[i] * self_stride];
+        indices_data[i * indices_stride] = order[i];
+      }
+    });
+  });
+}
+
+static void topk_kernel(
+    Tensor& values, Tensor& indices, const Tensor& self, int64_t k,
+    int64_t dim, bool largest, bool sorted) {
+  if (k == 0) {
+    return;
+  }
+  AT_DISPATCH_ALL_TYPES(self.scalar_type(), "topk_cpu", [&] {
+    using key_t = typename RadixKey<scalar_t>::type;
+    int64_t n = self.size(dim);
+    int64_t self_stride = self.stride(dim);
+    int64_t values_stride = values.stride(dim);
+    int64_t indices_stride = indices.stride(dim);
+    parallel_slices<scalar_t>(self, values, indices, dim,
+        [&](RadixScratch<key_t>& scratch, const scalar_t* self_data,
+            scalar_t* values_data, int64_t* indices_data) {
+      // select the k smallest keys; inverting them selects the largest values
+      auto& keys = scratch.keys;
+      keys.resize(2 * n);
+      for (int64_t i = 0; i < n; i++) {
+        key_t key = RadixKey<scalar_t>::convert(self_data[i * self_stride]);
+        keys[i] = largest ? static_cast<key_t>(~key) : key;
+      }
+      int64_t equal = k;
+      key_t kth = radix_select(keys.data(), keys.data() + n, n, equal);
+
+      auto& top_keys = scratch.top_keys;
+      auto& top_order = scratch.top_order;
+      top_keys.resize(2 * k);
+      top_order.resize(2 * k);
+      int64_t m = 0;
+      for (int64_t i = 0; i < n; i++) {
+        if (keys[i] < kth || (keys[i] == kth && equal > 0)) {
+          equal -= keys[i] == kth;
+          top_keys[m] = keys[i];
+          top_order[m] = i;
+          m++;
+        }
+      }
+      if (sorted) {
+        radix_sort_pairs(top_keys.data(), top_order.data(), top_keys.data() + k, top_order.data() + k, k);
+      }
+      for (int64_t i = 0; i < k; i++) {
+        values_data[i * values_stride] = self_data[top_order[i] * self_stride];
+        indices_data[i * indices_stride] = top_order[i];
+      }
+    });
+  });
+}
+
+static void kthvalue_kernel(
+    Tensor& values, Tensor& indices, const Tensor& self, int64_t k,
+    int64_t dim) {
+  AT_DISPATCH_ALL_TYPES(self.scalar_type(), "kthvalue_cpu", [&] {
+    using key_t = typename RadixKey<scalar_t>::type;
+    int64_t n = self.size(dim);
+    int64_t self_stride = self.stride(dim);
+    parallel_slices<scalar_t>(self, values, indices, dim,
+        [&](RadixScratch<key_t>& scratch, const scalar_t* self_data,
+            scalar_t* values_data, int64_t* indices_data) {
+      auto& keys = scratch.keys;
+      keys.resize(2 * n);
+      for (int64_t i = 0; i < n; i++) {
+        keys[i] = RadixKey<scalar_t>::convert(self_data[i * self_stride]);
+      }
+      int64_t rank = k;
+      key_t kth = radix_select(keys.data(), keys.data() + n, n, rank);
+      int64_t i = std::find(keys.begin(), keys.begin() + n, kth) - keys.begin();
+      *values_data = self_data[i * self_stride];
+      *indices_data = i;
+    });
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(sort_stub, &sort_kernel);
+REGISTER_DISPATCH(topk_stub, &topk_kernel);
+REGISTER_DISPATCH(kthvalue_stub, &kthvalue_kernel);
+
+}} // namespace at::native
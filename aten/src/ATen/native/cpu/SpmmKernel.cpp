@@ -0,0 +1,91 @@
+#include <ATen/native/sparse/SparseTensorMath.h>
+
+#include <algorithm>
+
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec256/vec256.h>
+
+namespace at { namespace native { namespace {
+
+// y += a * x over n elements
+template <typename scalar_t>
+inline void axpy(int64_t n, scalar_t a, const scalar_t* x, int64_t incx, scalar_t* y, int64_t incy) {
+  using Vec = vec256::Vec256<scalar_t>;
+  if (incx == 1 && incy == 1) {
+    const Vec a_vec(a);
+    int64_t k = 0;
+    for (; k + Vec::size() <= n; k += Vec::size()) {
+      (Vec::loadu(y + k) + a_vec * Vec::loadu(x + k)).store(y + k);
+    }
+    for (; k < n; k++) {
+      y[k] += a * x[k];
+    }
+  } else {
+    for (int64_t k = 0; k < n; k++) {
+      y[k * incy] += a * x[k * incx];
+    }
+  }
+}
+
+// The rows of S are split between tasks by their number of nonzeros, so that
+// matrices with a few dense rows, like the adjacency matrices of power law
+// graphs, keep every thread busy. A task owns whole rows of r.
+template <typename scalar_t>
+void spmm_kernel_impl(
+    Tensor& r, const Tensor& rowptr, const Tensor& order, const Tensor& cols,
+    const Tensor& values, const Tensor& dense, scalar_t alpha) {
+  const int64_t dim_i = rowptr.numel() - 1;
+  const int64_t dim_j = dense.size(0);
+  const int64_t dim_k = dense.size(1);
+  const int64_t nnz = cols.numel();
+  const int64_t* rowptr_data = rowptr.data<int64_t>();
+  const int64_t* order_data = order.defined() ? order.data<int64_t>() : nullptr;
+  const int64_t* cols_data = cols.data<int64_t>();
+  const int64_t cols_stride = cols.stride(0);
+  const scalar_t* values_data = values.data<scalar_t>();
+  const scalar_t* dense_data = dense.data<scalar_t>();
+  scalar_t* r_data = r.data<scalar_t>();
+  const int64_t dense_stride0 = dense.stride(0);
+  const int64_t dense_stride1 = dense.stride(1);
+  const int64_t r_stride0 = r.stride(0);
+  const int64_t r_stride1 = r.stride(1);
+
+  // first row of task c
+  const int64_t num_tasks = std::max<int64_t>(
+      std::min<int64_t>(dim_i, divup(nnz * dim_k, internal::GRAIN_SIZE)), 1);
+  auto task_start = [&](int64_t c) -> int64_t {
+    if (c >= num_tasks) {
+      return dim_i;
+    }
+    return std::lower_bound(rowptr_data, rowptr_data + dim_i, c * nnz / num_tasks) - rowptr_data;
+  };
+
+  parallel_for(0, num_tasks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t h = task_start(begin); h < task_start(end); h++) {
+      scalar_t* r_row = r_data + h * r_stride0;
+      for (int64_t e = rowptr_data[h]; e < rowptr_data[h + 1]; e++) {
+        const int64_t i = order_data == nullptr ? e : order_data[e];
+        const int64_t col = cols_data[i * cols_stride];
+        AT_CHECK(col >= 0 && col < dim_j,
+            "addmm: index out of column bound: ", col, " not between 1 and ", dim_j);
+        axpy<scalar_t>(dim_k, alpha * values_data[i],
+            dense_data + col * dense_stride0, dense_stride1, r_row, r_stride1);
+      }
+    }
+  });
+}
+
+void spmm_kernel(
+    Tensor& r, const Tensor& rowptr, const Tensor& order, const Tensor& cols,
+    const Tensor& values, const Tensor& dense, Scalar alpha) {
+  AT_DISPATCH_ALL_TYPES(values.scalar_type(), "addmm_sparse_dense", [&] {
+    spmm_kernel_impl<scalar_t>(r, rowptr, order, cols, values, dense, alpha.to<scalar_t>());
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(spmm_stub, &spmm_kernel);
+
+}} // namespace at::native
@@ -8,7 +8,7 @@
 #include <ATen/Parallel.h>
 
 #include <ATen/cpu/vml.h>
-#include <ATen/cpu/vec256/vec256.h>
+#include <ATen/cpu/vec512/vec512.h>
 #include <ATen/cpu/vec256/functional.h>
 
 #include <ATen/native/Distributions.h>
@@ -31,53 +31,62 @@ namespace {
 using namespace vec256;
 
 static void sigmoid_kernel(TensorIterator& iter) {
-  AT_DISPATCH_FLOATING_TYPES(iter.dtype(), "sigmoid_cpu", [&]() {
+  AT_DISPATCH_FLOATING_TYPES_AND2(at::ScalarType::Half, at::ScalarType::BFloat16,
+      iter.dtype(), "sigmoid_cpu", [&]() {
     unary_kernel_vec(
         iter,
         [=](scalar_t a) -> scalar_t { return (1 / (1 + std::exp((-a)))); },
-        [=](Vec256<scalar_t> a) {
-          a = Vec256<scalar_t>((scalar_t)(0)) - a;
+        [=](Vectorized<scalar_t> a) {
+          a = Vectorized<scalar_t>((scalar_t)(0)) - a;
           a = a.exp();
-          a = Vec256<scalar_t>((scalar_t)(1)) + a;
+          a = Vectorized<scalar_t>((scalar_t)(1)) + a;
           a = a.reciprocal();
           return a;
-        });
+        },
+        LoopCost::Expensive);
   });
 }
 
 static void abs_kernel(TensorIterator& iter) {
-  AT_DISPATCH_ALL_TYPES(iter.dtype(), "abs_cpu", [&]() {
+  AT_DISPATCH_ALL_TYPES_AND2(at::ScalarType::Half, at::ScalarType::BFloat16,
+      iter.dtype(), "abs_cpu", [&]() {
     unary_kernel_vec(
         iter,
         [=](scalar_t a) -> scalar_t { return std::abs(a); },
-        [=](Vec256<scalar_t> a) { return a.abs(); });
+        [=](Vectorized<scalar_t> a) { return a.abs(); },
+        LoopCost::Cheap);
   });
 }
 
 static void frac_kernel(TensorIterator& iter) {
-  AT_DISPATCH_FLOATING_TYPES(iter.dtype(), "frac_cpu", [&]() {
+  AT_DISPATCH_FLOATING_TYPES_AND2(at::ScalarType::Half, at::ScalarType::BFloat16,
+      iter.dtype(), "frac_cpu", [&]() {
     unary_kernel_vec(
         iter,
         [=](scalar_t a) -> scalar_t { return a - std::trunc(a); },
-        [=](Vec256<scalar_t> a) { return a.frac(); });
+        [=](Vectorized<scalar_t> a) { return a.frac(); },
+        LoopCost::Cheap);
   });
 }
 
 static void reciprocal_kernel(TensorIterator& iter) {
-  AT_DISPATCH_FLOATING_TYPES(iter.dtype(), "reciprocal_cpu", [&]() {
+  AT_DISPATCH_FLOATING_TYPES_AND2(at::ScalarType::Half, at::ScalarType::BFloat16,
+      iter.dtype(), "reciprocal_cpu", [&]() {
     unary_kernel_vec(
         iter,
         [=](scalar_t a) -> scalar_t { return decltype(a)(1.0) / a; },
-        [=](Vec256<scalar_t> a) { return a.reciprocal(); });
+        [=](Vectorized<scalar_t> a) { return a.reciprocal(); });
   });
 }
 
 static void neg_kernel(TensorIterator& iter) {
-  AT_DISPATCH_ALL_TYPES(iter.dtype(), "neg_cpu", [&]() {
+  AT_DISPATCH_ALL_TYPES_AND2(at::ScalarType::Half, at::ScalarType::BFloat16,
+      iter.dtype(), "neg_cpu", [&]() {
     unary_kernel_vec(
         iter,
         [=](scalar_t a) -> scalar_t { return -a; },
-        [=](Vec256<scalar_t> a) { return a.neg(); });
+        [=](Vectorized<scalar_t> a) { return a.neg(); },
+        LoopCost::Cheap);
   });
 }
 
@@ -140,20 +149,65 @@ void bernoulli_mkl_kernel(Tensor &self, const double p, Generator* gen) {
 #endif
 
 static void rsqrt_kernel(TensorIterator& iter) {
-  AT_DISPATCH_FLOATING_TYPES(iter.dtype(), "rsqrt_cpu", [&] {
+  AT_DISPATCH_FLOATING_TYPES_AND2(at::ScalarType::Half, at::ScalarType::BFloat16,
+      iter.dtype(), "rsqrt_cpu", [&] {
     unary_kernel_vec(
         iter,
         [=](scalar_t a) -> scalar_t {
           return ((scalar_t)1) / std::sqrt(a);
         },
-        [=](Vec256<scalar_t> a) { return a.rsqrt(); });
+        [=](Vectorized<scalar_t> a) { return a.rsqrt(); });
   });
 }
 
+// Half and BFloat16 have no VML functions of their own: they are widened to
+// float a chunk at a time, computed with the float function and narrowed back.
+template <typename scalar_t>
+static void reduced_float_vml_kernel(
+    TensorIterator& iter,
+    void (*vml_op)(float*, const float*, int64_t)) {
+  iter.serial_for_each(
+      [&](int ntensor, char** data_, const int64_t* strides, int64_t n) {
+        AT_ASSERT(ntensor == 2);
+        scalar_t* out_data = reinterpret_cast<scalar_t*>(data_[0]);
+        scalar_t* in_data = reinterpret_cast<scalar_t*>(data_[1]);
+        int64_t out_stride = strides[0] / sizeof(scalar_t);
+        int64_t in_stride = strides[1] / sizeof(scalar_t);
+        static constexpr int64_t WIDTH = 131072 / sizeof(float);
+        for (int64_t i = 0; i < n; i += WIDTH) {
+          float buffer[WIDTH];
+          int64_t width = WIDTH;
+          width = std::min(width, n - i);
+          if (in_stride == 1) {
+            vec256::convert(in_data + i, buffer, width);
+          } else {
+            for (int64_t j = 0; j < width; j++)
+              buffer[j] = in_data[in_stride * (i + j)];
+          }
+          vml_op(buffer, buffer, width);
+          if (out_stride == 1) {
+            vec256::convert(static_cast<const float*>(buffer), out_data + i, width);
+          } else {
+            for (int64_t j = 0; j < width; j++)
+              out_data[out_stride * (i + j)] = buffer[j];
+          }
+        }
+      },
+      {0, iter.numel()});
+}
+
 // TODO: Disable cont. branch to test more risky code
 
 #define IMPLEMENT_FLOAT_KERNEL(dispatchtypes, op)                             \
   static void op##_kernel(TensorIterator& iter) {                             \
+    if (iter.dtype() == ScalarType::Half) {                                   \
+      reduced_float_vml_kernel<at::Half>(iter, vml::v##op<float>);            \
+      return;                                                                 \
+    }                                                                         \
+    if (iter.dtype() == ScalarType::BFloat16) {                               \
+      reduced_float_vml_kernel<at::BFloat16>(iter, vml::v##op<float>);        \
+      return;                                                                 \
+    }                                                                         \
     AT_DISPATCH_FLOATING_TYPES(iter.dtype(), op##_vml_cpu, [&]() {            \
       iter.serial_for_each(                                                   \
           [&](int ntensor, char** data_, const int64_t* strides, int64_t n) { \
@@ -5,9 +5,16 @@
 #include <ATen/cuda/CUDAApplyUtils.cuh>
 #include <ATen/cuda/CUDAContext.h>
 #include <ATen/cuda/CUDAEvent.h>
+#include <ATen/cuda/PinnedMemoryAllocator.h>
 #include <c10/cuda/CUDAStream.h>
 #include <ATen/native/Copy.h>
 
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
 namespace {
 
 using namespace at;
@@ -243,10 +250,159 @@ void copy_to_cpu_async_(Tensor& dst, const Tensor& src) {
         cudaMemcpyDeviceToHost,
         stream));
     AT_CUDA_CHECK(THCCachingHostAllocator_recordEvent(
-        src.storage().data<scalar_t>(), stream));
+        dst.storage().data<scalar_t>(), stream));
   });
 }
 
+bool is_pinned(const Tensor& t) {
+  return t.storage().allocator() == at::cuda::getPinnedMemoryAllocator();
+}
+
+// Runs the host side of the staged non_blocking copies below, so that the
+// thread that issues them only has to enqueue the copy.
+class StagingThread {
+ public:
+  static StagingThread& get() {
+    // Leaked, so that the thread is never joined while CUDA is shutting down
+    static StagingThread* staging_thread = new StagingThread();
+    return *staging_thread;
+  }
+
+  std::shared_future<void> submit(std::function<void()> job) {
+    std::packaged_task<void()> task(std::move(job));
+    auto done = task.get_future().share();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      jobs_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+    return done;
+  }
+
+ private:
+  StagingThread() : thread_(&StagingThread::run, this) {
+    thread_.detach();
+  }
+
+  void run() {
+    for (;;) {
+      std::packaged_task<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !jobs_.empty(); });
+        task = std::move(jobs_.front());
+        jobs_.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::packaged_task<void()>> jobs_;
+  std::thread thread_;
+};
+
+// Stream callbacks run on a thread of the driver and must not call into
+// CUDA, so these only wait for or run copies between host tensors.
+void CUDART_CB wait_for_staging(cudaStream_t, cudaError_t, void* data) {
+  std::unique_ptr<std::shared_future<void>> done(static_cast<std::shared_future<void>*>(data));
+  try {
+    done->get();
+  } catch (const std::exception& e) {
+    AT_WARN("non_blocking copy to CUDA failed to stage its source: ", e.what());
+  }
+}
+
+void CUDART_CB unstage(cudaStream_t, cudaError_t status, void* data) {
+  std::unique_ptr<std::pair<Tensor, Tensor>> views(static_cast<std::pair<Tensor, Tensor>*>(data));
+  if (status != cudaSuccess) {
+    return;
+  }
+  try {
+    _copy_same_type_(views->first, views->second);
+  } catch (const std::exception& e) {
+    AT_WARN("non_blocking copy from CUDA failed to unstage its result: ", e.what());
+  }
+}
+
+// A non_blocking copy from a strided or pageable host tensor, through pinned
+// staging memory and without synchronizing with the stream.
+//
+// A pinned source must not be modified until the copy is done anyway, so it
+// is packed on the staging thread while the stream is still busy with
+// earlier work, and the stream waits for the packing before it copies.
+// A pageable source may be modified as soon as the copy returns, so it is
+// packed by the calling thread.
+void copy_from_cpu_staged_(Tensor& dst, const Tensor& src) {
+  if (dst.numel() == 0) {
+    return;
+  }
+
+  CUDAGuard device_guard(dst.device());
+  CUDAStream stream = getCurrentCUDAStream();
+
+  // Allocated from the caching host allocator, so the staging memory of
+  // copies of the same size is recycled once their copies have completed
+  Tensor staging = at::empty(src.sizes(), src.options().pinned_memory(true));
+  Tensor staging_view = at::from_blob(staging.data_ptr(), staging.sizes(), staging.options());
+  Tensor dst_contig = dst.is_contiguous() ? dst : at::empty(dst.sizes(), dst.options());
+
+  if (is_pinned(src)) {
+    auto done = StagingThread::get().submit([staging_view, src]() mutable {
+      _copy_same_type_(staging_view, src);
+    });
+    AT_CUDA_CHECK(cudaStreamAddCallback(
+        stream, wait_for_staging, new std::shared_future<void>(std::move(done)), 0));
+  } else {
+    _copy_same_type_(staging, src);
+  }
+  AT_CUDA_CHECK(cudaMemcpyAsync(
+      dst_contig.data_ptr(),
+      staging.data_ptr(),
+      src.numel() * src.element_size(),
+      cudaMemcpyHostToDevice,
+      stream));
+  AT_CUDA_CHECK(THCCachingHostAllocator_recordEvent(staging.storage().data(), stream));
+
+  if (!dst.is_same(dst_contig)) {
+    AT_DISPATCH_ALL_TYPES_AND2(at::ScalarType::Half, at::ScalarType::Bool, dst.scalar_type(), "copy_from_cpu_staged", [&]() {
+      copy_device_to_device<scalar_t, scalar_t>(dst, dst_contig);
+    });
+  }
+}
+
+// A non_blocking copy to a strided pinned tensor, or from a strided CUDA
+// tensor. The stream copies into pinned memory and then unpacks it into the
+// destination from a stream callback, so synchronizing with the stream also
+// waits for the unpacking.
+void copy_to_cpu_staged_(Tensor& dst, const Tensor& src) {
+  if (dst.numel() == 0) {
+    return;
+  }
+
+  CUDAGuard device_guard(src.device());
+  CUDAStream stream = getCurrentCUDAStream();
+
+  Tensor src_contig = src.contiguous();
+  Tensor staging = at::empty(src.sizes(), dst.options().pinned_memory(true));
+  AT_CUDA_CHECK(cudaMemcpyAsync(
+      staging.data_ptr(),
+      src_contig.data_ptr(),
+      src.numel() * src.element_size(),
+      cudaMemcpyDeviceToHost,
+      stream));
+
+  // Views that don't own their memory: the staging memory is only reused
+  // after the event recorded below, which follows the callback, and the
+  // destination is owned by the caller
+  auto views = new std::pair<Tensor, Tensor>(
+      at::from_blob(dst.data_ptr(), dst.sizes(), dst.strides(), dst.options()),
+      at::from_blob(staging.data_ptr(), staging.sizes(), staging.options()));
+  AT_CUDA_CHECK(cudaStreamAddCallback(stream, unstage, views, 0));
+  AT_CUDA_CHECK(THCCachingHostAllocator_recordEvent(staging.storage().data(), stream));
+}
+
 template <typename dst_T>
 void _copy__cuda(Tensor& dst, const Tensor& src, bool non_blocking) {
   AT_CHECK(dst.numel() == src.numel(), "sizes do not match");
@@ -255,8 +411,10 @@ void _copy__cuda(Tensor& dst, const Tensor& src, bool non_blocking) {
       copy_device_to_device<dst_T, scalar_t>(dst, src);
     } else if (dst.is_cuda()) {
       if (std::is_same<dst_T, scalar_t>::value) {
-        if (non_blocking) {
+        if (non_blocking && dst.is_contiguous() && src.is_contiguous() && is_pinned(src)) {
           copy_from_cpu_async_(dst, src);
+        } else if (non_blocking) {
+          copy_from_cpu_staged_(dst, src);
         } else {
           copy_from_cpu(dst, src);
         }
@@ -268,8 +426,13 @@ void _copy__cuda(Tensor& dst, const Tensor& src, bool non_blocking) {
       }
     } else {
       if (std::is_same<dst_T, scalar_t>::value) {
-        if (non_blocking) {
+        // Copies to pageable memory stay synchronous, as the destination
+        // would otherwise be filled behind the back of code that expects
+        // cudaMemcpyAsync semantics
+        if (non_blocking && is_pinned(dst) && dst.is_contiguous() && src.is_contiguous()) {
           copy_to_cpu_async_(dst, src);
+        } else if (non_blocking && is_pinned(dst)) {
+          copy_to_cpu_staged_(dst, src);
         } else {
           copy_to_cpu(dst, src);
         }
@@ -300,7 +463,7 @@ Tensor _s_copy_from_cuda(
     const Tensor& dst,
     bool non_blocking) {
   Tensor dst_ = dst;
-  _s_copy__cuda(dst_, self);
+  _s_copy__cuda(dst_, self, non_blocking);
   return dst;
 }
 
@@ -3,9 +3,11 @@
 #include <ATen/cuda/CUDAApplyUtils.cuh>
 #include <ATen/cuda/detail/IndexUtils.cuh>
 #include <ATen/cuda/detail/TensorInfo.cuh>
+#include <ATen/native/Dropout.h>
 #include <c10/macros/Macros.h>
 #include <curand_kernel.h>
 
+#include <THC/THCDeviceUtils.cuh>
 #include <THC/THCGeneral.h>
 #include <THC/THCTensorRandom.h>
 #include <THC/THCGenerator.hpp>
@@ -89,12 +91,131 @@ fused_dropout_kernel(cuda::detail::TensorInfo<scalar_t, IndexType> a,
   }
 }
 
+#if defined(__HIP_PLATFORM_HCC__)
+using mask_word_t = unsigned long long int;
+#else
+using mask_word_t = unsigned int;
+#endif
+
+// fused_dropout_kernel with the mask packed in bits: the mask bits of the
+// elements of a warp are the ballot of the warp, since the elements a warp
+// makes together are contiguous and aligned to its size. It draws the same
+// random numbers as fused_dropout_kernel.
+template <
+          typename scalar_t,
+          typename accscalar_t,
+          typename IndexType,
+          int ADims>
+#if __CUDA_ARCH__ >= 350
+C10_LAUNCH_BOUNDS_2(256, 8)
+#elif defined (__HIP_PLATFORM_HCC__)
+C10_LAUNCH_BOUNDS_2(256, 4)
+#endif
+__global__ void
+bitmask_dropout_kernel(cuda::detail::TensorInfo<scalar_t, IndexType> a,
+                       cuda::detail::TensorInfo<scalar_t, IndexType> b,
+                       mask_word_t* mask,
+                       IndexType totalElements, accscalar_t p, std::pair<uint64_t, uint64_t> seeds
+                       ) {
+
+  accscalar_t pinv = accscalar_t(1)/p;
+  IndexType idx = blockIdx.x * blockDim.x + threadIdx.x;
+  curandStatePhilox4_32_10_t state;
+    curand_init(
+        seeds.first,
+        idx,
+        seeds.second,
+        &state);
+  IndexType rounded_size = ((totalElements - 1)/(blockDim.x * gridDim.x * UNROLL)+1) *
+        blockDim.x * gridDim.x * UNROLL;
+  for (IndexType linearIndex = idx;
+       linearIndex < rounded_size;
+       linearIndex += gridDim.x * blockDim.x*UNROLL) {
+       float4 rand = curand_uniform4(&state);
+       scalar_t src[UNROLL];
+       rand.x = rand.x < p;
+       rand.y = rand.y < p;
+       rand.z = rand.z < p;
+       rand.w = rand.w < p;
+       for (int ii = 0; ii < UNROLL; ii++) {
+           IndexType li = linearIndex + blockDim.x * gridDim.x * ii;
+           if (li < totalElements) {
+               const IndexType aOffset =
+                   cuda::detail::IndexToOffset<scalar_t, IndexType, ADims>::get(li, a);
+               src[ii] = a.data[aOffset];
+           }
+       }
+       for (int ii = 0; ii < UNROLL; ii++) {
+           IndexType li = linearIndex + blockDim.x * gridDim.x * ii;
+           // all the threads of the warp take part in the ballot
+           mask_word_t bits = WARP_BALLOT((&rand.x)[ii] != 0);
+           if (li < totalElements) {
+               const IndexType bOffset =
+                   cuda::detail::IndexToOffset<scalar_t, IndexType, 1>::get(li, b);
+               b.data[bOffset] = (&rand.x)[ii] != 0 ? static_cast<scalar_t>(src[ii]*pinv) : scalar_t(0);
+               if (threadIdx.x % warpSize == 0) {
+                   mask[li / warpSize] = bits;
+               }
+           }
+       }
+       __syncthreads();
+  }
+}
+
 template<typename scalar_t, typename accscalar_t>
 void masked_scale_kernel(at::Tensor& ret, const at::Tensor src, const at::Tensor mask, accscalar_t scale){
    at::cuda::CUDA_tensor_apply3<scalar_t, scalar_t, uint8_t>(ret, src, mask, [scale]__device__(scalar_t& ret_val, const scalar_t& src_val, const uint8_t mask_val){
        ret_val = (float)mask_val * src_val * scale;
   });
 }
+// Each thread makes bytes of the mask, i.e. groups of 8 contiguous elements,
+// from two curand_uniform4.
+template <typename scalar_t, typename accscalar_t>
+#if __CUDA_ARCH__ >= 350
+C10_LAUNCH_BOUNDS_2(256, 8)
+#elif defined (__HIP_PLATFORM_HCC__)
+C10_LAUNCH_BOUNDS_2(256, 4)
+#endif
+__global__ void
+fused_bias_dropout_add_kernel(const scalar_t* input, const scalar_t* bias,
+                              const scalar_t* residual, scalar_t* output,
+                              uint8_t* mask, int64_t numel, int64_t bytes,
+                              int64_t bias_size,
+                              accscalar_t keep, accscalar_t scale,
+                              std::pair<uint64_t, uint64_t> seeds) {
+  int64_t idx = blockIdx.x * blockDim.x + threadIdx.x;
+  curandStatePhilox4_32_10_t state;
+  curand_init(seeds.first, idx, seeds.second, &state);
+  for (int64_t byte = idx; byte < bytes; byte += blockDim.x * gridDim.x) {
+    float4 rand_lo = curand_uniform4(&state);
+    float4 rand_hi = curand_uniform4(&state);
+    float rand[8] = {rand_lo.x, rand_lo.y, rand_lo.z, rand_lo.w,
+                     rand_hi.x, rand_hi.y, rand_hi.z, rand_hi.w};
+    uint8_t bits = 0;
+    for (int ii = 0; ii < 8; ii++) {
+      int64_t li = byte * 8 + ii;
+      if (li < numel) {
+        accscalar_t out = residual[li];
+        if (rand[ii] < keep) {
+          bits |= static_cast<uint8_t>(1 << ii);
+          out += (static_cast<accscalar_t>(input[li]) + bias[li % bias_size]) * scale;
+        }
+        output[li] = out;
+      }
+    }
+    mask[byte] = bits;
+  }
+}
+
+template <typename scalar_t, typename accscalar_t>
+__global__ void
+bitmask_scale_kernel(const scalar_t* src, const uint8_t* mask, scalar_t* ret,
+                     int64_t numel, accscalar_t scale) {
+  for (int64_t li = blockIdx.x * blockDim.x + threadIdx.x; li < numel;
+       li += blockDim.x * gridDim.x) {
+    ret[li] = (mask[li / 8] >> (li % 8) & 1) ? static_cast<scalar_t>(src[li] * scale) : scalar_t(0);
+  }
+}
 } //anonymous namespace
 
 std::tuple<Tensor,Tensor>
@@ -150,6 +271,60 @@ fused_dropout_cuda(const Tensor& self, double p, Generator * gen){
   return std::tuple<Tensor,Tensor>(ret, mask);
 }
 
+std::tuple<Tensor,Tensor>
+bitmask_dropout_cuda(const Tensor& self, double p, Generator * gen){
+  AT_CHECK(p >= 0 && p <= 1, "dropout probability has to be between 0 and 1, but got ", p);
+  Tensor ret = at::empty_like(self);
+  const int64_t nelem = self.numel();
+  Tensor mask = at::zeros({bitmask_size(nelem)}, self.options().dtype(kByte));
+  if (nelem == 0) {
+    return std::tuple<Tensor,Tensor>(ret, mask);
+  }
+  const int64_t block_size = 256;
+  unsigned int blocks_per_sm = at::cuda::getCurrentDeviceProperties()->maxThreadsPerMultiProcessor/block_size;
+  dim3 dim_block(block_size);
+  dim3 grid((nelem + block_size -1)/block_size);
+  grid.x = std::min((unsigned int)at::cuda::getCurrentDeviceProperties()->multiProcessorCount * blocks_per_sm, grid.x);
+//number of times random will be generated per thread, to offset philox counter in thc random state
+  int64_t counter_offset = ((nelem - 1)/(block_size*grid.x*UNROLL)+1)*UNROLL;
+  mask_word_t* mask_data = reinterpret_cast<mask_word_t*>(mask.data<uint8_t>());
+  if (cuda::detail::canUse32BitIndexMath(self)){
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(self.scalar_type(), "bitmask_dropout", [&] {
+      using accscalar_t = acc_type<scalar_t, true>;
+      accscalar_t pa = (accscalar_t)(1 - p);
+      auto self_info = cuda::detail::getTensorInfo<scalar_t, unsigned int>(self);
+      auto ret_info = cuda::detail::getTensorInfo<scalar_t, unsigned int>(ret);
+      self_info.collapseDims();
+      ret_info.collapseDims(); //ret is collapsed to 1d contiguous tensor
+      switch (self_info.dims) {
+        case 1:
+            bitmask_dropout_kernel<scalar_t, accscalar_t, unsigned int, 1><<<grid, dim_block, 0, at::cuda::getCurrentCUDAStream()>>>(self_info, ret_info, mask_data, nelem, pa, next_philox_seed(gen,counter_offset));
+            break;
+        default:
+            bitmask_dropout_kernel<scalar_t, accscalar_t, unsigned int, -1><<<grid, dim_block, 0, at::cuda::getCurrentCUDAStream()>>>(self_info, ret_info, mask_data, nelem, pa, next_philox_seed(gen,counter_offset));
+      }
+   });
+  } else {
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(self.scalar_type(), "bitmask_dropout", [&] {
+      using accscalar_t = acc_type<scalar_t, true>;
+      accscalar_t pa = (accscalar_t)(1 - p);
+      auto self_info = cuda::detail::getTensorInfo<scalar_t, uint64_t>(self);
+      auto ret_info = cuda::detail::getTensorInfo<scalar_t, uint64_t>(ret);
+      self_info.collapseDims();
+      ret_info.collapseDims(); //ret is collapsed to 1d contiguous tensor
+      switch (self_info.dims) {
+        case 1:
+            bitmask_dropout_kernel<scalar_t, accscalar_t, uint64_t, 1><<<grid, dim_block, 0, at::cuda::getCurrentCUDAStream()>>>(self_info, ret_info, mask_data, nelem, pa, next_philox_seed(gen,counter_offset));
+            break;
+        default:
+            bitmask_dropout_kernel<scalar_t, accscalar_t, uint64_t, -1><<<grid, dim_block, 0, at::cuda::getCurrentCUDAStream()>>>(self_info, ret_info, mask_data, nelem, pa, next_philox_seed(gen,counter_offset));
+      }
+   });
+  }
+  THCudaCheck(cudaGetLastError());
+  return std::tuple<Tensor,Tensor>(ret, mask);
+}
+
 Tensor masked_scale_cuda(const Tensor& self, const Tensor& mask, double scale){
    Tensor ret = at::empty_like(self);
    AT_CHECK(mask.scalar_type() == at::ScalarType::Byte, "mask should be torch.uint8 dtype");
@@ -161,5 +336,60 @@ Tensor masked_scale_cuda(const Tensor& self, const Tensor& mask, double scale){
   return ret;
 }
 
+std::tuple<Tensor,Tensor>
+fused_bias_dropout_add_cuda(const Tensor& self, const Tensor& bias, const Tensor& residual, double p, Generator * gen){
+  check_fused_bias_dropout_add(self, bias, residual, p);
+  Tensor input = self.contiguous();
+  Tensor bias_ = bias.contiguous();
+  Tensor residual_ = residual.contiguous();
+  Tensor ret = at::empty_like(input);
+  const int64_t nelem = input.numel();
+  Tensor mask = at::empty({bitmask_size(nelem)}, input.options().dtype(kByte));
+  if (nelem == 0) {
+    return std::tuple<Tensor,Tensor>(ret, mask);
+  }
+  const int64_t block_size = 256;
+  unsigned int blocks_per_sm = at::cuda::getCurrentDeviceProperties()->maxThreadsPerMultiProcessor/block_size;
+  dim3 dim_block(block_size);
+  dim3 grid((mask.numel() + block_size -1)/block_size);
+  grid.x = std::min((unsigned int)at::cuda::getCurrentDeviceProperties()->multiProcessorCount * blocks_per_sm, grid.x);
+//number of times random will be generated per thread, to offset philox counter in thc random state
+  int64_t counter_offset = ((mask.numel() - 1)/(block_size*grid.x)+1)*8;
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(input.scalar_type(), "fused_bias_dropout_add", [&] {
+      using accscalar_t = acc_type<scalar_t, true>;
+      fused_bias_dropout_add_kernel<scalar_t, accscalar_t><<<grid, dim_block, 0, at::cuda::getCurrentCUDAStream()>>>(
+          input.data<scalar_t>(), bias_.data<scalar_t>(), residual_.data<scalar_t>(),
+          ret.data<scalar_t>(), mask.data<uint8_t>(), nelem, mask.numel(), bias_.numel(),
+          static_cast<accscalar_t>(1 - p), static_cast<accscalar_t>(dropout_scale(p)),
+          next_philox_seed(gen, counter_offset));
+  });
+  THCudaCheck(cudaGetLastError());
+  return std::tuple<Tensor,Tensor>(ret, mask);
+}
+
+Tensor bitmask_scale_cuda(const Tensor& self, const Tensor& mask, double scale){
+  check_bitmask(self, mask);
+  Tensor input = self.contiguous();
+  Tensor mask_ = mask.contiguous();
+  Tensor ret = at::empty_like(input);
+  const int64_t nelem = input.numel();
+  if (nelem == 0) {
+    return ret;
+  }
+  const int64_t block_size = 256;
+  unsigned int blocks_per_sm = at::cuda::getCurrentDeviceProperties()->maxThreadsPerMultiProcessor/block_size;
+  dim3 dim_block(block_size);
+  dim3 grid((nelem + block_size -1)/block_size);
+  grid.x = std::min((unsigned int)at::cuda::getCurrentDeviceProperties()->multiProcessorCount * blocks_per_sm, grid.x);
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(input.scalar_type(), "bitmask_scale", [&] {
+      using accscalar_t = acc_type<scalar_t, true>;
+      bitmask_scale_kernel<scalar_t, accscalar_t><<<grid, dim_block, 0, at::cuda::getCurrentCUDAStream()>>>(
+          input.data<scalar_t>(), mask_.data<uint8_t>(), ret.data<scalar_t>(), nelem,
+          static_cast<accscalar_t>(scale));
+  });
+  THCudaCheck(cudaGetLastError());
+  return ret;
+}
+
 }
 }
@@ -104,6 +104,132 @@ __global__ void EmbeddingBag_updateOutputKernel(
   }
 }
 
+template <typename scalar_t, int vec_size>
+struct alignas(sizeof(scalar_t) * vec_size) aligned_vector {
+  scalar_t val[vec_size];
+};
+
+// This kernel assumes that all input tensors except `weight` and
+// per_sample_weights are contiguous, that the rows of `weight` are
+// contiguous, and that featureSize and weight_stride0 are multiples of
+// vec_size with `weight` aligned to vec_size elements.
+template <typename scalar_t, int vec_size>
+__global__ void EmbeddingBag_updateOutputKernel_warpPerBag(
+    int64_t *input, int64_t *offsets, scalar_t *weight, scalar_t *output,
+    int64_t *offset2bag, int64_t numIndices, int64_t numBags,
+    int64_t featureSize, int64_t weight_stride0,
+    int mode, int64_t *bag_size, int64_t *max_indices,
+    scalar_t* per_sample_weights, int64_t per_sample_weights_stride) {
+
+  // the strategy here is that each bag is handled by a single warp, whose
+  // lanes load vec_size consecutive features of a row at once
+
+  using accscalar_t = acc_type<scalar_t, true>;
+  using vec_t = aligned_vector<scalar_t, vec_size>;
+  int64_t warpOffset = blockIdx.x * blockDim.y + threadIdx.y;
+  int64_t warpStride = gridDim.x * blockDim.y;
+
+  for (int64_t bag = warpOffset; bag < numBags; bag += warpStride) {
+    int64_t begin = offsets[bag];
+    int64_t end = (bag < numBags - 1) ? (offsets[bag + 1]) : numIndices;
+    assert(end >= begin);
+
+    for (int64_t emb = begin + threadIdx.x; emb < end; emb += WARP_SIZE) {
+      offset2bag[emb] = bag;
+    }
+    if (mode == MODE_MEAN && threadIdx.x == 0) {
+      bag_size[bag] = end - begin;
+    }
+
+    for (int64_t featureDim = threadIdx.x * vec_size; featureDim < featureSize;
+         featureDim += WARP_SIZE * vec_size) {
+      accscalar_t weightFeatSum[vec_size];
+      scalar_t weightFeatMax[vec_size];
+      int64_t maxWord[vec_size];
+#pragma unroll
+      for (int ii = 0; ii < vec_size; ii++) {
+        weightFeatSum[ii] = 0;
+        maxWord[ii] = -1;
+      }
+
+      for (int64_t emb = begin; emb < end; emb++) {
+        const int64_t word = input[emb];
+        vec_t weightValue = *reinterpret_cast<vec_t*>(&weight[word * weight_stride0 + featureDim]);
+
+        if (mode == MODE_MAX) {
+#pragma unroll
+          for (int ii = 0; ii < vec_size; ii++) {
+            if (emb == begin || weightValue.val[ii] > weightFeatMax[ii]) {
+              weightFeatMax[ii] = weightValue.val[ii];
+              maxWord[ii] = word;
+            }
+          }
+        } else {
+          accscalar_t scaleWeightBy = per_sample_weights
+              ? static_cast<accscalar_t>(per_sample_weights[emb * per_sample_weights_stride])
+              : static_cast<accscalar_t>(1);
+#pragma unroll
+          for (int ii = 0; ii < vec_size; ii++) {
+            weightFeatSum[ii] += scaleWeightBy * static_cast<accscalar_t>(weightValue.val[ii]);
+          }
+        }
+      }
+
+      vec_t outputValue;
+#pragma unroll
+      for (int ii = 0; ii < vec_size; ii++) {
+        if (mode == MODE_MAX) {
+          // If bag is empty, set output to 0.
+          outputValue.val[ii] = (end == begin) ? static_cast<scalar_t>(0) : weightFeatMax[ii];
+          max_indices[bag * featureSize + featureDim + ii] = maxWord[ii];
+        } else {
+          if (mode == MODE_MEAN && end != begin) {
+            weightFeatSum[ii] = weightFeatSum[ii] / static_cast<accscalar_t>(end - begin);
+          }
+          outputValue.val[ii] = static_cast<scalar_t>(weightFeatSum[ii]);
+        }
+      }
+      *reinterpret_cast<vec_t*>(&output[bag * featureSize + featureDim]) = outputValue;
+    }
+  }
+}
+
+template <typename scalar_t>
+void embedding_bag_update_output_warp_per_bag(
+    const Tensor &indices, const Tensor &offsets, const Tensor &weight,
+    Tensor &output, Tensor &offset2bag, int mode, Tensor &bag_size,
+    Tensor &max_indices, const Tensor &per_sample_weights) {
+  constexpr int max_vec_size = 16 / sizeof(scalar_t);
+  int64_t featureSize = weight.size(1);
+  bool can_vectorize =
+      featureSize % max_vec_size == 0 &&
+      weight.stride(0) % max_vec_size == 0 &&
+      reinterpret_cast<uintptr_t>(weight.data_ptr()) % 16 == 0;
+
+  int64_t numBags = offsets.size(0);
+  dim3 block = dim3(WARP_SIZE, 8);
+  dim3 grid = dim3(std::min<int64_t>(THCCeilDiv(numBags, (int64_t)block.y), 65535));
+  cudaStream_t stream = at::cuda::getCurrentCUDAStream();
+
+#define WARP_PER_BAG_KERNEL(VEC_SIZE)                                              \
+  EmbeddingBag_updateOutputKernel_warpPerBag<scalar_t, VEC_SIZE>                   \
+      <<<grid, block, 0, stream>>>(                                                \
+          indices.data<int64_t>(), offsets.data<int64_t>(),                        \
+          weight.data<scalar_t>(), output.data<scalar_t>(),                        \
+          offset2bag.data<int64_t>(), indices.size(0), numBags, featureSize,       \
+          weight.stride(0), mode, bag_size.data<int64_t>(),                        \
+          mode == MODE_MAX ? max_indices.data<int64_t>() : NULL,                   \
+          per_sample_weights.defined() ? per_sample_weights.data<scalar_t>() : NULL, \
+          per_sample_weights.defined() ? per_sample_weights.stride(0) : 0)
+
+  if (can_vectorize) {
+    WARP_PER_BAG_KERNEL(max_vec_size);
+  } else {
+    WARP_PER_BAG_KERNEL(1);
+  }
+#undef WARP_PER_BAG_KERNEL
+}
+
 // FIXME: removed the accGradParametersKernelByFeature case present in
 // LookupTable. That kernel is faster at small sizes (<768 indices), which
 // does not need EmbeddingBag (LookupTable + Sum works fine), but would
@@ -185,6 +311,65 @@ __global__ void EmbeddingBag_accGradParametersKernel_sum_avg(
 }
 
 
+// This kernel assumes that all input tensors are contiguous.
+template <typename scalar_t>
+__global__ void EmbeddingBag_accGradParametersKernel_sum_avg_atomic(
+    int64_t *input, scalar_t *gradOutput, scalar_t *gradWeight,
+    int64_t *offset2bag, ptrdiff_t numel, int64_t stride, int mode,
+    const int64_t *bag_size, scalar_t* per_sample_weights,
+    int64_t per_sample_weights_stride) {
+
+  // Each warp adds the gradient of its bag to the row of an input; inputs
+  // that share a row collide in the atomics.
+
+  using accscalar_t = acc_type<scalar_t, true>;
+  int64_t warpOffset = blockIdx.x * blockDim.y + threadIdx.y;
+  int64_t warpStride = gridDim.x * blockDim.y;
+
+  for (int64_t idx = warpOffset; idx < numel; idx += warpStride) {
+    const int64_t bag = offset2bag[idx];
+    accscalar_t scale = per_sample_weights
+        ? static_cast<accscalar_t>(per_sample_weights[idx * per_sample_weights_stride])
+        : static_cast<accscalar_t>(1);
+    if (mode == MODE_MEAN) {
+      scale /= bag_size[bag];
+    }
+    scalar_t *weightRow = gradWeight + input[idx] * stride;
+    scalar_t *gradRow = gradOutput + bag * stride;
+    for (int64_t featureDim = threadIdx.x; featureDim < stride; featureDim += WARP_SIZE) {
+      atomicAdd(&weightRow[featureDim],
+                static_cast<scalar_t>(static_cast<accscalar_t>(gradRow[featureDim]) * scale));
+    }
+  }
+}
+
+__global__ void EmbeddingBag_countIndicesKernel(
+    int64_t *input, ptrdiff_t numel, int *count) {
+  for (int64_t idx = blockIdx.x * (int64_t)blockDim.x + threadIdx.x; idx < numel;
+       idx += gridDim.x * (int64_t)blockDim.x) {
+    atomicAdd(&count[input[idx]], 1);
+  }
+}
+
+// The atomics of the inputs that share a row serialize, while the sorted
+// path accumulates them in the registers of a single warp but has to sort
+// all of the indices first. Past this many inputs on one row the sort wins.
+const int ATOMIC_BACKWARD_MAX_DUPLICATES = 32;
+
+// Returns the largest number of times any row is referenced by `indices`.
+static int64_t embedding_bag_max_duplicates(const Tensor &indices, int64_t num_weights) {
+  auto count = at::zeros({num_weights}, indices.options().dtype(kInt));
+  ptrdiff_t numel = indices.numel();
+  cudaStream_t stream = at::cuda::getCurrentCUDAStream();
+  dim3 block(256);
+  dim3 grid(std::min<ptrdiff_t>(THCCeilDiv(numel, (ptrdiff_t)256), 4096));
+  EmbeddingBag_countIndicesKernel<<<grid, block, 0, stream>>>(
+      indices.data<int64_t>(), numel, count.data<int>());
+  THCudaCheck(cudaGetLastError());
+  return count.max().item<int64_t>();
+}
+
+
 Tensor embedding_bag_backward_cuda_sum_avg(
                                    const Tensor &grad,
                                    const Tensor &indices,
@@ -207,6 +392,25 @@ Tensor embedding_bag_backward_cuda_sum_avg(
 
   int64_t stride = grad_weight.stride(0);
 
+  // Scaling by frequency needs the counts from the sorted indices
+  if (!scale_grad_by_freq &&
+      embedding_bag_max_duplicates(indices, num_weights) <= ATOMIC_BACKWARD_MAX_DUPLICATES) {
+    dim3 block(WARP_SIZE, 8);
+    dim3 grid(std::min<ptrdiff_t>(THCCeilDiv(numel, (ptrdiff_t)8), 65535));
+    AT_DISPATCH_FLOATING_TYPES_AND_HALF(
+        grad.scalar_type(), "embedding_bag_backward_cuda_sum_avg_atomic_kernel", [&] {
+          EmbeddingBag_accGradParametersKernel_sum_avg_atomic<
+              scalar_t><<<grid, block, 0, stream>>>(
+              indices.data<int64_t>(), grad.data<scalar_t>(),
+              grad_weight.data<scalar_t>(), offset2bag.data<int64_t>(),
+              numel, stride, mode, bag_size.data<int64_t>(),
+              per_sample_weights.defined() ? per_sample_weights.data<scalar_t>() : NULL,
+              per_sample_weights.defined() ? per_sample_weights.stride(0) : 0);
+        });
+    THCudaCheck(cudaGetLastError());
+    return grad_weight;
+  }
+
   auto sorted_indices = at::empty_like(indices);
   auto orig_indices = at::empty_like(indices);
   using device_ptr = thrust::device_ptr<int64_t>;
@@ -367,6 +571,22 @@ _embedding_bag_cuda(const Tensor &weight, const Tensor &indices,
     max_indices = at::zeros({0}, indices.options());
   }
 
+  // A warp per bag reads the indices of a bag once and can load whole
+  // vectors of a row, but only keeps the device busy if there are enough
+  // bags; otherwise the bags are also split over their features below.
+  auto prop = at::cuda::getCurrentDeviceProperties();
+  int64_t resident_warps = (int64_t)prop->multiProcessorCount *
+                           prop->maxThreadsPerMultiProcessor / WARP_SIZE;
+  if (weight.stride(1) == 1 && numBags >= resident_warps) {
+    AT_DISPATCH_FLOATING_TYPES_AND_HALF(weight.scalar_type(), "embedding_bag_cuda", [&] {
+      embedding_bag_update_output_warp_per_bag<scalar_t>(
+          indices, offsets, weight, output, offset2bag, mode, bag_size,
+          max_indices, per_sample_weights);
+    });
+    THCudaCheck(cudaGetLastError());
+    return std::tuple<Tensor, Tensor, Tensor, Tensor>(output, offset2bag, bag_size, max_indices);
+  }
+
   dim3 block = dim3(32, 8);
   int grid = 1024;
   AT_DISPATCH_FLOATING_TYPES_AND_HALF(weight.scalar_type(), "embedding_bag_cuda", [&] {
@@ -0,0 +1,60 @@
+#include <ATen/native/FusedOptimizers.h>
+
+#include <ATen/AccumulateType.h>
+#include <ATen/Dispatch.h>
+#include <ATen/native/FusedOptimizerOps.h>
+#include <ATen/native/cuda/MultiTensorApply.cuh>
+
+namespace at { namespace native { namespace {
+
+void fused_sgd_kernel_cuda(
+    TensorList params, TensorList grads, TensorList momentum_buffers,
+    double lr, double weight_decay, double momentum, double dampening,
+    bool nesterov) {
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(params[0].scalar_type(), "fused_sgd_step", [&] {
+    using acc_t = acc_type<scalar_t, true>;
+    SGDStepOp<scalar_t, acc_t> op{
+        static_cast<acc_t>(lr), static_cast<acc_t>(weight_decay),
+        static_cast<acc_t>(momentum), static_cast<acc_t>(dampening),
+        nesterov};
+    multi_tensor_apply<3, scalar_t>({{params, grads, momentum_buffers}}, op);
+  });
+}
+
+void fused_adam_kernel_cuda(
+    TensorList params, TensorList grads, TensorList exp_avgs,
+    TensorList exp_avg_sqs, TensorList max_exp_avg_sqs, double step_size,
+    double beta1, double beta2, double eps, double weight_decay) {
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(params[0].scalar_type(), "fused_adam_step", [&] {
+    using acc_t = acc_type<scalar_t, true>;
+    AdamStepOp<scalar_t, acc_t> op{
+        static_cast<acc_t>(step_size), static_cast<acc_t>(beta1),
+        static_cast<acc_t>(beta2), static_cast<acc_t>(eps),
+        static_cast<acc_t>(weight_decay)};
+    multi_tensor_apply<5, scalar_t>(
+        {{params, grads, exp_avgs, exp_avg_sqs, max_exp_avg_sqs}}, op);
+  });
+}
+
+void fused_rmsprop_kernel_cuda(
+    TensorList params, TensorList grads, TensorList square_avgs,
+    TensorList grad_avgs, TensorList momentum_buffers, double lr,
+    double alpha, double eps, double weight_decay, double momentum) {
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(params[0].scalar_type(), "fused_rmsprop_step", [&] {
+    using acc_t = acc_type<scalar_t, true>;
+    RMSpropStepOp<scalar_t, acc_t> op{
+        static_cast<acc_t>(lr), static_cast<acc_t>(alpha),
+        static_cast<acc_t>(eps), static_cast<acc_t>(weight_decay),
+        static_cast<acc_t>(momentum)};
+    multi_tensor_apply<5, scalar_t>(
+        {{params, grads, square_avgs, grad_avgs, momentum_buffers}}, op);
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(fused_sgd_stub, &fused_sgd_kernel_cuda);
+REGISTER_DISPATCH(fused_adam_stub, &fused_adam_kernel_cuda);
+REGISTER_DISPATCH(fused_rmsprop_stub, &fused_rmsprop_kernel_cuda);
+
+}} // namespace at::native
@@ -7,6 +7,9 @@
 #include <ATen/native/TensorIterator.h>
 #include <c10/macros/Macros.h>
 
+#include <algorithm>
+#include <cstdint>
+
 // Marks a lambda as executable on both the host and device. The __host__
 // attribute is important so that we can access static type information from
 // the host, even if the function is typically only executed on the device.
@@ -72,6 +75,92 @@ static void launch_kernel(int64_t N, const func_t& f) {
   AT_CUDA_CHECK(cudaGetLastError());
 }
 
+// Vectorized loops for contiguous inputs and outputs. Each thread loads
+// vec_size elements of every operand with a single load of up to 128 bits
+// (e.g. a float4, or four halfs), applies f to each and stores the results
+// with a single store. The elements after the last whole vector are handled
+// one per thread by the first threads of the grid.
+template<typename scalar_t, int vec_size>
+struct alignas(sizeof(scalar_t) * vec_size) aligned_vector {
+  scalar_t val[vec_size];
+};
+
+template<typename scalar_t>
+constexpr int max_scalar_size() {
+  return sizeof(scalar_t);
+}
+
+template<typename scalar_t, typename next_t, typename... rest_t>
+constexpr int max_scalar_size() {
+  return sizeof(scalar_t) > max_scalar_size<next_t, rest_t...>()
+      ? sizeof(scalar_t) : max_scalar_size<next_t, rest_t...>();
+}
+
+// The number of elements of each operand a thread loads at once, so that the
+// widest operand is loaded 16 bytes at a time.
+template<typename... args_t>
+constexpr int vectorized_loop_size() {
+  return 16 / max_scalar_size<args_t...>() < 8 ? 16 / max_scalar_size<args_t...>() : 8;
+}
+
+template<int vec_size, typename scalar_t>
+static bool is_vector_aligned(const void* ptr) {
+  return reinterpret_cast<uintptr_t>(ptr) % (sizeof(scalar_t) * vec_size) == 0;
+}
+
+template<int vec_size, typename func_t, typename arg0_t, typename arg1_t>
+C10_LAUNCH_BOUNDS_1(launch_size_1d)
+__global__ void vectorized_unary_kernel(int N, func_t f, arg0_t* out, const arg1_t* in1) {
+  using out_vec_t = aligned_vector<arg0_t, vec_size>;
+  using in1_vec_t = aligned_vector<arg1_t, vec_size>;
+  int num_vecs = N / vec_size;
+  int idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (idx < num_vecs) {
+    in1_vec_t a = reinterpret_cast<const in1_vec_t*>(in1)[idx];
+    out_vec_t r;
+    #pragma unroll
+    for (int i = 0; i < vec_size; i++) {
+      r.val[i] = f(a.val[i]);
+    }
+    reinterpret_cast<out_vec_t*>(out)[idx] = r;
+  }
+  int tail = num_vecs * vec_size + idx;
+  if (idx < vec_size && tail < N) {
+    out[tail] = f(in1[tail]);
+  }
+}
+
+template<int vec_size, typename func_t, typename arg0_t, typename arg1_t, typename arg2_t>
+C10_LAUNCH_BOUNDS_1(launch_size_1d)
+__global__ void vectorized_binary_kernel(int N, func_t f, arg0_t* out, const arg1_t* in1, const arg2_t* in2) {
+  using out_vec_t = aligned_vector<arg0_t, vec_size>;
+  using in1_vec_t = aligned_vector<arg1_t, vec_size>;
+  using in2_vec_t = aligned_vector<arg2_t, vec_size>;
+  int num_vecs = N / vec_size;
+  int idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (idx < num_vecs) {
+    in1_vec_t a = reinterpret_cast<const in1_vec_t*>(in1)[idx];
+    in2_vec_t b = reinterpret_cast<const in2_vec_t*>(in2)[idx];
+    out_vec_t r;
+    #pragma unroll
+    for (int i = 0; i < vec_size; i++) {
+      r.val[i] = f(a.val[i], b.val[i]);
+    }
+    reinterpret_cast<out_vec_t*>(out)[idx] = r;
+  }
+  int tail = num_vecs * vec_size + idx;
+  if (idx < vec_size && tail < N) {
+    out[tail] = f(in1[tail], in2[tail]);
+  }
+}
+
+// Enough blocks for one vector per thread, and at least one for the tail
+template<int vec_size>
+static dim3 vectorized_grid(int64_t N) {
+  int64_t num_vecs = N / vec_size;
+  return dim3(std::max<int64_t>((num_vecs + launch_size_1d - 1) / launch_size_1d, 1));
+}
+
 template<typename func_t>
 void gpu_nullary_kernel(TensorIterator& iter, const func_t& f) {
   ASSERT_HOST_DEVICE_LAMBDA(func_t);
@@ -141,6 +230,16 @@ void gpu_unary_kernel(TensorIterator& iter, const func_t& f) {
     auto strides = iter.get_inner_strides();
     int stride0 = strides[0];
     int stride1 = strides[1];
+    constexpr int vec_size = vectorized_loop_size<arg0_t, arg1_t>();
+    if (vec_size > 1 && stride0 == sizeof(arg0_t) && stride1 == sizeof(arg1_t) &&
+        is_vector_aligned<vec_size, arg0_t>(out_data) &&
+        is_vector_aligned<vec_size, arg1_t>(in1_data)) {
+      auto stream = at::cuda::getCurrentCUDAStream();
+      vectorized_unary_kernel<vec_size><<<vectorized_grid<vec_size>(numel), launch_size_1d, 0, stream>>>(
+          numel, f, (arg0_t*)out_data, (const arg1_t*)in1_data);
+      AT_CUDA_CHECK(cudaGetLastError());
+      return;
+    }
     launch_kernel<launch_size_1d, 1>(numel, [out_data, stride0, stride1, in1_data, f]__device__(int idx) {
       arg0_t* out = (arg0_t*)&out_data[stride0 * idx];
       arg1_t* in1 = (arg1_t*)&in1_data[stride1 * idx];
@@ -198,6 +297,18 @@ void gpu_binary_kernel(TensorIterator& iter, const func_t& f) {
     int stride0 = strides[0];
     int stride1 = strides[1];
     int stride2 = strides[2];
+    constexpr int vec_size = vectorized_loop_size<arg0_t, arg1_t, arg2_t>();
+    if (vec_size > 1 && stride0 == sizeof(arg0_t) && stride1 == sizeof(arg1_t) &&
+        stride2 == sizeof(arg2_t) &&
+        is_vector_aligned<vec_size, arg0_t>(out_data) &&
+        is_vector_aligned<vec_size, arg1_t>(in1_data) &&
+        is_vector_aligned<vec_size, arg2_t>(in2_data)) {
+      auto stream = at::cuda::getCurrentCUDAStream();
+      vectorized_binary_kernel<vec_size><<<vectorized_grid<vec_size>(numel), launch_size_1d, 0, stream>>>(
+          numel, f, (arg0_t*)out_data, (const arg1_t*)in1_data, (const arg2_t*)in2_data);
+      AT_CUDA_CHECK(cudaGetLastError());
+      return;
+    }
     launch_kernel<launch_size_1d, 1>(numel, [stride0, stride1, out_data, in1_data, f, stride2, in2_data]__device__(int idx) {
       arg0_t* out = (arg0_t*)&out_data[stride0 * idx];
       arg1_t* in1 = (arg1_t*)&in1_data[stride1 * idx];
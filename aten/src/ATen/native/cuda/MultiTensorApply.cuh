@@ -0,0 +1,110 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/cuda/CUDAContext.h>
+#include <ATen/cuda/Exceptions.h>
+
+#include <array>
+
+namespace at { namespace native {
+
+// Applies an element-wise op to lists of tensors with as few kernel launches
+// as possible: every block of a launch handles a chunk of kChunkSize elements
+// of one of the tensors, and the addresses of the tensors a launch handles
+// are passed by value in its arguments, so a launch covers up to
+// kMaxBlocks chunks of up to kMaxTensors<depth> tensors.
+
+namespace multi_tensor_apply_detail {
+
+constexpr int kChunkSize = 65536;
+constexpr int kNumThreads = 512;
+constexpr int kMaxBlocks = 320;
+
+// Kernel arguments are limited to 4KB
+template <int depth>
+struct MaxTensors {
+  static constexpr int value = depth == 1 ? 110 : depth == 2 ? 64 : depth == 3 ? 48 : depth == 4 ? 36 : 30;
+};
+
+template <int depth>
+struct TensorListMetadata {
+  void* addresses[depth][MaxTensors<depth>::value];
+  int64_t numel[MaxTensors<depth>::value];
+  unsigned char block_to_tensor[kMaxBlocks];
+  int block_to_chunk[kMaxBlocks];
+};
+
+template <int depth, typename scalar_t, typename Op>
+__global__ void multi_tensor_apply_kernel(TensorListMetadata<depth> meta, Op op) {
+  const int tensor = meta.block_to_tensor[blockIdx.x];
+  const int64_t offset = static_cast<int64_t>(meta.block_to_chunk[blockIdx.x]) * kChunkSize;
+  const int64_t n = ::min(meta.numel[tensor] - offset, static_cast<int64_t>(kChunkSize));
+  scalar_t* ptrs[depth];
+#pragma unroll
+  for (int d = 0; d < depth; d++) {
+    ptrs[d] = meta.addresses[d][tensor] == nullptr
+        ? nullptr : static_cast<scalar_t*>(meta.addresses[d][tensor]) + offset;
+  }
+  for (int64_t i = threadIdx.x; i < n; i += blockDim.x) {
+    op(ptrs, i);
+  }
+}
+
+} // namespace multi_tensor_apply_detail
+
+// Calls op(ptrs, i) for every element i of every tensor of lists[0], where
+// ptrs[d] points into the matching tensor of lists[d], or is null when
+// lists[d] is empty. All the tensors must be contiguous.
+template <int depth, typename scalar_t, typename Op>
+void multi_tensor_apply(const std::array<TensorList, depth>& lists, const Op& op) {
+  using namespace multi_tensor_apply_detail;
+  constexpr int max_tensors = MaxTensors<depth>::value;
+  auto stream = at::cuda::getCurrentCUDAStream();
+
+  TensorListMetadata<depth> meta;
+  int num_tensors = 0;
+  int num_blocks = 0;
+  auto launch = [&]() {
+    multi_tensor_apply_kernel<depth, scalar_t><<<num_blocks, kNumThreads, 0, stream>>>(meta, op);
+    AT_CUDA_CHECK(cudaGetLastError());
+    num_blocks = 0;
+  };
+
+  for (size_t t = 0; t < lists[0].size(); t++) {
+    const int64_t numel = lists[0][t].numel();
+    if (numel == 0) {
+      continue;
+    }
+    for (int d = 0; d < depth; d++) {
+      meta.addresses[d][num_tensors] = lists[d].empty() ? nullptr : lists[d][t].data_ptr();
+    }
+    meta.numel[num_tensors] = numel;
+    num_tensors++;
+
+    const int64_t num_chunks = (numel + kChunkSize - 1) / kChunkSize;
+    for (int64_t chunk = 0; chunk < num_chunks; chunk++) {
+      meta.block_to_tensor[num_blocks] = num_tensors - 1;
+      meta.block_to_chunk[num_blocks] = chunk;
+      num_blocks++;
+      const bool last_chunk = chunk == num_chunks - 1;
+      if (num_blocks == kMaxBlocks || (num_tensors == max_tensors && last_chunk)) {
+        launch();
+        if (last_chunk) {
+          num_tensors = 0;
+        } else {
+          // the rest of this tensor goes to the next launch
+          for (int d = 0; d < depth; d++) {
+            meta.addresses[d][0] = meta.addresses[d][num_tensors - 1];
+          }
+          meta.numel[0] = meta.numel[num_tensors - 1];
+          num_tensors = 1;
+        }
+      }
+    }
+  }
+  if (num_blocks > 0) {
+    launch();
+  }
+}
+
+}} // namespace at::native
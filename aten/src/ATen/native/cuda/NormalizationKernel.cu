@@ -0,0 +1,499 @@
+#include <ATen/native/Normalization.h>
+
+#include <ATen/AccumulateType.h>
+#include <ATen/Dispatch.h>
+#include <ATen/cuda/CUDAContext.h>
+#include <ATen/cuda/Exceptions.h>
+#include <THC/THCDeviceUtils.cuh>
+
+namespace at { namespace native { namespace {
+
+constexpr int kCUDANumThreads = 256;
+// Upper bound of the number of warps in a block
+constexpr int kMaxNumWarps = 32;
+
+template <typename T>
+__device__ __forceinline__ T device_rsqrt(T val);
+
+template <>
+__device__ __forceinline__ float device_rsqrt(float val) {
+  return ::rsqrtf(val);
+}
+
+template <>
+__device__ __forceinline__ double device_rsqrt(double val) {
+  return ::rsqrt(val);
+}
+
+// The running state of Welford's algorithm. The count is kept in T so that
+// the whole state can be moved between lanes with warp shuffles.
+template <typename T>
+struct WelfordData {
+  T mean;
+  T m2;
+  T n;
+};
+
+template <typename T>
+__device__ __forceinline__ WelfordData<T> WelfordCombine(
+    const WelfordData<T>& a, const WelfordData<T>& b) {
+  const T n = a.n + b.n;
+  if (n == T(0)) {
+    return a;
+  }
+  const T delta = b.mean - a.mean;
+  const T nb_over_n = b.n / n;
+  return {a.mean + delta * nb_over_n,
+          a.m2 + b.m2 + delta * delta * a.n * nb_over_n,
+          n};
+}
+
+template <typename T>
+__device__ __forceinline__ WelfordData<T> WarpReduceWelford(WelfordData<T> val) {
+  for (int offset = warpSize / 2; offset > 0; offset /= 2) {
+    WelfordData<T> other = {WARP_SHFL_DOWN(val.mean, offset),
+                            WARP_SHFL_DOWN(val.m2, offset),
+                            WARP_SHFL_DOWN(val.n, offset)};
+    val = WelfordCombine(val, other);
+  }
+  return val;
+}
+
+// The result is only valid in the first thread of the block
+template <typename T>
+__device__ __forceinline__ WelfordData<T> BlockReduceWelford(
+    WelfordData<T> val, WelfordData<T>* shared) {
+  const int lane = threadIdx.x % warpSize;
+  const int wid = threadIdx.x / warpSize;
+  val = WarpReduceWelford(val);
+  if (lane == 0) {
+    shared[wid] = val;
+  }
+  __syncthreads();
+  if (threadIdx.x < blockDim.x / warpSize) {
+    val = shared[lane];
+  } else {
+    val = {T(0), T(0), T(0)};
+  }
+  if (wid == 0) {
+    val = WarpReduceWelford(val);
+  }
+  return val;
+}
+
+template <typename T>
+__device__ __forceinline__ T WarpReduceSum(T val) {
+  for (int offset = warpSize / 2; offset > 0; offset /= 2) {
+    val += WARP_SHFL_DOWN(val, offset);
+  }
+  return val;
+}
+
+// The result is only valid in the first thread of the block
+template <typename T>
+__device__ __forceinline__ T BlockReduceSum(T val, T* shared) {
+  const int lane = threadIdx.x % warpSize;
+  const int wid = threadIdx.x / warpSize;
+  val = WarpReduceSum(val);
+  __syncthreads();
+  if (lane == 0) {
+    shared[wid] = val;
+  }
+  __syncthreads();
+  val = (threadIdx.x < blockDim.x / warpSize) ? shared[lane] : T(0);
+  if (wid == 0) {
+    val = WarpReduceSum(val);
+  }
+  return val;
+}
+
+// One block per row: the moments of the row are computed with Welford's
+// algorithm, reduced across the block, and then used to normalize the row.
+template <typename T>
+__global__ void LayerNormForwardCUDAKernel(
+    int64_t N,
+    acc_type<T, true> eps,
+    const T* X,
+    const T* gamma,
+    const T* beta,
+    T* Y,
+    T* mean,
+    T* rstd) {
+  using T_ACC = acc_type<T, true>;
+  __shared__ WelfordData<T_ACC> shared[kMaxNumWarps];
+  __shared__ T_ACC shared_mean;
+  __shared__ T_ACC shared_rstd;
+  const int64_t i = blockIdx.x;
+  WelfordData<T_ACC> val = {T_ACC(0), T_ACC(0), T_ACC(0)};
+  for (int64_t j = threadIdx.x; j < N; j += blockDim.x) {
+    const T_ACC x = static_cast<T_ACC>(X[i * N + j]);
+    val.n += T_ACC(1);
+    const T_ACC delta = x - val.mean;
+    val.mean += delta / val.n;
+    val.m2 += delta * (x - val.mean);
+  }
+  val = BlockReduceWelford(val, shared);
+  if (threadIdx.x == 0) {
+    const T_ACC var = val.n > T_ACC(0) ? val.m2 / val.n : T_ACC(0);
+    shared_mean = val.mean;
+    shared_rstd = device_rsqrt(max(var, T_ACC(0)) + eps);
+    mean[i] = static_cast<T>(shared_mean);
+    rstd[i] = static_cast<T>(shared_rstd);
+  }
+  __syncthreads();
+  const T_ACC mean_val = shared_mean;
+  const T_ACC rstd_val = shared_rstd;
+  for (int64_t j = threadIdx.x; j < N; j += blockDim.x) {
+    const int64_t index = i * N + j;
+    const T_ACC gamma_val = gamma == nullptr ? T_ACC(1) : static_cast<T_ACC>(gamma[j]);
+    const T_ACC beta_val = beta == nullptr ? T_ACC(0) : static_cast<T_ACC>(beta[j]);
+    Y[index] = static_cast<T>(
+        (static_cast<T_ACC>(X[index]) - mean_val) * rstd_val * gamma_val + beta_val);
+  }
+}
+
+// One block per row, see LayerNormBackwardKernelImplInternal in
+// cpu/NormalizationKernel.cpp for the formula.
+template <typename T>
+__global__ void LayerNormBackwardCUDAKernel(
+    int64_t N,
+    const T* dY,
+    const T* X,
+    const T* mean,
+    const T* rstd,
+    const T* gamma,
+    T* dX) {
+  using T_ACC = acc_type<T, true>;
+  __shared__ T_ACC shared[kMaxNumWarps];
+  __shared__ T_ACC shared_c1;
+  __shared__ T_ACC shared_c2;
+  const int64_t i = blockIdx.x;
+  const T_ACC mean_val = static_cast<T_ACC>(mean[i]);
+  const T_ACC rstd_val = static_cast<T_ACC>(rstd[i]);
+  T_ACC ds = 0;
+  T_ACC db = 0;
+  for (int64_t j = threadIdx.x; j < N; j += blockDim.x) {
+    const int64_t index = i * N + j;
+    const T_ACC gamma_val = gamma == nullptr ? T_ACC(1) : static_cast<T_ACC>(gamma[j]);
+    const T_ACC dxhat = static_cast<T_ACC>(dY[index]) * gamma_val;
+    ds += dxhat * static_cast<T_ACC>(X[index]);
+    db += dxhat;
+  }
+  ds = BlockReduceSum(ds, shared);
+  db = BlockReduceSum(db, shared);
+  if (threadIdx.x == 0) {
+    const T_ACC scale = T_ACC(1) / static_cast<T_ACC>(N);
+    const T_ACC c1 = (db * mean_val - ds) * rstd_val * rstd_val * rstd_val * scale;
+    shared_c1 = c1;
+    shared_c2 = -c1 * mean_val - db * rstd_val * scale;
+  }
+  __syncthreads();
+  const T_ACC c1 = shared_c1;
+  const T_ACC c2 = shared_c2;
+  for (int64_t j = threadIdx.x; j < N; j += blockDim.x) {
+    const int64_t index = i * N + j;
+    const T_ACC gamma_val = gamma == nullptr ? T_ACC(1) : static_cast<T_ACC>(gamma[j]);
+    dX[index] = static_cast<T>(
+        rstd_val * gamma_val * static_cast<T_ACC>(dY[index]) +
+        c1 * static_cast<T_ACC>(X[index]) + c2);
+  }
+}
+
+// One thread per column, so that the reads of every row are coalesced
+template <typename T>
+__global__ void LayerNormGammaBetaBackwardCUDAKernel(
+    int64_t M,
+    int64_t N,
+    const T* dY,
+    const T* X,
+    const T* mean,
+    const T* rstd,
+    T* dgamma,
+    T* dbeta) {
+  using T_ACC = acc_type<T, true>;
+  const int64_t j = blockIdx.x * blockDim.x + threadIdx.x;
+  if (j >= N) {
+    return;
+  }
+  T_ACC dg = 0;
+  T_ACC db = 0;
+  for (int64_t i = 0; i < M; i++) {
+    const int64_t index = i * N + j;
+    const T_ACC dy = static_cast<T_ACC>(dY[index]);
+    dg += dy * (static_cast<T_ACC>(X[index]) - static_cast<T_ACC>(mean[i])) *
+        static_cast<T_ACC>(rstd[i]);
+    db += dy;
+  }
+  if (dgamma != nullptr) {
+    dgamma[j] = static_cast<T>(dg);
+  }
+  if (dbeta != nullptr) {
+    dbeta[j] = static_cast<T>(db);
+  }
+}
+
+// One block per group of a sample, like LayerNormForwardCUDAKernel with the
+// affine parameters indexed by channel.
+template <typename T>
+__global__ void GroupNormForwardCUDAKernel(
+    int64_t D,
+    int64_t HxW,
+    int64_t group,
+    acc_type<T, true> eps,
+    const T* X,
+    const T* gamma,
+    const T* beta,
+    T* Y,
+    T* mean,
+    T* rstd) {
+  using T_ACC = acc_type<T, true>;
+  __shared__ WelfordData<T_ACC> shared[kMaxNumWarps];
+  __shared__ T_ACC shared_mean;
+  __shared__ T_ACC shared_rstd;
+  const int64_t i = blockIdx.x;
+  const int64_t size = D * HxW;
+  WelfordData<T_ACC> val = {T_ACC(0), T_ACC(0), T_ACC(0)};
+  for (int64_t j = threadIdx.x; j < size; j += blockDim.x) {
+    const T_ACC x = static_cast<T_ACC>(X[i * size + j]);
+    val.n += T_ACC(1);
+    const T_ACC delta = x - val.mean;
+    val.mean += delta / val.n;
+    val.m2 += delta * (x - val.mean);
+  }
+  val = BlockReduceWelford(val, shared);
+  if (threadIdx.x == 0) {
+    const T_ACC var = val.n > T_ACC(0) ? val.m2 / val.n : T_ACC(0);
+    shared_mean = val.mean;
+    shared_rstd = device_rsqrt(max(var, T_ACC(0)) + eps);
+    mean[i] = static_cast<T>(shared_mean);
+    rstd[i] = static_cast<T>(shared_rstd);
+  }
+  __syncthreads();
+  const T_ACC mean_val = shared_mean;
+  const T_ACC rstd_val = shared_rstd;
+  const int64_t g = i % group;
+  for (int64_t j = threadIdx.x; j < size; j += blockDim.x) {
+    const int64_t index = i * size + j;
+    const int64_t c = g * D + j / HxW;
+    const T_ACC gamma_val = gamma == nullptr ? T_ACC(1) : static_cast<T_ACC>(gamma[c]);
+    const T_ACC beta_val = beta == nullptr ? T_ACC(0) : static_cast<T_ACC>(beta[c]);
+    Y[index] = static_cast<T>(
+        (static_cast<T_ACC>(X[index]) - mean_val) * rstd_val * gamma_val + beta_val);
+  }
+}
+
+// One block per channel of a sample: sum(dY * X) and sum(dY)
+template <typename T>
+__global__ void GroupNormInternalGradientsCUDAKernel(
+    int64_t HxW,
+    const T* dY,
+    const T* X,
+    acc_type<T, true>* ds,
+    acc_type<T, true>* db) {
+  using T_ACC = acc_type<T, true>;
+  __shared__ T_ACC shared[kMaxNumWarps];
+  const int64_t i = blockIdx.x;
+  T_ACC ds_sum = 0;
+  T_ACC db_sum = 0;
+  for (int64_t j = threadIdx.x; j < HxW; j += blockDim.x) {
+    const int64_t index = i * HxW + j;
+    const T_ACC dy = static_cast<T_ACC>(dY[index]);
+    ds_sum += dy * static_cast<T_ACC>(X[index]);
+    db_sum += dy;
+  }
+  ds_sum = BlockReduceSum(ds_sum, shared);
+  db_sum = BlockReduceSum(db_sum, shared);
+  if (threadIdx.x == 0) {
+    ds[i] = ds_sum;
+    db[i] = db_sum;
+  }
+}
+
+// One block per group of a sample, with the sums over the group taken from
+// the per channel sums.
+template <typename T>
+__global__ void GroupNormBackwardCUDAKernel(
+    int64_t D,
+    int64_t HxW,
+    int64_t group,
+    const T* dY,
+    const T* X,
+    const T* mean,
+    const T* rstd,
+    const T* gamma,
+    const acc_type<T, true>* ds,
+    const acc_type<T, true>* db,
+    T* dX) {
+  using T_ACC = acc_type<T, true>;
+  __shared__ T_ACC shared[kMaxNumWarps];
+  __shared__ T_ACC shared_c1;
+  __shared__ T_ACC shared_c2;
+  const int64_t i = blockIdx.x;
+  const int64_t g = i % group;
+  const T_ACC mean_val = static_cast<T_ACC>(mean[i]);
+  const T_ACC rstd_val = static_cast<T_ACC>(rstd[i]);
+  T_ACC ds_sum = 0;
+  T_ACC db_sum = 0;
+  for (int64_t d = threadIdx.x; d < D; d += blockDim.x) {
+    const T_ACC gamma_val = gamma == nullptr ? T_ACC(1) : static_cast<T_ACC>(gamma[g * D + d]);
+    ds_sum += ds[i * D + d] * gamma_val;
+    db_sum += db[i * D + d] * gamma_val;
+  }
+  ds_sum = BlockReduceSum(ds_sum, shared);
+  db_sum = BlockReduceSum(db_sum, shared);
+  if (threadIdx.x == 0) {
+    const T_ACC scale = T_ACC(1) / static_cast<T_ACC>(D * HxW);
+    const T_ACC c1 = (db_sum * mean_val - ds_sum) * rstd_val * rstd_val * rstd_val * scale;
+    shared_c1 = c1;
+    shared_c2 = -c1 * mean_val - db_sum * rstd_val * scale;
+  }
+  __syncthreads();
+  const T_ACC c1 = shared_c1;
+  const T_ACC c2 = shared_c2;
+  const int64_t size = D * HxW;
+  for (int64_t j = threadIdx.x; j < size; j += blockDim.x) {
+    const int64_t index = i * size + j;
+    const int64_t c = g * D + j / HxW;
+    const T_ACC gamma_val = gamma == nullptr ? T_ACC(1) : static_cast<T_ACC>(gamma[c]);
+    dX[index] = static_cast<T>(
+        rstd_val * gamma_val * static_cast<T_ACC>(dY[index]) +
+        c1 * static_cast<T_ACC>(X[index]) + c2);
+  }
+}
+
+// One thread per channel
+template <typename T>
+__global__ void GroupNormGammaBetaBackwardCUDAKernel(
+    int64_t N,
+    int64_t C,
+    int64_t group,
+    const T* mean,
+    const T* rstd,
+    const acc_type<T, true>* ds,
+    const acc_type<T, true>* db,
+    T* dgamma,
+    T* dbeta) {
+  using T_ACC = acc_type<T, true>;
+  const int64_t c = blockIdx.x * blockDim.x + threadIdx.x;
+  if (c >= C) {
+    return;
+  }
+  const int64_t g = c / (C / group);
+  T_ACC dg = 0;
+  T_ACC dbeta_sum = 0;
+  for (int64_t n = 0; n < N; n++) {
+    const int64_t ng = n * group + g;
+    dg += (ds[n * C + c] - db[n * C + c] * static_cast<T_ACC>(mean[ng])) *
+        static_cast<T_ACC>(rstd[ng]);
+    dbeta_sum += db[n * C + c];
+  }
+  if (dgamma != nullptr) {
+    dgamma[c] = static_cast<T>(dg);
+  }
+  if (dbeta != nullptr) {
+    dbeta[c] = static_cast<T>(dbeta_sum);
+  }
+}
+
+template <typename T>
+const T* optional_data(const Tensor& t) {
+  return t.defined() ? t.data<T>() : nullptr;
+}
+
+template <typename T>
+T* optional_data(Tensor& t) {
+  return t.defined() ? t.data<T>() : nullptr;
+}
+
+void LayerNormKernelImpl(
+    const Tensor& X, const Tensor& gamma, const Tensor& beta, int64_t M,
+    int64_t N, double eps, Tensor& Y, Tensor& mean, Tensor& rstd) {
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(X.scalar_type(), "layer_norm_cuda", [&] {
+    using T_ACC = acc_type<scalar_t, true>;
+    cudaStream_t stream = at::cuda::getCurrentCUDAStream();
+    LayerNormForwardCUDAKernel<scalar_t><<<M, kCUDANumThreads, 0, stream>>>(
+        N, static_cast<T_ACC>(eps), X.data<scalar_t>(),
+        optional_data<scalar_t>(gamma), optional_data<scalar_t>(beta),
+        Y.data<scalar_t>(), mean.data<scalar_t>(), rstd.data<scalar_t>());
+  });
+  AT_CUDA_CHECK(cudaGetLastError());
+}
+
+void LayerNormBackwardKernelImpl(
+    const Tensor& dY, const Tensor& X, const Tensor& mean, const Tensor& rstd,
+    const Tensor& gamma, int64_t M, int64_t N, Tensor& dX, Tensor& dgamma,
+    Tensor& dbeta) {
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(X.scalar_type(), "layer_norm_backward_cuda", [&] {
+    cudaStream_t stream = at::cuda::getCurrentCUDAStream();
+    if (dX.defined()) {
+      LayerNormBackwardCUDAKernel<scalar_t><<<M, kCUDANumThreads, 0, stream>>>(
+          N, dY.data<scalar_t>(), X.data<scalar_t>(), mean.data<scalar_t>(),
+          rstd.data<scalar_t>(), optional_data<scalar_t>(gamma),
+          dX.data<scalar_t>());
+    }
+    if (dgamma.defined() || dbeta.defined()) {
+      const int64_t blocks = (N + kCUDANumThreads - 1) / kCUDANumThreads;
+      LayerNormGammaBetaBackwardCUDAKernel<scalar_t><<<blocks, kCUDANumThreads, 0, stream>>>(
+          M, N, dY.data<scalar_t>(), X.data<scalar_t>(), mean.data<scalar_t>(),
+          rstd.data<scalar_t>(), optional_data<scalar_t>(dgamma),
+          optional_data<scalar_t>(dbeta));
+    }
+  });
+  AT_CUDA_CHECK(cudaGetLastError());
+}
+
+void GroupNormKernelImpl(
+    const Tensor& X, const Tensor& gamma, const Tensor& beta, int64_t N,
+    int64_t C, int64_t HxW, int64_t group, double eps, Tensor& Y,
+    Tensor& mean, Tensor& rstd) {
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(X.scalar_type(), "group_norm_cuda", [&] {
+    using T_ACC = acc_type<scalar_t, true>;
+    cudaStream_t stream = at::cuda::getCurrentCUDAStream();
+    GroupNormForwardCUDAKernel<scalar_t><<<N * group, kCUDANumThreads, 0, stream>>>(
+        C / group, HxW, group, static_cast<T_ACC>(eps), X.data<scalar_t>(),
+        optional_data<scalar_t>(gamma), optional_data<scalar_t>(beta),
+        Y.data<scalar_t>(), mean.data<scalar_t>(), rstd.data<scalar_t>());
+  });
+  AT_CUDA_CHECK(cudaGetLastError());
+}
+
+void GroupNormBackwardKernelImpl(
+    const Tensor& dY, const Tensor& X, const Tensor& mean, const Tensor& rstd,
+    const Tensor& gamma, int64_t N, int64_t C, int64_t HxW, int64_t group,
+    Tensor& dX, Tensor& dgamma, Tensor& dbeta) {
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(X.scalar_type(), "group_norm_backward_cuda", [&] {
+    using T_ACC = acc_type<scalar_t, true>;
+    cudaStream_t stream = at::cuda::getCurrentCUDAStream();
+    const auto acc_options =
+        X.options().dtype(X.scalar_type() == kDouble ? kDouble : kFloat);
+    Tensor ds = at::empty({N, C}, acc_options);
+    Tensor db = at::empty({N, C}, acc_options);
+    GroupNormInternalGradientsCUDAKernel<scalar_t><<<N * C, kCUDANumThreads, 0, stream>>>(
+        HxW, dY.data<scalar_t>(), X.data<scalar_t>(), ds.data<T_ACC>(),
+        db.data<T_ACC>());
+    if (dX.defined()) {
+      GroupNormBackwardCUDAKernel<scalar_t><<<N * group, kCUDANumThreads, 0, stream>>>(
+          C / group, HxW, group, dY.data<scalar_t>(), X.data<scalar_t>(),
+          mean.data<scalar_t>(), rstd.data<scalar_t>(),
+          optional_data<scalar_t>(gamma), ds.data<T_ACC>(), db.data<T_ACC>(),
+          dX.data<scalar_t>());
+    }
+    if (dgamma.defined() || dbeta.defined()) {
+      const int64_t blocks = (C + kCUDANumThreads - 1) / kCUDANumThreads;
+      GroupNormGammaBetaBackwardCUDAKernel<scalar_t><<<blocks, kCUDANumThreads, 0, stream>>>(
+          N, C, group, mean.data<scalar_t>(), rstd.data<scalar_t>(),
+          ds.data<T_ACC>(), db.data<T_ACC>(), optional_data<scalar_t>(dgamma),
+          optional_data<scalar_t>(dbeta));
+    }
+  });
+  AT_CUDA_CHECK(cudaGetLastError());
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(layer_norm_stub, &LayerNormKernelImpl);
+REGISTER_DISPATCH(layer_norm_backward_stub, &LayerNormBackwardKernelImpl);
+REGISTER_DISPATCH(group_norm_stub, &GroupNormKernelImpl);
+REGISTER_DISPATCH(group_norm_backward_stub, &GroupNormBackwardKernelImpl);
+
+}} // namespace at::native
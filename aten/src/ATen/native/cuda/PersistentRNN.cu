@@ -0,0 +1,310 @@
+#include <ATen/ATen.h>
+#include <ATen/AccumulateType.h>
+#include <ATen/NativeFunctions.h>
+#include <ATen/TensorUtils.h>
+#include <ATen/cuda/CUDAContext.h>
+#include <ATen/native/RNN.h>
+#include <THC/THCDeviceUtils.cuh>
+#include <c10/macros/Macros.h>
+
+#include <algorithm>
+#include <limits>
+
+// Persistent RNN kernels
+//
+// A persistent kernel runs all timesteps of one layer and direction of an RNN
+// in a single launch. Every block owns a slice of the hidden units and keeps
+// the rows of the recurrent weight for the gates of those units in shared
+// memory for the whole sequence, so the weight is read from global memory once
+// per sequence instead of once per step. This pays off for small batches,
+// where a step is too little work to hide the cost of a GEMM launch.
+//
+// The input-to-hidden products don't depend on the previous step, so they are
+// computed for the whole sequence by the caller with one GEMM and passed in as
+// input_gates. After each step the blocks wait for each other at a grid-wide
+// barrier, since the next step needs the hidden state of all units. All blocks
+// must therefore be resident on the device at once, which is guaranteed by
+// sizing the grid from the occupancy of the kernel.
+
+namespace at { namespace native {
+
+namespace {
+
+constexpr int kPersistentRNNThreads = 256;
+// Larger batches have enough work per step to be served well by cuDNN
+constexpr int64_t kPersistentRNNMaxBatch = 8;
+
+int64_t num_gates(int64_t mode) {
+  switch (mode) {
+    case PERSISTENT_RNN_LSTM: return 4;
+    case PERSISTENT_RNN_GRU: return 3;
+    default: return 1;
+  }
+}
+
+// Elements of shared memory used by a block that owns `units` hidden units
+int64_t shared_elements(int64_t mode, int64_t batch, int64_t hidden, int64_t units) {
+  int64_t gates = num_gates(mode);
+  return gates * units * hidden  // recurrent weight rows
+      + batch * hidden           // previous hidden state
+      + batch * gates * units    // recurrent gates of the step
+      + batch * units;           // cell state
+}
+
+template<typename T>
+__device__ __forceinline__
+T sigmoid(T in)  {
+  T one = static_cast<T>(1.0);
+  return one / (one + ::exp(-in));
+}
+
+// Waits until all blocks of the grid reach the barrier. `barrier` holds an
+// arrival count and a generation, both zero before the launch.
+__device__ __forceinline__ void grid_barrier(unsigned int* barrier) {
+  __syncthreads();
+  if (threadIdx.x == 0) {
+    volatile unsigned int* generation = barrier + 1;
+    unsigned int gen = *generation;
+    __threadfence();
+    if (atomicAdd(barrier, 1) == gridDim.x - 1) {
+      atomicExch(barrier, 0);
+      __threadfence();
+      atomicAdd(barrier + 1, 1);
+    } else {
+      while (*generation == gen) {}
+    }
+    __threadfence();
+  }
+  __syncthreads();
+}
+
+template <typename scalar_t, typename accscalar_t>
+__global__ void persistent_rnn_kernel(
+    const scalar_t* __restrict__ input_gates,  // [seq_length, batch, gates * hidden]
+    const scalar_t* __restrict__ weight_hh,    // [gates * hidden, hidden]
+    const scalar_t* __restrict__ bias_hh,      // [gates * hidden], GRU only, may be null
+    const scalar_t* __restrict__ hx,           // [batch, hidden]
+    const scalar_t* __restrict__ cx,           // [batch, hidden], LSTM only
+    scalar_t* output,                          // [seq_length, batch, hidden]
+    scalar_t* hy,                              // [batch, hidden]
+    scalar_t* cy,                              // [batch, hidden], LSTM only
+    unsigned int* barrier,
+    int mode, bool reverse, int seq_length, int batch, int hidden, int units) {
+  extern __shared__ char shared_buf[];
+  const int gates = mode == PERSISTENT_RNN_LSTM ? 4 : (mode == PERSISTENT_RNN_GRU ? 3 : 1);
+  const int first_unit = blockIdx.x * units;
+  const int block_units = min(units, hidden - first_unit);
+  const int block_rows = gates * block_units;
+
+  scalar_t* weight_s = reinterpret_cast<scalar_t*>(shared_buf);  // [block_rows, hidden]
+  scalar_t* hidden_s = weight_s + block_rows * hidden;          // [batch, hidden]
+  scalar_t* gates_s = hidden_s + batch * hidden;                 // [batch, block_rows]
+  scalar_t* cell_s = gates_s + batch * block_rows;               // [batch, block_units]
+
+  // Row g * block_units + k holds the row of gate g of unit first_unit + k
+  for (int i = threadIdx.x; i < block_rows * hidden; i += blockDim.x) {
+    int row = i / hidden;
+    int col = i % hidden;
+    int gate = row / block_units;
+    int unit = first_unit + row % block_units;
+    weight_s[i] = weight_hh[(gate * hidden + unit) * hidden + col];
+  }
+  if (mode == PERSISTENT_RNN_LSTM) {
+    for (int i = threadIdx.x; i < batch * block_units; i += blockDim.x) {
+      cell_s[i] = cx[(i / block_units) * hidden + first_unit + i % block_units];
+    }
+  }
+
+  const int warp = threadIdx.x / C10_WARP_SIZE;
+  const int lane = threadIdx.x % C10_WARP_SIZE;
+  const int num_warps = blockDim.x / C10_WARP_SIZE;
+
+  for (int step = 0; step < seq_length; step++) {
+    const int t = reverse ? seq_length - 1 - step : step;
+    // Written by all blocks in the previous step, so it must not be read
+    // through the non-coherent L1 cache
+    const volatile scalar_t* prev_hidden = step == 0
+        ? hx : output + (reverse ? t + 1 : t - 1) * batch * hidden;
+    for (int i = threadIdx.x; i < batch * hidden; i += blockDim.x) {
+      hidden_s[i] = prev_hidden[i];
+    }
+    __syncthreads();
+
+    // Recurrent gates, a warp per row and batch entry
+    for (int r = warp; r < batch * block_rows; r += num_warps) {
+      int b = r / block_rows;
+      int row = r % block_rows;
+      const scalar_t* w = weight_s + row * hidden;
+      const scalar_t* h = hidden_s + b * hidden;
+      accscalar_t sum = 0;
+      for (int j = lane; j < hidden; j += C10_WARP_SIZE) {
+        sum += static_cast<accscalar_t>(w[j]) * static_cast<accscalar_t>(h[j]);
+      }
+      for (int offset = C10_WARP_SIZE / 2; offset > 0; offset /= 2) {
+        sum += WARP_SHFL_DOWN(sum, offset);
+      }
+      if (lane == 0) {
+        gates_s[r] = static_cast<scalar_t>(sum);
+      }
+    }
+    __syncthreads();
+
+    const scalar_t* igates = input_gates + t * batch * gates * hidden;
+    scalar_t* out = output + t * batch * hidden;
+    for (int i = threadIdx.x; i < batch * block_units; i += blockDim.x) {
+      const int b = i / block_units;
+      const int k = i % block_units;
+      const int unit = first_unit + k;
+      const scalar_t* ig = igates + b * gates * hidden;
+      const scalar_t* hg = gates_s + b * block_rows;
+      accscalar_t h;
+      if (mode == PERSISTENT_RNN_LSTM) {
+        accscalar_t ingate = sigmoid<accscalar_t>(ig[unit] + hg[k]);
+        accscalar_t forgetgate = sigmoid<accscalar_t>(ig[hidden + unit] + hg[block_units + k]);
+        accscalar_t cellgate = ::tanh(static_cast<accscalar_t>(ig[2 * hidden + unit] + hg[2 * block_units + k]));
+        accscalar_t outgate = sigmoid<accscalar_t>(ig[3 * hidden + unit] + hg[3 * block_units + k]);
+        accscalar_t c = forgetgate * cell_s[i] + ingate * cellgate;
+        cell_s[i] = static_cast<scalar_t>(c);
+        h = outgate * ::tanh(c);
+      } else if (mode == PERSISTENT_RNN_GRU) {
+        accscalar_t b_r = bias_hh ? bias_hh[unit] : 0;
+        accscalar_t b_z = bias_hh ? bias_hh[hidden + unit] : 0;
+        accscalar_t b_n = bias_hh ? bias_hh[2 * hidden + unit] : 0;
+        accscalar_t resetgate = sigmoid<accscalar_t>(ig[unit] + hg[k] + b_r);
+        accscalar_t inputgate = sigmoid<accscalar_t>(ig[hidden + unit] + hg[block_units + k] + b_z);
+        accscalar_t newgate = ::tanh(ig[2 * hidden + unit] + resetgate * (hg[2 * block_units + k] + b_n));
+        h = newgate + inputgate * (hidden_s[b * hidden + unit] - newgate);
+      } else {
+        accscalar_t pre = static_cast<accscalar_t>(ig[unit]) + hg[k];
+        h = mode == PERSISTENT_RNN_TANH ? ::tanh(pre) : (pre > 0 ? pre : 0);
+      }
+      out[b * hidden + unit] = static_cast<scalar_t>(h);
+      if (step == seq_length - 1) {
+        hy[b * hidden + unit] = static_cast<scalar_t>(h);
+        if (mode == PERSISTENT_RNN_LSTM) {
+          cy[b * hidden + unit] = cell_s[i];
+        }
+      }
+    }
+    grid_barrier(barrier);
+  }
+}
+
+// Hidden units per block, or 0 if the recurrent weight doesn't fit on-chip
+template <typename scalar_t>
+int64_t persistent_rnn_units_per_block(int64_t mode, int64_t batch, int64_t hidden) {
+  using accscalar_t = acc_type<scalar_t, true>;
+  auto prop = at::cuda::getCurrentDeviceProperties();
+  int64_t max_shared = prop->sharedMemPerBlock / sizeof(scalar_t);
+  // Spread the units over all multiprocessors, one block each
+  int64_t units = (hidden + prop->multiProcessorCount - 1) / prop->multiProcessorCount;
+  if (shared_elements(mode, batch, hidden, units) > max_shared) {
+    return 0;
+  }
+  int64_t num_blocks = (hidden + units - 1) / units;
+  int max_active_blocks = 0;
+  cudaOccupancyMaxActiveBlocksPerMultiprocessor(
+      &max_active_blocks, persistent_rnn_kernel<scalar_t, accscalar_t>,
+      kPersistentRNNThreads, shared_elements(mode, batch, hidden, units) * sizeof(scalar_t));
+  if (max_active_blocks * prop->multiProcessorCount < num_blocks) {
+    return 0;
+  }
+  return units;
+}
+
+} // anonymous namespace
+
+bool _persistent_rnn_is_acceptable(const Tensor& input, int64_t hidden_size, int64_t mode) {
+#ifdef __HIP_PLATFORM_HCC__
+  return false;
+#else
+  if (input.dim() != 3 || input.size(0) == 0 || input.size(1) == 0 ||
+      input.size(1) > kPersistentRNNMaxBatch || hidden_size == 0) {
+    return false;
+  }
+  if (input.size(0) * input.size(1) * num_gates(mode) * hidden_size >
+      std::numeric_limits<int32_t>::max()) {
+    return false;
+  }
+  bool fits = false;
+  if (input.scalar_type() == kFloat) {
+    fits = persistent_rnn_units_per_block<float>(mode, input.size(1), hidden_size) > 0;
+  } else if (input.scalar_type() == kDouble) {
+    fits = persistent_rnn_units_per_block<double>(mode, input.size(1), hidden_size) > 0;
+  }
+  return fits;
+#endif
+}
+
+std::tuple<Tensor, Tensor, Tensor> _persistent_rnn_cuda(
+    const Tensor& input_gates_, const Tensor& weight_hh_, const Tensor& bias_hh_,
+    const Tensor& hx_, const Tensor& cx_, int64_t mode, bool reverse) {
+  AT_CHECK(input_gates_.dim() == 3, "_persistent_rnn: expected 3D input gates");
+  AT_CHECK(mode == PERSISTENT_RNN_RELU || mode == PERSISTENT_RNN_TANH ||
+           mode == PERSISTENT_RNN_LSTM || mode == PERSISTENT_RNN_GRU,
+           "_persistent_rnn: unknown mode ", mode);
+  int64_t seq_length = input_gates_.size(0);
+  int64_t batch = input_gates_.size(1);
+  int64_t hidden = hx_.size(-1);
+  int64_t gates = num_gates(mode);
+  AT_CHECK(input_gates_.size(2) == gates * hidden,
+           "_persistent_rnn: expected input gates of size ", gates * hidden,
+           " in the last dimension, but got ", input_gates_.size(2));
+  AT_CHECK(weight_hh_.dim() == 2 && weight_hh_.size(0) == gates * hidden &&
+           weight_hh_.size(1) == hidden,
+           "_persistent_rnn: expected recurrent weight of size [", gates * hidden,
+           ", ", hidden, "], but got ", weight_hh_.sizes());
+  AT_CHECK(hx_.numel() == batch * hidden, "_persistent_rnn: expected hidden state of ",
+           batch * hidden, " elements, but got ", hx_.numel());
+  bool is_lstm = mode == PERSISTENT_RNN_LSTM;
+  AT_CHECK(!is_lstm || (cx_.defined() && cx_.numel() == batch * hidden),
+           "_persistent_rnn: LSTM expects a cell state of ", batch * hidden, " elements");
+  checkAllSameGPU("_persistent_rnn", {{input_gates_, "input_gates", 1},
+                                      {weight_hh_, "weight_hh", 2},
+                                      {hx_, "hx", 4}});
+
+  auto input_gates = input_gates_.contiguous();
+  auto weight_hh = weight_hh_.contiguous();
+  auto bias_hh = bias_hh_.defined() ? bias_hh_.contiguous() : bias_hh_;
+  auto hx = hx_.contiguous();
+  auto cx = is_lstm ? cx_.contiguous() : Tensor();
+
+  auto output = at::empty({seq_length, batch, hidden}, input_gates.options());
+  auto hy = at::empty({batch, hidden}, input_gates.options());
+  auto cy = is_lstm ? at::empty({batch, hidden}, input_gates.options()) : at::empty({0}, input_gates.options());
+  if (seq_length == 0) {
+    hy.copy_(hx.view({batch, hidden}));
+    if (is_lstm) {
+      cy.copy_(cx.view({batch, hidden}));
+    }
+    return std::make_tuple(output, hy, cy);
+  }
+
+  auto barrier = at::zeros({2}, input_gates.options().dtype(kInt));
+  auto stream = at::cuda::getCurrentCUDAStream();
+
+  AT_DISPATCH_FLOATING_TYPES(input_gates.scalar_type(), "_persistent_rnn_cuda", [&] {
+    using accscalar_t = acc_type<scalar_t, true>;
+    int64_t units = persistent_rnn_units_per_block<scalar_t>(mode, batch, hidden);
+    AT_CHECK(units > 0, "_persistent_rnn: the recurrent weight of hidden size ", hidden,
+             " and batch size ", batch, " does not fit on the device");
+    int64_t num_blocks = (hidden + units - 1) / units;
+    size_t shared_size = shared_elements(mode, batch, hidden, units) * sizeof(scalar_t);
+    persistent_rnn_kernel<scalar_t, accscalar_t>
+        <<<num_blocks, kPersistentRNNThreads, shared_size, stream>>>(
+            input_gates.data<scalar_t>(),
+            weight_hh.data<scalar_t>(),
+            bias_hh.defined() ? bias_hh.data<scalar_t>() : nullptr,
+            hx.data<scalar_t>(),
+            is_lstm ? cx.data<scalar_t>() : nullptr,
+            output.data<scalar_t>(),
+            hy.data<scalar_t>(),
+            is_lstm ? cy.data<scalar_t>() : nullptr,
+            reinterpret_cast<unsigned int*>(barrier.data<int>()),
+            mode, reverse, seq_length, batch, hidden, units);
+  });
+  AT_CUDA_CHECK(cudaGetLastError());
+  return std::make_tuple(output, hy, cy);
+}
+
+}} // namespace at::native
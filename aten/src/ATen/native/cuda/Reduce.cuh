@@ -674,15 +674,25 @@ inline void gpu_reduce_kernel(TensorIterator& iter, const ops_t& ops, ident_t id
     config.output_mult[1] = config.split_output(block_height);
   }
 
-  if (config.input_mult[1] != 0 && config.values_per_thread() >= 256 && num_outputs <= 4096) {
+  if (config.input_mult[1] != 0 && config.values_per_thread() >= 256) {
     // Divide the input across thread-blocks if the amount of work per-thread
-    // is large enough and the size of the output is small enough. This will
-    // require a reduction using global memory.
-    config.ctas_per_output = div_up(config.values_per_thread(), 16);
-    if (config.ctas_per_output > 65535) {
-      config.ctas_per_output = 65535;
+    // is large enough and there are too few outputs to fill the device. This
+    // will require a reduction using global memory, so only add as many
+    // blocks as can be resident at once: more of them only grow the staging
+    // buffer and the final reduction done by the last block of each output.
+    auto prop = at::cuda::getCurrentDeviceProperties();
+    int64_t resident_blocks = (int64_t)prop->multiProcessorCount *
+        std::max(1, prop->maxThreadsPerMultiProcessor / config.num_threads);
+    int64_t output_blocks = div_up(num_outputs, config.step_output);
+    if (output_blocks < resident_blocks) {
+      int64_t ctas_per_output = std::min<int64_t>(
+          div_up(config.values_per_thread(), 16),
+          div_up(resident_blocks, output_blocks));
+      config.ctas_per_output = std::min<int64_t>(ctas_per_output, 65535);
+      if (config.ctas_per_output > 1) {
+        config.input_mult[2] = config.split_input(config.ctas_per_output);
+      }
     }
-    config.input_mult[2] = config.split_input(config.ctas_per_output);
   }
 
   at::DataPtr buffer;
@@ -716,4 +726,71 @@ inline void gpu_reduce_kernel(TensorIterator& iter, const ops_t& ops, ident_t id
   launch_reduce_kernel<ReduceConfig::MAX_NUM_THREADS>(config, reduce);
 }
 
+// Reduces the rows [offsets[s], offsets[s + 1]) of a contiguous
+// [num_rows, inner_size] input into row s of a contiguous
+// [num_segments, inner_size] output, e.g. to pool the variable-length
+// sequences of a ragged batch. threadIdx.x picks the column, the rows of a
+// segment are split across threadIdx.y and combined in shared memory, and
+// blockIdx.y strides over the segments.
+template <typename scalar_t, typename out_scalar_t, typename ops_t, typename arg_t>
+__global__ void segmented_reduce_kernel(const scalar_t* data, const int64_t* offsets,
+                                        out_scalar_t* out, int64_t inner_size,
+                                        int64_t num_segments, ops_t ops, arg_t ident) {
+  extern __shared__ char shared_memory[];
+  arg_t* shared = (arg_t*)shared_memory;
+  int64_t col = blockIdx.x * (int64_t)blockDim.x + threadIdx.x;
+  int tid = threadIdx.y * blockDim.x + threadIdx.x;
+
+  for (int64_t segment = blockIdx.y; segment < num_segments; segment += gridDim.y) {
+    arg_t value = ident;
+    if (col < inner_size) {
+      for (int64_t row = offsets[segment] + threadIdx.y; row < offsets[segment + 1]; row += blockDim.y) {
+        value = ops.reduce(value, data[row * inner_size + col]);
+      }
+    }
+    shared[tid] = value;
+    for (int offset = blockDim.y / 2; offset > 0; offset >>= 1) {
+      __syncthreads();
+      if (threadIdx.y < offset) {
+        value = ops.combine(value, shared[tid + offset * blockDim.x]);
+        shared[tid] = value;
+      }
+    }
+    if (threadIdx.y == 0 && col < inner_size) {
+      out[segment * inner_size + col] = ops.project(value);
+    }
+    __syncthreads();
+  }
+}
+
+template <typename scalar_t, typename out_scalar_t, typename ops_t, typename ident_t=double>
+inline void gpu_segmented_reduce_kernel(const Tensor& data, const Tensor& offsets,
+                                        const Tensor& result, const ops_t& ops,
+                                        ident_t ident=0) {
+  using traits = binary_function_traits<decltype(&ops_t::reduce)>;
+  using arg_t = typename traits::arg1_t;
+  AT_ASSERT(data.is_contiguous() && offsets.is_contiguous() && result.is_contiguous());
+  AT_ASSERT(offsets.scalar_type() == at::kLong);
+
+  int64_t num_segments = offsets.numel() - 1;
+  if (num_segments <= 0 || result.numel() == 0) {
+    return;
+  }
+  int64_t inner_size = result.numel() / num_segments;
+
+  int block_x = inner_size < at::cuda::warp_size()
+      ? last_pow2(inner_size) : at::cuda::warp_size();
+  int block_y = ReduceConfig::MAX_NUM_THREADS / block_x;
+  dim3 block(block_x, block_y);
+  dim3 grid(div_up(inner_size, block_x), std::min<int64_t>(num_segments, 65535));
+  int shared_memory = sizeof(arg_t) * block_x * block_y;
+
+  auto stream = at::cuda::getCurrentCUDAStream();
+  segmented_reduce_kernel<scalar_t, out_scalar_t, ops_t, arg_t>
+      <<<grid, block, shared_memory, stream>>>(
+          data.data<scalar_t>(), offsets.data<int64_t>(), result.data<out_scalar_t>(),
+          inner_size, num_segments, ops, (arg_t)ident);
+  AT_CUDA_CHECK(cudaGetLastError());
+}
+
 }} // namespace at::native
@@ -0,0 +1,55 @@
+#include <ATen/ATen.h>
+#include <ATen/AccumulateType.h>
+#include <ATen/Dispatch.h>
+#include <ATen/cuda/NumericLimits.cuh>
+#include <ATen/native/SegmentReduce.h>
+#include <ATen/native/cuda/Reduce.cuh>
+#include <THC/THCNumerics.cuh>
+
+namespace at { namespace native {
+
+template <typename scalar_t, typename acc_t=scalar_t>
+void segment_sum_kernel_impl(const Tensor& result, const Tensor& data, const Tensor& offsets) {
+  gpu_segmented_reduce_kernel<scalar_t, scalar_t>(data, offsets, result,
+    func_wrapper<scalar_t> ([]GPU_LAMBDA(acc_t a, acc_t b) -> acc_t {
+      return a + b;
+    }));
+}
+
+template <typename scalar_t>
+void segment_max_kernel_impl(const Tensor& result, const Tensor& data, const Tensor& offsets) {
+  gpu_segmented_reduce_kernel<scalar_t, scalar_t>(data, offsets, result,
+    func_wrapper<scalar_t> ([]GPU_LAMBDA(scalar_t a, scalar_t b) -> scalar_t {
+      return (THCNumerics<scalar_t>::isnan(a) || a > b) ? a : b;
+    }), at::numeric_limits<scalar_t>::lower_bound());
+}
+
+template <typename scalar_t>
+void segment_min_kernel_impl(const Tensor& result, const Tensor& data, const Tensor& offsets) {
+  gpu_segmented_reduce_kernel<scalar_t, scalar_t>(data, offsets, result,
+    func_wrapper<scalar_t> ([]GPU_LAMBDA(scalar_t a, scalar_t b) -> scalar_t {
+      return (THCNumerics<scalar_t>::isnan(a) || a < b) ? a : b;
+    }), at::numeric_limits<scalar_t>::upper_bound());
+}
+
+static void segment_reduce_kernel_cuda(Tensor& result, const Tensor& data, const Tensor& offsets,
+                                       SegmentReduction reduction) {
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(data.scalar_type(), "segment_reduce_cuda", [&] {
+    switch (reduction) {
+      case SEGMENT_REDUCE_SUM:
+      case SEGMENT_REDUCE_MEAN:
+        segment_sum_kernel_impl<scalar_t, acc_type<scalar_t, true>>(result, data, offsets);
+        break;
+      case SEGMENT_REDUCE_MAX:
+        segment_max_kernel_impl<scalar_t>(result, data, offsets);
+        break;
+      case SEGMENT_REDUCE_MIN:
+        segment_min_kernel_impl<scalar_t>(result, data, offsets);
+        break;
+    }
+  });
+}
+
+REGISTER_DISPATCH(segment_reduce_stub, &segment_reduce_kernel_cuda);
+
+}} // namespace at::native
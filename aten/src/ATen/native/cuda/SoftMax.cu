@@ -9,6 +9,7 @@
 
 #include <ATen/AccumulateType.h>
 #include <ATen/cuda/NumericLimits.cuh>
+#include <limits>
 #include <type_traits>
 
 namespace at {
@@ -647,5 +648,22 @@ Tensor softmax_backward_cuda(const Tensor &grad, const Tensor &output, int64_t d
   return host_softmax_backward<SoftMaxBackwardEpilogue>(tmp, output, dim, half_to_float);
 }
 
+// There is no fused CUDA kernel yet: this composes the unfused ops and matches
+// the CPU kernel, including zeros for rows that are masked entirely.
+Tensor masked_softmax_cuda(const Tensor &input, const Tensor &mask, const int64_t dim){
+  Tensor masked;
+  if (mask.is_floating_point()) {
+    masked = input + mask.to(input.scalar_type());
+  } else {
+    masked = input.masked_fill(mask, -std::numeric_limits<double>::infinity());
+  }
+  Tensor output = host_softmax<SoftMaxForwardEpilogue>(masked, dim, false);
+  if (output.dim() == 0) {
+    return output;
+  }
+  auto fully_masked = masked.eq(-std::numeric_limits<double>::infinity()).all(dim, /*keepdim=*/true);
+  return output.masked_fill_(fully_masked, 0);
+}
+
 }
 }
@@ -177,7 +177,8 @@ inline int64_t getFreeGlobalMemory() {
   See `help torch.bincount` for details on the math.
 
   3 implementations based of input size and memory usage:
-    case: #bins < THRESH_NUMBER_BINS_FOR_MULTI_BLOCK_MEM and enough shared mem
+    case: enough shared mem, and #bins < THRESH_NUMBER_BINS_FOR_MULTI_BLOCK_MEM
+          or more elements than #bins per block
         SHARED: Each block atomically adds to it's own **shared** hist copy,
         then atomically updates the global tensor.
     case: #bins < THRESH_NUMBER_BINS_FOR_GLOBAL_MEM and enough global mem
@@ -215,9 +216,12 @@ bool CUDA_tensor_histogram(
   auto sharedMem = nbins * sizeof(output_t) + 8; // 8 guard bytes
   auto maxGlobalMem = getFreeGlobalMemory();
   auto multiBlockMem = nbins * grid.x * sizeof(output_t) + 8; // 8 guard bytes
-  // determine memory type to use in the kernel
-  if (nbins < THRESH_NUMBER_BINS_FOR_MULTI_BLOCK_MEM &&
-      sharedMem < maxSharedMem) {
+  // determine memory type to use in the kernel. Zeroing and merging the
+  // shared bins takes nbins per block, so beyond a few bins they are only
+  // used when the blocks have more elements than there are bins.
+  if (sharedMem < maxSharedMem &&
+      (nbins < THRESH_NUMBER_BINS_FOR_MULTI_BLOCK_MEM ||
+       nbins * static_cast<int64_t>(grid.x) <= totalElements)) {
     memType = CUDAHistogramMemoryType::SHARED;
   } else if (
       nbins < THRESH_NUMBER_BINS_FOR_GLOBAL_MEM &&
@@ -80,6 +80,7 @@ std::tuple<at::Tensor,at::Tensor,at::Tensor> cudnn_convolution_transpose_backwar
 #include <ATen/cudnn/cudnn-wrapper.h>
 #include <ATen/cudnn/Descriptors.h>
 #include <ATen/cudnn/Types.h>
+#include <ATen/cuda/CUDAContext.h>
 #include <ATen/cudnn/Utils.h>
 #include <ATen/native/utils/ParamsHash.h>
 
@@ -89,9 +90,14 @@ std::tuple<at::Tensor,at::Tensor,at::Tensor> cudnn_convolution_transpose_backwar
 #include <iterator>
 #include <sstream>
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <stdint.h>
+#include <string>
 #include <unordered_map>
 
 // Note [behavior of cudnnFind and cudnnGet]
@@ -431,6 +437,25 @@ cudnnStatus_t getWorkspaceSize(
         sz);
 }
 
+// Largest workspace an algorithm may use, from
+// PYTORCH_CUDNN_CONV_WORKSPACE_LIMIT_MB. Algorithms that need more are passed
+// over when benchmarking and when picking from cuDNN's heuristics; if none
+// fits, the default algorithm of the direction is used.
+size_t getConvWorkspaceLimit() {
+  static size_t limit = [] {
+    const char* env = std::getenv("PYTORCH_CUDNN_CONV_WORKSPACE_LIMIT_MB");
+    if (!env) {
+      return std::numeric_limits<size_t>::max();
+    }
+    char* end = nullptr;
+    long long mb = std::strtoll(env, &end, 10);
+    AT_CHECK(*end == '\0' && mb >= 0,
+             "PYTORCH_CUDNN_CONV_WORKSPACE_LIMIT_MB must be a non-negative integer, got ", env);
+    return static_cast<size_t>(mb) * 1024 * 1024;
+  }();
+  return limit;
+}
+
 template<typename algo_t>
 size_t getMaxWorkspaceSize(
     const ConvolutionArgs& args,
@@ -450,7 +475,8 @@ size_t getMaxWorkspaceSize(
         size_t sz;
         err = getWorkspaceSize(args, algo[i], &sz);
         if (CUDNN_STATUS_SUCCESS != err || sz == 0
-            || sz < max_ws_size || sz > max_block_size) continue;
+            || sz < max_ws_size || sz > max_block_size
+            || sz > getConvWorkspaceLimit()) continue;
         max_ws_size = sz;
     }
     return max_ws_size;
@@ -458,8 +484,9 @@ size_t getMaxWorkspaceSize(
 
 template<typename perf_t>
 perf_t getBestAlgorithm(perf_t *perfResults, const ConvolutionArgs& args, int n_algo) {
-  int best_algo_idx;
+  int best_algo_idx = -1;
   bool is_deterministic = false;
+  size_t workspace_limit = getConvWorkspaceLimit();
   if (args.params.deterministic) {
     // iterate over perf results of all algorithms and find the best deterministic algo
     for (int i = 0; i < n_algo; i++) {
@@ -467,16 +494,30 @@ perf_t getBestAlgorithm(perf_t *perfResults, const ConvolutionArgs& args, int n_
       // Double check documentation for cudnnFindConvolutionForwardAlgorithmEx
       if (perfResults[i].status == CUDNN_STATUS_SUCCESS &&
           perfResults[i].determinism == CUDNN_DETERMINISTIC) {
-        best_algo_idx = i;
         is_deterministic = true;
-        break;
+        if (perfResults[i].memory <= workspace_limit) {
+          best_algo_idx = i;
+          break;
+        }
       }
     }
     if (!is_deterministic) {
       AT_ERROR("no deterministic convolution algorithms available in CuDNN");
     }
   } else {
-    best_algo_idx = 0;
+    for (int i = 0; i < n_algo; i++) {
+      if (perfResults[i].memory <= workspace_limit) {
+        best_algo_idx = i;
+        break;
+      }
+    }
+  }
+  if (best_algo_idx < 0) {
+    // Nothing fits in the workspace limit, findAlgorithm falls back to the
+    // default algorithm
+    perf_t result = perfResults[0];
+    result.status = CUDNN_STATUS_NOT_SUPPORTED;
+    return result;
   }
 
   // See Note [blacklist fft algorithms for strided dgrad]
@@ -508,6 +549,7 @@ struct algorithm_search<cudnnConvolutionFwdAlgoPerf_t> {
 
   static constexpr auto DEFAULT_ALGO = CUDNN_CONVOLUTION_FWD_ALGO_IMPLICIT_PRECOMP_GEMM;
   static BenchmarkCache<perf_t>& cache() { return fwd_algos; }
+  static const char* name() { return "fwd"; }
 
   static perf_t findAlgorithm(const ConvolutionArgs& args, bool benchmark) {
     static const algo_t algos[] = {
@@ -575,6 +617,7 @@ struct algorithm_search<cudnnConvolutionBwdDataAlgoPerf_t> {
 
   static constexpr auto DEFAULT_ALGO = CUDNN_CONVOLUTION_BWD_DATA_ALGO_1;
   static BenchmarkCache<perf_t>& cache() { return bwd_data_algos; }
+  static const char* name() { return "bwd_data"; }
 
   static perf_t findAlgorithm(const ConvolutionArgs& args, bool benchmark) {
     static const algo_t algos[] = {
@@ -641,6 +684,7 @@ struct algorithm_search<cudnnConvolutionBwdFilterAlgoPerf_t> {
   static constexpr auto DEFAULT_ALGO = CUDNN_CONVOLUTION_BWD_FILTER_ALGO_1;
 
   static BenchmarkCache<perf_t>& cache() { return bwd_filter_algos; }
+  static const char* name() { return "bwd_filter"; }
 
   static perf_t findAlgorithm(const ConvolutionArgs& args, bool benchmark) {
     static const algo_t algos[] = {
@@ -698,11 +742,143 @@ struct algorithm_search<cudnnConvolutionBwdFilterAlgoPerf_t> {
   }
 };
 
+// ---------------------------------------------------------------------
+//
+// Persistent algorithm cache
+//
+// ---------------------------------------------------------------------
+
+// When PYTORCH_CUDNN_CONV_CACHE_FILE names a file, every algorithm found by
+// benchmarking is appended to it. On the first convolution of a process, the
+// entries of the file for the GPU model of the current device and the cuDNN
+// version in use are loaded into the benchmark caches, so other processes and
+// later runs skip the search for shapes that were already benchmarked.
+//
+// Each line holds "<direction> <gpu model> <cudnn version> <params> <algo>
+// <math type> <determinism> <workspace size>", where params is the hex dump
+// of ConvolutionParams. Lines that don't parse are ignored, and lines written
+// concurrently by several processes are appended whole.
+
+const char* getConvCacheFile() {
+  return std::getenv("PYTORCH_CUDNN_CONV_CACHE_FILE");
+}
+
+std::string getGpuModelKey() {
+  std::string name = at::cuda::getCurrentDeviceProperties()->name;
+  std::replace(name.begin(), name.end(), ' ', '_');
+  return name;
+}
+
+std::string paramsToHex(const ConvolutionParams& params) {
+  static const char digits[] = "0123456789abcdef";
+  auto bytes = reinterpret_cast<const uint8_t*>(&params);
+  std::string hex;
+  hex.reserve(2 * sizeof(ConvolutionParams));
+  for (size_t i = 0; i < sizeof(ConvolutionParams); i++) {
+    hex.push_back(digits[bytes[i] >> 4]);
+    hex.push_back(digits[bytes[i] & 0xf]);
+  }
+  return hex;
+}
+
+bool paramsFromHex(const std::string& hex, ConvolutionParams* params) {
+  if (hex.size() != 2 * sizeof(ConvolutionParams)) {
+    return false;
+  }
+  auto nibble = [](char c) -> int {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+  };
+  auto bytes = reinterpret_cast<uint8_t*>(params);
+  for (size_t i = 0; i < sizeof(ConvolutionParams); i++) {
+    int hi = nibble(hex[2 * i]);
+    int lo = nibble(hex[2 * i + 1]);
+    if (hi < 0 || lo < 0) {
+      return false;
+    }
+    bytes[i] = static_cast<uint8_t>((hi << 4) | lo);
+  }
+  return true;
+}
+
+template<typename perf_t>
+void loadCachedAlgorithm(const ConvolutionParams& params, int algo, int math_type,
+                         int determinism, size_t memory) {
+  if (memory > getConvWorkspaceLimit()) {
+    return;
+  }
+  perf_t perf;
+  memset(&perf, 0, sizeof(perf));
+  perf.algo = static_cast<decltype(perf.algo)>(algo);
+  perf.status = CUDNN_STATUS_SUCCESS;
+  perf.memory = memory;
+  perf.determinism = static_cast<cudnnDeterminism_t>(determinism);
+  perf.mathType = static_cast<cudnnMathType_t>(math_type);
+  algorithm_search<perf_t>::cache().insert(params, perf);
+}
+
+void loadCachedAlgorithms() {
+  static std::once_flag once;
+  std::call_once(once, [] {
+    const char* path = getConvCacheFile();
+    if (!path) {
+      return;
+    }
+    std::ifstream file(path);
+    std::string gpu = getGpuModelKey();
+    int64_t version = cudnn_version();
+    std::string line;
+    while (std::getline(file, line)) {
+      std::istringstream fields(line);
+      std::string kind, line_gpu, hex;
+      int64_t line_version;
+      int algo, math_type, determinism;
+      size_t memory;
+      ConvolutionParams params;
+      if (!(fields >> kind >> line_gpu >> line_version >> hex >> algo >> math_type
+                   >> determinism >> memory) ||
+          line_gpu != gpu || line_version != version || !paramsFromHex(hex, &params)) {
+        continue;
+      }
+      if (kind == algorithm_search<cudnnConvolutionFwdAlgoPerf_t>::name()) {
+        loadCachedAlgorithm<cudnnConvolutionFwdAlgoPerf_t>(params, algo, math_type, determinism, memory);
+      } else if (kind == algorithm_search<cudnnConvolutionBwdDataAlgoPerf_t>::name()) {
+        loadCachedAlgorithm<cudnnConvolutionBwdDataAlgoPerf_t>(params, algo, math_type, determinism, memory);
+      } else if (kind == algorithm_search<cudnnConvolutionBwdFilterAlgoPerf_t>::name()) {
+        loadCachedAlgorithm<cudnnConvolutionBwdFilterAlgoPerf_t>(params, algo, math_type, determinism, memory);
+      }
+    }
+  });
+}
+
+template<typename perf_t>
+void saveCachedAlgorithm(const ConvolutionParams& params, const perf_t& perf) {
+  const char* path = getConvCacheFile();
+  if (!path) {
+    return;
+  }
+  std::ostringstream line;
+  line << algorithm_search<perf_t>::name() << " " << getGpuModelKey() << " "
+       << cudnn_version() << " " << paramsToHex(params) << " "
+       << static_cast<int>(perf.algo) << " " << static_cast<int>(perf.mathType) << " "
+       << static_cast<int>(perf.determinism) << " " << perf.memory << "\n";
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> guard(mutex);
+  std::ofstream file(path, std::ios::app);
+  // a single write, so lines of concurrent processes don't interleave
+  file << line.str() << std::flush;
+}
+
 template<typename perf_t>
 void findAlgorithm(const ConvolutionArgs& args, bool benchmark, perf_t* algoPerf) {
   using search = algorithm_search<perf_t>;
   auto& cache = search::cache();
 
+  if (benchmark) {
+    loadCachedAlgorithms();
+  }
+
   if (cache.find(args.params, algoPerf)) {
     return;
   }
@@ -734,6 +910,7 @@ void findAlgorithm(const ConvolutionArgs& args, bool benchmark, perf_t* algoPerf
       // if benchmarking, map the original params with the found algo+math type for re-use
       if (benchmark) {
         cache.insert(args.params, perfResults);
+        saveCachedAlgorithm(args.params, perfResults);
 
         // Free the cached blocks in our caching allocator. They are
         // needed here because the above benchmarking uses a huge amount of memory,
@@ -750,6 +927,11 @@ void findAlgorithm(const ConvolutionArgs& args, bool benchmark, perf_t* algoPerf
         algoPerf->mathType = CUDNN_DEFAULT_MATH;
       }
       search::getWorkspaceSize(args, algoPerf->algo, &(algoPerf->memory));
+      if (benchmark) {
+        // remember the fallback too, so the search isn't repeated
+        algoPerf->status = CUDNN_STATUS_SUCCESS;
+        cache.insert(args.params, *algoPerf);
+      }
   }
 }
 
@@ -899,17 +1081,21 @@ Tensor cudnn_convolution_forward(
   checkAllSameType(c, {input, weight});
   checkAllSameGPU(c, {input, weight});
 
+  // The output (and the filter) follow the layout of the input, so a
+  // channels last input is convolved as NHWC without any reorder.
+  auto memory_format = input->suggest_memory_format();
   auto output_t = at::empty(
                     conv_output_size(input->sizes(), weight->sizes(),
                                      padding, stride, dilation, groups),
-                    input->options());
+                    input->options(),
+                    memory_format);
 
   // Avoid ambiguity of "output" when this is being used as backwards
   TensorArg output{ output_t, "result", 0 };
   convolution_shape_check(c, input, weight, output, padding, stride, dilation, groups);
 
   // See #4500
-  Tensor weight_contig = weight->contiguous();
+  Tensor weight_contig = weight->contiguous(memory_format);
 
   raw_cudnn_convolution_forward_out(
       *output, *input, weight_contig,
@@ -64,6 +64,13 @@ Tensor _cudnn_init_dropout_state(double dropout, bool train, int64_t dropout_see
 #include <ATen/cudnn/Types.h>
 #include <ATen/cudnn/Utils.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+
 namespace at { namespace native {
 
 namespace {
@@ -366,6 +373,133 @@ namespace {
     return weight_size / elem_size;
   }
 
+  // Setup of the cuDNN calls that only depends on their shapes and
+  // parameters, keyed by a flat list of integers. The cache is cleared once
+  // it holds max_entries: keys include the input sizes, so that inputs of
+  // ever changing shapes, e.g. packed batches of sequences, would otherwise
+  // grow it without bound.
+  template <typename T>
+  struct RNNSetupCache {
+    explicit RNNSetupCache(size_t max_entries) : max_entries(max_entries) {}
+
+    std::shared_ptr<T> find(const std::vector<int64_t>& key) {
+      std::lock_guard<std::mutex> guard(mutex);
+      auto it = entries.find(key);
+      return it == entries.end() ? nullptr : it->second;
+    }
+
+    void insert(std::vector<int64_t> key, std::shared_ptr<T> value) {
+      std::lock_guard<std::mutex> guard(mutex);
+      if (entries.size() >= max_entries) {
+        entries.clear();
+      }
+      entries[std::move(key)] = std::move(value);
+    }
+
+    void erase(const std::vector<int64_t>& key) {
+      std::lock_guard<std::mutex> guard(mutex);
+      entries.erase(key);
+    }
+
+    template <typename Predicate>
+    void erase_if(Predicate predicate) {
+      std::lock_guard<std::mutex> guard(mutex);
+      for (auto it = entries.begin(); it != entries.end();) {
+        if (predicate(*it->second)) {
+          it = entries.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+
+    const size_t max_entries;
+    std::mutex mutex;
+    std::map<std::vector<int64_t>, std::shared_ptr<T>> entries;
+  };
+
+  void append_key(std::vector<int64_t>& key, IntArrayRef values) {
+    key.push_back(values.size());
+    key.insert(key.end(), values.begin(), values.end());
+  }
+
+  int64_t pointer_key(const void* ptr) {
+    return static_cast<int64_t>(reinterpret_cast<intptr_t>(ptr));
+  }
+
+  // The descriptors and workspace sizes of the cuDNN calls of one RNN, for
+  // one shape of input on one handle.
+  struct RNNPlan {
+    RNNPlan(const RNNParams& fn, cudnnHandle_t handle, cudnnDataType_t datatype,
+            const Tensor& x, const Tensor& y, const Tensor& hx, const Tensor& cx)
+        : descs(fn, handle, x, y, hx, cx),
+          x_descs_arr(descs.get_x_descs()),
+          y_descs_arr(descs.get_y_descs()),
+          num_weights(get_num_weights(handle, descs.rnn_desc, descs.x_descs[0], datatype)),
+          reserve_size(0) {
+      AT_CUDNN_CHECK(cudnnGetRNNWorkspaceSize(
+            handle,
+            descs.rnn_desc.desc(),
+            fn.tensors.seq_length,
+            x_descs_arr.data(),
+            &workspace_size
+            ));
+      if (fn.dropout.train) {
+        AT_CUDNN_CHECK(cudnnGetRNNTrainingReserveSize(
+              handle,
+              descs.rnn_desc.desc(),
+              fn.tensors.seq_length,
+              x_descs_arr.data(),
+              &reserve_size
+              ));
+      }
+    }
+
+    RNNDescriptors descs;
+    std::vector<cudnnTensorDescriptor_t> x_descs_arr;
+    std::vector<cudnnTensorDescriptor_t> y_descs_arr;
+    int64_t num_weights;
+    size_t workspace_size;
+    size_t reserve_size; // 0 in inference
+  };
+
+  // Building the descriptors, and in particular restoring the dropout
+  // descriptor, costs more than the kernels of short sequences, so plans are
+  // cached. A plan is only used with the handle it was built on, so it is
+  // never used by two threads at once.
+  std::shared_ptr<RNNPlan> get_rnn_plan(
+      const RNNParams& fn, cudnnHandle_t handle, cudnnDataType_t datatype,
+      const Tensor& x, const Tensor& y, const Tensor& hx, const Tensor& cx) {
+    // Leaked, so that no descriptor is destroyed after cuDNN at exit
+    static auto* cache = new RNNSetupCache<RNNPlan>(1024);
+    std::vector<int64_t> key = {
+      x.get_device(), pointer_key(handle),
+      fn.rnn.hidden_size, fn.rnn.num_layers, fn.rnn.bidirectional,
+      fn.rnn.mode, fn.rnn.datatype, fn.rnn.input_datatype, fn.rnn.algo,
+      fn.rnn.input_mode, datatype, fn.dropout.train, cx.defined()
+    };
+    if (fn.dropout.train && fn.dropout.dropout > 0) {
+      int64_t dropout_bits;
+      static_assert(sizeof(dropout_bits) == sizeof(fn.dropout.dropout), "double is not 64 bits");
+      std::memcpy(&dropout_bits, &fn.dropout.dropout, sizeof(dropout_bits));
+      key.push_back(dropout_bits);
+      key.push_back(pointer_key(fn.dropout.dropout_state.data_ptr()));
+    }
+    append_key(key, fn.tensors.batch_sizes);
+    for (const auto& tensor : {x, y, hx, cx}) {
+      if (tensor.defined()) {
+        append_key(key, tensor.sizes());
+        append_key(key, tensor.strides());
+      }
+    }
+    auto plan = cache->find(key);
+    if (!plan) {
+      plan = std::make_shared<RNNPlan>(fn, handle, datatype, x, y, hx, cx);
+      cache->insert(std::move(key), plan);
+    }
+    return plan;
+  }
+
   int64_t _num_linear_layers(cudnnRNNMode_t mode) {
     switch(mode) {
       case CUDNN_LSTM:
@@ -613,6 +747,98 @@ namespace {
     return dtype;
   }
 
+  // Copies weight into a new buffer of the cuDNN layout.
+  Tensor flatten_weights(
+      cudnnHandle_t handle, const RNNParams& fn, const RNNPlan& plan,
+      TensorList weight, int64_t weight_stride0, const TensorOptions& options) {
+    auto weight_buf = at::empty(plan.num_weights, options);
+    FilterDescriptor w_desc;
+    w_desc.set(weight_buf, 3);
+    weight_buf.zero_();
+    std::vector<Tensor> params;
+    size_t params_stride0;
+    std::tie(params, params_stride0) = get_parameters(handle, fn.rnn, plan.descs.rnn_desc, plan.descs.x_descs[0], w_desc, weight_buf);
+    _copyParams(MatrixRef<Tensor>{weight, static_cast<size_t>(weight_stride0)},
+                MatrixRef<Tensor>{params, params_stride0});
+    return weight_buf;
+  }
+
+  // A copy of the weights of an RNN in the cuDNN layout, for RNNs whose
+  // parameters aren't views of such a buffer. It is valid while the weights
+  // are the same tensors, at the same addresses, and haven't been modified in
+  // place since, as told by their version counters.
+  struct FlatWeights {
+    FlatWeights(TensorList weight, Tensor weight_buf)
+        : weight_buf(std::move(weight_buf)) {
+      for (const auto& w : weight) {
+        params.emplace_back(w.getIntrusivePtr());
+        versions.push_back(w.unsafeGetTensorImpl()->version_counter().current_version());
+        data_ptrs.push_back(w.data_ptr());
+      }
+    }
+
+    bool matches(TensorList weight) const {
+      if (weight.size() != params.size()) {
+        return false;
+      }
+      for (size_t i = 0; i < weight.size(); i++) {
+        if (params[i].lock().get() != weight[i].unsafeGetTensorImpl() ||
+            versions[i] != weight[i].unsafeGetTensorImpl()->version_counter().current_version() ||
+            data_ptrs[i] != weight[i].data_ptr()) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    bool expired() const {
+      return std::any_of(params.begin(), params.end(),
+                         [](const c10::weak_intrusive_ptr<TensorImpl, UndefinedTensorImpl>& param) {
+                           return param.expired();
+                         });
+    }
+
+    // weak, so that the entries of dead RNNs can be told apart from those
+    // of new tensors at the same addresses
+    std::vector<c10::weak_intrusive_ptr<TensorImpl, UndefinedTensorImpl>> params;
+    std::vector<uint32_t> versions;
+    std::vector<void*> data_ptrs;
+    Tensor weight_buf;
+  };
+
+  // The weights of an RNN whose parameters aren't flattened, in the cuDNN
+  // layout. Inference keeps the copy for the next calls with the same,
+  // unmodified parameters, so that e.g. running an RNN one step at a time
+  // doesn't copy all the weights at every step. Training doesn't keep it, and
+  // drops the copy kept for its parameters: optimizers update parameters
+  // through .data, which doesn't bump their version counter.
+  Tensor get_flat_weights(
+      cudnnHandle_t handle, const RNNParams& fn, const RNNPlan& plan,
+      TensorList weight, int64_t weight_stride0, const TensorOptions& options) {
+    // Leaked, so that no tensor is freed after CUDA at exit
+    static auto* cache = new RNNSetupCache<FlatWeights>(16);
+    std::vector<int64_t> key = {
+      options.device().index(), fn.rnn.hidden_size, fn.rnn.num_layers,
+      fn.rnn.bidirectional, fn.rnn.mode, fn.rnn.input_datatype,
+      fn.tensors.input_size, weight_stride0
+    };
+    for (const auto& w : weight) {
+      key.push_back(pointer_key(w.unsafeGetTensorImpl()));
+    }
+    if (fn.dropout.train) {
+      cache->erase(key);
+      return flatten_weights(handle, fn, plan, weight, weight_stride0, options);
+    }
+    auto flat = cache->find(key);
+    if (flat && flat->matches(weight)) {
+      return flat->weight_buf;
+    }
+    auto weight_buf = flatten_weights(handle, fn, plan, weight, weight_stride0, options);
+    cache->erase_if([](const FlatWeights& flat) { return flat.expired(); });
+    cache->insert(std::move(key), std::make_shared<FlatWeights>(weight, weight_buf));
+    return weight_buf;
+  }
+
 } // anonymous namespace
 
 // NB: does inplace update into TensorList
@@ -733,51 +959,27 @@ std::tuple<Tensor, Tensor, Tensor, Tensor, Tensor> _cudnn_rnn(
   auto handle = getCudnnHandle();
   cudnnRNNAlgo_t algo = get_algo(fn.rnn, fn.tensors, input);
   fn.rnn.set_algo(algo);
-  RNNDescriptors descs(fn, handle, x, y, hx, cx);
+  auto plan = get_rnn_plan(fn, handle, datatype, x, y, hx, cx);
+  auto& descs = plan->descs;
 
-  FilterDescriptor w_desc;
   if (!weight_buf.defined()) {
-    auto num_weights = get_num_weights(handle, descs.rnn_desc, descs.x_descs[0], datatype);
-    weight_buf = at::empty(num_weights, x.options());
-    w_desc.set(weight_buf, 3);
-    weight_buf.zero_();
-    std::vector<Tensor> params;
-    size_t params_stride0;
-    std::tie(params, params_stride0) = get_parameters(handle, fn.rnn, descs.rnn_desc, descs.x_descs[0], w_desc, weight_buf);
-    _copyParams(MatrixRef<Tensor>{weight, static_cast<size_t>(weight_stride0)},
-                MatrixRef<Tensor>{params, params_stride0});
-  } else {
-    w_desc.set(weight_buf, 3);
+    weight_buf = get_flat_weights(handle, fn, *plan, weight, weight_stride0, x.options());
   }
+  FilterDescriptor w_desc;
+  w_desc.set(weight_buf, 3);
 
   AT_CHECK(!cx.defined() || cx.sizes().equals(hidden_size),
            "Expected cell size ", IntArrayRef{hidden_size}, ", got ", cx.sizes());
 
-  size_t workspace_size;
-  auto x_descs_arr = descs.get_x_descs();
-  auto y_descs_arr = descs.get_y_descs();
-  AT_CUDNN_CHECK(cudnnGetRNNWorkspaceSize(
-        handle,
-        descs.rnn_desc.desc(),
-        fn.tensors.seq_length,
-        x_descs_arr.data(),
-        &workspace_size
-        ));
-  Tensor workspace = at::empty(workspace_size, input.options().dtype(kByte));
+  const auto& x_descs_arr = plan->x_descs_arr;
+  const auto& y_descs_arr = plan->y_descs_arr;
+  Tensor workspace = at::empty(plan->workspace_size, input.options().dtype(kByte));
 
   Tensor reserve;
   // NB: Previously, the test was for fn.requires_grad, but we don't have
   // this information.  Use 'train' as a proxy.
   if (fn_train) {
-    size_t reserve_size;
-    AT_CUDNN_CHECK(cudnnGetRNNTrainingReserveSize(
-          handle,
-          descs.rnn_desc.desc(),
-          fn.tensors.seq_length,
-          x_descs_arr.data(),
-          &reserve_size
-          ));
-    reserve = at::empty(reserve_size, input.options().dtype(kByte));
+    reserve = at::empty(plan->reserve_size, input.options().dtype(kByte));
     AT_CUDNN_CHECK(cudnnRNNForwardTraining(
           handle,
           descs.rnn_desc.desc(),
@@ -895,23 +1097,16 @@ std::tuple<Tensor, Tensor, Tensor> _cudnn_rnn_backward_input(
 
   cudnnRNNAlgo_t algo = get_algo(fn.rnn, fn.tensors, input);
   fn.rnn.set_algo(algo);
-  RNNDescriptors descs(fn, handle, x, y, hx, cx);
+  auto plan = get_rnn_plan(fn, handle, datatype, x, y, hx, cx);
+  auto& descs = plan->descs;
 
   FilterDescriptor w_desc;
   w_desc.set(weight_buf, 3);
 
-  size_t workspace_size;
-  auto x_descs_arr = descs.get_x_descs();
-  auto y_descs_arr = descs.get_y_descs();
-  AT_CUDNN_CHECK(cudnnGetRNNWorkspaceSize(
-        handle,
-        descs.rnn_desc.desc(),
-        fn.tensors.seq_length,
-        x_descs_arr.data(),
-        &workspace_size
-        ));
+  const auto& x_descs_arr = plan->x_descs_arr;
+  const auto& y_descs_arr = plan->y_descs_arr;
   // TODO: put this in the correct device???
-  Tensor workspace = at::empty(workspace_size, input.options().dtype(kByte));
+  Tensor workspace = at::empty(plan->workspace_size, input.options().dtype(kByte));
 
   AT_CUDNN_CHECK(cudnnRNNBackwardData(
         handle,
@@ -1000,22 +1195,15 @@ std::vector<Tensor> _cudnn_rnn_backward_weight(
 
   cudnnRNNAlgo_t algo = get_algo(fn.rnn, fn.tensors, input);
   fn.rnn.set_algo(algo);
-  RNNDescriptors descs(fn, handle, x, y, hx, cx);
+  auto plan = get_rnn_plan(fn, handle, datatype, x, y, hx, cx);
+  auto& descs = plan->descs;
 
   FilterDescriptor w_desc;
   w_desc.set(weight_buf, 3);
 
-  size_t workspace_size;
-  auto x_descs_arr = descs.get_x_descs();
-  auto y_descs_arr = descs.get_y_descs();
-  AT_CUDNN_CHECK(cudnnGetRNNWorkspaceSize(
-        handle,
-        descs.rnn_desc.desc(),
-        fn.tensors.seq_length,
-        x_descs_arr.data(),
-        &workspace_size
-        ));
-  Tensor workspace = at::empty(workspace_size, input.options().dtype(kByte));
+  const auto& x_descs_arr = plan->x_descs_arr;
+  const auto& y_descs_arr = plan->y_descs_arr;
+  Tensor workspace = at::empty(plan->workspace_size, input.options().dtype(kByte));
 
   AT_CUDNN_CHECK(cudnnRNNBackwardWeights(
         handle,
@@ -1171,7 +1359,9 @@ DropoutState& get_dropout_state(double dropout_p, bool train, TensorOptions opti
   return state;
 }
 
-Tensor try_get_weight_buf(
+// The number of elements of the buffer in the cuDNN layout that the
+// parameters are views of, starting at their storage, or -1 if they aren't.
+int64_t get_weight_buf_size(
       const Tensor& input, TensorList parameters, bool has_biases,
       cudnnRNNMode_t mode, int64_t hidden_size, int64_t num_layers, bool bidirectional) {
   // Prepare all relevant descriptors
@@ -1193,7 +1383,7 @@ Tensor try_get_weight_buf(
   auto param_storage = any_param.storage();
   auto weight_buf = at::empty({0}, any_param.options()).set_(param_storage);
   if (weight_buf.size(0) < num_params) {
-    return {};
+    return -1;
   } else if (weight_buf.size(0) > num_params) {
     weight_buf = weight_buf.narrow(0, 0, num_params);
   }
@@ -1209,10 +1399,44 @@ Tensor try_get_weight_buf(
   for (int64_t param_i = 0, ptr_i = 0;
        ptr_i < num_ptrs;
        ptr_i += (has_biases ? 2 : 4), param_i += 2) {
-    if (expected_data_ptrs[ptr_i] != parameters[param_i].data_ptr()) return {};
-    if (expected_data_ptrs[ptr_i + 1] != parameters[param_i + 1].data_ptr()) return {};
+    if (expected_data_ptrs[ptr_i] != parameters[param_i].data_ptr()) return -1;
+    if (expected_data_ptrs[ptr_i + 1] != parameters[param_i + 1].data_ptr()) return -1;
+  }
+  if (!parameters[num_parameters - 1].is_contiguous()) return -1;
+  return num_params;
+}
+
+Tensor try_get_weight_buf(
+      const Tensor& input, TensorList parameters, bool has_biases,
+      cudnnRNNMode_t mode, int64_t hidden_size, int64_t num_layers, bool bidirectional) {
+  // Whether the parameters are flattened only depends on their addresses,
+  // so it is only checked once for every set of addresses. Leaked, like the
+  // caches of the anonymous namespace.
+  static auto* cache = new RNNSetupCache<int64_t>(1024);
+  auto & any_param = parameters.at(0);
+  auto param_storage = any_param.storage();
+  std::vector<int64_t> key = {
+    any_param.get_device(), mode, hidden_size, num_layers, bidirectional,
+    getCudnnDataType(input), input.size(-1), has_biases,
+    pointer_key(param_storage.data()), param_storage.numel(),
+    parameters.back().is_contiguous()
+  };
+  for (const auto& param : parameters) {
+    key.push_back(pointer_key(param.data_ptr()));
+  }
+  auto num_params = cache->find(key);
+  if (!num_params) {
+    num_params = std::make_shared<int64_t>(get_weight_buf_size(
+        input, parameters, has_biases, mode, hidden_size, num_layers, bidirectional));
+    cache->insert(std::move(key), num_params);
+  }
+  if (*num_params < 0) {
+    return {};
+  }
+  auto weight_buf = at::empty({0}, any_param.options()).set_(param_storage);
+  if (weight_buf.size(0) > *num_params) {
+    weight_buf = weight_buf.narrow(0, 0, *num_params);
   }
-  if (!parameters[num_parameters - 1].is_contiguous()) return {};
   return weight_buf;
 }
 
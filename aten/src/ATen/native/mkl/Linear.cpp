@@ -0,0 +1,89 @@
+#include <ATen/ATen.h>
+#include <ATen/NativeFunctions.h>
+#include <ATen/Config.h>
+
+#if !AT_MKL_ENABLED()
+
+namespace at { namespace native {
+
+// Without MKL there is nothing to pack, and mkl_linear is plain linear.
+Tensor mkl_linear_pack_weight(const Tensor& weight, int64_t batch_size) {
+  return at::empty({0}, weight.options());
+}
+
+Tensor mkl_linear(const Tensor& input, const Tensor& packed_weight,
+                  const Tensor& weight, const Tensor& bias, int64_t batch_size) {
+  return at::linear(input, weight, bias);
+}
+
+}}
+
+#else // AT_MKL_ENABLED
+
+#include <mkl.h>
+
+#include <vector>
+
+namespace at { namespace native {
+
+static bool mkl_linear_packable(const Tensor& weight, int64_t batch_size) {
+  return weight.scalar_type() == kFloat && weight.device().is_cpu() &&
+      weight.dim() == 2 && !weight.requires_grad() && batch_size > 0;
+}
+
+// Packs the weight [N, K] of a linear layer as the B matrix of
+// cblas_sgemm_compute, so that MKL does not repack it on every call. The
+// packed layout depends on the number of rows of the input, so the weight is
+// packed for one batch_size. Returns an empty tensor when the weight cannot
+// be packed.
+Tensor mkl_linear_pack_weight(const Tensor& weight, int64_t batch_size) {
+  if (!mkl_linear_packable(weight, batch_size)) {
+    return at::empty({0}, weight.options().dtype(kFloat));
+  }
+  auto weight_contig = weight.contiguous();
+  const MKL_INT M = batch_size;
+  const MKL_INT N = weight.size(0);
+  const MKL_INT K = weight.size(1);
+  const size_t bytes = cblas_sgemm_pack_get_size(CblasBMatrix, M, N, K);
+  // The CPU allocator aligns the buffer to 64 bytes, as MKL recommends
+  Tensor packed = at::empty({static_cast<int64_t>((bytes + sizeof(float) - 1) / sizeof(float))},
+                            weight.options().dtype(kFloat));
+  cblas_sgemm_pack(CblasRowMajor, CblasBMatrix, CblasTrans, M, N, K, 1.0f,
+                   weight_contig.data<float>(), K, packed.data<float>());
+  return packed;
+}
+
+// linear(input, weight, bias) with the weight packed by mkl_linear_pack_weight
+// for batch_size rows. Other inputs, and empty packed weights, fall back to
+// linear.
+Tensor mkl_linear(const Tensor& input, const Tensor& packed_weight,
+                  const Tensor& weight, const Tensor& bias, int64_t batch_size) {
+  const int64_t K = weight.size(-1);
+  if (packed_weight.numel() == 0 || input.scalar_type() != kFloat ||
+      input.is_mkldnn() || input.dim() < 1 || input.size(-1) != K ||
+      input.numel() / K != batch_size || input.requires_grad() ||
+      !mkl_linear_packable(weight, batch_size)) {
+    return at::linear(input, weight, bias);
+  }
+  const MKL_INT M = batch_size;
+  const MKL_INT N = weight.size(0);
+  auto input_contig = input.contiguous();
+  Tensor output;
+  float beta = 0.0f;
+  if (bias.defined()) {
+    output = bias.to(kFloat).expand({M, N}).contiguous();
+    beta = 1.0f;
+  } else {
+    output = at::empty({M, N}, input.options());
+  }
+  cblas_sgemm_compute(CblasRowMajor, CblasNoTrans, CblasPacked, M, N, K,
+                      input_contig.data<float>(), K, packed_weight.data<float>(),
+                      K, beta, output.data<float>(), N);
+  std::vector<int64_t> out_sizes = input.sizes().vec();
+  out_sizes.back() = N;
+  return output.view(out_sizes);
+}
+
+}}
+
+#endif
@@ -38,10 +38,191 @@ std::tuple<at::Tensor,at::Tensor,at::Tensor> mkldnn_convolution_backward(
 #include <ATen/native/mkldnn/MKLDNNCommon.h>
 #include <ATen/native/mkldnn/Utils.h>
 
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 using namespace mkldnn;
 
 namespace at { namespace native {
 
+namespace {
+
+// Each thread keeps the primitives of this many convolution shapes, and the
+// reordered copies of this many weights, for later calls.
+constexpr size_t kConvCacheCapacity = 128;
+
+// The primitives of mkldnn_convolution for one shape. Creating them and
+// choosing the weight format takes longer than small convolutions do, so
+// they are kept and pointed at the tensors of each call with
+// set_data_handle().
+struct ConvForwardPrimitives {
+  std::shared_ptr<convolution_forward::primitive_desc> pd;
+  std::shared_ptr<memory> input_usr_memory;
+  std::shared_ptr<memory> bias_usr_memory;
+  std::shared_ptr<memory> output_usr_memory;
+  // The memory read by the convolution; a copy of the weight in another
+  // format if reorders_weight, else the weight itself.
+  std::shared_ptr<memory> weight_memory;
+  std::shared_ptr<memory::primitive_desc> weight_usr_pd;
+  bool reorders_weight;
+  std::vector<primitive> net;
+};
+
+// A weight reordered into the format of some convolution. It is reordered
+// again when the weight is freed or modified in place, which bumps its
+// version. Like the checks of saved variables in autograd, this misses
+// writes through a `.data` of the weight, which has a version of its own.
+struct ReorderedWeight {
+  ReorderedWeight(const Tensor& weight, std::shared_ptr<memory> reordered)
+      : weight(weight.getIntrusivePtr()),
+        data(weight.data_ptr()),
+        version(weight.unsafeGetTensorImpl()->version_counter().current_version()),
+        reordered(std::move(reordered)) {}
+
+  bool is_copy_of(const Tensor& weight, const memory::primitive_desc& pd) const {
+    return !this->weight.expired() && data == weight.data_ptr() &&
+        version == weight.unsafeGetTensorImpl()->version_counter().current_version() &&
+        reordered->get_primitive_desc() == pd;
+  }
+
+  c10::weak_intrusive_ptr<TensorImpl, UndefinedTensorImpl> weight;
+  void* data;
+  uint32_t version;
+  std::shared_ptr<memory> reordered;
+};
+
+std::map<std::vector<int64_t>, ConvForwardPrimitives>& conv_forward_cache() {
+  static thread_local std::map<std::vector<int64_t>, ConvForwardPrimitives> cache;
+  return cache;
+}
+
+// Returns the data of a copy of `weight` in the format of `weight_memory`,
+// reordering it only if it is not cached yet.
+void* reordered_weight(
+    const Tensor& weight,
+    const memory::primitive_desc& weight_usr_pd,
+    const memory& weight_memory) {
+  static thread_local std::unordered_map<const TensorImpl*, ReorderedWeight> cache;
+  const auto pd = weight_memory.get_primitive_desc();
+  auto it = cache.find(weight.unsafeGetTensorImpl());
+  if (it != cache.end() && it->second.is_copy_of(weight, pd)) {
+    return it->second.reordered->get_data_handle();
+  }
+  if (it != cache.end()) {
+    cache.erase(it);
+  } else if (cache.size() >= kConvCacheCapacity) {
+    cache.clear();
+  }
+
+  auto weight_usr_memory = memory(weight_usr_pd, weight.data_ptr());
+  auto reordered = std::make_shared<memory>(pd);
+  Stream::Instance().get_stream().submit({reorder(weight_usr_memory, *reordered)});
+  cache.emplace(weight.unsafeGetTensorImpl(), ReorderedWeight(weight, reordered));
+  return reordered->get_data_handle();
+}
+
+ConvForwardPrimitives create_conv_forward(
+    const Tensor& input, const Tensor& weight, const Tensor& bias,
+    const Tensor& output, IntArrayRef padding, IntArrayRef stride,
+    int64_t groups, bool channels_last) {
+  auto cpu_engine = CpuEngine::Instance().get_engine();
+
+  int32_t g = groups;
+
+  int32_t n = input.size(0);
+  int32_t ic = input.size(1);
+  int32_t ih = input.size(2);
+  int32_t iw = input.size(3);
+
+  int32_t oc = output.size(1);
+  int32_t oh = output.size(2);
+  int32_t ow = output.size(3);
+
+  int32_t kh = weight.size(2);
+  int32_t kw = weight.size(3);
+
+  int32_t sh = stride[0];
+  int32_t sw = stride[1];
+  int32_t ph = padding[0];
+  int32_t pw = padding[1];
+
+  auto data_t = memory::data_type::f32;
+  auto format_any = memory::format::any;
+  auto format_data = channels_last ? memory::format::nhwc : memory::format::nchw;
+  auto format_weight = (g!= 1) ? memory::format::goihw : memory::format::oihw;
+  auto format_x = memory::format::x;
+
+  memory::dims input_tz = {n, ic, ih, iw};
+  memory::dims weight_tz = (g!= 1) ? memory::dims{g, oc/g, ic/g, kh, kw} : memory::dims{oc, ic, kh, kw};
+  memory::dims bias_tz = {oc};
+  memory::dims output_tz = {n, oc, oh, ow};
+  memory::dims _stride = {sh, sw};
+  memory::dims _padding = {ph, pw};
+
+  auto input_md = memory::desc({input_tz}, data_t, format_any);
+  auto weight_md = memory::desc({weight_tz}, data_t, format_any);
+  auto bias_md = memory::desc({bias_tz}, data_t, format_any);
+  auto output_md = memory::desc({output_tz}, data_t, format_any);
+
+  std::shared_ptr<convolution_forward::desc> conv_forward_desc;
+  if (bias.defined()) {
+    conv_forward_desc.reset(new convolution_forward::desc(prop_kind::forward,
+      convolution_direct, input_md, weight_md, bias_md, output_md,
+      _stride, _padding, _padding, padding_kind::zero));
+  } else {
+    conv_forward_desc.reset(new convolution_forward::desc(prop_kind::forward,
+      convolution_direct, input_md, weight_md, output_md,
+      _stride, _padding, _padding, padding_kind::zero));
+  }
+
+  ConvForwardPrimitives conv;
+  conv.pd.reset(new convolution_forward::primitive_desc(
+    *conv_forward_desc, cpu_engine));
+
+  conv.input_usr_memory.reset(new memory({{{input_tz}, data_t, format_data}, cpu_engine},
+    input.data_ptr()));
+  conv.weight_usr_pd.reset(new memory::primitive_desc({{weight_tz}, data_t, format_weight}, cpu_engine));
+  conv.output_usr_memory.reset(new memory({{{output_tz}, data_t, format_data}, cpu_engine},
+    output.data_ptr()));
+
+  auto input_pd = conv.pd->src_primitive_desc();
+  auto input_memory = *conv.input_usr_memory;
+  if (conv.input_usr_memory->get_primitive_desc() != memory::primitive_desc(input_pd)) {
+    input_memory = memory(input_pd);
+    conv.net.push_back(reorder(*conv.input_usr_memory, input_memory));
+  }
+
+  // The weight is reordered ahead of the net, once per weight.
+  auto weight_pd = conv.pd->weights_primitive_desc();
+  conv.reorders_weight = *conv.weight_usr_pd != memory::primitive_desc(weight_pd);
+  conv.weight_memory.reset(new memory(weight_pd, weight.data_ptr()));
+
+  auto output_pd = conv.pd->dst_primitive_desc();
+  auto output_memory = *conv.output_usr_memory;
+  if (conv.output_usr_memory->get_primitive_desc() != memory::primitive_desc(output_pd)) {
+    output_memory = memory(output_pd);
+  }
+
+  if (bias.defined()) {
+    conv.bias_usr_memory.reset(new memory({{{bias_tz}, data_t, format_x}, cpu_engine},
+      bias.data_ptr()));
+    conv.net.push_back(convolution_forward(*conv.pd, input_memory,
+      *conv.weight_memory, *conv.bias_usr_memory, output_memory));
+  } else {
+    conv.net.push_back(convolution_forward(*conv.pd, input_memory,
+      *conv.weight_memory, output_memory));
+  }
+
+  if (output_memory != *conv.output_usr_memory) {
+    conv.net.push_back(reorder(output_memory, *conv.output_usr_memory));
+  }
+  return conv;
+}
+
+} // namespace
+
 Tensor _mkldnn_conv2d(
     const Tensor& input, const Tensor& weight, const Tensor& bias,
     at::IntArrayRef padding, at::IntArrayRef stride, at::IntArrayRef dilation, int64_t groups) {
@@ -109,12 +290,14 @@ at::Tensor mkldnn_convolution(
     return _mkldnn_conv2d(input, weight, bias, padding, stride, dilation, groups);
   }
 
+  // A channels last input is read as nhwc and produces a channels last
+  // output, so NHWC networks do not pay for a reorder around every conv.
+  auto memory_format = input.suggest_memory_format();
   auto output = at::empty(
       conv_output_size(
           input.sizes(), weight.sizes(), padding, stride, dilation),
-      input.options());
-
-  auto cpu_engine = CpuEngine::Instance().get_engine();
+      input.options(),
+      memory_format);
 
   int32_t g = groups;
 
@@ -135,86 +318,34 @@ at::Tensor mkldnn_convolution(
   int32_t ph = padding[0];
   int32_t pw = padding[1];
 
-  auto data_t = memory::data_type::f32;
-  auto format_any = memory::format::any;
-  auto format_nchw = memory::format::nchw;
-  auto format_weight = (g!= 1) ? memory::format::goihw : memory::format::oihw;
-  auto format_x = memory::format::x;
-
-  memory::dims input_tz = {n, ic, ih, iw};
-  memory::dims weight_tz = (g!= 1) ? memory::dims{g, oc/g, ic/g, kh, kw} : memory::dims{oc, ic, kh, kw};
-  memory::dims bias_tz = {oc};
-  memory::dims output_tz = {n, oc, oh, ow};
-  memory::dims _stride = {sh, sw};
-  memory::dims _padding = {ph, pw};
-
-  auto input_md = memory::desc({input_tz}, data_t, format_any);
-  auto weight_md = memory::desc({weight_tz}, data_t, format_any);
-  auto bias_md = memory::desc({bias_tz}, data_t, format_any);
-  auto output_md = memory::desc({output_tz}, data_t, format_any);
-
-  std::shared_ptr<convolution_forward::desc> conv_forward_desc;
-  if (bias.defined()) {
-    conv_forward_desc.reset(new convolution_forward::desc(prop_kind::forward,
-      convolution_direct, input_md, weight_md, bias_md, output_md,
-      _stride, _padding, _padding, padding_kind::zero));
-  } else {
-    conv_forward_desc.reset(new convolution_forward::desc(prop_kind::forward,
-      convolution_direct, input_md, weight_md, output_md,
-      _stride, _padding, _padding, padding_kind::zero));
-  }
-
-  std::shared_ptr<convolution_forward::primitive_desc> conv_forward_pd;
-  conv_forward_pd.reset(new convolution_forward::primitive_desc(
-    *conv_forward_desc, cpu_engine));
-
-  auto input_usr_memory = memory({{{input_tz}, data_t, format_nchw}, cpu_engine},
-    input.data_ptr());
-  auto weight_usr_memory = memory({{{weight_tz}, data_t,  format_weight}, cpu_engine},
-    weight.data_ptr());
-  auto output_usr_memory = memory({{{output_tz}, data_t, format_nchw}, cpu_engine},
-    output.data_ptr());
-
-  std::vector<primitive> net;
-
-  auto input_pd = conv_forward_pd->src_primitive_desc();
-  auto input_memory = input_usr_memory;
-  if (input_usr_memory.get_primitive_desc() != memory::primitive_desc(input_pd)) {
-    input_memory = memory(input_pd);
-    net.push_back(reorder(input_usr_memory, input_memory));
-  }
-
-  auto weight_pd = conv_forward_pd->weights_primitive_desc();
-  auto weight_memory = weight_usr_memory;
-  if (weight_usr_memory.get_primitive_desc() != memory::primitive_desc(weight_pd)) {
-    weight_memory = memory(weight_pd);
-    net.push_back(reorder(weight_usr_memory, weight_memory));
-  }
-
-  auto output_pd = conv_forward_pd->dst_primitive_desc();
-  auto output_memory = output_usr_memory;
-  if (output_usr_memory.get_primitive_desc() != memory::primitive_desc(output_pd)) {
-    output_memory = memory(output_pd);
+  const bool channels_last = memory_format == MemoryFormat::ChannelsLast;
+  const std::vector<int64_t> key = {
+      n, ic, ih, iw, oc, oh, ow, kh, kw, sh, sw, ph, pw, g,
+      bias.defined(), channels_last};
+
+  auto& cache = conv_forward_cache();
+  auto it = cache.find(key);
+  if (it == cache.end()) {
+    if (cache.size() >= kConvCacheCapacity) {
+      cache.clear();
+    }
+    it = cache.emplace(key, create_conv_forward(
+        input, weight, bias, output, padding, stride, groups,
+        channels_last)).first;
   }
+  const ConvForwardPrimitives& conv = it->second;
 
-  std::shared_ptr<convolution_forward> conv_forward;
-  std::shared_ptr<memory> bias_usr_memory;
-  if (bias.defined()) {
-    bias_usr_memory.reset(new memory({{{bias_tz}, data_t, format_x}, cpu_engine},
-      bias.data_ptr()));
-    conv_forward.reset(new convolution_forward(*conv_forward_pd, input_memory,
-      weight_memory, *bias_usr_memory, output_memory));
-  } else {
-    conv_forward.reset(new convolution_forward(*conv_forward_pd, input_memory,
-      weight_memory, output_memory));
-  }
-  net.push_back(*conv_forward);
-
-  if (output_memory != output_usr_memory) {
-    net.push_back(reorder(output_memory, output_usr_memory));
+  conv.input_usr_memory->set_data_handle(input.data_ptr());
+  conv.output_usr_memory->set_data_handle(output.data_ptr());
+  if (conv.bias_usr_memory) {
+    conv.bias_usr_memory->set_data_handle(bias.data_ptr());
   }
+  conv.weight_memory->set_data_handle(
+      conv.reorders_weight
+          ? reordered_weight(weight, *conv.weight_usr_pd, *conv.weight_memory)
+          : weight.data_ptr());
 
-  Stream::Instance().get_stream().submit(net);
+  Stream::Instance().get_stream().submit(conv.net);
 
   return output;
 }
@@ -476,8 +607,10 @@ std::tuple<at::Tensor,at::Tensor,at::Tensor> mkldnn_convolution_backward(
       input.sizes(), grad_output, weight, padding, stride, dilation, groups, output_mask[2]);
   }
   if (output_mask[1] || output_mask[2]) {
+    // the backward primitives expect nchw, so a channels last input is
+    // reordered here
     std::tie(grad_weight, grad_bias) = at::mkldnn_convolution_backward_weights(
-      weight.sizes(), grad_output, input, padding, stride, dilation, groups, output_mask[2]);
+      weight.sizes(), grad_output, input.contiguous(), padding, stride, dilation, groups, output_mask[2]);
   }
 
   return std::tuple<Tensor, Tensor, Tensor>{grad_input, grad_weight, grad_bias};
@@ -0,0 +1,103 @@
+#include <ATen/ATen.h>
+#include <ATen/ExpandUtils.h>
+#include <ATen/core/Type.h>
+#include <ATen/core/op_registration/op_registration.h>
+#include <ATen/native/TensorIterator.h>
+#include <ATen/native/cpu/Loops.h>
+#include <ATen/native/quantized/cpu/quantized_ops.h>
+
+#include <algorithm>
+
+namespace at { namespace native {
+namespace {
+
+#ifdef USE_QNNPACK
+void qnnpack_add(
+    const Tensor& qa, const Tensor& qb, Tensor& qc, uint8_t qmin,
+    uint8_t qmax) {
+  init_qnnpack();
+  qnnp_operator_t add_op = nullptr;
+  qnnp_status status = qnnp_create_add_nc_q8(
+      1 /* channels */,
+      qa.q_zero_point().toLong(), qa.q_scale().toFloat(),
+      qb.q_zero_point().toLong(), qb.q_scale().toFloat(),
+      qc.q_zero_point().toLong(), qc.q_scale().toFloat(),
+      qmin, qmax,
+      0 /* flags */,
+      &add_op);
+  AT_CHECK(status == qnnp_status_success, "failed to create QNNPACK add operator");
+  std::unique_ptr<qnnp_operator, decltype(&qnnp_delete_operator)> guard(
+      add_op, qnnp_delete_operator);
+  status = qnnp_setup_add_nc_q8(
+      add_op,
+      qa.numel() /* batch size */,
+      quantized_data(qa), 1 /* a stride */,
+      quantized_data(qb), 1 /* b stride */,
+      quantized_data(qc), 1 /* sum stride */);
+  AT_CHECK(status == qnnp_status_success, "failed to setup QNNPACK add operator");
+  status = qnnp_run_operator(add_op, qnnpack_threadpool());
+  AT_CHECK(status == qnnp_status_success, "failed to run QNNPACK add operator");
+}
+#endif // USE_QNNPACK
+
+// Adds the quantized values of qa and qb and requantizes the sums to scale
+// and zero_point without dequantizing the operands, optionally clamping at
+// the zero point (ReLU).
+template <bool ReLUFused>
+class QAddInt8 final : public c10::OperatorKernel {
+ public:
+  Tensor operator()(Tensor qa, Tensor qb, double scale, int64_t zero_point) {
+    AT_CHECK(qa.is_quantized() && qb.is_quantized(),
+        "quantized::add: expected quantized operands");
+    AT_CHECK(zero_point >= 0 && zero_point <= 255,
+        "quantized::add: zero_point must be in [0, 255], but got ", zero_point);
+    const float a_scale = qa.q_scale().toFloat();
+    const float b_scale = qb.q_scale().toFloat();
+    const int32_t a_zero_point = qa.q_zero_point().toLong();
+    const int32_t b_zero_point = qb.q_zero_point().toLong();
+    const int32_t qmin = ReLUFused ? zero_point : 0;
+    const int32_t qmax = 255;
+
+    Tensor qc;
+#ifdef USE_QNNPACK
+    if (qa.sizes() == qb.sizes() && qa.is_contiguous() && qb.is_contiguous() &&
+        // the range of scale ratios QNNPACK supports
+        a_scale / scale >= 1.0f / (1 << 14) && a_scale / scale < 256 &&
+        b_scale / scale >= 1.0f / (1 << 14) && b_scale / scale < 256) {
+      qc = at::_empty_affine_quantized(qa.sizes(),
+                                       at::device(kCPU).dtype(kQInt8),
+                                       scale, zero_point);
+      if (qc.numel() > 0) {
+        qnnpack_add(qa, qb, qc, qmin, qmax);
+      }
+      return qc;
+    }
+#endif // USE_QNNPACK
+    qc = at::_empty_affine_quantized(infer_size(qa.sizes(), qb.sizes()),
+                                     at::device(kCPU).dtype(kQInt8),
+                                     scale, zero_point);
+    const float a_multiplier = a_scale / scale;
+    const float b_multiplier = b_scale / scale;
+    auto iter = TensorIterator::binary_op(qc, qa, qb);
+    binary_kernel(*iter, [&](c10::qint8 a, c10::qint8 b) -> c10::qint8 {
+      const float sum = a_multiplier * (static_cast<int32_t>(a.val_) - a_zero_point) +
+          b_multiplier * (static_cast<int32_t>(b.val_) - b_zero_point);
+      int32_t q = static_cast<int32_t>(std::nearbyint(sum)) + zero_point;
+      return c10::qint8(static_cast<uint8_t>(std::min(std::max(q, qmin), qmax)));
+    });
+    return qc;
+  }
+};
+
+static auto registry = c10::RegisterOperators()
+.op("quantized::add(Tensor qa, Tensor qb, float scale, int zero_point)"
+     "-> Tensor qc",
+    c10::kernel<QAddInt8</*ReLUFused=*/false>>(),
+    c10::dispatchKey(QuantizedCPUTensorId()))
+.op("quantized::add_relu(Tensor qa, Tensor qb, float scale, int zero_point)"
+     "-> Tensor qc",
+    c10::kernel<QAddInt8</*ReLUFused=*/true>>(),
+    c10::dispatchKey(QuantizedCPUTensorId()));
+
+}  // namespace
+}}  // namespace at::native
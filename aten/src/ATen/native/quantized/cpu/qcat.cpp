@@ -0,0 +1,88 @@
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/WrapDimUtils.h>
+#include <ATen/core/Type.h>
+#include <ATen/core/op_registration/op_registration.h>
+#include <ATen/native/quantized/cpu/quantized_ops.h>
+
+#include <cstring>
+#include <vector>
+
+namespace at { namespace native {
+namespace {
+
+// Concatenates the quantized tensors along dim into a tensor with scale and
+// zero_point. Inputs with the same quantization parameters are copied, the
+// others are requantized from their quantized values.
+class QCatInt8 final : public c10::OperatorKernel {
+ public:
+  Tensor operator()(ArrayRef<Tensor> qxs, int64_t dim, double scale,
+                    int64_t zero_point) {
+    AT_CHECK(!qxs.empty(), "quantized::cat: expected a non-empty list of tensors");
+    AT_CHECK(zero_point >= 0 && zero_point <= 255,
+        "quantized::cat: zero_point must be in [0, 255], but got ", zero_point);
+    const Tensor& first = qxs[0];
+    dim = maybe_wrap_dim(dim, first.dim());
+    std::vector<int64_t> sizes = first.sizes().vec();
+    sizes[dim] = 0;
+    for (const Tensor& qx : qxs) {
+      check_quantized_input("quantized::cat", qx);
+      AT_CHECK(qx.dim() == first.dim(),
+          "quantized::cat: expected tensors of ", first.dim(), " dimensions");
+      for (int64_t d = 0; d < first.dim(); d++) {
+        AT_CHECK(d == dim || qx.size(d) == first.size(d),
+            "quantized::cat: sizes of tensors must match except in dimension ", dim);
+      }
+      sizes[dim] += qx.size(dim);
+    }
+
+    Tensor qy = at::_empty_affine_quantized(sizes, at::device(kCPU).dtype(kQInt8),
+                                            scale, zero_point);
+    if (qy.numel() == 0) {
+      return qy;
+    }
+    int64_t outer = 1;
+    for (int64_t d = 0; d < dim; d++) {
+      outer *= sizes[d];
+    }
+    const int64_t inner = qy.numel() / outer / sizes[dim];
+    const int64_t out_row = sizes[dim] * inner;
+    uint8_t* y_data = quantized_data(qy);
+    const float out_scale = scale;
+    parallel_for(0, outer, std::max<int64_t>(internal::GRAIN_SIZE / out_row, 1),
+        [&](int64_t begin, int64_t end) {
+      int64_t offset = 0;
+      for (const Tensor& qx : qxs) {
+        const int64_t in_row = qx.size(dim) * inner;
+        const uint8_t* x_data = quantized_data(qx);
+        const float x_scale = qx.q_scale().toFloat();
+        const int32_t x_zero_point = qx.q_zero_point().toLong();
+        const bool same_qparams = x_scale == out_scale && x_zero_point == zero_point;
+        const float multiplier = x_scale / out_scale;
+        for (int64_t o = begin; o < end; o++) {
+          const uint8_t* x = x_data + o * in_row;
+          uint8_t* y = y_data + o * out_row + offset;
+          if (same_qparams) {
+            std::memcpy(y, x, in_row);
+          } else {
+            for (int64_t i = 0; i < in_row; i++) {
+              y[i] = requantize_uint8(static_cast<int32_t>(x[i]) - x_zero_point,
+                                      multiplier, zero_point);
+            }
+          }
+        }
+        offset += in_row;
+      }
+    });
+    return qy;
+  }
+};
+
+static auto registry = c10::RegisterOperators().op(
+    "quantized::cat(Tensor[] qxs, int dim, float scale, int zero_point)"
+    " -> Tensor",
+    c10::kernel<QCatInt8>(),
+    c10::dispatchKey(QuantizedCPUTensorId()));
+
+}  // namespace
+}}  // namespace at::native
@@ -0,0 +1,338 @@
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/core/Type.h>
+#include <ATen/core/op_registration/op_registration.h>
+#include <ATen/cpp_custom_type_hack.h>
+#include <ATen/native/quantized/cpu/quantized_ops.h>
+
+#include <vector>
+
+namespace caffe2 {
+// Required for cpp_custom_type_hack to work
+CAFFE_KNOWN_TYPE(at::native::PackedConvWeight);
+} // namespace caffe2
+
+namespace at { namespace native {
+namespace {
+
+// Packs the quantized weight [OC, IC / groups, KH, KW] of quantized::conv2d.
+class QConv2dPackWeightInt8 final : public c10::OperatorKernel {
+ public:
+  Tensor operator()(Tensor qweight, int64_t groups) {
+    check_quantized_input("quantized::conv2d_prepack", qweight);
+    AT_CHECK(qweight.dim() == 4,
+        "quantized::conv2d_prepack: expected a 4-D weight, but got ",
+        qweight.dim(), " dimensions");
+    AT_CHECK(groups > 0 && qweight.size(0) % groups == 0,
+        "quantized::conv2d_prepack: expected the ", qweight.size(0),
+        " output channels to be divisible by groups, but got ", groups);
+    const int64_t OC = qweight.size(0);
+    const int64_t ICg = qweight.size(1);
+    const int64_t KH = qweight.size(2);
+    const int64_t KW = qweight.size(3);
+    const int64_t kernel_dim = KH * KW * ICg;
+
+    auto packed = guts::make_unique<PackedConvWeight>();
+    packed->groups = groups;
+    packed->w_scale = qweight.q_scale().toDouble();
+    packed->w_zero_point = qweight.q_zero_point().toLong();
+    packed->weight = at::empty({OC, KH, KW, ICg}, at::device(kCPU).dtype(kByte));
+    const uint8_t* src = quantized_data(qweight);
+    uint8_t* dst = packed->weight.data<uint8_t>();
+    for (int64_t oc = 0; oc < OC; oc++) {
+      for (int64_t c = 0; c < ICg; c++) {
+        for (int64_t k = 0; k < KH * KW; k++) {
+          dst[(oc * KH * KW + k) * ICg + c] = src[(oc * ICg + c) * KH * KW + k];
+        }
+      }
+    }
+#ifdef USE_FBGEMM
+    if (use_fbgemm()) {
+      // FBGEMM takes signed weights, which only shifts the zero point
+      std::vector<int8_t> w_int8(OC * kernel_dim);
+      for (int64_t i = 0; i < OC * kernel_dim; i++) {
+        w_int8[i] = static_cast<int8_t>(static_cast<int32_t>(dst[i]) - 128);
+      }
+      const int32_t w_zero_point_int8 = packed->w_zero_point - 128;
+      packed->col_offsets.resize(OC);
+      for (int64_t oc = 0; oc < OC; oc++) {
+        int32_t sum = 0;
+        for (int64_t k = 0; k < kernel_dim; k++) {
+          sum += w_int8[oc * kernel_dim + k];
+        }
+        packed->col_offsets[oc] = sum - w_zero_point_int8 * kernel_dim;
+      }
+      packed->w = guts::make_unique<fbgemm::PackBMatrix<int8_t>>(
+          /*trans=*/fbgemm::matrix_op_t::Transpose,
+          /*nRow=*/groups * kernel_dim,
+          /*nCol=*/OC / groups,
+          /*smat=*/w_int8.data(),
+          /*ld=*/kernel_dim,
+          /*pmat=*/nullptr, // PackBMatrix manages ownership of pmat
+          /*groups=*/groups);
+    }
+#endif // USE_FBGEMM
+    return cpp_custom_type_hack::create(std::move(packed), qweight.options());
+  }
+};
+
+struct ConvShape {
+  int64_t N, C, H, W, OC, OH, OW, KH, KW, groups;
+  int64_t stride_h, stride_w, pad_h, pad_w, dilation_h, dilation_w;
+};
+
+#ifdef USE_FBGEMM
+// FBGEMM convolves NHWC images with the im2col fused into the packing of the
+// input, so the NCHW input and output are transposed around it.
+template <bool ReLUFused>
+void fbgemm_conv2d(
+    const uint8_t* x_data, int32_t x_zero_point, PackedConvWeight& packed,
+    const int32_t* bias, float multiplier, int32_t y_zero_point,
+    const ConvShape& s, uint8_t* y_data) {
+  const int64_t HxW = s.H * s.W;
+  const int64_t OHxOW = s.OH * s.OW;
+  std::vector<uint8_t> x_nhwc(s.N * HxW * s.C);
+  std::vector<uint8_t> y_nhwc(s.N * OHxOW * s.OC);
+  std::vector<int32_t> buffer(s.N * OHxOW * s.OC);
+  nchw_to_nhwc(x_data, s.N, s.C, HxW, x_nhwc.data());
+
+  fbgemm::conv_param_t<> conv_p(
+      s.N, s.C, s.OC, {static_cast<int>(s.H), static_cast<int>(s.W)},
+      s.groups, {static_cast<int>(s.KH), static_cast<int>(s.KW)},
+      {static_cast<int>(s.stride_h), static_cast<int>(s.stride_w)},
+      {static_cast<int>(s.pad_h), static_cast<int>(s.pad_w),
+       static_cast<int>(s.pad_h), static_cast<int>(s.pad_w)});
+  const int32_t w_zero_point_int8 = packed.w_zero_point - 128;
+  // fbgemmPacked splits the rows between num_tasks calls
+  const int64_t num_tasks = get_num_threads();
+  parallel_for(0, num_tasks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t task = begin; task < end; task++) {
+      fbgemm::PackAWithIm2Col<uint8_t> packA(
+          /*conv_param=*/conv_p,
+          /*sdata=*/x_nhwc.data(),
+          /*pmat=*/nullptr, // packA manages ownership of pmat
+          // the zero point pads the image
+          /*zero_pt=*/x_zero_point,
+          /*row_offset=*/nullptr);
+      fbgemm::DoNothing<> doNothingObj{};
+      fbgemm::ReQuantizeOutput<ReLUFused> outputProcObj(
+          /*nextop=*/doNothingObj,
+          /*C_multiplier=*/&multiplier,
+          /*C_zero_point=*/y_zero_point,
+          /*Aq_zero_point=*/x_zero_point,
+          /*Bq_zero_point=*/&w_zero_point_int8,
+          /*row_offsets=*/packA.getRowOffsetBuffer(),
+          /*col_offsets=*/packed.col_offsets.data(),
+          /*bias=*/bias,
+          /*nCol=*/s.OC,
+          /*groups=*/s.groups);
+      fbgemm::fbgemmPacked(
+          /*packA=*/packA,
+          /*packB=*/*packed.w,
+          /*C=*/y_nhwc.data(),
+          /*C_buffer=*/buffer.data(),
+          /*ldc=*/s.OC,
+          /*outProcess=*/outputProcObj,
+          /*thread_id=*/task,
+          /*num_threads=*/num_tasks);
+    }
+  });
+
+  nhwc_to_nchw(y_nhwc.data(), s.N, s.OC, OHxOW, y_data);
+}
+#endif // USE_FBGEMM
+
+#ifdef USE_QNNPACK
+// QNNPACK convolves NHWC images like FBGEMM, with the kernel packed in the
+// operator cached by the weight.
+void qnnpack_conv2d(
+    const uint8_t* x_data, int32_t x_zero_point, float x_scale,
+    PackedConvWeight& packed, std::vector<int32_t> bias, float y_scale,
+    int32_t y_zero_point, uint8_t qmin, const ConvShape& s, uint8_t* y_data) {
+  init_qnnpack();
+  const int64_t HxW = s.H * s.W;
+  const int64_t OHxOW = s.OH * s.OW;
+  QnnpackParams params{x_zero_point, x_scale, y_zero_point, y_scale, qmin,
+                       std::move(bias)};
+  std::lock_guard<std::mutex> guard(packed.qnnpack.mutex);
+  if (!packed.qnnpack.op || !(packed.qnnpack.params == params)) {
+    qnnp_operator_t conv_op = nullptr;
+    qnnp_status status = qnnp_create_convolution2d_nhwc_q8(
+        s.pad_h, s.pad_w, s.pad_h, s.pad_w,
+        s.KH, s.KW,
+        s.stride_h, s.stride_w,
+        s.dilation_h, s.dilation_w,
+        s.groups, s.C / s.groups, s.OC / s.groups,
+        x_zero_point, x_scale,
+        packed.w_zero_point, packed.w_scale,
+        packed.weight.data<uint8_t>(), params.bias.data(),
+        y_zero_point, y_scale,
+        qmin, 255,
+        0 /* flags */,
+        &conv_op);
+    AT_CHECK(status == qnnp_status_success,
+        "failed to create QNNPACK convolution operator");
+    packed.qnnpack.op.reset(conv_op);
+    packed.qnnpack.params = std::move(params);
+  }
+  // QNNPACK may read up to 8 bytes before narrow pixels, like in Int8ConvOp
+  std::vector<uint8_t> x_nhwc(8 + s.N * HxW * s.C);
+  std::vector<uint8_t> y_nhwc(s.N * OHxOW * s.OC);
+  nchw_to_nhwc(x_data, s.N, s.C, HxW, x_nhwc.data() + 8);
+  qnnp_status status = qnnp_setup_convolution2d_nhwc_q8(
+      packed.qnnpack.op.get(),
+      s.N, s.H, s.W,
+      x_nhwc.data() + 8, s.C /* input pixel stride */,
+      y_nhwc.data(), s.OC /* output pixel stride */,
+      nullptr /* thread pool */);
+  AT_CHECK(status == qnnp_status_success,
+      "failed to setup QNNPACK convolution operator");
+  status = qnnp_run_operator(packed.qnnpack.op.get(), qnnpack_threadpool());
+  AT_CHECK(status == qnnp_status_success,
+      "failed to run QNNPACK convolution operator");
+  nhwc_to_nchw(y_nhwc.data(), s.N, s.OC, OHxOW, y_data);
+}
+#endif // USE_QNNPACK
+
+void reference_conv2d(
+    const uint8_t* x_data, int32_t x_zero_point, const PackedConvWeight& packed,
+    const int32_t* bias, float multiplier, int32_t y_zero_point, int32_t qmin,
+    const ConvShape& s, uint8_t* y_data) {
+  const uint8_t* w_data = packed.weight.data<uint8_t>();
+  const int32_t w_zero_point = packed.w_zero_point;
+  const int64_t ICg = s.C / s.groups;
+  const int64_t OCg = s.OC / s.groups;
+  const int64_t work = s.OH * s.OW * s.KH * s.KW * ICg;
+  parallel_for(0, s.N * s.OC, std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(work, 1), 1),
+      [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      const int64_t n = i / s.OC;
+      const int64_t oc = i % s.OC;
+      const int64_t g = oc / OCg;
+      const uint8_t* x = x_data + (n * s.C + g * ICg) * s.H * s.W;
+      const uint8_t* w = w_data + oc * s.KH * s.KW * ICg;
+      uint8_t* y = y_data + i * s.OH * s.OW;
+      for (int64_t oh = 0; oh < s.OH; oh++) {
+        for (int64_t ow = 0; ow < s.OW; ow++) {
+          int32_t acc = bias[oc];
+          for (int64_t kh = 0; kh < s.KH; kh++) {
+            const int64_t ih = oh * s.stride_h - s.pad_h + kh * s.dilation_h;
+            if (ih < 0 || ih >= s.H) {
+              continue;
+            }
+            for (int64_t kw = 0; kw < s.KW; kw++) {
+              const int64_t iw = ow * s.stride_w - s.pad_w + kw * s.dilation_w;
+              if (iw < 0 || iw >= s.W) {
+                continue;
+              }
+              const uint8_t* wk = w + (kh * s.KW + kw) * ICg;
+              for (int64_t c = 0; c < ICg; c++) {
+                acc += (static_cast<int32_t>(x[(c * s.H + ih) * s.W + iw]) - x_zero_point) *
+                    (static_cast<int32_t>(wk[c]) - w_zero_point);
+              }
+            }
+          }
+          y[oh * s.OW + ow] = requantize_uint8(acc, multiplier, y_zero_point, qmin);
+        }
+      }
+    }
+  });
+}
+
+// 2-D convolution of the quantized NCHW X with the prepacked weight,
+// requantized to Y_scale and Y_zero_point. The float bias is quantized to the
+// scale X_scale * W_scale of the int32 accumulators.
+template <bool ReLUFused>
+class QConv2dInt8 final : public c10::OperatorKernel {
+ public:
+  Tensor operator()(Tensor qx, Tensor packed_weight, c10::optional<Tensor> bias,
+                    ArrayRef<int64_t> stride, ArrayRef<int64_t> padding,
+                    ArrayRef<int64_t> dilation, double output_scale,
+                    int64_t output_zero_point) {
+    check_quantized_input("quantized::conv2d", qx);
+    AT_CHECK(qx.dim() == 4, "quantized::conv2d: expected a 4-D input, but got ",
+        qx.dim(), " dimensions");
+    AT_CHECK(stride.size() == 2 && padding.size() == 2 && dilation.size() == 2,
+        "quantized::conv2d: expected 2 strides, paddings and dilations");
+    AT_CHECK(output_zero_point >= 0 && output_zero_point <= 255,
+        "quantized::conv2d: output_zero_point must be in [0, 255], but got ",
+        output_zero_point);
+    auto& packed = cpp_custom_type_hack::cast<PackedConvWeight>(packed_weight);
+
+    ConvShape s;
+    s.N = qx.size(0);
+    s.C = qx.size(1);
+    s.H = qx.size(2);
+    s.W = qx.size(3);
+    s.OC = packed.weight.size(0);
+    s.KH = packed.weight.size(1);
+    s.KW = packed.weight.size(2);
+    s.groups = packed.groups;
+    s.stride_h = stride[0];
+    s.stride_w = stride[1];
+    s.pad_h = padding[0];
+    s.pad_w = padding[1];
+    s.dilation_h = dilation[0];
+    s.dilation_w = dilation[1];
+    AT_CHECK(s.C == packed.weight.size(3) * s.groups, "quantized::conv2d: expected ",
+        packed.weight.size(3) * s.groups, " input channels, but got ", s.C);
+    AT_CHECK(s.stride_h > 0 && s.stride_w > 0 && s.dilation_h > 0 &&
+        s.dilation_w > 0 && s.pad_h >= 0 && s.pad_w >= 0,
+        "quantized::conv2d: expected positive strides and dilations and "
+        "non-negative paddings");
+    s.OH = (s.H + 2 * s.pad_h - s.dilation_h * (s.KH - 1) - 1) / s.stride_h + 1;
+    s.OW = (s.W + 2 * s.pad_w - s.dilation_w * (s.KW - 1) - 1) / s.stride_w + 1;
+    AT_CHECK(s.OH > 0 && s.OW > 0,
+        "quantized::conv2d: the kernel is larger than the padded input");
+
+    const float x_scale = qx.q_scale().toFloat();
+    const int32_t x_zero_point = qx.q_zero_point().toLong();
+    const std::vector<int32_t> qbias = quantize_bias(bias, s.OC, x_scale * packed.w_scale);
+    const float multiplier = x_scale * packed.w_scale / output_scale;
+    const int32_t qmin = ReLUFused ? output_zero_point : 0;
+
+    Tensor qy = at::_empty_affine_quantized({s.N, s.OC, s.OH, s.OW},
+                                            at::device(kCPU).dtype(kQInt8),
+                                            output_scale, output_zero_point);
+    if (qy.numel() == 0) {
+      return qy;
+    }
+    const uint8_t* x_data = quantized_data(qx);
+    uint8_t* y_data = quantized_data(qy);
+#ifdef USE_FBGEMM
+    if (packed.w && s.dilation_h == 1 && s.dilation_w == 1) {
+      fbgemm_conv2d<ReLUFused>(x_data, x_zero_point, packed, qbias.data(),
+                               multiplier, output_zero_point, s, y_data);
+      return qy;
+    }
+#endif // USE_FBGEMM
+#ifdef USE_QNNPACK
+    if (multiplier < 1) {
+      qnnpack_conv2d(x_data, x_zero_point, x_scale, packed, qbias,
+                     output_scale, output_zero_point, qmin, s, y_data);
+      return qy;
+    }
+#endif // USE_QNNPACK
+    reference_conv2d(x_data, x_zero_point, packed, qbias.data(), multiplier,
+                     output_zero_point, qmin, s, y_data);
+    return qy;
+  }
+};
+
+static auto registry = c10::RegisterOperators()
+.op("quantized::conv2d_prepack(Tensor W, int groups) -> Tensor W_prepack",
+    c10::kernel<QConv2dPackWeightInt8>(),
+    c10::dispatchKey(QuantizedCPUTensorId()))
+.op("quantized::conv2d(Tensor X, Tensor W_prepack, Tensor? b, int[] stride,"
+     " int[] padding, int[] dilation, float Y_scale, int Y_zero_point)"
+     " -> Tensor Y",
+    c10::kernel<QConv2dInt8</*ReLUFused=*/false>>(),
+    c10::dispatchKey(QuantizedCPUTensorId()))
+.op("quantized::conv2d_relu(Tensor X, Tensor W_prepack, Tensor? b, int[] stride,"
+     " int[] padding, int[] dilation, float Y_scale, int Y_zero_point)"
+     " -> Tensor Y",
+    c10::kernel<QConv2dInt8</*ReLUFused=*/true>>(),
+    c10::dispatchKey(QuantizedCPUTensorId()));
+
+}  // namespace
+}}  // namespace at::native
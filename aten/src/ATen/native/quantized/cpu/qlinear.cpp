@@ -0,0 +1,245 @@
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/core/Type.h>
+#include <ATen/core/op_registration/op_registration.h>
+#include <ATen/cpp_custom_type_hack.h>
+#include <ATen/native/quantized/cpu/quantized_ops.h>
+
+#include <cstring>
+#include <vector>
+
+namespace caffe2 {
+// Required for cpp_custom_type_hack to work
+CAFFE_KNOWN_TYPE(at::native::PackedLinearWeight);
+} // namespace caffe2
+
+namespace at { namespace native {
+namespace {
+
+class QLinearPackWeightInt8 final : public c10::OperatorKernel {
+ public:
+  Tensor operator()(Tensor qweight) {
+    check_quantized_input("quantized::linear_prepack", qweight);
+    AT_CHECK(qweight.dim() == 2,
+        "quantized::linear_prepack: expected a 2-D weight, but got ",
+        qweight.dim(), " dimensions");
+    auto packed = guts::make_unique<PackedLinearWeight>();
+    packed->weight = qweight;
+    packed->w_scale = qweight.q_scale().toDouble();
+    packed->w_zero_point = qweight.q_zero_point().toLong();
+#ifdef USE_FBGEMM
+    if (use_fbgemm()) {
+      const int64_t N = qweight.size(0);
+      const int64_t K = qweight.size(1);
+      // FBGEMM takes signed weights, which only shifts the zero point
+      const uint8_t* w_data = quantized_data(qweight);
+      std::vector<int8_t> w_int8(N * K);
+      for (int64_t i = 0; i < N * K; i++) {
+        w_int8[i] = static_cast<int8_t>(static_cast<int32_t>(w_data[i]) - 128);
+      }
+      const int32_t w_zero_point_int8 = packed->w_zero_point - 128;
+      packed->col_offsets.resize(N);
+      for (int64_t j = 0; j < N; j++) {
+        int32_t sum = 0;
+        for (int64_t k = 0; k < K; k++) {
+          sum += w_int8[j * K + k];
+        }
+        packed->col_offsets[j] = sum - w_zero_point_int8 * K;
+      }
+      packed->w = guts::make_unique<fbgemm::PackBMatrix<int8_t>>(
+          /*trans=*/fbgemm::matrix_op_t::Transpose,
+          /*nRow=*/K,
+          /*nCol=*/N,
+          /*smat=*/w_int8.data(),
+          /*ld=*/K,
+          /*pmat=*/nullptr, // PackBMatrix manages ownership of pmat
+          /*groups=*/1);
+    }
+#endif // USE_FBGEMM
+    return cpp_custom_type_hack::create(std::move(packed), qweight.options());
+  }
+};
+
+#ifdef USE_FBGEMM
+template <bool ReLUFused>
+void fbgemm_linear(
+    const uint8_t* x_data, int32_t x_zero_point, PackedLinearWeight& packed,
+    const int32_t* bias, float multiplier, int32_t y_zero_point, int64_t M,
+    int64_t N, int64_t K, uint8_t* y_data) {
+  const int32_t w_zero_point_int8 = packed.w_zero_point - 128;
+  std::vector<int32_t> buffer(M * N);
+  // fbgemmPacked splits the rows between num_tasks calls
+  const int64_t num_tasks = std::min<int64_t>(get_num_threads(), M);
+  parallel_for(0, num_tasks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t task = begin; task < end; task++) {
+      fbgemm::PackAWithRowOffset<uint8_t> packA(
+          /*trans=*/fbgemm::matrix_op_t::NoTranspose,
+          /*nRow=*/M,
+          /*nCol=*/K,
+          /*smat=*/x_data,
+          /*ld=*/K,
+          /*pmat=*/nullptr, // packA manages ownership of pmat
+          /*groups=*/1,
+          /*row_offset=*/nullptr);
+      fbgemm::DoNothing<> doNothingObj{};
+      fbgemm::ReQuantizeOutput<ReLUFused> outputProcObj(
+          /*nextop=*/doNothingObj,
+          /*C_multiplier=*/&multiplier,
+          /*C_zero_point=*/y_zero_point,
+          /*Aq_zero_point=*/x_zero_point,
+          /*Bq_zero_point=*/&w_zero_point_int8,
+          /*row_offsets=*/packA.getRowOffsetBuffer(),
+          /*col_offsets=*/packed.col_offsets.data(),
+          /*bias=*/bias,
+          /*nCol=*/N);
+      fbgemm::fbgemmPacked(
+          /*packA=*/packA,
+          /*packB=*/*packed.w,
+          /*C=*/y_data,
+          /*C_buffer=*/buffer.data(),
+          /*ldc=*/N,
+          /*outProcess=*/outputProcObj,
+          /*thread_id=*/task,
+          /*num_threads=*/num_tasks);
+    }
+  });
+}
+#endif // USE_FBGEMM
+
+#ifdef USE_QNNPACK
+void qnnpack_linear(
+    const uint8_t* x_data, int32_t x_zero_point, float x_scale,
+    PackedLinearWeight& packed, std::vector<int32_t> bias, float y_scale,
+    int32_t y_zero_point, uint8_t qmin, int64_t M, int64_t N, int64_t K,
+    uint8_t* y_data) {
+  init_qnnpack();
+  QnnpackParams params{x_zero_point, x_scale, y_zero_point, y_scale, qmin,
+                       std::move(bias)};
+  std::lock_guard<std::mutex> guard(packed.qnnpack.mutex);
+  if (!packed.qnnpack.op || !(packed.qnnpack.params == params)) {
+    qnnp_operator_t fc_op = nullptr;
+    qnnp_status status = qnnp_create_fully_connected_nc_q8(
+        K, N,
+        x_zero_point, x_scale,
+        packed.w_zero_point, packed.w_scale,
+        quantized_data(packed.weight), params.bias.data(),
+        y_zero_point, y_scale,
+        qmin, 255,
+        0 /* flags */,
+        &fc_op);
+    AT_CHECK(status == qnnp_status_success,
+        "failed to create QNNPACK fully connected operator");
+    packed.qnnpack.op.reset(fc_op);
+    packed.qnnpack.params = std::move(params);
+  }
+  // QNNPACK may read up to 8 bytes before narrow rows, like in Int8FCOp
+  std::vector<uint8_t> padded;
+  if (K < 8) {
+    padded.resize(M * K + 8);
+    std::memcpy(padded.data() + 8, x_data, M * K);
+    x_data = padded.data() + 8;
+  }
+  qnnp_status status = qnnp_setup_fully_connected_nc_q8(
+      packed.qnnpack.op.get(), M, x_data, K /* input stride */, y_data,
+      N /* output stride */);
+  AT_CHECK(status == qnnp_status_success,
+      "failed to setup QNNPACK fully connected operator");
+  status = qnnp_run_operator(packed.qnnpack.op.get(), qnnpack_threadpool());
+  AT_CHECK(status == qnnp_status_success,
+      "failed to run QNNPACK fully connected operator");
+}
+#endif // USE_QNNPACK
+
+void reference_linear(
+    const uint8_t* x_data, int32_t x_zero_point, const PackedLinearWeight& packed,
+    const int32_t* bias, float multiplier, int32_t y_zero_point, int32_t qmin,
+    int64_t M, int64_t N, int64_t K, uint8_t* y_data) {
+  const uint8_t* w_data = quantized_data(packed.weight);
+  const int32_t w_zero_point = packed.w_zero_point;
+  parallel_for(0, M, std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(N * K, 1), 1),
+      [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      const uint8_t* x = x_data + i * K;
+      for (int64_t j = 0; j < N; j++) {
+        const uint8_t* w = w_data + j * K;
+        int32_t acc = bias[j];
+        for (int64_t k = 0; k < K; k++) {
+          acc += (static_cast<int32_t>(x[k]) - x_zero_point) *
+              (static_cast<int32_t>(w[k]) - w_zero_point);
+        }
+        y_data[i * N + j] = requantize_uint8(acc, multiplier, y_zero_point, qmin);
+      }
+    }
+  });
+}
+
+// Y = X W^T + b of the quantized X [..., K] and the prepacked quantized
+// W [N, K], requantized to Y_scale and Y_zero_point. The float bias is
+// quantized to the scale X_scale * W_scale of the int32 accumulators.
+template <bool ReLUFused>
+class QLinearInt8 final : public c10::OperatorKernel {
+ public:
+  Tensor operator()(Tensor qx, Tensor packed_weight, c10::optional<Tensor> bias,
+                    double output_scale, int64_t output_zero_point) {
+    check_quantized_input("quantized::linear", qx);
+    AT_CHECK(qx.dim() >= 1, "quantized::linear: expected a non-scalar input");
+    auto& packed = cpp_custom_type_hack::cast<PackedLinearWeight>(packed_weight);
+    const int64_t N = packed.weight.size(0);
+    const int64_t K = packed.weight.size(1);
+    AT_CHECK(qx.size(-1) == K, "quantized::linear: expected ", K,
+        " input features, but got ", qx.size(-1));
+    AT_CHECK(output_zero_point >= 0 && output_zero_point <= 255,
+        "quantized::linear: output_zero_point must be in [0, 255], but got ",
+        output_zero_point);
+    const int64_t M = qx.numel() / K;
+    const float x_scale = qx.q_scale().toFloat();
+    const int32_t x_zero_point = qx.q_zero_point().toLong();
+    const std::vector<int32_t> qbias = quantize_bias(bias, N, x_scale * packed.w_scale);
+    const float multiplier = x_scale * packed.w_scale / output_scale;
+    const int32_t qmin = ReLUFused ? output_zero_point : 0;
+
+    std::vector<int64_t> out_sizes = qx.sizes().vec();
+    out_sizes.back() = N;
+    Tensor qy = at::_empty_affine_quantized(out_sizes,
+                                            at::device(kCPU).dtype(kQInt8),
+                                            output_scale, output_zero_point);
+    if (qy.numel() == 0) {
+      return qy;
+    }
+    const uint8_t* x_data = quantized_data(qx);
+    uint8_t* y_data = quantized_data(qy);
+#ifdef USE_FBGEMM
+    if (packed.w) {
+      fbgemm_linear<ReLUFused>(x_data, x_zero_point, packed, qbias.data(),
+                               multiplier, output_zero_point, M, N, K, y_data);
+      return qy;
+    }
+#endif // USE_FBGEMM
+#ifdef USE_QNNPACK
+    if (multiplier < 1) {
+      qnnpack_linear(x_data, x_zero_point, x_scale, packed, qbias,
+                     output_scale, output_zero_point, qmin, M, N, K, y_data);
+      return qy;
+    }
+#endif // USE_QNNPACK
+    reference_linear(x_data, x_zero_point, packed, qbias.data(), multiplier,
+                     output_zero_point, qmin, M, N, K, y_data);
+    return qy;
+  }
+};
+
+static auto registry = c10::RegisterOperators()
+.op("quantized::linear_prepack(Tensor W) -> Tensor W_prepack",
+    c10::kernel<QLinearPackWeightInt8>(),
+    c10::dispatchKey(QuantizedCPUTensorId()))
+.op("quantized::linear(Tensor X, Tensor W_prepack, Tensor? b, float Y_scale,"
+     " int Y_zero_point) -> Tensor Y",
+    c10::kernel<QLinearInt8</*ReLUFused=*/false>>(),
+    c10::dispatchKey(QuantizedCPUTensorId()))
+.op("quantized::linear_relu(Tensor X, Tensor W_prepack, Tensor? b,"
+     " float Y_scale, int Y_zero_point) -> Tensor Y",
+    c10::kernel<QLinearInt8</*ReLUFused=*/true>>(),
+    c10::dispatchKey(QuantizedCPUTensorId()));
+
+}  // namespace
+}}  // namespace at::native
@@ -0,0 +1,240 @@
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/core/Type.h>
+#include <ATen/core/op_registration/op_registration.h>
+#include <ATen/native/quantized/cpu/quantized_ops.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace at { namespace native {
+namespace {
+
+#ifdef USE_QNNPACK
+// Runs the QNNPACK pooling operator pool_op on the NCHW qx, transposed to NHWC
+// and back into qy.
+void qnnpack_pool2d(
+    qnnp_operator_t pool_op, const Tensor& qx, Tensor& qy,
+    qnnp_status (*setup)(qnnp_operator_t, size_t, size_t, size_t,
+                         const uint8_t*, size_t, uint8_t*, size_t,
+                         pthreadpool_t),
+    const char* name) {
+  std::unique_ptr<qnnp_operator, QnnpackOperatorDeleter> guard(pool_op);
+  const int64_t N = qx.size(0);
+  const int64_t C = qx.size(1);
+  const int64_t H = qx.size(2);
+  const int64_t W = qx.size(3);
+  const int64_t OHxOW = qy.size(2) * qy.size(3);
+  std::vector<uint8_t> x_nhwc(N * H * W * C);
+  std::vector<uint8_t> y_nhwc(N * OHxOW * C);
+  nchw_to_nhwc(quantized_data(qx), N, C, H * W, x_nhwc.data());
+  qnnp_status status = setup(
+      pool_op, N, H, W,
+      x_nhwc.data(), C /* input pixel stride */,
+      y_nhwc.data(), C /* output pixel stride */,
+      nullptr /* thread pool */);
+  AT_CHECK(status == qnnp_status_success, "failed to setup QNNPACK ", name,
+      " operator");
+  status = qnnp_run_operator(pool_op, qnnpack_threadpool());
+  AT_CHECK(status == qnnp_status_success, "failed to run QNNPACK ", name,
+      " operator");
+  nhwc_to_nchw(y_nhwc.data(), N, C, OHxOW, quantized_data(qy));
+}
+#endif // USE_QNNPACK
+
+// Max pooling of the quantized NCHW X. The quantization is monotonic, so the
+// maximum of the quantized values is the quantized maximum and the output
+// keeps the scale and the zero point of the input.
+class QMaxPool2dInt8 final : public c10::OperatorKernel {
+ public:
+  Tensor operator()(Tensor qx, ArrayRef<int64_t> kernel_size,
+                    ArrayRef<int64_t> stride, ArrayRef<int64_t> padding,
+                    ArrayRef<int64_t> dilation) {
+    check_quantized_input("quantized::max_pool2d", qx);
+    AT_CHECK(qx.dim() == 4,
+        "quantized::max_pool2d: expected a 4-D input, but got ", qx.dim(),
+        " dimensions");
+    AT_CHECK(kernel_size.size() == 2 && stride.size() == 2 &&
+        padding.size() == 2 && dilation.size() == 2,
+        "quantized::max_pool2d: expected 2 kernel sizes, strides, paddings and "
+        "dilations");
+    const int64_t N = qx.size(0);
+    const int64_t C = qx.size(1);
+    const int64_t H = qx.size(2);
+    const int64_t W = qx.size(3);
+    const int64_t KH = kernel_size[0];
+    const int64_t KW = kernel_size[1];
+    AT_CHECK(KH > 0 && KW > 0 && stride[0] > 0 && stride[1] > 0 &&
+        dilation[0] > 0 && dilation[1] > 0,
+        "quantized::max_pool2d: expected positive kernel sizes, strides and "
+        "dilations");
+    AT_CHECK(padding[0] >= 0 && padding[1] >= 0 &&
+        padding[0] <= KH / 2 && padding[1] <= KW / 2,
+        "quantized::max_pool2d: padding should be at most half of the kernel size");
+    const int64_t OH = (H + 2 * padding[0] - dilation[0] * (KH - 1) - 1) / stride[0] + 1;
+    const int64_t OW = (W + 2 * padding[1] - dilation[1] * (KW - 1) - 1) / stride[1] + 1;
+    AT_CHECK(OH > 0 && OW > 0,
+        "quantized::max_pool2d: the kernel is larger than the padded input");
+
+    Tensor qy = at::_empty_affine_quantized({N, C, OH, OW},
+                                            at::device(kCPU).dtype(kQInt8),
+                                            qx.q_scale().toDouble(),
+                                            qx.q_zero_point().toLong());
+    if (qy.numel() == 0) {
+      return qy;
+    }
+#ifdef USE_QNNPACK
+    // QNNPACK has no 1x1 pooling
+    if (KH * KW > 1) {
+      init_qnnpack();
+      qnnp_operator_t pool_op = nullptr;
+      qnnp_status status = qnnp_create_max_pooling2d_nhwc_u8(
+          padding[0], padding[1], padding[0], padding[1],
+          KH, KW,
+          stride[0], stride[1],
+          dilation[0], dilation[1],
+          C,
+          0 /* output min */, 255 /* output max */,
+          0 /* flags */,
+          &pool_op);
+      AT_CHECK(status == qnnp_status_success,
+          "failed to create QNNPACK max pooling operator");
+      qnnpack_pool2d(pool_op, qx, qy, qnnp_setup_max_pooling2d_nhwc_u8,
+                     "max pooling");
+      return qy;
+    }
+#endif // USE_QNNPACK
+    const uint8_t* x_data = quantized_data(qx);
+    uint8_t* y_data = quantized_data(qy);
+    parallel_for(0, N * C, std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(OH * OW * KH * KW, 1), 1),
+        [&](int64_t begin, int64_t end) {
+      for (int64_t plane = begin; plane < end; plane++) {
+        const uint8_t* x = x_data + plane * H * W;
+        uint8_t* y = y_data + plane * OH * OW;
+        for (int64_t oh = 0; oh < OH; oh++) {
+          for (int64_t ow = 0; ow < OW; ow++) {
+            uint8_t maximum = 0;
+            for (int64_t kh = 0; kh < KH; kh++) {
+              const int64_t ih = oh * stride[0] - padding[0] + kh * dilation[0];
+              if (ih < 0 || ih >= H) {
+                continue;
+              }
+              for (int64_t kw = 0; kw < KW; kw++) {
+                const int64_t iw = ow * stride[1] - padding[1] + kw * dilation[1];
+                if (iw >= 0 && iw < W) {
+                  maximum = std::max(maximum, x[ih * W + iw]);
+                }
+              }
+            }
+            y[oh * OW + ow] = maximum;
+          }
+        }
+      }
+    });
+    return qy;
+  }
+};
+
+// Average pooling of the quantized NCHW X, averaging over the whole kernel
+// with the padding counted as zeros (count_include_pad). The averages of the
+// quantized values keep the scale and the zero point of the input.
+class QAvgPool2dInt8 final : public c10::OperatorKernel {
+ public:
+  Tensor operator()(Tensor qx, ArrayRef<int64_t> kernel_size,
+                    ArrayRef<int64_t> stride, ArrayRef<int64_t> padding) {
+    check_quantized_input("quantized::avg_pool2d", qx);
+    AT_CHECK(qx.dim() == 4,
+        "quantized::avg_pool2d: expected a 4-D input, but got ", qx.dim(),
+        " dimensions");
+    AT_CHECK(kernel_size.size() == 2 && stride.size() == 2 &&
+        padding.size() == 2,
+        "quantized::avg_pool2d: expected 2 kernel sizes, strides and paddings");
+    const int64_t N = qx.size(0);
+    const int64_t C = qx.size(1);
+    const int64_t H = qx.size(2);
+    const int64_t W = qx.size(3);
+    const int64_t KH = kernel_size[0];
+    const int64_t KW = kernel_size[1];
+    AT_CHECK(KH > 0 && KW > 0 && stride[0] > 0 && stride[1] > 0,
+        "quantized::avg_pool2d: expected positive kernel sizes and strides");
+    AT_CHECK(padding[0] >= 0 && padding[1] >= 0 &&
+        padding[0] <= KH / 2 && padding[1] <= KW / 2,
+        "quantized::avg_pool2d: padding should be at most half of the kernel size");
+    const int64_t OH = (H + 2 * padding[0] - KH) / stride[0] + 1;
+    const int64_t OW = (W + 2 * padding[1] - KW) / stride[1] + 1;
+    AT_CHECK(OH > 0 && OW > 0,
+        "quantized::avg_pool2d: the kernel is larger than the padded input");
+
+    const float scale = qx.q_scale().toFloat();
+    const int32_t zero_point = qx.q_zero_point().toLong();
+    Tensor qy = at::_empty_affine_quantized({N, C, OH, OW},
+                                            at::device(kCPU).dtype(kQInt8),
+                                            scale, zero_point);
+    if (qy.numel() == 0) {
+      return qy;
+    }
+#ifdef USE_QNNPACK
+    if (KH * KW > 1) {
+      init_qnnpack();
+      qnnp_operator_t pool_op = nullptr;
+      qnnp_status status = qnnp_create_average_pooling2d_nhwc_q8(
+          padding[0], padding[1], padding[0], padding[1],
+          KH, KW,
+          stride[0], stride[1],
+          C,
+          zero_point, scale,
+          zero_point, scale,
+          0 /* output min */, 255 /* output max */,
+          0 /* flags */,
+          &pool_op);
+      AT_CHECK(status == qnnp_status_success,
+          "failed to create QNNPACK average pooling operator");
+      qnnpack_pool2d(pool_op, qx, qy, qnnp_setup_average_pooling2d_nhwc_q8,
+                     "average pooling");
+      return qy;
+    }
+#endif // USE_QNNPACK
+    const uint8_t* x_data = quantized_data(qx);
+    uint8_t* y_data = quantized_data(qy);
+    const float multiplier = 1.0f / (KH * KW);
+    parallel_for(0, N * C, std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(OH * OW * KH * KW, 1), 1),
+        [&](int64_t begin, int64_t end) {
+      for (int64_t plane = begin; plane < end; plane++) {
+        const uint8_t* x = x_data + plane * H * W;
+        uint8_t* y = y_data + plane * OH * OW;
+        for (int64_t oh = 0; oh < OH; oh++) {
+          for (int64_t ow = 0; ow < OW; ow++) {
+            int32_t acc = 0;
+            for (int64_t kh = 0; kh < KH; kh++) {
+              const int64_t ih = oh * stride[0] - padding[0] + kh;
+              if (ih < 0 || ih >= H) {
+                continue;
+              }
+              for (int64_t kw = 0; kw < KW; kw++) {
+                const int64_t iw = ow * stride[1] - padding[1] + kw;
+                if (iw >= 0 && iw < W) {
+                  acc += static_cast<int32_t>(x[ih * W + iw]) - zero_point;
+                }
+              }
+            }
+            y[oh * OW + ow] = requantize_uint8(acc, multiplier, zero_point);
+          }
+        }
+      }
+    });
+    return qy;
+  }
+};
+
+static auto registry = c10::RegisterOperators()
+.op("quantized::max_pool2d(Tensor qx, int[] kernel_size, int[] stride,"
+     " int[] padding, int[] dilation) -> Tensor",
+    c10::kernel<QMaxPool2dInt8>(),
+    c10::dispatchKey(QuantizedCPUTensorId()))
+.op("quantized::avg_pool2d(Tensor qx, int[] kernel_size, int[] stride,"
+     " int[] padding) -> Tensor",
+    c10::kernel<QAvgPool2dInt8>(),
+    c10::dispatchKey(QuantizedCPUTensorId()));
+
+}  // namespace
+}}  // namespace at::native
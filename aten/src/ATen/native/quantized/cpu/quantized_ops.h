@@ -0,0 +1,191 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/quantized/Quantizer.h>
+
+#ifdef USE_FBGEMM
+#include "fbgemm/Fbgemm.h"
+#endif // USE_FBGEMM
+
+#ifdef USE_QNNPACK
+#include <qnnpack.h>
+#ifndef FBCODE_CAFFE2
+#include "caffe2/utils/threadpool/ThreadPool.h"
+#endif // FBCODE_CAFFE2
+#endif // USE_QNNPACK
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace at { namespace native {
+
+#ifdef USE_QNNPACK
+struct QnnpackOperatorDeleter {
+  void operator()(qnnp_operator_t op) const {
+    qnnp_delete_operator(op);
+  }
+};
+
+// What the QNNPACK operator of a prepacked weight was created for.
+struct QnnpackParams {
+  int32_t x_zero_point;
+  float x_scale;
+  int32_t y_zero_point;
+  float y_scale;
+  int32_t qmin;
+  std::vector<int32_t> bias;
+
+  bool operator==(const QnnpackParams& other) const {
+    return x_zero_point == other.x_zero_point && x_scale == other.x_scale &&
+        y_zero_point == other.y_zero_point && y_scale == other.y_scale &&
+        qmin == other.qmin && bias == other.bias;
+  }
+};
+
+// QNNPACK packs the weight when its operator is created, along with the bias
+// and the requantization of the outputs, which depend on the activations. So
+// the operator is created on the first call and kept until the parameters
+// change, like in Caffe2's Int8ConvOp. Operators remember the pointers they
+// are set up with, so the calls sharing a weight take turns.
+struct QnnpackOperator {
+  std::mutex mutex;
+  QnnpackParams params;
+  std::unique_ptr<qnnp_operator, QnnpackOperatorDeleter> op;
+};
+#endif // USE_QNNPACK
+
+// Weights of quantized::linear and quantized::conv2d, packed once by
+// quantized::linear_prepack and quantized::conv2d_prepack and passed around
+// as byte tensors with cpp_custom_type_hack. The quantized weight itself is
+// kept for the QNNPACK and reference kernels; with FBGEMM the weight is also
+// packed as signed 8-bit values, along with the column offsets it needs.
+// Without FBGEMM, as on ARM, the QNNPACK operator packs it on the first call.
+struct PackedLinearWeight {
+  Tensor weight; // [N, K]
+  double w_scale;
+  int64_t w_zero_point;
+#ifdef USE_FBGEMM
+  std::unique_ptr<fbgemm::PackBMatrix<int8_t>> w;
+  std::vector<int32_t> col_offsets;
+#endif // USE_FBGEMM
+#ifdef USE_QNNPACK
+  QnnpackOperator qnnpack;
+#endif // USE_QNNPACK
+};
+
+struct PackedConvWeight {
+  Tensor weight; // the uint8 values as [OC, KH, KW, IC / groups]
+  int64_t groups;
+  double w_scale;
+  int64_t w_zero_point;
+#ifdef USE_FBGEMM
+  std::unique_ptr<fbgemm::PackBMatrix<int8_t>> w;
+  std::vector<int32_t> col_offsets;
+#endif // USE_FBGEMM
+#ifdef USE_QNNPACK
+  QnnpackOperator qnnpack;
+#endif // USE_QNNPACK
+};
+
+inline const uint8_t* quantized_data(const Tensor& qx) {
+  return reinterpret_cast<const uint8_t*>(qx.data<c10::qint8>());
+}
+
+inline uint8_t* quantized_data(Tensor& qx) {
+  return reinterpret_cast<uint8_t*>(qx.data<c10::qint8>());
+}
+
+inline void check_quantized_input(const char* op, const Tensor& qx) {
+  AT_CHECK(qx.is_quantized(), op, ": expected a quantized tensor");
+  AT_CHECK(qx.is_contiguous(), op, ": expected a contiguous quantized tensor");
+}
+
+// The NHWC kernels of FBGEMM and QNNPACK run on transposed copies of the NCHW
+// QTensors.
+inline void nchw_to_nhwc(
+    const uint8_t* x, int64_t N, int64_t C, int64_t HxW, uint8_t* y) {
+  parallel_for(0, N * HxW, std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(C, 1), 1),
+      [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      const int64_t n = i / HxW;
+      const int64_t hw = i % HxW;
+      for (int64_t c = 0; c < C; c++) {
+        y[i * C + c] = x[(n * C + c) * HxW + hw];
+      }
+    }
+  });
+}
+
+inline void nhwc_to_nchw(
+    const uint8_t* x, int64_t N, int64_t C, int64_t HxW, uint8_t* y) {
+  parallel_for(0, N * C, std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(HxW, 1), 1),
+      [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      const int64_t n = i / C;
+      const int64_t c = i % C;
+      for (int64_t hw = 0; hw < HxW; hw++) {
+        y[i * HxW + hw] = x[(n * HxW + hw) * C + c];
+      }
+    }
+  });
+}
+
+// Rounds the int32 accumulator, in units of multiplier * output scale, to the
+// output. Like fbgemm::ReQuantizeOutput, so that all the kernels agree.
+inline uint8_t requantize_uint8(
+    int32_t acc, float multiplier, int32_t zero_point, int32_t qmin = 0,
+    int32_t qmax = 255) {
+  int32_t q = static_cast<int32_t>(std::nearbyint(acc * multiplier)) + zero_point;
+  return static_cast<uint8_t>(std::min(std::max(q, qmin), qmax));
+}
+
+// The float bias quantized to the scale of the accumulators, or zeros.
+inline std::vector<int32_t> quantize_bias(
+    const c10::optional<Tensor>& bias, int64_t n, double scale) {
+  std::vector<int32_t> qbias(n, 0);
+  if (bias.has_value() && bias->defined()) {
+    AT_CHECK(bias->dim() == 1 && bias->size(0) == n,
+        "expected a bias of ", n, " elements, but got ", bias->sizes());
+    Tensor b = bias->to(kFloat).contiguous();
+    const float* b_data = b.data<float>();
+    for (int64_t i = 0; i < n; i++) {
+      qbias[i] = static_cast<int32_t>(std::nearbyint(b_data[i] / scale));
+    }
+  }
+  return qbias;
+}
+
+inline bool use_fbgemm() {
+#ifdef USE_FBGEMM
+  return fbgemm::fbgemmSupportedCPU();
+#else
+  return false;
+#endif // USE_FBGEMM
+}
+
+#ifdef USE_QNNPACK
+inline void init_qnnpack() {
+  static std::once_flag once;
+  static qnnp_status status = qnnp_status_uninitialized;
+  std::call_once(once, []() { status = qnnp_initialize(); });
+  AT_CHECK(status == qnnp_status_success, "failed to initialize QNNPACK");
+}
+
+// QNNPACK is built to run on Caffe2's thread pool (QNNPACK_CUSTOM_THREADPOOL),
+// which mobile builds size to their cores, like the Caffe2 Int8 operators.
+inline pthreadpool_t qnnpack_threadpool() {
+#ifdef FBCODE_CAFFE2
+  return nullptr;
+#else
+  static std::unique_ptr<caffe2::ThreadPool> pool =
+      caffe2::ThreadPool::defaultThreadPool();
+  return reinterpret_cast<pthreadpool_t>(pool.get());
+#endif // FBCODE_CAFFE2
+}
+#endif // USE_QNNPACK
+
+}} // namespace at::native
@@ -6,9 +6,15 @@
 #include <ATen/NativeFunctions.h>
 #include <ATen/InitialTensorOptions.h>
 #include <ATen/SparseTensorUtils.h>
+#include <ATen/Parallel.h>
+#include <ATen/native/sparse/SparseTensorMath.h>
+#include <c10/util/flat_hash_map.h>
 
 #include <TH/THBlasUtils.h>
 
+#include <algorithm>
+#include <vector>
+
 namespace at { namespace native {
 
 using namespace at::sparse;
@@ -107,8 +113,11 @@ SparseTensor new_with_dims_and_tensor_sparse(
 /** Public creation API that dispatch to methods above **/
 
 /** Empty init **/
-Tensor empty_sparse(IntArrayRef size, const TensorOptions& options) {
+Tensor empty_sparse(IntArrayRef size, const TensorOptions& options, c10::optional<MemoryFormat> optional_memory_format) {
   AT_CHECK(!options.pinned_memory(), "Only dense CPU tensors can be pinned");
+  AT_CHECK(
+      !optional_memory_format.has_value(),
+      "memory format argument is not supported for sparse tensors");
   return new_with_dims_sparse(size.size(), 0, size, options);
 }
 
@@ -335,6 +344,73 @@ SparseTensor& copy_sparse_(SparseTensor& self, const SparseTensor& src, bool non
   return self._coalesced_(src.is_coalesced());
 }
 
+std::tuple<LongTensor, LongTensor> group_nonzeros_cpu(const LongTensor& flat_indices) {
+  LongTensor keys = flat_indices.contiguous();
+  const int64_t* keys_data = keys.data<int64_t>();
+  int64_t nnz = keys.numel();
+
+  // Every chunk counts its indices in its own map
+  int64_t num_chunks = nnz < internal::GRAIN_SIZE ? 1
+      : std::min<int64_t>(get_num_threads(), divup(nnz, internal::GRAIN_SIZE));
+  int64_t chunk_size = std::max<int64_t>(divup(nnz, num_chunks), 1);
+  std::vector<ska::flat_hash_map<int64_t, int64_t>> partial_counts(num_chunks);
+  parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      auto& map = partial_counts[c];
+      int64_t last = std::min(nnz, (c + 1) * chunk_size);
+      for (int64_t i = c * chunk_size; i < last; i++) {
+        map[keys_data[i]]++;
+      }
+    }
+  });
+  ska::flat_hash_map<int64_t, int64_t> group_start(partial_counts[0]);
+  for (int64_t c = 1; c < num_chunks; c++) {
+    for (const auto& it : partial_counts[c]) {
+      group_start[it.first] += it.second;
+    }
+  }
+
+  std::vector<int64_t> unique_keys;
+  unique_keys.reserve(group_start.size());
+  for (const auto& it : group_start) {
+    unique_keys.push_back(it.first);
+  }
+  std::sort(unique_keys.begin(), unique_keys.end());
+
+  int64_t num_groups = unique_keys.size();
+  LongTensor offsets = at::empty({num_groups + 1}, keys.options());
+  int64_t* offsets_data = offsets.data<int64_t>();
+  offsets_data[0] = 0;
+  for (int64_t g = 0; g < num_groups; g++) {
+    auto& start = group_start[unique_keys[g]];
+    offsets_data[g + 1] = offsets_data[g] + start;
+    start = offsets_data[g];
+  }
+  // The counts of every chunk become the position its first nonzero of each
+  // index is written to, so that the chunks can be scattered in parallel.
+  for (int64_t c = 0; c < num_chunks; c++) {
+    for (auto& it : partial_counts[c]) {
+      auto& start = group_start[it.first];
+      int64_t count = it.second;
+      it.second = start;
+      start += count;
+    }
+  }
+
+  LongTensor order = at::empty({nnz}, keys.options());
+  int64_t* order_data = order.data<int64_t>();
+  parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      auto& map = partial_counts[c];
+      int64_t last = std::min(nnz, (c + 1) * chunk_size);
+      for (int64_t i = c * chunk_size; i < last; i++) {
+        order_data[map[keys_data[i]]++] = i;
+      }
+    }
+  });
+  return std::make_tuple(offsets, order);
+}
+
 SparseTensor coalesce_sparse_cpu(const SparseTensor& self) {
   AT_ASSERT(self.defined());
   AT_ASSERT(!self.is_variable());  // TODO: change this to check `.requires_grad()` and `GradMode::is_enabled()` when Variable and Tensor are merged
@@ -355,55 +431,49 @@ SparseTensor coalesce_sparse_cpu(const SparseTensor& self) {
   Tensor values = self._values().contiguous();
   int64_t sparse_dim = self.sparse_dim();
   int64_t dense_dim = self.dense_dim();
-  int64_t nnz = self._nnz();
 
   LongTensor indices_scalar = flatten_indices(indices, self.sizes());
+  LongTensor offsets;
+  LongTensor order;
+  std::tie(offsets, order) = group_nonzeros_cpu(indices_scalar);
+  int64_t new_nnz = offsets.numel() - 1;
 
   SparseTensor dst = new_sparse(self.options());
   get_sparse_impl(dst)->resize_(sparse_dim, dense_dim, self.sizes());
-  // TODO: is there a more idiomatic way to do this?
-  LongTensor newIndices = at::empty(indices.sizes(), indices.options());
-  Tensor newValues = at::empty(values.sizes(), values.options());
+  LongTensor newIndices = at::empty({sparse_dim, new_nnz}, indices.options());
+  Tensor newValues = new_values_with_size_of(values, new_nnz);
   alias_into_sparse(dst, newIndices, newValues);
 
-  LongTensor indicesBuffer;
-  LongTensor indicesPermutation;
-  std::tie(indicesBuffer, indicesPermutation) = indices_scalar.sort(0);
   // NB: The accessor accesses here rely on self._nnz() > 0 (tested earlier in this function)
   auto newIndicesAccessor = newIndices.accessor<int64_t, 2>();
   auto indicesAccessor = indices.accessor<int64_t, 2>();
-  auto indicesPermutationAccessor = indicesPermutation.accessor<int64_t, 1>();
-  auto indicesBufferAccessor = indicesBuffer.accessor<int64_t, 1>();
+  const int64_t* offsets_data = offsets.data<int64_t>();
+  const int64_t* order_data = order.data<int64_t>();
 
-  int64_t i = -1;
   AT_DISPATCH_ALL_TYPES(
       values.scalar_type(), "coalesce", [&] {
-        int64_t prev = -1;
         int64_t blockSize = values.stride(0);
         scalar_t* values_ptr = values.data<scalar_t>();
         scalar_t* newValues_ptr = newValues.data<scalar_t>();
-        for (int64_t j = 0; j < nnz; j++) {
-          int64_t pos = indicesPermutationAccessor[j];
-          int64_t curr = indicesBufferAccessor[j];
-          if (curr == prev) {
-            if (values.numel() > 0) {  // if values is an empty tensor, there are no elements to copy
-              THBlas_axpy<scalar_t>(blockSize, 1, values_ptr + pos * blockSize, 1, newValues_ptr + i * blockSize, 1);
-            }
-          } else {
-            ++i;
+        int64_t grain_size = std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(blockSize, 1), 1);
+        parallel_for(0, new_nnz, grain_size, [&](int64_t begin, int64_t end) {
+          for (int64_t i = begin; i < end; i++) {
+            int64_t first = order_data[offsets_data[i]];
             for (int64_t d = 0; d < sparse_dim; d++) {
-              newIndicesAccessor[d][i] = indicesAccessor[d][pos];
+              newIndicesAccessor[d][i] = indicesAccessor[d][first];
             }
             if (values.numel() > 0) {  // if values is an empty tensor, there are no elements to copy
-              THBlas_copy<scalar_t>(blockSize, values_ptr + pos * blockSize, 1, newValues_ptr + i * blockSize, 1);
+              THBlas_copy<scalar_t>(blockSize, values_ptr + first * blockSize, 1, newValues_ptr + i * blockSize, 1);
+              for (int64_t j = offsets_data[i] + 1; j < offsets_data[i + 1]; j++) {
+                THBlas_axpy<scalar_t>(blockSize, 1, values_ptr + order_data[j] * blockSize, 1, newValues_ptr + i * blockSize, 1);
+              }
             }
           }
-          prev = curr;
-        }
+        });
     });
 
   dst._coalesced_(true);
-  get_sparse_impl(dst)->set_nnz_and_narrow(i + 1);
+  get_sparse_impl(dst)->set_nnz_and_narrow(new_nnz);
 
   return dst;
 }
@@ -1,4 +1,7 @@
+#include <ATen/native/sparse/SparseTensorMath.h>
+
 #include <ATen/ATen.h>
+#include <ATen/Parallel.h>
 #include <ATen/SparseTensorImpl.h>
 #include <ATen/ExpandUtils.h>
 #include <ATen/NativeFunctions.h>
@@ -36,8 +39,52 @@ namespace {
     return csr;
   }
 
+  // CSR row pointers of a matrix with dim rows from the row indices of its
+  // nonzeros. When rows is not sorted, order is the stable permutation of the
+  // nonzeros that sorts it; otherwise order is left undefined.
+  std::tuple<LongTensor, LongTensor> _to_csr_with_order(const LongTensor& rows_, int64_t dim, bool sorted) {
+    LongTensor rows = rows_.contiguous();
+    const int64_t* rows_data = rows.data<int64_t>();
+    int64_t nnz = rows.numel();
+    auto check_row = [&](int64_t row) {
+      AT_CHECK(row >= 0 && row < dim,
+          "addmm: index out of row bound: ", row, " not between 1 and ", dim);
+    };
+
+    if (!sorted) {
+      sorted = std::is_sorted(rows_data, rows_data + nnz);
+    }
+    if (sorted) {
+      if (nnz > 0) {
+        check_row(rows_data[0]);
+        check_row(rows_data[nnz - 1]);
+      }
+      return std::make_tuple(_to_csr(rows_data, dim, nnz), LongTensor());
+    }
+
+    // counting sort of the nonzeros by row
+    LongTensor csr = native::zeros({dim + 1}, kLong);
+    LongTensor order = native::empty({nnz}, kLong);
+    int64_t* csr_data = csr.data<int64_t>();
+    int64_t* order_data = order.data<int64_t>();
+    for (int64_t i = 0; i < nnz; i++) {
+      check_row(rows_data[i]);
+      csr_data[rows_data[i] + 1]++;
+    }
+    for (int64_t h = 0; h < dim; h++) {
+      csr_data[h + 1] += csr_data[h];
+    }
+    std::vector<int64_t> next(csr_data, csr_data + dim);
+    for (int64_t i = 0; i < nnz; i++) {
+      order_data[next[rows_data[i]]++] = i;
+    }
+    return std::make_tuple(csr, order);
+  }
+
 }
 
+DEFINE_DISPATCH(spmm_stub);
+
 // --------------------------------------------------------------------
 // zero_(SparseTensor)
 // --------------------------------------------------------------------
@@ -327,6 +374,46 @@ void add_dense_sparse_worker_cpu(Tensor& r, Scalar value, const SparseTensor& sp
   }
 }
 
+// r += value * sparse for a contiguous r and a hybrid sparse, like the
+// sparse gradients of embeddings in SGD. The nonzeros are grouped by index
+// instead of coalescing sparse, and the slices of r they update are added to
+// in parallel.
+static void add_dense_sparse_rows_cpu(Tensor& r, Scalar value, const SparseTensor& sparse) {
+  LongTensor flat_indices = flatten_indices(sparse._indices(), sparse.sizes()).contiguous();
+  Tensor values = sparse._values().contiguous();
+  LongTensor offsets;
+  LongTensor order;
+  std::tie(offsets, order) = group_nonzeros_cpu(flat_indices);
+  int64_t num_groups = offsets.numel() - 1;
+  if (values.numel() == 0) {
+    return;
+  }
+
+  const int64_t* flat_indices_data = flat_indices.data<int64_t>();
+  const int64_t* offsets_data = offsets.data<int64_t>();
+  const int64_t* order_data = order.data<int64_t>();
+  int64_t block_size = values.stride(0);
+  int64_t num_blocks = r.numel() / block_size;
+
+  AT_DISPATCH_ALL_TYPES(values.scalar_type(), "add_dense_sparse", [&] {
+    const scalar_t* values_ptr = values.data<scalar_t>();
+    scalar_t* r_ptr = r.data<scalar_t>();
+    scalar_t cast_value = value.to<scalar_t>();
+    int64_t grain_size = std::max<int64_t>(internal::GRAIN_SIZE / block_size, 1);
+    parallel_for(0, num_groups, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t g = begin; g < end; g++) {
+        int64_t index = flat_indices_data[order_data[offsets_data[g]]];
+        AT_CHECK(index >= 0 && index < num_blocks,
+            "add: index ", index, " is out of bounds for a tensor with ", num_blocks, " slices");
+        for (int64_t j = offsets_data[g]; j < offsets_data[g + 1]; j++) {
+          THBlas_axpy<scalar_t>(block_size, cast_value,
+              values_ptr + order_data[j] * block_size, 1, r_ptr + index * block_size, 1);
+        }
+      }
+    });
+  });
+}
+
 Tensor& add_out_dense_sparse_cpu(Tensor& r, const Tensor& dense, SparseTensorRef sparse__, Scalar value) {
   const SparseTensor& sparse_ = sparse__.tref;
 
@@ -342,12 +429,19 @@ Tensor& add_out_dense_sparse_cpu(Tensor& r, const Tensor& dense, SparseTensorRef
     dense.sizes(), " while other has size ", sparse_.sizes(), " (FYI: dense-sparse addition does not currently support broadcasting)");
 
   r.resize_as_(dense);
+  int64_t nDim = dense.dim();
+  int64_t nDimI = sparse_.sparse_dim();
+
+  if (nDim > nDimI && r.is_contiguous() && sparse_._nnz() > 0) {
+    if (!is_same_tensor(r, dense)) r.copy_(dense);
+    add_dense_sparse_rows_cpu(r, value, sparse_);
+    return r;
+  }
+
   SparseTensor sparse = sparse_.coalesce();
 
   LongTensor indices = sparse._indices();
   Tensor values = sparse._values();
-  int64_t nDim = dense.dim();
-  int64_t nDimI = sparse.sparse_dim();
 
   if (!is_same_tensor(r, dense)) r.copy_(dense);
   if (sparse._nnz() == 0) return r;
@@ -479,52 +573,29 @@ SparseTensor& mul_out_sparse_cpu(SparseTensor& r, const Tensor& t_, const Tensor
 // D = beta * D1 + alpha * mm(S, D2)
 // --------------------------------------------------------------------
 
-// NB: OMP pragmas have to get their own functions; can't put them in lambdas
-template <typename scalar_t>
-void s_addmm_out_sparse_dense_worker(int64_t nnz, int64_t dim_i, int64_t dim_j, int64_t dim_k, Tensor& r, Scalar beta, const Tensor& t, Scalar alpha, const Tensor& indices, const Tensor& values, const Tensor& dense) {
-  int64_t i;
-
+// The nonzeros are grouped by row into CSR form so that spmm_stub can hand
+// whole rows of r to each thread.
+static void s_addmm_out_sparse_dense_worker(int64_t dim_i, Tensor& r, Scalar beta, const Tensor& t, Scalar alpha, const SparseTensor& sparse, const Tensor& dense) {
   // r_ = alpha * sparse * dense
-  scalar_t cast_alpha = alpha.to<scalar_t>();
-  scalar_t cast_beta = beta.to<scalar_t>();
-  if (cast_beta == 0) {
-    r.zero_();
-  } else if (cast_beta == 1) {
-    if (!is_same_tensor(r, t)) {
-      r.copy_(t);
-    }
-  } else {
-    at::mul_out(r, t, scalar_to_tensor(beta));
-  }
-
-  auto indices_accessor = indices.accessor<int64_t, 2>();
-
-  auto values_accessor = values.accessor<scalar_t, 1>();
-  scalar_t* dense_ptr = dense.data<scalar_t>();
-  scalar_t* r_ptr = r.data<scalar_t>();
-
-  int64_t dense_stride0 = dense.stride(0);
-  int64_t dense_stride1 = dense.stride(1);
-  int64_t r_stride0 = r.stride(0);
-  int64_t r_stride1 = r.stride(1);
-  for (i = 0; i < nnz; i++) {
-    scalar_t val = values_accessor[i];
-    int64_t row = indices_accessor[0][i];
-    int64_t col = indices_accessor[1][i];
-    if (col >= 0 && col < dim_j && row >= 0 && row < dim_i) {
-      THBlas_axpy<scalar_t>(dim_k,
-            cast_alpha * val,
-            dense_ptr + col * dense_stride0, dense_stride1,
-            r_ptr + row * r_stride0, r_stride1);
-    } else {
-      if (col < 0 || col >= dim_j) {
-        AT_ERROR("addmm: index out of column bound: ", col, " not between 1 and ", dim_j);
-      } else {
-        AT_ERROR("addmm: index out of row bound: ", row, " not between 1 and ", dim_i);
+  AT_DISPATCH_ALL_TYPES(r.scalar_type(), "addmm_sparse_dense", [&] {
+    scalar_t cast_beta = beta.to<scalar_t>();
+    if (cast_beta == 0) {
+      r.zero_();
+    } else if (cast_beta == 1) {
+      if (!is_same_tensor(r, t)) {
+        r.copy_(t);
       }
+    } else {
+      at::mul_out(r, t, scalar_to_tensor(beta));
     }
-  }
-};
+  });
+
+  LongTensor indices = sparse._indices();
+  Tensor values = sparse._values().contiguous();
+  LongTensor rowptr, order;
+  std::tie(rowptr, order) = _to_csr_with_order(indices.select(0, 0), dim_i, sparse.is_coalesced());
+  spmm_stub(kCPU, r, rowptr, order, indices.select(0, 1), values, dense, alpha);
+}
 
 Tensor& s_addmm_out_sparse_dense_cpu(
     Tensor& r,
@@ -565,14 +636,7 @@ Tensor& s_addmm_out_sparse_dense_cpu(
     return r;
   }
 
-  LongTensor indices = sparse_._indices();
-  Tensor values      = sparse_._values();
-
-  AT_DISPATCH_ALL_TYPES(
-      values.scalar_type(), "addmm_sparse_dense", [&] {
-        s_addmm_out_sparse_dense_worker<scalar_t>(nnz, dim_i, dim_j, dim_k, r, beta, t, alpha, indices, values, dense);
-      }
-  );
+  s_addmm_out_sparse_dense_worker(dim_i, r, beta, t, alpha, sparse_, dense);
 
   return r;
 
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+namespace at { namespace native {
+
+// r += alpha * S * dense for the dim_i x dim_j sparse matrix S given in CSR
+// form: the nonzeros of row h are cols[order[e]] and values[order[e]] for e
+// in [rowptr[h], rowptr[h + 1]). order may be undefined when the nonzeros are
+// already sorted by row, and values is contiguous.
+using spmm_fn = void(*)(
+    Tensor& r, const Tensor& rowptr, const Tensor& order, const Tensor& cols,
+    const Tensor& values, const Tensor& dense, Scalar alpha);
+
+DECLARE_DISPATCH(spmm_fn, spmm_stub);
+
+// Groups the nonzeros of a CPU sparse tensor by their flattened indices
+// without sorting all of them: group g is made of the nonzeros
+// order[offsets[g]], ..., order[offsets[g + 1] - 1], in their original order,
+// and the groups are in increasing order of their index. Only the distinct
+// indices are sorted, which is much cheaper when there are many duplicates,
+// like in the gradients of embeddings.
+std::tuple<LongTensor, LongTensor> group_nonzeros_cpu(const LongTensor& flat_indices);
+
+}} // namespace at::native
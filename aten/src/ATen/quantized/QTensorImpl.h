@@ -28,12 +28,10 @@ struct CAFFE2_API QTensorImpl : public c10::TensorImpl {
   c10::intrusive_ptr<TensorImpl> shallow_copy_and_detach() const override {
     auto impl = c10::make_intrusive<QTensorImpl>(
         Storage(storage()), type_id(), quantizer_);
-    impl->set_sizes_and_strides(sizes(), strides());
+    impl->set_sizes_and_strides_like(*this);
     impl->storage_offset_ = storage_offset_;
     impl->is_wrapped_number_ = is_wrapped_number_;
     impl->reserved_ = reserved_;
-    impl->refresh_numel();
-    impl->refresh_contiguous();
     return impl;
   }
 
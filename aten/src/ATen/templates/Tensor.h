@@ -165,8 +165,20 @@ class CAFFE2_API Tensor {
   int64_t ndimension() const {
     return dim();
   }
-  bool is_contiguous() const {
-    return impl_->is_contiguous();
+  bool is_contiguous(at::MemoryFormat memory_format=at::MemoryFormat::Contiguous) const {
+    return impl_->is_contiguous(memory_format);
+  }
+
+  // The memory format an operator should give a result computed from this
+  // tensor, so that channels last activations stay channels last. Tensors that
+  // are both contiguous and channels last (e.g. with one channel) suggest
+  // Contiguous.
+  at::MemoryFormat suggest_memory_format() const {
+    if (layout() == at::kStrided && !impl_->is_contiguous() &&
+        impl_->is_contiguous(at::MemoryFormat::ChannelsLast)) {
+      return at::MemoryFormat::ChannelsLast;
+    }
+    return at::MemoryFormat::Contiguous;
   }
 
   // Total bytes consumed by the "view" of elements of the array.  Does not
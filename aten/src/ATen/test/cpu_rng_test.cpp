@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/core/PhiloxRNGEngine.h>
+
+using namespace at;
+
+TEST(CPURNGTest, PhiloxKnownAnswers) {
+  // The known answer tests of Random123 for Philox4x32-10
+  ASSERT_EQ(
+      Philox4x32::apply({{0, 0, 0, 0}}, {{0, 0}}),
+      (Philox4x32::Output{{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}}));
+  ASSERT_EQ(
+      Philox4x32::apply(
+          {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}},
+          {{0xffffffff, 0xffffffff}}),
+      (Philox4x32::Output{{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}}));
+  ASSERT_EQ(
+      Philox4x32::apply(
+          {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}},
+          {{0xa4093822, 0x299f31d0}}),
+      (Philox4x32::Output{{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}}));
+}
+
+TEST(CPURNGTest, PhiloxOffset) {
+  Philox4x32 stream(42);
+  stream();
+  stream();
+  ASSERT_EQ(stream(), Philox4x32(42, 2)());
+}
+
+// Random fills give the same values for any number of threads.
+TEST(CPURNGTest, ThreadCountIndependent) {
+  auto fill = [](int num_threads) {
+    set_num_threads(num_threads);
+    manual_seed(123);
+    std::vector<Tensor> results;
+    results.push_back(at::empty({10007}).uniform_(-2, 3));
+    results.push_back(at::empty({10007}, kDouble).uniform_());
+    results.push_back(at::empty({10007}).normal_(1, 2));
+    results.push_back(at::empty({10007}, kLong).bernoulli_(
+        at::empty({10007}, kDouble).fill_(0.3)));
+    // non-contiguous
+    results.push_back(at::empty({100, 101}).t().normal_());
+    return results;
+  };
+  auto serial = fill(1);
+  auto parallel = fill(4);
+  for (size_t i = 0; i < serial.size(); i++) {
+    ASSERT_TRUE(serial[i].equal(parallel[i]));
+  }
+  ASSERT_GE(serial[0].min().item<float>(), -2);
+  ASSERT_LT(serial[0].max().item<float>(), 3);
+  ASSERT_NEAR(serial[2].mean().item<float>(), 1, 0.1);
+  ASSERT_NEAR(serial[2].std().item<float>(), 2, 0.1);
+}
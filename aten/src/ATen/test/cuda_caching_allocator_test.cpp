@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <ATen/cuda/CUDAContext.h>
+#include <c10/cuda/CUDACachingAllocator.h>
+#include <c10/cuda/CUDAGuard.h>
+
+namespace CUDACachingAllocator = c10::cuda::CUDACachingAllocator;
+
+TEST(CUDACachingAllocatorTest, PrivatePoolDoesNotShareBlocks) {
+  if (!at::cuda::is_available()) return;
+  int device = c10::cuda::current_device();
+
+  void* shared_ptr = CUDACachingAllocator::raw_alloc(1000);
+  CUDACachingAllocator::raw_delete(shared_ptr);
+
+  auto pool = CUDACachingAllocator::createPrivatePool();
+  {
+    CUDACachingAllocator::MempoolGuard guard(pool);
+    void* private_ptr = CUDACachingAllocator::raw_alloc(1000);
+    // the block cached by the default pool must not be handed out
+    ASSERT_NE(private_ptr, shared_ptr);
+
+    auto stats = CUDACachingAllocator::getPoolStats(device, pool);
+    ASSERT_GT(stats.amount_allocated, 0);
+    ASSERT_GE(stats.amount_cached, stats.amount_allocated);
+
+    CUDACachingAllocator::raw_delete(private_ptr);
+    // ...but the pool reuses its own cached blocks
+    void* reused_ptr = CUDACachingAllocator::raw_alloc(1000);
+    ASSERT_EQ(reused_ptr, private_ptr);
+    CUDACachingAllocator::raw_delete(reused_ptr);
+  }
+  ASSERT_EQ(CUDACachingAllocator::getPoolStats(device, pool).amount_allocated, 0);
+
+  CUDACachingAllocator::releasePrivatePool(pool);
+  ASSERT_ANY_THROW(CUDACachingAllocator::getPoolStats(device, pool));
+}
+
+TEST(CUDACachingAllocatorTest, StreamPool) {
+  if (!at::cuda::is_available()) return;
+  int device = c10::cuda::current_device();
+
+  auto pool = CUDACachingAllocator::createPrivatePool();
+  auto stream = at::cuda::getStreamFromPool();
+  CUDACachingAllocator::setStreamPool(stream, pool);
+  {
+    c10::cuda::CUDAStreamGuard guard(stream);
+    void* ptr = CUDACachingAllocator::raw_alloc(5000);
+    ASSERT_GT(CUDACachingAllocator::getPoolStats(device, pool).amount_allocated, 0);
+
+    // releasing a pool with live blocks defers the cudaFree until they die
+    CUDACachingAllocator::releasePrivatePool(pool);
+    CUDACachingAllocator::raw_delete(ptr);
+  }
+  ASSERT_ANY_THROW(CUDACachingAllocator::getPoolStats(device, pool));
+}
+
+TEST(CUDACachingAllocatorTest, AllocatorSettings) {
+  if (!at::cuda::is_available()) return;
+  constexpr size_t kMB = 1048576;
+  int device = c10::cuda::current_device();
+
+  CUDACachingAllocator::emptyCache();
+  CUDACachingAllocator::setAllocatorSettings("roundup_power2_divisions:4");
+  CUDACachingAllocator::raw_delete(CUDACachingAllocator::raw_alloc(1200 * kMB));
+  ASSERT_EQ(CUDACachingAllocator::cacheInfo(device).cached_and_free, 1280 * kMB);
+
+  // oversize blocks are not split for smaller requests
+  CUDACachingAllocator::emptyCache();
+  CUDACachingAllocator::setAllocatorSettings("max_split_size_mb:64");
+  CUDACachingAllocator::raw_delete(CUDACachingAllocator::raw_alloc(100 * kMB));
+  void* small = CUDACachingAllocator::raw_alloc(10 * kMB);
+  auto info = CUDACachingAllocator::cacheInfo(device);
+  ASSERT_EQ(info.num_oversize_blocks, 1);
+  ASSERT_EQ(info.num_segments, 2);
+  CUDACachingAllocator::raw_delete(small);
+
+  ASSERT_THROW(
+      CUDACachingAllocator::setAllocatorSettings("roundup_power2_divisions:3"),
+      c10::Error);
+  CUDACachingAllocator::setAllocatorSettings("");
+  CUDACachingAllocator::emptyCache();
+}
+
+static uint64_t next_context = 0;
+static uint64_t record_context() {
+  return ++next_context;
+}
+
+TEST(CUDACachingAllocatorTest, SnapshotAndTrace) {
+  if (!at::cuda::is_available()) return;
+  CUDACachingAllocator::emptyCache();
+  CUDACachingAllocator::recordHistory(true, 16, record_context);
+
+  void* ptr = CUDACachingAllocator::raw_alloc(1000);
+  bool found = false;
+  for (const auto& segment : CUDACachingAllocator::snapshot()) {
+    size_t offset = 0;
+    for (const auto& block : segment.blocks) {
+      if (segment.address + offset == reinterpret_cast<uintptr_t>(ptr)) {
+        ASSERT_TRUE(block.allocated);
+        ASSERT_EQ(block.context, next_context);
+        found = true;
+      }
+      offset += block.size;
+    }
+    ASSERT_EQ(offset, segment.total_size);
+  }
+  ASSERT_TRUE(found);
+  CUDACachingAllocator::raw_delete(ptr);
+
+  auto trace = CUDACachingAllocator::getTrace();
+  ASSERT_GE(trace.size(), 2);
+  ASSERT_EQ(trace.back().action, CUDACachingAllocator::TraceEntry::FREE);
+  ASSERT_EQ(trace.back().addr, reinterpret_cast<uintptr_t>(ptr));
+
+  CUDACachingAllocator::recordHistory(false, 0, nullptr);
+  ASSERT_TRUE(CUDACachingAllocator::getTrace().empty());
+}
+
+TEST(CUDACachingAllocatorTest, ManagedOversubscription) {
+  if (!at::cuda::is_available()) return;
+  int device = c10::cuda::current_device();
+  int concurrent_managed_access = 0;
+  C10_CUDA_CHECK(cudaDeviceGetAttribute(
+      &concurrent_managed_access, cudaDevAttrConcurrentManagedAccess, device));
+  if (!concurrent_managed_access) return;
+
+  size_t device_free;
+  size_t device_total;
+  C10_CUDA_CHECK(cudaMemGetInfo(&device_free, &device_total));
+
+  CUDACachingAllocator::emptyCache();
+  ASSERT_THROW(
+      CUDACachingAllocator::raw_alloc(device_total + device_total / 8),
+      c10::Error);
+
+  CUDACachingAllocator::setAllocatorSettings("managed_oversubscription:True");
+  void* ptr = CUDACachingAllocator::raw_alloc(device_total + device_total / 8);
+  ASSERT_GT(CUDACachingAllocator::currentMemoryManaged(device), device_total);
+  bool found = false;
+  for (const auto& segment : CUDACachingAllocator::snapshot()) {
+    if (segment.address == reinterpret_cast<uintptr_t>(ptr)) {
+      ASSERT_TRUE(segment.is_managed);
+      found = true;
+    }
+  }
+  ASSERT_TRUE(found);
+  // allocations that fit still come from device memory
+  void* small = CUDACachingAllocator::raw_alloc(1000);
+  CUDACachingAllocator::raw_delete(small);
+  CUDACachingAllocator::raw_delete(ptr);
+
+  CUDACachingAllocator::emptyCache();
+  ASSERT_EQ(CUDACachingAllocator::currentMemoryManaged(device), 0);
+  CUDACachingAllocator::setAllocatorSettings("");
+}
@@ -1,7 +1,9 @@
 #include <gtest/gtest.h>
 
+#include <ATen/ATen.h>
 #include <ATen/cuda/CUDAContext.h>
 #include <c10/cuda/CUDAGuard.h>
+#include <c10/cuda/CUDAStreamScheduler.h>
 #include <ATen/cuda/CUDAMultiStreamGuard.h>
 #include <ATen/cuda/CUDAEvent.h>
 
@@ -193,6 +195,49 @@ TEST(TestStream, StreamPoolTest) {
   ASSERT_TRUE(hasDuplicates);
 }
 
+// Dedicated streams are never returned by the pool
+TEST(TestStream, DedicatedStreamTest) {
+  if (!at::cuda::is_available()) return;
+  int least_priority, greatest_priority;
+  std::tie(least_priority, greatest_priority) =
+      at::cuda::CUDAStream::priority_range();
+
+  const auto stream = at::cuda::getDedicatedStream(greatest_priority);
+  ASSERT_EQ(stream.priority(), greatest_priority);
+  ASSERT_EQ(at::cuda::getDedicatedStream(greatest_priority - 1).priority(),
+            greatest_priority);
+  ASSERT_EQ_CUDA(at::cuda::CUDAStream::unpack(stream.pack()), stream);
+
+  for (int i = 0; i < 200; ++i) {
+    ASSERT_NE(at::cuda::getStreamFromPool(i % 2 == 0).stream(), stream.stream());
+  }
+
+  at::cuda::setCurrentCUDAStream(stream);
+  ASSERT_EQ_CUDA(at::cuda::getCurrentCUDAStream(), stream);
+  at::cuda::setCurrentCUDAStream(at::cuda::getDefaultCUDAStream());
+}
+
+TEST(TestStream, StreamSchedulerTest) {
+  if (!at::cuda::is_available()) return;
+  c10::cuda::CUDAStreamScheduler scheduler(0, /*streamsPerClass=*/2);
+  using c10::cuda::QoSClass;
+
+  const auto critical = scheduler.getStream(QoSClass::LatencyCritical);
+  ASSERT_NE_CUDA(scheduler.getStream(QoSClass::LatencyCritical), critical);
+  ASSERT_EQ_CUDA(scheduler.getStream(QoSClass::LatencyCritical), critical);
+  ASSERT_EQ(critical.priority(), scheduler.getPriority(QoSClass::LatencyCritical));
+  ASSERT_LE(critical.priority(), scheduler.getStream(QoSClass::Background).priority());
+  ASSERT_NE(scheduler.getPool(QoSClass::LatencyCritical),
+            scheduler.getPool(QoSClass::Background));
+
+  // allocations on the streams of a class come from the pool of the class
+  at::cuda::CUDAStreamGuard guard(critical);
+  const auto pool = scheduler.getPool(QoSClass::LatencyCritical);
+  auto tensor = at::empty({1024}, at::kCUDA);
+  ASSERT_GE(c10::cuda::CUDACachingAllocator::getPoolStats(0, pool).amount_allocated,
+            1024 * sizeof(float));
+}
+
 // Multi-GPU
 TEST(TestStream, MultiGPUTest) {
   if (!at::cuda::is_available()) return;
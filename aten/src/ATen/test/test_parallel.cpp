@@ -4,6 +4,7 @@
 #include <ATen/DLConvertor.h>
 #include <ATen/Parallel.h>
 
+#include <atomic>
 #include <iostream>
 #include <string.h>
 #include <sstream>
@@ -51,3 +52,59 @@ TEST(TestParallel, Exceptions) {
     }),
     std::runtime_error);
 }
+
+TEST(TestParallel, CoversRangeOnce) {
+  const int64_t numel = 100000;
+  std::vector<std::atomic<int>> hits(numel);
+  for (auto& hit : hits) {
+    hit = 0;
+  }
+  std::atomic<bool> thread_num_in_range(true);
+  at::parallel_for(0, numel, 1000, [&](int64_t begin, int64_t end) {
+    if (at::get_thread_num() >= (int)at::get_num_threads()) {
+      thread_num_in_range = false;
+    }
+    for (int64_t i = begin; i < end; i++) {
+      hits[i]++;
+    }
+  });
+  ASSERT_TRUE(thread_num_in_range);
+  for (auto& hit : hits) {
+    ASSERT_EQ(hit, 1);
+  }
+}
+
+TEST(TestParallel, ParallelReduce) {
+  const int64_t numel = 1 << 20;
+  auto sum = at::parallel_reduce(
+      0, numel, 1000, (int64_t)0,
+      [](int64_t begin, int64_t end, int64_t ident) {
+        int64_t partial = ident;
+        for (int64_t i = begin; i < end; i++) {
+          partial += i;
+        }
+        return partial;
+      },
+      [](int64_t a, int64_t b) { return a + b; });
+  ASSERT_EQ(sum, numel * (numel - 1) / 2);
+}
+
+TEST(TestParallel, GrainSizes) {
+  // cheaper loops get larger chunks
+  ASSERT_GE(at::grain_size(LoopCost::Cheap), at::grain_size(LoopCost::Default));
+  ASSERT_GE(at::grain_size(LoopCost::Default), at::grain_size(LoopCost::Expensive));
+  ASSERT_GE(
+      at::grain_size(LoopCost::Expensive),
+      at::grain_size(LoopCost::VeryExpensive));
+
+  const auto grain_size = at::grain_size(LoopCost::Cheap);
+  at::set_grain_size(LoopCost::Cheap, 16);
+  ASSERT_EQ(at::grain_size(LoopCost::Cheap), 16);
+  // results don't depend on the grain size
+  Tensor a = rand({1000});
+  Tensor b = rand({1000});
+  auto expected = a.mul(b);
+  at::set_grain_size(LoopCost::Cheap, grain_size);
+  ASSERT_TRUE(expected.equal(a.mul(b)));
+  ASSERT_THROW(at::set_grain_size(LoopCost::Cheap, 0), c10::Error);
+}
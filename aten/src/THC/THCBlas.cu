@@ -4,6 +4,12 @@
 #include <ATen/cuda/CUDAContext.h>
 
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 float THCudaBlas_Sdot(THCState *state, int64_t n, float *x, int64_t incx, float *y, int64_t incy)
 {
@@ -268,6 +274,177 @@ void THCudaBlas_Sgemm(THCState *state, char transa, char transb, int64_t m, int6
 #  define CUDA_R_16F CUBLAS_DATA_HALF
 #endif
 
+#if !defined(__HIP_PLATFORM_HCC__) && CUDA_VERSION >= 9000
+namespace {
+
+// Half GEMMs run on tensor cores, but which cuBLAS algorithm is fastest
+// depends on the shape, and cuBLAS only uses tensor cores for some of them
+// unless m, n, k and the leading dimensions are all multiples of 8.
+//
+// With PYTORCH_CUBLAS_HGEMM_AUTOTUNE=1, the tensor op algorithms are timed
+// the first time a shape is seen on a device and the fastest one is cached.
+// With PYTORCH_CUBLAS_HGEMM_PAD=1, the operands of non-batched GEMMs are
+// zero-padded to multiples of 8 if that adds at most a quarter to the work.
+bool hgemm_env_flag(const char* name) {
+  const char* value = std::getenv(name);
+  return value != nullptr && value[0] != '\0' && std::strcmp(value, "0") != 0;
+}
+
+bool hgemm_autotune_enabled() {
+  static bool enabled = hgemm_env_flag("PYTORCH_CUBLAS_HGEMM_AUTOTUNE");
+  return enabled;
+}
+
+bool hgemm_pad_enabled() {
+  static bool enabled = hgemm_env_flag("PYTORCH_CUBLAS_HGEMM_PAD");
+  return enabled;
+}
+
+// device, opa, opb, m, n, k, lda, ldb, ldc, batchCount
+using HgemmKey = std::tuple<int, int, int, int, int, int, int, int, int, int64_t>;
+
+// Returns the algorithm to run a GEMM of the given shape with. The first
+// time a shape is seen, run(algo, c) is timed with every tensor op
+// algorithm on a scratch output of c_size bytes.
+template <typename run_t>
+cublasGemmAlgo_t hgemm_algorithm(THCState *state, const HgemmKey& key, size_t c_size, const run_t& run)
+{
+  if (!hgemm_autotune_enabled()) {
+    return CUBLAS_GEMM_DEFAULT_TENSOR_OP;
+  }
+
+  static std::mutex mutex;
+  static std::map<HgemmKey, cublasGemmAlgo_t> algorithms;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = algorithms.find(key);
+    if (it != algorithms.end()) {
+      return it->second;
+    }
+  }
+
+  cudaStream_t stream = THCState_getCurrentStream(state);
+  void* scratch = THCudaMalloc(state, c_size);
+  cudaEvent_t start, stop;
+  THCudaCheck(cudaEventCreate(&start));
+  THCudaCheck(cudaEventCreate(&stop));
+
+  cublasGemmAlgo_t best = CUBLAS_GEMM_DEFAULT_TENSOR_OP;
+  float best_time = std::numeric_limits<float>::max();
+  // Algorithms a cuBLAS version doesn't have fail and are skipped
+  for (int i = -1; i < 16; i++) {
+    cublasGemmAlgo_t algo = i < 0 ? CUBLAS_GEMM_DEFAULT_TENSOR_OP
+        : static_cast<cublasGemmAlgo_t>(CUBLAS_GEMM_ALGO0_TENSOR_OP + i);
+    if (run(algo, scratch) != CUBLAS_STATUS_SUCCESS) {
+      continue;
+    }
+    THCudaCheck(cudaEventRecord(start, stream));
+    if (run(algo, scratch) != CUBLAS_STATUS_SUCCESS) {
+      continue;
+    }
+    THCudaCheck(cudaEventRecord(stop, stream));
+    THCudaCheck(cudaEventSynchronize(stop));
+    float time;
+    THCudaCheck(cudaEventElapsedTime(&time, start, stop));
+    if (time < best_time) {
+      best = algo;
+      best_time = time;
+    }
+  }
+
+  THCudaCheck(cudaEventDestroy(start));
+  THCudaCheck(cudaEventDestroy(stop));
+  THCudaFree(state, scratch);
+
+  std::lock_guard<std::mutex> lock(mutex);
+  algorithms.emplace(key, best);
+  return best;
+}
+
+void hgemm_tensor_op(THCState *state, cublasHandle_t handle, cublasOperation_t opa, cublasOperation_t opb,
+                     int m, int n, int k, float alpha, const at::Half *a, int lda,
+                     const at::Half *b, int ldb, float beta, at::Half *c, int ldc)
+{
+  auto run = [&](cublasGemmAlgo_t algo, void* c_) {
+    return cublasGemmEx(handle, opa, opb, m, n, k, &alpha,
+                        a, CUDA_R_16F, lda, b, CUDA_R_16F, ldb,
+                        &beta, c_, CUDA_R_16F, ldc, CUDA_R_32F, algo);
+  };
+  THCublasCheck(cublasSetMathMode(handle, CUBLAS_TENSOR_OP_MATH));
+  HgemmKey key(c10::cuda::current_device(), opa, opb, m, n, k, lda, ldb, ldc, 1);
+  cublasGemmAlgo_t algo = hgemm_algorithm(state, key, (size_t)ldc * n * sizeof(at::Half), run);
+  THCublasCheck(run(algo, c));
+  THCublasCheck(cublasSetMathMode(handle, CUBLAS_DEFAULT_MATH));
+}
+
+int64_t round_up_to_8(int64_t x)
+{
+  return (x + 7) / 8 * 8;
+}
+
+bool hgemm_should_pad(int64_t m, int64_t n, int64_t k, int64_t lda, int64_t ldb, int64_t ldc)
+{
+  if (m % 8 == 0 && n % 8 == 0 && k % 8 == 0 && lda % 8 == 0 && ldb % 8 == 0 && ldc % 8 == 0) {
+    return false;
+  }
+  double work = (double)m * n * k;
+  double padded_work = (double)round_up_to_8(m) * round_up_to_8(n) * round_up_to_8(k);
+  return padded_work <= 1.25 * work;
+}
+
+// Copies the rows x cols column-major matrix src into a zeroed matrix of
+// round_up_to_8(rows) x round_up_to_8(cols), whose leading dimension is
+// its number of rows.
+at::Half* pad_matrix(THCState *state, const at::Half *src, int64_t ld, int64_t rows, int64_t cols)
+{
+  cudaStream_t stream = THCState_getCurrentStream(state);
+  int64_t padded_rows = round_up_to_8(rows);
+  size_t size = padded_rows * round_up_to_8(cols) * sizeof(at::Half);
+  auto dst = static_cast<at::Half*>(THCudaMalloc(state, size));
+  THCudaCheck(cudaMemsetAsync(dst, 0, size, stream));
+  THCudaCheck(cudaMemcpy2DAsync(dst, padded_rows * sizeof(at::Half), src, ld * sizeof(at::Half),
+                                rows * sizeof(at::Half), cols, cudaMemcpyDeviceToDevice, stream));
+  return dst;
+}
+
+// Runs the GEMM on copies of the operands that are zero-padded to multiples
+// of 8. The padding of k adds zeros to the sums and the padding of m and n
+// is dropped when the result is copied back.
+void hgemm_padded(THCState *state, cublasHandle_t handle, cublasOperation_t opa, cublasOperation_t opb,
+                  int64_t m, int64_t n, int64_t k, float alpha, const at::Half *a, int64_t lda,
+                  const at::Half *b, int64_t ldb, float beta, at::Half *c, int64_t ldc)
+{
+  cudaStream_t stream = THCState_getCurrentStream(state);
+  bool transa = opa != CUBLAS_OP_N;
+  bool transb = opb != CUBLAS_OP_N;
+  at::Half* padded_a = transa ? pad_matrix(state, a, lda, k, m) : pad_matrix(state, a, lda, m, k);
+  at::Half* padded_b = transb ? pad_matrix(state, b, ldb, n, k) : pad_matrix(state, b, ldb, k, n);
+  at::Half* padded_c;
+  if (beta != 0) {
+    padded_c = pad_matrix(state, c, ldc, m, n);
+  } else {
+    padded_c = static_cast<at::Half*>(THCudaMalloc(
+        state, round_up_to_8(m) * round_up_to_8(n) * sizeof(at::Half)));
+  }
+
+  int padded_m = round_up_to_8(m);
+  int padded_n = round_up_to_8(n);
+  int padded_k = round_up_to_8(k);
+  hgemm_tensor_op(state, handle, opa, opb, padded_m, padded_n, padded_k,
+                  alpha, padded_a, transa ? padded_k : padded_m,
+                  padded_b, transb ? padded_n : padded_k,
+                  beta, padded_c, padded_m);
+
+  THCudaCheck(cudaMemcpy2DAsync(c, ldc * sizeof(at::Half), padded_c, padded_m * sizeof(at::Half),
+                                m * sizeof(at::Half), n, cudaMemcpyDeviceToDevice, stream));
+  THCudaFree(state, padded_a);
+  THCudaFree(state, padded_b);
+  THCudaFree(state, padded_c);
+}
+
+} // namespace
+#endif
+
 void THCudaBlas_Hgemm(THCState *state, char transa, char transb, int64_t m, int64_t n, int64_t k, at::Half alpha, at::Half *a, int64_t lda, at::Half *b, int64_t ldb, at::Half beta, at::Half *c, int64_t ldc)
 {
   adjustLdLevel3(transa, transb, m, n, k, &lda, &ldb, &ldc);
@@ -306,14 +483,13 @@ void THCudaBlas_Hgemm(THCState *state, char transa, char transb, int64_t m, int6
                                   i_ldb, &fBeta, c, CUDA_R_16F, i_ldc));
 #else
       cudaDeviceProp* prop = at::cuda::getCurrentDeviceProperties();
-      if (prop->major >= 5){
-        THCublasCheck(cublasSetMathMode(handle, CUBLAS_TENSOR_OP_MATH));
-        THCublasCheck(cublasGemmEx(handle, opa, opb,
-                                   i_m, i_n, i_k, &fAlpha,
-                                   a, CUDA_R_16F, i_lda, b, CUDA_R_16F,
-                                   i_ldb, &fBeta, c, CUDA_R_16F, i_ldc,
-                                   CUDA_R_32F, CUBLAS_GEMM_DFALT_TENSOR_OP));
-        THCublasCheck(cublasSetMathMode(handle, CUBLAS_DEFAULT_MATH));
+      if (prop->major >= 7 && hgemm_pad_enabled() &&
+          hgemm_should_pad(i_m, i_n, i_k, i_lda, i_ldb, i_ldc)) {
+        hgemm_padded(state, handle, opa, opb, i_m, i_n, i_k,
+                     fAlpha, a, i_lda, b, i_ldb, fBeta, c, i_ldc);
+      } else if (prop->major >= 5){
+        hgemm_tensor_op(state, handle, opa, opb, i_m, i_n, i_k,
+                        fAlpha, a, i_lda, b, i_ldb, fBeta, c, i_ldc);
       }else{
         THCublasCheck(cublasSgemmEx(handle, opa, opb,
                                     i_m, i_n, i_k, &fAlpha,
@@ -381,13 +557,19 @@ void THCudaBlas_HgemmStridedBatched(THCState *state, char transa, char transb, i
                                    (int) batchCount, rocblas_datatype_f32_r, rocblas_gemm_algo_standard,
                                    0, 0, NULL, NULL));
 #else
+  auto run = [&](cublasGemmAlgo_t algo, void* c_) {
+    return cublasGemmStridedBatchedEx(handle,
+                                      opa, opb, (int)m, (int)n, (int)k,
+                                      (void*)&fAlpha, a, CUDA_R_16F, (int)lda, strideA,
+                                      b, CUDA_R_16F, (int)ldb, strideB,
+                                      (void*)&fBeta, c_, CUDA_R_16F, (int)ldc, strideC,
+                                      (int)batchCount, CUDA_R_32F, algo);
+  };
   THCublasCheck(cublasSetMathMode(handle, CUBLAS_TENSOR_OP_MATH));
-  THCublasCheck(cublasGemmStridedBatchedEx(handle,
-                                   opa, opb, (int)m, (int)n, (int)k,
-                                   (void*)&fAlpha, a, CUDA_R_16F, (int)lda, strideA,
-                                   b, CUDA_R_16F, (int)ldb, strideB,
-                                   (void*)&fBeta, c, CUDA_R_16F, (int)ldc, strideC,
-                                   (int)batchCount, CUDA_R_32F, CUBLAS_GEMM_DEFAULT_TENSOR_OP));
+  HgemmKey key(c10::cuda::current_device(), opa, opb, m, n, k, lda, ldb, ldc, batchCount);
+  size_t c_size = ((batchCount - 1) * strideC + ldc * n) * sizeof(at::Half);
+  cublasGemmAlgo_t algo = hgemm_algorithm(state, key, c_size, run);
+  THCublasCheck(run(algo, c));
   THCublasCheck(cublasSetMathMode(handle, CUBLAS_DEFAULT_MATH));
 #endif
 }
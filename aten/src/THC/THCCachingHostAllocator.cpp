@@ -1,105 +1,277 @@
 #include <THC/THCCachingHostAllocator.h>
 
+#include <c10/util/Exception.h>
 
 #include <cuda_runtime_api.h>
+#include <atomic>
+#include <cstdlib>
 #include <deque>
 #include <memory>
 #include <mutex>
 #include <stdint.h>
+#include <string>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
-#include <set>
 #include <utility>
+#include <vector>
 
 namespace {
 
-struct BlockSize
-{
-  size_t  size; // allocation size
-  void*   ptr;  // host memory pointer
+// Smallest size class, and the alignment of blocks carved out of the arena
+constexpr size_t kMinBlockSize = 512;
 
-  BlockSize(size_t size, void* ptr=NULL) : size(size), ptr(ptr) {}
+struct HostAllocatorConfig
+{
+  // sizes are rounded up to one of this many sizes per power-of-two interval
+  size_t roundup_power2_divisions = 4;
+  // bytes of freed blocks each thread keeps for itself
+  size_t thread_cache_size = 16 * 1048576;
+  // bytes of pinned memory reserved up front
+  size_t reserve_size = 0;
 };
 
-struct Block : public BlockSize
+HostAllocatorConfig parse_host_allocator_settings(const char* settings_cstr)
+{
+  HostAllocatorConfig config;
+  std::string settings(settings_cstr);
+  size_t pos = 0;
+  while (pos < settings.size()) {
+    size_t end = settings.find(',', pos);
+    if (end == std::string::npos) {
+      end = settings.size();
+    }
+    std::string option = settings.substr(pos, end - pos);
+    pos = end + 1;
+    if (option.empty()) {
+      continue;
+    }
+    size_t colon = option.find(':');
+    AT_CHECK(colon != std::string::npos,
+             "Invalid CUDA host allocator setting '", option, "', expected key:value");
+    std::string key = option.substr(0, colon);
+    std::string value = option.substr(colon + 1);
+    char* value_end = nullptr;
+    long long number = std::strtoll(value.c_str(), &value_end, 10);
+    AT_CHECK(*value_end == '\0' && number >= 0,
+             "CUDA host allocator setting ", key,
+             " must be a non-negative integer, got ", value);
+    if (key == "roundup_power2_divisions") {
+      AT_CHECK((number & (number - 1)) == 0,
+               "CUDA host allocator roundup_power2_divisions must be 0 or a "
+               "power of two, got ", value);
+      config.roundup_power2_divisions = static_cast<size_t>(number);
+    } else if (key == "thread_cache_mb") {
+      config.thread_cache_size = static_cast<size_t>(number) * 1048576;
+    } else if (key == "reserve_mb") {
+      config.reserve_size = static_cast<size_t>(number) * 1048576;
+    } else {
+      AT_ERROR("Unknown CUDA host allocator setting: ", key);
+    }
+  }
+  return config;
+}
+
+struct Block
 {
-  bool  allocated;    // true if the block is currently allocated
-  int   event_count;  // number of outstanding cuda events
+  size_t  size;         // size class of the block
+  void*   ptr;          // host memory pointer
+  bool    allocated;    // true while handed out or held by a thread cache
+  bool    in_reserve;   // carved out of the reserved memory, never freed
+  int     event_count;  // number of outstanding cuda events
+  // set by recordEvent, so that free can skip the lock for unrecorded blocks
+  std::atomic<bool> has_streams;
   std::unordered_set<at::cuda::CUDAStream> streams;
 
-  Block(size_t size, void* ptr, bool allocated) :
-      BlockSize(size, ptr), allocated(allocated), event_count(0), streams() {}
+  Block(size_t size, void* ptr, bool in_reserve) :
+      size(size), ptr(ptr), allocated(true), in_reserve(in_reserve),
+      event_count(0), has_streams(false), streams() {}
 };
 
-static bool BlockComparator(const BlockSize& a, const BlockSize& b)
+// Freed blocks kept by one thread, which it reuses without taking the lock.
+// The blocks stay marked as allocated until they are returned.
+struct ThreadCache
 {
-  // sort by size, break ties with pointer
-  if (a.size != b.size) {
-    return a.size < b.size;
+  std::unordered_map<size_t, std::vector<Block*>> blocks;
+  size_t cached_size = 0;
+
+  ~ThreadCache();
+};
+
+// Set once the calling thread's cache is destroyed, for frees during thread
+// or program exit
+thread_local bool thread_cache_destroyed = false;
+
+ThreadCache* get_thread_cache()
+{
+  if (thread_cache_destroyed) {
+    return nullptr;
   }
-  return (uintptr_t)a.ptr < (uintptr_t)b.ptr;
+  static thread_local ThreadCache cache;
+  return &cache;
 }
 
 struct HostAllocator
 {
-  typedef bool (*Comparison)(const BlockSize&, const BlockSize&);
-
-  // lock around all operations
+  // lock around the shared state below
   std::mutex mutex;
 
-  // blocks by pointer
+  // blocks by pointer; pointers to the elements stay valid on rehashing
   std::unordered_map<void*, Block> blocks;
 
-  // pointers that are ready to be allocated (event_count=0)
-  std::set<BlockSize, Comparison> available;
+  // blocks that are ready to be allocated (event_count=0), by size class
+  std::unordered_map<size_t, std::vector<Block*>> available;
 
   // outstanding cuda events
-  std::deque<std::pair<cudaEvent_t, void*>> cuda_events;
+  std::deque<std::pair<cudaEvent_t, Block*>> cuda_events;
+
+  // memory reserved up front, and how much of it is handed out
+  std::once_flag init_flag;
+  char* reserve = nullptr;
+  size_t reserve_used = 0;
 
-  HostAllocator() : available(BlockComparator) {}
+  // read from PYTORCH_CUDA_HOST_ALLOC_CONF on the first allocation
+  HostAllocatorConfig config;
 
-  cudaError_t malloc(void** ptr, size_t size)
+  // Rounds size up to its size class, so that requests of similar sizes
+  // share blocks
+  size_t round_size(size_t size) const
   {
-    std::lock_guard<std::mutex> lock(mutex);
+    if (size <= kMinBlockSize) {
+      return kMinBlockSize;
+    }
+    size_t power = kMinBlockSize;
+    while (power <= size / 2) {
+      power *= 2;
+    }
+    if (size == power) {
+      return size;
+    }
+    size_t divisions = config.roundup_power2_divisions;
+    size_t step = divisions > 1 ? power / divisions : power;
+    if (step < kMinBlockSize) {
+      step = kMinBlockSize;
+    }
+    return (size + step - 1) / step * step;
+  }
 
-    // process outstanding cuda events which may have occurred
-    cudaError_t err = processEvents();
+  // Reads the settings and reserves memory, once. Errors in the settings are
+  // raised here rather than when the library is loaded.
+  cudaError_t init()
+  {
+    cudaError_t err = cudaSuccess;
+    std::call_once(init_flag, [&] {
+      const char* settings = std::getenv("PYTORCH_CUDA_HOST_ALLOC_CONF");
+      if (settings) {
+        config = parse_host_allocator_settings(settings);
+      }
+      if (config.reserve_size > 0) {
+        void* ptr = nullptr;
+        err = cudaHostAlloc(&ptr, config.reserve_size, cudaHostAllocDefault);
+        reserve = static_cast<char*>(ptr);
+      }
+    });
+    return err;
+  }
+
+  cudaError_t malloc(void** ptr, Block** ctx, size_t size)
+  {
+    *ptr = nullptr;
+    *ctx = nullptr;
+    if (size == 0) {
+      return cudaSuccess;
+    }
+    cudaError_t err = init();
     if (err != cudaSuccess) {
       return err;
     }
-
-    // search for the smallest block which can hold this allocation
-    BlockSize search_key(size);
-    auto it = available.lower_bound(search_key);
-    if (it != available.end()) {
-      Block& block = blocks.at(it->ptr);
-      THAssert(!block.allocated && block.event_count == 0);
-      block.allocated = true;
-      *ptr = block.ptr;
-      available.erase(it);
-      return cudaSuccess;
+    size = round_size(size);
+
+    ThreadCache* cache = get_thread_cache();
+    if (cache) {
+      auto it = cache->blocks.find(size);
+      if (it != cache->blocks.end() && !it->second.empty()) {
+        Block* block = it->second.back();
+        it->second.pop_back();
+        cache->cached_size -= block->size;
+        *ptr = block->ptr;
+        *ctx = block;
+        return cudaSuccess;
+      }
     }
 
-    // note that cudaHostAlloc may not touch pointer if size is 0
-    *ptr = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
 
-    // allocate a new block if no cached allocation is found
-    err = cudaHostAlloc(ptr, size, cudaHostAllocDefault);
+      // process outstanding cuda events which may have occurred
+      err = processEvents();
+      if (err != cudaSuccess) {
+        return err;
+      }
+
+      auto it = available.find(size);
+      if (it != available.end() && !it->second.empty()) {
+        Block* block = it->second.back();
+        it->second.pop_back();
+        THAssert(!block->allocated && block->event_count == 0);
+        block->allocated = true;
+        *ptr = block->ptr;
+        *ctx = block;
+        return cudaSuccess;
+      }
+
+      // carve a new block out of the reserved memory
+      if (reserve && config.reserve_size - reserve_used >= size) {
+        void* block_ptr = reserve + reserve_used;
+        reserve_used += size;
+        *ctx = insertBlock(size, block_ptr, /*in_reserve=*/true);
+        *ptr = block_ptr;
+        return cudaSuccess;
+      }
+    }
+
+    // allocate a new block if no cached allocation is found. cudaHostAlloc
+    // is slow and may synchronize the device, so the lock is not held.
+    void* block_ptr = nullptr;
+    err = cudaHostAlloc(&block_ptr, size, cudaHostAllocDefault);
     if (err != cudaSuccess) {
       return err;
     }
 
-    blocks.insert({*ptr, Block(size, *ptr, true)});
+    std::lock_guard<std::mutex> lock(mutex);
+    *ctx = insertBlock(size, block_ptr, /*in_reserve=*/false);
+    *ptr = block_ptr;
     return cudaSuccess;
   }
 
-  cudaError_t free(void* ptr)
+  Block* insertBlock(size_t size, void* ptr, bool in_reserve)
   {
-    std::lock_guard<std::mutex> lock(mutex);
+    auto result = blocks.emplace(
+        std::piecewise_construct,
+        std::forward_as_tuple(ptr),
+        std::forward_as_tuple(size, ptr, in_reserve));
+    return &result.first->second;
+  }
 
-    if (!ptr) {
+  cudaError_t free(Block* block)
+  {
+    if (!block) {
       return cudaSuccess;
     }
+    THAssert(block->allocated);
+
+    // blocks that were never used on a stream can be reused right away, by
+    // the thread that freed them
+    if (!block->has_streams.load()) {
+      ThreadCache* cache = get_thread_cache();
+      if (cache && cache->cached_size + block->size <= config.thread_cache_size) {
+        cache->blocks[block->size].push_back(block);
+        cache->cached_size += block->size;
+        return cudaSuccess;
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
 
     // process outstanding cuda events which may have occurred
     cudaError_t err = processEvents();
@@ -107,29 +279,37 @@ struct HostAllocator
       return err;
     }
 
-    auto it = blocks.find(ptr);
-    THAssert(it != blocks.end());
-
-    Block& block = it->second;
-    THAssert(block.allocated);
-
     // free (on valid memory) shouldn't fail, so mark unallocated before
     // we process the streams.
-    block.allocated = false;
+    block->allocated = false;
 
     // insert CUDA events for each stream on which this block was used. This
-    err = insertEvents(block);
+    err = insertEvents(*block);
     if (err != cudaSuccess) {
       return err;
     }
 
-    if (block.event_count == 0) {
+    if (block->event_count == 0) {
       // the block can be re-used if there are no outstanding cuda events
-      available.insert(block);
+      available[block->size].push_back(block);
     }
     return cudaSuccess;
   }
 
+  // Returns the blocks of a thread cache to the shared pool
+  void releaseThreadCache(ThreadCache& cache)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : cache.blocks) {
+      for (Block* block : entry.second) {
+        block->allocated = false;
+        available[block->size].push_back(block);
+      }
+    }
+    cache.blocks.clear();
+    cache.cached_size = 0;
+  }
+
   cudaError_t recordEvent(void* ptr, at::cuda::CUDAStream stream)
   {
     std::lock_guard<std::mutex> lock(mutex);
@@ -144,6 +324,7 @@ struct HostAllocator
     THAssert(block.allocated);
 
     block.streams.insert(stream);
+    block.has_streams.store(true);
     return cudaSuccess;
   }
 
@@ -169,10 +350,10 @@ struct HostAllocator
         return err;
       }
 
-      Block& block = blocks.at(e.second);
+      Block& block = *e.second;
       block.event_count--;
       if (block.event_count == 0 && !block.allocated) {
-        available.insert(block);
+        available[block.size].push_back(&block);
       }
       cuda_events.pop_front();
     }
@@ -181,12 +362,17 @@ struct HostAllocator
 
   void emptyCache()
   {
+    ThreadCache* cache = get_thread_cache();
+    if (cache) {
+      releaseThreadCache(*cache);
+    }
+
     std::lock_guard<std::mutex> lock(mutex);
 
     // remove events for freed blocks
     for (auto it = cuda_events.begin(); it != cuda_events.end(); ++it) {
       cudaEvent_t event = it->first;
-      Block& block = blocks.at(it->second);
+      Block& block = *it->second;
       if (!block.allocated) {
         THCudaCheckWarn(cudaEventDestroy(event));
         block.event_count--;
@@ -199,13 +385,17 @@ struct HostAllocator
     // clear list of available blocks
     available.clear();
 
-    // free and erase non-allocated blocks
+    // free and erase non-allocated blocks. Blocks of the reserved memory
+    // stay cached, since they can't be freed on their own.
     for (auto it = blocks.begin(); it != blocks.end();) {
       Block& block = it->second;
-      if (!block.allocated) {
+      if (!block.allocated && !block.in_reserve) {
         THCudaCheckWarn(cudaFreeHost(block.ptr));
         it = blocks.erase(it);
       } else {
+        if (!block.allocated) {
+          available[block.size].push_back(&block);
+        }
         ++it;
       }
     }
@@ -213,13 +403,18 @@ struct HostAllocator
 
   cudaError_t insertEvents(Block& block)
   {
-    cudaError_t err;
+    cudaError_t err = cudaSuccess;
+    if (!block.has_streams.load()) {
+      return err;
+    }
 
     int prev_device;
     err = cudaGetDevice(&prev_device);
     if (err != cudaSuccess) return err;
 
     std::unordered_set<at::cuda::CUDAStream> streams(std::move(block.streams));
+    block.streams.clear();
+    block.has_streams.store(false);
     for (auto it = streams.begin(); it != streams.end(); ++it) {
       err = cudaSetDevice(it->device_index());
       if (err != cudaSuccess) break;
@@ -232,7 +427,7 @@ struct HostAllocator
       if (err != cudaSuccess) break;
 
       block.event_count++;
-      cuda_events.emplace_back(event, block.ptr);
+      cuda_events.emplace_back(event, &block);
     }
 
     cudaSetDevice(prev_device);
@@ -244,6 +439,12 @@ struct HostAllocator
 
 static HostAllocator allocator;
 
+ThreadCache::~ThreadCache()
+{
+  thread_cache_destroyed = true;
+  allocator.releaseThreadCache(*this);
+}
+
 cudaError_t THCCachingHostAllocator_recordEvent(void *ptr, at::cuda::CUDAStream stream)
 {
   return allocator.recordEvent(ptr, stream);
@@ -254,16 +455,17 @@ void THCCachingHostAllocator_emptyCache()
   allocator.emptyCache();
 }
 
-static void THCCachingHostDeleter(void* ptr) {
-  allocator.free(ptr);
+static void THCCachingHostDeleter(void* ctx) {
+  allocator.free(static_cast<Block*>(ctx));
 }
 
 struct THCCachingHostAllocator final : public at::Allocator {
   at::DataPtr allocate(size_t size) const override {
     THAssert(size >= 0);
     void *ptr;
-    THCudaCheck(allocator.malloc(&ptr, size));
-    return {ptr, ptr, &THCCachingHostDeleter, at::DeviceType::CPU};
+    Block *ctx;
+    THCudaCheck(allocator.malloc(&ptr, &ctx, size));
+    return {ptr, ctx, &THCCachingHostDeleter, at::DeviceType::CPU};
   }
   at::DeleterFnPtr raw_deleter() const override {
     return &THCCachingHostDeleter;
@@ -19,7 +19,25 @@
 // copy_from_cpu_async_ and copy_to_cpu_async_.
 //
 // Note that this allocator does not split larger allocations into smaller
-// blocks, unlike the caching device allocator.
+// blocks, unlike the caching device allocator. Instead, requests are rounded
+// up to size classes, so blocks are shared between requests of similar sizes.
+// Each thread keeps a few freed blocks it can reuse without taking the lock,
+// as long as they were not used on a stream. New blocks are allocated outside
+// the lock.
+//
+// The allocator is configured with the PYTORCH_CUDA_HOST_ALLOC_CONF
+// environment variable, a comma-separated list of key:value options:
+//
+//   reserve_mb:N                  pins N MiB with a single cudaHostAlloc on
+//                                 the first allocation, and serves blocks out
+//                                 of it before allocating new ones (default 0)
+//   thread_cache_mb:N             bytes of freed blocks each thread keeps for
+//                                 itself (default 16)
+//   roundup_power2_divisions:N    number of size classes between consecutive
+//                                 powers of two, 0 or a power of two (default 4)
+//
+// Blocks held by other threads' caches and blocks of the reserved memory are
+// not released by THCCachingHostAllocator_emptyCache.
 //
 THC_API c10::Allocator* getTHCCachingHostAllocator(void);
 
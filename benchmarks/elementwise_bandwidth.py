@@ -0,0 +1,89 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import argparse
+
+import torch
+
+
+"""Memory bandwidth of contiguous element-wise CUDA ops, per dtype.
+
+Reports the effective bandwidth, the bytes read and written by each op over
+its run time, which for these ops is bound by DRAM bandwidth:
+
+    python elementwise_bandwidth.py --numel 16777216 --dtypes float half
+"""
+
+DTYPES = {
+    'float': torch.float32,
+    'half': torch.float16,
+    'double': torch.float64,
+    'int': torch.int32,
+    'long': torch.int64,
+    'byte': torch.uint8,
+}
+
+# (name, number of inputs, op)
+OPS = [
+    ('neg', 1, lambda a, b: torch.neg(a)),
+    ('abs', 1, lambda a, b: torch.abs(a)),
+    ('add', 2, lambda a, b: torch.add(a, b)),
+    ('mul', 2, lambda a, b: torch.mul(a, b)),
+    ('add_', 2, lambda a, b: a.add_(b)),
+]
+
+
+def make_input(numel, dtype, offset):
+    # offset elements from an aligned allocation, to time the unaligned case
+    if dtype.is_floating_point:
+        t = torch.rand(numel + offset, device='cuda').to(dtype)
+    else:
+        t = torch.randint(0, 100, (numel + offset,), device='cuda', dtype=dtype)
+    return t[offset:]
+
+
+def bandwidth(op, num_inputs, a, b, iters):
+    out = op(a, b)
+    torch.cuda.synchronize()
+    start = torch.cuda.Event(enable_timing=True)
+    end = torch.cuda.Event(enable_timing=True)
+    start.record()
+    for _ in range(iters):
+        op(a, b)
+    end.record()
+    torch.cuda.synchronize()
+    seconds = start.elapsed_time(end) / 1e3 / iters
+    num_bytes = (num_inputs * a.numel() + out.numel()) * a.element_size()
+    return num_bytes / seconds / 1e9
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Memory bandwidth of contiguous element-wise CUDA ops')
+    parser.add_argument('--numel', type=int, default=1 << 24)
+    parser.add_argument('--iters', type=int, default=100)
+    parser.add_argument('--dtypes', nargs='+', default=sorted(DTYPES.keys()),
+                        choices=sorted(DTYPES.keys()))
+    parser.add_argument('--offset', type=int, default=0,
+                        help='misalign the inputs by this many elements')
+    args = parser.parse_args()
+
+    if not torch.cuda.is_available():
+        raise RuntimeError('elementwise_bandwidth.py requires CUDA')
+
+    print('{:<8} {:<6} {:>10}'.format('dtype', 'op', 'GB/s'))
+    for dtype_name in args.dtypes:
+        dtype = DTYPES[dtype_name]
+        a = make_input(args.numel, dtype, args.offset)
+        b = make_input(args.numel, dtype, args.offset)
+        for name, num_inputs, op in OPS:
+            if name in ('neg', 'abs') and dtype == torch.uint8:
+                continue
+            gbps = bandwidth(op, num_inputs, a, b, args.iters)
+            print('{:<8} {:<6} {:>10.1f}'.format(dtype_name, name, gbps))
+
+
+if __name__ == '__main__':
+    main()
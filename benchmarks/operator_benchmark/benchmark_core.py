@@ -27,6 +27,10 @@ RUN_MODES = {'short': 0, 'long': 1}
 BENCHMARK_TESTER = [{} for _ in range(len(RUN_MODES))]
 BENCHMARK_TEST_GROUP = {}
 
+# The PyTorch test cases, as (test name, input shapes, op args, run mode)
+# tuples, which binaries/aten_operator_benchmark.cc can run without Python.
+PYTORCH_TEST_CASES = []
+
 
 def add_benchmark_tester(framework, op_name, input_shapes, op_args, run_mode, func):
     func_name = "__".join([framework, op_name, benchmark_utils.shape_to_string(input_shapes)
@@ -40,6 +44,24 @@ def add_benchmark_tester(framework, op_name, input_shapes, op_args, run_mode, fu
         BENCHMARK_TESTER[mode][func_name] = func
 
 
+def add_pytorch_test_case(test_name, input_shapes, op_args, run_mode):
+    PYTORCH_TEST_CASES.append((test_name, input_shapes, op_args, run_mode))
+
+
+def export_cpp_configs(path):
+    """Writes the PyTorch test cases to a file for the C++ benchmark runner,
+    one per line: the test name, the run mode, the input shapes and the op
+    args, e.g. `matmul short 8x32,32x64 contig=0,dtype=float32`.
+    """
+    with open(path, 'w') as f:
+        for test_name, input_shapes, op_args, run_mode in PYTORCH_TEST_CASES:
+            shapes = ','.join('x'.join(str(s) for s in shape) for shape in input_shapes)
+            args = ['contig={}'.format(int(op_args.get('contig', True)))]
+            if 'dtype' in op_args:
+                args.append('dtype={}'.format(str(op_args['dtype']).replace('torch.', '')))
+            f.write('{} {} {} {}\n'.format(test_name, run_mode, shapes, ','.join(args)))
+
+
 def register_test(func):
     """Decorator to register a benchmark test group.
     A benchmark test group is a function that returns a list of benchmark test
@@ -134,6 +156,10 @@ class BenchmarkRunner(object):
         if self.args.list_tests:
             return
 
+        if self.args.export_cpp_configs:
+            export_cpp_configs(self.args.export_cpp_configs)
+            return
+
         for tester in BENCHMARK_TESTER[run_mode].items():
             full_test_id = tester[0]
             benchmark_func = tester[1]
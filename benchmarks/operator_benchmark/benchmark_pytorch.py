@@ -44,3 +44,4 @@ def PyTorchOperatorTestCase(test_name, op_type, input_shapes, op_args, run_mode)
         op_type(*(inputs + [num_runs]))
 
     benchmark_core.add_benchmark_tester("PyTorch", test_name, input_shapes, op_args, run_mode, benchmark_func)
+    benchmark_core.add_pytorch_test_case(test_name, input_shapes, op_args, run_mode)
@@ -51,6 +51,12 @@ def main():
         help='List all test cases without running them',
         action='store_true')
 
+    parser.add_argument(
+        '--export_cpp_configs',
+        help='Write the PyTorch test cases to this file for '
+        'binaries/aten_operator_benchmark.cc instead of running them',
+        default=None)
+
     parser.add_argument(
         "--iterations",
         help="Repeat each operator for the number of iterations",
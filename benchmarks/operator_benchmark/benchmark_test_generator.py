@@ -90,3 +90,9 @@ def map_pt_config_intraop(test_name, N, M, contig, dtype):
     input_shapes = [(N, M), (N, M)]
     args = {'contig': contig, 'dtype': dtype}
     return (input_shapes, args)
+
+
+def map_pt_config_reduce(test_name, M, N, contig):
+    input_shapes = [(M, N), (M, N)]
+    args = {'contig': contig, 'dtype': torch.float32}
+    return (input_shapes, args)
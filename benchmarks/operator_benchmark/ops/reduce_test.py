@@ -0,0 +1,63 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from operator_benchmark import benchmark_core, benchmark_runner
+from operator_benchmark.benchmark_test_generator import *
+
+import torch
+
+
+"""Microbenchmarks for PyTorch CPU reductions.
+
+Tests the following functions:
+
+- sum, mean, max, norm
+    - reductions over the outer (dim 0) and inner (dim 1) dimension of a
+      matrix, including tall matrices with few columns whose outer reduction
+      has fewer outputs than threads
+"""
+
+# Config
+config = generate_configs(
+    M=[16384, 1024],
+    N=[4, 64, 1024],
+    contig=[True, False],
+    mode=['short'],
+    sample_func=cross_product
+)
+
+
+def torch_reduce(op_str, dim):
+    jit_op_loop_code = """\
+def forward(self, a, b, iterations):
+    # type: (Tensor, Tensor, int)
+    result = a
+    for _ in range(iterations):
+        result = {}
+    return result
+"""
+    jit_op_loop = torch.jit.ScriptModule()
+    jit_op_loop.define(jit_op_loop_code.format(op_str.format(dim)))
+
+    print("torch_reduce(", op_str, dim, "):\n", jit_op_loop.code)
+    return jit_op_loop
+
+
+@benchmark_core.register_test
+def test_reduce():
+    generate_pt_test(
+        [config],
+        map_pt_config_reduce,
+        [(name + str(dim), torch_reduce(op_str, dim))
+         for name, op_str in [('sum', 'torch.sum(a, {})'),
+                              ('mean', 'torch.mean(a, {})'),
+                              ('max', 'torch.max(a, {})[0]'),
+                              ('norm', 'torch.norm(a, 2, {})')]
+         for dim in [0, 1]]
+    )
+
+
+if __name__ == "__main__":
+    benchmark_runner.main()
@@ -0,0 +1,76 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import argparse
+import json
+import subprocess
+import sys
+import time
+
+
+"""Startup time of short-lived processes using PyTorch.
+
+Runs fresh interpreters that import torch and then compile and run a small
+TorchScript function, which looks up its operators for the first time, and
+reports the median of each step over the runs:
+
+    python startup_time.py --runs 20
+"""
+
+CHILD = r"""
+import json
+import time
+start = time.time()
+import torch
+imported = time.time()
+
+@torch.jit.script
+def f(x, y):
+    return torch.relu(x * y + 1).sum()
+
+f(torch.ones(4), torch.ones(4))
+scripted = time.time()
+print(json.dumps({'start': start, 'import': imported - start,
+                  'first_script': scripted - imported}))
+"""
+
+
+def run_once():
+    launched = time.time()
+    out = subprocess.check_output([sys.executable, '-c', CHILD])
+    exited = time.time()
+    times = json.loads(out.decode('utf-8').strip().splitlines()[-1])
+    return {
+        'interpreter': times['start'] - launched,
+        'import torch': times['import'],
+        'first script call': times['first_script'],
+        'process': exited - launched,
+    }
+
+
+def median(values):
+    values = sorted(values)
+    mid = len(values) // 2
+    if len(values) % 2:
+        return values[mid]
+    return (values[mid - 1] + values[mid]) / 2
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Startup time of processes using PyTorch')
+    parser.add_argument('--runs', type=int, default=10)
+    args = parser.parse_args()
+
+    # the first run warms up the file system caches
+    run_once()
+    runs = [run_once() for _ in range(args.runs)]
+    print('{:<20} {:>10}'.format('step', 'ms'))
+    for step in ['interpreter', 'import torch', 'first script call', 'process']:
+        print('{:<20} {:>10.1f}'.format(step, 1e3 * median([r[step] for r in runs])))
+
+
+if __name__ == '__main__':
+    main()
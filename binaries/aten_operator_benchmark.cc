@@ -0,0 +1,253 @@
+// Runs the PyTorch test cases of benchmarks/operator_benchmark on the ATen
+// ops directly, so that kernel regressions show up without the overhead of
+// Python and of the bindings. The test cases are exported from the Python
+// benchmarks, e.g.
+//
+//   cd benchmarks
+//   python -m operator_benchmark.ops.matmul_test \
+//       --export_cpp_configs=configs.txt
+//
+// and every one of them runs for each of the given thread counts and devices:
+//
+//   aten_operator_benchmark --configs=configs.txt --run_mode=short \
+//       --threads=1,4 --devices=cpu,cuda \
+//       --benchmark_format=json --benchmark_out=results.json
+//
+// The names of the benchmarks only depend on the test cases, so the results
+// of two commits can be compared with Google Benchmark's tools/compare.py.
+
+#include "benchmark/benchmark.h"
+
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#ifdef USE_CUDA
+#include <c10/cuda/CUDAStream.h>
+#endif
+
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct TestCase {
+  std::string name;
+  std::string run_mode;
+  std::vector<std::vector<int64_t>> shapes;
+  bool contig = true;
+  at::ScalarType dtype = at::kFloat;
+};
+
+using Op = std::function<at::Tensor(std::vector<at::Tensor>&)>;
+
+// The ops of the PyTorch test cases, by test name. They compute what the
+// TorchScript loops of the Python test cases compute once per iteration.
+const std::unordered_map<std::string, Op>& ops() {
+  static const std::unordered_map<std::string, Op> ops = {
+      {"add", [](std::vector<at::Tensor>& x) { return at::add(x[0], x[1]); }},
+      {"matmul",
+       [](std::vector<at::Tensor>& x) { return at::matmul(x[0], x[1]); }},
+      {"bitor", [](std::vector<at::Tensor>& x) { return x[0].__ior__(42); }},
+      {"cbitor",
+       [](std::vector<at::Tensor>& x) { return x[0].__ior__(x[1]); }},
+      {"tanh", [](std::vector<at::Tensor>& x) { return x[0].tanh_(); }},
+      {"sigmoid", [](std::vector<at::Tensor>& x) { return x[0].sigmoid_(); }},
+      {"sumall", [](std::vector<at::Tensor>& x) { return at::sum(x[0]); }},
+      {"sum0", [](std::vector<at::Tensor>& x) { return at::sum(x[0], {0}); }},
+      {"sum1", [](std::vector<at::Tensor>& x) { return at::sum(x[0], {1}); }},
+      {"mean0", [](std::vector<at::Tensor>& x) { return at::mean(x[0], {0}); }},
+      {"mean1", [](std::vector<at::Tensor>& x) { return at::mean(x[0], {1}); }},
+      {"max0",
+       [](std::vector<at::Tensor>& x) { return std::get<0>(at::max(x[0], 0)); }},
+      {"max1",
+       [](std::vector<at::Tensor>& x) { return std::get<0>(at::max(x[0], 1)); }},
+      {"norm0",
+       [](std::vector<at::Tensor>& x) {
+         return at::norm(x[0], c10::optional<at::Scalar>(2), {0});
+       }},
+      {"norm1",
+       [](std::vector<at::Tensor>& x) {
+         return at::norm(x[0], c10::optional<at::Scalar>(2), {1});
+       }},
+  };
+  return ops;
+}
+
+std::vector<std::string> split(const std::string& text, char separator) {
+  std::vector<std::string> parts;
+  std::stringstream stream(text);
+  std::string part;
+  while (std::getline(stream, part, separator)) {
+    parts.push_back(part);
+  }
+  return parts;
+}
+
+// Parses a test case written by benchmark_core.export_cpp_configs(), e.g.
+// `matmul short 8x32,32x64 contig=0,dtype=float32`.
+TestCase parseTestCase(const std::string& line) {
+  std::stringstream stream(line);
+  TestCase test_case;
+  std::string shapes, args;
+  stream >> test_case.name >> test_case.run_mode >> shapes >> args;
+  AT_CHECK(!args.empty(), "Invalid test case: ", line);
+  for (const auto& shape : split(shapes, ',')) {
+    test_case.shapes.emplace_back();
+    for (const auto& size : split(shape, 'x')) {
+      test_case.shapes.back().push_back(std::stoll(size));
+    }
+  }
+  for (const auto& arg : split(args, ',')) {
+    const auto key_value = split(arg, '=');
+    AT_CHECK(key_value.size() == 2, "Invalid op arg ", arg, " in: ", line);
+    if (key_value[0] == "contig") {
+      test_case.contig = key_value[1] == "1";
+    } else if (key_value[0] == "dtype") {
+      static const std::unordered_map<std::string, at::ScalarType> dtypes = {
+          {"float32", at::kFloat},
+          {"float64", at::kDouble},
+          {"float16", at::kHalf},
+          {"int32", at::kInt},
+          {"int64", at::kLong},
+          {"uint8", at::kByte},
+      };
+      const auto it = dtypes.find(key_value[1]);
+      AT_CHECK(it != dtypes.end(), "Unsupported dtype in: ", line);
+      test_case.dtype = it->second;
+    }
+  }
+  return test_case;
+}
+
+// Creates the inputs like PyTorchOperatorTestCase does: the non contiguous
+// ones are every other element of tensors twice as large in every dimension.
+std::vector<at::Tensor> makeInputs(const TestCase& test_case, at::Device device) {
+  std::vector<at::Tensor> inputs;
+  const auto options = at::TensorOptions(device).dtype(test_case.dtype);
+  for (const auto& shape : test_case.shapes) {
+    auto sizes = shape;
+    if (!test_case.contig) {
+      for (auto& size : sizes) {
+        size *= 2;
+      }
+    }
+    at::Tensor input;
+    if (test_case.dtype == at::kFloat || test_case.dtype == at::kDouble) {
+      input = at::rand(sizes, options);
+    } else if (!at::isFloatingType(test_case.dtype)) {
+      input = at::randint(0, 100, sizes, options);
+    } else {
+      input = at::ones(sizes, options);
+    }
+    if (!test_case.contig) {
+      for (size_t dim = 0; dim < sizes.size(); ++dim) {
+        input = input.slice(dim, 0, sizes[dim], 2);
+      }
+    }
+    inputs.push_back(input);
+  }
+  return inputs;
+}
+
+void synchronize(at::Device device) {
+#ifdef USE_CUDA
+  if (device.is_cuda()) {
+    c10::cuda::getCurrentCUDAStream(device.index()).synchronize();
+  }
+#endif
+}
+
+std::string benchmarkName(
+    const std::string& line,
+    const TestCase& test_case,
+    int threads,
+    const std::string& device) {
+  std::stringstream name;
+  name << test_case.name << "/" << split(line, ' ')[2] << "/contig:"
+       << test_case.contig << "/dtype:" << at::toString(test_case.dtype)
+       << "/threads:" << threads << "/device:" << device;
+  return name.str();
+}
+
+// Removes `--name=value` from the arguments and returns the value, or
+// `default_value` if it isn't given.
+std::string takeFlag(
+    int* argc,
+    char** argv,
+    const std::string& name,
+    const std::string& default_value) {
+  const auto prefix = "--" + name + "=";
+  std::string value = default_value;
+  int kept = 1;
+  for (int i = 1; i < *argc; ++i) {
+    if (std::strncmp(argv[i], prefix.c_str(), prefix.size()) == 0) {
+      value = argv[i] + prefix.size();
+    } else {
+      argv[kept++] = argv[i];
+    }
+  }
+  *argc = kept;
+  return value;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const auto configs = takeFlag(&argc, argv, "configs", "");
+  const auto run_mode = takeFlag(&argc, argv, "run_mode", "short");
+  const auto threads = split(takeFlag(&argc, argv, "threads", "1"), ',');
+  const auto devices = split(takeFlag(&argc, argv, "devices", "cpu"), ',');
+  benchmark::Initialize(&argc, argv);
+  if (configs.empty()) {
+    std::cerr << "Usage: " << argv[0]
+              << " --configs=FILE [--run_mode=short|long] [--threads=1,4]"
+              << " [--devices=cpu,cuda] [benchmark flags]" << std::endl;
+    return 1;
+  }
+
+  std::ifstream file(configs);
+  AT_CHECK(file, "Couldn't open ", configs);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    const auto test_case = parseTestCase(line);
+    // Like the Python runner, the long mode also runs the short test cases
+    if (run_mode == "short" && test_case.run_mode != "short") {
+      continue;
+    }
+    const auto op = ops().find(test_case.name);
+    if (op == ops().end()) {
+      std::cerr << "Skipping " << test_case.name
+                << ", which has no C++ implementation" << std::endl;
+      continue;
+    }
+    for (const auto& device_name : devices) {
+      const at::Device device(device_name);
+      if (device.is_cuda() && !at::hasCUDA()) {
+        continue;
+      }
+      for (const auto& thread_count : threads) {
+        const int num_threads = std::stoi(thread_count);
+        benchmark::RegisterBenchmark(
+            benchmarkName(line, test_case, num_threads, device_name).c_str(),
+            [test_case, device, num_threads, op](benchmark::State& state) {
+              at::set_num_threads(num_threads);
+              auto inputs = makeInputs(test_case, device);
+              while (state.KeepRunning()) {
+                benchmark::DoNotOptimize(op->second(inputs));
+                synchronize(device);
+              }
+            });
+      }
+    }
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,84 @@
+#include <torch/data.h>
+#include <torch/types.h>
+
+#include <c10/util/Flags.h>
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+C10_DEFINE_string(
+    workers,
+    "1,2,4,8,16",
+    "Comma-separated list of worker counts to measure.");
+C10_DEFINE_int(examples, 100000, "The number of examples per epoch.");
+C10_DEFINE_int(batch_size, 4, "The batch size.");
+C10_DEFINE_int(example_size, 16, "The number of floats per example.");
+C10_DEFINE_int(repeat, 3, "The number of epochs to measure per worker count.");
+
+namespace {
+// Returns small, constant examples, so the time is dominated by the
+// DataLoader's own overhead rather than by the dataset.
+class ConstantDataset
+    : public torch::data::datasets::Dataset<ConstantDataset> {
+ public:
+  ConstantDataset(size_t size, int64_t example_size)
+      : size_(size),
+        data_(torch::ones({example_size})),
+        target_(torch::zeros({1})) {}
+
+  torch::data::Example<> get(size_t /* index */) override {
+    return {data_, target_};
+  }
+
+  torch::optional<size_t> size() const override {
+    return size_;
+  }
+
+ private:
+  size_t size_;
+  torch::Tensor data_;
+  torch::Tensor target_;
+};
+
+std::vector<size_t> parse_workers(const std::string& list) {
+  std::vector<size_t> workers;
+  std::istringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    workers.push_back(std::stoul(item));
+  }
+  return workers;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  c10::ParseCommandLineFlags(&argc, &argv);
+  ConstantDataset dataset(FLAGS_examples, FLAGS_example_size);
+
+  for (const auto workers : parse_workers(FLAGS_workers)) {
+    auto loader = torch::data::make_data_loader(
+        dataset,
+        torch::data::DataLoaderOptions(FLAGS_batch_size).workers(workers));
+    for (int iter_id = 0; iter_id < FLAGS_repeat; ++iter_id) {
+      const auto start = std::chrono::steady_clock::now();
+      size_t batches = 0;
+      for (auto& batch : *loader) {
+        (void)batch;
+        ++batches;
+      }
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      printf(
+          "Workers %3zu iteration %03d, took %4.5f seconds, "
+          "throughput %f batches/sec.\n",
+          workers,
+          iter_id,
+          elapsed.count(),
+          batches / elapsed.count());
+    }
+  }
+  return 0;
+}
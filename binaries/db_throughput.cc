@@ -32,6 +32,10 @@ C10_DEFINE_int(
     num_read_threads,
     1,
     "The number of concurrent reading threads.");
+C10_DEFINE_int(
+    readahead,
+    0,
+    "If positive, the reader reads this many records ahead on an I/O thread.");
 
 using caffe2::db::Cursor;
 using caffe2::db::DB;
@@ -82,6 +86,9 @@ void TestThroughputWithReaderWorker(const DBReader* reader, int thread_id) {
 
 void TestThroughputWithReader() {
   caffe2::db::DBReader reader(FLAGS_input_db_type, FLAGS_input_db);
+  if (FLAGS_readahead > 0) {
+    reader.EnableReadahead(FLAGS_readahead);
+  }
   std::vector<std::unique_ptr<std::thread>> reading_threads(
       FLAGS_num_read_threads);
   for (int i = 0; i < reading_threads.size(); ++i) {
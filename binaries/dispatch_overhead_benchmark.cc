@@ -0,0 +1,199 @@
+// Measures the framework overhead of calling a trivial op through each layer
+// of the C++ dispatch path, so that per-op overhead regressions show up as a
+// number rather than as a slower model.
+
+#include "benchmark/benchmark.h"
+
+#include <ATen/ATen.h>
+#include <ATen/core/dispatch/Dispatcher.h>
+#include <ATen/core/op_registration/op_registration.h>
+#include <torch/csrc/jit/interpreter.h>
+#include <torch/csrc/jit/ir.h>
+#include <torch/csrc/jit/irparser.h>
+#include <torch/torch.h>
+
+#include <sstream>
+#include <string>
+
+namespace {
+
+at::Tensor identity(at::Tensor self) {
+  return self;
+}
+
+// A kernel that does no work, so that calling it only measures the boxing,
+// the kernel lookup and the call through the dispatcher.
+auto registry = c10::RegisterOperators().op(
+    "_benchmark::identity(Tensor self) -> Tensor",
+    c10::kernel<decltype(identity), &identity>(),
+    c10::dispatchKey(c10::CPUTensorId()));
+
+c10::OperatorHandle identityOp() {
+  auto op =
+      c10::Dispatcher::singleton().findSchema("_benchmark::identity", "");
+  AT_CHECK(op.has_value(), "_benchmark::identity is not registered");
+  return *op;
+}
+
+// Returns a graph of num_nodes chained nodes of the given op and type, e.g.
+// aten::add on ints, taking two inputs of that type.
+std::shared_ptr<torch::jit::Graph> chainGraph(
+    int num_nodes,
+    const std::string& type,
+    const std::string& node) {
+  std::stringstream ir;
+  ir << "graph(%x0 : " << type << ", %y : " << type << "):\n";
+  // Tensor adds also take alpha
+  const bool tensor = type == "Tensor";
+  if (tensor) {
+    ir << "  %one : int = prim::Constant[value=1]()\n";
+  }
+  for (int i = 0; i < num_nodes; ++i) {
+    ir << "  %x" << i + 1 << " : " << type << " = " << node << "(%x" << i
+       << ", %y" << (tensor ? ", %one" : "") << ")\n";
+  }
+  ir << "  return (%x" << num_nodes << ")\n";
+  auto graph = std::make_shared<torch::jit::Graph>();
+  torch::jit::script::parseIR(ir.str(), graph.get());
+  return graph;
+}
+
+} // namespace
+
+static void BM_EmptyTensor(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(at::empty({0}));
+  }
+}
+BENCHMARK(BM_EmptyTensor);
+
+static void BM_EmptyVariable(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(torch::empty({0}));
+  }
+}
+BENCHMARK(BM_EmptyVariable);
+
+// at::Tensor method -> LegacyTypeDispatch -> CPU kernel
+static void BM_AddTensor(benchmark::State& state) {
+  auto a = at::ones({1});
+  auto b = at::ones({1});
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(a.add(b));
+  }
+}
+BENCHMARK(BM_AddTensor);
+
+// Same as above, through VariableType without recording a graph.
+static void BM_AddVariable(benchmark::State& state) {
+  auto a = torch::ones({1});
+  auto b = torch::ones({1});
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(a.add(b));
+  }
+}
+BENCHMARK(BM_AddVariable);
+
+// Same as above, also recording the autograd graph.
+static void BM_AddVariableRequiresGrad(benchmark::State& state) {
+  auto a = torch::ones({1}, torch::requires_grad());
+  auto b = torch::ones({1}, torch::requires_grad());
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(a.add(b));
+  }
+}
+BENCHMARK(BM_AddVariableRequiresGrad);
+
+static void BM_AddVariableNoGradGuard(benchmark::State& state) {
+  auto a = torch::ones({1}, torch::requires_grad());
+  auto b = torch::ones({1}, torch::requires_grad());
+  torch::NoGradGuard no_grad;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(a.add(b));
+  }
+}
+BENCHMARK(BM_AddVariableNoGradGuard);
+
+// IValue stack -> Dispatcher::lookup -> boxed kernel call
+static void BM_DispatcherCall(benchmark::State& state) {
+  const auto op = identityOp();
+  auto self = at::ones({1});
+  torch::jit::Stack stack;
+  while (state.KeepRunning()) {
+    stack.clear();
+    stack.emplace_back(self);
+    auto kernel = c10::Dispatcher::singleton().lookup(op, &stack);
+    kernel.call(&stack);
+    benchmark::DoNotOptimize(stack);
+  }
+}
+BENCHMARK(BM_DispatcherCall)->ThreadRange(1, 64);
+
+// Same as above with the kernel looked up once, as callers holding on to an
+// OpKernel do.
+static void BM_DispatcherCallCachedKernel(benchmark::State& state) {
+  const auto op = identityOp();
+  auto self = at::ones({1});
+  torch::jit::Stack stack;
+  stack.emplace_back(self);
+  auto kernel = c10::Dispatcher::singleton().lookup(op, &stack);
+  while (state.KeepRunning()) {
+    stack.clear();
+    stack.emplace_back(self);
+    kernel.call(&stack);
+    benchmark::DoNotOptimize(stack);
+  }
+}
+BENCHMARK(BM_DispatcherCallCachedKernel);
+
+// Same as above with a CachedOpKernel, which also checks whether the
+// dispatch key or the registered kernels changed since the last call.
+static void BM_DispatcherCallCachedOpKernel(benchmark::State& state) {
+  c10::CachedOpKernel kernel(identityOp());
+  auto self = at::ones({1});
+  torch::jit::Stack stack;
+  while (state.KeepRunning()) {
+    stack.clear();
+    stack.emplace_back(self);
+    kernel.call(&stack);
+    benchmark::DoNotOptimize(stack);
+  }
+}
+BENCHMARK(BM_DispatcherCallCachedOpKernel)->ThreadRange(1, 64);
+
+// Per node cost of the JIT interpreter on integer adds, which do almost no
+// work themselves.
+static void BM_InterpreterIntAdd(benchmark::State& state) {
+  const int num_nodes = state.range(0);
+  torch::jit::Code code(chainGraph(num_nodes, "int", "aten::add"));
+  torch::jit::Stack stack;
+  while (state.KeepRunning()) {
+    stack.clear();
+    stack.emplace_back(int64_t(0));
+    stack.emplace_back(int64_t(1));
+    torch::jit::InterpreterState(code).run(stack);
+    benchmark::DoNotOptimize(stack);
+  }
+  state.SetItemsProcessed(state.iterations() * num_nodes);
+}
+BENCHMARK(BM_InterpreterIntAdd)->Arg(1)->Arg(16)->Arg(256);
+
+// Per node cost of the JIT interpreter on 1-element tensor adds.
+static void BM_InterpreterTensorAdd(benchmark::State& state) {
+  const int num_nodes = state.range(0);
+  torch::jit::Code code(chainGraph(num_nodes, "Tensor", "aten::add"));
+  auto x = torch::ones({1});
+  auto y = torch::ones({1});
+  torch::jit::Stack stack;
+  while (state.KeepRunning()) {
+    stack.clear();
+    stack.emplace_back(x);
+    stack.emplace_back(y);
+    torch::jit::InterpreterState(code).run(stack);
+    benchmark::DoNotOptimize(stack);
+  }
+  state.SetItemsProcessed(state.iterations() * num_nodes);
+}
+BENCHMARK(BM_InterpreterTensorAdd)->Arg(1)->Arg(16)->Arg(256);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,95 @@
+#include <torch/nn/module.h>
+#include <torch/nn/modules/embedding.h>
+#include <torch/nn/modules/linear.h>
+#include <torch/nn/parallel/hogwild.h>
+#include <torch/optim/sgd.h>
+#include <torch/types.h>
+
+#include <ATen/Parallel.h>
+#include <c10/util/Flags.h>
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+C10_DEFINE_string(
+    threads,
+    "1,2,4,8,16",
+    "Comma-separated list of Hogwild thread counts to measure.");
+C10_DEFINE_int(steps, 2000, "The number of steps per thread.");
+C10_DEFINE_int(batch_size, 32, "The batch size.");
+C10_DEFINE_int(embeddings, 100000, "The number of rows of the embedding.");
+C10_DEFINE_int(embedding_dim, 64, "The size of the embeddings.");
+C10_DEFINE_bool(
+    atomic_sparse_updates,
+    true,
+    "Whether to update the embedding with atomic operations.");
+
+namespace {
+// An embedding bag followed by a linear layer, the typical shape of a
+// recommendation model, whose sparse updates rarely collide.
+struct Net : torch::nn::Module {
+  Net(int64_t embeddings, int64_t embedding_dim)
+      : embedding(register_module(
+            "embedding",
+            torch::nn::Embedding(
+                torch::nn::EmbeddingOptions(embeddings, embedding_dim)
+                    .sparse(true)))),
+        linear(register_module("linear", torch::nn::Linear(embedding_dim, 1))) {}
+
+  torch::Tensor forward(torch::Tensor indices) {
+    return linear->forward(embedding->forward(indices).sum(1));
+  }
+
+  torch::nn::Embedding embedding;
+  torch::nn::Linear linear;
+};
+
+std::vector<size_t> parse_threads(const std::string& list) {
+  std::vector<size_t> threads;
+  std::istringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    threads.push_back(std::stoul(item));
+  }
+  return threads;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  c10::ParseCommandLineFlags(&argc, &argv);
+  // every Hogwild thread keeps a core busy on its own
+  at::set_num_threads(1);
+  auto net = std::make_shared<Net>(FLAGS_embeddings, FLAGS_embedding_dim);
+
+  for (const auto threads : parse_threads(FLAGS_threads)) {
+    const auto start = std::chrono::steady_clock::now();
+    torch::nn::parallel::hogwild(
+        net, threads, [](size_t /*index*/, std::shared_ptr<Net> replica) {
+          torch::optim::SGD optimizer(
+              replica->parameters(),
+              torch::optim::SGDOptions(0.01).atomic_sparse_updates(
+                  FLAGS_atomic_sparse_updates));
+          for (int step = 0; step < FLAGS_steps; ++step) {
+            const auto indices = torch::randint(
+                FLAGS_embeddings, {FLAGS_batch_size, 8}, torch::kLong);
+            const auto target = torch::randn({FLAGS_batch_size, 1});
+            optimizer.zero_grad();
+            torch::mse_loss(replica->forward(indices), target).backward();
+            optimizer.step();
+          }
+        });
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    const double examples =
+        static_cast<double>(threads) * FLAGS_steps * FLAGS_batch_size;
+    printf(
+        "Threads %3zu, took %4.5f seconds, throughput %f examples/sec.\n",
+        threads,
+        elapsed.count(),
+        examples / elapsed.count());
+  }
+  return 0;
+}
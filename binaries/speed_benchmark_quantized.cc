@@ -0,0 +1,129 @@
+// Times one quantized:: ATen operator on random inputs, like speed_benchmark
+// times a Caffe2 net, e.g. to compare the QNNPACK kernels of the ARM builds
+// with the Caffe2 Int8 operators on a phone:
+//
+//   speed_benchmark_quantized --op=conv2d --input_dims=1,32,56,56 \
+//     --output_channels=64 --kernel=3 --padding=1 --iter=50
+
+#include <ATen/ATen.h>
+#include <ATen/core/dispatch/Dispatcher.h>
+#include <ATen/core/stack.h>
+
+#include <c10/util/Flags.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+C10_DEFINE_string(
+    op,
+    "conv2d",
+    "The quantized operator to benchmark: conv2d, linear, add, max_pool2d "
+    "or avg_pool2d.");
+C10_DEFINE_string(
+    input_dims,
+    "1,32,56,56",
+    "The dimensions of the input, separated by commas: NCHW for conv2d and "
+    "the pooling, [..., K] for linear.");
+C10_DEFINE_int(
+    output_channels,
+    32,
+    "The output channels of conv2d, or the output features of linear.");
+C10_DEFINE_int(kernel, 3, "The kernel size of conv2d and the pooling.");
+C10_DEFINE_int(stride, 1, "The stride of conv2d and the pooling.");
+C10_DEFINE_int(padding, 0, "The padding of conv2d and the pooling.");
+C10_DEFINE_int(groups, 1, "The groups of conv2d.");
+C10_DEFINE_int(warmup, 0, "The number of iterations to warm up.");
+C10_DEFINE_int(iter, 10, "The number of iterations to run.");
+
+namespace {
+
+std::vector<int64_t> parseDims(const std::string& str) {
+  std::vector<int64_t> dims;
+  size_t begin = 0;
+  while (begin < str.size()) {
+    size_t end = str.find(',', begin);
+    if (end == std::string::npos) {
+      end = str.size();
+    }
+    dims.push_back(std::stoll(str.substr(begin, end - begin)));
+    begin = end + 1;
+  }
+  return dims;
+}
+
+at::Tensor quantizedRandn(at::IntArrayRef sizes) {
+  return at::randn(sizes).quantize_linear(/*scale=*/0.05, /*zero_point=*/128);
+}
+
+c10::OperatorHandle findOp(const std::string& name) {
+  auto op = c10::Dispatcher::singleton().findSchema(name.c_str(), "");
+  AT_CHECK(op.has_value(), name, " is not registered");
+  return *op;
+}
+
+// Calls the operator on the boxed arguments and returns its output.
+at::Tensor callOp(const c10::OperatorHandle& op, const torch::jit::Stack& args) {
+  torch::jit::Stack stack = args;
+  auto kernel = c10::Dispatcher::singleton().lookup(op, &stack);
+  kernel.call(&stack);
+  return stack.back().toTensor();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  c10::SetUsageMessage("Times a quantized ATen operator.");
+  if (!c10::ParseCommandLineFlags(&argc, &argv)) {
+    std::cerr << "Failed to parse command line flags." << std::endl;
+    return 1;
+  }
+
+  const std::vector<int64_t> dims = parseDims(FLAGS_input_dims);
+  const std::vector<int64_t> kernel = {FLAGS_kernel, FLAGS_kernel};
+  const std::vector<int64_t> stride = {FLAGS_stride, FLAGS_stride};
+  const std::vector<int64_t> padding = {FLAGS_padding, FLAGS_padding};
+  const std::vector<int64_t> dilation = {1, 1};
+  at::Tensor qx = quantizedRandn(dims);
+
+  // The weights are prepacked once, outside of the timed calls.
+  c10::OperatorHandle op = findOp("quantized::" + FLAGS_op);
+  torch::jit::Stack args;
+  if (FLAGS_op == "conv2d") {
+    AT_CHECK(dims.size() == 4, "conv2d expects NCHW input_dims");
+    at::Tensor qw = quantizedRandn(
+        {FLAGS_output_channels, dims[1] / FLAGS_groups, FLAGS_kernel, FLAGS_kernel});
+    at::Tensor packed = callOp(
+        findOp("quantized::conv2d_prepack"), {qw, int64_t(FLAGS_groups)});
+    args = {qx, packed, at::randn({FLAGS_output_channels}), stride, padding,
+            dilation, 1.0, int64_t(128)};
+  } else if (FLAGS_op == "linear") {
+    at::Tensor qw = quantizedRandn({FLAGS_output_channels, dims.back()});
+    at::Tensor packed = callOp(findOp("quantized::linear_prepack"), {qw});
+    args = {qx, packed, at::randn({FLAGS_output_channels}), 1.0, int64_t(128)};
+  } else if (FLAGS_op == "add") {
+    args = {qx, quantizedRandn(dims), 0.1, int64_t(128)};
+  } else if (FLAGS_op == "max_pool2d") {
+    args = {qx, kernel, stride, padding, dilation};
+  } else if (FLAGS_op == "avg_pool2d") {
+    args = {qx, kernel, stride, padding};
+  } else {
+    AT_ERROR("Unknown op ", FLAGS_op);
+  }
+
+  for (int i = 0; i < FLAGS_warmup; ++i) {
+    callOp(op, args);
+  }
+  const auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < FLAGS_iter; ++i) {
+    callOp(op, args);
+  }
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::high_resolution_clock::now() - start;
+  std::cout << "Main run finished. Milliseconds per iter: "
+            << elapsed.count() / FLAGS_iter
+            << ". Iters per second: " << 1000.0 * FLAGS_iter / elapsed.count()
+            << std::endl;
+  return 0;
+}
@@ -0,0 +1,278 @@
+// Measures the end-to-end latency and throughput of a TorchScript module,
+// the way speed_benchmark measures a Caffe2 net, e.g.
+//
+//   speed_benchmark_torch --model=resnet18.pt --input_dims=1,3,224,224 \
+//       --input_type=float --threads=1,4 --concurrency=1,2 --profile
+//
+// For every number of intra-op threads and every number of concurrent
+// callers, the callers run `forward` on the same module, and the latency
+// percentiles of the calls, the throughput and the peak memory allocated
+// during the calls are reported. With --profile, a final single caller run
+// is profiled and the time spent per op and input shapes is printed.
+
+#include <torch/script.h>
+#include <torch/csrc/autograd/profiler.h>
+
+#include <ATen/Parallel.h>
+#include <c10/core/Allocator.h>
+#include <c10/util/Flags.h>
+#ifdef USE_CUDA
+#include <c10/cuda/CUDACachingAllocator.h>
+#include <c10/cuda/CUDAStream.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+C10_DEFINE_string(model, "", "The TorchScript archive to benchmark.");
+C10_DEFINE_string(
+    input_dims,
+    "",
+    "The sizes of the inputs of forward, with dimensions separated by "
+    "commas and inputs by semicolons, e.g. 1,3,224,224;1,10.");
+C10_DEFINE_string(
+    input_type,
+    "float",
+    "The types of the inputs (float, double, half, int64, int32 or uint8), "
+    "separated by semicolons. A single type applies to all the inputs.");
+C10_DEFINE_string(device, "cpu", "The device of the module and the inputs.");
+C10_DEFINE_int(warmup, 10, "The number of calls per caller before timing.");
+C10_DEFINE_int(iter, 100, "The number of timed calls per caller.");
+C10_DEFINE_string(
+    threads,
+    "1",
+    "Comma-separated list of intra-op thread counts to measure.");
+C10_DEFINE_string(
+    concurrency,
+    "1",
+    "Comma-separated list of numbers of concurrent callers to measure.");
+C10_DEFINE_bool(profile, false, "Print the time spent per op.");
+C10_DEFINE_int(profile_top, 20, "The number of ops --profile prints.");
+
+namespace {
+std::vector<std::string> split(const std::string& text, char separator) {
+  std::vector<std::string> parts;
+  std::istringstream stream(text);
+  std::string part;
+  while (std::getline(stream, part, separator)) {
+    parts.push_back(part);
+  }
+  return parts;
+}
+
+std::vector<int> parse_counts(const std::string& list) {
+  std::vector<int> counts;
+  for (const auto& item : split(list, ',')) {
+    counts.push_back(std::stoi(item));
+    AT_CHECK(counts.back() > 0, "Invalid count ", item, " in ", list);
+  }
+  return counts;
+}
+
+at::ScalarType parse_type(const std::string& name) {
+  if (name == "float") {
+    return at::kFloat;
+  } else if (name == "double") {
+    return at::kDouble;
+  } else if (name == "half") {
+    return at::kHalf;
+  } else if (name == "int64") {
+    return at::kLong;
+  } else if (name == "int32") {
+    return at::kInt;
+  } else if (name == "uint8") {
+    return at::kByte;
+  }
+  AT_ERROR("Unsupported input type: ", name);
+}
+
+std::vector<torch::jit::IValue> make_inputs(at::Device device) {
+  const auto dims = split(FLAGS_input_dims, ';');
+  const auto types = split(FLAGS_input_type, ';');
+  AT_CHECK(
+      types.size() == 1 || types.size() == dims.size(),
+      "--input_type must give one type, or one type per input");
+  std::vector<torch::jit::IValue> inputs;
+  for (size_t i = 0; i < dims.size(); ++i) {
+    std::vector<int64_t> sizes;
+    for (const auto& size : split(dims[i], ',')) {
+      sizes.push_back(std::stoll(size));
+    }
+    const auto type = parse_type(types.size() == 1 ? types[0] : types[i]);
+    const auto options = torch::TensorOptions(device).dtype(type);
+    if (at::isFloatingType(type)) {
+      inputs.emplace_back(torch::rand(sizes, options));
+    } else {
+      inputs.emplace_back(torch::randint(0, 100, sizes, options));
+    }
+  }
+  return inputs;
+}
+
+void synchronize(at::Device device) {
+#ifdef USE_CUDA
+  if (device.is_cuda()) {
+    c10::cuda::getCurrentCUDAStream(device.index()).synchronize();
+  }
+#endif
+}
+
+// The bytes allocated on the CPU by the calls, tracked through the memory
+// event hook of the allocators.
+std::atomic<int64_t> cpu_allocated{0};
+std::atomic<int64_t> cpu_peak{0};
+
+void record_memory_event(void* /* ptr */, int64_t nbytes, c10::Device device) {
+  if (!device.is_cpu()) {
+    return;
+  }
+  const auto allocated = cpu_allocated += nbytes;
+  auto peak = cpu_peak.load();
+  while (allocated > peak && !cpu_peak.compare_exchange_weak(peak, allocated)) {
+  }
+}
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+  const auto index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+  return sorted[index];
+}
+
+void run(
+    torch::jit::script::Module& module,
+    at::Device device,
+    int threads,
+    int concurrency) {
+  at::set_num_threads(threads);
+  std::vector<std::vector<double>> latencies(concurrency);
+  auto caller = [&](int id) {
+    at::set_num_threads(threads);
+    torch::NoGradGuard guard;
+    auto inputs = make_inputs(device);
+    for (int i = 0; i < FLAGS_warmup; ++i) {
+      module.forward(inputs);
+    }
+    synchronize(device);
+    for (int i = 0; i < FLAGS_iter; ++i) {
+      const auto start = std::chrono::steady_clock::now();
+      module.forward(inputs);
+      synchronize(device);
+      const std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+      latencies[id].push_back(elapsed.count());
+    }
+  };
+
+  // The warmup calls of the callers overlap with the timed calls of the
+  // others, so the wall time is measured around all of them and the
+  // throughput is a lower bound when the warmup isn't negligible.
+#ifdef USE_CUDA
+  if (device.is_cuda()) {
+    c10::cuda::CUDACachingAllocator::resetMaxMemoryAllocated(device.index());
+  }
+#endif
+  cpu_allocated = 0;
+  cpu_peak = 0;
+  c10::SetMemoryEventHook(record_memory_event);
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> callers;
+  for (int id = 0; id < concurrency; ++id) {
+    callers.emplace_back(caller, id);
+  }
+  for (auto& thread : callers) {
+    thread.join();
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  c10::SetMemoryEventHook(nullptr);
+
+  std::vector<double> all;
+  for (const auto& caller_latencies : latencies) {
+    all.insert(all.end(), caller_latencies.begin(), caller_latencies.end());
+  }
+  std::sort(all.begin(), all.end());
+  int64_t peak_bytes = cpu_peak;
+#ifdef USE_CUDA
+  if (device.is_cuda()) {
+    peak_bytes =
+        c10::cuda::CUDACachingAllocator::maxMemoryAllocated(device.index());
+  }
+#endif
+  printf(
+      "Threads %3d concurrency %3d: p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, "
+      "throughput %.2f calls/sec, peak memory %.2f MB.\n",
+      threads,
+      concurrency,
+      percentile(all, 0.5),
+      percentile(all, 0.9),
+      percentile(all, 0.99),
+      (FLAGS_warmup + FLAGS_iter) * concurrency / elapsed.count(),
+      peak_bytes / (1024.0 * 1024.0));
+}
+
+void profile(torch::jit::script::Module& module, at::Device device) {
+  using namespace torch::autograd::profiler;
+  torch::NoGradGuard guard;
+  auto inputs = make_inputs(device);
+  module.forward(inputs);
+  synchronize(device);
+  enableProfiler(ProfilerConfig(
+      ProfilerState::CPU,
+      /*report_input_shapes=*/true,
+      /*profile_memory=*/true));
+  for (int i = 0; i < FLAGS_iter; ++i) {
+    module.forward(inputs);
+  }
+  synchronize(device);
+  const auto stats = aggregateByInputShapes(disableProfiler());
+
+  printf("%-32s %-40s %8s %12s %12s\n", "Op", "Shapes", "Calls", "us/iter",
+         "KB/iter");
+  const auto count = std::min<size_t>(stats.size(), FLAGS_profile_top);
+  for (size_t i = 0; i < count; ++i) {
+    std::ostringstream shapes;
+    for (size_t j = 0; j < stats[i].shapes.size(); ++j) {
+      shapes << (j == 0 ? "" : ",") << "[";
+      for (size_t k = 0; k < stats[i].shapes[j].size(); ++k) {
+        shapes << (k == 0 ? "" : "x") << stats[i].shapes[j][k];
+      }
+      shapes << "]";
+    }
+    printf(
+        "%-32s %-40s %8lld %12.2f %12.2f\n",
+        stats[i].name.c_str(),
+        shapes.str().c_str(),
+        static_cast<long long>(stats[i].count),
+        stats[i].cpu_time_us / FLAGS_iter,
+        stats[i].allocated_bytes / 1024.0 / FLAGS_iter);
+  }
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  c10::ParseCommandLineFlags(&argc, &argv);
+  if (FLAGS_model.empty() || FLAGS_input_dims.empty()) {
+    fprintf(stderr, "Usage: %s --model=FILE --input_dims=DIMS [flags]\n",
+            argv[0]);
+    return 1;
+  }
+  const at::Device device(FLAGS_device);
+  auto module = torch::jit::load(FLAGS_model, device);
+  AT_CHECK(module != nullptr, "Couldn't load ", FLAGS_model);
+
+  for (const auto threads : parse_counts(FLAGS_threads)) {
+    for (const auto concurrency : parse_counts(FLAGS_concurrency)) {
+      run(*module, device, threads, concurrency);
+    }
+  }
+  if (FLAGS_profile) {
+    at::set_num_threads(parse_counts(FLAGS_threads).back());
+    profile(*module, device);
+  }
+  return 0;
+}
@@ -1,5 +1,7 @@
 #include <c10/core/Allocator.h>
 
+#include <atomic>
+
 namespace c10 {
 
 static void deleteInefficientStdFunctionContext(void* ptr) {
@@ -28,4 +30,14 @@ at::Allocator* GetAllocator(const at::DeviceType& t) {
   return alloc;
 }
 
+static std::atomic<MemoryEventHook> memory_event_hook{nullptr};
+
+void SetMemoryEventHook(MemoryEventHook hook) {
+  memory_event_hook = hook;
+}
+
+MemoryEventHook GetMemoryEventHook() {
+  return memory_event_hook.load(std::memory_order_relaxed);
+}
+
 } // namespace c10
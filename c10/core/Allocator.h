@@ -190,6 +190,14 @@ struct C10_API InefficientStdFunctionContext {
       Device device);
 };
 
+// Called by the allocators that report their activity (the default CPU
+// allocator and the CUDA caching allocator) for every allocation, with a
+// negative size for frees. The profiler uses it to put memory usage on its
+// timeline. Hooks may be called concurrently from any thread.
+using MemoryEventHook = void (*)(void* ptr, int64_t nbytes, Device device);
+C10_API void SetMemoryEventHook(MemoryEventHook hook);
+C10_API MemoryEventHook GetMemoryEventHook();
+
 /** Set the allocator for DeviceType `t`. The passed in allocator pointer is
  *  expected to have static lifetime; this function does NOT take ownership
  *  of the raw pointer. (The reason for this is to prevent existing pointers
@@ -26,7 +26,7 @@ namespace c10 {
  * or "SparseCUDA"; backend in torch.backends is something like "MKL" or
  * "CUDNN".
  */
-enum class Backend { CPU, CUDA, HIP, SparseCPU, SparseCUDA, SparseHIP, MSNPU, XLA, QuantizedCPU, ComplexCPU, ComplexCUDA, Undefined, MkldnnCPU, NumOptions };
+enum class Backend { CPU, CUDA, HIP, SparseCPU, SparseCUDA, SparseHIP, MSNPU, XLA, Vulkan, QuantizedCPU, ComplexCPU, ComplexCUDA, Undefined, MkldnnCPU, NumOptions };
 
 static inline Backend toSparse(Backend b) {
   switch (b) {
@@ -59,6 +59,8 @@ static inline Backend toDense(Backend b) {
       return Backend::MSNPU;
     case Backend::XLA:
       return Backend::XLA;
+    case Backend::Vulkan:
+      return Backend::Vulkan;
     case Backend::SparseCPU:
       return Backend::CPU;
     case Backend::SparseCUDA:
@@ -87,6 +89,8 @@ static inline Backend tensorTypeIdToBackend(TensorTypeId t) {
     return Backend::MSNPU;
   } else if (t == XLATensorId()) {
     return Backend::XLA;
+  } else if (t == VulkanTensorId()) {
+    return Backend::Vulkan;
   } else if (t == SparseCPUTensorId()) {
     return Backend::SparseCPU;
   } else if (t == SparseCUDATensorId()) {
@@ -120,6 +124,8 @@ static inline TensorTypeId backendToTensorTypeId(Backend b) {
       return MSNPUTensorId();
     case Backend::XLA:
       return XLATensorId();
+    case Backend::Vulkan:
+      return VulkanTensorId();
     case Backend::SparseCPU:
       return SparseCPUTensorId();
     case Backend::SparseCUDA:
@@ -153,6 +159,8 @@ static inline DeviceType backendToDeviceType(Backend b) {
       return DeviceType::MSNPU;
     case Backend::XLA:
       return DeviceType::XLA;
+    case Backend::Vulkan:
+      return DeviceType::VULKAN;
     case Backend::SparseCPU:
       return DeviceType::CPU;
     case Backend::SparseCUDA:
@@ -188,6 +196,7 @@ static inline Backend backendToCPU(Backend b) {
       return Backend::SparseCPU;
     case Backend::MSNPU:
     case Backend::XLA:
+    case Backend::Vulkan:
       return Backend::CPU;
     case Backend::MkldnnCPU:
       return Backend::MkldnnCPU;
@@ -210,6 +219,7 @@ static inline Backend backendToCUDA(Backend b) {
     case Backend::HIP:
     case Backend::MSNPU:
     case Backend::XLA:
+    case Backend::Vulkan:
       return Backend::CUDA;
     case Backend::SparseCPU:
     case Backend::SparseCUDA:
@@ -232,6 +242,7 @@ static inline Backend backendToHIP(Backend b) {
     case Backend::HIP:
     case Backend::MSNPU:
     case Backend::XLA:
+    case Backend::Vulkan:
       return Backend::HIP;
     case Backend::SparseCPU:
     case Backend::SparseCUDA:
@@ -256,6 +267,8 @@ static inline const char* toString(Backend b) {
       return "MSNPU";
     case Backend::XLA:
       return "XLA";
+    case Backend::Vulkan:
+      return "Vulkan";
     case Backend::SparseCPU:
       return "SparseCPU";
     case Backend::SparseCUDA:
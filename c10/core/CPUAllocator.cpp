@@ -1,5 +1,10 @@
 #include <c10/core/CPUAllocator.h>
 #include <c10/core/DeviceType.h>
+#include <c10/util/StaticTracepoint.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
 
 // TODO: rename flags to C10
 C10_DEFINE_bool(
@@ -17,6 +22,18 @@ C10_DEFINE_bool(
     false,
     "If set, fill memory with deterministic junk when allocating on CPU");
 
+C10_DEFINE_int64(
+    caffe2_cpu_numa_min_alloc_size,
+    0,
+    "If NUMA is enabled, smaller CPU allocations are left to the kernel's "
+    "first-touch placement instead of being moved to the allocation node");
+
+C10_DEFINE_int64(
+    caffe2_cpu_zeroed_alloc_min_size,
+    1 << 20,
+    "Zero-filled CPU allocations of at least this many bytes are mapped from "
+    "fresh pages, which the OS zeroes on first touch, instead of being filled");
+
 namespace c10 {
 
 void memset_junk(void* data, size_t num) {
@@ -46,13 +63,25 @@ void* alloc_cpu(size_t nbytes) {
     ((ptrdiff_t)nbytes) >= 0,
     "alloc_cpu() seems to have been called with negative number: ", nbytes);
 
+  int numa_node = GetAllocationNUMANode();
+  if (numa_node >= 0 &&
+      static_cast<int64_t>(nbytes) < FLAGS_caffe2_cpu_numa_min_alloc_size) {
+    numa_node = -1;
+  }
+  // Moving memory to a node moves whole pages, so page-align allocations
+  // spanning several pages to keep them from dragging their neighbours along.
+  size_t alignment = gAlignment;
+  if (numa_node >= 0 && nbytes >= 4 * GetNUMAPageSize()) {
+    alignment = GetNUMAPageSize();
+  }
+
   void* data;
 #ifdef __ANDROID__
-  data = memalign(gAlignment, nbytes);
+  data = memalign(alignment, nbytes);
 #elif defined(_MSC_VER)
-  data = _aligned_malloc(nbytes, gAlignment);
+  data = _aligned_malloc(nbytes, alignment);
 #else
-  CAFFE_ENFORCE_EQ(posix_memalign(&data, gAlignment, nbytes), 0);
+  CAFFE_ENFORCE_EQ(posix_memalign(&data, alignment, nbytes), 0);
 #endif
 
   CAFFE_ENFORCE(
@@ -60,8 +89,8 @@ void* alloc_cpu(size_t nbytes) {
       "DefaultCPUAllocator: not enough memory: you tried to allocate %dGB. Buy new RAM!",
       nbytes / 1073741824);
 
-  // move data to a thread's NUMA node
-  NUMAMove(data, nbytes, GetCurrentNUMANode());
+  // move data to the requested or the thread's NUMA node
+  NUMAMove(data, nbytes, numa_node);
   CHECK(
       !FLAGS_caffe2_cpu_allocator_do_zero_fill ||
       !FLAGS_caffe2_cpu_allocator_do_junk_fill)
@@ -72,10 +101,12 @@ void* alloc_cpu(size_t nbytes) {
     memset_junk(data, nbytes);
   }
 
+  C10_SDT(cpu_alloc, data, nbytes);
   return data;
 }
 
 void free_cpu(void* data) {
+  C10_SDT(cpu_free, data);
 #ifdef _MSC_VER
   _aligned_free(data);
 #else
@@ -83,6 +114,54 @@ void free_cpu(void* data) {
 #endif
 }
 
+#ifndef _WIN32
+namespace {
+
+struct ZeroedMapping {
+  void* data;
+  size_t nbytes;
+};
+
+void free_zeroed_mapping(void* ctx) {
+  auto* mapping = static_cast<ZeroedMapping*>(ctx);
+  C10_SDT(cpu_free, mapping->data);
+  munmap(mapping->data, mapping->nbytes);
+  delete mapping;
+}
+
+} // namespace
+#endif
+
+at::DataPtr try_alloc_zeroed_cpu(size_t nbytes) {
+#ifdef _WIN32
+  return {};
+#else
+  if (nbytes == 0 ||
+      static_cast<int64_t>(nbytes) < FLAGS_caffe2_cpu_zeroed_alloc_min_size ||
+      GetCPUAllocator() != GetDefaultCPUAllocator() ||
+      FLAGS_caffe2_report_cpu_memory_usage || GetMemoryEventHook()) {
+    return {};
+  }
+  void* data = mmap(
+      nullptr,
+      nbytes,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS,
+      /*fd=*/-1,
+      /*offset=*/0);
+  if (data == MAP_FAILED) {
+    return {};
+  }
+  // the pages aren't populated yet, so this only sets where they will be
+  NUMAMove(data, nbytes, GetAllocationNUMANode());
+  C10_SDT(cpu_alloc, data, nbytes);
+  return {data,
+          new ZeroedMapping{data, nbytes},
+          &free_zeroed_mapping,
+          at::Device(at::DeviceType::CPU)};
+#endif
+}
+
 // A virtual struct that is used to report C10's memory allocation and
 // deallocation status
 class C10_API MemoryAllocationReporter {
@@ -102,7 +181,7 @@ struct C10_API DefaultCPUAllocator final : at::Allocator {
   ~DefaultCPUAllocator() override {}
   at::DataPtr allocate(size_t nbytes) const override {
     void* data = alloc_cpu(nbytes);
-    if (FLAGS_caffe2_report_cpu_memory_usage && nbytes > 0) {
+    if (reporting() && nbytes > 0) {
       getMemoryAllocationReporter().New(data, nbytes);
       return {data, data, &ReportAndDelete, at::Device(at::DeviceType::CPU)};
     }
@@ -118,13 +197,17 @@ struct C10_API DefaultCPUAllocator final : at::Allocator {
   }
 
   at::DeleterFnPtr raw_deleter() const override {
-    if (FLAGS_caffe2_report_cpu_memory_usage) {
+    if (reporting()) {
       return &ReportAndDelete;
     }
     return &free_cpu;
   }
 
  protected:
+  static bool reporting() {
+    return FLAGS_caffe2_report_cpu_memory_usage || GetMemoryEventHook();
+  }
+
   static MemoryAllocationReporter& getMemoryAllocationReporter() {
     static MemoryAllocationReporter reporter_;
     return reporter_;
@@ -155,17 +238,32 @@ void MemoryAllocationReporter::New(void* ptr, size_t nbytes) {
   std::lock_guard<std::mutex> guard(mutex_);
   size_table_[ptr] = nbytes;
   allocated_ += nbytes;
-  LOG(INFO) << "C10 alloc " << nbytes << " bytes, total alloc " << allocated_
-            << " bytes.";
+  if (FLAGS_caffe2_report_cpu_memory_usage) {
+    LOG(INFO) << "C10 alloc " << nbytes << " bytes, total alloc "
+              << allocated_ << " bytes.";
+  }
+  if (auto hook = GetMemoryEventHook()) {
+    hook(ptr, static_cast<int64_t>(nbytes), Device(DeviceType::CPU));
+  }
 }
 
 void MemoryAllocationReporter::Delete(void* ptr) {
   std::lock_guard<std::mutex> guard(mutex_);
   auto it = size_table_.find(ptr);
-  CHECK(it != size_table_.end());
+  if (it == size_table_.end()) {
+    // raw allocations made before the memory event hook was set are freed
+    // through here once it is set
+    CHECK(!FLAGS_caffe2_report_cpu_memory_usage);
+    return;
+  }
   allocated_ -= it->second;
-  LOG(INFO) << "C10 deleted " << it->second << " bytes, total alloc "
-            << allocated_ << " bytes.";
+  if (FLAGS_caffe2_report_cpu_memory_usage) {
+    LOG(INFO) << "C10 deleted " << it->second << " bytes, total alloc "
+              << allocated_ << " bytes.";
+  }
+  if (auto hook = GetMemoryEventHook()) {
+    hook(ptr, -static_cast<int64_t>(it->second), Device(DeviceType::CPU));
+  }
   size_table_.erase(it);
 }
 
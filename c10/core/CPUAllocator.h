@@ -11,6 +11,8 @@
 C10_DECLARE_bool(caffe2_report_cpu_memory_usage);
 C10_DECLARE_bool(caffe2_cpu_allocator_do_zero_fill);
 C10_DECLARE_bool(caffe2_cpu_allocator_do_junk_fill);
+C10_DECLARE_int64(caffe2_cpu_numa_min_alloc_size);
+C10_DECLARE_int64(caffe2_cpu_zeroed_alloc_min_size);
 
 namespace c10 {
 
@@ -30,6 +32,14 @@ C10_API void memset_junk(void* data, size_t num);
 C10_API void* alloc_cpu(size_t nbytes);
 C10_API void free_cpu(void* data);
 
+// Returns nbytes of zeroed memory backed by fresh anonymous pages, which the
+// OS zeroes lazily as they are first touched, so that large zero-filled
+// buffers don't have to be filled up front. Returns a null DataPtr, for the
+// caller to allocate and fill the memory itself, if nbytes is smaller than
+// caffe2_cpu_zeroed_alloc_min_size, if the CPU allocator isn't the default
+// one (or reports its allocations), or if the platform has no such pages.
+C10_API at::DataPtr try_alloc_zeroed_cpu(size_t nbytes);
+
 // Get the CPU Alloctor.
 C10_API at::Allocator* GetCPUAllocator();
 // Sets the CPU allocator to the given allocator: the caller gives away the
@@ -0,0 +1,368 @@
+#include <c10/core/CPUCachingAllocator.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include <c10/core/CPUAllocator.h>
+#include <c10/util/Metrics.h>
+#include <c10/util/StaticTracepoint.h>
+
+C10_DEFINE_int64(
+    caffe2_cpu_caching_allocator_max_cached_size,
+    1 << 20,
+    "Largest allocation in bytes that the CPU caching allocator caches");
+
+C10_DEFINE_int64(
+    caffe2_cpu_caching_allocator_thread_cache_size,
+    8 << 20,
+    "Bytes a thread caches before handing blocks to the shared cache");
+
+namespace c10 {
+
+namespace {
+
+// Every block starts with a header recording its size class; this keeps
+// the payload aligned and lets the deleter work from the data pointer alone.
+constexpr size_t kHeaderSize = gAlignment;
+constexpr int kMinClassLog2 = 6;             // smallest class is 64 bytes
+constexpr int kMaxClassLog2 = 30;            // largest class is 1 GiB
+constexpr int kClassesPerDoubling = 4;
+constexpr size_t kNumClasses =
+    1 + (kMaxClassLog2 - kMinClassLog2) * kClassesPerDoubling;
+constexpr uint32_t kUncached = static_cast<uint32_t>(-1);
+
+struct BlockHeader {
+  uint32_t size_class;
+  size_t size;  // usable bytes after the header
+};
+static_assert(sizeof(BlockHeader) <= kHeaderSize, "block header too large");
+
+int floor_log2(size_t n) {
+  int result = 0;
+  while (n >>= 1) {
+    result++;
+  }
+  return result;
+}
+
+// (2^b, 2^(b+1)] is split into kClassesPerDoubling classes of equal width
+size_t size_class(size_t nbytes) {
+  if (nbytes <= (size_t(1) << kMinClassLog2)) {
+    return 0;
+  }
+  int b = floor_log2(nbytes - 1);
+  size_t base = size_t(1) << b;
+  size_t step = base / kClassesPerDoubling;
+  size_t k = (nbytes - base + step - 1) / step;
+  return 1 + (b - kMinClassLog2) * kClassesPerDoubling + (k - 1);
+}
+
+size_t class_size(size_t cls) {
+  if (cls == 0) {
+    return size_t(1) << kMinClassLog2;
+  }
+  size_t base = size_t(1) << ((cls - 1) / kClassesPerDoubling + kMinClassLog2);
+  size_t k = (cls - 1) % kClassesPerDoubling + 1;
+  return base + k * (base / kClassesPerDoubling);
+}
+
+size_t max_cached_size() {
+  int64_t size = FLAGS_caffe2_cpu_caching_allocator_max_cached_size;
+  return size <= 0 ? 0 : std::min<size_t>(size, size_t(1) << kMaxClassLog2);
+}
+
+BlockHeader* header_of(void* data) {
+  return reinterpret_cast<BlockHeader*>(static_cast<char*>(data) - kHeaderSize);
+}
+
+void* data_of(BlockHeader* header) {
+  return reinterpret_cast<char*>(header) + kHeaderSize;
+}
+
+struct CachingState {
+  // blocks moved out of thread caches, by size class
+  std::mutex mutex;
+  std::vector<std::vector<BlockHeader*>> free_lists{kNumClasses};
+
+  std::atomic<uint64_t> allocated_bytes{0};
+  std::atomic<uint64_t> cached_bytes{0};
+  std::atomic<uint64_t> num_allocations{0};
+  std::atomic<uint64_t> num_cache_hits{0};
+
+  // bumped by emptyCache(); thread caches of an older epoch are stale
+  std::atomic<uint64_t> epoch{0};
+};
+
+// Leaked, since threads may free blocks during static destruction
+CachingState& state() {
+  static CachingState* state = new CachingState();
+  return *state;
+}
+
+void release(BlockHeader* header) {
+  state().cached_bytes -= header->size;
+  free_cpu(header);
+}
+
+struct ThreadCache {
+  std::vector<std::vector<BlockHeader*>> free_lists{kNumClasses};
+  size_t cached_bytes = 0;
+  uint64_t epoch = state().epoch.load();
+
+  ~ThreadCache();
+
+  BlockHeader* pop(size_t cls) {
+    check_epoch();
+    auto& list = free_lists[cls];
+    if (list.empty()) {
+      return nullptr;
+    }
+    BlockHeader* header = list.back();
+    list.pop_back();
+    cached_bytes -= header->size;
+    return header;
+  }
+
+  void push(BlockHeader* header) {
+    check_epoch();
+    free_lists[header->size_class].push_back(header);
+    cached_bytes += header->size;
+    if (cached_bytes >
+        static_cast<size_t>(
+            FLAGS_caffe2_cpu_caching_allocator_thread_cache_size)) {
+      // The class that overflowed is likely freed here and allocated on
+      // another thread, so hand it over first.
+      flush_class(header->size_class);
+      if (cached_bytes >
+          static_cast<size_t>(
+              FLAGS_caffe2_cpu_caching_allocator_thread_cache_size)) {
+        flush();
+      }
+    }
+  }
+
+  void flush_class(size_t cls) {
+    auto& list = free_lists[cls];
+    if (list.empty()) {
+      return;
+    }
+    auto& s = state();
+    std::lock_guard<std::mutex> guard(s.mutex);
+    auto& shared = s.free_lists[cls];
+    for (BlockHeader* header : list) {
+      cached_bytes -= header->size;
+      shared.push_back(header);
+    }
+    list.clear();
+  }
+
+  void flush() {
+    for (size_t cls = 0; cls < kNumClasses; cls++) {
+      flush_class(cls);
+    }
+  }
+
+  void check_epoch() {
+    uint64_t current = state().epoch.load(std::memory_order_relaxed);
+    if (epoch == current) {
+      return;
+    }
+    epoch = current;
+    for (auto& list : free_lists) {
+      for (BlockHeader* header : list) {
+        release(header);
+      }
+      list.clear();
+    }
+    cached_bytes = 0;
+  }
+};
+
+// Set once the thread's cache is destroyed, so that blocks freed by later
+// thread_local destructors go to the shared cache instead.
+thread_local bool thread_cache_destroyed = false;
+
+ThreadCache::~ThreadCache() {
+  check_epoch();
+  flush();
+  thread_cache_destroyed = true;
+}
+
+ThreadCache* thread_cache() {
+  if (thread_cache_destroyed) {
+    return nullptr;
+  }
+  static thread_local ThreadCache cache;
+  return &cache;
+}
+
+BlockHeader* pop_shared(size_t cls) {
+  auto& s = state();
+  std::lock_guard<std::mutex> guard(s.mutex);
+  auto& list = s.free_lists[cls];
+  if (list.empty()) {
+    return nullptr;
+  }
+  BlockHeader* header = list.back();
+  list.pop_back();
+  return header;
+}
+
+void fill(void* data, size_t nbytes) {
+  if (FLAGS_caffe2_cpu_allocator_do_zero_fill) {
+    memset(data, 0, nbytes);
+  } else if (FLAGS_caffe2_cpu_allocator_do_junk_fill) {
+    memset_junk(data, nbytes);
+  }
+}
+
+void* caching_alloc(size_t nbytes) {
+  auto& s = state();
+  s.num_allocations++;
+
+  if (nbytes > max_cached_size()) {
+    auto header = static_cast<BlockHeader*>(alloc_cpu(nbytes + kHeaderSize));
+    header->size_class = kUncached;
+    header->size = nbytes;
+    s.allocated_bytes += nbytes;
+    return data_of(header);
+  }
+
+  size_t cls = size_class(nbytes);
+  ThreadCache* cache = thread_cache();
+  BlockHeader* header = cache ? cache->pop(cls) : nullptr;
+  if (!header) {
+    header = pop_shared(cls);
+  }
+  if (header) {
+    s.cached_bytes -= header->size;
+    s.num_cache_hits++;
+    fill(data_of(header), header->size);
+  } else {
+    size_t size = class_size(cls);
+    C10_SDT(cpu_cache_miss, size);
+    header = static_cast<BlockHeader*>(alloc_cpu(size + kHeaderSize));
+    header->size_class = cls;
+    header->size = size;
+  }
+  s.allocated_bytes += header->size;
+  return data_of(header);
+}
+
+void caching_free(void* data) {
+  if (!data) {
+    return;
+  }
+  auto& s = state();
+  BlockHeader* header = header_of(data);
+  s.allocated_bytes -= header->size;
+  if (header->size_class == kUncached) {
+    free_cpu(header);
+    return;
+  }
+  s.cached_bytes += header->size;
+  ThreadCache* cache = thread_cache();
+  if (cache) {
+    cache->push(header);
+  } else {
+    std::lock_guard<std::mutex> guard(s.mutex);
+    s.free_lists[header->size_class].push_back(header);
+  }
+}
+
+} // namespace
+
+at::DataPtr CPUCachingAllocator::allocate(size_t nbytes) const {
+  if (nbytes == 0) {
+    return {nullptr, nullptr, &caching_free, at::Device(at::DeviceType::CPU)};
+  }
+  void* data = caching_alloc(nbytes);
+  return {data, data, &caching_free, at::Device(at::DeviceType::CPU)};
+}
+
+at::DeleterFnPtr CPUCachingAllocator::raw_deleter() const {
+  return &caching_free;
+}
+
+void CPUCachingAllocator::emptyCache() {
+  auto& s = state();
+  s.epoch++;
+  ThreadCache* cache = thread_cache();
+  if (cache) {
+    cache->check_epoch();
+  }
+  std::lock_guard<std::mutex> guard(s.mutex);
+  for (auto& list : s.free_lists) {
+    for (BlockHeader* header : list) {
+      release(header);
+    }
+    list.clear();
+  }
+}
+
+CPUCachingAllocatorStats CPUCachingAllocator::getStats() const {
+  auto& s = state();
+  CPUCachingAllocatorStats stats;
+  stats.allocated_bytes = s.allocated_bytes.load();
+  stats.cached_bytes = s.cached_bytes.load();
+  stats.num_allocations = s.num_allocations.load();
+  stats.num_cache_hits = s.num_cache_hits.load();
+  return stats;
+}
+
+CPUCachingAllocator* GetCPUCachingAllocator() {
+  static CPUCachingAllocator allocator;
+  return &allocator;
+}
+
+namespace {
+void exportStat(
+    const char* name,
+    const char* help,
+    metrics::MetricType type,
+    uint64_t CPUCachingAllocatorStats::*stat) {
+  metrics::MetricsRegistry::get().addCollector(
+      name, help, type, [stat](std::vector<metrics::MetricSample>& samples) {
+        const auto stats = GetCPUCachingAllocator()->getStats();
+        samples.push_back({"", "", static_cast<double>(stats.*stat)});
+      });
+}
+
+void exportStats() {
+  using metrics::MetricType;
+  exportStat(
+      "c10_cpu_caching_allocator_allocated_bytes",
+      "Bytes allocated by the CPU caching allocator and not freed yet.",
+      MetricType::Gauge,
+      &CPUCachingAllocatorStats::allocated_bytes);
+  exportStat(
+      "c10_cpu_caching_allocator_cached_bytes",
+      "Free bytes held by the caches of the CPU caching allocator.",
+      MetricType::Gauge,
+      &CPUCachingAllocatorStats::cached_bytes);
+  exportStat(
+      "c10_cpu_caching_allocator_allocations_total",
+      "Allocations of the CPU caching allocator.",
+      MetricType::Counter,
+      &CPUCachingAllocatorStats::num_allocations);
+  exportStat(
+      "c10_cpu_caching_allocator_cache_hits_total",
+      "Allocations of the CPU caching allocator served from a cache.",
+      MetricType::Counter,
+      &CPUCachingAllocatorStats::num_cache_hits);
+}
+} // namespace
+
+void SetCPUCachingAllocatorEnabled(bool enabled) {
+  if (enabled) {
+    static std::once_flag exported;
+    std::call_once(exported, exportStats);
+    SetCPUAllocator(GetCPUCachingAllocator());
+  } else {
+    SetCPUAllocator(GetDefaultCPUAllocator());
+  }
+}
+
+} // namespace c10
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+#include <c10/core/Allocator.h>
+#include <c10/util/Flags.h>
+
+C10_DECLARE_int64(caffe2_cpu_caching_allocator_max_cached_size);
+C10_DECLARE_int64(caffe2_cpu_caching_allocator_thread_cache_size);
+
+namespace c10 {
+
+struct CPUCachingAllocatorStats {
+  // bytes handed out and not freed yet, rounded up to their size class
+  uint64_t allocated_bytes = 0;
+  // free bytes held by the thread caches and the shared cache
+  uint64_t cached_bytes = 0;
+  // number of allocations, and how many of them were served from a cache
+  uint64_t num_allocations = 0;
+  uint64_t num_cache_hits = 0;
+};
+
+/**
+ * A CPU allocator that keeps freed memory for reuse instead of returning it
+ * to the system allocator.
+ *
+ * Requests up to caffe2_cpu_caching_allocator_max_cached_size bytes are
+ * rounded up to one of four size classes per power of two. A freed block is
+ * kept in the cache of the thread that frees it, which serves later requests
+ * of that class without locking. Once a thread caches more than
+ * caffe2_cpu_caching_allocator_thread_cache_size bytes, its blocks are
+ * moved to a shared cache that the other threads fall back to. Larger
+ * requests go straight to alloc_cpu() / free_cpu().
+ *
+ * The allocator is opt-in, see SetCPUCachingAllocatorEnabled().
+ */
+class C10_API CPUCachingAllocator final : public at::Allocator {
+ public:
+  at::DataPtr allocate(size_t nbytes) const override;
+  at::DeleterFnPtr raw_deleter() const override;
+
+  // Returns all cached blocks to the system allocator. The caches of other
+  // threads are released the next time those threads allocate or free.
+  void emptyCache();
+  CPUCachingAllocatorStats getStats() const;
+};
+
+C10_API CPUCachingAllocator* GetCPUCachingAllocator();
+
+// Makes the caching allocator (or again the default allocator) the allocator
+// for DeviceType::CPU. Like SetAllocator(), this is meant to be called
+// during initialization; memory allocated before remains valid.
+C10_API void SetCPUCachingAllocatorEnabled(bool enabled);
+
+} // namespace c10
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <c10/util/ArrayRef.h>
+#include <c10/util/Exception.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+// Memory format is not the property of a Tensor. It is the way to tell an
+// operator how the result should be organized in memory and nothing more. That
+// means memory format should never be used as return value for any tensor state
+// interrogation functions (internally and externally).
+//
+// Possible options are:
+//  Any:
+//    An operator can return Tensor with any memory format. This describes the
+//    current behavior of operators.
+//
+//  Contiguous:
+//    Regardless of input tensors format, the output should be contiguous
+//    Tensor.
+//
+//  ChannelsLast:
+//    Regardless of input tensors format, the output should be in channels_last
+//    format: a 4-d NCHW-sized tensor whose channel dimension has stride 1, i.e.
+//    laid out in memory as NHWC.
+
+namespace c10 {
+enum class MemoryFormat : int8_t { Any, Contiguous, ChannelsLast };
+
+inline std::ostream& operator<<(
+    std::ostream& stream,
+    at::MemoryFormat memory_format) {
+  switch (memory_format) {
+    case MemoryFormat::Any:
+      return stream << "Any";
+    case MemoryFormat::Contiguous:
+      return stream << "Contiguous";
+    case MemoryFormat::ChannelsLast:
+      return stream << "ChannelsLast";
+    default:
+      AT_ERROR("Unknown memory format");
+  }
+}
+
+// Strides of a channels_last tensor of the given (N, C, H, W) sizes. Like the
+// contiguous strides, they treat dimensions of size zero as size one.
+inline std::vector<int64_t> get_channels_last_strides(IntArrayRef sizes) {
+  AT_CHECK(
+      sizes.size() == 4,
+      "ChannelsLast format is only supported for 4-dimensional tensors, got ",
+      sizes.size(),
+      " dimensions");
+  std::vector<int64_t> strides(sizes.size());
+  strides[1] = 1;
+  strides[3] = std::max<int64_t>(sizes[1], 1);
+  strides[2] = strides[3] * std::max<int64_t>(sizes[3], 1);
+  strides[0] = strides[2] * std::max<int64_t>(sizes[2], 1);
+  return strides;
+}
+
+} // namespace c10
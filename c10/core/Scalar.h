@@ -32,6 +32,7 @@ class C10_API Scalar {
   // syntax v{ .member = ... } because it doesn't work on MSVC
 
   AT_FORALL_SCALAR_TYPES_EXCEPT_QINT(DEFINE_IMPLICIT_CTOR)
+  DEFINE_IMPLICIT_CTOR(at::BFloat16, BFloat16, d)
 
 #undef DEFINE_IMPLICIT_CTOR
 
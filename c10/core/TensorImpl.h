@@ -5,11 +5,13 @@
 #include <numeric>
 
 #include <c10/core/Backend.h>
+#include <c10/core/MemoryFormat.h>
 #include <c10/core/Storage.h>
 #include <c10/core/TensorOptions.h>
 #include <c10/core/TensorTypeId.h>
 #include <c10/core/TensorTypeIdRegistration.h>
 #include <c10/core/CopyBytes.h>
+#include <c10/core/impl/SizesAndStrides.h>
 
 #include <c10/util/Exception.h>
 #include <c10/util/Optional.h>
@@ -381,11 +383,20 @@ struct C10_API TensorImpl : public c10::intrusive_ptr_target {
    * Tensors with non-trivial strides are not contiguous.  See
    * compute_contiguous() for the exact definition of whether or not
    * a tensor is contiguous or not.
+   *
+   * With MemoryFormat::ChannelsLast, whether the tensor is a 4-d tensor laid
+   * out contiguously in NHWC order instead; see
+   * compute_channels_last_contiguous().
    */
-  virtual bool is_contiguous() const {
+  virtual bool is_contiguous(
+      at::MemoryFormat memory_format = at::MemoryFormat::Contiguous) const {
 #ifdef DEBUG
     AT_ASSERT(compute_contiguous() == is_contiguous_);
+    AT_ASSERT(compute_channels_last_contiguous() == is_channels_last_contiguous_);
 #endif
+    if (memory_format == at::MemoryFormat::ChannelsLast) {
+      return is_channels_last_contiguous_;
+    }
     return is_contiguous_;
   }
 
@@ -736,8 +747,7 @@ struct C10_API TensorImpl : public c10::intrusive_ptr_target {
    */
   virtual void resize_dim(int64_t ndim) {
     AT_CHECK(allow_tensor_metadata_change(), "resize_dim is not allowed on Tensor created from .data or .detach()");
-    sizes_.resize(ndim, 0);
-    strides_.resize(ndim, 0);
+    sizes_and_strides_.resize(ndim);
     refresh_numel();
     refresh_contiguous();
   }
@@ -752,7 +762,7 @@ struct C10_API TensorImpl : public c10::intrusive_ptr_target {
    */
   virtual void set_size(int64_t dim, int64_t new_size) {
     AT_CHECK(allow_tensor_metadata_change(), "set_size is not allowed on Tensor created from .data or .detach()");
-    sizes_.at(dim) = new_size;
+    sizes_and_strides_.size_at(dim) = new_size;
     refresh_numel();
     refresh_contiguous();
   }
@@ -765,7 +775,7 @@ struct C10_API TensorImpl : public c10::intrusive_ptr_target {
    */
   virtual void set_stride(int64_t dim, int64_t new_stride) {
     AT_CHECK(allow_tensor_metadata_change(), "set_stride is not allowed on Tensor created from .data or .detach()");
-    strides_[dim] = new_stride;
+    sizes_and_strides_.stride_at_unchecked(dim) = new_stride;
     refresh_numel();
     refresh_contiguous();
   }
@@ -782,6 +792,34 @@ struct C10_API TensorImpl : public c10::intrusive_ptr_target {
     storage_offset_ = storage_offset;
   }
 
+  /**
+   * Set the strides of a tensor that has just been allocated (and so holds no
+   * data yet) to the contiguous strides of the given memory format.
+   *
+   * WARNING: This function doesn't rearrange data; it is only meant for
+   * freshly allocated tensors, e.g. in empty().
+   */
+  void empty_tensor_restride(at::MemoryFormat memory_format) {
+    AT_CHECK(allow_tensor_metadata_change(), "empty_tensor_restride is not allowed on Tensor created from .data or .detach()");
+    AT_ASSERT(!is_variable());  // TODO: remove this when Variable and Tensor are merged
+    switch (memory_format) {
+      case at::MemoryFormat::Any:
+      case at::MemoryFormat::Contiguous:
+        update_to_contiguous_strides(sizes_and_strides_.size());
+        break;
+      case at::MemoryFormat::ChannelsLast: {
+        auto new_strides = get_channels_last_strides(sizes());
+        for (size_t dim = 0; dim < new_strides.size(); ++dim) {
+          sizes_and_strides_.stride_at_unchecked(dim) = new_strides[dim];
+        }
+        refresh_contiguous();
+        break;
+      }
+      default:
+        AT_ERROR("Unsupported memory format ", memory_format);
+    }
+  }
+
   /**
    * Like set_sizes_and_strides but assumes contiguous strides.
    *
@@ -795,13 +833,8 @@ struct C10_API TensorImpl : public c10::intrusive_ptr_target {
   void set_sizes_contiguous(IntArrayRef new_size) {
     AT_CHECK(allow_tensor_metadata_change(), "set_sizes_contiguous is not allowed on Tensor created from .data or .detach()");
     AT_ASSERT(!is_variable());  // TODO: remove this when Variable and Tensor are merged
-    auto old_dim = sizes_.size();
-    auto new_dim = new_size.size();
-
-    sizes_.resize(new_dim);
-    for (size_t dim = 0; dim < new_dim; ++dim) {
-      sizes_[dim] = new_size[dim];
-    }
+    auto old_dim = sizes_and_strides_.size();
+    sizes_and_strides_.set_sizes(new_size);
 
     update_to_contiguous_strides(old_dim);
     refresh_numel();
@@ -829,25 +862,23 @@ struct C10_API TensorImpl : public c10::intrusive_ptr_target {
         ")");
     auto new_dim = new_size.size();
 
-    sizes_.resize(new_dim);
-    for (size_t dim = 0; dim < new_dim; ++dim) {
-      sizes_[dim] = new_size[dim];
-    }
+    sizes_and_strides_.set_sizes(new_size);
 
-    strides_.resize(new_dim);
     if (new_dim > 0) {
       for (size_t dim = new_dim - 1; ; dim--) {
         if (new_stride[dim] >= 0) {
-          strides_[dim] = new_stride[dim];
+          sizes_and_strides_.stride_at_unchecked(dim) = new_stride[dim];
         } else {
           // XXX: This behavior is surprising and may need to be removed to
           // support negative strides. Some pytorch functions rely on it:
           // for example, torch.cat (run TestTorch.test_cat_empty).
           if (dim == new_dim - 1) {
-            strides_[dim] = 1;
+            sizes_and_strides_.stride_at_unchecked(dim) = 1;
           } else {
             // Keep stride monotonically increasing to match NumPy.
-            strides_[dim] = std::max<int64_t>(sizes_[dim + 1], 1) * strides_[dim + 1];
+            sizes_and_strides_.stride_at_unchecked(dim) =
+                std::max<int64_t>(sizes_and_strides_.size_at_unchecked(dim + 1), 1) *
+                sizes_and_strides_.stride_at_unchecked(dim + 1);
           }
         }
         if (dim == 0) break;
@@ -858,6 +889,27 @@ struct C10_API TensorImpl : public c10::intrusive_ptr_target {
     refresh_contiguous();
   }
 
+  /**
+   * Set the sizes and strides of a tensor to those of another tensor.
+   *
+   * Unlike set_sizes_and_strides(src.sizes(), src.strides()), this copies the
+   * numel and contiguity that src has already computed instead of computing
+   * them again, which makes it the cheap way to give a new view the geometry
+   * of an existing tensor.
+   *
+   * WARNING: It is NOT valid to call this method on a Variable, or with a
+   * Variable as src.
+   * See Note [We regret making Variable hold a Tensor]
+   */
+  void set_sizes_and_strides_like(const TensorImpl& src) {
+    AT_CHECK(allow_tensor_metadata_change(), "set_sizes_and_strides_like is not allowed on Tensor created from .data or .detach()");
+    AT_ASSERT(!is_variable() && !src.is_variable());  // TODO: remove this when Variable and Tensor are merged
+    sizes_and_strides_ = src.sizes_and_strides_;
+    numel_ = src.numel_;
+    is_contiguous_ = src.is_contiguous_;
+    is_channels_last_contiguous_ = src.is_channels_last_contiguous_;
+  }
+
   /**
    * Return the size of a tensor at some dimension.
    */
@@ -921,12 +973,10 @@ struct C10_API TensorImpl : public c10::intrusive_ptr_target {
   virtual c10::intrusive_ptr<TensorImpl> shallow_copy_and_detach() const {
     AT_ASSERT(!is_variable());  // TODO: remove this when Variable and Tensor are merged
     auto impl = c10::make_intrusive<TensorImpl>(Storage(storage()), type_id());
-    impl->set_sizes_and_strides(sizes(), strides());
+    impl->set_sizes_and_strides_like(*this);
     impl->storage_offset_ = storage_offset_;
     impl->is_wrapped_number_ = is_wrapped_number_;
     impl->reserved_ = reserved_;
-    impl->refresh_numel();
-    impl->refresh_contiguous();
     return impl;
   }
 
@@ -983,12 +1033,12 @@ struct C10_API TensorImpl : public c10::intrusive_ptr_target {
    * This op is auto-asynchronous if the underlying device (CUDA) supports it.
    */
   void Extend(int64_t num, float growthPct) {
-    AT_ASSERT(sizes_.size() >= 1u);
+    AT_ASSERT(sizes_and_strides_.size() >= 1u);
     AT_ASSERTM(num >= 0, "`num` must be non-negative for Extend");
     AT_ASSERTM(
         is_contiguous_,
         "Right now Extend is only supported for contiguous Tensor.");
-    auto newDims = sizes_;
+    auto newDims = sizes_and_strides_.sizes_arrayref().vec();
     newDims[0] += num;
     if (!storage_.data()) {
       Resize(newDims);
@@ -1000,16 +1050,16 @@ struct C10_API TensorImpl : public c10::intrusive_ptr_target {
         static_cast<int64_t>(1),
         std::multiplies<int64_t>());
     if (newNumel * storage_.itemsize() <= storage_.capacity()) {
-      sizes_ = newDims;
+      sizes_and_strides_.set_sizes(newDims);
       numel_ = newNumel;
       return;
     }
-    auto newCapacity = sizes_;
+    auto newCapacity = sizes_and_strides_.sizes_arrayref().vec();
     newCapacity[0] = std::max<size_t>(
-        newDims[0], std::ceil(sizes_[0] * (growthPct + 100) / 100));
+        newDims[0],
+        std::ceil(sizes_and_strides_.size_at_unchecked(0) * (growthPct + 100) / 100));
     auto oldData = std::move(storage_.data_ptr());
     auto oldSize = numel_;
-    auto oldDims = sizes_;
     Resize(newCapacity);
     auto* newData = raw_mutable_data(data_type_);
     if (data_type_.copy()) {
@@ -1036,7 +1086,7 @@ struct C10_API TensorImpl : public c10::intrusive_ptr_target {
           true); // non-blocking
     }
     reserved_ = true;
-    sizes_ = newDims;
+    sizes_and_strides_.set_sizes(newDims);
     numel_ = newNumel;
   }
 
@@ -1053,7 +1103,7 @@ struct C10_API TensorImpl : public c10::intrusive_ptr_target {
         "Right now ReserveSpace is only supported for contiguous Tensor.");
     AT_ASSERTM(
         storage_.unique(), "Can't call ReserveSpace on shared storage.");
-    auto newCapacity = sizes_;
+    auto newCapacity = sizes_and_strides_.sizes_arrayref().vec();
     newCapacity[0] = outer_dim;
     auto newNumel = std::accumulate(
         newCapacity.begin(),
@@ -1066,11 +1116,11 @@ struct C10_API TensorImpl : public c10::intrusive_ptr_target {
     // Old data is discarded
     storage_.data_ptr().clear();
     auto oldSize = numel_;
-    auto oldDims = sizes_;
+    auto oldDims = sizes_and_strides_.sizes_arrayref().vec();
     Resize(newCapacity);
     // Allocate new memory but don't copy over the data
     raw_mutable_data(data_type_);
-    sizes_ = oldDims;
+    sizes_and_strides_.set_sizes(oldDims);
     numel_ = oldSize;
     reserved_ = true;
   }
@@ -1139,8 +1189,8 @@ struct C10_API TensorImpl : public c10::intrusive_ptr_target {
         " The old caffe2 mixes Reshape and Resize but this behavior has "
         "been changed. If you find this error, most likely you will need "
         "to change corresponding code from Reshape to Resize.");
-    auto old_dim = sizes_.size();
-    sizes_ = dims;
+    auto old_dim = sizes_and_strides_.size();
+    sizes_and_strides_.set_sizes(dims);
     update_to_contiguous_strides(old_dim);
   }
 
@@ -1357,12 +1407,12 @@ private:
       typename = typename std::enable_if<std::is_integral<T>::value>::type>
   bool SetDimsTemplate(ArrayRef<T> src) {
     auto old_numel = numel_;
-    auto old_dim = sizes_.size();
-    sizes_.resize(src.size());
+    auto old_dim = sizes_and_strides_.size();
+    sizes_and_strides_.resize(src.size());
     int64_t new_numel = 1;
     for (size_t i = 0; i < src.size(); ++i) {
       new_numel *= src[i];
-      sizes_[i] = src[i];
+      sizes_and_strides_.size_at_unchecked(i) = src[i];
     }
     update_to_contiguous_strides(old_dim);
     numel_ = new_numel;
@@ -1402,15 +1452,19 @@ private:
   }
 
   inline void update_to_contiguous_strides(size_t old_dim) {
-    strides_.resize(sizes_.size(), 0);
     if (dim() > 0) {
       int last_idx = dim() - 1;
-      strides_[last_idx] = 1;
+      sizes_and_strides_.stride_at_unchecked(last_idx) = 1;
       for (auto i = last_idx - 1; i >= 0; --i) {
-        strides_[i] = strides_[i + 1] * std::max<int64_t>(sizes_[i + 1], 1);
+        sizes_and_strides_.stride_at_unchecked(i) =
+            sizes_and_strides_.stride_at_unchecked(i + 1) *
+            std::max<int64_t>(sizes_and_strides_.size_at_unchecked(i + 1), 1);
       }
     }
     is_contiguous_ = true;
+    // A contiguous tensor is also channels last contiguous when its channel
+    // or spatial dimensions are all of size one.
+    is_channels_last_contiguous_ = compute_channels_last_contiguous();
   }
 
   /**
@@ -1430,6 +1484,12 @@ private:
    */
   bool compute_contiguous() const;
 
+  /**
+   * Compute whether or not a tensor is a 4-d tensor whose dimensions are
+   * contiguous in NHWC order, based on its sizes and strides.
+   */
+  bool compute_channels_last_contiguous() const;
+
 protected:
   /**
    * Recompute the cached numel of a tensor.  Call this if you modify sizes.
@@ -1446,6 +1506,7 @@ protected:
   void refresh_contiguous() {
     AT_ASSERT(!is_variable());  // TODO: remove this when Variable and Tensor are merged
     is_contiguous_ = compute_contiguous();
+    is_channels_last_contiguous_ = compute_channels_last_contiguous();
   }
 
 protected:
@@ -1460,19 +1521,14 @@ protected:
 
   PyObject* pyobj_ = nullptr; // weak reference
 
-  // We could save a word or two by combining the SmallVector structs,
-  // since their size is redundant, and if we need to overflow the buffer space
-  // we could keep the two pointers together. However, that would require
-  // implementing another struct from scratch, so only do this if we're desperate.
-  SmallVector<int64_t,5> sizes_;
-  SmallVector<int64_t,5> strides_;
+  // Sizes and strides share their dimensionality and a single buffer, which
+  // is inline for up to C10_SIZES_AND_STRIDES_MAX_INLINE_SIZE dimensions.
+  impl::SizesAndStrides sizes_and_strides_;
 
   int64_t storage_offset_ = 0;
-  // If sizes and strides are empty, the numel is 1!!  However, most of the
-  // time, we will immediately set sizes to {0} and reset numel to 0.
-  // (Can't do that in the default initializers, because there's no way to
-  // spell "allocate a one-element array" for strides_).
-  int64_t numel_ = 1;
+  // sizes_and_strides_ starts out as sizes {0} and strides {1}, which hold
+  // no elements.
+  int64_t numel_ = 0;
 
   // INVARIANT: When storage is non-null, this type meta must
   // agree with the type meta in storage
@@ -1493,6 +1549,7 @@ protected:
   // should pack this into a bitfield.
   TensorTypeId type_id_;
   bool is_contiguous_ = true;
+  bool is_channels_last_contiguous_ = false;
   bool is_wrapped_number_ = false;
 
   // Previously, if we change the tensor metadata (e.g. sizes / strides / storage / storage_offset)
@@ -1547,22 +1604,17 @@ protected:
 //    version counter (word 0)
 //    version counter (word 1)
 //    PyObject pointer
-//    sizes SmallVector (begin)
-//    sizes SmallVector (end)
-//    sizes SmallVector (capacity)
-//    sizes SmallVector (pre-allocated 0)
-//    sizes SmallVector (pre-allocated 1)
-//    sizes SmallVector (pre-allocated 2)
-//    sizes SmallVector (pre-allocated 3)
-//    sizes SmallVector (pre-allocated 4)
-//    strides SmallVector (begin)
-//    strides SmallVector (end)
-//    strides SmallVector (capacity)
-//    strides SmallVector (pre-allocated 0)
-//    strides SmallVector (pre-allocated 1)
-//    strides SmallVector (pre-allocated 2)
-//    strides SmallVector (pre-allocated 3)
-//    strides SmallVector (pre-allocated 4)
+//    sizes and strides (dimensionality)
+//    sizes and strides (pre-allocated 0)
+//    sizes and strides (pre-allocated 1)
+//    sizes and strides (pre-allocated 2)
+//    sizes and strides (pre-allocated 3)
+//    sizes and strides (pre-allocated 4)
+//    sizes and strides (pre-allocated 5)
+//    sizes and strides (pre-allocated 6)
+//    sizes and strides (pre-allocated 7)
+//    sizes and strides (pre-allocated 8)
+//    sizes and strides (pre-allocated 9)
 //    storage offset
 //    numel
 //    data type pointer
@@ -1570,7 +1622,7 @@ protected:
 //    miscellaneous bitfield
 //
 static_assert(sizeof(void*) != sizeof(int64_t) || // if 64-bit...
-              sizeof(TensorImpl) == sizeof(int64_t) * 29,
+              sizeof(TensorImpl) == sizeof(int64_t) * 24,
               "You changed the size of TensorImpl on 64-bit arch."
               "See Note [TensorImpl size constraints] on how to proceed.");
 
@@ -383,6 +383,8 @@ struct C10_API TensorOptions {
             return MSNPUTensorId();
           case DeviceType::XLA:
             return XLATensorId();
+          case DeviceType::VULKAN:
+            return VulkanTensorId();
           default:
             AT_ERROR("Unsupported device type for dense layout: ", device().type());
         }
@@ -601,6 +603,8 @@ inline DeviceType computeDeviceType(TensorTypeId tid) {
     return DeviceType::MSNPU;
   } else if (tid == XLATensorId()) {
     return DeviceType::XLA;
+  } else if (tid == VulkanTensorId()) {
+    return DeviceType::VULKAN;
   } else if (tid == SparseCPUTensorId()) {
     return DeviceType::CPU;
   } else if (tid == SparseCUDATensorId()) {
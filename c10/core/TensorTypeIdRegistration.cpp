@@ -74,5 +74,6 @@ C10_DEFINE_TENSOR_TYPE(MkldnnCPUTensorId);
 C10_DEFINE_TENSOR_TYPE(QuantizedCPUTensorId);
 C10_DEFINE_TENSOR_TYPE(ComplexCPUTensorId);
 C10_DEFINE_TENSOR_TYPE(ComplexCUDATensorId);
+C10_DEFINE_TENSOR_TYPE(VulkanTensorId);
 
 } // namespace c10
@@ -113,6 +113,7 @@ C10_DECLARE_TENSOR_TYPE(MkldnnCPUTensorId);
 C10_DECLARE_TENSOR_TYPE(QuantizedCPUTensorId); // PyTorch only
 C10_DECLARE_TENSOR_TYPE(ComplexCPUTensorId); // PyTorch only
 C10_DECLARE_TENSOR_TYPE(ComplexCUDATensorId); // PyTorch only
+C10_DECLARE_TENSOR_TYPE(VulkanTensorId); // PyTorch only
 
 } // namespace c10
 
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <c10/macros/Macros.h>
+#include <c10/util/ArrayRef.h>
+#include <c10/util/Exception.h>
+
+namespace c10 {
+namespace impl {
+
+#define C10_SIZES_AND_STRIDES_MAX_INLINE_SIZE 5
+
+/**
+ * The sizes and strides of a tensor, packed together.
+ *
+ * TensorImpl used to keep its sizes and strides in two SmallVectors, which
+ * stored the (always equal) dimensionality twice and, for tensors with more
+ * dimensions than fit inline, paid for two heap allocations.  Here both
+ * arrays live in a single buffer: up to C10_SIZES_AND_STRIDES_MAX_INLINE_SIZE
+ * dimensions are stored inline as
+ *
+ *    [size_0 ... size_4 | stride_0 ... stride_4]
+ *
+ * and larger tensors keep the same layout, sized to their dimensionality, in
+ * one heap allocation.
+ *
+ * Newly added dimensions always have zero size and zero stride.
+ */
+class SizesAndStrides {
+ public:
+  // A freshly constructed tensor is one dimensional with size 0 and stride 1.
+  SizesAndStrides() : size_(1) {
+    size_at_unchecked(0) = 0;
+    stride_at_unchecked(0) = 1;
+  }
+
+  ~SizesAndStrides() {
+    if (C10_UNLIKELY(!isInline())) {
+      free(outOfLineStorage_);
+    }
+  }
+
+  SizesAndStrides(const SizesAndStrides& rhs) : size_(rhs.size_) {
+    if (C10_LIKELY(rhs.isInline())) {
+      copyDataInline(rhs);
+    } else {
+      allocateOutOfLineStorage(size_);
+      copyDataOutline(rhs);
+    }
+  }
+
+  SizesAndStrides& operator=(const SizesAndStrides& rhs) {
+    if (this == &rhs) {
+      return *this;
+    }
+    if (C10_LIKELY(rhs.isInline())) {
+      if (C10_UNLIKELY(!isInline())) {
+        free(outOfLineStorage_);
+      }
+      copyDataInline(rhs);
+    } else {
+      if (isInline()) {
+        allocateOutOfLineStorage(rhs.size_);
+      } else if (size_ != rhs.size_) {
+        resizeOutOfLineStorage(rhs.size_);
+      }
+      copyDataOutline(rhs);
+    }
+    size_ = rhs.size_;
+    return *this;
+  }
+
+  // Leaves rhs empty (zero dimensional).
+  SizesAndStrides(SizesAndStrides&& rhs) noexcept : size_(rhs.size_) {
+    if (C10_LIKELY(isInline())) {
+      memcpy(inlineStorage_, rhs.inlineStorage_, sizeof(inlineStorage_));
+    } else {
+      outOfLineStorage_ = rhs.outOfLineStorage_;
+      rhs.outOfLineStorage_ = nullptr;
+    }
+    rhs.size_ = 0;
+  }
+
+  SizesAndStrides& operator=(SizesAndStrides&& rhs) noexcept {
+    if (this == &rhs) {
+      return *this;
+    }
+    if (C10_UNLIKELY(!isInline())) {
+      free(outOfLineStorage_);
+    }
+    if (C10_LIKELY(rhs.isInline())) {
+      memcpy(inlineStorage_, rhs.inlineStorage_, sizeof(inlineStorage_));
+    } else {
+      outOfLineStorage_ = rhs.outOfLineStorage_;
+      rhs.outOfLineStorage_ = nullptr;
+    }
+    size_ = rhs.size_;
+    rhs.size_ = 0;
+    return *this;
+  }
+
+  size_t size() const noexcept {
+    return size_;
+  }
+
+  const int64_t* sizes_data() const noexcept {
+    return C10_LIKELY(isInline()) ? &inlineStorage_[0] : &outOfLineStorage_[0];
+  }
+
+  int64_t* sizes_data() noexcept {
+    return C10_LIKELY(isInline()) ? &inlineStorage_[0] : &outOfLineStorage_[0];
+  }
+
+  const int64_t* strides_data() const noexcept {
+    return C10_LIKELY(isInline())
+        ? &inlineStorage_[C10_SIZES_AND_STRIDES_MAX_INLINE_SIZE]
+        : &outOfLineStorage_[size_];
+  }
+
+  int64_t* strides_data() noexcept {
+    return C10_LIKELY(isInline())
+        ? &inlineStorage_[C10_SIZES_AND_STRIDES_MAX_INLINE_SIZE]
+        : &outOfLineStorage_[size_];
+  }
+
+  IntArrayRef sizes_arrayref() const noexcept {
+    return IntArrayRef{sizes_data(), size()};
+  }
+
+  IntArrayRef strides_arrayref() const noexcept {
+    return IntArrayRef{strides_data(), size()};
+  }
+
+  const int64_t* sizes_begin() const noexcept {
+    return sizes_data();
+  }
+
+  const int64_t* sizes_end() const noexcept {
+    return sizes_data() + size();
+  }
+
+  // Replaces the sizes, resizing to their dimensionality.  The strides of
+  // the dimensions that are kept are left as they were.
+  void set_sizes(IntArrayRef newSizes) {
+    resize(newSizes.size());
+    std::copy(newSizes.begin(), newSizes.end(), sizes_data());
+  }
+
+  int64_t size_at(size_t idx) const {
+    AT_CHECK(idx < size(), "dimension ", idx, " out of range for ", size(), " dimensions");
+    return sizes_data()[idx];
+  }
+
+  int64_t& size_at(size_t idx) {
+    AT_CHECK(idx < size(), "dimension ", idx, " out of range for ", size(), " dimensions");
+    return sizes_data()[idx];
+  }
+
+  int64_t size_at_unchecked(size_t idx) const noexcept {
+    return sizes_data()[idx];
+  }
+
+  int64_t& size_at_unchecked(size_t idx) noexcept {
+    return sizes_data()[idx];
+  }
+
+  int64_t stride_at_unchecked(size_t idx) const noexcept {
+    return strides_data()[idx];
+  }
+
+  int64_t& stride_at_unchecked(size_t idx) noexcept {
+    return strides_data()[idx];
+  }
+
+  void resize(size_t newSize) {
+    const auto oldSize = size();
+    if (newSize == oldSize) {
+      return;
+    }
+    if (C10_LIKELY(
+            newSize <= C10_SIZES_AND_STRIDES_MAX_INLINE_SIZE && isInline())) {
+      if (oldSize < newSize) {
+        const auto bytesToZero = (newSize - oldSize) * sizeof(int64_t);
+        memset(&inlineStorage_[oldSize], 0, bytesToZero);
+        memset(
+            &inlineStorage_[C10_SIZES_AND_STRIDES_MAX_INLINE_SIZE + oldSize],
+            0,
+            bytesToZero);
+      }
+      size_ = newSize;
+    } else {
+      resizeSlowPath(newSize, oldSize);
+    }
+  }
+
+ private:
+  bool isInline() const noexcept {
+    return size_ <= C10_SIZES_AND_STRIDES_MAX_INLINE_SIZE;
+  }
+
+  static size_t storageBytes(size_t size) noexcept {
+    return size * 2 * sizeof(int64_t);
+  }
+
+  void copyDataInline(const SizesAndStrides& rhs) {
+    memcpy(inlineStorage_, rhs.inlineStorage_, sizeof(inlineStorage_));
+  }
+
+  void copyDataOutline(const SizesAndStrides& rhs) noexcept {
+    memcpy(outOfLineStorage_, rhs.outOfLineStorage_, storageBytes(rhs.size_));
+  }
+
+  void allocateOutOfLineStorage(size_t size) {
+    outOfLineStorage_ = static_cast<int64_t*>(malloc(storageBytes(size)));
+    if (!outOfLineStorage_) {
+      throw std::bad_alloc();
+    }
+  }
+
+  void resizeOutOfLineStorage(size_t newSize) {
+    AT_ASSERT(!isInline());
+    auto* storage = static_cast<int64_t*>(
+        realloc(outOfLineStorage_, storageBytes(newSize)));
+    if (!storage) {
+      throw std::bad_alloc();
+    }
+    outOfLineStorage_ = storage;
+  }
+
+  void resizeSlowPath(size_t newSize, size_t oldSize) {
+    const auto keep = std::min(newSize, oldSize);
+    if (newSize <= C10_SIZES_AND_STRIDES_MAX_INLINE_SIZE) {
+      // Out of line to inline.  The pointer shares memory with the inline
+      // buffer, so hold on to it while copying.
+      AT_ASSERT(!isInline());
+      int64_t* oldStorage = outOfLineStorage_;
+      memcpy(&inlineStorage_[0], &oldStorage[0], keep * sizeof(int64_t));
+      memcpy(
+          &inlineStorage_[C10_SIZES_AND_STRIDES_MAX_INLINE_SIZE],
+          &oldStorage[oldSize],
+          keep * sizeof(int64_t));
+      free(oldStorage);
+    } else {
+      // Either way the strides move, as they start right after the sizes.
+      auto* storage = static_cast<int64_t*>(malloc(storageBytes(newSize)));
+      if (!storage) {
+        throw std::bad_alloc();
+      }
+      const int64_t* oldSizes = sizes_data();
+      const int64_t* oldStrides = strides_data();
+      memcpy(&storage[0], oldSizes, keep * sizeof(int64_t));
+      memcpy(&storage[newSize], oldStrides, keep * sizeof(int64_t));
+      if (keep < newSize) {
+        const auto bytesToZero = (newSize - keep) * sizeof(int64_t);
+        memset(&storage[keep], 0, bytesToZero);
+        memset(&storage[newSize + keep], 0, bytesToZero);
+      }
+      if (!isInline()) {
+        free(outOfLineStorage_);
+      }
+      outOfLineStorage_ = storage;
+    }
+    size_ = newSize;
+  }
+
+  size_t size_;
+  union {
+    int64_t* outOfLineStorage_;
+    int64_t inlineStorage_[C10_SIZES_AND_STRIDES_MAX_INLINE_SIZE * 2]{};
+  };
+};
+
+} // namespace impl
+} // namespace c10
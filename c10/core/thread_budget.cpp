@@ -0,0 +1,161 @@
+#include <c10/core/thread_budget.h>
+
+#include <c10/util/Exception.h>
+#include <c10/util/numa.h>
+
+#include <algorithm>
+#include <sstream>
+
+C10_DEFINE_int(
+    caffe2_thread_budget,
+    0,
+    "If positive, the total number of threads shared by the intra-op, "
+    "inter-op and Caffe2 thread pools of the process");
+
+C10_DEFINE_int(
+    caffe2_thread_budget_numa_node,
+    -1,
+    "If non-negative, bind all thread pool workers to this NUMA node when "
+    "a thread budget is set; otherwise spread them over all nodes");
+
+namespace c10 {
+
+const char* toString(ThreadPoolKind kind) {
+  switch (kind) {
+    case ThreadPoolKind::IntraOp:
+      return "intra-op";
+    case ThreadPoolKind::InterOp:
+      return "inter-op";
+    case ThreadPoolKind::Caffe2:
+      return "caffe2";
+    default:
+      AT_ERROR("Unknown thread pool kind: ", static_cast<int>(kind));
+  }
+}
+
+ThreadBudget& ThreadBudget::get() {
+  static ThreadBudget budget;
+  return budget;
+}
+
+ThreadBudget::ThreadBudget()
+    : total_threads_(std::max(FLAGS_caffe2_thread_budget, 0)),
+      numa_node_id_(FLAGS_caffe2_thread_budget_numa_node) {
+  explicit_threads_.fill(0);
+  for (auto& next : next_worker_) {
+    next = 0;
+  }
+}
+
+bool ThreadBudget::enabled() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return total_threads_ > 0;
+}
+
+void ThreadBudget::setTotalThreads(size_t total_threads) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  total_threads_ = total_threads;
+}
+
+size_t ThreadBudget::totalThreads() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return total_threads_;
+}
+
+void ThreadBudget::setNUMANode(int numa_node_id) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  numa_node_id_ = numa_node_id;
+}
+
+int ThreadBudget::numaNode() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return numa_node_id_;
+}
+
+void ThreadBudget::setNumThreads(ThreadPoolKind kind, size_t num_threads) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  explicit_threads_[static_cast<size_t>(kind)] = num_threads;
+}
+
+size_t ThreadBudget::numThreads(ThreadPoolKind kind, size_t fallback) const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return numThreadsLocked(kind, fallback);
+}
+
+size_t ThreadBudget::numThreadsLocked(ThreadPoolKind kind, size_t fallback)
+    const {
+  auto explicit_threads = explicit_threads_[static_cast<size_t>(kind)];
+  if (explicit_threads > 0) {
+    return explicit_threads;
+  }
+  if (total_threads_ == 0) {
+    return fallback;
+  }
+  switch (kind) {
+    case ThreadPoolKind::InterOp:
+      // Inter-op workers spend most of their time running ops that fan out
+      // to the intra-op pool, so one worker is the default share.
+      return 1;
+    case ThreadPoolKind::IntraOp:
+    case ThreadPoolKind::Caffe2: {
+      // Whatever the explicitly sized pools leave (the inter-op pool always
+      // counts, as its workers run ops themselves).
+      size_t reserved = numThreadsLocked(ThreadPoolKind::InterOp, 1);
+      if (kind == ThreadPoolKind::IntraOp) {
+        reserved +=
+            explicit_threads_[static_cast<size_t>(ThreadPoolKind::Caffe2)];
+      }
+      return total_threads_ > reserved ? total_threads_ - reserved : 1;
+    }
+    default:
+      AT_ERROR("Unknown thread pool kind: ", static_cast<int>(kind));
+  }
+}
+
+int ThreadBudget::numaNodeForWorker(ThreadPoolKind kind, size_t worker_index)
+    const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (total_threads_ == 0) {
+    return -1;
+  }
+  if (numa_node_id_ >= 0) {
+    return numa_node_id_;
+  }
+  int num_nodes = GetNumNUMANodes();
+  if (num_nodes <= 1) {
+    return -1;
+  }
+  // Neighbouring workers of a pool usually split one op between them, so
+  // keep them on the same node rather than interleaving.
+  size_t num_threads = std::max<size_t>(numThreadsLocked(kind, 1), 1);
+  return static_cast<int>(
+      ((worker_index % num_threads) * num_nodes) / num_threads);
+}
+
+void ThreadBudget::bindWorker(ThreadPoolKind kind, size_t worker_index) const {
+  NUMABind(numaNodeForWorker(kind, worker_index));
+}
+
+void ThreadBudget::bindNextWorker(ThreadPoolKind kind) {
+  bindWorker(kind, next_worker_[static_cast<size_t>(kind)]++);
+}
+
+std::string ThreadBudget::summary() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  std::ostringstream ss;
+  if (total_threads_ == 0) {
+    ss << "thread budget: not set";
+    return ss.str();
+  }
+  ss << "thread budget: " << total_threads_ << " threads";
+  if (numa_node_id_ >= 0) {
+    ss << " on NUMA node " << numa_node_id_;
+  }
+  for (size_t i = 0; i < kNumKinds; ++i) {
+    auto kind = static_cast<ThreadPoolKind>(i);
+    ss << ", " << toString(kind) << ": " << numThreadsLocked(kind, 0);
+  }
+  return ss.str();
+}
+
+} // namespace c10
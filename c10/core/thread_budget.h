@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include <c10/macros/Macros.h>
+#include <c10/util/Flags.h>
+
+C10_DECLARE_int(caffe2_thread_budget);
+C10_DECLARE_int(caffe2_thread_budget_numa_node);
+
+namespace c10 {
+
+/**
+ * The thread pools whose size and placement are governed by ThreadBudget.
+ */
+enum class ThreadPoolKind : uint8_t {
+  // ATen intra-op parallelism (OpenMP team or the native intra-op pool)
+  IntraOp = 0,
+  // c10::global_work_queue(), used by the JIT for fork/wait
+  InterOp = 1,
+  // caffe2::ThreadPool used by Caffe2 operators
+  Caffe2 = 2,
+  COMPILE_TIME_MAX_THREAD_POOL_KINDS = 3,
+};
+
+C10_API const char* toString(ThreadPoolKind kind);
+
+/**
+ * Process-wide thread budget shared by all thread pools.
+ *
+ * Every pool used to size itself from the number of cores, so a process
+ * running ATen ops, JIT forks and Caffe2 nets at once (or several such
+ * processes on one socket) would start several times as many busy threads
+ * as there are cores. When a budget is set, the pools instead take their
+ * size from it: pools with an explicit size keep it, and the rest of the
+ * budget goes to intra-op parallelism (the Caffe2 pool shares that part,
+ * since Caffe2 operators and ATen ops of one net don't run at the same
+ * time). Pool workers are bound to NUMA nodes with NUMABind(), either all
+ * to the configured node or spread over the nodes in contiguous blocks.
+ *
+ * Without a budget (the default) every pool keeps its own default size and
+ * binding, and numThreads() simply returns the caller's fallback.
+ *
+ * The budget is read when a pool starts, so it has to be configured
+ * before any parallel work is run, either through setTotalThreads() or
+ * through the --caffe2_thread_budget and --caffe2_thread_budget_numa_node
+ * flags.
+ */
+class C10_API ThreadBudget {
+ public:
+  static ThreadBudget& get();
+
+  /// @brief Whether a budget has been set.
+  bool enabled() const;
+
+  /// @brief Sets the total number of threads; 0 disables the budget.
+  void setTotalThreads(size_t total_threads);
+
+  size_t totalThreads() const;
+
+  /// @brief Restricts all pool workers to a NUMA node; -1 spreads them.
+  void setNUMANode(int numa_node_id);
+
+  int numaNode() const;
+
+  /// @brief Fixes the number of threads of one pool within the budget.
+  void setNumThreads(ThreadPoolKind kind, size_t num_threads);
+
+  /**
+   * Number of threads the given pool should run, or fallback if no budget
+   * is set and the pool has no explicit size.
+   */
+  size_t numThreads(ThreadPoolKind kind, size_t fallback) const;
+
+  /**
+   * NUMA node that worker `worker_index` of the given pool should run on,
+   * or -1 if it should not be bound.
+   */
+  int numaNodeForWorker(ThreadPoolKind kind, size_t worker_index) const;
+
+  /// @brief Binds the calling thread as worker `worker_index` of a pool.
+  void bindWorker(ThreadPoolKind kind, size_t worker_index) const;
+
+  /**
+   * Binds the calling thread as the next worker of a pool, for pools that
+   * don't hand out worker indices to their thread initializers.
+   */
+  void bindNextWorker(ThreadPoolKind kind);
+
+  /// @brief A human-readable description of the current partition.
+  std::string summary() const;
+
+ private:
+  ThreadBudget();
+
+  static constexpr size_t kNumKinds =
+      static_cast<size_t>(ThreadPoolKind::COMPILE_TIME_MAX_THREAD_POOL_KINDS);
+
+  size_t numThreadsLocked(ThreadPoolKind kind, size_t fallback) const;
+
+  mutable std::mutex mutex_;
+  size_t total_threads_;
+  int numa_node_id_;
+  // 0 means the pool takes its share from the budget
+  std::array<size_t, kNumKinds> explicit_threads_;
+  std::array<std::atomic<size_t>, kNumKinds> next_worker_;
+};
+
+} // namespace c10
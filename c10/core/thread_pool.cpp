@@ -1,7 +1,43 @@
 #include <c10/core/thread_pool.h>
+#include <c10/core/thread_budget.h>
+#include <c10/util/Metrics.h>
+
+#include <algorithm>
 
 namespace c10 {
 
+namespace {
+// The tasks of all the pools of the process, for monitoring saturation.
+struct PoolMetrics {
+  metrics::Counter* queued;
+  metrics::Counter* running;
+  metrics::Counter* completed;
+};
+
+const PoolMetrics& poolMetrics() {
+  static const PoolMetrics pool_metrics{
+      metrics::MetricsRegistry::get().gauge(
+          "c10_thread_pool_queued_tasks",
+          "Tasks queued in the thread pools and not started yet."),
+      metrics::MetricsRegistry::get().gauge(
+          "c10_thread_pool_running_tasks",
+          "Tasks running on the threads of the thread pools."),
+      metrics::MetricsRegistry::get().counter(
+          "c10_thread_pool_tasks_total", "Tasks run by the thread pools.")};
+  return pool_metrics;
+}
+
+void taskStarted() {
+  poolMetrics().queued->add(-1);
+  poolMetrics().running->add(1);
+}
+
+void taskFinished() {
+  poolMetrics().running->add(-1);
+  poolMetrics().completed->add();
+}
+} // namespace
+
 ThreadPool::ThreadPool(std::size_t pool_size, int numa_node_id)
     : threads_(pool_size),
       running_(true),
@@ -48,11 +84,16 @@ bool ThreadPool::inThreadPool() const {
 }
 
 void ThreadPool::run(const std::function<void()>& func) {
+  enqueue(task_element_t(func));
+}
+
+void ThreadPool::enqueue(task_element_t task) {
+  poolMetrics().queued->add(1);
   std::unique_lock<std::mutex> lock(mutex_);
 
   // Set task and signal condition variable so that a worker thread will
   // wake up and use the task.
-  tasks_.push(task_element_t(func));
+  tasks_.push(std::move(task));
   complete_ = false;
   condition_.notify_one();
 }
@@ -93,6 +134,7 @@ void ThreadPool::main_loop(std::size_t index) {
       lock.unlock();
 
       // Run the task.
+      taskStarted();
       try {
         if (tasks.run_with_id) {
           tasks.with_id(index);
@@ -101,6 +143,7 @@ void ThreadPool::main_loop(std::size_t index) {
         }
       } catch (const std::exception&) {
       }
+      taskFinished();
 
       // Update status of empty, maybe
       // Need to recover the lock first
@@ -120,17 +163,203 @@ void ThreadPool::main_loop(std::size_t index) {
   } // while running_
 }
 
+namespace {
+// Pool and index of the worker running on this thread, if any.
+thread_local const WorkStealingThreadPool* current_ws_pool = nullptr;
+thread_local int current_ws_index = -1;
+} // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(
+    std::size_t pool_size,
+    int numa_node_id,
+    std::function<void()> init_thread)
+    : numa_node_id_(numa_node_id),
+      init_thread_(std::move(init_thread)),
+      pending_(0),
+      max_pending_(0),
+      available_(pool_size),
+      next_queue_(0),
+      steals_(0),
+      running_(true) {
+  // Always keep at least one deque so that run() is valid on an empty pool;
+  // the tasks are then only executed through runPendingTask().
+  for (std::size_t i = 0; i < std::max<std::size_t>(pool_size, 1); ++i) {
+    queues_.emplace_back(new WorkerQueue());
+  }
+  threads_.reserve(pool_size);
+  for (std::size_t i = 0; i < pool_size; ++i) {
+    threads_.emplace_back(
+        std::bind(&WorkStealingThreadPool::main_loop, this, i));
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    running_ = false;
+    condition_.notify_all();
+  }
+
+  for (auto& t : threads_) {
+    try {
+      t.join();
+    } catch (const std::exception&) {
+    }
+  }
+}
+
+size_t WorkStealingThreadPool::size() const {
+  return threads_.size();
+}
+
+size_t WorkStealingThreadPool::numAvailable() const {
+  return available_;
+}
+
+size_t WorkStealingThreadPool::numSteals() const {
+  return steals_;
+}
+
+size_t WorkStealingThreadPool::numPending() const {
+  return pending_;
+}
+
+size_t WorkStealingThreadPool::maxPending() const {
+  return max_pending_;
+}
+
+bool WorkStealingThreadPool::inThreadPool() const {
+  return current_ws_pool == this;
+}
+
+int WorkStealingThreadPool::currentWorker() const {
+  return current_ws_pool == this ? current_ws_index : -1;
+}
+
+void WorkStealingThreadPool::run(const std::function<void()>& func) {
+  int self = currentWorker();
+  std::size_t index = self >= 0
+      ? static_cast<std::size_t>(self)
+      : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+  // Account for the task before it becomes visible, so a worker that pops
+  // it right away never drives the counter below zero.
+  poolMetrics().queued->add(1);
+  std::size_t pending = ++pending_;
+  std::size_t max_pending = max_pending_.load(std::memory_order_relaxed);
+  while (pending > max_pending &&
+         !max_pending_.compare_exchange_weak(max_pending, pending)) {
+  }
+  {
+    std::lock_guard<std::mutex> guard(queues_[index]->mutex);
+    queues_[index]->tasks.push_back(func);
+  }
+  // Notify under the pool mutex so that a worker which has just found
+  // pending_ == 0 cannot miss the wakeup.
+  std::lock_guard<std::mutex> lock(mutex_);
+  condition_.notify_one();
+}
+
+bool WorkStealingThreadPool::tryPop(
+    std::size_t index,
+    std::function<void()>& task) {
+  auto& queue = *queues_[index];
+  std::lock_guard<std::mutex> guard(queue.mutex);
+  if (queue.tasks.empty()) {
+    return false;
+  }
+  task = std::move(queue.tasks.back());
+  queue.tasks.pop_back();
+  return true;
+}
+
+bool WorkStealingThreadPool::trySteal(
+    std::size_t index,
+    std::function<void()>& task) {
+  for (std::size_t i = 1; i <= queues_.size(); ++i) {
+    auto& queue = *queues_[(index + i) % queues_.size()];
+    std::unique_lock<std::mutex> guard(queue.mutex, std::try_to_lock);
+    if (!guard.owns_lock() || queue.tasks.empty()) {
+      continue;
+    }
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    if ((index + i) % queues_.size() != index) {
+      ++steals_;
+    }
+    return true;
+  }
+  return false;
+}
+
+bool WorkStealingThreadPool::runPendingTask() {
+  if (pending_ == 0) {
+    return false;
+  }
+  int self = currentWorker();
+  std::size_t index = self >= 0 ? static_cast<std::size_t>(self) : 0;
+  std::function<void()> task;
+  if (!tryPop(index, task) && !trySteal(index, task)) {
+    return false;
+  }
+  --pending_;
+  taskStarted();
+  try {
+    task();
+  } catch (const std::exception&) {
+  }
+  taskFinished();
+  return true;
+}
+
+void WorkStealingThreadPool::main_loop(std::size_t index) {
+  current_ws_pool = this;
+  current_ws_index = static_cast<int>(index);
+  NUMABind(numa_node_id_);
+  if (init_thread_) {
+    init_thread_();
+  }
+
+  while (running_) {
+    std::function<void()> task;
+    if (tryPop(index, task) || trySteal(index, task)) {
+      --pending_;
+      --available_;
+      taskStarted();
+      try {
+        task();
+      } catch (const std::exception&) {
+      }
+      taskFinished();
+      ++available_;
+      continue;
+    }
+
+    // trySteal() skips contended deques, so only go to sleep once no task
+    // is accounted for anywhere in the pool.
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (pending_ == 0 && running_) {
+      condition_.wait(lock);
+    }
+  }
+}
+
 // constexpr initialization guaranteed to be before any static initialization
 std::atomic<int> num_threads{1};
 void setNumThreads(size_t v) {
   if(-1  == num_threads.exchange(v)) {
    throw std::runtime_error("Error: cannot set num threads after pool has started");
   }
+  ThreadBudget::get().setNumThreads(ThreadPoolKind::InterOp, v);
 }
 
 TaskThreadPoolBase& global_work_queue() {
   static std::shared_ptr<TaskThreadPoolBase> pool =
-      ThreadPoolRegistry()->Create("C10", 0, num_threads.exchange(-1), false);
+      ThreadPoolRegistry()->Create(
+          "C10",
+          0,
+          ThreadBudget::get().numThreads(
+              ThreadPoolKind::InterOp, num_threads.exchange(-1)),
+          false);
   return *pool;
 }
 
@@ -1,11 +1,15 @@
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include <c10/util/Optional.h>
 #include <c10/util/intrusive_ptr.h>
@@ -81,14 +85,8 @@ class C10_API ThreadPool : public c10::TaskThreadPoolBase {
 
   template <typename Task>
   void runTaskWithID(Task task) {
-    std::unique_lock<std::mutex> lock(mutex_);
-
-    // Set task and signal condition variable so that a worker thread will
-    // wake up and use the task.
-    tasks_.push(
+    enqueue(
         task_element_t(static_cast<std::function<void(std::size_t)>>(task)));
-    complete_ = false;
-    condition_.notify_one();
   }
 
   /// @brief Wait for queue to be empty
@@ -98,8 +96,86 @@ class C10_API ThreadPool : public c10::TaskThreadPoolBase {
   virtual void init_thread() {}
 
  private:
+  void enqueue(task_element_t task);
+
+  // @brief Entry point for pool threads.
+  void main_loop(std::size_t index);
+};
+
+/**
+ * A thread pool with one task deque per worker.
+ *
+ * Tasks submitted from a worker thread are pushed onto that worker's own
+ * deque and popped LIFO, so nested work stays hot in cache; tasks submitted
+ * from outside the pool are distributed round-robin. An idle worker steals
+ * FIFO from the other deques before going to sleep, so a single long task
+ * never leaves the rest of a queue stranded behind it.
+ */
+class C10_API WorkStealingThreadPool : public c10::TaskThreadPoolBase {
+ public:
+  WorkStealingThreadPool() = delete;
+
+  // init_thread, if given, runs first on every worker thread. It is passed
+  // in rather than overridden since the workers start inside this
+  // constructor, before a derived class would be constructed.
+  explicit WorkStealingThreadPool(
+      std::size_t pool_size,
+      int numa_node_id = -1,
+      std::function<void()> init_thread = nullptr);
+
+  ~WorkStealingThreadPool();
+
+  size_t size() const override;
+
+  size_t numAvailable() const override;
+
+  bool inThreadPool() const override;
+
+  void run(const std::function<void()>& func) override;
+
+  /**
+   * Pops (or steals) one pending task and runs it on the calling thread.
+   * Returns false if there was nothing to run. Lets a thread that is
+   * waiting on pool work help out instead of blocking.
+   */
+  bool runPendingTask();
+
+  /// @brief Number of tasks taken from another worker's deque so far.
+  size_t numSteals() const;
+
+  /// @brief Number of tasks queued but not started yet.
+  size_t numPending() const;
+
+  /// @brief Largest numPending() seen so far.
+  size_t maxPending() const;
+
+ private:
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  // Returns the index of the current thread in this pool, or -1.
+  int currentWorker() const;
+
+  bool tryPop(std::size_t index, std::function<void()>& task);
+  bool trySteal(std::size_t index, std::function<void()>& task);
+
   // @brief Entry point for pool threads.
   void main_loop(std::size_t index);
+
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+  std::vector<std::thread> threads_;
+  int numa_node_id_;
+  std::function<void()> init_thread_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::atomic<std::size_t> pending_;
+  std::atomic<std::size_t> max_pending_;
+  std::atomic<std::size_t> available_;
+  std::atomic<std::size_t> next_queue_;
+  std::atomic<std::size_t> steals_;
+  std::atomic_bool running_;
 };
 
 C10_API void setNumThreads(size_t v);
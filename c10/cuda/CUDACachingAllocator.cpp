@@ -3,11 +3,15 @@
 #include <c10/cuda/CUDAGuard.h>
 #include <c10/cuda/CUDAException.h>
 #include <c10/cuda/CUDAFunctions.h>
+#include <c10/util/Metrics.h>
+#include <c10/util/StaticTracepoint.h>
 #include <c10/util/UniqueVoidPtr.h>
 
 #include <cuda_runtime_api.h>
 #include <algorithm>
+#include <cstdlib>
 #include <deque>
+#include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -38,6 +42,22 @@ namespace CUDACachingAllocator {
 //   smallest available free block or allocate a new block using cudaMalloc.
 //   To reduce fragmentation, requests between 1MB and 10MB will allocate and
 //   split a 20MB block, if no free block of sufficient size is available.
+// - The splitting and rounding of large blocks and an eager garbage
+//   collection of cached blocks can be tuned at runtime through the
+//   PYTORCH_CUDA_ALLOC_CONF environment variable or setAllocatorSettings():
+//     max_split_size_mb:N      blocks of N MiB or more are never split, and
+//                              are only reused for requests of similar size
+//     roundup_power2_divisions:N  large requests are rounded up to one of N
+//                              (a power of two) sizes per power-of-two
+//                              interval, so that ragged sizes share blocks
+//     garbage_collection_threshold:F  once more than fraction F of the
+//                              device memory is cached, unused cached
+//                              segments are freed (least recently used
+//                              first) before calling cudaMalloc
+// - snapshot() lists every segment with its blocks. recordHistory() keeps a
+//   ring buffer of the latest alloc/free events and tags each block with an
+//   id from a user supplied recorder (e.g. an interned stack trace), to find
+//   out which allocations fragment memory.
 //
 // With this allocator, allocations and frees should logically be considered
 // "usages" of the memory segment associated with streams, just like kernel
@@ -49,6 +69,14 @@ namespace CUDACachingAllocator {
 // ensure that the block is not reused before each recorded stream completes
 // work.
 //
+// - By default all allocations share one memory pool. Private pools can be
+//   created with createPrivatePool() and selected either per stream
+//   (setStreamPool) or per thread (MempoolGuard). Blocks never move between
+//   pools, so independent workloads on one device don't fragment each
+//   other's cache, and each pool keeps its own statistics and its own queue
+//   of recordStream() events: a pool's frees are never held up behind
+//   events recorded by another pool.
+//
 
 
 
@@ -56,6 +84,9 @@ namespace {
 
 using stream_set = std::unordered_set<cuda::CUDAStream>;
 
+// pool that allocations on this thread are routed to, see MempoolGuard
+thread_local MempoolId_t current_mempool = kDefaultMempool;
+
 constexpr size_t kMinBlockSize = 512;       // all sizes are rounded to at least 512 bytes
 constexpr size_t kSmallSize = 1048576;      // largest "small" allocation is 1 MiB
 constexpr size_t kSmallBuffer = 2097152;    // "small" allocations are packed in 2 MiB blocks
@@ -63,15 +94,74 @@ constexpr size_t kLargeBuffer = 20971520;   // "large" allocations may be packed
 constexpr size_t kMinLargeAlloc = 10485760; // allocations between 1 and 10 MiB may use kLargeBuffer
 constexpr size_t kRoundLarge = 2097152;     // round up large allocs to 2 MiB
 
+// Runtime tunables, see setAllocatorSettings()
+struct AllocatorConfig {
+  size_t max_split_size = std::numeric_limits<size_t>::max();
+  size_t roundup_power2_divisions = 0;
+  double garbage_collection_threshold = 0.0;
+  bool managed_oversubscription = false;
+};
+
+AllocatorConfig parse_allocator_settings(const std::string& settings) {
+  AllocatorConfig config;
+  size_t pos = 0;
+  while (pos < settings.size()) {
+    size_t end = settings.find(',', pos);
+    if (end == std::string::npos) {
+      end = settings.size();
+    }
+    std::string option = settings.substr(pos, end - pos);
+    pos = end + 1;
+    if (option.empty()) {
+      continue;
+    }
+    size_t colon = option.find(':');
+    AT_CHECK(colon != std::string::npos,
+             "Invalid CUDA allocator setting '", option, "', expected key:value");
+    std::string key = option.substr(0, colon);
+    std::string value = option.substr(colon + 1);
+    char* value_end = nullptr;
+    if (key == "max_split_size_mb") {
+      long long mb = std::strtoll(value.c_str(), &value_end, 10);
+      AT_CHECK(*value_end == '\0' && mb * 1048576 > (long long)kLargeBuffer,
+               "CUDA allocator max_split_size_mb must be an integer larger than ",
+               kLargeBuffer / 1048576, ", got ", value);
+      config.max_split_size = static_cast<size_t>(mb) * 1048576;
+    } else if (key == "roundup_power2_divisions") {
+      long long divisions = std::strtoll(value.c_str(), &value_end, 10);
+      AT_CHECK(*value_end == '\0' && divisions >= 0 &&
+                   (divisions & (divisions - 1)) == 0,
+               "CUDA allocator roundup_power2_divisions must be 0 or a power "
+               "of two, got ", value);
+      config.roundup_power2_divisions = static_cast<size_t>(divisions);
+    } else if (key == "garbage_collection_threshold") {
+      double threshold = std::strtod(value.c_str(), &value_end);
+      AT_CHECK(*value_end == '\0' && threshold > 0.0 && threshold < 1.0,
+               "CUDA allocator garbage_collection_threshold must be in (0, 1), "
+               "got ", value);
+      config.garbage_collection_threshold = threshold;
+    } else if (key == "managed_oversubscription") {
+      AT_CHECK(value == "True" || value == "False",
+               "CUDA allocator managed_oversubscription must be True or "
+               "False, got ", value);
+      config.managed_oversubscription = value == "True";
+    } else {
+      AT_ERROR("Unknown CUDA allocator setting: ", key);
+    }
+  }
+  return config;
+}
+
 struct DeviceStats {
   uint64_t   amount_allocated;      // total amount allocated in bytes
   uint64_t   max_amount_allocated;  // max total amount allocated in bytes
   uint64_t   amount_cached;         // total amount in cache in bytes
   uint64_t   max_amount_cached;     // max total amount in cache in bytes
+  uint64_t   amount_managed;        // part of amount_cached in managed memory
 
   DeviceStats() :
       amount_allocated(0), max_amount_allocated(0),
-      amount_cached(0), max_amount_cached(0) { }
+      amount_cached(0), max_amount_cached(0), amount_managed(0) { }
 
   void increaseAllocated(size_t delta) {
     amount_allocated += delta;
@@ -93,6 +183,7 @@ struct DeviceStats {
 };
 
 struct Block;
+struct MemoryPool;
 typedef bool (*Comparison)(const Block*, const Block*);
 typedef std::set<Block*, Comparison> BlockPool;
 
@@ -101,21 +192,29 @@ struct Block {
   cudaStream_t  stream;      // allocation stream
   stream_set    stream_uses; // streams on which the block was used
   size_t        size;        // block size in bytes
-  BlockPool*    pool;        // owning memory pool
+  BlockPool*    pool;        // owning set of free blocks (large or small)
+  MemoryPool*   mempool;     // owning memory pool
   void*         ptr;         // memory address
   bool          allocated;   // in-use flag
   Block*        prev;        // prev block if split from a larger allocation
   Block*        next;        // next block if split from a larger allocation
   int           event_count; // number of outstanding CUDA events
+  uint64_t      free_order;  // value of the allocator's free counter when
+                             // this block was last returned to the cache
+  uint64_t      context;     // id from the context recorder at allocation
+  bool          managed;     // part of a cudaMallocManaged segment
 
-  Block(int device, cudaStream_t stream, size_t size, BlockPool* pool, void* ptr) :
+  Block(int device, cudaStream_t stream, size_t size, BlockPool* pool,
+        MemoryPool* mempool, void* ptr, bool managed = false) :
     device(device), stream(stream), stream_uses(), size(size), pool(pool),
-    ptr(ptr), allocated(0), prev(nullptr), next(nullptr), event_count(0) { }
+    mempool(mempool), ptr(ptr), allocated(0), prev(nullptr), next(nullptr),
+    event_count(0), free_order(0), context(0), managed(managed) { }
 
   // constructor for search key
   Block(int device, cudaStream_t stream, size_t size) :
     device(device), stream(stream), stream_uses(), size(size), pool(nullptr),
-    ptr(nullptr), allocated(0), prev(nullptr), next(nullptr), event_count(0) { }
+    mempool(nullptr), ptr(nullptr), allocated(0), prev(nullptr), next(nullptr),
+    event_count(0), free_order(0), context(0), managed(false) { }
 };
 
 static bool BlockComparator(const Block* a, const Block* b)
@@ -132,6 +231,46 @@ static bool BlockComparator(const Block* a, const Block* b)
   return (uintptr_t)a->ptr < (uintptr_t)b->ptr;
 }
 
+// A set of cached blocks that is never shared with other pools
+struct MemoryPool {
+  explicit MemoryPool(MempoolId_t id) :
+      id(id), large_blocks(BlockComparator), small_blocks(BlockComparator),
+      num_allocated_blocks(0), released(false) {}
+
+  const MempoolId_t id;
+
+  // cached blocks larger than 1 MB
+  BlockPool large_blocks;
+
+  // cached blocks 1 MB or smaller
+  BlockPool small_blocks;
+
+  // outstanding cuda events for blocks of this pool
+  std::deque<std::pair<cudaEvent_t, Block*>> cuda_events;
+
+  // per-device statistics of this pool
+  std::vector<DeviceStats> device_stats;
+
+  // number of blocks handed out and not yet returned to the pool
+  size_t num_allocated_blocks;
+
+  // set by releasePrivatePool(); the pool is destroyed once it is unused
+  bool released;
+
+  DeviceStats &get_stats_for_device(int device) {
+    AT_ASSERT(device >= 0);
+    if ((size_t) device >= device_stats.size()) {
+      device_stats.resize(device + 1);
+    }
+    return device_stats.at(device);
+  }
+
+  bool empty() const {
+    return num_allocated_blocks == 0 && cuda_events.empty() &&
+        large_blocks.empty() && small_blocks.empty();
+  }
+};
+
 static std::string format_size(uint64_t size) {
   std::ostringstream os;
   os.precision(2);
@@ -164,21 +303,61 @@ struct THCCachingAllocator
   // lock around calls to cudaFree (to prevent deadlocks with NCCL)
   std::mutex cuda_free_mutex;
 
-  // cached blocks larger than 1 MB
-  BlockPool large_blocks;
+  // memory pools by id; kDefaultMempool is always present
+  std::unordered_map<MempoolId_t, std::unique_ptr<MemoryPool>> mempools;
 
-  // cached blocks 1 MB or smaller
-  BlockPool small_blocks;
+  // next id handed out by create_pool()
+  MempoolId_t next_mempool_id;
+
+  // private pools assigned to streams
+  std::unordered_map<cudaStream_t, MempoolId_t> stream_mempools;
 
   // allocated blocks by device pointer
   std::unordered_map<void*, Block*> allocated_blocks;
 
-  // outstanding cuda events
-  std::deque<std::pair<cudaEvent_t, Block*>> cuda_events;
+  // IPC handles of segments shared with other processes, by segment address;
+  // dropped when the segment is freed
+  std::unordered_map<void*, std::string> ipc_handles;
+
+  // runtime tunables
+  AllocatorConfig config;
+
+  // incremented whenever a block is returned to the cache
+  uint64_t free_counter;
+
+  // total memory of each device, queried lazily for garbage collection
+  std::vector<size_t> device_total_memory;
+
+  // whether each device can oversubscribe managed memory, queried lazily:
+  // 1 if it can, 0 if it can't, -1 if not queried yet
+  std::vector<int> device_managed_oversubscription;
+
+  // allocation history, see record_history()
+  bool record_history_enabled;
+  ContextRecorder context_recorder;
+  size_t trace_max_entries;
+  size_t trace_next;  // slot overwritten by the next entry once full
+  std::vector<TraceEntry> trace;
+
+  THCCachingAllocator() : next_mempool_id(kDefaultMempool + 1),
+                          free_counter(0), record_history_enabled(false),
+                          context_recorder(nullptr), trace_max_entries(0),
+                          trace_next(0) {
+    mempools.emplace(
+        kDefaultMempool,
+        std::unique_ptr<MemoryPool>(new MemoryPool(kDefaultMempool)));
+    const char* settings = std::getenv("PYTORCH_CUDA_ALLOC_CONF");
+    if (settings) {
+      config = parse_allocator_settings(settings);
+    }
+  }
 
-  THCCachingAllocator() :
-      large_blocks(BlockComparator),
-      small_blocks(BlockComparator) {}
+  void set_settings(const std::string& settings)
+  {
+    AllocatorConfig new_config = parse_allocator_settings(settings);
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    config = new_config;
+  }
 
   DeviceStats &get_stats_for_device(int device) {
     AT_ASSERT(device >= 0);
@@ -191,30 +370,49 @@ struct THCCachingAllocator
   /** allocates a block which is safe to use from the provided stream */
   void malloc(void** devPtr, size_t size, cudaStream_t stream)
   {
+    static auto* allocations = metrics::MetricsRegistry::get().counter(
+        "c10_cuda_caching_allocator_allocations_total",
+        "Allocations of the CUDA caching allocator.");
+    allocations->add();
+
     std::lock_guard<std::recursive_mutex> lock(mutex);
 
     int device;
     C10_CUDA_CHECK(cudaGetDevice(&device));
 
+    MemoryPool& mempool = select_pool(stream);
+
     // process outstanding cudaEvents
-    process_events();
+    process_events(mempool);
+    process_released_pool_events();
 
     size = round_size(size);
 
     DeviceStats &stats = get_stats_for_device(device);
+    DeviceStats &pool_stats = mempool.get_stats_for_device(device);
 
     Block search_key(device, stream, size);
-    auto& pool = get_pool(size);
+    auto& pool = get_pool(mempool, size);
 
     auto find_free_block = [&]()->Block*{
       auto it = pool.lower_bound(&search_key);
-      if (it != pool.end() && (*it)->device == device &&
-          (*it)->stream == stream) {
-        Block* block = *it;
-        pool.erase(it);
-        return block;
+      if (it == pool.end() || (*it)->device != device ||
+          (*it)->stream != stream) {
+        return nullptr;
       }
-      return nullptr;
+      // Blocks too large to be split are only handed out for requests of
+      // about their size, or the unsplittable remainder would be wasted.
+      if (size < config.max_split_size &&
+          (*it)->size >= config.max_split_size) {
+        return nullptr;
+      }
+      if (size >= config.max_split_size &&
+          (*it)->size >= size + kLargeBuffer) {
+        return nullptr;
+      }
+      Block* block = *it;
+      pool.erase(it);
+      return block;
     };
 
     Block* block = find_free_block();
@@ -231,7 +429,19 @@ struct THCCachingAllocator
     if (block == nullptr) {
       void* ptr;
       size_t alloc_size = get_allocation_size(size);
+      C10_SDT(cuda_cache_miss, alloc_size, device);
+      if (config.garbage_collection_threshold > 0.0) {
+        garbage_collect(device);
+      }
       cudaError_t err = cuda_malloc_retry(device, &ptr, alloc_size);
+      bool managed = false;
+      if (err == cudaErrorMemoryAllocation && size > kSmallSize &&
+          config.managed_oversubscription &&
+          supports_managed_oversubscription(device)) {
+        cudaGetLastError();  // clear CUDA error
+        err = cuda_malloc_managed(device, &ptr, alloc_size);
+        managed = err == cudaSuccess;
+      }
       if (err != cudaSuccess) {
         if (err == cudaErrorMemoryAllocation) {
           cudaGetLastError();  // clear CUDA error
@@ -270,7 +480,13 @@ struct THCCachingAllocator
         }
       }
       stats.increaseCached(alloc_size);
-      block = new Block(device, stream, alloc_size, &pool, ptr);
+      pool_stats.increaseCached(alloc_size);
+      if (managed) {
+        stats.amount_managed += alloc_size;
+      }
+      block = new Block(device, stream, alloc_size, &pool, &mempool, ptr,
+                        managed);
+      record_trace(TraceEntry::SEGMENT_ALLOC, block);
     }
 
     Block* remaining = nullptr;
@@ -279,7 +495,8 @@ struct THCCachingAllocator
 
       remaining = block;
 
-      block = new Block(device, stream, size, &pool, block->ptr);
+      block = new Block(device, stream, size, &pool, &mempool, block->ptr,
+                        remaining->managed);
       block->prev = remaining->prev;
       if (block->prev) {
         block->prev->next = block;
@@ -294,10 +511,25 @@ struct THCCachingAllocator
 
     block->allocated = true;
     allocated_blocks[block->ptr] = block;
+    if (record_history_enabled) {
+      block->context = context_recorder ? context_recorder() : 0;
+      record_trace(TraceEntry::ALLOC, block);
+    }
+
+    if (block->managed) {
+      prefetch_managed(block, stream);
+    }
 
     *devPtr = block->ptr;
 
+    mempool.num_allocated_blocks++;
     stats.increaseAllocated(block->size);
+    pool_stats.increaseAllocated(block->size);
+    C10_SDT(cuda_alloc, block->ptr, block->size, device, stream);
+    if (auto hook = GetMemoryEventHook()) {
+      hook(block->ptr, static_cast<int64_t>(block->size),
+           Device(DeviceType::CUDA, device));
+    }
   }
 
   void free(void* ptr)
@@ -315,12 +547,26 @@ struct THCCachingAllocator
     Block* block = it->second;
     allocated_blocks.erase(it);
     block->allocated = false;
+    record_trace(TraceEntry::FREE, block);
+    C10_SDT(cuda_free, block->ptr, block->size, block->device);
+    if (auto hook = GetMemoryEventHook()) {
+      hook(block->ptr, -static_cast<int64_t>(block->size),
+           Device(DeviceType::CUDA, block->device));
+    }
+    // free_block may delete the block
+    bool block_mempool_released = block->mempool->released;
 
     get_stats_for_device(block->device).decreaseAllocated(block->size);
+    block->mempool->get_stats_for_device(block->device)
+        .decreaseAllocated(block->size);
+    block->mempool->num_allocated_blocks--;
     if (!block->stream_uses.empty()) {
       insert_events(block);
     } else {
       free_block(block);
+      if (block_mempool_released) {
+        erase_released_pools();
+      }
     }
   }
 
@@ -329,8 +575,116 @@ struct THCCachingAllocator
   {
     std::lock_guard<std::recursive_mutex> lock(mutex);
     synchronize_and_free_events(nullopt);
-    free_blocks(large_blocks, large_blocks.begin(), large_blocks.end());
-    free_blocks(small_blocks, small_blocks.begin(), small_blocks.end());
+    for (auto& entry : mempools) {
+      auto& mempool = *entry.second;
+      free_blocks(mempool.large_blocks, mempool.large_blocks.begin(),
+                  mempool.large_blocks.end());
+      free_blocks(mempool.small_blocks, mempool.small_blocks.begin(),
+                  mempool.small_blocks.end());
+    }
+    erase_released_pools();
+  }
+
+  MempoolId_t create_pool()
+  {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    MempoolId_t id = next_mempool_id++;
+    mempools.emplace(id, std::unique_ptr<MemoryPool>(new MemoryPool(id)));
+    return id;
+  }
+
+  void release_pool(MempoolId_t id)
+  {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    AT_CHECK(id != kDefaultMempool, "cannot release the default memory pool");
+    MemoryPool& mempool = get_mempool(id);
+    for (auto it = stream_mempools.begin(); it != stream_mempools.end();) {
+      if (it->second == id) {
+        it = stream_mempools.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    mempool.released = true;
+    // Return what is cached now; blocks that are still in use are freed
+    // as they come back (see free_block).
+    free_blocks(mempool.large_blocks, mempool.large_blocks.begin(),
+                mempool.large_blocks.end());
+    free_blocks(mempool.small_blocks, mempool.small_blocks.begin(),
+                mempool.small_blocks.end());
+    erase_released_pools();
+  }
+
+  void set_stream_pool(cudaStream_t stream, MempoolId_t id)
+  {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (id == kDefaultMempool) {
+      stream_mempools.erase(stream);
+      return;
+    }
+    AT_CHECK(!get_mempool(id).released,
+             "memory pool ", id, " has already been released");
+    stream_mempools[stream] = id;
+  }
+
+  PoolStats pool_stats(int device, MempoolId_t id)
+  {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    const DeviceStats& stats = get_mempool(id).get_stats_for_device(device);
+    PoolStats result;
+    result.amount_allocated = stats.amount_allocated;
+    result.max_amount_allocated = stats.max_amount_allocated;
+    result.amount_cached = stats.amount_cached;
+    result.max_amount_cached = stats.max_amount_cached;
+    return result;
+  }
+
+  MemoryPool& get_mempool(MempoolId_t id)
+  {
+    auto it = mempools.find(id);
+    AT_CHECK(it != mempools.end(), "invalid memory pool id: ", id);
+    return *it->second;
+  }
+
+  /** the pool that allocations on the current thread and stream come from */
+  MemoryPool& select_pool(cudaStream_t stream)
+  {
+    MempoolId_t id = current_mempool;
+    if (id == kDefaultMempool && !stream_mempools.empty()) {
+      auto it = stream_mempools.find(stream);
+      if (it != stream_mempools.end()) {
+        id = it->second;
+      }
+    }
+    MemoryPool& mempool = get_mempool(id);
+    AT_CHECK(!mempool.released,
+             "memory pool ", id, " has already been released");
+    return mempool;
+  }
+
+  void process_released_pool_events()
+  {
+    bool any_released = false;
+    for (auto& entry : mempools) {
+      if (entry.second->released) {
+        process_events(*entry.second);
+        any_released = true;
+      }
+    }
+    if (any_released) {
+      erase_released_pools();
+    }
+  }
+
+  void erase_released_pools()
+  {
+    for (auto it = mempools.begin(); it != mempools.end();) {
+      if (it->second->released && it->second->empty()) {
+        it = mempools.erase(it);
+      } else {
+        ++it;
+      }
+    }
   }
 
   void* getBaseAllocation(void* ptr, size_t* outSize)
@@ -355,6 +709,33 @@ struct THCCachingAllocator
     return basePtr;
   }
 
+  std::string getIpcMemHandle(void* ptr, size_t* offset)
+  {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    Block* block = find_allocated_block(ptr);
+    if (!block) {
+      AT_ERROR("invalid device pointer: %p", ptr);
+    }
+    AT_CHECK(!block->managed,
+             "CUDA IPC doesn't support managed memory, which backs this "
+             "allocation (see managed_oversubscription)");
+    while (block->prev) {
+      block = block->prev;
+    }
+    if (offset) {
+      *offset = static_cast<char*>(ptr) - static_cast<char*>(block->ptr);
+    }
+    auto it = ipc_handles.find(block->ptr);
+    if (it != ipc_handles.end()) {
+      return it->second;
+    }
+    cudaIpcMemHandle_t handle;
+    C10_CUDA_CHECK(cudaIpcGetMemHandle(&handle, block->ptr));
+    std::string handle_str(reinterpret_cast<const char*>(&handle), CUDA_IPC_HANDLE_SIZE);
+    ipc_handles.emplace(block->ptr, handle_str);
+    return handle_str;
+  }
+
   // Accumulates sizes of all memory blocks for given device in given pool
   void cacheInfoAux(BlockPool& blocks, int dev_id, size_t* total, size_t* largest)
   {
@@ -369,11 +750,170 @@ struct THCCachingAllocator
     }
   }
 
+  CacheInfo cacheInfo(int dev_id)
+  {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    CacheInfo info;
+    Block search_key(dev_id, 0, 0);
+    for (auto& entry : mempools) {
+      for (BlockPool* pool :
+           {&entry.second->large_blocks, &entry.second->small_blocks}) {
+        auto it = pool->lower_bound(&search_key);
+        for (; it != pool->end() && (*it)->device == dev_id; ++it) {
+          const Block* block = *it;
+          info.cached_and_free += block->size;
+          info.largest_block = std::max(info.largest_block, block->size);
+          info.num_free_blocks++;
+          if (block->prev || block->next) {
+            info.free_in_split_segments += block->size;
+          }
+          if (block->size >= config.max_split_size) {
+            info.num_oversize_blocks++;
+          }
+        }
+      }
+    }
+    // Segments are identified by their first block; walk every segment on
+    // the device that has at least one allocated block.
+    std::unordered_set<const Block*> seen;
+    for (const auto& entry : allocated_blocks) {
+      const Block* head = entry.second;
+      if (head->device != dev_id) {
+        continue;
+      }
+      while (head->prev) {
+        head = head->prev;
+      }
+      if (seen.insert(head).second) {
+        info.num_segments++;
+      }
+    }
+    // ...plus the segments that are entirely free
+    for (auto& entry : mempools) {
+      for (BlockPool* pool :
+           {&entry.second->large_blocks, &entry.second->small_blocks}) {
+        auto it = pool->lower_bound(&search_key);
+        for (; it != pool->end() && (*it)->device == dev_id; ++it) {
+          if (!(*it)->prev && !(*it)->next) {
+            info.num_segments++;
+          }
+        }
+      }
+    }
+    return info;
+  }
+
+  std::vector<SegmentInfo> snapshot()
+  {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    // A segment is identified by its first block
+    std::vector<const Block*> heads;
+    auto add_head = [&](const Block* block) {
+      if (!block->prev) {
+        heads.push_back(block);
+      }
+    };
+    for (const auto& entry : allocated_blocks) {
+      add_head(entry.second);
+    }
+    for (const auto& entry : mempools) {
+      for (const Block* block : entry.second->large_blocks) {
+        add_head(block);
+      }
+      for (const Block* block : entry.second->small_blocks) {
+        add_head(block);
+      }
+      for (const auto& event : entry.second->cuda_events) {
+        // blocks freed while in use on other streams are in no set yet
+        if (!event.second->allocated) {
+          add_head(event.second);
+        }
+      }
+    }
+    std::sort(heads.begin(), heads.end(), [](const Block* a, const Block* b) {
+      if (a->device != b->device) {
+        return a->device < b->device;
+      }
+      return (uintptr_t)a->ptr < (uintptr_t)b->ptr;
+    });
+    heads.erase(std::unique(heads.begin(), heads.end()), heads.end());
+
+    std::vector<SegmentInfo> segments;
+    segments.reserve(heads.size());
+    for (const Block* head : heads) {
+      SegmentInfo segment;
+      segment.device = head->device;
+      segment.address = reinterpret_cast<uintptr_t>(head->ptr);
+      segment.stream = head->stream;
+      segment.mempool = head->mempool->id;
+      segment.is_large = head->pool == &head->mempool->large_blocks;
+      segment.is_managed = head->managed;
+      for (const Block* block = head; block; block = block->next) {
+        BlockInfo info;
+        info.size = block->size;
+        info.allocated = block->allocated;
+        info.context = block->context;
+        segment.total_size += block->size;
+        if (block->allocated) {
+          segment.allocated_size += block->size;
+        }
+        segment.blocks.push_back(info);
+      }
+      segments.push_back(std::move(segment));
+    }
+    return segments;
+  }
+
+  void record_history(bool enabled, size_t max_entries, ContextRecorder recorder)
+  {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    record_history_enabled = enabled;
+    context_recorder = enabled ? recorder : nullptr;
+    trace_max_entries = enabled ? max_entries : 0;
+    trace_next = 0;
+    trace.clear();
+    trace.shrink_to_fit();
+    trace.reserve(trace_max_entries);
+  }
+
+  std::vector<TraceEntry> get_trace()
+  {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    std::vector<TraceEntry> result;
+    result.reserve(trace.size());
+    result.insert(result.end(), trace.begin() + trace_next, trace.end());
+    result.insert(result.end(), trace.begin(), trace.begin() + trace_next);
+    return result;
+  }
+
+  void record_trace(TraceEntry::Action action, const Block* block)
+  {
+    if (trace_max_entries == 0) {
+      return;
+    }
+    TraceEntry entry;
+    entry.action = action;
+    entry.device = block->device;
+    entry.addr = reinterpret_cast<uintptr_t>(block->ptr);
+    entry.size = block->size;
+    entry.stream = block->stream;
+    entry.context = block->context;
+    if (trace.size() < trace_max_entries) {
+      trace.push_back(entry);
+    } else {
+      trace[trace_next] = entry;
+      trace_next = (trace_next + 1) % trace_max_entries;
+    }
+  }
+
   void cacheInfo(int dev_id, size_t* total, size_t* largest)
   {
     std::lock_guard<std::recursive_mutex> lock(mutex);
-    cacheInfoAux(large_blocks, dev_id, total, largest);
-    cacheInfoAux(small_blocks, dev_id, total, largest);
+    for (auto& entry : mempools) {
+      cacheInfoAux(entry.second->large_blocks, dev_id, total, largest);
+      cacheInfoAux(entry.second->small_blocks, dev_id, total, largest);
+    }
   }
 
   void recordStream(void* ptr, cuda::CUDAStream stream)
@@ -398,7 +938,15 @@ struct THCCachingAllocator
     auto& pool = *block->pool;
     try_merge_blocks(block, block->prev, pool);
     try_merge_blocks(block, block->next, pool);
+    block->free_order = ++free_counter;
     pool.insert(block);
+
+    if (block->mempool->released && !block->prev && !block->next) {
+      // Nothing can be allocated from a released pool anymore, so hand the
+      // segment straight back once it is entirely free.
+      auto it = pool.find(block);
+      free_blocks(pool, it, std::next(it));
+    }
   }
 
   /** combine previously split blocks */
@@ -424,20 +972,20 @@ struct THCCachingAllocator
     delete src;
   }
 
-  BlockPool& get_pool(size_t size) {
+  BlockPool& get_pool(MemoryPool& mempool, size_t size) {
     if (size <= kSmallSize) {
-      return small_blocks;
+      return mempool.small_blocks;
     } else {
-      return large_blocks;
+      return mempool.large_blocks;
     }
   }
 
   bool should_split(Block* block, size_t size) {
     size_t remaining = block->size - size;
-    if (block->pool == &small_blocks) {
+    if (block->pool == &block->mempool->small_blocks) {
       return remaining >= kMinBlockSize;
-    } else if (block->pool == &large_blocks) {
-      return remaining > kSmallSize;
+    } else if (block->pool == &block->mempool->large_blocks) {
+      return size < config.max_split_size && remaining > kSmallSize;
     } else {
       AT_ERROR("should_split: invalid pool");
     }
@@ -446,11 +994,76 @@ struct THCCachingAllocator
   size_t round_size(size_t size) {
     if (size < kMinBlockSize) {
       return kMinBlockSize;
+    } else if (size > kSmallSize && config.roundup_power2_divisions > 0) {
+      return round_power2_division(size, config.roundup_power2_divisions);
     } else {
       return kMinBlockSize * ((size + kMinBlockSize - 1) / kMinBlockSize);
     }
   }
 
+  // Rounds up to the next of `divisions` equally spaced sizes between the
+  // powers of two around `size`, e.g. for 4 divisions 1280 MiB is rounded
+  // up to one of 1024, 1280, 1536, 1792 or 2048 MiB.
+  static size_t round_power2_division(size_t size, size_t divisions) {
+    size_t power2_floor = 1;
+    while (power2_floor <= size / 2) {
+      power2_floor <<= 1;
+    }
+    if (power2_floor == size) {
+      return size;
+    }
+    size_t division = std::max(power2_floor / divisions, kMinBlockSize);
+    return division * ((size + division - 1) / division);
+  }
+
+  size_t get_device_total_memory(int device) {
+    if ((size_t) device >= device_total_memory.size()) {
+      device_total_memory.resize(device + 1, 0);
+    }
+    if (device_total_memory[device] == 0) {
+      size_t device_free;
+      C10_CUDA_CHECK(cudaMemGetInfo(&device_free, &device_total_memory[device]));
+    }
+    return device_total_memory[device];
+  }
+
+  /** frees least recently used cached segments until under the gc threshold */
+  void garbage_collect(int device)
+  {
+    DeviceStats& stats = get_stats_for_device(device);
+    size_t threshold = static_cast<size_t>(
+        config.garbage_collection_threshold * get_device_total_memory(device));
+    if (stats.amount_cached <= threshold) {
+      return;
+    }
+
+    // Only whole segments can be returned to the driver
+    std::vector<Block*> candidates;
+    for (auto& entry : mempools) {
+      for (BlockPool* pool :
+           {&entry.second->large_blocks, &entry.second->small_blocks}) {
+        for (Block* block : *pool) {
+          if (block->device == device && !block->prev && !block->next) {
+            candidates.push_back(block);
+          }
+        }
+      }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Block* a, const Block* b) {
+                return a->free_order < b->free_order;
+              });
+
+    for (Block* block : candidates) {
+      if (stats.amount_cached <= threshold) {
+        break;
+      }
+      BlockPool& pool = *block->pool;
+      auto it = pool.find(block);
+      free_blocks(pool, it, std::next(it));
+    }
+  }
+
   size_t get_allocation_size(size_t size) {
     if (size <= kSmallSize) {
       return kSmallBuffer;
@@ -463,10 +1076,20 @@ struct THCCachingAllocator
 
   cudaError_t cuda_malloc_retry(int device, void** devPtr, size_t size)
   {
+    static auto* mallocs = metrics::MetricsRegistry::get().counter(
+        "c10_cuda_caching_allocator_cuda_mallocs_total",
+        "Allocations of the CUDA caching allocator which called cudaMalloc.");
+    static auto* retries = metrics::MetricsRegistry::get().counter(
+        "c10_cuda_caching_allocator_malloc_retries_total",
+        "cudaMalloc calls which failed and were retried after freeing the "
+        "cached blocks.");
+    mallocs->add();
+
     // Try cudaMalloc. If cudaMalloc fails, frees all non-split cached blocks
     // and retries.
     cudaError_t err = cudaMalloc(devPtr, size);
     if (err != cudaSuccess) {
+      retries->add();
       cudaGetLastError();  // reset the last CUDA error
       free_cached_blocks(device);
       err = cudaMalloc(devPtr, size);
@@ -477,24 +1100,80 @@ struct THCCachingAllocator
     return cudaSuccess;
   }
 
+  // Managed memory only oversubscribes the device where its pages can
+  // migrate on demand, from Pascal on and not on Windows.
+  bool supports_managed_oversubscription(int device)
+  {
+    if ((size_t) device >= device_managed_oversubscription.size()) {
+      device_managed_oversubscription.resize(device + 1, -1);
+    }
+    int& supported = device_managed_oversubscription[device];
+    if (supported < 0) {
+      C10_CUDA_CHECK(cudaDeviceGetAttribute(
+          &supported, cudaDevAttrConcurrentManagedAccess, device));
+      supported = supported ? 1 : 0;
+    }
+    return supported == 1;
+  }
+
+  // Backs a segment that doesn't fit on the device with managed memory:
+  // its pages prefer to live on the device and are mapped there, so that
+  // the driver evicts the least recently used pages of managed segments to
+  // the host under pressure, and the device reads evicted pages over the
+  // bus rather than failing the allocation.
+  cudaError_t cuda_malloc_managed(int device, void** devPtr, size_t size)
+  {
+    static auto* managed_mallocs = metrics::MetricsRegistry::get().counter(
+        "c10_cuda_caching_allocator_managed_mallocs_total",
+        "Allocations of the CUDA caching allocator which didn't fit on the "
+        "device and called cudaMallocManaged.");
+    cudaError_t err = cudaMallocManaged(devPtr, size);
+    if (err != cudaSuccess) {
+      return err;
+    }
+    managed_mallocs->add();
+    C10_CUDA_CHECK(cudaMemAdvise(
+        *devPtr, size, cudaMemAdviseSetPreferredLocation, device));
+    C10_CUDA_CHECK(cudaMemAdvise(
+        *devPtr, size, cudaMemAdviseSetAccessedBy, device));
+    return cudaSuccess;
+  }
+
+  // Migrates the pages of a managed block that were evicted to the host back
+  // to the device ahead of the stream using it, instead of on the page
+  // faults of its first kernels.
+  void prefetch_managed(Block* block, cudaStream_t stream)
+  {
+    static auto* prefetched = metrics::MetricsRegistry::get().counter(
+        "c10_cuda_caching_allocator_managed_prefetched_bytes_total",
+        "Bytes of managed memory prefetched to the devices by the CUDA "
+        "caching allocator as it handed them out.");
+    C10_CUDA_CHECK(cudaMemPrefetchAsync(
+        block->ptr, block->size, block->device, stream));
+    prefetched->add(static_cast<int64_t>(block->size));
+  }
+
   void free_cached_blocks(int device)
   {
     // First ensure that all blocks that can't currently be allocated due to
     // outstanding events are returned to the pool.
     synchronize_and_free_events(device);
 
-    // Free all non-split cached blocks on device
+    // Free all non-split cached blocks on device, in every pool
     Block lower_bound(device, nullptr, 0);
     Block upper_bound(device + 1, nullptr, 0);
 
-    free_blocks(
-        large_blocks,
-        large_blocks.lower_bound(&lower_bound),
-        large_blocks.lower_bound(&upper_bound));
-    free_blocks(
-        small_blocks,
-        small_blocks.lower_bound(&lower_bound),
-        small_blocks.lower_bound(&upper_bound));
+    for (auto& entry : mempools) {
+      auto& mempool = *entry.second;
+      free_blocks(
+          mempool.large_blocks,
+          mempool.large_blocks.lower_bound(&lower_bound),
+          mempool.large_blocks.lower_bound(&upper_bound));
+      free_blocks(
+          mempool.small_blocks,
+          mempool.small_blocks.lower_bound(&lower_bound),
+          mempool.small_blocks.lower_bound(&upper_bound));
+    }
   }
 
   void free_blocks(BlockPool& blocks, BlockPool::iterator it, BlockPool::iterator end)
@@ -505,7 +1184,14 @@ struct THCCachingAllocator
       Block* block = *it;
       if (!block->prev && !block->next) {
         C10_CUDA_CHECK(cudaFree((void*)block->ptr));
+        ipc_handles.erase(block->ptr);
+        record_trace(TraceEntry::SEGMENT_FREE, block);
         get_stats_for_device(block->device).decreaseCached(block->size);
+        if (block->managed) {
+          get_stats_for_device(block->device).amount_managed -= block->size;
+        }
+        block->mempool->get_stats_for_device(block->device)
+            .decreaseCached(block->size);
         auto cur = it;
         ++it;
         blocks.erase(cur);
@@ -519,8 +1205,14 @@ struct THCCachingAllocator
   void synchronize_and_free_events(optional<int> device) {
     // Synchronize on outstanding events and then free associated blocks.
     // Limited to blocks on the given device if specified.
+    for (auto& entry : mempools) {
+      synchronize_and_free_events(*entry.second, device);
+    }
+  }
 
-    auto remaining_events = decltype(cuda_events)();
+  void synchronize_and_free_events(MemoryPool& mempool, optional<int> device) {
+    auto& cuda_events = mempool.cuda_events;
+    auto remaining_events = std::deque<std::pair<cudaEvent_t, Block*>>();
 
     for (auto& e : cuda_events) {
       cudaEvent_t event = e.first;
@@ -565,19 +1257,20 @@ struct THCCachingAllocator
       C10_CUDA_CHECK(cudaEventRecord(event, it->stream()));
 
       block->event_count++;
-      cuda_events.emplace_back(event, block);
+      block->mempool->cuda_events.emplace_back(event, block);
     }
 
     C10_CUDA_CHECK(cudaSetDevice(prev_device));
   }
 
-  void process_events()
+  void process_events(MemoryPool& mempool)
   {
     // Process outstanding cudaEvents. Events that are completed are removed
     // from the queue, and the 'event_count' for the corresponding allocation
     // is decremented. Stops at the first event which has not been completed.
     // Since events on different devices or streams may occur out of order,
     // the processing of some events may be delayed.
+    auto& cuda_events = mempool.cuda_events;
     while (!cuda_events.empty()) {
       auto& e = cuda_events.front();
       cudaEvent_t event = e.first;
@@ -642,11 +1335,36 @@ void cacheInfo(int dev_id, size_t* cachedAndFree, size_t* largestBlock) {
   caching_allocator.cacheInfo(dev_id, cachedAndFree, largestBlock);
 }
 
+CacheInfo cacheInfo(int dev_id) {
+  return caching_allocator.cacheInfo(dev_id);
+}
+
+void setAllocatorSettings(const std::string& settings) {
+  caching_allocator.set_settings(settings);
+}
+
+std::vector<SegmentInfo> snapshot() {
+  return caching_allocator.snapshot();
+}
+
+void recordHistory(bool enabled, size_t max_entries, ContextRecorder recorder) {
+  caching_allocator.record_history(enabled, max_entries, recorder);
+}
+
+std::vector<TraceEntry> getTrace() {
+  return caching_allocator.get_trace();
+}
+
 void* getBaseAllocation(void *ptr, size_t *size)
 {
   return caching_allocator.getBaseAllocation(ptr, size);
 }
 
+std::string getIpcMemHandle(void *ptr, size_t *offset)
+{
+  return caching_allocator.getIpcMemHandle(ptr, offset);
+}
+
 void recordStream(void *ptr, cuda::CUDAStream stream)
 {
   caching_allocator.recordStream(ptr, stream);
@@ -657,6 +1375,26 @@ std::mutex* getFreeMutex()
   return &caching_allocator.cuda_free_mutex;
 }
 
+MempoolId_t createPrivatePool() {
+  return caching_allocator.create_pool();
+}
+
+void releasePrivatePool(MempoolId_t pool) {
+  caching_allocator.release_pool(pool);
+}
+
+void setStreamPool(cuda::CUDAStream stream, MempoolId_t pool) {
+  caching_allocator.set_stream_pool(stream.stream(), pool);
+}
+
+MempoolId_t getCurrentMempool() {
+  return current_mempool;
+}
+
+void setCurrentMempool(MempoolId_t pool) {
+  current_mempool = pool;
+}
+
 static inline void assertValidDevice(int device) {
   int device_num = device_count();
   AT_ASSERTM(0 <= device && device < device_num, "Invalid device argument.");
@@ -696,6 +1434,54 @@ void resetMaxMemoryCached(int device) {
   stats.max_amount_cached = stats.amount_cached;
 }
 
+uint64_t currentMemoryManaged(int device)
+{
+  assertValidDevice(device);
+  return caching_allocator.get_stats_for_device(device).amount_managed;
+}
+
+namespace {
+void exportDeviceStat(
+    const char* name,
+    const char* help,
+    uint64_t (*stat)(int device)) {
+  metrics::MetricsRegistry::get().addCollector(
+      name,
+      help,
+      metrics::MetricType::Gauge,
+      [stat](std::vector<metrics::MetricSample>& samples) {
+        for (int device = 0; device < device_count(); ++device) {
+          samples.push_back({"",
+                             "device=\"" + std::to_string(device) + "\"",
+                             static_cast<double>(stat(device))});
+        }
+      });
+}
+
+struct ExportStats {
+  ExportStats() {
+    exportDeviceStat(
+        "c10_cuda_caching_allocator_allocated_bytes",
+        "Bytes allocated by the CUDA caching allocator and not freed yet.",
+        &currentMemoryAllocated);
+    exportDeviceStat(
+        "c10_cuda_caching_allocator_cached_bytes",
+        "Bytes of the devices held by the CUDA caching allocator.",
+        &currentMemoryCached);
+    exportDeviceStat(
+        "c10_cuda_caching_allocator_managed_bytes",
+        "Bytes cached by the CUDA caching allocator in managed memory, "
+        "which may be partly evicted to the host.",
+        &currentMemoryManaged);
+  }
+} export_stats;
+} // namespace
+
+PoolStats getPoolStats(int device, MempoolId_t pool) {
+  assertValidDevice(device);
+  return caching_allocator.pool_stats(device, pool);
+}
+
 //
 // In CUDA IPC, sender sends a tensor to receiver, getIpcDevPtr
 // is called by the receiving process to map the CUDA memory from the sending
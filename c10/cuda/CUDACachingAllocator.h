@@ -7,6 +7,8 @@
 #include <c10/util/Registry.h>
 
 #include <mutex>
+#include <string>
+#include <vector>
 
 namespace c10 {
 
@@ -39,13 +41,106 @@ namespace cuda {
 
 namespace CUDACachingAllocator {
 
+// Identifies a memory pool of the caching allocator. Blocks cached in one
+// pool are never handed out for allocations routed to another pool.
+using MempoolId_t = uint64_t;
+
+// The pool shared by all allocations that are not routed elsewhere.
+constexpr MempoolId_t kDefaultMempool = 0;
+
+// Statistics of a single memory pool on one device, in bytes.
+struct PoolStats {
+  uint64_t amount_allocated = 0;
+  uint64_t max_amount_allocated = 0;
+  uint64_t amount_cached = 0;
+  uint64_t max_amount_cached = 0;
+};
+
+// A breakdown of the memory cached on one device, see cacheInfo(int).
+struct CacheInfo {
+  size_t cached_and_free = 0;        // bytes in free cached blocks
+  size_t largest_block = 0;          // size of the largest free cached block
+  size_t num_free_blocks = 0;        // number of free cached blocks
+  size_t num_segments = 0;           // number of cudaMalloc'ed segments
+  size_t free_in_split_segments = 0; // free bytes in segments that are partly
+                                     // in use, which emptyCache() can't return
+  size_t num_oversize_blocks = 0;    // free blocks above max_split_size
+
+  // 0 when all free cached memory is one block, approaching 1 as it gets
+  // split into many small pieces
+  double fragmentation() const {
+    return cached_and_free == 0
+        ? 0.0
+        : 1.0 - static_cast<double>(largest_block) / cached_and_free;
+  }
+};
+
+// State of one block of a segment, see snapshot().
+struct BlockInfo {
+  size_t size = 0;
+  bool allocated = false;
+  uint64_t context = 0;  // id returned by the context recorder at allocation
+};
+
+// One cudaMalloc'ed segment and the blocks it is split into, in address
+// order.
+struct SegmentInfo {
+  int device = 0;
+  uintptr_t address = 0;
+  size_t total_size = 0;
+  size_t allocated_size = 0;
+  cudaStream_t stream = nullptr;
+  MempoolId_t mempool = kDefaultMempool;
+  bool is_large = false;
+  bool is_managed = false;  // allocated with cudaMallocManaged
+  std::vector<BlockInfo> blocks;
+};
+
+// An allocator event recorded while history is enabled, see recordHistory().
+struct TraceEntry {
+  enum Action {
+    ALLOC,          // block handed out by malloc
+    FREE,           // block returned by free
+    SEGMENT_ALLOC,  // cudaMalloc
+    SEGMENT_FREE    // cudaFree
+  };
+  Action action;
+  int device;
+  uintptr_t addr;
+  size_t size;
+  cudaStream_t stream;
+  uint64_t context;
+};
+
+// Called on every allocation while history is enabled; the returned id is
+// stored with the block, e.g. to look up the stack that allocated it.
+typedef uint64_t (*ContextRecorder)();
+
 C10_CUDA_API void* raw_alloc(size_t nbytes);
 C10_CUDA_API void raw_delete(void* ptr);
 
 C10_CUDA_API Allocator* get();
 C10_CUDA_API void emptyCache();
 C10_CUDA_API void cacheInfo(int dev_id, size_t* cachedAndFree, size_t* largestBlock);
+C10_CUDA_API CacheInfo cacheInfo(int dev_id);
+// Overrides the tunables read from PYTORCH_CUDA_ALLOC_CONF. `settings` has
+// the same format, e.g. "max_split_size_mb:128,roundup_power2_divisions:4".
+//
+// With "managed_oversubscription:True", a large allocation that doesn't fit
+// on the device even after the cache was emptied falls back to managed
+// memory (cudaMallocManaged) rather than failing, on devices whose managed
+// memory can be oversubscribed. Its pages prefer the device and are
+// prefetched to it on the stream of every allocation that reuses them, but
+// the driver may evict them to the host, so that jobs slightly larger than
+// the device slow down instead of running out of memory. Managed
+// allocations can't be shared with CUDA IPC.
+C10_CUDA_API void setAllocatorSettings(const std::string& settings);
 C10_CUDA_API void* getBaseAllocation(void *ptr, size_t *size);
+// Returns the cudaIpcMemHandle_t, as bytes, of the segment holding the
+// allocation 'ptr', and the offset of 'ptr' in it. Handles are cached until
+// the segment is freed, so sharing many tensors of one segment makes a single
+// cudaIpcGetMemHandle call.
+C10_CUDA_API std::string getIpcMemHandle(void *ptr, size_t *offset);
 C10_CUDA_API void recordStream(void *ptr, CUDAStream stream);
 C10_CUDA_API uint64_t currentMemoryAllocated(int device);
 C10_CUDA_API uint64_t maxMemoryAllocated(int device);
@@ -53,9 +148,54 @@ C10_CUDA_API void     resetMaxMemoryAllocated(int device);
 C10_CUDA_API uint64_t currentMemoryCached(int device);
 C10_CUDA_API uint64_t maxMemoryCached(int device);
 C10_CUDA_API void     resetMaxMemoryCached(int device);
+// Bytes of currentMemoryCached(device) in managed memory, see
+// managed_oversubscription in setAllocatorSettings().
+C10_CUDA_API uint64_t currentMemoryManaged(int device);
 
 C10_CUDA_API std::mutex* getFreeMutex();
 
+// Creates a new private memory pool and returns its id.
+C10_CUDA_API MempoolId_t createPrivatePool();
+// Stops routing allocations to the pool and returns its cached blocks to
+// the driver. Blocks still in use are released as they are freed.
+C10_CUDA_API void releasePrivatePool(MempoolId_t pool);
+// Routes allocations on `stream` to `pool` (kDefaultMempool to undo).
+C10_CUDA_API void setStreamPool(CUDAStream stream, MempoolId_t pool);
+// The pool allocations on the current thread are routed to. Takes
+// precedence over the stream's pool unless it is kDefaultMempool.
+C10_CUDA_API MempoolId_t getCurrentMempool();
+C10_CUDA_API void setCurrentMempool(MempoolId_t pool);
+C10_CUDA_API PoolStats getPoolStats(int device, MempoolId_t pool);
+
+// Every segment of every device, in address order.
+C10_CUDA_API std::vector<SegmentInfo> snapshot();
+// Starts (or, with enabled = false, stops and clears) recording the last
+// `max_entries` allocator events and tagging blocks with the id returned by
+// `recorder`, which may be null.
+C10_CUDA_API void recordHistory(
+    bool enabled,
+    size_t max_entries,
+    ContextRecorder recorder);
+// The recorded events, oldest first.
+C10_CUDA_API std::vector<TraceEntry> getTrace();
+
+// RAII guard routing the current thread's allocations to a memory pool.
+class C10_CUDA_API MempoolGuard {
+ public:
+  explicit MempoolGuard(MempoolId_t pool) : prev_(getCurrentMempool()) {
+    setCurrentMempool(pool);
+  }
+  ~MempoolGuard() {
+    setCurrentMempool(prev_);
+  }
+
+  MempoolGuard(const MempoolGuard&) = delete;
+  MempoolGuard& operator=(const MempoolGuard&) = delete;
+
+ private:
+  MempoolId_t prev_;
+};
+
 C10_CUDA_API std::shared_ptr<void> getIpcDevPtr(std::string handle);
 
 } // namespace CUDACachingAllocator
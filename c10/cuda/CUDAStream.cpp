@@ -3,6 +3,7 @@
 #include <c10/cuda/CUDAGuard.h>
 #include <c10/util/Exception.h>
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cstdint>
@@ -73,17 +74,32 @@ static std::array<LeakyStreamInternals, kStreamsPerPool>
 static std::array<LeakyStreamInternals, kStreamsPerPool>
     high_priority_streams[C10_COMPILE_TIME_MAX_GPUS];
 
+// Dedicated streams
+// Note: they are created one by one by getDedicatedStream() and never
+// destroyed. Their slots are published atomically, so that looking
+// a stream up (e.g. in CUDAStream::stream()) doesn't take the mutex, which
+// only serializes their creation.
+static constexpr int kMaxDedicatedStreams = 1024;
+static std::mutex dedicated_streams_mutex;
+static std::atomic<int> num_dedicated_streams[C10_COMPILE_TIME_MAX_GPUS];
+static std::array<std::atomic<LeakyStreamInternals*>, kMaxDedicatedStreams>
+    dedicated_streams[C10_COMPILE_TIME_MAX_GPUS];
+
 // Note [StreamId assignment]
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~
 // How do we assign stream IDs?
 //
-// -- 25 bits -- -- 2 bits --  -- 5 bits -----
-// zeros         StreamIdType  stream id index
+// -- 25 bits --------  -- 2 bits --  -- 5 bits ----------
+// stream id index >> 5  StreamIdType  stream id index & 31
 //
 // Where StreamIdType:
 //  00 = default stream
 //  01 = low priority stream
 //  10 = high priority stream
+//  11 = dedicated stream
+//
+// Only dedicated streams have indices larger than 31, so the high bits are
+// zeros for the other types.
 //
 // This is not really for efficiency; it's just easier to write the code
 // to extract the index if we do this with bitmasks :)
@@ -104,6 +120,7 @@ enum class StreamIdType : uint8_t {
   DEFAULT = 0x0,
   LOW = 0x1,
   HIGH = 0x2,
+  DEDICATED = 0x3,
 };
 
 std::ostream& operator<<(std::ostream& stream, StreamIdType s) {
@@ -117,6 +134,9 @@ std::ostream& operator<<(std::ostream& stream, StreamIdType s) {
     case StreamIdType::HIGH:
       stream << "HIGH";
       break;
+    case StreamIdType::DEDICATED:
+      stream << "DEDICATED";
+      break;
     default:
       stream << static_cast<uint8_t>(s);
       break;
@@ -129,16 +149,20 @@ std::ostream& operator<<(std::ostream& stream, StreamIdType s) {
 // see Note [Hazard when concatenating signed integers]
 
 static inline StreamIdType streamIdType(StreamId s) {
-  return static_cast<StreamIdType>(s >> kStreamsPerPoolBits);
+  return static_cast<StreamIdType>((s >> kStreamsPerPoolBits) & 0x3);
 }
 
 static inline size_t streamIdIndex(StreamId s) {
-  return static_cast<size_t>(s & ((1 << kStreamsPerPoolBits) - 1));
+  return static_cast<size_t>(
+      ((s >> (kStreamsPerPoolBits + 2)) << kStreamsPerPoolBits) |
+      (s & ((1 << kStreamsPerPoolBits) - 1)));
 }
 
 StreamId makeStreamId(StreamIdType st, size_t si) {
-  return (static_cast<StreamId>(st) << kStreamsPerPoolBits) |
-      static_cast<StreamId>(si);
+  return (static_cast<StreamId>(si >> kStreamsPerPoolBits)
+          << (kStreamsPerPoolBits + 2)) |
+      (static_cast<StreamId>(st) << kStreamsPerPoolBits) |
+      static_cast<StreamId>(si & ((1 << kStreamsPerPoolBits) - 1));
 }
 
 template <typename T, typename A>
@@ -178,6 +202,11 @@ static StreamId CUDAStream_getStreamId(const LeakyStreamInternals* ptr) {
         StreamIdType::HIGH, ptr - high_priority_streams[device_index].data());
   }
 
+  // Dedicated streams know their id, see getDedicatedStream()
+  if (ptr->stream_id >= 0) {
+    return ptr->stream_id;
+  }
+
   AT_ASSERTM(
       0,
       "Could not compute stream ID for ",
@@ -212,6 +241,7 @@ static void initGlobalStreamState() {
     default_streams[i].device_index = i;
     low_priority_counters[i] = 0;
     high_priority_counters[i] = 0;
+    num_dedicated_streams[i] = 0;
   }
 }
 
@@ -293,6 +323,12 @@ LeakyStreamInternals* CUDAStream_internals(CUDAStream s) {
       return &low_priority_streams[device_index][si];
     case StreamIdType::HIGH:
       return &high_priority_streams[device_index][si];
+    case StreamIdType::DEDICATED:
+      AT_ASSERTM(
+          si < static_cast<size_t>(num_dedicated_streams[device_index].load()),
+          "Unrecognized dedicated stream ",
+          s.unwrap());
+      return dedicated_streams[device_index][si].load();
     default:
       AT_ASSERTM(
           0,
@@ -345,6 +381,45 @@ CUDAStream getStreamFromPool(
   return CUDAStream_fromInternals(&low_priority_streams[device_index][idx]);
 }
 
+CUDAStream getDedicatedStream(int priority, DeviceIndex device_index) {
+  initCUDAStreamsOnce();
+  if (device_index == -1) {
+    device_index = current_device();
+  }
+  check_gpu(device_index);
+
+  std::lock_guard<std::mutex> guard(dedicated_streams_mutex);
+  const int idx = num_dedicated_streams[device_index].load();
+  AT_CHECK(
+      idx < kMaxDedicatedStreams,
+      "Too many dedicated CUDA streams on device ",
+      device_index,
+      " (at most ",
+      kMaxDedicatedStreams,
+      "); they are never destroyed, so create them once and keep them, or "
+      "use getStreamFromPool() for short-lived streams");
+
+  auto ptr = new LeakyStreamInternals();
+  ptr->device_index = device_index;
+  ptr->stream_id = makeStreamId(StreamIdType::DEDICATED, idx);
+  CUDAGuard device_guard{device_index};
+#ifndef __HIP_PLATFORM_HCC__
+  int least_priority, greatest_priority;
+  C10_CUDA_CHECK(
+      cudaDeviceGetStreamPriorityRange(&least_priority, &greatest_priority));
+  // lower numbers are higher priorities
+  priority = std::min(std::max(priority, greatest_priority), least_priority);
+  C10_CUDA_CHECK(
+      cudaStreamCreateWithPriority(&ptr->stream, kDefaultFlags, priority));
+#else
+  C10_CUDA_CHECK(cudaStreamCreateWithFlags(&ptr->stream, kDefaultFlags));
+#endif // __HIP_PLATFORM_HCC__
+
+  dedicated_streams[device_index][idx] = ptr;
+  num_dedicated_streams[device_index] = idx + 1;
+  return CUDAStream_fromInternals(ptr);
+}
+
 CUDAStream getDefaultCUDAStream(DeviceIndex device_index) {
   initCUDAStreamsOnce();
   if (device_index == -1) {
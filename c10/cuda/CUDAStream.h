@@ -39,10 +39,10 @@
 *
 * These pools suggest that stream users should prefer many short-lived streams,
 * as the cost of acquiring and releasing streams is effectively zero. If
-* many longer-lived streams are required in performance critical scenarios
-* then the functionality here may need to be extended to allow, for example,
-* "reserving" a subset of the pool so that other streams do not accidentally
-* overlap the performance critical streams.
+* many longer-lived streams are required in performance critical scenarios,
+* e.g. for latency-critical work that must not queue behind unrelated
+* kernels, getDedicatedStream() creates a stream of a given priority that is
+* not shared with the pools (see also CUDAStreamScheduler.h).
 *
 * Note: although the notion of "current stream for device" is thread local
 * (every OS thread has a separate current stream, as one might expect),
@@ -184,6 +184,19 @@ private:
 CAFFE2_API CUDAStream
 getStreamFromPool(const bool isHighPriority = false, DeviceIndex device = -1);
 
+/**
+ * Create a new CUDA stream with the given priority (lower numbers are
+ * higher priorities, and the priority is clamped to
+ * CUDAStream::priority_range()), for the passed device or the current one.
+ * Unlike the streams of the pool, it is never returned to anyone else, so
+ * that kernels enqueued on it only wait for each other.
+ *
+ * Dedicated streams are never destroyed, and there can be at most 1024 of
+ * them per device: create them once, for long-lived uses.
+ */
+CAFFE2_API CUDAStream
+getDedicatedStream(int priority = 0, DeviceIndex device = -1);
+
 /**
  * Get the default CUDA stream, for the passed CUDA device, or for the
  * current device if no device index is passed.  The default stream is
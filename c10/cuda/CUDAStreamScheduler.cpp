@@ -0,0 +1,60 @@
+#include <c10/cuda/CUDAStreamScheduler.h>
+
+#include <c10/cuda/CUDAFunctions.h>
+#include <c10/util/Exception.h>
+
+#include <tuple>
+
+namespace c10 {
+namespace cuda {
+
+CUDAStreamScheduler::CUDAStreamScheduler(
+    DeviceIndex device,
+    size_t streamsPerClass,
+    bool separatePools)
+    : device_(device == -1 ? current_device() : device) {
+  AT_CHECK(streamsPerClass > 0, "streamsPerClass must be positive");
+
+  // Note: lower numbers are higher priorities, and stream priority is not
+  // supported by HIP
+  int leastPriority = 0;
+  int greatestPriority = 0;
+#ifndef __HIP_PLATFORM_HCC__
+  std::tie(leastPriority, greatestPriority) = CUDAStream::priority_range();
+#endif // __HIP_PLATFORM_HCC__
+  priorities_[static_cast<size_t>(QoSClass::LatencyCritical)] =
+      greatestPriority;
+  priorities_[static_cast<size_t>(QoSClass::Default)] =
+      (leastPriority + greatestPriority) / 2;
+  priorities_[static_cast<size_t>(QoSClass::Background)] = leastPriority;
+
+  for (size_t qos = 0; qos < kNumQoSClasses; ++qos) {
+    counters_[qos] = 0;
+    pools_[qos] = separatePools ? CUDACachingAllocator::createPrivatePool()
+                                : CUDACachingAllocator::kDefaultMempool;
+    for (size_t i = 0; i < streamsPerClass; ++i) {
+      streams_[qos].push_back(getDedicatedStream(priorities_[qos], device_));
+      if (separatePools) {
+        CUDACachingAllocator::setStreamPool(streams_[qos].back(), pools_[qos]);
+      }
+    }
+  }
+}
+
+CUDAStreamScheduler::~CUDAStreamScheduler() {
+  for (auto pool : pools_) {
+    if (pool != CUDACachingAllocator::kDefaultMempool) {
+      CUDACachingAllocator::releasePrivatePool(pool);
+    }
+  }
+}
+
+CUDAStream CUDAStreamScheduler::getStream(QoSClass qos) {
+  const auto i = static_cast<size_t>(qos);
+  AT_CHECK(i < kNumQoSClasses, "Unknown QoS class ", static_cast<int>(i));
+  const auto idx = counters_[i]++ % streams_[i].size();
+  return streams_[i][idx];
+}
+
+} // namespace cuda
+} // namespace c10
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <c10/cuda/CUDACachingAllocator.h>
+#include <c10/cuda/CUDAMacros.h>
+#include <c10/cuda/CUDAStream.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace c10 {
+namespace cuda {
+
+// The quality of service classes of the work sharing a device.
+enum class QoSClass : uint8_t {
+  LatencyCritical = 0,
+  Default = 1,
+  Background = 2,
+};
+
+constexpr size_t kNumQoSClasses = 3;
+
+/**
+ * Assigns streams to the requests of a server by QoS class.
+ *
+ * Every class has its own streams, created with getDedicatedStream():
+ * latency-critical streams have the greatest priority of the device and
+ * background ones the least, so that the kernels of latency-critical requests
+ * never queue behind the kernels of background jobs on a stream, and are
+ * scheduled first when both are ready. Requests of one class get the streams
+ * of their class round-robin.
+ *
+ * With separatePools, the allocations on the streams of every class are also
+ * routed to a private pool of the caching allocator (see
+ * CUDACachingAllocator::setStreamPool), so that background jobs can neither
+ * fragment nor hold on to the memory cached for latency-critical requests.
+ *
+ * A request runs with its stream as the current stream:
+ *
+ *   // once, e.g. as a member of the server
+ *   c10::cuda::CUDAStreamScheduler scheduler(device);
+ *
+ *   // for every request
+ *   c10::cuda::CUDAStreamGuard guard(
+ *       scheduler.getStream(c10::cuda::QoSClass::LatencyCritical));
+ *   auto output = module.forward(inputs);
+ *
+ * getStream() may be called concurrently. The streams are never destroyed
+ * (see getDedicatedStream()), so schedulers should be created once and live
+ * as long as the server; destroying one releases its private pools.
+ */
+class C10_CUDA_API CUDAStreamScheduler {
+ public:
+  explicit CUDAStreamScheduler(
+      DeviceIndex device = -1,
+      size_t streamsPerClass = 4,
+      bool separatePools = true);
+  ~CUDAStreamScheduler();
+
+  CUDAStreamScheduler(const CUDAStreamScheduler&) = delete;
+  CUDAStreamScheduler& operator=(const CUDAStreamScheduler&) = delete;
+
+  // The next stream of the class, round-robin.
+  CUDAStream getStream(QoSClass qos);
+
+  // The private pool of the class, or kDefaultMempool without separatePools.
+  CUDACachingAllocator::MempoolId_t getPool(QoSClass qos) const {
+    return pools_[static_cast<size_t>(qos)];
+  }
+
+  // The priority of the streams of the class.
+  int getPriority(QoSClass qos) const {
+    return priorities_[static_cast<size_t>(qos)];
+  }
+
+  DeviceIndex device() const {
+    return device_;
+  }
+
+ private:
+  DeviceIndex device_;
+  std::array<std::vector<CUDAStream>, kNumQoSClasses> streams_;
+  std::array<std::atomic<uint32_t>, kNumQoSClasses> counters_;
+  std::array<int, kNumQoSClasses> priorities_;
+  std::array<CUDACachingAllocator::MempoolId_t, kNumQoSClasses> pools_;
+};
+
+} // namespace cuda
+} // namespace c10
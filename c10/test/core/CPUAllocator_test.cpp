@@ -0,0 +1,25 @@
+#include <gtest/gtest.h>
+
+#include <c10/core/CPUAllocator.h>
+
+TEST(CPUAllocatorTest, ZeroedAllocationsAreZero) {
+  size_t size = FLAGS_caffe2_cpu_zeroed_alloc_min_size + 100;
+  auto data = c10::try_alloc_zeroed_cpu(size);
+#ifdef _WIN32
+  ASSERT_FALSE(data);
+#else
+  ASSERT_TRUE(data);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(data.get()) % c10::gAlignment, 0);
+  auto* bytes = static_cast<unsigned char*>(data.get());
+  for (size_t i = 0; i < size; ++i) {
+    ASSERT_EQ(bytes[i], 0);
+  }
+  bytes[size - 1] = 1;
+#endif
+}
+
+TEST(CPUAllocatorTest, SmallZeroedAllocationsAreLeftToTheCaller) {
+  ASSERT_FALSE(c10::try_alloc_zeroed_cpu(0));
+  ASSERT_FALSE(
+      c10::try_alloc_zeroed_cpu(FLAGS_caffe2_cpu_zeroed_alloc_min_size - 1));
+}
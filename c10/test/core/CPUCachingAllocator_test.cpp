@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include <c10/core/CPUAllocator.h>
+#include <c10/core/CPUCachingAllocator.h>
+
+TEST(CPUCachingAllocatorTest, ReusesFreedBlocks) {
+  auto* allocator = c10::GetCPUCachingAllocator();
+  allocator->emptyCache();
+
+  void* first;
+  {
+    auto data = allocator->allocate(1000);
+    first = data.get();
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(first) % c10::gAlignment, 0);
+    ASSERT_GE(allocator->getStats().allocated_bytes, 1000);
+  }
+  ASSERT_GE(allocator->getStats().cached_bytes, 1000);
+
+  auto hits = allocator->getStats().num_cache_hits;
+  // requests in the same size class get the cached block back
+  auto data = allocator->allocate(1010);
+  ASSERT_EQ(data.get(), first);
+  ASSERT_EQ(allocator->getStats().num_cache_hits, hits + 1);
+}
+
+TEST(CPUCachingAllocatorTest, EmptyCache) {
+  auto* allocator = c10::GetCPUCachingAllocator();
+  allocator->emptyCache();
+  { auto data = allocator->allocate(4096); }
+  ASSERT_GT(allocator->getStats().cached_bytes, 0);
+  allocator->emptyCache();
+  ASSERT_EQ(allocator->getStats().cached_bytes, 0);
+}
+
+TEST(CPUCachingAllocatorTest, LargeAllocationsAreNotCached) {
+  auto* allocator = c10::GetCPUCachingAllocator();
+  allocator->emptyCache();
+  size_t size = FLAGS_caffe2_cpu_caching_allocator_max_cached_size + 1;
+  { auto data = allocator->allocate(size); }
+  ASSERT_EQ(allocator->getStats().cached_bytes, 0);
+  ASSERT_EQ(allocator->allocate(0).get(), nullptr);
+}
+
+TEST(CPUCachingAllocatorTest, FreeOnOtherThread) {
+  auto* allocator = c10::GetCPUCachingAllocator();
+  allocator->emptyCache();
+  auto before = allocator->getStats().allocated_bytes;
+  std::vector<at::DataPtr> blocks;
+  for (int i = 0; i < 16; i++) {
+    blocks.push_back(allocator->allocate(512));
+  }
+  std::thread([&] {
+    blocks.clear();
+  }).join();
+  // the exiting thread hands its cache to the shared cache
+  ASSERT_EQ(allocator->getStats().allocated_bytes, before);
+  auto hits = allocator->getStats().num_cache_hits;
+  auto data = allocator->allocate(512);
+  ASSERT_EQ(allocator->getStats().num_cache_hits, hits + 1);
+}
+
+TEST(CPUCachingAllocatorTest, SetEnabled) {
+  c10::SetCPUCachingAllocatorEnabled(true);
+  ASSERT_EQ(c10::GetCPUAllocator(), c10::GetCPUCachingAllocator());
+  c10::SetCPUCachingAllocatorEnabled(false);
+  ASSERT_EQ(c10::GetCPUAllocator(), c10::GetDefaultCPUAllocator());
+}
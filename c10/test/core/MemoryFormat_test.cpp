@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include <c10/core/MemoryFormat.h>
+#include <c10/core/TensorImpl.h>
+#include <c10/core/TensorTypeIdRegistration.h>
+
+#include <vector>
+
+namespace {
+c10::TensorImpl make_impl(std::vector<int64_t> sizes) {
+  c10::TensorImpl impl(
+      c10::CPUTensorId(), caffe2::TypeMeta::Make<float>(), c10::Device(c10::kCPU));
+  impl.set_sizes_contiguous(sizes);
+  return impl;
+}
+
+TEST(MemoryFormatTest, ChannelsLastStrides) {
+  EXPECT_EQ(
+      c10::get_channels_last_strides({2, 3, 4, 5}),
+      (std::vector<int64_t>{60, 1, 15, 3}));
+  // Empty dimensions are treated as size one.
+  EXPECT_EQ(
+      c10::get_channels_last_strides({2, 0, 4, 5}),
+      (std::vector<int64_t>{20, 1, 5, 1}));
+  EXPECT_ANY_THROW(c10::get_channels_last_strides({2, 3, 4}));
+}
+
+TEST(MemoryFormatTest, RestrideToChannelsLast) {
+  auto impl = make_impl({2, 3, 4, 5});
+  EXPECT_TRUE(impl.is_contiguous());
+  EXPECT_FALSE(impl.is_contiguous(c10::MemoryFormat::ChannelsLast));
+
+  impl.empty_tensor_restride(c10::MemoryFormat::ChannelsLast);
+  EXPECT_EQ(impl.strides(), c10::IntArrayRef({60, 1, 15, 3}));
+  EXPECT_FALSE(impl.is_contiguous());
+  EXPECT_TRUE(impl.is_contiguous(c10::MemoryFormat::ChannelsLast));
+
+  impl.empty_tensor_restride(c10::MemoryFormat::Contiguous);
+  EXPECT_EQ(impl.strides(), c10::IntArrayRef({60, 20, 5, 1}));
+  EXPECT_TRUE(impl.is_contiguous());
+}
+
+TEST(MemoryFormatTest, SingleChannelIsBoth) {
+  auto impl = make_impl({2, 1, 4, 5});
+  EXPECT_TRUE(impl.is_contiguous());
+  EXPECT_TRUE(impl.is_contiguous(c10::MemoryFormat::ChannelsLast));
+}
+
+TEST(MemoryFormatTest, OnlyFourDimensional) {
+  auto impl = make_impl({2, 3, 4});
+  EXPECT_FALSE(impl.is_contiguous(c10::MemoryFormat::ChannelsLast));
+  EXPECT_ANY_THROW(impl.empty_tensor_restride(c10::MemoryFormat::ChannelsLast));
+}
+} // namespace
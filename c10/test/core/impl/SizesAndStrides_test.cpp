@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include "c10/core/impl/SizesAndStrides.h"
+
+using namespace c10;
+using namespace c10::impl;
+
+static void fill(SizesAndStrides& sz, int64_t base) {
+  for (size_t i = 0; i < sz.size(); ++i) {
+    sz.size_at_unchecked(i) = base + i;
+    sz.stride_at_unchecked(i) = 10 * (base + i);
+  }
+}
+
+static void checkFilled(const SizesAndStrides& sz, size_t n, int64_t base) {
+  ASSERT_EQ(sz.size(), n);
+  for (size_t i = 0; i < n; ++i) {
+    EXPECT_EQ(sz.size_at(i), base + i);
+    EXPECT_EQ(sz.stride_at_unchecked(i), 10 * (base + i));
+  }
+}
+
+TEST(SizesAndStridesTest, DefaultConstructor) {
+  SizesAndStrides sz;
+  EXPECT_EQ(sz.sizes_arrayref(), IntArrayRef({0}));
+  EXPECT_EQ(sz.strides_arrayref(), IntArrayRef({1}));
+}
+
+TEST(SizesAndStridesTest, SetSizes) {
+  SizesAndStrides sz;
+  sz.set_sizes({5, 6, 7, 8});
+  EXPECT_EQ(sz.sizes_arrayref(), IntArrayRef({5, 6, 7, 8}));
+  // The stride of the kept dimension survives, new ones are zero
+  EXPECT_EQ(sz.strides_arrayref(), IntArrayRef({1, 0, 0, 0}));
+}
+
+TEST(SizesAndStridesTest, ResizeKeepsValues) {
+  // Covers inline -> inline, inline -> out of line, out of line -> out of
+  // line in both directions and out of line -> inline.
+  for (size_t from : {0, 1, 3, 5, 6, 9}) {
+    for (size_t to : {0, 2, 5, 6, 8, 12}) {
+      SizesAndStrides sz;
+      sz.resize(from);
+      fill(sz, 1);
+      sz.resize(to);
+      ASSERT_EQ(sz.size(), to);
+      for (size_t i = 0; i < to; ++i) {
+        if (i < from) {
+          EXPECT_EQ(sz.size_at(i), 1 + i);
+          EXPECT_EQ(sz.stride_at_unchecked(i), 10 * (1 + i));
+        } else {
+          EXPECT_EQ(sz.size_at(i), 0);
+          EXPECT_EQ(sz.stride_at_unchecked(i), 0);
+        }
+      }
+    }
+  }
+}
+
+TEST(SizesAndStridesTest, SizeAtOutOfRange) {
+  SizesAndStrides sz;
+  sz.resize(3);
+  EXPECT_ANY_THROW(sz.size_at(3));
+}
+
+TEST(SizesAndStridesTest, CopyAndMove) {
+  for (size_t n : {2, 5, 7}) {
+    for (size_t other : {1, 5, 7, 9}) {
+      SizesAndStrides sz;
+      sz.resize(n);
+      fill(sz, 3);
+
+      SizesAndStrides copied(sz);
+      checkFilled(copied, n, 3);
+
+      SizesAndStrides assigned;
+      assigned.resize(other);
+      fill(assigned, 100);
+      assigned = sz;
+      checkFilled(assigned, n, 3);
+      checkFilled(sz, n, 3);
+
+      SizesAndStrides moved(std::move(copied));
+      checkFilled(moved, n, 3);
+      EXPECT_EQ(copied.size(), 0);
+
+      SizesAndStrides move_assigned;
+      move_assigned.resize(other);
+      move_assigned = std::move(moved);
+      checkFilled(move_assigned, n, 3);
+      EXPECT_EQ(moved.size(), 0);
+    }
+  }
+}
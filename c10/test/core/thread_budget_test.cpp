@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <c10/core/thread_budget.h>
+
+using c10::ThreadBudget;
+using c10::ThreadPoolKind;
+
+namespace {
+
+// ThreadBudget is a process-wide singleton; reset it around every test.
+class ThreadBudgetTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    reset();
+  }
+  void TearDown() override {
+    reset();
+  }
+  void reset() {
+    auto& budget = ThreadBudget::get();
+    budget.setTotalThreads(0);
+    budget.setNUMANode(-1);
+    budget.setNumThreads(ThreadPoolKind::IntraOp, 0);
+    budget.setNumThreads(ThreadPoolKind::InterOp, 0);
+    budget.setNumThreads(ThreadPoolKind::Caffe2, 0);
+  }
+};
+
+} // namespace
+
+TEST_F(ThreadBudgetTest, DisabledUsesFallback) {
+  auto& budget = ThreadBudget::get();
+  EXPECT_FALSE(budget.enabled());
+  EXPECT_EQ(budget.numThreads(ThreadPoolKind::IntraOp, 7), 7);
+  EXPECT_EQ(budget.numThreads(ThreadPoolKind::InterOp, 3), 3);
+  EXPECT_EQ(budget.numaNodeForWorker(ThreadPoolKind::IntraOp, 0), -1);
+}
+
+TEST_F(ThreadBudgetTest, ExplicitSizeWinsWhenDisabled) {
+  auto& budget = ThreadBudget::get();
+  budget.setNumThreads(ThreadPoolKind::InterOp, 4);
+  EXPECT_EQ(budget.numThreads(ThreadPoolKind::InterOp, 1), 4);
+}
+
+TEST_F(ThreadBudgetTest, PartitionsTotal) {
+  auto& budget = ThreadBudget::get();
+  budget.setTotalThreads(16);
+  EXPECT_TRUE(budget.enabled());
+  EXPECT_EQ(budget.numThreads(ThreadPoolKind::InterOp, 100), 1);
+  EXPECT_EQ(budget.numThreads(ThreadPoolKind::IntraOp, 100), 15);
+  EXPECT_EQ(budget.numThreads(ThreadPoolKind::Caffe2, 100), 15);
+
+  budget.setNumThreads(ThreadPoolKind::InterOp, 4);
+  budget.setNumThreads(ThreadPoolKind::Caffe2, 2);
+  EXPECT_EQ(budget.numThreads(ThreadPoolKind::IntraOp, 100), 10);
+  EXPECT_EQ(budget.numThreads(ThreadPoolKind::Caffe2, 100), 2);
+}
+
+TEST_F(ThreadBudgetTest, NeverStarvesIntraOp) {
+  auto& budget = ThreadBudget::get();
+  budget.setTotalThreads(2);
+  budget.setNumThreads(ThreadPoolKind::InterOp, 8);
+  EXPECT_EQ(budget.numThreads(ThreadPoolKind::IntraOp, 100), 1);
+}
+
+TEST_F(ThreadBudgetTest, FixedNUMANode) {
+  auto& budget = ThreadBudget::get();
+  budget.setTotalThreads(8);
+  budget.setNUMANode(1);
+  for (size_t i = 0; i < 8; ++i) {
+    EXPECT_EQ(budget.numaNodeForWorker(ThreadPoolKind::IntraOp, i), 1);
+  }
+  // Binding is a no-op unless NUMA is enabled
+  budget.bindNextWorker(ThreadPoolKind::IntraOp);
+}
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <c10/core/thread_pool.h>
+
+#include <atomic>
+#include <chrono>
+
+using c10::WorkStealingThreadPool;
+
+namespace {
+
+void waitFor(const std::atomic<int>& counter, int expected) {
+  while (counter.load() != expected) {
+    std::this_thread::yield();
+  }
+}
+
+} // namespace
+
+TEST(WorkStealingThreadPoolTest, RunsAllTasks) {
+  WorkStealingThreadPool pool(4);
+  EXPECT_EQ(pool.size(), 4);
+  EXPECT_FALSE(pool.inThreadPool());
+
+  std::atomic<int> counter(0);
+  for (int i = 0; i < 1000; ++i) {
+    pool.run([&counter]() { ++counter; });
+  }
+  waitFor(counter, 1000);
+}
+
+TEST(WorkStealingThreadPoolTest, NestedTasksRunInPool) {
+  WorkStealingThreadPool pool(2);
+  std::atomic<int> counter(0);
+  std::atomic<int> in_pool(0);
+  pool.run([&]() {
+    for (int i = 0; i < 100; ++i) {
+      pool.run([&]() {
+        if (pool.inThreadPool()) {
+          ++in_pool;
+        }
+        ++counter;
+      });
+    }
+  });
+  waitFor(counter, 100);
+  EXPECT_EQ(in_pool.load(), 100);
+}
+
+TEST(WorkStealingThreadPoolTest, IdleWorkersSteal) {
+  WorkStealingThreadPool pool(4);
+  std::atomic<int> counter(0);
+  // A single blocked worker pushes all follow-up work onto its own deque;
+  // the other workers can only get at it by stealing.
+  pool.run([&]() {
+    for (int i = 0; i < 64; ++i) {
+      pool.run([&counter]() { ++counter; });
+    }
+    waitFor(counter, 64);
+  });
+  waitFor(counter, 64);
+  EXPECT_GT(pool.numSteals(), 0);
+}
+
+TEST(WorkStealingThreadPoolTest, RunPendingTaskOnCaller) {
+  WorkStealingThreadPool pool(0);
+  std::atomic<int> counter(0);
+  pool.run([&counter]() { ++counter; });
+  EXPECT_TRUE(pool.runPendingTask());
+  EXPECT_FALSE(pool.runPendingTask());
+  EXPECT_EQ(counter.load(), 1);
+}
+
+TEST(WorkStealingThreadPoolTest, QueueDepth) {
+  WorkStealingThreadPool pool(0);
+  for (int i = 0; i < 3; ++i) {
+    pool.run([]() {});
+  }
+  EXPECT_EQ(pool.numPending(), 3);
+  EXPECT_TRUE(pool.runPendingTask());
+  EXPECT_TRUE(pool.runPendingTask());
+  EXPECT_EQ(pool.numPending(), 1);
+  EXPECT_EQ(pool.maxPending(), 3);
+}
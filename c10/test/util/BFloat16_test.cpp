@@ -0,0 +1,67 @@
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include <c10/util/BFloat16.h>
+#include <gtest/gtest.h>
+
+namespace {
+float float_from_bits(uint32_t bits) {
+  float res;
+  std::memcpy(&res, &bits, sizeof(res));
+  return res;
+}
+
+TEST(BFloat16ConversionTest, FloatToBFloat16AndBack) {
+  // Values with at most 8 significant bits are exact in BFloat16.
+  std::vector<float> inputs = {0.f, -0.f, 1.f, -2.5f, 3.140625f, 65280.f,
+                               std::ldexp(1.f, -126),
+                               std::numeric_limits<float>::infinity()};
+  for (float x : inputs) {
+    c10::BFloat16 b(x);
+    EXPECT_EQ(static_cast<float>(b), x) << "Test failed for " << x;
+  }
+}
+
+TEST(BFloat16ConversionTest, RoundsToNearestEven) {
+  // 1 + 2^-8 lies halfway between 1 and 1 + 2^-7; the even one is 1.
+  EXPECT_EQ(c10::BFloat16(float_from_bits(0x3F808000)).x, 0x3F80);
+  // 1 + 3 * 2^-8 lies halfway between 1 + 2^-7 and 1 + 2^-6; the even one is
+  // the latter.
+  EXPECT_EQ(c10::BFloat16(float_from_bits(0x3F818000)).x, 0x3F82);
+  // Just above the halfway point rounds up.
+  EXPECT_EQ(c10::BFloat16(float_from_bits(0x3F808001)).x, 0x3F81);
+  // Just below rounds down.
+  EXPECT_EQ(c10::BFloat16(float_from_bits(0x3F807FFF)).x, 0x3F80);
+  // The largest float rounds to infinity.
+  EXPECT_EQ(
+      c10::BFloat16(std::numeric_limits<float>::max()).x,
+      std::numeric_limits<c10::BFloat16>::infinity().x);
+}
+
+TEST(BFloat16ConversionTest, KeepsNaN) {
+  // A NaN whose payload only sits in the low 16 bits must not be rounded to an
+  // infinity.
+  c10::BFloat16 b(float_from_bits(0x7F800001));
+  EXPECT_TRUE(std::isnan(static_cast<float>(b)));
+}
+
+TEST(BFloat16ArithmeticTest, ComputesInFloat) {
+  c10::BFloat16 a(1.5f), b(2.f);
+  EXPECT_EQ(static_cast<float>(a + b), 3.5f);
+  EXPECT_EQ(static_cast<float>(a * b), 3.f);
+  EXPECT_EQ(static_cast<float>(a - 1), 0.5f);
+  EXPECT_EQ(a * 2.f, 3.f);
+  EXPECT_TRUE(a < b);
+}
+
+TEST(BFloat16LimitsTest, MatchFloat32Range) {
+  using limits = std::numeric_limits<c10::BFloat16>;
+  EXPECT_EQ(static_cast<float>(limits::max()), 3.38953139e38f);
+  EXPECT_EQ(static_cast<float>(limits::lowest()), -3.38953139e38f);
+  EXPECT_EQ(
+      static_cast<float>(limits::min()), std::numeric_limits<float>::min());
+  EXPECT_EQ(static_cast<float>(limits::epsilon()), 0.0078125f);
+}
+} // namespace
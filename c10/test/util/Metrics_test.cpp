@@ -0,0 +1,86 @@
+#include <c10/util/Metrics.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using namespace c10::metrics;
+
+namespace {
+const MetricFamily* find(
+    const std::vector<MetricFamily>& metrics,
+    const std::string& name) {
+  for (const auto& metric : metrics) {
+    if (metric.name == name) {
+      return &metric;
+    }
+  }
+  return nullptr;
+}
+} // namespace
+
+TEST(MetricsTest, givenName_whenCreatingCounterTwice_thenReturnsSameCounter) {
+  auto& registry = MetricsRegistry::get();
+  auto* counter = registry.counter("test_same_counter_total", "A counter.");
+  EXPECT_EQ(counter, registry.counter("test_same_counter_total", "A counter."));
+  EXPECT_ANY_THROW(registry.gauge("test_same_counter_total", "A gauge."));
+}
+
+TEST(MetricsTest, givenConcurrentAdds_whenCollecting_thenNoAddIsLost) {
+  auto* counter = MetricsRegistry::get().counter(
+      "test_concurrent_counter_total", "A counter.");
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([counter] {
+      for (int j = 0; j < 1000; ++j) {
+        counter->add();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const auto metrics = MetricsRegistry::get().collect();
+  const auto* metric = find(metrics, "test_concurrent_counter_total");
+  ASSERT_NE(nullptr, metric);
+  ASSERT_EQ(1u, metric->samples.size());
+  EXPECT_EQ(4000, metric->samples[0].value);
+}
+
+TEST(MetricsTest, givenHistogram_whenObserving_thenCountsAreCumulative) {
+  auto* histogram = MetricsRegistry::get().histogram(
+      "test_histogram_seconds", "A histogram.", {1, 10});
+  histogram->observe(0.5);
+  histogram->observe(1);
+  histogram->observe(5);
+  histogram->observe(50);
+  EXPECT_EQ((std::vector<int64_t>{2, 1, 1}), histogram->counts());
+
+  const auto text = toPrometheusText(MetricsRegistry::get().collect());
+  EXPECT_NE(std::string::npos, text.find("# TYPE test_histogram_seconds histogram\n"));
+  EXPECT_NE(std::string::npos, text.find("test_histogram_seconds_bucket{le=\"1\"} 2\n"));
+  EXPECT_NE(std::string::npos, text.find("test_histogram_seconds_bucket{le=\"10\"} 3\n"));
+  EXPECT_NE(std::string::npos, text.find("test_histogram_seconds_bucket{le=\"+Inf\"} 4\n"));
+  EXPECT_NE(std::string::npos, text.find("test_histogram_seconds_sum 56.5\n"));
+  EXPECT_NE(std::string::npos, text.find("test_histogram_seconds_count 4\n"));
+}
+
+TEST(MetricsTest, givenCollector_whenCollecting_thenItsSamplesAreExported) {
+  int calls = 0;
+  MetricsRegistry::get().addCollector(
+      "test_collected_bytes",
+      "A gauge.",
+      MetricType::Gauge,
+      [&calls](std::vector<MetricSample>& samples) {
+        ++calls;
+        samples.push_back({"", "device=\"0\"", 1024});
+        samples.push_back({"", "device=\"1\"", 123456789});
+      });
+  const auto text = toPrometheusText(MetricsRegistry::get().collect());
+  EXPECT_EQ(1, calls);
+  EXPECT_NE(std::string::npos, text.find("# HELP test_collected_bytes A gauge.\n"));
+  EXPECT_NE(std::string::npos, text.find("test_collected_bytes{device=\"0\"} 1024\n"));
+  EXPECT_NE(std::string::npos, text.find("test_collected_bytes{device=\"1\"} 123456789\n"));
+  MetricsRegistry::get().addCollector(
+      "test_collected_bytes", "A gauge.", MetricType::Gauge, nullptr);
+}
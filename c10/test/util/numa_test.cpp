@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+
+#include <c10/core/CPUAllocator.h>
+#include <c10/util/numa.h>
+
+TEST(NUMATest, AllocationGuardRestoresNode) {
+  ASSERT_EQ(c10::GetAllocationNUMANodeOverride(), -1);
+  {
+    c10::NUMAAllocationGuard guard(1);
+    ASSERT_EQ(c10::GetAllocationNUMANodeOverride(), 1);
+    {
+      c10::NUMAAllocationGuard inner(0);
+      ASSERT_EQ(c10::GetAllocationNUMANodeOverride(), 0);
+    }
+    ASSERT_EQ(c10::GetAllocationNUMANodeOverride(), 1);
+  }
+  ASSERT_EQ(c10::GetAllocationNUMANodeOverride(), -1);
+  ASSERT_ANY_THROW(c10::SetAllocationNUMANode(-2));
+}
+
+TEST(NUMATest, AllocateOnNode) {
+  if (!c10::IsNUMAEnabled()) {
+    ASSERT_EQ(c10::GetAllocationNUMANode(), -1);
+    return;
+  }
+  int last_node = c10::GetNumNUMANodes() - 1;
+  c10::NUMAAllocationGuard guard(last_node);
+  size_t nbytes = 16 * c10::GetNUMAPageSize();
+  void* data = c10::alloc_cpu(nbytes);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(data) % c10::GetNUMAPageSize(), 0);
+  ASSERT_EQ(c10::GetNUMANode(data), last_node);
+  c10::free_cpu(data);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+/// Defines the BFloat16 type (brain floating-point). It has the same 8-bit
+/// exponent as float32 and a 7-bit mantissa, so it covers the range of float32
+/// with less precision, and converting to float32 is a 16-bit shift. As with
+/// Half, arithmetic is implemented by converting to float and performing the
+/// operation in float32; BFloat16 is meant for storage, to halve the memory
+/// traffic of memory bound kernels.
+
+#include <c10/macros/Macros.h>
+#include <c10/util/Half.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+
+namespace c10 {
+
+namespace detail {
+
+  inline C10_HOST_DEVICE float f32_from_bits(uint16_t src) {
+    float res = 0;
+    uint32_t tmp = src;
+    tmp <<= 16;
+    std::memcpy(&res, &tmp, sizeof(tmp));
+    return res;
+  }
+
+  inline C10_HOST_DEVICE uint16_t bits_from_f32(float src) {
+    uint32_t res = 0;
+    std::memcpy(&res, &src, sizeof(res));
+    return res >> 16;
+  }
+
+  /*
+   * Convert a 32-bit floating-point number in IEEE single-precision format to
+   * the upper 16 bits, rounding to the nearest value and to even on ties, like
+   * the hardware conversions (AVX512-BF16, ARMv8.6) do. NaNs are kept quiet
+   * NaNs instead of being rounded up to infinity.
+   */
+  inline C10_HOST_DEVICE uint16_t round_to_nearest_even(float src) {
+    if (std::isnan(src)) {
+      return UINT16_C(0x7FC0);
+    }
+    uint32_t U32 = 0;
+    std::memcpy(&U32, &src, sizeof(U32));
+    uint32_t rounding_bias = ((U32 >> 16) & 1) + UINT32_C(0x7FFF);
+    return static_cast<uint16_t>((U32 + rounding_bias) >> 16);
+  }
+
+} // namespace detail
+
+struct alignas(2) BFloat16 {
+  uint16_t x;
+
+  struct from_bits_t {};
+  static constexpr from_bits_t from_bits() {
+    return from_bits_t();
+  }
+
+  // HIP wants __host__ __device__ tag, CUDA does not
+#ifdef __HIP_PLATFORM_HCC__
+  C10_HOST_DEVICE BFloat16() = default;
+#else
+  BFloat16() = default;
+#endif
+
+  constexpr C10_HOST_DEVICE BFloat16(unsigned short bits, from_bits_t)
+      : x(bits){};
+  inline C10_HOST_DEVICE BFloat16(float value);
+  inline C10_HOST_DEVICE operator float() const;
+};
+
+C10_API std::ostream& operator<<(std::ostream& out, const BFloat16& value);
+
+} // namespace c10
+
+#include <c10/util/BFloat16-inl.h>
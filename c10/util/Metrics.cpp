@@ -0,0 +1,203 @@
+#include <c10/util/Metrics.h>
+
+#include <c10/util/Exception.h>
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace c10 {
+namespace metrics {
+
+Histogram::Histogram(std::vector<double> bounds)
+    : bounds_(std::move(bounds)),
+      counts_(new std::atomic<int64_t>[bounds_.size() + 1]) {
+  AT_CHECK(
+      std::is_sorted(bounds_.begin(), bounds_.end()),
+      "Histogram bounds must be increasing");
+  for (size_t i = 0; i <= bounds_.size(); ++i) {
+    counts_[i] = 0;
+  }
+}
+
+void Histogram::observe(double value) {
+  const auto bucket =
+      std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin();
+  counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+  auto sum = sum_.load(std::memory_order_relaxed);
+  while (!sum_.compare_exchange_weak(
+      sum, sum + value, std::memory_order_relaxed)) {
+  }
+}
+
+std::vector<int64_t> Histogram::counts() const {
+  std::vector<int64_t> counts(bounds_.size() + 1);
+  for (size_t i = 0; i < counts.size(); ++i) {
+    counts[i] = counts_[i].load(std::memory_order_relaxed);
+  }
+  return counts;
+}
+
+struct MetricsRegistry::Entry {
+  std::string name;
+  std::string help;
+  MetricType type;
+  std::unique_ptr<Counter> counter;
+  std::unique_ptr<Histogram> histogram;
+  Collector collector;
+};
+
+MetricsRegistry& MetricsRegistry::get() {
+  // Leaked, so that metrics can be updated from static destructors.
+  static MetricsRegistry* registry = new MetricsRegistry();
+  return *registry;
+}
+
+MetricsRegistry::Entry& MetricsRegistry::entry(
+    const std::string& name,
+    const std::string& help,
+    MetricType type) {
+  for (auto& entry : entries_) {
+    if (entry->name == name) {
+      AT_CHECK(entry->type == type, "Metric ", name, " has another type");
+      return *entry;
+    }
+  }
+  entries_.emplace_back(new Entry{name, help, type, nullptr, nullptr, nullptr});
+  return *entries_.back();
+}
+
+Counter* MetricsRegistry::counter(
+    const std::string& name,
+    const std::string& help) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto& e = entry(name, help, MetricType::Counter);
+  if (!e.counter) {
+    e.counter.reset(new Counter());
+  }
+  return e.counter.get();
+}
+
+Counter* MetricsRegistry::gauge(
+    const std::string& name,
+    const std::string& help) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto& e = entry(name, help, MetricType::Gauge);
+  if (!e.counter) {
+    e.counter.reset(new Counter());
+  }
+  return e.counter.get();
+}
+
+Histogram* MetricsRegistry::histogram(
+    const std::string& name,
+    const std::string& help,
+    std::vector<double> bounds) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto& e = entry(name, help, MetricType::Histogram);
+  if (!e.histogram) {
+    e.histogram.reset(new Histogram(std::move(bounds)));
+  }
+  return e.histogram.get();
+}
+
+void MetricsRegistry::addCollector(
+    const std::string& name,
+    const std::string& help,
+    MetricType type,
+    Collector collector) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  entry(name, help, type).collector = std::move(collector);
+}
+
+std::vector<MetricFamily> MetricsRegistry::collect() const {
+  std::vector<MetricFamily> metrics;
+  std::vector<Collector> collectors;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (const auto& entry : entries_) {
+      metrics.push_back({entry->name, entry->help, entry->type, {}});
+      auto& samples = metrics.back().samples;
+      if (entry->counter) {
+        samples.push_back({"", "", static_cast<double>(entry->counter->value())});
+      }
+      if (entry->histogram) {
+        const auto& bounds = entry->histogram->bounds();
+        const auto counts = entry->histogram->counts();
+        int64_t cumulative = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+          cumulative += counts[i];
+          std::ostringstream le;
+          le.precision(15);
+          le << "le=\"";
+          if (i < bounds.size()) {
+            le << bounds[i];
+          } else {
+            le << "+Inf";
+          }
+          le << "\"";
+          samples.push_back(
+              {"_bucket", le.str(), static_cast<double>(cumulative)});
+        }
+        samples.push_back({"_sum", "", entry->histogram->sum()});
+        samples.push_back({"_count", "", static_cast<double>(cumulative)});
+      }
+      collectors.push_back(entry->collector);
+    }
+  }
+  // Collectors run without the lock, so that they may use the registry.
+  for (size_t i = 0; i < metrics.size(); ++i) {
+    if (collectors[i]) {
+      collectors[i](metrics[i].samples);
+    }
+  }
+  std::sort(
+      metrics.begin(),
+      metrics.end(),
+      [](const MetricFamily& a, const MetricFamily& b) {
+        return a.name < b.name;
+      });
+  return metrics;
+}
+
+std::string toPrometheusText(const std::vector<MetricFamily>& metrics) {
+  std::ostringstream text;
+  // Enough digits for the byte and event counts to be printed exactly
+  text.precision(15);
+  for (const auto& metric : metrics) {
+    if (metric.samples.empty()) {
+      continue;
+    }
+    text << "# HELP " << metric.name << " " << metric.help << "\n";
+    text << "# TYPE " << metric.name << " ";
+    switch (metric.type) {
+      case MetricType::Counter:
+        text << "counter";
+        break;
+      case MetricType::Gauge:
+        text << "gauge";
+        break;
+      case MetricType::Histogram:
+        text << "histogram";
+        break;
+    }
+    text << "\n";
+    for (const auto& sample : metric.samples) {
+      text << metric.name << sample.suffix;
+      if (!sample.labels.empty()) {
+        text << "{" << sample.labels << "}";
+      }
+      text << " ";
+      if (std::isinf(sample.value)) {
+        text << (sample.value > 0 ? "+Inf" : "-Inf");
+      } else {
+        text << sample.value;
+      }
+      text << "\n";
+    }
+  }
+  return text.str();
+}
+
+} // namespace metrics
+} // namespace c10
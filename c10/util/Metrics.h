@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <c10/macros/Macros.h>
+
+namespace c10 {
+namespace metrics {
+
+enum class MetricType { Counter, Gauge, Histogram };
+
+// One value of a metric. `labels` are already formatted the Prometheus way,
+// e.g. `device="0"`, and `suffix` is appended to the name of the metric
+// (histograms have `_bucket`, `_sum` and `_count` samples).
+struct C10_API MetricSample {
+  std::string suffix;
+  std::string labels;
+  double value;
+};
+
+struct C10_API MetricFamily {
+  std::string name;
+  std::string help;
+  MetricType type;
+  std::vector<MetricSample> samples;
+};
+
+// A value that only changes through add(), which is a single relaxed atomic
+// operation. Counters only go up; gauges registered with
+// MetricsRegistry::gauge() use the same class and may go down.
+class C10_API Counter {
+ public:
+  void add(int64_t delta = 1) {
+    value_.fetch_add(delta, std::memory_order_relaxed);
+  }
+  int64_t value() const {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<int64_t> value_{0};
+};
+
+// Counts observations into buckets with the given (increasing) upper
+// bounds, plus an implicit +Inf bucket. observe() is lock free.
+class C10_API Histogram {
+ public:
+  explicit Histogram(std::vector<double> bounds);
+
+  void observe(double value);
+
+  const std::vector<double>& bounds() const {
+    return bounds_;
+  }
+  // The number of observations of each bucket (not cumulative), the last
+  // one being the +Inf bucket.
+  std::vector<int64_t> counts() const;
+  double sum() const {
+    return sum_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::vector<double> bounds_;
+  std::unique_ptr<std::atomic<int64_t>[]> counts_;
+  std::atomic<double> sum_{0};
+};
+
+// Holds the metrics of the process, keyed by name.
+//
+// Metrics are created once, usually into a function-local static, and the
+// returned pointers stay valid for the lifetime of the process, so updating
+// them never takes a lock:
+//
+//   static auto* compiles = c10::metrics::MetricsRegistry::get().counter(
+//       "torch_fuser_kernels_compiled_total", "Fusion kernels compiled.");
+//   compiles->add();
+//
+// Values that already exist somewhere else (e.g. the statistics of an
+// allocator) are exported with a collector, which is called on every
+// collect() instead. collect() is meant to be pulled periodically by the
+// monitoring of the process, see toPrometheusText().
+class C10_API MetricsRegistry {
+ public:
+  using Collector = std::function<void(std::vector<MetricSample>&)>;
+
+  static MetricsRegistry& get();
+
+  // Returns the metric with the given name, creating it if it doesn't
+  // exist. A name must always be used for the same type of metric.
+  Counter* counter(const std::string& name, const std::string& help);
+  Counter* gauge(const std::string& name, const std::string& help);
+  Histogram* histogram(
+      const std::string& name,
+      const std::string& help,
+      std::vector<double> bounds);
+
+  // Registers (or replaces) the collector of the metric `name`.
+  void addCollector(
+      const std::string& name,
+      const std::string& help,
+      MetricType type,
+      Collector collector);
+
+  // The current values of all the metrics, sorted by name.
+  std::vector<MetricFamily> collect() const;
+
+ private:
+  struct Entry;
+
+  Entry& entry(const std::string& name, const std::string& help, MetricType type);
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Entry>> entries_;
+};
+
+// Formats metrics in the Prometheus text exposition format.
+C10_API std::string toPrometheusText(const std::vector<MetricFamily>& metrics);
+
+} // namespace metrics
+} // namespace c10
@@ -0,0 +1,41 @@
+#pragma once
+
+// Static tracepoints (USDT probes), which cost a nop until a tracer such as
+// bpftrace or perf attaches to them, e.g.
+//
+//   bpftrace -e 'usdt:libtorch.so:pytorch:op_start { @[str(arg0)] = count(); }'
+//
+// C10_SDT(name, args...) defines the probe `name` of the `pytorch` provider
+// with up to 8 integer or pointer arguments. The probes of the runtime are:
+//
+//   op_start(name), op_done(name)            an op called through VariableType
+//   cpu_alloc(ptr, size), cpu_free(ptr)      alloc_cpu() and free_cpu()
+//   cpu_cache_miss(size)                     the CPU caching allocator
+//   cuda_alloc(ptr, size, device, stream), cuda_free(ptr, size, device),
+//   cuda_cache_miss(size, device)            the CUDA caching allocator
+//   autograd_function_start(type_name, sequence_nr),
+//   autograd_function_done(type_name, sequence_nr)
+//                                            a Function run by the engine
+//   graph_executor_compile_start(executor),
+//   graph_executor_compile_done(executor)    the optimization of a graph for
+//                                            a new execution plan
+//   c10d_collective_start(work, backend),
+//   c10d_collective_done(work, success)      a collective of c10d (NCCL
+//                                            collectives are done once
+//                                            launched on their streams)
+//
+// String arguments are `const char*`, type names are mangled.
+
+#include <cstddef>
+
+#if defined(__ELF__) && (defined(__x86_64__) || defined(__i386__))
+#include <c10/util/StaticTracepointELFx86.h>
+
+#define C10_SDT_PROVIDER(provider, name, ...)                     \
+  C10_SDT_PROBE_N(                                                \
+    provider, name, C10_SDT_NARG(0, ##__VA_ARGS__), ##__VA_ARGS__)
+#else
+#define C10_SDT_PROVIDER(provider, name, ...) do {} while(0)
+#endif
+
+#define C10_SDT(name, ...) C10_SDT_PROVIDER(pytorch, name, ##__VA_ARGS__)
@@ -0,0 +1,100 @@
+#pragma once
+
+// Default constraint for the probe arguments as operands.
+#ifndef C10_SDT_ARG_CONSTRAINT
+#define C10_SDT_ARG_CONSTRAINT        "nor"
+#endif
+
+// Instruction to emit for the probe.
+#define C10_SDT_NOP                   nop
+
+// Note section properties.
+#define C10_SDT_NOTE_NAME             "stapsdt"
+#define C10_SDT_NOTE_TYPE             3
+
+// Size of address depending on platform.
+#ifdef __LP64__
+#define C10_SDT_ASM_ADDR              .8byte
+#else
+#define C10_SDT_ASM_ADDR              .4byte
+#endif
+
+// Assembler helper Macros.
+#define C10_SDT_S(x)                  #x
+#define C10_SDT_ASM_1(x)              C10_SDT_S(x) "\n"
+#define C10_SDT_ASM_2(a, b)           C10_SDT_S(a) "," C10_SDT_S(b) "\n"
+#define C10_SDT_ASM_3(a, b, c)        C10_SDT_S(a) "," C10_SDT_S(b) ","        \
+                                      C10_SDT_S(c) "\n"
+#define C10_SDT_ASM_STRING(x)         C10_SDT_ASM_1(.asciz C10_SDT_S(x))
+
+// Helper to determine the size of an argument.
+#define C10_SDT_ISARRAY(x)    (__builtin_classify_type(x) == 14)
+#define C10_SDT_ARGSIZE(x)    (C10_SDT_ISARRAY(x) ? sizeof(void*) : sizeof(x))
+
+// Format of each probe arguments as operand.
+// Size of the arugment tagged with C10_SDT_Sn, with "n" constraint.
+// Value of the argument tagged with C10_SDT_An, with configured constraint.
+#define C10_SDT_ARG(n, x)                                                      \
+  [C10_SDT_S##n] "n"                ((size_t)C10_SDT_ARGSIZE(x)),              \
+  [C10_SDT_A##n] C10_SDT_ARG_CONSTRAINT (x)
+
+// Templates to append arguments as operands.
+#define C10_SDT_OPERANDS_0()          [__sdt_dummy] "g" (0)
+#define C10_SDT_OPERANDS_1(_1)        C10_SDT_ARG(1, _1)
+#define C10_SDT_OPERANDS_2(_1, _2)                                             \
+  C10_SDT_OPERANDS_1(_1), C10_SDT_ARG(2, _2)
+#define C10_SDT_OPERANDS_3(_1, _2, _3)                                         \
+  C10_SDT_OPERANDS_2(_1, _2), C10_SDT_ARG(3, _3)
+#define C10_SDT_OPERANDS_4(_1, _2, _3, _4)                                     \
+  C10_SDT_OPERANDS_3(_1, _2, _3), C10_SDT_ARG(4, _4)
+#define C10_SDT_OPERANDS_5(_1, _2, _3, _4, _5)                                 \
+  C10_SDT_OPERANDS_4(_1, _2, _3, _4), C10_SDT_ARG(5, _5)
+#define C10_SDT_OPERANDS_6(_1, _2, _3, _4, _5, _6)                             \
+  C10_SDT_OPERANDS_5(_1, _2, _3, _4, _5), C10_SDT_ARG(6, _6)
+#define C10_SDT_OPERANDS_7(_1, _2, _3, _4, _5, _6, _7)                         \
+  C10_SDT_OPERANDS_6(_1, _2, _3, _4, _5, _6), C10_SDT_ARG(7, _7)
+#define C10_SDT_OPERANDS_8(_1, _2, _3, _4, _5, _6, _7, _8)                     \
+  C10_SDT_OPERANDS_7(_1, _2, _3, _4, _5, _6, _7), C10_SDT_ARG(8, _8)
+
+// Templates to reference the arguments from operands in note section.
+#define C10_SDT_ARGFMT(no)          %n[C10_SDT_S##no]@%[C10_SDT_A##no]
+#define C10_SDT_ARG_TEMPLATE_0      /*No arguments*/
+#define C10_SDT_ARG_TEMPLATE_1      C10_SDT_ARGFMT(1)
+#define C10_SDT_ARG_TEMPLATE_2      C10_SDT_ARG_TEMPLATE_1 C10_SDT_ARGFMT(2)
+#define C10_SDT_ARG_TEMPLATE_3      C10_SDT_ARG_TEMPLATE_2 C10_SDT_ARGFMT(3)
+#define C10_SDT_ARG_TEMPLATE_4      C10_SDT_ARG_TEMPLATE_3 C10_SDT_ARGFMT(4)
+#define C10_SDT_ARG_TEMPLATE_5      C10_SDT_ARG_TEMPLATE_4 C10_SDT_ARGFMT(5)
+#define C10_SDT_ARG_TEMPLATE_6      C10_SDT_ARG_TEMPLATE_5 C10_SDT_ARGFMT(6)
+#define C10_SDT_ARG_TEMPLATE_7      C10_SDT_ARG_TEMPLATE_6 C10_SDT_ARGFMT(7)
+#define C10_SDT_ARG_TEMPLATE_8      C10_SDT_ARG_TEMPLATE_7 C10_SDT_ARGFMT(8)
+
+// Structure of note section for the probe.
+#define C10_SDT_NOTE_CONTENT(provider, name, arg_template)                     \
+  C10_SDT_ASM_1(990: C10_SDT_NOP)                                              \
+  C10_SDT_ASM_3(     .pushsection .note.stapsdt,"","note")                     \
+  C10_SDT_ASM_1(     .balign 4)                                                \
+  C10_SDT_ASM_3(     .4byte 992f-991f, 994f-993f, C10_SDT_NOTE_TYPE)           \
+  C10_SDT_ASM_1(991: .asciz C10_SDT_NOTE_NAME)                                 \
+  C10_SDT_ASM_1(992: .balign 4)                                                \
+  C10_SDT_ASM_1(993: C10_SDT_ASM_ADDR 990b)                                    \
+  C10_SDT_ASM_1(     C10_SDT_ASM_ADDR 0) /*Reserved for Semaphore address*/    \
+  C10_SDT_ASM_1(     C10_SDT_ASM_ADDR 0) /*Reserved for Semaphore name*/       \
+  C10_SDT_ASM_STRING(provider)                                                 \
+  C10_SDT_ASM_STRING(name)                                                     \
+  C10_SDT_ASM_STRING(arg_template)                                             \
+  C10_SDT_ASM_1(994: .balign 4)                                                \
+  C10_SDT_ASM_1(     .popsection)
+
+// Main probe Macro.
+#define C10_SDT_PROBE(provider, name, n, arglist)                              \
+    __asm__ __volatile__ (                                                     \
+      C10_SDT_NOTE_CONTENT(provider, name, C10_SDT_ARG_TEMPLATE_##n)           \
+      :: C10_SDT_OPERANDS_##n arglist                                          \
+    )                                                                          \
+
+// Helper Macros to handle variadic arguments.
+#define C10_SDT_NARG_(_0, _1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+#define C10_SDT_NARG(...)                                                      \
+  C10_SDT_NARG_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define C10_SDT_PROBE_N(provider, name, N, ...)                                \
+  C10_SDT_PROBE(provider, name, N, (__VA_ARGS__))
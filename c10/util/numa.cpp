@@ -14,6 +14,29 @@ C10_DEFINE_bool(caffe2_cpu_numa_enabled, false, "Use NUMA whenever possible.");
 
 namespace c10 {
 
+namespace {
+thread_local int allocation_numa_node = -1;
+} // namespace
+
+void SetAllocationNUMANode(int numa_node_id) {
+  AT_CHECK(numa_node_id >= -1, "Invalid NUMA node id: ", numa_node_id);
+  allocation_numa_node = numa_node_id;
+}
+
+int GetAllocationNUMANodeOverride() {
+  return allocation_numa_node;
+}
+
+int GetAllocationNUMANode() {
+  if (!IsNUMAEnabled()) {
+    return -1;
+  }
+  if (allocation_numa_node >= 0) {
+    return allocation_numa_node;
+  }
+  return GetCurrentNUMANode();
+}
+
 #ifdef C10_ENABLE_NUMA
 bool IsNUMAEnabled() {
   return FLAGS_caffe2_cpu_numa_enabled && numa_available() >= 0;
@@ -103,6 +126,11 @@ int GetCurrentNUMANode() {
   return n;
 }
 
+size_t GetNUMAPageSize() {
+  static const size_t page_size = getpagesize();
+  return page_size;
+}
+
 #else // C10_ENABLE_NUMA
 
 bool IsNUMAEnabled() {
@@ -127,6 +155,10 @@ int GetCurrentNUMANode() {
   return -1;
 }
 
+size_t GetNUMAPageSize() {
+  return 4096;
+}
+
 #endif // C10_NUMA_ENABLED
 
 } // namespace c10
@@ -37,4 +37,47 @@ C10_API void NUMAMove(void* ptr, size_t size, int numa_node_id);
  */
 C10_API int GetCurrentNUMANode();
 
+/**
+ * Get the NUMA node that CPU allocations of the calling thread are placed
+ * on: the node set by SetAllocationNUMANode() if any, else the node the
+ * thread is running on. Returns -1 if NUMA is disabled.
+ */
+C10_API int GetAllocationNUMANode();
+
+/**
+ * Place CPU allocations of the calling thread on `numa_node_id`, or on the
+ * thread's current node if it is -1
+ */
+C10_API void SetAllocationNUMANode(int numa_node_id);
+
+/**
+ * The node set by SetAllocationNUMANode() for the calling thread, or -1
+ */
+C10_API int GetAllocationNUMANodeOverride();
+
+/**
+ * Get the size of a page that NUMAMove() moves as a unit
+ */
+C10_API size_t GetNUMAPageSize();
+
+/**
+ * RAII guard placing the CPU allocations of the current thread on a given
+ * NUMA node, e.g. while loading weights that are used from another socket
+ */
+class C10_API NUMAAllocationGuard {
+ public:
+  explicit NUMAAllocationGuard(int numa_node_id)
+      : prev_(GetAllocationNUMANodeOverride()) {
+    SetAllocationNUMANode(numa_node_id);
+  }
+  ~NUMAAllocationGuard() {
+    SetAllocationNUMANode(prev_);
+  }
+  NUMAAllocationGuard(const NUMAAllocationGuard&) = delete;
+  NUMAAllocationGuard& operator=(const NUMAAllocationGuard&) = delete;
+
+ private:
+  int prev_;
+};
+
 } // namespace c10
@@ -18,6 +18,7 @@
 #include <exception>
 
 #include "c10/macros/Macros.h"
+#include "c10/util/BFloat16.h"
 #include "c10/util/Backtrace.h"
 #include "c10/util/C++17.h"
 #include "c10/util/Exception.h"
@@ -624,6 +625,7 @@ CAFFE_DECLARE_PREALLOCATED_KNOWN_TYPE(
     detail::_guard_long_unique<std::vector<long>>)
 
 CAFFE_DECLARE_PREALLOCATED_KNOWN_TYPE(27, c10::qint8);
+CAFFE_DECLARE_PREALLOCATED_KNOWN_TYPE(28, at::BFloat16)
 
-CAFFE_DECLARE_PREALLOCATED_KNOWN_TYPE(28, _CaffeHighestPreallocatedTypeId)
+CAFFE_DECLARE_PREALLOCATED_KNOWN_TYPE(29, _CaffeHighestPreallocatedTypeId)
 } // namespace caffe2
@@ -9,6 +9,7 @@
 #include "caffe2/core/operator.h"
 #include "caffe2/core/workspace.h"
 #include "caffe2/onnx/onnx_exporter.h"
+#include "caffe2/opt/backend_cutting.h"
 #include "caffe2/proto/caffe2_pb.h"
 #include "onnx/onnx_pb.h"
 
@@ -43,6 +44,11 @@ class TensorRTTransformer {
       NetDef* pred_net,
       const std::unordered_map<std::string, TensorShape>& shape_hints);
 
+  // Which of the supported subgraphs are lowered to TensorRT
+  void SetCuttingOptions(const opt::BackendCuttingOptions& options) {
+    cutting_options_ = options;
+  }
+
  private:
   caffe2::NetDef SubnetToTrtOp(
       const caffe2::NetDef& net,
@@ -88,5 +94,7 @@ class TensorRTTransformer {
   size_t max_workspace_size_{1024 * 1024 * 2};
   int verbosity_{2};
   bool debug_builder_{false};
+
+  opt::BackendCuttingOptions cutting_options_;
 };
 } // namespace caffe2
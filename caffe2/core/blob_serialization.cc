@@ -1,5 +1,8 @@
 #include "caffe2/core/blob_serialization.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <sstream>
 #include <mutex>
 
@@ -21,7 +24,149 @@ C10_DEFINE_bool(
     false,
     "Serialize FLOAT16 tensors using byte_data field");
 
+C10_DEFINE_bool(
+    caffe2_serialize_using_raw_data,
+    false,
+    "Serialize tensors of fixed width types as their little-endian bytes in "
+    "the raw_data field, which is much faster than the typed fields");
+
+C10_DEFINE_string(
+    caffe2_serialize_float_as,
+    "",
+    "Lossy format to serialize FLOAT tensors in, one of fp16, bf16 or "
+    "rowwise_uint8 (8-bit quantization of each row, for tensors of at least "
+    "2 dimensions). Deserialization converts them back to float");
+
 namespace caffe2 {
+
+namespace {
+
+bool IsLittleEndian() {
+  const int kValue = 1;
+  return reinterpret_cast<const char*>(&kValue)[0] == 1;
+}
+
+bool IsFixedWidthType(TensorProto::DataType data_type) {
+  switch (data_type) {
+    case TensorProto_DataType_FLOAT:
+    case TensorProto_DataType_INT32:
+    case TensorProto_DataType_BOOL:
+    case TensorProto_DataType_UINT8:
+    case TensorProto_DataType_INT8:
+    case TensorProto_DataType_UINT16:
+    case TensorProto_DataType_INT16:
+    case TensorProto_DataType_INT64:
+    case TensorProto_DataType_FLOAT16:
+    case TensorProto_DataType_DOUBLE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Format --caffe2_serialize_float_as selects for the given tensor
+TensorProto::RawDataFormat FloatSerializationFormat(const Tensor& tensor) {
+  const auto& format = FLAGS_caffe2_serialize_float_as;
+  if (format.empty() || !tensor.dtype().Match<float>()) {
+    return TensorProto_RawDataFormat_NATIVE;
+  }
+  if (format == "fp16") {
+    return TensorProto_RawDataFormat_FP16;
+  } else if (format == "bf16") {
+    return TensorProto_RawDataFormat_BF16;
+  } else if (format == "rowwise_uint8") {
+    return tensor.dim() >= 2 ? TensorProto_RawDataFormat_ROWWISE_UINT8
+                             : TensorProto_RawDataFormat_NATIVE;
+  }
+  CAFFE_THROW("Unknown --caffe2_serialize_float_as format: ", format);
+}
+
+void EncodeFloats(
+    TensorProto::RawDataFormat format,
+    const float* values,
+    int64_t size,
+    int64_t row_size,
+    std::string* raw) {
+  switch (format) {
+    case TensorProto_RawDataFormat_FP16: {
+      raw->resize(size * sizeof(uint16_t));
+      auto* out = reinterpret_cast<uint16_t*>(&(*raw)[0]);
+      for (int64_t i = 0; i < size; ++i) {
+        out[i] = at::Half(values[i]).x;
+      }
+    } break;
+    case TensorProto_RawDataFormat_BF16: {
+      raw->resize(size * sizeof(uint16_t));
+      auto* out = reinterpret_cast<uint16_t*>(&(*raw)[0]);
+      for (int64_t i = 0; i < size; ++i) {
+        out[i] = c10::detail::round_to_nearest_even(values[i]);
+      }
+    } break;
+    case TensorProto_RawDataFormat_ROWWISE_UINT8: {
+      const int64_t rows = size / row_size;
+      const int64_t row_bytes = row_size + 2 * sizeof(float);
+      raw->resize(rows * row_bytes);
+      for (int64_t r = 0; r < rows; ++r) {
+        const float* row = values + r * row_size;
+        auto* out = reinterpret_cast<uint8_t*>(&(*raw)[r * row_bytes]);
+        const auto minmax = std::minmax_element(row, row + row_size);
+        const float bias = *minmax.first;
+        const float scale = (*minmax.second - bias) / 255.0f;
+        const float inverse_scale = scale > 0 ? 1.0f / scale : 0.0f;
+        for (int64_t i = 0; i < row_size; ++i) {
+          out[i] = static_cast<uint8_t>(
+              std::lrintf((row[i] - bias) * inverse_scale));
+        }
+        std::memcpy(out + row_size, &scale, sizeof(float));
+        std::memcpy(out + row_size + sizeof(float), &bias, sizeof(float));
+      }
+    } break;
+    default:
+      CAFFE_THROW("Not a lossy float format: ", format);
+  }
+}
+
+void DecodeFloats(
+    TensorProto::RawDataFormat format,
+    const std::string& raw,
+    int64_t size,
+    int64_t row_size,
+    float* values) {
+  switch (format) {
+    case TensorProto_RawDataFormat_FP16:
+    case TensorProto_RawDataFormat_BF16: {
+      CAFFE_ENFORCE_EQ(
+          raw.size(), size * sizeof(uint16_t), "Incorrect proto field size.");
+      const auto* in = reinterpret_cast<const uint16_t*>(raw.data());
+      for (int64_t i = 0; i < size; ++i) {
+        values[i] = format == TensorProto_RawDataFormat_FP16
+            ? static_cast<float>(at::Half(in[i], at::Half::from_bits()))
+            : c10::detail::f32_from_bits(in[i]);
+      }
+    } break;
+    case TensorProto_RawDataFormat_ROWWISE_UINT8: {
+      const int64_t rows = size / row_size;
+      const int64_t row_bytes = row_size + 2 * sizeof(float);
+      CAFFE_ENFORCE_EQ(
+          raw.size(), rows * row_bytes, "Incorrect proto field size.");
+      for (int64_t r = 0; r < rows; ++r) {
+        const auto* in =
+            reinterpret_cast<const uint8_t*>(raw.data() + r * row_bytes);
+        float scale, bias;
+        std::memcpy(&scale, in + row_size, sizeof(float));
+        std::memcpy(&bias, in + row_size + sizeof(float), sizeof(float));
+        float* row = values + r * row_size;
+        for (int64_t i = 0; i < row_size; ++i) {
+          row[i] = in[i] * scale + bias;
+        }
+      }
+    } break;
+    default:
+      CAFFE_THROW("Unsupported raw data format: ", format);
+  }
+}
+
+} // namespace
 /**
  * @brief StringSerializer is the serializer for String.
  *
@@ -123,6 +268,13 @@ void TensorSerializer::SerializeWithChunkSize(
   } else if (chunk_size == kDefaultChunkSize) {
     chunk_size = FLAGS_caffe2_tensor_chunk_size;
   }
+  // Rowwise formats quantize whole rows, so chunks have to start at rows
+  if (tensor.numel() > chunk_size &&
+      FloatSerializationFormat(tensor) ==
+          TensorProto_RawDataFormat_ROWWISE_UINT8) {
+    const auto row_size = tensor.size_from_dim(1);
+    chunk_size = std::max<int64_t>(chunk_size / row_size, 1) * row_size;
+  }
 
   auto processChunk = [&](int64_t chunkStart) {
     BlobProto blob_proto;
@@ -226,6 +378,48 @@ void TensorSerializer::Serialize(
   // TODO: use CUDAGuard here instead of context and employ explicit sync
   // copy
   auto uniq_ptr = CreateContext(input.GetDevice());
+
+  const auto float_format = FloatSerializationFormat(input);
+  if (chunkSize > 0 && float_format != TensorProto_RawDataFormat_NATIVE) {
+    const int64_t row_size =
+        float_format == TensorProto_RawDataFormat_ROWWISE_UINT8
+        ? input.size_from_dim(1)
+        : 1;
+    CAFFE_ENFORCE(
+        chunkBegin % row_size == 0 && chunkSize % row_size == 0,
+        "Chunks of rowwise serialized tensors must contain whole rows");
+    std::vector<float> values(chunkSize);
+    uniq_ptr->CopyToCPU<float>(
+        chunkSize, input.template data<float>() + chunkBegin, values.data());
+    uniq_ptr->FinishDeviceComputation();
+    proto.set_storage_type(TensorProto_StorageType_RAW);
+    proto.set_raw_data_format(float_format);
+    EncodeFloats(
+        float_format,
+        values.data(),
+        chunkSize,
+        row_size,
+        proto.mutable_raw_data());
+    return;
+  }
+  if (FLAGS_caffe2_serialize_using_raw_data && IsFixedWidthType(data_type)) {
+    CAFFE_ENFORCE(
+        IsLittleEndian(),
+        "Serialization to raw data on big endian platform is not written yet.");
+    proto.set_storage_type(TensorProto_StorageType_RAW);
+    auto* raw = proto.mutable_raw_data();
+    raw->resize(chunkSize * input.itemsize());
+    if (chunkSize > 0) {
+      uniq_ptr->CopyBytesToCPU(
+          raw->size(),
+          static_cast<const char*>(input.raw_data()) +
+              chunkBegin * input.itemsize(),
+          &(*raw)[0]);
+      uniq_ptr->FinishDeviceComputation();
+    }
+    return;
+  }
+
   // A lot of copypaste is error prone. Should we create a macro for this?
   switch (data_type) {
     case TensorProto_DataType_FLOAT:
@@ -249,7 +443,7 @@ void TensorSerializer::Serialize(
     case TensorProto_DataType_STRING: {
       proto.mutable_string_data()->Reserve(chunkSize);
       const string* content = input.template data<string>();
-      for (int i = chunkBegin; i < chunkBegin + chunkSize; ++i) {
+      for (int64_t i = chunkBegin; i < chunkBegin + chunkSize; ++i) {
         proto.add_string_data(content[i]);
       }
       break;
@@ -305,12 +499,12 @@ void TensorSerializer::Serialize(
             "Serialization of FLOAT16 on big endian platform "
             "is not written yet.");
         unique_ptr<char[]> buffer(new char[2 * chunkSize]);
-        this->context_->template CopyToCPU<char>(
+        uniq_ptr->template CopyToCPU<char>(
             2 * chunkSize,
             reinterpret_cast<const char*>(
                 input.template data<at::Half>() + chunkBegin),
             buffer.get());
-        this->context_->FinishDeviceComputation();
+        uniq_ptr->FinishDeviceComputation();
         proto.set_byte_data(buffer.release(), 2 * chunkSize);
       } else {
         detail::CopyToProtoWithCast(
@@ -332,7 +526,7 @@ void TensorSerializer::Serialize(
       proto.mutable_string_data()->Reserve(chunkSize);
       if (chunkSize > 0) {
         const char* raw_data = static_cast<const char*>(input.raw_data());
-        for (int i = chunkBegin; i < chunkBegin + chunkSize; ++i) {
+        for (int64_t i = chunkBegin; i < chunkBegin + chunkSize; ++i) {
           proto.add_string_data(SerializeBlob(
               raw_data + i * input.itemsize(), input.dtype(), ""));
         }
@@ -506,6 +700,57 @@ void TensorDeserializer::DeserializeToTensor(
       tensor->numel());
   auto chunkSize = chunkEnd - chunkBegin;
 
+  if (tensor_proto.storage_type() == TensorProto_StorageType_RAW) {
+    const auto& raw = tensor_proto.raw_data();
+    if (tensor_proto.raw_data_format() == TensorProto_RawDataFormat_NATIVE) {
+      CAFFE_ENFORCE(
+          IsFixedWidthType(tensor_proto.data_type()),
+          "Raw data is only supported for fixed width types");
+      CAFFE_ENFORCE(
+          IsLittleEndian(),
+          "Deserialization of raw data on big endian platform "
+          "is not written yet.");
+      CAFFE_ENFORCE_EQ(
+          chunkSize * tensor->itemsize(),
+          raw.size(),
+          "Incorrect proto field size.");
+      if (chunkSize > 0) {
+        context->CopyBytesFromCPU(
+            raw.size(),
+            raw.data(),
+            static_cast<char*>(tensor->raw_mutable_data(tensor->dtype())) +
+                chunkBegin * tensor->itemsize());
+      }
+    } else {
+      CAFFE_ENFORCE_EQ(
+          tensor_proto.data_type(),
+          TensorProto_DataType_FLOAT,
+          "Lossy raw data formats are only supported for FLOAT tensors");
+      int64_t row_size = 1;
+      if (tensor_proto.raw_data_format() ==
+          TensorProto_RawDataFormat_ROWWISE_UINT8) {
+        CAFFE_ENFORCE_GE(tensor->dim(), 2);
+        row_size = tensor->size_from_dim(1);
+        CAFFE_ENFORCE(
+            chunkBegin % row_size == 0 && chunkSize % row_size == 0,
+            "Chunks of rowwise serialized tensors must contain whole rows");
+      }
+      std::vector<float> values(chunkSize);
+      DecodeFloats(
+          tensor_proto.raw_data_format(),
+          raw,
+          chunkSize,
+          row_size,
+          values.data());
+      context->CopyFromCPU<float>(
+          chunkSize,
+          values.data(),
+          tensor->template mutable_data<float>() + chunkBegin);
+    }
+    context->FinishDeviceComputation();
+    return;
+  }
+
   switch (tensor_proto.data_type()) {
     case TensorProto_DataType_FLOAT:
       detail::CopyFromProtoAsIs(
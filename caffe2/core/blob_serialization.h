@@ -16,6 +16,8 @@
 C10_DECLARE_int(caffe2_tensor_chunk_size);
 C10_DECLARE_int(caffe2_max_tensor_serializer_threads);
 C10_DECLARE_bool(caffe2_serialize_fp16_as_bytes);
+C10_DECLARE_bool(caffe2_serialize_using_raw_data);
+C10_DECLARE_string(caffe2_serialize_float_as);
 
 namespace caffe2 {
 
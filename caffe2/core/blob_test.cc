@@ -1,3 +1,4 @@
+#include <cmath>
 #include <iostream>
 #include <memory>
 #include <mutex>
@@ -733,6 +734,91 @@ TEST(TensorTest, Half) {
   }
 }
 
+// Serializes the blob in chunks of chunk_size and deserializes all the chunks
+// back into one tensor
+Tensor SerializeAndDeserializeInChunks(
+    const Blob& blob,
+    int chunk_size,
+    std::vector<BlobProto>* chunks) {
+  std::mutex mutex;
+  auto acceptor = [&](const std::string& /*key*/, const std::string& value) {
+    std::lock_guard<std::mutex> guard(mutex);
+    chunks->emplace_back();
+    CHECK(chunks->back().ParseFromString(value));
+  };
+  SerializeBlob(blob, "test", acceptor, chunk_size);
+  CHECK(!chunks->empty());
+  auto tensor = EmptyTensorFromProto(chunks->front().tensor());
+  TensorDeserializer deserializer;
+  for (const auto& chunk : *chunks) {
+    deserializer.DeserializeToTensor(chunk.tensor(), &tensor);
+  }
+  return tensor;
+}
+
+TEST(TensorTest, RawDataSerialization) {
+  FLAGS_caffe2_serialize_using_raw_data = true;
+  Blob blob;
+  TensorCPU* tensor = BlobGetMutableTensor(&blob, CPU);
+  tensor->Resize(7, 3);
+  for (int i = 0; i < tensor->numel(); ++i) {
+    tensor->mutable_data<int64_t>()[i] = (int64_t(1) << 40) + i;
+  }
+  std::vector<BlobProto> chunks;
+  auto new_tensor = SerializeAndDeserializeInChunks(blob, 4, &chunks);
+  FLAGS_caffe2_serialize_using_raw_data = false;
+
+  EXPECT_EQ(chunks.size(), 6);
+  for (const auto& chunk : chunks) {
+    const auto& tensor_proto = chunk.tensor();
+    EXPECT_EQ(tensor_proto.storage_type(), TensorProto_StorageType_RAW);
+    EXPECT_EQ(tensor_proto.int64_data_size(), 0);
+    EXPECT_EQ(
+        tensor_proto.raw_data().size(),
+        (tensor_proto.segment().end() - tensor_proto.segment().begin()) *
+            sizeof(int64_t));
+  }
+  EXPECT_EQ(new_tensor.sizes(), tensor->sizes());
+  for (int i = 0; i < tensor->numel(); ++i) {
+    EXPECT_EQ(new_tensor.data<int64_t>()[i], tensor->data<int64_t>()[i]);
+  }
+}
+
+TEST(TensorTest, LossyFloatSerialization) {
+  Blob blob;
+  TensorCPU* tensor = BlobGetMutableTensor(&blob, CPU);
+  tensor->Resize(10, 16);
+  for (int i = 0; i < tensor->numel(); ++i) {
+    tensor->mutable_data<float>()[i] = std::sin(i) * (i / 16 + 1);
+  }
+  // Relative to the range of the rows, which is at most 2 * 10
+  const std::vector<std::pair<std::string, float>> formats = {
+      {"fp16", 1e-2}, {"bf16", 1e-1}, {"rowwise_uint8", 20.0f / 255}};
+  for (const auto& format : formats) {
+    FLAGS_caffe2_serialize_float_as = format.first;
+    std::vector<BlobProto> chunks;
+    // Rowwise chunks are rounded down to 2 rows
+    auto new_tensor = SerializeAndDeserializeInChunks(blob, 40, &chunks);
+    FLAGS_caffe2_serialize_float_as = "";
+
+    EXPECT_EQ(
+        chunks.size(), format.first == "rowwise_uint8" ? 5 : 4)
+        << format.first;
+    for (const auto& chunk : chunks) {
+      EXPECT_EQ(chunk.tensor().storage_type(), TensorProto_StorageType_RAW);
+      EXPECT_NE(
+          chunk.tensor().raw_data_format(), TensorProto_RawDataFormat_NATIVE);
+      EXPECT_EQ(chunk.tensor().float_data_size(), 0);
+    }
+    EXPECT_EQ(new_tensor.sizes(), tensor->sizes());
+    for (int i = 0; i < tensor->numel(); ++i) {
+      EXPECT_NEAR(
+          new_tensor.data<float>()[i], tensor->data<float>()[i], format.second)
+          << format.first << " " << i;
+    }
+  }
+}
+
 TEST(TensorTest, TensorFactory) {
   Tensor a = empty({1, 2, 3}, at::device(CPU).dtype<float>());
   EXPECT_NE(a.data<float>(), nullptr);
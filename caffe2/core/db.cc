@@ -171,6 +171,108 @@ class MiniDB : public DB {
 REGISTER_CAFFE2_DB(MiniDB, MiniDB);
 REGISTER_CAFFE2_DB(minidb, MiniDB);
 
+void DBReader::EnableReadahead(size_t num_records) {
+  CAFFE_ENFORCE(cursor_ != nullptr, "Reader not initialized.");
+  if (readahead_ > 0) {
+    StopReadahead();
+  }
+  readahead_ = num_records;
+  if (readahead_ > 0) {
+    StartReadahead();
+  }
+}
+
+void DBReader::StartReadahead() const {
+  CAFFE_ENFORCE(!readahead_thread_.joinable());
+  readahead_stop_ = false;
+  readahead_error_ = nullptr;
+  readahead_thread_ = std::thread([this] { ReadaheadLoop(); });
+}
+
+void DBReader::StopReadahead() const {
+  if (!readahead_thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(reader_mutex_);
+    readahead_stop_ = true;
+  }
+  readahead_not_full_.notify_all();
+  readahead_thread_.join();
+  // The cursor is now past the buffered records, so they can only be dropped
+  // together with the position they were read from.
+  std::lock_guard<std::mutex> lock(reader_mutex_);
+  readahead_buffer_.clear();
+}
+
+void DBReader::ReadaheadLoop() const {
+  try {
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(reader_mutex_);
+        readahead_not_full_.wait(lock, [this] {
+          return readahead_stop_ || readahead_buffer_.size() < readahead_;
+        });
+        if (readahead_stop_) {
+          return;
+        }
+      }
+      // Only this thread touches the cursor, the I/O happens without holding
+      // the lock so that Read() can keep draining the buffer meanwhile.
+      std::pair<string, string> record(cursor_->key(), cursor_->value());
+      for (uint32_t s = 0; s < num_shards_; s++) {
+        cursor_->Next();
+        if (!cursor_->Valid()) {
+          MoveToBeginning();
+          break;
+        }
+      }
+      {
+        std::lock_guard<std::mutex> lock(reader_mutex_);
+        readahead_buffer_.push_back(std::move(record));
+      }
+      readahead_not_empty_.notify_one();
+    }
+  } catch (...) {
+    {
+      std::lock_guard<std::mutex> lock(reader_mutex_);
+      readahead_error_ = std::current_exception();
+    }
+    readahead_not_empty_.notify_all();
+  }
+}
+
+void DBReader::ReadFromReadaheadBuffer(
+    string* key,
+    string* value,
+    std::unique_lock<std::mutex>* mutex_lock) const {
+  readahead_not_empty_.wait(*mutex_lock, [this] {
+    return !readahead_buffer_.empty() || readahead_error_;
+  });
+  if (readahead_buffer_.empty()) {
+    std::rethrow_exception(readahead_error_);
+  }
+  *key = std::move(readahead_buffer_.front().first);
+  *value = std::move(readahead_buffer_.front().second);
+  readahead_buffer_.pop_front();
+  mutex_lock->unlock();
+  readahead_not_full_.notify_one();
+}
+
+string DBReader::NextKey() const {
+  std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
+  if (readahead_ == 0) {
+    return cursor_->key();
+  }
+  readahead_not_empty_.wait(mutex_lock, [this] {
+    return !readahead_buffer_.empty() || readahead_error_;
+  });
+  if (readahead_buffer_.empty()) {
+    std::rethrow_exception(readahead_error_);
+  }
+  return readahead_buffer_.front().first;
+}
+
 void DBReaderSerializer::Serialize(
     const void* pointer,
     TypeMeta typeMeta,
@@ -182,8 +284,11 @@ void DBReaderSerializer::Serialize(
   proto.set_name(name);
   proto.set_source(reader.source_);
   proto.set_db_type(reader.db_type_);
-  if (reader.cursor() && reader.cursor()->SupportsSeek()) {
-    proto.set_key(reader.cursor()->key());
+  if (reader.cursor_ && reader.cursor_->SupportsSeek()) {
+    proto.set_key(reader.NextKey());
+  }
+  if (reader.readahead_ > 0) {
+    proto.set_readahead(reader.readahead_);
   }
   BlobProto blob_proto;
   blob_proto.set_name(name);
@@ -1,7 +1,12 @@
 #ifndef CAFFE2_CORE_DB_H_
 #define CAFFE2_CORE_DB_H_
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <mutex>
+#include <thread>
+#include <utility>
 
 #include "c10/util/Registry.h"
 #include "caffe2/core/blob_serialization.h"
@@ -140,6 +145,10 @@ inline bool DBExists(const string& db_type, const string& full_db_name) {
 
 /**
  * A reader wrapper for DB that also allows us to serialize it.
+ *
+ * With EnableReadahead(), the reader keeps a background I/O thread that reads
+ * the next records into a bounded buffer, so that Read() only waits for the
+ * storage when the consumers are faster than the db.
  */
 class CAFFE2_API DBReader {
  public:
@@ -165,6 +174,9 @@ class CAFFE2_API DBReader {
     }
     num_shards_ = 1;
     shard_id_ = 0;
+    if (proto.readahead() > 0) {
+      EnableReadahead(proto.readahead());
+    }
   }
 
   explicit DBReader(std::unique_ptr<DB> db)
@@ -175,11 +187,16 @@ class CAFFE2_API DBReader {
     cursor_ = db_->NewCursor();
   }
 
+  ~DBReader() {
+    StopReadahead();
+  }
+
   void Open(
       const string& db_type,
       const string& source,
       const int32_t num_shards = 1,
       const int32_t shard_id = 0) {
+    StopReadahead();
     // Note(jiayq): resetting is needed when we re-open e.g. leveldb where no
     // concurrent access is allowed.
     cursor_.reset();
@@ -201,6 +218,7 @@ class CAFFE2_API DBReader {
       unique_ptr<DB>&& db,
       const int32_t num_shards = 1,
       const int32_t shard_id = 0) {
+    StopReadahead();
     cursor_.reset();
     db_.reset();
     db_ = std::move(db);
@@ -228,6 +246,10 @@ class CAFFE2_API DBReader {
   void Read(string* key, string* value) const {
     CAFFE_ENFORCE(cursor_ != nullptr, "Reader not initialized.");
     std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
+    if (readahead_ > 0) {
+      ReadFromReadaheadBuffer(key, value, &mutex_lock);
+      return;
+    }
     *key = cursor_->key();
     *value = cursor_->value();
 
@@ -246,16 +268,42 @@ class CAFFE2_API DBReader {
    */
   void SeekToFirst() const {
     CAFFE_ENFORCE(cursor_ != nullptr, "Reader not initialized.");
+    if (readahead_ > 0) {
+      // The buffered records come from the old position, drop them.
+      StopReadahead();
+      {
+        std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
+        MoveToBeginning();
+      }
+      StartReadahead();
+      return;
+    }
     std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
     MoveToBeginning();
   }
 
+  /**
+   * Starts reading up to num_records records ahead of Read() on a background
+   * thread, from the current position of the cursor. Passing 0 goes back to
+   * reading synchronously. Not thread safe with respect to Read().
+   */
+  void EnableReadahead(size_t num_records);
+
+  /**
+   * Returns the number of records read ahead, 0 if readahead is disabled.
+   */
+  size_t readahead() const {
+    return readahead_;
+  }
+
   /**
    * Returns the underlying cursor of the db reader.
    *
    * Note that if you directly use the cursor, the read will not be thread
    * safe, because there is no mechanism to stop multiple threads from
    * accessing the same cursor. You should consider using Read() explicitly.
+   * When readahead is enabled the cursor is owned by the I/O thread and is
+   * ahead of Read(); disable readahead before using it.
    */
   inline Cursor* cursor() const {
     VLOG(1) << "Usually for a DBReader you should use Read() to be "
@@ -274,6 +322,17 @@ class CAFFE2_API DBReader {
     SeekToFirst();
   }
 
+  // Defined in db.cc; all of them expect readahead_ > 0.
+  void StartReadahead() const;
+  void StopReadahead() const;
+  void ReadaheadLoop() const;
+  void ReadFromReadaheadBuffer(
+      string* key,
+      string* value,
+      std::unique_lock<std::mutex>* mutex_lock) const;
+  // The key the next Read() returns, used for serialization.
+  string NextKey() const;
+
   void MoveToBeginning() const {
     cursor_->SeekToFirst();
     for (uint32_t s = 0; s < shard_id_; s++) {
@@ -291,6 +350,15 @@ class CAFFE2_API DBReader {
   uint32_t num_shards_{};
   uint32_t shard_id_{};
 
+  // Readahead state, guarded by reader_mutex_ except for the thread itself.
+  size_t readahead_{0};
+  mutable std::thread readahead_thread_;
+  mutable std::deque<std::pair<string, string>> readahead_buffer_;
+  mutable std::condition_variable readahead_not_full_;
+  mutable std::condition_variable readahead_not_empty_;
+  mutable bool readahead_stop_{false};
+  mutable std::exception_ptr readahead_error_;
+
   C10_DISABLE_COPY_AND_ASSIGN(DBReader);
 };
 
@@ -12,8 +12,9 @@ NetDef optimize_inference_net(
     const NetDef& net,
     const std::set<string>& static_blobs) {
   if (net.type() != "" && net.type() != "simple") {
-    LOG(INFO) << "Cannot optimize memory for nets of type: " << net.type();
-    return net;
+    // Ops of other net types may run concurrently, the order of the net is
+    // not enough to tell whether two blobs are alive at the same time
+    return optimize_inference_net_for_dag(net, static_blobs);
   }
 
   std::vector<OperatorDef> ops;
@@ -123,6 +124,177 @@ NetDef optimize_inference_net(
   return optim_net;
 }
 
+NetDef optimize_inference_net_for_dag(
+    const NetDef& net,
+    const std::set<string>& static_blobs) {
+  const int num_ops = net.op_size();
+  for (const auto& op : net.op()) {
+    if (op.type() == "RecurrentNetwork") {
+      LOG(INFO) << "Memonger does not support RecurrentNetwork yet";
+      return net;
+    }
+    for (const auto& arg : op.arg()) {
+      if (arg.has_n() || arg.nets_size() > 0) {
+        // subnets access blobs by name, outside of the op's inputs and outputs
+        LOG(INFO) << "Memonger does not support ops with subnets yet: "
+                  << op.type();
+        return net;
+      }
+    }
+  }
+
+  // Step 1: build the dependencies the DAG executors use (read after write,
+  // write after write and write after read, see dag_utils), and for each op
+  // the set of ops that are guaranteed to have finished before it starts.
+  // Parents always come first in the net, so one pass in order is enough.
+  const int num_words = (num_ops + 63) / 64;
+  std::vector<std::vector<uint64_t>> ancestors(
+      num_ops, std::vector<uint64_t>(num_words, 0));
+  auto addAncestors = [&](int op_id, int parent) {
+    if (parent == op_id) {
+      return;
+    }
+    auto& anc = ancestors[op_id];
+    const auto& parent_anc = ancestors[parent];
+    for (int w = 0; w < num_words; ++w) {
+      anc[w] |= parent_anc[w];
+    }
+    anc[parent / 64] |= uint64_t(1) << (parent % 64);
+  };
+  auto happensBefore = [&](int a, int b) {
+    return ((ancestors[b][a / 64] >> (a % 64)) & 1) != 0;
+  };
+
+  std::unordered_set<string> all_blobs;
+  std::unordered_map<string, int> blob_creator;
+  std::unordered_map<string, std::vector<int>> blob_readers;
+  // every op reading or writing a blob, and the op that writes it first
+  std::unordered_map<string, std::vector<int>> blob_users;
+  std::unordered_map<string, int> first_writer;
+  for (int i = 0; i < num_ops; ++i) {
+    const auto& op = net.op(i);
+    auto checkInputs =
+        [&](const google::protobuf::RepeatedPtrField<std::string>& inputs) {
+          for (const auto& input : inputs) {
+            all_blobs.insert(input);
+            auto it = blob_creator.find(input);
+            if (it != blob_creator.end()) {
+              addAncestors(i, it->second);
+            }
+            blob_readers[input].push_back(i);
+            blob_users[input].push_back(i);
+          }
+        };
+    checkInputs(op.input());
+    checkInputs(op.control_input());
+    for (const auto& output : op.output()) {
+      all_blobs.insert(output);
+      auto it = blob_creator.find(output);
+      if (it != blob_creator.end()) {
+        addAncestors(i, it->second);
+      }
+      for (int reader : blob_readers[output]) {
+        addAncestors(i, reader);
+      }
+      blob_readers[output].clear();
+      blob_creator[output] = i;
+      blob_users[output].push_back(i);
+      first_writer.emplace(output, i);
+    }
+  }
+
+  // Only blobs created by the net can be recycled, external inputs are read
+  // before the net writes anything
+  std::unordered_set<string> fixed_blobs(
+      static_blobs.begin(), static_blobs.end());
+  fixed_blobs.insert(net.external_input().begin(), net.external_input().end());
+  fixed_blobs.insert(
+      net.external_output().begin(), net.external_output().end());
+  for (const auto& kv : blob_users) {
+    auto it = first_writer.find(kv.first);
+    if (it == first_writer.end() || kv.second.front() != it->second) {
+      fixed_blobs.insert(kv.first);
+    }
+  }
+
+  // Step 2: in net order, give each blob the first shared blob on the same
+  // device all of whose current users finish before the blob is first
+  // written, under any schedule of the DAG. Every later user of the blob
+  // depends on that first write, so the lifetimes can't overlap.
+  struct SharedBlob {
+    string name;
+    DeviceOption device;
+    std::vector<int> users;
+  };
+  std::vector<SharedBlob> shared_blobs;
+  std::unordered_map<string, string> renaming;
+  for (int i = 0; i < num_ops; ++i) {
+    const auto& op = net.op(i);
+    const auto& device =
+        op.has_device_option() ? op.device_option() : net.device_option();
+    for (const auto& output : op.output()) {
+      if (fixed_blobs.count(output) || renaming.count(output) ||
+          first_writer[output] != i) {
+        continue;
+      }
+      const auto& users = blob_users[output];
+      SharedBlob* target = nullptr;
+      for (auto& shared : shared_blobs) {
+        if (!IsSameDevice(shared.device, device)) {
+          continue;
+        }
+        bool finished = std::all_of(
+            shared.users.begin(), shared.users.end(), [&](int user) {
+              return happensBefore(user, i);
+            });
+        if (finished) {
+          target = &shared;
+          break;
+        }
+      }
+      if (!target) {
+        string name = "__m" + c10::to_string(shared_blobs.size()) + "_shared";
+        // Safety check to prevent double-memongering nets.
+        if (all_blobs.count(name)) {
+          LOG(INFO) << "Net was already memongered!";
+          return net;
+        }
+        shared_blobs.push_back(SharedBlob{name, device, {}});
+        target = &shared_blobs.back();
+      }
+      target->users = users;
+      renaming[output] = target->name;
+    }
+  }
+
+  // Step 3: rename inputs and outputs
+  NetDef optim_net = net;
+  for (auto& op : *optim_net.mutable_op()) {
+    for (int i = 0; i < op.input_size(); i++) {
+      auto it = renaming.find(op.input(i));
+      if (it != renaming.end()) {
+        op.set_input(i, it->second);
+      }
+    }
+    for (int i = 0; i < op.control_input_size(); i++) {
+      auto it = renaming.find(op.control_input(i));
+      if (it != renaming.end()) {
+        op.set_control_input(i, it->second);
+      }
+    }
+    for (int i = 0; i < op.output_size(); i++) {
+      auto it = renaming.find(op.output(i));
+      if (it != renaming.end()) {
+        op.set_output(i, it->second);
+      }
+    }
+  }
+
+  VLOG(1) << "optimized net using " << shared_blobs.size()
+          << " shared blobs for " << renaming.size() << " blobs";
+  return optim_net;
+}
+
 class ComputeBlobRecyclingForDag {
  public:
   explicit ComputeBlobRecyclingForDag(const int size)
@@ -14,6 +14,14 @@ CAFFE2_API NetDef optimize_inference_net(
     const NetDef& net,
     const std::set<string>& static_blobs);
 
+// Shares blobs between operator outputs whose lifetimes can't overlap under
+// any schedule of the net's DAG, so the result is valid for every net type,
+// including the concurrent executors. Blobs in `static_blobs` and the net's
+// external inputs and outputs are never shared.
+CAFFE2_API NetDef optimize_inference_net_for_dag(
+    const NetDef& net,
+    const std::set<string>& static_blobs);
+
 CAFFE2_API NetDef compute_blob_recycling_for_dag(
     const NetDef& net,
     const std::vector<string>& heads,
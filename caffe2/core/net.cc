@@ -1,7 +1,10 @@
 #include "caffe2/core/net.h"
 #include "caffe2/core/net_simple.h"
 
+#include <algorithm>
+#include <exception>
 #include <set>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -16,6 +19,11 @@ C10_DEFINE_string(
     caffe2_override_executor,
     "",
     "Comma-separated list of executor overrides");
+C10_DEFINE_int(
+    caffe2_net_construction_threads,
+    8,
+    "Number of threads constructing the operators of a net whose schema "
+    "allows ParallelConstruction(); 1 constructs them one after the other");
 
 namespace caffe2 {
 
@@ -148,6 +156,111 @@ void ClearGlobalNetObservers() {
   VLOG(1) << "All net observers cleared";
 }
 
+namespace {
+
+unique_ptr<OperatorBase> CreateNetOperator(
+    const std::shared_ptr<const NetDef>& net_def,
+    Workspace* ws,
+    int idx) {
+  const auto& operator_def = net_def->op(idx);
+  VLOG(1) << "Creating operator #" << idx << ": " << operator_def.name()
+          << ": " << operator_def.type();
+  if (!operator_def.has_device_option() && net_def->has_device_option()) {
+    // In the case that the operator def does not specify a device option but
+    // the net def has a default option, we copy the device option over to the
+    // operator def.
+    OperatorDef temp_def(operator_def);
+    temp_def.mutable_device_option()->CopyFrom(net_def->device_option());
+    return CreateOperator(temp_def, ws, idx);
+  }
+  auto op = CreateOperator(operator_def, ws, idx);
+  op->set_debug_def(
+      std::shared_ptr<const OperatorDef>{net_def, &(net_def->op(idx))});
+  return op;
+}
+
+} // namespace
+
+std::vector<std::unique_ptr<OperatorBase>> CreateNetOperators(
+    const std::shared_ptr<const NetDef>& net_def,
+    Workspace* ws) {
+  const int num_ops = net_def->op_size();
+  std::vector<std::unique_ptr<OperatorBase>> operators(num_ops);
+
+  std::vector<int> parallel_ops;
+  if (FLAGS_caffe2_net_construction_threads > 1) {
+    for (int idx = 0; idx < num_ops; ++idx) {
+      const auto* schema = OpSchemaRegistry::Schema(net_def->op(idx).type());
+      if (schema && schema->parallel_construction()) {
+        parallel_ops.push_back(idx);
+      }
+    }
+  }
+  const int num_threads = std::min<int>(
+      {FLAGS_caffe2_net_construction_threads,
+       static_cast<int>(parallel_ops.size()),
+       static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u))});
+  if (num_threads <= 1) {
+    for (int idx = 0; idx < num_ops; ++idx) {
+      operators[idx] = CreateNetOperator(net_def, ws, idx);
+    }
+    return operators;
+  }
+
+  // Construct the other operators in order, and create the output blobs of
+  // the parallel ones in their place. A parallel operator with a missing
+  // input is constructed in order too, to fail as it would have.
+  std::vector<char> is_parallel(num_ops, false);
+  for (int idx : parallel_ops) {
+    is_parallel[idx] = true;
+  }
+  parallel_ops.clear();
+  for (int idx = 0; idx < num_ops; ++idx) {
+    const auto& operator_def = net_def->op(idx);
+    if (is_parallel[idx] &&
+        std::all_of(
+            operator_def.input().begin(),
+            operator_def.input().end(),
+            [ws](const string& input) { return ws->HasBlob(input); })) {
+      for (const auto& output : operator_def.output()) {
+        ws->CreateBlob(output);
+      }
+      parallel_ops.push_back(idx);
+    } else {
+      operators[idx] = CreateNetOperator(net_def, ws, idx);
+    }
+  }
+
+  // The workspace is only read from now on
+  std::atomic<size_t> next{0};
+  std::vector<std::exception_ptr> errors(num_ops);
+  auto worker = [&]() {
+    for (size_t i = next++; i < parallel_ops.size(); i = next++) {
+      const int idx = parallel_ops[i];
+      try {
+        operators[idx] = CreateNetOperator(net_def, ws, idx);
+      } catch (...) {
+        errors[idx] = std::current_exception();
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // The error of the first failed operator, as when constructed in order
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  return operators;
+}
+
 unique_ptr<NetBase> CreateNet(const NetDef& net_def, Workspace* ws) {
   std::shared_ptr<NetDef> tmp_net_def(new NetDef(net_def));
   return CreateNet(tmp_net_def, ws);
@@ -22,6 +22,7 @@
 #include "caffe2/utils/simple_queue.h"
 
 C10_DECLARE_string(caffe2_override_executor);
+C10_DECLARE_int(caffe2_net_construction_threads);
 
 namespace caffe2 {
 
@@ -158,6 +159,20 @@ CAFFE2_API unique_ptr<NetBase> CreateNet(
     const std::shared_ptr<const NetDef>& net_def,
     Workspace* ws);
 
+/**
+ * @brief Creates the operators of a net, in the given workspace, giving the
+ * device option of the net to the operators that have none.
+ *
+ * The operators whose schema allows ParallelConstruction() are constructed on
+ * up to caffe2_net_construction_threads threads, the others one after the
+ * other in the order of the net. The blobs of the outputs of the operators
+ * are created first, in the order of the net, so that every operator finds
+ * the blobs that it would if the operators were created one after the other.
+ */
+CAFFE2_API std::vector<std::unique_ptr<OperatorBase>> CreateNetOperators(
+    const std::shared_ptr<const NetDef>& net_def,
+    Workspace* ws);
+
 CAFFE2_API void AddGlobalNetObserverCreator(NetObserverCreator creator);
 
 CAFFE2_API void ClearGlobalNetObservers();
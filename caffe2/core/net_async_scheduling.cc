@@ -1,13 +1,24 @@
 #include "caffe2/core/net_async_scheduling.h"
 
+#include <algorithm>
+
 #include "caffe2/core/net_async_tracing.h"
+#include "caffe2/core/operator.h"
 
 namespace caffe2 {
 
+namespace {
+// Task priorities are estimated during the first runs, once the shapes of
+// the intermediate blobs are known, and then refreshed periodically from the
+// profiled operator times if the net reports stats
+constexpr int kPriorityWarmupRuns = 3;
+constexpr int kPriorityUpdateRuns = 100;
+} // namespace
+
 AsyncSchedulingNet::AsyncSchedulingNet(
     const std::shared_ptr<const NetDef>& net_def,
     Workspace* ws)
-    : AsyncNetBase(net_def, ws), running_(false) {}
+    : AsyncNetBase(net_def, ws), running_(false), num_runs_(0) {}
 
 void AsyncSchedulingNet::reset() {
   AsyncNetBase::reset();
@@ -186,7 +197,91 @@ void AsyncSchedulingNet::schedule(int task_id, bool run_inline) noexcept {
     schedule_func();
   } else {
     const auto& device_option = event(task_id).GetDeviceOption();
-    pool(device_option)->run(schedule_func);
+    if (options_.use_critical_path_scheduling_) {
+      runByPriority(pool(device_option), task_id, std::move(schedule_func));
+    } else {
+      pool(device_option)->run(schedule_func);
+    }
+  }
+}
+
+void AsyncSchedulingNet::runByPriority(
+    TaskThreadPoolBase* pool,
+    int task_id,
+    std::function<void()> func) {
+  ReadyQueue* queue = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(ready_queues_mutex_);
+    auto& queue_ptr = ready_queues_[pool];
+    if (!queue_ptr) {
+      queue_ptr = caffe2::make_unique<ReadyQueue>();
+    }
+    queue = queue_ptr.get();
+  }
+  {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->tasks.push_back(
+        ReadyTask{task_priorities_[task_id], task_id, std::move(func)});
+    std::push_heap(queue->tasks.begin(), queue->tasks.end());
+  }
+  // the job doesn't necessarily run this task, but the best one ready by the
+  // time a worker picks it up
+  pool->run([queue]() {
+    std::function<void()> top_func;
+    {
+      std::lock_guard<std::mutex> lock(queue->mutex);
+      // every push is followed by exactly one job
+      DCHECK(!queue->tasks.empty());
+      std::pop_heap(queue->tasks.begin(), queue->tasks.end());
+      top_func = std::move(queue->tasks.back().func);
+      queue->tasks.pop_back();
+    }
+    top_func();
+  });
+}
+
+float AsyncSchedulingNet::estimateOpCost(int op_id) const {
+  const auto* op = operators_[op_id];
+  const auto& def = op->debug_def();
+  const auto* schema = OpSchemaRegistry::Schema(def.type());
+  if (schema && schema->HasCostInferenceFunction()) {
+    std::vector<TensorShape> shapes;
+    shapes.reserve(op->InputSize());
+    for (const auto* blob : op->Inputs()) {
+      shapes.push_back(GetTensorShapeOfBlob(blob));
+    }
+    try {
+      auto flops = schema->InferCost(def, shapes).flops;
+      if (flops > 0) {
+        return flops;
+      }
+    } catch (const std::exception&) {
+      // shapes are not known yet, fall back to the unit cost
+    }
+  }
+  return 1.0;
+}
+
+void AsyncSchedulingNet::updateTaskPriorities() {
+  // Profiled times are used when available, FLOPs estimated from the blob
+  // shapes otherwise, with a unit cost for operators without an estimate
+  std::vector<float> op_times;
+  if (options_.report_stats_) {
+    op_times = counters_.GetReport().GetPerOperatorMeanTime();
+  }
+  task_priorities_.assign(tasksNum(), 0.0);
+  // Children are chains starting after the end of their parents, and chains
+  // are ordered by their first operator, so a child's id is always larger
+  for (auto task_id = tasksNum() - 1; task_id >= 0; --task_id) {
+    float cost = 0.0;
+    for (auto op_id : chains_[task_id]) {
+      cost += op_times.empty() ? estimateOpCost(op_id) : op_times[op_id];
+    }
+    float path_cost = 0.0;
+    for (auto child_id : children(task_id)) {
+      path_cost = std::max(path_cost, task_priorities_[child_id]);
+    }
+    task_priorities_[task_id] = cost + path_cost;
   }
 }
 
@@ -246,6 +341,13 @@ bool AsyncSchedulingNet::RunAsync() {
     running_ = true;
     reset();
 
+    if (options_.use_critical_path_scheduling_ &&
+        (num_runs_ < kPriorityWarmupRuns ||
+         (options_.report_stats_ && num_runs_ % kPriorityUpdateRuns == 0))) {
+      updateTaskPriorities();
+    }
+    ++num_runs_;
+
     StartAllObservers();
     tracing::startIter(tracer_);
     if (options_.report_stats_) {
@@ -263,11 +365,22 @@ bool AsyncSchedulingNet::RunAsync() {
 
   // schedule() is not expected to throw, at this moment all the initial tasks
   // will be scheduled and the full graph of tasks will be executed
+  std::vector<int> root_tasks;
   for (auto task_id = 0; task_id < tasksNum(); ++task_id) {
     if (parents(task_id).empty()) {
-      schedule(task_id, options_.run_root_tasks_inline_);
+      root_tasks.push_back(task_id);
     }
   }
+  if (options_.use_critical_path_scheduling_) {
+    // the first jobs posted may start before the other roots are queued
+    std::stable_sort(
+        root_tasks.begin(), root_tasks.end(), [this](int a, int b) {
+          return task_priorities_[a] > task_priorities_[b];
+        });
+  }
+  for (auto task_id : root_tasks) {
+    schedule(task_id, options_.run_root_tasks_inline_);
+  }
 
   if (tasksNum() == 0) {
     finishRun();
@@ -30,6 +30,37 @@ class CAFFE2_API AsyncSchedulingNet : public AsyncNetBase {
 
   std::atomic<int> processed_tasks_num_;
 
+  // Critical path scheduling: ready tasks wait in a queue per pool ordered by
+  // the estimated cost of the longest path from the task to the end of the
+  // net, and every job posted to a pool runs the top task of its queue
+  struct ReadyTask {
+    float priority;
+    int task_id;
+    std::function<void()> func;
+    bool operator<(const ReadyTask& other) const {
+      // ties go to the task that comes first in the net
+      return priority < other.priority ||
+          (priority == other.priority && task_id > other.task_id);
+    }
+  };
+  struct ReadyQueue {
+    std::mutex mutex;
+    // max heap
+    std::vector<ReadyTask> tasks;
+  };
+  void runByPriority(
+      TaskThreadPoolBase* pool,
+      int task_id,
+      std::function<void()> func);
+  void updateTaskPriorities();
+  float estimateOpCost(int op_id) const;
+
+  std::mutex ready_queues_mutex_;
+  std::unordered_map<TaskThreadPoolBase*, std::unique_ptr<ReadyQueue>>
+      ready_queues_;
+  std::vector<float> task_priorities_;
+  int num_runs_;
+
   C10_DISABLE_COPY_AND_ASSIGN(AsyncSchedulingNet);
 };
 
@@ -375,22 +375,11 @@ std::vector<OperatorNode> prepareOperatorNodes(
   std::vector<OperatorNode> operator_nodes(net_def->op_size());
   std::map<string, int> blob_creator;
   std::map<string, std::set<int>> blob_readers;
-  bool net_def_has_device_option = net_def->has_device_option();
   // Initialize the operators
+  auto operators = CreateNetOperators(net_def, ws);
   for (int idx = 0; idx < net_def->op_size(); ++idx) {
     const OperatorDef& op_def = net_def->op(idx);
-    VLOG(1) << "Creating operator #" << idx << ": " << op_def.name() << ": "
-            << op_def.type();
-    if (!op_def.has_device_option() && net_def_has_device_option) {
-      OperatorDef temp_def(op_def);
-      temp_def.mutable_device_option()->CopyFrom(net_def->device_option());
-      operator_nodes[idx].operator_ = CreateOperator(temp_def, ws, idx);
-    } else {
-      auto op = CreateOperator(op_def, ws, idx);
-      op->set_debug_def(
-          std::shared_ptr<const OperatorDef>{net_def, &(net_def->op(idx))});
-      operator_nodes[idx].operator_ = std::move(op);
-    }
+    operator_nodes[idx].operator_ = std::move(operators[idx]);
     // Check the inputs, and set up parents if necessary. This addressese the
     // read after write case.
     auto checkInputs =
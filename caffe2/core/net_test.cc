@@ -1101,4 +1101,92 @@ TEST(NetTest, ProfDAGNetErrorTest) {
   testProfDAGNetErrorCase(/*test_error=*/true);
 }
 
+namespace {
+
+// Checks in its constructor that its input blobs exist, as operators
+// constructed in parallel expect, and optionally throws.
+class ParallelConstructionTestOp final : public OperatorBase {
+ public:
+  ParallelConstructionTestOp(const OperatorDef& operator_def, Workspace* ws)
+      : OperatorBase(operator_def, ws) {
+    CAFFE_ENFORCE(
+        !GetSingleArgument<bool>("throw", false),
+        "ParallelConstructionTestOp ",
+        operator_def.output(0));
+    for (const auto& input : operator_def.input()) {
+      CAFFE_ENFORCE(ws->HasBlob(input));
+    }
+  }
+
+  bool Run(int /* unused */ /*stream_id*/) override {
+    counter.fetch_add(1);
+    return true;
+  }
+};
+
+REGISTER_CPU_OPERATOR(ParallelConstructionTest, ParallelConstructionTestOp);
+OPERATOR_SCHEMA(ParallelConstructionTest)
+    .NumInputs(0, INT_MAX)
+    .NumOutputs(1, INT_MAX)
+    .ParallelConstruction();
+
+// A chain of ParallelConstructionTest ops, with a NetTestDummy every 10 ops,
+// one of which throws with throw_at >= 0.
+NetDef ParallelConstructionNet(const std::string& type, int throw_at) {
+  NetDef net_def;
+  net_def.set_name("parallel_construction_" + type);
+  net_def.set_type(type);
+  net_def.add_external_input("in");
+  std::string previous = "in";
+  for (int i = 0; i < 100; ++i) {
+    auto& op = *net_def.add_op();
+    op.set_type(i % 10 ? "ParallelConstructionTest" : "NetTestDummy");
+    op.add_input(previous);
+    previous = c10::str("blob_", i);
+    op.add_output(previous);
+    if (i == throw_at || i == throw_at + 21) {
+      auto& arg = *op.add_arg();
+      arg.set_name("throw");
+      arg.set_i(1);
+    }
+  }
+  return net_def;
+}
+
+} // namespace
+
+TEST(NetTest, ParallelConstruction) {
+  auto old = FLAGS_caffe2_net_construction_threads;
+  auto g = MakeGuard([&]() { FLAGS_caffe2_net_construction_threads = old; });
+  for (int threads : {1, 4}) {
+    FLAGS_caffe2_net_construction_threads = threads;
+    for (const std::string type : {"simple", "dag", "async_scheduling"}) {
+      Workspace ws;
+      ws.CreateBlob("in");
+      auto net_def = ParallelConstructionNet(type, -1);
+      std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+      ASSERT_TRUE(net != nullptr);
+      const auto operators = net->GetOperators();
+      ASSERT_EQ(operators.size(), 100);
+      for (int i = 0; i < 100; ++i) {
+        ASSERT_EQ(operators[i]->net_position(), i);
+        ASSERT_EQ(operators[i]->debug_def().output(0), c10::str("blob_", i));
+      }
+      counter.exchange(0);
+      ASSERT_TRUE(net->Run());
+      ASSERT_EQ(counter.load(), 100);
+
+      // The error of the first op that throws, as when constructed in order
+      Workspace failing_ws;
+      failing_ws.CreateBlob("in");
+      try {
+        CreateNet(ParallelConstructionNet(type, 33), &failing_ws);
+        FAIL() << "expected the creation of the net to throw";
+      } catch (const EnforceNotMet& e) {
+        ASSERT_NE(std::string(e.what()).find("blob_33"), std::string::npos);
+      }
+    }
+  }
+}
+
 } // namespace caffe2
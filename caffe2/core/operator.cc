@@ -1,6 +1,10 @@
 #include "caffe2/core/operator.h"
 
 #include <algorithm>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <sstream>
 
 #include "caffe2/core/init.h"
 #include "caffe2/core/logging.h"
@@ -8,6 +12,7 @@
 #include "caffe2/core/operator_gradient.h"
 #include "caffe2/core/tensor.h"
 #include "caffe2/core/tensor_int8.h"
+#include "caffe2/core/timer.h"
 #include "caffe2/core/types.h"
 #include "caffe2/core/workspace.h"
 
@@ -31,6 +36,17 @@ C10_DEFINE_bool(
     false,
     "If set, throws if floating point exceptions (FE_DIVBYZERO, FE_INVALID, "
     "FE_OVERFLOW) are detected when running any operator.");
+C10_DEFINE_bool(
+    caffe2_operator_autotune_engines,
+    false,
+    "If set, operators that do not specify an engine are created with the "
+    "engine that was the fastest for the same arguments and input shapes in "
+    "AutotuneOperatorEngines, if any.");
+C10_DEFINE_string(
+    caffe2_operator_engine_cache,
+    "",
+    "If set, the file the autotuned operator engines are loaded from on "
+    "first use, and saved to after each AutotuneOperatorEngines.");
 
 namespace caffe2 {
 
@@ -149,6 +165,81 @@ unique_ptr<OperatorBase> TryCreateOperator(
   }
 }
 
+// Fastest engine for each (device, op type, arguments, input shapes) key, as
+// measured by AutotuneOperatorEngines.
+struct EngineCache {
+  std::mutex mutex;
+  CaffeMap<string, string> engines;
+  bool loaded = false;
+};
+
+EngineCache& g_engine_cache() {
+  static auto* g_engine_cache_ = new EngineCache();
+  return *g_engine_cache_;
+}
+
+// Needs the cache mutex.
+void MaybeLoadEngineCacheFromFlag(EngineCache* cache) {
+  if (cache->loaded) {
+    return;
+  }
+  cache->loaded = true;
+  if (FLAGS_caffe2_operator_engine_cache.empty()) {
+    return;
+  }
+  std::ifstream file(FLAGS_caffe2_operator_engine_cache);
+  string key, engine;
+  while (file >> key >> engine) {
+    cache->engines[key] = engine;
+  }
+}
+
+// FNV-1a, so that the keys stay the same across builds and hosts.
+uint64_t Fingerprint(const string& str) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (const char c : str) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+// Returns the cache key of the op with the current shapes of its inputs, or
+// an empty string if one of the inputs does not exist yet.
+string EngineCacheKey(const OperatorDef& operator_def, Workspace* ws) {
+  string args;
+  for (const auto& arg : operator_def.arg()) {
+    args += arg.SerializeAsString();
+  }
+  std::stringstream key;
+  key << operator_def.device_option().device_type() << "/"
+      << operator_def.type() << "/" << std::hex << Fingerprint(args)
+      << std::dec;
+  for (const auto& input : operator_def.input()) {
+    const Blob* blob = ws->GetBlob(input);
+    if (!blob) {
+      return "";
+    }
+    const TensorShape shape = GetTensorShapeOfBlob(blob);
+    key << "/" << shape.data_type() << ":";
+    for (int i = 0; i < shape.dims_size(); ++i) {
+      key << (i ? "x" : "") << shape.dims(i);
+    }
+  }
+  return key.str();
+}
+
+string LookupAutotunedEngine(const OperatorDef& operator_def, Workspace* ws) {
+  const string key = EngineCacheKey(operator_def, ws);
+  if (key.empty()) {
+    return "";
+  }
+  auto& cache = g_engine_cache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  MaybeLoadEngineCacheFromFlag(&cache);
+  auto it = cache.engines.find(key);
+  return it == cache.engines.end() ? "" : it->second;
+}
+
 unique_ptr<OperatorBase> _CreateOperator(
     const OperatorDef& operator_def,
     Workspace* ws) {
@@ -175,11 +266,18 @@ unique_ptr<OperatorBase> _CreateOperator(
   }
 #endif
 
-  // second try engines specified in the operator_def and preferred engines
+  // second try engines specified in the operator_def, the autotuned engine
+  // and preferred engines
   std::vector<std::string> engines{};
   if (operator_def.engine().size()) {
     const auto op_def_engines = split(',', operator_def.engine());
     engines.insert(engines.end(), op_def_engines.begin(), op_def_engines.end());
+  } else if (FLAGS_caffe2_operator_autotune_engines) {
+    const auto autotuned_engine = LookupAutotunedEngine(operator_def, ws);
+    if (autotuned_engine.size()) {
+      VLOG(2) << "Inserting autotuned engine: " << autotuned_engine;
+      engines.push_back(autotuned_engine);
+    }
   }
   if (!FLAGS_caffe2_disable_implicit_engine_preference &&
       g_per_op_engine_pref().count(device_type) &&
@@ -342,6 +440,136 @@ unique_ptr<OperatorBase> CreateOperator(
   }
 }
 
+std::vector<std::string> GetRegisteredEngines(
+    const std::string& op_type,
+    DeviceType device_type) {
+  std::vector<std::string> engines;
+  if (!gDeviceTypeRegistry()->count(device_type)) {
+    return engines;
+  }
+  auto* registry = gDeviceTypeRegistry()->at(device_type);
+  if (registry->Has(op_type)) {
+    engines.push_back("DEFAULT");
+  }
+  // See OpRegistryKey
+  const std::string engine_prefix = op_type + "_ENGINE_";
+  for (const auto& key : registry->Keys()) {
+    if (key.compare(0, engine_prefix.size(), engine_prefix) == 0) {
+      engines.push_back(key.substr(engine_prefix.size()));
+    }
+  }
+  return engines;
+}
+
+int AutotuneOperatorEngines(NetDef* net_def, Workspace* ws, int iterations) {
+  CAFFE_ENFORCE_GT(iterations, 0);
+  // Run the net once so that all the blobs the ops read have their shapes.
+  NetDef warmup_net(*net_def);
+  warmup_net.set_name(net_def->name() + "_autotune_warmup");
+  CAFFE_ENFORCE(ws->RunNetOnce(warmup_net), "Autotuning warm-up run failed");
+
+  int num_tuned = 0;
+  for (auto& op_def : *net_def->mutable_op()) {
+    if (op_def.engine().size()) {
+      continue;
+    }
+    // Running an op that updates one of its inputs again would change the
+    // data the next candidates run on.
+    bool in_place = false;
+    for (const auto& output : op_def.output()) {
+      for (const auto& input : op_def.input()) {
+        in_place |= input == output;
+      }
+    }
+    const auto device_type =
+        ProtoToType(static_cast<DeviceTypeProto>(
+            op_def.device_option().device_type()));
+    const auto engines = GetRegisteredEngines(op_def.type(), device_type);
+    if (in_place || engines.size() < 2) {
+      continue;
+    }
+
+    std::string best_engine;
+    double best_time = std::numeric_limits<double>::max();
+    for (const auto& engine : engines) {
+      OperatorDef candidate_def(op_def);
+      candidate_def.set_engine(engine);
+      try {
+        auto op = TryCreateOperator(
+            OpRegistryKey(op_def.type(), engine), candidate_def, ws);
+        // The first run allocates the outputs and any per-engine state. Run()
+        // waits for the device, so the timings include the kernels.
+        if (!op || !op->Run()) {
+          continue;
+        }
+        Timer timer;
+        bool success = true;
+        for (int i = 0; i < iterations && success; ++i) {
+          success = op->Run();
+        }
+        const double time = timer.MilliSeconds() / iterations;
+        VLOG(1) << "Engine " << engine << " of " << op_def.type() << " took "
+                << time << " ms";
+        if (success && time < best_time) {
+          best_time = time;
+          best_engine = engine;
+        }
+      } catch (const std::exception& e) {
+        VLOG(1) << "Engine " << engine << " of " << op_def.type()
+                << " failed: " << e.what();
+      }
+    }
+    if (best_engine.empty()) {
+      continue;
+    }
+
+    const string key = EngineCacheKey(op_def, ws);
+    {
+      auto& cache = g_engine_cache();
+      std::lock_guard<std::mutex> lock(cache.mutex);
+      MaybeLoadEngineCacheFromFlag(&cache);
+      cache.engines[key] = best_engine;
+    }
+    op_def.set_engine(best_engine);
+    ++num_tuned;
+  }
+  if (!FLAGS_caffe2_operator_engine_cache.empty()) {
+    SaveOperatorEngineCache(FLAGS_caffe2_operator_engine_cache);
+  }
+  return num_tuned;
+}
+
+void LoadOperatorEngineCache(const std::string& filename) {
+  std::ifstream file(filename);
+  CAFFE_ENFORCE(file.good(), "Cannot open engine cache ", filename);
+  auto& cache = g_engine_cache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  cache.loaded = true;
+  string key, engine;
+  while (file >> key >> engine) {
+    cache.engines[key] = engine;
+  }
+}
+
+void SaveOperatorEngineCache(const std::string& filename) {
+  auto& cache = g_engine_cache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  // Before truncating the file, which may be the one we load from.
+  MaybeLoadEngineCacheFromFlag(&cache);
+  std::ofstream file(filename);
+  CAFFE_ENFORCE(file.good(), "Cannot open engine cache ", filename);
+  for (const auto& entry : cache.engines) {
+    file << entry.first << " " << entry.second << "\n";
+  }
+}
+
+void ClearOperatorEngineCache() {
+  auto& cache = g_engine_cache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  cache.engines.clear();
+  cache.loaded = true;
+}
+
 std::map<DeviceType, OperatorRegistry*>* gDeviceTypeRegistry() {
   static std::map<DeviceType, OperatorRegistry*> g_device_type_registry;
   return &g_device_type_registry;
@@ -29,6 +29,8 @@
 #include <ATen/core/ivalue.h>
 
 C10_DECLARE_bool(caffe2_operator_throw_if_fp_exceptions);
+C10_DECLARE_bool(caffe2_operator_autotune_engines);
+C10_DECLARE_string(caffe2_operator_engine_cache);
 
 namespace c10 {
 struct FunctionSchema;
@@ -1342,6 +1344,31 @@ CAFFE2_API void SetOpEnginePref(
     const std::string& op_type,
     const CaffeMap<DeviceType, EnginePrefType>& op_pref);
 
+// Returns the engines op_type is registered with on the device, "DEFAULT"
+// standing for the implementation registered without an engine.
+CAFFE2_API std::vector<std::string> GetRegisteredEngines(
+    const std::string& op_type,
+    DeviceType device_type);
+
+// Engine autotuning: for each op of net_def that does not set an engine and
+// has more than one registered, benchmarks all of them with the shapes its
+// inputs have in ws and sets the fastest as the engine of the op. The net is
+// run once first so that every intermediate blob has its shape, and ops that
+// update an input in place are skipped. Create the net again from net_def to
+// use the new engines. Returns the number of ops whose engine was set.
+//
+// The winners are also kept in a process-wide cache keyed by device, op type,
+// arguments and input shapes. With --caffe2_operator_autotune_engines,
+// CreateOperator uses the cached engine of ops that do not set one, and with
+// --caffe2_operator_engine_cache the cache persists across processes.
+CAFFE2_API int AutotuneOperatorEngines(
+    NetDef* net_def,
+    Workspace* ws,
+    int iterations = 10);
+CAFFE2_API void LoadOperatorEngineCache(const std::string& filename);
+CAFFE2_API void SaveOperatorEngineCache(const std::string& filename);
+CAFFE2_API void ClearOperatorEngineCache();
+
 CAFFE2_API void
 LoadInt8TensorInfoOfBlob(float* scale, float* offset, const Blob* b);
 
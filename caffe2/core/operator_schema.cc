@@ -189,6 +189,11 @@ OpSchema& OpSchema::InputsCanCrossDevices() {
   return *this;
 }
 
+OpSchema& OpSchema::ParallelConstruction() {
+  parallel_construction_ = true;
+  return *this;
+}
+
 OpSchema& OpSchema::TensorInferenceFunction(
     TensorInferenceFunctionType function) {
   tensor_inference_function_ = function;
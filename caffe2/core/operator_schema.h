@@ -294,6 +294,11 @@ class CAFFE2_API OpSchema {
   // This op can pass data across devices
   OpSchema& InputsCanCrossDevices();
 
+  // The constructors of all the implementations of this op are thread-safe,
+  // and only look up their inputs and outputs in the workspace, so nets may
+  // construct them in parallel (see caffe2_net_construction_threads).
+  OpSchema& ParallelConstruction();
+
   /**
    * @brief A function to allow one to get the number of outputs based on the
    * number of inputs, if this schema supports it.
@@ -358,6 +363,9 @@ class CAFFE2_API OpSchema {
   bool inputs_can_cross_devices() const {
     return inputs_can_cross_devices_;
   }
+  bool parallel_construction() const {
+    return parallel_construction_;
+  }
 
   /**
    * @brief Returns the required device location of inputs and outputs.
@@ -430,6 +438,7 @@ class CAFFE2_API OpSchema {
   int max_output_ = std::numeric_limits<int>::max();
   bool private_ = false;
   bool inputs_can_cross_devices_ = false;
+  bool parallel_construction_ = false;
   std::function<bool(int)> num_inputs_allowed_ = [](int) { return true; };
   std::function<bool(int)> num_outputs_allowed_ = [](int) { return true; };
   std::function<bool(int, int)> num_inputs_outputs_allowed_ = [](int, int) {
@@ -1,4 +1,8 @@
+#include <chrono>
+#include <cstdio>
 #include <iostream>
+#include <set>
+#include <thread>
 
 #include "caffe2/core/net.h"
 #include "caffe2/core/operator.h"
@@ -69,6 +73,32 @@ REGISTER_CPU_OPERATOR_WITH_ENGINE(JustTest, BAZ, JustTestAndDoesConstruct);
 REGISTER_CUDA_OPERATOR(JustTest, JustTest);
 REGISTER_CPU_OPERATOR(JustTestWithSomeOutput, JustTestWithSomeOutput);
 
+template <int kSleepMicroseconds>
+class JustTestSleeping : public JustTest {
+ public:
+  using JustTest::JustTest;
+  bool Run(int /* unused */ /*stream_id*/) override {
+    std::this_thread::sleep_for(
+        std::chrono::microseconds(kSleepMicroseconds));
+    return true;
+  }
+  string type() override {
+    return "SLEEPING_" + c10::to_string(kSleepMicroseconds);
+  }
+};
+
+OPERATOR_SCHEMA(JustTestAutotune).NumInputs(0, 1).NumOutputs(0, 1);
+REGISTER_CPU_OPERATOR(JustTestAutotune, JustTestSleeping<2000>);
+REGISTER_CPU_OPERATOR_WITH_ENGINE(
+    JustTestAutotune,
+    SLOW,
+    JustTestSleeping<5000>);
+REGISTER_CPU_OPERATOR_WITH_ENGINE(JustTestAutotune, FAST, JustTestSleeping<0>);
+REGISTER_CPU_OPERATOR_WITH_ENGINE(
+    JustTestAutotune,
+    FOO,
+    JustTestAndNeverConstructs);
+
 TEST(OperatorTest, DeviceTypeRegistryWorks) {
   EXPECT_EQ(gDeviceTypeRegistry()->count(CPU), 1);
 }
@@ -595,4 +625,48 @@ TEST(IsTestArg, non_standard) {
       "JustTestWithNonStandardIsTestArg");
 }
 
+TEST(EngineAutotuneTest, PicksFastestEngine) {
+  const auto engines = GetRegisteredEngines("JustTestAutotune", CPU);
+  EXPECT_EQ(
+      std::set<string>(engines.begin(), engines.end()),
+      std::set<string>({"DEFAULT", "SLOW", "FAST", "FOO"}));
+
+  Workspace ws;
+  NetDef net_def;
+  net_def.set_name("autotune");
+  net_def.add_op()->set_type("JustTestAutotune");
+  auto* explicit_op = net_def.add_op();
+  explicit_op->set_type("JustTestAutotune");
+  explicit_op->set_engine("SLOW");
+  EXPECT_EQ(AutotuneOperatorEngines(&net_def, &ws, 3), 1);
+  EXPECT_EQ(net_def.op(0).engine(), "FAST");
+  EXPECT_EQ(net_def.op(1).engine(), "SLOW");
+
+  OperatorDef op_def;
+  op_def.set_type("JustTestAutotune");
+  EXPECT_EQ(
+      static_cast<JustTest*>(CreateOperator(op_def, &ws).get())->type(),
+      "SLEEPING_2000");
+  FLAGS_caffe2_operator_autotune_engines = true;
+  EXPECT_EQ(
+      static_cast<JustTest*>(CreateOperator(op_def, &ws).get())->type(),
+      "SLEEPING_0");
+
+  // The cache survives a save and a load.
+  const string filename = std::tmpnam(nullptr);
+  SaveOperatorEngineCache(filename);
+  ClearOperatorEngineCache();
+  EXPECT_EQ(
+      static_cast<JustTest*>(CreateOperator(op_def, &ws).get())->type(),
+      "SLEEPING_2000");
+  LoadOperatorEngineCache(filename);
+  EXPECT_EQ(
+      static_cast<JustTest*>(CreateOperator(op_def, &ws).get())->type(),
+      "SLEEPING_0");
+  std::remove(filename.c_str());
+
+  FLAGS_caffe2_operator_autotune_engines = false;
+  ClearOperatorEngineCache();
+}
+
 }  // namespace caffe2
@@ -310,4 +310,82 @@ TEST(SimpleNetTest, TestSimpleNetTimingControlDependency) {
   EXPECT_NEAR(ms, 350, kTimeThreshold);
 }
 
+// This network has two short independent operators listed before a chain of
+// three operators. Running the ready tasks in the order they are listed keeps
+// both workers on the short operators first, and the chain finishes at 200ms;
+// running the chain first, since it has the longest path to the end of the
+// net, overlaps the short operators with it and finishes at 150ms.
+const char kSleepNetDefStringCriticalPath[] = R"DOC(
+  name: "sleepnet"
+  type: "async_scheduling"
+  num_workers: 2
+  op {
+    output: "short1"
+    name: "short1"
+    type: "Sleep"
+    arg {
+      name: "ms"
+      i: 50
+    }
+  }
+  op {
+    output: "short2"
+    name: "short2"
+    type: "Sleep"
+    arg {
+      name: "ms"
+      i: 50
+    }
+  }
+  op {
+    output: "long1"
+    name: "long1"
+    type: "Sleep"
+    arg {
+      name: "ms"
+      i: 50
+    }
+  }
+  op {
+    input: "long1"
+    output: "long2"
+    name: "long2"
+    type: "Sleep"
+    arg {
+      name: "ms"
+      i: 50
+    }
+  }
+  op {
+    input: "long2"
+    output: "long3"
+    name: "long3"
+    type: "Sleep"
+    arg {
+      name: "ms"
+      i: 50
+    }
+  }
+)DOC";
+
+const char kCriticalPathSchedulingArg[] = R"DOC(
+  arg {
+    name: "critical_path_scheduling"
+    i: 1
+  }
+)DOC";
+
+TEST(AsyncSchedulingNetTest, TestTimingReadyOrder) {
+  int ms = RunNetAndGetDuration(
+      string(kSleepNetDefStringCriticalPath), "async_scheduling");
+  EXPECT_NEAR(ms, 200, kTimeThreshold);
+}
+
+TEST(AsyncSchedulingNetTest, TestTimingCriticalPath) {
+  int ms = RunNetAndGetDuration(
+      string(kSleepNetDefStringCriticalPath) + kCriticalPathSchedulingArg,
+      "async_scheduling");
+  EXPECT_NEAR(ms, 150, kTimeThreshold);
+}
+
 }  // namespace caffe2
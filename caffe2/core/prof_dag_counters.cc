@@ -125,6 +125,18 @@ bool ProfDAGReport::hasStats() const {
   return runtime_stats_.cnt() > 0;
 }
 
+std::vector<float> ProfDAGReport::GetPerOperatorMeanTime() const {
+  std::vector<float> mean_times;
+  if (!hasStats()) {
+    return mean_times;
+  }
+  mean_times.reserve(time_per_op_total_.size());
+  for (const auto& stats : time_per_op_total_) {
+    mean_times.push_back(stats.cnt() > 0 ? stats.sum() / stats.cnt() : 0.0);
+  }
+  return mean_times;
+}
+
 ProfDAGProto ProfDAGReport::statsProto(
     const std::string& name,
     const ProfDAGStats& stats,
@@ -59,6 +59,10 @@ class ProfDAGReport {
   // formatted as a map: (netName__opIndex__opType, cost)
   ProfDAGProtos GetPerOperatorCost() const;
 
+  // Mean execution time in milliseconds of each operator of the net, empty
+  // if no run has been profiled yet
+  std::vector<float> GetPerOperatorMeanTime() const;
+
   ProfDAGReport& operator+=(const ProfDAGReport& rhs);
 
   void PrintStats();
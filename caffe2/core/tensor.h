@@ -163,7 +163,7 @@ class CAFFE2_API Tensor final {
     // set_storage already sets data_type_ of TensorImpl
     x.impl_->set_storage(storage());
     x.impl_->set_storage_offset(impl_->storage_offset());
-    x.impl_->set_sizes_and_strides(sizes(), strides());
+    x.impl_->set_sizes_and_strides_like(*impl_);
     return x;
   }
 
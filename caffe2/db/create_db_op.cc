@@ -3,7 +3,13 @@
 namespace caffe2 {
 REGISTER_CPU_OPERATOR(CreateDB, CreateDBOp<CPUContext>);
 
-OPERATOR_SCHEMA(CreateDB).NumInputs(0).NumOutputs(1);
+OPERATOR_SCHEMA(CreateDB)
+    .NumInputs(0)
+    .NumOutputs(1)
+    .Arg(
+        "readahead",
+        "(int, default 0) If positive, the reader reads this many records "
+        "ahead of its consumers on a background thread.");
 
 NO_GRADIENT(CreateDB);
 }  // namespace caffe2
@@ -196,5 +196,47 @@ TEST(DBReaderShardedTest, Reader) {
   EXPECT_EQ(value, "05");
 }
 
+TEST(DBReaderReadaheadTest, Reader) {
+  std::string name = std::tmpnam(nullptr);
+  CreateAndFill("minidb", name);
+  std::unique_ptr<DBReader> reader(new DBReader("minidb", name));
+  reader->EnableReadahead(3);
+  EXPECT_EQ(reader->readahead(), 3);
+  string key;
+  string value;
+  // Reads wrap around the end of the db just like the synchronous reader.
+  for (int i = 0; i < 2 * kMaxItems + 1; ++i) {
+    std::stringstream ss;
+    ss << std::setw(2) << std::setfill('0') << (i % kMaxItems);
+    reader->Read(&key, &value);
+    EXPECT_EQ(key, ss.str());
+    EXPECT_EQ(value, ss.str());
+  }
+  reader->SeekToFirst();
+  reader->Read(&key, &value);
+  EXPECT_EQ(key, "00");
+  reader->EnableReadahead(0);
+  EXPECT_EQ(reader->readahead(), 0);
+
+  // Concurrent readers still see every record exactly once.
+  CreateAndFill("minidb", name + "1");
+  std::unique_ptr<DBReader> sharded(new DBReader("minidb", name + "1", 2, 1));
+  sharded->EnableReadahead(2);
+  vector<unique_ptr<std::thread>> threads(kMaxItems / 2);
+  vector<string> keys(kMaxItems / 2);
+  vector<string> values(kMaxItems / 2);
+  for (int i = 0; i < kMaxItems / 2; ++i) {
+    threads[i].reset(new std::thread(
+        [&sharded](string* key, string* value) { sharded->Read(key, value); },
+        &keys[i],
+        &values[i]));
+  }
+  for (int i = 0; i < kMaxItems / 2; ++i) {
+    threads[i]->join();
+  }
+  std::set<string> keys_set(keys.begin(), keys.end());
+  EXPECT_EQ(keys_set, std::set<string>({"01", "03", "05", "07", "09"}));
+}
+
 }  // namespace db
 }  // namespace caffe2
@@ -26,9 +26,13 @@ OPERATOR_SCHEMA(ImageInput)
           int batch_size = helper.GetSingleArgument<int>("batch_size", 0);
           int crop = helper.GetSingleArgument<int>("crop", -1);
           int color = helper.GetSingleArgument<int>("color", 1);
+          const StorageOrder order = StringToStorageOrder(
+              helper.GetSingleArgument<string>("order", "NHWC"));
           CHECK_GT(crop, 0);
           out[0] = CreateTensorShape(
-              vector<int>{batch_size, crop, crop, color ? 3 : 1},
+              order == StorageOrder::NCHW
+                  ? vector<int>{batch_size, color ? 3 : 1, crop, crop}
+                  : vector<int>{batch_size, crop, crop, color ? 3 : 1},
               TensorProto::FLOAT);
           out[1] =
               CreateTensorShape(vector<int>{1, batch_size}, TensorProto::INT32);
@@ -109,6 +113,12 @@ The dimension of the output image will always be cropxcrop
          "outputs)")
     .Arg("random_scale", "[min, max] shortest-side desired for image resize. "
          "Defaults to [-1, -1] or no random resize desired.")
+    .Arg("reduced_decode", "If 1 and scale is used, JPEGs that are at least "
+         "2, 4 or 8 times larger than scale are decoded directly at that "
+         "reduced size, which is much faster. Not applied with bounding "
+         "boxes or inception-style scale jittering. Defaults to 0")
+    .Arg("order", "Layout of the output images on CPU, NHWC or NCHW. "
+         "Defaults to NHWC")
     .Input(0, "reader", "The input reader (a db::DBReader)")
     .Output(0, "data", "Tensor containing the images")
     .Output(1, "label", "Tensor containing the labels")
@@ -80,6 +80,8 @@ class ImageInputOp final
   bool GetImageAndLabelAndInfoFromDBValue(
       const string& value, cv::Mat* img, PerImageArg& info, int item_id,
       std::mt19937* randgen);
+  int GetDecodeFlags(
+      const char* data, size_t size, const PerImageArg& info) const;
   void DecodeAndTransform(
       const std::string& value, float *image_data, int item_id,
       const int channels, std::size_t thread_index);
@@ -152,6 +154,12 @@ class ImageInputOp final
   std::atomic<long> num_decode_errors_in_batch_{0};
   // opencv exceptions tolerance
   float max_decode_error_ratio_;
+
+  // Decode JPEGs at 1/2, 1/4 or 1/8 of their size when that is still
+  // larger than scale_
+  bool reduced_decode_;
+  // Layout of the output images
+  StorageOrder order_;
 };
 
 template <class Context>
@@ -212,7 +220,11 @@ ImageInputOp<Context>::ImageInputOp(
           {-1, -1})),
       max_decode_error_ratio_(OperatorBase::template GetSingleArgument<float>(
           "max_decode_error_ratio",
-          1.0)) {
+          1.0)),
+      reduced_decode_(
+          OperatorBase::template GetSingleArgument<int>("reduced_decode", 0)),
+      order_(StringToStorageOrder(
+          OperatorBase::template GetSingleArgument<string>("order", "NHWC"))) {
   if ((random_scale_[0] == -1) || (random_scale_[1] == -1)) {
     random_scaling_ = false;
   } else {
@@ -302,6 +314,13 @@ ImageInputOp<Context>::ImageInputOp(
       !use_caffe_datum_ || OutputSize() == 2,
       "There can only be 2 outputs if the Caffe datum format is used");
 
+  CAFFE_ENFORCE(
+      order_ == StorageOrder::NHWC || order_ == StorageOrder::NCHW,
+      "Unsupported storage order");
+  CAFFE_ENFORCE(
+      !gpu_transform_ || order_ == StorageOrder::NHWC,
+      "The GPU transform always outputs NCHW images from NHWC ones");
+
   CAFFE_ENFORCE(random_scale_.size() == 2,
       "Must provide [scale_min, scale_max]");
   CAFFE_ENFORCE_GE(random_scale_[1], random_scale_[0],
@@ -356,6 +375,9 @@ ImageInputOp<Context>::ImageInputOp(
                 << (warp_ ? " with " : " without ") << "warping;";
     }
   }
+  if (reduced_decode_) {
+    LOG(INFO) << "    Decoding JPEGs at a reduced size when possible;";
+  }
   LOG(INFO) << "    " << (is_test_ ? "Central" : "Random")
             << " cropping image to " << crop_
             << (mirror_ ? " with " : " without ") << "random mirroring;";
@@ -380,12 +402,12 @@ ImageInputOp<Context>::ImageInputOp(
   for (int i = 0; i < num_decode_threads_; ++i) {
     randgen_per_thread_.emplace_back(meta_randgen());
   }
+  const int64_t channels = color_ ? 3 : 1;
   ReinitializeTensor(
       &prefetched_image_,
-      {int64_t(batch_size_),
-       int64_t(crop_),
-       int64_t(crop_),
-       int64_t(color_ ? 3 : 1)},
+      order_ == StorageOrder::NCHW
+          ? std::vector<int64_t>{batch_size_, channels, crop_, crop_}
+          : std::vector<int64_t>{batch_size_, crop_, crop_, channels},
       at::dtype<uint8_t>().device(CPU));
   std::vector<int64_t> sizes;
   if (label_type_ != SINGLE_LABEL && label_type_ != SINGLE_LABEL_WEIGHTED) {
@@ -448,6 +470,83 @@ bool RandomSizedCropping(
   return inception_scale_jitter;
 }
 
+// Reads the dimensions of a JPEG from its frame header without decoding it.
+// Returns false if the data is not a JPEG or the header is not found.
+inline bool GetJpegSize(const char* data, size_t size, int* height, int* width) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  if (size < 4 || bytes[0] != 0xFF || bytes[1] != 0xD8) {
+    return false;
+  }
+  size_t pos = 2;
+  while (pos + 4 <= size) {
+    if (bytes[pos] != 0xFF) {
+      return false;
+    }
+    const uint8_t marker = bytes[pos + 1];
+    if (marker == 0xFF) {
+      // Fill byte
+      ++pos;
+      continue;
+    }
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+      // Markers without a payload
+      pos += 2;
+      continue;
+    }
+    // SOF0 to SOF15, except DHT, JPG and DAC which share the range
+    if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+        marker != 0xC8 && marker != 0xCC) {
+      if (pos + 9 > size) {
+        return false;
+      }
+      *height = (bytes[pos + 5] << 8) | bytes[pos + 6];
+      *width = (bytes[pos + 7] << 8) | bytes[pos + 8];
+      return *height > 0 && *width > 0;
+    }
+    const size_t length = (bytes[pos + 2] << 8) | bytes[pos + 3];
+    if (marker == 0xDA || length < 2) {
+      // The scan starts before any frame header
+      return false;
+    }
+    pos += 2 + length;
+  }
+  return false;
+}
+
+template <class Context>
+int ImageInputOp<Context>::GetDecodeFlags(
+    const char* data,
+    size_t size,
+    const PerImageArg& info) const {
+#if CV_VERSION_MAJOR > 3 || (CV_VERSION_MAJOR == 3 && CV_VERSION_MINOR >= 2)
+  // libjpeg can decode a JPEG at 1/2, 1/4 or 1/8 of its size by only running
+  // the low frequencies of each block through the inverse DCT, which is much
+  // cheaper than decoding at full size and shrinking the result. This only
+  // works when the image is rescaled to scale_ anyway: bounding boxes are in
+  // full size pixels, and minsize, random scaling and inception-style crops
+  // depend on the original size.
+  if (reduced_decode_ && scale_ > 0 && !info.bounding_params.valid &&
+      (scale_jitter_type_ == NO_SCALE_JITTER || is_test_)) {
+    int height, width;
+    if (GetJpegSize(data, size, &height, &width)) {
+      const int min_side = std::min(height, width);
+      // libjpeg rounds the reduced dimensions up
+      if ((min_side + 7) / 8 >= scale_) {
+        return color_ ? cv::IMREAD_REDUCED_COLOR_8
+                      : cv::IMREAD_REDUCED_GRAYSCALE_8;
+      } else if ((min_side + 3) / 4 >= scale_) {
+        return color_ ? cv::IMREAD_REDUCED_COLOR_4
+                      : cv::IMREAD_REDUCED_GRAYSCALE_4;
+      } else if ((min_side + 1) / 2 >= scale_) {
+        return color_ ? cv::IMREAD_REDUCED_COLOR_2
+                      : cv::IMREAD_REDUCED_GRAYSCALE_2;
+      }
+    }
+  }
+#endif
+  return color_ ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE;
+}
+
 template <class Context>
 bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
     const string& value,
@@ -480,7 +579,7 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
                 datum.data().size(),
                 CV_8UC1,
                 const_cast<char*>(datum.data().data())),
-            color_ ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE);
+            GetDecodeFlags(datum.data().data(), datum.data().size(), info));
         if (src.rows == 0 || src.cols == 0) {
           num_decode_errors_in_batch_++;
           src = cv::Mat::zeros(cv::Size(224, 224), CV_8UC3);
@@ -555,7 +654,8 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
                 &encoded_size,
                 CV_8UC1,
                 const_cast<char*>(encoded_image_str.data())),
-            color_ ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE);
+            GetDecodeFlags(
+                encoded_image_str.data(), encoded_image_str.size(), info));
         if (src.rows == 0 || src.cols == 0) {
           num_decode_errors_in_batch_++;
           src = cv::Mat::zeros(cv::Size(224, 224), CV_8UC3);
@@ -948,6 +1048,43 @@ void ColorNormalization(
   }
 }
 
+// Copies the crop x crop window at (height_offset, width_offset) of the HWC
+// uint8 image, mirrored if requested, and stores (x - mean[c]) * std[c] in the
+// given order.
+template <class Context>
+void CropAndNormalizeImage(
+    const cv::Mat& scaled_img,
+    const int channels,
+    const int height_offset,
+    const int width_offset,
+    const int crop,
+    const bool mirror_image,
+    const float* mean,
+    const float* std,
+    const StorageOrder order,
+    float* image_data) {
+  const int plane_size = crop * crop;
+  for (int h = 0; h < crop; ++h) {
+    const uint8_t* row = scaled_img.ptr(height_offset + h);
+    for (int w = 0; w < crop; ++w) {
+      const int src_w = width_offset + (mirror_image ? crop - 1 - w : w);
+      const uint8_t* cv_data = row + src_w * channels;
+      if (order == StorageOrder::NHWC) {
+        float* dst = image_data + (h * crop + w) * channels;
+        for (int c = 0; c < channels; ++c) {
+          dst[c] = (static_cast<float>(cv_data[c]) - mean[c]) * std[c];
+        }
+      } else {
+        float* dst = image_data + h * crop + w;
+        for (int c = 0; c < channels; ++c) {
+          dst[c * plane_size] =
+              (static_cast<float>(cv_data[c]) - mean[c]) * std[c];
+        }
+      }
+    }
+  }
+}
+
 // Factored out image transformation
 template <class Context>
 void TransformImage(
@@ -968,7 +1105,8 @@ void TransformImage(
     const std::vector<float>& std,
     std::mt19937* randgen,
     std::bernoulli_distribution* mirror_this_image,
-    bool is_test = false) {
+    bool is_test = false,
+    StorageOrder order = StorageOrder::NHWC) {
   CAFFE_ENFORCE_GE(
       scaled_img.rows, crop, "Image height must be bigger than crop.");
   CAFFE_ENFORCE_GE(
@@ -985,42 +1123,55 @@ void TransformImage(
     height_offset =
       std::uniform_int_distribution<>(0, scaled_img.rows - crop)(*randgen);
   }
+  const bool mirror_image =
+      !is_test && mirror && (*mirror_this_image)(*randgen);
+
+  const bool jitter =
+      channels == 3 && !is_test && (color_jitter || color_lighting);
+  if (!jitter) {
+    // Nothing happens between the copy and the normalization, so do both in
+    // a single pass straight into the output layout.
+    CropAndNormalizeImage<Context>(
+        scaled_img, channels, height_offset, width_offset, crop, mirror_image,
+        mean.data(), std.data(), order, image_data);
+    return;
+  }
 
-  float* image_data_ptr = image_data;
-  if (!is_test && mirror && (*mirror_this_image)(*randgen)) {
-    // Copy mirrored image.
-    for (int h = height_offset; h < height_offset + crop; ++h) {
-      for (int w = width_offset + crop - 1; w >= width_offset; --w) {
-        const uint8_t* cv_data = scaled_img.ptr(h) + w * channels;
-        for (int c = 0; c < channels; ++c) {
-          *(image_data_ptr++) = static_cast<float>(cv_data[c]);
-        }
-      }
-    }
-  } else {
-    // Copy normally.
-    for (int h = height_offset; h < height_offset + crop; ++h) {
-      for (int w = width_offset; w < width_offset + crop; ++w) {
-        const uint8_t* cv_data = scaled_img.ptr(h) + w * channels;
-        for (int c = 0; c < channels; ++c) {
-          *(image_data_ptr++) = static_cast<float>(cv_data[c]);
-        }
-      }
-    }
+  // The color augmentations work on HWC images.
+  const std::vector<float> zero_mean(channels, 0.0f);
+  const std::vector<float> unit_std(channels, 1.0f);
+  std::vector<float> hwc_buffer;
+  float* hwc_data = image_data;
+  if (order == StorageOrder::NCHW) {
+    hwc_buffer.resize(crop * crop * channels);
+    hwc_data = hwc_buffer.data();
   }
+  CropAndNormalizeImage<Context>(
+      scaled_img, channels, height_offset, width_offset, crop, mirror_image,
+      zero_mean.data(), unit_std.data(), StorageOrder::NHWC, hwc_data);
 
-  if (color_jitter && channels == 3 && !is_test) {
-    ColorJitter<Context>(image_data, crop, saturation, brightness, contrast,
+  if (color_jitter) {
+    ColorJitter<Context>(hwc_data, crop, saturation, brightness, contrast,
       randgen);
   }
-  if (color_lighting && channels == 3 && !is_test) {
-    ColorLighting<Context>(image_data, crop, color_lighting_std,
+  if (color_lighting) {
+    ColorLighting<Context>(hwc_data, crop, color_lighting_std,
       color_lighting_eigvecs, color_lighting_eigvals, randgen);
   }
 
   // Color normalization
   // Mean subtraction and scaling.
-  ColorNormalization<Context>(image_data, crop, channels, mean, std);
+  if (order == StorageOrder::NHWC) {
+    ColorNormalization<Context>(image_data, crop, channels, mean, std);
+  } else {
+    const int plane_size = crop * crop;
+    for (int p = 0; p < plane_size; ++p) {
+      for (int c = 0; c < channels; ++c) {
+        image_data[c * plane_size + p] =
+            (hwc_data[p * channels + c] - mean[c]) * std[c];
+      }
+    }
+  }
 }
 
 // Only crop / transose the image
@@ -1093,7 +1244,7 @@ void ImageInputOp<Context>::DecodeAndTransform(
     color_jitter_, img_saturation_, img_brightness_, img_contrast_,
     color_lighting_, color_lighting_std_, color_lighting_eigvecs_,
     color_lighting_eigvals_, crop_, mirror_, mean_, std_,
-    randgen, &mirror_this_image, is_test_);
+    randgen, &mirror_this_image, is_test_, order_);
 }
 
 template <class Context>
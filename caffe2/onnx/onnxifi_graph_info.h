@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -16,6 +17,9 @@ struct BackendGraphInfo {
   onnxBackend backend;
   onnxGraph graph;
   onnxifi_library* lib{nullptr};
+  // The op whose inputs and outputs are currently set on the graph, so that
+  // ops that run with the same buffers every time can skip onnxSetGraphIO
+  std::atomic<const void*> io_owner{nullptr};
 
   BackendGraphInfo(
       onnxBackendID backend_id,
@@ -33,7 +37,9 @@ struct BackendGraphInfo {
     backend = other.backend;
     graph = other.graph;
     lib = other.lib;
+    io_owner = other.io_owner.load();
     other.backend_id = other.backend = other.graph = other.lib = nullptr;
+    other.io_owner = nullptr;
   }
 
   BackendGraphInfo& operator=(BackendGraphInfo&& other) {
@@ -41,7 +47,9 @@ struct BackendGraphInfo {
     backend = other.backend;
     graph = other.graph;
     lib = other.lib;
+    io_owner = other.io_owner.load();
     other.backend_id = other.backend = other.graph = other.lib = nullptr;
+    other.io_owner = nullptr;
     return *this;
   }
 
@@ -0,0 +1,84 @@
+#include "caffe2/operators/fc_inference.h"
+#include "caffe2/operators/fully_connected_op.h"
+#include "caffe2/utils/eigen_utils.h"
+
+namespace caffe2 {
+
+namespace {
+
+// FC followed by an activation applied in place on the output while it is
+// still in cache. Created by the FuseFCActivation optimization pass.
+class FCActivationOp final : public FullyConnectedOp<CPUContext> {
+ public:
+  enum class Activation { RELU, SIGMOID, TANH };
+
+  template <class... Args>
+  explicit FCActivationOp(Args&&... args)
+      : FullyConnectedOp<CPUContext>(std::forward<Args>(args)...) {
+    const auto activation =
+        this->template GetSingleArgument<std::string>("activation", "");
+    if (activation == "Relu") {
+      activation_ = Activation::RELU;
+    } else if (activation == "Sigmoid") {
+      activation_ = Activation::SIGMOID;
+    } else if (activation == "Tanh") {
+      activation_ = Activation::TANH;
+    } else {
+      CAFFE_THROW("Unsupported activation for FCActivation: ", activation);
+    }
+  }
+
+  bool RunOnDevice() override {
+    if (!FullyConnectedOp<CPUContext>::RunOnDevice()) {
+      return false;
+    }
+    auto* Y = Output(0);
+    const int N = Y->numel();
+    float* Y_data = Y->template mutable_data<float>();
+    EigenVectorArrayMap<float> Y_arr(Y_data, N);
+    switch (activation_) {
+      case Activation::RELU:
+        Y_arr = Y_arr.cwiseMax(0.0f);
+        break;
+      case Activation::SIGMOID:
+        Y_arr = 1.0f / (1.0f + (-Y_arr).exp());
+        break;
+      case Activation::TANH:
+        math::Tanh<float, CPUContext>(N, Y_data, Y_data, &context_);
+        break;
+    }
+    return true;
+  }
+
+ private:
+  Activation activation_;
+};
+
+} // namespace
+
+REGISTER_CPU_OPERATOR(FCActivation, FCActivationOp);
+
+using namespace std::placeholders;
+OPERATOR_SCHEMA(FCActivation)
+    .NumInputs(3)
+    .NumOutputs(1)
+    .TensorInferenceFunction(std::bind(FCShapeInference, _1, _2, false))
+    .CostInferenceFunction(std::bind(CostInferenceForFC, _1, _2, false))
+    .Arg("activation", "*(type: string)* One of Relu, Sigmoid or Tanh.")
+    .Arg("axis", "*(type: int; default: 1)* Same as for FC.")
+    .Arg("axis_w", "*(type: int; default: 1)* Same as for FC.")
+    .SetDoc(R"DOC(
+Computes $Y = activation(XW^T+b)$, the fusion of an FC operator with the
+following Relu, Sigmoid or Tanh operator. The activation is applied in place
+on the output of the FC, so the intermediate tensor is never written out.
+This operator is created by the FuseFCActivation optimization pass and has no
+gradient.
+)DOC")
+    .Input(0, "X", "Input blob, see FC.")
+    .Input(1, "W", "Weight blob of shape $(N,K)$, see FC.")
+    .Input(2, "b", "Bias blob of length $N$, see FC.")
+    .Output(0, "Y", "Output blob of shape $(M,N)$.");
+
+NO_GRADIENT(FCActivation);
+
+} // namespace caffe2
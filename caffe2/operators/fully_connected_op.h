@@ -18,7 +18,7 @@ template <
     class Context,
     class Engine = DefaultEngine,
     bool TransposeWeight = true>
-class FullyConnectedOp final : public Operator<Context> {
+class FullyConnectedOp : public Operator<Context> {
  public:
   USE_OPERATOR_CONTEXT_FUNCTIONS;
   template <class... Args>
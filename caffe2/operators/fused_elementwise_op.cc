@@ -0,0 +1,293 @@
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <map>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/elementwise_ops_utils.h"
+#include "caffe2/utils/eigen_utils.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+std::vector<int> ComputeFusedElementwiseDims(
+    const std::vector<std::vector<int>>& dims) {
+  std::vector<int> out = dims.front();
+  for (size_t i = 1; i < dims.size(); ++i) {
+    out = elementwise_ops_utils::ComputeBinaryBroadcastForwardDims(
+        out, dims[i]);
+  }
+  return out;
+}
+
+// Runs a chain of elementwise operators in a single pass over its output,
+// one block at a time, so the intermediate tensors never leave the cache.
+// Created by the FuseElementwiseChains optimization pass.
+class FusedElementwiseOp final : public Operator<CPUContext> {
+ public:
+  enum class ElementwiseType {
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    RELU,
+    SIGMOID,
+    TANH,
+    EXP,
+    LOG,
+    ABS,
+    SQRT,
+    NEGATIVE
+  };
+
+  template <class... Args>
+  explicit FusedElementwiseOp(Args&&... args)
+      : Operator<CPUContext>(std::forward<Args>(args)...),
+        operands_(this->template GetRepeatedArgument<int>("operands")),
+        operand_first_(
+            this->template GetRepeatedArgument<int>("operand_first")) {
+    const auto ops = this->template GetRepeatedArgument<std::string>("ops");
+    CAFFE_ENFORCE(!ops.empty(), "FusedElementwise needs at least one op");
+    CAFFE_ENFORCE_EQ(ops.size(), operands_.size());
+    CAFFE_ENFORCE_EQ(ops.size(), operand_first_.size());
+    for (size_t i = 0; i < ops.size(); ++i) {
+      ops_.push_back(ParseElementwiseType(ops[i]));
+      if (IsBinary(ops_.back())) {
+        CAFFE_ENFORCE(
+            operands_[i] >= 0 && operands_[i] < InputSize(),
+            "Invalid operand for ",
+            ops[i],
+            ": ",
+            operands_[i]);
+      }
+    }
+  }
+
+  bool RunOnDevice() override {
+    const int num_inputs = InputSize();
+    std::vector<std::vector<int>> dims(num_inputs);
+    for (int i = 0; i < num_inputs; ++i) {
+      const auto& X = Input(i);
+      dims[i].assign(X.sizes().begin(), X.sizes().end());
+    }
+    const std::vector<int> Y_dims = ComputeFusedElementwiseDims(dims);
+    const int N = std::accumulate(
+        Y_dims.cbegin(), Y_dims.cend(), 1, std::multiplies<int>());
+
+    // Inputs are read from their own memory when they already have the shape
+    // of the output or are a scalar, and broadcast into a buffer otherwise.
+    // All of this happens before Y is allocated, which may reuse an input.
+    inputs_.assign(num_inputs, nullptr);
+    scalars_.assign(num_inputs, 0.0f);
+    broadcast_buffers_.resize(num_inputs);
+    for (int i = 0; i < num_inputs; ++i) {
+      const auto& X = Input(i);
+      const float* X_data = X.template data<float>();
+      if (X.numel() == N) {
+        inputs_[i] = X_data;
+      } else if (X.numel() == 1) {
+        scalars_[i] = X_data[0];
+      } else {
+        broadcast_buffers_[i].resize(N);
+        math::Broadcast<float, CPUContext>(
+            dims[i].size(),
+            dims[i].data(),
+            Y_dims.size(),
+            Y_dims.data(),
+            1.0f,
+            X_data,
+            broadcast_buffers_[i].data(),
+            &context_);
+        inputs_[i] = broadcast_buffers_[i].data();
+      }
+    }
+
+    auto* Y = Output(
+        0,
+        std::vector<int64_t>(Y_dims.cbegin(), Y_dims.cend()),
+        at::dtype<float>());
+    float* Y_data = Y->template mutable_data<float>();
+
+    std::array<float, kBlockSize> value;
+    std::array<float, kBlockSize> operand;
+    for (int offset = 0; offset < N; offset += kBlockSize) {
+      const int n = std::min(kBlockSize, N - offset);
+      LoadBlock(0, offset, n, value.data());
+      EigenVectorArrayMap<float> V(value.data(), n);
+      for (size_t i = 0; i < ops_.size(); ++i) {
+        if (IsBinary(ops_[i])) {
+          LoadBlock(operands_[i], offset, n, operand.data());
+          ApplyBinary(
+              ops_[i],
+              operand_first_[i],
+              ConstEigenVectorArrayMap<float>(operand.data(), n),
+              &V);
+        } else {
+          ApplyUnary(ops_[i], n, value.data());
+        }
+      }
+      std::copy(value.data(), value.data() + n, Y_data + offset);
+    }
+    return true;
+  }
+
+ private:
+  static constexpr int kBlockSize = 1024;
+
+  static ElementwiseType ParseElementwiseType(const std::string& op) {
+    static const std::map<std::string, ElementwiseType> kTypes = {
+        {"Add", ElementwiseType::ADD},
+        {"Sub", ElementwiseType::SUB},
+        {"Mul", ElementwiseType::MUL},
+        {"Div", ElementwiseType::DIV},
+        {"Relu", ElementwiseType::RELU},
+        {"Sigmoid", ElementwiseType::SIGMOID},
+        {"Tanh", ElementwiseType::TANH},
+        {"Exp", ElementwiseType::EXP},
+        {"Log", ElementwiseType::LOG},
+        {"Abs", ElementwiseType::ABS},
+        {"Sqrt", ElementwiseType::SQRT},
+        {"Negative", ElementwiseType::NEGATIVE},
+    };
+    auto it = kTypes.find(op);
+    CAFFE_ENFORCE(it != kTypes.end(), "Unsupported FusedElementwise op: ", op);
+    return it->second;
+  }
+
+  static bool IsBinary(ElementwiseType type) {
+    return type == ElementwiseType::ADD || type == ElementwiseType::SUB ||
+        type == ElementwiseType::MUL || type == ElementwiseType::DIV;
+  }
+
+  void LoadBlock(int input, int offset, int n, float* block) const {
+    if (inputs_[input]) {
+      std::copy(inputs_[input] + offset, inputs_[input] + offset + n, block);
+    } else {
+      std::fill(block, block + n, scalars_[input]);
+    }
+  }
+
+  static void ApplyBinary(
+      ElementwiseType type,
+      bool operand_first,
+      const ConstEigenVectorArrayMap<float>& B,
+      EigenVectorArrayMap<float>* A) {
+    switch (type) {
+      case ElementwiseType::ADD:
+        *A += B;
+        break;
+      case ElementwiseType::SUB:
+        *A = operand_first ? (B - *A).eval() : (*A - B).eval();
+        break;
+      case ElementwiseType::MUL:
+        *A *= B;
+        break;
+      case ElementwiseType::DIV:
+        *A = operand_first ? (B / *A).eval() : (*A / B).eval();
+        break;
+      default:
+        CAFFE_THROW("Not a binary op");
+    }
+  }
+
+  void ApplyUnary(ElementwiseType type, int n, float* X) {
+    EigenVectorArrayMap<float> A(X, n);
+    switch (type) {
+      case ElementwiseType::RELU:
+        A = A.cwiseMax(0.0f);
+        break;
+      case ElementwiseType::SIGMOID:
+        A = 1.0f / (1.0f + (-A).exp());
+        break;
+      case ElementwiseType::TANH:
+        math::Tanh<float, CPUContext>(n, X, X, &context_);
+        break;
+      case ElementwiseType::EXP:
+        math::Exp<float, CPUContext>(n, X, X, &context_);
+        break;
+      case ElementwiseType::LOG:
+        math::Log<float, CPUContext>(n, X, X, &context_);
+        break;
+      case ElementwiseType::ABS:
+        math::Abs<float, CPUContext>(n, X, X, &context_);
+        break;
+      case ElementwiseType::SQRT:
+        math::Sqrt<float, CPUContext>(n, X, X, &context_);
+        break;
+      case ElementwiseType::NEGATIVE:
+        math::Neg<float, CPUContext>(n, X, X, &context_);
+        break;
+      default:
+        CAFFE_THROW("Not a unary op");
+    }
+  }
+
+  std::vector<ElementwiseType> ops_;
+  std::vector<int> operands_;
+  std::vector<int> operand_first_;
+  std::vector<const float*> inputs_;
+  std::vector<float> scalars_;
+  std::vector<std::vector<float>> broadcast_buffers_;
+};
+
+constexpr int FusedElementwiseOp::kBlockSize;
+
+std::vector<TensorShape> FusedElementwiseShapeInference(
+    const OperatorDef& /* unused */,
+    const std::vector<TensorShape>& in) {
+  std::vector<std::vector<int>> dims;
+  for (const auto& shape : in) {
+    dims.emplace_back(shape.dims().begin(), shape.dims().end());
+  }
+  std::vector<TensorShape> out(1);
+  out[0].set_data_type(TensorProto_DataType_FLOAT);
+  for (const int dim : ComputeFusedElementwiseDims(dims)) {
+    out[0].add_dims(dim);
+  }
+  return out;
+}
+
+} // namespace
+
+REGISTER_CPU_OPERATOR(FusedElementwise, FusedElementwiseOp);
+
+OPERATOR_SCHEMA(FusedElementwise)
+    .NumInputs(1, INT_MAX)
+    .NumOutputs(1)
+    .AllowInplace([](int /* in */, int /* out */) { return true; })
+    .TensorInferenceFunction(FusedElementwiseShapeInference)
+    .Arg(
+        "ops",
+        "*(type: [string])* The chain of operators, each one of Add, Sub, "
+        "Mul, Div, Relu, Sigmoid, Tanh, Exp, Log, Abs, Sqrt or Negative.")
+    .Arg(
+        "operands",
+        "*(type: [int])* For each binary op, the index of the input it "
+        "combines the running value with, -1 for unary ops.")
+    .Arg(
+        "operand_first",
+        "*(type: [int])* For each binary op, 1 if the input is the first "
+        "argument of the op, e.g. `operand - value` for Sub.")
+    .SetDoc(R"DOC(
+Computes a chain of elementwise operators in a single loop, without writing
+out the intermediate results. The running value starts as input 0, and each
+op of `ops` is applied to it in order: unary ops transform it, binary ops
+combine it with the input given by `operands`. Inputs are broadcast to the
+shape of the output following the numpy rules of the binary ops. Only float
+tensors are supported.
+
+This operator is created by the FuseElementwiseChains optimization pass and
+has no gradient.
+)DOC")
+    .Input(0, "X", "*(type: Tensor`<float>`)* Input the chain starts from.")
+    .Output(0, "Y", "*(type: Tensor`<float>`)* Result of the chain.");
+
+NO_GRADIENT(FusedElementwise);
+
+} // namespace caffe2
@@ -26,6 +26,7 @@ OPERATOR_SCHEMA(GivenTensorFill)
     .NumInputs(0, 1)
     .NumOutputs(1)
     .AllowInplace({{0, 0}})
+    .ParallelConstruction()
     .SetDoc(R"DOC(
 This op fills an output tensor with the data specified by the *value* and *dtype* arguments.  The output tensor shape is specified by the *shape* argument. Beware, when using this argument *value* should have a value for every element of the *output*, as missing values will not be initialized automatically. If *input_as_shape* is set to *true*, then the *input* should be a 1D tensor containing the desired output shape (the dimensions specified in *extra_shape* will also be appended). In this case, the *shape* argument should **not** be set.
 
@@ -100,6 +101,7 @@ OPERATOR_SCHEMA(GivenTensorDoubleFill)
     .NumInputs(0, 1)
     .NumOutputs(1)
     .AllowInplace({{0, 0}})
+    .ParallelConstruction()
     .Arg(
         "values",
         "The value for the elements of the output tensor.",
@@ -123,6 +125,7 @@ OPERATOR_SCHEMA(GivenTensorBoolFill)
     .NumInputs(0, 1)
     .NumOutputs(1)
     .AllowInplace({{0, 0}})
+    .ParallelConstruction()
     .Arg(
         "values",
         "The value for the elements of the output tensor.",
@@ -145,6 +148,7 @@ OPERATOR_SCHEMA(GivenTensorIntFill)
     .NumInputs(0, 1)
     .NumOutputs(1)
     .AllowInplace({{0, 0}})
+    .ParallelConstruction()
     .Arg(
         "values",
         "The value for the elements of the output tensor.",
@@ -167,6 +171,7 @@ OPERATOR_SCHEMA(GivenTensorInt64Fill)
     .NumInputs(0, 1)
     .NumOutputs(1)
     .AllowInplace({{0, 0}})
+    .ParallelConstruction()
     .Arg(
         "values",
         "The value for the elements of the output tensor.",
@@ -189,6 +194,7 @@ OPERATOR_SCHEMA(GivenTensorStringFill)
     .NumInputs(0, 1)
     .NumOutputs(1)
     .AllowInplace({{0, 0}})
+    .ParallelConstruction()
     .Arg(
         "values",
         "The value for the elements of the output tensor.",
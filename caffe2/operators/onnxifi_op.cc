@@ -1,5 +1,7 @@
 #include "caffe2/operators/onnxifi_op.h"
 
+#include <cstring>
+
 namespace caffe2 {
 
 namespace {
@@ -242,8 +244,54 @@ void OnnxifiOp<CPUContext>::maybeAdjustOutputBatchSizes(
   }
 }
 
+template <>
+bool OnnxifiOp<CPUContext>::feedMaxBoundBuffer(
+    int input_idx,
+    const Tensor& input_tensor,
+    onnxTensorDescriptorV1* desc) {
+  const auto it = input_shape_hints_.find(input_idx);
+  if (it == input_shape_hints_.end()) {
+    return false;
+  }
+  const auto& info = it->second;
+  auto& buffer = input_buffers_[input_idx];
+  if (!buffer.defined()) {
+    std::vector<int64_t> dims(info.dims.begin(), info.dims.end());
+    buffer = caffe2::empty(
+        dims, at::dtype(OnnxifiTypeToDataType(info.onnxifi_type)).device(CPU));
+    // The rows past the real batch are never read back, but are zeroed once
+    // so that the backend doesn't compute on uninitialized memory
+    memset(buffer.raw_mutable_data(), 0, buffer.nbytes());
+  }
+
+  // Only a smaller first (batch) dimension fits in the buffer
+  const auto tensor_dims = input_tensor.sizes();
+  if (input_tensor.dtype() != buffer.dtype() ||
+      tensor_dims.size() != info.dims.size() || tensor_dims.empty() ||
+      tensor_dims[0] > info.dims[0]) {
+    return false;
+  }
+  for (size_t j = 1; j < tensor_dims.size(); ++j) {
+    if (tensor_dims[j] != info.dims[j]) {
+      return false;
+    }
+  }
+  context_.CopyBytesSameDevice(
+      input_tensor.nbytes(),
+      input_tensor.raw_data(),
+      buffer.raw_mutable_data());
+  desc->dimensions = info.dims.size();
+  desc->shape = info.dims.data();
+  SetInputTensorDescriptorTypeAndBuffer(buffer, desc);
+  return true;
+}
+
 template <>
 bool OnnxifiOp<CPUContext>::RunOnDevice() {
+  // With max bound buffers, the inputs and outputs set on the graph stay valid
+  // as long as no buffer moves and no other op sets its own
+  bool io_changed = !use_max_bound_buffers_ ||
+      backend_graph_shared_ptr_->io_owner != static_cast<const void*>(this);
   CAFFE_ENFORCE_EQ(input_desc_.size(), InputSize());
   for (unsigned i = 0U; i < InputSize(); ++i) {
     const auto& input_tensor = Input(i);
@@ -251,13 +299,20 @@ bool OnnxifiOp<CPUContext>::RunOnDevice() {
     auto& tensor_descriptor = input_desc_[i];
     tensor_descriptor.tag = ONNXIFI_TAG_TENSOR_DESCRIPTOR_V1;
     tensor_descriptor.memoryType = ONNXIFI_MEMORY_TYPE_CPU;
-    tensor_descriptor.dimensions = tensor_dims.size();
     auto& input_shape = input_shapes_[i];
     input_shape.clear();
     input_shape.insert(
         input_shape.begin(), tensor_dims.cbegin(), tensor_dims.cend());
+    const auto previous_buffer = tensor_descriptor.buffer;
+    if (use_max_bound_buffers_ &&
+        feedMaxBoundBuffer(i, input_tensor, &tensor_descriptor)) {
+      io_changed |= tensor_descriptor.buffer != previous_buffer;
+      continue;
+    }
+    tensor_descriptor.dimensions = tensor_dims.size();
     tensor_descriptor.shape = input_shape.data();
     SetInputTensorDescriptorTypeAndBuffer(input_tensor, &tensor_descriptor);
+    io_changed = true;
   }
 
   CAFFE_ENFORCE_EQ(output_desc_.size(), OutputSize());
@@ -286,8 +341,12 @@ bool OnnxifiOp<CPUContext>::RunOnDevice() {
         i,
         tensor_dims_int64_,
         at::dtype(OnnxifiTypeToDataType(type)).device(CPU));
+    // Growing the output back from the real batch size of the previous run
+    // keeps its memory (see caffe2_keep_on_shrink), so it usually stays put
+    const auto previous_buffer = tensor_descriptor.buffer;
     SetOutputTensorDescriptorTypeAndBuffer(
         type, output_tensor, &tensor_descriptor);
+    io_changed |= tensor_descriptor.buffer != previous_buffer;
   }
   bool ext_supported = false;
   onnxMemoryFenceV1 input_fence;
@@ -334,14 +393,18 @@ bool OnnxifiOp<CPUContext>::RunOnDevice() {
   }
 #endif
   if (!ext_supported) {
-    CAFFE_ENFORCE_EQ(
-        lib_->onnxSetGraphIO(
-            graph_,
-            input_desc_.size(),
-            input_desc_.data(),
-            output_desc_.size(),
-            output_desc_.data()),
-        ONNXIFI_STATUS_SUCCESS);
+    if (io_changed) {
+      CAFFE_ENFORCE_EQ(
+          lib_->onnxSetGraphIO(
+              graph_,
+              input_desc_.size(),
+              input_desc_.data(),
+              output_desc_.size(),
+              output_desc_.data()),
+          ONNXIFI_STATUS_SUCCESS);
+      backend_graph_shared_ptr_->io_owner =
+          use_max_bound_buffers_ ? static_cast<const void*>(this) : nullptr;
+    }
 
     input_fence.tag = ONNXIFI_TAG_MEMORY_FENCE_V1;
     input_fence.type = ONNXIFI_SYNCHRONIZATION_EVENT;
@@ -391,5 +454,8 @@ OPERATOR_SCHEMA(Onnxifi)
         "Initialization pair indicating the mapping of the name between NetDef and ONNX model")
     .Arg(
         "output_resize_hints",
-        "A list of key/value pairs indicating which input index to look up for real batch size for the given max output batch size");
+        "A list of key/value pairs indicating which input index to look up for real batch size for the given max output batch size")
+    .Arg(
+        "use_max_bound_buffers",
+        "(int default=0) Copy the inputs into buffers of the shapes given by input_shape_hint_<idx>, allocated once, so that the backend graph is bound to the same inputs and outputs on every run");
 } // namespace caffe2
@@ -68,6 +68,27 @@ class OnnxifiOp final : public Operator<Context> {
     input_shapes_.resize(input_names_.size());
     output_shapes_.resize(output_names_.size());
 
+    // With max bound buffers, inputs are copied into buffers of their bound
+    // shape (given by input_shape_hint_<idx>), so that the backend sees the
+    // same buffers and shapes on every run
+    use_max_bound_buffers_ =
+        this->template GetSingleArgument<int>("use_max_bound_buffers", 0);
+    if (use_max_bound_buffers_) {
+      for (int i = 0; i < input_names_.size(); ++i) {
+        const std::string key = c10::str("input_shape_hint_", i);
+        auto input_shape_hint = this->template GetRepeatedArgument<int>(key);
+        if (!input_shape_hint.empty()) {
+          TensorInfo info;
+          info.onnxifi_type = input_shape_hint.front();
+          for (size_t j = 1; j < input_shape_hint.size(); ++j) {
+            info.dims.push_back(input_shape_hint[j]);
+          }
+          input_shape_hints_.emplace(i, std::move(info));
+        }
+      }
+      input_buffers_.resize(input_names_.size());
+    }
+
     // Get output resizing hints
     adjust_output_batch_ =
         this->template GetSingleArgument<int>("adjust_output_batch", 0);
@@ -249,6 +270,13 @@ class OnnxifiOp final : public Operator<Context> {
 
   std::vector<int> extractOutputBatchSizes() const;
 
+  // Copies the input into its max bound buffer and points the descriptor
+  // at it. Returns false if the input doesn't fit in the buffer.
+  bool feedMaxBoundBuffer(
+      int input_idx,
+      const Tensor& input_tensor,
+      onnxTensorDescriptorV1* desc);
+
   void maybeAdjustOutputBatchSizes(
       const std::vector<int>& real_output_batch_sizes);
 
@@ -307,6 +335,12 @@ class OnnxifiOp final : public Operator<Context> {
   // output shape hints
   std::unordered_map<int, TensorInfo> output_shape_hints_;
 
+  // Whether inputs are fed through buffers of their bound shapes, and the
+  // bound shapes and buffers of the inputs
+  bool use_max_bound_buffers_{false};
+  std::unordered_map<int, TensorInfo> input_shape_hints_;
+  std::vector<Tensor> input_buffers_;
+
   // Whether we need to resize outputs or not
   bool adjust_output_batch_{false};
 
@@ -327,6 +327,44 @@ void ReplaceSubgraph(
   }
 }
 
+// Whether the gain of lowering the ops of `subgraph` outweighs the cost of
+// its transfers. Must be called after DetectBoundaryReferences().
+bool WorthTransforming(
+    const TransformSubgraph& subgraph,
+    const BackendCuttingOptions& options) {
+  size_t num_ops = 0;
+  double gain = 0;
+  for (auto node : subgraph.nodes) {
+    if (!nn::is<NeuralNetOperator>(node)) {
+      continue;
+    }
+    ++num_ops;
+    if (options.op_gain) {
+      const auto* nn_op = nn::get<NeuralNetOperator>(node);
+      gain += options.op_gain(
+          dyn_cast<Caffe2Annotation>(nn_op->getAnnotation())->getOperatorDef());
+    } else {
+      gain += 1;
+    }
+  }
+  if (num_ops == 0 || num_ops < options.min_ops) {
+    return false;
+  }
+  if (!options.transfer_cost) {
+    return true;
+  }
+  double cost = 0;
+  for (const auto& kv : subgraph.external_input_refs) {
+    cost += options.transfer_cost(kv.first);
+  }
+  for (const auto& kv : subgraph.external_output_refs) {
+    cost += options.transfer_cost(kv.first);
+  }
+  VLOG(2) << "Group " << subgraph.group_id << ": " << num_ops
+          << " ops, gain " << gain << ", transfer cost " << cost;
+  return gain > cost;
+}
+
 void PruneUnrefereredNodes(NNModule* nn) {
   auto& g = nn->dataFlow;
   std::vector<NodeRef> to_delete;
@@ -360,6 +398,16 @@ caffe2::NetDef OptimizeForBackend(
     std::function<bool(const caffe2::OperatorDef&)> supports,
     std::function<caffe2::NetDef(const caffe2::NetDef&)> transform_func,
     bool debug) {
+  BackendCuttingOptions options;
+  options.debug = debug;
+  return OptimizeForBackend(net, supports, transform_func, options);
+}
+
+caffe2::NetDef OptimizeForBackend(
+    caffe2::NetDef& net,
+    std::function<bool(const caffe2::OperatorDef&)> supports,
+    std::function<caffe2::NetDef(const caffe2::NetDef&)> transform_func,
+    const BackendCuttingOptions& options) {
   auto nn = convertToNNModule(net);
   auto& dfg = nn.dataFlow;
 
@@ -413,6 +461,9 @@ caffe2::NetDef OptimizeForBackend(
   for (auto& g : subs) {
     // Generate boundary input/output edges
     DetectBoundaryReferences(&g, context.infos, external_outputs);
+    if (!WorthTransforming(g, options)) {
+      continue;
+    }
 
     caffe2::NetDef subnet = ConvertToC2Net(g, context.infos);
     // Transform the subgraph protobuf def, note that we can have less external
@@ -426,7 +477,7 @@ caffe2::NetDef OptimizeForBackend(
   // absorbed
   PruneUnrefereredNodes(&nn);
 
-  if (debug) {
+  if (options.debug) {
     DumpGraph(&dfg);
   }
 
@@ -5,10 +5,42 @@
 #include "caffe2/proto/caffe2_pb.h"
 
 #include <functional>
+#include <string>
 
 namespace caffe2 {
 namespace opt {
 
+// Decides which of the subgraphs supported by a backend are worth lowering
+// to it. A subgraph is lowered when it has at least `min_ops` ops and the sum
+// of the gains of its ops exceeds the cost of moving its boundary tensors
+// between the backends, so that small islands of supported ops between
+// unsupported ones stay where they are.
+struct CAFFE2_API BackendCuttingOptions {
+  // Minimum number of ops of a lowered subgraph
+  size_t min_ops{1};
+
+  // Estimated gain of running the op on the backend, in the unit of
+  // transfer_cost. Every op gains 1 if not set.
+  std::function<double(const caffe2::OperatorDef&)> op_gain;
+
+  // Estimated cost of moving the given tensor into or out of the backend.
+  // Transfers are free if not set.
+  std::function<double(const std::string&)> transfer_cost;
+
+  // Dump the graph after the transformation to dump.dot
+  bool debug{false};
+};
+
+// Cuts `net` into maximal subgraphs of ops that satisfy `supports` and
+// replaces the ones `options` considers worth it by the result of
+// `transform_func`, which may have fewer but not more external inputs and
+// outputs than the subgraph it's given.
+CAFFE2_API caffe2::NetDef OptimizeForBackend(
+    caffe2::NetDef& net,
+    std::function<bool(const caffe2::OperatorDef&)> supports,
+    std::function<caffe2::NetDef(const caffe2::NetDef&)> transform_func,
+    const BackendCuttingOptions& options);
+
 CAFFE2_API caffe2::NetDef OptimizeForBackend(
     caffe2::NetDef& net,
     std::function<bool(const caffe2::OperatorDef&)> supports,
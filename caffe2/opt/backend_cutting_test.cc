@@ -151,3 +151,43 @@ TEST(BackendCuttingTest, skipPath) {
   auto net_opt = caffe2::opt::OptimizeForBackend(net, Supports, Transform);
   EXPECT_EQ(4, net_opt.op_size());
 }
+
+// X -> CopyIn -> MyConv -> CopyOut -> Y
+TEST(BackendCuttingTest, costModel) {
+  caffe2::NetDef net;
+  net.add_external_input("X");
+  net.add_external_input("W0");
+  net.add_external_input("b0");
+  net.add_external_output("Y");
+  auto* op = net.add_op();
+  op->set_type("CopyIn");
+  op->add_input("X");
+  op->add_output("N0");
+  AddConv(&net, 0);
+  op = net.add_op();
+  op->set_type("CopyOut");
+  op->add_input("N1");
+  op->add_output("Y");
+
+  // Moving N0 in and N1 out costs more than what the conv gains
+  caffe2::opt::BackendCuttingOptions options;
+  options.transfer_cost = [](const std::string& tensor) {
+    return StartsWith(tensor, "N") ? 1.0 : 0.0;
+  };
+  auto net_opt =
+      caffe2::opt::OptimizeForBackend(net, Supports, Transform, options);
+  EXPECT_EQ(3, net_opt.op_size());
+  EXPECT_EQ("MyConv", net_opt.op(1).type());
+
+  options.op_gain = [](const caffe2::OperatorDef& op) {
+    return StartsWith(op.type(), "MyConv") ? 10.0 : 1.0;
+  };
+  net_opt = caffe2::opt::OptimizeForBackend(net, Supports, Transform, options);
+  EXPECT_EQ(3, net_opt.op_size());
+  EXPECT_EQ("BigOpt", net_opt.op(1).type());
+
+  // Too small, regardless of the gain
+  options.min_ops = 2;
+  net_opt = caffe2::opt::OptimizeForBackend(net, Supports, Transform, options);
+  EXPECT_EQ("MyConv", net_opt.op(1).type());
+}
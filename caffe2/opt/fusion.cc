@@ -2,6 +2,10 @@
 #include "caffe2/core/logging.h"
 #include "caffe2/opt/converter.h"
 #include "caffe2/opt/passes.h"
+#include "caffe2/utils/proto_utils.h"
+
+#include <algorithm>
+#include <unordered_set>
 
 namespace caffe2 {
 namespace opt {
@@ -121,5 +125,291 @@ void fuseConvBN(nom::repr::NNModule* nn, caffe2::Workspace* ws) {
 
 REGISTER_WS_OPT_PASS_FROM_FUNC(FuseConvBN, fuseConvBN);
 
+repr::NNGraph::NodeRef getSingleConsumer(
+    repr::NNModule* nn,
+    repr::NNGraph::NodeRef node) {
+  auto outputs = repr::nn::getOutputs(node);
+  if (outputs.size() != 1 || nn->outputs.count(outputs.front())) {
+    return nullptr;
+  }
+  auto consumers = repr::nn::getConsumers(outputs.front());
+  if (consumers.size() != 1) {
+    return nullptr;
+  }
+  return consumers.front();
+}
+
+repr::NNGraph::NodeRef replaceWithFusedOp(
+    repr::NNModule* nn,
+    const std::vector<repr::NNGraph::NodeRef>& ops,
+    const std::vector<repr::NNGraph::NodeRef>& inputs,
+    const caffe2::OperatorDef& def) {
+  CAFFE_ENFORCE(!ops.empty(), "No operators to fuse");
+  auto fusedNode =
+      nn->dataFlow.createNode(make_unique<repr::GenericOperator>(def.type()));
+  auto annotation = make_unique<Caffe2Annotation>();
+  annotation->setOperatorDef(def);
+  annotation->setDeviceType(def.device_option().device_type());
+  if (!def.device_option().node_name().empty()) {
+    annotation->setDevice(def.device_option().node_name());
+  }
+  repr::nn::get<repr::NeuralNetOperator>(fusedNode)->setAnnotation(
+      std::move(annotation));
+
+  for (auto input : inputs) {
+    nn->dataFlow.createEdge(input, fusedNode);
+  }
+  for (auto output : repr::nn::getOutputs(ops.back())) {
+    nn->dataFlow.createEdge(fusedNode, output);
+  }
+
+  std::vector<repr::NNGraph::NodeRef> intermediates;
+  for (size_t i = 0; i + 1 < ops.size(); ++i) {
+    for (auto output : repr::nn::getOutputs(ops[i])) {
+      intermediates.push_back(output);
+    }
+  }
+  for (auto op : ops) {
+    nn->dataFlow.deleteNode(op);
+  }
+  for (auto tensor : intermediates) {
+    nn->dataFlow.deleteNode(tensor);
+  }
+  return fusedNode;
+}
+
+namespace {
+
+const caffe2::OperatorDef* getOpDef(repr::NNGraph::NodeRef node) {
+  const auto* annotation =
+      repr::nn::get<repr::NeuralNetOperator>(node)->getAnnotation();
+  if (!annotation || !isa<Caffe2Annotation>(annotation)) {
+    return nullptr;
+  }
+  return &dyn_cast<Caffe2Annotation>(annotation)->getOperatorDef();
+}
+
+// The fused operators only have default CPU implementations
+bool isDefaultCPUOp(repr::NNGraph::NodeRef node) {
+  const auto* def = getOpDef(node);
+  return def && def->device_option().device_type() == PROTO_CPU &&
+      def->engine().empty();
+}
+
+std::string getOpName(repr::NNGraph::NodeRef node) {
+  return repr::nn::get<repr::NeuralNetOperator>(node)->getName();
+}
+
+} // namespace
+
+void fuseFCActivation(repr::NNModule* nn) {
+  for (auto node_pair : repr::nn::dataIterator<repr::FC>(nn->dataFlow)) {
+    repr::NNGraph::NodeRef fcNode;
+    repr::FC* fc;
+    std::tie(fc, fcNode) = node_pair;
+    NOM_REQUIRE_OR_CONT(isDefaultCPUOp(fcNode));
+
+    auto activationNode = getSingleConsumer(nn, fcNode);
+    NOM_REQUIRE_OR_CONT(activationNode);
+    auto activation = getOpName(activationNode);
+    NOM_REQUIRE_OR_CONT(
+        activation == "Relu" || activation == "Sigmoid" ||
+        activation == "Tanh");
+    NOM_REQUIRE_OR_CONT(isDefaultCPUOp(activationNode));
+    NOM_REQUIRE_OR_CONT(repr::nn::getOutputs(activationNode).size() == 1);
+
+    auto def = *getOpDef(fcNode);
+    def.set_type("FCActivation");
+    AddArgument("activation", activation, &def);
+    replaceWithFusedOp(
+        nn, {fcNode, activationNode}, repr::nn::getInputs(fcNode), def);
+  }
+}
+
+void fuseSparseLengthsReduction(repr::NNModule* nn) {
+  static const std::unordered_map<std::string, std::string> kFusedOps = {
+      {"LengthsSum", "SparseLengthsSum"},
+      {"LengthsMean", "SparseLengthsMean"},
+      {"LengthsWeightedSum", "SparseLengthsWeightedSum"},
+  };
+  // Fusing deletes the reduction, collect the Gathers beforehand
+  std::vector<repr::NNGraph::NodeRef> gatherNodes;
+  for (auto node :
+       repr::nn::nodeIterator<repr::GenericOperator>(nn->dataFlow)) {
+    if (getOpName(node) == "Gather") {
+      gatherNodes.push_back(node);
+    }
+  }
+  for (auto gatherNode : gatherNodes) {
+    NOM_REQUIRE_OR_CONT(isDefaultCPUOp(gatherNode));
+    ArgumentHelper gatherArgs(*getOpDef(gatherNode));
+    // SparseLengths* operators index rows of DATA
+    NOM_REQUIRE_OR_CONT(gatherArgs.GetSingleArgument<int>("axis", 0) == 0);
+    NOM_REQUIRE_OR_CONT(
+        !gatherArgs.GetSingleArgument<bool>("match_outer", false));
+    auto gatherInputs = repr::nn::getInputs(gatherNode);
+    NOM_REQUIRE_OR_CONT(gatherInputs.size() == 2);
+
+    auto reduceNode = getSingleConsumer(nn, gatherNode);
+    NOM_REQUIRE_OR_CONT(reduceNode);
+    auto fused = kFusedOps.find(getOpName(reduceNode));
+    NOM_REQUIRE_OR_CONT(fused != kFusedOps.end());
+    NOM_REQUIRE_OR_CONT(isDefaultCPUOp(reduceNode));
+    auto reduceInputs = repr::nn::getInputs(reduceNode);
+    // The gathered rows have to be the DATA of the reduction
+    NOM_REQUIRE_OR_CONT(
+        reduceInputs.front() == repr::nn::getOutputs(gatherNode).front());
+
+    std::vector<repr::NNGraph::NodeRef> inputs;
+    if (fused->first == "LengthsWeightedSum") {
+      // (DATA, SCALARS, LENGTHS) -> (DATA, WEIGHTS, INDICES, LENGTHS)
+      NOM_REQUIRE_OR_CONT(reduceInputs.size() == 3);
+      inputs = {
+          gatherInputs[0], reduceInputs[1], gatherInputs[1], reduceInputs[2]};
+    } else {
+      // (DATA, LENGTHS) -> (DATA, INDICES, LENGTHS)
+      NOM_REQUIRE_OR_CONT(reduceInputs.size() == 2);
+      inputs = {gatherInputs[0], gatherInputs[1], reduceInputs[1]};
+    }
+
+    auto def = *getOpDef(reduceNode);
+    def.set_type(fused->second);
+    replaceWithFusedOp(nn, {gatherNode, reduceNode}, inputs, def);
+  }
+}
+
+namespace {
+
+bool isBinaryElementwise(const std::string& name) {
+  return name == "Add" || name == "Sub" || name == "Mul" || name == "Div";
+}
+
+// Unary operators with only float implementations
+bool isFloatElementwise(const std::string& name) {
+  return name == "Relu" || name == "Sigmoid" || name == "Tanh" ||
+      name == "Exp" || name == "Log" || name == "Abs" || name == "Sqrt";
+}
+
+bool isFusableElementwise(repr::NNGraph::NodeRef node) {
+  if (!repr::nn::is<repr::NeuralNetOperator>(node)) {
+    return false;
+  }
+  auto name = getOpName(node);
+  bool binary = isBinaryElementwise(name);
+  if (!binary && !isFloatElementwise(name) && name != "Negative") {
+    return false;
+  }
+  if (!isDefaultCPUOp(node)) {
+    return false;
+  }
+  // Legacy broadcasting with an axis has its own semantics
+  if (ArgumentHelper(*getOpDef(node)).GetSingleArgument<int>("broadcast", 0)) {
+    return false;
+  }
+  auto inputs = repr::nn::getInputs(node);
+  if (inputs.size() != (binary ? 2u : 1u) ||
+      (binary && inputs[0] == inputs[1])) {
+    return false;
+  }
+  return repr::nn::getOutputs(node).size() == 1;
+}
+
+repr::NNGraph::NodeRef getChainPredecessor(
+    repr::NNModule* nn,
+    repr::NNGraph::NodeRef node) {
+  for (auto input : repr::nn::getInputs(node)) {
+    if (!repr::nn::hasProducer(input)) {
+      continue;
+    }
+    auto producer = repr::nn::getProducer(input);
+    if (isFusableElementwise(producer) &&
+        getSingleConsumer(nn, producer) == node) {
+      return producer;
+    }
+  }
+  return nullptr;
+}
+
+} // namespace
+
+void fuseElementwiseChains(repr::NNModule* nn) {
+  // Find the maximal chains first, the graph is only modified afterwards
+  std::unordered_set<repr::NNGraph::NodeRef> visited;
+  std::vector<std::vector<repr::NNGraph::NodeRef>> chains;
+  for (auto node : nn->dataFlow.getMutableNodes()) {
+    if (visited.count(node) || !isFusableElementwise(node)) {
+      continue;
+    }
+    auto head = node;
+    for (auto prev = getChainPredecessor(nn, head);
+         prev && !visited.count(prev);
+         prev = getChainPredecessor(nn, head)) {
+      head = prev;
+    }
+    std::vector<repr::NNGraph::NodeRef> chain{head};
+    visited.insert(head);
+    for (auto next = getSingleConsumer(nn, head);
+         next && !visited.count(next) && isFusableElementwise(next);
+         next = getSingleConsumer(nn, next)) {
+      chain.push_back(next);
+      visited.insert(next);
+    }
+    if (chain.size() > 1 &&
+        std::any_of(chain.begin(), chain.end(), [](repr::NNGraph::NodeRef n) {
+          return isFloatElementwise(getOpName(n));
+        })) {
+      chains.push_back(std::move(chain));
+    }
+  }
+
+  for (const auto& chain : chains) {
+    // The value flowing through the chain starts from input 0, each binary
+    // step combines it with one of the inputs
+    std::vector<repr::NNGraph::NodeRef> inputs;
+    auto inputIndex = [&inputs](repr::NNGraph::NodeRef tensor) {
+      auto it = std::find(inputs.begin(), inputs.end(), tensor);
+      if (it != inputs.end()) {
+        return static_cast<int>(it - inputs.begin());
+      }
+      inputs.push_back(tensor);
+      return static_cast<int>(inputs.size() - 1);
+    };
+    std::vector<std::string> ops;
+    std::vector<int> operands;
+    std::vector<int> operandFirst;
+    repr::NNGraph::NodeRef value = nullptr;
+    for (auto op : chain) {
+      auto opInputs = repr::nn::getInputs(op);
+      if (!value) {
+        inputIndex(opInputs[0]);
+      }
+      ops.push_back(getOpName(op));
+      if (opInputs.size() == 2) {
+        bool first = value && opInputs[1] == value;
+        operands.push_back(inputIndex(first ? opInputs[0] : opInputs[1]));
+        operandFirst.push_back(first);
+      } else {
+        operands.push_back(-1);
+        operandFirst.push_back(0);
+      }
+      value = repr::nn::getOutputs(op).front();
+    }
+
+    auto def = *getOpDef(chain.back());
+    def.set_type("FusedElementwise");
+    def.clear_arg();
+    AddArgument("ops", ops, &def);
+    AddArgument("operands", operands, &def);
+    AddArgument("operand_first", operandFirst, &def);
+    replaceWithFusedOp(nn, chain, inputs, def);
+  }
+}
+
+REGISTER_OPT_PASS_FROM_FUNC(FuseFCActivation, fuseFCActivation);
+REGISTER_OPT_PASS_FROM_FUNC(
+    FuseSparseLengthsReduction,
+    fuseSparseLengthsReduction);
+REGISTER_OPT_PASS_FROM_FUNC(FuseElementwiseChains, fuseElementwiseChains);
+
 } // namespace opt
 } // namespace caffe2
@@ -27,6 +27,40 @@ using namespace nom;
 
 CAFFE2_API void fuseConvBN(repr::NNModule* nn, caffe2::Workspace* ws);
 
+// CPU inference fusions, each replacing a chain of operators with a single
+// operator that doesn't materialize the tensors in between.
+//
+// FC followed by Relu, Sigmoid or Tanh becomes FCActivation.
+CAFFE2_API void fuseFCActivation(repr::NNModule* nn);
+// Gather along the first dimension followed by a LengthsSum, LengthsMean or
+// LengthsWeightedSum of the gathered rows becomes the matching SparseLengths*
+// operator.
+CAFFE2_API void fuseSparseLengthsReduction(repr::NNModule* nn);
+// Chains of elementwise operators (Add, Sub, Mul, Div and unary activations)
+// become a FusedElementwise operator running the whole chain in one loop.
+// Only chains with a float-only activation are fused, which guarantees the
+// chain computes in float.
+CAFFE2_API void fuseElementwiseChains(repr::NNModule* nn);
+
+// Helpers to write fusion passes.
+//
+// Returns the operator consuming the output of `node` if `node` has a single
+// output, read exactly once by a single operator and not an output of the
+// module, nullptr otherwise. The output can then be fused away.
+CAFFE2_API repr::NNGraph::NodeRef getSingleConsumer(
+    repr::NNModule* nn,
+    repr::NNGraph::NodeRef node);
+
+// Replaces the chain of operators `ops`, each the single consumer of the
+// previous one, with one operator described by `def` that reads `inputs` in
+// order and writes the outputs of the last operator of the chain. The tensors
+// in between are deleted. Returns the node of the new operator.
+CAFFE2_API repr::NNGraph::NodeRef replaceWithFusedOp(
+    repr::NNModule* nn,
+    const std::vector<repr::NNGraph::NodeRef>& ops,
+    const std::vector<repr::NNGraph::NodeRef>& inputs,
+    const caffe2::OperatorDef& def);
+
 // Generic activation fusion helper.
 //
 // \tparam OperationT The operator to be fused.
@@ -0,0 +1,175 @@
+#include "caffe2/core/common.h"
+#include "caffe2/opt/converter.h"
+#include "caffe2/opt/passes.h"
+#include "caffe2/utils/proto_utils.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+caffe2::OperatorDef* addOp(
+    caffe2::NetDef* net,
+    const std::string& type,
+    const std::vector<std::string>& inputs,
+    const std::vector<std::string>& outputs) {
+  caffe2::OperatorDef* def = net->add_op();
+  def->set_type(type);
+  for (const auto& input : inputs) {
+    def->add_input(input);
+  }
+  for (const auto& output : outputs) {
+    def->add_output(output);
+  }
+  return def;
+}
+
+caffe2::NetDef runPass(const std::string& name, const caffe2::NetDef& net) {
+  auto nn = caffe2::convertToNNModule(net);
+  auto pass = caffe2::OptimizationPassRegistry()->Create(name, &nn);
+  pass->run();
+  return caffe2::convertToCaffe2Proto(nn, net);
+}
+
+} // namespace
+
+TEST(Fusion, FCActivation) {
+  caffe2::NetDef net;
+  addOp(&net, "FC", {"X", "W", "b"}, {"Y"});
+  addOp(&net, "Relu", {"Y"}, {"Z"});
+  net.add_external_output("Z");
+
+  auto optimized_net = runPass("FuseFCActivation", net);
+  ASSERT_EQ(optimized_net.op().size(), 1);
+  const auto& op = optimized_net.op(0);
+  EXPECT_EQ(op.type(), "FCActivation");
+  ASSERT_EQ(op.input().size(), 3);
+  EXPECT_EQ(op.input(0), "X");
+  EXPECT_EQ(op.input(1), "W");
+  EXPECT_EQ(op.input(2), "b");
+  ASSERT_EQ(op.output().size(), 1);
+  EXPECT_EQ(op.output(0), "Z");
+  EXPECT_EQ(
+      caffe2::ArgumentHelper(op).GetSingleArgument<std::string>(
+          "activation", ""),
+      "Relu");
+}
+
+TEST(Fusion, FCActivationUsedOutputNoFusion) {
+  caffe2::NetDef net;
+  addOp(&net, "FC", {"X", "W", "b"}, {"Y"});
+  addOp(&net, "Relu", {"Y"}, {"Z"});
+  net.add_external_output("Y");
+  net.add_external_output("Z");
+
+  auto optimized_net = runPass("FuseFCActivation", net);
+  ASSERT_EQ(optimized_net.op().size(), 2);
+  EXPECT_EQ(optimized_net.op(0).type(), "FC");
+}
+
+TEST(Fusion, SparseLengthsSum) {
+  caffe2::NetDef net;
+  addOp(&net, "Gather", {"D", "I"}, {"G"});
+  addOp(&net, "LengthsSum", {"G", "L"}, {"S"});
+  net.add_external_output("S");
+
+  auto optimized_net = runPass("FuseSparseLengthsReduction", net);
+  ASSERT_EQ(optimized_net.op().size(), 1);
+  const auto& op = optimized_net.op(0);
+  EXPECT_EQ(op.type(), "SparseLengthsSum");
+  ASSERT_EQ(op.input().size(), 3);
+  EXPECT_EQ(op.input(0), "D");
+  EXPECT_EQ(op.input(1), "I");
+  EXPECT_EQ(op.input(2), "L");
+  EXPECT_EQ(op.output(0), "S");
+}
+
+TEST(Fusion, SparseLengthsWeightedSum) {
+  caffe2::NetDef net;
+  addOp(&net, "Gather", {"D", "I"}, {"G"});
+  addOp(&net, "LengthsWeightedSum", {"G", "W", "L"}, {"S"});
+  net.add_external_output("S");
+
+  auto optimized_net = runPass("FuseSparseLengthsReduction", net);
+  ASSERT_EQ(optimized_net.op().size(), 1);
+  const auto& op = optimized_net.op(0);
+  EXPECT_EQ(op.type(), "SparseLengthsWeightedSum");
+  ASSERT_EQ(op.input().size(), 4);
+  EXPECT_EQ(op.input(0), "D");
+  EXPECT_EQ(op.input(1), "W");
+  EXPECT_EQ(op.input(2), "I");
+  EXPECT_EQ(op.input(3), "L");
+}
+
+TEST(Fusion, SparseLengthsGatherAxisNoFusion) {
+  caffe2::NetDef net;
+  auto* gather = addOp(&net, "Gather", {"D", "I"}, {"G"});
+  gather->add_arg()->CopyFrom(caffe2::MakeArgument<int>("axis", 1));
+  addOp(&net, "LengthsSum", {"G", "L"}, {"S"});
+  net.add_external_output("S");
+
+  auto optimized_net = runPass("FuseSparseLengthsReduction", net);
+  EXPECT_EQ(optimized_net.op().size(), 2);
+}
+
+TEST(Fusion, ElementwiseChain) {
+  caffe2::NetDef net;
+  addOp(&net, "Mul", {"X", "A"}, {"Y"});
+  addOp(&net, "Sub", {"B", "Y"}, {"Z"});
+  addOp(&net, "Sigmoid", {"Z"}, {"Z"});
+  addOp(&net, "Add", {"Z", "A"}, {"O"});
+  net.add_external_output("O");
+
+  auto optimized_net = runPass("FuseElementwiseChains", net);
+  ASSERT_EQ(optimized_net.op().size(), 1);
+  const auto& op = optimized_net.op(0);
+  EXPECT_EQ(op.type(), "FusedElementwise");
+  ASSERT_EQ(op.input().size(), 3);
+  EXPECT_EQ(op.input(0), "X");
+  EXPECT_EQ(op.input(1), "A");
+  EXPECT_EQ(op.input(2), "B");
+  EXPECT_EQ(op.output(0), "O");
+
+  caffe2::ArgumentHelper args(op);
+  EXPECT_EQ(
+      args.GetRepeatedArgument<std::string>("ops"),
+      std::vector<std::string>({"Mul", "Sub", "Sigmoid", "Add"}));
+  EXPECT_EQ(
+      args.GetRepeatedArgument<int>("operands"),
+      std::vector<int>({1, 2, -1, 1}));
+  EXPECT_EQ(
+      args.GetRepeatedArgument<int>("operand_first"),
+      std::vector<int>({0, 1, 0, 0}));
+}
+
+TEST(Fusion, ElementwiseChainWithoutActivationNoFusion) {
+  // Arithmetic alone may run on integer tensors
+  caffe2::NetDef net;
+  addOp(&net, "Mul", {"X", "A"}, {"Y"});
+  addOp(&net, "Add", {"Y", "B"}, {"Z"});
+  net.add_external_output("Z");
+
+  auto optimized_net = runPass("FuseElementwiseChains", net);
+  EXPECT_EQ(optimized_net.op().size(), 2);
+}
+
+TEST(Fusion, ElementwiseChainStopsAtSharedOutput) {
+  caffe2::NetDef net;
+  addOp(&net, "Relu", {"X"}, {"Y"});
+  addOp(&net, "Exp", {"Y"}, {"Z"});
+  addOp(&net, "Mul", {"Z", "A"}, {"O"});
+  addOp(&net, "Tanh", {"Z"}, {"P"});
+  net.add_external_output("O");
+  net.add_external_output("P");
+
+  auto optimized_net = runPass("FuseElementwiseChains", net);
+  ASSERT_EQ(optimized_net.op().size(), 3);
+  int fused = 0;
+  for (const auto& op : optimized_net.op()) {
+    if (op.type() == "FusedElementwise") {
+      ++fused;
+      EXPECT_EQ(op.input(0), "X");
+      EXPECT_EQ(op.output(0), "Z");
+    }
+  }
+  EXPECT_EQ(fused, 1);
+}
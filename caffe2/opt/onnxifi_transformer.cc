@@ -294,6 +294,7 @@ OnnxifiTransformer::generateBatchPaddingHints(
 
 OperatorDef OnnxifiTransformer::BuildOnnxifiOp(
     const std::string& onnx_model_str,
+    const std::unordered_map<std::string, TensorShape>& input_shape_hints,
     const std::unordered_map<std::string, TensorShape>& output_shape_hints,
     const std::unordered_set<std::string>& initialization_list,
     const std::vector<std::string>& external_inputs,
@@ -332,6 +333,24 @@ OperatorDef OnnxifiTransformer::BuildOnnxifiOp(
     output_names->add_strings(output);
   }
 
+  // Add input size hints, which are the bound shapes of the inputs the op
+  // allocates when it uses max bound buffers
+  if (opts_.use_max_bound_buffers) {
+    AddArgument("use_max_bound_buffers", 1, &op);
+    for (int i = 0; i < op.input_size(); ++i) {
+      const auto it = input_shape_hints.find(op.input(i));
+      if (it != input_shape_hints.end()) {
+        const auto& shape = it->second;
+        auto* input_shape_hint_arg = op.add_arg();
+        input_shape_hint_arg->set_name(c10::str("input_shape_hint_", i));
+        input_shape_hint_arg->add_ints(onnxifiDataType(shape.data_type()));
+        for (const auto& d : shape.dims()) {
+          input_shape_hint_arg->add_ints(d);
+        }
+      }
+    }
+  }
+
   // Add output size hints
   for (int i = 0; i < op.output_size(); ++i) {
     const auto& o = op.output(i);
@@ -393,9 +412,6 @@ NetDef OnnxifiTransformer::SubnetToOnnxifiOpViaC2(
     WriteProtoToTextFile(
         net, "debug_original_net_" + c10::to_string(onnxifi_op_id) + ".pb_txt");
   }
-  if (opts_.min_ops > net.op_size()) {
-    return net;
-  }
   // We already have all the ops and external inputs and outputs!
   NetDef onnxifi_net(net);
 
@@ -448,7 +464,15 @@ NetDef OnnxifiTransformer::SubnetToOnnxifiOpViaC2(
     }
   }
 
-  // Compute output shape hints
+  // Compute input and output shape hints. Quantized inputs keep being bound
+  // as they come.
+  std::unordered_map<std::string, TensorShape> input_shape_hints;
+  for (const auto& i : total_inputs_vec) {
+    const auto& info = shape_hints.at(i);
+    if (!initialization_list.count(i) && !info.is_quantized) {
+      input_shape_hints.emplace(i, info.shape);
+    }
+  }
   std::unordered_map<std::string, TensorShape> output_shape_hints;
   for (const auto& o : onnxifi_net.external_output()) {
     const auto it = shape_hints.find(o);
@@ -468,6 +492,7 @@ NetDef OnnxifiTransformer::SubnetToOnnxifiOpViaC2(
   onnxifi_net.SerializeToString(&model_str);
   auto onnxifi_op = BuildOnnxifiOp(
       model_str,
+      input_shape_hints,
       output_shape_hints,
       initialization_list,
       onnxifi_net_inputs,
@@ -493,9 +518,6 @@ NetDef OnnxifiTransformer::SubnetToOnnxifiOpViaOnnx(
     Workspace* ws,
     onnx::OnnxExporter* exporter,
     ShapeInfoMap* shape_hints) {
-  if (opts_.min_ops > net.op_size()) {
-    return net;
-  }
   ::ONNX_NAMESPACE::ModelProto onnx_model;
   fillModelInfo(&onnx_model);
 
@@ -586,8 +608,13 @@ NetDef OnnxifiTransformer::SubnetToOnnxifiOpViaOnnx(
       onnxifi_net_inputs,
       shape_hints_onnx_,
       std::unordered_map<std::string, ::ONNX_NAMESPACE::TypeProto>());
+  std::unordered_map<std::string, TensorShape> input_shape_hints;
   for (const auto& i : io_vec) {
     onnx_model.mutable_graph()->add_input()->CopyFrom(i);
+    const auto it = shape_hints_onnx_.find(i.name());
+    if (it != shape_hints_onnx_.end() && !initialization_list.count(i.name())) {
+      input_shape_hints.emplace(i.name(), it->second);
+    }
   }
 
   // Onnx model is ready. Build ONNXIFI Op
@@ -595,6 +622,7 @@ NetDef OnnxifiTransformer::SubnetToOnnxifiOpViaOnnx(
   onnx_model.SerializeToString(&model_str);
   auto onnxifi_op = BuildOnnxifiOp(
       model_str,
+      input_shape_hints,
       output_shape_hints,
       initialization_list,
       onnxifi_net_inputs,
@@ -859,6 +887,13 @@ void OnnxifiTransformer::getBackendId() {
   }
 }
 
+opt::BackendCuttingOptions OnnxifiTransformer::cuttingOptions() const {
+  opt::BackendCuttingOptions options;
+  options.min_ops = opts_.min_ops;
+  options.debug = opts_.debug;
+  return options;
+}
+
 NetDef OnnxifiTransformer::TransformViaC2(
     NetDef* pred_net,
     const std::unordered_set<std::string>& weights,
@@ -877,7 +912,7 @@ NetDef OnnxifiTransformer::TransformViaC2(
       };
 
   return opt::OptimizeForBackend(
-      *pred_net, c2_supports, c2_converter, opts_.debug);
+      *pred_net, c2_supports, c2_converter, cuttingOptions());
 }
 
 NetDef OnnxifiTransformer::TransformViaOnnx(
@@ -905,7 +940,7 @@ NetDef OnnxifiTransformer::TransformViaOnnx(
   };
 
   return opt::OptimizeForBackend(
-      *pred_net, onnx_supports, onnx_converter, opts_.debug);
+      *pred_net, onnx_supports, onnx_converter, cuttingOptions());
 }
 
 // Cutting off the runnable part and replace with ONNXIFI ops. Asssume the nets
@@ -9,6 +9,7 @@
 
 #include "caffe2/core/operator.h"
 #include "caffe2/onnx/onnxifi_init.h"
+#include "caffe2/opt/backend_cutting.h"
 #include "caffe2/opt/backend_transformer_base.h"
 
 namespace caffe2 {
@@ -32,6 +33,11 @@ struct OnnxifiTransformerOptions {
   // we explicitly blacklist operators out of the onnxifi op.
   bool permit_unknown_output_batch_size{false};
 
+  // Whether the onnxifi ops allocate their inputs and outputs once at the
+  // bound shapes and feed partial batches through them, so that the backend
+  // sees the same buffers and shapes on every run
+  bool use_max_bound_buffers{false};
+
   // Minimum number of ops to create an onnxifi op. If the subgraph is too
   // small, it doesn't make sense to lower it to backend.
   size_t min_ops{1};
@@ -74,12 +80,16 @@ class CAFFE2_API OnnxifiTransformer final : public BackendTransformerBase {
   // We already have all the ops and external inputs and outputs!
   OperatorDef BuildOnnxifiOp(
       const std::string& onnx_model_str,
+      const std::unordered_map<std::string, TensorShape>& input_shape_hints,
       const std::unordered_map<std::string, TensorShape>& output_size_hints,
       const std::unordered_set<std::string>& initialization_list,
       const std::vector<std::string>& external_inputs,
       const std::vector<std::string>& external_outputs,
       const std::unordered_map<int, std::string>& batch_pos_map);
 
+  // Options of the cutting of the net into onnxifi ops
+  opt::BackendCuttingOptions cuttingOptions() const;
+
   // Transform by passing C2 proto to backend
   NetDef TransformViaC2(
       NetDef* pred_net,
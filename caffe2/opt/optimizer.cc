@@ -9,6 +9,7 @@ namespace opt {
 
 void workspaceOptimizations(nom::repr::NNModule* nn, Workspace* ws, int level) {
   switch (level) {
+    case 2:
     case 1:
       opt::fuseConvBN(nn, ws);
     case 0:
@@ -19,6 +20,10 @@ void workspaceOptimizations(nom::repr::NNModule* nn, Workspace* ws, int level) {
 
 void graphOptimzations(nom::repr::NNModule* nn, int level) {
   switch (level) {
+    case 2:
+      opt::fuseSparseLengthsReduction(nn);
+      opt::fuseFCActivation(nn);
+      opt::fuseElementwiseChains(nn);
     case 1:
 #ifdef USE_NNPACK 
       opt::addNNPACK(nn, false);
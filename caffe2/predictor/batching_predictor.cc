@@ -0,0 +1,265 @@
+#include "caffe2/predictor/batching_predictor.h"
+
+#include <future>
+
+#include "caffe2/core/context.h"
+#include "c10/util/string_utils.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Histogram buckets hold the values up to successive powers of two, and the
+// last one everything above.
+constexpr int kBatchSizeBuckets = 13;
+constexpr int kLatencyBuckets = 25;
+
+std::vector<std::string> bucketNames(int numBuckets) {
+  std::vector<std::string> names;
+  for (int i = 0; i + 1 < numBuckets; ++i) {
+    names.push_back("le_" + c10::to_string(int64_t(1) << i));
+  }
+  names.push_back("inf");
+  return names;
+}
+
+size_t bucketIndex(int64_t value, int numBuckets) {
+  int index = 0;
+  while (index + 1 < numBuckets && (int64_t(1) << index) < value) {
+    ++index;
+  }
+  return index;
+}
+
+using Clock = std::chrono::steady_clock;
+
+Tensor concatRows(const std::vector<const Tensor*>& parts, int64_t rows) {
+  const Tensor& first = *parts.front();
+  auto dims = first.sizes().vec();
+  dims[0] = rows;
+  Tensor result(dims, CPU);
+  const auto& meta = first.dtype();
+  char* dst = static_cast<char*>(result.raw_mutable_data(meta));
+  CPUContext context;
+  for (const Tensor* part : parts) {
+    context.CopyItemsSameDevice(meta, part->numel(), part->raw_data(), dst);
+    dst += part->nbytes();
+  }
+  return result;
+}
+
+Tensor sliceRows(const Tensor& tensor, int64_t begin, int64_t rows) {
+  auto dims = tensor.sizes().vec();
+  dims[0] = rows;
+  Tensor result(dims, CPU);
+  const auto& meta = tensor.dtype();
+  int64_t rowItems = tensor.size_from_dim(1);
+  CPUContext context;
+  context.CopyItemsSameDevice(
+      meta,
+      rows * rowItems,
+      static_cast<const char*>(tensor.raw_data()) +
+          begin * rowItems * tensor.itemsize(),
+      result.raw_mutable_data(meta));
+  return result;
+}
+
+} // namespace
+
+struct BatchingPredictor::Request {
+  const TensorMap* inputs;
+  TensorMap* outputs;
+  int64_t rows;
+  Clock::time_point enqueued;
+  std::promise<bool> done;
+
+  // Whether the inputs of both requests can be concatenated
+  bool batchesWith(const Request& other) const {
+    if (inputs->size() != other.inputs->size()) {
+      return false;
+    }
+    for (const auto& input : *inputs) {
+      auto it = other.inputs->find(input.first);
+      if (it == other.inputs->end() ||
+          it->second.dtype() != input.second.dtype() ||
+          it->second.ndim() != input.second.ndim()) {
+        return false;
+      }
+      for (int d = 1; d < input.second.ndim(); ++d) {
+        if (it->second.size(d) != input.second.size(d)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+};
+
+BatchingPredictor::BatchingPredictor(
+    std::unique_ptr<Predictor> predictor,
+    BatchingPredictorOptions options)
+    : predictor_(std::move(predictor)),
+      options_(std::move(options)),
+      stats_(options_.stats_name) {
+  CAFFE_ENFORCE(predictor_, "BatchingPredictor needs a Predictor");
+  CAFFE_ENFORCE_GT(options_.max_batch_size, 0);
+  stats_.batch_size_histogram.setDetails(bucketNames(kBatchSizeBuckets));
+  stats_.latency_us_histogram.setDetails(bucketNames(kLatencyBuckets));
+  scheduler_ = std::thread([this] { schedule(); });
+}
+
+BatchingPredictor::~BatchingPredictor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  scheduler_.join();
+}
+
+bool BatchingPredictor::operator()(
+    const TensorMap& inputs,
+    TensorMap* outputs) {
+  CAFFE_ENFORCE(!inputs.empty(), "BatchingPredictor needs at least one input");
+  int64_t rows = -1;
+  for (const auto& input : inputs) {
+    CAFFE_ENFORCE_GE(
+        input.second.ndim(), 1, "Input ", input.first, " has no batch dimension");
+    if (rows < 0) {
+      rows = input.second.size(0);
+    }
+    CAFFE_ENFORCE_EQ(
+        input.second.size(0),
+        rows,
+        "All inputs must have the same batch size, but ",
+        input.first,
+        " has a different one");
+  }
+
+  Request request;
+  request.inputs = &inputs;
+  request.outputs = outputs;
+  request.rows = rows;
+  request.enqueued = Clock::now();
+  auto done = request.done.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CAFFE_ENFORCE(!stop_, "BatchingPredictor is shutting down");
+    queue_.push_back(&request);
+    queued_rows_ += rows;
+  }
+  cv_.notify_all();
+  CAFFE_EVENT(stats_, num_requests);
+
+  bool success = done.get();
+  int64_t latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                        Clock::now() - request.enqueued)
+                        .count();
+  CAFFE_EVENT(stats_, latency_us, latency);
+  CAFFE_EVENT(
+      stats_,
+      latency_us_histogram,
+      1,
+      bucketIndex(latency, kLatencyBuckets));
+  return success;
+}
+
+void BatchingPredictor::schedule() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+    // Wait for more requests until the batch is full or the oldest request
+    // has waited long enough
+    auto deadline = queue_.front()->enqueued + options_.max_latency;
+    cv_.wait_until(lock, deadline, [this] {
+      return stop_ || queued_rows_ >= options_.max_batch_size;
+    });
+
+    std::vector<Request*> batch;
+    int64_t rows = 0;
+    while (!queue_.empty()) {
+      Request* next = queue_.front();
+      if (!batch.empty() &&
+          (rows + next->rows > options_.max_batch_size ||
+           !batch.front()->batchesWith(*next))) {
+        break;
+      }
+      batch.push_back(next);
+      rows += next->rows;
+      queue_.pop_front();
+    }
+    queued_rows_ -= rows;
+
+    lock.unlock();
+    runBatch(batch);
+    lock.lock();
+  }
+}
+
+void BatchingPredictor::runBatch(const std::vector<Request*>& batch) {
+  int64_t rows = 0;
+  for (const Request* request : batch) {
+    rows += request->rows;
+  }
+  CAFFE_EVENT(stats_, num_batches);
+  CAFFE_EVENT(stats_, batch_size, rows);
+  CAFFE_EVENT(
+      stats_, batch_size_histogram, 1, bucketIndex(rows, kBatchSizeBuckets));
+
+  try {
+    TensorMap inputs;
+    for (const auto& input : *batch.front()->inputs) {
+      if (batch.size() == 1) {
+        inputs.emplace(input.first, input.second.UnsafeSharedInstance());
+        continue;
+      }
+      std::vector<const Tensor*> parts;
+      for (const Request* request : batch) {
+        parts.push_back(&request->inputs->at(input.first));
+      }
+      inputs.emplace(input.first, concatRows(parts, rows));
+    }
+
+    Predictor::TensorList outputs;
+    if (!(*predictor_)(inputs, &outputs)) {
+      CAFFE_EVENT(stats_, num_failures);
+      for (Request* request : batch) {
+        request->done.set_value(false);
+      }
+      return;
+    }
+
+    // The outputs live in the workspace of the predictor, which the next
+    // batch overwrites, so every request gets copies
+    const auto& names = predictor_->def().external_output();
+    int64_t begin = 0;
+    for (Request* request : batch) {
+      request->outputs->clear();
+      for (size_t i = 0; i < outputs.size(); ++i) {
+        const Tensor& output = outputs[i];
+        if (output.ndim() >= 1 && output.size(0) == rows) {
+          request->outputs->emplace(
+              names.Get(i), sliceRows(output, begin, request->rows));
+        } else {
+          request->outputs->emplace(names.Get(i), output.Clone());
+        }
+      }
+      begin += request->rows;
+    }
+  } catch (...) {
+    CAFFE_EVENT(stats_, num_failures);
+    for (Request* request : batch) {
+      request->done.set_exception(std::current_exception());
+    }
+    return;
+  }
+
+  for (Request* request : batch) {
+    request->done.set_value(true);
+  }
+}
+
+} // namespace caffe2
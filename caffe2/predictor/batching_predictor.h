@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "caffe2/core/stats.h"
+#include "caffe2/predictor/predictor.h"
+
+namespace caffe2 {
+
+struct CAFFE2_API BatchingPredictorOptions {
+  // Largest number of rows, summed over the requests, to run the net on at
+  // once. A request that is larger on its own still runs, alone.
+  int64_t max_batch_size = 32;
+  // How long the oldest queued request may wait for others to batch with.
+  std::chrono::microseconds max_latency{1000};
+  // Prefix of the exported stats
+  std::string stats_name = "batching_predictor";
+};
+
+/**
+ * @brief Batches the requests of concurrent callers into single runs of a
+ * Predictor.
+ *
+ * Callers block in operator() while a scheduler thread concatenates the
+ * queued requests along their first dimension, until there are
+ * max_batch_size rows or the oldest request has waited max_latency, runs
+ * the net once and splits the outputs back by rows. Requests batch together
+ * if they feed the same inputs with the same types and the same sizes past
+ * the first dimension; outputs whose first dimension isn't the total number
+ * of rows are given whole to every request of the batch.
+ *
+ * The outputs are owned by the caller, unlike those of Predictor, which are
+ * part of its workspace. Exports the number of requests, batches and
+ * failures, and the mean and histogram of the batch sizes and of the
+ * request latencies in microseconds, under `stats_name`.
+ */
+class CAFFE2_API BatchingPredictor {
+ public:
+  using TensorMap = Predictor::TensorMap;
+
+  BatchingPredictor(
+      std::unique_ptr<Predictor> predictor,
+      BatchingPredictorOptions options = BatchingPredictorOptions());
+
+  // Runs the queued requests and stops the scheduler
+  ~BatchingPredictor();
+
+  // Runs the net on `inputs`, all of which must have the same size in their
+  // first dimension. Thread-safe. Throws if the net failed or threw.
+  bool operator()(const TensorMap& inputs, TensorMap* outputs);
+
+  Predictor& predictor() {
+    return *predictor_;
+  }
+
+ private:
+  struct Request;
+
+  void schedule();
+  void runBatch(const std::vector<Request*>& batch);
+
+  struct BatchingStats {
+    CAFFE_STAT_CTOR(BatchingStats);
+    CAFFE_EXPORTED_STAT(num_requests);
+    CAFFE_EXPORTED_STAT(num_batches);
+    CAFFE_EXPORTED_STAT(num_failures);
+    CAFFE_AVG_EXPORTED_STAT(batch_size);
+    CAFFE_AVG_EXPORTED_STAT(latency_us);
+    CAFFE_DETAILED_EXPORTED_STAT(batch_size_histogram);
+    CAFFE_DETAILED_EXPORTED_STAT(latency_us_histogram);
+  };
+
+  std::unique_ptr<Predictor> predictor_;
+  const BatchingPredictorOptions options_;
+  BatchingStats stats_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Request*> queue_;
+  int64_t queued_rows_ = 0;
+  bool stop_ = false;
+  std::thread scheduler_;
+};
+
+} // namespace caffe2
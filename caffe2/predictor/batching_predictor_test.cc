@@ -0,0 +1,142 @@
+#include "caffe2/core/context.h"
+#include "caffe2/core/stats.h"
+#include "caffe2/core/tensor.h"
+#include "caffe2/predictor/batching_predictor.h"
+#include "caffe2/utils/proto_utils.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+namespace caffe2 {
+
+namespace {
+
+const char* predictSpec = R"DOC(
+        name: "predict"
+        type: "simple"
+        external_input: "data"
+        external_input: "W"
+        external_input: "b"
+        external_output: "y"
+        op {
+          input: "data"
+          input: "W"
+          input: "b"
+          output: "y"
+          type: "FC"
+        }
+)DOC";
+
+const char* initSpec = R"DOC(
+        name: "init"
+        type: "simple"
+        op {
+          type: "ConstantFill"
+          output: "W"
+          arg {
+            name: "shape"
+            ints: 10
+            ints: 4
+          }
+          arg {
+            name: "value"
+            f: 2.0
+          }
+        }
+        op {
+          type: "ConstantFill"
+          output: "b"
+          arg {
+            name: "shape"
+            ints: 10
+          }
+          arg {
+            name: "value"
+            f: 1.0
+          }
+        }
+)DOC";
+
+NetDef parseNetDef(const std::string& value) {
+  NetDef def;
+  CAFFE_ENFORCE(
+      TextFormat::ParseFromString(value, &def),
+      "Failed to parse NetDef with value: ",
+      value);
+  return def;
+}
+
+// Rows whose 4 features are all `value`, for which the net predicts
+// 10 values of 8 * value + 1
+Tensor filledRows(int64_t rows, float value) {
+  Tensor tensor(std::vector<int64_t>{rows, 4}, CPU);
+  float* data = tensor.mutable_data<float>();
+  for (int64_t i = 0; i < tensor.numel(); ++i) {
+    data[i] = value;
+  }
+  return tensor;
+}
+
+} // namespace
+
+TEST(BatchingPredictorTest, ConcurrentRequests) {
+  BatchingPredictorOptions options;
+  options.max_batch_size = 8;
+  options.max_latency = std::chrono::milliseconds(5);
+  options.stats_name = "batching_predictor_test";
+  BatchingPredictor predictor(
+      caffe2::make_unique<Predictor>(makePredictorConfig(
+          parseNetDef(initSpec), parseNetDef(predictSpec))),
+      options);
+
+  const int numThreads = 16;
+  std::vector<std::thread> threads;
+  std::vector<bool> correct(numThreads, false);
+  for (int t = 0; t < numThreads; ++t) {
+    threads.emplace_back([&, t] {
+      int64_t rows = 1 + t % 3;
+      BatchingPredictor::TensorMap inputs;
+      inputs.emplace("data", filledRows(rows, t));
+      BatchingPredictor::TensorMap outputs;
+      if (!predictor(inputs, &outputs)) {
+        return;
+      }
+      const Tensor& y = outputs.at("y");
+      if (y.ndim() != 2 || y.size(0) != rows || y.size(1) != 10) {
+        return;
+      }
+      for (int64_t i = 0; i < y.numel(); ++i) {
+        if (y.data<float>()[i] != 8 * t + 1) {
+          return;
+        }
+      }
+      correct[t] = true;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < numThreads; ++t) {
+    EXPECT_TRUE(correct[t]) << "request " << t;
+  }
+
+  auto stats = toMap(StatRegistry::get().publish());
+  EXPECT_EQ(stats["batching_predictor_test/num_requests"], numThreads);
+  EXPECT_EQ(stats["batching_predictor_test/num_failures"], 0);
+  EXPECT_EQ(stats["batching_predictor_test/batch_size/sum"], 31);
+  EXPECT_LE(stats["batching_predictor_test/batch_size/count"], numThreads);
+  EXPECT_GE(stats["batching_predictor_test/batch_size/count"], 4);
+}
+
+TEST(BatchingPredictorTest, MismatchedBatchSizes) {
+  BatchingPredictor predictor(caffe2::make_unique<Predictor>(
+      makePredictorConfig(parseNetDef(initSpec), parseNetDef(predictSpec))));
+  BatchingPredictor::TensorMap inputs;
+  inputs.emplace("data", filledRows(2, 1));
+  inputs.emplace("other", filledRows(3, 1));
+  BatchingPredictor::TensorMap outputs;
+  EXPECT_THROW(predictor(inputs, &outputs), EnforceNotMet);
+}
+
+} // namespace caffe2
@@ -1,5 +1,6 @@
 #include "caffe2/predictor/predictor.h"
 #include <unordered_set>
+#include "caffe2/core/blob_stats.h"
 #include "caffe2/core/init.h"
 
 namespace caffe2 {
@@ -24,6 +25,18 @@ const Tensor& getTensor(Workspace* ws, const std::string& name) {
   return *BlobGetMutableTensor(getBlob(ws, name), CPU);
 }
 
+size_t blobsSizeBytes(
+    const Workspace& ws,
+    const std::vector<std::string>& names) {
+  size_t bytes = 0;
+  for (const auto& name : names) {
+    if (const auto* blob = ws.GetBlob(name)) {
+      bytes += BlobStat::sizeBytes(*blob);
+    }
+  }
+  return bytes;
+}
+
 } // namespace
 
 Predictor::Predictor(
@@ -122,4 +135,15 @@ bool Predictor::operator()(const TensorMap& inputs, TensorMap* outputs) {
   return true;
 }
 
+size_t Predictor::ownedBytes() const {
+  return blobsSizeBytes(*config_.ws, config_.ws->LocalBlobs());
+}
+
+size_t Predictor::sharedBytes() const {
+  if (!config_.parent_ws) {
+    return 0;
+  }
+  return blobsSizeBytes(*config_.parent_ws, config_.parent_ws->Blobs());
+}
+
 } // namespace caffe2
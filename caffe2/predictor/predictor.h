@@ -62,6 +62,14 @@ class CAFFE2_API Predictor {
     return config_.output_names;
   }
 
+  // Bytes of CPU memory held by the blobs of this predictor's own workspace,
+  // i.e. its inputs, activations and, unless they are shared, parameters.
+  size_t ownedBytes() const;
+
+  // Bytes of CPU memory held by the parameters this predictor shares with
+  // others through PredictorConfig::parent_ws.
+  size_t sharedBytes() const;
+
  private:
   bool run_map_workspace(const TensorMap& inputs);
 
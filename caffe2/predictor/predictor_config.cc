@@ -94,4 +94,37 @@ PredictorConfig makePredictorConfig(
   return config;
 }
 
+std::shared_ptr<Workspace> makeSharedParameterWorkspace(
+    const NetDef& init_net) {
+  auto ws = std::make_shared<Workspace>();
+  CAFFE_ENFORCE(ws->RunNetOnce(init_net));
+  return ws;
+}
+
+PredictorConfig makeSharedPredictorConfig(
+    std::shared_ptr<Workspace> parameters,
+    const NetDef& run_net) {
+  CAFFE_ENFORCE(parameters, "Shared parameter workspace is null");
+  for (const auto& op : run_net.op()) {
+    for (const auto& output : op.output()) {
+      CAFFE_ENFORCE(
+          !parameters->HasBlob(output),
+          "Operator ",
+          op.type(),
+          " of net ",
+          run_net.name(),
+          " writes to shared parameter ",
+          output);
+    }
+  }
+#ifdef C10_MOBILE
+  GlobalInit();
+#endif
+  PredictorConfig config;
+  config.parent_ws = std::move(parameters);
+  config.ws = std::make_shared<Workspace>(config.parent_ws.get());
+  config.predict_net = std::make_shared<NetDef>(run_net);
+  return config;
+}
+
 } // namespace caffe2
@@ -34,6 +34,11 @@ struct CAFFE2_API PredictorConfig {
   // passed in by a user might contain extra tensors used by other models
   std::vector<std::string> parameter_names;
 
+  // Workspace holding the parameters `ws` reads from when they are shared
+  // with other predictors, see makeSharedPredictorConfig. Declared before
+  // `ws` so that it outlives it.
+  std::shared_ptr<Workspace> parent_ws;
+
   // TODO We still save ws is because of the current design of workspace and
   // tensor. Once tensor support intrusive_ptr, we'll get rid of this and use
   // parameters to construct Workspace
@@ -54,4 +59,23 @@ CAFFE2_API PredictorConfig makePredictorConfig(
     bool run_init = true,
     int optimization = 1);
 
+/**
+ * Runs `init_net` once into a workspace whose blobs can be shared, read-only,
+ * by any number of configs made with makeSharedPredictorConfig.
+ */
+CAFFE2_API std::shared_ptr<Workspace> makeSharedParameterWorkspace(
+    const NetDef& init_net);
+
+/**
+ * Creates a config whose workspace reads parameters from `parameters` and
+ * only owns the blobs `run_net` creates itself, such as its inputs and
+ * activations. Predictors made from configs sharing `parameters` can run
+ * concurrently, one per thread. It is an error for `run_net` to write to a
+ * shared blob, and the run net is not optimized since optimization passes
+ * may rewrite parameters in place.
+ */
+CAFFE2_API PredictorConfig makeSharedPredictorConfig(
+    std::shared_ptr<Workspace> parameters,
+    const NetDef& run_net);
+
 } // namespace caffe2
@@ -205,4 +205,46 @@ TEST_F(PredictorTest, SimpleBatchSizedMapInput) {
   EXPECT_NEAR(output.front().data<float>()[4], 0.1209, 1E-4);
 }
 
+TEST_F(PredictorTest, SharedParameters) {
+  auto parameters = makeSharedParameterWorkspace(parseNetDef(initSpec));
+  Predictor p1(makeSharedPredictorConfig(parameters, parseNetDef(predictSpec)));
+  Predictor p2(makeSharedPredictorConfig(parameters, parseNetDef(predictSpec)));
+
+  auto inputData = randomTensor({1, 4}, ctx_.get());
+  Predictor::TensorList input;
+  auto tensor = BlobGetMutableTensor(inputData.get(), CPU);
+  input.emplace_back(tensor->Alias());
+  Predictor::TensorList output1, output2;
+  p1(input, &output1);
+  p2(input, &output2);
+  EXPECT_EQ(output1.size(), 1);
+  EXPECT_EQ(output2.size(), 1);
+  EXPECT_NEAR(output1.front().data<float>()[4], 0.1209, 1E-4);
+  EXPECT_NEAR(output2.front().data<float>()[4], 0.1209, 1E-4);
+  EXPECT_NE(output1.front().data<float>(), output2.front().data<float>());
+
+  // W is 10x4 and b is 10 floats
+  const size_t parameterBytes = (10 * 4 + 10) * sizeof(float);
+  EXPECT_EQ(p1.sharedBytes(), parameterBytes);
+  EXPECT_EQ(p2.sharedBytes(), parameterBytes);
+  EXPECT_FALSE(p1.ws()->LocalBlobs().empty());
+  for (const auto& name : p1.ws()->LocalBlobs()) {
+    EXPECT_NE(name, "W");
+    EXPECT_NE(name, "b");
+  }
+  // A predictor with its own copy of the parameters owns them on top of
+  // the same inputs and activations
+  Predictor::TensorList output;
+  (*p_)(input, &output);
+  EXPECT_EQ(p_->sharedBytes(), 0);
+  EXPECT_EQ(p_->ownedBytes(), p1.ownedBytes() + parameterBytes);
+}
+
+TEST_F(PredictorTest, SharedParametersAreReadOnly) {
+  auto parameters = makeSharedParameterWorkspace(parseNetDef(initSpec));
+  auto run = parseNetDef(predictSpec);
+  run.mutable_op(0)->set_output(0, "W");
+  ASSERT_THROW(makeSharedPredictorConfig(parameters, run), EnforceNotMet);
+}
+
 } // namespace caffe2
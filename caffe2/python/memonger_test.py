@@ -152,6 +152,37 @@ class MemongerTest(hu.HypothesisTestCase):
         for op in optimized_net.op:
             self.assertEqual(len(op.output), len(set(op.output)), str(op))
 
+    @given(net_type=st.sampled_from(["dag", "async_scheduling", "parallel"]))
+    def test_fast_memonger_concurrent_net(self, net_type):
+        net = core.Net("towers")
+        net.Proto().type = net_type
+        towers = []
+        for t in range(2):
+            blob = "data"
+            for i in range(4):
+                blob = net.Relu(blob, "tower{}_relu{}".format(t, i))
+            towers.append(blob)
+        net.Sum(towers, "out")
+        net.Proto().external_input.append("data")
+        net.Proto().external_output.append("out")
+
+        optimized_net = memonger.optimize_inference_fast(net.Proto(), [])
+        self.assertLess(count_blobs(optimized_net), count_blobs(net.Proto()))
+        # The towers may run concurrently, so they can't share blobs
+        tower_blobs = [
+            set(o for op in optimized_net.op[t * 4:(t + 1) * 4]
+                for o in op.output)
+            for t in range(2)
+        ]
+        self.assertFalse(tower_blobs[0] & tower_blobs[1])
+
+        data = np.random.randn(4, 3).astype(np.float32)
+        workspace.FeedBlob("data", data)
+        workspace.RunNetOnce(net)
+        out = workspace.FetchBlob("out")
+        workspace.RunNetOnce(optimized_net)
+        np.testing.assert_almost_equal(out, workspace.FetchBlob("out"))
+
     @given(input_dim=st.integers(min_value=1, max_value=4),
            output_dim=st.integers(min_value=1, max_value=4),
            batch_size=st.integers(min_value=1, max_value=4))
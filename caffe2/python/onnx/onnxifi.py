@@ -24,9 +24,15 @@ def onnxifi_caffe2_net(
         debug=False,
         use_onnx=True,
         adjust_batch=True,
-        black_list=None):
+        black_list=None,
+        use_max_bound_buffers=False):
     """
     Transform the caffe2_net by collapsing ONNXIFI-runnable nodes into Onnxifi c2 ops
+
+    With use_max_bound_buffers, the Onnxifi ops allocate their inputs and
+    outputs once at the bound shapes (max_batch_size, max_seq_size), copy the
+    real batches into them and cut the outputs to the real batch sizes, so
+    that the backend binds them once.
     """
     shape_hints = {}
     for k, v in input_shapes.items():
@@ -38,7 +44,8 @@ def onnxifi_caffe2_net(
                              max_seq_size,
                              adjust_batch,
                              debug,
-                             use_onnx)
+                             use_onnx,
+                             use_max_bound_buffers)
     pred_net_cut = caffe2_pb2.NetDef()
     pred_net_cut.ParseFromString(pred_net_str)
     return pred_net_cut
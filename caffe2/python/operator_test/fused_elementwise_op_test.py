@@ -0,0 +1,88 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.python import core
+from hypothesis import given
+import caffe2.python.hypothesis_test_util as hu
+import hypothesis.strategies as st
+import numpy as np
+
+
+def _sigmoid(x):
+    return 1.0 / (1.0 + np.exp(-x))
+
+
+class TestFusedElementwiseOp(hu.HypothesisTestCase):
+
+    @given(n=st.integers(1, 40), d=st.integers(1, 100), **hu.gcs_cpu_only)
+    def test_chain(self, n, d, gc, dc):
+        X = np.random.randn(n, d).astype(np.float32)
+        A = np.random.randn(d).astype(np.float32)
+        B = np.random.randn(1).astype(np.float32)
+
+        # sigmoid(B - X * A) + A
+        op = core.CreateOperator(
+            "FusedElementwise",
+            ["X", "A", "B"],
+            ["Y"],
+            ops=["Mul", "Sub", "Sigmoid", "Add"],
+            operands=[1, 2, -1, 1],
+            operand_first=[0, 1, 0, 0],
+        )
+
+        def ref(X, A, B):
+            return [_sigmoid(B - X * A) + A]
+
+        self.assertReferenceChecks(gc, op, [X, A, B], ref)
+
+    @given(n=st.integers(1, 3000), **hu.gcs_cpu_only)
+    def test_unary_chain(self, n, gc, dc):
+        X = np.random.rand(n).astype(np.float32) + 0.5
+
+        op = core.CreateOperator(
+            "FusedElementwise",
+            ["X"],
+            ["X"],
+            ops=["Sqrt", "Log", "Negative", "Tanh", "Abs", "Relu"],
+            operands=[-1] * 6,
+            operand_first=[0] * 6,
+        )
+
+        def ref(X):
+            return [np.maximum(np.abs(np.tanh(-np.log(np.sqrt(X)))), 0)]
+
+        self.assertReferenceChecks(gc, op, [X], ref)
+
+    @given(n=st.integers(1, 10),
+           k=st.integers(1, 10),
+           m=st.integers(1, 10),
+           activation=st.sampled_from(["Relu", "Sigmoid", "Tanh"]),
+           **hu.gcs_cpu_only)
+    def test_fc_activation(self, n, k, m, activation, gc, dc):
+        X = np.random.randn(n, k).astype(np.float32)
+        W = np.random.randn(m, k).astype(np.float32)
+        b = np.random.randn(m).astype(np.float32)
+
+        op = core.CreateOperator(
+            "FCActivation",
+            ["X", "W", "b"],
+            ["Y"],
+            activation=activation,
+        )
+
+        def ref(X, W, b):
+            Y = X.dot(W.T) + b
+            if activation == "Relu":
+                return [np.maximum(Y, 0)]
+            if activation == "Sigmoid":
+                return [_sigmoid(Y)]
+            return [np.tanh(Y)]
+
+        self.assertReferenceChecks(gc, op, [X, W, b], ref)
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
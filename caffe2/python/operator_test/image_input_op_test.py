@@ -237,7 +237,8 @@ def create_test(output_dir, width, height, default_bound, minsize, crop, means,
 
 def run_test(
         size_tuple, means, stds, label_type, num_labels, is_test, scale_jitter_type,
-        color_jitter, color_lighting, dc, validator, output1=None, output2_size=None):
+        color_jitter, color_lighting, dc, validator, output1=None, output2_size=None,
+        order="NHWC", reduced_decode=0):
     # TODO: Does not test on GPU and does not test use_gpu_transform
     # WARNING: Using ModelHelper automatically does NHWC to NCHW
     # transformation if needed.
@@ -300,7 +301,9 @@ def run_test(
                 output_sizes=output_sizes,
                 scale_jitter_type=scale_jitter_type,
                 color_jitter=color_jitter,
-                color_lighting=color_lighting
+                color_lighting=color_lighting,
+                order=order,
+                reduced_decode=reduced_decode
             )
 
             imageop.device_option.CopyFrom(device_option)
@@ -320,12 +323,13 @@ def run_test(
 class TestImport(hu.HypothesisTestCase):
     def validate_image_and_label(
             self, expected_images, device_option, count_images, label_type,
-            is_test, scale_jitter_type, color_jitter, color_lighting):
+            is_test, scale_jitter_type, color_jitter, color_lighting,
+            order="NHWC"):
         l = workspace.FetchBlob('label')
         result = workspace.FetchBlob('data').astype(np.int32)
-        # If we don't use_gpu_transform, the output is in NHWC
-        # Our reference output is CHW so we swap
-        if device_option.device_type != 1:
+        # If we don't use_gpu_transform, the output is in the requested order
+        # Our reference output is CHW so we swap for NHWC
+        if device_option.device_type != 1 and order == "NHWC":
             expected = [img.swapaxes(0, 1).swapaxes(1, 2) for
                         (img, _, _, _) in expected_images]
         else:
@@ -427,6 +431,40 @@ class TestImport(hu.HypothesisTestCase):
             validator, output1, output2_size)
     # End test_imageinput
 
+    @given(size_tuple=st.tuples(
+        st.integers(min_value=8, max_value=4096),
+        st.integers(min_value=8, max_value=4096)).flatmap(lambda t: st.tuples(
+            st.just(t[0]), st.just(t[1]),
+            st.just(min(t[0] - 6, t[1] - 4)),
+            st.integers(min_value=1, max_value=min(t[0] - 6, t[1] - 4)))),
+        means=st.tuples(st.integers(min_value=0, max_value=255),
+                        st.integers(min_value=0, max_value=255),
+                        st.integers(min_value=0, max_value=255)),
+        stds=st.tuples(st.floats(min_value=1, max_value=10),
+                       st.floats(min_value=1, max_value=10),
+                       st.floats(min_value=1, max_value=10)),
+        is_test=st.integers(min_value=0, max_value=1),
+        color_jitter=st.integers(min_value=0, max_value=1),
+        color_lighting=st.integers(min_value=0, max_value=1),
+        reduced_decode=st.integers(min_value=0, max_value=1),
+        **hu.gcs_cpu_only)
+    @settings(verbosity=Verbosity.verbose)
+    def test_imageinput_nchw(
+            self, size_tuple, means, stds, is_test, color_jitter,
+            color_lighting, reduced_decode, gc, dc):
+        # reduced_decode is a no-op with minsize and bounding boxes, so the
+        # output must match exactly
+        def validator(expected_images, device_option, count_images):
+            self.validate_image_and_label(
+                expected_images, device_option, count_images, 0,
+                is_test, 0, color_jitter, color_lighting, order="NCHW")
+        # End validator
+        run_test(
+            size_tuple, means, stds, 0, 1, is_test, 0, color_jitter,
+            color_lighting, dc, validator, order="NCHW",
+            reduced_decode=reduced_decode)
+    # End test_imageinput_nchw
+
 
 if __name__ == '__main__':
     import unittest
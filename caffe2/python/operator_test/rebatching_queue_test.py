@@ -77,6 +77,74 @@ class TestReBatchingQueue(TestCase):
             workspace.FetchBlob(results[1]), workspace.FetchBlob("tensors")[5:]
         )
 
+    def test_rebatching_queue_dequeue_across_batches(self):
+        net = core.Net('net')
+        workspace.FeedBlob(
+            "first", np.arange(12, dtype=np.float32).reshape(4, 3)
+        )
+        workspace.FeedBlob(
+            "second", np.arange(12, 24, dtype=np.float32).reshape(4, 3)
+        )
+
+        queue = net.CreateRebatchingQueue([], 1, capacity=10, num_blobs=1)
+
+        net.EnqueueRebatchingQueue([queue, "first"], [], enqueue_batch=True)
+        net.EnqueueRebatchingQueue([queue, "second"], [], enqueue_batch=True)
+        # The queue holds its own copy of the enqueued batches
+        net.Scale("first", "first", scale=0.0)
+
+        # Within the first batch, across both and within the second one
+        results = [
+            net.DequeueRebatchingQueue([queue], 1, num_elements=3),
+            net.DequeueRebatchingQueue([queue], 1, num_elements=3),
+            net.DequeueRebatchingQueue([queue], 1, num_elements=2),
+        ]
+
+        workspace.RunNetOnce(net)
+
+        expected = np.arange(24, dtype=np.float32).reshape(8, 3)
+        npt.assert_array_equal(workspace.FetchBlob(results[0]), expected[:3])
+        npt.assert_array_equal(workspace.FetchBlob(results[1]), expected[3:6])
+        npt.assert_array_equal(workspace.FetchBlob(results[2]), expected[6:])
+
+    def test_rebatching_queue_variable_length(self):
+        net = core.Net('net')
+        lengths = np.array([2, 0, 3, 1], dtype=np.int32)
+        values = np.arange(12, dtype=np.int64).reshape(6, 2)
+        workspace.FeedBlob("lengths", lengths)
+        workspace.FeedBlob("values", values)
+        workspace.FeedBlob("length", np.array([2], dtype=np.int32))
+        workspace.FeedBlob("value", np.array([[12, 13], [14, 15]], np.int64))
+
+        queue = net.CreateRebatchingQueue(
+            [], 1, capacity=10, num_blobs=2, variable_length=True
+        )
+
+        net.EnqueueRebatchingQueue(
+            [queue, "lengths", "values"], [], enqueue_batch=True
+        )
+        net.EnqueueRebatchingQueue([queue, "length", "value"], [])
+
+        results = [
+            net.DequeueRebatchingQueue([queue], 2, num_elements=3),
+            net.DequeueRebatchingQueue([queue], 2, num_elements=2),
+        ]
+
+        workspace.RunNetOnce(net)
+
+        first_lengths, first_values = (
+            workspace.FetchBlob(blob) for blob in results[0]
+        )
+        npt.assert_array_equal(first_lengths, [2, 0, 3])
+        npt.assert_array_equal(first_values, values[:5])
+        second_lengths, second_values = (
+            workspace.FetchBlob(blob) for blob in results[1]
+        )
+        npt.assert_array_equal(second_lengths, [1, 2])
+        npt.assert_array_equal(
+            second_values, np.arange(10, 16, dtype=np.int64).reshape(3, 2)
+        )
+
     def test_rebatching_queue_closes_properly(self):
         net = core.Net('net')
         workspace.FeedBlob(
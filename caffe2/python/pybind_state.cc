@@ -1681,7 +1681,8 @@ void addGlobalMethods(py::module& m) {
          int max_seq_size,
          bool adjust_batch,
          bool debug_builder,
-         bool use_onnx) -> py::bytes {
+         bool use_onnx,
+         bool use_max_bound_buffers) -> py::bytes {
         caffe2::NetDef pred_net;
         CAFFE_ENFORCE(
             ParseProtoFromLargeString(
@@ -1698,6 +1699,7 @@ void addGlobalMethods(py::module& m) {
         opts.adjust_batch = adjust_batch;
         opts.debug = debug_builder;
         opts.use_onnx = use_onnx;
+        opts.use_max_bound_buffers = use_max_bound_buffers;
         OnnxifiTransformer ts(opts);
         Workspace* curr_ws = GetCurrentWorkspace();
         std::unordered_set<int> blacklist_set(
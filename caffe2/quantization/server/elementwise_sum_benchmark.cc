@@ -3,6 +3,7 @@
 #include <iostream>
 #include <vector>
 
+#include "caffe2/utils/cpuid.h"
 #include "utility_dnnlowp_ops.h"
 
 using namespace std;
@@ -30,7 +31,32 @@ int main(int argc, const char* argv[]) {
       33);
   double dt = chrono::duration<double>(chrono::system_clock::now() - t).count();
   double bytes = 3. * LEN * sizeof(a[0]);
-  cout << bytes / dt / 1e9 << " GB/s" << endl;
+  cout << "AVX2 " << bytes / dt / 1e9 << " GB/s" << endl;
+
+  if (caffe2::GetCpuId().avx512f()) {
+    t = chrono::system_clock::now();
+    caffe2::internal::ElementWiseSumAVX512<false>(
+        a.data(),
+        b.data(),
+        c_avx512.data(),
+        a.size(),
+        1.0f,
+        11,
+        2.0f,
+        22,
+        3.0f,
+        33);
+    dt = chrono::duration<double>(chrono::system_clock::now() - t).count();
+    cout << "AVX512 " << bytes / dt / 1e9 << " GB/s" << endl;
+
+    for (int i = 0; i < LEN; ++i) {
+      if (c_avx2[i] != c_avx512[i]) {
+        cerr << "AVX512 result " << int(c_avx512[i]) << " != AVX2 result "
+             << int(c_avx2[i]) << " at " << i << endl;
+        return 1;
+      }
+    }
+  }
 
   return 0;
 }
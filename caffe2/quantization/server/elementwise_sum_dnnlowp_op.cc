@@ -72,7 +72,8 @@ bool SumDNNLowPOp<T, ReluFused>::RunOnDevice() {
   if (InputTensorCPU_(0).template IsType<T>()) {
     if (InputSize() == 2 && is_same<T, uint8_t>::value && GetCpuId().avx2() &&
         GetCpuId().fma()) {
-      // fast path when we have 2 uint8_t inputs with AVX2 / FMA support
+      // fast path when we have 2 uint8_t inputs with AVX2 / FMA support,
+      // using AVX-512 when available
       array<const T*, 2> input_data;
       for (int i = 0; i < 2; ++i) {
         input_data[i] = InputTensorCPU_(i).template data<T>();
@@ -82,22 +83,37 @@ bool SumDNNLowPOp<T, ReluFused>::RunOnDevice() {
 #pragma omp parallel
 #endif
       {
-        constexpr int VLEN = 8;
+        const bool use_avx512 = GetCpuId().avx512f();
+        const int VLEN = use_avx512 ? 16 : 8;
         int j_begin, j_end;
         tie(j_begin, j_end) = Get1DPartition(
             len, dnnlowp_get_num_threads(), dnnlowp_get_thread_num(), VLEN);
 
-        internal::ElementWiseSumAVX2<T, ReluFused>(
-            input_data[0] + j_begin,
-            input_data[1] + j_begin,
-            output_data + j_begin,
-            j_end - j_begin,
-            in_qparams_[0].scale,
-            in_qparams_[0].zero_point,
-            in_qparams_[1].scale,
-            in_qparams_[1].zero_point,
-            out_qparams_.scale,
-            out_qparams_.zero_point);
+        if (use_avx512) {
+          internal::ElementWiseSumAVX512<ReluFused>(
+              reinterpret_cast<const uint8_t*>(input_data[0] + j_begin),
+              reinterpret_cast<const uint8_t*>(input_data[1] + j_begin),
+              reinterpret_cast<uint8_t*>(output_data + j_begin),
+              j_end - j_begin,
+              in_qparams_[0].scale,
+              in_qparams_[0].zero_point,
+              in_qparams_[1].scale,
+              in_qparams_[1].zero_point,
+              out_qparams_.scale,
+              out_qparams_.zero_point);
+        } else {
+          internal::ElementWiseSumAVX2<T, ReluFused>(
+              input_data[0] + j_begin,
+              input_data[1] + j_begin,
+              output_data + j_begin,
+              j_end - j_begin,
+              in_qparams_[0].scale,
+              in_qparams_[0].zero_point,
+              in_qparams_[1].scale,
+              in_qparams_[1].zero_point,
+              out_qparams_.scale,
+              out_qparams_.zero_point);
+        }
       } // omp parallel
     } else {
       RequantizationParams in_requantization_params[InputSize()];
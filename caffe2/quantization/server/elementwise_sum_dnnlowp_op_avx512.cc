@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+namespace internal {
+
+using namespace std;
+
+constexpr int VLEN = 16;
+
+template <bool ReluFused>
+void ElementWiseSumAVX512(
+    const uint8_t* input0,
+    const uint8_t* input1,
+    uint8_t* output,
+    int len,
+    float a_scale,
+    int32_t a_zero_point,
+    float b_scale,
+    int32_t b_zero_point,
+    float c_scale,
+    int32_t c_zero_point) {
+  const __m512 a_scale_v = _mm512_set1_ps(a_scale);
+  const __m512 b_scale_v = _mm512_set1_ps(b_scale);
+  const __m512 zero_point_v =
+      _mm512_set1_ps(-a_zero_point * a_scale - b_zero_point * b_scale);
+  const __m512 c_scale_inv_v = _mm512_set1_ps(1.0 / c_scale);
+  const __m512 c_zero_point_v = _mm512_set1_ps(c_zero_point);
+  const __m512i min_v = _mm512_set1_epi32(ReluFused ? c_zero_point : 0);
+  const __m512i max_v = _mm512_set1_epi32(255);
+
+  int len_aligned = len / (VLEN * 4) * (VLEN * 4);
+  int j = 0;
+  for (; j < len_aligned; j += VLEN * 4) {
+    // Unlike AVX2, AVX-512 zero extends uint8_t directly, and the 4 vectors
+    // are clamped and narrowed separately, so no permutation is needed
+    for (int k = 0; k < 4; ++k) {
+      __m512 in_v0 = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(input0 + j + k * VLEN))));
+      __m512 in_v1 = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(input1 + j + k * VLEN))));
+      __m512 acc_v = _mm512_fmadd_ps(
+          in_v1, b_scale_v, _mm512_fmadd_ps(in_v0, a_scale_v, zero_point_v));
+      __m512 transformed_v =
+          _mm512_fmadd_ps(acc_v, c_scale_inv_v, c_zero_point_v);
+
+      __m512i rounded_v = _mm512_cvtps_epi32(transformed_v);
+      __m512i clamped_v =
+          _mm512_min_epi32(max_v, _mm512_max_epi32(min_v, rounded_v));
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(output + j + k * VLEN),
+          _mm512_cvtepi32_epi8(clamped_v));
+    }
+  }
+  for (; j < len; ++j) {
+    float acc = 0;
+    acc += (input0[j] - a_zero_point) * a_scale;
+    acc += (input1[j] - b_zero_point) * b_scale;
+    float transformed_val = c_zero_point + acc / c_scale;
+    output[j] = std::max(
+        ReluFused ? c_zero_point : 0.0f,
+        std::min(255.0f, nearbyint(transformed_val)));
+  }
+}
+
+template void ElementWiseSumAVX512<false>(
+    const uint8_t* input0,
+    const uint8_t* input1,
+    uint8_t* output,
+    int len,
+    float a_scale,
+    int32_t a_zero_point,
+    float b_scale,
+    int32_t b_zero_point,
+    float c_scale,
+    int32_t c_zero_point);
+
+template void ElementWiseSumAVX512<true>(
+    const uint8_t* input0,
+    const uint8_t* input1,
+    uint8_t* output,
+    int len,
+    float a_scale,
+    int32_t a_zero_point,
+    float b_scale,
+    int32_t b_zero_point,
+    float c_scale,
+    int32_t c_zero_point);
+
+} // namespace internal
+
+} // namespace caffe2
@@ -105,6 +105,19 @@ void ElementWiseSumAVX2(
     float c_scale,
     int32_t c_zero_points);
 
+template <bool ReluFused>
+void ElementWiseSumAVX512(
+    const uint8_t* input0,
+    const uint8_t* input1,
+    uint8_t* output,
+    int len,
+    float a_scale,
+    int32_t a_zero_point,
+    float b_scale,
+    int32_t b_zero_point,
+    float c_scale,
+    int32_t c_zero_point);
+
 }
 
 } // namespace caffe2
@@ -304,6 +304,67 @@ def swap_concat_relu(net, ignore_op_with_output=None):
         net = next_net
 
 
+def remove_first_dequantize(net):
+    """
+    Removes a Dequantize op whose output is only used by DNNLOWP ops, which
+    then take its quantized input as it is instead of quantizing the fp32
+    tensor again. Quantize ops among the users are removed too.
+    """
+    net = copy.deepcopy(net)
+
+    for i, op in enumerate(net.op):
+        if op.type != "Dequantize":
+            continue
+        quantized, dequantized = op.input[0], op.output[0]
+        if dequantized in net.external_output:
+            continue
+
+        uses = blob_uses(net, dequantized)
+        if not uses or any(
+            not net.op[j].engine.startswith("DNNLOWP")
+            or dequantized in net.op[j].control_input
+            for j in uses
+        ):
+            continue
+
+        renames = {dequantized: quantized}
+        removed = {i}
+        for j in uses:
+            if net.op[j].type == "Quantize":
+                renames[net.op[j].output[0]] = quantized
+                removed.add(j)
+        # The blobs must not be written by other ops, and the outputs of the
+        # removed Quantize ops must not be visible outside of the net
+        written = [
+            b for (k, o) in enumerate(net.op) if k not in removed for b in o.output
+        ]
+        if any(b in written or b in net.external_output for b in renames) or (
+            quantized in [b for o in net.op[i + 1 :] for b in o.output]
+        ):
+            continue
+
+        new_ops = []
+        for (k, o) in enumerate(net.op):
+            if k in removed:
+                continue
+            for (idx, b) in enumerate(o.input):
+                o.input[idx] = renames.get(b, b)
+            new_ops.append(o)
+        del net.op[:]
+        net.op.extend(new_ops)
+        break
+    return net
+
+
+def remove_dequantize(net):
+    # Run until we hit a fixed point
+    while True:
+        next_net = remove_first_dequantize(net)
+        if len(next_net.op) == len(net.op):
+            return next_net
+        net = next_net
+
+
 def add_version_to_conv_bias(net, init_net):
     """
     In architectures such as FPN (https://arxiv.org/abs/1612.03144), few Conv
@@ -1,95 +1,198 @@
 #include "rebatching_queue.h"
-#include "caffe2/utils/smart_tensor_printer.h"
 
 namespace caffe2 {
 
 namespace {
 
-// This concat function will always create a new first dimension to concat
+// Queue elements are views into a single copy of the enqueued batch, which
+// each view keeps alive through the context of its data pointer
+void deleteBatchReference(void* batch) {
+  delete static_cast<TensorCPU*>(batch);
+}
+
+// Returns a tensor of the given dims sharing the memory of batch at data
+TensorCPU makeView(
+    const TensorCPU& batch,
+    const std::vector<int64_t>& dims,
+    const void* data) {
+  TensorCPU view(dims, CPU);
+  const auto nbytes = view.numel() * batch.itemsize();
+  if (nbytes == 0) {
+    view.raw_mutable_data(batch.dtype());
+    return view;
+  }
+  view.ShareExternalPointer(
+      at::DataPtr(
+          const_cast<void*>(data),
+          new TensorCPU(batch.UnsafeSharedInstance()),
+          &deleteBatchReference,
+          at::Device(CPU)),
+      batch.dtype(),
+      nbytes);
+  return view;
+}
+
+// The batch `tensor` is a view into, nullptr if it isn't a view
+const TensorCPU* viewedBatch(const TensorCPU& tensor) {
+  if (!tensor.storage_initialized()) {
+    return nullptr;
+  }
+  const auto& dataPtr = tensor.storage().data_ptr();
+  if (dataPtr.get_deleter() != &deleteBatchReference) {
+    return nullptr;
+  }
+  return static_cast<const TensorCPU*>(dataPtr.get_context());
+}
+
+// Tries to make output a view of the tensors when they are adjacent views
+// into the same batch
+bool concatAsView(
+    const std::vector<const TensorCPU*>& tensors,
+    const std::vector<int64_t>& outputDims,
+    TensorCPU* output) {
+  const auto* batch = viewedBatch(*tensors[0]);
+  if (!batch) {
+    return false;
+  }
+  const char* end = static_cast<const char*>(tensors[0]->raw_data());
+  for (const auto* tensor : tensors) {
+    const auto* tensorBatch = viewedBatch(*tensor);
+    if (!tensorBatch ||
+        tensorBatch->getIntrusivePtr().get() !=
+            batch->getIntrusivePtr().get() ||
+        tensor->raw_data() != end) {
+      return false;
+    }
+    end += tensor->nbytes();
+  }
+  *output = makeView(*batch, outputDims, tensors[0]->raw_data());
+  return true;
+}
+
+// The fixed size concat always creates a new first dimension to concat, the
+// variable length one concatenates along the existing first dimension
 void concat(
     CPUContext& context,
     const std::vector<std::vector<TensorCPU>>& inputs,
-    const std::vector<TensorCPU*>& outputs) {
+    const std::vector<TensorCPU*>& outputs,
+    bool variableLength) {
   CAFFE_ENFORCE(!inputs.empty());
 
   const auto& inputZero = inputs[0];
   const auto numTensors = inputZero.size();
   const auto numRows = inputs.size();
 
-  // Precompute the output sizes to avoid resizing
-  std::vector<std::vector<int64_t>> outputDims(numTensors);
-
-  for (size_t i = 0; i < numTensors; ++i) {
-    SmartTensorPrinter::PrintTensor(inputZero.at(i));
-    outputDims[i] = inputZero.at(i).sizes().vec();
-    outputDims[i].insert(outputDims[i].begin(), numRows);
-  }
-
-  // Resize to the final output size
-  std::vector<void*> destinations(numTensors);
-  for (size_t i = 0; i < numTensors; ++i) {
-    outputs[i]->Resize(outputDims[i]);
-    destinations[i] = outputs[i]->raw_mutable_data(inputZero[i].meta());
-  }
-
   for (size_t i = 0; i < numRows; ++i) {
     CAFFE_ENFORCE_EQ(inputs[i].size(), numTensors);
+  }
 
-    for (int j = 0; j < numTensors; ++j) {
+  for (size_t j = 0; j < numTensors; ++j) {
+    std::vector<const TensorCPU*> tensors(numRows);
+    // Precompute the output size to avoid resizing
+    auto outputDims = inputZero[j].sizes().vec();
+    if (variableLength) {
+      CAFFE_ENFORCE(!outputDims.empty());
+      outputDims[0] = 0;
+    } else {
+      outputDims.insert(outputDims.begin(), 0);
+    }
+    for (size_t i = 0; i < numRows; ++i) {
       const auto& input = inputs[i][j];
-
       CAFFE_ENFORCE(inputZero[j].meta() == input.dtype());
       CAFFE_ENFORCE_EQ(inputZero[j].itemsize(), input.itemsize());
       CAFFE_ENFORCE_EQ(inputZero[j].ndim(), input.dim());
-      for (int k = 0; k < input.dim(); ++k) {
+      for (int k = variableLength ? 1 : 0; k < input.dim(); ++k) {
         CAFFE_ENFORCE_EQ(input.sizes()[k], inputZero[j].size(k));
       }
+      outputDims[0] += variableLength ? input.size(0) : 1;
+      tensors[i] = &input;
+    }
+
+    if (concatAsView(tensors, outputDims, outputs[j])) {
+      continue;
+    }
 
+    // Don't write into the memory of a batch a previous dequeue returned
+    if (viewedBatch(*outputs[j])) {
+      *outputs[j] = TensorCPU(CPU);
+    }
+    outputs[j]->Resize(outputDims);
+    auto* destination = outputs[j]->raw_mutable_data(inputZero[j].meta());
+    for (const auto* input : tensors) {
       // Skip empty tensors
-      if (input.numel() == 0) {
+      if (input->numel() == 0) {
         continue;
       }
 
       context.CopyItemsToCPU(
-          input.dtype(),
-          input.numel(),
-          input.raw_data() /* src */,
-          destinations[j] /* dst */
+          input->dtype(),
+          input->numel(),
+          input->raw_data() /* src */,
+          destination /* dst */
       );
 
-      destinations[j] =
-          (char*)destinations[j] + input.numel() * input.itemsize();
+      destination = (char*)destination + input->nbytes();
     }
   }
 }
 
+// Splits the inputs into queue elements, either along their first dimension
+// or, in variable length mode, into the number of rows given by inputs[0]
 std::vector<std::vector<TensorCPU>> split(
-    CPUContext& context,
-    const std::vector<const TensorCPU*>& inputs) {
+    const std::vector<const TensorCPU*>& inputs,
+    bool variableLength) {
   CAFFE_ENFORCE(!inputs.empty());
+  for (const auto* inputPtr : inputs) {
+    CAFFE_ENFORCE(inputPtr);
+    CAFFE_ENFORCE_GE(inputPtr->dim(), 1);
+  }
 
   const auto outputSize = inputs[0]->sizes().at(0);
   std::vector<std::vector<TensorCPU>> outputs(outputSize);
 
-  for (const auto* inputPtr : inputs) {
-    CAFFE_ENFORCE(inputPtr);
-
-    const auto& input = *inputPtr;
-    const auto innerSize = input.size_from_dim(1);
-    const auto itemSize = input.dtype().itemsize();
+  std::vector<int64_t> rowOffsets(outputSize + 1, 0);
+  if (variableLength) {
+    const auto& lengths = *inputs[0];
+    CAFFE_ENFORCE_EQ(lengths.dim(), 1, "LENGTHS must be a vector");
+    const auto* lengthsData = lengths.data<int32_t>();
+    for (int64_t i = 0; i < outputSize; ++i) {
+      CAFFE_ENFORCE_GE(lengthsData[i], 0);
+      rowOffsets[i + 1] = rowOffsets[i] + lengthsData[i];
+    }
+  }
 
-    auto outputDims = input.sizes().vec();
-    CAFFE_ENFORCE(!outputDims.empty());
-    outputDims.erase(outputDims.begin());
-    CAFFE_ENFORCE_EQ(input.sizes().at(0), outputSize);
+  for (size_t j = 0; j < inputs.size(); ++j) {
+    const auto& input = *inputs[j];
+    const bool byLengths = variableLength && j > 0;
+    // A single copy of the batch the elements are views into
+    const auto batch = input.Clone();
+    const auto innerSize = batch.size_from_dim(1);
+    const auto itemSize = batch.dtype().itemsize();
+    const char* data =
+        batch.numel() > 0 ? static_cast<const char*>(batch.raw_data()) : nullptr;
+
+    auto outputDims = batch.sizes().vec();
+    if (byLengths) {
+      CAFFE_ENFORCE_EQ(
+          batch.size(0),
+          rowOffsets.back(),
+          "Tensors must have as many rows as the sum of LENGTHS");
+    } else {
+      CAFFE_ENFORCE_EQ(batch.size(0), outputSize);
+      if (variableLength) {
+        outputDims[0] = 1;
+      } else {
+        outputDims.erase(outputDims.begin());
+      }
+    }
 
-    for (int i = 0; i < outputSize; ++i) {
-      outputs[i].push_back(Tensor(outputDims, CPU));
-      context.CopyItemsToCPU(
-          input.dtype(),
-          innerSize,
-          (char*)input.raw_data() + i * innerSize * itemSize /* src */,
-          outputs[i].back().raw_mutable_data(input.dtype()) /* dst */);
+    for (int64_t i = 0; i < outputSize; ++i) {
+      const auto begin = byLengths ? rowOffsets[i] : i;
+      if (byLengths) {
+        outputDims[0] = rowOffsets[i + 1] - rowOffsets[i];
+      }
+      outputs[i].push_back(
+          makeView(batch, outputDims, data + begin * innerSize * itemSize));
     }
   }
 
@@ -97,8 +200,14 @@ std::vector<std::vector<TensorCPU>> split(
 }
 } // anonymous namespace
 
-RebatchingQueue::RebatchingQueue(size_t capacity, size_t numBlobs)
-    : capacity_(capacity), numBlobs_(numBlobs), queue_(capacity) {}
+RebatchingQueue::RebatchingQueue(
+    size_t capacity,
+    size_t numBlobs,
+    bool variableLength)
+    : capacity_(capacity),
+      numBlobs_(numBlobs),
+      variableLength_(variableLength),
+      queue_(capacity) {}
 
 RebatchingQueue::~RebatchingQueue() {
   close();
@@ -146,7 +255,7 @@ bool RebatchingQueue::dequeue(
     return false;
   }
 
-  concat(context, results, outputs);
+  concat(context, results, outputs, variableLength_);
 
   return true;
 }
@@ -165,17 +274,30 @@ bool RebatchingQueue::enqueueOne(
   for (const auto* tensorPtr : inputs) {
     tensorVector.push_back(tensorPtr->Clone());
   }
+  if (variableLength_) {
+    // The length of a single element is a scalar or a vector of one value
+    auto& length = tensorVector.front();
+    CAFFE_ENFORCE_EQ(length.numel(), 1, "LENGTHS of one element");
+    length.Reshape(std::vector<int64_t>{1});
+    for (size_t i = 1; i < tensorVector.size(); ++i) {
+      CAFFE_ENFORCE_GE(tensorVector[i].dim(), 1);
+      CAFFE_ENFORCE_EQ(
+          tensorVector[i].size(0),
+          length.data<int32_t>()[0],
+          "Tensors must have as many rows as LENGTHS");
+    }
+  }
 
   return enqueue(std::move(splittedInputs));
 }
 
 bool RebatchingQueue::enqueueMany(
-    CPUContext& context,
+    CPUContext& /*context*/,
     const std::vector<const TensorCPU*>& inputs) {
   CAFFE_ENFORCE_EQ(numBlobs_, inputs.size());
 
   std::vector<std::vector<TensorCPU>> splittedInputs;
-  splittedInputs = split(context, inputs);
+  splittedInputs = split(inputs, variableLength_);
   return enqueue(std::move(splittedInputs));
 }
 
@@ -217,6 +339,10 @@ size_t RebatchingQueue::numBlobs() const {
   return numBlobs_;
 }
 
+bool RebatchingQueue::variableLength() const {
+  return variableLength_;
+}
+
 bool RebatchingQueue::isClosed() const {
   std::lock_guard<std::mutex> g(mutex_);
   return isClosed_;
@@ -17,9 +17,16 @@ namespace caffe2 {
 // atomic index + circular queue optimizations or pull something more
 // heavy-weight later
 
+// Elements enqueued as a batch are views into a single copy of the batch, and
+// dequeueing adjacent elements of the same batch returns views into it as well
+// instead of copying them.
+//
+// In variable length mode the first blob is LENGTHS, an int32 vector with a
+// length per element, and each element has that many rows of the other blobs.
+// Elements are dequeued by concatenating their rows, without padding.
 class RebatchingQueue {
  public:
-  RebatchingQueue(size_t capacity, size_t numBlobs);
+  RebatchingQueue(size_t capacity, size_t numBlobs, bool variableLength = false);
 
   ~RebatchingQueue();
 
@@ -40,6 +47,8 @@ class RebatchingQueue {
 
   size_t numBlobs() const;
 
+  bool variableLength() const;
+
   bool isClosed() const;
 
   void close();
@@ -52,6 +61,7 @@ class RebatchingQueue {
 
   const size_t capacity_;
   const size_t numBlobs_;
+  const bool variableLength_;
 
   mutable std::mutex mutex_;
 
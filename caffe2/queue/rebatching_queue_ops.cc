@@ -26,7 +26,12 @@ Creates the Queue.
     .Arg("num_blobs", "Number of input tensors the queue will support")
     .Arg(
         "capacity",
-        "Maximal number of elements the queue can hold at any given point");
+        "Maximal number of elements the queue can hold at any given point")
+    .Arg(
+        "variable_length",
+        "If set, the first tensor is LENGTHS, an int32 vector giving the "
+        "number of rows of the other tensors in each element. Dequeueing "
+        "concatenates the rows of the elements instead of stacking them.");
 
 OPERATOR_SCHEMA(CloseRebatchingQueue)
     .NumInputs(1)
@@ -62,6 +67,8 @@ Dequeue Tensors from the Queue.
 If the Queue is closed this might return less elements than asked.
 If num_elements > 1 the returned elements will be concatenated into one
 tensor per component.
+Elements that were enqueued together in one batch are returned as views into
+the enqueued data instead of being copied.
 )DOC")
     .Input(0, "rebatching_queue", "object representing the queue")
     .Input(1, "tensor", "First tensor to enqueue")
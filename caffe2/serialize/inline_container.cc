@@ -1,9 +1,11 @@
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <cerrno>
 #include <istream>
 #include <ostream>
 #include <fstream>
+#include <vector>
 
 #include <c10/core/Allocator.h>
 #include <c10/core/Backend.h>
@@ -17,6 +19,10 @@
 
 #include "miniz.h"
 
+#ifdef CAFFE2_USE_ZSTD
+#include <zstd.h>
+#endif
+
 namespace caffe2 {
 namespace serialize {
 
@@ -142,8 +148,13 @@ constexpr int MZ_ZIP_LOCAL_DIR_HEADER_SIZE = 30;
 constexpr int MZ_ZIP_LDH_FILENAME_LEN_OFS = 26;
 constexpr int MZ_ZIP_LDH_EXTRA_LEN_OFS = 28;
 
-static std::string getPadding(size_t cursor, const std::string& filename, size_t size) {
-  size_t start = cursor + MZ_ZIP_LOCAL_DIR_HEADER_SIZE + filename.size() + sizeof(mz_uint16) * 2;
+static std::string getPadding(
+    size_t cursor,
+    const std::string& filename,
+    size_t size,
+    size_t extra_size) {
+  size_t start = cursor + MZ_ZIP_LOCAL_DIR_HEADER_SIZE + filename.size() +
+      extra_size + sizeof(mz_uint16) * 2;
   if (size >= MZ_UINT32_MAX || cursor >= MZ_UINT32_MAX) {
     start += sizeof(mz_uint16) * 2;
     if (size >= MZ_UINT32_MAX) {
@@ -165,6 +176,145 @@ static std::string getPadding(size_t cursor, const std::string& filename, size_t
   return buf;
 }
 
+static void write_le(std::string& out, uint64_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i) {
+    out.push_back(static_cast<char>(value >> (8 * i)));
+  }
+}
+
+static uint64_t read_le(const uint8_t* buf, size_t bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes; ++i) {
+    value |= static_cast<uint64_t>(buf[i]) << (8 * i);
+  }
+  return value;
+}
+
+// the seek table of the zstd seekable format: a skippable frame holding the
+// compressed and decompressed size of every frame and a footer
+constexpr uint32_t kZstdSkippableMagic = 0x184D2A5E;
+constexpr uint32_t kZstdSeekableMagic = 0x8F92EAB1;
+constexpr size_t kZstdSeekTableFooterSize = 9;
+constexpr size_t kZstdSeekTableEntrySize = 8;
+constexpr size_t kZstdSkippableHeaderSize = 8;
+constexpr size_t kZstdExtraSize = 12;
+
+struct ZstdFrame {
+  size_t compressed_size;
+  size_t size;
+};
+
+// the size of the seek table ending with `footer`
+static size_t zstdSeekTableSize(const uint8_t* footer, const std::string& name) {
+  if (read_le(footer + 5, 4) != kZstdSeekableMagic) {
+    CAFFE_THROW("PytorchStreamReader failed reading file: invalid zstd seek table in ", name);
+  }
+  return kZstdSkippableHeaderSize +
+      read_le(footer, 4) * kZstdSeekTableEntrySize + kZstdSeekTableFooterSize;
+}
+
+static std::vector<ZstdFrame> parseZstdSeekTable(
+    const uint8_t* table,
+    size_t table_size,
+    const std::string& name) {
+  if (read_le(table, 4) != kZstdSkippableMagic ||
+      read_le(table + 4, 4) != table_size - kZstdSkippableHeaderSize) {
+    CAFFE_THROW("PytorchStreamReader failed reading file: invalid zstd seek table in ", name);
+  }
+  size_t num_frames = (table_size - kZstdSkippableHeaderSize -
+                       kZstdSeekTableFooterSize) / kZstdSeekTableEntrySize;
+  std::vector<ZstdFrame> frames(num_frames);
+  const uint8_t* entry = table + kZstdSkippableHeaderSize;
+  for (auto& frame : frames) {
+    frame.compressed_size = read_le(entry, 4);
+    frame.size = read_le(entry + 4, 4);
+    entry += kZstdSeekTableEntrySize;
+  }
+  return frames;
+}
+
+static void decompressZstdFrame(
+    const void* src,
+    const ZstdFrame& frame,
+    void* dst,
+    const std::string& name) {
+#ifdef CAFFE2_USE_ZSTD
+  size_t n = ZSTD_decompress(dst, frame.size, src, frame.compressed_size);
+  if (ZSTD_isError(n)) {
+    CAFFE_THROW("PytorchStreamReader failed decompressing ", name, ": ", ZSTD_getErrorName(n));
+  }
+  if (n != frame.size) {
+    CAFFE_THROW("PytorchStreamReader failed decompressing ", name, ": unexpected frame size");
+  }
+#else
+  CAFFE_THROW("PytorchStreamReader can't read ", name, ", which is compressed with zstd: "
+              "PyTorch was built without zstd (USE_ZSTD)");
+#endif
+}
+
+static void decompressZstd(
+    const char* src,
+    size_t src_size,
+    char* dst,
+    size_t dst_size,
+    const std::string& name) {
+  if (src_size < kZstdSeekTableFooterSize) {
+    CAFFE_THROW("PytorchStreamReader failed reading file: invalid zstd seek table in ", name);
+  }
+  const uint8_t* end = reinterpret_cast<const uint8_t*>(src) + src_size;
+  size_t table_size = zstdSeekTableSize(end - kZstdSeekTableFooterSize, name);
+  if (table_size > src_size) {
+    CAFFE_THROW("PytorchStreamReader failed reading file: invalid zstd seek table in ", name);
+  }
+  size_t in = 0;
+  size_t out = 0;
+  for (const auto& frame : parseZstdSeekTable(end - table_size, table_size, name)) {
+    if (in + frame.compressed_size > src_size - table_size ||
+        out + frame.size > dst_size) {
+      CAFFE_THROW("PytorchStreamReader failed reading file: invalid zstd seek table in ", name);
+    }
+    decompressZstdFrame(src + in, frame, dst + out, name);
+    in += frame.compressed_size;
+    out += frame.size;
+  }
+  if (out != dst_size) {
+    CAFFE_THROW("PytorchStreamReader failed reading file: invalid zstd seek table in ", name);
+  }
+}
+
+// compresses `data` into frames of kZstdFrameSize bytes followed by the seek
+// table
+static std::string compressZstd(const void* data, size_t size, int level) {
+#ifdef CAFFE2_USE_ZSTD
+  std::string out;
+  std::string table;
+  const char* src = static_cast<const char*>(data);
+  for (size_t pos = 0; pos < size; pos += kZstdFrameSize) {
+    size_t n = std::min<size_t>(kZstdFrameSize, size - pos);
+    size_t start = out.size();
+    out.resize(start + ZSTD_compressBound(n));
+    size_t compressed = ZSTD_compress(&out[start], out.size() - start, src + pos, n, level);
+    if (ZSTD_isError(compressed)) {
+      CAFFE_THROW("PytorchStreamWriter failed compressing: ", ZSTD_getErrorName(compressed));
+    }
+    out.resize(start + compressed);
+    write_le(table, compressed, 4);
+    write_le(table, n, 4);
+  }
+  size_t num_frames = table.size() / kZstdSeekTableEntrySize;
+  write_le(out, kZstdSkippableMagic, 4);
+  write_le(out, table.size() + kZstdSeekTableFooterSize, 4);
+  out += table;
+  write_le(out, num_frames, 4);
+  // no checksums in the seek table, the zip entry has one
+  write_le(out, 0, 1);
+  write_le(out, kZstdSeekableMagic, 4);
+  return out;
+#else
+  CAFFE_THROW("PytorchStreamWriter was built without zstd (USE_ZSTD)");
+#endif
+}
+
 size_t PyTorchStreamReader::getFileID(const std::string& name) {
   std::stringstream ss;
   ss << archive_name_ << "/" << name;
@@ -176,18 +326,205 @@ size_t PyTorchStreamReader::getFileID(const std::string& name) {
   return result;
 }
 
+static at::DataPtr allocate(c10::Allocator* allocator, size_t n) {
+  if (allocator) {
+    return allocator->allocate(n);
+  }
+  void* ptr = malloc(n);
+  return at::DataPtr(ptr, ptr, free, at::kCPU);
+}
+
 // return dataptr, size
 std::tuple<at::DataPtr, size_t> PyTorchStreamReader::getRecord(const std::string& name) {
+  return getRecord(name, nullptr);
+}
+
+std::tuple<at::DataPtr, size_t> PyTorchStreamReader::getRecord(
+    const std::string& name,
+    c10::Allocator* allocator) {
+  std::unique_lock<std::mutex> guard(reader_lock_);
+  size_t key = getFileID(name);
+  mz_zip_archive_file_stat stat;
+  mz_zip_reader_file_stat(ar_.get(), key, &stat);
+  valid("retrieving file meta-data");
+  if (stat.m_method != 0 || stat.m_comp_size != stat.m_uncomp_size) {
+    at::DataPtr retval = allocate(allocator, stat.m_uncomp_size);
+    mz_zip_reader_extract_to_mem(ar_.get(), key, retval.get(), stat.m_uncomp_size, 0);
+    valid("reading file");
+    return std::make_tuple(std::move(retval), stat.m_uncomp_size);
+  }
+
+  // records that are stored uncompressed are read directly, or used in place
+  // if the reader holds the file in memory (their checksum is not verified
+  // then). records compressed with zstd are decompressed from there.
+  uint64_t zstd_size = 0;
+  size_t offset = getRecordOffset(key, &zstd_size);
+  at::DataPtr retval = in_->getDataPtr(offset, stat.m_uncomp_size);
+  if (retval) {
+    guard.unlock();
+  } else {
+    retval = allocate(zstd_size ? nullptr : allocator, stat.m_uncomp_size);
+    size_t n = in_->read(offset, retval.get(), stat.m_uncomp_size, "reading file");
+    guard.unlock();
+    if (n != stat.m_uncomp_size) {
+      CAFFE_THROW("PytorchStreamReader failed reading file: unexpected end of file reading ", name);
+    }
+
+    auto crc = mz_crc32(
+        MZ_CRC32_INIT,
+        static_cast<const unsigned char*>(retval.get()),
+        stat.m_uncomp_size);
+    if (crc != stat.m_crc32) {
+      CAFFE_THROW("PytorchStreamReader failed reading file: CRC-32 check failed for ", name);
+    }
+  }
+  if (zstd_size == 0) {
+    return std::make_tuple(std::move(retval), stat.m_uncomp_size);
+  }
+
+  at::DataPtr decompressed = allocate(allocator, zstd_size);
+  decompressZstd(
+      static_cast<const char*>(retval.get()),
+      stat.m_uncomp_size,
+      static_cast<char*>(decompressed.get()),
+      zstd_size,
+      name);
+  return std::make_tuple(std::move(decompressed), zstd_size);
+}
+
+std::function<size_t(char*, size_t)> PyTorchStreamReader::getRecordReader(
+    const std::string& name) {
+  std::unique_lock<std::mutex> guard(reader_lock_);
   size_t key = getFileID(name);
   mz_zip_archive_file_stat stat;
   mz_zip_reader_file_stat(ar_.get(), key, &stat);
   valid("retrieving file meta-data");
-  void * ptr = malloc(stat.m_uncomp_size);
-  mz_zip_reader_extract_to_mem(ar_.get(), key, ptr, stat.m_uncomp_size, 0);
-  valid("reading file");
+  bool stored = stat.m_method == 0 && stat.m_comp_size == stat.m_uncomp_size;
+  at::DataPtr data;
+  size_t offset = 0;
+  uint64_t zstd_size = 0;
+  if (stored) {
+    offset = getRecordOffset(key, &zstd_size);
+    data = in_->getDataPtr(offset, stat.m_uncomp_size);
+  }
+  if (!stored || data) {
+    // the record has to be decompressed by miniz, or is in memory already
+    guard.unlock();
+    size_t size = stat.m_uncomp_size;
+    if (!data || zstd_size) {
+      std::tie(data, size) = getRecord(name);
+    }
+    auto record = std::make_shared<at::DataPtr>(std::move(data));
+    size_t pos = 0;
+    return [record, size, pos](char* buf, size_t n) mutable {
+      n = std::min(n, size - pos);
+      memcpy(buf, static_cast<char*>(record->get()) + pos, n);
+      pos += n;
+      return n;
+    };
+  }
 
-  at::DataPtr retval(ptr, ptr, free, at::kCPU);
-  return std::make_tuple(std::move(retval), stat.m_uncomp_size);
+  if (zstd_size) {
+    return getZstdRecordReader(name, offset, stat.m_uncomp_size, stat.m_crc32);
+  }
+
+  size_t end = offset + stat.m_uncomp_size;
+  mz_ulong crc = MZ_CRC32_INIT;
+  mz_uint32 expected_crc = stat.m_crc32;
+  return [this, name, offset, end, crc, expected_crc](char* buf, size_t n) mutable {
+    n = std::min<size_t>(n, end - offset);
+    if (n == 0) {
+      return n;
+    }
+    {
+      std::lock_guard<std::mutex> guard(reader_lock_);
+      size_t read = in_->read(offset, buf, n, "reading file");
+      if (read != n) {
+        CAFFE_THROW("PytorchStreamReader failed reading file: unexpected end of file reading ", name);
+      }
+    }
+    offset += n;
+    crc = mz_crc32(crc, reinterpret_cast<const unsigned char*>(buf), n);
+    if (offset == end && crc != expected_crc) {
+      CAFFE_THROW("PytorchStreamReader failed reading file: CRC-32 check failed for ", name);
+    }
+    return n;
+  };
+}
+
+// called with reader_lock_ held, the returned function takes it to read
+// each frame
+std::function<size_t(char*, size_t)> PyTorchStreamReader::getZstdRecordReader(
+    const std::string& name,
+    size_t offset,
+    size_t size,
+    uint32_t expected_crc) {
+  if (size < kZstdSeekTableFooterSize) {
+    CAFFE_THROW("PytorchStreamReader failed reading file: invalid zstd seek table in ", name);
+  }
+  uint8_t footer[kZstdSeekTableFooterSize];
+  if (in_->read(offset + size - kZstdSeekTableFooterSize, footer,
+                kZstdSeekTableFooterSize, "reading zstd seek table") !=
+      kZstdSeekTableFooterSize) {
+    CAFFE_THROW("PytorchStreamReader failed reading file: unexpected end of file reading ", name);
+  }
+  size_t table_size = zstdSeekTableSize(footer, name);
+  if (table_size > size) {
+    CAFFE_THROW("PytorchStreamReader failed reading file: invalid zstd seek table in ", name);
+  }
+  auto table = std::make_shared<std::vector<uint8_t>>(table_size);
+  if (in_->read(offset + size - table_size, table->data(), table_size,
+                "reading zstd seek table") != table_size) {
+    CAFFE_THROW("PytorchStreamReader failed reading file: unexpected end of file reading ", name);
+  }
+  auto frames = std::make_shared<std::vector<ZstdFrame>>(
+      parseZstdSeekTable(table->data(), table_size, name));
+
+  size_t end = offset + size - table_size;
+  size_t frame = 0;
+  std::vector<char> compressed;
+  std::vector<char> buffer;
+  size_t pos = 0;
+  mz_ulong crc = MZ_CRC32_INIT;
+  return [this, name, offset, end, table, frames, frame, compressed, buffer,
+          pos, crc, expected_crc](char* buf, size_t n) mutable {
+    size_t copied = 0;
+    while (copied < n) {
+      if (pos == buffer.size()) {
+        if (frame == frames->size()) {
+          break;
+        }
+        const auto& next = (*frames)[frame++];
+        if (offset + next.compressed_size > end) {
+          CAFFE_THROW("PytorchStreamReader failed reading file: invalid zstd seek table in ", name);
+        }
+        compressed.resize(next.compressed_size);
+        {
+          std::lock_guard<std::mutex> guard(reader_lock_);
+          size_t read = in_->read(offset, compressed.data(), compressed.size(), "reading file");
+          if (read != compressed.size()) {
+            CAFFE_THROW("PytorchStreamReader failed reading file: unexpected end of file reading ", name);
+          }
+        }
+        offset += compressed.size();
+        crc = mz_crc32(crc, reinterpret_cast<const unsigned char*>(compressed.data()), compressed.size());
+        if (frame == frames->size()) {
+          crc = mz_crc32(crc, table->data(), table->size());
+          if (offset != end || crc != expected_crc) {
+            CAFFE_THROW("PytorchStreamReader failed reading file: CRC-32 check failed for ", name);
+          }
+        }
+        buffer.resize(next.size);
+        decompressZstdFrame(compressed.data(), next, buffer.data(), name);
+        pos = 0;
+      }
+      size_t m = std::min(n - copied, buffer.size() - pos);
+      memcpy(buf + copied, buffer.data() + pos, m);
+      copied += m;
+      pos += m;
+    }
+    return copied;
+  };
 }
 
 static int64_t read_le_16(uint8_t* buf) {
@@ -195,8 +532,18 @@ static int64_t read_le_16(uint8_t* buf) {
 }
 
 size_t PyTorchStreamReader::getRecordOffset(const std::string& name) {
+  std::lock_guard<std::mutex> guard(reader_lock_);
+  uint64_t zstd_size = 0;
+  size_t offset = getRecordOffset(getFileID(name), &zstd_size);
+  if (zstd_size) {
+    CAFFE_THROW("PytorchStreamReader: ", name, " is compressed with zstd, it can't be used in place");
+  }
+  return offset;
+}
+
+size_t PyTorchStreamReader::getRecordOffset(size_t file_id, uint64_t* zstd_size) {
   mz_zip_archive_file_stat stat;
-  mz_zip_reader_file_stat(ar_.get(), getFileID(name), &stat);
+  mz_zip_reader_file_stat(ar_.get(), file_id, &stat);
   valid("retriving file meta-data");
   uint8_t local_header[MZ_ZIP_LOCAL_DIR_HEADER_SIZE];
   in_->read(
@@ -206,7 +553,23 @@ size_t PyTorchStreamReader::getRecordOffset(const std::string& name) {
       "reading file header");
   size_t filename_len = read_le_16(local_header + MZ_ZIP_LDH_FILENAME_LEN_OFS);
   size_t extra_len = read_le_16(local_header + MZ_ZIP_LDH_EXTRA_LEN_OFS);
-  return stat.m_local_header_ofs + MZ_ZIP_LOCAL_DIR_HEADER_SIZE + filename_len + extra_len;
+  size_t extra_ofs = stat.m_local_header_ofs + MZ_ZIP_LOCAL_DIR_HEADER_SIZE + filename_len;
+  if (zstd_size) {
+    // look for the "ZS" field among the extra fields
+    *zstd_size = 0;
+    std::vector<uint8_t> extra(extra_len);
+    in_->read(extra_ofs, extra.data(), extra_len, "reading file header");
+    for (size_t pos = 0; pos + 4 <= extra_len;) {
+      size_t field_len = read_le_16(&extra[pos + 2]);
+      if (extra[pos] == 'Z' && extra[pos + 1] == 'S' &&
+          field_len == kZstdExtraSize - 4 && pos + kZstdExtraSize <= extra_len) {
+        *zstd_size = read_le(&extra[pos + 4], 8);
+        break;
+      }
+      pos += 4 + field_len;
+    }
+  }
+  return extra_ofs + extra_len;
 }
 
 
@@ -256,18 +619,78 @@ PyTorchStreamWriter::PyTorchStreamWriter(
 
   mz_zip_writer_init_v2(ar_.get(), 0, MZ_ZIP_FLAG_WRITE_ZIP64);
   valid("initializing archive");
+}
+
+void PyTorchStreamWriter::setCompression(const std::string& prefix, int level) {
+  AT_CHECK(
+      !version_written_,
+      "PytorchStreamWriter: compression must be set before writing records");
+#ifndef CAFFE2_USE_ZSTD
+  AT_CHECK(
+      level == 0,
+      "PytorchStreamWriter can't compress records: PyTorch was built without zstd (USE_ZSTD)");
+#endif
+  for (auto& compression : compression_) {
+    if (compression.first == prefix) {
+      compression.second = level;
+      return;
+    }
+  }
+  compression_.emplace_back(prefix, level);
+}
 
+// the version is written with the first record, once the compression of the
+// records is known
+void PyTorchStreamWriter::writeVersion() {
+  version_written_ = true;
+  bool compressed = false;
+  for (const auto& compression : compression_) {
+    compressed |= compression.second != 0;
+  }
   std::stringstream version;
-  version << kMaxSupportedFileFormatVersion << "\n";
-  writeRecord("version", version.str().c_str(), version.str().size());
+  version << (compressed ? kZstdFileFormatVersion : kMinSupportedFileFormatVersion) << "\n";
+  writeRecord("version", version.str().c_str(), version.str().size(), 0);
 }
 
 void PyTorchStreamWriter::writeRecord(const std::string& name, const void* data, size_t size) {
   AT_ASSERT(!finalized_);
+  if (!version_written_) {
+    writeVersion();
+  }
+  int level = 0;
+  size_t prefix_size = 0;
+  for (const auto& compression : compression_) {
+    if (compression.first.size() >= prefix_size &&
+        name.compare(0, compression.first.size(), compression.first) == 0) {
+      level = compression.second;
+      prefix_size = compression.first.size();
+    }
+  }
+  writeRecord(name, data, size, level);
+}
+
+void PyTorchStreamWriter::writeRecord(
+    const std::string& name,
+    const void* data,
+    size_t size,
+    int level) {
   std::stringstream ss;
   ss << archive_name_ << "/" << name;
   const std::string& full_name = ss.str();
-  std::string padding = getPadding(ar_->m_archive_size, full_name, size);
+  std::string compressed;
+  std::string extra;
+  if (level != 0 && size > 0) {
+    compressed = compressZstd(data, size, level);
+    if (compressed.size() < size) {
+      // zip extra encoding (key, size_of_extra_bytes, decompressed size)
+      extra = "ZS";
+      write_le(extra, kZstdExtraSize - 4, 2);
+      write_le(extra, size, 8);
+      data = compressed.data();
+      size = compressed.size();
+    }
+  }
+  extra += getPadding(ar_->m_archive_size, full_name, size, extra.size());
   uint32_t flags = 0;
   mz_zip_writer_add_mem_ex_v2(
       ar_.get(),
@@ -280,8 +703,8 @@ void PyTorchStreamWriter::writeRecord(const std::string& name, const void* data,
       0,
       0,
       nullptr,
-      padding.c_str(),
-      padding.size(),
+      extra.c_str(),
+      extra.size(),
       nullptr,
       0);
   valid("writing file");
@@ -289,6 +712,9 @@ void PyTorchStreamWriter::writeRecord(const std::string& name, const void* data,
 
 void PyTorchStreamWriter::writeEndOfFile() {
   AT_ASSERT(!finalized_);
+  if (!version_written_) {
+    writeVersion();
+  }
   finalized_ = true;
   mz_zip_writer_finalize_archive(ar_.get());
   mz_zip_writer_end(ar_.get());
@@ -6,6 +6,10 @@
 #include <istream>
 #include <ostream>
 #include <fstream>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 #include <c10/core/Allocator.h>
 #include <c10/core/Backend.h>
@@ -43,6 +47,13 @@ typedef struct mz_zip_archive mz_zip_archive;
 //    it is possible to mmap the entire file and get an aligned pointer to
 //    tensor data.
 // 3. We universally write in ZIP64 format for consistency.
+// 4. Records can be compressed with zstd (see setCompression). They are still
+//    stored entries for zip, holding independent zstd frames of at most
+//    kZstdFrameSize bytes of the record, followed by the seek table of the
+//    zstd seekable format, so that a record can be decompressed frame by
+//    frame. A "ZS" extra field of the local header holds the size of the
+//    record once decompressed. Archives with such records have version
+//    kZstdFileFormatVersion, so that older readers refuse them.
 
 // The PyTorchStreamReader also provides additional properties:
 // 1. It can read zip files that are created with common
@@ -51,6 +62,9 @@ typedef struct mz_zip_archive mz_zip_archive;
 // 2. It provides a getRecordOffset function which returns the offset into the
 //    raw file where file data lives. If the file was written with PyTorchStreamWriter
 //    it is guarenteed to be 64 byte aligned.
+// 3. It is safe to read records from several threads. Reads through the
+//    adapter are serialized, but checksums are verified and records are
+//    decompressed in parallel.
 
 // PyTorchReader/Writer handle checking the version number on the archive format
 // and ensure that all files are written to a archive_name directory so they
@@ -90,7 +104,7 @@ namespace caffe2 {
 namespace serialize {
 
 constexpr uint64_t kMinSupportedFileFormatVersion = 0x1L;
-constexpr uint64_t kMaxSupportedFileFormatVersion = 0x1L;
+constexpr uint64_t kMaxSupportedFileFormatVersion = 0x2L;
 
 // Writer-specific constants
 constexpr uint64_t kFileFormatVersion = 0x2L;
@@ -98,6 +112,12 @@ constexpr uint64_t kFileFormatVersion = 0x2L;
 // Writer-specific constants
 constexpr uint64_t kFieldAlignment = 64;
 
+// The version of archives with zstd compressed records
+constexpr uint64_t kZstdFileFormatVersion = 0x2L;
+
+// The uncompressed bytes of a record in each zstd frame
+constexpr uint64_t kZstdFrameSize = 1 << 22;
+
 class CAFFE2_API PyTorchStreamReader final {
  public:
   explicit PyTorchStreamReader(const std::string& file_name);
@@ -106,9 +126,21 @@ class CAFFE2_API PyTorchStreamReader final {
 
   // return dataptr, size
   std::tuple<at::DataPtr, size_t> getRecord(const std::string& name);
+  // like getRecord, but copies the record into memory from `allocator`
+  // (e.g. pinned memory), unless the adapter holds it in memory already
+  std::tuple<at::DataPtr, size_t> getRecord(
+      const std::string& name,
+      c10::Allocator* allocator);
 
+  // throws for records compressed with zstd, which can't be used in place
   size_t getRecordOffset(const std::string& name);
 
+  // returns a function that reads the next bytes of record `name` into a
+  // buffer and returns how many it read (0 at the end of the record), so
+  // that records can be consumed without holding them in memory at once.
+  // the function must not outlive the reader.
+  std::function<size_t(char*, size_t)> getRecordReader(const std::string& name);
+
   ~PyTorchStreamReader();
 
  private:
@@ -116,12 +148,22 @@ class CAFFE2_API PyTorchStreamReader final {
   size_t read(uint64_t pos, char* buf, size_t n);
   void valid(const char* what);
   size_t getFileID(const std::string& name);
+  // sets `zstd_size` to the decompressed size of a record compressed with
+  // zstd, or to 0
+  size_t getRecordOffset(size_t file_id, uint64_t* zstd_size = nullptr);
+  std::function<size_t(char*, size_t)> getZstdRecordReader(
+      const std::string& name,
+      size_t offset,
+      size_t size,
+      uint32_t expected_crc);
 
   friend size_t
   istream_read_func(void* pOpaque, uint64_t file_ofs, void* pBuf, size_t n);
   std::unique_ptr<mz_zip_archive> ar_;
   std::string archive_name_;
   std::unique_ptr<ReadAdapterInterface> in_;
+  // guards ar_ and in_
+  std::mutex reader_lock_;
 };
 
 class CAFFE2_API PyTorchStreamWriter final {
@@ -133,6 +175,12 @@ class CAFFE2_API PyTorchStreamWriter final {
   void writeRecord(const std::string& name, const void* data, size_t size);
   void writeEndOfFile();
 
+  // compresses the records whose name starts with `prefix` (e.g. "tensors/")
+  // with zstd at `level`, or stores them as is if `level` is 0. The longest
+  // matching prefix applies; records that don't shrink are stored anyway.
+  // must be called before the first record is written.
+  void setCompression(const std::string& prefix, int level);
+
   bool finalized() const {
     return finalized_;
   }
@@ -145,12 +193,20 @@ class CAFFE2_API PyTorchStreamWriter final {
 
  private:
    void valid(const char* what);
+   void writeVersion();
+   void writeRecord(
+       const std::string& name,
+       const void* data,
+       size_t size,
+       int level);
    size_t current_pos_ = 0;
    std::unique_ptr<mz_zip_archive> ar_;
    std::string archive_name_;
    std::ostream* out_;
    std::ofstream file_stream_;
    bool finalized_ = false;
+   bool version_written_ = false;
+   std::vector<std::pair<std::string, int>> compression_;
    friend size_t ostream_write_func(void *pOpaque, uint64_t file_ofs, const void *pBuf, size_t n);
 };
 
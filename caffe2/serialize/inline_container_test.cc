@@ -1,10 +1,14 @@
 #include <cstdio>
 #include <string>
 #include <array>
+#include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include "caffe2/core/common.h"
 #include "caffe2/serialize/inline_container.h"
+#include "caffe2/serialize/mmap_file_adapter.h"
 
 namespace caffe2 {
 namespace serialize {
@@ -58,6 +62,128 @@ TEST(PyTorchStreamWriterAndReader, SaveAndLoad) {
   ASSERT_EQ(memcmp(the_file.c_str() + off2, data2.data(), data2.size()), 0);
 }
 
+TEST(PyTorchStreamWriterAndReader, ReadFromManyThreads) {
+  constexpr int kNumRecords = 16;
+  std::ostringstream oss;
+  PyTorchStreamWriter writer(&oss);
+  for (int i = 0; i < kNumRecords; ++i) {
+    std::vector<char> data(1000 + i, static_cast<char>(i));
+    writer.writeRecord(c10::to_string(i), data.data(), data.size());
+  }
+  writer.writeEndOfFile();
+
+  std::istringstream iss(oss.str());
+  PyTorchStreamReader reader(&iss);
+  std::vector<std::thread> threads;
+  std::vector<int> ok(kNumRecords, 0);
+  for (int i = 0; i < kNumRecords; ++i) {
+    threads.emplace_back([&, i] {
+      at::DataPtr data_ptr;
+      size_t size;
+      std::tie(data_ptr, size) = reader.getRecord(c10::to_string(i));
+      std::vector<char> expected(1000 + i, static_cast<char>(i));
+      ok[i] = size == expected.size() &&
+          memcmp(data_ptr.get(), expected.data(), size) == 0;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < kNumRecords; ++i) {
+    ASSERT_TRUE(ok[i]) << "record " << i;
+  }
+}
+
+TEST(PyTorchStreamWriterAndReader, RecordReader) {
+  std::vector<char> data(1000);
+  for (int i = 0; i < data.size(); ++i) {
+    data[i] = i % 251;
+  }
+  std::ostringstream oss;
+  PyTorchStreamWriter writer(&oss);
+  writer.writeRecord("key", data.data(), data.size());
+  writer.writeEndOfFile();
+
+  std::istringstream iss(oss.str());
+  PyTorchStreamReader reader(&iss);
+  auto record_reader = reader.getRecordReader("key");
+  std::vector<char> result;
+  char buf[64];
+  while (size_t n = record_reader(buf, sizeof(buf))) {
+    result.insert(result.end(), buf, buf + n);
+  }
+  ASSERT_EQ(result, data);
+}
+
+#ifdef CAFFE2_USE_ZSTD
+TEST(PyTorchStreamWriterAndReader, ZstdCompressedRecords) {
+  // a few frames, the last one partial
+  std::vector<char> data(kZstdFrameSize * 2 + 1000);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = (i / 7) % 13;
+  }
+  std::ostringstream oss;
+  PyTorchStreamWriter writer(&oss);
+  writer.setCompression("tensors/", 3);
+  writer.setCompression("tensors/raw/", 0);
+  writer.writeRecord("tensors/0", data.data(), data.size());
+  writer.writeRecord("tensors/raw/0", data.data(), data.size());
+  writer.writeRecord("code/0", data.data(), data.size());
+  writer.writeEndOfFile();
+  ASSERT_ANY_THROW(writer.setCompression("code/", 3));
+  ASSERT_LT(oss.str().size(), 3 * data.size());
+
+  std::istringstream iss(oss.str());
+  PyTorchStreamReader reader(&iss);
+  for (const std::string name : {"tensors/0", "tensors/raw/0", "code/0"}) {
+    at::DataPtr data_ptr;
+    size_t size;
+    std::tie(data_ptr, size) = reader.getRecord(name);
+    ASSERT_EQ(size, data.size()) << name;
+    ASSERT_EQ(memcmp(data_ptr.get(), data.data(), size), 0) << name;
+
+    auto record_reader = reader.getRecordReader(name);
+    std::vector<char> result;
+    std::vector<char> buf(1 << 20);
+    while (size_t n = record_reader(buf.data(), buf.size())) {
+      result.insert(result.end(), buf.data(), buf.data() + n);
+    }
+    ASSERT_EQ(result, data) << name;
+  }
+  // compressed records can't be used in place
+  ASSERT_ANY_THROW(reader.getRecordOffset("tensors/0"));
+  ASSERT_EQ(reader.getRecordOffset("tensors/raw/0") % kFieldAlignment, 0);
+}
+#endif
+
+#ifndef _WIN32
+TEST(PyTorchStreamWriterAndReader, LoadMmapped) {
+  std::array<char, 127> data;
+  for (int i = 0; i < data.size(); ++i) {
+    data[i] = i;
+  }
+  {
+    PyTorchStreamWriter writer("mmapped.zip");
+    writer.writeRecord("key", data.data(), data.size());
+    writer.writeEndOfFile();
+  }
+
+  at::DataPtr data_ptr;
+  int64_t size;
+  {
+    PyTorchStreamReader reader(
+        caffe2::make_unique<MmapFileAdapter>("mmapped.zip"));
+    std::tie(data_ptr, size) = reader.getRecord("key");
+    // the record is used in place, so it is as aligned as it is in the file
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(data_ptr.get()) % kFieldAlignment, 0);
+  }
+  // the mapping outlives the reader
+  ASSERT_EQ(size, data.size());
+  ASSERT_EQ(memcmp(data_ptr.get(), data.data(), data.size()), 0);
+  std::remove("mmapped.zip");
+}
+#endif
+
 } // namespace
 } // namespace serialize
 } // namespace caffe2
@@ -0,0 +1,92 @@
+#include "caffe2/serialize/mmap_file_adapter.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <c10/util/Exception.h>
+
+namespace caffe2 {
+namespace serialize {
+
+struct MmapFileAdapter::Mapping {
+  Mapping(void* data, size_t size) : data(data), size(size) {}
+  ~Mapping() {
+#ifndef _WIN32
+    if (size > 0) {
+      munmap(data, size);
+    }
+#endif
+  }
+
+  void* data;
+  size_t size;
+};
+
+MmapFileAdapter::MmapFileAdapter(const std::string& file_name) {
+#ifdef _WIN32
+  AT_ERROR("MmapFileAdapter is not supported on Windows");
+#else
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    AT_ERROR(
+        "open file failed, file path: ", file_name, ": ", strerror(errno));
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    int err = errno;
+    close(fd);
+    AT_ERROR("fstat failed, file path: ", file_name, ": ", strerror(err));
+  }
+  const size_t size = st.st_size;
+  void* data = nullptr;
+  if (size > 0) {
+    data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      int err = errno;
+      close(fd);
+      AT_ERROR("mmap failed, file path: ", file_name, ": ", strerror(err));
+    }
+  }
+  // the mapping keeps its own reference to the file
+  close(fd);
+  mapping_ = std::make_shared<Mapping>(data, size);
+#endif
+}
+
+size_t MmapFileAdapter::size() const {
+  return mapping_->size;
+}
+
+size_t MmapFileAdapter::read(uint64_t pos, void* buf, size_t n, const char* what)
+    const {
+  if (pos >= mapping_->size) {
+    return 0;
+  }
+  n = std::min<size_t>(n, mapping_->size - pos);
+  memcpy(buf, static_cast<char*>(mapping_->data) + pos, n);
+  return n;
+}
+
+static void deleteMapping(void* ctx) {
+  delete static_cast<std::shared_ptr<void>*>(ctx);
+}
+
+at::DataPtr MmapFileAdapter::getDataPtr(uint64_t pos, size_t n) const {
+  AT_ASSERT(pos + n <= mapping_->size);
+  void* data = static_cast<char*>(mapping_->data) + pos;
+  auto ctx = new std::shared_ptr<void>(mapping_);
+  return at::DataPtr(data, ctx, deleteMapping, at::kCPU);
+}
+
+MmapFileAdapter::~MmapFileAdapter() {}
+
+} // namespace serialize
+} // namespace caffe2
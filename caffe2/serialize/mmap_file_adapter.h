@@ -0,0 +1,36 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "c10/macros/Macros.h"
+#include "caffe2/serialize/read_adapter_interface.h"
+
+namespace caffe2 {
+namespace serialize {
+
+// this is a reader that maps the whole file into memory. records that are
+// stored uncompressed are not copied: PyTorchStreamReader::getRecord returns
+// pointers into the mapping, which stays alive as long as any of them (or the
+// adapter) does. the mapping is private and copy-on-write, so processes that
+// load the same file share its pages through the page cache until they are
+// written to, and writes never reach the file.
+//
+// only supported on POSIX systems.
+class CAFFE2_API MmapFileAdapter final : public ReadAdapterInterface {
+ public:
+  C10_DISABLE_COPY_AND_ASSIGN(MmapFileAdapter);
+  explicit MmapFileAdapter(const std::string& file_name);
+  size_t size() const override;
+  size_t read(uint64_t pos, void* buf, size_t n, const char* what = "")
+      const override;
+  at::DataPtr getDataPtr(uint64_t pos, size_t n) const override;
+  ~MmapFileAdapter();
+
+ private:
+  struct Mapping;
+  std::shared_ptr<Mapping> mapping_;
+};
+
+} // namespace serialize
+} // namespace caffe2
@@ -1,6 +1,7 @@
 #include "caffe2/utils/threadpool/ThreadPool.h"
 #include "WorkersPool.h"
 #include "caffe2/core/logging.h"
+#include "c10/core/thread_budget.h"
 
 #include <cpuinfo.h>
 
@@ -73,6 +74,11 @@ std::unique_ptr<ThreadPool> ThreadPool::defaultThreadPool() {
         break;
     }
   }
+  // A process-wide thread budget, if set, overrides the per-core default so
+  // that this pool doesn't compete with the ATen and inter-op pools.
+  numThreads = c10::ThreadBudget::get().numThreads(
+      c10::ThreadPoolKind::Caffe2, numThreads);
+
   LOG(INFO) << "Constructing thread pool with " << numThreads << " threads";
   return caffe2::make_unique<ThreadPool>(numThreads);
 }
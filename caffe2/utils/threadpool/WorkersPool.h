@@ -3,6 +3,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <thread>
+#include "c10/core/thread_budget.h"
 #include "c10/util/thread_name.h"
 #include "caffe2/core/common.h"
 #include "caffe2/core/logging.h"
@@ -268,6 +269,7 @@ class alignas(kGEMMLOWPCacheLineSize) Worker {
   // Thread entry point.
   void ThreadFunc() {
     c10::setThreadName("CaffeWorkersPool");
+    c10::ThreadBudget::get().bindNextWorker(c10::ThreadPoolKind::Caffe2);
     ChangeState(State::Ready);
 
     // Thread main loop
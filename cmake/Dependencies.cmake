@@ -1007,6 +1007,7 @@ if (USE_ZSTD)
   include_directories(SYSTEM ${CMAKE_CURRENT_LIST_DIR}/../third_party/zstd/lib)
   add_subdirectory(${CMAKE_CURRENT_LIST_DIR}/../third_party/zstd/build/cmake)
   set_property(TARGET libzstd_static PROPERTY POSITION_INDEPENDENT_CODE ON)
+  set(CAFFE2_USE_ZSTD 1)
 endif()
 
 # ---[ Onnx
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include <torch/data.h>
+#include <torch/data/detail/queue.h>
 #include <torch/data/detail/sequencers.h>
 #include <torch/serialize.h>
 #include <torch/types.h>
@@ -8,13 +9,16 @@
 #include <test/cpp/api/support.h>
 
 #include <c10/util/ArrayRef.h>
+#include <c10/util/tempfile.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <future>
 #include <iostream>
 #include <iterator>
 #include <limits>
+#include <memory>
 #include <mutex>
 #include <numeric>
 #include <stdexcept>
@@ -442,6 +446,76 @@ TEST(DataTest, TensorDatasetConstructsFromInitializerListOfTensors) {
       torch::tensor({0, 0, 1, 0, 0}, torch::kFloat32).allclose(dataset.get(2)));
 }
 
+TEST(DataTest, MappedDatasetReturnsViewsOfWrittenExamples) {
+  auto tempfile = c10::make_tempfile();
+  auto data = torch::randn({6, 2, 3});
+  auto target = torch::arange(6, torch::kInt64);
+  datasets::MappedDataset::write(
+      tempfile.name, {{"data", data.unbind()}, {"target", target.unbind()}});
+
+  datasets::MappedDataset dataset(tempfile.name);
+  ASSERT_EQ(dataset.size().value(), 6);
+  ASSERT_EQ(
+      dataset.column_names(), (std::vector<std::string>{"data", "target"}));
+  for (size_t i = 0; i < 6; ++i) {
+    auto example = dataset.get(i);
+    ASSERT_TRUE(example.data.equal(data[i]));
+    ASSERT_EQ(example.target.item<int64_t>(), static_cast<int64_t>(i));
+  }
+
+  // Writing to a view changes neither the file nor other views.
+  dataset.get(1).data.fill_(0);
+  ASSERT_TRUE(dataset.get(1).data.equal(data[1]));
+  ASSERT_TRUE(datasets::MappedDataset(tempfile.name).get(1).data.equal(data[1]));
+
+  ASSERT_THROWS_WITH(dataset.get(6), "out of range");
+  ASSERT_THROWS_WITH(dataset.get_column("labels", 0), "no column named");
+}
+
+TEST(DataTest, MappedDatasetGathersBatches) {
+  auto tempfile = c10::make_tempfile();
+  auto data = torch::randn({8, 4});
+  auto target = torch::randint(10, {8}, torch::kInt64);
+  datasets::MappedDataset::write(
+      tempfile.name, {{"data", data.unbind()}, {"target", target.unbind()}});
+  datasets::MappedDataset dataset(tempfile.name);
+
+  const std::vector<size_t> indices = {2, 3, 4, 0, 7, 6};
+  auto batch = dataset.get_batch(indices);
+  auto expected = torch::tensor(
+      std::vector<int64_t>(indices.begin(), indices.end()), torch::kInt64);
+  ASSERT_TRUE(batch.data.equal(data.index_select(0, expected)));
+  ASSERT_TRUE(batch.target.equal(target.index_select(0, expected)));
+
+  auto loader = torch::data::make_data_loader(
+      dataset, DataLoaderOptions().batch_size(3).workers(0));
+  std::vector<Example<>> batches(loader->begin(), loader->end());
+  ASSERT_EQ(batches.size(), 3);
+  ASSERT_TRUE(batches[0].data.equal(data.slice(0, 0, 3)));
+  ASSERT_TRUE(batches[2].target.equal(target.slice(0, 6, 8)));
+}
+
+TEST(DataTest, MappedDatasetStoresRaggedColumns) {
+  auto tempfile = c10::make_tempfile();
+  std::vector<torch::Tensor> sequences = {
+      torch::randn({3, 2}), torch::randn({0, 2}), torch::randn({5, 2})};
+  datasets::MappedDataset::write(tempfile.name, {{"data", sequences}});
+  datasets::MappedDataset dataset(tempfile.name, "data", /*target_column=*/"");
+
+  for (size_t i = 0; i < sequences.size(); ++i) {
+    auto example = dataset.get(i);
+    ASSERT_TRUE(example.data.equal(sequences[i]));
+    ASSERT_FALSE(example.target.defined());
+  }
+  auto batch = dataset.get_batch({2, 0});
+  ASSERT_TRUE(batch.data.equal(torch::cat({sequences[2], sequences[0]})));
+
+  ASSERT_THROWS_WITH(
+      (datasets::MappedDataset::write(
+          tempfile.name, {{"data", {torch::ones({2, 2}), torch::ones({2, 3})}}})),
+      "differ in other than the first dimension");
+}
+
 TEST(DataTest, StackTransformWorksForExample) {
   struct D : public datasets::Dataset<D> {
     Example<> get(size_t index) override {
@@ -477,7 +551,40 @@ TEST(DataTest, StackTransformWorksForTensorExample) {
   ASSERT_TRUE(second.data.allclose(torch::eye(4).slice(/*dim=*/0, 2, 4)));
 }
 
+TEST(DataTest, StackTransformCopiesIntoPreallocatedBatch) {
+  std::vector<Example<>> examples;
+  for (int64_t i = 0; i < 100; ++i) {
+    // Every other example is a non-contiguous view.
+    auto data = i % 2 ? torch::randn({3, 5}) : torch::randn({5, 3}).t();
+    examples.push_back({data, torch::tensor(i)});
+  }
+  std::vector<torch::Tensor> data, targets;
+  for (const auto& example : examples) {
+    data.push_back(example.data);
+    targets.push_back(example.target);
+  }
+
+  auto batch = transforms::Stack<Example<>>().apply_batch(examples);
+  ASSERT_TRUE(batch.data.equal(torch::stack(data)));
+  ASSERT_TRUE(batch.target.equal(torch::stack(targets)));
+}
+
+TEST(DataTest, StackTransformFallsBackToStack) {
+  auto leaf = torch::ones({2}, torch::requires_grad());
+  auto batch = transforms::Stack<TensorExample>().apply_batch(
+      {TensorExample(leaf), TensorExample(leaf * 2)});
+  ASSERT_TRUE(batch.data.requires_grad());
+  batch.data.sum().backward();
+  ASSERT_TRUE(leaf.grad().equal(torch::full({2}, 3)));
+
+  ASSERT_THROWS_WITH(
+      transforms::Stack<TensorExample>().apply_batch(
+          {TensorExample(torch::ones(2)), TensorExample(torch::ones(3))}),
+      "Sizes of tensors must match");
+}
+
 // Template classes cannot be nested in functions.
+template <typename Target>// Template classes cannot be nested in functions.
 template <typename Target>
 struct T : transforms::TensorTransform<Target> {
   torch::Tensor operator()(torch::Tensor input) override {
@@ -680,6 +787,88 @@ TEST(DataTest, QueueClearEmptiesTheQueue) {
   ASSERT_THROWS_WITH(queue.pop(1 * kMillisecond), "Timeout");
 }
 
+TEST(DataTest, BoundedQueueRoundsCapacityUpToPowerOfTwo) {
+  torch::data::detail::BoundedQueue<int> queue(5);
+  ASSERT_EQ(queue.capacity(), 8);
+}
+
+TEST(DataTest, BoundedQueueTryPushFailsWhenFull) {
+  torch::data::detail::BoundedQueue<int> queue(2);
+  std::vector<int> values = {1, 2, 3};
+  ASSERT_EQ(queue.try_push(values.begin(), values.size()), 2);
+  ASSERT_EQ(queue.try_push(values.begin() + 2, 1), 0);
+  ASSERT_EQ(queue.pop(), 1);
+  ASSERT_EQ(queue.try_push(values.begin() + 2, 1), 1);
+  ASSERT_EQ(queue.pop(), 2);
+  ASSERT_EQ(queue.pop(), 3);
+}
+
+TEST(DataTest, BoundedQueuePopsBatches) {
+  torch::data::detail::BoundedQueue<int> queue(8);
+  queue.push(std::vector<int>{1, 2, 3, 4, 5});
+  std::vector<int> values;
+  ASSERT_EQ(queue.pop(values, 3), 3);
+  ASSERT_EQ(queue.pop(values, 3), 2);
+  ASSERT_EQ(values, std::vector<int>({1, 2, 3, 4, 5}));
+}
+
+TEST(DataTest, BoundedQueuePopWithTimeoutThrowsUponTimeout) {
+  torch::data::detail::BoundedQueue<int> queue(2);
+  ASSERT_THROWS_WITH(
+      queue.pop(10 * kMillisecond),
+      "Timeout in DataLoader queue while waiting for next batch "
+      "(timeout was 10 ms)");
+}
+
+TEST(DataTest, BoundedQueueClearEmptiesTheQueue) {
+  torch::data::detail::BoundedQueue<int> queue(4);
+  queue.push(std::vector<int>{1, 2, 3});
+  ASSERT_EQ(queue.clear(), 3);
+  ASSERT_THROWS_WITH(queue.pop(1 * kMillisecond), "Timeout");
+}
+
+TEST(DataTest, BoundedQueueBlocksProducersWhileFull) {
+  // Many producers and consumers going through a queue much smaller than the
+  // number of elements, so both sides have to park.
+  torch::data::detail::BoundedQueue<int> queue(4);
+  const int kThreads = 4;
+  const int kValuesPerThread = 10000;
+  std::vector<std::thread> threads;
+  std::vector<int64_t> sums(kThreads, 0);
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&queue] {
+      std::vector<int> batch;
+      for (int i = 1; i <= kValuesPerThread; ++i) {
+        batch.push_back(i);
+        if (batch.size() == 3 || i == kValuesPerThread) {
+          queue.push(std::move(batch));
+          batch.clear();
+        }
+      }
+    });
+    threads.emplace_back([&queue, &sums, t] {
+      for (int i = 0; i < kValuesPerThread; ++i) {
+        sums[t] += queue.pop();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const int64_t expected =
+      int64_t(kThreads) * kValuesPerThread * (kValuesPerThread + 1) / 2;
+  ASSERT_EQ(std::accumulate(sums.begin(), sums.end(), int64_t(0)), expected);
+}
+
+TEST(DataTest, DataShuttleCanPushAndPopJobs) {
+  torch::data::detail::DataShuttle<int, int> shuttle;
+  shuttle.push_jobs({1, 2, 3});
+  ASSERT_EQ(shuttle.in_flight_jobs(), 3);
+  for (int i = 1; i <= 3; ++i) {
+    ASSERT_EQ(shuttle.pop_job(), i);
+  }
+}
+
 TEST(DataTest, DataShuttleCanPushAndPopJob) {
   torch::data::detail::DataShuttle<int, int> shuttle;
   shuttle.push_job(1);
@@ -1447,6 +1636,75 @@ TEST(DataLoaderTest, TestExceptionsArePropagatedFromWorkers) {
   }
 }
 
+TEST(DataLoaderTest, WorkerProcessesReturnEveryBatch) {
+  const size_t kDatasetSize = 100;
+  auto data_loader = torch::data::make_data_loader(
+      DummyDataset(kDatasetSize),
+      DataLoaderOptions().batch_size(7).workers(3).worker_processes(true));
+
+  for (size_t epoch = 0; epoch < 2; ++epoch) {
+    std::vector<int> values;
+    for (auto& batch : *data_loader) {
+      values.insert(values.end(), batch.begin(), batch.end());
+    }
+    std::sort(values.begin(), values.end());
+    std::vector<int> expected(kDatasetSize);
+    std::iota(expected.begin(), expected.end(), 1);
+    ASSERT_EQ(values, expected) << "epoch " << epoch;
+  }
+}
+
+TEST(DataLoaderTest, WorkerProcessesReturnTensorsThroughSharedMemory) {
+  auto tensor = torch::arange(60, torch::kFloat32).view({20, 3});
+  auto data_loader = torch::data::make_data_loader(
+      datasets::TensorDataset(tensor).map(
+          transforms::Stack<TensorExample>()),
+      samplers::SequentialSampler(20),
+      DataLoaderOptions().batch_size(4).workers(2).worker_processes(true));
+
+  int64_t row = 0;
+  for (auto& batch : *data_loader) {
+    ASSERT_EQ(batch.data.sizes(), std::vector<int64_t>({4, 3}));
+    ASSERT_TRUE(batch.data.equal(tensor.narrow(0, row, 4)));
+    row += 4;
+  }
+  ASSERT_EQ(row, 20);
+}
+
+TEST(DataLoaderTest, WorkerProcessesPropagateExceptions) {
+  struct D : datasets::Dataset<DummyDataset, int> {
+    int get(size_t index) override {
+      throw std::invalid_argument("badness");
+    }
+    torch::optional<size_t> size() const override {
+      return 100;
+    }
+  };
+
+  auto data_loader = torch::data::make_data_loader(
+      D{},
+      samplers::RandomSampler(100),
+      DataLoaderOptions().workers(2).worker_processes(true));
+  ASSERT_THROWS_WITH(*data_loader->begin(), "raised: badness");
+}
+
+TEST(DataLoaderTest, WorkerProcessesAreRejectedForStatefulDatasets) {
+  struct D : datasets::StatefulDataset<D, int, size_t> {
+    torch::optional<int> get_batch(size_t) override {
+      return torch::nullopt;
+    }
+    torch::optional<size_t> size() const override {
+      return 100;
+    }
+    void reset() override {}
+  };
+
+  auto options = DataLoaderOptions().workers(2).worker_processes(true);
+  ASSERT_THROWS_WITH(
+      (torch::data::make_data_loader(D{}, options)),
+      "not supported for stateful datasets");
+}
+
 TEST(DataLoaderTest, StatefulDatasetWithNoWorkers) {
   const int kNumberOfExamplesAfterWhichTheDatasetExhausts = 10;
 
@@ -1879,3 +2137,144 @@ TEST(DataLoaderTest, ChunkDatasetDoesNotHang) {
   // cleanly.
   auto iterator = data_loader->begin();
 }
+
+// DummyChunkDataReader that counts how often chunks are read.
+struct CountingChunkDataReader : DummyChunkDataReader {
+  BatchType read_chunk(size_t chunk_index) override {
+    ++*reads;
+    return DummyChunkDataReader::read_chunk(chunk_index);
+  }
+
+  std::shared_ptr<std::atomic<size_t>> reads =
+      std::make_shared<std::atomic<size_t>>(0);
+};
+
+// Returns the sum of the examples of every epoch.
+std::vector<int> sum_chunk_dataset_epochs(
+    CountingChunkDataReader data_reader,
+    datasets::ChunkDatasetOptions options,
+    size_t epochs) {
+  samplers::SequentialSampler sampler(0);
+  auto dataset = datasets::make_shared_dataset<datasets::ChunkDataset<
+      CountingChunkDataReader,
+      samplers::SequentialSampler,
+      samplers::SequentialSampler>>(data_reader, sampler, sampler, options);
+  auto data_loader = torch::data::make_data_loader(
+      dataset.map(transforms::BatchLambda<std::vector<int>, int>(
+          [](std::vector<int> batch) {
+            return std::accumulate(batch.begin(), batch.end(), 0);
+          })),
+      DataLoaderOptions(options.batch_size()).workers(0));
+  std::vector<int> sums;
+  for (size_t epoch = 0; epoch < epochs; ++epoch) {
+    int sum = 0;
+    for (auto batch_sum : *data_loader) {
+      sum += batch_sum;
+    }
+    sums.push_back(sum);
+  }
+  return sums;
+}
+
+TEST(DataLoaderTest, ChunkDatasetCacheAvoidsReadingChunksAgain) {
+  CountingChunkDataReader data_reader;
+  auto sums = sum_chunk_dataset_epochs(
+      data_reader, datasets::ChunkDatasetOptions(2, 5).chunk_cache_size(3), 3);
+  ASSERT_EQ(sums, std::vector<int>(3, 595)); // sum([0, 35))
+  ASSERT_EQ(data_reader.reads->load(), 3);
+}
+
+TEST(DataLoaderTest, ChunkDatasetCacheEvictsLeastRecentlyUsedChunks) {
+  datasets::detail::ChunkCache<std::vector<int>> cache(2);
+  cache.put(0, {0});
+  cache.put(1, {1});
+  ASSERT_TRUE(cache.get(0).has_value());
+  cache.put(2, {2});
+  ASSERT_FALSE(cache.get(1).has_value());
+  ASSERT_EQ(cache.get(0).value(), std::vector<int>({0}));
+  ASSERT_EQ(cache.get(2).value(), std::vector<int>({2}));
+}
+
+TEST(DataLoaderTest, ChunkDatasetReadsAheadAcrossEpochs) {
+  CountingChunkDataReader data_reader;
+  const size_t epochs = 4;
+  auto sums = sum_chunk_dataset_epochs(
+      data_reader,
+      datasets::ChunkDatasetOptions(2, 5).cross_epoch_read_ahead(2),
+      epochs);
+  ASSERT_EQ(sums, std::vector<int>(epochs, 595));
+  // Chunks that were read ahead are not read again; at most the chunks read
+  // ahead after the last epoch are extra.
+  ASSERT_LE(data_reader.reads->load(), 3 * epochs + 2);
+}
+
+TEST(DataLoaderTest, ChunkDatasetAdaptivePreloadingReturnsEveryExample) {
+  CountingChunkDataReader data_reader;
+  auto sums = sum_chunk_dataset_epochs(
+      data_reader,
+      datasets::ChunkDatasetOptions(3, 5, 10).adaptive_preloading(true),
+      3);
+  ASSERT_EQ(sums, std::vector<int>(3, 595));
+}
+
+TEST(DataLoaderTest, DevicePrefetchReturnsEveryBatchInOrder) {
+  auto data_loader = torch::data::make_data_loader(
+      datasets::TensorDataset(torch::arange(20).view({10, 2})),
+      samplers::SequentialSampler(10),
+      DataLoaderOptions()
+          .batch_size(3)
+          .workers(2)
+          .device(torch::kCPU)
+          .device_prefetch(3));
+  for (size_t epoch = 0; epoch < 2; ++epoch) {
+    int64_t expected = 0;
+    for (auto& batch : *data_loader) {
+      ASSERT_LE(batch.size(), 3);
+      for (auto& example : batch) {
+        ASSERT_EQ(example.data.device(), torch::Device(torch::kCPU));
+        ASSERT_TRUE(example.data.equal(torch::arange(expected, expected + 2)));
+        expected += 2;
+      }
+    }
+    ASSERT_EQ(expected, 20);
+  }
+}
+
+TEST(DataLoaderTest, DevicePrefetchMustBePositive) {
+  ASSERT_THROWS_WITH(
+      torch::data::make_data_loader(
+          DummyDataset(),
+          DataLoaderOptions().device(torch::kCPU).device_prefetch(0)),
+      "device_prefetch to be positive");
+}
+
+TEST(DataLoaderTest, PinMemoryAndDevicePrefetch_CUDA) {
+  auto data_loader = torch::data::make_data_loader(
+      datasets::TensorDataset(torch::arange(20).view({10, 2}))
+          .map(transforms::Stack<TensorExample>()),
+      samplers::SequentialSampler(10),
+      DataLoaderOptions()
+          .batch_size(2)
+          .workers(2)
+          .pin_memory(true)
+          .device(torch::kCUDA));
+  int64_t expected = 0;
+  for (auto& batch : *data_loader) {
+    ASSERT_TRUE(batch.data.is_cuda());
+    ASSERT_TRUE(batch.data.cpu().equal(
+        torch::arange(expected, expected + 4).view({2, 2})));
+    expected += 4;
+  }
+  ASSERT_EQ(expected, 20);
+}
+
+TEST(DataLoaderTest, StackTransformPinsMemory_CUDA) {
+  auto batch = transforms::Stack<Example<>>(/*pin_memory=*/true)
+                   .apply_batch({{torch::ones(3), torch::zeros(1)},
+                                 {torch::ones(3), torch::zeros(1)}});
+  ASSERT_TRUE(batch.data.equal(torch::ones({2, 3})));
+  const auto* pinned =
+      at::detail::getCUDAHooks().getPinnedMemoryAllocator();
+  ASSERT_EQ(batch.data.storage().allocator(), pinned);
+  ASSERT_EQ(batch.target.storage().allocator(), pinned);
+}
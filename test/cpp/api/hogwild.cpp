@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <torch/nn/modules/embedding.h>
+#include <torch/nn/modules/linear.h>
+#include <torch/nn/parallel/hogwild.h>
+#include <torch/optim/sgd.h>
+#include <torch/types.h>
+
+#include <test/cpp/api/support.h>
+
+#include <atomic>
+#include <vector>
+
+using namespace torch::nn;
+
+struct HogwildTest : torch::test::SeedingFixture {};
+
+TEST_F(HogwildTest, ReplicasShareParametersButNotGradients) {
+  Linear linear(3, 2);
+  auto replicas = parallel::share_parameters(linear, 2);
+  ASSERT_EQ(replicas.size(), 2);
+  for (auto& replica : replicas) {
+    ASSERT_EQ(replica->weight.data_ptr(), linear->weight.data_ptr());
+    ASSERT_EQ(replica->bias.data_ptr(), linear->bias.data_ptr());
+  }
+
+  replicas[0]->forward(torch::ones({1, 3})).sum().backward();
+  ASSERT_TRUE(replicas[0]->weight.grad().defined());
+  ASSERT_FALSE(replicas[1]->weight.grad().defined());
+  ASSERT_FALSE(linear->weight.grad().defined());
+
+  {
+    torch::NoGradGuard guard;
+    replicas[1]->weight.fill_(3);
+  }
+  ASSERT_TRUE(linear->weight.eq(3).all().item<uint8_t>());
+}
+
+TEST_F(HogwildTest, AtomicSparseUpdatesAreNotLost) {
+  // every worker adds 1 to the same rows many times
+  Embedding embedding(EmbeddingOptions(4, 8).sparse(true));
+  {
+    torch::NoGradGuard guard;
+    embedding->weight.zero_();
+  }
+  const size_t workers = 4;
+  const int64_t steps = 200;
+  std::atomic<int64_t> done(0);
+  parallel::hogwild(
+      embedding, workers, [&](size_t /*index*/, Embedding replica) {
+        torch::optim::SGD optimizer(
+            replica->parameters(),
+            torch::optim::SGDOptions(1).atomic_sparse_updates(true));
+        const auto indices = torch::tensor({0, 2, 2}, torch::kLong);
+        for (int64_t step = 0; step < steps; ++step) {
+          optimizer.zero_grad();
+          (-replica->forward(indices).sum()).backward();
+          ASSERT_TRUE(replica->weight.grad().is_sparse());
+          optimizer.step();
+        }
+        ++done;
+      });
+  ASSERT_EQ(done.load(), workers);
+  const auto weight = embedding->weight;
+  ASSERT_TRUE(weight[0].eq(workers * steps).all().item<uint8_t>());
+  ASSERT_TRUE(weight[1].eq(0).all().item<uint8_t>());
+  ASSERT_TRUE(weight[2].eq(2 * workers * steps).all().item<uint8_t>());
+}
+
+TEST_F(HogwildTest, RethrowsExceptionsOfWorkers) {
+  Linear linear(3, 2);
+  ASSERT_THROWS_WITH(
+      parallel::hogwild(linear, 3, [](size_t index, Linear replica) {
+        if (index == 1) {
+          AT_ERROR("Badness!");
+        }
+      }),
+      "Badness!");
+}
@@ -7,6 +7,11 @@
 
 #include <test/cpp/api/support.h>
 
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
 TEST(NoGradTest, SetsGradModeCorrectly) {
   torch::manual_seed(0);
   torch::NoGradGuard guard;
@@ -19,6 +24,53 @@ TEST(NoGradTest, SetsGradModeCorrectly) {
   ASSERT_FALSE(model->weight.grad().defined());
 }
 
+TEST(InferenceModeTest, CreatesPlainTensors) {
+  auto weight = torch::ones({3, 3}, torch::requires_grad());
+  {
+    torch::InferenceModeGuard guard;
+    ASSERT_FALSE(torch::autograd::GradMode::is_enabled());
+    auto x = torch::ones({2, 3});
+    ASSERT_FALSE(x.is_variable());
+    auto w = torch::autograd::as_variable_ref(weight).data();
+    auto y = torch::relu(x.mm(w)) + 1;
+    ASSERT_FALSE(y.is_variable());
+    ASSERT_TRUE(y.allclose(at::full({2, 3}, 4)));
+  }
+  ASSERT_TRUE(torch::autograd::GradMode::is_enabled());
+  ASSERT_FALSE(torch::autograd::InferenceMode::is_enabled());
+  ASSERT_TRUE(torch::ones({2, 3}).is_variable());
+}
+
+TEST(AutocastTest, LeavesCPUMatrixProductsInFloat) {
+  auto weight = torch::randn({4, 4}, torch::requires_grad());
+  auto x = torch::randn({2, 4});
+  torch::AutocastGuard guard;
+  ASSERT_EQ(x.mm(weight).scalar_type(), torch::kFloat);
+  ASSERT_EQ(x.half().sum().scalar_type(), torch::kFloat);
+}
+
+TEST(AutocastTest, CastsOpsToTheirPrecision_CUDA) {
+  auto weight = torch::randn(
+      {4, 4}, torch::device(torch::kCUDA).requires_grad(true));
+  auto x = torch::randn({2, 4}, torch::device(torch::kCUDA));
+  torch::Tensor y, z;
+  {
+    torch::AutocastGuard guard;
+    y = x.mm(weight);
+    ASSERT_EQ(y.scalar_type(), torch::kHalf);
+    z = torch::log_softmax(y, 1);
+    ASSERT_EQ(z.scalar_type(), torch::kFloat);
+  }
+  ASSERT_FALSE(torch::autograd::AutocastMode::is_enabled());
+  z.sum().backward();
+  ASSERT_EQ(weight.grad().scalar_type(), torch::kFloat);
+  ASSERT_TRUE(weight.grad().allclose(
+      x.t().mm(torch::ones({2, 4}, torch::kCUDA) -
+               4 * torch::softmax(y.to(torch::kFloat), 1)),
+      1e-2,
+      1e-2));
+}
+
 struct AutogradTest : torch::test::SeedingFixture {
   AutogradTest() {
     x = torch::randn({3, 3}, torch::requires_grad());
@@ -41,4 +93,180 @@ TEST_F(AutogradTest, CanTakeDerivativesOfZeroDimTensors) {
 TEST_F(AutogradTest, CanPassCustomGradientInputs) {
   z.sum().backward(torch::ones({}) * 2);
   ASSERT_TRUE(x.grad().allclose(y * 2));
-}
\ No newline at end of file
+}
+
+TEST_F(AutogradTest, AccumulatesGradientsOfManyConsumers) {
+  // The gradients of the adds are the same tensor, which must not be
+  // accumulated into in place.
+  auto w = x * 1;
+  auto out = w * 2 + w * 3 + w + w;
+  out.sum().backward();
+  ASSERT_TRUE(x.grad().allclose(torch::full({3, 3}, 7)));
+
+  x.grad().zero_();
+  auto shared = x * 1;
+  std::vector<torch::Tensor> consumers;
+  for (int i = 0; i < 8; ++i) {
+    consumers.push_back(shared * i);
+  }
+  torch::stack(consumers).sum().backward();
+  ASSERT_TRUE(x.grad().allclose(torch::full({3, 3}, 28)));
+}
+
+namespace {
+// Keeps copies of the saved variables and counts how often they are packed
+// and unpacked.
+struct CopyingHooks : public torch::autograd::SavedVariableHooks {
+  struct Copied : public torch::autograd::PackedData {
+    Copied(at::Tensor data, int& unpacked)
+        : data(std::move(data)), unpacked(unpacked) {}
+    at::Tensor unpack() override {
+      ++unpacked;
+      return data;
+    }
+    at::Tensor data;
+    int& unpacked;
+  };
+
+  std::shared_ptr<torch::autograd::PackedData> pack(
+      const at::Tensor& data) override {
+    ++packed;
+    return std::make_shared<Copied>(data.clone(), unpacked);
+  }
+
+  int packed = 0;
+  int unpacked = 0;
+};
+} // namespace
+
+TEST_F(AutogradTest, SavedVariableHooksPackSavedData) {
+  CopyingHooks hooks;
+  torch::Tensor output;
+  {
+    torch::autograd::SavedVariableHooksGuard guard(&hooks);
+    output = (x * y).sum();
+  }
+  ASSERT_EQ(torch::autograd::get_saved_variable_hooks(), nullptr);
+  ASSERT_GT(hooks.packed, 0);
+  output.backward();
+  ASSERT_EQ(hooks.unpacked, hooks.packed);
+  ASSERT_TRUE(x.grad().allclose(y));
+}
+
+TEST_F(AutogradTest, CheckpointComputesSameGradients) {
+  torch::nn::Linear model(3, 3);
+  auto function = [&](const torch::autograd::variable_list& inputs) {
+    auto hidden = torch::tanh(model->forward(inputs[0]));
+    hidden = torch::dropout(hidden, /*p=*/0.5, /*train=*/true);
+    return torch::autograd::variable_list{hidden * inputs[1]};
+  };
+
+  torch::manual_seed(0);
+  function({x, y})[0].sum().backward();
+  auto x_grad = x.grad().clone();
+  auto weight_grad = model->weight.grad().clone();
+  x.grad().zero_();
+  model->weight.grad().zero_();
+
+  torch::manual_seed(0);
+  auto output = torch::checkpoint(function, {x, y})[0];
+  ASSERT_EQ(output.grad_fn()->name(), "torch::autograd::CheckpointBackward");
+  // The recomputation must see the random state of the forward pass
+  torch::randn({3, 3});
+  output.sum().backward();
+  ASSERT_TRUE(x.grad().allclose(x_grad));
+  ASSERT_TRUE(model->weight.grad().allclose(weight_grad));
+  ASSERT_FALSE(y.grad().defined());
+}
+
+TEST_F(AutogradTest, CheckpointKeepsHistoryOfInputs) {
+  auto output = torch::checkpoint(
+      [](const torch::autograd::variable_list& inputs) { return inputs; },
+      {x})[0];
+  ASSERT_EQ(x.grad_fn(), nullptr);
+  output.sum().backward();
+  ASSERT_TRUE(x.grad().allclose(torch::ones({3, 3})));
+  ASSERT_THROWS_WITH(
+      output.sum().backward(), "Trying to backward through the graph");
+}
+namespace {
+// Builds `branches` independent chains of `depth` tiny ops from x and sums
+// them, so every function in the backward pass does almost no work.
+torch::Tensor deepGraph(const torch::Tensor& x, int64_t depth, int branches) {
+  torch::Tensor out;
+  for (int b = 0; b < branches; ++b) {
+    auto y = x;
+    for (int64_t i = 0; i < depth; ++i) {
+      y = y * 1.0 + 0.5;
+    }
+    out = out.defined() ? out + y : y;
+  }
+  return out.sum();
+}
+} // namespace
+
+TEST(AutogradEngineTest, BackwardThroughputOnDeepGraphs) {
+  const int64_t depth = 1000;
+  const int branches = 4;
+  const int iters = 10;
+  auto x = torch::ones({4}, torch::requires_grad());
+
+  double seconds = 0;
+  for (int i = 0; i < iters; ++i) {
+    auto loss = deepGraph(x, depth, branches);
+    auto start = std::chrono::steady_clock::now();
+    loss.backward();
+    seconds += std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+  }
+  ASSERT_TRUE(x.grad().allclose(torch::full({4}, branches * iters)));
+
+  // two functions per op in the chains
+  const double functions = 2.0 * depth * branches * iters;
+  std::cout << "autograd backward: " << functions / seconds / 1e6
+            << " M functions/s" << std::endl;
+}
+
+TEST(AutogradEngineTest, ConcurrentBackwardAccumulatesIntoSharedLeaf) {
+  const int num_threads = 4;
+  const int iters = 20;
+  auto x = torch::zeros({16}, torch::requires_grad());
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < iters; ++i) {
+        deepGraph(x, /*depth=*/10, /*branches=*/2).backward();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_TRUE(
+      x.grad().allclose(torch::full({16}, 2 * num_threads * iters)));
+}
+
+TEST(AutogradEngineTest, ReusesMemoryOfFreedFunctions) {
+  auto x = torch::ones({4}, torch::requires_grad());
+  auto y = x * 2;
+  const void* grad_fn = y.grad_fn().get();
+  y.reset();
+  auto z = x * 2;
+  ASSERT_EQ(z.grad_fn().get(), grad_fn);
+}
+
+TEST(AutogradEngineTest, FreesGraphsOnOtherThreads) {
+  auto x = torch::ones({4}, torch::requires_grad());
+  std::vector<torch::Tensor> losses;
+  for (int i = 0; i < 4; ++i) {
+    losses.push_back(deepGraph(x, /*depth=*/100, /*branches=*/2));
+  }
+  std::thread([&] {
+    losses[0].backward();
+    losses.clear();
+  }).join();
+  deepGraph(x, /*depth=*/100, /*branches=*/2).backward();
+  ASSERT_TRUE(x.grad().allclose(torch::full({4}, 4)));
+}
@@ -15,6 +15,7 @@
 #include <cstdlib>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <random>
 #include <vector>
@@ -320,6 +321,108 @@ TEST(OptimTest, ExternalVectorOfParameters) {
   ASSERT_TRUE(parameters[2].allclose(original_parameters[2] - 1.0));
 }
 
+// Steps parameters of many sizes on `device` with the fused step, and copies
+// of them on the CPU with the per-parameter step, which an extra
+// non-contiguous parameter forces.
+template <typename OptimizerClass, typename Options>
+void check_fused_step(Options options, torch::Device device) {
+  torch::manual_seed(0);
+  std::vector<torch::Tensor> fused;
+  std::vector<torch::Tensor> unfused;
+  for (int64_t i = 0; i < 40; ++i) {
+    const auto parameter =
+        torch::randn({i == 0 ? 70000 : i * 7 + 1}, torch::kFloat64);
+    fused.push_back(parameter.to(device));
+    unfused.push_back(parameter.clone());
+  }
+  unfused.push_back(torch::randn({4, 3}, torch::kFloat64).t());
+
+  OptimizerClass fused_optimizer(fused, options);
+  OptimizerClass unfused_optimizer(unfused, options);
+  for (size_t step = 0; step < 5; ++step) {
+    for (size_t i = 0; i < fused.size(); ++i) {
+      const auto grad = torch::randn(fused[i].sizes(), torch::kFloat64);
+      fused[i].grad() = grad.to(device);
+      unfused[i].grad() = grad.clone();
+    }
+    unfused.back().grad() = torch::ones_like(unfused.back());
+    fused_optimizer.step();
+    unfused_optimizer.step();
+  }
+  for (size_t i = 0; i < fused.size(); ++i) {
+    ASSERT_TRUE(fused[i].to(torch::kCPU).allclose(unfused[i]));
+    ASSERT_TRUE(fused[i].grad().to(torch::kCPU).allclose(unfused[i].grad()));
+  }
+}
+
+void check_fused_steps(torch::Device device) {
+  check_fused_step<SGD>(SGDOptions(0.1), device);
+  check_fused_step<SGD>(
+      SGDOptions(0.1).momentum(0.9).dampening(0.1).weight_decay(1e-2),
+      device);
+  check_fused_step<SGD>(
+      SGDOptions(0.1).momentum(0.9).nesterov(true).weight_decay(1e-2),
+      device);
+  check_fused_step<Adam>(AdamOptions(0.1), device);
+  check_fused_step<Adam>(
+      AdamOptions(0.1).amsgrad(true).weight_decay(1e-2), device);
+  check_fused_step<RMSprop>(RMSpropOptions(0.1), device);
+  check_fused_step<RMSprop>(
+      RMSpropOptions(0.1).centered(true).momentum(0.9).weight_decay(1e-2),
+      device);
+}
+
+TEST(OptimTest, FusedStepMatchesUnfused) {
+  check_fused_steps(torch::kCPU);
+}
+
+TEST(OptimTest, FusedStepMatchesUnfused_CUDA) {
+  check_fused_steps(torch::kCUDA);
+}
+
+// Steps `OptimizerClass` with a sparse gradient for the rows 1 and 3 (twice)
+// of a parameter, and with the same gradient made dense for a copy of it.
+template <typename OptimizerClass, typename Options>
+std::vector<torch::Tensor> step_sparse_and_dense(Options options) {
+  torch::manual_seed(0);
+  const auto indices = torch::tensor({1, 3, 3}, torch::kLong).view({1, 3});
+  const auto values = torch::randn({3, 4});
+  const auto dense_grad =
+      torch::zeros({5, 4}).index_add_(0, indices[0], values);
+
+  std::vector<torch::Tensor> sparse_parameters = {torch::randn({5, 4})};
+  std::vector<torch::Tensor> dense_parameters = {sparse_parameters[0].clone()};
+  OptimizerClass sparse_optimizer(sparse_parameters, options);
+  OptimizerClass dense_optimizer(dense_parameters, options);
+  for (size_t step = 0; step < 3; ++step) {
+    sparse_parameters[0].grad() =
+        torch::sparse_coo_tensor(indices, values, {5, 4});
+    dense_parameters[0].grad() = dense_grad;
+    sparse_optimizer.step();
+    dense_optimizer.step();
+  }
+  return {sparse_parameters[0], dense_parameters[0]};
+}
+
+TEST(OptimTest, SparseGradients_Adagrad) {
+  const auto parameters =
+      step_sparse_and_dense<Adagrad>(AdagradOptions(0.1).lr_decay(1e-3));
+  ASSERT_TRUE(parameters[0].allclose(parameters[1]));
+}
+
+TEST(OptimTest, SparseGradients_Adam) {
+  // The same rows have a gradient at every step, so the lazy sparse update
+  // matches the dense one.
+  const auto parameters = step_sparse_and_dense<Adam>(AdamOptions(0.1));
+  ASSERT_TRUE(parameters[0].allclose(parameters[1]));
+}
+
+TEST(OptimTest, SparseGradients_SGDWithAtomicUpdates) {
+  const auto parameters =
+      step_sparse_and_dense<SGD>(SGDOptions(0.1).atomic_sparse_updates(true));
+  ASSERT_TRUE(parameters[0].allclose(parameters[1]));
+}
+
 TEST(OptimTest, AddParameter_LBFGS) {
   torch::manual_seed(0);
 
@@ -338,3 +441,29 @@ TEST(OptimTest, AddParameter_LBFGS) {
 
   // REQUIRE this doesn't throw
 }
+
+TEST(OptimTest, LossScalerSkipsOverflowingSteps) {
+  std::vector<torch::Tensor> parameters = {
+      torch::ones({2, 2}, torch::requires_grad())};
+  SGD optimizer(parameters, 0.5);
+  LossScaler scaler(LossScalerOptions().init_scale(8).growth_interval(2));
+
+  auto loss = scaler.scale(parameters[0].sum());
+  ASSERT_TRUE(loss.allclose(torch::tensor(32.0f)));
+  loss.backward();
+  ASSERT_TRUE(scaler.step(optimizer));
+  ASSERT_TRUE(parameters[0].grad().allclose(torch::ones({2, 2})));
+  ASSERT_TRUE(parameters[0].allclose(torch::full({2, 2}, 0.5)));
+  ASSERT_EQ(scaler.current_scale(), 8);
+
+  parameters[0].grad().fill_(std::numeric_limits<float>::infinity());
+  ASSERT_FALSE(scaler.step(optimizer));
+  ASSERT_TRUE(parameters[0].allclose(torch::full({2, 2}, 0.5)));
+  ASSERT_EQ(scaler.current_scale(), 4);
+
+  for (size_t step = 0; step < 2; ++step) {
+    parameters[0].grad().fill_(0);
+    ASSERT_TRUE(scaler.step(optimizer));
+  }
+  ASSERT_EQ(scaler.current_scale(), 8);
+}
@@ -223,3 +223,32 @@ TEST_F(ParallelTest, DataParallelUsesAllAvailableCUDADevices_CUDA) {
     ASSERT_EQ(output[i].item<int32_t>(), i);
   }
 }
+
+TEST_F(ParallelTest, DataParallelModuleMatchesSingleDevice_MultiCUDA) {
+  Linear model(5, 3);
+  parallel::DataParallel<Linear> parallel_model(
+      model,
+      std::vector<torch::Device>{torch::Device(torch::kCUDA, 0),
+                                 torch::Device(torch::kCUDA, 1)});
+  ASSERT_EQ(parallel_model.replicas().size(), 2);
+  ASSERT_TRUE(model->weight.device().is_cuda());
+
+  auto input = torch::randn({8, 5}, torch::kCUDA);
+  for (int step = 0; step < 2; ++step) {
+    model->zero_grad();
+    model->forward(input).sum().backward();
+    auto expected_output = model->forward(input);
+    auto expected_grad = model->weight.grad().clone();
+
+    model->zero_grad();
+    auto output = parallel_model.forward(input);
+    ASSERT_TRUE(output.allclose(expected_output));
+    output.sum().backward();
+    parallel_model.reduce_gradients();
+    ASSERT_TRUE(model->weight.grad().allclose(expected_grad));
+
+    // The replicas must see updated parameters in the next step
+    torch::NoGradGuard no_grad;
+    model->weight.add_(model->weight.grad(), -0.1);
+  }
+}
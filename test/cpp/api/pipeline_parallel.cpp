@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <torch/nn/modules/functional.h>
+#include <torch/nn/modules/linear.h>
+#include <torch/nn/modules/sequential.h>
+#include <torch/nn/parallel/pipeline_parallel.h>
+#include <torch/types.h>
+
+#include <test/cpp/api/support.h>
+
+#include <memory>
+#include <vector>
+
+using namespace torch::nn;
+
+struct PipelineParallelTest : torch::test::SeedingFixture {};
+
+namespace {
+Sequential make_model() {
+  return Sequential(
+      Linear(4, 8),
+      Functional(torch::relu),
+      Linear(8, 8),
+      Functional(torch::tanh),
+      Linear(8, 2));
+}
+
+torch::Tensor mse_loss(torch::Tensor output, torch::Tensor target) {
+  return (output - target).pow(2).mean();
+}
+
+// Checks that training a pipeline over `devices` computes the loss and the
+// gradients of training the model as a whole, on the CPU.
+void check_train_step(
+    const std::vector<torch::Device>& devices,
+    parallel::PipelineSchedule schedule) {
+  auto model = make_model();
+  auto reference = std::dynamic_pointer_cast<SequentialImpl>(model->clone());
+  parallel::Pipeline pipeline(
+      model, devices, /*chunks=*/4, /*balance=*/{}, schedule);
+
+  auto input = torch::randn({10, 4});
+  auto target = torch::randn({10, 2});
+  auto expected_loss = mse_loss(reference->forward(input), target);
+  expected_loss.backward();
+  auto loss = pipeline.train_step(input, target, mse_loss);
+  ASSERT_TRUE(loss.cpu().allclose(expected_loss, 1e-4, 1e-6));
+
+  auto parameters = model->parameters();
+  auto expected_parameters = reference->parameters();
+  ASSERT_EQ(parameters.size(), expected_parameters.size());
+  for (size_t i = 0; i < parameters.size(); ++i) {
+    ASSERT_TRUE(parameters[i].grad().cpu().allclose(
+        expected_parameters[i].grad(), 1e-4, 1e-6));
+  }
+}
+} // namespace
+
+TEST_F(PipelineParallelTest, PartitionsLayers) {
+  auto model = make_model();
+  parallel::Pipeline pipeline(
+      model, {torch::kCPU, torch::kCPU}, /*chunks=*/2);
+  ASSERT_EQ(pipeline.stages().size(), 2);
+  ASSERT_EQ(pipeline.stages()[0]->size(), 3);
+  ASSERT_EQ(pipeline.stages()[1]->size(), 2);
+
+  parallel::Pipeline balanced(
+      model, {torch::kCPU, torch::kCPU}, /*chunks=*/2, /*balance=*/{1, 4});
+  ASSERT_EQ(balanced.stages()[0]->size(), 1);
+  ASSERT_EQ(balanced.stages()[1]->size(), 4);
+
+  const std::vector<torch::Device> devices = {torch::kCPU, torch::kCPU};
+  const std::vector<size_t> short_balance = {1, 2};
+  ASSERT_THROWS_WITH(
+      parallel::Pipeline(model, devices, /*chunks=*/2, short_balance),
+      "The balance sums to 3 layers");
+}
+
+TEST_F(PipelineParallelTest, ForwardMatchesSequential) {
+  auto model = make_model();
+  auto input = torch::randn({10, 4});
+  auto expected = model->forward(input);
+  parallel::Pipeline pipeline(
+      model, {torch::kCPU, torch::kCPU, torch::kCPU}, /*chunks=*/3);
+  ASSERT_TRUE(pipeline.forward(input).allclose(expected));
+}
+
+TEST_F(PipelineParallelTest, GPipeMatchesSequential) {
+  check_train_step(
+      {torch::kCPU, torch::kCPU, torch::kCPU}, parallel::PipelineSchedule::GPipe);
+}
+
+TEST_F(PipelineParallelTest, OneForwardOneBackwardMatchesSequential) {
+  check_train_step(
+      {torch::kCPU, torch::kCPU, torch::kCPU},
+      parallel::PipelineSchedule::OneForwardOneBackward);
+}
+
+TEST_F(PipelineParallelTest, GPipeMatchesSequential_MultiCUDA) {
+  check_train_step(
+      {torch::Device(torch::kCUDA, 0), torch::Device(torch::kCUDA, 1)},
+      parallel::PipelineSchedule::GPipe);
+}
+
+TEST_F(PipelineParallelTest, OneForwardOneBackwardMatchesSequential_MultiCUDA) {
+  check_train_step(
+      {torch::Device(torch::kCUDA, 0), torch::Device(torch::kCUDA, 1)},
+      parallel::PipelineSchedule::OneForwardOneBackward);
+}
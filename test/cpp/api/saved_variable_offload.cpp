@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+
+#include <torch/csrc/cuda/saved_variable_offload.h>
+#include <torch/types.h>
+
+#include <test/cpp/api/support.h>
+
+struct SavedVariableOffloadTest : torch::test::SeedingFixture {};
+
+TEST_F(SavedVariableOffloadTest, ComputesSameGradients_CUDA) {
+  auto x = torch::randn(
+      {64, 64}, torch::device(torch::kCUDA).requires_grad(true));
+  auto function = [&] {
+    auto y = x;
+    for (int i = 0; i < 8; ++i) {
+      y = torch::tanh(y.mm(x));
+    }
+    return y.sum();
+  };
+
+  function().backward();
+  auto expected = x.grad().clone();
+  x.grad().zero_();
+
+  torch::Tensor output;
+  {
+    torch::cuda::SavedVariableOffload offload(/*min_bytes=*/0);
+    torch::autograd::SavedVariableHooksGuard guard(&offload);
+    output = function();
+  }
+  output.backward();
+  ASSERT_TRUE(x.grad().allclose(expected));
+}
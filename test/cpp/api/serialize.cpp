@@ -400,3 +400,80 @@ TEST(SerializeTest, UnserializableSubmoduleIsIgnoredWhenLoadingModule) {
   // serialization.
   ASSERT_EQ(output, 5);  
 }
+
+TEST(SerializeTest, SaveAsyncSharded) {
+  torch::manual_seed(0);
+  auto model = xor_model();
+  auto model2 = xor_model();
+  std::vector<torch::Tensor> expected;
+  for (const auto& parameter : model->parameters()) {
+    expected.push_back(parameter.clone());
+  }
+
+  auto tempfile = c10::make_tempfile();
+  const size_t num_shards = 3;
+  auto checkpoint = torch::save_async(model, tempfile.name, num_shards);
+  // The checkpoint holds the values at the time of the call.
+  {
+    torch::NoGradGuard guard;
+    for (auto& parameter : model->parameters()) {
+      parameter.fill_(42);
+    }
+  }
+  checkpoint.wait();
+  ASSERT_TRUE(checkpoint.done());
+
+  torch::load(model2, tempfile.name, num_shards);
+  auto parameters = model2->parameters();
+  ASSERT_EQ(parameters.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_TRUE(parameters[i].equal(expected[i]));
+    ASSERT_TRUE(parameters[i].requires_grad());
+  }
+  for (size_t i = 1; i < num_shards; i++) {
+    std::remove(shard_filename(tempfile.name, i, num_shards).c_str());
+  }
+}
+
+TEST(SerializeTest, SaveAsyncMoreShardsThanTensors) {
+  auto x = torch::randn({5, 5});
+  auto tempfile = c10::make_tempfile();
+  const size_t num_shards = 4;
+  torch::save_async(std::vector<torch::Tensor>{x}, tempfile.name, num_shards)
+      .wait();
+
+  std::vector<torch::Tensor> y;
+  torch::load(y, tempfile.name, num_shards);
+  ASSERT_EQ(y.size(), 1);
+  ASSERT_TRUE(x.equal(y[0]));
+  for (size_t i = 1; i < num_shards; i++) {
+    std::remove(shard_filename(tempfile.name, i, num_shards).c_str());
+  }
+}
+
+TEST(SerializeTest, SaveAsync_CUDA) {
+  auto model = xor_model();
+  auto model2 = xor_model();
+  model->to(torch::kCUDA);
+  std::vector<torch::Tensor> expected;
+  for (const auto& parameter : model->parameters()) {
+    expected.push_back(parameter.cpu());
+  }
+
+  auto tempfile = c10::make_tempfile();
+  auto checkpoint = torch::save_async(model, tempfile.name, 2);
+  {
+    torch::NoGradGuard guard;
+    for (auto& parameter : model->parameters()) {
+      parameter.zero_();
+    }
+  }
+  checkpoint.wait();
+
+  torch::load(model2, tempfile.name, 2, torch::Device(torch::kCPU));
+  auto parameters = model2->parameters();
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_TRUE(parameters[i].equal(expected[i]));
+  }
+  std::remove(shard_filename(tempfile.name, 1, 2).c_str());
+}
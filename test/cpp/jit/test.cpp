@@ -12,6 +12,8 @@
 #include <test/cpp/jit/test_alias_analysis.h>
 #include <test/cpp/jit/test_argument_spec.h>
 #include <test/cpp/jit/test_autodiff.h>
+#include <test/cpp/jit/test_batch_mm.h>
+#include <test/cpp/jit/test_batching_executor.h>
 #include <test/cpp/jit/test_class_import.h>
 #include <test/cpp/jit/test_class_parser.h>
 #include <test/cpp/jit/test_code_template.h>
@@ -25,10 +27,13 @@
 #include <test/cpp/jit/test_ir.h>
 #include <test/cpp/jit/test_irparser.h>
 #include <test/cpp/jit/test_ivalue.h>
+#include <test/cpp/jit/test_memory_planning.h>
 #include <test/cpp/jit/test_misc.h>
+#include <test/cpp/jit/test_mkldnn_layout.h>
 #include <test/cpp/jit/test_netdef_converter.h>
 #include <test/cpp/jit/test_peephole_optimize.h>
 #include <test/cpp/jit/test_qualified_name.h>
+#include <test/cpp/jit/test_static_runtime.h>
 #include <test/cpp/jit/test_subgraph_matcher.h>
 #include <test/cpp/jit/test_subgraph_utils.h>
 
@@ -43,10 +48,12 @@ namespace jit {
   _(Blocks)                        \
   _(CodeTemplate)                  \
   _(ControlFlow)                   \
+  _(InterpreterConstants)          \
   _(CreateAutodiffSubgraphs)       \
   _(CustomOperators)               \
   _(CustomOperatorAliasing)        \
   _(IValueKWargs)                  \
+  _(LazyOperatorSchema)            \
   _(CustomFusion)                  \
   _(Differentiate)                 \
   _(DifferentiateWithRequiresGrad) \
@@ -57,6 +64,10 @@ namespace jit {
   _(PassManagement)                \
   _(Proto)                         \
   _(RegisterFusionCachesKernel)    \
+  _(PersistentKernelCache)         \
+  _(FusionInterpreter)             \
+  _(FusionReduction)               \
+  _(FusionKernelEviction)          \
   _(SchemaParser)                  \
   _(TopologicalIndex)              \
   _(TopologicalMove)               \
@@ -69,14 +80,28 @@ namespace jit {
   _(MemoryDAG)                     \
   _(IRParser)                      \
   _(ConstantPooling)               \
+  _(BatchLinear)                   \
+  _(MemoryPlanning)                \
+  _(MKLDNNLayout)                  \
+  _(StaticRuntime)                 \
+  _(BatchingExecutor)              \
   _(NetDefConverter)               \
   _(THNNConv)                      \
   _(ATenNativeBatchNorm)           \
   _(NoneSchemaMatch)               \
   _(ClassParser)                   \
   _(Profiler)                      \
+  _(ProfilingExecutor)             \
+  _(ParallelCompilation)           \
+  _(MethodWarmup)                  \
+  _(SaveOptimizedPlans)            \
+  _(ExecutorOverhead)              \
+  _(ForkWait)                      \
   _(PeepholeOptimize)              \
   _(RecordFunction)                \
+  _(SamplingProfiler)              \
+  _(ProfilerTrace)                 \
+  _(ProfilerShapeAggregation)      \
   _(SubgraphMatching)              \
   _(ModuleDefine)                  \
   _(QualifiedName)                 \
@@ -828,6 +828,28 @@ void testMemoryDAG() {
       AT_ASSERT(!t.mayContainAlias(e, elem));
     }
   }
+
+  {
+    // Cached memory locations are invalidated by new pointers
+    // c -> b -> a
+    MemoryDAG t;
+    auto a = t.makeFreshValue(aValue);
+    auto b = t.makeFreshValue(bValue);
+    auto c = t.makeFreshValue(cValue);
+    auto d = t.makeFreshValue(dValue);
+    t.makePointerTo(b, a);
+    t.makePointerTo(c, b);
+    ASSERT_TRUE(t.mayAlias(c, a));
+    ASSERT_FALSE(t.mayAlias(c, d));
+    ASSERT_EQ(c->getMemoryLocations().count(), 1);
+
+    // c -> b -> a -> d
+    t.makePointerTo(a, d);
+    ASSERT_TRUE(t.mayAlias(c, d));
+    ASSERT_TRUE(t.mayAlias(b, d));
+    ASSERT_EQ(c->getMemoryLocations().count(), 1);
+    ASSERT_EQ(t.fromIndex(d->index), d);
+  }
 }
 
 void testAliasRegistration() {
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <torch/csrc/autograd/variable.h>
+#include <torch/csrc/jit/interpreter.h>
+#include <torch/csrc/jit/ir.h>
+#include <torch/csrc/jit/irparser.h>
+#include <torch/csrc/jit/passes/batch_mm.h>
+#include <torch/csrc/jit/testing/file_check.h>
+#include "test/cpp/jit/test_base.h"
+
+namespace torch {
+namespace jit {
+
+void testBatchLinear() {
+  const auto graph_string = R"IR(
+graph(%x : Tensor, %w1 : Tensor, %w2 : Tensor, %w3 : Tensor,
+      %b1 : Tensor?, %b2 : Tensor?):
+  %t3 : Tensor = aten::t(%w3)
+  %y1 : Tensor = aten::linear(%x, %w1, %b1)
+  %y2 : Tensor = aten::linear(%x, %w2, %b2)
+  %y3 : Tensor = aten::matmul(%x, %t3)
+  return (%y1, %y2, %y3)
+  )IR";
+  auto graph = std::make_shared<Graph>();
+  script::parseIR(graph_string, &*graph);
+  BatchMM(graph);
+  testing::FileCheck()
+      .check_count("prim::BatchedLinear", 1, /*exactly*/ true)
+      ->check_not("aten::linear")
+      ->check_not("aten::matmul")
+      ->run(*graph);
+
+  auto v = [](at::Tensor t) { return autograd::make_variable(t, false); };
+  auto x = v(at::randn({4, 8}));
+  auto w1 = v(at::randn({3, 8}));
+  auto w2 = v(at::randn({5, 8}));
+  auto w3 = v(at::randn({2, 8}));
+  auto b1 = v(at::randn({3}));
+  auto b2 = v(at::randn({5}));
+  Code code(graph);
+  auto check = [&](IValue bias2) {
+    Stack stack = {x, w1, w2, w3, b1, bias2};
+    InterpreterState(code).run(stack);
+    ASSERT_EQ(stack.size(), 3);
+    auto expected2 = bias2.isNone() ? at::linear(x, w2)
+                                    : at::linear(x, w2, bias2.toTensor());
+    ASSERT_TRUE(stack[0].toTensor().allclose(at::linear(x, w1, b1)));
+    ASSERT_TRUE(stack[1].toTensor().allclose(expected2));
+    ASSERT_TRUE(stack[2].toTensor().allclose(at::matmul(x, w3.t())));
+  };
+  // the second run reuses the concatenated weights
+  check(b2);
+  check(b2);
+  // which are rebuilt once a weight changes
+  w1.add_(1);
+  check(b2);
+  // some projections without a bias: each one runs on its own
+  check(IValue());
+}
+
+} // namespace jit
+} // namespace torch
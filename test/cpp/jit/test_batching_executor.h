@@ -0,0 +1,83 @@
+#pragma once
+
+#include <torch/csrc/jit/batching_executor.h>
+#include <torch/csrc/jit/script/module.h>
+#include "test/cpp/jit/test_base.h"
+#include "torch/csrc/autograd/generated/variable_factories.h"
+
+#include <thread>
+
+namespace torch {
+namespace jit {
+
+void testBatchingExecutor() {
+  auto m = std::make_shared<script::Module>();
+  m->register_parameter("weight", torch::randn({4, 3}), false);
+  m->define(R"(
+    def forward(self, x):
+      return x.mm(self.weight), x.sum()
+  )");
+
+  // concurrent requests of different sizes batch along dimension 0
+  {
+    BatchingExecutorOptions options;
+    options.max_batch_size = 16;
+    options.max_latency = std::chrono::milliseconds(50);
+    BatchingExecutor executor(m, options);
+    std::vector<at::Tensor> inputs;
+    std::vector<std::vector<at::Tensor>> outputs(8);
+    for (int64_t i = 0; i < 8; ++i) {
+      inputs.push_back(torch::randn({i % 3 + 1, 4}));
+    }
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      threads.emplace_back(
+          [&, i] { outputs[i] = executor.run({inputs[i]}); });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      ASSERT_EQ(outputs[i].size(), 2);
+      ASSERT_TRUE(outputs[i][0].allclose(inputs[i].mm(m->get_parameter("weight"))));
+      // outputs that aren't per row are given whole
+      ASSERT_EQ(outputs[i][1].dim(), 0);
+    }
+    // a request failing on its own throws to its caller
+    ASSERT_ANY_THROW(executor.run({torch::randn({2, 5})}));
+  }
+
+  // padded variable length inputs are trimmed back
+  auto padded = std::make_shared<script::Module>();
+  padded->define(R"(
+    def forward(self, x, lengths):
+      return x * 2, lengths
+  )");
+  {
+    BatchingExecutorOptions options;
+    options.max_latency = std::chrono::milliseconds(50);
+    options.variable_length = BatchingExecutorOptions::VariableLength::Pad;
+    options.pad_dim = 1;
+    options.padding_value = -1;
+    BatchingExecutor executor(padded, options);
+    std::vector<at::Tensor> inputs = {torch::randn({2, 3, 5}),
+                                      torch::randn({1, 7, 5})};
+    std::vector<std::vector<at::Tensor>> outputs(2);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      threads.emplace_back(
+          [&, i] { outputs[i] = executor.run({inputs[i]}); });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      ASSERT_TRUE(outputs[i][0].allclose(inputs[i] * 2));
+      ASSERT_EQ(outputs[i][1].size(0), inputs[i].size(0));
+      ASSERT_EQ(outputs[i][1][0].item<int64_t>(), inputs[i].size(1));
+    }
+  }
+}
+
+} // namespace jit
+} // namespace torch
@@ -274,6 +274,21 @@ void testIValueKWargs() {
   ASSERT_EQ(result.toInt(), 19);
 }
 
+void testLazyOperatorSchema() {
+  RegisterOperators reg({Operator(
+      "foo::lazy_schema.overload(Tensor a) -> Tensor",
+      [](Stack& stack) { return 0; })});
+  auto& ops = getAllOperatorsFor(Symbol::fromQualString("foo::lazy_schema"));
+  ASSERT_EQ(ops.size(), 1);
+  // registering operators and finding them by name leaves schemas unparsed
+  ASSERT_FALSE(ops.front()->isSchemaParsed());
+
+  auto& op = sig("foo::lazy_schema.overload(Tensor a) -> Tensor");
+  ASSERT_EQ(&op, ops.front().get());
+  ASSERT_TRUE(op.isSchemaParsed());
+  ASSERT_EQ(op.schema().name(), "foo::lazy_schema");
+}
+
 } // namespace test
 } // namespace jit
 } // namespace torch
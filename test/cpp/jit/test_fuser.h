@@ -13,8 +13,10 @@
 #include "torch/csrc/jit/custom_operator.h"
 #include "torch/csrc/jit/dynamic_dag.h"
 #include "torch/csrc/jit/fuser/interface.h"
+#include "torch/csrc/jit/fuser/kernel_cache.h"
 #include "torch/csrc/jit/import.h"
 #include "torch/csrc/jit/interpreter.h"
+#include "torch/csrc/jit/irparser.h"
 #include "torch/csrc/jit/passes/alias_analysis.h"
 #include "torch/csrc/jit/passes/common_subexpression_elimination.h"
 #include "torch/csrc/jit/passes/constant_propagation.h"
@@ -49,6 +51,7 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdlib>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -218,6 +221,150 @@ void testRegisterFusionCachesKernel(std::ostream& out = std::cout) {
   // and therefore share a KernelSpec to share kernels for specializations
   ASSERT_EQ(second_key, expected_key);
 }
+
+void testFusionInterpreter() {
+  // forces the CPU backend to interpret kernels rather than compile them
+  setenv("PYTORCH_FUSER_CPU_INTERPRETER", "1", 1);
+  overrideCanFuseOnCPU(true);
+
+  Graph graph;
+  Var i0 = Var::asNewInput(graph);
+  Var i1 = Var::asNewInput(graph);
+  Var i2 = Var::asNewInput(graph);
+  auto o1 = i0.sigmoid() * i1 + i2.tanh();
+  auto o0 = o1.tanh() * i1.sigmoid();
+  o0.addAsOutput();
+  o1.addAsOutput();
+
+  // one transposed input exercises the strided indexing
+  std::vector<at::Tensor> inputs = {
+      at::rand({64, 32, 8}),
+      at::rand({64, 8, 32}).transpose(1, 2),
+      at::rand({64, 32, 8})};
+  auto outputs = debugLaunchGraph(graph, inputs);
+
+  overrideCanFuseOnCPU(false);
+  unsetenv("PYTORCH_FUSER_CPU_INTERPRETER");
+
+  auto out1 = inputs[0].sigmoid() * inputs[1] + inputs[2].tanh();
+  auto out0 = out1.tanh() * inputs[1].sigmoid();
+  ASSERT_EQ(outputs.size(), 2);
+  ASSERT_TRUE(outputs[0].allclose(out0));
+  ASSERT_TRUE(outputs[1].allclose(out1));
+}
+
+void testFusionReduction() {
+  setenv("PYTORCH_FUSER_CPU_INTERPRETER", "1", 1);
+  overrideCanFuseOnCPU(true);
+
+  const auto graph_string = R"IR(
+    graph(%x : Tensor,
+          %y : Tensor):
+      %dims : int[] = prim::Constant[value=[1]]()
+      %keepdim : bool = prim::Constant[value=0]()
+      %m : Tensor = aten::mul(%x, %y)
+      %e : Tensor = aten::exp(%m)
+      %s : Tensor = aten::sum(%e, %dims, %keepdim)
+      return (%m, %s))IR";
+  auto graph = std::make_shared<Graph>();
+  script::parseIR(graph_string, &*graph);
+
+  // the broadcast of %y exercises the expanded output
+  std::vector<at::Tensor> inputs = {at::rand({16, 8, 4}), at::rand({8, 1})};
+  auto outputs = debugLaunchGraph(*graph, inputs);
+  auto m = inputs[0] * inputs[1];
+  ASSERT_EQ(outputs.size(), 2);
+  ASSERT_TRUE(outputs[0].allclose(m));
+  ASSERT_TRUE(outputs[1].allclose(m.exp().sum({1})));
+  ASSERT_EQ(outputs[1].sizes(), at::IntArrayRef({16, 4}));
+
+  // the sum ends the group
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    graph->inputs()[i]->setType(CompleteTensorType::create(inputs[i]));
+  }
+  PropagateInputShapes(graph);
+  FuseGraph(graph);
+  overrideCanFuseOnCPU(false);
+  unsetenv("PYTORCH_FUSER_CPU_INTERPRETER");
+
+  for (const Node* n : graph->nodes()) {
+    ASSERT_NE(n->kind(), aten::sum);
+  }
+  auto group_it = std::find_if(
+      graph->nodes().begin(), graph->nodes().end(), [](const Node* n) {
+        return n->kind() == prim::FusionGroup;
+      });
+  ASSERT_TRUE(group_it != graph->nodes().end());
+  testing::FileCheck()
+      .check("aten::mul")
+      ->check("aten::exp")
+      ->check("aten::sum")
+      ->run(*group_it->g(attr::Subgraph));
+}
+
+void testFusionKernelEviction() {
+  setenv("PYTORCH_FUSER_CPU_INTERPRETER", "1", 1);
+  overrideCanFuseOnCPU(true);
+  const auto max_kernels = maxKernelsPerFusion();
+  overrideMaxKernelsPerFusion(2);
+
+  Graph graph;
+  Var i0 = Var::asNewInput(graph);
+  Var i1 = Var::asNewInput(graph);
+  auto o0 = i0 * i1.sigmoid();
+  o0.addAsOutput();
+
+  auto contiguous = at::rand({4, 8});
+  auto transposed = at::rand({8, 4}).t();
+  auto launch = [&](const at::Tensor& a, const at::Tensor& b) {
+    const auto before = nCompiledKernels();
+    auto outputs = debugLaunchGraph(graph, {a, b});
+    AT_ASSERT(outputs[0].allclose(a * b.sigmoid()));
+    return nCompiledKernels() - before;
+  };
+
+  // kernels depend on the layout of the inputs, not on their sizes
+  ASSERT_EQ(launch(contiguous, contiguous), 1);
+  ASSERT_EQ(launch(at::rand({16, 3}), at::rand({16, 3})), 0);
+  ASSERT_EQ(launch(transposed, contiguous), 1);
+  // the stride of a size-1 dim is ignored
+  ASSERT_EQ(launch(at::rand({8, 1}).t(), at::rand({1, 8})), 0);
+  // the least recently used kernel is evicted
+  ASSERT_EQ(launch(contiguous, transposed), 1);
+  ASSERT_EQ(launch(contiguous, contiguous), 0);
+  ASSERT_EQ(launch(transposed, contiguous), 1);
+
+  overrideMaxKernelsPerFusion(max_kernels);
+  overrideCanFuseOnCPU(false);
+  unsetenv("PYTORCH_FUSER_CPU_INTERPRETER");
+}
+
+void testPersistentKernelCache() {
+  char dir[] = "/tmp/pytorch_fuser_cacheXXXXXX";
+  ASSERT_TRUE(mkdtemp(dir));
+  setenv("PYTORCH_FUSER_CACHE_DIR", dir, 1);
+  ASSERT_TRUE(fuser::persistentKernelCacheEnabled());
+
+  const std::string code = "void kernel_1(int n) { kernel_10(n); }";
+  const std::string binary("\x7f" "ELF\0\1", 6);
+  ASSERT_FALSE(fuser::loadPersistentKernel("kernel_1", code, "target"));
+  fuser::storePersistentKernel("kernel_1", code, "target", binary);
+
+  // the same kernel compiled under another name hits the entry
+  const std::string renamed = "void kernel_7(int n) { kernel_10(n); }";
+  auto cached = fuser::loadPersistentKernel("kernel_7", renamed, "target");
+  ASSERT_TRUE(cached);
+  ASSERT_EQ(cached->name, "kernel_1");
+  ASSERT_EQ(cached->binary, binary);
+
+  // other code or another target miss
+  ASSERT_FALSE(fuser::loadPersistentKernel(
+      "kernel_7", "void kernel_7(int n) { kernel_11(n); }", "target"));
+  ASSERT_FALSE(fuser::loadPersistentKernel("kernel_1", code, "other"));
+
+  unsetenv("PYTORCH_FUSER_CACHE_DIR");
+  ASSERT_FALSE(fuser::persistentKernelCacheEnabled());
+}
 } // namespace
 } // namespace jit
 } // namespace torch
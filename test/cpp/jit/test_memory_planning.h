@@ -0,0 +1,65 @@
+#pragma once
+
+#include <torch/csrc/autograd/variable.h>
+#include <torch/csrc/jit/interpreter.h>
+#include <torch/csrc/jit/ir.h>
+#include <torch/csrc/jit/irparser.h>
+#include <torch/csrc/jit/passes/memory_planning.h>
+#include <torch/csrc/jit/testing/file_check.h>
+#include "test/cpp/jit/test_base.h"
+
+namespace torch {
+namespace jit {
+
+void testMemoryPlanning() {
+  const auto graph_string = R"IR(
+graph(%x : Float(2, 3), %y : Float(2, 3)):
+  %1 : int = prim::Constant[value=1]()
+  %a : Float(2, 3) = aten::add(%x, %y, %1)
+  %b : Float(2, 3) = aten::mul(%a, %y)
+  %c : Float(2, 3) = aten::mul(%b, %x)
+  %d : Float(2, 3) = aten::add(%c, %y, %1)
+  return (%d)
+  )IR";
+  auto graph = std::make_shared<Graph>();
+  script::parseIR(graph_string, &*graph);
+
+  auto plan = PlanMemory(graph);
+  // %d is returned, so only %a, %b and %c live in the arena
+  ASSERT_EQ(plan.regions.size(), 3);
+  const Node* a = nullptr;
+  const Node* c = nullptr;
+  for (const auto& entry : plan.regions) {
+    if (entry.first->output()->uniqueName() == "a") {
+      a = entry.first;
+    } else if (entry.first->output()->uniqueName() == "c") {
+      c = entry.first;
+    }
+  }
+  ASSERT_TRUE(a && c);
+  // %a is dead by the time %c is computed, so they share memory
+  ASSERT_EQ(plan.regions.at(a).offset, plan.regions.at(c).offset);
+  ASSERT_EQ(plan.total_size, 2 * 64);
+
+  auto x = autograd::make_variable(at::randn({2, 3}));
+  auto y = autograd::make_variable(at::randn({2, 3}));
+  auto expected = (x + y) * y * x + y;
+
+  MemoryPlanning(graph);
+  testing::FileCheck()
+      .check_count("prim::MemoryArena", 1, /*exactly*/ true)
+      ->check_count("prim::ArenaTensor", 3, /*exactly*/ true)
+      ->run(*graph);
+
+  Code code(graph);
+  // the second run reuses the arena of the first
+  for (int i = 0; i < 2; ++i) {
+    InterpreterState interp(code);
+    Stack stack = {x, y};
+    interp.run(stack);
+    ASSERT_TRUE(stack.at(0).toTensor().allclose(expected));
+  }
+}
+
+} // namespace jit
+} // namespace torch
@@ -16,6 +16,7 @@
 #include "torch/csrc/jit/fuser/interface.h"
 #include "torch/csrc/jit/import.h"
 #include "torch/csrc/jit/interpreter.h"
+#include "torch/csrc/jit/irparser.h"
 #include "torch/csrc/jit/pass_manager.h"
 #include "torch/csrc/jit/passes/alias_analysis.h"
 #include "torch/csrc/jit/passes/common_subexpression_elimination.h"
@@ -35,6 +36,7 @@
 #include "torch/csrc/utils/memory.h"
 
 #include "torch/csrc/autograd/engine.h"
+#include "torch/csrc/autograd/sampling_profiler.h"
 #include "torch/csrc/autograd/variable.h"
 
 #include <torch/csrc/jit/testing/file_check.h>
@@ -42,21 +44,27 @@
 #include "torch/csrc/jit/profiling_record.h"
 #include "torch/csrc/jit/script/compiler.h"
 #include "torch/csrc/jit/script/module.h"
+#include "torch/csrc/jit/script/parser.h"
 #include "torch/jit.h"
 
 #include "onnx/onnx_pb.h"
 
 #include <ATen/ATen.h>
+#include <ATen/Parallel.h>
 
 #include <c10/util/Exception.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_set>
 #include <utility>
@@ -429,6 +437,37 @@ void testControlFlow() {
   ASSERT_EQ(256, run_binary("while_test", 2, 0));
 }
 
+void testInterpreterConstants() {
+  auto graph = std::make_shared<Graph>();
+  script::parseIR(
+      R"IR(
+graph(%a : Tensor):
+  %n : int = prim::Constant[value=3]()
+  %t : bool = prim::Constant[value=1]()
+  %r : Tensor = prim::Loop(%n, %t, %a)
+    block0(%i : int, %x : Tensor):
+      %two : int = prim::Constant[value=2]()
+      %y : Tensor = aten::mul(%x, %two)
+      -> (%t, %y)
+  return (%r)
+  )IR",
+      &*graph);
+  Code code(graph);
+  std::stringstream ss;
+  ss << code;
+  // constants live in registers rather than in instructions
+  ASSERT_EQ(ss.str().find("= Constant "), std::string::npos);
+
+  // the constant used in the loop body must survive every iteration
+  for (int run = 0; run < 2; ++run) {
+    InterpreterState interp(code);
+    Stack stack = {autograd::make_variable(at::ones({2}))};
+    interp.run(stack);
+    ASSERT_TRUE(stack.at(0).toTensor().equal(
+        autograd::make_variable(at::full({2}, 8))));
+  }
+}
+
 void testProto() {
   ::ONNX_NAMESPACE::ModelProto proto;
   proto.set_producer_name("foo");
@@ -711,6 +750,126 @@ void testRecordFunction() {
   checkTracedInputs(jit_inputs);
 }
 
+void testProfilerTrace() {
+  using namespace autograd::profiler;
+  std::stringstream ss;
+  {
+    RecordProfile guard(
+        ss,
+        ProfilerConfig(
+            ProfilerState::CPU,
+            /*report_input_shapes=*/true,
+            /*profile_memory=*/true));
+    auto work = [] {
+      auto t = torch::randn({4, 5}, at::kCPU);
+      for (size_t i = 0; i < 10; ++i) {
+        t = t.mul(2);
+      }
+    };
+    work();
+    std::thread other(work);
+    other.join();
+  }
+
+  const std::string trace = ss.str();
+  auto count = [&](const std::string& what) {
+    size_t n = 0;
+    for (size_t pos = 0; (pos = trace.find(what, pos)) != std::string::npos;
+         ++n, ++pos) {
+    }
+    return n;
+  };
+  AT_CHECK(trace.front() == '[');
+  // one track per thread that recorded events
+  AT_CHECK(count("\"thread_name\"") >= 2, trace);
+  AT_CHECK(count("\"name\": \"mul\"") >= 20, trace);
+  AT_CHECK(count("\"Input Shapes\": \"[[4, 5], []]\"") >= 20, trace);
+  // allocations on the CPU counter track
+  AT_CHECK(count("\"ph\": \"C\"") > 0, trace);
+  AT_CHECK(count("\"name\": \"CPU\"") > 0, trace);
+  AT_CHECK(c10::GetMemoryEventHook() == nullptr);
+}
+
+void testProfilerShapeAggregation() {
+  using namespace autograd::profiler;
+  auto small = torch::randn({4, 5}, at::kCPU);
+  auto large = torch::randn({8, 8}, at::kCPU).to(at::kDouble);
+  enableProfiler(ProfilerConfig(
+      ProfilerState::CPU,
+      /*report_input_shapes=*/true,
+      /*profile_memory=*/true));
+  for (size_t i = 0; i < 3; ++i) {
+    small.mul(2);
+  }
+  for (size_t i = 0; i < 5; ++i) {
+    large.mul(2);
+  }
+  auto stats = aggregateByInputShapes(disableProfiler());
+
+  auto find = [&](std::vector<int64_t> sizes, const std::string& dtype) {
+    for (const auto& op : stats) {
+      if (op.name == "mul" && !op.shapes.empty() && op.shapes[0] == sizes) {
+        AT_CHECK(op.dtypes.size() == op.shapes.size());
+        AT_CHECK(op.dtypes[0] == dtype, op.dtypes[0]);
+        return op;
+      }
+    }
+    AT_ERROR("no stats for mul");
+  };
+  auto small_stats = find({4, 5}, "Float");
+  auto large_stats = find({8, 8}, "Double");
+  AT_CHECK(small_stats.count == 3);
+  AT_CHECK(large_stats.count == 5);
+  // every result is allocated while mul runs, and freed after it returns
+  AT_CHECK(small_stats.allocated_bytes >= 3 * 4 * 5 * 4);
+  AT_CHECK(large_stats.allocated_bytes >= 5 * 8 * 8 * 8);
+  for (size_t i = 1; i < stats.size(); ++i) {
+    AT_CHECK(stats[i - 1].cpu_time_us >= stats[i].cpu_time_us);
+  }
+}
+
+void testSamplingProfiler() {
+  using namespace autograd::profiler;
+  const size_t period = 4;
+  const size_t iters = 4000;
+  auto t = torch::randn({2, 2}, at::kCPU);
+
+  auto countNeg = [] {
+    for (const auto& stats : scrapeSampledOps()) {
+      if (stats.name == "neg") {
+        uint64_t in_buckets = 0;
+        for (auto n : stats.buckets) {
+          in_buckets += n;
+        }
+        AT_CHECK(in_buckets == stats.count);
+        AT_CHECK(stats.count == 0 || stats.total_ns > 0);
+        return stats.count;
+      }
+    }
+    return uint64_t(0);
+  };
+
+  const auto before = countNeg();
+  enableSamplingProfiler(period);
+  AT_CHECK(isSamplingProfilerEnabled());
+  for (size_t i = 0; i < iters; ++i) {
+    t.neg();
+  }
+  disableSamplingProfiler();
+  AT_CHECK(getSamplingPeriod() == period);
+  const auto sampled = countNeg() - before;
+  // about iters / period, with a generous margin for the random gaps
+  AT_CHECK(sampled > iters / period / 2, sampled);
+  AT_CHECK(sampled < iters / period * 2, sampled);
+
+  // nothing is recorded once disabled
+  for (size_t i = 0; i < iters; ++i) {
+    t.neg();
+  }
+  AT_CHECK(countNeg() - before == sampled);
+  setSamplingPeriod(1);
+}
+
 void testAutogradProfiler() {
   constexpr int batch_size = 4;
   constexpr int input_size = 256;
@@ -891,6 +1050,242 @@ void testProfiler() {
   checkShape(*tanh_n, eltwise);
 }
 
+void testProfilingExecutor() {
+  auto graph = std::make_shared<Graph>();
+  script::parseIR(
+      R"IR(
+graph(%a : Tensor,
+      %b : Tensor):
+  %c : Tensor = aten::mul(%a, %b)
+  %d : Tensor = aten::tanh(%c)
+  return (%d))IR",
+      &*graph);
+
+  auto v = [](at::Tensor t) { return autograd::make_variable(t, false); };
+  auto run = [&](GraphExecutor& executor, const at::Tensor& a) {
+    auto stack = createStack({v(a), v(a)});
+    executor.run(stack);
+    ASSERT_TRUE(stack.back().toTensor().allclose((a * a).tanh()));
+    return lastExecutedOptimizedGraph()->inputs()[0]->type();
+  };
+
+  getProfilingMode() = true;
+  GraphExecutor executor(graph);
+  auto input = at::rand({2, 3});
+  // the first runs are profiled
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_NE(run(executor, input)->kind(), TypeKind::CompleteTensorType);
+  }
+  // then the inputs are specialized to the shapes seen
+  auto type = run(executor, input)->cast<CompleteTensorType>();
+  ASSERT_TRUE(type);
+  ASSERT_EQ(type->sizes(), std::vector<int64_t>({2, 3}));
+  // inputs of other shapes fail the guards
+  ASSERT_EQ(
+      run(executor, at::rand({4, 3}))->kind(),
+      TypeKind::DimensionedTensorType);
+  getProfilingMode() = false;
+}
+
+void testParallelCompilation() {
+  const std::string src = R"JIT(
+def a(x):
+    return x + 1
+def b(x):
+    return x * 2
+def c(x):
+    return a(x) + b(x)
+def d(x):
+    return x.sum()
+)JIT";
+  auto define = [](const std::string& src) {
+    auto cu = std::make_shared<script::CompilationUnit>();
+    script::Parser p(src);
+    std::vector<script::Def> definitions;
+    std::vector<script::ResolverPtr> resolvers;
+    while (p.lexer().cur().kind != script::TK_EOF) {
+      definitions.emplace_back(p.parseFunction(/*is_method=*/false));
+      resolvers.push_back(script::nativeResolver());
+    }
+    cu->define(definitions, resolvers, nullptr, /*parallel=*/true);
+    return cu;
+  };
+  auto cu = define(src);
+  auto x = torch::randn({3});
+  auto out = cu->get_function("c")({x}).toTensor();
+  ASSERT_TRUE(out.allclose(x + 1 + x * 2));
+  ASSERT_TRUE(cu->get_function("d")({x}).toTensor().allclose(x.sum()));
+
+  // errors reach the caller
+  bool threw = false;
+  try {
+    define(src + "def e(x):\n    return undefined(x)\n");
+  } catch (const std::exception& e) {
+    threw = std::string(e.what()).find("undefined") != std::string::npos;
+  }
+  ASSERT_TRUE(threw);
+}
+
+void testMethodWarmup() {
+  auto m = std::make_shared<script::Module>();
+  m->register_parameter("w", torch::ones({3}), false);
+  m->define(R"(
+    def forward(self, x):
+      return x * self.w + 1
+  )");
+  auto& method = m->get_method("forward");
+  auto x = torch::randn({3});
+  auto future = method.warmup_async({x});
+  future->wait();
+  ASSERT_TRUE(future->value().isNone());
+  ASSERT_EQ(
+      method.get_executor().getDebugState().execution_plans.size(), 1);
+
+  // the first call reuses the plan compiled in the background
+  ASSERT_TRUE(m->forward({x}).toTensor().allclose(x + 1));
+  ASSERT_EQ(
+      method.get_executor().getDebugState().execution_plans.size(), 1);
+}
+
+void testSaveOptimizedPlans() {
+  auto m = std::make_shared<script::Module>();
+  m->register_parameter("w", torch::ones({3}), false);
+  m->define(R"(
+    def forward(self, x, flag: bool):
+      if flag:
+        x = x * self.w
+      return x + 1
+  )");
+  auto x = torch::randn({3});
+  m->get_method("forward").warmup_async({x, true})->wait();
+  std::stringstream saved;
+  m->save(saved, script::ExtraFilesMap(), /*save_optimized_plans=*/true);
+
+  // the loaded method starts with the saved plan
+  auto loaded = load(saved);
+  auto& method = loaded->get_method("forward");
+  auto plans = method.get_executor().optimizedPlans();
+  auto saved_plans = m->get_method("forward").get_executor().optimizedPlans();
+  ASSERT_EQ(plans.size(), 1);
+  ASSERT_EQ(saved_plans.size(), 1);
+  ASSERT_EQ(
+      Canonicalize(plans[0].graph)->toString(),
+      Canonicalize(saved_plans[0].graph)->toString());
+
+  // and runs it for the inputs it was optimized for
+  ASSERT_TRUE(loaded->forward({x, true}).toTensor().allclose(x + 1));
+  ASSERT_EQ(method.get_executor().getDebugState().execution_plans.size(), 1);
+  ASSERT_TRUE(loaded->forward({x.toType(at::kDouble), false})
+                  .toTensor()
+                  .allclose(x.toType(at::kDouble) + 1));
+  ASSERT_EQ(method.get_executor().getDebugState().execution_plans.size(), 2);
+}
+
+// Measures the per-call overhead of GraphExecutor on a graph that does no
+// work but has many inputs, so ArgumentSpec checking and plan lookup
+// dominate.
+void testExecutorOverhead(std::ostream& out = std::cout) {
+  constexpr size_t num_inputs = 32;
+  constexpr size_t num_iters = 10000;
+  auto graph = std::make_shared<Graph>();
+  for (size_t i = 0; i < num_inputs; ++i) {
+    graph->addInput();
+  }
+  graph->registerOutput(graph->inputs()[0]);
+
+  auto v = [](at::Tensor t) { return autograd::make_variable(t, false); };
+  auto makeInputs = [&](at::IntArrayRef sizes) {
+    Stack stack;
+    for (size_t i = 0; i < num_inputs; ++i) {
+      stack.emplace_back(v(at::rand(sizes)));
+    }
+    return stack;
+  };
+  GraphExecutor executor(graph);
+  auto run = [&](const Stack& inputs) {
+    Stack stack = inputs;
+    executor.run(stack);
+    ASSERT_TRUE(stack.back().toTensor().is_same(inputs[0].toTensor()));
+  };
+
+  // switching between specs still picks the right plan
+  auto inputs = makeInputs({2});
+  auto other_inputs = makeInputs({2, 2});
+  run(inputs);
+  run(other_inputs);
+  run(inputs);
+  ASSERT_EQ(executor.getDebugState().execution_plans.size(), 2);
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_iters; ++i) {
+    run(inputs);
+  }
+  std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+  out << "GraphExecutor overhead with " << num_inputs
+      << " inputs: " << elapsed.count() / num_iters << "us per call\n";
+}
+
+void testForkWait() {
+  // x * 0 + x * 1 + ... + x * 7, each product in its own fork
+  constexpr int num_forks = 8;
+  auto graph = std::make_shared<Graph>();
+  Value* x = graph->addInput();
+  std::vector<Value*> futures;
+  for (int i = 0; i < num_forks; ++i) {
+    auto fork = graph->insertNode(graph->create(prim::fork));
+    auto block = fork->addBlock();
+    {
+      WithInsertPoint g(block);
+      auto product = graph->insert(aten::mul, {x, graph->insertConstant(i)});
+      block->registerOutput(product);
+      fork->output()->setType(FutureType::create(product->type()));
+    }
+    script::lambdaLiftFork(fork);
+    futures.push_back(fork->output());
+  }
+  Value* sum = nullptr;
+  for (Value* future : futures) {
+    Value* value = graph->insert(aten::wait, {future});
+    sum = sum ? graph->insert(aten::add, {sum, value}) : value;
+  }
+  graph->registerOutput(sum);
+  Code code(graph);
+
+  auto input = at::rand({4});
+  auto expected = input * (num_forks * (num_forks - 1) / 2);
+  auto run = [&]() {
+    Stack stack = {input};
+    InterpreterState(code).run(stack);
+    return stack.back().toTensor().allclose(expected);
+  };
+  ASSERT_TRUE(run());
+
+  // Interpreters run from inter-op workers block on their forks, which are
+  // queued behind them. Starting more of them than there are workers only
+  // finishes because the blocked workers run queued tasks themselves.
+  auto& pool = c10::global_work_queue();
+  const size_t num_runs = 2 * pool.size() + 1;
+  std::atomic<size_t> num_done{0};
+  std::atomic<size_t> num_correct{0};
+  for (size_t i = 0; i < num_runs; ++i) {
+    pool.run([&]() {
+      if (run()) {
+        ++num_correct;
+      }
+      ++num_done;
+    });
+  }
+  while (num_done < num_runs) {
+    std::this_thread::yield();
+  }
+  ASSERT_EQ(num_correct.load(), num_runs);
+
+  auto stats = at::get_inter_op_stats();
+  ASSERT_EQ(stats.num_threads, pool.size());
+  ASSERT_GE(stats.max_queued, 1);
+}
+
 } // namespace test
 } // namespace jit
 } // namespace torch
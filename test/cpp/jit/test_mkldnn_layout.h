@@ -0,0 +1,68 @@
+#pragma once
+
+#include <torch/csrc/autograd/variable.h>
+#include <torch/csrc/jit/interpreter.h>
+#include <torch/csrc/jit/ir.h>
+#include <torch/csrc/jit/irparser.h>
+#include <torch/csrc/jit/passes/mkldnn_layout.h>
+#include <torch/csrc/jit/testing/file_check.h>
+#include "test/cpp/jit/test_base.h"
+
+namespace torch {
+namespace jit {
+
+void testMKLDNNLayout() {
+  if (!at::hasMKLDNN()) {
+    return;
+  }
+  const auto graph_string = R"IR(
+graph(%x : Float(1, 3, 8, 8), %w : Float(4, 3, 3, 3), %b : Float(4)):
+  %ones : int[] = prim::Constant[value=[1, 1]]()
+  %zeros : int[] = prim::Constant[value=[0, 0]]()
+  %twos : int[] = prim::Constant[value=[2, 2]]()
+  %groups : int = prim::Constant[value=1]()
+  %false : bool = prim::Constant[value=0]()
+  %c : Float(1, 4, 8, 8) = aten::conv2d(%x, %w, %b, %ones, %ones, %ones, %groups)
+  %r : Float(1, 4, 8, 8) = aten::relu_(%c)
+  %p : Float(1, 4, 4, 4) = aten::max_pool2d(%r, %twos, %twos, %zeros, %ones, %false)
+  %s : Float(1, 4, 4, 4) = aten::sigmoid(%p)
+  return (%s)
+  )IR";
+  auto graph = std::make_shared<Graph>();
+  script::parseIR(graph_string, &*graph);
+
+  ConvertToMKLDNN(graph);
+  // the chain is only reordered on its way in and out, and relu_ on the
+  // convolution's output no one else sees is done out of place
+  testing::FileCheck()
+      .check_count("aten::to_mkldnn", 1, /*exactly*/ true)
+      ->check("prim::MKLDNNConvWeight")
+      ->check("prim::MKLDNNWeight")
+      ->check("aten::conv2d")
+      ->check_not("aten::relu_")
+      ->check("aten::relu")
+      ->check("aten::max_pool2d")
+      ->check_count("aten::to_dense", 1, /*exactly*/ true)
+      ->check("aten::sigmoid")
+      ->run(*graph);
+
+  auto x = autograd::make_variable(at::randn({1, 3, 8, 8}));
+  auto w = autograd::make_variable(at::randn({4, 3, 3, 3}));
+  auto b = autograd::make_variable(at::randn({4}));
+  auto expected =
+      at::max_pool2d(at::conv2d(x, w, b, 1, 1).relu(), 2, 2).sigmoid();
+
+  Code code(graph);
+  // the second run uses the cached weights of the first
+  for (int i = 0; i < 2; ++i) {
+    InterpreterState interp(code);
+    Stack stack = {x, w, b};
+    interp.run(stack);
+    auto s = stack.at(0).toTensor();
+    ASSERT_FALSE(s.is_mkldnn());
+    ASSERT_TRUE(s.allclose(expected, 1e-4, 1e-5));
+  }
+}
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <torch/csrc/jit/script/module.h>
+#include <torch/csrc/jit/static_runtime.h>
+#include <torch/csrc/jit/testing/file_check.h>
+#include "test/cpp/jit/test_base.h"
+#include "torch/csrc/autograd/generated/variable_factories.h"
+
+namespace torch {
+namespace jit {
+
+void testStaticRuntime() {
+  auto m = std::make_shared<script::Module>();
+  m->register_parameter(
+      "weight", torch::randn({3, 3}, at::requires_grad()), false);
+  m->define(R"(
+    def forward(self, x):
+      a = x.mm(self.weight)
+      b = a * x
+      c = b + a
+      return c.relu() * 2
+  )");
+  auto x = torch::randn({3, 3});
+  auto expected = m->run_method("forward", x).toTensor();
+
+  {
+    StaticRuntime runtime(*m);
+    // the parameter is frozen into the graph
+    ASSERT_EQ(runtime.graph()->inputs().size(), 1);
+    auto outputs = runtime.run({x});
+    ASSERT_EQ(outputs.size(), 1);
+    ASSERT_TRUE(outputs[0].allclose(expected));
+    ASSERT_FALSE(outputs[0].requires_grad());
+  }
+  {
+    StaticRuntime runtime(*m, {x});
+    testing::FileCheck().check("prim::MemoryArena")->run(*runtime.graph());
+    // the second run reuses the arena of the first
+    for (int i = 0; i < 2; ++i) {
+      Stack stack = {x};
+      runtime.run(stack);
+      ASSERT_EQ(stack.size(), 1);
+      ASSERT_TRUE(stack[0].toTensor().allclose(expected));
+    }
+  }
+}
+
+} // namespace jit
+} // namespace torch
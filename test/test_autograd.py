@@ -17,7 +17,7 @@ from torch.autograd.gradcheck import gradgradcheck, gradcheck
 from torch.autograd.function import once_differentiable
 from torch.autograd.profiler import profile, format_time, EventList, FunctionEvent
 from torch.utils.checkpoint import checkpoint
-from common_utils import (TEST_MKL, TestCase, run_tests, skipIfNoLapack,
+from common_utils import (TestCase, run_tests, skipIfNoLapack,
                           suppress_warnings, skipIfRocm,
                           load_tests, random_symmetric_pd_matrix)
 from common_cuda import TEST_CUDA
@@ -2200,7 +2200,6 @@ class TestAutograd(TestCase):
         _test_with_size((2, 3, 3), (2, 3, 4))
         _test_with_size((2, 3, 3), (2, 3, 2))
 
-    @unittest.skipIf(not TEST_MKL, "PyTorch is built without MKL support")
     def test_fft_ifft_rfft_irfft(self):
         def _test_complex(sizes, signal_ndim):
             x = torch.randn(sizes, requires_grad=True, dtype=torch.double)
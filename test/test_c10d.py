@@ -183,6 +183,18 @@ class StoreTestBase(object):
     def test_set_get(self):
         self._test_set_get(self._create_store())
 
+    def _test_multi_set_get(self, fs):
+        keys = ["multi_key%d" % i for i in range(10)]
+        values = ["multi_value%d" % i for i in range(10)]
+        fs.multi_set(keys, values)
+        fs.set("multi_key10", "multi_value10")
+        self.assertEqual(
+            [v.encode() for v in values[::-1]] + [b"multi_value10"],
+            fs.multi_get(keys[::-1] + ["multi_key10"]))
+
+    def test_multi_set_get(self):
+        self._test_multi_set_get(self._create_store())
+
 
 class FileStoreTest(TestCase, StoreTestBase):
     def setUp(self):
@@ -207,7 +219,7 @@ class PrefixFileStoreTest(TestCase, StoreTestBase):
         return c10d.PrefixStore(self.prefix, self.filestore)
 
 
-def create_tcp_store(addr):
+def create_tcp_store(addr, num_shards=1):
     """
     Creates a TCP store. Retries if the chosen port is already in use.
     """
@@ -216,7 +228,7 @@ def create_tcp_store(addr):
         try:
             port = common.find_free_port()
             ports.append(port)
-            return c10d.TCPStore(addr, port, 1, True)
+            return c10d.TCPStore(addr, port, 1, True, num_shards)
         except RuntimeError as error:
             if str(error) == "Address already in use":
                 continue
@@ -242,6 +254,13 @@ class TCPStoreTest(TestCase, StoreTestBase):
             store2 = c10d.TCPStore(addr, port, 1, True)  # noqa: F841
 
 
+class ShardedTCPStoreTest(TestCase, StoreTestBase):
+    def _create_store(self):
+        store = create_tcp_store('localhost', num_shards=4)
+        store.set_timeout(timedelta(seconds=300))
+        return store
+
+
 class PrefixTCPStoreTest(TestCase, StoreTestBase):
     def setUp(self):
         super(PrefixTCPStoreTest, self).setUp()
@@ -253,6 +272,18 @@ class PrefixTCPStoreTest(TestCase, StoreTestBase):
         return c10d.PrefixStore(self.prefix, self.tcpstore)
 
 
+@unittest.skipIf(not hasattr(c10d, "RedisStore") or "REDIS_HOST" not in os.environ,
+                 "c10d isn't built with Redis, or REDIS_HOST isn't set")
+class RedisStoreTest(TestCase, StoreTestBase):
+    def _create_store(self):
+        # a prefix of its own for every test, the server outlives them
+        prefix = "test_c10d/%d/%s/" % (os.getpid(), self.id())
+        store = c10d.RedisStore(os.environ["REDIS_HOST"],
+                                int(os.getenv("REDIS_PORT", 6379)), prefix)
+        store.set_timeout(timedelta(seconds=300))
+        return store
+
+
 class RendezvousTest(TestCase):
     def test_unknown_handler(self):
         with self.assertRaisesRegex(RuntimeError, "^No rendezvous handler"):
@@ -433,6 +464,67 @@ class RendezvousTCPTest(TestCase):
         self.assertEqual(b"value0", store0.get("key0"))
 
 
+class ElasticRendezvousTest(TestCase):
+    @retry_on_address_already_in_use_error
+    def test_rounds(self):
+        addr = 'localhost'
+        port = common.find_free_port()
+        server = c10d.TCPStore(addr, port, 1, True)  # noqa: F841
+
+        def join(results, i, min_size, max_size):
+            # the store clients can't be shared between threads
+            store = c10d.TCPStore(addr, port, 1, False)
+            rdzv = c10d.ElasticRendezvous(
+                store, min_size, max_size,
+                last_call_timeout=timedelta(seconds=1))
+            _, rank, world_size = rdzv.next_rendezvous()
+            results[i] = (rdzv.round, rank, world_size)
+
+        def run(count, min_size, max_size):
+            results = [None] * count
+            threads = [
+                threading.Thread(target=join, args=(results, i, min_size, max_size))
+                for i in range(count)
+            ]
+            for thread in threads:
+                thread.start()
+            for thread in threads:
+                thread.join()
+            return results
+
+        # the round closes once max_size processes joined
+        results = run(3, 2, 3)
+        self.assertEqual([0] * 3, [r[0] for r in results])
+        self.assertEqual([0, 1, 2], sorted(r[1] for r in results))
+        self.assertEqual([3] * 3, [r[2] for r in results])
+
+        # or after the last call, with less than max_size processes
+        results = run(2, 2, 4)
+        self.assertEqual([1] * 2, [r[0] for r in results])
+        self.assertEqual([0, 1], sorted(r[1] for r in results))
+        self.assertEqual([2] * 2, [r[2] for r in results])
+
+        # the processes which can't join a round wait for the next one
+        results = [None]
+        waiting = threading.Thread(target=join, args=(results, 0, 2, 2))
+        waiting.start()
+        store = c10d.TCPStore(addr, port, 1, False)
+        rdzv = c10d.ElasticRendezvous(store, 2, 2)
+        while rdzv.num_waiting() == 0:
+            time.sleep(0.1)
+        self.assertEqual(1, rdzv.num_waiting())
+        _, rank, world_size = rdzv.next_rendezvous()
+        waiting.join()
+        self.assertEqual(2, rdzv.round)
+        self.assertEqual(2, world_size)
+        self.assertEqual([0, 1], sorted([rank, results[0][1]]))
+
+    def test_invalid_sizes(self):
+        store = c10d.FileStore(tempfile.NamedTemporaryFile(delete=False).name, 1)
+        with self.assertRaisesRegex(ValueError, "min_size <= max_size"):
+            c10d.ElasticRendezvous(store, 3, 2)
+
+
 class MultiProcessTestCase(TestCase):
     MAIN_PROCESS_RANK = -1
 
@@ -780,6 +872,117 @@ class ProcessGroupGlooTest(MultiProcessTestCase):
         inputs = [torch.Tensor([i + self.rank]).cuda() for i in range(1000)]
         self._test_allreduce_stress(inputs)
 
+    def test_chunked_allreduce_broadcast(self):
+        store = c10d.FileStore(self.file.name, self.world_size)
+        opts = self.opts(threads=4)
+        # two devices, so the chunks run on both contexts
+        opts.devices = [c10d.ProcessGroupGloo.create_tcp_device(interface="lo")] * 2
+        opts.minChunkBytes = 1024
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, opts)
+
+        # 1000 floats make 3 chunks, multiple inputs are chunked alike
+        inputs = [torch.arange(1000, dtype=torch.float) * (self.rank + i) for i in range(2)]
+        pg.allreduce(inputs).wait()
+        expected = torch.arange(1000, dtype=torch.float) * (self.world_size * (self.world_size - 1) / 2)
+        for i, tensor in enumerate(inputs):
+            self.assertEqual(expected + torch.arange(1000, dtype=torch.float) * i * self.world_size, tensor)
+
+        # non-contiguous tensors aren't chunked
+        tensor = torch.ones(100, 20).t()
+        pg.allreduce(tensor).wait()
+        self.assertEqual(torch.full([20, 100], self.world_size), tensor)
+
+        tensor = torch.full([10, 100], self.rank)
+        pg.broadcast(tensor, root=1).wait()
+        self.assertEqual(torch.ones(10, 100), tensor)
+
+    @skip_if_not_multigpu
+    def test_elastic_rendezvous(self):
+        store = c10d.FileStore(self.file.name, self.world_size)
+        rdzv = c10d.ElasticRendezvous(store, self.world_size, self.world_size)
+        tensor = torch.ones([4])
+        for size in [self.world_size, self.world_size - 1]:
+            rdzv.min_size = rdzv.max_size = size
+            round_store, rank, world_size = rdzv.next_rendezvous()
+            self.assertEqual(size, world_size)
+            pg = c10d.ProcessGroupGloo(round_store, rank, world_size, self.opts())
+            pg.allreduce(tensor).wait()
+            # the last process leaves, the others rebuild their process group
+            # and keep their tensor
+            if self.rank == self.world_size - 1:
+                return
+        self.assertEqual(torch.full([4], self.world_size * (self.world_size - 1)), tensor)
+
+    def test_pipelined_allreduce_cuda(self):
+        store = c10d.FileStore(self.file.name, self.world_size)
+        opts = self.opts()
+        opts.minChunkBytes = 1024
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, opts)
+
+        # 1000 floats are staged in 3 chunks
+        inputs = [(torch.arange(1000, dtype=torch.float) * self.rank).cuda(i) for i in range(2)]
+        pg.allreduce(inputs).wait()
+        expected = torch.arange(1000, dtype=torch.float) * (self.world_size * (self.world_size - 1) / 2) * 2
+        for tensor in inputs:
+            self.assertEqual(expected, tensor.cpu())
+
+    def test_allreduce_coalesced(self):
+        store = c10d.FileStore(self.file.name, self.world_size)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
+
+        # Mixed types and shapes, small enough to need several buckets
+        tensors = [
+            torch.full([3, 2], self.rank + i, dtype=dtype)
+            for i in range(20)
+            for dtype in (torch.float32, torch.float64, torch.int64)
+        ]
+        work = c10d._allreduce_coalesced(pg, tensors, 64)
+        work.wait()
+        offset = self.world_size * (self.world_size - 1) / 2
+        for i, tensor in enumerate(tensors):
+            expected = torch.full([3, 2], (i // 3) * self.world_size + offset, dtype=tensor.dtype)
+            self.assertEqual(expected, tensor)
+
+    def test_broadcast_coalesced(self):
+        store = c10d.FileStore(self.file.name, self.world_size)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
+
+        for root in range(self.world_size):
+            tensors = [
+                torch.full([3, 2], self.rank + i, dtype=dtype)
+                for i in range(20)
+                for dtype in (torch.float32, torch.float64, torch.int64)
+            ]
+            opts = c10d.BroadcastOptions()
+            opts.rootRank = root
+            work = c10d._broadcast_coalesced(pg, tensors, 64, opts)
+            work.wait()
+            for i, tensor in enumerate(tensors):
+                expected = torch.full([3, 2], root + i // 3, dtype=tensor.dtype)
+                self.assertEqual(expected, tensor)
+
+    def test_reduce_coalesced(self):
+        store = c10d.FileStore(self.file.name, self.world_size)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
+
+        for root in range(self.world_size):
+            tensors = [
+                torch.full([3, 2], self.rank + i, dtype=dtype)
+                for i in range(20)
+                for dtype in (torch.float32, torch.float64, torch.int64)
+            ]
+            opts = c10d.ReduceOptions()
+            opts.rootRank = root
+            work = c10d._reduce_coalesced(pg, tensors, 64, opts)
+            work.wait()
+            offset = self.world_size * (self.world_size - 1) / 2
+            for i, tensor in enumerate(tensors):
+                if self.rank == root:
+                    value = (i // 3) * self.world_size + offset
+                else:
+                    value = self.rank + i // 3
+                self.assertEqual(torch.full([3, 2], value, dtype=tensor.dtype), tensor)
+
     def test_scatter_checks(self):
         store = c10d.FileStore(self.file.name, self.world_size)
         pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
@@ -1326,6 +1529,74 @@ class ProcessGroupGlooTest(MultiProcessTestCase):
             self.assertEqual(torch.full(size, float(i * self.world_size)), tensor)
 
 
+class ProcessGroupAgentTest(MultiProcessTestCase):
+    def _create_agent(self):
+        store = c10d.FileStore(self.file.name, self.world_size)
+        opts = c10d.ProcessGroupGloo.Options()
+        opts.devices = [c10d.ProcessGroupGloo.create_tcp_device(interface="lo")]
+        opts.timeout = 5.0
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, opts)
+        return c10d.ProcessGroupAgent(pg)
+
+    def test_call(self):
+        agent = self._create_agent()
+        self.assertEqual(self.rank, agent.rank)
+        self.assertEqual(self.world_size, agent.world_size)
+
+        def fail():
+            raise ValueError("failed on rank {}".format(self.rank))
+
+        agent.register_function("add", lambda x, y: x + y)
+        agent.register_function("divmod", lambda x, y: (x // y, x % y))
+        agent.register_function("fail", fail)
+        agent.sync()
+
+        futures = [
+            agent.call(dst, "add", torch.full([2, 3], self.rank), torch.full([2, 3], dst))
+            for dst in range(self.world_size)
+        ]
+        for dst, future in enumerate(futures):
+            result, = future.wait()
+            self.assertEqual(torch.full([2, 3], self.rank + dst), result)
+
+        dst = (self.rank + 1) % self.world_size
+        self.assertEqual((self.rank // 2, self.rank % 2), agent.call(dst, "divmod", self.rank, 2).wait())
+        with self.assertRaisesRegex(RuntimeError, "failed on rank {}".format(dst)):
+            agent.call(dst, "fail").wait()
+        with self.assertRaisesRegex(RuntimeError, "no function named 'missing'"):
+            agent.call(dst, "missing").wait()
+        agent.join()
+
+    def test_sharded_embedding(self):
+        agent = self._create_agent()
+        torch.manual_seed(0)
+        num_embeddings, dim = 10, 3
+        table = torch.randn(num_embeddings, dim)
+        # shards of 3, 3, 3 and 1 rows
+        rows = (num_embeddings + self.world_size - 1) // self.world_size
+        shard = table[self.rank * rows:(self.rank + 1) * rows].clone()
+        embedding = c10d.ShardedEmbedding(agent, "embedding", num_embeddings, shard)
+        self.assertEqual(rows, embedding.rows_per_shard)
+        self.assertEqual(shard.size(0), embedding.shard_size(self.rank))
+
+        indices = torch.tensor([[9, 0, 4], [4, 4, (self.rank * 3) % num_embeddings]])
+        self.assertEqual(table[indices], embedding.lookup(indices))
+
+        # the same on all ranks
+        grad = torch.randn(2, 3, dim)
+        embedding.update(indices, grad, 0.1)
+        agent.sync()
+        expected = table.clone()
+        for rank in range(self.world_size):
+            rank_indices = torch.tensor([9, 0, 4, 4, 4, (rank * 3) % num_embeddings])
+            expected.index_add_(0, rank_indices, grad.view(-1, dim) * -0.1)
+        self.assertEqual(expected, embedding.lookup(torch.arange(num_embeddings)))
+
+        with self.assertRaisesRegex(RuntimeError, "out of range"):
+            embedding.lookup(torch.tensor([num_embeddings]))
+        agent.join()
+
+
 class ProcessGroupNCCLTest(TestCase):
     MAIN_PROCESS_RANK = 0
 
@@ -1574,6 +1845,50 @@ class ProcessGroupNCCLTest(TestCase):
                     tensors_list[i - 2][j])
 
 
+class NcclErrorHandlingTest(MultiProcessTestCase):
+    @property
+    def world_size(self):
+        return 2
+
+    def _test_nccl_timeout(self, blocking):
+        store = c10d.FileStore(self.file.name, self.world_size)
+        pg = c10d.ProcessGroupNCCL(store, self.rank, self.world_size,
+                                   timeout=timedelta(seconds=1))
+        tensor = torch.ones([4]).cuda(self.rank)
+        # sets up the communicators on both ranks
+        pg.allreduce(tensor).wait()
+        if self.rank == 0:
+            # the rank 1 doesn't take part, so the watchdog times it out
+            work = pg.allreduce(tensor)
+            if blocking:
+                with self.assertRaisesRegex(RuntimeError, "timed out"):
+                    work.wait()
+            else:
+                work.wait()
+                while not work.is_completed():
+                    time.sleep(0.1)
+                self.assertFalse(work.is_success())
+            with self.assertRaisesRegex(RuntimeError, "aborted"):
+                pg.allreduce(tensor)
+            store.set("done", "1")
+        else:
+            store.wait(["done"])
+
+    @skip_if_not_nccl
+    @skip_if_lt_x_gpu(2)
+    def test_nccl_timeout(self):
+        self._test_nccl_timeout(blocking=False)
+
+    @skip_if_not_nccl
+    @skip_if_lt_x_gpu(2)
+    def test_nccl_blocking_wait_timeout(self):
+        os.environ["NCCL_BLOCKING_WAIT"] = "1"
+        try:
+            self._test_nccl_timeout(blocking=True)
+        finally:
+            del os.environ["NCCL_BLOCKING_WAIT"]
+
+
 class Net(nn.Module):
     def __init__(self):
         super(Net, self).__init__()
@@ -2415,6 +2730,39 @@ class DistributedDataParallelTest(MultiProcessTestCase):
             loss = criterion(output, target)
             loss.backward()
 
+    @skip_if_not_nccl
+    @skip_if_not_multigpu
+    def test_export_comm_trace(self):
+        import json
+        store = c10d.FileStore(self.file.name, self.world_size)
+        os.environ["NCCL_ENABLE_TIMING"] = "1"
+        try:
+            process_group = c10d.ProcessGroupNCCL(store, self.rank, self.world_size)
+        finally:
+            del os.environ["NCCL_ENABLE_TIMING"]
+        device_id = gpus_for_rank(self.world_size)[self.rank][0]
+        model = DistributedDataParallel(
+            Net().float().to(device_id),
+            device_ids=[device_id],
+            process_group=process_group,
+            bucket_cap_mb=0.001,
+        )
+        model.enable_comm_profiling()
+
+        batch_size = 4
+        criterion = nn.CrossEntropyLoss()
+        input = torch.rand([batch_size, 2], dtype=torch.float)
+        target = torch.LongTensor([random.randrange(4) for _ in range(batch_size)]).to(device_id)
+        criterion(model(input), target).backward()
+
+        with tempfile.NamedTemporaryFile(mode='w+', suffix='.json') as f:
+            model.export_comm_trace(f.name)
+            trace = json.load(f)
+        names = set(event['name'] for event in trace['traceEvents'])
+        self.assertIn('reduction', names)
+        self.assertIn('device reduction', names)
+        self.assertGreaterEqual(trace['otherData']['exposed_comm_time_us'], 0)
+
 
 class ReducerModule(nn.Module):
     def __init__(self):
@@ -2548,6 +2896,164 @@ class ReducerTest(TestCase):
             output.backward()
             optimizer.step()
 
+    def test_forward_backward_rebuild_buckets(self):
+        batch_size = 10
+        model = self._create_mixed_precision_model()
+        reference = copy.deepcopy(model)
+        parameters = [list(model.parameters())]
+        group_by_type = groupby(
+            range(len(parameters[0])),
+            key=lambda i: parameters[0][i].type())
+        buckets = [list(indices) for _, indices in group_by_type]
+        reducer = dist.Reducer(parameters, buckets, self.process_group, [16, 1024])
+        loss = nn.CrossEntropyLoss()
+        for _ in range(3):
+            input = torch.rand([batch_size, 2], dtype=torch.double)
+            target = torch.LongTensor([random.randrange(4) for _ in range(batch_size)])
+            output = loss(model(input), target)
+            reducer.prepare_for_backward(output)
+            output.backward()
+            loss(reference(input), target).backward()
+            for p, q in zip(model.parameters(), reference.parameters()):
+                self.assertEqual(q.grad, p.grad)
+
+    def test_forward_backward_gradient_as_bucket_view(self):
+        batch_size = 10
+        model = self._create_mixed_precision_model()
+        reference = copy.deepcopy(model)
+        parameters = [list(model.parameters())]
+        group_by_type = groupby(
+            range(len(parameters[0])),
+            key=lambda i: parameters[0][i].type())
+        buckets = [list(indices) for _, indices in group_by_type]
+        reducer = dist.Reducer(parameters, buckets, self.process_group, [16, 1024],
+                               gradient_as_bucket_view=True)
+        reference_reducer = self._create_reducer_for_models([reference])
+        optimizer = torch.optim.SGD(model.parameters(), lr=0.1)
+        reference_optimizer = torch.optim.SGD(reference.parameters(), lr=0.1)
+        loss = nn.CrossEntropyLoss()
+
+        # The gradients are zero before the first backward pass.
+        for p in model.parameters():
+            self.assertEqual(torch.zeros(p.size()), p.grad)
+
+        for i in range(4):
+            input = torch.rand([batch_size, 2], dtype=torch.double)
+            target = torch.LongTensor([random.randrange(4) for _ in range(batch_size)])
+            for m, r, o in [(model, reducer, optimizer),
+                            (reference, reference_reducer, reference_optimizer)]:
+                o.zero_grad()
+                # Unused parameter only in the first iteration.
+                output = loss(m(input, use_fc3=(i > 0)), target)
+                r.prepare_for_backward(output)
+                output.backward()
+                o.step()
+            for p, q in zip(model.parameters(), reference.parameters()):
+                self.assertEqual(q.grad, p.grad)
+                self.assertEqual(q, p)
+            # The buckets were rebuilt after the first iteration; from then
+            # on the gradients stay in the same buckets.
+            if i == 1:
+                grad_ptrs = [p.grad.data_ptr() for p in model.parameters()]
+            elif i > 1:
+                self.assertEqual(grad_ptrs, [p.grad.data_ptr() for p in model.parameters()])
+
+    def _test_comm_hook(self, hook, exact):
+        batch_size = 10
+        model = self._create_mixed_precision_model()
+        reference = copy.deepcopy(model)
+        reducer = self._create_reducer_for_models([model])
+        reducer.register_comm_hook(hook)
+        reference_reducer = self._create_reducer_for_models([reference])
+        loss = nn.CrossEntropyLoss()
+        for _ in range(2):
+            input = torch.rand([batch_size, 2], dtype=torch.double)
+            target = torch.LongTensor([random.randrange(4) for _ in range(batch_size)])
+            for m, r in [(model, reducer), (reference, reference_reducer)]:
+                output = loss(m(input), target)
+                r.prepare_for_backward(output)
+                output.backward()
+            if exact:
+                for p, q in zip(model.parameters(), reference.parameters()):
+                    self.assertEqual(q.grad, p.grad, prec=1e-3)
+
+    def test_fp16_compress_hook(self):
+        self._test_comm_hook(dist.FP16CompressHook(), exact=True)
+
+    def test_powersgd_hook(self):
+        self._test_comm_hook(dist.PowerSGDHook(rank=1), exact=False)
+
+    def test_topk_hook(self):
+        # Sending every element is lossless.
+        self._test_comm_hook(dist.TopKHook(ratio=1.0), exact=True)
+
+    def test_bucket_completion_hook(self):
+        batch_size = 10
+        model = self._create_mixed_precision_model()
+        reference = copy.deepcopy(model)
+        reducer = self._create_reducer_for_models([model])
+        completed = []
+
+        def sgd_step(bucket_index, variables):
+            completed.append(bucket_index)
+            with torch.no_grad():
+                for variable in variables:
+                    variable.add_(-0.1, variable.grad)
+
+        reducer.register_bucket_completion_hook(sgd_step)
+        reference_optimizer = torch.optim.SGD(reference.parameters(), lr=0.1)
+        loss = nn.CrossEntropyLoss()
+        for _ in range(2):
+            input = torch.rand([batch_size, 2], dtype=torch.double)
+            target = torch.LongTensor([random.randrange(4) for _ in range(batch_size)])
+            del completed[:]
+            output = loss(model(input), target)
+            reducer.prepare_for_backward(output)
+            output.backward()
+            reference_optimizer.zero_grad()
+            loss(reference(input), target).backward()
+            reference_optimizer.step()
+            self.assertEqual(sorted(completed), completed)
+            self.assertEqual(len(set(completed)), len(completed))
+            for p, q in zip(model.parameters(), reference.parameters()):
+                self.assertEqual(q, p)
+            for p in model.parameters():
+                p.grad.zero_()
+
+    def test_bucket_stats(self):
+        batch_size = 10
+        model = self._create_mixed_precision_model()
+        reducer = self._create_reducer_for_models([model])
+        reducer.set_comm_profiling(True)
+        loss = nn.CrossEntropyLoss()
+        input = torch.rand([batch_size, 2], dtype=torch.double)
+        target = torch.LongTensor([random.randrange(4) for _ in range(batch_size)])
+        output = loss(model(input), target)
+        reducer.prepare_for_backward(output)
+        with torch.autograd.profiler.profile() as prof:
+            output.backward()
+
+        # The events of every bucket are in order, and the device duration
+        # is unknown for Gloo.
+        bucket_stats = reducer.get_bucket_stats()
+        self.assertGreater(len(bucket_stats), 0)
+        for stats in bucket_stats:
+            self.assertEqual(5, len(stats))
+            self.assertGreaterEqual(stats[0], 0)
+            self.assertEqual(sorted(stats[:4]), stats[:4])
+            self.assertEqual(-1, stats[4])
+        self.assertGreaterEqual(reducer.get_exposed_comm_time(), 0)
+        names = set(evt.name for evt in prof.function_events)
+        self.assertIn("ddp_launch_reduction", names)
+        self.assertIn("ddp_wait_reduction", names)
+
+    def test_register_comm_hook_twice(self):
+        model = ReducerModule()
+        reducer = self._create_reducer_for_models([model])
+        reducer.register_comm_hook(dist.FP16CompressHook())
+        with self.assertRaisesRegex(RuntimeError, "already been registered"):
+            reducer.register_comm_hook(dist.TopKHook())
+
 
 class ComputeBucketAssignmentTest(TestCase):
     def test_single_limit_single_dtype(self):
@@ -4,6 +4,7 @@ import unittest
 import sys
 from itertools import repeat
 import os
+import subprocess
 from contextlib import contextmanager
 import threading
 import queue
@@ -984,6 +985,50 @@ class TestCuda(TestCase):
         y.copy_(x, non_blocking=True)
         self.assertEqual(x, y)
 
+    def test_copy_non_blocking_strided(self):
+        for pin in [False, True]:
+            x = torch.randn(6, 5)
+            if pin:
+                x = x.pin_memory()
+            y = torch.zeros(5, 6, device='cuda')
+            y.copy_(x.t(), non_blocking=True)
+            z = torch.zeros(6, 5, device='cuda').t()
+            z.copy_(x.t(), non_blocking=True)
+            torch.cuda.synchronize()
+            self.assertEqual(y.cpu(), x.t())
+            self.assertEqual(z.cpu(), x.t())
+
+        x = torch.randn(6, 5, device='cuda')
+        y = torch.zeros(5, 6).pin_memory()
+        y.copy_(x.t(), non_blocking=True)
+        z = torch.zeros(6, 5).pin_memory().t()
+        z.copy_(x.t(), non_blocking=True)
+        torch.cuda.synchronize()
+        self.assertEqual(y, x.t().cpu())
+        self.assertEqual(z, x.t().cpu())
+
+    def test_hgemm_autotune_and_pad(self):
+        # the flags are read once per process; 61 x 67 x 59 is padded to
+        # 64 x 72 x 64
+        script = """
+import torch
+a = torch.randn(61, 59, device='cuda')
+b = torch.randn(59, 67, device='cuda')
+c = torch.randn(61, 67, device='cuda')
+expected = torch.addmm(c, a, b)
+for _ in range(2):
+    result = torch.addmm(c.half(), a.half(), b.half()).float()
+    assert (result - expected).abs().max().item() < 1e-1, 'addmm'
+    result = torch.addmm(c.half(), b.t().half(), a.t().half(), beta=0).t().float()
+    assert (result - torch.mm(a, b)).abs().max().item() < 1e-1, 'addmm transposed'
+x = torch.randn(3, 61, 59, device='cuda')
+y = torch.randn(3, 59, 67, device='cuda')
+result = torch.bmm(x.half(), y.half()).float()
+assert (result - torch.bmm(x, y)).abs().max().item() < 1e-1, 'bmm'
+"""
+        env = dict(os.environ, PYTORCH_CUBLAS_HGEMM_AUTOTUNE='1', PYTORCH_CUBLAS_HGEMM_PAD='1')
+        subprocess.check_call([sys.executable, '-c', script], env=env)
+
     def test_serialization_array_with_storage(self):
         x = torch.randn(5, 5).cuda()
         y = torch.IntTensor(2, 5).fill_(0).cuda()
@@ -2076,6 +2121,38 @@ class TestCuda(TestCase):
         # cached blocks in case it affects future tests.
         torch.cuda.empty_cache()
 
+    @skipIfRocm
+    @unittest.skipIf(torch.version.cuda is None or
+                     tuple(int(v) for v in torch.version.cuda.split('.')[:2]) < (10, 1),
+                     "CUDA graphs require CUDA 10.1")
+    def test_cuda_graph_module(self):
+        import torch.jit.cuda_graph
+
+        class M(torch.jit.ScriptModule):
+            def __init__(self):
+                super(M, self).__init__()
+                self.weight = torch.nn.Parameter(torch.randn(8, 8, device='cuda'))
+
+            @torch.jit.script_method
+            def forward(self, x):
+                y = torch.mm(x, self.weight)
+                return y.relu() + 1
+
+        m = M()
+        graphed = torch.jit.cuda_graph.CUDAGraphModule(m, (torch.randn(4, 8, device='cuda'),))
+        with torch.no_grad():
+            for _ in range(3):
+                x = torch.randn(4, 8, device='cuda')
+                self.assertEqual(graphed(x), m(x))
+            # Other shapes run the module
+            x = torch.randn(2, 8, device='cuda')
+            self.assertEqual(graphed(x), m(x))
+
+        graphed.reset()
+        x = torch.randn(4, 8, device='cuda')
+        with torch.no_grad():
+            self.assertEqual(graphed(x), m(x))
+
     def test_reduction_gpu_memory_accessing(self):
         x = torch.ones(512, 8, dtype=torch.float32, device='cuda')
         torch.sum(x, 0)
@@ -1401,6 +1401,43 @@ graph(%x : Tensor,
                    .check_next("add").check_next("return") \
                    .run(str(trace.graph))
 
+    def test_insert_histogram_observers(self):
+        class testModule(torch.jit.ScriptModule):
+            def __init__(self):
+                super(testModule, self).__init__()
+                self.conv1 = nn.Conv2d(1, 20, 5, 1)
+
+            @torch.jit.script_method
+            def forward(self, x):
+                x = self.conv1(x)
+                return x
+
+        script_module = testModule()
+        torch._C._jit_reset_histograms()
+        torch._C._jit_pass_insert_histogram_observers(script_module._c, "forward")
+        FileCheck().check("prim::ObserveHistogram").run(str(script_module.graph))
+
+        # Calibrate on inputs in [0, 2]
+        script_module.forward(torch.ones([1, 1, 5, 5]))
+        script_module.forward(torch.ones([1, 1, 5, 5]) * 2)
+
+        qparam_dict = torch._C._jit_compute_qparams_from_histograms("min_max")
+        self.assertIn('x', qparam_dict)
+        qscheme, scale, zero_point = qparam_dict['x']
+        self.assertEqual(qscheme, 'per_tensor_quant')
+        self.assertAlmostEqual(scale, 2. / 255, places=6)
+        self.assertEqual(zero_point, 0)
+        for method in ("percentile", "kl"):
+            for _, scale, zero_point in torch._C._jit_compute_qparams_from_histograms(method).values():
+                self.assertGreater(scale, 0)
+                self.assertTrue(0 <= zero_point <= 255)
+
+        torch._C._jit_pass_insert_quantdequant(script_module.graph, qparam_dict)
+        FileCheck().check_not("prim::ObserveHistogram").run(str(script_module.graph))
+        FileCheck().check("quantize_linear").check_next("int_repr") \
+                   .check_next("dequantize_linear").check("conv2d") \
+                   .run(str(script_module.graph))
+
     def test_insert_quantdequant_alternate_qnode(self):
         input_data = torch.ones([1, 1, 5, 5])
 
@@ -1491,6 +1528,39 @@ graph(%a, %b, %c, %d):
                    .check("my::muladd").check_next("return")      \
                    .run(str(m.graph))
 
+    def test_freeze_module(self):
+        class M(torch.jit.ScriptModule):
+            def __init__(self):
+                super(M, self).__init__()
+                self.conv = nn.Conv2d(3, 4, 3, bias=False)
+                self.bn = nn.BatchNorm2d(4)
+                self.weight = nn.Parameter(torch.randn(6, 4))
+
+            @torch.jit.script_method
+            def forward(self, x):
+                y = self.bn(self.conv(x)).sum(dim=[2, 3])
+                return y.matmul(self.weight.t())
+
+        m = M()
+        # give the batch norm non-trivial statistics
+        with torch.no_grad():
+            m.bn.running_mean.uniform_(-1, 1)
+            m.bn.running_var.uniform_(0.5, 2)
+            m.bn.weight.uniform_(0.5, 2)
+            m.bn.bias.uniform_(-1, 1)
+
+        with self.assertRaisesRegex(RuntimeError, "eval mode"):
+            torch._C._jit_pass_freeze_module(m._c)
+
+        m.eval()
+        x = torch.randn(2, 3, 8, 8)
+        expected = m(x)
+        torch._C._jit_pass_freeze_module(m._c)
+        self.assertEqual(len(list(m.graph.inputs())), 1)
+        FileCheck().check("aten::conv2d").check_not("aten::batch_norm") \
+                   .check_not("aten::t(").check("aten::matmul").run(str(m.graph))
+        self.assertEqual(m(x), expected)
+
     def test_expand_quantlint(self):
         pass
 
@@ -1981,6 +2051,26 @@ graph(%a, %b, %c, %d):
         self.assertEqual(out, out_ref)
         self.assertEqual(grad, grad_ref)
 
+    def test_fuse_bias_dropout_add(self):
+        @torch.jit.script
+        def func(x, bias, residual):
+            return torch.dropout(x + bias, 0.3, True) + residual
+
+        x = torch.randn(4, 8, requires_grad=True)
+        bias = torch.randn(8, requires_grad=True)
+        residual = torch.randn(4, 8, requires_grad=True)
+        out = func(x, bias, residual)
+        FileCheck().check("aten::_fused_bias_dropout_add").check_not("aten::dropout") \
+            .run(str(func.graph_for(x, bias, residual)))
+
+        # dropped elements are the residual, and the others the scaled sum
+        kept = out.ne(residual).float()
+        self.assertEqual(out, (x + bias) * kept / 0.7 + residual)
+        grad_x, grad_bias, grad_residual = torch.autograd.grad(out.sum(), (x, bias, residual))
+        self.assertEqual(grad_x, kept / 0.7)
+        self.assertEqual(grad_bias, grad_x.sum(0))
+        self.assertEqual(grad_residual, torch.ones(4, 8))
+
     def test_conv(self):
         x = torch.ones(20, 16, 50, 40)
         trace, outputs, inputs = torch.jit.get_trace_graph(nn.Conv2d(16, 13, 3, bias=False), x, return_inputs=True)
@@ -6764,6 +6854,78 @@ a")
             for out, ref_out in zip(outs, ref_outs):
                 torch.testing.assert_allclose(out, ref_out)
 
+    @unittest.skipIf(TEST_WITH_UBSAN or not torch.fbgemm_is_cpu_supported(),
+                     'Quantized RNN requires FBGEMM. FBGEMM does not play'
+                     ' well with UBSAN at the moment, so we skip the test if'
+                     ' we are in a UBSAN environment.')
+    def test_rnn_quantized(self):
+        d_in, d_hid, seq_len, batch = 3, 4, 5, 3
+
+        for rnn in [
+            torch.nn.LSTM(d_in, d_hid, num_layers=2, bidirectional=True).float(),
+            torch.nn.GRU(d_in, d_hid, num_layers=2, bidirectional=True).float(),
+        ]:
+            ref = copy.deepcopy(rnn)
+            rnn = torch.jit.quantized.quantize_rnn_modules(rnn)
+            if isinstance(ref, torch.nn.LSTM):
+                self.assertIsInstance(rnn, torch.jit.quantized.QuantizedLSTM)
+            else:
+                self.assertIsInstance(rnn, torch.jit.quantized.QuantizedGRU)
+            rnn = self.getExportImportCopyWithPacking(rnn)
+
+            x = torch.randn(seq_len, batch, d_in)
+            lengths = torch.tensor([5, 3, 2])
+            packed = torch.nn.utils.rnn.pack_padded_sequence(x, lengths)
+
+            # The weights and activations are quantized to 8 bits
+            with torch.no_grad():
+                out, hidden = rnn(x)
+                ref_out, ref_hidden = ref(x)
+                torch.testing.assert_allclose(out, ref_out, rtol=0, atol=5e-2)
+
+                out, hidden = rnn(packed)
+                ref_out, ref_hidden = ref(packed)
+                self.assertEqual(out.batch_sizes, ref_out.batch_sizes)
+                torch.testing.assert_allclose(out.data, ref_out.data, rtol=0, atol=5e-2)
+
+    @unittest.skipIf(TEST_WITH_UBSAN or not torch.fbgemm_is_cpu_supported(),
+                     'Quantized linear requires FBGEMM. FBGEMM does not play'
+                     ' well with UBSAN at the moment, so we skip the test if'
+                     ' we are in a UBSAN environment.')
+    def test_linear_quantized_fp16(self):
+        # Weights that fp16 represents exactly
+        linear = torch.nn.Linear(4, 3).float()
+        linear.weight = torch.nn.Parameter(
+            torch.arange(12, dtype=torch.float).view(3, 4) / 4, requires_grad=False)
+        ref = copy.deepcopy(linear)
+
+        class M(torch.nn.Module):
+            def __init__(self, linear):
+                super(M, self).__init__()
+                self.linear = linear
+
+            def forward(self, x):
+                return self.linear(x)
+
+        m = torch.jit.quantized.quantize_linear_modules(M(linear), torch.float16)
+        self.assertIsInstance(m.linear, torch.jit.quantized.QuantizedLinearFP16)
+        x = torch.randn(5, 2, 4)
+        torch.testing.assert_allclose(m(x), ref(x))
+
+        m = self.getExportImportCopyWithPacking(m.linear)
+        torch.testing.assert_allclose(m(x), ref(x))
+
+    def test_linear_prepacked(self):
+        linear = torch.nn.Linear(4, 3).float()
+        ref = copy.deepcopy(linear)
+        m = torch.jit.quantized.prepack_linear_modules(linear, batch_size=5)
+        self.assertIsInstance(m, torch.jit.quantized.PackedLinear)
+        m = self.getExportImportCopyWithPacking(m)
+        with torch.no_grad():
+            # The packed batch size, and another one that falls back to linear
+            for x in [torch.randn(5, 4), torch.randn(2, 3, 4)]:
+                torch.testing.assert_allclose(m(x), ref(x))
+
     def test_script_module(self):
         class M1(torch.jit.ScriptModule):
             def __init__(self):
@@ -8267,6 +8429,54 @@ a")
         self.assertEqual(1, foo3(a))
         self.assertEqual(2, foo3(b))
 
+    def test_export_opnames(self):
+        class Sub(torch.jit.ScriptModule):
+            @torch.jit.script_method
+            def forward(self, x):
+                return torch.relu(x)
+
+        class M(torch.jit.ScriptModule):
+            def __init__(self):
+                super(M, self).__init__()
+                self.sub = Sub()
+
+            @torch.jit.script_method
+            def forward(self, x):
+                if bool(x.sum() > 0):
+                    x = x.mul(2)
+                return self.sub(x + 1)
+
+        names = torch.jit.export_opnames(M())
+        # the ops in the submodule and the if block are found
+        for name in ['aten::add', 'aten::mul', 'aten::relu', 'aten::sum']:
+            self.assertIn(name, names)
+        self.assertEqual(names, sorted(names))
+        self.assertFalse(any(name.startswith('prim::') for name in names))
+
+    def test_save_optimized_plans(self):
+        class M(torch.jit.ScriptModule):
+            @torch.jit.script_method
+            def forward(self, x):
+                return torch.relu(x * 2 + 1)
+
+        m = M()
+        x = torch.randn(3, 4)
+        m(x)
+        buffer = io.BytesIO()
+        torch.jit.save(m, buffer, _save_optimized_plans=True)
+        buffer.seek(0)
+        loaded = torch.jit.load(buffer)
+        # the plan for x is loaded, and used instead of optimizing a new one
+        self.assertEqual(len(loaded.get_debug_state().execution_plans), 1)
+        self.assertEqual(loaded(x), m(x))
+        self.assertEqual(len(loaded.get_debug_state().execution_plans), 1)
+
+        # plans are only saved when asked for
+        buffer = io.BytesIO()
+        torch.jit.save(m, buffer)
+        buffer.seek(0)
+        self.assertEqual(len(torch.jit.load(buffer).get_debug_state().execution_plans), 0)
+
     def test_script_module_export_submodule(self):
         class M1(torch.jit.ScriptModule):
             def __init__(self):
@@ -12006,6 +12216,24 @@ a")
         imported_m = self.getExportImportCopy(m)
         self.assertEqual(m(), imported_m())
 
+    def test_attribute_serialization_large(self):
+        tensors = [torch.randn(2) for _ in range(300)]
+
+        class M(torch.jit.ScriptModule):
+            def __init__(self):
+                super(M, self).__init__()
+                self.tensor_list = torch.jit.Attribute(tensors, List[torch.Tensor])
+                self.table = torch.jit.Attribute(
+                    {str(i): i for i in range(100000)}, Dict[str, int])
+
+            @torch.jit.script_method
+            def forward(self):
+                return self.tensor_list, self.table
+
+        m = M()
+        imported_m = self.getExportImportCopy(m)
+        self.assertEqual(m(), imported_m())
+
     def test_string_len(self):
         def fn(x):
             # type: (str) -> int
@@ -13498,14 +13726,14 @@ nn_functional_tests = [
         '', (True, 'aten::_batch_norm_impl_index')),
     ('instance_norm', (S, S, S), (non_differentiable(torch.zeros(S)), non_differentiable(torch.ones(S))),),
     ('layer_norm', (S, S, S, S), ([5],), '',
-     (True, ['prim::Loop', 'aten::_batch_norm_impl_index'])),
+     (True, ['prim::Loop', 'aten::native_layer_norm'])),
     ('layer_norm', (S, S, S, S), ([5], non_differentiable(torch.rand(S)),), 'with_only_weight',
-     (True, ['prim::Loop', 'aten::_batch_norm_impl_index'])),
+     (True, ['prim::Loop', 'aten::native_layer_norm'])),
     ('layer_norm', (S, S, S, S), ([5], None, non_differentiable(torch.rand(S)),), 'with_only_bias',
-     (True, ['prim::Loop', 'aten::_batch_norm_impl_index'])),
+     (True, ['prim::Loop', 'aten::native_layer_norm'])),
     ('layer_norm', (S, S, S, S), ([5], non_differentiable(torch.rand(S)),
                                   non_differentiable(torch.rand(S))), 'with_weight_and_bias',
-     (True, ['prim::Loop', 'aten::_batch_norm_impl_index'])),
+     (True, ['prim::Loop', 'aten::native_layer_norm'])),
     ('group_norm', (S, S, S), (1, torch.rand(5),),),
     ('local_response_norm', (S, S, S), (2, ),),
     ('nll_loss', F.log_softmax(torch.randn(3, 5), dim=0), (torch.tensor([1, 0, 4]),), '', (True, 'aten::nll_loss_forward')),
@@ -14296,6 +14524,28 @@ class TestAsync(JitTestCase):
         f = io.BytesIO()
         torch.onnx.export(MyMod(), (torch.rand(3, 4),), f)
 
+    @unittest.skipIf(IS_WINDOWS, "mmap is not supported on Windows")
+    def test_save_load_mmap(self):
+        class MyMod(torch.jit.ScriptModule):
+            def __init__(self):
+                super(MyMod, self).__init__()
+                self.weight = torch.nn.Parameter(torch.randn(3, 4))
+
+            @torch.jit.script_method
+            def forward(self, a):
+                return a.mm(self.weight)
+
+        m = MyMod()
+        x = torch.randn(2, 3)
+        with TemporaryFileName() as fname:
+            m.save(fname)
+            loaded = torch.jit.load(fname, mmap=True)
+            self.assertEqual(m(x), loaded(x))
+            # the storage is a private mapping, writes do not reach the file
+            with torch.no_grad():
+                loaded.weight.zero_()
+            self.assertEqual(m(x), torch.jit.load(fname, mmap=True)(x))
+
     def test_save_load_with_extra_files(self):
         class MyMod(torch.jit.ScriptModule):
             @torch.jit.script_method
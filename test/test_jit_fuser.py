@@ -48,6 +48,23 @@ class TestFuser(JitTestCase):
     def test_abs_cuda(self):
         self._test_fused_abs(device="cuda")
 
+    @unittest.skipIf(IS_WINDOWS or IS_SANDCASTLE, "NYI: fuser support for Windows or Sandcastle")
+    @enable_cpu_fuser
+    def test_tiled_noncontiguous_cpu(self):
+        def f(x, y, z):
+            return (x * y + z).relu()
+
+        # x is transposed, y is broadcast along the rows and z has strides in
+        # both dimensions, with many tiles per row for the large shapes
+        shapes = [(1, 1), (3, 5), (500, 1000), (3, 3000)]
+        for rows, columns in shapes:
+            x = torch.randn(columns, rows).t()
+            y = torch.randn(columns)
+            z = torch.randn(columns * 2, rows)[::2].t()
+            scripted = self.checkScript(f, (x, y, z))
+            self.assertEqual(scripted(x, y, z), f(x, y, z))
+            self.assertAllFused(scripted.graph_for(x, y, z))
+
     @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
     @unittest.skipIf(not RUN_CUDA, "fuser requires CUDA")
     def test_arg_configurations_smoke_cuda(self):
@@ -12,6 +12,9 @@ from functools import wraps, reduce
 from operator import mul
 from collections import OrderedDict
 import threading
+import os
+import shutil
+import tempfile
 
 import torch
 from torch._six import inf, nan
@@ -21,12 +24,14 @@ import torch.nn.functional as F
 import torch.nn.parallel as dp
 import torch.nn.init as init
 import torch.nn.utils.rnn as rnn_utils
+import torch.nn.utils.ragged as ragged_utils
 from torch.nn.utils import clip_grad_norm_, clip_grad_value_
 from torch.nn.utils import parameters_to_vector, vector_to_parameters
 from torch.autograd import Variable, gradcheck
 from torch.autograd.gradcheck import gradgradcheck
 from torch.nn import Parameter
 from torch.nn.parallel._functions import Broadcast
+from torch.nn.modules.utils import _pair
 from common_utils import freeze_rng_state, run_tests, TestCase, skipIfNoLapack, skipIfRocm, \
     TEST_NUMPY, TEST_SCIPY, download_file, PY3, PY34, to_gpu, \
     get_function_arglist, load_tests
@@ -2235,6 +2240,63 @@ class TestNN(NNTestCase):
     def test_softmax_backward_cuda(self):
         self._test_softmax_backward(torch.device('cuda'))
 
+    def _test_softmax_dims(self, device):
+        # non-last dims take the kernels vectorized across the inner dims
+        for fn, ref in [(F.softmax, lambda x, d: x.exp() / x.exp().sum(d, keepdim=True)),
+                        (F.log_softmax, lambda x, d: x - x.exp().sum(d, keepdim=True).log())]:
+            for dtype in [torch.float, torch.double]:
+                input = torch.randn(3, 5, 7, 11, device=device, dtype=dtype)
+                for dim in range(input.dim()):
+                    self.assertEqual(fn(input, dim=dim), ref(input, dim))
+            input = torch.randn(3, 4, 5, device=device, dtype=torch.double, requires_grad=True)
+            self.assertTrue(gradcheck(lambda x: fn(x, dim=1), (input,)))
+
+    def test_softmax_dims(self):
+        self._test_softmax_dims(torch.device('cpu'))
+
+    def _test_masked_softmax(self, device):
+        def reference(input, mask, dim):
+            if mask.dtype in (torch.uint8, torch.bool):
+                masked = input.masked_fill(mask, float('-inf'))
+            else:
+                masked = input + mask
+            out = F.softmax(masked, dim=dim)
+            # rows that are masked entirely give zeros instead of NaNs
+            return out.masked_fill(out != out, 0)
+
+        input = torch.randn(2, 3, 5, 9, device=device)
+        mask_shapes = [(2, 3, 5, 9), (2, 1, 1, 9), (5, 1), (1,)]
+        for mask_shape in mask_shapes:
+            for mask_dtype in [torch.uint8, torch.bool, torch.float]:
+                if mask_dtype == torch.float:
+                    mask = torch.randn(mask_shape, device=device)
+                else:
+                    mask = (torch.rand(mask_shape, device=device) < 0.3).to(mask_dtype)
+                for dim in range(-input.dim(), input.dim()):
+                    out = torch._masked_softmax(input, mask, dim)
+                    self.assertEqual(out, reference(input, mask, dim))
+
+        # fully masked rows
+        mask = torch.zeros(2, 3, 5, 9, dtype=torch.uint8, device=device)
+        mask[0, 1] = 1
+        out = torch._masked_softmax(input, mask, -1)
+        self.assertEqual(out[0, 1], torch.zeros(5, 9, device=device))
+        self.assertEqual(out[1].sum(-1), torch.ones(3, 5, device=device))
+
+        input = torch.randn(2, 4, 6, device=device, dtype=torch.double, requires_grad=True)
+        bool_mask = torch.rand(2, 1, 6, device=device) < 0.3
+        add_mask = torch.randn(4, 1, device=device, dtype=torch.double, requires_grad=True)
+        for dim in [0, 1, 2]:
+            self.assertTrue(gradcheck(lambda x: torch._masked_softmax(x, bool_mask, dim), (input,)))
+            self.assertTrue(gradcheck(lambda x, m: torch._masked_softmax(x, m, dim), (input, add_mask)))
+
+    def test_masked_softmax(self):
+        self._test_masked_softmax(torch.device('cpu'))
+
+    @unittest.skipIf(not TEST_CUDA, "CUDA unavailable")
+    def test_masked_softmax_cuda(self):
+        self._test_masked_softmax(torch.device('cuda'))
+
     def _test_gumbel_softmax_st_shapes(self, cuda, dtype, shape, dim, count_expected):
         logits = torch.randn(shape, dtype=torch.float)
         logits = logits.to(dtype)
@@ -2573,6 +2635,119 @@ class TestNN(NNTestCase):
             self._test_EmbeddingBag(False, 'sum', True, test_backward=test_backward, dtype=dtype)
             self._test_EmbeddingBag(False, 'mean', True, test_backward=test_backward, dtype=dtype)
 
+    def test_embedding_bag_many_bags(self):
+        # enough bags for the sum and mean kernels to split them over threads
+        weight = torch.randn(50, 128, requires_grad=True)
+        lengths = torch.randint(0, 20, (3000,), dtype=torch.long)
+        lengths[::7] = 0
+        offsets = torch.cat([lengths.new_zeros(1), lengths.cumsum(0)[:-1]])
+        input = torch.randint(0, 50, (int(lengths.sum()),), dtype=torch.long)
+        per_sample_weights = torch.randn(input.size())
+        bags = torch.arange(len(lengths)).repeat_interleave(lengths)
+        for mode, psw in [('sum', None), ('mean', None), ('sum', per_sample_weights)]:
+            scaled = weight[input] if psw is None else weight[input] * psw.unsqueeze(1)
+            expected = torch.zeros(len(lengths), 128).index_add_(0, bags, scaled)
+            if mode == 'mean':
+                expected = expected / lengths.clamp(min=1).unsqueeze(1).float()
+            result = F.embedding_bag(input, weight, offsets, mode=mode, per_sample_weights=psw)
+            self.assertEqual(result, expected, prec=1e-4)
+            # the strided weight takes the generic path
+            strided = F.embedding_bag(input, weight.t().contiguous().t(), offsets,
+                                      mode=mode, per_sample_weights=psw)
+            self.assertEqual(strided, expected, prec=1e-4)
+            grad, = torch.autograd.grad(result.sum(), weight)
+            expected_grad, = torch.autograd.grad(expected.sum(), weight)
+            self.assertEqual(grad, expected_grad, prec=1e-4)
+
+    def _test_cached_embedding_bag(self, device, policy):
+        cached = nn.CachedEmbeddingBag(40, 5, cache_size=24, mode='sum', sparse=True,
+                                       policy=policy, device=device)
+        reference = nn.EmbeddingBag.from_pretrained(cached.weight.clone(), freeze=False,
+                                                    mode='sum', sparse=True).to(device)
+        optimizers = [torch.optim.SGD(cached.parameters(), lr=0.5),
+                      torch.optim.SGD(reference.parameters(), lr=0.5)]
+        # 32 of the rows are used, so that batches both hit and evict rows,
+        # while the last, the current and the prefetched batches fit in the cache
+        batches = [torch.randint(0, 32, (8,), dtype=torch.long) for _ in range(20)]
+        offsets = torch.tensor([0, 3, 3], device=device)
+        cached.prefetch(batches[0])
+        for i, input in enumerate(batches):
+            if i + 1 < len(batches):
+                cached.prefetch(batches[i + 1])
+            output = cached(input, offsets)
+            expected = reference(input.to(device), offsets)
+            self.assertEqual(output, expected)
+            grad = torch.randn(3, 5, device=device)
+            for optimizer, out in zip(optimizers, [output, expected]):
+                optimizer.zero_grad()
+                out.backward(grad)
+                optimizer.step()
+        state = cached.state_dict()
+        self.assertEqual(list(state.keys()), ['weight'])
+        self.assertEqual(state['weight'], reference.weight.detach().cpu())
+
+        loaded = nn.CachedEmbeddingBag(40, 5, cache_size=24, mode='sum', device=device)
+        loaded.load_state_dict(state)
+        input = torch.arange(24, dtype=torch.long).view(4, 6)
+        self.assertEqual(loaded(input), reference(input.to(device)))
+
+    def test_cached_embedding_bag(self):
+        for policy in ['lru', 'lfu']:
+            self._test_cached_embedding_bag('cpu', policy)
+
+        cached = nn.CachedEmbeddingBag(10, 2, cache_size=2)
+        with self.assertRaisesRegex(RuntimeError, 'increase cache_size'):
+            cached(torch.tensor([[0, 1, 2]]))
+        with self.assertRaisesRegex(RuntimeError, 'index out of range'):
+            cached(torch.tensor([[0, 10]]))
+
+    def test_cached_embedding_bag_file(self):
+        directory = tempfile.mkdtemp()
+        try:
+            filename = os.path.join(directory, 'table')
+            cached = nn.CachedEmbeddingBag(10, 3, cache_size=4, mode='sum', filename=filename)
+            self.assertEqual(cached.weight, torch.zeros(10, 3))
+            optimizer = torch.optim.SGD(cached.parameters(), lr=1)
+            cached(torch.tensor([[1, 5]])).sum().backward()
+            optimizer.step()
+            cached.flush()
+            # the rows are updated in the file, as seen by another mapping
+            reopened = nn.CachedEmbeddingBag(10, 3, cache_size=4, filename=filename)
+            expected = torch.zeros(10, 3)
+            expected[1] = expected[5] = -1
+            self.assertEqual(reopened.weight, expected)
+            del cached, reopened
+        finally:
+            shutil.rmtree(directory)
+
+    def test_embedding_bag_rowwise_quantized(self):
+        weight = torch.randn(10, 6) * 3
+        input = torch.tensor([3, 1, 1, 9, 4, 0, 7, 2], dtype=torch.long)
+        offsets = torch.tensor([0, 0, 3, 3, 6], dtype=torch.long)
+        per_sample_weights = torch.randn(input.size())
+        for bits in [8, 4]:
+            packed = torch._embedding_bag_rowwise_quantize(weight, bits)
+            self.assertEqual(packed.dtype, torch.uint8)
+            dequantized = torch._embedding_bag_rowwise_dequantize(packed, bits)
+            self.assertEqual(dequantized.size(), weight.size())
+            # every value is within half a quantization step of the original
+            levels = 2 ** bits - 1
+            step = (weight.max(1, keepdim=True)[0] - weight.min(1, keepdim=True)[0]) / levels
+            self.assertTrue(((dequantized - weight).abs() <= step / 2 + 5e-2).all())
+
+            for mode, psw in [(0, None), (1, None), (0, per_sample_weights)]:
+                expected = F.embedding_bag(input, dequantized, offsets,
+                                           mode=['sum', 'mean'][mode],
+                                           per_sample_weights=psw)
+                result = torch._embedding_bag_rowwise_quantized(packed, input, offsets, bits, mode, psw)
+                self.assertEqual(result, expected, prec=1e-4)
+
+            with self.assertRaises(RuntimeError):
+                out_of_bounds = torch.tensor([10], dtype=torch.long)
+                torch._embedding_bag_rowwise_quantized(packed, out_of_bounds, offsets[:1], bits)
+        with self.assertRaises(RuntimeError):
+            torch._embedding_bag_rowwise_quantize(torch.randn(3, 5), 4)
+
     @staticmethod
     def _embedding_bag_reference_impl(input, weight, offsets=None, mode='sum',
                                       per_sample_weights=None):
@@ -2738,6 +2913,37 @@ class TestNN(NNTestCase):
             self._test_EmbeddingBag(True, 'sum', True, dtype)
             self._test_EmbeddingBag(True, 'mean', True, dtype)
 
+    @unittest.skipIf(not TEST_CUDA, "CUDA unavailable")
+    def test_embedding_bag_many_bags_cuda(self):
+        # enough bags for a warp per bag, with uniform indices for the atomic
+        # backward and a hot index for the sorted one
+        for dtype, features in [(torch.float, 128), (torch.double, 130)]:
+            weight = torch.randn(1000, features, dtype=dtype)
+            lengths = torch.randint(0, 5, (20000,), dtype=torch.long)
+            offsets = torch.cat([lengths.new_zeros(1), lengths.cumsum(0)[:-1]])
+            uniform = torch.randint(0, 1000, (int(lengths.sum()),), dtype=torch.long)
+            hot = uniform.clone()
+            hot[::2] = 7
+            prec = 1e-4
+            for input, mode in product([uniform, hot], ['sum', 'mean', 'max']):
+                psw = None
+                if mode == 'sum':
+                    psw = torch.randn(input.size(), dtype=dtype)
+                results = []
+                for device in ['cpu', 'cuda']:
+                    w = weight.to(device, torch.double if device == 'cpu' else dtype).requires_grad_()
+                    out = F.embedding_bag(input.to(device), w, offsets.to(device), mode=mode,
+                                          per_sample_weights=None if psw is None else psw.to(w))
+                    out.backward(torch.ones_like(out))
+                    results.append((out.double().cpu(), w.grad.double().cpu()))
+                self.assertEqual(results[0][0], results[1][0], prec=prec)
+                self.assertEqual(results[0][1], results[1][1], prec=prec * 10)
+
+    @unittest.skipIf(not TEST_CUDA, "CUDA unavailable")
+    def test_cached_embedding_bag_cuda(self):
+        for policy in ['lru', 'lfu']:
+            self._test_cached_embedding_bag('cuda', policy)
+
     def test_fractional_max_pool2d(self):
         x = torch.randn(1, 2, 7, 7, requires_grad=True)
         samples = x.new(1, 2, 2).uniform_()
@@ -2801,6 +3007,59 @@ class TestNN(NNTestCase):
         input = torch.Tensor(num_features, b, d, w, h)
         self._test_dropout(nn.Dropout3d, True, input)
 
+    def _unpack_bitmask(self, mask, like):
+        bits = torch.tensor([1, 2, 4, 8, 16, 32, 64, 128], device=mask.device, dtype=torch.uint8)
+        return (mask.unsqueeze(1) & bits).ne(0).view(-1)[:like.numel()].view_as(like).to(like.dtype)
+
+    def _test_bitmask_dropout(self, device):
+        p = 0.3
+        x = torch.randn(50, 37, device=device, requires_grad=True)
+        out, mask = torch._bitmask_dropout(x, p)
+        self.assertEqual(mask.dtype, torch.uint8)
+        self.assertEqual(mask.numel(), (x.numel() + 63) // 64 * 8)
+        kept = self._unpack_bitmask(mask, x)
+        self.assertLess(abs(kept.mean().item() - (1 - p)), 0.05)
+        self.assertEqual(out, x * kept / (1 - p))
+        grad = torch.randn(50, 37, device=device)
+        grad_x, = torch.autograd.grad(out, x, grad)
+        self.assertEqual(grad_x, grad * kept / (1 - p))
+
+    def test_bitmask_dropout(self):
+        self._test_bitmask_dropout("cpu")
+
+    @unittest.skipIf(not TEST_CUDA, "CUDA unavailable")
+    def test_bitmask_dropout_cuda(self):
+        self._test_bitmask_dropout("cuda")
+
+    def _test_fused_bias_dropout_add(self, device):
+        p = 0.3
+        x = torch.randn(50, 37, device=device, requires_grad=True)
+        bias = torch.randn(37, device=device, requires_grad=True)
+        residual = torch.randn(50, 37, device=device, requires_grad=True)
+        out, mask = torch._fused_bias_dropout_add(x, bias, residual, p)
+        self.assertEqual(mask.dtype, torch.uint8)
+        self.assertEqual(mask.numel(), (x.numel() + 63) // 64 * 8)
+        kept = self._unpack_bitmask(mask, x)
+        self.assertLess(abs(kept.mean().item() - (1 - p)), 0.05)
+        self.assertEqual(out, (x + bias) * kept / (1 - p) + residual)
+
+        grad = torch.randn(50, 37, device=device)
+        grad_x, grad_bias, grad_residual = torch.autograd.grad(out, (x, bias, residual), grad)
+        self.assertEqual(grad_x, grad * kept / (1 - p))
+        self.assertEqual(grad_bias, grad_x.sum(0))
+        self.assertEqual(grad_residual, grad)
+
+        out, mask = torch._fused_bias_dropout_add(x, bias, residual, 1)
+        self.assertEqual(out, residual)
+        self.assertEqual(mask.sum().item(), 0)
+
+    def test_fused_bias_dropout_add(self):
+        self._test_fused_bias_dropout_add("cpu")
+
+    @unittest.skipIf(not TEST_CUDA, "CUDA unavailable")
+    def test_fused_bias_dropout_add_cuda(self):
+        self._test_fused_bias_dropout_add("cuda")
+
     def test_AlphaDropout(self):
         # generate random tensor with zero mean and unit std
         input = torch.randn(5000)
@@ -3006,6 +3265,53 @@ class TestNN(NNTestCase):
         self._test_LayerNorm_general("cuda")
         self._test_LayerNorm_cuda_half()
 
+    def _test_LayerNorm_GroupNorm_backward(self, device="cpu"):
+        # compare the fused kernels with the normalization written out in
+        # differentiable ops, and check their double backward
+        def ref_norm(x, dims, weight, bias, affine_shape, eps):
+            mean = x.mean(dims, keepdim=True)
+            var = (x - mean).pow(2).mean(dims, keepdim=True)
+            out = (x - mean) / (var + eps).sqrt()
+            if weight is not None:
+                out = out * weight.view(affine_shape)
+            if bias is not None:
+                out = out + bias.view(affine_shape)
+            return out
+
+        for affine in [False, True]:
+            x = torch.randn(3, 4, 2, 5, device=device, dtype=torch.double, requires_grad=True)
+            w = torch.randn(2, 5, device=device, dtype=torch.double, requires_grad=True) if affine else None
+            b = torch.randn(2, 5, device=device, dtype=torch.double, requires_grad=True) if affine else None
+            inputs = [x] + ([w, b] if affine else [])
+            out = F.layer_norm(x, [2, 5], w, b, eps=1e-5)
+            ref = ref_norm(x, (2, 3), w, b, [2, 5], 1e-5)
+            grad = torch.randn_like(out)
+            self.assertEqual(out, ref)
+            self.assertEqual(torch.autograd.grad(out, inputs, grad),
+                             torch.autograd.grad(ref, inputs, grad))
+            _assertGradAndGradgradChecks(
+                self, lambda x, *args: F.layer_norm(x, [2, 5], *args, eps=1e-5), inputs)
+
+            x = torch.randn(3, 6, 2, 5, device=device, dtype=torch.double, requires_grad=True)
+            w = torch.randn(6, device=device, dtype=torch.double, requires_grad=True) if affine else None
+            b = torch.randn(6, device=device, dtype=torch.double, requires_grad=True) if affine else None
+            inputs = [x] + ([w, b] if affine else [])
+            out = F.group_norm(x, 2, w, b, eps=1e-5)
+            ref = ref_norm(x.view(3, 2, 3, 2, 5), (2, 3, 4), w, b, [2, 3, 1, 1], 1e-5).view_as(x)
+            grad = torch.randn_like(out)
+            self.assertEqual(out, ref)
+            self.assertEqual(torch.autograd.grad(out, inputs, grad),
+                             torch.autograd.grad(ref, inputs, grad))
+            _assertGradAndGradgradChecks(
+                self, lambda x, *args: F.group_norm(x, 2, *args, eps=1e-5), inputs)
+
+    def test_LayerNorm_GroupNorm_backward(self):
+        self._test_LayerNorm_GroupNorm_backward()
+
+    @unittest.skipIf(not TEST_CUDA, "CUDA unavailable")
+    def test_LayerNorm_GroupNorm_backward_cuda(self):
+        self._test_LayerNorm_GroupNorm_backward("cuda")
+
     def _test_GroupNorm_general(self, device="cpu", dtype=torch.float):
         good_shape_g = {
             (1, 2, 3, 4): 2,
@@ -3591,6 +3897,52 @@ class TestNN(NNTestCase):
     def test_pool_large_size(self, dtype=torch.float):
         self._test_pool_large_size(self, device="cpu")
 
+    def test_pool2d_cpu_vectorized(self):
+        # The inner outputs of stride 1 windows and the channels of channels
+        # last inputs are computed in vectors, the others one at a time.
+        configs = [dict(kernel_size=3, stride=1, padding=1),
+                   dict(kernel_size=3, stride=2, padding=1, ceil_mode=True),
+                   dict(kernel_size=(2, 4), stride=(1, 3), padding=(1, 2)),
+                   dict(kernel_size=2)]
+        for dtype, kwargs, width in product([torch.float, torch.double], configs, [7, 37]):
+            x = torch.randn(2, 19, 11, width, dtype=dtype)
+            x_cl = x.contiguous(memory_format=torch.channels_last)
+            for dilation in [1, 2]:
+                out, indices = F.max_pool2d(x.requires_grad_(), dilation=dilation,
+                                            return_indices=True, **kwargs)
+                # the maxima are the elements at the indices
+                self.assertEqual(out, x.flatten(2).gather(2, indices.flatten(2)).view_as(out))
+                no_grad_out = F.max_pool2d(x.detach(), dilation=dilation, **kwargs)
+                self.assertEqual(out, no_grad_out)
+                out_cl = F.max_pool2d(x_cl, dilation=dilation, **kwargs)
+                self.assertTrue(out_cl.is_contiguous(memory_format=torch.channels_last))
+                self.assertEqual(out, out_cl)
+
+            ceil_mode = kwargs.get('ceil_mode', False)
+            for count_include_pad in [True, False]:
+                avg_kwargs = dict(kwargs, count_include_pad=count_include_pad)
+                out = F.avg_pool2d(x, **avg_kwargs)
+                self.assertEqual(out, F.avg_pool3d(x.unsqueeze(2), **dict(
+                    avg_kwargs, kernel_size=(1,) + _pair(kwargs['kernel_size']),
+                    stride=(1,) + _pair(kwargs.get('stride', kwargs['kernel_size'])),
+                    padding=(0,) + _pair(kwargs.get('padding', 0)))).squeeze(2))
+                out_cl = F.avg_pool2d(x_cl, **avg_kwargs)
+                self.assertTrue(out_cl.is_contiguous(memory_format=torch.channels_last))
+                self.assertEqual(out, out_cl)
+                if count_include_pad and not ceil_mode:
+                    padding = _pair(kwargs.get('padding', 0))
+                    x_padded = F.pad(x, (padding[1], padding[1], padding[0], padding[0]))
+                    kernel_size = _pair(kwargs['kernel_size'])
+                    expected = F.conv2d(
+                        x_padded.view(-1, 1, *x_padded.shape[2:]),
+                        torch.ones(1, 1, *kernel_size, dtype=dtype) / (kernel_size[0] * kernel_size[1]),
+                        stride=kwargs.get('stride', kwargs['kernel_size']))
+                    self.assertEqual(out, expected.view_as(out))
+
+        x = torch.randn(2, 3, 5, 6, 7, dtype=torch.double, requires_grad=True)
+        gradcheck(lambda x: F.avg_pool3d(x, 3, stride=2, padding=1, ceil_mode=True), [x])
+        gradcheck(lambda x: F.max_pool3d(x, 2, stride=1, dilation=2), [x])
+
     def _test_scatter(self, tensor):
         x = tensor.detach().requires_grad_()
         result = dp.scatter(x, (0, 1))
@@ -4711,6 +5063,70 @@ class TestNN(NNTestCase):
                                         m2.weight.grad.data], 0),
                              prec=dtype2prec[dtype])
 
+    def test_Conv2d_depthwise_and_groups_cpu(self):
+        # doubles skip mkldnn, so these take the direct depthwise kernels and
+        # the batched GEMM of grouped convolutions
+        def per_group(x, weight, bias, groups, **kwargs):
+            xs = x.chunk(groups, 1)
+            ws = weight.chunk(groups, 0)
+            bs = bias.chunk(groups, 0) if bias is not None else [None] * groups
+            return torch.cat([F.conv2d(xg, wg, bg, **kwargs) for xg, wg, bg in zip(xs, ws, bs)], 1)
+
+        for channels, groups, multiplier, kernel_size, stride, padding, bias in product(
+                [4], [4, 2], [1, 2], [3, 5], [1, 2], [0, 1, 2], [True, False]):
+            x = torch.randn(2, channels, 11, 13, dtype=torch.double, requires_grad=True)
+            weight = torch.randn(channels * multiplier, channels // groups, kernel_size, kernel_size,
+                                 dtype=torch.double, requires_grad=True)
+            b = torch.randn(channels * multiplier, dtype=torch.double, requires_grad=True) if bias else None
+            kwargs = dict(stride=stride, padding=padding)
+            output = F.conv2d(x, weight, b, groups=groups, **kwargs)
+            expected = per_group(x, weight, b, groups, **kwargs)
+            self.assertEqual(output, expected)
+
+            grad_output = torch.randn_like(output)
+            inputs = (x, weight) + ((b,) if bias else ())
+            grads = torch.autograd.grad(output, inputs, grad_output)
+            expected_grads = torch.autograd.grad(expected, inputs, grad_output)
+            for grad, expected_grad in zip(grads, expected_grads):
+                self.assertEqual(grad, expected_grad)
+
+        x = torch.randn(1, 2, 7, 6, dtype=torch.double, requires_grad=True)
+        weight = torch.randn(4, 1, 3, 3, dtype=torch.double, requires_grad=True)
+        b = torch.randn(4, dtype=torch.double, requires_grad=True)
+        self.assertTrue(gradcheck(lambda x, w, b: torch._depthwise_convolution(x, w, b, [1, 1], [2, 2]),
+                                  (x, weight, b)))
+        self.assertTrue(gradgradcheck(lambda x, w, b: F.conv2d(x, w, b, padding=1, groups=2),
+                                      (x, weight, b)))
+
+    def test_Conv2d_cpu_benchmark(self):
+        # in benchmark mode, CPU convolutions time the algorithms that support
+        # their shape and cache the fastest one: all of them have to agree
+        shapes = [
+            # batch, in_channels, out_channels, kernel_size, stride, padding, groups
+            (1, 8, 16, 3, 1, 1, 1),
+            (1, 8, 16, 3, 2, 0, 1),
+            (3, 8, 8, 3, 1, 1, 8),
+            (2, 8, 4, 5, 2, 2, 2),
+            (1, 3, 6, 1, 1, 0, 1),
+        ]
+        for dtype in [torch.float, torch.double]:
+            for batch, in_channels, out_channels, kernel_size, stride, padding, groups in shapes:
+                m = nn.Conv2d(in_channels, out_channels, kernel_size, stride=stride, padding=padding,
+                              groups=groups).to(dtype)
+                x = torch.randn(batch, in_channels, 12, 10, dtype=dtype, requires_grad=True)
+                with torch.backends.cudnn.flags(enabled=False, benchmark=False):
+                    expected = m(x)
+                    expected_grads = torch.autograd.grad(expected.sum(), (x, m.weight, m.bias))
+                # Winograd (NNPACK) rounds differently from the other algorithms
+                prec = 1e-4 if dtype == torch.float else dtype2prec[dtype]
+                for _ in range(2):  # the second run uses the cached choice
+                    with torch.backends.cudnn.flags(enabled=False, benchmark=True):
+                        output = m(x)
+                        grads = torch.autograd.grad(output.sum(), (x, m.weight, m.bias))
+                    self.assertEqual(output, expected, prec=prec)
+                    for grad, expected_grad in zip(grads, expected_grads):
+                        self.assertEqual(grad, expected_grad, prec=prec)
+
     def test_MaxUnpool2d_output_size(self):
         m = nn.MaxPool2d(3, stride=2, return_indices=True)
         mu = nn.MaxUnpool2d(3, stride=2)
@@ -5051,6 +5467,74 @@ class TestNN(NNTestCase):
                 _compatibility_test(unsorted_sequences, unsorted_sequences_lengths,
                                     batch_first)
 
+    def test_ragged_batch(self):
+        lengths = [3, 5, 3, 0, 2, 5]
+        sequences = [torch.randn(length, 4, dtype=torch.double) for length in lengths]
+        batch = ragged_utils.ragged_batch(sequences)
+        self.assertEqual(batch.offsets, [0, 3, 8, 11, 11, 13, 18])
+        self.assertEqual(batch.lengths(), lengths)
+        for sequence, expected in zip(batch.unbind(), sequences):
+            self.assertEqual(sequence, expected)
+
+        # ops over the steps run on the values
+        linear = nn.Linear(4, 4).double()
+        result = (batch.apply(linear) * 2 + batch).apply(F.layer_norm, (4,))
+        for sequence, expected in zip(result.unbind(), sequences):
+            self.assertEqual(sequence, F.layer_norm(linear(expected) * 2 + expected, (4,)))
+
+        # ops over the sequences are batched by length
+        calls = []
+
+        def mean(x):
+            calls.append(x.shape[:2])
+            return x.mean(1, keepdim=True).expand_as(x)
+        means = ragged_utils.ragged_apply(mean, batch)
+        self.assertEqual(sorted(calls), [(1, 0), (1, 2), (2, 3), (2, 5)])
+        for sequence, expected in zip(means.unbind(), sequences):
+            self.assertEqual(sequence, expected.mean(0, keepdim=True).expand_as(expected))
+        softmax = ragged_utils.ragged_softmax(batch)
+        for sequence, expected in zip(softmax.unbind(), sequences):
+            self.assertEqual(sequence, F.softmax(expected, dim=0))
+
+        padded, padded_lengths = ragged_utils.pad_ragged(batch, batch_first=True)
+        self.assertEqual(padded.shape, (6, 5, 4))
+        self.assertEqual(ragged_utils.ragged_from_padded(padded, padded_lengths, batch_first=True).values,
+                         batch.values)
+        nonempty = ragged_utils.ragged_batch([s for s in sequences if s.size(0) > 0])
+        lstm = nn.LSTM(4, 3).double()
+        output = ragged_utils.ragged_from_packed(lstm(ragged_utils.pack_ragged(nonempty))[0])
+        self.assertEqual(output.offsets, nonempty.offsets)
+        for sequence, expected in zip(output.unbind(), nonempty.unbind()):
+            self.assertEqual(sequence, lstm(expected.unsqueeze(1))[0].squeeze(1))
+
+    def test_ragged_attention(self):
+        def reference(q, k, v, num_heads, causal):
+            q, k, v = [x.view(x.size(0), num_heads, -1).transpose(0, 1) for x in (q, k, v)]
+            weights = torch.matmul(q, k.transpose(1, 2)) / math.sqrt(q.size(-1))
+            if causal:
+                mask = torch.ones(weights.shape[1:], dtype=torch.uint8).triu(1)
+                weights = weights.masked_fill(mask, -inf)
+            return torch.matmul(F.softmax(weights, dim=-1), v).transpose(0, 1).reshape(q.size(1), -1)
+
+        query = ragged_utils.ragged_batch([torch.randn(length, 6, dtype=torch.double)
+                                           for length in [4, 2, 4, 1]])
+        key = ragged_utils.ragged_batch([torch.randn(length, 6, dtype=torch.double)
+                                         for length in [3, 5, 3, 3]])
+        value = key.apply(lambda x: torch.randn(x.size(0), 4, dtype=torch.double))
+        for num_heads, causal in product([1, 2], [False, True]):
+            for q, k, v in [(query, key, value), (query, query, query)]:
+                result = ragged_utils.ragged_attention(q, k, v, num_heads, causal)
+                self.assertEqual(result.offsets, q.offsets)
+                for sequence, args in zip(result.unbind(), zip(q.unbind(), k.unbind(), v.unbind())):
+                    self.assertEqual(sequence, reference(*(args + (num_heads, causal))))
+
+        def attention(q, k, v):
+            return ragged_utils.ragged_attention(
+                ragged_utils.RaggedBatch(q, query.offsets), ragged_utils.RaggedBatch(k, key.offsets),
+                ragged_utils.RaggedBatch(v, key.offsets), num_heads=2).values
+        inputs = [x.values.detach().requires_grad_() for x in (query, key, value)]
+        self.assertTrue(gradcheck(attention, inputs))
+
     def test_pack_padded_sequence(self):
         def generate_test_case(sorted_lengths, should_shuffle):
             def pad(tensor, length):
@@ -5287,6 +5771,38 @@ class TestNN(NNTestCase):
             weight_data[:] = 4
             self.assertEqual(weight_data, all_vars[4].data)
 
+    @unittest.skipIf(not TEST_CUDNN, 'CUDNN not available')
+    @skipIfRocm
+    def test_cudnn_weight_format_inference(self):
+        # In inference, the copy of weights that aren't flattened is kept
+        # across calls; it must follow in-place updates of the weights
+        rnn = nn.LSTM(10, 20, num_layers=2).cuda().eval()
+        weight = rnn.weight_hh_l0
+        with torch.no_grad():
+            weight.set_(weight.data.clone())
+        input = torch.randn(3, 4, 10, device='cuda')
+
+        def check():
+            with warnings.catch_warnings(record=True):
+                output = rnn(input)[0]
+            rnn_cpu = deepcopy(rnn).cpu()
+            self.assertEqual(output.cpu(), rnn_cpu(input.cpu())[0])
+            return output
+
+        output = check()
+        self.assertEqual(check(), output)
+        with torch.no_grad():
+            weight.mul_(0.5)
+        self.assertNotEqual(check(), output)
+        # updates through .data don't bump the version counter, but follow
+        # a training call
+        rnn.train()
+        with warnings.catch_warnings(record=True):
+            rnn(input)
+        rnn.eval()
+        weight.data.mul_(0.5)
+        check()
+
     @unittest.skipIf(not TEST_CUDNN, 'CUDNN not available')
     def test_cudnn_weight_tying(self):
         rnns = [
@@ -5527,6 +6043,27 @@ class TestNN(NNTestCase):
             self._test_rnn_retain_variables("cuda", dtype)
         self._test_rnn_retain_variables("cuda", dtype)
 
+    @unittest.skipIf(not TEST_CUDA, 'CUDA not available')
+    def test_RNN_persistent_cuda(self):
+        # Small batches in eval mode run on the persistent kernels
+        for module in (nn.LSTM, nn.GRU, nn.RNN):
+            for bidirectional, batch_first in product((False, True), (False, True)):
+                rnn = module(10, 16, num_layers=2, bidirectional=bidirectional,
+                             batch_first=batch_first).double().eval()
+                input = torch.randn(5, 4, 10, dtype=torch.double)
+                num_directions = 2 if bidirectional else 1
+                hx = torch.randn(2 * num_directions, 4, 16, dtype=torch.double)
+                if batch_first:
+                    input = input.transpose(0, 1).contiguous()
+                hidden = (hx, torch.randn_like(hx)) if module is nn.LSTM else hx
+                with torch.no_grad():
+                    expected = rnn(input, hidden)
+                    rnn_cuda = rnn.cuda()
+                    hidden_cuda = tuple(h.cuda() for h in hidden) if module is nn.LSTM else hidden.cuda()
+                    output = rnn_cuda(input.cuda(), hidden_cuda)
+                self.assertEqual(output[0], expected[0])
+                self.assertEqual(output[1], expected[1])
+
     def _test_RNN_cpu_vs_cudnn(self, dropout):
 
         def forward_backward(cuda, rnn, input_val, hx_val, grad_output, grad_hy, weights_val):
@@ -6115,6 +6652,51 @@ class TestNN(NNTestCase):
     def test_batchnorm_update_stats(self):
         self._test_batchnorm_update_stats()
 
+    def test_batchnorm_channels_last_cpu(self):
+        # few channels with a large image, and an input that is neither
+        # contiguous nor channels last
+        inputs = [torch.randn(2, 19, 6, 5, dtype=torch.double),
+                  torch.randn(1, 3, 97, 131, dtype=torch.double) * 10 + 5,
+                  torch.randn(4, 8, 5, 7, dtype=torch.double).transpose(2, 3)]
+        for x, train in product(inputs, [True, False]):
+            bn = nn.BatchNorm2d(x.size(1)).double()
+            bn.running_var.uniform_(0.5, 2)
+            bn.weight.data.uniform_()
+            bn.train(train)
+            bn_cl = deepcopy(bn)
+            x = x.requires_grad_()
+            x_cl = x.detach().contiguous(memory_format=torch.channels_last).requires_grad_()
+
+            out = bn(x)
+            out_cl = bn_cl(x_cl)
+            self.assertTrue(out_cl.is_contiguous(memory_format=torch.channels_last))
+            self.assertEqual(out, out_cl)
+            self.assertEqual(bn.running_mean, bn_cl.running_mean)
+            self.assertEqual(bn.running_var, bn_cl.running_var)
+
+            # reference with the mean and the variance computed by reductions
+            dims = [0, 2, 3]
+            mean = x.detach().mean(dims, keepdim=True)
+            var = x.detach().var(dims, unbiased=False, keepdim=True)
+            if not train:
+                mean = bn.running_mean.view(1, -1, 1, 1)
+                var = bn.running_var.view(1, -1, 1, 1)
+            expected = (x.detach() - mean) / (var + bn.eps).sqrt() * bn.weight.view(1, -1, 1, 1) + bn.bias.view(1, -1, 1, 1)
+            self.assertEqual(out, expected)
+
+            grad = torch.randn_like(out)
+            out.backward(grad)
+            out_cl.backward(grad.contiguous(memory_format=torch.channels_last))
+            self.assertEqual(x.grad, x_cl.grad)
+            self.assertEqual(bn.weight.grad, bn_cl.weight.grad)
+            self.assertEqual(bn.bias.grad, bn_cl.bias.grad)
+
+        x = torch.randn(2, 3, 4, 4, dtype=torch.double).contiguous(memory_format=torch.channels_last)
+        x.requires_grad_()
+        weight = torch.rand(3, dtype=torch.double, requires_grad=True)
+        bias = torch.rand(3, dtype=torch.double, requires_grad=True)
+        gradcheck(lambda x, w, b: F.batch_norm(x, None, None, w, b, training=True), [x, weight, bias])
+
     @unittest.skipIf(not TEST_CUDA, "CUDA unavailable")
     def test_batchnorm_update_stats_cuda(self):
         self._test_batchnorm_update_stats("cuda", torch.float)
@@ -7102,6 +7684,29 @@ class TestNN(NNTestCase):
             out_t_5 = m(in_t_9[:, :, :5, :5])
         self.assertEqual(out_t_9[:, :, :15, :15], out_t_5)
 
+    def test_upsampling2d_channels_last_cpu(self):
+        modes = [dict(mode='nearest'),
+                 dict(mode='bilinear', align_corners=True),
+                 dict(mode='bilinear', align_corners=False)]
+        for dtype, kwargs, size in product([torch.float, torch.double], modes, [(5, 7), (13, 4)]):
+            x = torch.randn(2, 19, 6, 5, dtype=dtype)
+            x_cl = x.contiguous(memory_format=torch.channels_last).requires_grad_()
+            x = x.requires_grad_()
+
+            out = F.interpolate(x, size, **kwargs)
+            out_cl = F.interpolate(x_cl, size, **kwargs)
+            self.assertTrue(out_cl.is_contiguous(memory_format=torch.channels_last))
+            self.assertEqual(out, out_cl)
+
+            grad = torch.randn_like(out)
+            out.backward(grad)
+            out_cl.backward(grad.contiguous(memory_format=torch.channels_last))
+            self.assertEqual(x.grad, x_cl.grad)
+
+        x = torch.randn(1, 3, 4, 4, dtype=torch.double).contiguous(memory_format=torch.channels_last)
+        x.requires_grad_()
+        gradcheck(lambda x: F.interpolate(x, (7, 3), mode='bilinear', align_corners=False), [x])
+
     def test_upsamplingNearest3d(self):
         m = nn.Upsample(size=4, mode='nearest')
         in_t = torch.ones(1, 1, 2, 2, 2)
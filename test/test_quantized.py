@@ -121,5 +121,107 @@ class TestQuantizedOps(unittest.TestCase):
         np.testing.assert_equal(qC, qC_hat.int_repr())
 
 
+class TestQuantizedKernels(unittest.TestCase):
+    """Tests the quantized kernels against the float ops on the dequantized
+    operands. QNNPACK and FBGEMM round with fixed point arithmetic, so the
+    results may be off by one."""
+    def assertQuantizedClose(self, qY_hat, Y, scale, zero_point):
+        qY = _quantize(Y, scale, zero_point)
+        diff = np.abs(qY_hat.int_repr().numpy().astype(np.int32) - qY.astype(np.int32))
+        self.assertLessEqual(diff.max(), 1)
+
+    def test_qadd(self):
+        A = torch.randn(3, 40) * 10
+        B = torch.randn(3, 40) * 10
+        qA = A.quantize_linear(scale=0.2, zero_point=100)
+        qB = B.quantize_linear(scale=0.15, zero_point=130)
+        scale, zero_point = 0.3, 120
+        C = (qA.dequantize() + qB.dequantize()).numpy()
+        qC_hat = torch.ops.quantized.add(qA, qB, scale=scale, zero_point=zero_point)
+        self.assertQuantizedClose(qC_hat, C, scale, zero_point)
+        self.assertAlmostEqual(qC_hat.q_scale(), scale)
+        self.assertEqual(qC_hat.q_zero_point(), zero_point)
+
+        C[C < 0] = 0
+        qC_hat = torch.ops.quantized.add_relu(qA, qB, scale=scale, zero_point=zero_point)
+        self.assertQuantizedClose(qC_hat, C, scale, zero_point)
+
+    def test_qlinear(self):
+        X = torch.rand(5, 3, 20) * 4 - 2
+        W = torch.randn(7, 20) * 0.5
+        b = torch.randn(7)
+        qX = X.quantize_linear(scale=0.02, zero_point=110)
+        qW = W.quantize_linear(scale=0.01, zero_point=125)
+        W_prepack = torch.ops.quantized.linear_prepack(qW)
+        scale, zero_point = 0.1, 128
+        Y = torch.nn.functional.linear(qX.dequantize(), qW.dequantize(), b).numpy()
+        qY_hat = torch.ops.quantized.linear(qX, W_prepack, b, scale, zero_point)
+        self.assertEqual(qY_hat.shape, (5, 3, 7))
+        self.assertQuantizedClose(qY_hat, Y, scale, zero_point)
+
+        Y[Y < 0] = 0
+        qY_hat = torch.ops.quantized.linear_relu(qX, W_prepack, b, scale, zero_point)
+        self.assertQuantizedClose(qY_hat, Y, scale, zero_point)
+
+    def test_qconv2d(self):
+        X = torch.rand(2, 4, 9, 8) * 4 - 2
+        b = torch.randn(6)
+        qX = X.quantize_linear(scale=0.02, zero_point=110)
+        scale, zero_point = 0.2, 128
+        for groups, dilation in [(1, 1), (2, 1), (1, 2)]:
+            W = torch.randn(6, 4 // groups, 3, 3) * 0.5
+            qW = W.quantize_linear(scale=0.01, zero_point=125)
+            W_prepack = torch.ops.quantized.conv2d_prepack(qW, groups)
+            Y = torch.nn.functional.conv2d(qX.dequantize(), qW.dequantize(), b, stride=[2, 1],
+                                           padding=[1, 1], dilation=dilation, groups=groups)
+            qY_hat = torch.ops.quantized.conv2d(qX, W_prepack, b, [2, 1], [1, 1],
+                                                [dilation, dilation], scale, zero_point)
+            self.assertEqual(qY_hat.shape, Y.shape)
+            self.assertQuantizedClose(qY_hat, Y.numpy(), scale, zero_point)
+
+    def test_qconv2d_reuses_prepacked_weight(self):
+        # QNNPACK caches its operator in the prepacked weight, which must be
+        # recreated when the bias or the output parameters change
+        X = torch.rand(1, 8, 6, 6) * 4 - 2
+        W = torch.randn(8, 8, 3, 3) * 0.5
+        qX = X.quantize_linear(scale=0.02, zero_point=110)
+        qW = W.quantize_linear(scale=0.01, zero_point=125)
+        W_prepack = torch.ops.quantized.conv2d_prepack(qW, 1)
+        for b, scale, zero_point in [(torch.randn(8), 0.2, 128),
+                                     (torch.randn(8), 0.2, 128),
+                                     (None, 0.3, 100)]:
+            Y = torch.nn.functional.conv2d(qX.dequantize(), qW.dequantize(), b, padding=1)
+            qY_hat = torch.ops.quantized.conv2d(qX, W_prepack, b, [1, 1], [1, 1], [1, 1],
+                                                scale, zero_point)
+            self.assertQuantizedClose(qY_hat, Y.numpy(), scale, zero_point)
+
+    def test_qmax_pool2d(self):
+        X = torch.randn(2, 3, 10, 9)
+        qX = X.quantize_linear(scale=0.05, zero_point=128)
+        Y = torch.nn.functional.max_pool2d(qX.dequantize(), kernel_size=3, stride=2, padding=1)
+        qY_hat = torch.ops.quantized.max_pool2d(qX, [3, 3], [2, 2], [1, 1], [1, 1])
+        np.testing.assert_equal(qY_hat.int_repr().numpy(), _quantize(Y.numpy(), 0.05, 128))
+        self.assertAlmostEqual(qY_hat.q_scale(), 0.05)
+
+    def test_qavg_pool2d(self):
+        X = torch.randn(2, 3, 10, 9)
+        qX = X.quantize_linear(scale=0.05, zero_point=128)
+        Y = torch.nn.functional.avg_pool2d(qX.dequantize(), kernel_size=3, stride=2, padding=1)
+        qY_hat = torch.ops.quantized.avg_pool2d(qX, [3, 3], [2, 2], [1, 1])
+        self.assertEqual(qY_hat.shape, Y.shape)
+        self.assertQuantizedClose(qY_hat, Y.numpy(), 0.05, 128)
+
+    def test_qcat(self):
+        A = torch.randn(2, 3, 4)
+        B = torch.randn(2, 5, 4)
+        qA = A.quantize_linear(scale=0.05, zero_point=128)
+        qB = B.quantize_linear(scale=0.03, zero_point=100)
+        # the first operand has the output parameters and is copied
+        qC_hat = torch.ops.quantized.cat([qA, qB], 1, 0.05, 128)
+        np.testing.assert_equal(qC_hat.int_repr()[:, :3].numpy(), qA.int_repr().numpy())
+        C = torch.cat([qA.dequantize(), qB.dequantize()], 1).numpy()
+        self.assertQuantizedClose(qC_hat, C, 0.05, 128)
+
+
 if __name__ == '__main__':
     run_tests()
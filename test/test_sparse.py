@@ -814,6 +814,24 @@ class TestSparse(TestCase):
         test_shape(10, 100, 0, 0)
         test_shape(10, 100, 0, 20)
 
+    def test_mm_skewed_rows(self):
+        # a few rows hold most of the nonzeros, and the rows are in no order
+        di, dj, dk = 300, 200, 70
+        rows = torch.cat([torch.zeros(5000, dtype=torch.long),
+                          torch.full((3000,), di - 1, dtype=torch.long),
+                          torch.randint(0, di, (2000,))])
+        cols = torch.randint(0, dj, (rows.numel(),))
+        perm = torch.randperm(rows.numel())
+        indices = torch.stack([rows, cols])[:, perm].to(self.device)
+        values = torch.randn(rows.numel(), device=self.device)
+        x = torch.sparse_coo_tensor(indices, values, (di, dj))
+        dense_x = self.safeToDense(x)
+        for y in [torch.randn(dj, dk, device=self.device),
+                  torch.randn(dk, dj, device=self.device).t()]:
+            t = torch.randn(di, dk, device=self.device)
+            self.assertEqual(torch.addmm(t, x, y, beta=0.5, alpha=2), torch.addmm(t, dense_x, y, beta=0.5, alpha=2))
+            self.assertEqual(torch.mm(x.coalesce(), y), torch.mm(dense_x, y))
+
     @cpu_only
     def test_saddmm(self):
         def test_shape(di, dj, dk, nnz):
@@ -1168,6 +1186,25 @@ class TestSparse(TestCase):
         test_shape([3, 4], [1, 4], [4, 4, 4], [3, 4, 4])
         test_shape([3, 4, 0], [1, 4], [4, 4, 4, 0], [3, 4, 4, 0])
 
+    def test_add_dense_sparse_duplicates(self):
+        # like the sparse gradient of an embedding, with many repeated rows
+        num_rows, dim = 1000, 16
+        indices = torch.randint(0, 50, (1, 40000), device=self.device)
+        indices[0, ::7] = torch.randint(0, num_rows, (indices[0, ::7].numel(),), device=self.device)
+        values = torch.randn(indices.size(1), dim, dtype=self.value_dtype, device=self.device)
+        x = self.sparse_tensor(indices, values, torch.Size([num_rows, dim]))
+        self.assertFalse(x.is_coalesced())
+
+        y = x.coalesce()
+        self.assertTrue(y.is_coalesced())
+        self.assertEqual(y._indices(), indices.unique(sorted=True).view(1, -1))
+        expected = torch.zeros(num_rows, dim, dtype=self.value_dtype, device=self.device).index_add_(0, indices[0], values)
+        self.assertEqual(self.safeToDense(y), expected)
+
+        w = torch.randn(num_rows, dim, dtype=self.value_dtype, device=self.device)
+        self.assertEqual(w + x, w + expected)
+        self.assertEqual(w.clone().add_(-0.1, x), w - 0.1 * expected)
+
     def test_add_noncontiguous(self):
         indices = self.index_tensor([[1, 2], [0, 2]])
         values = self.value_tensor([1.]).expand(2, 3, 4, 5)
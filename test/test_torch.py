@@ -22,10 +22,11 @@ from torch._utils import _rebuild_tensor
 from torch._six import inf, nan, string_classes, istuple
 from itertools import product, combinations, combinations_with_replacement
 from functools import reduce
+from contextlib import contextmanager
 from torch import multiprocessing as mp
 from common_methods_invocations import tri_tests_args, run_additional_tri_tests, \
     _compare_trilu_indices
-from common_utils import TestCase, iter_indices, TEST_NUMPY, TEST_SCIPY, TEST_MKL, \
+from common_utils import TestCase, iter_indices, TEST_NUMPY, TEST_SCIPY, \
     TEST_LIBROSA, run_tests, download_file, skipIfNoLapack, suppress_warnings, \
     IS_WINDOWS, PY3, NO_MULTIPROCESSING_SPAWN, skipIfRocm, do_test_dtypes, do_test_empty_full, \
     IS_SANDCASTLE, load_tests, brute_pdist, brute_cdist, slowTest
@@ -1306,6 +1307,42 @@ class _TestTorchMixin(object):
             self.assertTrue(y.is_contiguous())
             self.assertTrue(torch.allclose(expected, actual))
 
+    def test_cdist_compute_mode(self):
+        for device in torch.testing.get_all_device_types():
+            x = torch.randn(30, 10, device=device) * 100
+            # rows close to the ones of x, whose distances would be lost to
+            # cancellation in the GEMM
+            y = torch.cat([x[:10] + 1e-3 * torch.randn(10, 10, device=device),
+                           torch.randn(20, 10, device=device)])
+            expected = brute_cdist(x, y, p=2)
+            for compute_mode in [None, 0, 1, 2]:
+                actual = torch.cdist(x, y, p=2, compute_mode=compute_mode)
+                self.assertTrue(torch.allclose(expected, actual, rtol=1e-4))
+                self.assertEqual(torch.cdist(x, x, p=2, compute_mode=compute_mode).diag(),
+                                 torch.zeros(30, device=device))
+            with self.assertRaisesRegex(RuntimeError, 'invalid compute_mode'):
+                torch.cdist(x, y, compute_mode=3)
+
+    def test_cdist_topk(self):
+        for device in torch.testing.get_all_device_types():
+            x = torch.randn(50, 8, device=device)
+            # more than one tile of rows of y for 5000
+            for r2 in [70, 5000]:
+                y = torch.randn(r2, 8, device=device)
+                for p in [1, 2]:
+                    for k in [0, 1, 5, 70]:
+                        expected_values, expected_indices = torch.cdist(x, y, p=p).topk(k, 1, largest=False)
+                        values, indices = torch.cdist_topk(x, y, k, p=p)
+                        self.assertEqual(expected_values, values)
+                        self.assertEqual(expected_indices, indices)
+
+            x.requires_grad_()
+            values, indices = torch.cdist_topk(x, y, 3)
+            grad, = torch.autograd.grad(values.sum(), x)
+            x_ = x.detach().requires_grad_()
+            expected_grad, = torch.autograd.grad(torch.cdist(x_, y).gather(1, indices).sum(), x_)
+            self.assertEqual(expected_grad, grad)
+
     @unittest.skipIf(not TEST_SCIPY, "Scipy not found")
     def test_logsumexp(self):
         from scipy.special import logsumexp
@@ -1530,6 +1567,33 @@ class _TestTorchMixin(object):
         res_csub.sub_(scalar)
         self.assertEqual(res_add, res_csub)
 
+    def test_repeated_elementwise_ops(self):
+        # TensorIterator reuses the plans of operands with the same types,
+        # shapes and strides, which must not leak the tensors or the outputs
+        # of the previous calls. The expected values are computed in double,
+        # which doesn't share these plans.
+        for _ in range(3):
+            a = torch.randn(5, 7)
+            b = torch.randn(7)
+            self.assertEqual(torch.add(a, b), (a.double() + b.double()).float())
+            self.assertEqual(a.t() + 1, (a.double().t() + 1).float())
+            self.assertEqual(a.exp().neg(), a.double().exp().neg().float())
+
+            # the same tensor as an output and as an input
+            expected = a.double() * 2
+            a.add_(a)
+            self.assertEqual(a, expected.float())
+
+            # an output resized by the op
+            out = torch.empty(0)
+            torch.mul(a, b, out=out)
+            self.assertEqual(out, (a.double() * b.double()).float())
+
+            # a 0-dim input converted to the type of the op
+            one = torch.tensor(1, dtype=torch.double)
+            self.assertEqual((a + one).dtype, torch.float)
+            self.assertEqual(a + one, (a.double() + 1).float())
+
     @staticmethod
     def _test_neg(self, cast):
         float_types = [torch.DoubleTensor, torch.FloatTensor, torch.LongTensor]
@@ -1848,6 +1912,25 @@ class _TestTorchMixin(object):
             self.assertRaises(RuntimeError, lambda: torch.bmm(b1, b2.cuda()))
             self.assertRaises(RuntimeError, lambda: torch.bmm(b1.cuda(), b2))
 
+    def test_bmm_small_matrices(self):
+        # sizes handled by the small matrix kernel, with row and column tails,
+        # and transposed or strided batches
+        for dtype in [torch.float, torch.double]:
+            for M, N, O in [(1, 1, 1), (3, 5, 7), (8, 8, 8), (13, 17, 33), (64, 64, 64)]:
+                b1 = torch.randn(6, M, N, dtype=dtype)
+                b2 = torch.randn(6, N, O, dtype=dtype)
+                b2_t = b2.transpose(1, 2).contiguous().transpose(1, 2)
+                b1_s = torch.randn(6, M, 2 * N, dtype=dtype)[:, :, ::2]
+                b1_s.copy_(b1)
+                expected = torch.stack([torch.mm(b1[i], b2[i]) for i in range(6)])
+                self.assertEqual(expected, torch.bmm(b1, b2))
+                self.assertEqual(expected, torch.bmm(b1_s, b2_t))
+                res = torch.randn(6, M, O, dtype=dtype)
+                self.assertEqual(res * .1 + expected * .5,
+                                 torch.baddbmm(.1, res, .5, b1, b2_t))
+                res.fill_(float('nan'))
+                self.assertEqual(expected, torch.baddbmm(0, res, 1, b1, b2))
+
     def test_addbmm(self):
         # num_batches = 10
         # M, N, O = 12, 8, 5
@@ -2253,6 +2336,23 @@ class _TestTorchMixin(object):
             lambda t, d: t.sum(d),
             lambda n, d: n.sum(d))
 
+    def test_reduction_few_outputs(self):
+        # reductions into fewer outputs than threads split the reduced
+        # dimension between threads instead of the outputs
+        for dtype in [torch.float, torch.double, torch.int64]:
+            for shape, dim in [((100000, 3), 0), ((100000, 17), 0), ((3, 100000), 1),
+                               ((500, 2, 300), (0, 2)), ((2, 300, 500), (1, 2))]:
+                x = torch.randn(shape, dtype=torch.double).mul_(10)
+                for t in [x, x.transpose(0, -1).contiguous().transpose(0, -1)]:
+                    ref = t.to(dtype).double()
+                    t = t.to(dtype)
+                    self.assertEqual(t.sum(dim).double(), ref.sum(dim), 1e-3 * t.numel())
+                    if isinstance(dim, int):
+                        self.assertEqual(t.max(dim)[0].double(), ref.max(dim)[0])
+                    if dtype.is_floating_point:
+                        self.assertEqual(t.mean(dim).double(), ref.mean(dim), 1e-3)
+                        self.assertEqual(t.norm(2, dim).double(), ref.norm(2, dim), 1e-3 * t.numel())
+
     @unittest.skipIf(not TEST_NUMPY, 'Numpy not found')
     def test_mean_dim(self):
         self._test_dim_ops(
@@ -2540,6 +2640,10 @@ class _TestTorchMixin(object):
             expanded = torch.randn(1, 5, 1, 2, device=device).expand(3, 5, 7, 2)
             test_against_np(expanded)
 
+            # large enough to be split between threads
+            test_against_np(torch.randn(300000, device=device), bins=1000)
+            test_against_np(torch.randn(300000, dtype=torch.double, device=device), bins=7)
+
     def test_histc_cpu(self):
         self._test_histc(self, 'cpu')
 
@@ -2630,6 +2734,11 @@ class _TestTorchMixin(object):
         self.assertRaises(RuntimeError, lambda: torch.device('cuda', -1))
         self.assertRaises(RuntimeError, lambda: torch.device(-1))
 
+        vulkan0 = torch.device('vulkan:0')
+        self.assertEqual('vulkan:0', str(vulkan0))
+        self.assertEqual('vulkan', vulkan0.type)
+        self.assertEqual(0, vulkan0.index)
+
         self.assertRaises(RuntimeError, lambda: torch.device('other'))
         self.assertRaises(RuntimeError, lambda: torch.device('other:0'))
 
@@ -4022,6 +4131,46 @@ class _TestTorchMixin(object):
     def test_contiguous(self):
         return self._test_contiguous(self, lambda t: t)
 
+    def test_memory_format(self):
+        for device in torch.testing.get_all_device_types():
+            x = torch.randn(4, 3, 8, 8, device=device)
+            nhwc = x.contiguous(memory_format=torch.channels_last)
+            self.assertEqual(nhwc.stride(), (192, 1, 24, 3))
+            self.assertTrue(nhwc.is_contiguous(memory_format=torch.channels_last))
+            self.assertFalse(nhwc.is_contiguous())
+            self.assertEqual(nhwc, x)
+            self.assertEqual(nhwc.contiguous().stride(), x.stride())
+            # contiguous returns the input when it already has the format
+            self.assertIs(nhwc.contiguous(memory_format=torch.channels_last), nhwc)
+
+            y = torch.empty(4, 3, 8, 8, device=device, memory_format=torch.channels_last)
+            self.assertEqual(y.stride(), nhwc.stride())
+            self.assertRaises(RuntimeError, lambda: torch.empty(3, 8, 8, memory_format=torch.channels_last))
+
+            # a single channel is both contiguous and channels last
+            z = torch.empty(4, 1, 8, 8, device=device, memory_format=torch.channels_last)
+            self.assertTrue(z.is_contiguous())
+            self.assertTrue(z.is_contiguous(memory_format=torch.channels_last))
+
+            # element-wise results keep the format of their input
+            self.assertTrue((nhwc + 1).is_contiguous(memory_format=torch.channels_last))
+            self.assertTrue(nhwc.relu().is_contiguous(memory_format=torch.channels_last))
+
+    def test_memory_format_conv_bn(self):
+        for device in torch.testing.get_all_device_types():
+            x = torch.randn(2, 4, 9, 9, device=device)
+            conv = torch.nn.Conv2d(4, 6, 3, padding=1).to(device)
+            bn = torch.nn.BatchNorm2d(6).to(device).eval()
+            nhwc = x.contiguous(memory_format=torch.channels_last)
+            out = conv(nhwc)
+            self.assertTrue(out.is_contiguous(memory_format=torch.channels_last))
+            self.assertEqual(out, conv(x))
+            bn_out = bn(out)
+            self.assertTrue(bn_out.is_contiguous(memory_format=torch.channels_last))
+            self.assertEqual(bn_out, bn(conv(x)))
+            pool_out = torch.nn.functional.max_pool2d(bn_out, 2)
+            self.assertTrue(pool_out.is_contiguous(memory_format=torch.channels_last))
+
     def test_empty_tensor_props(self):
         sizes = [(0,), (0, 3), (5, 0), (5, 0, 3, 0, 2), (0, 3, 0, 2), (0, 5, 0, 2, 0)]
         for size in sizes:
@@ -4159,6 +4308,40 @@ class _TestTorchMixin(object):
         torch.zeros(5, 6).copy_(torch.zeros(6))
         self.assertRaises(RuntimeError, lambda: torch.zeros(5, 6).copy_(torch.zeros(30)))
 
+    def test_copy_permuted(self):
+        # permute + contiguous is a batched transpose on CPU; check it against
+        # the offsets of the permuted elements computed by broadcasting
+        def expected_offsets(t):
+            offsets = torch.zeros(t.size(), dtype=torch.long)
+            for d in range(t.dim()):
+                shape = [1] * t.dim()
+                shape[d] = t.size(d)
+                offsets = offsets + torch.arange(t.size(d)).view(shape) * t.stride(d)
+            return offsets
+
+        cases = [
+            ((4, 33, 17, 9), (0, 2, 3, 1)),
+            ((4, 17, 9, 33), (0, 3, 1, 2)),
+            ((3, 70, 50), (2, 1, 0)),
+            ((2, 5, 12, 7, 11), (0, 2, 1, 4, 3)),
+            ((2, 5, 12, 7, 11), (4, 3, 2, 1, 0)),
+            ((8, 40, 6, 16), (0, 2, 1, 3)),
+            ((1, 64, 1, 40), (3, 1, 2, 0)),
+        ]
+        for dtype in [torch.uint8, torch.int16, torch.half, torch.float, torch.double, torch.int64]:
+            for sizes, perm in cases:
+                n = reduce(lambda a, b: a * b, sizes)
+                x = (torch.arange(n) % 100).view(sizes)
+                p = x.to(dtype).permute(perm)
+                expected = expected_offsets(p) % 100
+                self.assertEqual(p.contiguous().long(), expected)
+                out = torch.empty(p.size(), dtype=dtype)
+                out.copy_(p)
+                self.assertEqual(out.long(), expected)
+                # a transposed, expanded source
+                q = x.to(dtype).select(0, 0).unsqueeze(0).expand(sizes).permute(perm)
+                self.assertEqual(q.contiguous().long(), expected_offsets(q) % 100)
+
     def test_randperm(self):
         _RNGState = torch.get_rng_state()
         res1 = torch.randperm(100)
@@ -4370,6 +4553,57 @@ class _TestTorchMixin(object):
         # Make sure True isn't mistakenly taken as the 2nd dimension (interpreted as 1)
         self.assertRaises(TypeError, lambda: q.topk(4, True))
 
+    @unittest.skipIf(not TEST_NUMPY, "Numpy not found")
+    def test_sort_topk_radix(self):
+        # the CPU sort is a stable radix sort, so its indices match numpy's
+        # mergesort; NaN is ordered above everything else
+        for dtype in [torch.uint8, torch.int8, torch.int16, torch.int32, torch.int64, torch.float, torch.double]:
+            for sizes in [(3, 1000), (100, 12), (1, 65), (5, 0)]:
+                if dtype.is_floating_point:
+                    x = torch.randn(sizes, dtype=dtype).mul_(4).round_()
+                    x.view(-1)[::7] = float('nan')
+                    x.view(-1)[::11] = float('inf')
+                else:
+                    x = torch.randint(0 if dtype == torch.uint8 else -100, 100, sizes, dtype=dtype)
+                for dim in [-1, 0]:
+                    values, indices = x.sort(dim)
+                    expected = np.argsort(x.numpy(), axis=dim, kind='mergesort')
+                    self.assertEqual(indices, torch.from_numpy(expected))
+                    self.assertEqual(values, x.gather(dim, indices))
+                    self.assertEqual(x.argsort(dim), indices)
+
+                    values_desc, indices_desc = x.sort(dim, descending=True)
+                    self.assertEqual(values_desc, values.flip(dim))
+                    self.assertEqual(values_desc, x.gather(dim, indices_desc))
+
+                    n = x.size(dim)
+                    for k in [0, 1, n // 2, n]:
+                        for largest in [True, False]:
+                            top, top_indices = x.topk(k, dim, largest=largest)
+                            ref = values_desc if largest else values
+                            self.assertEqual(top, ref.narrow(dim, 0, k))
+                            self.assertEqual(top, x.gather(dim, top_indices))
+                            unsorted, unsorted_indices = x.topk(k, dim, largest=largest, sorted=False)
+                            self.assertEqual(unsorted.sort(dim, descending=largest)[0], top)
+                            self.assertEqual(unsorted, x.gather(dim, unsorted_indices))
+                    if x.numel() > 0:
+                        for k in [1, (n + 1) // 2, n]:
+                            kth, kth_index = x.kthvalue(k, dim, keepdim=True)
+                            self.assertEqual(kth, values.narrow(dim, k - 1, 1))
+                            self.assertEqual(kth, x.gather(dim, kth_index))
+
+        # out= variants, including a noncontiguous output and one aliasing the input
+        x = torch.randn(50, 300)
+        values = torch.empty(300, 50).t()
+        indices = torch.empty(50, 300, dtype=torch.long)
+        torch.sort(x, 1, out=(values, indices))
+        self.assertEqual(values, x.sort(1)[0])
+        y = x.clone()
+        torch.topk(y, 10, out=(y, indices))
+        self.assertEqual(y, x.topk(10)[0])
+        self.assertEqual(indices, x.topk(10)[1])
+        self.assertRaises(RuntimeError, lambda: x.topk(301))
+
     @unittest.skipIf(not torch.cuda.is_available(), 'no CUDA')
     def test_topk_noncontiguous_gpu(self):
         t = torch.randn(20, device="cuda")[::2]
@@ -4623,6 +4857,30 @@ class _TestTorchMixin(object):
             self.assertRaises(RuntimeError, lambda: torch.cat([]))
             self.assertRaisesRegex(TypeError, 'got None', lambda: torch.cat([x, None]))
 
+    def test_cat_many_small_inputs(self):
+        # contiguous inputs are copied in parallel blocks that may start and
+        # end in the middle of an input; compare with the non-contiguous path
+        for dtype in (torch.float, torch.int64, torch.uint8):
+            for dim in range(3):
+                inputs = []
+                for i in range(300):
+                    size = [16, 20, 12]
+                    size[dim] = i % 4
+                    inputs.append(torch.randint(100, size).to(dtype))
+                inputs.append(torch.empty(0, dtype=dtype))  # legacy empty tensors are skipped
+                non_contiguous = [t.transpose(0, 1).contiguous().transpose(0, 1) if t.dim() > 1 else t
+                                  for t in inputs]
+                expected = torch.cat(non_contiguous, dim)
+                actual = torch.cat(inputs, dim)
+                self.assertEqual(actual, expected, 0)
+
+                # out= with a result of the right size keeps its buffer
+                out = torch.empty_like(actual)
+                ptr = out.data_ptr()
+                torch.cat(inputs, dim, out=out)
+                self.assertEqual(out, expected, 0)
+                self.assertEqual(out.data_ptr(), ptr)
+
     def test_cat_bad_input_sizes(self):
         x = torch.randn(2, 1)
         y = torch.randn(2, 1, 1)
@@ -6094,10 +6352,45 @@ class _TestTorchMixin(object):
         _test_complex((50,), 2, lambda x: x.as_strided([5, 5, 2], [4, 2, 2]))
         _test_complex((50,), 2, lambda x: x.as_strided([5, 5, 2], [4, 3, 1]))
 
-    @unittest.skipIf(not TEST_MKL, "PyTorch is built without MKL support")
     def test_fft_ifft_rfft_irfft(self):
         self._test_fft_ifft_rfft_irfft(self)
 
+        @contextmanager
+        def plan_cache_max_size(n):
+            plan_cache = torch.backends.cpu.fft_plan_cache
+            original = plan_cache.max_size
+            plan_cache.max_size = n
+            yield
+            plan_cache.max_size = original
+
+        with plan_cache_max_size(max(1, torch.backends.cpu.fft_plan_cache.size - 10)):
+            self._test_fft_ifft_rfft_irfft(self)
+
+        with plan_cache_max_size(0):
+            self._test_fft_ifft_rfft_irfft(self)
+            self.assertEqual(torch.backends.cpu.fft_plan_cache.size, 0)
+
+        torch.backends.cpu.fft_plan_cache.clear()
+        self.assertEqual(torch.backends.cpu.fft_plan_cache.size, 0)
+
+        # check that still works after clearing cache
+        with plan_cache_max_size(10):
+            self._test_fft_ifft_rfft_irfft(self)
+            self.assertLessEqual(torch.backends.cpu.fft_plan_cache.size, 10)
+
+        with self.assertRaisesRegex(RuntimeError, r"must be non-negative"):
+            torch.backends.cpu.fft_plan_cache.max_size = -1
+
+        with self.assertRaisesRegex(RuntimeError, r"read-only property"):
+            torch.backends.cpu.fft_plan_cache.size = -1
+
+        # sizes that are not products of small primes
+        for n in (17, 37, 97, 2 * 53):
+            x = torch.randn(3, n, dtype=torch.double)
+            self.assertEqual(x.rfft(1).irfft(1, signal_sizes=(n,)), x)
+            z = torch.randn(3, n, 2, dtype=torch.double)
+            self.assertEqual(z.fft(1).ifft(1), z)
+
     @staticmethod
     def _test_stft(self, device='cpu'):
         if not TEST_LIBROSA:
@@ -6438,6 +6731,38 @@ class _TestTorchMixin(object):
     def test_cholesky_batched(self):
         self._test_cholesky_batched(self, lambda t: t)
 
+    @skipIfNoLapack
+    def test_linalg_batched_small_matrices(self):
+        # matrices up to 8 x 8 have their own kernels, larger ones use LAPACK,
+        # and large batches are split between threads
+        for n, batch in product([1, 2, 3, 4, 8, 9, 16], [1, 500]):
+            A = torch.randn(batch, n, n, dtype=torch.double) + n * torch.eye(n, dtype=torch.double)
+            b = torch.randn(batch, n, 2, dtype=torch.double)
+            identity = torch.eye(n, dtype=torch.double).expand_as(A)
+            self.assertEqual(torch.matmul(A, torch.inverse(A)), identity)
+            x, LU = torch.solve(b, A)
+            self.assertEqual(torch.matmul(A, x), b)
+            LU_data, pivots = torch.lu(A)
+            self.assertEqual(LU_data, LU)
+            P, L, U = torch.lu_unpack(LU_data, pivots)
+            self.assertEqual(P.matmul(L.matmul(U)), A)
+            self.assertEqual(A[0].det(), U[0].diag().prod() * P[0].det())
+
+            S = A.matmul(A.transpose(-2, -1))
+            C = torch.cholesky(S)
+            self.assertEqual(C.matmul(C.transpose(-2, -1)), S)
+            C = torch.cholesky(S, upper=True)
+            self.assertEqual(C.transpose(-2, -1).matmul(C), S)
+
+        # errors are still reported for the first failing matrix
+        A = torch.eye(3, dtype=torch.double).repeat(500, 1, 1)
+        A[300, 1].zero_()
+        A[400].zero_()
+        with self.assertRaisesRegex(RuntimeError, r"For batch 300: U\(2,2\) is zero"):
+            torch.inverse(A)
+        with self.assertRaisesRegex(RuntimeError, r"For batch 300: U\(2,2\) is zero"):
+            torch.cholesky(A)
+
     @staticmethod
     def _test_cholesky_solve(self, cast):
         a = torch.Tensor(((6.80, -2.11, 5.66, 5.97, 8.23),
@@ -7376,6 +7701,39 @@ class _TestTorchMixin(object):
             dest2[idx[i]] = dest2[idx[i]] + src[i]
         self.assertEqual(dest, dest2)
 
+    def test_index_add_accumulate_duplicates(self):
+        # large enough to be accumulated in parallel, with many duplicates
+        num_copy, num_dest = 20000, 50
+        src = torch.randn(num_copy, 8, dtype=torch.double)
+        idx = torch.randint(num_dest, (num_copy,), dtype=torch.long)
+        dest = torch.randn(num_dest, 8, dtype=torch.double)
+
+        # the non contiguous destination goes through the serial TH kernel
+        expected = dest.t().contiguous().t().index_add_(0, idx, src)
+        result = dest.clone().index_add_(0, idx, src)
+        self.assertEqual(result, expected, 0)
+        num_threads = torch.get_num_threads()
+        torch.set_num_threads(1)
+        try:
+            self.assertEqual(dest.clone().index_add_(0, idx, src), result, 0)
+        finally:
+            torch.set_num_threads(num_threads)
+
+        self.assertEqual(dest.index_put((idx,), src, accumulate=True), result, 0)
+        self.assertEqual(dest.index_put((idx - num_dest,), src, accumulate=True), result, 0)
+        # two indices still go through the serial TensorIterator kernel
+        expected = dest.clone()
+        expected[:, 0] = result[:, 0]
+        self.assertEqual(dest.index_put((idx, torch.zeros_like(idx)), src[:, 0], accumulate=True), expected, 0)
+        self.assertEqual(dest.index_put((idx,), torch.ones(8, dtype=torch.double), accumulate=True),
+                         dest + idx.bincount(minlength=num_dest).double().unsqueeze(1))
+
+        idx[-1] = num_dest
+        unchanged = dest.clone()
+        self.assertRaises(RuntimeError, lambda: unchanged.index_add_(0, idx, src))
+        self.assertRaises(IndexError, lambda: unchanged.index_put_((idx,), src, accumulate=True))
+        self.assertEqual(unchanged, dest, 0)
+
     def test_index_select(self):
         src = torch.randn(3, 4, 5)
         # Index can be duplicated.
@@ -7610,6 +7968,41 @@ class _TestTorchMixin(object):
     def test_scatterFill(self):
         self._test_scatter_base(self, lambda t: t, 'scatter_', True)
 
+    def test_gather_scatter_lastdim(self):
+        # contiguous tensors indexed along the last dim go through the
+        # parallel row kernels; the non-contiguous copies take the generic path
+        for dtype in [torch.float, torch.double, torch.int64, torch.uint8]:
+            src = torch.randn(7, 9, 33).mul(10).to(dtype)
+            src_nc = src.transpose(0, 1).contiguous().transpose(0, 1)
+            idx = torch.randint(33, (7, 9, 21))
+            self.assertEqual(torch.gather(src, 2, idx), torch.gather(src_nc, 2, idx), 0)
+            self.assertEqual(torch.gather(src, -1, idx[:, :, :1]), torch.gather(src_nc, -1, idx[:, :, :1]), 0)
+
+            base = torch.zeros(7, 9, 40).to(dtype)
+            base_nc = base.transpose(0, 1).contiguous().transpose(0, 1)
+            for method in ['scatter_', 'scatter_add_']:
+                actual = getattr(base.clone(), method)(2, idx, src)
+                expected = getattr(base_nc.clone(), method)(2, idx, src)
+                self.assertEqual(actual, expected, 0)
+
+            idx[3, 4, 5] = 33
+            self.assertRaises(RuntimeError, lambda: torch.gather(src, 2, idx))
+            idx[3, 4, 5] = 40
+            self.assertRaises(RuntimeError, lambda: base.clone().scatter_(2, idx, src))
+
+    def test_index_rows(self):
+        # a single LongTensor index into dim 0 of a contiguous tensor copies rows
+        for dtype in [torch.float, torch.int64, torch.half, torch.bool]:
+            src = torch.randn(10, 3, 4).gt(0).to(dtype)
+            idx = torch.tensor([[0, -1, 9], [3, 3, -10]])
+            expected = torch.stack([torch.stack([src[i] for i in row]) for row in idx.tolist()])
+            self.assertEqual(src[idx], expected, 0)
+            self.assertEqual(src.index_select(0, idx[0, ::2]), expected[0, ::2], 0)
+        self.assertEqual(src[torch.tensor([], dtype=torch.long)].shape, (0, 3, 4))
+        self.assertRaisesRegex(IndexError, 'index 10 is out of bounds for dimension 0 with size 10',
+                               lambda: src[torch.tensor([1, 10])])
+        self.assertRaises(RuntimeError, lambda: src.index_select(0, torch.tensor([-1])))
+
     def test_masked_scatter(self):
         for dtype in [torch.uint8, torch.bool]:
             num_copy, num_dest = 3, 10
@@ -8300,6 +8693,34 @@ class _TestTorchMixin(object):
         with self.assertRaises(RuntimeError):
             torch.repeat_interleave(y, torch.arange(9).reshape(3, 3), dim=0)
 
+    def test_segment_reduce(self):
+        devices = ['cpu'] + (['cuda'] if torch.cuda.is_available() else [])
+        for device in devices:
+            data = torch.randn(10, 3, 2, dtype=torch.double, device=device)
+            offsets = torch.tensor([0, 3, 3, 7, 10], device=device)
+            for reduce in ['sum', 'mean', 'max', 'min']:
+                result = torch.segment_reduce(data, offsets, reduce)
+                self.assertEqual(result.size(), (4, 3, 2))
+                for s in range(4):
+                    rows = data[offsets[s]:offsets[s + 1]]
+                    if rows.size(0) == 0:
+                        expected = torch.zeros(3, 2, dtype=torch.double, device=device)
+                    elif reduce in ['max', 'min']:
+                        expected = getattr(rows, reduce)(0)[0]
+                    else:
+                        expected = getattr(rows, reduce)(0)
+                    self.assertEqual(result[s], expected)
+
+                x = data.clone().requires_grad_()
+                self.assertTrue(torch.autograd.gradcheck(
+                    lambda x: torch.segment_reduce(x, offsets, reduce), (x,)))
+
+            with self.assertRaises(RuntimeError):
+                torch.segment_reduce(data, offsets, 'prod')
+
+        with self.assertRaises(RuntimeError):
+            torch.segment_reduce(torch.randn(3, 2), torch.tensor([0, 2, 1]), 'sum')
+
     @unittest.skipIf(not TEST_NUMPY, "Numpy not found")
     def test_repeat_tile(self):
 
@@ -9348,6 +9769,32 @@ class _TestTorchMixin(object):
             xh2 = torch.load(f)
             self.assertEqual(xh.float(), xh2.float())
 
+    def test_bfloat16_tensor(self):
+        x = torch.randn(5, 37)
+        y = torch.rand(5, 37) + 1
+        xb, yb = x.to(torch.bfloat16), y.to(torch.bfloat16)
+        self.assertEqual(xb.dtype, torch.bfloat16)
+        self.assertTrue(xb.is_floating_point())
+        self.assertEqual(xb.float(), x, 1e-2)
+
+        # the kernels compute in float, so results only differ by the final
+        # rounding to bfloat16
+        xf, yf = xb.float(), yb.float()
+        self.assertEqual((xb + yb).float(), xf + yf, 5e-2)
+        self.assertEqual((xb * yb).float(), xf * yf, 5e-2)
+        self.assertEqual((xb / yb).float(), xf / yf, 5e-2)
+        self.assertEqual(xb.exp().float(), xf.exp(), 1e-1)
+        self.assertEqual(xb.sigmoid().float(), xf.sigmoid(), 1e-2)
+        self.assertEqual(xb.abs().float(), xf.abs(), 0)
+        self.assertEqual(xb.neg().float(), -xf, 0)
+        self.assertEqual(xb.sum().float(), xf.sum(), 1e-1)
+        self.assertEqual(xb.mean(1).float(), xf.mean(1), 1e-2)
+        self.assertEqual(torch.softmax(xb, 1).float(), torch.softmax(xf, 1), 1e-2)
+        self.assertEqual(torch.log_softmax(xb, 1).float(), torch.log_softmax(xf, 1), 5e-2)
+
+        # the sum accumulates in float instead of stalling at 256
+        self.assertEqual(torch.ones(1000, dtype=torch.bfloat16).sum().item(), 1000)
+
     def test_serialize_device(self):
         device_str = ['cpu', 'cpu:0', 'cuda', 'cuda:0']
         device_obj = [torch.device(d) for d in device_str]
@@ -10822,6 +11269,39 @@ tensor([[[1., 1., 1.,  ..., 1., 1., 1.],
         if torch.cuda.is_available():
             run_test(torch.device('cuda'))
 
+    def test_unique_large(self):
+        # large enough to be split into chunks counted in parallel
+        for dtype in [torch.int64, torch.int32, torch.float]:
+            for high in [10, 100000]:
+                x = torch.randint(high, (300000,)).to(dtype)
+                x_unique, x_inverse, x_counts = torch.unique(
+                    x, sorted=True, return_inverse=True, return_counts=True)
+                expected_unique, expected_counts = torch.unique_consecutive(
+                    x.sort()[0], return_counts=True)
+                self.assertEqual(x_unique, expected_unique)
+                self.assertEqual(x_counts, expected_counts)
+                self.assertEqual(x_unique[x_inverse], x)
+
+                x_unique = torch.unique(x, sorted=False)
+                self.assertEqual(x_unique.sort()[0], expected_unique)
+
+                z = x.sort()[0].repeat_interleave(2)
+                z_unique, z_inverse, z_counts = torch.unique_consecutive(
+                    z, return_inverse=True, return_counts=True)
+                self.assertEqual(z_unique, expected_unique)
+                self.assertEqual(z_unique[z_inverse], z)
+                self.assertEqual(z_counts, expected_counts * 2)
+
+        # NaNs are a single value
+        x = torch.tensor([1., float('nan'), 0., float('nan'), -0., 1.])
+        x_unique, x_inverse, x_counts = torch.unique(
+            x, sorted=True, return_inverse=True, return_counts=True)
+        self.assertEqual(x_unique[:2], torch.tensor([0., 1.]))
+        self.assertTrue(torch.isnan(x_unique[2]))
+        self.assertEqual(x_unique.numel(), 3)
+        self.assertEqual(x_inverse, torch.tensor([1, 2, 0, 2, 0, 1]))
+        self.assertEqual(x_counts, torch.tensor([2, 2, 2]))
+
     def test_unique_dim(self):
         self.assertFalse(hasattr(torch, 'unique_dim'))
 
@@ -11081,6 +11561,13 @@ tensor([[[1., 1., 1.,  ..., 1., 1., 1.],
         big_exp[1] = 1000000
         big_out = torch.ones(1000000, dtype=torch.int8, device=device).bincount()
         self.assertEqual(big_exp, big_out)
+        # test large input size with weights and many bins
+        big_in = torch.randint(0, 5000, (1000000,), device=device)
+        big_w = torch.rand(1000000, dtype=torch.double, device=device)
+        big_exp = torch.zeros(5000, dtype=torch.double, device=device).index_add_(0, big_in, big_w)
+        self.assertEqual(big_exp, big_in.bincount(big_w))
+        big_exp = torch.zeros(5000, dtype=torch.long, device=device).index_add_(0, big_in, torch.ones_like(big_in))
+        self.assertEqual(big_exp, big_in.bincount())
 
     @slowTest
     def test_slow_test(self):
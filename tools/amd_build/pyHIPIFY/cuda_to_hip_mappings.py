@@ -2340,11 +2340,14 @@ C10_MAPPINGS = collections.OrderedDict([
     ("c10/cuda/CUDAFunctions.h", ("c10/hip/HIPFunctions.h", API_C10)),
     ("c10/cuda/CUDAStream.h", ("c10/hip/HIPStream.h", API_C10)),
     ("c10/cuda/CUDACachingAllocator.h", ("c10/hip/HIPCachingAllocator.h", API_C10)),
+    ("c10/cuda/CUDAStreamScheduler.h", ("c10/hip/HIPStreamScheduler.h", API_C10)),
     ("c10/cuda/impl/CUDATest.h", ("c10/hip/impl/HIPTest.h", API_C10)),
     ("c10/cuda/impl/CUDAGuardImpl.h", ("c10/hip/impl/HIPGuardImpl.h", API_C10)),
     ("c10/cuda/impl/cuda_cmake_macros.h", ("c10/hip/impl/hip_cmake_macros.h", API_C10)),
     ("C10_CUDA_CHECK", ("C10_HIP_CHECK", API_C10)),
     ("c10::cuda", ("c10::hip", API_C10)),
+    ("cuda::CUDAStreamScheduler", ("hip::HIPStreamScheduler", API_C10)),
+    ("CUDAStreamScheduler", ("HIPStreamScheduler", API_C10)),
     ("cuda::CUDAStream", ("hip::HIPStream", API_C10)),
     ("CUDAStream", ("HIPStream", API_C10)),
     # This substitution is not permissible, because there's another copy of this
@@ -2354,6 +2357,7 @@ C10_MAPPINGS = collections.OrderedDict([
     ("cuda::set_device", ("hip::set_device", API_C10)),
     ("cuda::getStreamFromPool", ("hip::getStreamFromPool", API_C10)),
     ("getStreamFromPool", ("getStreamFromPool", API_C10)),
+    ("cuda::getDedicatedStream", ("hip::getDedicatedStream", API_C10)),
     ("cuda::getDefaultCUDAStream", ("hip::getDefaultHIPStream", API_C10)),
     ("getDefaultCUDAStream", ("getDefaultHIPStream", API_C10)),
     ("cuda::getCurrentCUDAStream", ("hip::getCurrentHIPStream", API_C10)),
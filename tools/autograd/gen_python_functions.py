@@ -296,6 +296,8 @@ def create_python_bindings(python_functions, has_self, is_module=False):
         'Storage &': 'storage',
         'const Type &': 'scalartype',
         'const THPLayout &': 'layout',
+        'MemoryFormat': 'memoryformat',
+        'c10::optional<MemoryFormat>': 'memoryformatOptional',
         'const Device &': 'device',
         'c10::optional<ScalarType>': 'scalartypeOptional',
         'c10::optional<Scalar>': 'scalarOptional',
@@ -870,6 +872,8 @@ def get_python_signature(declaration, include_out):
             default = arg['default']
             if default == 'nullptr' or default == 'nullopt' or default == '{}':
                 default = 'None'
+            elif default == 'MemoryFormat::Contiguous':
+                default = 'torch.contiguous_format'
         if default is not None:
             param += '=' + str(default)
         return param
@@ -10,6 +10,9 @@ from .gen_variable_type import format_trace
 
 FUNCTION_TEMPLATE = CodeTemplate("""\
 inline at::Tensor ${name}(${formals}) {
+  if (autograd::InferenceMode::is_enabled()) {
+    return at::${name}(${actuals});
+  }
   ${pre_record_trace}
   at::Tensor tensor = at::${name}(${actuals});
   at::Tensor result =
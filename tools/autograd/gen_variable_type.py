@@ -64,6 +64,32 @@ DONT_PROFILE = {
     'size', 'storage_offset', 'stride',
 }
 
+# In autocast mode, these functions cast their floating point inputs to half
+# on CUDA, because they run faster on tensor cores and are accurate enough in
+# half precision. See torch/csrc/autograd/autocast_mode.h
+AUTOCAST_HALF = {
+    'addbmm', 'addmm', 'addmv', 'addr', 'baddbmm', 'bmm', 'matmul', 'mm', 'mv',
+    'linear', 'prelu', 'convolution', '_convolution', 'conv1d', 'conv2d',
+    'conv3d', 'conv_tbc', 'conv_transpose1d', 'conv_transpose2d',
+    'conv_transpose3d', 'lstm_cell', 'gru_cell', 'rnn_tanh_cell',
+    'rnn_relu_cell',
+}
+
+# In autocast mode, these functions cast their half inputs to float, because
+# their results or their gradients often overflow or lose too much precision
+# in half precision.
+AUTOCAST_FLOAT = {
+    'acos', 'asin', 'cosh', 'erfinv', 'exp', 'expm1', 'log', 'log10', 'log2',
+    'log1p', 'reciprocal', 'rsqrt', 'sinh', 'tan', 'pow', 'softplus',
+    'softmax', 'log_softmax', 'layer_norm', 'group_norm', 'norm', 'renorm',
+    'dist', 'pdist', 'cdist', 'cosine_similarity', 'cumsum', 'cumprod',
+    'prod', 'sum', 'binary_cross_entropy', 'binary_cross_entropy_with_logits',
+    'cosine_embedding_loss', 'ctc_loss', 'hinge_embedding_loss', 'kl_div',
+    'l1_loss', 'margin_ranking_loss', 'mse_loss', 'multi_margin_loss',
+    'multilabel_margin_loss', 'nll_loss', 'nll_loss2d', 'poisson_nll_loss',
+    'smooth_l1_loss', 'soft_margin_loss', 'triplet_margin_loss',
+}
+
 # We don't set or modify grad_fn on these methods. Generally, they return
 # tensors that have requires_grad=False. In-place functions listed here will
 # not examine or modify requires_grad or grad_fn.
@@ -167,7 +193,7 @@ if (compute_requires_grad( ${args_with_derivatives} )) {
 """)
 
 ASSIGN_GRAD_FN = CodeTemplate("""\
-grad_fn = std::shared_ptr<${op}>(new ${op}(${op_ctor}), deleteFunction);
+grad_fn = make_function<${op}>(${op_ctor});
 grad_fn->set_next_edges(collect_next_edges( ${args_with_derivatives} ));
 """)
 
@@ -207,7 +233,17 @@ if (${cond}) {
 }
 """)
 
+# Calls the function again with its inputs cast, outside of autocast mode so
+# that the functions it calls don't cast them again.
+AUTOCAST = CodeTemplate("""\
+if (AutocastMode::is_enabled()) {
+  AutoAutocastMode autocast_mode(false);
+  return ${method_prefix_derived}${api_name}(${autocast_args});
+}
+""")
+
 RECORD_FUNCTION = CodeTemplate("""\
+OpTracepoints tracepoints("${name}");
 RECORD_FUNCTION("${name}", std::vector<c10::IValue>({${input_names}}), Function::peek_at_next_sequence_nr());
 """)
 
@@ -681,6 +717,15 @@ def emit_body(declaration):
             return ('', '')
         return format_trace(declaration)
 
+    def emit_autocast(dtype):
+        autocast_args = []
+        for arg in arguments:
+            if arg['dynamic_type'] == 'Tensor' and arg['simple_type'] == 'Tensor':
+                autocast_args.append('autocast::cached_cast({}, {})'.format(dtype, arg['name']))
+            else:
+                autocast_args.append(arg['name'])
+        return AUTOCAST.substitute(declaration, autocast_args=autocast_args)
+
     def declare_returned_variables():
         if modifies_arguments:
             return ''
@@ -862,6 +907,9 @@ def emit_body(declaration):
     combined = nested_dict(env, declaration)
 
     body = []
+    if not modifies_arguments and not returns_void:
+        if name in AUTOCAST_HALF or name in AUTOCAST_FLOAT:
+            body.append(emit_autocast('at::kHalf' if name in AUTOCAST_HALF else 'at::kFloat'))
     if base_name not in DONT_PROFILE:
         input_names = record_function_input_names()
         body.append(
@@ -2039,6 +2039,136 @@ std::tuple<Tensor, Tensor, Tensor> batchnorm_double_backward(
 
 }
 
+// Helper for layer_norm_double_backward and group_norm_double_backward.
+// x is normalized by mean and rstd over dims, which are kept with size one
+// in mean and rstd, and then scaled by a gamma that broadcasts against x.
+// With xhat = (x - mean) * rstd, the first backward is
+//   gI = rstd * (gO * gamma - E[gO * gamma] - xhat * E[gO * gamma * xhat]),
+//   gG = gO * xhat and gB = gO,
+// where E is the mean over dims, before gG and gB are summed to the shape of
+// gamma. The gamma gradient returned here is not summed up either.
+std::tuple<Tensor, Tensor, Tensor> normalization_double_backward(
+    const Tensor & x,
+    const Tensor & mean,
+    const Tensor & rstd,
+    const Tensor & gamma,
+    const Tensor & ggI,
+    const Tensor & ggG,
+    const Tensor & ggB,
+    const Tensor & gO,
+    IntArrayRef dims) {
+  auto row_mean = [&](const Tensor& t) { return t.mean(dims, true); };
+  auto xhat = (x - mean) * rstd;
+  auto gO_gamma = gamma.defined() ? gO * gamma : gO;
+
+  Tensor gI, gG, ggO;
+  if (ggI.defined()) {
+    auto gO_gamma_sub_mean = gO_gamma - row_mean(gO_gamma);
+    auto gO_gamma_xhat_mean = row_mean(gO_gamma * xhat);
+    auto ggI_sub_mean = ggI - row_mean(ggI);
+    auto ggI_xhat_mean = row_mean(ggI * xhat);
+    gI = -rstd * rstd * (
+        xhat * (row_mean(ggI * gO_gamma_sub_mean) - 3 * gO_gamma_xhat_mean * ggI_xhat_mean) +
+        ggI_xhat_mean * gO_gamma_sub_mean + gO_gamma_xhat_mean * ggI_sub_mean);
+    // the first backward is linear in gO * gamma, with the same operator
+    // applying to ggI
+    auto gO_gamma_grad = rstd * (ggI_sub_mean - xhat * ggI_xhat_mean);
+    if (gamma.defined()) {
+      ggO = gO_gamma_grad * gamma;
+      gG = gO_gamma_grad * gO;
+    } else {
+      ggO = gO_gamma_grad;
+    }
+  }
+  if (ggG.defined()) {
+    auto ggO_G_term = ggG * xhat;
+    ggO = ggO.defined() ? ggO + ggO_G_term : ggO_G_term;
+    auto xhat_grad = ggG * gO;
+    auto gI_G_term = rstd * (xhat_grad - row_mean(xhat_grad) - xhat * row_mean(xhat_grad * xhat));
+    gI = gI.defined() ? gI + gI_G_term : gI_G_term;
+  }
+  if (ggB.defined()) {
+    ggO = ggO.defined() ? ggO + ggB : ggB.expand_as(x);
+  }
+  return std::tuple<Tensor, Tensor, Tensor>{gI, gG, ggO};
+}
+
+std::tuple<Tensor, Tensor, Tensor> layer_norm_double_backward(
+    const Tensor & input,
+    const Tensor & gamma,
+    const Tensor & ggI,
+    const Tensor & ggG,
+    const Tensor & ggB,
+    const Tensor & gO,
+    const Tensor & save_mean,
+    const Tensor & save_rstd,
+    int64_t M,
+    int64_t N,
+    std::array<bool,3> output_mask) {
+  auto reshape = [](const Tensor& t, IntArrayRef shape) {
+    return t.defined() ? t.reshape(shape) : t;
+  };
+  Tensor gI, gG, ggO;
+  std::tie(gI, gG, ggO) = normalization_double_backward(
+      input.reshape({M, N}), save_mean.reshape({M, 1}), save_rstd.reshape({M, 1}),
+      reshape(gamma, {1, N}), reshape(ggI, {M, N}), reshape(ggG, {1, N}),
+      reshape(ggB, {1, N}), gO.reshape({M, N}), {1});
+
+  if (output_mask[0]) {
+    gI = gI.defined() ? gI.reshape(input.sizes()) : at::zeros_like(input);
+  }
+  if (output_mask[1]) {
+    AT_ASSERTM(gamma.defined(), "gamma should always be defined when it requires grad");
+    gG = gG.defined() ? gG.sum(0).reshape(gamma.sizes()) : at::zeros_like(gamma);
+  }
+  if (output_mask[2]) {
+    ggO = ggO.defined() ? ggO.reshape(gO.sizes()) : at::zeros_like(gO);
+  }
+  return std::tuple<Tensor, Tensor, Tensor>{
+      output_mask[0] ? gI : Tensor(), output_mask[1] ? gG : Tensor(),
+      output_mask[2] ? ggO : Tensor()};
+}
+
+std::tuple<Tensor, Tensor, Tensor> group_norm_double_backward(
+    const Tensor & input,
+    const Tensor & gamma,
+    const Tensor & ggI,
+    const Tensor & ggG,
+    const Tensor & ggB,
+    const Tensor & gO,
+    const Tensor & save_mean,
+    const Tensor & save_rstd,
+    int64_t N,
+    int64_t C,
+    int64_t HxW,
+    int64_t group,
+    std::array<bool,3> output_mask) {
+  const int64_t D = C / group;
+  auto reshape = [](const Tensor& t, IntArrayRef shape) {
+    return t.defined() ? t.reshape(shape) : t;
+  };
+  Tensor gI, gG, ggO;
+  std::tie(gI, gG, ggO) = normalization_double_backward(
+      input.reshape({N, group, D, HxW}), save_mean.reshape({N, group, 1, 1}),
+      save_rstd.reshape({N, group, 1, 1}), reshape(gamma, {1, group, D, 1}),
+      reshape(ggI, {N, group, D, HxW}), reshape(ggG, {1, group, D, 1}),
+      reshape(ggB, {1, group, D, 1}), gO.reshape({N, group, D, HxW}), {2, 3});
+
+  if (output_mask[0]) {
+    gI = gI.defined() ? gI.reshape(input.sizes()) : at::zeros_like(input);
+  }
+  if (output_mask[1]) {
+    AT_ASSERTM(gamma.defined(), "gamma should always be defined when it requires grad");
+    gG = gG.defined() ? gG.sum({0, 3}).reshape(gamma.sizes()) : at::zeros_like(gamma);
+  }
+  if (output_mask[2]) {
+    ggO = ggO.defined() ? ggO.reshape(gO.sizes()) : at::zeros_like(gO);
+  }
+  return std::tuple<Tensor, Tensor, Tensor>{
+      output_mask[0] ? gI : Tensor(), output_mask[1] ? gG : Tensor(),
+      output_mask[2] ? ggO : Tensor()};
+}
+
 std::tuple<Tensor, Tensor, Tensor> _trilinear_backward(const Tensor& grad_out, const Tensor& i1, const Tensor& i2, const Tensor& i3,
                                                        IntArrayRef expand1, IntArrayRef expand2, IntArrayRef expand3,
                                                        IntArrayRef sumdim, int64_t unroll_dim, std::array<bool, 3> grad_mask) {
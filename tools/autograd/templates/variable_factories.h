@@ -5,6 +5,7 @@
 #include <ATen/ATen.h>
 #include <c10/util/ArrayRef.h>
 #include <c10/util/qint8.h>
+#include <torch/csrc/autograd/grad_mode.h>
 #include <torch/csrc/autograd/variable.h>
 #include <torch/csrc/jit/tracer.h>
 
@@ -19,6 +20,9 @@ namespace torch {
       at::ArrayRef<T> values, const at::TensorOptions& options) {          \
     at::Tensor result =                                                    \
         at::tensor(values, at::TensorOptions(options).is_variable(false)); \
+    if (autograd::InferenceMode::is_enabled()) {                           \
+      return result;                                                       \
+    }                                                                      \
     return autograd::make_variable(result, options.requires_grad());       \
   }                                                                        \
   inline at::Tensor tensor(                                                \
@@ -58,6 +62,9 @@ inline at::Tensor from_blob(
     const at::TensorOptions& options = at::TensorOptions()) {
   at::Tensor tensor =
       at::from_blob(data, sizes, strides, deleter, options.is_variable(false));
+  if (autograd::InferenceMode::is_enabled()) {
+    return tensor;
+  }
   return autograd::make_variable(tensor, options.requires_grad());
 }
 
@@ -92,6 +99,9 @@ inline at::Tensor from_blob(
     const at::TensorOptions& options = at::TensorOptions()) {
   at::Tensor tensor =
       at::from_blob(data, sizes, deleter, options.is_variable(false));
+  if (autograd::InferenceMode::is_enabled()) {
+    return tensor;
+  }
   return autograd::make_variable(tensor, options.requires_grad());
 }
 
@@ -214,6 +214,13 @@ def run_cmake(version,
     if os.getenv('MKL_SEQ'):
         cmake_defines(cmake_args, INTEL_MKL_SEQUENTIAL=check_env_flag('MKL_SEQ'))
 
+    if os.getenv('SELECTED_OP_LIST'):
+        cmake_defines(cmake_args, SELECTED_OP_LIST=escape_path(os.getenv('SELECTED_OP_LIST')))
+
+    aten_threading = os.getenv('ATEN_THREADING')
+    if aten_threading:
+        cmake_defines(cmake_args, ATEN_THREADING=aten_threading)
+
     mkldnn_threading = os.getenv('MKLDNN_THREADING')
     if mkldnn_threading:
         cmake_defines(cmake_args, MKLDNN_THREADING=mkldnn_threading)
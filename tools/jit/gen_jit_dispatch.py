@@ -10,10 +10,14 @@ python -m tools.jit.gen_jit_dispatch \
 Where $OUTPUT_DIR is where you would like the files to be
 generated.  In the full build system, OUTPUT_DIR is
 torch/csrc/jit/generated/
+
+Pass --selected-op-list-path to only compile the kernels of the ops
+listed in a yaml file, such as one written by torch.jit.export_opnames.
 """
 
 import argparse
 import copy
+import yaml
 from itertools import groupby
 from ..autograd.utils import CodeTemplate, write
 from ..autograd.gen_autograd import load_aten_declarations
@@ -51,6 +55,8 @@ TYPE_MAP = {
     'IntArrayRef': 'int[]',
     'Layout': 'Layout',
     'Layout?': 'Layout?',
+    'MemoryFormat': 'MemoryFormat',
+    'MemoryFormat?': 'MemoryFormat?',
     'Device': 'Device',
     'Device?': 'Device?',
     'ScalarType': 'ScalarType',
@@ -96,6 +102,8 @@ FROM_IVALUE = {
     'IntArrayRef': '{}.toIntList()->elements()',
     'Layout': '{}.toLayout()',
     'Layout?': '{}.toOptional<c10::Layout>()',
+    'MemoryFormat': '{}.toMemoryFormat()',
+    'MemoryFormat?': '{}.toOptional<c10::MemoryFormat>()',
     'Scalar': '{}.toScalar()',
     'Scalar?': '{}.toOptional<Scalar>()',
     'ScalarType': '{}.toScalarType()',
@@ -159,6 +167,9 @@ CONSTRUCTOR = CodeTemplate("""\
 }
 """)
 
+UNSELECTED_OP = CodeTemplate("""\
+unselected_op("aten::${name}")""")
+
 OPERATOR = CodeTemplate("""\
 Operator(
     "${signature}",
@@ -220,6 +231,11 @@ def is_out_variant(decl):
     return decl['name'].endswith('_out')
 
 
+def jit_name(decl):
+    """The name of decl in its schema, where out variants are overloads."""
+    return decl['name'] if not is_out_variant(decl) else decl['name'][:-4]
+
+
 # for each argument in decl, the location it should appear in the
 # jit schema declaration. e.g.
 # arguments = [x, y, z] # the order in aten
@@ -230,7 +246,18 @@ def argument_order(decl):
     return decl.get('jit_argument_order') or list(range(len(decl['arguments'])))
 
 
-def gen_jit_dispatch(declarations, out, template_path):
+def load_op_list(path):
+    """Returns the ops listed in the yaml file at path, without their
+    aten:: namespace, or None when path is None."""
+    if path is None:
+        return None
+    with open(path, 'r') as f:
+        op_list = yaml.safe_load(f) or []
+    return set(op[len('aten::'):] if op.startswith('aten::') else op
+               for op in op_list)
+
+
+def gen_jit_dispatch(declarations, out, template_path, selected_op_list_path=None):
     REGISTER_ATEN_OPS_CPP = CodeTemplate.from_file(template_path + '/register_aten_ops.cpp')
 
     ops = []
@@ -393,6 +420,15 @@ def gen_jit_dispatch(declarations, out, template_path):
     # generation is deterministic
     jit_decl_groups = sort_decls(jit_decls)
 
+    # Selective builds only compile the kernels of the listed ops, with all
+    # their overloads, since graphs do not record which overload a node
+    # calls. The other ops keep their schemas, which are only parsed when
+    # used, because passes match nodes against them.
+    selected_op_list = load_op_list(selected_op_list_path)
+
+    def is_selected(decl):
+        return selected_op_list is None or jit_name(decl) in selected_op_list
+
     # NOTE: see Note [Sharded File] at the top of the register_aten_ops.cpp
     # template regarding sharding of the generated files.
     #
@@ -406,8 +442,12 @@ def gen_jit_dispatch(declarations, out, template_path):
     for group in jit_decl_groups:
         x = sum(ord(c) for c in group[0]['name']) % num_shards
         for decl in group:
+            if is_selected(decl):
+                op = emit_decl_variant(decl)
+            else:
+                op = UNSELECTED_OP.substitute(name=jit_name(decl))
             shards[x].append(OPERATOR.substitute(signature=signature(decl, decl['should_match_schema']),
-                                                 op=emit_decl_variant(decl)))
+                                                 op=op))
 
     for i, shard in enumerate(shards):
         env = {
@@ -511,8 +551,7 @@ def signature(decl, should_match_schema=True):
         def type_maybe_field(r):
             return '{} {}'.format(jit_type_of(r), r['field_name']) if 'field_name' in r else jit_type_of(r)
         ret_list = '({})'.format(', '.join(type_maybe_field(r) for r in decl['returns']))
-    name = decl['name'] if not is_out_variant(decl) else decl['name'][:-4]
-    constructed_string = 'aten::{}({}) -> {}'.format(name, arg_list, ret_list)
+    constructed_string = 'aten::{}({}) -> {}'.format(jit_name(decl), arg_list, ret_list)
     return match_signature(decl, constructed_string, should_match_schema)
 
 
@@ -525,8 +564,11 @@ def main():
                         help='path to output directory')
     parser.add_argument('template_path', metavar='TEMPLATE_PATH',
                         help='path to templates directory')
+    parser.add_argument('--selected-op-list-path',
+                        help='path to a yaml list of the ops to compile kernels for')
     args = parser.parse_args()
-    gen_jit_dispatch(args.declarations, args.out, args.template_path)
+    gen_jit_dispatch(args.declarations, args.out, args.template_path,
+                     args.selected_op_list_path)
 
 
 if __name__ == '__main__':
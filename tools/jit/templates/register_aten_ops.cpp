@@ -51,22 +51,26 @@ namespace {
 
 // XXX: This function is to specialize IValue for tensor type in
 // interpreter, it should only be used in this file
-at::Tensor toOptionalTensor(const IValue& v) {
+at::Tensor toOptionalTensor(IValue&& v) {
   if (v.isNone()) {
     return at::Tensor();
   }
-  return v.toTensor();
+  return std::move(v).toTensor();
 }
 
 // XXX: This function is to specialize IValue for list of optional
 // tensor type in interpreter, it should only be used in this file
-std::vector<Tensor> toListOfOptionalTensor(const IValue& v) {
+std::vector<Tensor> toListOfOptionalTensor(IValue&& v) {
   // v is a list of optional tensor, loop over as generic list
-  auto vlist = v.toGenericListRef();
+  auto vlist = std::move(v).toGenericList();
+  // If the stack held the only reference to the list, the tensors can be
+  // moved out of it
+  const bool is_unique = vlist.use_count() == 1;
   std::vector<Tensor> res;
+  res.reserve(vlist->elements().size());
 
-  for (const IValue &v: vlist) {
-    res.emplace_back(toOptionalTensor(v));
+  for (IValue &v: vlist->elements()) {
+    res.emplace_back(toOptionalTensor(is_unique ? std::move(v) : IValue(v)));
   }
   return res;
 }
@@ -79,6 +83,14 @@ std::array<bool, N> as_bool_array(const std::vector<bool>& vec) {
   return res;
 }
 
+// The kernel of the ops a selective build leaves out of SELECTED_OP_LIST.
+C10_UNUSED Operation unselected_op(const char* name) {
+  return [name](Stack&) -> int {
+    AT_ERROR(name, " was not selected in this build of PyTorch. Add it to "
+             "the SELECTED_OP_LIST the build was configured with.");
+  };
+}
+
 RegisterOperators reg({
   Operator(
       "aten::get_device(Tensor self) -> int",
@@ -109,6 +109,7 @@ def type_to_python(typename, size=None):
         'IntegerTensor': 'Tensor',
         'Scalar': 'Number',
         'ScalarType': '_dtype',
+        'MemoryFormat': 'memory_format',
         'Storage': 'Storage',
         'BoolTensor': 'Tensor',
         'IndexTensor': 'Tensor',
@@ -149,6 +150,8 @@ def arg_to_type_hint(arg):
             default = None
         elif default == 'c10::nullopt':
             default = None
+        elif default == 'MemoryFormat::Contiguous':
+            default = 'contiguous_format'
         elif isinstance(default, str) and default.startswith('{') and default.endswith('}'):
             if arg['dynamic_type'] == 'Tensor' and default == '{}':
                 default = None
@@ -429,7 +432,7 @@ def gen_pyi(declarations_path, out):
         'type': ['def type(self, dtype: Union[None, str, _dtype]=None, non_blocking: bool=False)'
                  ' -> Union[str, Tensor]: ...'],
         'get_device': ['def get_device(self) -> _int: ...'],
-        'is_contiguous': ['def is_contiguous(self) -> bool: ...'],
+        'is_contiguous': ['def is_contiguous(self, memory_format: memory_format=contiguous_format) -> bool: ...'],
         'is_cuda': ['def is_cuda(self) -> bool: ...'],
         'is_leaf': ['def is_leaf(self) -> bool: ...'],
         'storage_offset': ['def storage_offset(self) -> _int: ...'],
@@ -23,7 +23,8 @@ def generate_code(ninja_global=None,
                   declarations_path=None,
                   nn_path=None,
                   install_dir=None,
-                  subset=None):
+                  subset=None,
+                  selected_op_list_path=None):
     # cwrap depends on pyyaml, so we can't import it earlier
     root = os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
     sys.path.insert(0, root)
@@ -47,7 +48,8 @@ def generate_code(ninja_global=None,
 
     if subset == "libtorch" or not subset:
         gen_autograd(declarations_path or DECLARATIONS_PATH, autograd_gen_dir, 'tools/autograd')
-        gen_jit_dispatch(declarations_path or DECLARATIONS_PATH, jit_gen_dir, 'tools/jit/templates')
+        gen_jit_dispatch(declarations_path or DECLARATIONS_PATH, jit_gen_dir, 'tools/jit/templates',
+                         selected_op_list_path)
 
 
 def main():
@@ -60,6 +62,10 @@ def main():
         '--subset',
         help='Subset of source files to generate. Can be "libtorch" or "pybindings". Generates both when omitted.'
     )
+    parser.add_argument(
+        '--selected-op-list-path',
+        help='Path to a yaml list of the aten ops to compile JIT kernels for. Compiles all of them when omitted.'
+    )
     options = parser.parse_args()
     generate_code(
         options.ninja_global,
@@ -67,6 +73,7 @@ def main():
         options.nn_path,
         options.install_dir,
         options.subset,
+        options.selected_op_list_path,
     )
 
 
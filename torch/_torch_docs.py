@@ -6442,3 +6442,30 @@ If the `repeats` is `tensor([n1, n2, n3, ...])`, then the output will be
 `tensor([0, 0, ..., 1, 1, ..., 2, 2, ..., ...])` where `0` appears `n1` times,
 `1` appears `n2` times, `2` appears `n3` times, etc.
 """)
+
+add_docstr(torch.segment_reduce,
+           r"""
+segment_reduce(data, offsets, reduce) -> Tensor
+
+Reduces the rows of :attr:`data` in each segment ``[offsets[i], offsets[i + 1])``,
+e.g. to pool over the sequences of a ragged batch that are concatenated along
+the first dimension. The result has the sizes of :attr:`data`, except for its
+first dimension, which has ``offsets.size(0) - 1`` entries. Empty segments
+reduce to 0.
+
+:attr:`offsets` must be non-decreasing and within ``[0, data.size(0)]``. This is
+only checked for CPU tensors.
+
+Args:
+    data (Tensor): the rows to reduce
+    offsets (LongTensor): the 1-D boundaries of the segments, on the device of
+        :attr:`data`
+    reduce (str): one of ``'sum'``, ``'mean'``, ``'max'`` or ``'min'``
+
+Example::
+
+    >>> x = torch.tensor([[1., 2.], [3., 4.], [5., 6.]])
+    >>> torch.segment_reduce(x, torch.tensor([0, 1, 3]), 'sum')
+    tensor([[ 1.,  2.],
+            [ 8., 10.]])
+""")
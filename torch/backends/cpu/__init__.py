@@ -0,0 +1,50 @@
+import sys
+import torch
+
+
+class FFTPlanCacheAttrContextProp(object):
+    # Like regular ContextProp, but the getter and setter take no device.
+    def __init__(self, getter, setter):
+        self.getter = getter
+        self.setter = setter
+
+    def __get__(self, obj, objtype):
+        return self.getter()
+
+    def __set__(self, obj, val):
+        if isinstance(self.setter, str):
+            raise RuntimeError(self.setter)
+        self.setter(val)
+
+
+class FFTPlanCache(object):
+    r"""
+    Represents the plan cache of CPU FFTs, shared by all threads. The
+    attributes `size` and `max_size`, and method `clear`, can fetch and/ or
+    change properties of the C++ CPU FFT plan cache.
+    """
+    size = FFTPlanCacheAttrContextProp(
+        torch._cpu_fft_get_plan_cache_size,
+        '.size is a read-only property showing the number of plans currently in the '
+        'cache. To change the cache capacity, set fft_plan_cache.max_size.')
+
+    max_size = FFTPlanCacheAttrContextProp(torch._cpu_fft_get_plan_cache_max_size,
+                                           torch._cpu_fft_set_plan_cache_max_size)
+
+    def clear(self):
+        return torch._cpu_fft_clear_plan_cache()
+
+
+class CPUModule(object):
+    def __init__(self, m):
+        self.__dict__ = m.__dict__
+        # You have to retain the old module, otherwise it will
+        # get GC'ed and a lot of things will break.  See:
+        # https://stackoverflow.com/questions/47540722/how-do-i-use-the-sys-modules-replacement-trick-in-init-py-on-python-2
+        self.__old_mod = m
+
+    fft_plan_cache = FFTPlanCache()
+
+# This is the sys.modules replacement trick, see
+# https://stackoverflow.com/questions/2447353/getattr-on-a-module/7668273#7668273
+sys.modules[__name__] = CPUModule(sys.modules[__name__])
@@ -1,6 +1,7 @@
 #ifdef USE_CUDA
 #include <torch/csrc/CudaIPCTypes.h>
 #include <TH/THAllocator.h>
+#include <chrono>
 #include <map>
 #include <mutex>
 #include <random>
@@ -16,6 +17,14 @@ namespace torch {
 
 namespace {
 
+int64_t currentProcessId() {
+#ifdef _MSC_VER
+  return GetCurrentProcessId();
+#else
+  return getpid();
+#endif
+}
+
 void warnProducerTerminatedBeforeSharedTensorsReleased() {
   static bool warned = false;
   if (!warned) {
@@ -31,6 +40,7 @@ struct CudaIPCGlobalEntities {
   std::map<std::string, std::shared_ptr<CudaIPCRefCountersFile>>
       ref_counters_files_;
   std::shared_ptr<CudaIPCRefCountersFile> next_available_ref_counters_file_;
+  CudaIPCMappedRefCounters mapped_ref_counters_;
   CudaIPCSentDataLimbo CudaIPCSentDataLimbo_;
   CudaIPCGlobalEntities() : ref_counters_files_() {}
   ~CudaIPCGlobalEntities() {
@@ -53,52 +63,140 @@ struct CudaIPCGlobalEntities {
 CudaIPCGlobalEntities cuda_ipc_global_entities;
 
 CudaIPCSentDataLimbo::~CudaIPCSentDataLimbo() {
+  {
+    std::lock_guard<std::mutex> lock(limbo_mutex_);
+    stop_collector_ = true;
+  }
+  collector_cv_.notify_one();
+  if (collector_.joinable()) {
+    // A forked child inherits the thread object, but not the thread
+    if (collector_pid_ == currentProcessId()) {
+      collector_.join();
+    } else {
+      collector_.detach();
+    }
+  }
   collect();
-  if (shared_blocks_.size() > 0) {
+  if (size() > 0) {
     warnProducerTerminatedBeforeSharedTensorsReleased();
   }
 }
 
 bool CudaIPCSentDataLimbo::collect() {
-  bool freed_memory = false;
-  std::lock_guard<std::mutex> lock(limbo_mutex_);
-  std::vector<std::unique_ptr<CudaIPCSentData>> kept_blocks;
-  for (auto& sd : shared_blocks_) {
-    if (sd->counter_value() > 0) {
-      kept_blocks.push_back(std::move(sd));
-    } else {
-      freed_memory = true;
-      sd.reset();
+  std::vector<std::unique_ptr<CudaIPCSentData>> freed_blocks;
+  {
+    std::lock_guard<std::mutex> lock(limbo_mutex_);
+    std::vector<std::unique_ptr<CudaIPCSentData>> kept_blocks;
+    for (auto& sd : shared_blocks_) {
+      if (sd->counter_value() > 0) {
+        kept_blocks.push_back(std::move(sd));
+      } else {
+        freed_blocks.push_back(std::move(sd));
+      }
     }
+    shared_blocks_ = std::move(kept_blocks);
   }
-  shared_blocks_ = std::move(kept_blocks);
+  // Blocks are freed without holding the lock, since freeing goes through
+  // the caching allocator, which itself collects the limbo when out of memory
+  bool freed_memory = !freed_blocks.empty();
+  freed_blocks.clear();
   return freed_memory;
 }
 
 void CudaIPCSentDataLimbo::add(std::unique_ptr<CudaIPCSentData> shared_block) {
-  std::lock_guard<std::mutex> lock(limbo_mutex_);
-  static bool warned = false;
-  if (shared_blocks_.size() > CUDA_IPC_WARN_AFTER_X_BLOCKS_IN_LIMBO &&
-      !warned) {
-    LOG(WARNING)
-        << "Producer process tried to deallocate over "
-        << CUDA_IPC_WARN_AFTER_X_BLOCKS_IN_LIMBO
-        << " memory blocks referred by consumer processes. Deallocation might be significantly slowed down. "
-        << "We assume it will never going to be the case, but if it is, please file but to https://github.com/pytorch/pytorch";
-    warned = true;
+  {
+    std::lock_guard<std::mutex> lock(limbo_mutex_);
+    static bool warned = false;
+    if (shared_blocks_.size() > CUDA_IPC_WARN_AFTER_X_BLOCKS_IN_LIMBO &&
+        !warned) {
+      LOG(WARNING)
+          << "Producer process tried to deallocate over "
+          << CUDA_IPC_WARN_AFTER_X_BLOCKS_IN_LIMBO
+          << " memory blocks referred by consumer processes. Deallocation might be significantly slowed down. "
+          << "We assume it will never going to be the case, but if it is, please file but to https://github.com/pytorch/pytorch";
+      warned = true;
+    }
+    shared_blocks_.push_back(std::move(shared_block));
+    if (!collector_.joinable() && !stop_collector_) {
+      collector_pid_ = currentProcessId();
+      collector_ = std::thread([this] { collector_loop(); });
+    }
+  }
+  collector_cv_.notify_one();
+}
+
+void CudaIPCSentDataLimbo::collector_loop() {
+  std::unique_lock<std::mutex> lock(limbo_mutex_);
+  while (!stop_collector_) {
+    if (shared_blocks_.empty()) {
+      collector_cv_.wait(lock);
+    } else {
+      collector_cv_.wait_for(
+          lock, std::chrono::milliseconds(CUDA_IPC_LIMBO_COLLECT_INTERVAL_MS));
+    }
+    if (stop_collector_) {
+      break;
+    }
+    lock.unlock();
+    try {
+      collect();
+    } catch (...) { /* No throw */
+    }
+    lock.lock();
+  }
+}
+
+void CudaIPCMappedRefCounters::release(
+    const std::string& handle,
+    int64_t offset) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = files_.begin();
+  while (it != files_.end() && it->first != handle) {
+    ++it;
+  }
+  if (it != files_.end()) {
+    files_.splice(files_.begin(), files_, it);
+  } else {
+    int flags = TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_NOCREATE;
+    at::DataPtr sptr = THRefcountedMapAllocator::makeDataPtr(
+        handle.c_str(),
+        flags,
+        sizeof(int64_t) * CUDA_IPC_REF_COUNTER_FILE_SIZE,
+        nullptr);
+    files_.emplace_front(handle, std::move(sptr));
+    if (files_.size() > CUDA_IPC_MAX_MAPPED_REF_COUNTER_FILES) {
+      files_.pop_back();
+    }
   }
-  shared_blocks_.push_back(std::move(shared_block));
+  *(static_cast<int64_t*>(files_.front().second.get()) + offset) -= 1;
 }
 
 void CudaIPCSentDataDelete(void* ptr) {
   std::unique_ptr<CudaIPCSentData> sent_data(
       static_cast<CudaIPCSentData*>(ptr));
   if (sent_data->counter_value() > 0) {
+    // Freed by the limbo's collector once the consumers release it
     cuda_ipc_global_entities.CudaIPCSentDataLimbo_.add(std::move(sent_data));
   }
-  cuda_ipc_global_entities.CudaIPCSentDataLimbo_.collect();
 }
 
+#ifndef __HIP_PLATFORM_HCC__
+struct CudaIPCPendingRelease {
+  std::string handle;
+  int64_t offset;
+};
+
+void CUDART_CB CudaIPCReleaseRefCounterCallback(
+    cudaStream_t /* unused */,
+    cudaError_t /* unused */,
+    void* data) {
+  // Runs on a driver thread, which must not call into CUDA
+  std::unique_ptr<CudaIPCPendingRelease> pending(
+      static_cast<CudaIPCPendingRelease*>(data));
+  CudaIPCReleaseRefCounter(pending->handle, pending->offset);
+}
+#endif
+
 void ReturnRefCounter(const std::string& handle, uint64_t offset /* unused */) {
   std::lock_guard<std::mutex> lock(
       cuda_ipc_global_entities.ref_counters_mutex_);
@@ -180,6 +278,9 @@ int64_t CudaIPCSentData::counter_value() {
 }
 
 at::DataPtr GetNewRefCountedSentData(void* data, at::Device device) {
+  std::string handle;
+  int64_t offset;
+  int64_t* counter_ptr;
   {
     std::lock_guard<std::mutex> lock(
         cuda_ipc_global_entities.ref_counters_mutex_);
@@ -205,20 +306,55 @@ at::DataPtr GetNewRefCountedSentData(void* data, at::Device device) {
       cuda_ipc_global_entities.ref_counters_files_[ref_counter_handle] = rc;
       cuda_ipc_global_entities.next_available_ref_counters_file_ = rc;
     }
+    // Offsets are taken under the lock, since the limbo's collector returns
+    // them from another thread
+    auto& rc = cuda_ipc_global_entities.next_available_ref_counters_file_;
+    rc->set_counter(1);
+    handle = rc->handle();
+    offset = rc->get_offset();
+    counter_ptr = rc->counter_ptr();
+    rc->rotate_offset();
+    if (!rc->have_offsets()) {
+      rc.reset();
+    }
   }
-  cuda_ipc_global_entities.next_available_ref_counters_file_->set_counter(1);
-  auto sent_data = new CudaIPCSentData(
-      cuda_ipc_global_entities.next_available_ref_counters_file_->handle(),
-      cuda_ipc_global_entities.next_available_ref_counters_file_->get_offset(),
-      cuda_ipc_global_entities.next_available_ref_counters_file_->counter_ptr(),
-      device);
+  auto sent_data = new CudaIPCSentData(handle, offset, counter_ptr, device);
+  return at::DataPtr(data, sent_data, CudaIPCSentDataDelete, device);
+}
 
-  cuda_ipc_global_entities.next_available_ref_counters_file_->rotate_offset();
-  if (!cuda_ipc_global_entities.next_available_ref_counters_file_
-           ->have_offsets()) {
-    cuda_ipc_global_entities.next_available_ref_counters_file_.reset();
+void CudaIPCReleaseRefCounter(const std::string& handle, int64_t offset) {
+  // We don't want to break existing code, so resource deletion is best
+  // effort basis. Exception expected if producer process terminated
+  // before consumer released data.
+  try {
+    cuda_ipc_global_entities.mapped_ref_counters_.release(handle, offset);
+  } catch (c10::Error) {
+    // Already warned inside of producer process
   }
-  return at::DataPtr(data, sent_data, CudaIPCSentDataDelete, device);
+}
+
+void CudaIPCReleaseRefCounterAsync(
+    const std::string& handle,
+    int64_t offset,
+    c10::cuda::CUDAStream stream) {
+#ifndef __HIP_PLATFORM_HCC__
+  // The producer may reuse the memory as soon as the counter drops, so it is
+  // released only after the work queued on the stream, which may still read
+  // the memory, has completed
+  std::unique_ptr<CudaIPCPendingRelease> pending(
+      new CudaIPCPendingRelease{handle, offset});
+  if (cudaStreamAddCallback(
+          stream,
+          CudaIPCReleaseRefCounterCallback,
+          pending.get(),
+          0) == cudaSuccess) {
+    pending.release();
+    return;
+  }
+  cudaGetLastError();
+#endif
+  cudaStreamSynchronize(stream);
+  CudaIPCReleaseRefCounter(handle, offset);
 }
 
 bool CudaIPCCollect() {
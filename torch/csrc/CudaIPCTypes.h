@@ -7,7 +7,11 @@
 #include <c10/cuda/CUDAStream.h>
 #include <c10/util/Logging.h>
 #include <cuda_runtime_api.h>
+#include <condition_variable>
 #include <cstddef>
+#include <list>
+#include <mutex>
+#include <thread>
 
 namespace torch {
 
@@ -49,6 +53,18 @@ struct CudaIPCSentData final {
 
 at::DataPtr GetNewRefCountedSentData(void* data, at::Device device);
 
+// Decrements reference counter `offset` of the producer's counters file
+// `handle`. Files are mapped once and kept mapped for later releases. Best
+// effort: nothing happens if the producer has already exited.
+void CudaIPCReleaseRefCounter(const std::string& handle, int64_t offset);
+
+// Same as CudaIPCReleaseRefCounter, once the work queued so far on `stream`
+// has completed, without blocking the calling thread.
+void CudaIPCReleaseRefCounterAsync(
+    const std::string& handle,
+    int64_t offset,
+    c10::cuda::CUDAStream stream);
+
 namespace {
 
 constexpr int64_t CUDA_IPC_REF_COUNTER_FILE_SIZE = 10000;
@@ -58,21 +74,41 @@ constexpr int64_t CUDA_IPC_WARN_AFTER_X_BLOCKS_IN_LIMBO = 1000;
 // And to give us leeway, we picked 1000 as it gives us enough events to share
 // tensors effectively.
 constexpr int64_t CUDA_IPC_MAXIMUM_EVENTS_TO_USE = 1000;
-
-// All to be deleted data blocks with non zero reference counter goes there
+// Interval at which the limbo is scanned in the background while not empty
+constexpr int64_t CUDA_IPC_LIMBO_COLLECT_INTERVAL_MS = 10;
+// Number of producers' counters files a consumer keeps mapped
+constexpr size_t CUDA_IPC_MAX_MAPPED_REF_COUNTER_FILES = 16;
+
+// All to be deleted data blocks with non zero reference counter goes there.
+// A background thread, started with the first block, frees blocks whose
+// counters drop to zero while the limbo is not empty.
 struct CudaIPCSentDataLimbo final {
   ~CudaIPCSentDataLimbo();
   bool collect();
   void add(std::unique_ptr<CudaIPCSentData> shared_block);
   uint64_t size() {
+    std::lock_guard<std::mutex> lock(limbo_mutex_);
     return shared_blocks_.size();
   }
 
  private:
-  // TODO: Can be changed to FIFO in order to avoid full traverse on every
-  // collect()
+  void collector_loop();
+
   std::vector<std::unique_ptr<CudaIPCSentData>> shared_blocks_;
   std::mutex limbo_mutex_;
+  std::condition_variable collector_cv_;
+  std::thread collector_;
+  int64_t collector_pid_ = 0;
+  bool stop_collector_ = false;
+};
+
+// Counters files of producers mapped by a consumer, most recently used first
+struct CudaIPCMappedRefCounters final {
+  void release(const std::string& handle, int64_t offset);
+
+ private:
+  std::list<std::pair<std::string, at::DataPtr>> files_;
+  std::mutex mutex_;
 };
 
 struct CudaIPCRefCountersFile final {
@@ -2,7 +2,9 @@
 
 #include <torch/data/dataloader_options.h>
 #include <torch/data/detail/data_shuttle.h>
+#include <torch/data/detail/device_transfer.h>
 #include <torch/data/detail/sequencers.h>
+#include <torch/data/detail/worker_process.h>
 #include <torch/data/iterator.h>
 #include <torch/data/samplers/random.h>
 #include <torch/data/worker_exception.h>
@@ -11,9 +13,11 @@
 #include <torch/csrc/utils/memory.h>
 #include <torch/csrc/utils/variadic.h>
 
+#include <ATen/detail/CUDAHooksInterface.h>
 #include <c10/util/Exception.h>
 
 #include <cstddef>
+#include <deque>
 #include <exception>
 #include <memory>
 #include <thread>
@@ -37,7 +41,16 @@ class DataLoaderBase {
       std::unique_ptr<Dataset> main_thread_dataset = nullptr)
       : options_(std::move(options)),
         main_thread_dataset_(std::move(main_thread_dataset)),
-        sequencer_(new_sequencer()) {}
+        shuttle_(options_.max_jobs + options_.workers),
+        sequencer_(new_sequencer()) {
+    if (options_.device) {
+      AT_CHECK(
+          options_.device_prefetch > 0,
+          "DataLoader expects device_prefetch to be positive");
+      device_transfer_ =
+          torch::make_unique<detail::DeviceTransfer>(*options_.device);
+    }
+  }
 
   virtual ~DataLoaderBase() {
     join();
@@ -79,6 +92,7 @@ class DataLoaderBase {
       return;
     }
     shuttle_.drain();
+    drain_device_batches();
     // Send one 'quit' message per worker. Since a worker dies (exits its
     // thread) after receiving this message, each `QuitWorker()` message will be
     // read by exactly one worker.
@@ -137,6 +151,7 @@ class DataLoaderBase {
   /// new jobs.
   virtual void reset() {
     shuttle_.drain();
+    drain_device_batches();
     sequence_number_ = 0;
     sequencer_ = new_sequencer();
     prefetch();
@@ -145,13 +160,21 @@ class DataLoaderBase {
   /// Schedules `requested_jobs` many new batches to be fetched. The actual
   /// number of jobs scheduled may be less if the DataLoader exhausts.
   void prefetch(size_t requested_jobs) {
-    for (size_t r = 0; r < requested_jobs; ++r) {
+    if (requested_jobs == 1) {
       if (auto batch_request = get_batch_request()) {
         this->push_job(std::move(*batch_request));
+      }
+      return;
+    }
+    std::vector<Job> jobs;
+    for (size_t r = 0; r < requested_jobs; ++r) {
+      if (auto batch_request = get_batch_request()) {
+        jobs.emplace_back(std::move(*batch_request), sequence_number_++);
       } else {
         break;
       }
     }
+    shuttle_.push_jobs(std::move(jobs));
   }
 
   /// Schedules the maximum number of jobs (based on the `max_jobs` option).
@@ -163,6 +186,33 @@ class DataLoaderBase {
   /// is exhausted. This operation will block until a batch is available if one
   /// is still expected.
   optional<BatchType> next() {
+    if (!device_transfer_) {
+      return next_on_host();
+    }
+    while (device_batches_.size() < options_.device_prefetch) {
+      auto batch = next_on_host();
+      if (!batch) {
+        break;
+      }
+      auto copy = [this](Tensor tensor) {
+        return this->device_transfer_->copy(tensor);
+      };
+      auto on_device = detail::map_tensors(std::move(*batch), copy);
+      device_batches_.emplace_back(
+          std::move(on_device), device_transfer_->record());
+    }
+    if (device_batches_.empty()) {
+      return nullopt;
+    }
+    auto batch = std::move(device_batches_.front());
+    device_batches_.pop_front();
+    batch.second();
+    return std::move(batch.first);
+  }
+
+  /// Like `next()`, but returns the batch as produced by the dataset (and
+  /// pinned, if configured).
+  optional<BatchType> next_on_host() {
     if (options_.workers > 0) {
       while (optional<Result> result = this->pop_result()) {
         if (result->exception) {
@@ -173,20 +223,69 @@ class DataLoaderBase {
         }
       }
     } else if (auto batch_request = get_batch_request()) {
-      return this->main_thread_dataset_->get_batch(std::move(*batch_request));
+      return pin(
+          this->main_thread_dataset_->get_batch(std::move(*batch_request)));
     }
     return nullopt;
   }
 
+  /// Discards the batches that are being copied to the device. Their memory
+  /// may only be reused once the copies have completed, so the current stream
+  /// is made to wait for them.
+  void drain_device_batches() {
+    for (auto& batch : device_batches_) {
+      batch.second();
+    }
+    device_batches_.clear();
+  }
+
+  /// Copies the tensors of `batch` into pinned memory if the `pin_memory`
+  /// option is set. Tensors that are pinned already, for example because
+  /// they were collated by `transforms::Stack(/*pin_memory=*/true)`, are left
+  /// as they are.
+  template <typename T>
+  T pin(T batch) const {
+    if (!options_.pin_memory) {
+      return batch;
+    }
+    return detail::map_tensors(std::move(batch), [](Tensor tensor) {
+      if (!tensor.defined() ||
+          tensor.storage().allocator() ==
+              at::detail::getCUDAHooks().getPinnedMemoryAllocator()) {
+        return tensor;
+      }
+      return tensor.pin_memory();
+    });
+  }
+
   /// The function that worker threads run.
   void worker_thread(Dataset& dataset) {
+    run_worker([&dataset](BatchRequestType request) {
+      return dataset.get_batch(std::move(request));
+    });
+  }
+
+  /// The function that worker threads run if the batches are loaded by
+  /// worker processes. Each thread hands its jobs to one process.
+  void worker_thread(detail::WorkerProcess& process) {
+    run_worker([&process](BatchRequestType request) {
+      detail::WireWriter writer;
+      detail::Transport<BatchRequestType>::write(writer, request);
+      auto reader = process.request(writer);
+      return detail::Transport<Batch>::read(reader);
+    });
+  }
+
+  /// Processes jobs with `get_batch` until told to quit.
+  template <typename GetBatch>
+  void run_worker(const GetBatch& get_batch) {
     while (true) {
       auto job = shuttle_.pop_job();
       if (job.quit) {
         break;
       }
       try {
-        auto batch = dataset.get_batch(std::move(*job.batch_request));
+        auto batch = pin(get_batch(std::move(*job.batch_request)));
         shuttle_.push_result({std::move(batch), job.sequence_number});
       } catch (...) {
         shuttle_.push_result({std::current_exception(), job.sequence_number});
@@ -194,6 +293,22 @@ class DataLoaderBase {
     }
   }
 
+  /// Forks a worker process that loads batches from its copy of `dataset`.
+  void fork_worker(Dataset& dataset) {
+    AT_CHECK(
+        detail::Transport<Batch>::supported &&
+            detail::Transport<BatchRequestType>::supported,
+        "DataLoader worker processes only support batches and batch requests "
+        "made of integers, tensors, Examples and vectors thereof");
+    // The handler only runs in the child, where `dataset` is still alive.
+    worker_processes_.push_back(torch::make_unique<detail::WorkerProcess>(
+        [&dataset](detail::WireReader& request, detail::WireWriter& response) {
+          auto batch = dataset.get_batch(
+              detail::Transport<BatchRequestType>::read(request));
+          detail::Transport<Batch>::write(response, batch);
+        }));
+  }
+
   /// Convenience method that calls `shuttle_.push_job()` with the next sequence
   /// number.
   template <typename T>
@@ -233,12 +348,24 @@ class DataLoaderBase {
   /// The worker threads, running the `worker_thread()` method.
   std::vector<std::thread> workers_;
 
+  /// The worker processes, if the `worker_processes` option is set. They
+  /// exit when destroyed, after the worker threads have been joined.
+  std::vector<std::unique_ptr<detail::WorkerProcess>> worker_processes_;
+
   /// The `DataShuttle` which takes care of the life cycle of a job.
   detail::DataShuttle<Job, Result> shuttle_;
 
   /// The `Sequencer`, which handles optional ordering of batches.
   std::unique_ptr<detail::sequencers::Sequencer<Result>> sequencer_;
 
+  /// Copies batches to `options_.device`, if set.
+  std::unique_ptr<detail::DeviceTransfer> device_transfer_;
+
+  /// Batches whose copies to the device have been started, with the function
+  /// that waits for them, in the order they are returned.
+  std::deque<std::pair<BatchType, detail::DeviceTransfer::Ready>>
+      device_batches_;
+
   /// True if the DataLoader has joined its worker threads.
   bool joined_ = false;
 };
@@ -38,6 +38,10 @@ class StatefulDataLoader : public DataLoaderBase<
       : super(
             std::move(options),
             torch::make_unique<Dataset>(std::move(dataset))) {
+    AT_CHECK(
+        !this->options_.worker_processes,
+        "DataLoader worker processes are not supported for stateful "
+        "datasets, whose state would not be shared between the processes");
     for (size_t w = 0; w < this->options_.workers; ++w) {
       // As opposed to the stateless case, here all worker threads access the
       // same underlying dataset.
@@ -40,13 +40,27 @@ class StatelessDataLoader : public DataLoaderBase<
       Sampler sampler,
       DataLoaderOptions options)
       : super(std::move(options)), sampler_(std::move(sampler)) {
-    for (size_t w = 0; w < this->options_.workers; ++w) {
-      // Here we copy the dataset into the worker thread closure. Each worker
-      // has its own copy of the dataset. This means the dataset must be
-      // trivially copiable, or else we don't expect more than one worker to
-      // be in use.
-      this->workers_.emplace_back(
-          [this, dataset]() mutable { this->worker_thread(dataset); });
+    if (this->options_.worker_processes) {
+      // All processes are forked before any worker thread is started. Each
+      // process inherits its own copy of the dataset, and is driven by one
+      // worker thread.
+      for (size_t w = 0; w < this->options_.workers; ++w) {
+        this->fork_worker(dataset);
+      }
+      for (auto& process : this->worker_processes_) {
+        auto* worker = process.get();
+        this->workers_.emplace_back(
+            [this, worker] { this->worker_thread(*worker); });
+      }
+    } else {
+      for (size_t w = 0; w < this->options_.workers; ++w) {
+        // Here we copy the dataset into the worker thread closure. Each worker
+        // has its own copy of the dataset. This means the dataset must be
+        // trivially copiable, or else we don't expect more than one worker to
+        // be in use.
+        this->workers_.emplace_back(
+            [this, dataset]() mutable { this->worker_thread(dataset); });
+      }
     }
     if (this->options_.workers == 0) {
       this->main_thread_dataset_ =
@@ -37,6 +37,30 @@ struct DataLoaderOptions {
   /// Whether to omit the last batch if it contains less than `batch_size`
   /// examples.
   TORCH_ARG(bool, drop_last) = false;
+
+  /// Whether to copy the tensors of every batch into pinned (page-locked)
+  /// memory before returning it, so that it can be copied to a CUDA device
+  /// asynchronously. Memory is pinned by the worker threads, if any.
+  TORCH_ARG(bool, pin_memory) = false;
+
+  /// If set, batches are returned on this device. Batches are copied ahead of
+  /// their use, up to `device_prefetch` of them at a time. For CUDA devices,
+  /// the copies are made on a side stream, which the current stream waits for
+  /// when a batch is returned. Combine with `pin_memory` so that the copies
+  /// do not block.
+  TORCH_ARG(optional<Device>, device);
+
+  /// The number of batches to copy to `device` ahead of their use.
+  TORCH_ARG(size_t, device_prefetch) = 2;
+
+  /// Whether each of the `workers` loads its batches in a separate process,
+  /// forked from the process that creates the DataLoader, instead of in a
+  /// thread. Use this for datasets that call code which does not scale across
+  /// threads. The tensors of every batch are returned through shared memory,
+  /// without being copied again. Only supported for stateless datasets on
+  /// POSIX systems, with batches and batch requests made of integers,
+  /// tensors, `Example`s and vectors thereof.
+  TORCH_ARG(bool, worker_processes) = false;
 };
 
 /// Like `DataLoaderOptions`, but without any unconfigured state.
@@ -52,7 +76,11 @@ struct FullDataLoaderOptions {
         max_jobs(options.max_jobs_.value_or(2 * workers)),
         timeout(options.timeout_),
         enforce_ordering(options.enforce_ordering_),
-        drop_last(options.drop_last_) {}
+        drop_last(options.drop_last_),
+        pin_memory(options.pin_memory_),
+        device(options.device_),
+        device_prefetch(options.device_prefetch_),
+        worker_processes(options.worker_processes_) {}
 
   size_t batch_size;
   size_t workers;
@@ -60,6 +88,10 @@ struct FullDataLoaderOptions {
   optional<std::chrono::milliseconds> timeout;
   bool enforce_ordering;
   bool drop_last;
+  bool pin_memory;
+  optional<Device> device;
+  size_t device_prefetch;
+  bool worker_processes;
 };
 } // namespace data
 } // namespace torch
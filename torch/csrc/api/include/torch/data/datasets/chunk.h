@@ -2,6 +2,12 @@
 
 #include <torch/data/datasets/stateful.h>
 
+#include <algorithm>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
 namespace torch {
 namespace data {
 namespace datasets {
@@ -141,6 +147,16 @@ class BatchDataBuffer {
     cv_read_.notify_all();
   }
 
+  /// Blocks until fewer than `example_count` examples are in the queue, or
+  /// the buffer is stopped. Called from the ChunkDataset worker threads.
+  void wait_for_room(size_t example_count) {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    cv_write_.wait(lock, [this, example_count] {
+      return this->total_example_count_in_queue_ < example_count ||
+          this->stop_;
+    });
+  }
+
   /// Push exceptions thrown during preloading into batch queue. Called from
   /// the ChunkDataset worker threads.
   void add_chunk_data(std::exception_ptr e_ptr) {
@@ -231,6 +247,52 @@ class BatchDataBuffer {
   // the program to hang. This boolean is used to break this waiting condition.
   bool stop_ = false;
 };
+
+/// A thread-safe cache of the most recently used chunks. Holds at most
+/// `capacity` chunks; when full, the least recently used one is evicted.
+template <typename Chunk>
+class ChunkCache {
+ public:
+  explicit ChunkCache(size_t capacity) : capacity_(capacity) {
+    AT_ASSERT(capacity_ > 0);
+  }
+
+  /// Returns a copy of the chunk with index `chunk_index` if it is cached.
+  optional<Chunk> get(size_t chunk_index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = chunks_.find(chunk_index);
+    if (it == chunks_.end()) {
+      return nullopt;
+    }
+    order_.splice(order_.begin(), order_, it->second.second);
+    return it->second.first;
+  }
+
+  /// Caches a copy of `chunk` under `chunk_index`.
+  void put(size_t chunk_index, const Chunk& chunk) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = chunks_.find(chunk_index);
+    if (it != chunks_.end()) {
+      it->second.first = chunk;
+      order_.splice(order_.begin(), order_, it->second.second);
+      return;
+    }
+    if (chunks_.size() == capacity_) {
+      chunks_.erase(order_.back());
+      order_.pop_back();
+    }
+    order_.push_front(chunk_index);
+    chunks_.emplace(chunk_index, std::make_pair(chunk, order_.begin()));
+  }
+
+ private:
+  size_t capacity_;
+  // Chunk indices, the most recently used first.
+  std::list<size_t> order_;
+  std::unordered_map<size_t, std::pair<Chunk, std::list<size_t>::iterator>>
+      chunks_;
+  std::mutex mutex_;
+};
 } // namespace detail
 
 /// Options to configure a `ChunkDataset`.
@@ -266,6 +328,27 @@ struct ChunkDatasetOptions {
 
   // the capacity of the queue for batch caching.
   TORCH_ARG(size_t, cache_size) = 2048;
+
+  /// The number of chunks of the next epoch to read while the last batches of
+  /// the current one are consumed. The chunk order of the next epoch is then
+  /// drawn from the chunk sampler as soon as the current epoch has run out of
+  /// chunks, so changes to the sampler (such as setting its epoch) must be
+  /// made before that. Chunk readers must support reading them before
+  /// `reset()` is called.
+  TORCH_ARG(size_t, cross_epoch_read_ahead) = 0;
+
+  /// The number of chunks to keep in memory after they are read, so that
+  /// chunks used again in later epochs are not read again. Chunks are
+  /// identified by their index, so the reader must return the same data for
+  /// the same index in every epoch.
+  TORCH_ARG(size_t, chunk_cache_size) = 0;
+
+  /// Whether the number of preloaders reading chunks at a time adapts to the
+  /// occupancy of the batch cache. Preloader `i` of `n` only reads a new chunk
+  /// while fewer than `cache_size * (n - i) / n` examples are cached, so all
+  /// preloaders run when the cache drains and a single one when it is full,
+  /// instead of all of them holding chunks that do not fit into the cache.
+  TORCH_ARG(bool, adaptive_preloading) = false;
 };
 
 /// A stateful dataset that support hierarchical sampling and prefetching of
@@ -302,7 +385,13 @@ class ChunkDataset final
         example_sampler_(std::move(example_sampler)),
         options_(std::move(options)),
         quit_worker_(false),
-        running_preloaders_(0) {}
+        running_preloaders_(0) {
+    if (options_.chunk_cache_size_ > 0) {
+      chunk_cache_ =
+          torch::make_unique<detail::ChunkCache<UnwrappedBatchType>>(
+              options_.chunk_cache_size_);
+    }
+  }
 
   virtual ~ChunkDataset() {
     // stop batch buffer first.
@@ -343,7 +432,18 @@ class ChunkDataset final
 
     chunk_reader_.reset();
 
-    chunk_sampler_.reset(chunk_reader_.chunk_count());
+    read_ahead_queue_.clear();
+    if (next_epoch_drawn_) {
+      // The chunk sampler was already reset for this epoch, and the first
+      // chunks it returned were read ahead.
+      pending_chunks_ = std::move(next_epoch_chunks_);
+      next_epoch_chunks_.clear();
+      next_epoch_drawn_ = false;
+    } else {
+      pending_chunks_.clear();
+      read_ahead_chunks_.clear();
+      chunk_sampler_.reset(chunk_reader_.chunk_count());
+    }
 
     // Throw out any existing cached batch in the buffer and re-creates a new
     // chunk buffer.
@@ -379,16 +479,27 @@ class ChunkDataset final
   void preloader(size_t id) {
     while (!quit_worker_.load()) {
       try {
+        if (options_.adaptive_preloading_ && id > 0) {
+          const auto count = options_.preloader_count_;
+          batch_buffer_->wait_for_room(std::max<size_t>(
+              1, options_.cache_size_ * (count - id) / count));
+          if (quit_worker_.load()) {
+            break;
+          }
+        }
         size_t chunk_id = 0;
         {
           std::lock_guard<std::mutex> lock(chunk_index_guard_);
-          if (auto chunk_sampler_result = chunk_sampler_.next(1)) {
+          if (!pending_chunks_.empty()) {
+            chunk_id = pending_chunks_.front();
+            pending_chunks_.pop_front();
+          } else if (auto chunk_sampler_result = chunk_sampler_.next(1)) {
             chunk_id = chunk_sampler_result.value()[0];
           } else {
             break;
           }
         }
-        UnwrappedBatchType data = chunk_reader_.read_chunk(chunk_id);
+        UnwrappedBatchType data = load_chunk(chunk_id);
         if (!data.empty()) { // skip empty chunks.
           batch_buffer_->add_chunk_data(std::move(data));
         }
@@ -402,6 +513,69 @@ class ChunkDataset final
       // all preloaders are completed, so we can notify the batch_buffer.
       batch_buffer_->stop();
     }
+    if (options_.cross_epoch_read_ahead_ > 0) {
+      read_ahead();
+    }
+  }
+
+  /// Reads the first chunks of the next epoch. Called by the preloaders once
+  /// the current epoch has run out of chunks.
+  void read_ahead() {
+    while (!quit_worker_.load()) {
+      size_t chunk_id = 0;
+      {
+        std::lock_guard<std::mutex> lock(chunk_index_guard_);
+        if (!next_epoch_drawn_) {
+          // Only the first preloader to get here draws the next epoch.
+          next_epoch_drawn_ = true;
+          chunk_sampler_.reset(chunk_reader_.chunk_count());
+          for (size_t i = 0; i < options_.cross_epoch_read_ahead_; ++i) {
+            auto chunk_sampler_result = chunk_sampler_.next(1);
+            if (!chunk_sampler_result) {
+              break;
+            }
+            next_epoch_chunks_.push_back(chunk_sampler_result.value()[0]);
+            read_ahead_queue_.push_back(chunk_sampler_result.value()[0]);
+          }
+        }
+        if (read_ahead_queue_.empty()) {
+          return;
+        }
+        chunk_id = read_ahead_queue_.front();
+        read_ahead_queue_.pop_front();
+      }
+      try {
+        auto data = load_chunk(chunk_id);
+        std::lock_guard<std::mutex> lock(chunk_index_guard_);
+        read_ahead_chunks_.emplace(chunk_id, std::move(data));
+      } catch (...) {
+        // The chunk is read again in the next epoch, which reports the error.
+      }
+    }
+  }
+
+  /// Returns the chunk with index `chunk_id`, from the chunks read ahead or
+  /// the chunk cache if possible.
+  UnwrappedBatchType load_chunk(size_t chunk_id) {
+    {
+      std::lock_guard<std::mutex> lock(chunk_index_guard_);
+      auto it = read_ahead_chunks_.find(chunk_id);
+      if (it != read_ahead_chunks_.end()) {
+        auto data = std::move(it->second);
+        read_ahead_chunks_.erase(it);
+        return data;
+      }
+    }
+    if (chunk_cache_) {
+      if (auto data = chunk_cache_->get(chunk_id)) {
+        return std::move(*data);
+      }
+    }
+    UnwrappedBatchType data = chunk_reader_.read_chunk(chunk_id);
+    if (chunk_cache_) {
+      chunk_cache_->put(chunk_id, data);
+    }
+    return data;
   }
 
   /// Block the current thread until the workers finish execution and exit.
@@ -443,8 +617,26 @@ class ChunkDataset final
   // indicates that the chunk loading is completed.
   std::atomic<size_t> running_preloaders_;
 
-  // mutex to synchronize chunk sampler next() call.
+  // mutex to synchronize chunk sampler next() call, and access to the chunks
+  // of the next epoch below.
   std::mutex chunk_index_guard_;
+
+  // chunks of the current epoch that were drawn from the chunk sampler before
+  // the epoch started, and are loaded before any other.
+  std::deque<size_t> pending_chunks_;
+
+  // whether the chunk sampler has been reset for the next epoch already, and
+  // the first chunks of that epoch.
+  bool next_epoch_drawn_ = false;
+  std::deque<size_t> next_epoch_chunks_;
+
+  // chunks of the next epoch that still need to be read ahead, and the ones
+  // that have been.
+  std::deque<size_t> read_ahead_queue_;
+  std::unordered_map<size_t, UnwrappedBatchType> read_ahead_chunks_;
+
+  // recently read chunks, if the chunk_cache_size option is set.
+  std::unique_ptr<detail::ChunkCache<UnwrappedBatchType>> chunk_cache_;
 };
 } // namespace datasets
 } // namespace data
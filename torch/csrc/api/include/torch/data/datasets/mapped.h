@@ -0,0 +1,106 @@
+#pragma once
+
+#include <torch/data/datasets/base.h>
+#include <torch/data/example.h>
+#include <torch/types.h>
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+
+#include <c10/util/ArrayRef.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace torch {
+namespace data {
+namespace datasets {
+/// A dataset stored in a memory-mapped, columnar binary file.
+///
+/// Each column of the file stores one tensor per example, of a fixed dtype.
+/// In a fixed-size column all tensors have the same shape. In a ragged column
+/// they have the same shape except for the first dimension, and an index of
+/// row offsets locates the rows of every example. The file is mapped instead
+/// of read, so datasets larger than memory are paged in from disk as they are
+/// used.
+///
+/// `get()` returns tensors that are views into the mapping, without copying.
+/// The mapping is private: writing to the tensors does not modify the file.
+/// `get_batch()` gathers the examples into one tensor per column, copying
+/// runs of consecutive examples with a single `memcpy`. For ragged columns,
+/// the rows of the examples are concatenated.
+///
+/// Files are written with `MappedDataset::write`. Only supported on POSIX
+/// systems.
+class TORCH_API MappedDataset : public BatchDataset<MappedDataset, Example<>> {
+ public:
+  /// Maps the file at `path`. Examples hold the tensors of the columns named
+  /// `data_column` and `target_column`. If `target_column` is empty, the
+  /// targets are undefined tensors.
+  explicit MappedDataset(
+      const std::string& path,
+      const std::string& data_column = "data",
+      const std::string& target_column = "target");
+
+  /// Returns the `Example` at the given `index`, as views into the mapping.
+  Example<> get(size_t index) const;
+
+  /// Returns the examples at the given `indices`, stacked into one tensor for
+  /// the data and one for the targets.
+  Example<> get_batch(ArrayRef<size_t> indices) override;
+
+  /// Returns the number of examples in the dataset.
+  optional<size_t> size() const override;
+
+  /// Returns the tensor of the column named `name` for the example at the
+  /// given `index`, as a view into the mapping.
+  Tensor get_column(const std::string& name, size_t index) const;
+
+  /// Returns the names of the columns in the file.
+  std::vector<std::string> column_names() const;
+
+  /// Writes a file that can be mapped by `MappedDataset`. Every column is
+  /// given as a name and one CPU tensor per example; all columns must have
+  /// the same number of examples. A column whose tensors differ in shape is
+  /// stored as a ragged column.
+  static void write(
+      const std::string& path,
+      const std::vector<std::pair<std::string, std::vector<Tensor>>>& columns);
+
+ private:
+  struct Column {
+    std::string name;
+    ScalarType dtype;
+    /// The shape of every example for fixed-size columns, and the shape of a
+    /// row for ragged columns.
+    std::vector<int64_t> shape;
+    bool ragged;
+    uint64_t data_offset;
+    /// The offset of `size() + 1` row offsets, for ragged columns.
+    uint64_t index_offset;
+    /// The number of bytes of an example (fixed-size) or a row (ragged).
+    size_t row_bytes;
+  };
+
+  size_t find_column(const std::string& name) const;
+
+  /// Returns the rows of `column` that belong to the example at `index`.
+  std::pair<uint64_t, uint64_t> rows(const Column& column, size_t index) const;
+
+  Tensor view(const Column& column, size_t index) const;
+  Tensor gather(const Column& column, ArrayRef<size_t> indices) const;
+
+  std::shared_ptr<void> mapping_;
+  const char* base_ = nullptr;
+  size_t bytes_ = 0;
+  size_t size_ = 0;
+  std::vector<Column> columns_;
+  size_t data_column_ = 0;
+  optional<size_t> target_column_;
+};
+} // namespace datasets
+} // namespace data
+} // namespace torch
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <torch/types.h>
+
+#include <c10/util/Exception.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace torch {
+namespace data {
+namespace detail {
+
+/// A bounded, lock-free MPMC queue.
+///
+/// The elements live in a ring buffer whose cells carry a sequence number
+/// that tells producers and consumers whether the cell is free for the
+/// current lap or holds a value (Vyukov's bounded MPMC queue). A push or pop
+/// claims a range of consecutive cells with a single compare-and-swap, so
+/// batches cost one atomic read-modify-write no matter their size.
+///
+/// Blocking calls first spin, yielding the CPU between attempts, and then
+/// park on a condition variable. The condition variables are only touched
+/// when a thread is parked on the other side, so they stay off the fast path.
+///
+/// Note that this data structure is written specifically for use with the
+/// `DataLoader`. Its behavior is tailored to this use case and may not be
+/// applicable to more general uses.
+template <typename T>
+class BoundedQueue {
+ public:
+  /// Constructs a queue that holds at least `capacity` elements. The capacity
+  /// is rounded up to a power of two.
+  explicit BoundedQueue(size_t capacity) {
+    size_t rounded = 2;
+    while (rounded < capacity) {
+      rounded *= 2;
+    }
+    mask_ = rounded - 1;
+    cells_.reset(new Cell[rounded]);
+    for (size_t i = 0; i < rounded; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  ~BoundedQueue() {
+    clear();
+  }
+
+  /// Returns the number of elements the queue can hold.
+  size_t capacity() const noexcept {
+    return mask_ + 1;
+  }
+
+  /// Moves as many of the `count` values starting at `first` into the queue
+  /// as there is space for, without blocking, and returns how many were
+  /// moved.
+  template <typename Iterator>
+  size_t try_push(Iterator first, size_t count) {
+    size_t position = enqueue_position_.load(std::memory_order_relaxed);
+    while (true) {
+      const auto free = claimable(position, count, /*lap_offset=*/0);
+      if (free < 0) {
+        position = enqueue_position_.load(std::memory_order_relaxed);
+        continue;
+      }
+      if (free == 0) {
+        return 0;
+      }
+      const auto n = static_cast<size_t>(free);
+      if (enqueue_position_.compare_exchange_weak(
+              position, position + n, std::memory_order_relaxed)) {
+        for (size_t i = 0; i < n; ++i, ++first) {
+          Cell& cell = cells_[(position + i) & mask_];
+          new (&cell.storage) T(std::move(*first));
+          cell.sequence.store(position + i + 1, std::memory_order_release);
+        }
+        wake(not_empty_, n);
+        return n;
+      }
+    }
+  }
+
+  /// Moves up to `max_count` values out of the queue into `output`, without
+  /// blocking, and returns how many were moved.
+  template <typename OutputIterator>
+  size_t try_pop(OutputIterator output, size_t max_count) {
+    size_t position = dequeue_position_.load(std::memory_order_relaxed);
+    while (true) {
+      const auto ready = claimable(position, max_count, /*lap_offset=*/1);
+      if (ready < 0) {
+        position = dequeue_position_.load(std::memory_order_relaxed);
+        continue;
+      }
+      if (ready == 0) {
+        return 0;
+      }
+      const auto n = static_cast<size_t>(ready);
+      if (dequeue_position_.compare_exchange_weak(
+              position, position + n, std::memory_order_relaxed)) {
+        for (size_t i = 0; i < n; ++i) {
+          Cell& cell = cells_[(position + i) & mask_];
+          T* value = reinterpret_cast<T*>(&cell.storage);
+          *output++ = std::move(*value);
+          value->~T();
+          cell.sequence.store(
+              position + i + mask_ + 1, std::memory_order_release);
+        }
+        wake(not_full_, n);
+        return n;
+      }
+    }
+  }
+
+  /// Pushes a new value to the back of the queue, blocking while it is full.
+  void push(T value) {
+    wait_until(not_full_, nullopt, [this, &value] {
+      return this->try_push(&value, 1);
+    });
+  }
+
+  /// Pushes all `values` to the back of the queue, in order, blocking while
+  /// it is full.
+  void push(std::vector<T> values) {
+    size_t pushed = 0;
+    while (pushed < values.size()) {
+      pushed += wait_until(not_full_, nullopt, [this, &values, pushed] {
+        return this->try_push(values.begin() + pushed, values.size() - pushed);
+      });
+    }
+  }
+
+  /// Blocks until at least one element is ready to be popped from the front of
+  /// the queue. An optional `timeout` in seconds can be used to limit the time
+  /// spent waiting for an element. If the wait times out, an exception is
+  /// raised.
+  T pop(optional<std::chrono::milliseconds> timeout = nullopt) {
+    optional<T> value;
+    wait_until(not_empty_, timeout, [this, &value] {
+      return this->try_pop(OptionalInserter(value), 1);
+    });
+    return std::move(*value);
+  }
+
+  /// Like `pop()`, but appends up to `max_count` elements to `values` once at
+  /// least one is ready, and returns how many were appended.
+  size_t pop(
+      std::vector<T>& values,
+      size_t max_count,
+      optional<std::chrono::milliseconds> timeout = nullopt) {
+    return wait_until(not_empty_, timeout, [this, &values, max_count] {
+      return this->try_pop(std::back_inserter(values), max_count);
+    });
+  }
+
+  /// Empties the queue and returns the number of elements that were removed.
+  size_t clear() {
+    std::vector<T> discarded;
+    size_t count = 0;
+    while (size_t popped = try_pop(std::back_inserter(discarded), capacity())) {
+      count += popped;
+      discarded.clear();
+    }
+    return count;
+  }
+
+ private:
+  // The number of attempts a blocking call makes before it parks.
+  static constexpr size_t kSpinCount = 64;
+
+  struct Cell {
+    std::atomic<size_t> sequence;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+  };
+
+  // Where threads that wait for a queue to become non-empty (or non-full)
+  // park.
+  struct Parking {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::atomic<size_t> sleepers{0};
+  };
+
+  // Assigns a single element to an `optional`.
+  struct OptionalInserter {
+    explicit OptionalInserter(optional<T>& value) : value(&value) {}
+    OptionalInserter& operator*() {
+      return *this;
+    }
+    OptionalInserter& operator++(int) {
+      return *this;
+    }
+    OptionalInserter& operator=(T&& element) {
+      *value = std::move(element);
+      return *this;
+    }
+    optional<T>* value;
+  };
+
+  // Returns how many of the `count` cells starting at `position` are ready
+  // to be claimed: free ones for producers (`lap_offset` 0), full ones for
+  // consumers (`lap_offset` 1). Returns -1 if `position` is out of date.
+  int64_t claimable(size_t position, size_t count, size_t lap_offset) const {
+    size_t n = 0;
+    for (; n < count; ++n) {
+      const Cell& cell = cells_[(position + n) & mask_];
+      const auto sequence = cell.sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<intptr_t>(sequence) -
+          static_cast<intptr_t>(position + n + lap_offset);
+      if (difference != 0) {
+        if (n == 0 && difference > 0) {
+          return -1;
+        }
+        break;
+      }
+    }
+    return static_cast<int64_t>(n);
+  }
+
+  // Wakes threads parked on `parking` after `count` elements were pushed to
+  // (or popped from) the queue.
+  void wake(Parking& parking, size_t count) {
+    // Pairs with the fence in `wait_until`: either the sleeper sees the new
+    // state of the cells, or this thread sees the sleeper.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parking.sleepers.load(std::memory_order_relaxed) > 0) {
+      std::lock_guard<std::mutex> lock(parking.mutex);
+      if (count == 1) {
+        parking.cv.notify_one();
+      } else {
+        parking.cv.notify_all();
+      }
+    }
+  }
+
+  // Calls `attempt` until it returns non-zero, spinning first and then
+  // parking on `parking`, and returns its result.
+  template <typename Attempt>
+  size_t wait_until(
+      Parking& parking,
+      optional<std::chrono::milliseconds> timeout,
+      const Attempt& attempt) {
+    for (size_t i = 0; i < kSpinCount; ++i) {
+      if (const size_t count = attempt()) {
+        return count;
+      }
+      std::this_thread::yield();
+    }
+    const auto deadline = std::chrono::steady_clock::now() +
+        timeout.value_or(std::chrono::milliseconds(0));
+    std::unique_lock<std::mutex> lock(parking.mutex);
+    while (true) {
+      parking.sleepers.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const size_t count = attempt();
+      if (count == 0) {
+        if (timeout) {
+          parking.cv.wait_until(lock, deadline);
+        } else {
+          parking.cv.wait(lock);
+        }
+      }
+      parking.sleepers.fetch_sub(1, std::memory_order_relaxed);
+      if (count > 0) {
+        return count;
+      }
+      if (timeout && std::chrono::steady_clock::now() >= deadline) {
+        if (const size_t late = attempt()) {
+          return late;
+        }
+        // clang-format off
+        AT_ERROR(
+            "Timeout in DataLoader queue while waiting for next batch"
+            " (timeout was ", timeout->count(), " ms)");
+        // clang-format on
+      }
+    }
+  }
+
+  // Producers and consumers touch different ends of the queue, so the
+  // positions are kept on separate cache lines.
+  static constexpr size_t kCacheLineSize = 64;
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_;
+  char padding0_[kCacheLineSize];
+  std::atomic<size_t> enqueue_position_{0};
+  char padding1_[kCacheLineSize];
+  std::atomic<size_t> dequeue_position_{0};
+  char padding2_[kCacheLineSize];
+  Parking not_empty_;
+  Parking not_full_;
+};
+
+template <typename T>
+constexpr size_t BoundedQueue<T>::kSpinCount;
+
+template <typename T>
+constexpr size_t BoundedQueue<T>::kCacheLineSize;
+} // namespace detail
+} // namespace data
+} // namespace torch
@@ -1,13 +1,16 @@
 #pragma once
 
-#include <torch/data/detail/queue.h>
+#include <torch/data/detail/bounded_queue.h>
 #include <torch/types.h>
 
 #include <c10/util/Exception.h>
 #include <c10/util/Optional.h>
 
 #include <chrono>
+#include <cstddef>
+#include <deque>
 #include <utility>
+#include <vector>
 
 namespace torch {
 namespace data {
@@ -22,15 +25,29 @@ namespace detail {
 /// dequeues a result is the count of in-flight jobs decremented. When the main
 /// thread attempts to dequeue a job but no jobs are in-flight, that means the
 /// epoch is complete and `pop_result` returns an empty optional.
+///
+/// Both queues are bounded and lock-free. Their `capacity` must be at least
+/// the largest number of jobs that are in flight at any time, or pushing can
+/// block forever.
 template <typename Job, typename Result>
 class DataShuttle {
  public:
+  explicit DataShuttle(size_t capacity = 64)
+      : new_jobs_(capacity), results_(capacity) {}
+
   /// Pushes a new job. Called by the main thread.
   void push_job(Job job) {
     new_jobs_.push(std::move(job));
     ++in_flight_jobs_;
   }
 
+  /// Pushes several new jobs at once. Called by the main thread.
+  void push_jobs(std::vector<Job> jobs) {
+    const auto count = jobs.size();
+    new_jobs_.push(std::move(jobs));
+    in_flight_jobs_ += count;
+  }
+
   /// Pushes the result of a job. Called by worker threads.
   void push_result(Result result) {
     results_.push(std::move(result));
@@ -43,13 +60,22 @@ class DataShuttle {
   }
 
   /// Returns the result of a job, or nullopt if all jobs were exhausted. Called
-  /// by the main thread.
+  /// by the main thread. All results that are ready are taken from the queue
+  /// at once, and handed out by subsequent calls.
   optional<Result> pop_result(
       optional<std::chrono::milliseconds> timeout = nullopt) {
     if (in_flight_jobs_ > 0) {
-      auto result = results_.pop(timeout);
+      if (popped_results_.empty()) {
+        batch_.clear();
+        results_.pop(batch_, in_flight_jobs_, timeout);
+        for (auto& result : batch_) {
+          popped_results_.push_back(std::move(result));
+        }
+      }
+      auto result = std::move(popped_results_.front());
+      popped_results_.pop_front();
       --in_flight_jobs_;
-      return result;
+      return std::move(result);
     }
     return nullopt;
   }
@@ -74,12 +100,16 @@ class DataShuttle {
 
  private:
   /// The queue for jobs that are not yet in flight.
-  Queue<Job> new_jobs_;
+  BoundedQueue<Job> new_jobs_;
   /// The number of in-flight jobs.
   /// NOTE: Not atomic because only manipulated by the main thread.
   size_t in_flight_jobs_ = 0;
   /// The queue for results of finished jobs.
-  Queue<Result> results_;
+  BoundedQueue<Result> results_;
+  /// Results taken from `results_` that were not returned yet, and the buffer
+  /// they are popped into. Only used by the main thread.
+  std::deque<Result> popped_results_;
+  std::vector<Result> batch_;
 };
 
 } // namespace detail
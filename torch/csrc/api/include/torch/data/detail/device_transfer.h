@@ -0,0 +1,102 @@
+#pragma once
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/data/example.h>
+#include <torch/types.h>
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace torch {
+namespace data {
+namespace detail {
+
+// The overloads are declared up front so that they can call each other.
+template <typename Data, typename Target, typename F>
+Example<Data, Target> map_tensors(Example<Data, Target> example, const F&);
+template <typename Data, typename F>
+Example<Data, example::NoTarget> map_tensors(
+    Example<Data, example::NoTarget> example,
+    const F&);
+template <typename T, typename F>
+std::vector<T> map_tensors(std::vector<T> values, const F&);
+template <typename T, typename F>
+optional<T> map_tensors(optional<T> value, const F&);
+
+/// Applies `function` to every tensor in `value` and returns the result.
+/// Tensors, `Example`s and vectors thereof are traversed; other types are
+/// returned unchanged.
+template <typename T, typename F>
+T map_tensors(T value, const F& /* unused */) {
+  return value;
+}
+
+template <typename F>
+Tensor map_tensors(Tensor tensor, const F& function) {
+  return function(std::move(tensor));
+}
+
+template <typename Data, typename Target, typename F>
+Example<Data, Target> map_tensors(
+    Example<Data, Target> example,
+    const F& function) {
+  example.data = map_tensors(std::move(example.data), function);
+  example.target = map_tensors(std::move(example.target), function);
+  return example;
+}
+
+template <typename Data, typename F>
+Example<Data, example::NoTarget> map_tensors(
+    Example<Data, example::NoTarget> example,
+    const F& function) {
+  example.data = map_tensors(std::move(example.data), function);
+  return example;
+}
+
+template <typename T, typename F>
+std::vector<T> map_tensors(std::vector<T> values, const F& function) {
+  for (auto& value : values) {
+    value = map_tensors(std::move(value), function);
+  }
+  return values;
+}
+
+template <typename T, typename F>
+optional<T> map_tensors(optional<T> value, const F& function) {
+  if (value) {
+    value = map_tensors(std::move(*value), function);
+  }
+  return value;
+}
+
+/// Copies batches to a device ahead of their use. For CUDA devices, the
+/// copies are issued on a side stream, so that they overlap with the work on
+/// the current stream, and are only waited for when the batch is handed out.
+/// For other devices, the copies are synchronous.
+class TORCH_API DeviceTransfer {
+ public:
+  /// Makes the stream that is current when it is called wait until the
+  /// copies of a batch have completed.
+  using Ready = std::function<void()>;
+
+  explicit DeviceTransfer(Device device);
+  ~DeviceTransfer();
+
+  /// Starts copying `tensor` to the device. Copies from pinned memory do not
+  /// block the calling thread. The result must not be used before the `Ready`
+  /// function returned by the next call to `record()` has been called.
+  Tensor copy(const Tensor& tensor);
+
+  /// Marks the end of the copies of one batch.
+  Ready record();
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+} // namespace detail
+} // namespace data
+} // namespace torch
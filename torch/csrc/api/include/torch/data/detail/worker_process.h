@@ -0,0 +1,186 @@
+#pragma once
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/data/example.h>
+#include <torch/types.h>
+
+#include <c10/util/Exception.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace torch {
+namespace data {
+namespace detail {
+
+/// Encodes a message for another process. Integers and strings are copied
+/// into the message; the contents of tensors are placed into a single shared
+/// memory segment when the message is sent, so the receiver can use them
+/// without copying.
+class TORCH_API WireWriter {
+ public:
+  void write_int(int64_t value);
+  void write_string(const std::string& value);
+  /// Writes a CPU tensor. Only its contents are sent, not its strides or
+  /// whether it requires grad.
+  void write_tensor(const Tensor& tensor);
+
+  const std::string& bytes() const noexcept {
+    return bytes_;
+  }
+
+  /// The number of bytes of shared memory the tensors of the message take.
+  size_t shared_bytes() const noexcept {
+    return shared_bytes_;
+  }
+
+  /// Copies the contents of the tensors into `segment`, which must have
+  /// `shared_bytes()` bytes.
+  void copy_tensors(void* segment) const;
+
+ private:
+  std::string bytes_;
+  std::vector<std::pair<Tensor, size_t>> tensors_;
+  size_t shared_bytes_ = 0;
+};
+
+/// Decodes a message written by a `WireWriter`. Tensors are views into the
+/// shared memory segment received with the message, which stays mapped as
+/// long as either the reader or one of the tensors is alive.
+class TORCH_API WireReader {
+ public:
+  WireReader(std::string bytes, std::shared_ptr<void> segment);
+
+  int64_t read_int();
+  std::string read_string();
+  Tensor read_tensor();
+
+ private:
+  std::string bytes_;
+  size_t position_ = 0;
+  std::shared_ptr<void> segment_;
+};
+
+/// Describes how values of type `T` are passed to and from worker processes.
+/// Supported are integers, tensors, `Example`s and vectors thereof.
+template <typename T, typename = void>
+struct Transport {
+  static constexpr bool supported = false;
+  static void write(WireWriter& /* unused */, const T& /* unused */) {
+    AT_ERROR(
+        "DataLoader worker processes only support batches and batch requests "
+        "made of integers, tensors, Examples and vectors thereof");
+  }
+  static T read(WireReader& /* unused */) {
+    AT_ERROR(
+        "DataLoader worker processes only support batches and batch requests "
+        "made of integers, tensors, Examples and vectors thereof");
+  }
+};
+
+template <typename T>
+struct Transport<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+  static constexpr bool supported = true;
+  static void write(WireWriter& writer, T value) {
+    writer.write_int(static_cast<int64_t>(value));
+  }
+  static T read(WireReader& reader) {
+    return static_cast<T>(reader.read_int());
+  }
+};
+
+template <>
+struct Transport<Tensor> {
+  static constexpr bool supported = true;
+  static void write(WireWriter& writer, const Tensor& tensor) {
+    writer.write_tensor(tensor);
+  }
+  static Tensor read(WireReader& reader) {
+    return reader.read_tensor();
+  }
+};
+
+template <typename T>
+struct Transport<std::vector<T>> {
+  static constexpr bool supported = Transport<T>::supported;
+  static void write(WireWriter& writer, const std::vector<T>& values) {
+    writer.write_int(values.size());
+    for (const auto& value : values) {
+      Transport<T>::write(writer, value);
+    }
+  }
+  static std::vector<T> read(WireReader& reader) {
+    const auto size = reader.read_int();
+    std::vector<T> values;
+    values.reserve(size);
+    for (int64_t i = 0; i < size; ++i) {
+      values.push_back(Transport<T>::read(reader));
+    }
+    return values;
+  }
+};
+
+template <typename Data, typename Target>
+struct Transport<Example<Data, Target>> {
+  static constexpr bool supported =
+      Transport<Data>::supported && Transport<Target>::supported;
+  static void write(WireWriter& writer, const Example<Data, Target>& example) {
+    Transport<Data>::write(writer, example.data);
+    Transport<Target>::write(writer, example.target);
+  }
+  static Example<Data, Target> read(WireReader& reader) {
+    auto data = Transport<Data>::read(reader);
+    auto target = Transport<Target>::read(reader);
+    return {std::move(data), std::move(target)};
+  }
+};
+
+template <typename Data>
+struct Transport<Example<Data, example::NoTarget>> {
+  static constexpr bool supported = Transport<Data>::supported;
+  static void write(
+      WireWriter& writer,
+      const Example<Data, example::NoTarget>& example) {
+    Transport<Data>::write(writer, example.data);
+  }
+  static Example<Data, example::NoTarget> read(WireReader& reader) {
+    return Transport<Data>::read(reader);
+  }
+};
+
+/// A child process, forked from the calling process, that answers requests
+/// with `handler`. The child has a copy of the memory of the parent at the
+/// time of the fork, so `handler` may use any state that exists by then. It
+/// runs single-threaded (also for intra-op parallelism) and exits when the
+/// `WorkerProcess` is destroyed, or when the parent dies.
+///
+/// Only supported on POSIX systems.
+class TORCH_API WorkerProcess {
+ public:
+  using Handler = std::function<void(WireReader& request, WireWriter& response)>;
+
+  explicit WorkerProcess(Handler handler);
+  ~WorkerProcess();
+
+  WorkerProcess(const WorkerProcess&) = delete;
+  WorkerProcess& operator=(const WorkerProcess&) = delete;
+
+  /// Sends `request` to the child and blocks until it has responded. If
+  /// `handler` threw, an exception with the same message is raised. Only one
+  /// thread may make requests at a time.
+  WireReader request(const WireWriter& request);
+
+ private:
+  int socket_ = -1;
+  int pid_ = -1;
+};
+
+} // namespace detail
+} // namespace data
+} // namespace torch
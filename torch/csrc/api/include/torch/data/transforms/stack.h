@@ -4,6 +4,12 @@
 #include <torch/data/transforms/collate.h>
 #include <torch/types.h>
 
+#include <ATen/Parallel.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <utility>
 #include <vector>
 
@@ -11,13 +17,73 @@ namespace torch {
 namespace data {
 namespace transforms {
 
+namespace detail {
+/// Stacks `tensors` into a new tensor, optionally in pinned memory. If the
+/// tensors are CPU tensors of the same shape and dtype that do not require
+/// grad, the batch is allocated once and every tensor is copied into its slot
+/// with a `memcpy`, in parallel. Otherwise this falls back to `torch::stack`.
+inline Tensor stack_into_batch(
+    const std::vector<Tensor>& tensors,
+    bool pin_memory) {
+  bool can_copy = !tensors.empty();
+  for (const auto& tensor : tensors) {
+    if (!tensor.defined() || !tensor.device().is_cpu() ||
+        tensor.layout() != kStrided ||
+        (tensor.is_variable() && tensor.requires_grad()) ||
+        tensor.scalar_type() != tensors.front().scalar_type() ||
+        tensor.sizes() != tensors.front().sizes()) {
+      can_copy = false;
+      break;
+    }
+  }
+  if (!can_copy) {
+    auto batch = torch::stack(tensors);
+    return pin_memory ? batch.pin_memory() : batch;
+  }
+
+  std::vector<int64_t> sizes = {static_cast<int64_t>(tensors.size())};
+  const auto example_sizes = tensors.front().sizes();
+  sizes.insert(sizes.end(), example_sizes.begin(), example_sizes.end());
+  auto batch = torch::empty(
+      sizes, tensors.front().options().pinned_memory(pin_memory));
+
+  const size_t bytes =
+      tensors.front().numel() * tensors.front().element_size();
+  char* destination = static_cast<char*>(batch.data_ptr());
+  // Small examples are copied in groups, so that the threads have enough
+  // work to be worth waking up.
+  constexpr size_t kMinBytesPerTask = 32768;
+  const int64_t grain_size =
+      std::max<size_t>(1, kMinBytesPerTask / std::max<size_t>(bytes, 1));
+  at::parallel_for(
+      /*begin=*/0,
+      /*end=*/tensors.size(),
+      grain_size,
+      [&tensors, destination, bytes](int64_t index, int64_t stop) {
+        for (; index < stop; ++index) {
+          const auto contiguous = tensors[index].contiguous();
+          std::memcpy(
+              destination + index * bytes, contiguous.data_ptr(), bytes);
+        }
+      });
+  return batch;
+}
+} // namespace detail
+
 template <typename T = Example<>>
 struct Stack;
 
 /// A `Collation` for `Example<Tensor, Tensor>` types that stacks all data
 /// tensors into one tensor, and all target (label) tensors into one tensor.
+///
+/// The batch tensors are allocated up front and the examples are copied into
+/// their slots in parallel. If `pin_memory` is set, the batch tensors are
+/// allocated in pinned memory, so that the `DataLoader` need not copy them
+/// again for its `pin_memory` option.
 template <>
 struct Stack<Example<>> : public Collation<Example<>> {
+  explicit Stack(bool pin_memory = false) : pin_memory(pin_memory) {}
+
   Example<> apply_batch(std::vector<Example<>> examples) override {
     std::vector<torch::Tensor> data, targets;
     data.reserve(examples.size());
@@ -26,23 +92,30 @@ struct Stack<Example<>> : public Collation<Example<>> {
       data.push_back(std::move(example.data));
       targets.push_back(std::move(example.target));
     }
-    return {torch::stack(data), torch::stack(targets)};
+    return {detail::stack_into_batch(data, pin_memory),
+            detail::stack_into_batch(targets, pin_memory)};
   }
+
+  bool pin_memory;
 };
 
 /// A `Collation` for `Example<Tensor, NoTarget>` types that stacks all data
-/// tensors into one tensor.
+/// tensors into one tensor, like `Stack<Example<>>`.
 template <>
 struct Stack<TensorExample>
     : public Collation<Example<Tensor, example::NoTarget>> {
+  explicit Stack(bool pin_memory = false) : pin_memory(pin_memory) {}
+
   TensorExample apply_batch(std::vector<TensorExample> examples) override {
     std::vector<torch::Tensor> data;
     data.reserve(examples.size());
     for (auto& example : examples) {
       data.push_back(std::move(example.data));
     }
-    return torch::stack(data);
+    return detail::stack_into_batch(data, pin_memory);
   }
+
+  bool pin_memory;
 };
 } // namespace transforms
 } // namespace data
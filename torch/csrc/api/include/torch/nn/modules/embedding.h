@@ -17,6 +17,9 @@ struct TORCH_API EmbeddingOptions {
   TORCH_ARG(int64_t, count);
   /// The size of each embedding vector (number of columns in the table).
   TORCH_ARG(int64_t, dimension);
+  /// Whether the gradient of the table is a sparse tensor, holding only the
+  /// rows that were looked up.
+  TORCH_ARG(bool, sparse) = false;
 };
 
 /// Performs a lookup in a fixed size embedding table.
@@ -4,8 +4,10 @@
 #include <torch/nn/module.h>
 #include <torch/nn/pimpl.h>
 #include <torch/types.h>
+#include <torch/utils.h>
 
 #include <torch/csrc/autograd/functions/comm.h>
+#include <torch/csrc/autograd/variable.h>
 #ifdef USE_CUDA
 #include <torch/csrc/cuda/comm.h>
 #endif
@@ -20,6 +22,7 @@
 #include <exception>
 #include <memory>
 #include <mutex>
+#include <utility>
 #include <vector>
 
 namespace torch {
@@ -173,6 +176,274 @@ Tensor data_parallel(
 #endif
 }
 
+/// Evaluates a module in parallel across devices like `data_parallel()`, but
+/// keeps the replicas of the module from one call to the next, instead of
+/// cloning the module on every call.
+///
+/// The module itself, moved to the first device, is the replica on that
+/// device. The replicas on the other devices keep their parameters and
+/// buffers in one flat tensor per bucket of at most `bucket_size` bytes, so
+/// every call to `forward()` only broadcasts the current parameters and
+/// buffers of the module into them, one bucket at a time and through NCCL if
+/// available, without allocating. Their gradients are kept in flat tensors in
+/// the same way. After backward, `reduce_gradients()` reduces them bucket by
+/// bucket and adds them to the gradients of the module:
+///
+///   parallel::DataParallel<Linear> parallel_model(model);
+///   for (auto& batch : *data_loader) {
+///     optimizer.zero_grad();
+///     parallel_model.forward(batch.data).sum().backward();
+///     parallel_model.reduce_gradients();
+///     optimizer.step();
+///   }
+template <typename ModuleType>
+class DataParallel {
+ public:
+  using ReplicaType = typename decltype(replicate(
+      std::declval<const ModuleType&>(),
+      std::declval<const std::vector<Device>&>()))::value_type;
+
+  explicit DataParallel(
+      ModuleType module,
+      optional<std::vector<Device>> devices = nullopt,
+      optional<Device> output_device = nullopt,
+      int64_t dim = 0,
+      size_t bucket_size = 10 * 1024 * 1024)
+      : module_(std::move(module)), dim_(dim) {
+    if (devices) {
+      devices_ = std::move(*devices);
+    } else {
+      const auto device_count = torch::cuda::device_count();
+      AT_CHECK(
+          device_count > 0,
+          "Expected at least one CUDA device to be available");
+      for (size_t index = 0; index < device_count; ++index) {
+        devices_.emplace_back(kCUDA, index);
+      }
+    }
+    AT_CHECK(!devices_.empty(), "Expected at least one device");
+    output_device_ = output_device.value_or(devices_.front());
+
+    module_->to(devices_.front());
+    if (devices_.size() == 1) {
+      return;
+    }
+#ifdef USE_CUDA
+    replicas_.push_back(module_);
+    const std::vector<Device> other_devices(devices_.begin() + 1, devices_.end());
+    for (auto& replica : replicate(module_, other_devices)) {
+      replicas_.push_back(std::move(replica));
+    }
+
+    const auto parameters = module_->parameters();
+    const auto buffers = module_->buffers();
+    parameter_buckets_ = make_buckets(parameters, bucket_size);
+    buffer_buckets_ = make_buckets(buffers, bucket_size);
+    gradient_buckets_ = make_buckets(parameters, bucket_size);
+
+    NoGradGuard no_grad;
+    for (size_t device = 1; device < devices_.size(); ++device) {
+      auto replica_parameters = replicas_[device]->parameters();
+      auto replica_buffers = replicas_[device]->buffers();
+      bind_to_buckets(replica_parameters, parameter_buckets_, device);
+      bind_to_buckets(replica_buffers, buffer_buckets_, device);
+    }
+    for (auto& bucket : gradient_buckets_) {
+      for (auto& flat : bucket.flats) {
+        flat.zero_();
+      }
+    }
+#else
+    AT_ERROR("DataParallel not supported without CUDA");
+#endif
+  }
+
+  /// Broadcasts the parameters and buffers of the module to the replicas, and
+  /// evaluates `module(input)` like `data_parallel()`.
+  Tensor forward(Tensor input) {
+    if (devices_.size() == 1) {
+      input = input.to(devices_.front());
+      return module_->forward(std::move(input)).to(output_device_);
+    }
+#ifdef USE_CUDA
+    {
+      NoGradGuard no_grad;
+      broadcast_buckets(module_->parameters(), parameter_buckets_);
+      broadcast_buckets(module_->buffers(), buffer_buckets_);
+    }
+
+    autograd::Scatter scatter(devices_, /*chunk_sizes=*/nullopt, dim_);
+    auto scattered_inputs = fmap<Tensor>(scatter.apply({std::move(input)}));
+    auto outputs = parallel_apply(replicas_, scattered_inputs, devices_);
+    return autograd::Gather(output_device_, dim_)
+        .apply(fmap<autograd::Variable>(std::move(outputs)))
+        .front();
+#else
+    AT_ERROR("DataParallel not supported without CUDA");
+    return Tensor();
+#endif
+  }
+
+  /// Adds the gradients of the replicas on the other devices to the gradients
+  /// of the module, and zeroes them. Call this after backward.
+  void reduce_gradients() {
+    if (devices_.size() == 1) {
+      return;
+    }
+#ifdef USE_CUDA
+    NoGradGuard no_grad;
+    std::vector<std::vector<Tensor>> replica_parameters(devices_.size());
+    for (size_t device = 1; device < devices_.size(); ++device) {
+      replica_parameters[device] = replicas_[device]->parameters();
+    }
+    auto parameters = module_->parameters();
+
+    for (auto& bucket : gradient_buckets_) {
+      // Backward accumulates into the existing gradients in place, except in
+      // double backward, which replaces them.
+      for (size_t device = 1; device < devices_.size(); ++device) {
+        for (size_t i = 0; i < bucket.indices.size(); ++i) {
+          auto& grad = replica_parameters[device][bucket.indices[i]].grad();
+          auto view = bucket.view(i, device);
+          if (!grad.defined() ||
+              autograd::as_variable_ref(grad).data().data_ptr() !=
+                  view.data_ptr()) {
+            if (grad.defined()) {
+              view.copy_(autograd::as_variable_ref(grad).data());
+            }
+            grad = autograd::make_variable(view);
+          }
+        }
+      }
+
+      bucket.flats.front().zero_();
+      torch::cuda::reduce_add_into(bucket.flats);
+
+      for (size_t i = 0; i < bucket.indices.size(); ++i) {
+        auto& grad = parameters[bucket.indices[i]].grad();
+        auto sum = bucket.view(i, 0);
+        if (grad.defined()) {
+          autograd::as_variable_ref(grad).data().add_(sum);
+        } else {
+          grad = autograd::make_variable(sum.clone());
+        }
+      }
+      for (size_t device = 1; device < devices_.size(); ++device) {
+        bucket.flats[device].zero_();
+      }
+    }
+#endif
+  }
+
+  /// The module, which is also the replica on the first device.
+  ModuleType& module() {
+    return module_;
+  }
+
+  /// The replicas of the module on each device, after the first one.
+  const std::vector<ReplicaType>& replicas() const {
+    return replicas_;
+  }
+
+ private:
+  // Consecutive tensors of the same type, packed into one flat tensor per
+  // device. The flat tensor on the first device is a staging buffer for the
+  // module's own tensors.
+  struct Bucket {
+    Tensor view(size_t i, size_t device) const {
+      return flats[device]
+          .narrow(0, offsets[i], numels[i])
+          .view(sizes[i]);
+    }
+
+    std::vector<Tensor> flats;
+    std::vector<size_t> indices;
+    std::vector<int64_t> offsets;
+    std::vector<int64_t> numels;
+    std::vector<std::vector<int64_t>> sizes;
+  };
+
+  std::vector<Bucket> make_buckets(
+      const std::vector<Tensor>& tensors,
+      size_t bucket_size) const {
+    std::vector<Bucket> buckets;
+    std::vector<int64_t> bucket_numels;
+    size_t bytes = 0;
+    for (size_t index = 0; index < tensors.size(); ++index) {
+      const auto& tensor = tensors[index];
+      const size_t tensor_bytes = tensor.numel() * tensor.element_size();
+      if (buckets.empty() ||
+          tensor.scalar_type() != buckets.back().flats.front().scalar_type() ||
+          (bytes > 0 && bytes + tensor_bytes > bucket_size)) {
+        if (!buckets.empty()) {
+          allocate_flats(buckets.back(), bucket_numels.back());
+        }
+        buckets.emplace_back();
+        // Only holds the type until the flat tensors are allocated.
+        buckets.back().flats.push_back(at::empty(
+            {0}, autograd::as_variable_ref(tensor).data().options()));
+        bucket_numels.push_back(0);
+        bytes = 0;
+      }
+      auto& bucket = buckets.back();
+      bucket.indices.push_back(index);
+      bucket.offsets.push_back(bucket_numels.back());
+      bucket.numels.push_back(tensor.numel());
+      bucket.sizes.push_back(tensor.sizes().vec());
+      bucket_numels.back() += tensor.numel();
+      bytes += tensor_bytes;
+    }
+    if (!buckets.empty()) {
+      allocate_flats(buckets.back(), bucket_numels.back());
+    }
+    return buckets;
+  }
+
+  void allocate_flats(Bucket& bucket, int64_t numel) const {
+    const auto options = bucket.flats.front().options();
+    bucket.flats.clear();
+    for (const auto& device : devices_) {
+      bucket.flats.push_back(at::empty({numel}, options.device(device)));
+    }
+  }
+
+  // Makes the tensors of a replica views of the flat tensors on its device.
+  static void bind_to_buckets(
+      std::vector<Tensor>& tensors,
+      const std::vector<Bucket>& buckets,
+      size_t device) {
+    for (const auto& bucket : buckets) {
+      for (size_t i = 0; i < bucket.indices.size(); ++i) {
+        autograd::as_variable_ref(tensors[bucket.indices[i]])
+            .set_data(bucket.view(i, device));
+      }
+    }
+  }
+
+  void broadcast_buckets(
+      const std::vector<Tensor>& tensors,
+      std::vector<Bucket>& buckets) const {
+#ifdef USE_CUDA
+    for (auto& bucket : buckets) {
+      for (size_t i = 0; i < bucket.indices.size(); ++i) {
+        bucket.view(i, 0).copy_(
+            autograd::as_variable_ref(tensors[bucket.indices[i]]).data());
+      }
+      torch::cuda::broadcast_into(bucket.flats);
+    }
+#endif
+  }
+
+  ModuleType module_;
+  std::vector<Device> devices_;
+  Device output_device_{kCPU};
+  int64_t dim_;
+  std::vector<ReplicaType> replicas_;
+  std::vector<Bucket> parameter_buckets_;
+  std::vector<Bucket> buffer_buckets_;
+  std::vector<Bucket> gradient_buckets_;
+};
+
 } // namespace parallel
 } // namespace nn
 } // namespace torch
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <torch/nn/module.h>
+#include <torch/nn/pimpl.h>
+#include <torch/types.h>
+
+#include <torch/csrc/autograd/variable.h>
+
+#include <ATen/Parallel.h>
+#include <c10/util/Exception.h>
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace torch {
+namespace nn {
+namespace parallel {
+
+/// Returns `count` replicas of the module for lock-free ("Hogwild")
+/// training with threads. Every replica is a `clone()` of the module with
+/// its own gradients, so that threads can run their own forward and
+/// backward passes, but its parameters and buffers share the storage of
+/// those of `module`: an optimizer stepping the parameters of a replica
+/// updates the parameters of all of them, without any synchronization.
+template <typename ModuleType>
+std::vector<std::shared_ptr<ModuleType>> share_parameters(
+    const std::shared_ptr<ModuleType>& module,
+    size_t count) {
+  const auto parameters = module->named_parameters();
+  const auto buffers = module->named_buffers();
+  std::vector<std::shared_ptr<ModuleType>> replicas;
+  replicas.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    auto replica = std::dynamic_pointer_cast<ModuleType>(module->clone());
+    for (auto& parameter : replica->named_parameters()) {
+      parameter->set_data(
+          autograd::as_variable_ref(parameters[parameter.key()]).data());
+    }
+    for (auto& buffer : replica->named_buffers()) {
+      buffer->set_data(autograd::as_variable_ref(buffers[buffer.key()]).data());
+    }
+    replicas.push_back(std::move(replica));
+  }
+  return replicas;
+}
+
+/// Shares the parameters of a module holder, such as `Linear`.
+template <typename ModuleType>
+std::vector<ModuleHolder<ModuleType>> share_parameters(
+    const ModuleHolder<ModuleType>& module,
+    size_t count) {
+  auto ptrs = share_parameters(module.ptr(), count);
+  return std::vector<ModuleHolder<ModuleType>>(ptrs.begin(), ptrs.end());
+}
+
+/// Trains a module with `num_workers` threads sharing its parameters
+/// (Hogwild). Calls `worker(index, replica)` on a thread for every replica
+/// of `share_parameters(module, num_workers)`, and returns once all of them
+/// returned. Workers typically own an optimizer of the parameters of their
+/// replica, and a shard of the data:
+///
+///   parallel::hogwild(model, 8, [&](size_t index, std::shared_ptr<Net> net) {
+///     optim::SGD optimizer(
+///         net->parameters(),
+///         optim::SGDOptions(0.01).atomic_sparse_updates(true));
+///     for (auto& batch : *loaders[index]) {
+///       optimizer.zero_grad();
+///       torch::nll_loss(net->forward(batch.data), batch.target).backward();
+///       optimizer.step();
+///     }
+///   });
+///
+/// The updates of dense parameters race: concurrent updates of an element
+/// may be lost, which Hogwild training tolerates. Sparse gradients, as
+/// produced by `Embedding` with `sparse(true)`, touch few rows, so their
+/// updates can be made atomic instead (see
+/// `SGDOptions::atomic_sparse_updates`). Every worker already keeps a core
+/// busy, so the intra-op parallelism of the operators should be limited to 1
+/// thread (see `at::set_num_threads`).
+///
+/// The first exception thrown by any worker is rethrown once all the workers
+/// have returned.
+template <typename ModuleType, typename Worker>
+void hogwild(
+    const std::shared_ptr<ModuleType>& module,
+    size_t num_workers,
+    Worker&& worker) {
+  AT_CHECK(num_workers > 0, "Expected at least one worker");
+  auto replicas = share_parameters(module, num_workers);
+
+  std::exception_ptr exception;
+  std::mutex mutex;
+  std::vector<std::thread> threads;
+  threads.reserve(num_workers);
+  for (size_t index = 0; index < num_workers; ++index) {
+    threads.emplace_back([&, index] {
+      try {
+        at::init_num_threads();
+        worker(index, replicas[index]);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!exception) {
+          exception = std::current_exception();
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
+/// Trains a module holder, such as `Linear`, with Hogwild.
+template <typename ModuleType, typename Worker>
+void hogwild(
+    const ModuleHolder<ModuleType>& module,
+    size_t num_workers,
+    Worker&& worker) {
+  hogwild(
+      module.ptr(),
+      num_workers,
+      [&](size_t index, std::shared_ptr<ModuleType> replica) {
+        worker(index, ModuleHolder<ModuleType>(std::move(replica)));
+      });
+}
+
+} // namespace parallel
+} // namespace nn
+} // namespace torch
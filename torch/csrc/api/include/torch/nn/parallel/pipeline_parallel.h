@@ -0,0 +1,327 @@
+#pragma once
+
+#include <torch/nn/modules/any.h>
+#include <torch/nn/modules/sequential.h>
+#include <torch/types.h>
+#include <torch/utils.h>
+
+#ifdef USE_CUDA
+#include <ATen/cuda/CUDAEvent.h>
+#include <c10/cuda/CUDACachingAllocator.h>
+#include <c10/cuda/CUDAGuard.h>
+#include <c10/cuda/CUDAStream.h>
+#endif
+#include <ATen/Device.h>
+#include <c10/util/Exception.h>
+#include <c10/util/Optional.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace torch {
+namespace nn {
+namespace parallel {
+
+/// The order in which `Pipeline::train_step()` runs the forward and backward
+/// passes of the micro-batches on every stage.
+enum class PipelineSchedule {
+  /// All the forward passes, then all the backward passes (GPipe). Every stage
+  /// keeps the activations of all the micro-batches until backward.
+  GPipe,
+  /// Once the pipeline is full, every stage alternates one forward and one
+  /// backward pass (1F1B). A stage keeps the activations of at most as many
+  /// micro-batches as there are stages from it to the last one.
+  OneForwardOneBackward,
+};
+
+/// Evaluates a `Sequential` whose layers are partitioned across devices, one
+/// stage of consecutive layers per device, pipelining micro-batches through
+/// the stages so that the devices work on different micro-batches at the same
+/// time.
+///
+/// Batches are split into `chunks` micro-batches along the first dimension.
+/// `balance` is the number of layers of every stage; by default the layers are
+/// split evenly. The activations (and their gradients) are copied between CUDA
+/// devices on a dedicated stream per device, so that the copies overlap with
+/// the computation of the other micro-batches:
+///
+///   parallel::Pipeline pipeline(
+///       model, {Device(kCUDA, 0), Device(kCUDA, 1)}, /*chunks=*/8);
+///   for (auto& batch : *data_loader) {
+///     optimizer.zero_grad();
+///     pipeline.train_step(batch.data, batch.target, [](Tensor x, Tensor y) {
+///       return torch::mse_loss(x, y);
+///     });
+///     optimizer.step();
+///   }
+///
+/// The layers are shared with `sequential`, and moved to their devices.
+class Pipeline {
+ public:
+  using LossFunction = std::function<Tensor(Tensor, Tensor)>;
+
+  Pipeline(
+      Sequential sequential,
+      std::vector<Device> devices,
+      size_t chunks,
+      std::vector<size_t> balance = {},
+      PipelineSchedule schedule = PipelineSchedule::GPipe)
+      : devices_(std::move(devices)), chunks_(chunks), schedule_(schedule) {
+    AT_CHECK(!devices_.empty(), "Expected at least one device");
+    AT_CHECK(chunks_ > 0, "Expected at least one micro-batch");
+    const auto layer_count = sequential->size();
+    if (balance.empty()) {
+      AT_CHECK(
+          layer_count >= devices_.size(),
+          "Expected at least as many layers as devices, but got ",
+          layer_count,
+          " layers and ",
+          devices_.size(),
+          " devices");
+      for (size_t stage = 0; stage < devices_.size(); ++stage) {
+        balance.push_back(
+            layer_count / devices_.size() +
+            (stage < layer_count % devices_.size() ? 1 : 0));
+      }
+    }
+    AT_CHECK(
+        balance.size() == devices_.size(),
+        "Expected a balance entry for every device");
+    size_t balance_sum = 0;
+    for (const auto layers : balance) {
+      AT_CHECK(layers > 0, "Expected at least one layer per stage");
+      balance_sum += layers;
+    }
+    AT_CHECK(
+        balance_sum == layer_count,
+        "The balance sums to ",
+        balance_sum,
+        " layers, but the Sequential has ",
+        layer_count);
+
+    auto layer = sequential->begin();
+    for (size_t stage = 0; stage < devices_.size(); ++stage) {
+      Sequential partition;
+      for (size_t i = 0; i < balance[stage]; ++i, ++layer) {
+        partition->push_back(*layer);
+      }
+      partition->to(devices_[stage]);
+      stages_.push_back(std::move(partition));
+#ifdef USE_CUDA
+      if (devices_[stage].is_cuda()) {
+        copy_streams_.push_back(
+            c10::cuda::getStreamFromPool(false, devices_[stage].index()));
+      } else {
+        copy_streams_.push_back(nullopt);
+      }
+#endif
+    }
+  }
+
+  /// Evaluates the `Sequential` on `input`, pipelining its micro-batches, and
+  /// returns the output on the last device. The output can be backpropagated
+  /// through, in which case the autograd engine schedules the backward
+  /// passes; `train_step()` schedules them to bound the memory used instead.
+  Tensor forward(Tensor input) {
+    auto micro_batches = input.chunk(chunks_);
+    // At clock tick `clock`, stage `s` works on micro-batch `clock - s`.
+    const auto clocks = micro_batches.size() + stages_.size() - 1;
+    for (size_t clock = 0; clock < clocks; ++clock) {
+      for (size_t stage = 0; stage < stages_.size(); ++stage) {
+        if (clock < stage || clock - stage >= micro_batches.size()) {
+          continue;
+        }
+        auto& x = micro_batches[clock - stage];
+        x = stages_[stage]->forward(copy_to(x, stage));
+      }
+    }
+    return torch::cat(micro_batches);
+  }
+
+  /// Runs the forward and backward passes of a batch, pipelining its
+  /// micro-batches in the order of the schedule, and returns the loss. The
+  /// loss of every micro-batch is divided by their number, so that the
+  /// gradients accumulated into the parameters are the ones of the batch with
+  /// a loss function averaging over it.
+  Tensor train_step(Tensor input, Tensor target, const LossFunction& loss) {
+    const auto inputs = input.chunk(chunks_);
+    const auto targets = target.to(devices_.back()).chunk(chunks_);
+    AT_CHECK(
+        inputs.size() == targets.size(),
+        "Expected the input and the target to have the same batch size");
+    const auto micro_batch_count = inputs.size();
+    const auto stage_count = stages_.size();
+
+    // The input (a leaf, except on the first stage) and the output (the loss,
+    // on the last stage) of every stage and micro-batch, kept until backward.
+    std::vector<std::vector<Tensor>> stage_inputs(
+        stage_count, std::vector<Tensor>(micro_batch_count));
+    std::vector<std::vector<Tensor>> stage_outputs(
+        stage_count, std::vector<Tensor>(micro_batch_count));
+    std::vector<std::vector<bool>> forward_done(
+        stage_count, std::vector<bool>(micro_batch_count, false));
+    std::vector<std::vector<bool>> backward_done(
+        stage_count, std::vector<bool>(micro_batch_count, false));
+    Tensor total_loss;
+
+    auto run = [&](const Step& step, size_t stage) {
+      const auto m = step.micro_batch;
+      if (step.forward) {
+        auto x = stage == 0
+            ? copy_to(inputs[m], stage)
+            : copy_to(stage_outputs[stage - 1][m].detach(), stage)
+                  .set_requires_grad(true);
+        auto y = stages_[stage]->forward(x);
+        if (stage == stage_count - 1) {
+          y = loss(y, targets[m]) / static_cast<double>(micro_batch_count);
+          total_loss =
+              total_loss.defined() ? total_loss + y.detach() : y.detach();
+        }
+        stage_inputs[stage][m] = std::move(x);
+        stage_outputs[stage][m] = std::move(y);
+        forward_done[stage][m] = true;
+      } else {
+        if (stage == stage_count - 1) {
+          stage_outputs[stage][m].backward();
+        } else {
+          auto& next_input = stage_inputs[stage + 1][m];
+          stage_outputs[stage][m].backward(copy_to(next_input.grad(), stage));
+          next_input = Tensor();
+        }
+        stage_outputs[stage][m] = Tensor();
+        if (stage == 0) {
+          stage_inputs[stage][m] = Tensor();
+        }
+        backward_done[stage][m] = true;
+      }
+    };
+
+    // Issues the next step of every stage whose dependencies are done, until
+    // all the steps are. The devices run asynchronously, so the order in
+    // which this thread issues the steps is what lets them overlap.
+    const auto steps = make_steps(micro_batch_count);
+    std::vector<size_t> next_step(stage_count, 0);
+    size_t remaining = stage_count * 2 * micro_batch_count;
+    while (remaining > 0) {
+      bool progressed = false;
+      for (size_t stage = 0; stage < stage_count; ++stage) {
+        if (next_step[stage] == steps[stage].size()) {
+          continue;
+        }
+        const auto& step = steps[stage][next_step[stage]];
+        const auto m = step.micro_batch;
+        const bool ready = step.forward
+            ? stage == 0 || forward_done[stage - 1][m]
+            : (stage == stage_count - 1 ? forward_done[stage][m]
+                                        : backward_done[stage + 1][m]);
+        if (ready) {
+          run(step, stage);
+          ++next_step[stage];
+          --remaining;
+          progressed = true;
+        }
+      }
+      AT_ASSERTM(progressed, "Pipeline schedule deadlocked");
+    }
+    return total_loss;
+  }
+
+  /// The stages of the pipeline, one per device.
+  const std::vector<Sequential>& stages() const {
+    return stages_;
+  }
+
+  const std::vector<Device>& devices() const {
+    return devices_;
+  }
+
+ private:
+  struct Step {
+    bool forward;
+    size_t micro_batch;
+  };
+
+  // The steps of every stage, in the order of the schedule.
+  std::vector<std::vector<Step>> make_steps(size_t micro_batch_count) const {
+    std::vector<std::vector<Step>> steps(stages_.size());
+    for (size_t stage = 0; stage < stages_.size(); ++stage) {
+      auto& stage_steps = steps[stage];
+      if (schedule_ == PipelineSchedule::GPipe) {
+        for (size_t m = 0; m < micro_batch_count; ++m) {
+          stage_steps.push_back({true, m});
+        }
+        for (size_t m = 0; m < micro_batch_count; ++m) {
+          stage_steps.push_back({false, m});
+        }
+        continue;
+      }
+      // Forward passes fill the pipeline up to this stage, then every
+      // forward pass is followed by the backward pass of the oldest
+      // micro-batch, and the last backward passes drain it.
+      const auto warmup =
+          std::min(stages_.size() - stage - 1, micro_batch_count);
+      for (size_t m = 0; m < warmup; ++m) {
+        stage_steps.push_back({true, m});
+      }
+      for (size_t m = warmup; m < micro_batch_count; ++m) {
+        stage_steps.push_back({true, m});
+        stage_steps.push_back({false, m - warmup});
+      }
+      for (size_t m = micro_batch_count - warmup; m < micro_batch_count; ++m) {
+        stage_steps.push_back({false, m});
+      }
+    }
+    return steps;
+  }
+
+  // Copies a tensor to the device of a stage. Copies between CUDA devices run
+  // on the copy stream of the destination device, after the work queued on
+  // the source tensor, and before the work queued on the copy afterwards.
+  Tensor copy_to(const Tensor& tensor, size_t stage) const {
+    const auto& device = devices_[stage];
+    if (tensor.device() == device) {
+      return tensor;
+    }
+#ifdef USE_CUDA
+    if (tensor.is_cuda() && device.is_cuda()) {
+      const auto& copy_stream = *copy_streams_[stage];
+      at::cuda::CUDAEvent source_ready;
+      source_ready.record(
+          c10::cuda::getCurrentCUDAStream(tensor.device().index()));
+      source_ready.block(copy_stream);
+      Tensor copy;
+      {
+        c10::cuda::CUDAStreamGuard guard(copy_stream);
+        copy = tensor.to(device, /*non_blocking=*/true);
+      }
+      // Neither tensor can be freed before the streams using them are done.
+      c10::cuda::CUDACachingAllocator::recordStream(
+          tensor.storage().data(), copy_stream);
+      const auto compute_stream =
+          c10::cuda::getCurrentCUDAStream(device.index());
+      at::cuda::CUDAEvent copy_done;
+      copy_done.record(copy_stream);
+      copy_done.block(compute_stream);
+      c10::cuda::CUDACachingAllocator::recordStream(
+          copy.storage().data(), compute_stream);
+      return copy;
+    }
+#endif
+    return tensor.to(device);
+  }
+
+  std::vector<Device> devices_;
+  size_t chunks_;
+  PipelineSchedule schedule_;
+  std::vector<Sequential> stages_;
+#ifdef USE_CUDA
+  std::vector<optional<c10::cuda::CUDAStream>> copy_streams_;
+#endif
+};
+
+} // namespace parallel
+} // namespace nn
+} // namespace torch
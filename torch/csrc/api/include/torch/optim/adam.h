@@ -50,6 +50,10 @@ class TORCH_API Adam : public Optimizer {
  private:
   Adam() : options(0) {}
 
+  /// Steps all the parameters with `at::native::fused_adam_step` when they
+  /// allow it, and returns whether it did.
+  bool fused_step();
+
   template <typename Self, typename Archive>
   static void serialize(Self& self, Archive& archive) {
     _TORCH_OPTIM_SERIALIZE(step_buffers);
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <torch/arg.h>
+#include <torch/optim/optimizer.h>
+#include <torch/types.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace torch {
+namespace serialize {
+class OutputArchive;
+class InputArchive;
+} // namespace serialize
+} // namespace torch
+
+namespace torch {
+namespace optim {
+
+struct TORCH_API LossScalerOptions {
+  /// The scale of the first steps.
+  TORCH_ARG(double, init_scale) = 65536;
+  /// The factor the scale grows by after `growth_interval` steps without an
+  /// overflow.
+  TORCH_ARG(double, growth_factor) = 2;
+  /// The factor the scale is multiplied by after an overflow.
+  TORCH_ARG(double, backoff_factor) = 0.5;
+  TORCH_ARG(int64_t, growth_interval) = 2000;
+};
+
+/// Scales the loss of a mixed precision training step, so that the small
+/// gradients don't flush to zero in half precision, and unscales the
+/// gradients before the optimizer steps. The scale is adjusted dynamically:
+/// the steps whose gradients overflow are skipped and shrink the scale, and
+/// the scale grows back after `growth_interval` steps without overflow.
+///
+///   torch::optim::LossScaler scaler;
+///   for (auto& batch : *data_loader) {
+///     optimizer.zero_grad();
+///     torch::Tensor loss;
+///     {
+///       torch::AutocastGuard autocast;
+///       loss = torch::mse_loss(model->forward(batch.data), batch.target);
+///     }
+///     scaler.scale(loss).backward();
+///     scaler.step(optimizer);
+///   }
+class TORCH_API LossScaler {
+ public:
+  explicit LossScaler(const LossScalerOptions& options = {});
+
+  /// Returns the loss multiplied by the current scale.
+  Tensor scale(const Tensor& loss) const;
+
+  /// Unscales the gradients of the parameters of `optimizer` and steps it if
+  /// they are all finite, then updates the scale. Returns whether the
+  /// optimizer stepped.
+  bool step(Optimizer& optimizer);
+
+  /// The current scale.
+  double current_scale() const noexcept {
+    return scale_;
+  }
+
+  void save(serialize::OutputArchive& archive) const;
+  void load(serialize::InputArchive& archive);
+
+  LossScalerOptions options;
+
+ private:
+  double scale_;
+
+  /// The number of steps since the scale last changed.
+  int64_t steps_since_update_{0};
+};
+} // namespace optim
+} // namespace torch
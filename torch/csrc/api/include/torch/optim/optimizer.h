@@ -79,6 +79,14 @@ class TORCH_API OptimizerBase {
   /// Additionally, zeros out the buffers when this is called on the index
   Tensor& buffer_at(std::vector<Tensor>& buffers, size_t index);
 
+  /// Returns the indices of the parameters that have a gradient, if these
+  /// parameters, their gradients and their entries in each of the given
+  /// `buffers` can all be updated by one fused step (see
+  /// `ATen/native/FusedOptimizers.h`), and an empty vector otherwise.
+  /// Creates the missing buffer entries like `buffer_at`.
+  std::vector<size_t> fused_step_parameters(
+      const std::vector<std::vector<Tensor>*>& buffers);
+
   /// The parameters this optimizer optimizes.
   std::vector<Tensor> parameters_;
 };
@@ -54,6 +54,10 @@ class TORCH_API RMSprop : public Optimizer {
  private:
   RMSprop() : options(0) {}
 
+  /// Steps all the parameters with `at::native::fused_rmsprop_step` when they
+  /// allow it, and returns whether it did.
+  bool fused_step();
+
   template <typename Self, typename Archive>
   static void serialize(Self& self, Archive& archive) {
     _TORCH_OPTIM_SERIALIZE(square_average_buffers);
@@ -26,6 +26,11 @@ struct TORCH_API SGDOptions {
   TORCH_ARG(double, dampening) = 0;
   TORCH_ARG(double, weight_decay) = 0;
   TORCH_ARG(bool, nesterov) = false;
+  /// Applies the sparse gradients of dense CPU parameters with atomic adds,
+  /// so that no update is lost when other threads step the same parameters
+  /// concurrently (see `nn::parallel::hogwild`). Only used without momentum
+  /// and weight decay, which would make the updates dense.
+  TORCH_ARG(bool, atomic_sparse_updates) = false;
 };
 
 class TORCH_API SGD : public Optimizer {
@@ -47,6 +52,10 @@ class TORCH_API SGD : public Optimizer {
  private:
   SGD() : options(0) {}
 
+  /// Steps all the parameters with `at::native::fused_sgd_step` when they
+  /// allow it, and returns whether it did.
+  bool fused_step();
+
   /// Counts how often `step()` is called, for dampening.
   size_t iteration_{0};
 };
@@ -3,6 +3,8 @@
 #include <torch/serialize/archive.h>
 #include <torch/serialize/tensor.h>
 
+#include <cstddef>
+#include <string>
 #include <utility>
 
 namespace torch {
@@ -70,6 +72,31 @@ void save(const std::vector<torch::Tensor>& tensor_vec, SaveToArgs&&... args) {
   archive.save_to(std::forward<SaveToArgs>(args)...);
 }
 
+/// Serializes the given `value` into `num_shards` files on background
+/// threads, and returns once the tensors of `value` have been copied (see
+/// `serialize::OutputArchive::save_to_async`). The returned
+/// `serialize::AsyncSave` can be used to wait for the files to be written.
+///
+/// \rst
+/// .. code-block:: cpp
+///
+///   torch::nn::Linear model(3, 4);
+///   auto checkpoint = torch::save_async(model, "model.pt", /*num_shards=*/4);
+///   // ... keep training `model` ...
+///   checkpoint.wait();
+///
+///   torch::load(model, "model.pt", /*num_shards=*/4);
+/// \endrst
+template <typename Value>
+serialize::AsyncSave save_async(
+    const Value& value,
+    const std::string& filename,
+    size_t num_shards = 1) {
+  serialize::OutputArchive archive;
+  archive << value;
+  return archive.save_to_async(filename, num_shards);
+}
+
 /// Deserializes the given `value`.
 /// There must be an overload of `operator>>` between `serialize::InputArchive`
 /// and `Value` for this method to be well-formed. Currently, such an overload
@@ -71,6 +71,14 @@ class TORCH_API InputArchive final {
   void load_from(const std::string& filename,
       c10::optional<torch::Device> device = c10::nullopt);
 
+  /// Loads the `InputArchive` from the `num_shards` files written by
+  /// `OutputArchive::save_to_async(filename, num_shards)`. Storage are
+  /// remapped using device option. If device is not specified, the module is
+  /// loaded to the original device.
+  void load_from(const std::string& filename,
+      size_t num_shards,
+      c10::optional<torch::Device> device = c10::nullopt);
+
   /// Loads the `InputArchive` from a serialized representation stored in the
   /// given `stream`. Storage are remapped using device option. If device
   /// is not specified, the module is loaded to the original device.
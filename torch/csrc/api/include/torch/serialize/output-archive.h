@@ -2,10 +2,13 @@
 
 #include <torch/csrc/WindowsTorchApiMacro.h>
 
+#include <cstddef>
+#include <future>
 #include <iosfwd>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace at {
 class Tensor;
@@ -22,6 +25,39 @@ struct Module;
 
 namespace torch {
 namespace serialize {
+/// Returns the name of the file that shard `shard` of `num_shards` is written
+/// to by `OutputArchive::save_to_async`, which is `filename` itself if there
+/// is a single shard, and `filename.<shard>` otherwise.
+TORCH_API std::string shard_filename(
+    const std::string& filename,
+    size_t shard,
+    size_t num_shards);
+
+/// A checkpoint that is being written in the background. Returned by
+/// `OutputArchive::save_to_async`. Destroying an `AsyncSave` waits for the
+/// writes to finish.
+class TORCH_API AsyncSave final {
+ public:
+  AsyncSave() = default;
+  explicit AsyncSave(std::vector<std::future<void>> shards);
+
+  // Move is allowed.
+  AsyncSave(AsyncSave&&) = default;
+  AsyncSave& operator=(AsyncSave&&) = default;
+
+  ~AsyncSave();
+
+  /// Returns true if all shards have been written (or failed to be).
+  bool done() const;
+
+  /// Blocks until all shards have been written, and rethrows the first error
+  /// that occurred while writing them, if any.
+  void wait();
+
+ private:
+  std::vector<std::future<void>> shards_;
+};
+
 class TORCH_API OutputArchive final {
  public:
   /// Default-constructs the `OutputArchive`.
@@ -54,6 +90,20 @@ class TORCH_API OutputArchive final {
   /// `stream`.
   void save_to(std::ostream& stream);
 
+  /// Saves the `OutputArchive` into `num_shards` files (see `shard_filename`),
+  /// which are written in parallel on background threads.
+  ///
+  /// The tensors are copied before this function returns, so they may be
+  /// modified right away: CPU tensors are cloned, and CUDA tensors are copied
+  /// into pinned host memory without blocking the calling thread. The copies
+  /// are ordered on the current CUDA streams, and the writers wait for them
+  /// before serializing. Tensors are assigned to shards so that the shards
+  /// have roughly the same size; every shard keeps the nesting of the archive.
+  ///
+  /// The archive can be restored with `InputArchive::load_from(filename,
+  /// num_shards)`.
+  AsyncSave save_to_async(const std::string& filename, size_t num_shards = 1);
+
   /// Forwards all arguments to `write()`.
   /// Useful for generic code that can be re-used for both `OutputArchive` and
   /// `InputArchive` (where `operator()` forwards to `read()`).
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <torch/csrc/autograd/autocast_mode.h>
+#include <torch/csrc/autograd/functions/checkpoint.h>
 #include <torch/csrc/autograd/grad_mode.h>
 
 #include <cstdint>
@@ -13,6 +15,25 @@ struct TORCH_API NoGradGuard : public AutoGradMode {
   NoGradGuard() : AutoGradMode(/*enabled=*/false) {}
 };
 
+// A RAII, thread local (!) guard for inference only code. Ops skip autograd
+// entirely and tensors created by torch:: factory functions are plain tensors
+// without autograd metadata. Tensors given to ops inside the guard must be
+// plain tensors too; see `autograd::AutoInferenceMode`.
+struct TORCH_API InferenceModeGuard : public autograd::AutoInferenceMode {};
+
+// A RAII, thread local (!) guard that runs the matrix products and
+// convolutions in half precision on CUDA, and the ops that need the range of
+// single precision in float; see `autograd::AutocastMode`. It should span the
+// forward pass and the loss of a training step, not the backward pass, and
+// would usually be used with an `optim::LossScaler`.
+struct TORCH_API AutocastGuard : public autograd::AutoAutocastMode {
+  AutocastGuard() : AutoAutocastMode(/*enabled=*/true) {}
+};
+
+/// Runs a function without keeping its intermediate results for backward,
+/// which recomputes them instead; see `autograd::checkpoint`.
+using autograd::checkpoint;
+
 /// Sets the global random seed for all newly created CPU and CUDA tensors.
 using at::manual_seed;
 } // namespace torch
@@ -0,0 +1,450 @@
+#include <torch/data/datasets/mapped.h>
+
+#include <torch/data/example.h>
+#include <torch/types.h>
+
+#include <c10/util/Exception.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace torch {
+namespace data {
+namespace datasets {
+namespace {
+// The file starts with a header:
+//
+//   char     magic[8]
+//   uint32_t version
+//   uint32_t column_count
+//   uint64_t example_count
+//
+// followed by one entry per column:
+//
+//   uint32_t name_length
+//   char     name[name_length]
+//   int32_t  dtype
+//   uint8_t  ragged
+//   uint32_t dim
+//   int64_t  shape[dim]
+//   uint64_t data_offset
+//   uint64_t index_offset
+//
+// All integers are little-endian. The contents of each column are stored at
+// `data_offset`, example after example. Ragged columns also store
+// `example_count + 1` uint64_t row offsets at `index_offset`. Both offsets
+// are multiples of `kAlignment`, so the tensors are suitably aligned for
+// their dtype.
+constexpr char kMagic[8] = {'T', 'O', 'R', 'C', 'H', 'M', 'A', 'P'};
+constexpr uint32_t kVersion = 1;
+constexpr uint64_t kAlignment = 64;
+
+bool check_is_little_endian() {
+  const uint32_t word = 1;
+  return reinterpret_cast<const uint8_t*>(&word)[0] == 1;
+}
+
+uint64_t align(uint64_t offset) {
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+size_t row_bytes(ScalarType dtype, const std::vector<int64_t>& shape) {
+  size_t bytes = elementSize(dtype);
+  for (const auto size : shape) {
+    bytes *= size;
+  }
+  return bytes;
+}
+
+template <typename T>
+void append(std::string& buffer, T value) {
+  buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/// Reads the header of the file, checking that it lies within the mapping.
+class HeaderReader {
+ public:
+  HeaderReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+  template <typename T>
+  T read() {
+    T value;
+    std::memcpy(&value, take(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  std::string read_string(size_t length) {
+    return std::string(take(length), length);
+  }
+
+ private:
+  const char* take(size_t bytes) {
+    AT_CHECK(
+        bytes <= size_ - position_,
+        "Corrupt mapped dataset file: the header is truncated");
+    const char* data = data_ + position_;
+    position_ += bytes;
+    return data;
+  }
+
+  const char* data_;
+  size_t size_;
+  size_t position_ = 0;
+};
+
+struct ColumnLayout {
+  std::string name;
+  ScalarType dtype;
+  std::vector<int64_t> shape;
+  bool ragged = false;
+  /// The row offsets of every example, for ragged columns.
+  std::vector<uint64_t> row_offsets;
+  uint64_t data_bytes = 0;
+  uint64_t data_offset = 0;
+  uint64_t index_offset = 0;
+};
+
+std::string encode_header(
+    const std::vector<ColumnLayout>& layouts,
+    uint64_t example_count) {
+  std::string header(kMagic, sizeof(kMagic));
+  append<uint32_t>(header, kVersion);
+  append<uint32_t>(header, layouts.size());
+  append<uint64_t>(header, example_count);
+  for (const auto& layout : layouts) {
+    append<uint32_t>(header, layout.name.size());
+    header += layout.name;
+    append<int32_t>(header, static_cast<int32_t>(layout.dtype));
+    append<uint8_t>(header, layout.ragged);
+    append<uint32_t>(header, layout.shape.size());
+    for (const auto size : layout.shape) {
+      append<int64_t>(header, size);
+    }
+    append<uint64_t>(header, layout.data_offset);
+    append<uint64_t>(header, layout.index_offset);
+  }
+  return header;
+}
+
+void pad_to(std::ofstream& stream, uint64_t offset) {
+  const auto position = static_cast<uint64_t>(stream.tellp());
+  AT_ASSERT(position <= offset);
+  const std::string padding(offset - position, '\0');
+  stream.write(padding.data(), padding.size());
+}
+} // namespace
+
+MappedDataset::MappedDataset(
+    const std::string& path,
+    const std::string& data_column,
+    const std::string& target_column) {
+#ifdef _WIN32
+  AT_ERROR("MappedDataset is not supported on Windows");
+#else
+  static const bool is_little_endian = check_is_little_endian();
+  AT_CHECK(is_little_endian, "MappedDataset requires a little-endian host");
+
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  AT_CHECK(
+      fd >= 0, "Error opening mapped dataset file at ", path, ": ",
+      std::strerror(errno));
+  struct stat status;
+  if (::fstat(fd, &status) != 0) {
+    const int error = errno;
+    ::close(fd);
+    AT_ERROR("Error reading mapped dataset file at ", path, ": ",
+             std::strerror(error));
+  }
+  bytes_ = status.st_size;
+  AT_CHECK(bytes_ > 0, "Mapped dataset file at ", path, " is empty");
+  // A private mapping gives copy-on-write pages, so the views handed out by
+  // `get()` may be written to without touching the file.
+  void* data =
+      ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  const int error = errno;
+  ::close(fd);
+  AT_CHECK(
+      data != MAP_FAILED, "Error mapping dataset file at ", path, ": ",
+      std::strerror(error));
+  const size_t bytes = bytes_;
+  mapping_ = std::shared_ptr<void>(
+      data, [bytes](void* pointer) { ::munmap(pointer, bytes); });
+  base_ = static_cast<const char*>(data);
+
+  HeaderReader reader(base_, bytes_);
+  AT_CHECK(
+      reader.read_string(sizeof(kMagic)) == std::string(kMagic, sizeof(kMagic)),
+      path, " is not a mapped dataset file");
+  const auto version = reader.read<uint32_t>();
+  AT_CHECK(
+      version == kVersion, "Unsupported mapped dataset file version ", version,
+      " (expected ", kVersion, ")");
+  const auto column_count = reader.read<uint32_t>();
+  size_ = reader.read<uint64_t>();
+
+  columns_.reserve(column_count);
+  for (uint32_t i = 0; i < column_count; ++i) {
+    Column column;
+    column.name = reader.read_string(reader.read<uint32_t>());
+    const auto dtype = reader.read<int32_t>();
+    AT_CHECK(
+        dtype >= 0 && dtype < static_cast<int32_t>(ScalarType::Undefined),
+        "Corrupt mapped dataset file: column '", column.name,
+        "' has an invalid dtype");
+    column.dtype = static_cast<ScalarType>(dtype);
+    column.ragged = reader.read<uint8_t>() != 0;
+    column.shape.resize(reader.read<uint32_t>());
+    for (auto& size : column.shape) {
+      size = reader.read<int64_t>();
+      AT_CHECK(
+          size >= 0, "Corrupt mapped dataset file: column '", column.name,
+          "' has a negative size");
+    }
+    column.data_offset = reader.read<uint64_t>();
+    column.index_offset = reader.read<uint64_t>();
+    column.row_bytes = row_bytes(column.dtype, column.shape);
+
+    uint64_t rows = size_;
+    if (column.ragged) {
+      AT_CHECK(
+          column.index_offset <= bytes_ &&
+              (size_ + 1) * sizeof(uint64_t) <= bytes_ - column.index_offset,
+          "Corrupt mapped dataset file: the index of column '", column.name,
+          "' lies outside the file");
+      const auto* row_offsets =
+          reinterpret_cast<const uint64_t*>(base_ + column.index_offset);
+      AT_CHECK(
+          row_offsets[0] == 0 &&
+              std::is_sorted(row_offsets, row_offsets + size_ + 1),
+          "Corrupt mapped dataset file: the index of column '", column.name,
+          "' is not sorted");
+      rows = row_offsets[size_];
+    }
+    AT_CHECK(
+        column.data_offset <= bytes_ &&
+            rows * column.row_bytes <= bytes_ - column.data_offset,
+        "Corrupt mapped dataset file: the data of column '", column.name,
+        "' lies outside the file");
+    columns_.push_back(std::move(column));
+  }
+
+  data_column_ = find_column(data_column);
+  if (!target_column.empty()) {
+    target_column_ = find_column(target_column);
+  }
+#endif
+}
+
+Example<> MappedDataset::get(size_t index) const {
+  return {view(columns_[data_column_], index),
+          target_column_ ? view(columns_[*target_column_], index) : Tensor()};
+}
+
+Example<> MappedDataset::get_batch(ArrayRef<size_t> indices) {
+  return {gather(columns_[data_column_], indices),
+          target_column_ ? gather(columns_[*target_column_], indices)
+                         : Tensor()};
+}
+
+optional<size_t> MappedDataset::size() const {
+  return size_;
+}
+
+Tensor MappedDataset::get_column(const std::string& name, size_t index) const {
+  return view(columns_[find_column(name)], index);
+}
+
+std::vector<std::string> MappedDataset::column_names() const {
+  std::vector<std::string> names;
+  names.reserve(columns_.size());
+  for (const auto& column : columns_) {
+    names.push_back(column.name);
+  }
+  return names;
+}
+
+size_t MappedDataset::find_column(const std::string& name) const {
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    if (columns_[i].name == name) {
+      return i;
+    }
+  }
+  AT_ERROR("Mapped dataset file has no column named '", name, "'");
+}
+
+std::pair<uint64_t, uint64_t> MappedDataset::rows(
+    const Column& column,
+    size_t index) const {
+  AT_CHECK(
+      index < size_, "Index ", index,
+      " is out of range for a mapped dataset of size ", size_);
+  if (!column.ragged) {
+    return {index, index + 1};
+  }
+  const auto* row_offsets =
+      reinterpret_cast<const uint64_t*>(base_ + column.index_offset);
+  return {row_offsets[index], row_offsets[index + 1]};
+}
+
+Tensor MappedDataset::view(const Column& column, size_t index) const {
+  const auto range = rows(column, index);
+  std::vector<int64_t> shape;
+  if (column.ragged) {
+    shape.push_back(range.second - range.first);
+  }
+  shape.insert(shape.end(), column.shape.begin(), column.shape.end());
+  // The deleter keeps the mapping alive for as long as the view is.
+  auto mapping = mapping_;
+  return torch::from_blob(
+      const_cast<char*>(base_) + column.data_offset +
+          range.first * column.row_bytes,
+      shape,
+      [mapping](void* /* unused */) {},
+      column.dtype);
+}
+
+Tensor MappedDataset::gather(const Column& column, ArrayRef<size_t> indices)
+    const {
+  std::vector<std::pair<uint64_t, uint64_t>> ranges;
+  ranges.reserve(indices.size());
+  uint64_t total_rows = 0;
+  for (const auto index : indices) {
+    ranges.push_back(rows(column, index));
+    total_rows += ranges.back().second - ranges.back().first;
+  }
+
+  std::vector<int64_t> shape = {static_cast<int64_t>(total_rows)};
+  shape.insert(shape.end(), column.shape.begin(), column.shape.end());
+  auto batch = torch::empty(shape, column.dtype);
+
+  // Examples that follow each other in the batch and in the file are copied
+  // together, so a sequential batch takes a single `memcpy`.
+  const char* source = base_ + column.data_offset;
+  char* destination = static_cast<char*>(batch.data_ptr());
+  size_t i = 0;
+  while (i < ranges.size()) {
+    const auto first = ranges[i].first;
+    auto last = ranges[i].second;
+    for (++i; i < ranges.size() && ranges[i].first == last; ++i) {
+      last = ranges[i].second;
+    }
+    const size_t bytes = (last - first) * column.row_bytes;
+    std::memcpy(destination, source + first * column.row_bytes, bytes);
+    destination += bytes;
+  }
+  return batch;
+}
+
+void MappedDataset::write(
+    const std::string& path,
+    const std::vector<std::pair<std::string, std::vector<Tensor>>>& columns) {
+  static const bool is_little_endian = check_is_little_endian();
+  AT_CHECK(is_little_endian, "MappedDataset requires a little-endian host");
+  AT_CHECK(!columns.empty(), "A mapped dataset needs at least one column");
+
+  const uint64_t example_count = columns.front().second.size();
+  std::vector<ColumnLayout> layouts;
+  layouts.reserve(columns.size());
+  for (const auto& column : columns) {
+    const auto& tensors = column.second;
+    AT_CHECK(
+        tensors.size() == example_count, "Column '", column.first, "' has ",
+        tensors.size(), " examples, but column '", columns.front().first,
+        "' has ", example_count);
+    ColumnLayout layout;
+    layout.name = column.first;
+    layout.dtype =
+        tensors.empty() ? ScalarType::Float : tensors.front().scalar_type();
+    if (!tensors.empty()) {
+      layout.shape = tensors.front().sizes().vec();
+    }
+    for (const auto& tensor : tensors) {
+      AT_CHECK(
+          tensor.defined() && tensor.device().is_cpu(), "Column '",
+          column.first, "' must hold defined CPU tensors");
+      AT_CHECK(
+          tensor.scalar_type() == layout.dtype, "Column '", column.first,
+          "' mixes tensors of dtype ", layout.dtype, " and ",
+          tensor.scalar_type());
+      if (tensor.sizes() != layout.shape) {
+        layout.ragged = true;
+      }
+    }
+    if (layout.ragged) {
+      // Ragged columns share the shape of a row and are indexed by rows.
+      AT_CHECK(
+          !layout.shape.empty(), "Column '", column.first,
+          "' holds tensors of different shapes, which requires them to have "
+          "at least one dimension");
+      layout.shape.erase(layout.shape.begin());
+      layout.row_offsets.reserve(example_count + 1);
+      layout.row_offsets.push_back(0);
+      for (const auto& tensor : tensors) {
+        AT_CHECK(
+            tensor.dim() == static_cast<int64_t>(layout.shape.size()) + 1 &&
+                tensor.sizes().slice(1) == layout.shape,
+            "Column '", column.first,
+            "' holds tensors whose shapes differ in other than the first "
+            "dimension");
+        layout.row_offsets.push_back(
+            layout.row_offsets.back() + tensor.size(0));
+      }
+    }
+    for (const auto& tensor : tensors) {
+      layout.data_bytes += tensor.numel() * tensor.element_size();
+    }
+    layouts.push_back(std::move(layout));
+  }
+
+  // The size of the header does not depend on the offsets, so they can be
+  // assigned once it is known.
+  uint64_t offset = align(encode_header(layouts, example_count).size());
+  for (auto& layout : layouts) {
+    if (layout.ragged) {
+      layout.index_offset = offset;
+      offset = align(offset + layout.row_offsets.size() * sizeof(uint64_t));
+    }
+    layout.data_offset = offset;
+    offset = align(offset + layout.data_bytes);
+  }
+
+  std::ofstream stream(path, std::ios::binary);
+  AT_CHECK(stream, "Error opening mapped dataset file at ", path);
+  const auto header = encode_header(layouts, example_count);
+  stream.write(header.data(), header.size());
+  for (size_t c = 0; c < columns.size(); ++c) {
+    const auto& layout = layouts[c];
+    if (layout.ragged) {
+      pad_to(stream, layout.index_offset);
+      stream.write(
+          reinterpret_cast<const char*>(layout.row_offsets.data()),
+          layout.row_offsets.size() * sizeof(uint64_t));
+    }
+    pad_to(stream, layout.data_offset);
+    for (const auto& tensor : columns[c].second) {
+      const auto contiguous = tensor.contiguous();
+      stream.write(
+          static_cast<const char*>(contiguous.data_ptr()),
+          contiguous.numel() * contiguous.element_size());
+    }
+  }
+  AT_CHECK(stream, "Error writing mapped dataset file at ", path);
+}
+} // namespace datasets
+} // namespace data
+} // namespace torch
@@ -0,0 +1,71 @@
+#include <torch/data/detail/device_transfer.h>
+
+#include <torch/csrc/utils/memory.h>
+
+#ifdef USE_CUDA
+#include <ATen/cuda/CUDAEvent.h>
+#include <c10/cuda/CUDAGuard.h>
+#include <c10/cuda/CUDAStream.h>
+#endif
+
+#include <memory>
+
+namespace torch {
+namespace data {
+namespace detail {
+
+struct DeviceTransfer::Impl {
+  explicit Impl(Device device) : device(device) {}
+
+  Device device;
+#ifdef USE_CUDA
+  // Only set for CUDA devices.
+  std::unique_ptr<c10::cuda::CUDAStream> stream;
+#endif
+};
+
+DeviceTransfer::DeviceTransfer(Device device)
+    : impl_(torch::make_unique<Impl>(device)) {
+#ifdef USE_CUDA
+  if (device.is_cuda()) {
+    impl_->stream = torch::make_unique<c10::cuda::CUDAStream>(
+        c10::cuda::getStreamFromPool(
+            /*isHighPriority=*/false, device.index()));
+  }
+#endif
+}
+
+DeviceTransfer::~DeviceTransfer() = default;
+
+Tensor DeviceTransfer::copy(const Tensor& tensor) {
+#ifdef USE_CUDA
+  if (impl_->stream) {
+    // The result is allocated on the stream it will be used on, so the
+    // caching allocator does not need to know about the side stream.
+    auto result =
+        torch::empty_like(tensor, tensor.options().device(impl_->device));
+    c10::cuda::CUDAStreamGuard guard(*impl_->stream);
+    result.copy_(tensor, /*non_blocking=*/true);
+    return result;
+  }
+#endif
+  return tensor.to(impl_->device);
+}
+
+DeviceTransfer::Ready DeviceTransfer::record() {
+#ifdef USE_CUDA
+  if (impl_->stream) {
+    auto event = std::make_shared<at::cuda::CUDAEvent>();
+    event->record(*impl_->stream);
+    const auto index = impl_->device.index();
+    return [event, index] {
+      event->block(c10::cuda::getCurrentCUDAStream(index));
+    };
+  }
+#endif
+  return [] {};
+}
+
+} // namespace detail
+} // namespace data
+} // namespace torch
@@ -0,0 +1,410 @@
+#include <torch/data/detail/worker_process.h>
+
+#include <ATen/Parallel.h>
+#include <TH/THAllocator.h>
+
+#include <c10/util/Exception.h>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <utility>
+
+#ifndef _WIN32
+// Not available everywhere. Without MSG_NOSIGNAL, a write to the socket of a
+// dead worker raises SIGPIPE instead of failing.
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#ifndef MSG_CMSG_CLOEXEC
+#define MSG_CMSG_CLOEXEC 0
+#endif
+#endif
+
+namespace torch {
+namespace data {
+namespace detail {
+namespace {
+// Tensors are placed at offsets that are multiples of this in the segment.
+constexpr size_t kTensorAlignment = 64;
+
+size_t round_up(size_t value) {
+  return (value + kTensorAlignment - 1) / kTensorAlignment * kTensorAlignment;
+}
+
+#ifndef _WIN32
+// Precedes the bytes of every message. If the message has tensors, the file
+// descriptor of their shared memory segment is attached to the header.
+struct Header {
+  uint64_t bytes;
+  uint64_t shared_bytes;
+  uint64_t error;
+};
+
+// The parent's ends of the sockets of all live workers. A forked child must
+// close them, or the workers it inherits them from never see the end of
+// their stream.
+std::mutex parent_sockets_mutex;
+std::unordered_set<int> parent_sockets;
+
+void write_all(int fd, const char* data, size_t size) {
+  while (size > 0) {
+    const auto written = ::send(fd, data, size, MSG_NOSIGNAL);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    AT_CHECK(
+        written > 0,
+        "Failed to write to DataLoader worker socket: ",
+        std::strerror(errno));
+    data += written;
+    size -= written;
+  }
+}
+
+// Returns false if the other end was closed before any byte was read.
+bool read_all(int fd, char* data, size_t size) {
+  bool started = false;
+  while (size > 0) {
+    const auto bytes_read = ::read(fd, data, size);
+    if (bytes_read < 0 && errno == EINTR) {
+      continue;
+    }
+    AT_CHECK(
+        bytes_read >= 0,
+        "Failed to read from DataLoader worker socket: ",
+        std::strerror(errno));
+    if (bytes_read == 0) {
+      AT_CHECK(!started, "DataLoader worker socket closed mid-message");
+      return false;
+    }
+    started = true;
+    data += bytes_read;
+    size -= bytes_read;
+  }
+  return true;
+}
+
+std::string segment_name() {
+  static std::atomic<uint64_t> counter{0};
+  return "/torch_dataloader_" + std::to_string(::getpid()) + "_" +
+      std::to_string(counter++);
+}
+
+void send_message(int socket, const WireWriter& writer, bool error) {
+  Header header{writer.bytes().size(), writer.shared_bytes(), error};
+  at::DataPtr segment;
+  int fd = -1;
+  if (header.shared_bytes > 0) {
+    // The segment is unlinked right away, so that nothing is left behind if
+    // either process dies; it is passed on by file descriptor.
+    segment = THMapAllocator::makeDataPtr(
+        segment_name().c_str(),
+        TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_EXCLUSIVE |
+            TH_ALLOCATOR_MAPPED_KEEPFD | TH_ALLOCATOR_MAPPED_UNLINK,
+        header.shared_bytes,
+        nullptr);
+    writer.copy_tensors(segment.get());
+    fd = THMapAllocator::fromDataPtr(segment)->fd();
+  }
+
+  struct iovec io;
+  io.iov_base = &header;
+  io.iov_len = sizeof(header);
+  struct msghdr message;
+  std::memset(&message, 0, sizeof(message));
+  message.msg_iov = &io;
+  message.msg_iovlen = 1;
+  char control[CMSG_SPACE(sizeof(int))];
+  if (fd >= 0) {
+    std::memset(control, 0, sizeof(control));
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+  }
+  ssize_t sent;
+  do {
+    sent = ::sendmsg(socket, &message, MSG_NOSIGNAL);
+  } while (sent < 0 && errno == EINTR);
+  AT_CHECK(
+      sent > 0,
+      "Failed to write to DataLoader worker socket: ",
+      std::strerror(errno));
+  // The rest of the header, if it was split, and the bytes.
+  write_all(
+      socket,
+      reinterpret_cast<const char*>(&header) + sent,
+      sizeof(header) - sent);
+  write_all(socket, writer.bytes().data(), writer.bytes().size());
+}
+
+// Returns false if the other end was closed.
+bool receive_message(int socket, Header& header, std::string& bytes,
+                     std::shared_ptr<void>& segment) {
+  struct iovec io;
+  io.iov_base = &header;
+  io.iov_len = sizeof(header);
+  struct msghdr message;
+  std::memset(&message, 0, sizeof(message));
+  message.msg_iov = &io;
+  message.msg_iovlen = 1;
+  char control[CMSG_SPACE(sizeof(int))];
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  ssize_t received;
+  do {
+    received = ::recvmsg(socket, &message, MSG_CMSG_CLOEXEC);
+  } while (received < 0 && errno == EINTR);
+  AT_CHECK(
+      received >= 0,
+      "Failed to read from DataLoader worker socket: ",
+      std::strerror(errno));
+  if (received == 0) {
+    return false;
+  }
+  int fd = -1;
+  if (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+  }
+  read_all(
+      socket,
+      reinterpret_cast<char*>(&header) + received,
+      sizeof(header) - received);
+  bytes.resize(header.bytes);
+  read_all(socket, &bytes[0], bytes.size());
+
+  segment.reset();
+  if (header.shared_bytes > 0) {
+    AT_CHECK(fd >= 0, "Missing shared memory in DataLoader worker message");
+    // Maps the segment and closes `fd`.
+    auto data = std::make_shared<at::DataPtr>(THMapAllocator::makeDataPtr(
+        WITH_FD,
+        "<DataLoader worker batch>",
+        fd,
+        TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_FROMFD,
+        header.shared_bytes,
+        nullptr));
+    void* base = data->get();
+    segment = std::shared_ptr<void>(std::move(data), base);
+  }
+  return true;
+}
+
+// The loop run by the child process.
+void serve(int socket, const WorkerProcess::Handler& handler) {
+  Header header;
+  std::string bytes;
+  std::shared_ptr<void> segment;
+  while (receive_message(socket, header, bytes, segment)) {
+    WireReader request(std::move(bytes), std::move(segment));
+    WireWriter response;
+    bool error = false;
+    try {
+      handler(request, response);
+    } catch (const c10::Error& e) {
+      response = WireWriter();
+      response.write_string(e.what_without_backtrace());
+      error = true;
+    } catch (const std::exception& e) {
+      response = WireWriter();
+      response.write_string(e.what());
+      error = true;
+    } catch (...) {
+      response = WireWriter();
+      response.write_string("unknown exception");
+      error = true;
+    }
+    send_message(socket, response, error);
+    bytes.clear();
+  }
+}
+#endif // _WIN32
+} // namespace
+
+void WireWriter::write_int(int64_t value) {
+  bytes_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void WireWriter::write_string(const std::string& value) {
+  write_int(value.size());
+  bytes_.append(value);
+}
+
+void WireWriter::write_tensor(const Tensor& tensor) {
+  write_int(tensor.defined());
+  if (!tensor.defined()) {
+    return;
+  }
+  AT_CHECK(
+      !tensor.is_cuda(),
+      "DataLoader worker processes can only return CPU tensors");
+  auto contiguous = tensor.contiguous();
+  write_int(static_cast<int64_t>(contiguous.scalar_type()));
+  write_int(contiguous.dim());
+  for (const auto size : contiguous.sizes()) {
+    write_int(size);
+  }
+  const auto offset = round_up(shared_bytes_);
+  write_int(offset);
+  shared_bytes_ = offset + contiguous.nbytes();
+  tensors_.emplace_back(std::move(contiguous), offset);
+}
+
+void WireWriter::copy_tensors(void* segment) const {
+  for (const auto& tensor : tensors_) {
+    std::memcpy(
+        static_cast<char*>(segment) + tensor.second,
+        tensor.first.data_ptr(),
+        tensor.first.nbytes());
+  }
+}
+
+WireReader::WireReader(std::string bytes, std::shared_ptr<void> segment)
+    : bytes_(std::move(bytes)), segment_(std::move(segment)) {}
+
+int64_t WireReader::read_int() {
+  int64_t value;
+  AT_CHECK(
+      position_ + sizeof(value) <= bytes_.size(),
+      "Truncated DataLoader worker message");
+  std::memcpy(&value, bytes_.data() + position_, sizeof(value));
+  position_ += sizeof(value);
+  return value;
+}
+
+std::string WireReader::read_string() {
+  const auto size = read_int();
+  AT_CHECK(
+      position_ + size <= bytes_.size(),
+      "Truncated DataLoader worker message");
+  std::string value = bytes_.substr(position_, size);
+  position_ += size;
+  return value;
+}
+
+Tensor WireReader::read_tensor() {
+  if (!read_int()) {
+    return Tensor();
+  }
+  const auto type = static_cast<ScalarType>(read_int());
+  std::vector<int64_t> sizes(read_int());
+  for (auto& size : sizes) {
+    size = read_int();
+  }
+  const auto offset = read_int();
+  auto options = TensorOptions().dtype(type);
+  if (!segment_) {
+    // All tensors of the message are empty.
+    return torch::empty(sizes, options);
+  }
+  auto segment = segment_;
+  return torch::from_blob(
+      static_cast<char*>(segment_.get()) + offset,
+      sizes,
+      [segment](void*) {},
+      options);
+}
+
+#ifndef _WIN32
+WorkerProcess::WorkerProcess(Handler handler) {
+  int sockets[2];
+  AT_CHECK(
+      ::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0,
+      "Failed to create a socket for a DataLoader worker process: ",
+      std::strerror(errno));
+  std::unique_lock<std::mutex> lock(parent_sockets_mutex);
+  const auto pid = ::fork();
+  if (pid < 0) {
+    lock.unlock();
+    ::close(sockets[0]);
+    ::close(sockets[1]);
+    AT_ERROR(
+        "Failed to fork a DataLoader worker process: ", std::strerror(errno));
+  }
+  if (pid == 0) {
+    // The lock is not released here: it belongs to the parent's copy of this
+    // thread, and the child never creates workers itself.
+    lock.release();
+    ::close(sockets[0]);
+    for (const auto socket : parent_sockets) {
+      ::close(socket);
+    }
+    at::set_num_threads(1);
+    int status = 0;
+    try {
+      serve(sockets[1], handler);
+    } catch (...) {
+      status = 1;
+    }
+    // Skip the destructors and exit handlers of the parent's state.
+    ::_exit(status);
+  }
+  parent_sockets.insert(sockets[0]);
+  lock.unlock();
+  ::close(sockets[1]);
+  socket_ = sockets[0];
+  pid_ = pid;
+}
+
+WorkerProcess::~WorkerProcess() {
+  // The child exits once it sees the end of the stream.
+  {
+    std::lock_guard<std::mutex> lock(parent_sockets_mutex);
+    parent_sockets.erase(socket_);
+    ::close(socket_);
+  }
+  int status;
+  while (::waitpid(pid_, &status, 0) < 0 && errno == EINTR) {
+  }
+}
+
+WireReader WorkerProcess::request(const WireWriter& request) {
+  send_message(socket_, request, /*error=*/false);
+  Header header;
+  std::string bytes;
+  std::shared_ptr<void> segment;
+  AT_CHECK(
+      receive_message(socket_, header, bytes, segment),
+      "DataLoader worker process (pid ", pid_, ") exited unexpectedly");
+  WireReader response(std::move(bytes), std::move(segment));
+  if (header.error) {
+    AT_ERROR(
+        "DataLoader worker process (pid ",
+        pid_,
+        ") raised: ",
+        response.read_string());
+  }
+  return response;
+}
+#else
+WorkerProcess::WorkerProcess(Handler /* unused */) {
+  AT_ERROR("DataLoader worker processes are not supported on Windows");
+}
+
+WorkerProcess::~WorkerProcess() = default;
+
+WireReader WorkerProcess::request(const WireWriter& /* unused */) {
+  AT_ERROR("DataLoader worker processes are not supported on Windows");
+}
+#endif // _WIN32
+
+} // namespace detail
+} // namespace data
+} // namespace torch
@@ -27,11 +27,20 @@ void EmbeddingImpl::reset() {
 
 void EmbeddingImpl::pretty_print(std::ostream& stream) const {
   stream << "torch::nn::Embedding(count=" << options.count_
-         << ", dimension=" << options.dimension_ << ")";
+         << ", dimension=" << options.dimension_;
+  if (options.sparse_) {
+    stream << ", sparse=true";
+  }
+  stream << ")";
 }
 
 Tensor EmbeddingImpl::forward(const Tensor& input) {
-  return torch::embedding(weight, /*indices=*/input);
+  return torch::embedding(
+      weight,
+      /*indices=*/input,
+      /*padding_idx=*/-1,
+      /*scale_grad_by_freq=*/false,
+      /*sparse=*/options.sparse_);
 }
 } // namespace nn
 } // namespace torch
@@ -5,11 +5,68 @@
 #include <torch/utils.h>
 
 #include <ATen/ATen.h>
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/SparseTensorUtils.h>
 
+#include <cmath>
 #include <functional>
 
 namespace torch {
 namespace optim {
+namespace {
+/// Updates the rows of `p` and of `sum` that the sparse `grad` touches, as in
+/// https://github.com/pytorch/pytorch/blob/master/torch/optim/adagrad.py
+/// On CPU, the update of every row is fused into a single pass, in parallel
+/// over the rows, and the gradient is never made dense.
+void sparse_adagrad_step(Tensor& p, Tensor& sum, const Tensor& sparse_grad, double clr) {
+  // the update is non-linear so indices must be unique
+  const Tensor grad = sparse_grad.coalesce();
+  const int64_t nnz = grad._nnz();
+  if (nnz == 0) {
+    return;
+  }
+  const Tensor indices = grad._indices();
+  const Tensor values = grad._values().contiguous();
+
+  if (p.device().is_cpu() && p.is_contiguous() && sum.is_contiguous()) {
+    const Tensor flat_indices =
+        at::sparse::flatten_indices(indices, grad.sizes()).contiguous();
+    const int64_t* flat_indices_data = flat_indices.data<int64_t>();
+    const int64_t block_size = values.numel() / nnz;
+    AT_DISPATCH_FLOATING_TYPES(p.scalar_type(), "sparse_adagrad_step", [&] {
+      const scalar_t* values_data = values.data<scalar_t>();
+      scalar_t* p_data = p.data<scalar_t>();
+      scalar_t* sum_data = sum.data<scalar_t>();
+      const scalar_t lr = clr;
+      at::parallel_for(
+          0,
+          nnz,
+          std::max<int64_t>(at::internal::GRAIN_SIZE / std::max<int64_t>(block_size, 1), 1),
+          [&](int64_t begin, int64_t end) {
+            for (int64_t i = begin; i < end; ++i) {
+              const scalar_t* g = values_data + i * block_size;
+              scalar_t* w = p_data + flat_indices_data[i] * block_size;
+              scalar_t* h = sum_data + flat_indices_data[i] * block_size;
+              for (int64_t k = 0; k < block_size; ++k) {
+                h[k] += g[k] * g[k];
+                w[k] -= lr * g[k] / (std::sqrt(h[k]) + scalar_t(1e-10));
+              }
+            }
+          });
+    });
+    return;
+  }
+
+  const auto make_sparse = [&](const Tensor& new_values) {
+    return at::sparse_coo_tensor(indices, new_values, grad.sizes());
+  };
+  sum.add_(make_sparse(values.pow(2)));
+  const auto std_values =
+      sum.sparse_mask(at::SparseTensorRef(grad))._values().sqrt_().add_(1e-10);
+  p.add_(make_sparse(values / std_values), -clr);
+}
+} // namespace
 
 AdagradOptions::AdagradOptions(double learning_rate)
     : learning_rate_(learning_rate) {}
@@ -24,6 +81,9 @@ void Adagrad::step() {
     }
 
     if (options.weight_decay_ > 0) {
+      AT_CHECK(
+          !p.grad().is_sparse(),
+          "weight_decay option is not compatible with sparse gradients");
       p.grad() = p.grad() + options.weight_decay_ * p;
     }
 
@@ -32,6 +92,11 @@ void Adagrad::step() {
         (1.0 + (buffer_at(step_buffers, i) - 1.0) * options.lr_decay_);
 
     auto& sum = buffer_at(sum_buffers, i);
+    if (p.grad().is_sparse()) {
+      NoGradGuard guard;
+      sparse_adagrad_step(p, sum, p.grad(), clr);
+      continue;
+    }
     sum.addcmul_(p.grad(), p.grad(), 1.0);
     const auto std = buffer_at(sum_buffers, i).sqrt().add_(1e-10);
 
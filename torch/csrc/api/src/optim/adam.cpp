@@ -6,16 +6,105 @@
 #include <torch/utils.h>
 
 #include <ATen/ATen.h>
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/SparseTensorUtils.h>
+#include <ATen/native/FusedOptimizers.h>
 
+#include <algorithm>
 #include <cmath>
 #include <functional>
 
 namespace torch {
 namespace optim {
+namespace {
+/// Updates the rows of `p` and of its moments that the sparse `grad` touches,
+/// leaving the others alone, as in
+/// https://github.com/pytorch/pytorch/blob/master/torch/optim/sparse_adam.py
+/// On CPU, the update of every row is fused into a single pass, in parallel
+/// over the rows, and the gradient is never made dense.
+void sparse_adam_step(
+    Tensor& p,
+    Tensor& exp_average,
+    Tensor& exp_average_sq,
+    const Tensor& sparse_grad,
+    const AdamOptions& options,
+    double step_size) {
+  // the update is non-linear so indices must be unique
+  const Tensor grad = sparse_grad.coalesce();
+  const int64_t nnz = grad._nnz();
+  if (nnz == 0) {
+    return;
+  }
+  const Tensor indices = grad._indices();
+  const Tensor values = grad._values().contiguous();
+
+  if (p.device().is_cpu() && p.is_contiguous() && exp_average.is_contiguous() &&
+      exp_average_sq.is_contiguous()) {
+    const Tensor flat_indices =
+        at::sparse::flatten_indices(indices, grad.sizes()).contiguous();
+    const int64_t* flat_indices_data = flat_indices.data<int64_t>();
+    const int64_t block_size = values.numel() / nnz;
+    AT_DISPATCH_FLOATING_TYPES(p.scalar_type(), "sparse_adam_step", [&] {
+      const scalar_t* values_data = values.data<scalar_t>();
+      scalar_t* p_data = p.data<scalar_t>();
+      scalar_t* m_data = exp_average.data<scalar_t>();
+      scalar_t* v_data = exp_average_sq.data<scalar_t>();
+      const scalar_t one_minus_beta1 = 1 - options.beta1_;
+      const scalar_t one_minus_beta2 = 1 - options.beta2_;
+      const scalar_t eps = options.eps_;
+      const scalar_t lr = step_size;
+      at::parallel_for(
+          0,
+          nnz,
+          std::max<int64_t>(at::internal::GRAIN_SIZE / std::max<int64_t>(block_size, 1), 1),
+          [&](int64_t begin, int64_t end) {
+            for (int64_t i = begin; i < end; ++i) {
+              const scalar_t* g = values_data + i * block_size;
+              const int64_t offset = flat_indices_data[i] * block_size;
+              scalar_t* w = p_data + offset;
+              scalar_t* m = m_data + offset;
+              scalar_t* v = v_data + offset;
+              for (int64_t k = 0; k < block_size; ++k) {
+                m[k] += one_minus_beta1 * (g[k] - m[k]);
+                v[k] += one_minus_beta2 * (g[k] * g[k] - v[k]);
+                w[k] -= lr * m[k] / (std::sqrt(v[k]) + eps);
+              }
+            }
+          });
+    });
+    return;
+  }
+
+  const auto make_sparse = [&](const Tensor& new_values) {
+    return at::sparse_coo_tensor(indices, new_values, grad.sizes());
+  };
+  const at::SparseTensorRef mask(grad);
+  const auto old_exp_average_values = exp_average.sparse_mask(mask)._values();
+  auto exp_average_update_values =
+      values.sub(old_exp_average_values).mul_(1 - options.beta1_);
+  exp_average.add_(make_sparse(exp_average_update_values));
+  const auto old_exp_average_sq_values =
+      exp_average_sq.sparse_mask(mask)._values();
+  auto exp_average_sq_update_values = values.pow(2)
+                                          .sub_(old_exp_average_sq_values)
+                                          .mul_(1 - options.beta2_);
+  exp_average_sq.add_(make_sparse(exp_average_sq_update_values));
+
+  const auto numer = exp_average_update_values.add_(old_exp_average_values);
+  const auto denom = exp_average_sq_update_values.add_(old_exp_average_sq_values)
+                         .sqrt_()
+                         .add_(options.eps_);
+  p.add_(make_sparse(numer.div_(denom)), -step_size);
+}
+} // namespace
 AdamOptions::AdamOptions(double learning_rate)
     : learning_rate_(learning_rate) {}
 
 void Adam::step() {
+  if (fused_step()) {
+    return;
+  }
   for (size_t i = 0; i < parameters_.size(); ++i) {
     Tensor p = parameters_.at(i);
     if (!p.grad().defined()) {
@@ -23,6 +112,9 @@ void Adam::step() {
     }
 
     if (options.weight_decay_ > 0) {
+      AT_CHECK(
+          !p.grad().is_sparse(),
+          "weight_decay option is not compatible with sparse gradients");
       p.grad() = p.grad() + options.weight_decay_ * p;
     }
 
@@ -31,6 +123,26 @@ void Adam::step() {
 
     buffer_at(step_buffers, i) += 1;
 
+    if (p.grad().is_sparse()) {
+      AT_CHECK(
+          !options.amsgrad_,
+          "amsgrad option is not compatible with sparse gradients");
+      const auto bias_correction1 =
+          1 - std::pow(options.beta1_, buffer_at(step_buffers, i));
+      const auto bias_correction2 =
+          1 - std::pow(options.beta2_, buffer_at(step_buffers, i));
+      NoGradGuard guard;
+      sparse_adam_step(
+          p,
+          exp_average,
+          exp_average_sq,
+          p.grad(),
+          options,
+          options.learning_rate_ * std::sqrt(bias_correction2) /
+              bias_correction1);
+      continue;
+    }
+
     exp_average.mul_(options.beta1_).add_(p.grad(), 1 - options.beta1_);
     exp_average_sq.mul_(options.beta2_)
         .addcmul_(p.grad(), p.grad(), 1 - options.beta2_);
@@ -54,6 +166,52 @@ void Adam::step() {
   }
 }
 
+bool Adam::fused_step() {
+  std::vector<std::vector<Tensor>*> buffers = {
+      &exp_average_buffers, &exp_average_sq_buffers};
+  if (options.amsgrad_) {
+    buffers.push_back(&max_exp_average_sq_buffers);
+  }
+  const auto indices = fused_step_parameters(buffers);
+  // The parameters share a step size, so they must have all been updated as
+  // many times.
+  if (indices.empty() ||
+      !std::all_of(indices.begin(), indices.end(), [&](size_t i) {
+        return buffer_at(step_buffers, i) ==
+            buffer_at(step_buffers, indices[0]);
+      })) {
+    return false;
+  }
+  std::vector<Tensor> params, grads, exp_averages, exp_average_sqs,
+      max_exp_average_sqs;
+  for (const auto i : indices) {
+    params.push_back(parameters_[i]);
+    grads.push_back(parameters_[i].grad());
+    exp_averages.push_back(exp_average_buffers[i]);
+    exp_average_sqs.push_back(exp_average_sq_buffers[i]);
+    if (options.amsgrad_) {
+      max_exp_average_sqs.push_back(max_exp_average_sq_buffers[i]);
+    }
+    buffer_at(step_buffers, i) += 1;
+  }
+
+  const auto step = buffer_at(step_buffers, indices[0]);
+  const auto bias_correction1 = 1 - std::pow(options.beta1_, step);
+  const auto bias_correction2 = 1 - std::pow(options.beta2_, step);
+  at::native::fused_adam_step(
+      params,
+      grads,
+      exp_averages,
+      exp_average_sqs,
+      max_exp_average_sqs,
+      options.learning_rate_ * std::sqrt(bias_correction2) / bias_correction1,
+      options.beta1_,
+      options.beta2_,
+      options.eps_,
+      options.weight_decay_);
+  return true;
+}
+
 void Adam::save(serialize::OutputArchive& archive) const {
   serialize(*this, archive);
 }
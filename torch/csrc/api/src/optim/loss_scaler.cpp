@@ -0,0 +1,65 @@
+#include <torch/optim/loss_scaler.h>
+
+#include <torch/optim/optimizer.h>
+#include <torch/serialize/archive.h>
+#include <torch/types.h>
+#include <torch/utils.h>
+
+#include <ATen/ATen.h>
+
+#include <cmath>
+
+namespace torch {
+namespace optim {
+LossScaler::LossScaler(const LossScalerOptions& options)
+    : options(options), scale_(options.init_scale_) {}
+
+Tensor LossScaler::scale(const Tensor& loss) const {
+  return loss * scale_;
+}
+
+bool LossScaler::step(Optimizer& optimizer) {
+  // The sum of all the gradients is finite if they all are, and checking it
+  // only synchronizes with the device once.
+  Tensor sum;
+  {
+    NoGradGuard guard;
+    for (auto& parameter : optimizer.parameters()) {
+      auto& grad = parameter.grad();
+      if (!grad.defined()) {
+        continue;
+      }
+      grad.mul_(1 / scale_);
+      auto grad_sum = grad.sum(at::kFloat);
+      sum = sum.defined() ? sum + grad_sum.to(sum.device()) : grad_sum;
+    }
+  }
+
+  const bool finite = !sum.defined() || std::isfinite(sum.item<float>());
+  if (finite) {
+    optimizer.step();
+    if (++steps_since_update_ == options.growth_interval_) {
+      scale_ *= options.growth_factor_;
+      steps_since_update_ = 0;
+    }
+  } else {
+    scale_ *= options.backoff_factor_;
+    steps_since_update_ = 0;
+  }
+  return finite;
+}
+
+void LossScaler::save(serialize::OutputArchive& archive) const {
+  archive.write("scale", torch::tensor(scale_));
+  archive.write("steps_since_update", torch::tensor(steps_since_update_));
+}
+
+void LossScaler::load(serialize::InputArchive& archive) {
+  Tensor scale, steps_since_update;
+  archive.read("scale", scale);
+  archive.read("steps_since_update", steps_since_update);
+  scale_ = scale.item<double>();
+  steps_since_update_ = steps_since_update.item<int64_t>();
+}
+} // namespace optim
+} // namespace torch
@@ -5,6 +5,8 @@
 #include <torch/serialize/archive.h>
 #include <torch/types.h>
 
+#include <ATen/native/FusedOptimizers.h>
+
 #include <string>
 #include <utility>
 #include <vector>
@@ -57,6 +59,32 @@ Tensor& OptimizerBase::buffer_at(std::vector<Tensor>& buffers, size_t index) {
   return buffers[index];
 }
 
+std::vector<size_t> OptimizerBase::fused_step_parameters(
+    const std::vector<std::vector<Tensor>*>& buffers) {
+  std::vector<size_t> indices;
+  std::vector<Tensor> tensors;
+  for (size_t i = 0; i < parameters_.size(); ++i) {
+    const auto& parameter = parameters_[i];
+    if (parameter.grad().defined()) {
+      indices.push_back(i);
+      tensors.push_back(parameter);
+      tensors.push_back(parameter.grad());
+    }
+  }
+  if (!at::native::can_use_fused_optimizer_step(tensors)) {
+    return {};
+  }
+  for (auto* buffer : buffers) {
+    for (const auto i : indices) {
+      tensors.push_back(buffer_at(*buffer, i));
+    }
+  }
+  if (!at::native::can_use_fused_optimizer_step(tensors)) {
+    return {};
+  }
+  return indices;
+}
+
 void OptimizerBase::save(serialize::OutputArchive& archive) const {}
 void OptimizerBase::load(serialize::InputArchive& archive) {}
 
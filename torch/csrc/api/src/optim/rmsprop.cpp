@@ -5,6 +5,7 @@
 #include <torch/utils.h>
 
 #include <ATen/ATen.h>
+#include <ATen/native/FusedOptimizers.h>
 
 #include <functional>
 
@@ -17,6 +18,9 @@ RMSpropOptions::RMSpropOptions(double learning_rate)
 /// Adapted from
 /// https://github.com/pytorch/pytorch/blob/master/torch/optim/rmsprop.py
 void RMSprop::step() {
+  if (fused_step()) {
+    return;
+  }
   for (size_t i = 0; i < parameters_.size(); ++i) {
     Tensor p = parameters_.at(i);
     if (!p.grad().defined()) {
@@ -53,6 +57,45 @@ void RMSprop::step() {
   }
 }
 
+bool RMSprop::fused_step() {
+  std::vector<std::vector<Tensor>*> buffers = {&square_average_buffers};
+  if (options.centered_) {
+    buffers.push_back(&grad_average_buffers);
+  }
+  if (options.momentum_ > 0) {
+    buffers.push_back(&momentum_buffers);
+  }
+  const auto indices = fused_step_parameters(buffers);
+  if (indices.empty()) {
+    return false;
+  }
+  std::vector<Tensor> params, grads, square_averages, grad_averages,
+      momentums;
+  for (const auto i : indices) {
+    params.push_back(parameters_[i]);
+    grads.push_back(parameters_[i].grad());
+    square_averages.push_back(square_average_buffers[i]);
+    if (options.centered_) {
+      grad_averages.push_back(grad_average_buffers[i]);
+    }
+    if (options.momentum_ > 0) {
+      momentums.push_back(momentum_buffers[i]);
+    }
+  }
+  at::native::fused_rmsprop_step(
+      params,
+      grads,
+      square_averages,
+      grad_averages,
+      momentums,
+      options.learning_rate_,
+      options.alpha_,
+      options.eps_,
+      options.weight_decay_,
+      options.momentum_);
+  return true;
+}
+
 void RMSprop::save(serialize::OutputArchive& archive) const {
   serialize(*this, archive);
 }
@@ -8,14 +8,67 @@
 #include <torch/utils.h>
 
 #include <ATen/ATen.h>
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/SparseTensorUtils.h>
+#include <ATen/native/FusedOptimizers.h>
 
+#include <atomic>
 #include <functional>
 
 namespace torch {
 namespace optim {
+namespace {
+/// Adds `alpha * sparse_grad` to `p` with relaxed atomic adds, in parallel
+/// over the nonzeros of the gradient, which needs not be coalesced.
+void atomic_sparse_add_(Tensor& p, const Tensor& sparse_grad, double alpha) {
+  const int64_t nnz = sparse_grad._nnz();
+  if (nnz == 0) {
+    return;
+  }
+  const Tensor flat_indices =
+      at::sparse::flatten_indices(sparse_grad._indices(), sparse_grad.sizes())
+          .contiguous();
+  const Tensor values = sparse_grad._values().contiguous();
+  const int64_t* flat_indices_data = flat_indices.data<int64_t>();
+  const int64_t block_size = values.numel() / nnz;
+  AT_DISPATCH_FLOATING_TYPES(p.scalar_type(), "atomic_sparse_add_", [&] {
+    using atomic_t = std::atomic<scalar_t>;
+    static_assert(
+        sizeof(atomic_t) == sizeof(scalar_t) &&
+            alignof(atomic_t) == alignof(scalar_t),
+        "atomic_sparse_add_ needs atomics the size of scalars");
+    const scalar_t* values_data = values.data<scalar_t>();
+    atomic_t* p_data = reinterpret_cast<atomic_t*>(p.data<scalar_t>());
+    const scalar_t a = alpha;
+    at::parallel_for(
+        0,
+        nnz,
+        std::max<int64_t>(
+            at::internal::GRAIN_SIZE / std::max<int64_t>(block_size, 1), 1),
+        [&](int64_t begin, int64_t end) {
+          for (int64_t i = begin; i < end; ++i) {
+            const scalar_t* g = values_data + i * block_size;
+            atomic_t* w = p_data + flat_indices_data[i] * block_size;
+            for (int64_t k = 0; k < block_size; ++k) {
+              scalar_t old = w[k].load(std::memory_order_relaxed);
+              while (!w[k].compare_exchange_weak(
+                  old, old + a * g[k], std::memory_order_relaxed)) {
+              }
+            }
+          }
+        });
+  });
+}
+} // namespace
+
 SGDOptions::SGDOptions(double learning_rate) : learning_rate_(learning_rate) {}
 
 void SGD::step() {
+  if (fused_step()) {
+    iteration_ += 1;
+    return;
+  }
   for (size_t i = 0; i < parameters_.size(); ++i) {
     Tensor p = parameters_.at(i);
 
@@ -25,6 +78,14 @@ void SGD::step() {
 
     auto update = p.grad();
 
+    if (options.atomic_sparse_updates_ && update.is_sparse() &&
+        options.weight_decay_ == 0 && options.momentum_ == 0 &&
+        p.device().is_cpu() && p.is_contiguous()) {
+      NoGradGuard guard;
+      atomic_sparse_add_(p, update, -options.learning_rate_);
+      continue;
+    }
+
     if (options.weight_decay_ > 0) {
       update += options.weight_decay_ * p;
     }
@@ -48,6 +109,36 @@ void SGD::step() {
   iteration_ += 1;
 }
 
+bool SGD::fused_step() {
+  const bool use_momentum = options.momentum_ != 0;
+  std::vector<std::vector<Tensor>*> buffers;
+  if (use_momentum) {
+    buffers.push_back(&momentum_buffers);
+  }
+  const auto indices = fused_step_parameters(buffers);
+  if (indices.empty()) {
+    return false;
+  }
+  std::vector<Tensor> params, grads, momentums;
+  for (const auto i : indices) {
+    params.push_back(parameters_[i]);
+    grads.push_back(parameters_[i].grad());
+    if (use_momentum) {
+      momentums.push_back(momentum_buffers[i]);
+    }
+  }
+  at::native::fused_sgd_step(
+      params,
+      grads,
+      momentums,
+      options.learning_rate_,
+      options.weight_decay_,
+      options.momentum_,
+      iteration_ == 0 ? 1 : 1 - options.dampening_,
+      options.nesterov_);
+  return true;
+}
+
 void SGD::save(serialize::OutputArchive& archive) const {
   optim::serialize(archive, "momentum_buffers", momentum_buffers);
 }
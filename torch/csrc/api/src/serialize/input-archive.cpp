@@ -1,4 +1,5 @@
 #include <torch/serialize/input-archive.h>
+#include <torch/serialize/output-archive.h>
 
 #include <torch/types.h>
 #include <torch/utils.h>
@@ -15,6 +16,28 @@
 
 namespace torch {
 namespace serialize {
+namespace {
+// Adds the parameters, buffers and submodules of `source` to `target`.
+void merge(jit::script::Module& target, const jit::script::Module& source) {
+  for (const auto& slot : source.get_parameters()) {
+    target.register_parameter(
+        slot.name(), slot.value().toTensor(), /*is_buffer=*/false);
+  }
+  for (const auto& slot : source.get_attributes()) {
+    if (slot.type()->isSubtypeOf(c10::TensorType::get())) {
+      target.register_buffer(slot.name(), slot.value().toTensor());
+    }
+  }
+  for (const auto& submodule : source.get_modules()) {
+    auto nested = target.find_module(submodule->name());
+    if (nested == nullptr) {
+      nested = std::make_shared<jit::script::Module>();
+      target.register_module(submodule->name(), nested);
+    }
+    merge(*nested, *submodule);
+  }
+}
+} // namespace
 
 InputArchive::InputArchive()
     : module_(std::make_shared<jit::script::Module>()) {}
@@ -79,6 +102,17 @@ void InputArchive::load_from(const std::string& filename,
   module_ = torch::jit::load(filename, std::move(device));
 }
 
+void InputArchive::load_from(const std::string& filename,
+    size_t num_shards,
+    c10::optional<torch::Device> device /*= c10::nullopt*/) {
+  AT_CHECK(num_shards > 0, "load_from expects at least one shard");
+  module_ = torch::jit::load(shard_filename(filename, 0, num_shards), device);
+  for (size_t i = 1; i < num_shards; i++) {
+    auto shard = torch::jit::load(shard_filename(filename, i, num_shards), device);
+    merge(*module_, *shard);
+  }
+}
+
 void InputArchive::load_from(std::istream& stream,
     c10::optional<torch::Device> device /*= c10::nullopt*/) {
   module_ = torch::jit::load(stream, std::move(device));
@@ -8,12 +8,154 @@
 
 #include <c10/util/Exception.h>
 
+#ifdef USE_CUDA
+#include <ATen/cuda/CUDAEvent.h>
+#include <c10/cuda/CUDAStream.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <functional>
 #include <memory>
 #include <ostream>
+#include <set>
 #include <string>
+#include <utility>
 
 namespace torch {
 namespace serialize {
+namespace {
+using ModulePtr = std::shared_ptr<jit::script::Module>;
+
+// Copies `tensor` to the CPU, so that the copy is not affected by later
+// modifications of `tensor`. Copies from CUDA tensors go to pinned memory and
+// do not block; their devices are added to `devices`.
+Tensor snapshot(const Tensor& tensor, std::set<c10::DeviceIndex>& devices) {
+  torch::NoGradGuard guard;
+  Tensor copy;
+  if (tensor.is_cuda()) {
+    copy = torch::empty(
+        tensor.sizes(),
+        tensor.options().device(kCPU).pinned_memory(true));
+    copy.copy_(tensor, /*non_blocking=*/true);
+    devices.insert(tensor.device().index());
+  } else {
+    copy = tensor.clone();
+  }
+  copy.set_requires_grad(tensor.requires_grad());
+  return copy;
+}
+
+// Distributes snapshots of the parameters and buffers of `module` over the
+// modules in `shards`, which have the same nesting as `module`. Each tensor
+// goes to the shard with the fewest bytes so far.
+void distribute(
+    const jit::script::Module& module,
+    const std::vector<ModulePtr>& shards,
+    std::vector<size_t>& shard_bytes,
+    std::set<c10::DeviceIndex>& devices) {
+  auto add = [&](const jit::script::Slot& slot, bool is_buffer) {
+    const auto& tensor = slot.value().toTensor();
+    const auto shard =
+        std::min_element(shard_bytes.begin(), shard_bytes.end()) -
+        shard_bytes.begin();
+    shards[shard]->register_parameter(
+        slot.name(), snapshot(tensor, devices), is_buffer);
+    shard_bytes[shard] += tensor.nbytes();
+  };
+  for (const auto& slot : module.get_parameters()) {
+    add(slot, /*is_buffer=*/false);
+  }
+  for (const auto& slot : module.get_attributes()) {
+    if (slot.type()->isSubtypeOf(c10::TensorType::get())) {
+      add(slot, /*is_buffer=*/true);
+    }
+  }
+  for (const auto& submodule : module.get_modules()) {
+    std::vector<ModulePtr> nested;
+    for (const auto& shard : shards) {
+      nested.push_back(std::make_shared<jit::script::Module>());
+      shard->register_module(submodule->name(), nested.back());
+    }
+    distribute(*submodule, nested, shard_bytes, devices);
+  }
+}
+
+// Returns a function that blocks until the copies issued so far on the
+// current streams of `devices` have completed.
+std::function<void()> record(const std::set<c10::DeviceIndex>& devices) {
+#ifdef USE_CUDA
+  std::vector<std::shared_ptr<at::cuda::CUDAEvent>> events;
+  for (const auto index : devices) {
+    events.push_back(std::make_shared<at::cuda::CUDAEvent>());
+    events.back()->record(c10::cuda::getCurrentCUDAStream(index));
+  }
+  return [events] {
+    for (const auto& event : events) {
+      event->synchronize();
+    }
+  };
+#else
+  AT_ASSERT(devices.empty());
+  return [] {};
+#endif
+}
+} // namespace
+
+std::string shard_filename(
+    const std::string& filename,
+    size_t shard,
+    size_t num_shards) {
+  AT_CHECK(
+      shard < num_shards,
+      "Shard ", shard, " is out of range for ", num_shards, " shards");
+  if (num_shards == 1) {
+    return filename;
+  }
+  return filename + "." + std::to_string(shard);
+}
+
+AsyncSave::AsyncSave(std::vector<std::future<void>> shards)
+    : shards_(std::move(shards)) {}
+
+AsyncSave::~AsyncSave() {
+  for (auto& shard : shards_) {
+    if (shard.valid()) {
+      shard.wait();
+    }
+  }
+}
+
+bool AsyncSave::done() const {
+  return std::all_of(
+      shards_.begin(), shards_.end(), [](const std::future<void>& shard) {
+        return !shard.valid() ||
+            shard.wait_for(std::chrono::seconds(0)) ==
+            std::future_status::ready;
+      });
+}
+
+void AsyncSave::wait() {
+  // Waits for every shard before rethrowing, so no writer outlives the call.
+  std::exception_ptr error;
+  for (auto& shard : shards_) {
+    if (!shard.valid()) {
+      continue;
+    }
+    try {
+      shard.get();
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
 OutputArchive::OutputArchive()
     : module_(std::make_shared<jit::script::Module>()) {}
 
@@ -39,5 +181,33 @@ void OutputArchive::save_to(std::ostream& stream) {
   AT_ASSERT(module_ != nullptr);
   jit::ExportModule(*module_, stream);
 }
+
+AsyncSave OutputArchive::save_to_async(
+    const std::string& filename,
+    size_t num_shards) {
+  AT_ASSERT(module_ != nullptr);
+  AT_CHECK(num_shards > 0, "save_to_async expects at least one shard");
+  std::vector<ModulePtr> shards;
+  for (size_t i = 0; i < num_shards; i++) {
+    shards.push_back(std::make_shared<jit::script::Module>());
+  }
+  std::vector<size_t> shard_bytes(num_shards, 0);
+  std::set<c10::DeviceIndex> devices;
+  distribute(*module_, shards, shard_bytes, devices);
+  auto ready = record(devices);
+
+  std::vector<std::future<void>> writers;
+  for (size_t i = 0; i < num_shards; i++) {
+    writers.push_back(std::async(
+        std::launch::async,
+        [ready](ModulePtr shard, std::string name) {
+          ready();
+          jit::ExportModule(*shard, name);
+        },
+        std::move(shards[i]),
+        shard_filename(filename, i, num_shards)));
+  }
+  return AsyncSave(std::move(writers));
+}
 } // namespace serialize
 } // namespace torch
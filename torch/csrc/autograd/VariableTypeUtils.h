@@ -3,6 +3,7 @@
 #include <torch/csrc/autograd/variable.h>
 #include <torch/csrc/autograd/function.h>
 #include <torch/csrc/autograd/edge.h>
+#include <torch/csrc/autograd/autocast_mode.h>
 #include <torch/csrc/autograd/grad_mode.h>
 #include <torch/csrc/autograd/saved_variable.h>
 #include <torch/csrc/autograd/generated/Functions.h>
@@ -17,6 +18,7 @@
 #include <torch/csrc/autograd/functions/utils.h>
 
 #include <ATen/core/VariableHooksInterface.h>
+#include <c10/util/StaticTracepoint.h>
 
 #include <array>
 #include <cstddef>
@@ -42,6 +44,18 @@ namespace torch { namespace autograd {
 
 extern std::vector<std::unique_ptr<Type>> type_to_variable_type;
 
+// Hits the op_start and op_done static tracepoints (see
+// c10/util/StaticTracepoint.h) around an op.
+struct OpTracepoints {
+  explicit OpTracepoints(const char* name) : name_(name) {
+    C10_SDT(op_start, name_);
+  }
+  ~OpTracepoints() {
+    C10_SDT(op_done, name_);
+  }
+  const char* name_;
+};
+
 inline void check_inplace(const Tensor& tensor) {
   auto& var = static_cast<const Variable&>(tensor);
   if (var.requires_grad() && var.is_leaf() && GradMode::is_enabled()) {
@@ -0,0 +1,78 @@
+#include <torch/csrc/autograd/autocast_mode.h>
+
+#include <torch/csrc/autograd/variable.h>
+
+#include <unordered_map>
+
+namespace torch { namespace autograd {
+
+namespace {
+
+thread_local bool AutocastMode_enabled = false;
+
+// The number of guards enabling autocast mode on this thread
+thread_local int autocast_depth = 0;
+
+// The half copies of the parameters, by parameter
+thread_local std::unordered_map<c10::TensorImpl*, at::Tensor> cast_cache;
+
+} // namespace
+
+bool AutocastMode::is_enabled() {
+  return AutocastMode_enabled;
+}
+
+void AutocastMode::set_enabled(bool enabled) {
+  AutocastMode_enabled = enabled;
+}
+
+AutoAutocastMode::AutoAutocastMode(bool enabled)
+    : prev_mode(AutocastMode::is_enabled()), enabled(enabled) {
+  AutocastMode::set_enabled(enabled);
+  if (enabled) {
+    autocast_depth++;
+  }
+}
+
+AutoAutocastMode::~AutoAutocastMode() {
+  if (enabled && --autocast_depth == 0) {
+    autocast::clear_cache();
+  }
+  AutocastMode::set_enabled(prev_mode);
+}
+
+namespace autocast {
+
+at::Tensor cached_cast(at::ScalarType dtype, const at::Tensor& tensor) {
+  if (!tensor.defined()) {
+    return tensor;
+  }
+  bool should_cast = dtype == at::kHalf
+      ? tensor.is_cuda() && tensor.scalar_type() == at::kFloat
+      : tensor.scalar_type() == at::kHalf;
+  if (!should_cast) {
+    return tensor;
+  }
+  // The parameters are the only tensors used again by the next ops with the
+  // same values
+  bool is_parameter = dtype == at::kHalf && tensor.is_variable() &&
+      tensor.requires_grad() && as_variable_ref(tensor).is_leaf();
+  if (!is_parameter) {
+    return tensor.to(dtype);
+  }
+  auto it = cast_cache.find(tensor.unsafeGetTensorImpl());
+  if (it != cast_cache.end()) {
+    return it->second;
+  }
+  auto cast = tensor.to(dtype);
+  cast_cache.emplace(tensor.unsafeGetTensorImpl(), cast);
+  return cast;
+}
+
+void clear_cache() {
+  cast_cache.clear();
+}
+
+} // namespace autocast
+
+}}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <torch/csrc/WindowsTorchApiMacro.h>
+
+namespace torch { namespace autograd {
+
+// In autocast mode, VariableType casts the floating point inputs of the ops
+// which are faster and accurate enough in half precision (matrix products,
+// convolutions and RNN cells) to half on CUDA, and the half inputs of the ops
+// which need the range of single precision (pointwise exp and log, softmax,
+// reductions, norms and losses) to float. The lists of ops are in
+// tools/autograd/gen_variable_type.py. The casts are differentiable, so the
+// gradients of the parameters keep the type of the parameters.
+struct TORCH_API AutocastMode {
+  static bool is_enabled();
+  static void set_enabled(bool enabled);
+};
+
+// A RAII, thread local (!) guard that enables or disables autocast mode upon
+// construction, and sets it back to the original value upon destruction.
+//
+// The half copies of the parameters (leaf Variables requiring grad) are
+// cached until the outermost guard enabling autocast mode is destroyed, so a
+// forward pass which uses a parameter many times (e.g. an RNN) casts it once.
+// Parameters must not be modified inside the guard: it should only span the
+// forward pass (and the loss) of a single step.
+struct TORCH_API AutoAutocastMode {
+  AutoAutocastMode(bool enabled);
+  ~AutoAutocastMode();
+  bool prev_mode;
+  bool enabled;
+};
+
+namespace autocast {
+
+// Returns `tensor` cast to `dtype` if it is a floating point tensor that
+// autocast mode casts to `dtype` (a CUDA float tensor for half, a half tensor
+// for float), and `tensor` itself otherwise.
+TORCH_API at::Tensor cached_cast(at::ScalarType dtype, const at::Tensor& tensor);
+
+// Drops the half copies of the parameters of this thread.
+TORCH_API void clear_cache();
+
+} // namespace autocast
+
+}}
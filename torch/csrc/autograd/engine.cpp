@@ -13,6 +13,7 @@
 #include <c10/util/Exception.h>
 
 #include <atomic>
+#include <cstdlib>
 #include <condition_variable>
 #include <cstdint>
 #include <functional>
@@ -39,17 +40,23 @@ static constexpr int NO_DEVICE = -2;
 // handling reentrant backwards calls; see Note [Reentrant backwards]
 static thread_local int worker_device = NO_DEVICE;
 
+// The ready queue served by the current engine thread, or nullptr outside of
+// the engine's threads.  Several CPU workers share worker_device == -1, so
+// this (and not the device) identifies the thread that owns a GraphTask.
+static thread_local ReadyQueue* worker_queue = nullptr;
+
 // This variable is true if ALL invocations in the stack of re-entrant engine
 // invocations are imperative backwards. This special variable is needed for the
 // gradient checkpointing feature only.
 static thread_local bool checkpoint_valid = true;
 
 // XXX: Changes to the way multithreading works in execute should be done with
-// great care. Right now the implementation guarantees that a single function's
-// apply will never be entered concurrently (even if multiple graphs are
-// executed at the same time). Adding multiple threads per-device or removing
-// engine thread affinity to the device can break this invariant, and we depend
-// on it in a few places (e.g. AccumulateGrad function).
+// great care. With a single CPU worker (the default) the implementation
+// guarantees that a single function's apply will never be entered concurrently
+// (even if multiple graphs are executed at the same time). When more CPU
+// workers are enabled (see PYTORCH_AUTOGRAD_CPU_WORKERS), a function is still
+// run at most once per GraphTask, but graphs executed at the same time may
+// share functions; AccumulateGrad takes a lock for that reason.
 
 struct FunctionTask {
   GraphTask* base;
@@ -79,13 +86,33 @@ struct CompareFunctionTaskTime {
   }
 };
 
+// A multi-producer, single-consumer queue of tasks for one engine thread.
+//
+// Producers push onto a lock-free stack; the consumer moves everything pushed
+// so far into a heap ordered by sequence number, which only it touches.  The
+// mutex and condition variable are only used to put the consumer to sleep
+// when there is no work, and producers only take the mutex when it is asleep.
 struct ReadyQueue {
+  struct Node {
+    FunctionTask task;
+    Node* next;
+  };
+
   std::priority_queue<FunctionTask, std::vector<FunctionTask>, CompareFunctionTaskTime> heap;
+  std::atomic<Node*> inbox{nullptr};
+  std::atomic<bool> sleeping{false};
   std::condition_variable not_empty;
   std::mutex mutex;
 
   void push(FunctionTask item);
   FunctionTask pop();
+  // Whether the consumer is waiting for work.
+  bool idle() const {
+    return sleeping.load();
+  }
+
+ private:
+  void drain();
 };
 
 // Note [Reentrant backwards]
@@ -110,7 +137,7 @@ struct ReadyQueue {
 //
 // Here's our cunning idea: instead of blocking, just get back to work
 // on whatever task queue you should have been working on previously
-// (this is saved via the thread local variable worker_device)!  There are
+// (this is saved via the thread local variable worker_queue)!  There are
 // "simply" two things you have to arrange for:
 //
 //  - We have to promptly kick ourselves out of the thread_main() loop
@@ -166,9 +193,10 @@ struct GraphTask {
 
   void init_to_execute(Function& graph_root, const edge_list& outputs);
 
-  // The value of worker_device in the thread that created this task.
+  // The ready queue of the engine thread that created this task, or nullptr
+  // if it was created outside of the engine.
   // See Note [Reentrant backwards]
-  int owner;
+  ReadyQueue* owner;
 
   bool can_checkpoint() {
     return exec_info.empty();
@@ -179,21 +207,43 @@ struct GraphTask {
     , outstanding_tasks(0)
     , keep_graph(keep_graph)
     , grad_mode(grad_mode)
-    , owner(NO_DEVICE) {}
+    , owner(nullptr) {}
 };
 
 auto ReadyQueue::push(FunctionTask item) -> void {
-  {
-    std::lock_guard<std::mutex> lock(mutex);
-    ++item.base->outstanding_tasks;
-    heap.push(std::move(item));
+  // The task must be counted before any thread can run it
+  ++item.base->outstanding_tasks;
+  auto node = new Node{std::move(item), inbox.load()};
+  while (!inbox.compare_exchange_weak(node->next, node)) {
+  }
+  // Pairs with the store to sleeping in pop(): either the consumer sees the
+  // node before it goes to sleep, or we see that it is asleep and wake it.
+  if (sleeping.load()) {
+    { std::lock_guard<std::mutex> lock(mutex); }
+    not_empty.notify_one();
+  }
+}
+
+auto ReadyQueue::drain() -> void {
+  Node* node = inbox.exchange(nullptr);
+  while (node) {
+    heap.push(std::move(node->task));
+    Node* next = node->next;
+    delete node;
+    node = next;
   }
-  not_empty.notify_one();
 }
 
 auto ReadyQueue::pop() -> FunctionTask {
-  std::unique_lock<std::mutex> lock(mutex);
-  not_empty.wait(lock, [this]{ return !heap.empty(); });
+  drain();
+  if (heap.empty()) {
+    std::unique_lock<std::mutex> lock(mutex);
+    sleeping.store(true);
+    not_empty.wait(lock, [this]{ return inbox.load() != nullptr; });
+    sleeping.store(false);
+    lock.unlock();
+    drain();
+  }
   // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
   auto task = std::move(const_cast<FunctionTask&>(heap.top())); heap.pop();
   return task;
@@ -266,7 +316,7 @@ auto Engine::thread_init(int device) -> void {
 // It's all ok and is handled right now, but it should be accounted for
 // in case this code is to be changed.
 auto Engine::thread_main(GraphTask *graph_task) -> void {
-  auto queue = ready_queues[worker_device + 1];
+  auto queue = worker_queue;
   // Why the test on graph_task->outstanding_tasks?  See
   // Note [Reentrant backwards]
   while (!graph_task || graph_task->outstanding_tasks > 0) {
@@ -284,7 +334,7 @@ auto Engine::thread_main(GraphTask *graph_task) -> void {
     // graph (in case of reentrant execution.)  See Note [Reentrant backwards].
     auto base_owner = task.base->owner;
     // Task from a non-worker thread. Easy case.
-    if (base_owner == NO_DEVICE) {
+    if (base_owner == nullptr) {
       if (--task.base->outstanding_tasks == 0) {
         std::lock_guard<std::mutex> lock(task.base->mutex);
         task.base->not_done.notify_all();
@@ -292,17 +342,15 @@ auto Engine::thread_main(GraphTask *graph_task) -> void {
     } else {
       // If it's a task initiated from this thread, decrease the counter, but
       // don't do anything - loop condition will do all checks for us next.
-      if (base_owner == worker_device) {
+      if (base_owner == queue) {
         --task.base->outstanding_tasks;
       // Otherwise send a dummy function task to the owning thread just to
       // ensure that it's not sleeping. If it has work, it might see that
       // graph_task->outstanding_tasks == 0 before it gets to the task, but
       // it's a no-op anyway.
-      } else if (base_owner != worker_device) {
+      } else {
         if (--task.base->outstanding_tasks == 0) {
-          // Synchronize outstanding_tasks with queue mutex
-          std::atomic_thread_fence(std::memory_order_release);
-          ready_queue_by_index(base_owner).push(FunctionTask(task.base, nullptr, InputBuffer(0)));
+          base_owner->push(FunctionTask(task.base, nullptr, InputBuffer(0)));
         }
       }
     }
@@ -435,6 +483,11 @@ static variable_list call_function(FunctionTask& task) {
 }
 
 auto Engine::evaluate_function(FunctionTask& task) -> void {
+  static auto* evaluated = c10::metrics::MetricsRegistry::get().counter(
+      "torch_autograd_functions_evaluated_total",
+      "Functions evaluated by the autograd engine.");
+  evaluated->add();
+
   // If exec_info is not empty, we have to instrument the execution
   auto & exec_info = task.base->exec_info;
   if (!exec_info.empty()) {
@@ -448,9 +501,13 @@ auto Engine::evaluate_function(FunctionTask& task) -> void {
     if (!fn_info.needed) return;
   }
 
+  auto& fn = *task.fn;
+  const char* fn_type = typeid(fn).name();
+  const uint64_t sequence_nr = fn.sequence_nr();
+  C10_SDT(autograd_function_start, fn_type, sequence_nr);
   auto outputs = call_function(task);
+  C10_SDT(autograd_function_done, fn_type, sequence_nr);
 
-  auto& fn = *task.fn;
   if (!task.base->keep_graph) {
     fn.release_variables();
   }
@@ -471,6 +528,18 @@ auto Engine::evaluate_function(FunctionTask& task) -> void {
     }
   }
 
+  // The first CPU function that becomes ready stays on this worker; any
+  // further ones are independent branches and are offered to idle CPU workers.
+  bool kept_cpu_task = false;
+  auto ready_queue_for = [&](const InputBuffer& input_buffer) -> ReadyQueue& {
+    auto device = input_buffer.device();
+    if (device.type() != at::kCPU || !kept_cpu_task) {
+      kept_cpu_task |= device.type() == at::kCPU;
+      return ready_queue(device);
+    }
+    return idle_cpu_queue();
+  };
+
   std::lock_guard<std::mutex> lock(task.base->mutex);
   for (int i = 0; i < num_outputs; ++i) {
     auto& output = outputs[i];
@@ -504,7 +573,7 @@ auto Engine::evaluate_function(FunctionTask& task) -> void {
       InputBuffer input_buffer(next.function->num_inputs());
       input_buffer.add(next.input_nr, std::move(output));
       if (is_ready) {
-        auto& queue = ready_queue(input_buffer.device());
+        auto& queue = ready_queue_for(input_buffer);
         queue.push(FunctionTask(task.base, next.function, std::move(input_buffer)));
       } else {
         not_ready.emplace(next.function.get(), std::move(input_buffer));
@@ -514,7 +583,7 @@ auto Engine::evaluate_function(FunctionTask& task) -> void {
       auto &input_buffer = not_ready_it->second;
       input_buffer.add(next.input_nr, std::move(output));
       if (is_ready) {
-        auto& queue = ready_queue(input_buffer.device());
+        auto& queue = ready_queue_for(input_buffer);
         queue.push(FunctionTask(task.base, next.function, std::move(input_buffer)));
         not_ready.erase(not_ready_it);
       }
@@ -565,6 +634,12 @@ auto Engine::execute(const edge_list& roots,
                      bool create_graph,
                      const edge_list& outputs) -> variable_list {
   std::call_once(start_threads_flag, &Engine::start_threads, this);
+  static auto* backward_seconds =
+      c10::metrics::MetricsRegistry::get().histogram(
+          "torch_autograd_backward_seconds",
+          "Duration of the backward passes run by the autograd engine.",
+          {0.0001, 0.001, 0.01, 0.1, 1, 10});
+  const auto start = std::chrono::steady_clock::now();
 
   // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
   validate_outputs(roots, const_cast<variable_list&>(inputs), [](const std::string& msg) {
@@ -583,10 +658,13 @@ auto Engine::execute(const edge_list& roots,
   if (!outputs.empty()) {
     graph_task.init_to_execute(*graph_root, outputs);
   }
+  // The owner must be known before any task can finish
+  // See Note [Reentrant backwards]
+  graph_task.owner = worker_queue;
   ready_queue(at::kCPU).push(FunctionTask(&graph_task, std::move(graph_root), InputBuffer(0)));
 
   // Not a worker
-  if (worker_device == NO_DEVICE) {
+  if (worker_queue == nullptr) {
     // Wait for all tasks to complete
     graph_task.not_done.wait(lock, [&graph_task]{
       return graph_task.outstanding_tasks.load() == 0;
@@ -595,7 +673,6 @@ auto Engine::execute(const edge_list& roots,
     // Get back to work while we wait for our new graph_task to
     // complete!
     // See Note [Reentrant backwards]
-    graph_task.owner = worker_device;
     lock.unlock();
     thread_main(&graph_task);
   }
@@ -622,6 +699,9 @@ auto Engine::execute(const edge_list& roots,
     cb_lock.lock();
   }
 
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  backward_seconds->observe(elapsed.count());
   return graph_task.captured_vars;
 }
 
@@ -656,12 +736,25 @@ bool Engine::is_checkpoint_valid() {
 auto Engine::ready_queue(at::Device device) -> ReadyQueue& {
   // See Note [Allocating GPUs to autograd threads]
   if (device.type() == at::kCPU) {
-    return *ready_queues.at(0);
+    // CPU work created on a CPU worker stays on that worker
+    if (worker_device == -1) {
+      return *worker_queue;
+    }
+    return *cpu_ready_queues.at(0);
   } else {
     return *ready_queues.at(device.index() + 1);
   }
 }
 
+auto Engine::idle_cpu_queue() -> ReadyQueue& {
+  for (auto& queue : cpu_ready_queues) {
+    if (queue.get() != worker_queue && queue->idle()) {
+      return *queue;
+    }
+  }
+  return ready_queue(at::kCPU);
+}
+
 // See Note [Allocating GPUs to autograd threads]
 // NB: This would become obsolete if we truly allocated a CPU thread
 // per device, rather than colocate.
@@ -669,6 +762,19 @@ auto Engine::ready_queue_by_index(int device_index) -> ReadyQueue& {
   return *ready_queues.at(device_index + 1);
 }
 
+// Extra CPU workers are opt-in: with several of them, independent branches of
+// a backward pass run in parallel, but functions shared by graphs executed at
+// the same time are no longer serialized (see the XXX note above).
+static int num_cpu_workers() {
+  if (const char* env = std::getenv("PYTORCH_AUTOGRAD_CPU_WORKERS")) {
+    int n = std::atoi(env);
+    if (n > 0) {
+      return n;
+    }
+  }
+  return 1;
+}
+
 auto Engine::start_threads() -> void {
   // See Note [Allocating GPUs to autograd threads]
   c10::DeviceIndex num_devices = 0;
@@ -685,9 +791,24 @@ auto Engine::start_threads() -> void {
   ready_queues = std::vector<std::shared_ptr<ReadyQueue>>(num_threads);
   for (auto& queue : ready_queues)
     queue.reset(new ReadyQueue());
-  for (int i = 0; i < num_threads; ++i) {
-    std::thread t(&Engine::thread_init, this, i - 1);
+  // The first CPU worker serves ready_queues[0]; the others have their own
+  // queues, which are only reachable through cpu_ready_queues.
+  cpu_ready_queues = {ready_queues[0]};
+  for (int i = 1; i < num_cpu_workers(); ++i) {
+    cpu_ready_queues.push_back(std::make_shared<ReadyQueue>());
+  }
+  auto start = [this](std::shared_ptr<ReadyQueue> queue, int device) {
+    std::thread t([this, queue, device] {
+      worker_queue = queue.get();
+      thread_init(device);
+    });
     t.detach();
+  };
+  for (size_t i = 1; i < cpu_ready_queues.size(); ++i) {
+    start(cpu_ready_queues[i], -1);
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    start(ready_queues[i], i - 1);
   }
 }
 
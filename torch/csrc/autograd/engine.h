@@ -56,6 +56,9 @@ protected:
   void evaluate_function(FunctionTask& task);
   ReadyQueue& ready_queue(at::Device device);
   ReadyQueue& ready_queue_by_index(int device_index);
+  // The queue of an idle CPU worker other than the current thread, if any,
+  // and otherwise ready_queue(kCPU).
+  ReadyQueue& idle_cpu_queue();
   void start_threads();
   virtual void thread_init(int device);
   virtual void thread_main(GraphTask *graph_task);
@@ -63,6 +66,8 @@ protected:
 
   std::once_flag start_threads_flag;
   std::vector<std::shared_ptr<ReadyQueue>> ready_queues;
+  // The queues of the CPU workers; the first one is also ready_queues[0].
+  std::vector<std::shared_ptr<ReadyQueue>> cpu_ready_queues;
   std::vector<std::function<void()>> final_callbacks;
   std::mutex post_callbacks_lock;
 };
@@ -6,6 +6,7 @@
 #include <ATen/ATen.h>
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <stdexcept>
@@ -38,6 +39,121 @@ AnomalyMetadata* Function::metadata() noexcept {
   return anomaly_metadata_.get();
 }
 
+namespace {
+
+/*
+ * Thread local pool for the memory of Functions.
+ *
+ * Freed blocks of up to kFunctionPoolMaxBlockSize bytes are kept in free
+ * lists, one per multiple of kFunctionPoolGranularity, and handed out again
+ * by the next allocation of that size class on the same thread.  Graphs are
+ * usually built and freed on the same thread, so once a training loop reaches
+ * steady state, building the graph of an iteration reuses the memory of the
+ * graph of the previous one.
+ *
+ * Every block is a separate allocation from the heap, since Functions may be
+ * freed on a different thread than the one that created them (e.g. an
+ * engine worker thread).  For the same reason the pool of each thread holds
+ * at most kFunctionPoolMaxCachedBytes, beyond which blocks go back to the
+ * heap.
+ */
+constexpr size_t kFunctionPoolGranularity = 16;
+constexpr size_t kFunctionPoolMaxBlockSize = 512;
+constexpr size_t kFunctionPoolMaxCachedBytes = 64 << 20;
+
+struct FunctionPool {
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  FunctionPool() : free_lists{}, cached_bytes(0) {}
+
+  ~FunctionPool() {
+    for (FreeBlock* block : free_lists) {
+      while (block) {
+        FreeBlock* next = block->next;
+        ::operator delete(block);
+        block = next;
+      }
+    }
+  }
+
+  static size_t size_class(size_t size) {
+    return (std::max<size_t>(size, 1) - 1) / kFunctionPoolGranularity;
+  }
+
+  void* allocate(size_t size) {
+    const size_t cls = size_class(size);
+    FreeBlock* block = free_lists[cls];
+    if (!block) {
+      return ::operator new((cls + 1) * kFunctionPoolGranularity);
+    }
+    free_lists[cls] = block->next;
+    cached_bytes -= (cls + 1) * kFunctionPoolGranularity;
+    return block;
+  }
+
+  void deallocate(void* ptr, size_t size) {
+    const size_t cls = size_class(size);
+    const size_t block_size = (cls + 1) * kFunctionPoolGranularity;
+    if (cached_bytes + block_size > kFunctionPoolMaxCachedBytes) {
+      ::operator delete(ptr);
+      return;
+    }
+    auto* block = static_cast<FreeBlock*>(ptr);
+    block->next = free_lists[cls];
+    free_lists[cls] = block;
+    cached_bytes += block_size;
+  }
+
+  std::array<FreeBlock*, kFunctionPoolMaxBlockSize / kFunctionPoolGranularity>
+      free_lists;
+  size_t cached_bytes;
+};
+
+// Functions can be freed while thread locals are destroyed, so the pool is
+// only reached through a pointer that is reset when the pool goes away.
+thread_local FunctionPool* current_function_pool = nullptr;
+thread_local bool function_pool_destroyed = false;
+
+struct FunctionPoolHolder {
+  FunctionPoolHolder() {
+    current_function_pool = &pool;
+  }
+  ~FunctionPoolHolder() {
+    current_function_pool = nullptr;
+    function_pool_destroyed = true;
+  }
+  FunctionPool pool;
+};
+
+FunctionPool* get_function_pool() {
+  if (!current_function_pool && !function_pool_destroyed) {
+    static thread_local FunctionPoolHolder holder;
+  }
+  return current_function_pool;
+}
+
+} // namespace
+
+void* allocateFunctionMemory(size_t size) {
+  FunctionPool* pool = get_function_pool();
+  if (size > kFunctionPoolMaxBlockSize || !pool) {
+    return ::operator new(size);
+  }
+  return pool->allocate(size);
+}
+
+void deallocateFunctionMemory(void* ptr, size_t size) noexcept {
+  // Threads that never allocated a Function don't hold on to freed ones.
+  FunctionPool* pool = current_function_pool;
+  if (size > kFunctionPoolMaxBlockSize || !pool) {
+    ::operator delete(ptr);
+    return;
+  }
+  pool->deallocate(ptr, size);
+}
+
 static void gatherFunctions(
     Function* func,
     std::vector<std::shared_ptr<Function>>& stack) {
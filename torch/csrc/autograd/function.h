@@ -36,6 +36,11 @@ using IndexRange = std::pair<size_t, size_t>;
 // Custom deleter to prevent stack overflows.
 void deleteFunction(Function* function);
 
+// Memory for Functions and the control blocks of the shared_ptrs owning them,
+// from a thread local pool (see Function::operator new).
+TORCH_API void* allocateFunctionMemory(size_t size);
+TORCH_API void deallocateFunctionMemory(void* ptr, size_t size) noexcept;
+
 ///~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 ///                               Function
 ///~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -109,6 +114,24 @@ struct TORCH_API Function : std::enable_shared_from_this<Function> {
   Function& operator=(Function&& other) = delete;
   virtual ~Function() = default;
 
+  /// A `Function` is created for every differentiable op and freed with its
+  /// graph, often millions of times per iteration, so their memory comes from
+  /// a thread local pool of recently freed blocks instead of the heap.
+  static void* operator new(size_t size) {
+    return allocateFunctionMemory(size);
+  }
+
+  static void operator delete(void* ptr, size_t size) noexcept {
+    deallocateFunctionMemory(ptr, size);
+  }
+
+  // The class specific operator new hides the global placement new.
+  static void* operator new(size_t /*size*/, void* ptr) noexcept {
+    return ptr;
+  }
+
+  static void operator delete(void* /*ptr*/, void* /*place*/) noexcept {}
+
   /// Evaluates the function on the given inputs and returns the result of the
   /// function call.
   variable_list operator()(variable_list&& inputs) {
@@ -387,7 +410,50 @@ edge_list collect_next_edges(Variables&&... variables) {
   if (!GradMode::is_enabled())
     return {};
   detail::MakeNextFunctionList make;
+  // Exact unless some of the arguments are lists of variables.
+  make.next_edges.reserve(sizeof...(Variables));
   make.apply(std::forward<Variables>(variables)...);
   return std::move(make.next_edges);
 }
+
+/// An allocator for the control blocks of `shared_ptr<Function>`s, using the
+/// same pool as the `Function`s themselves.
+template <typename T>
+struct FunctionAllocator {
+  using value_type = T;
+
+  FunctionAllocator() = default;
+  template <typename U>
+  FunctionAllocator(const FunctionAllocator<U>&) noexcept {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(allocateFunctionMemory(n * sizeof(T)));
+  }
+
+  void deallocate(T* ptr, size_t n) noexcept {
+    deallocateFunctionMemory(ptr, n * sizeof(T));
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const FunctionAllocator<T>&, const FunctionAllocator<U>&) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const FunctionAllocator<T>&, const FunctionAllocator<U>&) {
+  return false;
+}
+
+/// Create a `Function` of type `T` for a new node of the autograd graph. Both
+/// the `Function` and the control block of the returned `shared_ptr` come
+/// from the `Function` pool, and it is freed with `deleteFunction`, so that
+/// deleting deep graphs doesn't overflow the stack.
+template <typename T, typename... Args>
+std::shared_ptr<T> make_function(Args&&... args) {
+  return std::shared_ptr<T>(
+      new T(std::forward<Args>(args)...),
+      deleteFunction,
+      FunctionAllocator<T>());
+}
 }} // namespace torch::autograd
@@ -4,6 +4,8 @@
 #include <torch/csrc/autograd/variable.h>
 #include <torch/csrc/WindowsTorchApiMacro.h>
 
+#include <mutex>
+
 namespace torch { namespace autograd {
 
 struct TORCH_API AccumulateGrad : public Function {
@@ -12,6 +14,11 @@ struct TORCH_API AccumulateGrad : public Function {
   variable_list apply(variable_list&& grads) override;
 
   Variable variable;
+
+ private:
+  // Graphs executed at the same time on different CPU workers may accumulate
+  // into the same variable.
+  std::mutex mutex_;
 };
 
 }} // namespace torch::autograd
@@ -0,0 +1,147 @@
+#include <torch/csrc/autograd/functions/checkpoint.h>
+
+#include <torch/csrc/autograd/engine.h>
+#include <torch/csrc/autograd/function.h>
+#include <torch/csrc/autograd/functions/utils.h>
+#include <torch/csrc/autograd/grad_mode.h>
+#include <torch/csrc/autograd/variable.h>
+
+#include <ATen/ATen.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace torch { namespace autograd {
+
+namespace {
+
+std::unique_ptr<at::Generator> copy_cpu_rng_state() {
+  auto state = at::CPU(at::kFloat).generator();
+  state->copy(at::globalContext().defaultGenerator(at::kCPU));
+  return state;
+}
+
+// Sets the state of the default CPU generator upon construction, and sets it
+// back to the original state upon destruction.
+struct CPURNGStateGuard {
+  explicit CPURNGStateGuard(const at::Generator* state) {
+    if (state) {
+      prev_state_ = copy_cpu_rng_state();
+      at::globalContext().defaultGenerator(at::kCPU).copy(*state);
+    }
+  }
+  ~CPURNGStateGuard() {
+    if (prev_state_) {
+      at::globalContext().defaultGenerator(at::kCPU).copy(*prev_state_);
+    }
+  }
+  std::unique_ptr<at::Generator> prev_state_;
+};
+
+Variable detach_like(const Variable& variable) {
+  if (!variable.defined()) {
+    return variable;
+  }
+  auto detached = variable.detach();
+  detached.set_requires_grad(variable.requires_grad());
+  return detached;
+}
+
+} // namespace
+
+CheckpointBackward::CheckpointBackward(
+    CheckpointedFunction function,
+    const variable_list& inputs,
+    bool preserve_rng_state)
+    : function_(std::move(function)) {
+  inputs_.reserve(inputs.size());
+  for (const auto& input : inputs) {
+    inputs_.emplace_back(input, /*is_output=*/false);
+  }
+  if (preserve_rng_state) {
+    cpu_rng_state_ = copy_cpu_rng_state();
+  }
+}
+
+variable_list CheckpointBackward::apply(variable_list&& grads) {
+  AT_CHECK(
+      Engine::get_default_engine().is_checkpoint_valid(),
+      "checkpoint() only supports backward(), not computing the gradients ",
+      "of some variables only");
+  AT_CHECK(function_, ERR_BACKWARD_TWICE);
+
+  variable_list inputs;
+  inputs.reserve(inputs_.size());
+  for (const auto& saved : inputs_) {
+    inputs.push_back(detach_like(saved.unpack()));
+  }
+
+  variable_list outputs;
+  {
+    CPURNGStateGuard rng_guard(cpu_rng_state_.get());
+    AutoGradMode grad_mode(/*enabled=*/true);
+    outputs = function_(inputs);
+  }
+  AT_CHECK(
+      outputs.size() == grads.size(),
+      "checkpointed function returned ", outputs.size(),
+      " outputs when recomputed, but ", grads.size(), " in the forward pass");
+
+  edge_list roots;
+  variable_list root_grads;
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    if (outputs[i].defined() && outputs[i].requires_grad() &&
+        grads[i].defined()) {
+      roots.push_back(outputs[i].gradient_edge());
+      root_grads.push_back(std::move(grads[i]));
+    }
+  }
+  if (!roots.empty()) {
+    Engine::get_default_engine().execute(
+        roots, root_grads, /*keep_graph=*/false, /*create_graph=*/false);
+  }
+
+  variable_list grad_inputs;
+  grad_inputs.reserve(inputs.size());
+  for (auto& input : inputs) {
+    grad_inputs.push_back(input.defined() ? input.grad() : Variable());
+  }
+  return grad_inputs;
+}
+
+void CheckpointBackward::release_variables() {
+  for (auto& saved : inputs_) {
+    saved.reset_data();
+  }
+  function_ = nullptr;
+}
+
+variable_list checkpoint(
+    const CheckpointedFunction& function,
+    const variable_list& inputs,
+    bool preserve_rng_state) {
+  if (!compute_requires_grad(inputs)) {
+    return function(inputs);
+  }
+
+  auto grad_fn =
+      std::make_shared<CheckpointBackward>(function, inputs, preserve_rng_state);
+  grad_fn->set_next_edges(collect_next_edges(inputs));
+
+  variable_list outputs;
+  {
+    AutoGradMode grad_mode(/*enabled=*/false);
+    outputs = function(inputs);
+    // Outputs may be inputs or views of them, whose history must stay as is.
+    for (auto& output : outputs) {
+      if (output.defined()) {
+        output = output.detach();
+      }
+    }
+  }
+  set_history(outputs, grad_fn);
+  return outputs;
+}
+
+}} // namespace torch::autograd
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/csrc/autograd/function.h>
+#include <torch/csrc/autograd/saved_variable.h>
+#include <torch/csrc/autograd/variable.h>
+
+#include <ATen/ATen.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace torch { namespace autograd {
+
+using CheckpointedFunction = std::function<variable_list(const variable_list&)>;
+
+/// Trades compute for memory by running `function` without recording the
+/// autograd graph of its body, so that none of its intermediate results are
+/// kept alive until backward. Only `inputs` are saved. When the backward pass
+/// reaches the returned outputs `function` is run again, this time with grad
+/// mode enabled, and its graph is backpropagated through right away.
+///
+/// The state of the default CPU generator is restored before `function` is
+/// re-run, so that e.g. dropout masks come out the same as in the forward
+/// pass. CUDA generators cannot be copied yet, so functions that draw CUDA
+/// random numbers are not recomputed exactly.
+///
+/// Gradients of variables that `function` uses without taking them as inputs
+/// (e.g. module parameters) are accumulated into their `grad()` during the
+/// recomputation. Because of that, checkpointed graphs only support
+/// `backward()`, not computing the gradients of some variables only.
+///
+/// If grad mode is disabled or none of `inputs` requires grad, `function` is
+/// simply called.
+TORCH_API variable_list checkpoint(
+    const CheckpointedFunction& function,
+    const variable_list& inputs,
+    bool preserve_rng_state = true);
+
+struct TORCH_API CheckpointBackward : public Function {
+  CheckpointBackward(
+      CheckpointedFunction function,
+      const variable_list& inputs,
+      bool preserve_rng_state);
+
+  variable_list apply(variable_list&& grads) override;
+  void release_variables() override;
+
+  CheckpointedFunction function_;
+  std::vector<SavedVariable> inputs_;
+  std::unique_ptr<at::Generator> cpu_rng_state_;
+};
+
+}} // namespace torch::autograd
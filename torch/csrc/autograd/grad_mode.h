@@ -1,5 +1,6 @@
 #pragma once
 
+#include <ATen/core/LegacyTypeDispatch.h>
 #include <torch/csrc/WindowsTorchApiMacro.h>
 
 namespace torch { namespace autograd {
@@ -21,4 +22,33 @@ struct TORCH_API AutoGradMode {
   bool prev_mode;
 };
 
+struct TORCH_API InferenceMode {
+  static bool is_enabled();
+  static void set_enabled(bool enabled);
+};
+
+// A RAII, thread local (!) guard for code that will never run backward, which
+// enables inference mode upon construction and sets it back to the original
+// value upon destruction. On top of disabling grad mode, ops dispatch straight
+// to the ATen kernels instead of going through VariableType, and the torch::
+// factory functions return plain tensors instead of Variables, so no autograd
+// metadata is allocated and no version counters are bumped.
+//
+// All tensors given to ops inside the guard must be plain tensors, e.g. the
+// ones created inside it or the `data()` of a Variable.
+struct TORCH_API AutoInferenceMode {
+  AutoInferenceMode()
+      : prev_mode(InferenceMode::is_enabled()),
+        grad_mode(/*enabled=*/false),
+        non_variable_type_mode(/*enabled=*/true) {
+    InferenceMode::set_enabled(true);
+  }
+  ~AutoInferenceMode() {
+    InferenceMode::set_enabled(prev_mode);
+  }
+  bool prev_mode;
+  AutoGradMode grad_mode;
+  at::AutoNonVariableTypeMode non_variable_type_mode;
+};
+
 }}
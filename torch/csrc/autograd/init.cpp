@@ -4,6 +4,7 @@
 #include <torch/csrc/utils/pybind.h>
 #include <torch/csrc/autograd/grad_mode.h>
 #include <torch/csrc/autograd/profiler.h>
+#include <torch/csrc/autograd/sampling_profiler.h>
 #include <torch/csrc/autograd/python_function.h>
 #include <torch/csrc/autograd/function.h>
 
@@ -36,7 +37,8 @@ PyObject* THPAutograd_initExtension(PyObject* _unused) {
       .value("NVTX", ProfilerState::NVTX);
 
   py::class_<ProfilerConfig>(m, "ProfilerConfig")
-      .def(py::init<ProfilerState, bool>());
+      .def(py::init<ProfilerState, bool>())
+      .def(py::init<ProfilerState, bool, bool>());
 
   py::class_<Event>(m, "ProfilerEvent")
       .def("kind", &Event::kind)
@@ -46,14 +48,37 @@ PyObject* THPAutograd_initExtension(PyObject* _unused) {
       .def("cpu_elapsed_us", &Event::cpu_elapsed_us)
       .def("cuda_elapsed_us", &Event::cuda_elapsed_us)
       .def("has_cuda", &Event::has_cuda)
-      .def("shapes", &Event::shapes);
+      .def("shapes", &Event::shapes)
+      .def("dtypes", &Event::dtypes)
+      .def("alloc_size", &Event::alloc_size);
+
+  py::class_<OpShapeStats>(m, "OpShapeStats")
+      .def_readonly("name", &OpShapeStats::name)
+      .def_readonly("shapes", &OpShapeStats::shapes)
+      .def_readonly("dtypes", &OpShapeStats::dtypes)
+      .def_readonly("count", &OpShapeStats::count)
+      .def_readonly("cpu_time_us", &OpShapeStats::cpu_time_us)
+      .def_readonly("allocated_bytes", &OpShapeStats::allocated_bytes)
+      .def_readonly("freed_bytes", &OpShapeStats::freed_bytes);
 
   m.def("_enable_profiler", enableProfiler);
   m.def("_disable_profiler", disableProfiler);
+  m.def("_aggregate_by_input_shapes", aggregateByInputShapes);
 
   m.def("_push_range", [](std::string name) { pushRange(std::move(name)); });
   m.def("_pop_range", []() { popRange(); });
 
+  py::class_<SampledOpStats>(m, "SampledOpStats")
+      .def_readonly("name", &SampledOpStats::name)
+      .def_readonly("count", &SampledOpStats::count)
+      .def_readonly("total_ns", &SampledOpStats::total_ns)
+      .def_readonly("buckets", &SampledOpStats::buckets);
+
+  m.def("_enable_sampling_profiler", enableSamplingProfiler);
+  m.def("_disable_sampling_profiler", disableSamplingProfiler);
+  m.def("_is_sampling_profiler_enabled", isSamplingProfilerEnabled);
+  m.def("_scrape_sampled_ops", scrapeSampledOps);
+
   Py_RETURN_TRUE;
 }
 
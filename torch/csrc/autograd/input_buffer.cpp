@@ -1,5 +1,7 @@
 #include <torch/csrc/autograd/input_buffer.h>
 
+#include <torch/csrc/autograd/grad_mode.h>
+
 #include <ATen/DeviceGuard.h>
 
 #include <cstddef>
@@ -9,6 +11,20 @@
 namespace torch { namespace autograd {
 
 
+namespace {
+// Whether var can be accumulated into in place, i.e. whether nobody else can
+// observe the change: only the buffer references var and its storage, it
+// already has the shape and type of the sum, and no graph of the
+// accumulation is needed for a higher order derivative.
+bool can_accumulate_into(const Variable& var, const Variable& other) {
+  return !GradMode::is_enabled() && var.layout() == at::kStrided &&
+      other.layout() == at::kStrided && !var.requires_grad() &&
+      var.use_count() == 1 && var.has_storage() &&
+      var.storage().use_count() == 1 && var.type() == other.type() &&
+      var.sizes() == other.sizes();
+}
+} // namespace
+
 void InputBuffer::add(size_t pos, Variable var) {
   AT_ASSERT(pos < buffer.size());
   if (!var.defined()) {
@@ -19,9 +35,16 @@ void InputBuffer::add(size_t pos, Variable var) {
     buffer[pos] = std::move(var);
   } else {
     at::OptionalDeviceGuard device_guard(device_of(var));
-    // ATen doesn't route sparse additions correctly...
-    // do dense + sparse in-place if possible
-    if (old_var.is_sparse()) {
+    // Functions with many consumers get a gradient from each of them. Once
+    // the buffer owns the sum, the following gradients are added to it in
+    // place, so that each input allocates at most one sum.
+    if (can_accumulate_into(old_var, var)) {
+      old_var.add_(var);
+    } else if (can_accumulate_into(var, old_var)) {
+      buffer[pos] = var.add_(old_var);
+    } else if (old_var.is_sparse()) {
+      // ATen doesn't route sparse additions correctly...
+      // do dense + sparse in-place if possible
 //storage use_count is a big hammer, but for anything lighter there's an adversarial example with unexpected inplace modification
       if (!var.is_sparse() && var.is_contiguous() && var.storage().use_count() == 1) {
           buffer[pos] = var.add_(old_var);
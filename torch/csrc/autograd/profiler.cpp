@@ -1,11 +1,16 @@
 #include <torch/csrc/autograd/profiler.h>
 #include <torch/csrc/jit/code_template.h>
 
+#include <algorithm>
 #include <fstream>
 #include <list>
+#include <map>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace torch { namespace autograd { namespace profiler {
@@ -56,7 +61,8 @@ void pushRangeImpl(
     const StringView& name,
     const char* msg = "",
     int64_t sequence_nr = -1,
-    std::vector<std::vector<int64_t>>&& shapes = {}) {
+    std::vector<std::vector<int64_t>>&& shapes = {},
+    std::vector<std::string>&& dtypes = {}) {
   if (state == ProfilerState::Disabled) {
     return;
   }
@@ -74,7 +80,8 @@ void pushRangeImpl(
         name,
         thread_id,
         state == ProfilerState::CUDA,
-        std::move(shapes));
+        std::move(shapes),
+        std::move(dtypes));
   }
 }
 
@@ -97,6 +104,15 @@ void popRange() {
   }
 }
 
+static void recordMemoryEvent(void* /* ptr */, int64_t nbytes, c10::Device device) {
+  if (state == ProfilerState::Disabled || state == ProfilerState::NVTX) {
+    return;
+  }
+  getEventList()
+      .record(EventKind::MemoryAlloc, StringView(""), thread_id, false)
+      .updateMemoryStats(nbytes, device);
+}
+
 void enableProfiler(ProfilerConfig config) {
   ProfilerState new_state = config.state;
   AT_ASSERT(new_state != ProfilerState::Disabled);
@@ -111,20 +127,30 @@ void enableProfiler(ProfilerConfig config) {
         auto* msg = (fn.seqNr() >= 0) ? ", seq = " : "";
         if (config.report_input_shapes) {
           std::vector<std::vector<int64_t>> inputSizes;
+          std::vector<std::string> inputTypes;
           inputSizes.reserve(fn.inputs().size());
+          inputTypes.reserve(fn.inputs().size());
           for (const c10::IValue& input : fn.inputs()) {
             if (!input.isTensor()) {
               inputSizes.emplace_back();
+              inputTypes.emplace_back();
               continue;
             }
             const at::Tensor& tensor = input.toTensor();
             if (tensor.defined()) {
               inputSizes.push_back(input.toTensor().sizes().vec());
+              inputTypes.emplace_back(c10::toString(tensor.scalar_type()));
             } else {
               inputSizes.emplace_back();
+              inputTypes.emplace_back();
             }
           }
-          pushRangeImpl(fn.name(), msg, fn.seqNr(), std::move(inputSizes));
+          pushRangeImpl(
+              fn.name(),
+              msg,
+              fn.seqNr(),
+              std::move(inputSizes),
+              std::move(inputTypes));
         } else {
           pushRangeImpl(fn.name(), msg, fn.seqNr(), {});
         }
@@ -151,6 +177,9 @@ void enableProfiler(ProfilerConfig config) {
     });
   }
   mark("__start_profile", false);
+  if (config.profile_memory && state != ProfilerState::NVTX) {
+    c10::SetMemoryEventHook(recordMemoryEvent);
+  }
 }
 
 thread_event_lists disableProfiler() {
@@ -160,6 +189,9 @@ thread_event_lists disableProfiler() {
   ProfilerState old_state = state;
   mark("__stop_profile");
 
+  if (c10::GetMemoryEventHook() == recordMemoryEvent) {
+    c10::SetMemoryEventHook(nullptr);
+  }
   popCallback();
   state = ProfilerState::Disabled;
 
@@ -184,6 +216,59 @@ thread_event_lists disableProfiler() {
   }
 }
 
+std::vector<OpShapeStats> aggregateByInputShapes(
+    const thread_event_lists& event_lists) {
+  using Key = std::tuple<
+      std::string,
+      std::vector<std::vector<int64_t>>,
+      std::vector<std::string>>;
+  std::map<Key, OpShapeStats> groups;
+  for (const auto& events : event_lists) {
+    // ranges are pushed and popped on the thread that recorded them, and
+    // memory events are charged to every range open on their thread
+    std::vector<std::pair<const Event*, OpShapeStats>> stack;
+    for (const Event& e : events) {
+      if (e.kind() == "push") {
+        stack.emplace_back(&e, OpShapeStats());
+      } else if (e.kind() == "memory_alloc") {
+        for (auto& open : stack) {
+          if (e.alloc_size() > 0) {
+            open.second.allocated_bytes += e.alloc_size();
+          } else {
+            open.second.freed_bytes -= e.alloc_size();
+          }
+        }
+      } else if (e.kind() == "pop" && !stack.empty()) {
+        const Event* start = stack.back().first;
+        const OpShapeStats& range = stack.back().second;
+        auto& group = groups[Key(start->name(), start->shapes(), start->dtypes())];
+        if (group.count == 0) {
+          group.name = start->name();
+          group.shapes = start->shapes();
+          group.dtypes = start->dtypes();
+        }
+        group.count++;
+        group.cpu_time_us += start->cpu_elapsed_us(e);
+        group.allocated_bytes += range.allocated_bytes;
+        group.freed_bytes += range.freed_bytes;
+        stack.pop_back();
+      }
+    }
+  }
+  std::vector<OpShapeStats> result;
+  result.reserve(groups.size());
+  for (auto& group : groups) {
+    result.push_back(std::move(group.second));
+  }
+  std::stable_sort(
+      result.begin(),
+      result.end(),
+      [](const OpShapeStats& a, const OpShapeStats& b) {
+        return a.cpu_time_us > b.cpu_time_us;
+      });
+  return result;
+}
+
 void Event::record(bool record_cuda) {
   if (record_cuda) {
     cuda_stubs->record(&device_, &event, &cpu_ns_);
@@ -192,7 +277,7 @@ void Event::record(bool record_cuda) {
   cpu_ns_ = getTime();
 }
 
-double Event::cuda_elapsed_us(const Event & e) {
+double Event::cuda_elapsed_us(const Event & e) const {
   if(!e.has_cuda() || !has_cuda()) {
     throw std::logic_error("Events were not recorded for CUDA");
   }
@@ -212,70 +297,188 @@ static jit::CodeTemplate event_template(R"(
   "ts": ${ts},
   "dur": ${dur},
   "tid": ${tid},
-  "pid": "CPU Functions",
-  "args": {}
+  "pid": "${pid}",
+  "args": {${args}}
+})");
+
+static jit::CodeTemplate thread_name_template(R"(
+{
+  "name": "thread_name",
+  "ph": "M",
+  "tid": ${tid},
+  "pid": "${pid}",
+  "args": {"name": "${name}"}
+})");
+
+static jit::CodeTemplate counter_template(R"(
+{
+  "name": "${name}",
+  "ph": "C",
+  "ts": ${ts},
+  "pid": "Memory",
+  "args": {"bytes": ${bytes}}
 })");
 
 
 RecordProfile::RecordProfile(std::ostream& out)
 : out_(out) {
-  init();
+  init(ProfilerConfig(ProfilerState::CPU, false /* report shapes */));
 }
 
 RecordProfile::RecordProfile(const std::string& filename)
 : file_(new std::ofstream(filename)), out_(*file_) {
-  init();
+  init(ProfilerConfig(ProfilerState::CPU, false /* report shapes */));
 }
 
-void RecordProfile::init() {
-  enableProfiler(ProfilerConfig(ProfilerState::CPU, false /* report shapes */));
+RecordProfile::RecordProfile(std::ostream& out, ProfilerConfig config)
+: out_(out) {
+  init(config);
+}
+
+RecordProfile::RecordProfile(const std::string& filename, ProfilerConfig config)
+: file_(new std::ofstream(filename)), out_(*file_) {
+  init(config);
+}
+
+void RecordProfile::init(ProfilerConfig config) {
+  AT_CHECK(
+      config.state == ProfilerState::CPU || config.state == ProfilerState::CUDA,
+      "RecordProfile only supports CPU and CUDA profiling");
+  enableProfiler(config);
 }
 
 RecordProfile::~RecordProfile() {
   thread_event_lists event_lists = disableProfiler();
-  std::vector<Event*> events;
-  for(auto& l : event_lists) {
-    for(auto& e : l) {
-        events.push_back(&e);
-    }
-  }
-  processEvents(events);
+  processEvents(event_lists);
   if (file_){
     file_->close();
   }
 }
 
-void RecordProfile::processEvents(const std::vector<Event*>& events) {
+static std::string formatShapes(const std::vector<std::vector<int64_t>>& shapes) {
+  std::ostringstream ss;
+  ss << "[";
+  for (size_t i = 0; i < shapes.size(); ++i) {
+    ss << (i > 0 ? ", " : "") << "[";
+    for (size_t j = 0; j < shapes[i].size(); ++j) {
+      ss << (j > 0 ? ", " : "") << shapes[i][j];
+    }
+    ss << "]";
+  }
+  ss << "]";
+  return ss.str();
+}
+
+static std::string formatTypes(const std::vector<std::string>& dtypes) {
+  std::ostringstream ss;
+  ss << "[";
+  for (size_t i = 0; i < dtypes.size(); ++i) {
+    ss << (i > 0 ? ", " : "") << dtypes[i];
+  }
+  ss << "]";
+  return ss.str();
+}
+
+void RecordProfile::processEvents(const thread_event_lists& event_lists) {
   AT_CHECK(out_, "could not open file");
-  Event* start = nullptr;
-  for (Event* e : events) {
-    if(0 == strcmp(e->name(), "__start_profile")) {
-      start = e;
-      break;
+  const Event* start = nullptr;
+  // the CUDA event each device's timings are measured from
+  std::unordered_map<int, const Event*> cuda_starts;
+  for (const auto& events : event_lists) {
+    for (const Event& e : events) {
+      if (0 == strcmp(e.name(), "__start_profile")) {
+        start = &e;
+      } else if (
+          0 == strcmp(e.name(), "__cuda_start_event") && e.has_cuda()) {
+        cuda_starts.emplace(e.device(), &e);
+      }
     }
   }
   AT_CHECK(start, "could not find start?");
-  std::vector<Event*> stack;
+
   out_ << "[\n";
   bool first = true;
-  for(Event* e : events) {
-    if(e->kind() == "push") {
-      stack.push_back(e);
-    } else if(e->kind() == "pop") {
-      if(!first) {
-        out_ << ",\n";
+  auto emit = [&](const std::string& event) {
+    if (!first) {
+      out_ << ",\n";
+    }
+    first = false;
+    out_ << event;
+  };
+
+  std::vector<const Event*> memory_events;
+  for (const auto& events : event_lists) {
+    if (events.empty()) {
+      continue;
+    }
+    const auto tid = events.front().thread_id();
+    jit::TemplateEnv thread_env;
+    thread_env.d("tid", tid);
+    thread_env.s("pid", "CPU Functions");
+    thread_env.s("name", "thread " + std::to_string(tid));
+    emit(thread_name_template.format(thread_env));
+
+    // ranges are pushed and popped on the thread that recorded them
+    std::vector<const Event*> stack;
+    for (const Event& e : events) {
+      if (e.kind() == "push") {
+        stack.push_back(&e);
+      } else if (e.kind() == "memory_alloc") {
+        memory_events.push_back(&e);
+      } else if (e.kind() == "pop" && !stack.empty()) {
+        const Event* e_start = stack.back();
+        const Event* e_end = &e;
+        stack.pop_back();
+        std::string args;
+        if (!e_start->shapes().empty()) {
+          args = "\"Input Shapes\": \"" + formatShapes(e_start->shapes()) + "\"";
+          args += ", \"Input Types\": \"" + formatTypes(e_start->dtypes()) + "\"";
+        }
+        jit::TemplateEnv env;
+        env.s("name", e_start->name());
+        env.d("ts", start->cpu_elapsed_us(*e_start));
+        env.d("dur", e_start->cpu_elapsed_us(*e_end));
+        env.d("tid", e_start->thread_id());
+        env.s("pid", "CPU Functions");
+        env.s("args", args);
+        emit(event_template.format(env));
+
+        auto cuda_start = cuda_starts.find(e_start->device());
+        if (e_start->has_cuda() && e_end->has_cuda() &&
+            cuda_start != cuda_starts.end()) {
+          const Event* c0 = cuda_start->second;
+          env.d("ts", start->cpu_elapsed_us(*c0) + c0->cuda_elapsed_us(*e_start));
+          env.d("dur", e_start->cuda_elapsed_us(*e_end));
+          env.d("tid", e_start->device());
+          env.s("pid", "CUDA Functions");
+          emit(event_template.format(env));
+        }
       }
-      first = false;
-      Event* e_start = stack.back();
-      stack.pop_back();
-      jit::TemplateEnv env;
-      env.s("name", e_start->name());
-      env.d("ts", start->cpu_elapsed_us(*e_start));
-      env.d("dur", e_start->cpu_elapsed_us(*e));
-      env.d("tid", e_start->thread_id());
-      out_ << event_template.format(env);
     }
   }
+
+  // usage is accumulated in time order across threads
+  std::sort(
+      memory_events.begin(),
+      memory_events.end(),
+      [&](const Event* a, const Event* b) {
+        return a->cpu_elapsed_us(*b) > 0;
+      });
+  std::map<std::pair<int, int>, int64_t> usage;
+  for (const Event* e : memory_events) {
+    auto key = std::make_pair(static_cast<int>(e->device_type()), e->device());
+    auto& bytes = usage[key];
+    bytes += e->alloc_size();
+    std::string name = c10::DeviceTypeName(e->device_type());
+    if (e->device() >= 0) {
+      name += ":" + std::to_string(e->device());
+    }
+    jit::TemplateEnv env;
+    env.s("name", name);
+    env.d("ts", start->cpu_elapsed_us(*e));
+    env.d("bytes", bytes);
+    emit(counter_template.format(env));
+  }
   out_ << "]\n";
 }
 
@@ -102,16 +102,25 @@ enum class TORCH_API ProfilerState {
 };
 
 struct ProfilerConfig {
-  ProfilerConfig(ProfilerState state, bool report_input_shapes)
-      : state(state), report_input_shapes(report_input_shapes) {}
+  ProfilerConfig(
+      ProfilerState state,
+      bool report_input_shapes,
+      bool profile_memory = false)
+      : state(state),
+        report_input_shapes(report_input_shapes),
+        profile_memory(profile_memory) {}
   ProfilerState state;
   bool report_input_shapes;
+  // record allocations and frees of the allocators that report them (see
+  // c10::SetMemoryEventHook)
+  bool profile_memory;
 };
 
 enum class TORCH_API EventKind : uint16_t {
   Mark,
   PushRange,
-  PopRange
+  PopRange,
+  MemoryAlloc
 };
 #ifndef _MSC_VER
 #  pragma GCC diagnostic pop
@@ -123,11 +132,13 @@ struct TORCH_API Event final {
       StringView name,
       uint16_t thread_id,
       bool record_cuda,
-      std::vector<std::vector<int64_t>>&& shapes = {})
+      std::vector<std::vector<int64_t>>&& shapes = {},
+      std::vector<std::string>&& dtypes = {})
       : name_(std::move(name)),
         kind_(kind),
         thread_id_(thread_id),
-        shapes_(shapes) {
+        shapes_(shapes),
+        dtypes_(dtypes) {
     record(record_cuda);
   }
 
@@ -137,6 +148,7 @@ struct TORCH_API Event final {
       case EventKind::Mark: return "mark";
       case EventKind::PushRange: return "push";
       case EventKind::PopRange: return "pop";
+      case EventKind::MemoryAlloc: return "memory_alloc";
     }
     throw std::runtime_error("unknown EventKind");
   }
@@ -149,16 +161,33 @@ struct TORCH_API Event final {
   std::vector<std::vector<int64_t>> shapes() const {
     return shapes_;
   }
-  double cpu_elapsed_us(const Event & e) {
+  // The scalar type of each tensor input, "" for other inputs
+  const std::vector<std::string>& dtypes() const {
+    return dtypes_;
+  }
+  double cpu_elapsed_us(const Event & e) const {
     return (e.cpu_ns_ - cpu_ns_)/(1000.0);
   }
-  double cuda_elapsed_us(const Event & e);
+  double cuda_elapsed_us(const Event & e) const;
   bool has_cuda() const {
     return event != nullptr;
   }
   int device() const {
     return device_;
   }
+  // For MemoryAlloc events: the bytes allocated (negative for frees), and
+  // the device they are on
+  void updateMemoryStats(int64_t alloc_size, c10::Device device) {
+    alloc_size_ = alloc_size;
+    device_type_ = device.type();
+    device_ = device.index();
+  }
+  int64_t alloc_size() const {
+    return alloc_size_;
+  }
+  c10::DeviceType device_type() const {
+    return device_type_;
+  }
 private:
   // signed to allow for negative intervals, initialized for safety.
   int64_t cpu_ns_ = 0;
@@ -166,8 +195,11 @@ private:
   EventKind kind_;
   uint16_t thread_id_;
   std::vector<std::vector<int64_t>> shapes_;
+  std::vector<std::string> dtypes_;
   int device_ = -1;
   struct CUevent_st* event = nullptr;
+  int64_t alloc_size_ = 0;
+  c10::DeviceType device_type_ = c10::DeviceType::CPU;
 };
 
 // a linked-list of fixed sized vectors, to avoid
@@ -195,11 +227,12 @@ struct RangeEventList {
   }
 
   template<typename... Args>
-  void record(Args&&... args) {
+  Event& record(Args&&... args) {
     if (blocks.empty() || blocks.front().size() == num_block_elements) {
       allocBlock();
     }
     blocks.front().emplace_back(std::forward<Args>(args)...);
+    return blocks.front().back();
   }
 
   std::vector<Event> consolidate() {
@@ -227,6 +260,26 @@ using thread_event_lists = std::vector<std::vector<Event>>;
 TORCH_API void enableProfiler(ProfilerConfig);
 TORCH_API thread_event_lists disableProfiler();
 
+// The ranges of one op with one set of input shapes and types, summed.
+// Times and bytes are inclusive of nested ranges; bytes are those allocated
+// and freed on the op's thread while it ran.
+struct TORCH_API OpShapeStats {
+  std::string name;
+  std::vector<std::vector<int64_t>> shapes;
+  std::vector<std::string> dtypes;
+  int64_t count = 0;
+  double cpu_time_us = 0;
+  int64_t allocated_bytes = 0;
+  int64_t freed_bytes = 0;
+};
+
+// Groups the ranges of a profile by (name, input shapes, input dtypes),
+// sorted by decreasing total CPU time. Shapes and types are only known when
+// the profile was taken with report_input_shapes, and bytes when it was
+// taken with profile_memory.
+TORCH_API std::vector<OpShapeStats> aggregateByInputShapes(
+    const thread_event_lists& event_lists);
+
 
 // Usage:
 //   {
@@ -234,16 +287,23 @@ TORCH_API thread_event_lists disableProfiler();
 //     // code you want to profile
 //   }
 // Then open filename.trace in chrome://tracing
+//
+// The trace has a track per thread with its CPU ranges. Depending on the
+// config, ranges also carry their input shapes, CUDA ranges get a track per
+// device (timed by the CUDA events of each range), and memory usage gets a
+// counter per device.
 struct TORCH_API RecordProfile {
   RecordProfile(std::ostream& out);
   RecordProfile(const std::string& filename);
+  RecordProfile(std::ostream& out, ProfilerConfig config);
+  RecordProfile(const std::string& filename, ProfilerConfig config);
 
   ~RecordProfile();
 private:
-  void init();
+  void init(ProfilerConfig config);
   std::unique_ptr<std::ofstream> file_;
   std::ostream& out_;
-  void processEvents(const std::vector<Event*>& events);
+  void processEvents(const thread_event_lists& event_lists);
 };
 
 
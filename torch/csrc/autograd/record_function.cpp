@@ -1,21 +1,55 @@
 #include <torch/csrc/autograd/record_function.h>
 #include <torch/csrc/autograd/function.h>
 
+#include <atomic>
+#include <functional>
+#include <random>
+#include <thread>
+
 namespace torch { namespace autograd { namespace profiler {
 
 namespace {
 std::vector<RecordFunctionCallback> start_callbacks;
 std::vector<RecordFunctionCallback> end_callbacks;
+std::vector<bool> is_sampled_callback;
+size_t num_sampled_callbacks = 0;
 size_t callback_needs_inputs = 0;
+std::atomic<uint32_t> sampling_period{1};
 thread_local RecordFunction* thread_local_func_ = nullptr;
+
+// Returns true for about one in sampling_period calls on this thread.  The gap
+// to the next sample is drawn uniformly from [1, 2 * period - 1], so calls in
+// a fixed pattern are not sampled in lockstep, and the calls in between only
+// cost a decrement.
+bool sampleNext() {
+  thread_local std::minstd_rand generator(
+      std::hash<std::thread::id>()(std::this_thread::get_id()));
+  thread_local int64_t countdown = 0;
+  if (--countdown > 0) {
+    return false;
+  }
+  uint32_t period = sampling_period.load(std::memory_order_relaxed);
+  countdown = period <= 1
+      ? 1
+      : 1 + static_cast<int64_t>(generator() % (2 * period - 1));
+  return true;
+}
 }
 
 void pushCallback(
     RecordFunctionCallback start,
     RecordFunctionCallback end,
-    bool needs_inputs) {
+    bool needs_inputs,
+    bool sampled) {
+  AT_CHECK(
+      !(sampled && needs_inputs),
+      "Sampled RecordFunction callbacks cannot ask for inputs");
   start_callbacks.push_back(start);
   end_callbacks.push_back(end);
+  is_sampled_callback.push_back(sampled);
+  if (sampled) {
+    ++num_sampled_callbacks;
+  }
   if (callback_needs_inputs > 0 || needs_inputs) {
     ++callback_needs_inputs;
   }
@@ -27,11 +61,24 @@ void popCallback() {
   }
   start_callbacks.pop_back();
   end_callbacks.pop_back();
+  if (is_sampled_callback.back()) {
+    --num_sampled_callbacks;
+  }
+  is_sampled_callback.pop_back();
   if (callback_needs_inputs > 0) {
     --callback_needs_inputs;
   }
 }
 
+void setSamplingPeriod(uint32_t period) {
+  AT_CHECK(period > 0, "Sampling period must be positive");
+  sampling_period = period;
+}
+
+uint32_t getSamplingPeriod() {
+  return sampling_period;
+}
+
 bool hasCallbacks() {
   return !start_callbacks.empty();
 }
@@ -41,7 +88,7 @@ bool needsInputs() {
 }
 
 void RecordFunction::before(const char* name, int64_t sequence_nr) {
-  if (!hasCallbacks()) {
+  if (!hasCallbacks() || !pickCallbacks()) {
     return;
   }
   AT_ASSERT(!initialized_);
@@ -53,7 +100,7 @@ void RecordFunction::before(const char* name, int64_t sequence_nr) {
 }
 
 void RecordFunction::before(std::string name, int64_t sequence_nr) {
-  if (!hasCallbacks()) {
+  if (!hasCallbacks() || !pickCallbacks()) {
     return;
   }
   AT_ASSERT(!initialized_);
@@ -65,7 +112,7 @@ void RecordFunction::before(std::string name, int64_t sequence_nr) {
 }
 
 void RecordFunction::before(Function* fn, int64_t sequence_nr) {
-  if (!hasCallbacks()) {
+  if (!hasCallbacks() || !pickCallbacks()) {
     return;
   }
   AT_ASSERT(!initialized_);
@@ -77,19 +124,28 @@ void RecordFunction::before(Function* fn, int64_t sequence_nr) {
   processCallbacks();
 }
 
+bool RecordFunction::pickCallbacks() {
+  sampled_ = num_sampled_callbacks > 0 && sampleNext();
+  return sampled_ || num_sampled_callbacks < start_callbacks.size();
+}
+
 void RecordFunction::processCallbacks() {
   parent_ = thread_local_func_;
   thread_local_func_ = this;
 
-  for (const auto& cb : start_callbacks) {
-    cb(*this);
+  for (size_t i = 0; i < start_callbacks.size(); ++i) {
+    if (sampled_ || !is_sampled_callback[i]) {
+      start_callbacks[i](*this);
+    }
   }
 }
 
 RecordFunction::~RecordFunction() {
   if (initialized_) {
-    for (const auto& cb : end_callbacks) {
-      cb(*this);
+    for (size_t i = 0; i < end_callbacks.size(); ++i) {
+      if (sampled_ || !is_sampled_callback[i]) {
+        end_callbacks[i](*this);
+      }
     }
     thread_local_func_ = parent_;
   }
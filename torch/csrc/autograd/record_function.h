@@ -77,7 +77,15 @@ struct TORCH_API RecordFunction {
     return parent_;
   }
 
+  // Whether the sampled callbacks run for this invocation
+  inline bool sampled() const {
+    return sampled_;
+  }
+
  private:
+  // Decides which callbacks run for this invocation; returns false when
+  // none do
+  bool pickCallbacks();
   void processCallbacks();
 
   Function* fn_ = nullptr;
@@ -87,6 +95,7 @@ struct TORCH_API RecordFunction {
   RecordFunction* parent_ = nullptr;
 
   bool initialized_ = false;
+  bool sampled_ = false;
 };
 
 TORCH_API bool hasCallbacks();
@@ -105,12 +114,21 @@ TORCH_API bool needsInputs();
 
 // WARNING: all calls to pushCallback/popCallback are not thread safe and
 // must not overlap with other code execution
+//
+// Sampled callbacks only run for about one in getSamplingPeriod()
+// invocations, chosen independently on every thread; when only sampled
+// callbacks are registered the other invocations return right after the
+// decision. Sampled callbacks cannot ask for inputs.
 using RecordFunctionCallback = std::function<void(const RecordFunction&)>;
 TORCH_API void pushCallback(
     RecordFunctionCallback start,
     RecordFunctionCallback end = [](const RecordFunction&){},
-    bool needs_inputs = false);
+    bool needs_inputs = false,
+    bool sampled = false);
 TORCH_API void popCallback();
 
+TORCH_API void setSamplingPeriod(uint32_t period);
+TORCH_API uint32_t getSamplingPeriod();
+
 } // namespace profiler
 }} // namespace torch::autograd
@@ -0,0 +1,174 @@
+#include <torch/csrc/autograd/sampling_profiler.h>
+
+#include <torch/csrc/autograd/record_function.h>
+#include <c10/util/Exception.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace torch { namespace autograd { namespace profiler {
+
+namespace {
+
+struct OpSlot {
+  explicit OpSlot(std::string name) : name(std::move(name)) {
+    for (auto& bucket : buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  // Only the owning thread writes the counters, so they are updated with a
+  // plain load and store rather than a read-modify-write.
+  static void add(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(
+        counter.load(std::memory_order_relaxed) + value,
+        std::memory_order_relaxed);
+  }
+
+  void record(uint64_t ns) {
+    size_t bucket = 0;
+    while ((ns >> (bucket + 1)) != 0 &&
+           bucket + 1 < SampledOpStats::kNumBuckets) {
+      ++bucket;
+    }
+    add(count, 1);
+    add(total_ns, ns);
+    add(buckets[bucket], 1);
+  }
+
+  const std::string name;
+  std::atomic<uint64_t> count{0};
+  std::atomic<uint64_t> total_ns{0};
+  std::array<std::atomic<uint64_t>, SampledOpStats::kNumBuckets> buckets;
+};
+
+// The samples of one thread. Slots are appended in chunks that never move,
+// and are published through `size`, so readers only need an acquire load.
+struct ThreadBuffer {
+  static constexpr size_t kChunkSize = 64;
+  static constexpr size_t kMaxChunks = 64;
+
+  OpSlot* slot(const char* name) {
+    auto it = index.find(name);
+    if (it != index.end()) {
+      return it->second;
+    }
+    size_t n = size.load(std::memory_order_relaxed);
+    if (n == kChunkSize * kMaxChunks) {
+      return nullptr;
+    }
+    auto& chunk = chunks[n / kChunkSize];
+    if (!chunk) {
+      chunk.reset(new std::unique_ptr<OpSlot>[kChunkSize]);
+    }
+    auto& slot = chunk[n % kChunkSize];
+    slot.reset(new OpSlot(name));
+    index.emplace(slot->name, slot.get());
+    size.store(n + 1, std::memory_order_release);
+    return slot.get();
+  }
+
+  const OpSlot& at(size_t i) const {
+    return *chunks[i / kChunkSize][i % kChunkSize];
+  }
+
+  std::array<std::unique_ptr<std::unique_ptr<OpSlot>[]>, kMaxChunks> chunks;
+  std::atomic<size_t> size{0};
+  // only used by the owning thread
+  std::unordered_map<std::string, OpSlot*> index;
+  std::vector<std::pair<const RecordFunction*, std::chrono::steady_clock::time_point>>
+      open_ranges;
+};
+
+std::mutex buffers_mutex;
+// Buffers are kept after their threads exit, so their samples are still
+// scraped.
+std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+bool enabled = false;
+
+ThreadBuffer& threadBuffer() {
+  thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+    auto buffer = std::make_shared<ThreadBuffer>();
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    buffers.push_back(buffer);
+    return buffer;
+  }();
+  return *buffer;
+}
+
+void onStart(const RecordFunction& fn) {
+  threadBuffer().open_ranges.emplace_back(
+      &fn, std::chrono::steady_clock::now());
+}
+
+void onEnd(const RecordFunction& fn) {
+  auto end = std::chrono::steady_clock::now();
+  auto& buffer = threadBuffer();
+  auto& open_ranges = buffer.open_ranges;
+  // Ranges are closed in reverse order; anything above `fn` was opened
+  // before the profiler was re-enabled and will never be closed.
+  while (!open_ranges.empty() && open_ranges.back().first != &fn) {
+    open_ranges.pop_back();
+  }
+  if (open_ranges.empty()) {
+    return;
+  }
+  auto start = open_ranges.back().second;
+  open_ranges.pop_back();
+  if (auto slot = buffer.slot(fn.name().str())) {
+    slot->record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     end - start)
+                     .count());
+  }
+}
+
+} // namespace
+
+void enableSamplingProfiler(uint32_t period) {
+  AT_CHECK(!enabled, "The sampling profiler is already enabled");
+  setSamplingPeriod(period);
+  pushCallback(onStart, onEnd, /*needs_inputs=*/false, /*sampled=*/true);
+  enabled = true;
+}
+
+void disableSamplingProfiler() {
+  AT_CHECK(enabled, "The sampling profiler is not enabled");
+  popCallback();
+  enabled = false;
+}
+
+bool isSamplingProfilerEnabled() {
+  return enabled;
+}
+
+std::vector<SampledOpStats> scrapeSampledOps() {
+  std::map<std::string, SampledOpStats> totals;
+  std::lock_guard<std::mutex> lock(buffers_mutex);
+  for (const auto& buffer : buffers) {
+    size_t n = buffer->size.load(std::memory_order_acquire);
+    for (size_t i = 0; i < n; ++i) {
+      const auto& slot = buffer->at(i);
+      auto& stats = totals[slot.name];
+      stats.name = slot.name;
+      stats.count += slot.count.load(std::memory_order_relaxed);
+      stats.total_ns += slot.total_ns.load(std::memory_order_relaxed);
+      for (size_t b = 0; b < SampledOpStats::kNumBuckets; ++b) {
+        stats.buckets[b] += slot.buckets[b].load(std::memory_order_relaxed);
+      }
+    }
+  }
+  std::vector<SampledOpStats> result;
+  result.reserve(totals.size());
+  for (auto& entry : totals) {
+    result.push_back(std::move(entry.second));
+  }
+  return result;
+}
+
+}}} // namespace torch::autograd::profiler
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace torch { namespace autograd { namespace profiler {
+
+// Latency statistics of one op, as collected by the sampling profiler.
+struct TORCH_API SampledOpStats {
+  static constexpr size_t kNumBuckets = 32;
+
+  std::string name;
+  uint64_t count = 0;
+  uint64_t total_ns = 0;
+  // buckets[i] counts the samples that took [2^i, 2^(i+1)) nanoseconds; the
+  // first and last buckets also hold faster and slower samples
+  std::array<uint64_t, kNumBuckets> buckets{};
+};
+
+// A profiler cheap enough to leave on in production.
+//
+// Registers sampled RecordFunction callbacks (see pushCallback), so only about
+// one in `period` op invocations is timed. Each thread aggregates its samples
+// into a buffer that only it writes, which scrapeSampledOps() reads without
+// stopping it.
+//
+// Enabling and disabling push and pop a RecordFunction callback, and have
+// the same restrictions as pushCallback/popCallback.
+TORCH_API void enableSamplingProfiler(uint32_t period);
+TORCH_API void disableSamplingProfiler();
+TORCH_API bool isSamplingProfilerEnabled();
+
+// Totals over all threads since the profiler was first enabled, sorted by
+// name. Counts only grow, so periodic scrapers should report differences.
+TORCH_API std::vector<SampledOpStats> scrapeSampledOps();
+
+}}} // namespace torch::autograd::profiler
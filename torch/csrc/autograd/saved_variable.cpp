@@ -14,6 +14,23 @@
 
 namespace torch { namespace autograd {
 
+namespace {
+thread_local SavedVariableHooks* saved_variable_hooks = nullptr;
+} // namespace
+
+SavedVariableHooks* get_saved_variable_hooks() {
+  return saved_variable_hooks;
+}
+
+SavedVariableHooksGuard::SavedVariableHooksGuard(SavedVariableHooks* hooks)
+    : prev_hooks_(saved_variable_hooks) {
+  saved_variable_hooks = hooks;
+}
+
+SavedVariableHooksGuard::~SavedVariableHooksGuard() {
+  saved_variable_hooks = prev_hooks_;
+}
+
 SavedVariable::SavedVariable(const Variable& variable, bool is_output) {
   if (variable.defined()) {
     was_default_constructed_ = false;
@@ -30,11 +47,17 @@ SavedVariable::SavedVariable(const Variable& variable, bool is_output) {
     }
     version_counter_ = variable.version_counter();
     saved_version_ = version_counter_.current_version();
+    if (saved_variable_hooks) {
+      packed_data_ = saved_variable_hooks->pack(data_);
+      if (packed_data_) {
+        data_.reset();
+      }
+    }
   }
 }
 
 Variable SavedVariable::unpack(std::shared_ptr<Function> saved_for) const {
-  if (!data_.defined()) {
+  if (!data_.defined() && !packed_data_) {
     if (!was_default_constructed_) {
       throw std::runtime_error(ERR_BACKWARD_TWICE);
     }
@@ -51,11 +74,13 @@ Variable SavedVariable::unpack(std::shared_ptr<Function> saved_for) const {
     grad_fn = std::move(saved_for);
   }
 
+  at::Tensor data = packed_data_ ? packed_data_->unpack() : data_;
+
   if (saved_version_ != version_counter_.current_version()) {
     std::stringstream message;
     message << "one of the variables needed for gradient computation has been "
-        "modified by an inplace operation: [" << data_.type().toString() << " "
-        << data_.sizes() << "]";
+        "modified by an inplace operation: [" << data.type().toString() << " "
+        << data.sizes() << "]";
     if (grad_fn) {
         message << ", which is output " << output_nr_
             << " of " << grad_fn->name() << ",";
@@ -80,9 +105,9 @@ Variable SavedVariable::unpack(std::shared_ptr<Function> saved_for) const {
   // in-place functions on unpacked variables.
   Variable var;
   if (grad_fn) {
-    var = make_variable(data_, Edge(std::move(grad_fn), output_nr_));
+    var = make_variable(data, Edge(std::move(grad_fn), output_nr_));
   } else {
-    var = make_variable(data_, requires_grad_);
+    var = make_variable(data, requires_grad_);
   }
   var.set_version_counter(saved_version_);
 
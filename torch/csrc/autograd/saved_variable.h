@@ -14,6 +14,40 @@ struct Function;
 
 TORCH_API extern const char* ERR_BACKWARD_TWICE;
 
+/// The data of a saved variable after it was packed by `SavedVariableHooks`,
+/// e.g. a copy of it in host memory.
+struct TORCH_API PackedData {
+  virtual ~PackedData() = default;
+
+  /// Returns the original data. May be called more than once if the graph is
+  /// retained.
+  virtual at::Tensor unpack() = 0;
+};
+
+/// Hooks that decide where the data of variables saved for backward live in
+/// between the forward and the backward pass. They are thread local, like
+/// grad mode, and apply to the variables saved by the forward pass on this
+/// thread; the backward pass may unpack them on any thread.
+struct TORCH_API SavedVariableHooks {
+  virtual ~SavedVariableHooks() = default;
+
+  /// Called when `data` is saved for backward. Returns `nullptr` to keep
+  /// `data` itself.
+  virtual std::shared_ptr<PackedData> pack(const at::Tensor& data) = 0;
+};
+
+/// Returns the hooks of the current thread, or `nullptr` if none are set.
+TORCH_API SavedVariableHooks* get_saved_variable_hooks();
+
+/// A RAII, thread local (!) guard that sets the hooks used to pack saved
+/// variables upon construction, and sets the previous ones back upon
+/// destruction. The hooks must outlive the guard.
+struct TORCH_API SavedVariableHooksGuard {
+  explicit SavedVariableHooksGuard(SavedVariableHooks* hooks);
+  ~SavedVariableHooksGuard();
+  SavedVariableHooks* prev_hooks_;
+};
+
 /// A snapshot of a variable at a certain version. A `SavedVariable` stores
 /// enough information to reconstruct a variable from a certain point in time.
 class TORCH_API SavedVariable {
@@ -29,7 +63,8 @@ class TORCH_API SavedVariable {
   Variable unpack(std::shared_ptr<Function> saved_for = nullptr) const;
 
   void reset_data() {
-    return data_.reset();
+    data_.reset();
+    packed_data_.reset();
   }
 
   void reset_grad_function() {
@@ -38,6 +73,8 @@ class TORCH_API SavedVariable {
 
  private:
   at::Tensor data_;
+  // Set instead of data_ if the SavedVariableHooks packed it.
+  std::shared_ptr<PackedData> packed_data_;
 
   // The gradient function associated with this node. If has_grad_fn
   // is false, then this is a leaf node. Note that the grad_fn is not saved if
@@ -18,6 +18,7 @@
 #include <torch/csrc/autograd/generated/VariableType.h>
 #include <torch/csrc/utils/python_strings.h>
 #include <torch/csrc/cuda/python_comm.h>
+#include <torch/csrc/cuda/python_graph.h>
 #include <torch/csrc/autograd/generated/variable_factories.h>
 
 using namespace torch;
@@ -477,6 +478,7 @@ namespace torch { namespace cuda {
 
 void initModule(PyObject *module) {
   python::initCommMethods(module);
+  python::initGraphBindings(module);
 }
 
 }}
@@ -9,11 +9,18 @@
 
 #include <ATen/ATen.h>
 #include <ATen/cuda/CUDAContext.h>
+#include <ATen/cuda/CUDAEvent.h>
+#include <ATen/cuda/PinnedMemoryAllocator.h>
 #include <c10/cuda/CUDAGuard.h>
 #include <c10/util/Optional.h>
 #include <torch/csrc/autograd/variable.h>
 
+#include <THC/THC.h>
+
+#include <algorithm>
+#include <climits>
 #include <cstddef>
+#include <mutex>
 #include <vector>
 
 
@@ -46,6 +53,213 @@ struct unique_type_checker {
   bool unique = true;
 };
 
+namespace {
+// Large copies are split into chunks of this size, so that a device can
+// forward a chunk while it receives the next one.
+constexpr size_t kPipelineChunkBytes = 4 * 1024 * 1024;
+
+size_t nbytes(const Tensor& tensor) {
+  return tensor.numel() * tensor.element_size();
+}
+
+bool is_pinned(const Tensor& tensor) {
+  return tensor.storage().allocator() == at::cuda::getPinnedMemoryAllocator();
+}
+
+// The relative performance of the peer-to-peer link from device src to device
+// dst as reported by CUDA (lower is faster; NVLink ranks before PCIe), or -1
+// if dst can't access src directly.
+int peer_performance_rank(int64_t src, int64_t dst) {
+  static std::once_flag once;
+  static int64_t num_devices = 0;
+  static std::vector<int> ranks;
+  std::call_once(once, [] {
+    num_devices = at::cuda::device_count();
+    ranks.assign(num_devices * num_devices, -1);
+    for (int64_t i = 0; i < num_devices; ++i) {
+      for (int64_t j = 0; j < num_devices; ++j) {
+        int supported = 0;
+        int rank = 0;
+        if (i == j) {
+          ranks[i * num_devices + j] = 0;
+        } else if (
+            cudaDeviceGetP2PAttribute(
+                &supported, cudaDevP2PAttrAccessSupported, i, j) ==
+                cudaSuccess &&
+            supported &&
+            cudaDeviceGetP2PAttribute(
+                &rank, cudaDevP2PAttrPerformanceRank, i, j) == cudaSuccess) {
+          ranks[i * num_devices + j] = rank;
+        }
+      }
+    }
+    // don't leave the errors of unsupported queries to the next CUDA call
+    cudaGetLastError();
+  });
+  if (src >= num_devices || dst >= num_devices) {
+    return -1;
+  }
+  return ranks[src * num_devices + dst];
+}
+
+// The spanning tree along which to broadcast from devices[0]: every device
+// receives from the device already in the tree with the fastest link to it,
+// preferring those that forward to the fewest devices, so that on a mesh of
+// NVLinks the data is relayed over NVLink rather than fanned out of
+// devices[0] over PCIe. Devices without a peer link to any device of the tree
+// receive from devices[0].
+struct BroadcastTree {
+  // positions in devices, parents before their children
+  std::vector<size_t> order;
+  // the position of the parent of every device; unused for devices[0]
+  std::vector<size_t> parent;
+  std::vector<size_t> num_children;
+};
+
+BroadcastTree broadcast_tree(IntArrayRef devices) {
+  const size_t num_devices = devices.size();
+  BroadcastTree tree;
+  tree.order.push_back(0);
+  tree.parent.assign(num_devices, 0);
+  tree.num_children.assign(num_devices, 0);
+  std::vector<bool> in_tree(num_devices, false);
+  in_tree[0] = true;
+  for (size_t step = 1; step < num_devices; ++step) {
+    size_t best_child = num_devices;
+    size_t best_parent = 0;
+    int best_rank = INT_MAX;
+    for (size_t child = 0; child < num_devices; ++child) {
+      if (in_tree[child]) {
+        continue;
+      }
+      for (size_t parent : tree.order) {
+        const int rank = peer_performance_rank(devices[parent], devices[child]);
+        if (rank < 0) {
+          continue;
+        }
+        if (rank < best_rank ||
+            (rank == best_rank &&
+             tree.num_children[parent] < tree.num_children[best_parent])) {
+          best_child = child;
+          best_parent = parent;
+          best_rank = rank;
+        }
+      }
+    }
+    if (best_child == num_devices) {
+      best_child = std::find(in_tree.begin(), in_tree.end(), false) - in_tree.begin();
+      best_parent = 0;
+    }
+    in_tree[best_child] = true;
+    tree.order.push_back(best_child);
+    tree.parent[best_child] = best_parent;
+    ++tree.num_children[best_parent];
+  }
+  return tree;
+}
+
+// Copies the contiguous CUDA tensors[0] into the other tensors, contiguous
+// and of the same size and type, along the broadcast tree. The copies are
+// split in chunks, and a device forwards a chunk to its children as soon as
+// it has received it, so that all the links of the tree are busy at once.
+//
+// Every device receives on its current stream, which first waits for the
+// current stream of devices[0], as Tensor::copy_ does. The current stream of
+// a device that forwards then waits for its children to have read it, so
+// that the caller can overwrite or free it on that stream.
+void broadcast_pipelined(std::vector<Tensor>& tensors) {
+  const size_t num_devices = tensors.size();
+  std::vector<int64_t> devices;
+  std::vector<at::cuda::CUDAStream> streams;
+  for (const auto& tensor : tensors) {
+    devices.push_back(tensor.get_device());
+    streams.push_back(at::cuda::getCurrentCUDAStream(devices.back()));
+  }
+  const auto tree = broadcast_tree(devices);
+  const size_t bytes = nbytes(tensors[0]);
+  const size_t num_chunks =
+      std::max<size_t>(1, (bytes + kPipelineChunkBytes - 1) / kPipelineChunkBytes);
+
+  THCState* state = at::globalContext().getTHCState();
+  at::cuda::CUDAEvent source_ready;
+  source_ready.record(streams[0]);
+  for (size_t i = 1; i < num_devices; ++i) {
+    source_ready.block(streams[i]);
+    THCState_getPeerToPeerAccess(
+        state, devices[i], devices[tree.parent[i]]);
+  }
+
+  // received[i][chunk] follows the copy of chunk to the device at position i,
+  // for the devices that forward it
+  std::vector<std::vector<at::cuda::CUDAEvent>> received(num_devices);
+  for (size_t i = 1; i < num_devices; ++i) {
+    if (tree.num_children[i] > 0) {
+      received[i].resize(num_chunks);
+    }
+  }
+  at::cuda::CUDAGuard device_guard(devices[0]);
+  for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+    const size_t offset = chunk * kPipelineChunkBytes;
+    const size_t size = std::min(kPipelineChunkBytes, bytes - offset);
+    for (size_t k = 1; k < num_devices; ++k) {
+      const size_t i = tree.order[k];
+      const size_t parent = tree.parent[i];
+      if (parent != 0) {
+        received[parent][chunk].block(streams[i]);
+      }
+      device_guard.set_index(devices[i]);
+      AT_CUDA_CHECK(cudaMemcpyPeerAsync(
+          static_cast<char*>(tensors[i].data_ptr()) + offset,
+          devices[i],
+          static_cast<const char*>(tensors[parent].data_ptr()) + offset,
+          devices[parent],
+          size,
+          streams[i]));
+      if (!received[i].empty()) {
+        received[i][chunk].record(streams[i]);
+      }
+    }
+  }
+
+  for (size_t i = 1; i < num_devices; ++i) {
+    at::cuda::CUDAEvent done;
+    done.record(streams[i]);
+    done.block(streams[tree.parent[i]]);
+  }
+}
+
+// Copies the contiguous CUDA tensor src to a new tensor on device, on the
+// current stream of device rather than on that of the device of src as
+// Tensor::to does, so that the copies from one device to several others
+// run at once, each over its own link. Synchronizes the two streams like
+// Tensor::copy_. Returns src itself if it is on device, as Tensor::to does.
+Tensor copy_to_device(const Tensor& src, int64_t device) {
+  const int64_t src_device = src.get_device();
+  if (src_device == device) {
+    return src;
+  }
+  at::cuda::CUDAGuard device_guard(device);
+  auto result = at::empty(src.sizes(), src.options().device({kCUDA, device}));
+  if (src.numel() == 0) {
+    result.copy_(src, /*non_blocking=*/true);
+    return result;
+  }
+  auto src_stream = at::cuda::getCurrentCUDAStream(src_device);
+  auto stream = at::cuda::getCurrentCUDAStream(device);
+  at::cuda::CUDAEvent src_ready;
+  src_ready.record(src_stream);
+  src_ready.block(stream);
+  THCState_getPeerToPeerAccess(
+      at::globalContext().getTHCState(), device, src_device);
+  AT_CUDA_CHECK(cudaMemcpyPeerAsync(
+      result.data_ptr(), device, src.data_ptr(), src_device, nbytes(src), stream));
+  at::cuda::CUDAEvent copied;
+  copied.record(stream);
+  copied.block(src_stream);
+  return result;
+}
+} // namespace
+
 std::vector<Tensor> broadcast(const Tensor& tensor, IntArrayRef devices) {
   if (tensor.is_cuda() && tensor.get_device() != devices[0])
     throw std::runtime_error("device of broadcasted tensor must appear as the "
@@ -65,6 +279,26 @@ std::vector<Tensor> broadcast(const Tensor& tensor, IntArrayRef devices) {
 #else
   {
 #endif
+    if (!tensor.is_sparse() && (!tensor.is_cuda() || tensor.is_contiguous())) {
+      // A host tensor is copied to the first device only, and relayed from
+      // there
+      tensors.push_back(
+          tensor.is_cuda() ? tensor
+                           : tensor.to(
+                                 at::Device(kCUDA, devices[0]),
+                                 tensor.scalar_type(),
+                                 /*non_blocking=*/true,
+                                 /*copy=*/true).contiguous());
+      for (auto device : devices.slice(1)) {
+        at::cuda::CUDAGuard device_guard(device);
+        tensors.push_back(at::empty(
+            tensor.sizes(), tensor.options().device(at::Device(kCUDA, device))));
+      }
+      if (tensors.size() > 1) {
+        broadcast_pipelined(tensors);
+      }
+      return tensors;
+    }
     if (tensor.is_cuda()) {
       tensors.push_back(tensor);
     }
@@ -171,6 +405,61 @@ tensor_list2d broadcast_coalesced(TensorList tensors, IntArrayRef devices, size_
   return outputs;
 }
 
+namespace {
+void check_tensors_for_collective(const std::vector<at::Tensor>& tensors) {
+  AT_CHECK(!tensors.empty(), "expected at least one tensor");
+  for (const auto& tensor : tensors) {
+    AT_CHECK(
+        tensor.is_cuda() && !tensor.is_sparse(),
+        "expected dense CUDA tensors, but got ", tensor.type());
+    AT_CHECK(
+        tensor.type() == tensors[0].type() &&
+            tensor.sizes() == tensors[0].sizes(),
+        "expected tensors of the same type and size: ",
+        tensors[0].type(), " ", tensors[0].sizes(), " vs. ",
+        tensor.type(), " ", tensor.sizes());
+  }
+}
+} // namespace
+
+void broadcast_into(std::vector<at::Tensor>& tensors) {
+  check_tensors_for_collective(tensors);
+#ifdef USE_NCCL
+  if (nccl::is_available(tensors)) {
+    nccl::broadcast(tensors);
+    return;
+  }
+#endif
+  if (std::all_of(tensors.begin(), tensors.end(), [](const at::Tensor& t) {
+        return t.is_contiguous();
+      })) {
+    broadcast_pipelined(tensors);
+    return;
+  }
+  for (size_t i = 1; i < tensors.size(); ++i) {
+    at::cuda::CUDAGuard device_guard(tensors[i].get_device());
+    tensors[i].copy_(tensors[0], /*non_blocking=*/true);
+  }
+}
+
+void reduce_add_into(std::vector<at::Tensor>& tensors) {
+  check_tensors_for_collective(tensors);
+#ifdef USE_NCCL
+  if (nccl::is_available(tensors)) {
+    nccl::reduce(tensors, /*root=*/0);
+    return;
+  }
+#endif
+  at::cuda::CUDAGuard device_guard(tensors[0].get_device());
+  for (size_t i = 1; i < tensors.size(); ++i) {
+    tensors[0].add_(tensors[i].to(
+        tensors[0].device(),
+        tensors[0].scalar_type(),
+        /*non_blocking=*/true,
+        /*copy=*/false));
+  }
+}
+
 std::vector<at::Tensor> scatter(
     const at::Tensor& tensor,
     at::IntArrayRef devices,
@@ -210,8 +499,31 @@ std::vector<at::Tensor> scatter(
           "(expected ", device_index, ")");
       cuda_guard.reset_stream(*(*streams)[chunk]);
     }
-    chunks[chunk] = chunks[chunk].contiguous().to(
-        {at::DeviceType::CUDA, device_index}, /*non_blocking=*/true);
+    if (tensor.is_cuda() && !tensor.is_sparse()) {
+      chunks[chunk] = copy_to_device(chunks[chunk].contiguous(), device_index);
+    } else if (!tensor.is_sparse() && !is_pinned(tensor)) {
+      // The non_blocking copies of pageable memory pack their source into
+      // pinned memory before they start, so copy in chunks: the packing of a
+      // chunk overlaps the transfer of the previous one.
+      auto source = chunks[chunk].contiguous().view(-1);
+      auto result = at::empty(
+          chunks[chunk].sizes(),
+          source.options().device({at::DeviceType::CUDA, device_index}));
+      auto flat_result = result.view(-1);
+      const int64_t step = std::max<int64_t>(
+          1,
+          static_cast<int64_t>(kPipelineChunkBytes) /
+              static_cast<int64_t>(source.element_size()));
+      for (int64_t begin = 0; begin < source.numel(); begin += step) {
+        const int64_t length = std::min(step, source.numel() - begin);
+        flat_result.narrow(0, begin, length)
+            .copy_(source.narrow(0, begin, length), /*non_blocking=*/true);
+      }
+      chunks[chunk] = result;
+    } else {
+      chunks[chunk] = chunks[chunk].contiguous().to(
+          {at::DeviceType::CUDA, device_index}, /*non_blocking=*/true);
+    }
   }
   return chunks;
 }
@@ -247,6 +559,25 @@ at::Tensor gather(
   result = at::empty(expected_size, first.options().device(device));
 
   int64_t chunk_start = 0;
+  if (device.is_cpu()) {
+    // Copies to pageable memory are synchronous, so copy all the inputs to
+    // pinned memory first, at once, and unpack each of them while the later
+    // ones are still in flight
+    std::vector<at::Tensor> staged;
+    staged.reserve(tensors.size());
+    for (const auto& tensor : tensors) {
+      at::cuda::CUDAGuard device_guard(tensor.get_device());
+      staged.push_back(at::empty(
+          tensor.sizes(), result.options().pinned_memory(true)));
+      staged.back().copy_(tensor, /*non_blocking=*/true);
+    }
+    for (size_t i = 0; i < tensors.size(); ++i) {
+      at::cuda::getCurrentCUDAStream(tensors[i].get_device()).synchronize();
+      result.narrow(dim, chunk_start, tensors[i].size(dim)).copy_(staged[i]);
+      chunk_start += tensors[i].size(dim);
+    }
+    return result;
+  }
   for (const auto& tensor : tensors) {
     result.narrow(dim, chunk_start, tensor.size(dim))
         .copy_(tensor, /*non_blocking=*/true);
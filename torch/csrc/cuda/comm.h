@@ -17,6 +17,15 @@ TORCH_API std::vector<at::Tensor> broadcast(const at::Tensor& tensor, at::IntArr
 TORCH_API tensor_list2d broadcast_coalesced(at::TensorList tensors, at::IntArrayRef devices,
                                   size_t buffer_size);
 
+/// Copies `tensors[0]` into the other tensors in place, like `broadcast()`
+/// but into existing tensors. All tensors must be dense CUDA tensors of the
+/// same size and type, on distinct devices.
+TORCH_API void broadcast_into(std::vector<at::Tensor>& tensors);
+
+/// Sums `tensors` into `tensors[0]` in place. All tensors must be dense CUDA
+/// tensors of the same size and type, on distinct devices.
+TORCH_API void reduce_add_into(std::vector<at::Tensor>& tensors);
+
 TORCH_API std::vector<at::Tensor> scatter(
     const at::Tensor& tensor,
     at::IntArrayRef devices,
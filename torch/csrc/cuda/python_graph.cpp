@@ -0,0 +1,30 @@
+#include <torch/csrc/utils/pybind.h>
+#include <torch/csrc/cuda/python_graph.h>
+
+#include <ATen/cuda/CUDAGraph.h>
+
+namespace torch { namespace cuda { namespace python {
+void initGraphBindings(PyObject *module) {
+  auto m = py::cast<py::module>(module);
+  py::class_<at::cuda::CUDAGraph>(m, "_CUDAGraph")
+      .def(py::init<>())
+      .def(
+          "capture_begin",
+          &at::cuda::CUDAGraph::capture_begin,
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "capture_end",
+          &at::cuda::CUDAGraph::capture_end,
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "replay",
+          &at::cuda::CUDAGraph::replay,
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "reset",
+          &at::cuda::CUDAGraph::reset,
+          py::call_guard<py::gil_scoped_release>())
+      .def("has_graph", &at::cuda::CUDAGraph::has_graph);
+}
+
+}}} // namespace torch::cuda::python
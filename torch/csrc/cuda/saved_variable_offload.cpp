@@ -0,0 +1,142 @@
+#include <torch/csrc/cuda/saved_variable_offload.h>
+
+#include <ATen/ATen.h>
+#include <ATen/cuda/CUDAContext.h>
+#include <ATen/cuda/CUDAEvent.h>
+#include <c10/cuda/CUDACachingAllocator.h>
+#include <c10/cuda/CUDAGuard.h>
+
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace torch { namespace cuda {
+
+// The tensors offloaded by one SavedVariableOffload, in the order they were
+// saved. Shared with the offloaded tensors, which outlive the hooks.
+struct SavedVariableOffload::State {
+  explicit State(size_t prefetch_depth) : prefetch_depth(prefetch_depth) {}
+
+  // Prefetches the tensors saved right before the one at `index`.
+  void prefetch_before(size_t index);
+
+  const size_t prefetch_depth;
+  std::mutex mutex;
+  std::vector<std::weak_ptr<Offloaded>> offloaded;
+};
+
+struct SavedVariableOffload::Offloaded : public autograd::PackedData {
+  Offloaded(std::shared_ptr<State> state, size_t index, at::Device device)
+      : state(std::move(state)), index(index), device(device) {}
+
+  at::Tensor unpack() override;
+  void prefetch();
+
+  const std::shared_ptr<State> state;
+  const size_t index;
+  const at::Device device;
+
+  std::mutex mutex;
+  at::Tensor host;
+  // Recorded once the copy to host is done.
+  at::cuda::CUDAEvent offloaded;
+  // A copy back to the device that was started ahead of unpack().
+  at::Tensor prefetched;
+  at::cuda::CUDAEvent prefetch_done;
+};
+
+void SavedVariableOffload::State::prefetch_before(size_t index) {
+  std::vector<std::shared_ptr<Offloaded>> next;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = index; i > 0 && index - i < prefetch_depth; --i) {
+      if (auto offloaded_tensor = offloaded[i - 1].lock()) {
+        next.push_back(std::move(offloaded_tensor));
+      }
+    }
+  }
+  for (auto& offloaded_tensor : next) {
+    offloaded_tensor->prefetch();
+  }
+}
+
+void SavedVariableOffload::Offloaded::prefetch() {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (prefetched.defined()) {
+    return;
+  }
+  at::cuda::CUDAGuard device_guard(device);
+  auto stream = at::cuda::getStreamFromPool(/*isHighPriority=*/false, device.index());
+  at::cuda::CUDAStreamGuard stream_guard(stream);
+  offloaded.block(stream);
+  prefetched = at::empty(host.sizes(), host.options().device(device));
+  prefetched.copy_(host, /*non_blocking=*/true);
+  prefetch_done.record(stream);
+}
+
+at::Tensor SavedVariableOffload::Offloaded::unpack() {
+  at::Tensor data;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    at::cuda::CUDAGuard device_guard(device);
+    auto stream = at::cuda::getCurrentCUDAStream();
+    if (prefetched.defined()) {
+      // The prefetched tensor was allocated on the side stream, but will be
+      // used and freed on this one.
+      prefetch_done.block(stream);
+      c10::cuda::CUDACachingAllocator::recordStream(
+          prefetched.storage().data(), stream);
+      data = std::move(prefetched);
+      prefetched = at::Tensor();
+    } else {
+      offloaded.block(stream);
+      data = at::empty(host.sizes(), host.options().device(device));
+      data.copy_(host, /*non_blocking=*/true);
+    }
+  }
+  state->prefetch_before(index);
+  return data;
+}
+
+SavedVariableOffload::SavedVariableOffload(
+    int64_t min_bytes,
+    size_t prefetch_depth)
+    : min_bytes_(min_bytes), state_(std::make_shared<State>(prefetch_depth)) {}
+
+std::shared_ptr<autograd::PackedData> SavedVariableOffload::pack(
+    const at::Tensor& data) {
+  if (!data.is_cuda() || data.is_sparse() ||
+      data.numel() * static_cast<int64_t>(data.element_size()) < min_bytes_) {
+    return nullptr;
+  }
+
+  std::shared_ptr<Offloaded> offloaded_tensor;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    offloaded_tensor = std::make_shared<Offloaded>(
+        state_, state_->offloaded.size(), data.device());
+    state_->offloaded.push_back(offloaded_tensor);
+  }
+
+  at::cuda::CUDAGuard device_guard(data.device());
+  auto current_stream = at::cuda::getCurrentCUDAStream();
+  auto stream = at::cuda::getStreamFromPool(/*isHighPriority=*/false, data.get_device());
+
+  // The side stream must wait for data to be computed, and the caching
+  // allocator must not reuse its memory before the copy is done, even if the
+  // forward pass frees it right away.
+  at::cuda::CUDAEvent data_ready;
+  data_ready.record(current_stream);
+  data_ready.block(stream);
+  c10::cuda::CUDACachingAllocator::recordStream(data.storage().data(), stream);
+
+  offloaded_tensor->host = at::empty(
+      data.sizes(), data.options().device(at::kCPU).pinned_memory(true));
+  at::cuda::CUDAStreamGuard stream_guard(stream);
+  offloaded_tensor->host.copy_(data, /*non_blocking=*/true);
+  offloaded_tensor->offloaded.record(stream);
+  return offloaded_tensor;
+}
+
+}} // namespace torch::cuda
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/csrc/autograd/saved_variable.h>
+
+#include <ATen/ATen.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace torch { namespace cuda {
+
+/// `SavedVariableHooks` that copy the large CUDA tensors saved for backward
+/// to pinned host memory on a side stream, so that they do not take up device
+/// memory until backward. When backward unpacks one of them, the ones saved
+/// right before it are copied back on a side stream, as backward usually
+/// needs them next, which overlaps the copies with the backward computation.
+///
+/// Use one instance per forward pass; it may be destroyed before backward:
+///
+///   {
+///     torch::cuda::SavedVariableOffload offload;
+///     torch::autograd::SavedVariableHooksGuard guard(&offload);
+///     loss = model->forward(input);
+///   }
+///   loss.backward();
+class TORCH_API SavedVariableOffload : public autograd::SavedVariableHooks {
+ public:
+  /// Offloads tensors of at least `min_bytes` bytes, and prefetches up to
+  /// `prefetch_depth` tensors ahead of the one being unpacked.
+  explicit SavedVariableOffload(
+      int64_t min_bytes = 1 << 20,
+      size_t prefetch_depth = 2);
+
+  std::shared_ptr<autograd::PackedData> pack(const at::Tensor& data) override;
+
+ private:
+  struct Offloaded;
+  struct State;
+
+  int64_t min_bytes_;
+  std::shared_ptr<State> state_;
+};
+
+}} // namespace torch::cuda
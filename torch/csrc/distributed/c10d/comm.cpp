@@ -0,0 +1,198 @@
+#include <torch/csrc/distributed/c10d/comm.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <tuple>
+
+#include <c10/util/Exception.h>
+
+namespace c10d {
+namespace {
+
+// Every process must start the power iteration from the same matrix, so it
+// is drawn from a fixed seed instead of the global generator.
+at::Tensor initialQ(
+    int64_t rows,
+    int64_t cols,
+    const at::TensorOptions& options) {
+  auto q = at::empty({rows, cols}, options.device(at::kCPU).dtype(at::kFloat));
+  std::mt19937 generator(0);
+  std::normal_distribution<float> distribution;
+  auto data = q.data<float>();
+  for (int64_t i = 0; i < rows * cols; i++) {
+    data[i] = distribution(generator);
+  }
+  return q.to(options.device(), at::typeMetaToScalarType(options.dtype()));
+}
+
+// Orthonormalizes the columns of `matrix` in place (Gram-Schmidt).
+void orthogonalize(at::Tensor& matrix, double eps = 1e-8) {
+  const auto cols = matrix.size(1);
+  for (int64_t i = 0; i < cols; i++) {
+    auto col = matrix.select(1, i);
+    col.div_(col.norm().add_(eps));
+    for (int64_t j = i + 1; j < cols; j++) {
+      auto other = matrix.select(1, j);
+      other.sub_(col * col.dot(other));
+    }
+  }
+}
+
+} // namespace
+
+std::shared_ptr<ProcessGroup::Work> FP16CompressHook::runHook(
+    ProcessGroup& processGroup,
+    size_t bucketIndex,
+    std::vector<at::Tensor>& tensors) {
+  auto& compressed = compressed_[bucketIndex];
+  compressed.clear();
+  for (const auto& tensor : tensors) {
+    compressed.push_back(tensor.to(at::kHalf));
+  }
+  return processGroup.allreduce(compressed);
+}
+
+void FP16CompressHook::finalizeHook(
+    ProcessGroup& /* unused */,
+    size_t bucketIndex,
+    std::vector<at::Tensor>& tensors) {
+  auto& compressed = compressed_.at(bucketIndex);
+  for (size_t i = 0; i < tensors.size(); i++) {
+    tensors[i].copy_(compressed[i]);
+  }
+  compressed_.erase(bucketIndex);
+}
+
+PowerSGDHook::PowerSGDHook(int64_t rank, bool errorFeedback)
+    : rank_(rank), errorFeedback_(errorFeedback) {
+  AT_CHECK(rank_ > 0, "PowerSGDHook expects a positive rank, got ", rank_);
+}
+
+std::shared_ptr<ProcessGroup::Work> PowerSGDHook::runHook(
+    ProcessGroup& processGroup,
+    size_t bucketIndex,
+    std::vector<at::Tensor>& tensors) {
+  AT_CHECK(
+      tensors.size() == 1, "PowerSGDHook supports a single model replica");
+  auto& tensor = tensors[0];
+  auto& state = states_[bucketIndex];
+  const auto numel = tensor.numel();
+  const auto cols = static_cast<int64_t>(std::ceil(std::sqrt(numel)));
+  const auto rows = cols == 0 ? 0 : (numel + cols - 1) / cols;
+
+  const auto type = tensor.scalar_type();
+  state.compressed = (type == at::kFloat || type == at::kDouble) &&
+      std::min(rows, cols) > rank_ && (rows + cols) * rank_ < numel;
+  if (!state.compressed) {
+    state.p = {tensor};
+    return processGroup.allreduce(state.p);
+  }
+
+  // (Re-)initialize if the bucket assignment changed.
+  if (!state.matrix.defined() || state.matrix.size(0) != rows ||
+      state.matrix.size(1) != cols || state.error.numel() != numel) {
+    state.matrix = at::zeros({rows, cols}, tensor.options());
+    state.error = at::zeros({numel}, tensor.options());
+    state.p = {at::empty({rows, rank_}, tensor.options())};
+    state.q = {initialQ(cols, rank_, tensor.options())};
+  }
+
+  auto flat = state.matrix.view({-1}).narrow(0, 0, numel);
+  flat.copy_(tensor);
+  if (errorFeedback_) {
+    flat.add_(state.error);
+  }
+  at::mm_out(state.p[0], state.matrix, state.q[0]);
+  return processGroup.allreduce(state.p);
+}
+
+void PowerSGDHook::finalizeHook(
+    ProcessGroup& processGroup,
+    size_t bucketIndex,
+    std::vector<at::Tensor>& tensors) {
+  auto& state = states_.at(bucketIndex);
+  if (!state.compressed) {
+    // Reduced in place.
+    state.p.clear();
+    return;
+  }
+
+  auto& tensor = tensors[0];
+  auto& p = state.p[0];
+  orthogonalize(p);
+  at::mm_out(state.q[0], state.matrix.t(), p);
+  processGroup.allreduce(state.q)->wait();
+
+  const auto numel = tensor.numel();
+  auto approximation = p.mm(state.q[0].t()).view({-1}).narrow(0, 0, numel);
+  if (errorFeedback_) {
+    state.error.copy_(state.matrix.view({-1}).narrow(0, 0, numel));
+    state.error.sub_(approximation);
+  }
+  tensor.copy_(approximation);
+}
+
+TopKHook::TopKHook(double ratio) : ratio_(ratio) {
+  AT_CHECK(
+      ratio_ > 0 && ratio_ <= 1,
+      "TopKHook expects a ratio in (0, 1], got ",
+      ratio_);
+}
+
+std::shared_ptr<ProcessGroup::Work> TopKHook::runHook(
+    ProcessGroup& processGroup,
+    size_t bucketIndex,
+    std::vector<at::Tensor>& tensors) {
+  AT_CHECK(tensors.size() == 1, "TopKHook supports a single model replica");
+  auto& tensor = tensors[0];
+  auto& state = states_[bucketIndex];
+  const auto numel = tensor.numel();
+  if (!state.error.defined() || state.error.numel() != numel ||
+      state.error.scalar_type() != tensor.scalar_type()) {
+    state.error = at::zeros_like(tensor);
+  }
+
+  // The error now holds the compensated contents; what is selected is sent
+  // and cleared, the rest is carried over to the next iteration.
+  state.error.add_(tensor);
+  const auto k = std::min<int64_t>(
+      numel,
+      std::max<int64_t>(1, static_cast<int64_t>(std::ceil(ratio_ * numel))));
+  auto indices = std::get<1>(state.error.abs().topk(k, 0, true, false));
+  auto values = state.error.index_select(0, indices);
+  state.error.index_fill_(0, indices, 0);
+
+  const auto size = processGroup.getSize();
+  state.indices = {indices};
+  state.values = {values};
+  state.gatheredIndices = {std::vector<at::Tensor>(size)};
+  state.gatheredValues = {std::vector<at::Tensor>(size)};
+  for (int i = 0; i < size; i++) {
+    state.gatheredIndices[0][i] = at::empty_like(indices);
+    state.gatheredValues[0][i] = at::empty_like(values);
+  }
+  state.indicesWork =
+      processGroup.allgather(state.gatheredIndices, state.indices);
+  return processGroup.allgather(state.gatheredValues, state.values);
+}
+
+void TopKHook::finalizeHook(
+    ProcessGroup& /* unused */,
+    size_t bucketIndex,
+    std::vector<at::Tensor>& tensors) {
+  auto& state = states_.at(bucketIndex);
+  state.indicesWork->wait();
+  state.indicesWork.reset();
+
+  auto& tensor = tensors[0];
+  tensor.zero_();
+  for (size_t i = 0; i < state.gatheredValues[0].size(); i++) {
+    tensor.index_add_(
+        0, state.gatheredIndices[0][i], state.gatheredValues[0][i]);
+  }
+  state.gatheredIndices.clear();
+  state.gatheredValues.clear();
+}
+
+} // namespace c10d
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <ATen/ATen.h>
+#include <c10d/ProcessGroup.hpp>
+
+namespace c10d {
+
+// A communication hook replaces the allreduce that the Reducer issues for
+// the contents of a bucket, for example to compress gradients before they
+// are sent over the network.
+//
+// Both functions are called with the reducer lock held and receive the
+// flattened contents of a bucket, one tensor per model replica. The contents
+// are already divided by the size of the process group, so their sum across
+// processes is the average gradient.
+class CommHookInterface {
+ public:
+  virtual ~CommHookInterface() = default;
+
+  // Starts communicating the bucket contents. The tensors may be modified;
+  // state that must be kept alive until the work completes is owned by the
+  // hook.
+  virtual std::shared_ptr<ProcessGroup::Work> runHook(
+      ProcessGroup& processGroup,
+      size_t bucketIndex,
+      std::vector<at::Tensor>& tensors) = 0;
+
+  // Called after the work returned by runHook has completed. Must leave the
+  // (approximately) averaged gradient in `tensors`.
+  virtual void finalizeHook(
+      ProcessGroup& processGroup,
+      size_t bucketIndex,
+      std::vector<at::Tensor>& tensors) {}
+};
+
+// Reduces the bucket contents in half precision, halving the number of
+// bytes sent for fp32 gradients.
+class FP16CompressHook : public CommHookInterface {
+ public:
+  std::shared_ptr<ProcessGroup::Work> runHook(
+      ProcessGroup& processGroup,
+      size_t bucketIndex,
+      std::vector<at::Tensor>& tensors) override;
+
+  void finalizeHook(
+      ProcessGroup& processGroup,
+      size_t bucketIndex,
+      std::vector<at::Tensor>& tensors) override;
+
+ protected:
+  std::unordered_map<size_t, std::vector<at::Tensor>> compressed_;
+};
+
+// PowerSGD (Vogels et al., 2019): the bucket contents are viewed as an
+// n x m matrix M and approximated by P * Q^T with P of size n x rank and
+// Q of size m x rank, found with one step of power iteration that is warm
+// started from the previous Q. Instead of n * m elements, (n + m) * rank
+// elements are reduced, in two allreduce calls.
+//
+// With error feedback, the part of M that was not captured by the
+// approximation is added to the contents of the bucket in the next
+// iteration.
+//
+// Supports a single model replica and floating point gradients; other
+// buckets, and buckets too small to be compressed, are allreduced as is.
+class PowerSGDHook : public CommHookInterface {
+ public:
+  explicit PowerSGDHook(int64_t rank = 1, bool errorFeedback = true);
+
+  std::shared_ptr<ProcessGroup::Work> runHook(
+      ProcessGroup& processGroup,
+      size_t bucketIndex,
+      std::vector<at::Tensor>& tensors) override;
+
+  void finalizeHook(
+      ProcessGroup& processGroup,
+      size_t bucketIndex,
+      std::vector<at::Tensor>& tensors) override;
+
+ protected:
+  struct State {
+    // Compensated bucket contents, padded and viewed as an n x m matrix.
+    at::Tensor matrix;
+    at::Tensor error;
+    std::vector<at::Tensor> p;
+    std::vector<at::Tensor> q;
+    bool compressed = false;
+  };
+
+  const int64_t rank_;
+  const bool errorFeedback_;
+  std::unordered_map<size_t, State> states_;
+};
+
+// Top-k sparsification with error feedback (Stich et al., 2018): only the
+// `ratio` fraction of elements of largest magnitude is sent, as pairs of
+// indices and values gathered from every process. The elements that were
+// not sent are added to the contents of the bucket in the next iteration.
+//
+// Supports a single model replica.
+class TopKHook : public CommHookInterface {
+ public:
+  explicit TopKHook(double ratio = 0.01);
+
+  std::shared_ptr<ProcessGroup::Work> runHook(
+      ProcessGroup& processGroup,
+      size_t bucketIndex,
+      std::vector<at::Tensor>& tensors) override;
+
+  void finalizeHook(
+      ProcessGroup& processGroup,
+      size_t bucketIndex,
+      std::vector<at::Tensor>& tensors) override;
+
+ protected:
+  struct State {
+    at::Tensor error;
+    std::vector<at::Tensor> indices;
+    std::vector<at::Tensor> values;
+    std::vector<std::vector<at::Tensor>> gatheredIndices;
+    std::vector<std::vector<at::Tensor>> gatheredValues;
+    std::shared_ptr<ProcessGroup::Work> indicesWork;
+  };
+
+  const double ratio_;
+  std::unordered_map<size_t, State> states_;
+};
+
+} // namespace c10d
@@ -1,6 +1,7 @@
 #include <torch/csrc/distributed/c10d/ddp.h>
 
 #include <torch/csrc/cuda/comm.h>
+#include <torch/csrc/distributed/c10d/reducer.h>
 #include <torch/csrc/utils/tensor_flatten.h>
 
 #ifdef USE_C10D_NCCL
@@ -59,6 +60,15 @@ void distBroadcastCoalesced(
     std::vector<at::Tensor>& tensors,
     int64_t bufferSize,
     bool fineGrained) {
+  if (!fineGrained) {
+    BroadcastOptions broadcastOptions;
+    broadcastOptions.rootRank = 0;
+    broadcastOptions.rootTensor = 0;
+    broadcast_coalesced(processGroup, tensors, bufferSize, broadcastOptions)
+        ->wait();
+    return;
+  }
+
   std::vector<std::vector<at::Tensor>> bucketedTensors =
       bucketTensors(tensors, bufferSize, fineGrained);
   // We store single-element vectors in `flatTensors` because
@@ -14,12 +14,21 @@
 
 #include <c10d/PrefixStore.hpp>
 #include <c10d/TCPStore.hpp>
+
+#ifdef USE_C10D_REDIS
+#include <c10d/RedisStore.hpp>
+#endif
+
 #include <gloo/transport/tcp/device.h>
 #include <pybind11/chrono.h>
+#include <pybind11/functional.h>
 
 #include <torch/csrc/Exceptions.h>
 #include <torch/csrc/distributed/c10d/ddp.h>
 #include <torch/csrc/distributed/c10d/reducer.h>
+#include <torch/csrc/distributed/rpc/process_group_agent.h>
+#include <torch/csrc/distributed/rpc/sharded_embedding.h>
+#include <torch/csrc/jit/pybind_utils.h>
 #include <torch/csrc/utils/object_ptr.h>
 #include <torch/csrc/utils/pybind.h>
 
@@ -34,6 +43,41 @@ constexpr char* GLOO_SOCKET_IFNAME_ENV = "GLOO_SOCKET_IFNAME";
 template <typename T>
 using shared_ptr_class_ = py::class_<T, std::shared_ptr<T>>;
 
+// The result of an RpcAgent call.
+struct PyRpcFuture {
+  c10::intrusive_ptr<c10::ivalue::Future> future;
+};
+
+// Wraps a Python function as an RPC function. The function runs on the
+// threads of the agent, so the Python object is only used with the GIL.
+rpc::RpcFunction wrapPyRpcFunction(py::function fn) {
+  std::shared_ptr<py::function> function(
+      new py::function(std::move(fn)), [](py::function* f) {
+        py::gil_scoped_acquire acquire;
+        delete f;
+      });
+  return [function](std::vector<c10::IValue> args) {
+    py::gil_scoped_acquire acquire;
+    try {
+      py::tuple pyArgs(args.size());
+      for (size_t i = 0; i < args.size(); i++) {
+        pyArgs[i] = torch::jit::toPyObject(std::move(args[i]));
+      }
+      py::object result = (*function)(*pyArgs);
+      if (result.is_none()) {
+        return std::vector<c10::IValue>();
+      }
+      if (!py::isinstance<py::tuple>(result)) {
+        result = py::make_tuple(result);
+      }
+      return torch::jit::toStack(py::cast<py::tuple>(result));
+    } catch (py::error_already_set& e) {
+      // the Python error can't outlive the GIL
+      throw std::runtime_error(e.what());
+    }
+  };
+}
+
 PyObject* c10d_init(PyObject* _unused) {
   auto c10d_module = THPObjectPtr(PyImport_ImportModule("torch.distributed"));
   if (!c10d_module) {
@@ -43,10 +87,18 @@ PyObject* c10d_init(PyObject* _unused) {
   auto module = py::handle(c10d_module).cast<py::module>();
 
   shared_ptr_class_<::c10d::Reducer>(module, "Reducer")
-      .def(py::init<
-           std::vector<std::vector<torch::autograd::Variable>>,
-           std::vector<std::vector<size_t>>,
-           std::shared_ptr<::c10d::ProcessGroup>>())
+      .def(
+          py::init<
+              std::vector<std::vector<torch::autograd::Variable>>,
+              std::vector<std::vector<size_t>>,
+              std::shared_ptr<::c10d::ProcessGroup>,
+              std::vector<size_t>,
+              bool>(),
+          py::arg("replicas"),
+          py::arg("bucket_indices"),
+          py::arg("process_group"),
+          py::arg("bucket_size_limits") = std::vector<size_t>(),
+          py::arg("gradient_as_bucket_view") = false)
       .def(
           "initialize_buckets",
           &::c10d::Reducer::initialize_buckets,
@@ -60,7 +112,41 @@ PyObject* c10d_init(PyObject* _unused) {
           [](::c10d::Reducer& reducer, const torch::autograd::Variable& output)
               -> void { reducer.prepare_for_backward({output}); },
           py::call_guard<py::gil_scoped_release>())
-      .def("get_backward_stats", &::c10d::Reducer::get_backward_stats);
+      .def(
+          "register_bucket_completion_hook",
+          &::c10d::Reducer::register_bucket_completion_hook,
+          py::arg("hook"),
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "register_comm_hook",
+          &::c10d::Reducer::register_comm_hook,
+          py::arg("comm_hook"),
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "set_comm_profiling",
+          &::c10d::Reducer::set_comm_profiling,
+          py::arg("enabled"),
+          py::call_guard<py::gil_scoped_release>())
+      .def("get_backward_stats", &::c10d::Reducer::get_backward_stats)
+      .def("get_bucket_stats", &::c10d::Reducer::get_bucket_stats)
+      .def(
+          "get_exposed_comm_time", &::c10d::Reducer::get_exposed_comm_time);
+
+  auto commHook =
+      shared_ptr_class_<::c10d::CommHookInterface>(module, "CommHook");
+
+  shared_ptr_class_<::c10d::FP16CompressHook>(
+      module, "FP16CompressHook", commHook)
+      .def(py::init<>());
+
+  shared_ptr_class_<::c10d::PowerSGDHook>(module, "PowerSGDHook", commHook)
+      .def(
+          py::init<int64_t, bool>(),
+          py::arg("rank") = 1,
+          py::arg("error_feedback") = true);
+
+  shared_ptr_class_<::c10d::TopKHook>(module, "TopKHook", commHook)
+      .def(py::init<double>(), py::arg("ratio") = 0.01);
 
   py::enum_<::c10d::ReduceOp>(module, "ReduceOp", R"(
 An enum-like class of available reduce operations: ``SUM``, ``PRODUCT``,
@@ -111,6 +197,10 @@ They are used in specifying strategies for reduction collectives, e.g.,
       .def_readwrite("reduceOp", &::c10d::ReduceScatterOptions::reduceOp)
       .def_readwrite("timeout", &::c10d::ReduceScatterOptions::timeout);
 
+  py::class_<::c10d::AllToAllOptions>(module, "AllToAllOptions")
+      .def(py::init<>())
+      .def_readwrite("timeout", &::c10d::AllToAllOptions::timeout);
+
   py::class_<::c10d::BarrierOptions>(module, "BarrierOptions")
       .def(py::init<>())
       .def_readwrite("timeout", &::c10d::BarrierOptions::timeout);
@@ -141,6 +231,35 @@ They are used in specifying strategies for reduction collectives, e.g.,
               "add",
               &::c10d::Store::add,
               py::call_guard<py::gil_scoped_release>())
+          .def(
+              "multi_set",
+              [](::c10d::Store& store,
+                 const std::vector<std::string>& keys,
+                 const std::vector<std::string>& values) {
+                std::vector<std::vector<uint8_t>> values_;
+                values_.reserve(values.size());
+                for (const auto& value : values) {
+                  values_.emplace_back(value.begin(), value.end());
+                }
+                store.multiSet(keys, values_);
+              },
+              py::call_guard<py::gil_scoped_release>())
+          .def(
+              "multi_get",
+              [](::c10d::Store& store, const std::vector<std::string>& keys) {
+                std::vector<std::vector<uint8_t>> values;
+                {
+                  py::gil_scoped_release release;
+                  values = store.multiGet(keys);
+                }
+                std::vector<py::bytes> result;
+                result.reserve(values.size());
+                for (auto& value : values) {
+                  result.emplace_back(
+                      reinterpret_cast<char*>(value.data()), value.size());
+                }
+                return result;
+              })
           .def(
               "set_timeout",
               &::c10d::Store::setTimeout,
@@ -164,11 +283,26 @@ They are used in specifying strategies for reduction collectives, e.g.,
       .def(py::init<const std::string&, int>());
 
   shared_ptr_class_<::c10d::TCPStore>(module, "TCPStore", store)
-      .def(py::init<const std::string&, int, int, bool>());
+      .def(
+          py::init<const std::string&, int, int, bool, int>(),
+          py::arg("host_name"),
+          py::arg("port"),
+          py::arg("world_size"),
+          py::arg("is_master"),
+          py::arg("num_shards") = 1);
 
   shared_ptr_class_<::c10d::PrefixStore>(module, "PrefixStore", store)
       .def(py::init<const std::string&, ::c10d::Store&>());
 
+#ifdef USE_C10D_REDIS
+  shared_ptr_class_<::c10d::RedisStore>(module, "RedisStore", store)
+      .def(
+          py::init<const std::string&, int, const std::string&>(),
+          py::arg("host_name"),
+          py::arg("port"),
+          py::arg("prefix") = "");
+#endif
+
   auto processGroup =
       shared_ptr_class_<::c10d::ProcessGroup>(module, "ProcessGroup")
           .def("rank", &::c10d::ProcessGroup::getRank)
@@ -343,6 +477,16 @@ They are used in specifying strategies for reduction collectives, e.g.,
               py::arg("input_tensor"),
               py::call_guard<py::gil_scoped_release>())
 
+          .def(
+              "alltoall",
+              &::c10d::ProcessGroup::alltoall,
+              py::arg("output_tensor"),
+              py::arg("input_tensor"),
+              py::arg("output_split_sizes"),
+              py::arg("input_split_sizes"),
+              py::arg("opts") = ::c10d::AllToAllOptions(),
+              py::call_guard<py::gil_scoped_release>())
+
           .def(
               "send",
               &::c10d::ProcessGroup::send,
@@ -380,7 +524,9 @@ They are used in specifying strategies for reduction collectives, e.g.,
       .def(py::init<>())
       .def_readwrite("devices", &::c10d::ProcessGroupGloo::Options::devices)
       .def_readwrite("timeout", &::c10d::ProcessGroupGloo::Options::timeout)
-      .def_readwrite("threads", &::c10d::ProcessGroupGloo::Options::threads);
+      .def_readwrite("threads", &::c10d::ProcessGroupGloo::Options::threads)
+      .def_readwrite(
+          "minChunkBytes", &::c10d::ProcessGroupGloo::Options::minChunkBytes);
 
   processGroupGloo.def_static(
       "create_tcp_device",
@@ -449,11 +595,15 @@ They are used in specifying strategies for reduction collectives, e.g.,
               const std::shared_ptr<::c10d::Store>&,
               int,
               int,
-              const std::string&>(),
+              const std::string&,
+              int,
+              const std::chrono::milliseconds&>(),
           py::arg("store"),
           py::arg("rank"),
           py::arg("size"),
-          py::arg("groupName") = "");
+          py::arg("groupName") = "",
+          py::arg("localSize") = 0,
+          py::arg("timeout") = ::c10d::Store::kNoTimeout);
 #endif
 
 #ifdef USE_C10D_MPI
@@ -527,6 +677,33 @@ They are used in specifying strategies for reduction collectives, e.g.,
       py::call_guard<py::gil_scoped_release>());
 #endif
 
+  module.def(
+      "_allreduce_coalesced",
+      &::c10d::allreduce_coalesced,
+      py::arg("process_group"),
+      py::arg("tensors"),
+      py::arg("bucket_size"),
+      py::arg("opts") = ::c10d::AllreduceOptions(),
+      py::call_guard<py::gil_scoped_release>());
+
+  module.def(
+      "_broadcast_coalesced",
+      &::c10d::broadcast_coalesced,
+      py::arg("process_group"),
+      py::arg("tensors"),
+      py::arg("bucket_size"),
+      py::arg("opts") = ::c10d::BroadcastOptions(),
+      py::call_guard<py::gil_scoped_release>());
+
+  module.def(
+      "_reduce_coalesced",
+      &::c10d::reduce_coalesced,
+      py::arg("process_group"),
+      py::arg("tensors"),
+      py::arg("bucket_size"),
+      py::arg("opts") = ::c10d::ReduceOptions(),
+      py::call_guard<py::gil_scoped_release>());
+
   module.def(
       "_compute_bucket_assignment_by_size",
       &::c10d::compute_bucket_assignment_by_size,
@@ -534,6 +711,84 @@ They are used in specifying strategies for reduction collectives, e.g.,
       py::arg("bucket_size"),
       py::call_guard<py::gil_scoped_release>());
 
+  py::class_<PyRpcFuture>(module, "RpcFuture")
+      .def("wait", [](PyRpcFuture& self) {
+        {
+          py::gil_scoped_release release;
+          self.future->wait();
+        }
+        return torch::jit::toPyObject(self.future->value());
+      });
+
+  auto rpcAgent =
+      shared_ptr_class_<rpc::RpcAgent>(module, "RpcAgent")
+          .def_property_readonly("rank", &rpc::RpcAgent::rank)
+          .def_property_readonly("world_size", &rpc::RpcAgent::worldSize)
+          .def(
+              "register_function",
+              [](rpc::RpcAgent& agent, const std::string& name, py::function fn) {
+                agent.registerFunction(name, wrapPyRpcFunction(std::move(fn)));
+              },
+              py::arg("name"),
+              py::arg("fn"))
+          .def(
+              "call",
+              [](rpc::RpcAgent& agent,
+                 int dst,
+                 const std::string& name,
+                 py::args args) {
+                auto stack = torch::jit::toStack(args);
+                py::gil_scoped_release release;
+                return PyRpcFuture{agent.call(dst, name, std::move(stack))};
+              })
+          .def(
+              "sync",
+              &rpc::RpcAgent::sync,
+              py::call_guard<py::gil_scoped_release>())
+          .def(
+              "join",
+              &rpc::RpcAgent::join,
+              py::call_guard<py::gil_scoped_release>());
+
+  shared_ptr_class_<rpc::ProcessGroupAgent>(
+      module, "ProcessGroupAgent", rpcAgent)
+      .def(
+          py::init<std::shared_ptr<::c10d::ProcessGroup>, size_t>(),
+          py::arg("process_group"),
+          py::arg("num_threads") = 4,
+          py::call_guard<py::gil_scoped_release>());
+
+  shared_ptr_class_<rpc::ShardedEmbedding>(module, "ShardedEmbedding")
+      .def(
+          py::init<
+              std::shared_ptr<rpc::RpcAgent>,
+              std::string,
+              int64_t,
+              at::Tensor>(),
+          py::arg("agent"),
+          py::arg("name"),
+          py::arg("num_embeddings"),
+          py::arg("shard"),
+          py::call_guard<py::gil_scoped_release>())
+      .def_property_readonly(
+          "num_embeddings", &rpc::ShardedEmbedding::numEmbeddings)
+      .def_property_readonly(
+          "rows_per_shard", &rpc::ShardedEmbedding::rowsPerShard)
+      .def_property_readonly("shard", &rpc::ShardedEmbedding::shard)
+      .def("shard_size", &rpc::ShardedEmbedding::shardSize, py::arg("rank"))
+      .def(
+          "lookup",
+          &rpc::ShardedEmbedding::lookup,
+          py::arg("indices"),
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "update",
+          &rpc::ShardedEmbedding::update,
+          py::arg("indices"),
+          py::arg("grad"),
+          py::arg("lr"),
+          py::call_guard<py::gil_scoped_release>());
+
   Py_RETURN_TRUE;
 }
 
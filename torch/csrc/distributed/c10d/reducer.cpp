@@ -1,12 +1,17 @@
 #include <torch/csrc/distributed/c10d/reducer.h>
 
+#include <algorithm>
 #include <functional>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 
 #include <c10/util/Exception.h>
 #include <torch/csrc/autograd/engine.h>
 #include <torch/csrc/autograd/function_hook.h>
 #include <torch/csrc/autograd/functions/accumulate_grad.h>
 #include <torch/csrc/autograd/profiler.h>
+#include <torch/csrc/autograd/record_function.h>
 #include <torch/csrc/utils/hash.h>
 #include <torch/csrc/utils/memory.h>
 
@@ -36,19 +41,46 @@ inline int64_t current_time_in_nanos() {
   return torch::autograd::profiler::getTime();
 }
 
+// Returns a gradient for the variable sharing the storage of `bucket_view`.
+// It is not an autograd view of the bucket, so that it can still be detached
+// in place.
+torch::autograd::Variable bucket_view_gradient(
+    const at::Tensor& bucket_view,
+    const torch::autograd::Variable& variable) {
+  return torch::autograd::make_variable(
+      torch::autograd::as_variable_ref(bucket_view)
+          .data()
+          .view(variable.sizes()));
+}
+
+// Returns whether the gradient is the part of the bucket contents held by
+// `bucket_view`.
+bool is_bucket_view(const at::Tensor& grad, const at::Tensor& bucket_view) {
+  return grad.defined() && grad.is_alias_of(bucket_view) &&
+      grad.data_ptr() == bucket_view.data_ptr() &&
+      grad.numel() == bucket_view.numel() && grad.is_contiguous();
+}
+
 } // namespace
 
 Reducer::Reducer(
     std::vector<std::vector<torch::autograd::Variable>> replicas,
     std::vector<std::vector<size_t>> bucket_indices,
-    std::shared_ptr<c10d::ProcessGroup> process_group)
+    std::shared_ptr<c10d::ProcessGroup> process_group,
+    std::vector<size_t> bucket_size_limits,
+    bool gradient_as_bucket_view)
     : replicas_(std::move(replicas)),
       process_group_(std::move(process_group)),
       expect_autograd_hooks_(false),
       require_finalize_(false),
       has_marked_unused_parameters_(false),
+      gradient_as_bucket_view_(gradient_as_bucket_view),
       next_bucket_(0),
-      backward_stats_base_(0) {
+      backward_stats_base_(0),
+      exposed_comm_time_(-1),
+      comm_profiling_(false),
+      bucket_size_limits_(std::move(bucket_size_limits)),
+      has_rebuilt_buckets_(false) {
   AT_ASSERTM(replicas_.size() >= 1, "Expected at least one model replica.");
   AT_ASSERTM(replicas_[0].size() >= 1, "Expected at least one parameter.");
 
@@ -158,8 +190,14 @@ void Reducer::mark_variable_ready(
   AT_ASSERTM(
       variable_index < variable_locators_.size(),
       "Out of range variable index.");
-  backward_stats_[replica_index][variable_index] =
-      current_time_in_nanos() - backward_stats_base_;
+  const auto now = current_time_in_nanos() - backward_stats_base_;
+  backward_stats_[replica_index][variable_index] = now;
+
+  // Record the order in which gradients are ready to rebuild buckets.
+  if (replica_index == 0 && !has_rebuilt_buckets_ &&
+      !bucket_size_limits_.empty()) {
+    ready_order_.push_back(variable_index);
+  }
 
   // Any time we mark a variable ready (be it in line due to unused parameters,
   // or via an autograd hook), we require a call to the finalize function. If
@@ -170,6 +208,10 @@ void Reducer::mark_variable_ready(
   const auto& bucket_index = variable_locators_[variable_index];
   auto& bucket = buckets_[bucket_index.bucket_index];
   auto& replica = bucket.replicas[replica_index];
+  auto& stats = bucket_stats_[bucket_index.bucket_index];
+  if (stats[kFirstGradReady] < 0) {
+    stats[kFirstGradReady] = now;
+  }
 
   // Something is wrong if all variables contained in this bucket replica have
   // already been marked as ready.
@@ -205,12 +247,14 @@ void Reducer::mark_variable_ready(
   // of the bucket it would otherwise hold.
   auto bucket_view = replica.contents.narrow(0, offset, length);
   auto& grad = variable.grad();
-  if (grad.defined()) {
-    // Assert that the grad tensor and the bucket don't share storage.
-    // If they did, we could avoid the copy altogether.
-    // The reason for not doing this is that existing code calls
-    // `detach_` from `zero_grad`, which is incompatible with views.
-    AT_ASSERT(!grad.is_alias_of(bucket_view));
+  if (is_bucket_view(grad, bucket_view)) {
+    // The gradient was accumulated in the bucket already.
+  } else if (grad.defined()) {
+    // Unless gradient_as_bucket_view is set, the grad tensor and the bucket
+    // don't share storage. They can't be autograd views of the bucket,
+    // because existing code calls `detach_` from `zero_grad`, which is
+    // incompatible with views.
+    AT_ASSERT(gradient_as_bucket_view_ || !grad.is_alias_of(bucket_view));
     AT_ASSERT(grad.type() == variable.type());
     AT_ASSERT(grad.device() == variable.device());
     AT_ASSERT(grad.numel() == length);
@@ -231,6 +275,7 @@ void Reducer::mark_variable_ready(
     replica.contents.div_(process_group_->getSize());
     // Kick off reduction if all replicas for this bucket are ready.
     if (--bucket.pending == 0) {
+      stats[kBucketReady] = current_time_in_nanos() - backward_stats_base_;
       mark_bucket_ready(bucket_index.bucket_index);
     }
   }
@@ -278,14 +323,53 @@ void Reducer::mark_bucket_ready(size_t bucket_index) {
       //
       tensors.push_back(replica.contents);
     }
-    bucket.work = process_group_->allreduce(tensors);
+    bucket_stats_[next_bucket_][kReductionLaunch] =
+        current_time_in_nanos() - backward_stats_base_;
+    RECORD_FUNCTION("ddp_launch_reduction", std::vector<c10::IValue>());
+    if (comm_hook_) {
+      bucket.work =
+          comm_hook_->runHook(*process_group_, next_bucket_, tensors);
+    } else {
+      bucket.work = process_group_->allreduce(tensors);
+    }
   }
 }
 
+void Reducer::register_bucket_completion_hook(BucketCompletionHook hook) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  AT_ASSERTM(
+      !expect_autograd_hooks_,
+      "`register_bucket_completion_hook` must NOT be called during autograd "
+      "execution.");
+  bucket_completion_hook_ = std::move(hook);
+}
+
+void Reducer::set_comm_profiling(bool enabled) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  comm_profiling_ = enabled;
+}
+
+void Reducer::register_comm_hook(
+    std::shared_ptr<CommHookInterface> comm_hook) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  AT_ASSERTM(
+      !expect_autograd_hooks_,
+      "`register_comm_hook` must NOT be called during autograd execution.");
+  AT_CHECK(
+      !comm_hook_, "A communication hook has already been registered.");
+  comm_hook_ = std::move(comm_hook);
+}
+
 void Reducer::initialize_buckets(
     std::vector<std::vector<size_t>> bucket_indices) {
   std::lock_guard<std::mutex> lock(mutex_);
+  initialize_buckets_locked(std::move(bucket_indices));
+}
 
+void Reducer::initialize_buckets_locked(
+    std::vector<std::vector<size_t>> bucket_indices) {
   // This shouldn't be called if we're expecting autograd hooks to fire.
   AT_ASSERTM(
       !expect_autograd_hooks_,
@@ -351,6 +435,23 @@ void Reducer::initialize_buckets(
       replica.contents = torch::autograd::make_variable_consuming(
           at::empty({static_cast<long>(offset)}, options));
 
+      // Move the gradients into the bucket, keeping their values.
+      if (gradient_as_bucket_view_) {
+        for (size_t i = 0; i < replica.variables.size(); i++) {
+          auto& variable = replica.variables[i];
+          const auto bucket_view = replica.contents.narrow(
+              0, replica.offsets[i], replica.lengths[i]);
+          auto view = bucket_view_gradient(bucket_view, variable);
+          auto& grad = variable.grad();
+          if (grad.defined()) {
+            view.copy_(grad);
+          } else {
+            view.zero_();
+          }
+          grad = std::move(view);
+        }
+      }
+
       // Add bucket replica to enclosing bucket.
       bucket.replicas.push_back(std::move(replica));
     }
@@ -408,11 +509,25 @@ void Reducer::prepare_for_backward(
         "your module when reporting this issue (e.g. list, dict, iterable).");
   }
 
+  // Rebuild buckets once a full iteration has been observed.
+  if (!has_rebuilt_buckets_ && !bucket_size_limits_.empty()) {
+    if (ready_order_.size() == replicas_[0].size()) {
+      rebuild_buckets();
+    } else {
+      ready_order_.clear();
+    }
+  }
+
   // Reset accounting.
   has_marked_unused_parameters_ = true;
   expect_autograd_hooks_ = true;
   next_bucket_ = 0;
   backward_stats_base_ = current_time_in_nanos();
+  bucket_stats_.resize(buckets_.size());
+  for (auto& stats : bucket_stats_) {
+    stats.assign(kBucketStatCount, -1);
+  }
+  exposed_comm_time_ = -1;
   for (auto& bucket : buckets_) {
     for (auto& replica : bucket.replicas) {
       replica.pending = replica.variables.size();
@@ -465,6 +580,85 @@ void Reducer::prepare_for_backward(
   }
 }
 
+std::pair<double, double> Reducer::measure_allreduce_cost() {
+  // Time allreduce calls of two sizes and fit t(bytes) = latency +
+  // bytes / bandwidth. Results are copied to the host to make sure the
+  // reduction has completed for CUDA tensors as well.
+  const auto options = at::TensorOptions()
+                           .device(replicas_[0][0].device())
+                           .dtype(at::kFloat);
+  const int64_t small_bytes = 4 * 1024;
+  const int64_t large_bytes = 4 * 1024 * 1024;
+  const int iterations = 5;
+  auto time = [&](int64_t bytes) {
+    std::vector<at::Tensor> tensors = {
+        at::zeros({bytes / static_cast<int64_t>(sizeof(float))}, options)};
+    process_group_->allreduce(tensors)->wait();
+    tensors[0].narrow(0, 0, 1).cpu();
+    const auto start = current_time_in_nanos();
+    for (int i = 0; i < iterations; i++) {
+      process_group_->allreduce(tensors)->wait();
+    }
+    tensors[0].narrow(0, 0, 1).cpu();
+    return (current_time_in_nanos() - start) / (1e9 * iterations);
+  };
+  const auto small_time = time(small_bytes);
+  const auto large_time = time(large_bytes);
+  const auto bandwidth = (large_bytes - small_bytes) /
+      std::max(large_time - small_time, 1e-9);
+  const auto latency = std::max(small_time - small_bytes / bandwidth, 0.0);
+  return std::make_pair(latency, bandwidth);
+}
+
+void Reducer::rebuild_buckets() {
+  has_rebuilt_buckets_ = true;
+  const auto variable_count = replicas_[0].size();
+
+  // Buckets large enough for the latency to be at most 10% of the time
+  // of the allreduce, within the specified limits.
+  double latency;
+  double bandwidth;
+  std::tie(latency, bandwidth) = measure_allreduce_cost();
+  const auto bucket_size = static_cast<size_t>(std::min<double>(
+      std::max<double>(9 * latency * bandwidth, bucket_size_limits_.front()),
+      bucket_size_limits_.back()));
+
+  // Processes must agree on the bucket assignment, so take the ready order
+  // and bucket size of rank 0.
+  auto shared = at::empty(
+      {static_cast<int64_t>(variable_count + 1)},
+      at::TensorOptions().dtype(at::kLong));
+  auto data = shared.data<int64_t>();
+  data[0] = bucket_size;
+  std::copy(ready_order_.begin(), ready_order_.end(), data + 1);
+  std::vector<at::Tensor> tensors = {shared.to(replicas_[0][0].device())};
+  BroadcastOptions options;
+  options.rootRank = 0;
+  process_group_->broadcast(tensors, options)->wait();
+  shared = tensors[0].cpu();
+  data = shared.data<int64_t>();
+  std::vector<size_t> order(data + 1, data + 1 + variable_count);
+  ready_order_.clear();
+
+  std::vector<size_t> limits = {static_cast<size_t>(data[0])};
+  if (bucket_size_limits_.front() < limits[0]) {
+    limits.insert(limits.begin(), bucket_size_limits_.front());
+  }
+
+  std::vector<at::Tensor> ordered;
+  ordered.reserve(variable_count);
+  for (const auto index : order) {
+    ordered.push_back(replicas_[0][index]);
+  }
+  auto bucket_indices = compute_bucket_assignment_by_size(ordered, limits);
+  for (auto& bucket : bucket_indices) {
+    for (auto& index : bucket) {
+      index = order[index];
+    }
+  }
+  initialize_buckets_locked(std::move(bucket_indices));
+}
+
 void Reducer::finalize_backward() {
   // No longer expect autograd hooks to fire after this function returns.
   AT_ASSERT(expect_autograd_hooks_);
@@ -477,10 +671,42 @@ void Reducer::finalize_backward() {
   // Check that all buckets were completed and had their work kicked off.
   AT_ASSERT(next_bucket_ == buckets_.size());
 
+  // Every reduction has been launched: the time waiting for them from now
+  // on is the communication which didn't overlap with the backward pass.
+  exposed_comm_time_ = 0;
+
   // Wait for asynchronous reduction to complete and unflatten contents.
-  for (auto& bucket : buckets_) {
+  for (size_t bucket_index = 0; bucket_index < buckets_.size();
+       bucket_index++) {
+    auto& bucket = buckets_[bucket_index];
+    auto& stats = bucket_stats_[bucket_index];
     AT_ASSERT(bucket.work);
-    bucket.work->wait();
+    const auto wait_start = current_time_in_nanos();
+    {
+      RECORD_FUNCTION("ddp_wait_reduction", std::vector<c10::IValue>());
+      bucket.work->wait();
+      if (comm_profiling_) {
+        // Copying to the host waits for the reduction on the device too
+        for (const auto& replica : bucket.replicas) {
+          replica.contents.narrow(0, 0, 1).cpu();
+        }
+        const auto duration = bucket.work->getDuration();
+        if (duration >= 0) {
+          stats[kDeviceDuration] = static_cast<int64_t>(duration * 1e6);
+        }
+      }
+    }
+    const auto wait_end = current_time_in_nanos();
+    stats[kReductionComplete] = wait_end - backward_stats_base_;
+    exposed_comm_time_ += wait_end - wait_start;
+    if (comm_hook_) {
+      std::vector<at::Tensor> tensors;
+      tensors.reserve(bucket.replicas.size());
+      for (const auto& replica : bucket.replicas) {
+        tensors.push_back(replica.contents);
+      }
+      comm_hook_->finalizeHook(*process_group_, bucket_index, tensors);
+    }
     for (auto& replica : bucket.replicas) {
       for (size_t intra_bucket_index = 0;
            intra_bucket_index < replica.variables.size();
@@ -488,15 +714,27 @@ void Reducer::finalize_backward() {
         auto& variable = replica.variables[intra_bucket_index];
         const auto offset = replica.offsets[intra_bucket_index];
         const auto length = replica.lengths[intra_bucket_index];
-        auto bucket_view =
-            replica.contents.narrow(0, offset, length).view(variable.sizes());
+        auto bucket_view = replica.contents.narrow(0, offset, length);
         auto& grad = variable.grad();
+        if (is_bucket_view(grad, bucket_view)) {
+          continue;
+        }
+        if (gradient_as_bucket_view_) {
+          // The gradient was replaced since the buckets were initialized;
+          // make it a view of the reduced gradient again.
+          grad = bucket_view_gradient(bucket_view, variable);
+          continue;
+        }
+        bucket_view = bucket_view.view(variable.sizes());
         if (!grad.defined()) {
           grad = at::empty(bucket_view.sizes(), bucket_view.options());
         }
         grad.copy_(bucket_view);
       }
     }
+    if (bucket_completion_hook_) {
+      bucket_completion_hook_(bucket_index, bucket.replicas[0].variables);
+    }
   }
 }
 
@@ -522,6 +760,140 @@ inline bool operator==(const BucketKey& lhs, const BucketKey& rhs) {
   return lhs.type == rhs.type && lhs.device == rhs.device;
 }
 
+// Work returned by the coalesced collectives. Completes when the collectives
+// of all buckets complete, and copies the bucket contents back into the
+// original tensors the first time it is waited on or synchronized, unless
+// the collective leaves nothing to copy back on this process.
+class CoalescedWork : public ProcessGroup::Work {
+ public:
+  struct Bucket {
+    std::vector<at::Tensor> tensors;
+    std::vector<size_t> offsets;
+    std::vector<size_t> lengths;
+    // Must be kept alive until the work completes.
+    std::vector<at::Tensor> contents;
+    std::shared_ptr<ProcessGroup::Work> work;
+  };
+
+  explicit CoalescedWork(std::vector<Bucket> buckets, bool copyBack = true)
+      : buckets_(std::move(buckets)), unflattened_(!copyBack) {}
+
+  bool isCompleted() override {
+    for (auto& bucket : buckets_) {
+      if (!bucket.work->isCompleted()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool isSuccess() const override {
+    for (const auto& bucket : buckets_) {
+      if (!bucket.work->isSuccess()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::exception_ptr exception() const override {
+    for (const auto& bucket : buckets_) {
+      if (!bucket.work->isSuccess()) {
+        return bucket.work->exception();
+      }
+    }
+    return nullptr;
+  }
+
+  void synchronize() override {
+    for (auto& bucket : buckets_) {
+      bucket.work->synchronize();
+    }
+    unflatten();
+  }
+
+  void wait() override {
+    for (auto& bucket : buckets_) {
+      bucket.work->wait();
+    }
+    unflatten();
+  }
+
+ protected:
+  void unflatten() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (unflattened_) {
+      return;
+    }
+    for (auto& bucket : buckets_) {
+      auto& contents = bucket.contents[0];
+      for (size_t i = 0; i < bucket.tensors.size(); i++) {
+        auto& tensor = bucket.tensors[i];
+        tensor.copy_(contents.narrow(0, bucket.offsets[i], bucket.lengths[i])
+                         .view(tensor.sizes()));
+      }
+    }
+    unflattened_ = true;
+  }
+
+  std::vector<Bucket> buckets_;
+  bool unflattened_;
+};
+
+using BucketCollective = std::function<std::shared_ptr<ProcessGroup::Work>(
+    std::vector<at::Tensor>&)>;
+
+// Groups `tensors` by type and device into buckets of about `bucket_size`
+// bytes, flattens every bucket into a single contents tensor and starts
+// `collective` on it.
+std::shared_ptr<ProcessGroup::Work> runCoalesced(
+    const std::vector<at::Tensor>& tensors,
+    size_t bucket_size,
+    bool copyBack,
+    const BucketCollective& collective) {
+  const auto bucket_indices =
+      compute_bucket_assignment_by_size(tensors, {bucket_size});
+
+  std::vector<CoalescedWork::Bucket> buckets;
+  buckets.reserve(bucket_indices.size());
+  for (const auto& indices : bucket_indices) {
+    CoalescedWork::Bucket bucket;
+    const auto& first = tensors[indices.front()];
+    size_t offset = 0;
+    for (const auto index : indices) {
+      const auto& tensor = tensors[index];
+      const auto length = tensor.numel();
+      bucket.tensors.push_back(tensor);
+      bucket.offsets.push_back(offset);
+      bucket.lengths.push_back(length);
+      offset += length;
+    }
+
+    // Flatten the bucket the same way the reducer fills the contents of a
+    // bucket replica. See Reducer::initialize_buckets for why the contents
+    // tensor must be a Variable.
+    auto options = at::TensorOptions()
+                       .device(first.device())
+                       .dtype(first.dtype());
+    auto contents = at::empty({static_cast<long>(offset)}, options);
+    if (first.is_variable()) {
+      contents =
+          torch::autograd::make_variable_consuming(std::move(contents));
+    }
+    for (size_t i = 0; i < bucket.tensors.size(); i++) {
+      const auto& tensor = bucket.tensors[i];
+      contents.narrow(0, bucket.offsets[i], bucket.lengths[i])
+          .view(tensor.sizes())
+          .copy_(tensor);
+    }
+    bucket.contents.push_back(std::move(contents));
+    bucket.work = collective(bucket.contents);
+    buckets.push_back(std::move(bucket));
+  }
+
+  return std::make_shared<CoalescedWork>(std::move(buckets), copyBack);
+}
+
 } // namespace
 
 // This is equivalent to take_tensors but returns indices into the
@@ -602,4 +974,75 @@ std::vector<std::vector<size_t>> compute_bucket_assignment_by_size(
   return result;
 }
 
+BucketCompletionHook make_optimizer_hook(
+    std::function<std::unique_ptr<torch::optim::Optimizer>(
+        std::vector<torch::Tensor>)> make_optimizer) {
+  auto optimizers = std::make_shared<std::unordered_map<
+      c10::TensorImpl*,
+      std::unique_ptr<torch::optim::Optimizer>>>();
+  return [make_optimizer, optimizers](
+             size_t /* unused */,
+             const std::vector<torch::autograd::Variable>& variables) {
+    for (const auto& variable : variables) {
+      auto& optimizer = (*optimizers)[variable.unsafeGetTensorImpl()];
+      if (!optimizer) {
+        optimizer = make_optimizer({variable});
+      }
+      optimizer->step();
+    }
+  };
+}
+
+std::shared_ptr<ProcessGroup::Work> allreduce_coalesced(
+    ProcessGroup& process_group,
+    std::vector<at::Tensor> tensors,
+    size_t bucket_size,
+    const AllreduceOptions& opts) {
+  return runCoalesced(
+      tensors,
+      bucket_size,
+      /* copyBack */ true,
+      [&](std::vector<at::Tensor>& contents) {
+        return process_group.allreduce(contents, opts);
+      });
+}
+
+std::shared_ptr<ProcessGroup::Work> broadcast_coalesced(
+    ProcessGroup& process_group,
+    std::vector<at::Tensor> tensors,
+    size_t bucket_size,
+    const BroadcastOptions& opts) {
+  AT_CHECK(
+      opts.rootTensor == 0,
+      "broadcast_coalesced broadcasts a single list of tensors, "
+      "expected root tensor 0");
+  return runCoalesced(
+      tensors,
+      bucket_size,
+      // the root already has the results
+      /* copyBack */ process_group.getRank() != opts.rootRank,
+      [&](std::vector<at::Tensor>& contents) {
+        return process_group.broadcast(contents, opts);
+      });
+}
+
+std::shared_ptr<ProcessGroup::Work> reduce_coalesced(
+    ProcessGroup& process_group,
+    std::vector<at::Tensor> tensors,
+    size_t bucket_size,
+    const ReduceOptions& opts) {
+  AT_CHECK(
+      opts.rootTensor == 0,
+      "reduce_coalesced reduces a single list of tensors, "
+      "expected root tensor 0");
+  return runCoalesced(
+      tensors,
+      bucket_size,
+      // only the root receives the results
+      /* copyBack */ process_group.getRank() == opts.rootRank,
+      [&](std::vector<at::Tensor>& contents) {
+        return process_group.reduce(contents, opts);
+      });
+}
+
 } // namespace c10d
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <atomic>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <tuple>
@@ -9,20 +10,42 @@
 
 #include <c10d/ProcessGroup.hpp>
 #include <torch/csrc/autograd/function.h>
+#include <torch/csrc/distributed/c10d/comm.h>
+#include <torch/optim/optimizer.h>
 #include <torch/csrc/autograd/variable.h>
 
 namespace c10d {
 
+// Called with the index and the variables of the first model replica of a
+// bucket, once the gradients of the bucket have been reduced.
+using BucketCompletionHook = std::function<
+    void(size_t, const std::vector<torch::autograd::Variable>&)>;
+
 class Reducer {
  public:
   // The constructor takes a list of variables for every model replica.
   // The bucket assignment for this reducer is specified as a list of
   // buckets, each of which is specified as a list of indices into the
   // variables list for **a single replica** (i.e. `variables[0]`).
+  //
+  // If bucket size limits are specified (see
+  // compute_bucket_assignment_by_size), the buckets are rebuilt once, after
+  // the first iteration, to follow the order in which gradients became ready
+  // in that iteration. The last limit is then lowered to what is needed to
+  // amortize the latency of an allreduce, as measured on the process group.
+  //
+  // If `gradient_as_bucket_view` is set, the gradients of the variables are
+  // set to tensors sharing the storage of the bucket contents, so that
+  // gradients are accumulated in the buckets and reduced in place, instead
+  // of being copied into the buckets before the reduction and back after it.
+  // Gradients are then defined (as zeros) from the start, and assigning
+  // another tensor to a gradient only costs the copies for that iteration.
   explicit Reducer(
       std::vector<std::vector<torch::autograd::Variable>> replicas,
       std::vector<std::vector<size_t>> bucket_indices,
-      std::shared_ptr<c10d::ProcessGroup> process_group);
+      std::shared_ptr<c10d::ProcessGroup> process_group,
+      std::vector<size_t> bucket_size_limits = {},
+      bool gradient_as_bucket_view = false);
 
   // To (re-)initialize bucket assignment, pass a list of buckets, each
   // of which is specified by a list of indices in the variables list.
@@ -37,6 +60,17 @@ class Reducer {
   void prepare_for_backward(
       const std::vector<torch::autograd::Variable>& outputs);
 
+  // Replaces the allreduce of bucket contents with the specified
+  // communication hook. Must be called before the first backward pass.
+  void register_comm_hook(std::shared_ptr<CommHookInterface> comm_hook);
+
+  // Registers a function that is called for every bucket, in bucket order,
+  // as soon as its reduction has completed and the reduced gradients have
+  // been written back, while the reductions of later buckets may still be
+  // in flight. This can be used to overlap the optimizer step with
+  // communication (see make_optimizer_hook).
+  void register_bucket_completion_hook(BucketCompletionHook hook);
+
   // Returns the relative time in nanoseconds when gradients were ready,
   // with respect to the time `prepare_for_backward` was called. The outer
   // vector is for model replicas and the inner vector is for parameters.
@@ -44,10 +78,55 @@ class Reducer {
     return backward_stats_;
   }
 
+  // Indices of the timestamps of a bucket in `get_bucket_stats`.
+  enum BucketStat {
+    // The first gradient of the bucket was ready.
+    kFirstGradReady = 0,
+    // The last gradient of the bucket was ready.
+    kBucketReady,
+    // The reduction of the bucket was launched, once the reductions of the
+    // buckets before it were.
+    kReductionLaunch,
+    // The reduction of the bucket was found complete by `finalize_backward`.
+    kReductionComplete,
+    // Not a timestamp: how long the reduction ran for on the device, if the
+    // process group times its work (see ProcessGroup::Work::getDuration).
+    kDeviceDuration,
+    kBucketStatCount,
+  };
+
+  // Returns, for every bucket of the last iteration, the relative times in
+  // nanoseconds of its BucketStat events, with respect to the time
+  // `prepare_for_backward` was called, or -1 for the missing ones.
+  //
+  // Unless comm profiling is enabled, the reductions of CUDA buckets are
+  // "complete" once the current stream was made to wait for them, and the
+  // device duration is unknown.
+  std::vector<std::vector<int64_t>> get_bucket_stats() const {
+    return bucket_stats_;
+  }
+
+  // Returns the time in nanoseconds `finalize_backward` spent waiting for
+  // the reductions of the last iteration, once every bucket was launched at
+  // the end of the backward pass, i.e. the communication that didn't overlap
+  // with the backward pass. Like the bucket stats, it only covers the device
+  // time of CUDA reductions if comm profiling is enabled.
+  int64_t get_exposed_comm_time() const {
+    return exposed_comm_time_;
+  }
+
+  // Makes `finalize_backward` wait for every reduction to complete on the
+  // host, and query the process group for its duration on the device, so
+  // that the bucket stats of CUDA buckets are accurate. This synchronizes
+  // with the devices once per bucket, so it is only meant for profiling.
+  void set_comm_profiling(bool enabled);
+
  protected:
   std::mutex mutex_;
   std::vector<std::vector<torch::autograd::Variable>> replicas_;
   std::shared_ptr<c10d::ProcessGroup> process_group_;
+  std::shared_ptr<CommHookInterface> comm_hook_;
+  BucketCompletionHook bucket_completion_hook_;
 
   std::vector<std::vector<std::shared_ptr<torch::autograd::Function>>>
       grad_accumulators_;
@@ -56,6 +135,7 @@ class Reducer {
   bool expect_autograd_hooks_;
   bool require_finalize_;
   bool has_marked_unused_parameters_;
+  bool gradient_as_bucket_view_;
   size_t next_bucket_;
 
   void mark_variable_ready(
@@ -65,6 +145,18 @@ class Reducer {
 
   void mark_bucket_ready(size_t bucket_index);
 
+  void initialize_buckets_locked(
+      std::vector<std::vector<size_t>> bucket_indices);
+
+  // Rebuilds the buckets in the gradient ready order recorded in the first
+  // iteration. This is a collective call; the order and bucket size limits
+  // of rank 0 are used by every process.
+  void rebuild_buckets();
+
+  // Returns the estimated latency (in seconds) and bandwidth (in bytes per
+  // second) of an allreduce on the process group.
+  std::pair<double, double> measure_allreduce_cost();
+
   void finalize_backward();
 
   // A bucket replica represents [1..N] gradients to be reduced,
@@ -138,10 +230,64 @@ class Reducer {
   // the point in time buckets were ready, or ideal bucket assignment/ordering.
   int64_t backward_stats_base_;
   std::vector<std::vector<int64_t>> backward_stats_;
+
+  // The BucketStat timestamps of every bucket in the current iteration, with
+  // the same base as the backward stats.
+  std::vector<std::vector<int64_t>> bucket_stats_;
+  int64_t exposed_comm_time_;
+  bool comm_profiling_;
+
+  // Limits used to rebuild buckets; empty if buckets are never rebuilt.
+  std::vector<size_t> bucket_size_limits_;
+  bool has_rebuilt_buckets_;
+  // Indices of the variables of the first replica in the order they were
+  // marked ready during the first iteration.
+  std::vector<size_t> ready_order_;
 };
 
 std::vector<std::vector<size_t>> compute_bucket_assignment_by_size(
     const std::vector<at::Tensor>& tensors,
     std::vector<size_t> bucket_size);
 
+// Returns a bucket completion hook that steps the parameters of every bucket
+// with an optimizer created by `make_optimizer`. One optimizer is created for
+// every parameter, the first time its bucket completes, so that optimizer
+// state is kept when buckets are rebuilt. With this hook registered, the
+// optimizer step must not also be run after the backward pass.
+//
+// Parameters of other model replicas are not updated; they are synchronized
+// with the first replica before the next forward pass.
+BucketCompletionHook make_optimizer_hook(
+    std::function<std::unique_ptr<torch::optim::Optimizer>(
+        std::vector<torch::Tensor>)> make_optimizer);
+
+// Allreduces `tensors` in place with one collective per bucket instead of
+// one per tensor. Tensors are grouped by type and device into buckets of
+// about `bucket_size` bytes (see compute_bucket_assignment_by_size), each
+// bucket is flattened into a single contents tensor and reduced, and the
+// results are copied back into `tensors` when the returned work is waited
+// on or synchronized.
+std::shared_ptr<ProcessGroup::Work> allreduce_coalesced(
+    ProcessGroup& process_group,
+    std::vector<at::Tensor> tensors,
+    size_t bucket_size,
+    const AllreduceOptions& opts = AllreduceOptions());
+
+// Broadcasts `tensors` from the root rank with one collective per bucket,
+// bucketed and flattened like allreduce_coalesced.
+std::shared_ptr<ProcessGroup::Work> broadcast_coalesced(
+    ProcessGroup& process_group,
+    std::vector<at::Tensor> tensors,
+    size_t bucket_size,
+    const BroadcastOptions& opts = BroadcastOptions());
+
+// Reduces `tensors` to the root rank with one collective per bucket,
+// bucketed and flattened like allreduce_coalesced. Only the tensors of the
+// root rank are written.
+std::shared_ptr<ProcessGroup::Work> reduce_coalesced(
+    ProcessGroup& process_group,
+    std::vector<at::Tensor> tensors,
+    size_t bucket_size,
+    const ReduceOptions& opts = ReduceOptions());
+
 } // namespace c10d
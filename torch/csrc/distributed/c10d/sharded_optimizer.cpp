@@ -0,0 +1,129 @@
+#include <torch/csrc/distributed/c10d/sharded_optimizer.h>
+
+#include <c10/util/Exception.h>
+#include <torch/serialize/archive.h>
+#include <torch/utils.h>
+
+namespace c10d {
+
+ShardedOptimizer::ShardedOptimizer(
+    std::vector<torch::Tensor> parameters,
+    std::shared_ptr<ProcessGroup> process_group,
+    OptimizerFactory make_optimizer)
+    : torch::optim::Optimizer(std::move(parameters)),
+      process_group_(std::move(process_group)) {
+  AT_CHECK(!parameters_.empty(), "Expected at least one parameter");
+  const auto options =
+      torch::autograd::as_variable_ref(parameters_[0]).data().options();
+  int64_t numel = 0;
+  for (const auto& parameter : parameters_) {
+    AT_CHECK(
+        parameter.dtype() == parameters_[0].dtype() &&
+            parameter.device() == parameters_[0].device(),
+        "All parameters of a ShardedOptimizer must have the same type and "
+        "device");
+    offsets_.push_back(numel);
+    numel += parameter.numel();
+  }
+
+  const auto size = process_group_->getSize();
+  const auto rank = process_group_->getRank();
+  shard_numel_ = (numel + size - 1) / size;
+  flat_parameters_ = at::zeros({shard_numel_ * size}, options);
+  flat_gradients_ = at::zeros({shard_numel_ * size}, options);
+  gradient_shard_ = at::empty({shard_numel_}, options);
+
+  // The parameters become views of the flat tensor
+  torch::NoGradGuard no_grad;
+  for (size_t i = 0; i < parameters_.size(); i++) {
+    auto& parameter = torch::autograd::as_variable_ref(parameters_[i]);
+    auto view = flat_parameters_.narrow(0, offsets_[i], parameter.numel())
+                    .view(parameter.sizes());
+    view.copy_(parameter.data());
+    parameter.set_data(view);
+  }
+
+  const auto shard =
+      flat_parameters_.narrow(0, rank * shard_numel_, shard_numel_);
+  master_ = torch::autograd::make_variable(
+      shard.to(at::kFloat, /*non_blocking=*/false, /*copy=*/true),
+      /*requires_grad=*/true);
+  // With fp32 parameters, the optimizer reads the reduced gradients in place
+  master_.grad() = torch::autograd::make_variable(
+      gradient_shard_.scalar_type() == at::kFloat
+          ? gradient_shard_
+          : at::zeros({shard_numel_}, options.dtype(at::kFloat)));
+  optimizer_ = make_optimizer({master_});
+  AT_CHECK(optimizer_, "The optimizer factory returned no optimizer");
+}
+
+void ShardedOptimizer::bind_gradients() {
+  for (size_t i = 0; i < parameters_.size(); i++) {
+    auto& parameter = parameters_[i];
+    auto& grad = parameter.grad();
+    auto view = flat_gradients_.narrow(0, offsets_[i], parameter.numel())
+                    .view(parameter.sizes());
+    if (grad.defined() &&
+        torch::autograd::as_variable_ref(grad).data().data_ptr() ==
+            view.data_ptr()) {
+      continue;
+    }
+    // Backward accumulates into the existing gradients in place, except
+    // in double backward, which replaces them.
+    if (grad.defined()) {
+      view.copy_(torch::autograd::as_variable_ref(grad).data());
+    } else {
+      view.zero_();
+    }
+    grad = torch::autograd::make_variable(view);
+  }
+}
+
+void ShardedOptimizer::step() {
+  torch::NoGradGuard no_grad;
+  const auto size = process_group_->getSize();
+  const auto rank = process_group_->getRank();
+
+  // Average the gradients, keeping the shard of this process only
+  bind_gradients();
+  flat_gradients_.div_(size);
+  std::vector<at::Tensor> outputs = {gradient_shard_};
+  std::vector<std::vector<at::Tensor>> inputs = {
+      flat_gradients_.chunk(size)};
+  process_group_->reduce_scatter(outputs, inputs)->wait();
+  auto& master_grad = master_.grad();
+  if (master_grad.data_ptr() != gradient_shard_.data_ptr()) {
+    torch::autograd::as_variable_ref(master_grad)
+        .data()
+        .copy_(gradient_shard_);
+  }
+
+  optimizer_->step();
+
+  // Write the shard back into the parameters, and gather the shards of the
+  // other processes
+  auto shard = flat_parameters_.narrow(0, rank * shard_numel_, shard_numel_);
+  shard.copy_(master_.data());
+  std::vector<std::vector<at::Tensor>> gathered = {
+      flat_parameters_.chunk(size)};
+  std::vector<at::Tensor> sources = {shard.clone()};
+  process_group_->allgather(gathered, sources)->wait();
+}
+
+void ShardedOptimizer::save(torch::serialize::OutputArchive& archive) const {
+  archive.write("master", master_, /*is_buffer=*/true);
+  torch::serialize::OutputArchive optimizer_archive;
+  optimizer_->save(optimizer_archive);
+  archive.write("optimizer", optimizer_archive);
+}
+
+void ShardedOptimizer::load(torch::serialize::InputArchive& archive) {
+  // The master weights are reloaded in place, where the optimizer sees them
+  at::Tensor master = master_;
+  archive.read("master", master, /*is_buffer=*/true);
+  torch::serialize::InputArchive optimizer_archive;
+  archive.read("optimizer", optimizer_archive);
+  optimizer_->load(optimizer_archive);
+}
+
+} // namespace c10d
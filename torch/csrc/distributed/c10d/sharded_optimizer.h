@@ -0,0 +1,77 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <c10d/ProcessGroup.hpp>
+#include <torch/csrc/autograd/variable.h>
+#include <torch/optim/optimizer.h>
+
+namespace c10d {
+
+// Wraps an optimizer to shard its state across the processes of a data
+// parallel process group, so that every process keeps the state and the
+// fp32 master weights of 1/N of the parameters only.
+//
+// The parameters are packed into one flat tensor, split into N shards, and
+// the optimizer created by `make_optimizer` only steps the fp32 copy of the
+// shard of this process. Every step reduce-scatters the gradients (averaging
+// them, so they must not be reduced beforehand, e.g. by a Reducer), steps
+// the shard, and allgathers the updated parameters:
+//
+//   c10d::ShardedOptimizer optimizer(
+//       model->parameters(), process_group, [](std::vector<Tensor> shard) {
+//         return torch::make_unique<torch::optim::Adam>(
+//             shard, torch::optim::AdamOptions(1e-3));
+//       });
+//   optimizer.zero_grad();
+//   loss(model->forward(input), target).backward();
+//   optimizer.step();
+//
+// All parameters must have the same type and device. They become views of
+// the flat tensor, and so do their gradients after the first step. Every
+// process saves and loads the state of its own shard.
+class ShardedOptimizer : public torch::optim::Optimizer {
+ public:
+  using OptimizerFactory =
+      std::function<std::unique_ptr<torch::optim::Optimizer>(
+          std::vector<torch::Tensor>)>;
+
+  ShardedOptimizer(
+      std::vector<torch::Tensor> parameters,
+      std::shared_ptr<ProcessGroup> process_group,
+      OptimizerFactory make_optimizer);
+
+  void step() override;
+
+  void save(torch::serialize::OutputArchive& archive) const override;
+  void load(torch::serialize::InputArchive& archive) override;
+
+  // The optimizer of the shard of this process, e.g. to change its options.
+  torch::optim::Optimizer& shard_optimizer() {
+    return *optimizer_;
+  }
+
+ protected:
+  // Makes the gradients of the parameters views of `flat_gradients_`,
+  // copying the ones which aren't yet, and zeroing the missing ones.
+  void bind_gradients();
+
+  std::shared_ptr<ProcessGroup> process_group_;
+
+  // The parameters and their gradients, padded to N shards of
+  // `shard_numel_` elements.
+  at::Tensor flat_parameters_;
+  at::Tensor flat_gradients_;
+  std::vector<int64_t> offsets_;
+  int64_t shard_numel_;
+
+  // The reduced gradients of the shard of this process, and its fp32 master
+  // weights, which the optimizer steps.
+  at::Tensor gradient_shard_;
+  torch::autograd::Variable master_;
+  std::unique_ptr<torch::optim::Optimizer> optimizer_;
+};
+
+} // namespace c10d
@@ -0,0 +1,47 @@
+#include <torch/csrc/distributed/rpc/message.h>
+
+#include <torch/csrc/jit/pickler.h>
+
+namespace torch {
+namespace distributed {
+namespace rpc {
+
+Message Message::fromIValues(
+    MessageType type,
+    int64_t id,
+    const std::vector<c10::IValue>& values) {
+  Message message;
+  message.type = type;
+  message.id = id;
+  torch::jit::Pickler pickler(&message.tensors);
+  pickler.start();
+  for (const auto& value : values) {
+    pickler.addIValue(value);
+  }
+  pickler.finish();
+  message.payload = pickler.stack();
+  return message;
+}
+
+std::vector<c10::IValue> Message::toIValues() const {
+  torch::jit::Unpickler unpickler(
+      const_cast<char*>(payload.data()), payload.size(), &tensors);
+  return unpickler.parse_ivalue_list();
+}
+
+Message Message::exception(int64_t id, const std::string& what) {
+  Message message;
+  message.type = MessageType::EXCEPTION;
+  message.id = id;
+  message.payload.assign(what.begin(), what.end());
+  return message;
+}
+
+std::string Message::exceptionMessage() const {
+  AT_ASSERT(type == MessageType::EXCEPTION);
+  return std::string(payload.begin(), payload.end());
+}
+
+} // namespace rpc
+} // namespace distributed
+} // namespace torch
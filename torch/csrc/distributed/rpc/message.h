@@ -0,0 +1,45 @@
+#pragma once
+
+#include <ATen/core/ivalue.h>
+
+#include <string>
+#include <vector>
+
+namespace torch {
+namespace distributed {
+namespace rpc {
+
+enum class MessageType : int64_t {
+  REQUEST = 0,
+  RESPONSE = 1,
+  // a response whose payload is the error message of a failed request
+  EXCEPTION = 2,
+  // tells the listener of the receiving agent to stop
+  SHUTDOWN = 3,
+};
+
+// A message exchanged by RPC agents. The payload is a JIT pickle of a list of
+// IValues, in which each tensor is an index into `tensors`, so the tensor data
+// is sent as is instead of being copied into the pickle.
+struct Message {
+  MessageType type = MessageType::REQUEST;
+  // matches a response to its request
+  int64_t id = 0;
+  std::vector<char> payload;
+  std::vector<at::Tensor> tensors;
+
+  static Message fromIValues(
+      MessageType type,
+      int64_t id,
+      const std::vector<c10::IValue>& values);
+
+  std::vector<c10::IValue> toIValues() const;
+
+  static Message exception(int64_t id, const std::string& what);
+  // The error message of an EXCEPTION message.
+  std::string exceptionMessage() const;
+};
+
+} // namespace rpc
+} // namespace distributed
+} // namespace torch
@@ -0,0 +1,190 @@
+#include <torch/csrc/distributed/rpc/process_group_agent.h>
+
+#include <ATen/ATen.h>
+#include <c10/util/Exception.h>
+#include <torch/csrc/autograd/generated/variable_factories.h>
+
+namespace torch {
+namespace distributed {
+namespace rpc {
+
+namespace {
+
+// The headers are received from any rank, and the other parts of a message
+// from the rank that sent its header.
+constexpr int kHeaderTag = 0;
+constexpr int kBodyTag = 1;
+
+// [type, id, pickle bytes, number of tensors, number of shape and type entries]
+constexpr int64_t kHeaderSize = 5;
+
+void sendTensor(
+    ::c10d::ProcessGroup& processGroup,
+    int dst,
+    int tag,
+    at::Tensor tensor) {
+  std::vector<at::Tensor> tensors = {std::move(tensor)};
+  processGroup.send(tensors, dst, tag)->wait();
+}
+
+void recvTensor(
+    ::c10d::ProcessGroup& processGroup,
+    int src,
+    at::Tensor tensor) {
+  std::vector<at::Tensor> tensors = {std::move(tensor)};
+  processGroup.recv(tensors, src, kBodyTag)->wait();
+}
+
+} // namespace
+
+ProcessGroupAgent::ProcessGroupAgent(
+    std::shared_ptr<::c10d::ProcessGroup> processGroup,
+    size_t numThreads)
+    : RpcAgent(processGroup->getRank(), processGroup->getSize()),
+      processGroup_(std::move(processGroup)),
+      sendMutexes_(worldSize_),
+      threadPool_(numThreads),
+      joined_(false) {
+  if (worldSize_ > 1) {
+    listenerThread_ = std::thread(&ProcessGroupAgent::listen, this);
+  }
+}
+
+ProcessGroupAgent::~ProcessGroupAgent() {
+  join();
+}
+
+void ProcessGroupAgent::sync() {
+  processGroup_->barrier()->wait();
+}
+
+void ProcessGroupAgent::join() {
+  if (joined_) {
+    return;
+  }
+  joined_ = true;
+  waitPendingCalls();
+  // all agents got the responses to all their calls, so no more requests
+  // are coming
+  sync();
+  threadPool_.waitWorkComplete();
+  if (worldSize_ > 1) {
+    // every listener gets one SHUTDOWN, from the previous rank
+    Message shutdown;
+    shutdown.type = MessageType::SHUTDOWN;
+    send((rank_ + 1) % worldSize_, std::move(shutdown));
+    listenerThread_.join();
+  }
+}
+
+void ProcessGroupAgent::send(int dst, Message&& message) {
+  std::vector<at::Tensor> tensors;
+  std::vector<int64_t> meta;
+  tensors.reserve(message.tensors.size());
+  for (const auto& tensor : message.tensors) {
+    AT_CHECK(
+        !tensor.is_sparse(), "ProcessGroupAgent: can't send sparse tensors");
+    tensors.push_back(tensor.cpu().contiguous());
+    meta.push_back(static_cast<int64_t>(tensor.scalar_type()));
+    meta.push_back(tensor.dim());
+    meta.insert(meta.end(), tensor.sizes().begin(), tensor.sizes().end());
+  }
+
+  auto header = at::empty({kHeaderSize}, at::kLong);
+  auto h = header.data<int64_t>();
+  h[0] = static_cast<int64_t>(message.type);
+  h[1] = message.id;
+  h[2] = message.payload.size();
+  h[3] = tensors.size();
+  h[4] = meta.size();
+
+  std::lock_guard<std::mutex> lock(sendMutexes_[dst]);
+  sendTensor(*processGroup_, dst, kHeaderTag, header);
+  // empty parts aren't sent, the receiver knows their sizes from the header
+  if (!message.payload.empty()) {
+    sendTensor(
+        *processGroup_,
+        dst,
+        kBodyTag,
+        at::from_blob(
+            message.payload.data(),
+            {static_cast<int64_t>(message.payload.size())},
+            at::kByte));
+  }
+  if (!meta.empty()) {
+    sendTensor(
+        *processGroup_,
+        dst,
+        kBodyTag,
+        at::from_blob(
+            meta.data(), {static_cast<int64_t>(meta.size())}, at::kLong));
+  }
+  for (auto& tensor : tensors) {
+    if (tensor.numel() > 0) {
+      sendTensor(*processGroup_, dst, kBodyTag, tensor);
+    }
+  }
+}
+
+void ProcessGroupAgent::listen() {
+  try {
+    while (true) {
+      std::vector<at::Tensor> header = {at::empty({kHeaderSize}, at::kLong)};
+      auto work = processGroup_->recvAnysource(header, kHeaderTag);
+      work->wait();
+      const int src = work->sourceRank();
+      const auto h = header[0].data<int64_t>();
+
+      Message message;
+      message.type = static_cast<MessageType>(h[0]);
+      if (message.type == MessageType::SHUTDOWN) {
+        return;
+      }
+      message.id = h[1];
+      message.payload.resize(h[2]);
+      if (!message.payload.empty()) {
+        recvTensor(
+            *processGroup_,
+            src,
+            at::from_blob(message.payload.data(), {h[2]}, at::kByte));
+      }
+      std::vector<int64_t> meta(h[4]);
+      if (!meta.empty()) {
+        recvTensor(
+            *processGroup_, src, at::from_blob(meta.data(), {h[4]}, at::kLong));
+      }
+      size_t pos = 0;
+      for (int64_t i = 0; i < h[3]; i++) {
+        AT_ASSERT(pos + 2 <= meta.size());
+        const auto dtype = static_cast<at::ScalarType>(meta[pos]);
+        const auto dim = meta[pos + 1];
+        pos += 2;
+        AT_ASSERT(pos + dim <= meta.size());
+        std::vector<int64_t> sizes(
+            meta.begin() + pos, meta.begin() + pos + dim);
+        pos += dim;
+        // the functions and the callers get variables, as from local calls
+        auto tensor = torch::empty(sizes, at::TensorOptions().dtype(dtype));
+        if (tensor.numel() > 0) {
+          recvTensor(*processGroup_, src, tensor);
+        }
+        message.tensors.push_back(std::move(tensor));
+      }
+
+      if (message.type == MessageType::REQUEST) {
+        threadPool_.run([this, src, message] {
+          send(src, handleRequest(message));
+        });
+      } else {
+        handleResponse(std::move(message));
+      }
+    }
+  } catch (const std::exception& e) {
+    failPendingCalls(
+        std::string("ProcessGroupAgent: receiving failed: ") + e.what());
+  }
+}
+
+} // namespace rpc
+} // namespace distributed
+} // namespace torch
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <c10/core/thread_pool.h>
+#include <c10d/ProcessGroup.hpp>
+#include <torch/csrc/distributed/rpc/rpc_agent.h>
+
+namespace torch {
+namespace distributed {
+namespace rpc {
+
+// An RpcAgent that sends its messages with the point-to-point operations of a
+// process group, e.g. over the TCP transport of ProcessGroupGloo. The ranks
+// of the agents are the ranks in the process group, which the agent must be
+// the only user of while it runs.
+//
+// A message is sent as a header, the pickle, the shapes and types of its
+// tensors, and the tensors. A listener thread receives the messages from any
+// rank, and the requests run on a pool of `numThreads` threads, so functions
+// can make calls themselves.
+class ProcessGroupAgent : public RpcAgent {
+ public:
+  explicit ProcessGroupAgent(
+      std::shared_ptr<::c10d::ProcessGroup> processGroup,
+      size_t numThreads = 4);
+
+  // Calls join if it wasn't called.
+  ~ProcessGroupAgent() override;
+
+  void sync() override;
+
+  void join() override;
+
+ protected:
+  void send(int dst, Message&& message) override;
+
+ private:
+  void listen();
+
+  std::shared_ptr<::c10d::ProcessGroup> processGroup_;
+  // Only one message at a time can be sent to a rank, so the parts of
+  // concurrent messages don't interleave.
+  std::vector<std::mutex> sendMutexes_;
+  c10::ThreadPool threadPool_;
+  std::thread listenerThread_;
+  bool joined_;
+};
+
+} // namespace rpc
+} // namespace distributed
+} // namespace torch
@@ -0,0 +1,154 @@
+#include <torch/csrc/distributed/rpc/rpc_agent.h>
+
+#include <c10/util/Exception.h>
+
+namespace torch {
+namespace distributed {
+namespace rpc {
+
+namespace {
+
+// Completes `future` with the results of a RESPONSE, or the error of an
+// EXCEPTION.
+void completeFuture(
+    c10::intrusive_ptr<c10::ivalue::Future> future,
+    const Message& response) {
+  if (response.type == MessageType::EXCEPTION) {
+    future->markCompleted(
+        c10::ivalue::Future::FutureError(response.exceptionMessage()));
+  } else {
+    future->markCompleted(c10::ivalue::Tuple::create(response.toIValues()));
+  }
+}
+
+} // namespace
+
+RpcAgent::RpcAgent(int rank, int worldSize)
+    : rank_(rank), worldSize_(worldSize), nextId_(0) {
+  AT_CHECK(
+      rank >= 0 && rank < worldSize,
+      "RpcAgent: invalid rank ",
+      rank,
+      " for world size ",
+      worldSize);
+}
+
+RpcAgent::~RpcAgent() = default;
+
+void RpcAgent::registerFunction(const std::string& name, RpcFunction fn) {
+  std::lock_guard<std::mutex> lock(functionsMutex_);
+  functions_[name] = std::move(fn);
+}
+
+c10::intrusive_ptr<c10::ivalue::Future> RpcAgent::call(
+    int dst,
+    const std::string& name,
+    std::vector<c10::IValue> args) {
+  AT_CHECK(
+      dst >= 0 && dst < worldSize_,
+      "RpcAgent: invalid destination ",
+      dst,
+      " for world size ",
+      worldSize_);
+  // the request is [name, args...]
+  args.insert(args.begin(), name);
+  const int64_t id = nextId_++;
+  auto request = Message::fromIValues(MessageType::REQUEST, id, args);
+  auto future = c10::make_intrusive<c10::ivalue::Future>();
+
+  if (dst == rank_) {
+    completeFuture(future, handleRequest(request));
+    return future;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    pending_.emplace(id, future);
+  }
+  try {
+    send(dst, std::move(request));
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    pending_.erase(id);
+    pendingCV_.notify_all();
+    throw;
+  }
+  return future;
+}
+
+Message RpcAgent::handleRequest(const Message& request) {
+  AT_ASSERT(request.type == MessageType::REQUEST);
+  try {
+    auto args = request.toIValues();
+    AT_CHECK(
+        !args.empty() && args[0].isString(),
+        "RpcAgent: malformed request");
+    const auto name = args[0].toStringRef();
+    args.erase(args.begin());
+
+    RpcFunction fn;
+    {
+      std::lock_guard<std::mutex> lock(functionsMutex_);
+      auto it = functions_.find(name);
+      AT_CHECK(
+          it != functions_.end(),
+          "RpcAgent: no function named '",
+          name,
+          "' is registered on rank ",
+          rank_);
+      fn = it->second;
+    }
+    return Message::fromIValues(
+        MessageType::RESPONSE, request.id, fn(std::move(args)));
+  } catch (const std::exception& e) {
+    return Message::exception(request.id, e.what());
+  }
+}
+
+void RpcAgent::handleResponse(Message&& response) {
+  AT_ASSERT(
+      response.type == MessageType::RESPONSE ||
+      response.type == MessageType::EXCEPTION);
+  c10::intrusive_ptr<c10::ivalue::Future> future;
+  {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    auto it = pending_.find(response.id);
+    AT_ASSERTM(
+        it != pending_.end(),
+        "RpcAgent: response to unknown request ",
+        response.id);
+    future = std::move(it->second);
+    pending_.erase(it);
+  }
+  try {
+    completeFuture(future, response);
+  } catch (const std::exception& e) {
+    // the results couldn't be unpickled
+    if (!future->completed()) {
+      future->markCompleted(c10::ivalue::Future::FutureError(e.what()));
+    }
+  }
+  pendingCV_.notify_all();
+}
+
+void RpcAgent::failPendingCalls(const std::string& what) {
+  std::unordered_map<int64_t, c10::intrusive_ptr<c10::ivalue::Future>> pending;
+  {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    std::swap(pending, pending_);
+  }
+  for (auto& entry : pending) {
+    entry.second->markCompleted(
+        c10::ivalue::Future::FutureError(std::string(what)));
+  }
+  pendingCV_.notify_all();
+}
+
+void RpcAgent::waitPendingCalls() {
+  std::unique_lock<std::mutex> lock(pendingMutex_);
+  pendingCV_.wait(lock, [&] { return pending_.empty(); });
+}
+
+} // namespace rpc
+} // namespace distributed
+} // namespace torch
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <ATen/core/ivalue.h>
+#include <torch/csrc/distributed/rpc/message.h>
+
+namespace torch {
+namespace distributed {
+namespace rpc {
+
+// A function that can be called remotely. It takes the arguments of the call
+// and returns its results.
+using RpcFunction =
+    std::function<std::vector<c10::IValue>(std::vector<c10::IValue>)>;
+
+// An RpcAgent calls the functions registered on the agents of other
+// processes and runs the calls they make to its own functions.
+//
+// Calls are asynchronous: `call` returns a future that completes with a tuple
+// of the results once the response arrives, or with the error the function
+// threw. Arguments and results are any IValues the JIT pickler supports, and
+// the data of the tensors among them is sent as is, next to the pickle.
+//
+// Subclasses implement the transport: they send messages with `send` and
+// pass the messages they receive to `handleRequest` and `handleResponse`.
+class RpcAgent {
+ public:
+  RpcAgent(int rank, int worldSize);
+  virtual ~RpcAgent();
+
+  int rank() const {
+    return rank_;
+  }
+
+  int worldSize() const {
+    return worldSize_;
+  }
+
+  // Registers `fn` as `name`, replacing the function the name had. Register
+  // the functions before the other agents call them, e.g. by calling `sync`
+  // afterwards on all agents.
+  void registerFunction(const std::string& name, RpcFunction fn);
+
+  // Calls the function `name` of the agent `dst` with `args`. A call to the
+  // agent itself runs in the calling thread.
+  c10::intrusive_ptr<c10::ivalue::Future> call(
+      int dst,
+      const std::string& name,
+      std::vector<c10::IValue> args);
+
+  // Blocks until all agents reached `sync`.
+  virtual void sync() = 0;
+
+  // Waits for the responses of the calls of this agent, then for all agents
+  // to do the same, and stops the agent. Must be called on all agents, after
+  // which none of them can call any more.
+  virtual void join() = 0;
+
+ protected:
+  virtual void send(int dst, Message&& message) = 0;
+
+  // Runs the function of a REQUEST message and returns the RESPONSE, or the
+  // EXCEPTION if the function threw.
+  Message handleRequest(const Message& request);
+
+  // Completes the future of the call a RESPONSE or EXCEPTION message answers.
+  void handleResponse(Message&& response);
+
+  // Fails the futures of all calls awaiting a response, e.g. if the
+  // transport broke.
+  void failPendingCalls(const std::string& what);
+
+  // Blocks until all calls of this agent completed.
+  void waitPendingCalls();
+
+  const int rank_;
+  const int worldSize_;
+
+ private:
+  std::mutex functionsMutex_;
+  std::unordered_map<std::string, RpcFunction> functions_;
+
+  std::atomic<int64_t> nextId_;
+  std::mutex pendingMutex_;
+  std::condition_variable pendingCV_;
+  std::unordered_map<int64_t, c10::intrusive_ptr<c10::ivalue::Future>>
+      pending_;
+};
+
+} // namespace rpc
+} // namespace distributed
+} // namespace torch
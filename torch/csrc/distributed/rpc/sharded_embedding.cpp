@@ -0,0 +1,164 @@
+#include <torch/csrc/distributed/rpc/sharded_embedding.h>
+
+#include <c10/util/Exception.h>
+#include <torch/csrc/autograd/generated/variable_factories.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace torch {
+namespace distributed {
+namespace rpc {
+
+namespace {
+
+at::Tensor indexTensor(const std::vector<int64_t>& indices) {
+  return torch::tensor(at::ArrayRef<int64_t>(indices));
+}
+
+} // namespace
+
+ShardedEmbedding::ShardedEmbedding(
+    std::shared_ptr<RpcAgent> agent,
+    std::string name,
+    int64_t numEmbeddings,
+    at::Tensor shard)
+    : agent_(std::move(agent)),
+      name_(std::move(name)),
+      numEmbeddings_(numEmbeddings),
+      rowsPerShard_(
+          (numEmbeddings + agent_->worldSize() - 1) / agent_->worldSize()),
+      state_(std::make_shared<State>()) {
+  AT_CHECK(numEmbeddings > 0, "ShardedEmbedding: expected rows");
+  AT_CHECK(
+      shard.dim() == 2 && shard.size(0) == shardSize(agent_->rank()),
+      "ShardedEmbedding: expected a shard of ",
+      shardSize(agent_->rank()),
+      " rows on rank ",
+      agent_->rank(),
+      ", got a tensor of size ",
+      shard.sizes());
+  AT_CHECK(
+      !shard.requires_grad(),
+      "ShardedEmbedding: the shard can't require grad, it's updated in place");
+  state_->shard = std::move(shard);
+
+  auto state = state_;
+  agent_->registerFunction(
+      name_ + ".lookup", [state](std::vector<c10::IValue> args) {
+        AT_ASSERT(args.size() == 1);
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return std::vector<c10::IValue>{
+            state->shard.index_select(0, args[0].toTensor())};
+      });
+  agent_->registerFunction(
+      name_ + ".update", [state](std::vector<c10::IValue> args) {
+        AT_ASSERT(args.size() == 3);
+        const auto grad = args[1].toTensor().to(state->shard.scalar_type());
+        const auto lr = args[2].toDouble();
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->shard.index_add_(0, args[0].toTensor(), grad * -lr);
+        return std::vector<c10::IValue>();
+      });
+  // the other agents can call the functions once they're registered on all
+  agent_->sync();
+}
+
+int64_t ShardedEmbedding::shardSize(int rank) const {
+  const int64_t begin = std::min(rank * rowsPerShard_, numEmbeddings_);
+  const int64_t end = std::min(begin + rowsPerShard_, numEmbeddings_);
+  return end - begin;
+}
+
+ShardedEmbedding::Partition ShardedEmbedding::partition(
+    const at::Tensor& indices) const {
+  AT_CHECK(
+      !at::isFloatingType(indices.scalar_type()),
+      "ShardedEmbedding: expected integer indices, got ",
+      indices.scalar_type());
+  const auto flat = indices.reshape({-1}).to(at::kLong).cpu().contiguous();
+  const auto data = flat.data<int64_t>();
+  Partition partition;
+  partition.rows.resize(agent_->worldSize());
+  partition.positions.resize(agent_->worldSize());
+  for (int64_t i = 0; i < flat.numel(); i++) {
+    const int64_t index = data[i];
+    AT_CHECK(
+        index >= 0 && index < numEmbeddings_,
+        "ShardedEmbedding: index ",
+        index,
+        " is out of range for a table of ",
+        numEmbeddings_,
+        " rows");
+    const int64_t rank = index / rowsPerShard_;
+    partition.rows[rank].push_back(index - rank * rowsPerShard_);
+    partition.positions[rank].push_back(i);
+  }
+  return partition;
+}
+
+at::Tensor ShardedEmbedding::lookup(const at::Tensor& indices) {
+  auto parts = partition(indices);
+  const auto& shard = state_->shard;
+  auto output =
+      torch::empty({indices.numel(), shard.size(1)}, shard.options());
+
+  // send all requests before waiting for any
+  std::vector<std::pair<int, c10::intrusive_ptr<c10::ivalue::Future>>> calls;
+  for (int rank = 0; rank < agent_->worldSize(); rank++) {
+    if (!parts.rows[rank].empty()) {
+      calls.emplace_back(
+          rank,
+          agent_->call(
+              rank, name_ + ".lookup", {indexTensor(parts.rows[rank])}));
+    }
+  }
+  for (auto& call : calls) {
+    call.second->wait();
+    const auto rows =
+        call.second->value().toTuple()->elements().at(0).toTensor();
+    output.index_copy_(0, indexTensor(parts.positions[call.first]), rows);
+  }
+
+  auto sizes = indices.sizes().vec();
+  sizes.push_back(shard.size(1));
+  return output.view(sizes);
+}
+
+void ShardedEmbedding::update(
+    const at::Tensor& indices,
+    const at::Tensor& grad,
+    double lr) {
+  const auto& shard = state_->shard;
+  auto sizes = indices.sizes().vec();
+  sizes.push_back(shard.size(1));
+  AT_CHECK(
+      grad.sizes().equals(sizes),
+      "ShardedEmbedding: expected a gradient of size ",
+      at::IntArrayRef(sizes),
+      ", got ",
+      grad.sizes());
+  auto parts = partition(indices);
+  const auto flatGrad = grad.detach().reshape({indices.numel(), shard.size(1)}).cpu();
+
+  std::vector<c10::intrusive_ptr<c10::ivalue::Future>> calls;
+  for (int rank = 0; rank < agent_->worldSize(); rank++) {
+    if (!parts.rows[rank].empty()) {
+      calls.push_back(agent_->call(
+          rank,
+          name_ + ".update",
+          {indexTensor(parts.rows[rank]),
+           flatGrad.index_select(0, indexTensor(parts.positions[rank])),
+           lr}));
+    }
+  }
+  for (auto& call : calls) {
+    call->wait();
+    // throws the error of a failed update
+    call->value();
+  }
+}
+
+} // namespace rpc
+} // namespace distributed
+} // namespace torch
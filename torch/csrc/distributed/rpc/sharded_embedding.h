@@ -0,0 +1,82 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <ATen/ATen.h>
+#include <torch/csrc/distributed/rpc/rpc_agent.h>
+
+namespace torch {
+namespace distributed {
+namespace rpc {
+
+// An embedding table whose rows are split in contiguous shards over the
+// agents of an RpcAgent, i.e. a parameter server for embeddings too large for
+// one process. Every agent serves its shard and can look up and update any
+// row, with one call per shard for a whole batch of indices.
+//
+// The rank r holds the rows [r * rowsPerShard, (r + 1) * rowsPerShard), and
+// the last shards hold fewer, or no rows.
+class ShardedEmbedding {
+ public:
+  // Creates the table `name` from the shard of this rank, a tensor of
+  // shardSize(rank) x embedding dimension, which the table updates in place.
+  // Must be called on all agents, with the same name and number of rows.
+  ShardedEmbedding(
+      std::shared_ptr<RpcAgent> agent,
+      std::string name,
+      int64_t numEmbeddings,
+      at::Tensor shard);
+
+  int64_t numEmbeddings() const {
+    return numEmbeddings_;
+  }
+
+  int64_t rowsPerShard() const {
+    return rowsPerShard_;
+  }
+
+  // The number of rows the rank holds.
+  int64_t shardSize(int rank) const;
+
+  const at::Tensor& shard() const {
+    return state_->shard;
+  }
+
+  // Returns the rows `indices` of the table, in a tensor of
+  // indices.sizes() x embedding dimension.
+  at::Tensor lookup(const at::Tensor& indices);
+
+  // Does an SGD step on the rows `indices` of the table: subtracts
+  // lr * grad, with grad being e.g. the gradient of the result of
+  // lookup(indices). The gradients of repeated indices add up.
+  void update(const at::Tensor& indices, const at::Tensor& grad, double lr);
+
+ private:
+  // What the functions of the agent use, which they may outlive.
+  struct State {
+    at::Tensor shard;
+    // the lookups and updates of the shard run concurrently
+    std::mutex mutex;
+  };
+
+  // The rows of each shard among `indices`, in shard local indices, and their
+  // positions in `indices`.
+  struct Partition {
+    std::vector<std::vector<int64_t>> rows;
+    std::vector<std::vector<int64_t>> positions;
+  };
+
+  Partition partition(const at::Tensor& indices) const;
+
+  std::shared_ptr<RpcAgent> agent_;
+  const std::string name_;
+  const int64_t numEmbeddings_;
+  const int64_t rowsPerShard_;
+  std::shared_ptr<State> state_;
+};
+
+} // namespace rpc
+} // namespace distributed
+} // namespace torch
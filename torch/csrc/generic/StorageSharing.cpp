@@ -237,14 +237,13 @@ static PyObject * THPStorage_(shareCuda)(THPStorage *self)
   THPObjectPtr _event_sync_required(Py_None);
   Py_INCREF(Py_None);
   if (THWStorage_(data)(LIBRARY_STATE storage)) {
-    size_t base_size;
-    void *base_ptr = c10::cuda::CUDACachingAllocator::getBaseAllocation(THWStorage_(data)(LIBRARY_STATE storage), &base_size);
-    ptrdiff_t offset_bytes = (char*)storage->data<scalar_t>() - (char*)base_ptr;
+    // The handle of the segment is cached by the allocator, so sharing many
+    // storages of one segment only asks the driver once
+    size_t offset_bytes;
+    std::string handle = c10::cuda::CUDACachingAllocator::getIpcMemHandle(
+        THWStorage_(data)(LIBRARY_STATE storage), &offset_bytes);
 
-    cudaIpcMemHandle_t handle;
-    THCudaCheck(cudaIpcGetMemHandle(&handle, base_ptr));
-
-    _handle = PyBytes_FromStringAndSize((char *)&handle, CUDA_IPC_HANDLE_SIZE);
+    _handle = PyBytes_FromStringAndSize(handle.data(), handle.size());
     _offset_bytes = PyLong_FromSsize_t((Py_ssize_t)offset_bytes);
 
     // Put Storage Data behind new ref counting context
@@ -312,21 +311,7 @@ static PyObject * THPStorage_(releaseIPCCounter)(PyObject *_unused, PyObject *ar
   std::string ref_counter_handle = PyBytes_AS_STRING(_ref_counter);
   ptrdiff_t ref_counter_offset =
       (ptrdiff_t)THPUtils_unpackLong(_ref_counter_offset);
-  // We don't want to break existing code, so resource deletion is best
-  // effort basis. Exception expected if producer process terminated
-  // before consumer released data.
-  int flags =
-      TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_NOCREATE;
-  try {
-    auto sptr = THRefcountedMapAllocator::makeDataPtr(
-        ref_counter_handle.c_str(),
-        flags,
-        sizeof(int64_t) * torch::CUDA_IPC_REF_COUNTER_FILE_SIZE,
-        nullptr);
-    *(static_cast<int64_t*>(sptr.get()) + ref_counter_offset) -= 1;
-  } catch (c10::Error) {
-    // Already warned inside of producer process
-  }
+  torch::CudaIPCReleaseRefCounter(ref_counter_handle, ref_counter_offset);
   Py_RETURN_NONE;
   END_HANDLE_TH_ERRORS
 }
@@ -404,35 +389,19 @@ static PyObject * THPStorage_(newSharedCuda)(PyObject *_unused, PyObject *args)
   auto sp = std::shared_ptr<void>(
       (void*)c, [ref_counter_handle, ref_counter_offset, device](void* ptr) {
         delete static_cast<torch::CudaIPCReceivedData*>(ptr);
-        // Sync default stream to make sure all operations related to the storage is
-        // finished (otherwise another process may reuse memory and corrupt
-        // data)
+        // The counter is released once all operations related to the storage
+        // queued on the current stream are finished (otherwise another process
+        // may reuse memory and corrupt data)
 
         // Ideally all shared memory reference counting could be replaced by
         // sending untriggered CUDA event from the producer to consumer and
         // using this event as the criteria of memory release. However, CUDA (atm 10.1)
         // does not support the creation of untriggered events and performance
         // impact of having thousands of shared events is unknown.
-
-        // TODO: Instead of cudaStreamSynchronize it is possible to add Stream
-        // Callback and release counter inside of it (need to check performance impact)
-        cudaStreamSynchronize(c10::cuda::getCurrentCUDAStream(device));
-
-        // We don't want to break existing code, so resource deletion is best
-        // effort basis. Exception expected if producer process terminated
-        // before consumer released data.
-        int flags =
-            TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_NOCREATE;
-        try {
-          auto sptr = THRefcountedMapAllocator::makeDataPtr(
-              ref_counter_handle.c_str(),
-              flags,
-              sizeof(int64_t) * torch::CUDA_IPC_REF_COUNTER_FILE_SIZE,
-              nullptr);
-          *(static_cast<int64_t*>(sptr.get()) + ref_counter_offset) -= 1;
-        } catch (c10::Error) {
-          // Already warned inside of producer process
-        }
+        torch::CudaIPCReleaseRefCounterAsync(
+            ref_counter_handle,
+            ref_counter_offset,
+            c10::cuda::getCurrentCUDAStream(device));
       });
 
   THWStoragePtr base(THWStorage_(newWithDataAndAllocator)(
@@ -185,6 +185,114 @@ ArgumentSpec ArgumentSpecCreator::create(bool with_grad, const Stack& input)
   return spec;
 }
 
+bool ArgumentSpecCreator::matches(
+    const ArgumentSpec& spec,
+    bool with_grad,
+    const Stack& input) const {
+  // spec was created by this creator, so as long as the optionals match the
+  // tensors line up with its entries
+  const IValue* stack[DEPTH_LIMIT]; // as in create()
+  stack[0] = last(input, num_inputs_).begin();
+  size_t stack_top = 0;
+  size_t tensor_offset = 0;
+  size_t optional_offset = 0;
+  for (Inst inst : instructions_) {
+    switch (inst) {
+      case SPECIALIZE_OPTIONAL_TENSOR: {
+        auto& arg = *stack[stack_top]++;
+        if (!spec.matchesOptional(optional_offset++, arg)) {
+          return false;
+        }
+        if (!arg.isNone() &&
+            !spec.matchesTensor(tensor_offset++, arg, with_grad)) {
+          return false;
+        }
+      } break;
+      case SPECIALIZE_TENSOR:
+        if (!spec.matchesTensor(
+                tensor_offset++, *stack[stack_top]++, with_grad)) {
+          return false;
+        }
+        break;
+      case SPECIALIZE_OPTIONAL:
+        if (!spec.matchesOptional(optional_offset++, *stack[stack_top]++)) {
+          return false;
+        }
+        break;
+      case ENTER_TUPLE: {
+        const IValue* iv = stack[stack_top]++;
+        AT_ASSERT(iv->isTuple());
+        // see [argspec refcounting]
+        auto p = *reinterpret_cast<const at::ivalue::Tuple* const*>(iv);
+        stack[++stack_top] = &p->elements()[0];
+      } break;
+      case ENTER_OBJECT: {
+        const IValue* iv = stack[stack_top]++;
+        AT_ASSERT(iv->isObject());
+        // see [argspec refcounting]
+        auto p = *reinterpret_cast<const at::ivalue::Object* const*>(iv);
+        stack[++stack_top] = &p->slots()[0];
+      } break;
+      case SKIP:
+        stack[stack_top]++;
+        break;
+      case LEAVE:
+        --stack_top;
+        break;
+    }
+  }
+  return true;
+}
+
+ArgumentSpec ArgumentSpecCreator::create(
+    at::ArrayRef<ArgumentInfo> tensors,
+    const std::vector<bool>& optionals) const {
+  AT_CHECK(
+      optionals.size() == num_optionals_,
+      "expected a spec of ",
+      num_optionals_,
+      " optionals, but got ",
+      optionals.size());
+  ArgumentSpec spec(num_tensors_, num_optionals_);
+  size_t tensor_offset = 0;
+  size_t optional_offset = 0;
+  auto addTensor = [&] {
+    AT_CHECK(
+        tensor_offset < tensors.size(),
+        "expected a spec of more than ",
+        tensors.size(),
+        " tensors");
+    spec.addTensor(tensors[tensor_offset++]);
+  };
+  for (Inst inst : instructions_) {
+    switch (inst) {
+      case SPECIALIZE_OPTIONAL_TENSOR: {
+        bool is_present = optionals[optional_offset++];
+        spec.addOptional(is_present);
+        if (is_present) {
+          addTensor();
+        }
+      } break;
+      case SPECIALIZE_TENSOR:
+        addTensor();
+        break;
+      case SPECIALIZE_OPTIONAL:
+        spec.addOptional(optionals[optional_offset++]);
+        break;
+      default:
+        // the other instructions only walk the inputs
+        break;
+    }
+  }
+  AT_CHECK(
+      tensor_offset == tensors.size(),
+      "expected a spec of ",
+      tensor_offset,
+      " tensors, but got ",
+      tensors.size());
+  return spec;
+}
+
 // For every input of a given graph, returns a most detailed type that can be
 // inferred for it based on this ArgumentSpec.
 void ArgumentSpecCreator::specializeTypes(
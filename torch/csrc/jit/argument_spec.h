@@ -45,6 +45,17 @@ struct ArgumentInfo {
     return DimensionedTensorType::create(
         type(), ConvertIntToCPUOrCUDA(device()), dim());
   }
+  // The raw bits of this struct, e.g. to save it with a model
+  plain_data_type toPlainData() const {
+    plain_data_type data;
+    std::memcpy(&data, this, sizeof(ArgumentInfo));
+    return data;
+  }
+  static ArgumentInfo fromPlainData(plain_data_type data) {
+    ArgumentInfo arg;
+    std::memcpy(&arg, &data, sizeof(ArgumentInfo));
+    return arg;
+  }
 
  private:
   unsigned defined_ : 1;
@@ -71,34 +82,38 @@ struct ArgumentSpec {
   }
 
   void addOptional(const IValue& input) {
-    bool is_present = !input.isNone();
+    addOptional(!input.isNone());
+  }
+
+  void addOptional(bool is_present) {
     optional_presence.push_back(is_present);
     hash_code = hash_combine(hash_code, is_present);
   }
 
   void addTensor(const IValue& input, bool with_grad) {
-    AT_ASSERT(input.isTensor());
     tensor_args.emplace_back();
     auto& arg = tensor_args.back();
-    // Initialize all fields to 0. This is convenient, because e.g.
-    // requires_grad() can be checked even on tensors AND will make
-    // padding bits all 0s.
-    std::memset(&arg, 0, sizeof(ArgumentInfo));
+    fillInfo(arg, input, with_grad);
+    combineHash(arg);
+  }
 
-    // [argspec refcounting] reinterpret the IValue to avoid having to refcount
-    // the Tensor microbenchmarks
-    // https://github.com/zdevito/pytorch/commit/21e7200a0a0fc456bea2f10e95b1781f83933d10
-    // show overhead in extra refcounting along this path
-    const at::Tensor* t = reinterpret_cast<const at::Tensor*>(&input);
-    if ((arg.defined_ = t->defined())) {
-      arg.requires_grad_ = with_grad && autograd::Variable(*t).requires_grad();
-      arg.dim_ = t->dim();
-      arg.device_ = t->is_cuda() ? t->get_device() : -1;
-      arg.type_ = static_cast<unsigned>(t->scalar_type());
-    }
+  void addTensor(const ArgumentInfo& arg) {
+    tensor_args.push_back(arg);
     combineHash(arg);
   }
 
+  // Whether the i-th tensor (or optional) of this spec is the one that
+  // addTensor (or addOptional) would record for `input`. These let a spec be
+  // compared against inputs without creating a new one.
+  bool matchesTensor(size_t i, const IValue& input, bool with_grad) const {
+    ArgumentInfo arg;
+    fillInfo(arg, input, with_grad);
+    return std::memcmp(&arg, &tensor_args[i], sizeof(ArgumentInfo)) == 0;
+  }
+  bool matchesOptional(size_t i, const IValue& input) const {
+    return optional_presence[i] == !input.isNone();
+  }
+
   void combineHash(const ArgumentInfo& arg) {
     ArgumentInfo::plain_data_type arg_data;
     std::memcpy(&arg_data, &arg, sizeof(ArgumentInfo));
@@ -143,6 +158,26 @@ struct ArgumentSpec {
   }
 
  private:
+  static void fillInfo(ArgumentInfo& arg, const IValue& input, bool with_grad) {
+    AT_ASSERT(input.isTensor());
+    // Initialize all fields to 0. This is convenient, because e.g.
+    // requires_grad() can be checked even on tensors AND will make
+    // padding bits all 0s.
+    std::memset(&arg, 0, sizeof(ArgumentInfo));
+
+    // [argspec refcounting] reinterpret the IValue to avoid having to refcount
+    // the Tensor microbenchmarks
+    // https://github.com/zdevito/pytorch/commit/21e7200a0a0fc456bea2f10e95b1781f83933d10
+    // show overhead in extra refcounting along this path
+    const at::Tensor* t = reinterpret_cast<const at::Tensor*>(&input);
+    if ((arg.defined_ = t->defined())) {
+      arg.requires_grad_ = with_grad && autograd::Variable(*t).requires_grad();
+      arg.dim_ = t->dim();
+      arg.device_ = t->is_cuda() ? t->get_device() : -1;
+      arg.type_ = static_cast<unsigned>(t->scalar_type());
+    }
+  }
+
   size_t hash_code; // precomputed on construction
   std::vector<ArgumentInfo> tensor_args;
   std::vector<bool> optional_presence;
@@ -173,6 +208,15 @@ struct TORCH_API ArgumentSpecCreator {
   };
   ArgumentSpecCreator(Graph& graph);
   ArgumentSpec create(bool with_grad, const Stack& stack) const;
+  // Same as create(with_grad, stack) == spec, but without building a spec
+  bool matches(const ArgumentSpec& spec, bool with_grad, const Stack& stack)
+      const;
+  // The spec with these tensors and optionals (see ArgumentSpec::tensorAt and
+  // isPresent), e.g. those of a spec saved with a model by the creator of an
+  // identical graph, in the order create() would add them.
+  ArgumentSpec create(
+      at::ArrayRef<ArgumentInfo> tensors,
+      const std::vector<bool>& optionals) const;
   void specializeTypes(Graph& g, const ArgumentSpec& spec) const;
   void dump() const;
   using WrittenSlots = std::unordered_set<std::string>;
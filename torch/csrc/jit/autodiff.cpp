@@ -66,6 +66,7 @@ bool isDifferentiable(Node* n) {
       "aten::fmod(Tensor self, Scalar other) -> Tensor",
       "aten::remainder(Tensor self, Scalar other) -> Tensor",
       "aten::max_pool2d_with_indices(Tensor self, int[] kernel_size, int[] stride, int[] padding, int[] dilation, bool ceil_mode) -> (Tensor, Tensor)",
+      "aten::_fused_bias_dropout_add(Tensor self, Tensor bias, Tensor residual, float p, Generator? generator) -> (Tensor, Tensor)",
       "aten::thnn_conv2d_forward(Tensor self, Tensor weight, int[] kernel_size, Tensor? bias, int[] stride, int[] padding) -> (Tensor, Tensor, Tensor)",
       "aten::native_batch_norm(Tensor input, Tensor? weight, Tensor? bias, Tensor? running_mean, Tensor? running_var, bool training, float momentum, float eps) -> (Tensor, Tensor, Tensor)",
   };
@@ -368,6 +369,24 @@ class GradientHelper {
               nullptr,
               nullptr};
 
+    } else if (
+        node->matches(
+            "aten::_fused_bias_dropout_add(Tensor self, Tensor bias, Tensor residual, float p, Generator? generator) -> (Tensor, Tensor)")) {
+      AT_ASSERT(grads.size() == 2);
+      auto graph = node->owningGraph();
+      auto backward_value = graph->insert(
+          aten::_fused_bias_dropout_add_backward,
+          {grads.at(0).value(), outputs.at(1).value(), inputs.at(3).value()});
+      Node* tuple_unpack_node =
+          graph->insertNode(graph->createTupleUnpack(backward_value));
+      auto tuple_outputs = tuple_unpack_node->outputs();
+      AT_ASSERT(tuple_outputs.size() == size_t(2));
+      return {tuple_outputs[0],
+              tuple_outputs[1],
+              grads.at(0).value(),
+              nullptr,
+              nullptr};
+
     } else if (
         node->matches(
             "aten::thnn_conv2d_forward(Tensor self, Tensor weight, int[] kernel_size, Tensor? bias, int[] stride, int[] padding) -> (Tensor, Tensor, Tensor)")) {
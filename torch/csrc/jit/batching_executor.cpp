@@ -0,0 +1,328 @@
+#include <torch/csrc/jit/batching_executor.h>
+
+#include <ATen/ATen.h>
+#include <c10/util/Exception.h>
+#include <torch/csrc/autograd/grad_mode.h>
+
+#include <algorithm>
+#include <future>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using VariableLength = BatchingExecutorOptions::VariableLength;
+
+std::vector<double> powersOfTwo(int count) {
+  std::vector<double> bounds;
+  for (int i = 0; i < count; ++i) {
+    bounds.push_back(static_cast<double>(int64_t(1) << i));
+  }
+  return bounds;
+}
+
+// 100us to 10s
+std::vector<double> latencyBounds() {
+  std::vector<double> bounds;
+  for (double bound = 1e-4; bound < 20; bound *= 10) {
+    bounds.push_back(bound);
+    bounds.push_back(2.5 * bound);
+    bounds.push_back(5 * bound);
+  }
+  return bounds;
+}
+
+std::vector<at::Tensor> toTensors(const IValue& output) {
+  if (output.isTensor()) {
+    return {output.toTensor()};
+  }
+  AT_CHECK(
+      output.isTuple(),
+      "BatchingExecutor: the method must return a tensor or a tuple of ",
+      "tensors, but returned ",
+      output.tagKind());
+  std::vector<at::Tensor> tensors;
+  for (const auto& element : output.toTuple()->elements()) {
+    AT_CHECK(
+        element.isTensor(),
+        "BatchingExecutor: the method must return a tensor or a tuple of ",
+        "tensors, but returned a tuple holding ",
+        element.tagKind());
+    tensors.push_back(element.toTensor());
+  }
+  return tensors;
+}
+
+} // namespace
+
+struct BatchingExecutor::Request {
+  const std::vector<at::Tensor>* inputs;
+  std::vector<at::Tensor> outputs;
+  int64_t rows;
+  Clock::time_point enqueued;
+  std::promise<void> done;
+};
+
+BatchingExecutor::BatchingExecutor(
+    std::shared_ptr<script::Module> module,
+    BatchingExecutorOptions options)
+    : module_(std::move(module)), options_(std::move(options)) {
+  AT_CHECK(module_, "BatchingExecutor needs a module");
+  AT_CHECK(options_.max_batch_size > 0, "max_batch_size must be positive");
+  AT_CHECK(options_.batch_dim >= 0, "batch_dim must not be negative");
+  AT_CHECK(
+      options_.variable_length != VariableLength::Pad ||
+          (options_.pad_dim >= 0 && options_.pad_dim != options_.batch_dim),
+      "pad_dim must not be negative, nor be batch_dim");
+  // fails early if there is no such method
+  module_->get_method(options_.method_name);
+
+  auto& registry = c10::metrics::MetricsRegistry::get();
+  const auto& name = options_.metrics_name;
+  metrics_.requests = registry.counter(
+      name + "_requests_total", "Requests run by BatchingExecutor.");
+  metrics_.batches = registry.counter(
+      name + "_batches_total", "Batches run by BatchingExecutor.");
+  metrics_.failures = registry.counter(
+      name + "_failures_total", "Batches of BatchingExecutor that threw.");
+  metrics_.queued = registry.gauge(
+      name + "_queued_requests",
+      "Requests waiting to be batched by BatchingExecutor.");
+  metrics_.batch_size = registry.histogram(
+      name + "_batch_size",
+      "Rows of the batches of BatchingExecutor.",
+      powersOfTwo(13));
+  metrics_.latency = registry.histogram(
+      name + "_latency_seconds",
+      "Time from the submission of a request to BatchingExecutor to its "
+      "result.",
+      latencyBounds());
+
+  scheduler_ = std::thread([this] { schedule(); });
+}
+
+BatchingExecutor::~BatchingExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  scheduler_.join();
+}
+
+std::vector<at::Tensor> BatchingExecutor::run(
+    const std::vector<at::Tensor>& inputs) {
+  AT_CHECK(!inputs.empty(), "BatchingExecutor needs at least one input");
+  int64_t rows = -1;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    AT_CHECK(
+        inputs[i].dim() > options_.batch_dim,
+        "Input ",
+        i,
+        " has no dimension ",
+        options_.batch_dim,
+        " to batch along");
+    AT_CHECK(
+        options_.variable_length != VariableLength::Pad ||
+            inputs[i].dim() > options_.pad_dim,
+        "Input ",
+        i,
+        " has no dimension ",
+        options_.pad_dim,
+        " to pad");
+    if (rows < 0) {
+      rows = inputs[i].size(options_.batch_dim);
+    }
+    AT_CHECK(
+        inputs[i].size(options_.batch_dim) == rows,
+        "All inputs must have the same batch size, but input ",
+        i,
+        " has a different one");
+  }
+
+  Request request;
+  request.inputs = &inputs;
+  request.rows = rows;
+  request.enqueued = Clock::now();
+  auto done = request.done.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AT_CHECK(!stop_, "BatchingExecutor is shutting down");
+    queue_.push_back(&request);
+    queued_rows_ += rows;
+  }
+  cv_.notify_all();
+  metrics_.requests->add();
+  metrics_.queued->add();
+
+  done.get();
+  metrics_.latency->observe(
+      std::chrono::duration<double>(Clock::now() - request.enqueued).count());
+  return std::move(request.outputs);
+}
+
+bool BatchingExecutor::batchesWith(const Request& a, const Request& b) const {
+  if (a.inputs->size() != b.inputs->size()) {
+    return false;
+  }
+  const bool pad = options_.variable_length == VariableLength::Pad;
+  for (size_t i = 0; i < a.inputs->size(); ++i) {
+    const auto& x = (*a.inputs)[i];
+    const auto& y = (*b.inputs)[i];
+    if (x.type() != y.type() || x.device() != y.device() ||
+        x.dim() != y.dim()) {
+      return false;
+    }
+    for (int64_t d = 0; d < x.dim(); ++d) {
+      if (d != options_.batch_dim && !(pad && d == options_.pad_dim) &&
+          x.size(d) != y.size(d)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void BatchingExecutor::schedule() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+    // Wait for more requests until the batch is full or the oldest request
+    // has waited long enough
+    auto deadline = queue_.front()->enqueued + options_.max_latency;
+    cv_.wait_until(lock, deadline, [this] {
+      return stop_ || queued_rows_ >= options_.max_batch_size;
+    });
+
+    std::vector<Request*> batch;
+    int64_t rows = 0;
+    while (!queue_.empty()) {
+      Request* next = queue_.front();
+      if (!batch.empty() &&
+          (rows + next->rows > options_.max_batch_size ||
+           !batchesWith(*batch.front(), *next))) {
+        break;
+      }
+      batch.push_back(next);
+      rows += next->rows;
+      queue_.pop_front();
+    }
+    queued_rows_ -= rows;
+    metrics_.queued->add(-static_cast<int64_t>(batch.size()));
+
+    lock.unlock();
+    runBatch(batch);
+    lock.lock();
+  }
+}
+
+void BatchingExecutor::runBatch(const std::vector<Request*>& batch) {
+  const auto batch_dim = options_.batch_dim;
+  const auto pad_dim = options_.pad_dim;
+  int64_t rows = 0;
+  for (const Request* request : batch) {
+    rows += request->rows;
+  }
+  metrics_.batches->add();
+  metrics_.batch_size->observe(static_cast<double>(rows));
+
+  try {
+    autograd::AutoGradMode no_grad(false);
+    const auto& first = *batch.front()->inputs;
+    std::vector<IValue> inputs;
+    // the padded length of every input
+    std::vector<int64_t> lengths(first.size(), 0);
+    for (size_t i = 0; i < first.size(); ++i) {
+      if (options_.variable_length == VariableLength::Pad) {
+        for (const Request* request : batch) {
+          lengths[i] =
+              std::max(lengths[i], (*request->inputs)[i].size(pad_dim));
+        }
+        auto sizes = first[i].sizes().vec();
+        sizes[batch_dim] = rows;
+        sizes[pad_dim] = lengths[i];
+        auto padded =
+            at::full(sizes, options_.padding_value, first[i].options());
+        int64_t begin = 0;
+        for (const Request* request : batch) {
+          const auto& part = (*request->inputs)[i];
+          padded.narrow(batch_dim, begin, request->rows)
+              .narrow(pad_dim, 0, part.size(pad_dim))
+              .copy_(part);
+          begin += request->rows;
+        }
+        inputs.emplace_back(std::move(padded));
+      } else if (batch.size() == 1) {
+        inputs.emplace_back(first[i]);
+      } else {
+        std::vector<at::Tensor> parts;
+        for (const Request* request : batch) {
+          parts.push_back((*request->inputs)[i]);
+        }
+        inputs.emplace_back(at::cat(parts, batch_dim));
+      }
+    }
+    // the extra argument is filled on the host, and is a variable like the
+    // inputs
+    const auto long_options =
+        first[0].options().dtype(at::kLong).device(at::kCPU);
+    if (options_.variable_length == VariableLength::Pad) {
+      auto row_lengths = at::empty({rows}, long_options);
+      int64_t begin = 0;
+      for (const Request* request : batch) {
+        row_lengths.narrow(0, begin, request->rows)
+            .fill_((*request->inputs)[0].size(pad_dim));
+        begin += request->rows;
+      }
+      inputs.emplace_back(row_lengths.to(first[0].device()));
+    } else if (options_.variable_length == VariableLength::Pack) {
+      auto offsets =
+          at::empty({static_cast<int64_t>(batch.size()) + 1}, long_options);
+      auto data = offsets.data<int64_t>();
+      data[0] = 0;
+      for (size_t r = 0; r < batch.size(); ++r) {
+        data[r + 1] = data[r] + batch[r]->rows;
+      }
+      inputs.emplace_back(offsets.to(first[0].device()));
+    }
+
+    auto outputs = toTensors(
+        module_->get_method(options_.method_name)(std::move(inputs)));
+
+    int64_t begin = 0;
+    for (Request* request : batch) {
+      request->outputs.clear();
+      for (const auto& output : outputs) {
+        if (output.dim() <= batch_dim || output.size(batch_dim) != rows) {
+          request->outputs.push_back(output);
+          continue;
+        }
+        auto part = output.narrow(batch_dim, begin, request->rows);
+        if (options_.variable_length == VariableLength::Pad &&
+            output.dim() > pad_dim && output.size(pad_dim) == lengths[0]) {
+          part = part.narrow(pad_dim, 0, (*request->inputs)[0].size(pad_dim));
+        }
+        request->outputs.push_back(std::move(part));
+      }
+      begin += request->rows;
+    }
+  } catch (...) {
+    metrics_.failures->add();
+    for (Request* request : batch) {
+      request->done.set_exception(std::current_exception());
+    }
+    return;
+  }
+
+  for (Request* request : batch) {
+    request->done.set_value();
+  }
+}
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/csrc/jit/script/module.h>
+
+#include <c10/util/Metrics.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace torch {
+namespace jit {
+
+struct TORCH_API BatchingExecutorOptions {
+  // How requests with inputs of different sizes outside of batch_dim batch.
+  enum class VariableLength {
+    // They don't: requests only batch if their inputs have the same sizes
+    // outside of batch_dim.
+    None,
+    // The inputs may differ in size along pad_dim, and are padded with
+    // padding_value to the longest of the batch. The method is given an
+    // extra, last argument: the int64 lengths along pad_dim of the rows of
+    // the batch. The outputs are trimmed back to the length of every
+    // request along pad_dim, where their size is that of the padded inputs.
+    Pad,
+    // The rows of a request along batch_dim are the steps of one sequence,
+    // as in torch.nn.utils.ragged.RaggedBatch. The method is given an extra,
+    // last argument: the int64 offsets of the requests along batch_dim, of
+    // size (number of requests + 1).
+    Pack,
+  };
+
+  // Largest number of rows, summed over the requests, to run the method on
+  // at once. A request that is larger on its own still runs, alone.
+  int64_t max_batch_size = 32;
+  // How long the oldest queued request may wait for others to batch with.
+  std::chrono::microseconds max_latency{1000};
+  // The dimension of the inputs and outputs holding the rows of a request.
+  int64_t batch_dim = 0;
+  VariableLength variable_length = VariableLength::None;
+  // The dimension of the inputs padded with VariableLength::Pad.
+  int64_t pad_dim = 1;
+  double padding_value = 0;
+  std::string method_name = "forward";
+  // Prefix of the exported metrics (see c10::metrics::MetricsRegistry).
+  std::string metrics_name = "torch_jit_batching_executor";
+};
+
+/**
+ * \brief Batches the requests of concurrent callers into single calls of a
+ * method of a script::Module.
+ *
+ * Callers block in run() while a scheduler thread concatenates the inputs of
+ * the queued requests along batch_dim, until there are max_batch_size rows
+ * or the oldest request has waited max_latency, calls the method once and
+ * splits its outputs back by rows. Requests batch together if their inputs
+ * have the same types, devices and sizes outside of batch_dim (see
+ * VariableLength for the exceptions). The method must return a tensor or a
+ * tuple of tensors; outputs whose size along batch_dim isn't the total
+ * number of rows are given whole to every request of the batch. The outputs
+ * of a request are views of the outputs of its batch.
+ *
+ * The method runs with grad mode disabled. Exports the number of requests,
+ * batches and failures, the number of queued requests, and histograms of
+ * the batch sizes and of the request latencies in seconds, under
+ * `metrics_name`.
+ */
+class TORCH_API BatchingExecutor {
+ public:
+  explicit BatchingExecutor(
+      std::shared_ptr<script::Module> module,
+      BatchingExecutorOptions options = BatchingExecutorOptions());
+
+  // Runs the queued requests and stops the scheduler.
+  ~BatchingExecutor();
+
+  // Runs the method on `inputs`, all of which must have the same size along
+  // batch_dim. Thread-safe. Throws if the method threw.
+  std::vector<at::Tensor> run(const std::vector<at::Tensor>& inputs);
+
+  script::Module& module() {
+    return *module_;
+  }
+
+ private:
+  struct Request;
+
+  void schedule();
+  void runBatch(const std::vector<Request*>& batch);
+  bool batchesWith(const Request& a, const Request& b) const;
+
+  struct Metrics {
+    c10::metrics::Counter* requests;
+    c10::metrics::Counter* batches;
+    c10::metrics::Counter* failures;
+    c10::metrics::Counter* queued;
+    c10::metrics::Histogram* batch_size;
+    c10::metrics::Histogram* latency;
+  };
+
+  std::shared_ptr<script::Module> module_;
+  const BatchingExecutorOptions options_;
+  Metrics metrics_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Request*> queue_;
+  int64_t queued_rows_ = 0;
+  bool stop_ = false;
+  std::thread scheduler_;
+};
+
+} // namespace jit
+} // namespace torch
@@ -3,6 +3,7 @@
 
 #include <torch/csrc/autograd/symbolic.h>
 #include <torch/csrc/jit/export.h>
+#include <torch/csrc/jit/graph_serialization.h>
 #include <torch/csrc/onnx/onnx.h>
 
 #include <ATen/core/functional.h>
@@ -486,7 +487,8 @@ class ScriptModuleSerializer final {
 
   void serialize(
       const script::Module& module,
-      const script::ExtraFilesMap& extra_files = script::ExtraFilesMap());
+      const script::ExtraFilesMap& extra_files = script::ExtraFilesMap(),
+      bool save_optimized_plans = false);
 
  private:
   void convertModel(
@@ -521,6 +523,11 @@ class ScriptModuleSerializer final {
       const std::string& name,
       torch::ModuleDef* module_def);
 
+  void writeOptimizedPlans(
+      const script::Module& module,
+      const std::string& module_name,
+      torch::ModuleDef* module_def);
+
   void convertParameter(
       const script::Slot& param,
       torch::ParameterDef* param_def,
@@ -541,6 +548,8 @@ class ScriptModuleSerializer final {
   OrderedDict<ClassTypePtr, std::string> converted_classes_;
   std::unordered_map<ClassTypePtr, std::vector<ClassTypePtr>> class_to_deps_;
 
+  bool save_optimized_plans_ = false;
+
   static const size_t op_version_set = 0;
 };
 
@@ -555,7 +564,9 @@ ScriptModuleSerializer::ScriptModuleSerializer(std::ostream* ofs)
 
 void ScriptModuleSerializer::serialize(
     const script::Module& module,
-    const script::ExtraFilesMap& extra_files) {
+    const script::ExtraFilesMap& extra_files,
+    bool save_optimized_plans) {
+  save_optimized_plans_ = save_optimized_plans;
   torch::ModelDef model_def;
   convertModel(module, &model_def, extra_files);
   std::string output;
@@ -804,12 +815,66 @@ void ScriptModuleSerializer::convertModule(
     record->set_key(filename.str());
   }
 
+  if (save_optimized_plans_) {
+    writeOptimizedPlans(module, module_name.str(), module_def);
+  }
+
   for (const auto& elem : module.get_modules()) {
     torch::ModuleDef* sub_def = module_def->add_submodules();
     convertModule(*elem, module_name.str(), elem->name(), sub_def);
   }
 }
 
+// The plans are only a cache of the optimizations of the methods, so the
+// plans that cannot be saved, e.g. those calling Python, are left out, and
+// will be optimized again after loading.
+void ScriptModuleSerializer::writeOptimizedPlans(
+    const script::Module& module,
+    const std::string& module_name,
+    torch::ModuleDef* module_def) {
+  if (!module.is_optimized()) {
+    return;
+  }
+  std::vector<IValue> plans;
+  for (const auto& method : module.get_methods()) {
+    for (const OptimizedPlan& plan :
+         method->get_executor().optimizedPlans()) {
+      IValue graph;
+      try {
+        graph = graphToIValue(*plan.graph);
+      } catch (const c10::Error& e) {
+        AT_WARN(
+            "Not saving an optimized plan of ",
+            method->name(),
+            ": ",
+            e.what_without_backtrace());
+        continue;
+      }
+      std::vector<int64_t> tensors = fmap(
+          plan.tensors, [](const ArgumentInfo& arg) -> int64_t {
+            return arg.toPlainData();
+          });
+      std::vector<int64_t> optionals(
+          plan.optionals.begin(), plan.optionals.end());
+      plans.emplace_back(c10::ivalue::Tuple::create(
+          {method->name(), std::move(tensors), std::move(optionals), graph}));
+    }
+  }
+  if (plans.empty()) {
+    return;
+  }
+  Pickler pickler(&tensor_table_);
+  pickler.start();
+  for (const IValue& plan : plans) {
+    pickler.addIValue(plan);
+  }
+  pickler.finish();
+  std::string filename = "plans/" + module_name + ".pkl";
+  writer_.writeRecord(
+      filename, pickler.stack().data(), pickler.stack().size());
+  module_def->mutable_optimized_plans()->set_key(filename);
+}
+
 void ScriptModuleSerializer::convertParameter(
     const script::Slot& param,
     torch::ParameterDef* param_def,
@@ -1043,17 +1108,19 @@ std::tuple<std::string, RawDataExportMap> export_onnx(
 void ExportModule(
     const script::Module& module,
     std::ostream& out,
-    const script::ExtraFilesMap& extra_files) {
+    const script::ExtraFilesMap& extra_files,
+    bool save_optimized_plans) {
   ScriptModuleSerializer serializer(&out);
-  serializer.serialize(module, extra_files);
+  serializer.serialize(module, extra_files, save_optimized_plans);
 }
 
 void ExportModule(
     const script::Module& module,
     const std::string& filename,
-    const script::ExtraFilesMap& extra_files) {
+    const script::ExtraFilesMap& extra_files,
+    bool save_optimized_plans) {
   ScriptModuleSerializer serializer(filename);
-  serializer.serialize(module, extra_files);
+  serializer.serialize(module, extra_files, save_optimized_plans);
 }
 
 } // namespace jit
@@ -41,12 +41,14 @@ TORCH_API std::string pretty_print_onnx(
 TORCH_API void ExportModule(
     const script::Module& module,
     std::ostream& out,
-    const script::ExtraFilesMap& metadata = script::ExtraFilesMap());
+    const script::ExtraFilesMap& metadata = script::ExtraFilesMap(),
+    bool save_optimized_plans = false);
 
 TORCH_API void ExportModule(
     const script::Module& module,
     const std::string& filename,
-    const script::ExtraFilesMap& metadata = script::ExtraFilesMap());
+    const script::ExtraFilesMap& metadata = script::ExtraFilesMap(),
+    bool save_optimized_plans = false);
 
 } // namespace jit
 } // namespace torch
@@ -26,7 +26,7 @@ namespace fuser {
 static auto dim_calc = CodeTemplate(R"(
 //printf("tensor ${tensor} sizes[${d}] = %d, strides[${d}] = %d\n", ${tensor}.sizes[${d}],${tensor}.strides[${d}]);
 size_t ${tensor}_dimIndex${d} = ${tensor}_linearIndex ${mod_sizes};
-${tensor}_offset += ${tensor}_dimIndex${d} ${times_stride};
+${tensor}_${offset} += ${tensor}_dimIndex${d} ${times_stride};
 )");
 
 static std::string valueName(const Value* n) {
@@ -289,14 +289,18 @@ static std::string encodeRHS(const Node* n) {
   }
 }
 
+// Computes ${tensor}_offset (or ${tensor}_tileOffset for the tiles of CPU
+// kernels) from linearIndex
 static void emitIndexingFor(
     std::ostream& out,
     const std::string& tensor,
     const int ndim,
-    const bool last_is_cont) {
+    const bool last_is_cont,
+    const std::string& offset = "offset") {
   TemplateEnv env;
   env.s("tensor", tensor);
-  out << format("IndexType ${tensor}_offset = 0;\n", env);
+  env.s("offset", offset);
+  out << format("IndexType ${tensor}_${offset} = 0;\n", env);
   out << format("IndexType ${tensor}_linearIndex = linearIndex;\n", env);
   for (int d = ndim - 1; d >= 0; --d) {
     env.d("d", d);
@@ -328,6 +332,9 @@ std::string generateKernel(
 
   std::stringstream body;
   std::stringstream tensorOffsets;
+  // CPU kernels only: the offsets of element i of a tile, and the tile rows
+  std::stringstream tileOffsets;
+  std::stringstream rowSizes;
   std::vector<std::string> formals;
   std::vector<std::string> argument_loads;
 
@@ -342,7 +349,6 @@ std::string generateKernel(
           std::to_string(
               formals.size()); // can't be unique() because Param may be an output
       const auto nDim = desc.nDim();
-      emitIndexingFor(tensorOffsets, tensor, nDim, desc.lastIsContiguous());
       env.s("tensor", tensor);
       env.d("nDim", nDim);
       env.s("scalar_type", scalarTypeName(desc.scalar_type));
@@ -351,6 +357,27 @@ std::string generateKernel(
       argument_loads.push_back(format(
           "*static_cast<TensorInfo<${scalar_type},${nDim}>*>(args[${formal_index}])",
           env));
+      if (use_cuda) {
+        emitIndexingFor(tensorOffsets, tensor, nDim, desc.lastIsContiguous());
+        return;
+      }
+      emitIndexingFor(
+          tensorOffsets, tensor, nDim, desc.lastIsContiguous(), "tileOffset");
+      if (nDim == 0) {
+        tileOffsets << format("size_t ${tensor}_offset = 0;\n", env);
+        return;
+      }
+      env.d("last", nDim - 1);
+      env.s(
+          "times_stride",
+          desc.lastIsContiguous() ? ""
+                                  : format(" * ${tensor}.strides[${last}]", env));
+      tileOffsets << format(
+          "size_t ${tensor}_offset = ${tensor}_tileOffset + i${times_stride};\n",
+          env);
+      env.s("argument_load", argument_loads.back());
+      rowSizes << format(
+          "rowSize = gcd(rowSize, (${argument_load}).sizes[${last}]);\n", env);
   };
 
   auto emitScalarFormal = [&](const Value* n){
@@ -422,6 +449,7 @@ std::string generateKernel(
   }
 
   bool has_random = false;
+  bool has_reduction = false;
   // Generates code for intermediate nodes
   // Note: Concat and Chunk are implicitly generated
   // Note: Random number generation is only supported for CUDA kernels.
@@ -436,6 +464,13 @@ std::string generateKernel(
       continue;
     if (n->mustBeNone())
       continue;
+    // Note: reductions are emitted as accumulating writes to their outputs,
+    // and their constant int[] dims are only used at compile time
+    if (n->kind() == aten::sum)
+      continue;
+    if (n->kind() == prim::Constant &&
+        n->output()->type()->kind() == TypeKind::ListType)
+      continue;
     if (n->kind() == aten::rand_like) {
       AT_ASSERT(use_cuda);
       has_random = true;
@@ -476,7 +511,14 @@ std::string generateKernel(
     // Acquires and converts (if needed) outputs
     // Note: conversion to half is only supported for CUDA kernels.
     const auto is_half = (output.second.scalar_type == at::ScalarType::Half);
-    if (is_half) {
+    if (output.first->node()->kind() == aten::sum) {
+      // Reduced outputs are expanded along the reduced dims, so every
+      // element of the map adds into its slot of the (zeroed) output
+      AT_ASSERT(!is_half);
+      env.s("node", valueName(output.first->node()->input(0)));
+      body << format("atomicAdd(&${access}, ${node});\n", env);
+      has_reduction = true;
+    } else if (is_half) {
       AT_ASSERT(use_cuda);
       body << format("${access} = __float2half(${node});\n", env);
       has_half_tensor = true;
@@ -505,6 +547,10 @@ std::string generateKernel(
 
   // Insantiates the CUDA or CPU-specific templates
   env.s("tensorOffsets", tensorOffsets.str());
+  env.s("tileOffsets", tileOffsets.str());
+  env.s("rowSizes", rowSizes.str());
+  // Elements of a tile may add into the same element of a reduced output
+  env.s("simd", has_reduction ? "" : "#pragma omp simd");
   env.s("kernelBody", body.str());
   env.v("formals", formals);
   env.v("argument_loads", argument_loads);
@@ -3,6 +3,7 @@
 #include <ATen/ATen.h>
 #include <ATen/core/jit_type.h>
 #include <c10/util/Exception.h>
+#include <c10/util/Metrics.h>
 #include <torch/csrc/jit/code_template.h>
 #include <torch/csrc/jit/fuser/codegen.h>
 #include <torch/csrc/jit/fuser/interface.h>
@@ -15,6 +16,7 @@
 #include <torch/csrc/jit/passes/shape_analysis.h>
 
 #include <atomic>
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <sstream>
@@ -222,6 +224,24 @@ void processGradSumToSize(KernelSpec& spec) {
   }
 }
 
+// Records the reduction of every kernel output produced by aten::sum. The
+// fuser only fuses sums as the last op of a group, so the summed value is
+// computed elementwise over the map and accumulated into the output.
+static void setOutputReductions(KernelSpec& spec) {
+  auto& reductions = spec.outputReductions();
+  AT_ASSERT(reductions.empty());
+  for (const Value* output : spec.graph()->outputs()) {
+    const Node* n = output->node();
+    if (n->kind() == aten::sum) {
+      reductions.emplace_back(ReductionInfo(
+          n->get<std::vector<int64_t>>(attr::dim).value(),
+          n->get<bool>(attr::keepdim).value()));
+    } else {
+      reductions.emplace_back(c10::nullopt);
+    }
+  }
+}
+
 // Performs "upfront" compilation where storage is known but shapes are not.
 // Currently identifies how to expand all tensors so that all intermediate
 // tensors are the same shape, simplifying code generation.
@@ -235,6 +255,7 @@ static void upfrontCompilation(KernelSpec& spec) {
   setInputBroadcastGroups(spec);
   setInputChunkDescriptors(spec);
   processGradSumToSize(spec);
+  setOutputReductions(spec);
 }
 
 int64_t registerFusion(const Node* fusion_group) {
@@ -264,6 +285,11 @@ std::shared_ptr<FusedKernel> compileKernel(
     const ArgSpec& arg_spec,
     const std::vector<int64_t>& map_size,
     const at::Device device) {
+  static auto* compile_seconds = c10::metrics::MetricsRegistry::get().histogram(
+      "torch_fuser_compile_seconds",
+      "Duration of the compilations of fusion kernels.",
+      {0.01, 0.1, 1, 10});
+  const auto start = std::chrono::steady_clock::now();
   const std::vector<TensorDesc>& input_desc = arg_spec.descs();
 
   auto graph = spec.graph()->copy();
@@ -273,7 +299,7 @@ std::shared_ptr<FusedKernel> compileKernel(
     graph->inputs()[i]->setType(DimensionedTensorType::create(
         desc.scalar_type,
         device,
-        desc.nDim())); // TODO: nDim is bad, as it is collapsed
+        desc.contiguity.size()));
   }
 
   PropagateInputShapes(graph);
@@ -308,15 +334,28 @@ std::shared_ptr<FusedKernel> compileKernel(
   std::vector<TensorDesc> output_desc;
   std::vector<PartitionDesc> concat_desc;
   std::vector<std::pair<const Value*, const TensorDesc>> flat_outputs;
-  for (const Value* o : graph->outputs()) {
+  for (size_t i = 0; i < graph->outputs().size(); ++i) {
+    const Value* o = graph->outputs()[i];
     // Creates output description
     std::vector<int64_t> sizes = map_size;
     if (o->node()->kind() == prim::FusedConcat) {
       sizes.at(o->node()->i(attr::dim)) *= o->node()->inputs().size();
     }
     auto scalar_type = o->type()->expect<c10::DimensionedTensorType const>()->scalarType();
-    auto type = CompleteTensorType::create(scalar_type, device, sizes);
-    output_desc.emplace_back(type);
+    if (const auto& reduction = spec.outputReductions().at(i)) {
+      // Reduced outputs are written through a view expanded to the map size,
+      // so the reduced dims (stride 0) are not contiguous with their
+      // neighbours. This doesn't depend on the map size.
+      const auto reduced = reduction->reducedDims(sizes.size());
+      std::vector<bool> cont(sizes.size());
+      for (size_t d = 0; d < sizes.size(); ++d) {
+        cont[d] = !reduced[d] && (d + 1 == sizes.size() || !reduced[d + 1]);
+      }
+      output_desc.emplace_back(scalar_type, cont);
+    } else {
+      auto type = CompleteTensorType::create(scalar_type, device, sizes);
+      output_desc.emplace_back(type);
+    }
     const auto& desc = output_desc.back();
 
     // Creates concat and flattened output descriptions (relies on output desc)
@@ -342,7 +381,7 @@ std::shared_ptr<FusedKernel> compileKernel(
       generateKernel(name, *graph, flat_inputs, flat_outputs, use_cuda);
   const FusedKernelConstructor& kernel_ctor =
       getConstructor(use_cuda ? at::DeviceType::CUDA : at::DeviceType::CPU);
-  return kernel_ctor(
+  auto kernel = kernel_ctor(
       device.index(),
       name,
       code,
@@ -350,7 +389,12 @@ std::shared_ptr<FusedKernel> compileKernel(
       output_desc,
       chunk_desc,
       concat_desc,
-      spec.hasRandom());
+      spec.hasRandom(),
+      *graph);
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  compile_seconds->observe(elapsed.count());
+  return kernel;
 }
 
 } // namespace fuser
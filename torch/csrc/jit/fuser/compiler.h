@@ -33,6 +33,8 @@ TORCH_API size_t nCompiledKernels();
 
 TORCH_API int debugFuser();
 
+// graph is the fusion group specialized to the kernel's inputs, which the
+// code was generated from
 using FusedKernelConstructor = std::function<std::shared_ptr<FusedKernel>(
     int16_t device,
     std::string name,
@@ -41,7 +43,8 @@ using FusedKernelConstructor = std::function<std::shared_ptr<FusedKernel>(
     std::vector<TensorDesc> output_desc,
     std::vector<PartitionDesc> chunk_desc,
     std::vector<PartitionDesc> concat_desc,
-    bool has_random)>;
+    bool has_random,
+    const Graph& graph)>;
 
 TORCH_API void registerFusionBackend(
     at::Device::Type backend_type,
@@ -1,12 +1,17 @@
 #include <torch/csrc/jit/fuser/cpu/fused_kernel.h>
+#include <ATen/Parallel.h>
 #include <c10/util/Exception.h>
 #include <torch/csrc/jit/code_template.h>
 #include <torch/csrc/jit/fuser/compiler.h>
 #include <torch/csrc/jit/fuser/cpu/dynamic_library.h>
+#include <torch/csrc/jit/fuser/cpu/interpreted_kernel.h>
 #include <torch/csrc/jit/fuser/cpu/temp_file.h>
+#include <torch/csrc/jit/fuser/kernel_cache.h>
 #include <torch/csrc/utils/memory.h>
 
+#include <cstdio>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
@@ -20,6 +25,7 @@ namespace cpu {
 static const std::string so_template = "/tmp/pytorch_fuserXXXXXX.so";
 static const std::string cpp_template = "/tmp/pytorch_fuserXXXXXX.cpp";
 static const std::string check_exists_string = "which '${program}' > /dev/null";
+static const std::string version_string = "\"${cxx}\" --version 2> /dev/null";
 
 static bool programExists(const std::string& program) {
   TemplateEnv env;
@@ -47,6 +53,7 @@ struct CompilerConfig {
 
   std::string cxx = "g++"; // compiler location
   bool openmp = true;
+  std::string version; // first line of `cxx --version`, set on first use
 };
 
 static CompilerConfig& getConfig() {
@@ -71,6 +78,46 @@ static const std::string compile_string =
 #endif
     "-std=c++11 -fPIC ${fopenmp} -shared \"${cpp_file}\" -o \"${so_file}\" -lm";
 
+static std::string readFile(const std::string& file) {
+  std::ifstream stream(file, std::ios::binary);
+  std::stringstream contents;
+  contents << stream.rdbuf();
+  return contents.str();
+}
+
+static const std::string& compilerVersion() {
+  auto& config = getConfig();
+  if (config.version.empty()) {
+    TemplateEnv env;
+    env.s("cxx", config.cxx);
+    std::string cmd = format(version_string, env);
+    FILE* pipe = popen(cmd.c_str(), "r");
+    if (pipe) {
+      char line[256] = {0};
+      if (fgets(line, sizeof(line), pipe)) {
+        config.version = line;
+      }
+      pclose(pipe);
+    }
+    if (config.version.empty()) {
+      config.version = config.cxx;
+    }
+  }
+  return config.version;
+}
+
+// Everything besides the code that the compiled library depends on,
+// for the persistent kernel cache
+static std::string compilerTarget() {
+  auto& config = getConfig();
+  TemplateEnv env;
+  env.s("cxx", config.cxx);
+  env.s("fopenmp", config.openmp ? "-fopenmp" : "");
+  env.s("cpp_file", "");
+  env.s("so_file", "");
+  return "cpu\n" + compilerVersion() + format(compile_string, env);
+}
+
 static void runCompiler(
     const std::string& cpp_file,
     const std::string& so_file) {
@@ -117,19 +164,53 @@ FusedKernelCPU::FusedKernelCPU(
           std::move(concat_desc),
           has_random) {
   TempFile so_file(so_template, 3);
-  TempFile cpp_file(cpp_template, 4);
-  cpp_file.write(code_);
-  cpp_file.sync();
-  runCompiler(cpp_file.name(), so_file.name());
+  std::string symbol = name_;
+  at::optional<CachedKernel> cached;
+  if (persistentKernelCacheEnabled()) {
+    cached = loadPersistentKernel(name_, code_, compilerTarget());
+  }
+  if (cached) {
+    so_file.write(cached->binary);
+    so_file.sync();
+    symbol = cached->name;
+  } else {
+    TempFile cpp_file(cpp_template, 4);
+    cpp_file.write(code_);
+    cpp_file.sync();
+    runCompiler(cpp_file.name(), so_file.name());
+    if (persistentKernelCacheEnabled()) {
+      storePersistentKernel(
+          name_, code_, compilerTarget(), readFile(so_file.name()));
+    }
+  }
   if (debugFuser() >= 2)
     disas(so_file.name());
   so_lib = make_unique<DynamicLibrary>(so_file.name().c_str());
 #pragma GCC diagnostic ignored "-Wpedantic"
-  kernel =
-      reinterpret_cast<void (*)(uint32_t, void**)>(so_lib->sym(name_.c_str()));
+  kernel = reinterpret_cast<void (*)(uint32_t, void**, ParallelFor)>(
+      so_lib->sym(symbol.c_str()));
 #pragma GCC diagnostic pop
 }
 
+void FusedKernelCPU::parallelFor(
+    uint32_t numTiles,
+    uint32_t grainSize,
+    void (*fn)(void* context, uint32_t begin, uint32_t end),
+    void* context) {
+  at::parallel_for(0, numTiles, grainSize, [&](int64_t begin, int64_t end) {
+    fn(context, begin, end);
+  });
+}
+
+// Kernels are interpreted when there is no compiler to build them with
+static bool useInterpreter() {
+  const char* env = getenv("PYTORCH_FUSER_CPU_INTERPRETER");
+  if (env && atoi(env)) {
+    return true;
+  }
+  return getConfig().cxx.empty();
+}
+
 static std::shared_ptr<FusedKernel> createFusionKernel(
     int16_t device,
     std::string name,
@@ -138,7 +219,19 @@ static std::shared_ptr<FusedKernel> createFusionKernel(
     std::vector<TensorDesc> output_desc,
     std::vector<PartitionDesc> chunk_desc,
     std::vector<PartitionDesc> concat_desc,
-    bool has_random) {
+    bool has_random,
+    const Graph& graph) {
+  if (useInterpreter()) {
+    return std::make_shared<FusedKernelInterpreted>(
+        std::move(name),
+        std::move(code),
+        std::move(input_desc),
+        std::move(output_desc),
+        std::move(chunk_desc),
+        std::move(concat_desc),
+        has_random,
+        graph);
+  }
   return std::make_shared<FusedKernelCPU>(
       std::move(name),
       std::move(code),
@@ -30,14 +30,28 @@ struct TORCH_API FusedKernelCPU : public ::torch::jit::fuser::FusedKernel {
     return at::Backend::CPU;
   }
 
+  // The tiles of the kernel run on the intra-op thread pool, see
+  // cpu_compilation_unit_template
+  using ParallelFor = void (*)(
+      uint32_t numTiles,
+      uint32_t grainSize,
+      void (*fn)(void* context, uint32_t begin, uint32_t end),
+      void* context);
+
   void launch_raw(const uint32_t numel, std::vector<void*>& arguments)
       const override {
-    kernel(numel, arguments.data());
+    kernel(numel, arguments.data(), &parallelFor);
   }
 
  private:
+  static void parallelFor(
+      uint32_t numTiles,
+      uint32_t grainSize,
+      void (*fn)(void* context, uint32_t begin, uint32_t end),
+      void* context);
+
   std::unique_ptr<DynamicLibrary> so_lib;
-  void (*kernel)(uint32_t, void**) = nullptr;
+  void (*kernel)(uint32_t, void**, ParallelFor) = nullptr;
 };
 
 } // namespace cpu
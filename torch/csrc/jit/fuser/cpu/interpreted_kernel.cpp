@@ -0,0 +1,439 @@
+#include <torch/csrc/jit/fuser/cpu/interpreted_kernel.h>
+
+#include <ATen/Parallel.h>
+#include <c10/util/Exception.h>
+#include <torch/csrc/jit/constants.h>
+#include <torch/csrc/jit/fuser/tensor_info.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+namespace torch {
+namespace jit {
+namespace fuser {
+namespace cpu {
+
+namespace {
+
+// Elements evaluated together; small enough that every intermediate of a
+// block stays in L1
+constexpr size_t kBlockSize = 256;
+
+template <typename T>
+double loadAs(const void* data, size_t offset) {
+  return static_cast<double>(static_cast<const T*>(data)[offset]);
+}
+
+template <typename T>
+void storeAs(void* data, size_t offset, double value) {
+  static_cast<T*>(data)[offset] = static_cast<T>(value);
+}
+
+bool isIntegral(const TypePtr& type) {
+  if (type->kind() == TypeKind::IntType || type->kind() == TypeKind::BoolType) {
+    return true;
+  }
+  if (auto tensor = type->cast<DimensionedTensorType>()) {
+    return at::isIntegralType(tensor->scalarType());
+  }
+  return false;
+}
+
+// Offsets of the elements [start, start + n) of a (compressed) tensor, as
+// computed by emitIndexingFor in the generated code
+void computeOffsets(
+    TensorInfo* info,
+    size_t nDim,
+    size_t start,
+    size_t n,
+    size_t* offsets) {
+  const uint32_t* sizes = info->sizes(nDim);
+  const uint32_t* strides = info->strides(nDim);
+  for (size_t i = 0; i < n; ++i) {
+    size_t linear_index = start + i;
+    size_t offset = 0;
+    for (size_t d = nDim; d-- > 0;) {
+      if (d > 0) {
+        offset += (linear_index % sizes[d]) * strides[d];
+        linear_index /= sizes[d];
+      } else {
+        offset += linear_index * strides[d];
+      }
+    }
+    offsets[i] = offset;
+  }
+}
+
+} // namespace
+
+FusedKernelInterpreted::FusedKernelInterpreted(
+    std::string name,
+    std::string code,
+    std::vector<TensorDesc> input_desc,
+    std::vector<TensorDesc> output_desc,
+    std::vector<PartitionDesc> chunk_desc,
+    std::vector<PartitionDesc> concat_desc,
+    bool has_random,
+    const Graph& graph)
+    : FusedKernel(
+          std::move(name),
+          std::move(code),
+          std::move(input_desc),
+          std::move(output_desc),
+          std::move(chunk_desc),
+          std::move(concat_desc),
+          has_random) {
+  AT_CHECK(!has_random_, "random number generation is not supported on CPU");
+
+  std::unordered_map<const Value*, size_t> slots;
+  auto slotFor = [&](const Value* v) {
+    auto it = slots.find(v);
+    if (it == slots.end()) {
+      it = slots.emplace(v, slots.size()).first;
+    }
+    return it->second;
+  };
+  auto makeOperand = [&](const Value* v, const TensorDesc* desc) {
+    Operand operand;
+    operand.slot = slotFor(v);
+    operand.is_tensor = desc != nullptr;
+    operand.nDim = desc ? desc->nDim() : 0;
+    operand.load = nullptr;
+    operand.store = nullptr;
+    operand.accumulate = false;
+    if (desc) {
+      switch (desc->scalar_type) {
+#define DEFINE_CASE(ctype, name, _)  \
+  case at::ScalarType::name:         \
+    operand.load = &loadAs<ctype>;   \
+    operand.store = &storeAs<ctype>; \
+    break;
+        AT_FORALL_SCALAR_TYPES_EXCEPT_HALF_AND_QINT(DEFINE_CASE)
+#undef DEFINE_CASE
+        default:
+          AT_ERROR(
+              "fused CPU kernels do not support tensors of type ",
+              desc->scalar_type);
+      }
+    }
+    return operand;
+  };
+
+  // Flattens inputs and outputs in the order compileKernel passes them
+  size_t tensor_index = 0;
+  for (const Value* input : graph.inputs()) {
+    if (input->type()->isSubtypeOf(FloatType::get())) {
+      inputs_.push_back(makeOperand(input, nullptr));
+    }
+    if (!input->type()->isSubtypeOf(TensorType::get())) {
+      continue;
+    }
+    const auto& chunk = chunkDesc().at(tensor_index);
+    if (chunk.isNoop()) {
+      inputs_.push_back(makeOperand(input, &inputDesc().at(tensor_index)));
+    } else {
+      for (const auto& use : input->uses()) {
+        if (use.user->kind() == prim::ConstantChunk) {
+          for (const Value* o : use.user->outputs()) {
+            inputs_.push_back(makeOperand(o, &*chunk.subTensorDesc()));
+          }
+          break;
+        }
+      }
+    }
+    tensor_index++;
+  }
+  for (size_t i = 0; i < graph.outputs().size(); ++i) {
+    const Value* output = graph.outputs()[i];
+    const auto& concat = concatDesc().at(i);
+    if (output->node()->kind() == aten::sum) {
+      // reduced outputs are expanded to the map size, see compileKernel
+      outputs_.push_back(
+          makeOperand(output->node()->input(0), &outputDesc().at(i)));
+      outputs_.back().accumulate = true;
+      accumulates_ = true;
+    } else if (concat.isNoop()) {
+      outputs_.push_back(makeOperand(output, &outputDesc().at(i)));
+    } else {
+      for (const Value* c : output->node()->inputs()) {
+        outputs_.push_back(makeOperand(c, &*concat.subTensorDesc()));
+      }
+    }
+  }
+
+  for (const Node* n : graph.nodes()) {
+    if (n->kind() == prim::FusedConcat || n->kind() == prim::ConstantChunk ||
+        n->kind() == aten::sum || n->mustBeNone()) {
+      continue;
+    }
+    if (n->kind() == prim::Constant &&
+        n->output()->type()->kind() == TypeKind::ListType) {
+      continue;
+    }
+    if (n->kind() == prim::Constant) {
+      const auto value = toIValue(n->output()).value();
+      double constant;
+      if (value.isDouble()) {
+        constant = value.toDouble();
+      } else if (value.isBool()) {
+        constant = value.toBool();
+      } else {
+        AT_ASSERT(value.isInt());
+        constant = value.toInt();
+      }
+      constants_.emplace_back(slotFor(n->output()), constant);
+      continue;
+    }
+    Instruction inst;
+    inst.kind = n->kind();
+    inst.output = slotFor(n->output());
+    inst.integral = isIntegral(n->output()->type());
+    if (n->kind() == aten::clamp) {
+      inst.inputs.push_back(slotFor(n->input(0)));
+      inst.has_min = !n->input(1)->node()->mustBeNone();
+      inst.has_max = !n->input(2)->node()->mustBeNone();
+      AT_CHECK(
+          inst.has_min || inst.has_max,
+          "At least one of 'min' or 'max' must not be None");
+      inst.inputs.push_back(inst.has_min ? slotFor(n->input(1)) : 0);
+      inst.inputs.push_back(inst.has_max ? slotFor(n->input(2)) : 0);
+    } else {
+      for (const Value* input : n->inputs()) {
+        inst.inputs.push_back(slotFor(input));
+      }
+    }
+    instructions_.push_back(std::move(inst));
+  }
+  num_slots_ = slots.size();
+
+  // Checks every op is supported up front, rather than on first launch
+  std::vector<double> scratch(num_slots_ * kBlockSize);
+  for (const auto& inst : instructions_) {
+    evaluate(inst, scratch.data(), 0);
+  }
+}
+
+void FusedKernelInterpreted::evaluate(
+    const Instruction& inst,
+    double* slots,
+    size_t n) const {
+  double* out = slots + inst.output * kBlockSize;
+  auto in = [&](size_t i) -> const double* {
+    return slots + inst.inputs.at(i) * kBlockSize;
+  };
+
+#define UNARY(kind, expr)            \
+  case kind: {                       \
+    const double* a = in(0);         \
+    for (size_t i = 0; i < n; ++i) { \
+      const double x = a[i];         \
+      out[i] = (expr);               \
+    }                                \
+    break;                           \
+  }
+#define BINARY(kind, expr)           \
+  case kind: {                       \
+    const double* a = in(0);         \
+    const double* b = in(1);         \
+    for (size_t i = 0; i < n; ++i) { \
+      const double x = a[i];         \
+      const double y = b[i];         \
+      out[i] = (expr);               \
+    }                                \
+    break;                           \
+  }
+#define TERNARY(kind, expr)          \
+  case kind: {                       \
+    const double* a = in(0);         \
+    const double* b = in(1);         \
+    const double* c = in(2);         \
+    for (size_t i = 0; i < n; ++i) { \
+      const double x = a[i];         \
+      const double y = b[i];         \
+      const double z = c[i];         \
+      out[i] = (expr);               \
+    }                                \
+    break;                           \
+  }
+
+  // Mirrors the expressions encodeRHS generates
+  switch (inst.kind) {
+    UNARY(aten::_cast_Float, static_cast<float>(x))
+    UNARY(aten::abs, std::fabs(x))
+    UNARY(aten::sigmoid, 1. / (1. + std::exp(-x)))
+    UNARY(aten::relu, x < 0 ? 0. : x)
+    UNARY(aten::log, std::log(x))
+    UNARY(aten::log10, std::log10(x))
+    UNARY(aten::log1p, std::log1p(x))
+    UNARY(aten::log2, std::log2(x))
+    UNARY(aten::lgamma, std::lgamma(x))
+    UNARY(aten::exp, std::exp(x))
+    UNARY(aten::expm1, std::expm1(x))
+    UNARY(aten::erf, std::erf(x))
+    UNARY(aten::erfc, std::erfc(x))
+    UNARY(aten::cos, std::cos(x))
+    UNARY(aten::acos, std::acos(x))
+    UNARY(aten::cosh, std::cosh(x))
+    UNARY(aten::sin, std::sin(x))
+    UNARY(aten::asin, std::asin(x))
+    UNARY(aten::sinh, std::sinh(x))
+    UNARY(aten::tan, std::tan(x))
+    UNARY(aten::atan, std::atan(x))
+    UNARY(aten::tanh, std::tanh(x))
+    UNARY(aten::sqrt, std::sqrt(x))
+    UNARY(aten::rsqrt, 1. / std::sqrt(x))
+    UNARY(aten::ceil, std::ceil(x))
+    UNARY(aten::floor, std::floor(x))
+    UNARY(aten::round, std::round(x))
+    UNARY(aten::trunc, std::trunc(x))
+    UNARY(aten::frac, x - std::trunc(x))
+    UNARY(aten::reciprocal, 1. / x)
+    UNARY(aten::neg, -x)
+    UNARY(aten::type_as, x)
+    BINARY(aten::atan2, std::atan2(x, y))
+    BINARY(aten::min, std::fmin(x, y))
+    BINARY(aten::max, std::fmax(x, y))
+    BINARY(aten::__and__, x && y)
+    BINARY(aten::__or__, x || y)
+    BINARY(aten::__xor__, static_cast<int64_t>(x) ^ static_cast<int64_t>(y))
+    BINARY(
+        aten::__lshift__, static_cast<int64_t>(x) << static_cast<int64_t>(y))
+    BINARY(
+        aten::__rshift__, static_cast<int64_t>(x) >> static_cast<int64_t>(y))
+    BINARY(aten::div, x / y)
+    BINARY(aten::mul, x * y)
+    BINARY(aten::eq, x == y)
+    BINARY(aten::ne, x != y)
+    BINARY(aten::ge, x >= y)
+    BINARY(aten::gt, x > y)
+    BINARY(aten::le, x <= y)
+    BINARY(aten::lt, x < y)
+    BINARY(aten::fmod, std::fmod(x, y))
+    BINARY(aten::remainder, std::remainder(x, y))
+    BINARY(aten::pow, std::pow(x, y))
+    BINARY(aten::_sigmoid_backward, x * y * (1. - y))
+    BINARY(aten::_tanh_backward, x * (1. - y * y))
+    TERNARY(aten::threshold, x <= y ? z : x)
+    TERNARY(aten::add, x + z * y)
+    TERNARY(aten::sub, x - z * y)
+    TERNARY(aten::lerp, x + z * (y - x))
+    TERNARY(aten::where, x ? y : z)
+    case aten::addcmul: {
+      const double* a = in(0);
+      const double* b = in(1);
+      const double* c = in(2);
+      const double* d = in(3);
+      for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] + d[i] * b[i] * c[i];
+      }
+      break;
+    }
+    case aten::clamp: {
+      // bounds are checked first so that NaN bounds are ignored
+      const double* a = in(0);
+      const double* lo = inst.has_min ? in(1) : nullptr;
+      const double* hi = inst.has_max ? in(2) : nullptr;
+      for (size_t i = 0; i < n; ++i) {
+        double x = a[i];
+        if (lo && x < lo[i]) {
+          x = lo[i];
+        } else if (hi && x > hi[i]) {
+          x = hi[i];
+        }
+        out[i] = x;
+      }
+      break;
+    }
+    default:
+      AT_ERROR(
+          "fused CPU kernels cannot interpret ", inst.kind.toQualString());
+  }
+#undef UNARY
+#undef BINARY
+#undef TERNARY
+
+  if (inst.integral) {
+    for (size_t i = 0; i < n; ++i) {
+      out[i] = std::trunc(out[i]);
+    }
+  }
+}
+
+void FusedKernelInterpreted::launch_raw(
+    const uint32_t numel,
+    std::vector<void*>& arguments) const {
+  // arguments are numel, then the inputs, then the outputs
+  AT_ASSERT(arguments.size() == 1 + inputs_.size() + outputs_.size());
+  std::vector<void*> input_args(
+      arguments.begin() + 1, arguments.begin() + 1 + inputs_.size());
+  std::vector<void*> output_args(
+      arguments.begin() + 1 + inputs_.size(), arguments.end());
+
+  auto body = [&](int64_t begin, int64_t end) {
+    std::vector<double> slots(num_slots_ * kBlockSize);
+    for (const auto& constant : constants_) {
+      std::fill_n(
+          &slots[constant.first * kBlockSize], kBlockSize, constant.second);
+    }
+    for (size_t j = 0; j < inputs_.size(); ++j) {
+      if (!inputs_[j].is_tensor) {
+        std::fill_n(
+            &slots[inputs_[j].slot * kBlockSize],
+            kBlockSize,
+            *static_cast<double*>(input_args[j]));
+      }
+    }
+
+    size_t offsets[kBlockSize];
+    for (int64_t start = begin; start < end; start += kBlockSize) {
+      const size_t n = std::min<size_t>(kBlockSize, end - start);
+      for (size_t j = 0; j < inputs_.size(); ++j) {
+        const auto& input = inputs_[j];
+        if (!input.is_tensor) {
+          continue;
+        }
+        auto info = static_cast<TensorInfo*>(input_args[j]);
+        computeOffsets(info, input.nDim, start, n, offsets);
+        double* slot = &slots[input.slot * kBlockSize];
+        for (size_t i = 0; i < n; ++i) {
+          slot[i] = input.load(info->data, offsets[i]);
+        }
+      }
+      for (const auto& inst : instructions_) {
+        evaluate(inst, slots.data(), n);
+      }
+      for (size_t j = 0; j < outputs_.size(); ++j) {
+        const auto& output = outputs_[j];
+        auto info = static_cast<TensorInfo*>(output_args[j]);
+        computeOffsets(info, output.nDim, start, n, offsets);
+        const double* slot = &slots[output.slot * kBlockSize];
+        if (output.accumulate) {
+          for (size_t i = 0; i < n; ++i) {
+            output.store(
+                info->data,
+                offsets[i],
+                output.load(info->data, offsets[i]) + slot[i]);
+          }
+        } else {
+          for (size_t i = 0; i < n; ++i) {
+            output.store(info->data, offsets[i], slot[i]);
+          }
+        }
+      }
+    }
+  };
+  // Accumulating outputs are shared between elements, so reductions run
+  // serially
+  at::parallel_for(
+      0,
+      numel,
+      accumulates_ ? std::max<int64_t>(numel, 1) : at::internal::GRAIN_SIZE,
+      body);
+}
+
+} // namespace cpu
+} // namespace fuser
+} // namespace jit
+} // namespace torch
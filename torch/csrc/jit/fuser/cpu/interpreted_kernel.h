@@ -0,0 +1,85 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/csrc/jit/fuser/fused_kernel.h>
+#include <torch/csrc/jit/ir.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace torch {
+namespace jit {
+namespace fuser {
+namespace cpu {
+
+// Runs a fusion group in-process, without compiling the generated code.
+//
+// The graph is evaluated over blocks of elements: each block of inputs is
+// loaded once, every node is applied to the whole block and the results
+// are stored once, so intermediates stay in cache just like in a compiled
+// kernel. Used when no C++ compiler is available (or when
+// PYTORCH_FUSER_CPU_INTERPRETER=1), so CPU fusion does not depend on a
+// toolchain being installed.
+//
+// Takes the same arguments as the compiled kernel (see launchFusion), and
+// computes in double precision.
+struct TORCH_API FusedKernelInterpreted
+    : public ::torch::jit::fuser::FusedKernel {
+  FusedKernelInterpreted(
+      std::string name,
+      std::string code,
+      std::vector<TensorDesc> input_desc,
+      std::vector<TensorDesc> output_desc,
+      std::vector<PartitionDesc> chunk_desc,
+      std::vector<PartitionDesc> concat_desc,
+      bool has_random,
+      const Graph& graph);
+
+  at::Backend backend() const override {
+    return at::Backend::CPU;
+  }
+
+  void launch_raw(const uint32_t numel, std::vector<void*>& arguments)
+      const override;
+
+ private:
+  // A flattened input or output: a tensor (see TensorInfo) or, for inputs,
+  // a double scalar
+  struct Operand {
+    size_t slot;
+    bool is_tensor;
+    size_t nDim;
+    double (*load)(const void* data, size_t offset);
+    void (*store)(void* data, size_t offset, double value);
+    // the output is a reduction, so values are added to it
+    bool accumulate;
+  };
+
+  struct Instruction {
+    NodeKind kind;
+    std::vector<size_t> inputs;
+    size_t output;
+    // the output is an integer or bool, so results are truncated
+    bool integral;
+    // for clamp, which may be passed None as either bound
+    bool has_min = false;
+    bool has_max = false;
+  };
+
+  void evaluate(const Instruction& inst, double* slots, size_t n) const;
+
+  std::vector<Operand> inputs_;
+  std::vector<Operand> outputs_;
+  std::vector<std::pair<size_t, double>> constants_;
+  std::vector<Instruction> instructions_;
+  size_t num_slots_ = 0;
+  bool accumulates_ = false;
+};
+
+} // namespace cpu
+} // namespace fuser
+} // namespace jit
+} // namespace torch
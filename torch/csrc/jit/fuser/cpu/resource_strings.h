@@ -53,22 +53,86 @@ float fracf(float x) {
 
 ${type_declarations}
 
-#define OMP_THRESHOLD 100000
-static void ${kernelName}_kernel(IndexType totalElements, ${formals}) {
-  #pragma omp parallel for if(totalElements > OMP_THRESHOLD)
-  for (IndexType linearIndex = 0;
-        linearIndex < totalElements;
-        linearIndex += 1) {
-      // Convert `linearIndex` into an offset of tensor:
-      ${tensorOffsets}
+// The elements are processed in tiles of consecutive indices that never
+// cross a row of the innermost dimension of a tensor: the offsets of a tile
+// are computed once, and its inner loop only adds the innermost strides, so
+// that it can be vectorized (the offsets in the inner loop are size_t, which
+// unlike IndexType can't wrap around). The tiles run on the intra-op thread pool of
+// the process, through parallelFor.
+#define TILE_SIZE 1024
+#define GRAIN_SIZE 32768
+
+typedef void (*ParallelFor)(
+    IndexType numTiles,
+    IndexType grainSize,
+    void (*fn)(void* context, IndexType begin, IndexType end),
+    void* context);
+
+static IndexType gcd(IndexType a, IndexType b) {
+  while (b != 0) {
+    IndexType t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+template <typename T>
+static inline void atomicAdd(T* address, T value) {
+  T old = *address;
+  T sum;
+  do {
+    sum = old + value;
+  } while (!__atomic_compare_exchange(
+      address, &old, &sum, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static void ${kernelName}_kernel(IndexType tileBegin, IndexType tileEnd,
+    IndexType rowSize, IndexType tilesPerRow, ${formals}) {
+  for (IndexType tile = tileBegin; tile < tileEnd; tile++) {
+    IndexType column = (tile % tilesPerRow) * TILE_SIZE;
+    IndexType linearIndex = (tile / tilesPerRow) * rowSize + column;
+    IndexType tileSize = rowSize - column < TILE_SIZE ? rowSize - column : TILE_SIZE;
+    // Convert `linearIndex` into the offsets of the tile in the tensors:
+    ${tensorOffsets}
+    ${simd}
+    for (size_t i = 0; i < tileSize; i++) {
+      ${tileOffsets}
       // calculate the results
       ${kernelBody}
     }
+  }
+}
+
+struct ${kernelName}_context {
+  void** args;
+  IndexType rowSize;
+  IndexType tilesPerRow;
+};
+
+static void ${kernelName}_tiles(void* context, IndexType begin, IndexType end) {
+  void** args = static_cast<${kernelName}_context*>(context)->args;
+  IndexType rowSize = static_cast<${kernelName}_context*>(context)->rowSize;
+  IndexType tilesPerRow = static_cast<${kernelName}_context*>(context)->tilesPerRow;
+  ${kernelName}_kernel(begin, end, rowSize, tilesPerRow ${,argument_loads});
 }
 
 extern "C"
-void ${kernelName}(IndexType totalElements, void ** args) {
-  ${kernelName}_kernel(totalElements ${,argument_loads});
+void ${kernelName}(IndexType totalElements, void ** args, ParallelFor parallelFor) {
+  if (totalElements == 0) {
+    return;
+  }
+  // The rows of the tiles divide the innermost dimension of every tensor
+  IndexType rowSize = totalElements;
+  ${rowSizes}
+  IndexType tilesPerRow = (rowSize + TILE_SIZE - 1) / TILE_SIZE;
+  IndexType tileSize = rowSize < TILE_SIZE ? rowSize : TILE_SIZE;
+  ${kernelName}_context context = {args, rowSize, tilesPerRow};
+  parallelFor(
+      totalElements / rowSize * tilesPerRow,
+      GRAIN_SIZE / tileSize > 1 ? GRAIN_SIZE / tileSize : 1,
+      ${kernelName}_tiles,
+      &context);
 }
 )");
 
@@ -6,6 +6,7 @@
 #include <c10/cuda/CUDAGuard.h>
 #include <torch/csrc/jit/fuser/cpu/dynamic_library.h>
 #include <torch/csrc/jit/fuser/cuda/thnvrtc.h>
+#include <torch/csrc/jit/fuser/kernel_cache.h>
 #include <torch/csrc/jit/resource_guard.h>
 
 // Note: unclear why this forward declaration is necessary
@@ -171,37 +172,63 @@ FusedKernelCUDA::FusedKernelCUDA(
   int major, minor;
   getMajorMinor(prop_, major, minor);
 
-  // Creates the NVRTC program
-  nvrtcProgram program;
-  TORCH_NVRTC_CHECK(nvrtc().nvrtcCreateProgram(
-      &program, code_.c_str(), nullptr, 0, nullptr, nullptr));
-
   const std::string compute = "--gpu-architecture=compute_" +
       std::to_string(major) + std::to_string(minor);
   const std::vector<const char*> args = {
       "--std=c++11", compute.c_str(), "-default-device"};
-  const auto result =
-      nvrtc().nvrtcCompileProgram(program, args.size(), args.data());
-  if (result == NVRTC_ERROR_COMPILATION) {
-    size_t logsize;
-    nvrtc().nvrtcGetProgramLogSize(program, &logsize);
-    std::vector<char> log(logsize);
-    nvrtc().nvrtcGetProgramLog(program, log.data());
-    std::stringstream cu;
-    cu << log.data();
-    throw std::runtime_error(cu.str());
+
+  // The PTX depends on the NVRTC version and the arguments besides the code
+  std::string symbol = name_;
+  std::string target;
+  at::optional<CachedKernel> cached;
+  if (persistentKernelCacheEnabled()) {
+    int nvrtc_major, nvrtc_minor;
+    TORCH_NVRTC_CHECK(nvrtc().nvrtcVersion(&nvrtc_major, &nvrtc_minor));
+    std::stringstream ss;
+    ss << "cuda\nnvrtc " << nvrtc_major << "." << nvrtc_minor;
+    for (const char* arg : args) {
+      ss << " " << arg;
+    }
+    target = ss.str();
+    cached = loadPersistentKernel(name_, code_, target);
+  }
+
+  if (cached) {
+    ptx_.assign(cached->binary.begin(), cached->binary.end());
+    symbol = cached->name;
+  } else {
+    // Creates the NVRTC program
+    nvrtcProgram program;
+    TORCH_NVRTC_CHECK(nvrtc().nvrtcCreateProgram(
+        &program, code_.c_str(), nullptr, 0, nullptr, nullptr));
+
+    const auto result =
+        nvrtc().nvrtcCompileProgram(program, args.size(), args.data());
+    if (result == NVRTC_ERROR_COMPILATION) {
+      size_t logsize;
+      nvrtc().nvrtcGetProgramLogSize(program, &logsize);
+      std::vector<char> log(logsize);
+      nvrtc().nvrtcGetProgramLog(program, log.data());
+      std::stringstream cu;
+      cu << log.data();
+      throw std::runtime_error(cu.str());
+    }
+    ResourceGuard holdProgram(
+        [&] { TORCH_NVRTC_CHECK(nvrtc().nvrtcDestroyProgram(&program)); });
+    TORCH_NVRTC_CHECK(result);
+    size_t ptx_size;
+    TORCH_NVRTC_CHECK(nvrtc().nvrtcGetPTXSize(program, &ptx_size));
+    ptx_.resize(ptx_size);
+    TORCH_NVRTC_CHECK(nvrtc().nvrtcGetPTX(program, ptx_.data()));
+    if (persistentKernelCacheEnabled()) {
+      storePersistentKernel(
+          name_, code_, target, std::string(ptx_.begin(), ptx_.end()));
+    }
   }
-  ResourceGuard holdProgram(
-      [&] { TORCH_NVRTC_CHECK(nvrtc().nvrtcDestroyProgram(&program)); });
-  TORCH_NVRTC_CHECK(result);
-  size_t ptx_size;
-  TORCH_NVRTC_CHECK(nvrtc().nvrtcGetPTXSize(program, &ptx_size));
-  ptx_.resize(ptx_size);
-  TORCH_NVRTC_CHECK(nvrtc().nvrtcGetPTX(program, ptx_.data()));
 
   TORCH_CU_CHECK(nvrtc().cuModuleLoadData(&module_, ptx_.data()));
   TORCH_CU_CHECK(
-      nvrtc().cuModuleGetFunction(&function_, module_, name_.c_str()));
+      nvrtc().cuModuleGetFunction(&function_, module_, symbol.c_str()));
 
   // Computes max blocks
   TORCH_CU_CHECK(nvrtc().cuOccupancyMaxActiveBlocksPerMultiprocessor(
@@ -269,7 +296,8 @@ static std::shared_ptr<FusedKernel> createFusionKernel(
     std::vector<TensorDesc> output_desc,
     std::vector<PartitionDesc> chunk_desc,
     std::vector<PartitionDesc> concat_desc,
-    bool has_random) {
+    bool has_random,
+    const Graph& graph) {
   return std::make_shared<FusedKernelCUDA>(
       device,
       std::move(name),
@@ -137,6 +137,31 @@ static bool shouldExpandArgs(
   return expandArgs(spec, args, map_size, /*dry_run=*/true);
 }
 
+// Gives size-1 dims the stride they would have if they were contiguous with
+// the next dim. Size-1 dims are never stepped over, so their strides don't
+// affect addressing, but they are part of the contiguity the kernels are
+// specialized on; normalizing them keeps tensors that only differ there
+// (e.g. a batch of one sliced from a transposed tensor) on the same kernel.
+static void normalizeStrides(std::vector<at::Tensor>& args) {
+  for (auto& arg : args) {
+    const auto sizes = arg.sizes();
+    std::vector<int64_t> strides(arg.strides().begin(), arg.strides().end());
+    bool changed = false;
+    for (size_t i = sizes.size(); i-- > 0;) {
+      if (sizes[i] != 1) {
+        continue;
+      }
+      const int64_t stride =
+          (i + 1 < sizes.size()) ? sizes[i + 1] * strides[i + 1] : 1;
+      changed |= strides[i] != stride;
+      strides[i] = stride;
+    }
+    if (changed) {
+      arg = arg.as_strided(sizes, strides, arg.storage_offset());
+    }
+  }
+}
+
 // Note: assumes that inputs are 32-bit addressable
 static uint32_t computeNumel(const at::ArrayRef<int64_t>& sizes) {
   uint32_t result = 1;
@@ -188,6 +213,7 @@ static void compressContiguous(
 // Launches the requested fusion on the given device with the given inputs.
 // Output pointers are stored in outputs (to be put on the stack later).
 void launchFusion(
+    const KernelSpec& spec,
     const FusedKernel& fusion,
     const at::Device device,
     const at::ArrayRef<at::Tensor>& inputs,
@@ -292,7 +318,21 @@ void launchFusion(
   const auto& ref_options = inputs[0].options();
   for (size_t i = 0; i < fusion.outputDesc().size(); ++i) {
     const auto& c = fusion.concatDesc()[i];
-    if (c.isNoop()) {
+    const auto& reduction = spec.outputReductions().at(i);
+    if (reduction) {
+      // The kernel accumulates into the output through a view expanded
+      // along the reduced dims
+      std::vector<int64_t> keep_sizes(map_size.begin(), map_size.end());
+      const auto reduced = reduction->reducedDims(keep_sizes.size());
+      for (size_t d = 0; d < keep_sizes.size(); ++d) {
+        if (reduced[d]) {
+          keep_sizes[d] = 1;
+        }
+      }
+      outputs.push_back(at::zeros(
+          keep_sizes, ref_options.dtype(fusion.outputDesc()[i].scalar_type)));
+      addTensorInfo(fusion.outputDesc()[i], outputs[i].expand(map_size));
+    } else if (c.isNoop()) {
       outputs.push_back(at::empty(
           map_size, ref_options.dtype(fusion.outputDesc()[i].scalar_type)));
       addTensorInfo(fusion.outputDesc()[i], outputs[i]);
@@ -315,6 +355,20 @@ void launchFusion(
   }
 
   fusion.launch_raw(numel, arguments);
+
+  // Drops the reduced dims unless they are kept
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    const auto& reduction = spec.outputReductions().at(i);
+    if (!reduction || reduction->keepdim()) {
+      continue;
+    }
+    const auto reduced = reduction->reducedDims(outputs[i].dim());
+    for (int64_t d = outputs[i].dim() - 1; d >= 0; --d) {
+      if (reduced[d]) {
+        outputs[i] = outputs[i].squeeze(d);
+      }
+    }
+  }
 }
 
 bool runFusion(const int64_t key, Stack& stack, std::string* code_out) {
@@ -362,16 +416,18 @@ bool runFusion(const int64_t key, Stack& stack, std::string* code_out) {
       if (hasBroadcast) return false;
   }
   expandArgs(spec, inputs, *maybe_map_size, /*dry_run=*/false);
+  normalizeStrides(inputs);
 
   // Retrieves the kernel, compiling (and caching) if necessary
   ArgSpec arg_spec{inputs, device.index()};
+  // Note: the kernel is used directly after caching it, since other threads
+  // may evict it from the spec in between
   auto maybe_kernel = spec.findKernel(arg_spec);
   if (!maybe_kernel) {
     const auto kernel = compileKernel(spec, arg_spec, *maybe_map_size, device);
     spec.cacheKernel(arg_spec, kernel);
+    maybe_kernel = kernel;
   }
-  maybe_kernel = spec.findKernel(arg_spec);
-  AT_ASSERT(maybe_kernel);
 
   if (code_out) {
     *code_out = maybe_kernel.value()->code();
@@ -379,7 +435,8 @@ bool runFusion(const int64_t key, Stack& stack, std::string* code_out) {
 
   // Launches fusion
   std::vector<at::Tensor> raw_outputs;
-  launchFusion(*(*maybe_kernel), device, inputs, all_inputs, raw_outputs);
+  launchFusion(
+      spec, *(*maybe_kernel), device, inputs, all_inputs, raw_outputs);
 
   auto outputs = fmap(spec.outputMapAndSizes(), [&](const OutputMapAndSize& omap) {
     if (omap.needsSumToSize()) {
@@ -5,6 +5,8 @@
 #include <torch/csrc/jit/fuser/fallback.h>
 #include <torch/csrc/jit/fuser/kernel_cache.h>
 
+#include <atomic>
+#include <cstdlib>
 #include <stdexcept>
 
 namespace torch {
@@ -15,6 +17,13 @@ namespace detail {
 // Note: CPU fusion is currently disabled due to test flakiness
 bool cpu_fuser_enabled = false;
 
+static size_t defaultMaxKernelsPerFusion() {
+  const char* env = getenv("PYTORCH_FUSER_MAX_KERNELS");
+  return env ? std::strtoul(env, nullptr, 10) : 64;
+}
+
+std::atomic<size_t> max_kernels_per_fusion{defaultMaxKernelsPerFusion()};
+
 } // namespace detail
 
 int64_t registerFusion(const Node* fusion_group) {
@@ -40,6 +49,14 @@ void overrideCanFuseOnCPU(bool value) {
   detail::cpu_fuser_enabled = value;
 }
 
+size_t maxKernelsPerFusion() {
+  return detail::max_kernels_per_fusion.load();
+}
+
+void overrideMaxKernelsPerFusion(size_t value) {
+  detail::max_kernels_per_fusion = value;
+}
+
 // Uses the above interface by stuffing the graph into a node and treating that
 // node as a fusion group.
 std::vector<at::Tensor> debugLaunchGraph(
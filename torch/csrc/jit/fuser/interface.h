@@ -32,6 +32,12 @@ TORCH_API bool canFuseOnGPU();
 // flakiness)
 TORCH_API void overrideCanFuseOnCPU(bool value);
 
+// Number of kernels each fusion keeps compiled (one per input layout);
+// the least recently used are evicted beyond it. Defaults to 64, or to
+// PYTORCH_FUSER_MAX_KERNELS if set.
+TORCH_API size_t maxKernelsPerFusion();
+TORCH_API void overrideMaxKernelsPerFusion(size_t value);
+
 // Treats the given graph as a fusion group and launches it on the
 // specified device with the given inputs.
 // Returns the outputs.
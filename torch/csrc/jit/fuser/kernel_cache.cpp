@@ -1,9 +1,23 @@
 #include <torch/csrc/jit/fuser/kernel_cache.h>
+#include <torch/csrc/jit/fuser/compiler.h>
 #include <torch/csrc/jit/passes/canonicalize.h>
 #include <torch/csrc/jit/passes/shape_analysis.h>
 
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <process.h>
+#endif
+
+#include <cctype>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
 #include <mutex>
+#include <sstream>
 #include <unordered_map>
 
 namespace torch {
@@ -87,6 +101,143 @@ at::optional<KernelSpec*> lookupGraph(std::shared_ptr<Graph> graph) {
   return nolock_retrieve(cache, it->second);
 }
 
+static const char* kPersistentCacheMagic = "PTFUSER1";
+
+static std::string persistentCacheDir() {
+  const char* dir = getenv("PYTORCH_FUSER_CACHE_DIR");
+  return dir ? dir : "";
+}
+
+bool persistentKernelCacheEnabled() {
+  return !persistentCacheDir().empty();
+}
+
+static bool isIdentifierChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// What an entry is addressed by: the target and the code with every
+// occurrence of the kernel name replaced by a placeholder
+static std::string persistentCacheKey(
+    const std::string& name,
+    const std::string& code,
+    const std::string& target) {
+  std::string key = target + "\n";
+  size_t pos = 0;
+  while (true) {
+    size_t found = code.find(name, pos);
+    if (found == std::string::npos) {
+      key.append(code, pos, std::string::npos);
+      break;
+    }
+    size_t end = found + name.size();
+    bool whole = (found == 0 || !isIdentifierChar(code[found - 1])) &&
+        (end == code.size() || !isIdentifierChar(code[end]));
+    key.append(code, pos, found - pos);
+    key += whole ? "${kernel_name}" : name;
+    pos = end;
+  }
+  return key;
+}
+
+// FNV-1a
+static uint64_t hashKey(const std::string& key) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : key) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+static std::string entryPath(const std::string& dir, const std::string& key) {
+  std::ostringstream path;
+  path << dir << "/" << std::hex << hashKey(key) << ".kernel";
+  return path.str();
+}
+
+static void writeField(std::ostream& out, const std::string& field) {
+  uint64_t size = field.size();
+  out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+  out.write(field.data(), field.size());
+}
+
+static bool readField(FILE* file, std::string& field) {
+  uint64_t size;
+  if (fread(&size, sizeof(size), 1, file) != 1) {
+    return false;
+  }
+  field.resize(size);
+  return size == 0 || fread(&field[0], 1, size, file) == size;
+}
+
+at::optional<CachedKernel> loadPersistentKernel(
+    const std::string& name,
+    const std::string& code,
+    const std::string& target) {
+  const std::string dir = persistentCacheDir();
+  if (dir.empty()) {
+    return at::nullopt;
+  }
+  const std::string key = persistentCacheKey(name, code, target);
+  FILE* file = fopen(entryPath(dir, key).c_str(), "rb");
+  if (!file) {
+    return at::nullopt;
+  }
+  std::string magic, stored_key;
+  CachedKernel kernel;
+  bool ok = readField(file, magic) && magic == kPersistentCacheMagic &&
+      readField(file, stored_key) && stored_key == key &&
+      readField(file, kernel.name) && readField(file, kernel.binary);
+  fclose(file);
+  if (!ok) {
+    return at::nullopt;
+  }
+  return kernel;
+}
+
+void storePersistentKernel(
+    const std::string& name,
+    const std::string& code,
+    const std::string& target,
+    const std::string& binary) {
+  const std::string dir = persistentCacheDir();
+  if (dir.empty()) {
+    return;
+  }
+#ifndef _WIN32
+  mkdir(dir.c_str(), 0755);
+#endif
+  const std::string key = persistentCacheKey(name, code, target);
+  const std::string path = entryPath(dir, key);
+
+  std::ostringstream entry;
+  writeField(entry, kPersistentCacheMagic);
+  writeField(entry, key);
+  writeField(entry, name);
+  writeField(entry, binary);
+  const std::string contents = entry.str();
+
+  // Writes to a private file and renames it into place, so that concurrent
+  // processes never read a partial entry
+  std::ostringstream tmp;
+  tmp << path << ".tmp." << getpid();
+  FILE* file = fopen(tmp.str().c_str(), "wb");
+  bool ok = file != nullptr;
+  if (ok) {
+    ok = fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+    ok = fclose(file) == 0 && ok;
+  }
+  ok = ok && std::rename(tmp.str().c_str(), path.c_str()) == 0;
+  if (!ok) {
+    std::remove(tmp.str().c_str());
+    if (debugFuser()) {
+      std::cerr << "warning: pytorch jit fuser failed to write " << path
+                << " to the persistent kernel cache\n";
+    }
+  }
+}
+
 } // namespace fuser
 } // namespace jit
 } // namespace torch
@@ -7,6 +7,7 @@
 
 #include <cstdint>
 #include <functional>
+#include <string>
 
 namespace torch {
 namespace jit {
@@ -31,6 +32,37 @@ TORCH_API at::optional<KernelSpec*> retrieve(const int64_t key);
 // Only used for testing.
 TORCH_API int64_t debugNumCachedKernelSpecs();
 
+// Persistent kernel cache
+//
+// When PYTORCH_FUSER_CACHE_DIR names a directory, backends store the
+// artifacts they compile there and look for them before compiling again, so
+// kernels survive process restarts. Entries are addressed by the generated
+// code (with the kernel name erased, since names are handed out per
+// process) and a backend-specific target string that must capture
+// everything else the artifact depends on (architecture, compiler version,
+// flags). On load the full code and target are compared, so hash
+// collisions only cost a recompile.
+struct CachedKernel {
+  // the name the kernel was compiled under
+  std::string name;
+  std::string binary;
+};
+
+TORCH_API bool persistentKernelCacheEnabled();
+
+TORCH_API at::optional<CachedKernel> loadPersistentKernel(
+    const std::string& name,
+    const std::string& code,
+    const std::string& target);
+
+// Failures to write are reported when PYTORCH_FUSION_DEBUG is set and are
+// otherwise ignored
+TORCH_API void storePersistentKernel(
+    const std::string& name,
+    const std::string& code,
+    const std::string& target,
+    const std::string& binary);
+
 } // namespace fuser
 } // namespace jit
 } // namespace torch
@@ -10,10 +10,13 @@
 #include <torch/csrc/jit/ir.h>
 #include <ATen/core/stack.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace torch {
@@ -41,6 +44,35 @@ struct TORCH_API PartitionInfo {
   int64_t dim_;
 };
 
+// Helper struct recording a trailing reduction (aten::sum over constant dims)
+// fused into a kernel output: the kernel accumulates the summed value into
+// an output whose reduced dims are expanded to the map size.
+// Note: dims may be negative, they are wrapped once the rank is known.
+struct TORCH_API ReductionInfo {
+  ReductionInfo(std::vector<int64_t> _dims, const bool _keepdim)
+      : dims_{std::move(_dims)}, keepdim_{_keepdim} {};
+
+  const std::vector<int64_t>& dims() const {
+    return dims_;
+  }
+  bool keepdim() const {
+    return keepdim_;
+  }
+
+  // Returns the set of reduced dims for a map of the given rank as a mask
+  std::vector<bool> reducedDims(const size_t ndim) const {
+    std::vector<bool> reduced(ndim, false);
+    for (int64_t dim : dims_) {
+      reduced.at(dim < 0 ? dim + ndim : dim) = true;
+    }
+    return reduced;
+  }
+
+ private:
+  std::vector<int64_t> dims_;
+  bool keepdim_;
+};
+
 // This is a helper struct to record the following:
 // for each fusion group output, it records the corresponding
 // kernel output offset (in offset) and the fusion group input
@@ -76,6 +108,10 @@ struct TORCH_API OutputMapAndSize {
 // Note: uses a mutex to control access to its kernel store
 // Note: unordered containers do not invalidate references/pointers on
 //   rehashing, which is critical for thread-safety.
+// Note: kernels are specialized on the rank and contiguity of their inputs,
+//   not on sizes. At most maxKernelsPerFusion() of them are kept, evicting
+//   the least recently used, so inputs whose layouts keep changing don't grow
+//   the store without bound.
 // TODO: allow abstract kernels to use multiple generated kernels
 // TODO: allow abstract kernels to reuse generated kernels from common pool
 struct TORCH_API KernelSpec {
@@ -91,7 +127,9 @@ struct TORCH_API KernelSpec {
         inputBroadcastGroups_{},
         inputChunks_{},
         outputMapAndSizes_{},
+        outputReductions_{},
         has_random_{false},
+        lru_{},
         kernels_{} {
     for (const auto& n : graph_->nodes()) {
       if (n->kind() == aten::rand_like) {
@@ -140,6 +178,13 @@ struct TORCH_API KernelSpec {
     return outputMapAndSizes_;
   }
 
+  std::vector<c10::optional<ReductionInfo>>& outputReductions() {
+    return outputReductions_;
+  }
+  const std::vector<c10::optional<ReductionInfo>>& outputReductions() const {
+    return outputReductions_;
+  }
+
   bool hasRandom() const {
     return has_random_;
   }
@@ -151,12 +196,25 @@ struct TORCH_API KernelSpec {
     const auto it = kernels_.find(arg_spec);
     if (it == kernels_.end())
       return c10::nullopt;
-    return it->second;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->second;
   }
   void cacheKernel(const ArgSpec& arg_spec, std::shared_ptr<FusedKernel> kernel)
       const {
     std::lock_guard<std::mutex> guard{mutex_};
-    kernels_.emplace(arg_spec, kernel);
+    if (kernels_.count(arg_spec))
+      return;
+    lru_.emplace_front(arg_spec, std::move(kernel));
+    kernels_.emplace(arg_spec, lru_.begin());
+    const size_t max_kernels = std::max<size_t>(maxKernelsPerFusion(), 1);
+    while (lru_.size() > max_kernels) {
+      kernels_.erase(lru_.back().first);
+      lru_.pop_back();
+    }
+  }
+  size_t nCachedKernels() const {
+    std::lock_guard<std::mutex> guard{mutex_};
+    return lru_.size();
   }
 
  private:
@@ -172,10 +230,16 @@ struct TORCH_API KernelSpec {
   // element per fusion group output (which may be larger than the
   // number of kernel outputs).
   std::vector<OutputMapAndSize> outputMapAndSizes_;
+  // One element per kernel output, set for outputs that are reduced
+  std::vector<c10::optional<ReductionInfo>> outputReductions_;
   bool has_random_;
   mutable std::mutex mutex_;
+  // Cached kernels, most recently used first
+  using KernelList =
+      std::list<std::pair<ArgSpec, std::shared_ptr<FusedKernel>>>;
+  mutable KernelList lru_;
   mutable std::
-      unordered_map<ArgSpec, std::shared_ptr<FusedKernel>, torch::hash<ArgSpec>>
+      unordered_map<ArgSpec, KernelList::iterator, torch::hash<ArgSpec>>
           kernels_;
 };
 
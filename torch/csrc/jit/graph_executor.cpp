@@ -2,6 +2,7 @@
 
 #include <ATen/core/ivalue.h>
 #include <c10/util/Exception.h>
+#include <c10/util/StaticTracepoint.h>
 #include <torch/csrc/autograd/grad_mode.h>
 #include <torch/csrc/jit/argument_spec.h>
 #include <torch/csrc/jit/autodiff.h>
@@ -26,6 +27,7 @@
 #include <torch/csrc/jit/passes/requires_grad_analysis.h>
 #include <torch/csrc/jit/passes/shape_analysis.h>
 #include <torch/csrc/jit/passes/specialize_autogradzero.h>
+#include <torch/csrc/jit/profiling_record.h>
 #include <torch/csrc/jit/resource_guard.h>
 #include <torch/csrc/jit/tracer.h>
 
@@ -33,6 +35,7 @@
 #include <torch/csrc/autograd/function.h>
 #include <torch/csrc/jit/script/logging.h>
 
+#include <atomic>
 #include <cstdint>
 #include <iterator>
 #include <memory>
@@ -52,6 +55,11 @@ void debugSetAutodiffSubgraphInlining(bool state) {
   autodiff_subgraph_inlining = state;
 }
 
+std::atomic<bool>& getProfilingMode() {
+  static std::atomic<bool> profiling_mode{false};
+  return profiling_mode;
+}
+
 thread_local std::weak_ptr<Graph> last_executed_optimized_graph;
 std::shared_ptr<Graph> lastExecutedOptimizedGraph() {
   return last_executed_optimized_graph.lock();
@@ -523,11 +531,68 @@ struct GraphExecutorImpl {
       return runTraced(stack);
     }
 
+    if (optimize && getProfilingMode()) {
+      return runProfiled(stack);
+    }
+
     auto& execution_plan =
         optimize ? getOrCompile(stack) : getOrCompileFallback();
     return execution_plan.run(stack);
   }
 
+  void warmup(const Stack& stack) {
+    AT_CHECK(
+        stack.size() >= num_inputs,
+        "expected ",
+        num_inputs,
+        " inputs, but got only ",
+        stack.size());
+    if (!optimize) {
+      getOrCompileFallback();
+    } else if (getProfilingMode()) {
+      // profiles are only recorded by real runs, so just instrument the graph
+      ArgumentSpec spec =
+          arg_spec_creator_.create(autograd::GradMode::is_enabled(), stack);
+      std::lock_guard<std::mutex> lock(compile_mutex);
+      if (!profiled_plans.count(spec)) {
+        profiled_plans.emplace(spec, startProfiling(spec));
+      }
+    } else {
+      getOrCompile(stack);
+    }
+  }
+
+  std::vector<OptimizedPlan> optimizedPlans() {
+    std::lock_guard<std::mutex> lock(compile_mutex);
+    std::vector<OptimizedPlan> plans;
+    for (auto& entry : plan_cache) {
+      const ArgumentSpec& spec = entry.first;
+      OptimizedPlan plan;
+      for (size_t i = 0; i < spec.numTensors(); ++i) {
+        plan.tensors.push_back(spec.tensorAt(i));
+      }
+      for (size_t i = 0; i < spec.numOptionals(); ++i) {
+        plan.optionals.push_back(spec.isPresent(i));
+      }
+      plan.graph = entry.second.graph;
+      plans.push_back(std::move(plan));
+    }
+    return plans;
+  }
+
+  bool addOptimizedPlan(const OptimizedPlan& plan) {
+    if (!optimize) {
+      return false;
+    }
+    ArgumentSpec spec = arg_spec_creator_.create(plan.tensors, plan.optionals);
+    std::lock_guard<std::mutex> lock(compile_mutex);
+    if (plan_cache.count(spec)) {
+      return false;
+    }
+    plan_cache.emplace(std::move(spec), ExecutionPlan(plan.graph));
+    return true;
+  }
+
   GraphExecutorState getDebugState() {
     GraphExecutorState state;
     state.graph = graph.get();
@@ -554,30 +619,47 @@ struct GraphExecutorImpl {
   }
 
   const ExecutionPlan& getOrCompile(const Stack& stack) {
+    const bool with_grad = autograd::GradMode::is_enabled();
+    // fast path: the inputs match the spec of the previous call, which is
+    // checked in place, without building a spec, hashing it or locking
+    if (auto last = last_plan.load(std::memory_order_acquire)) {
+      if (arg_spec_creator_.matches(last->first, with_grad, stack)) {
+        logging::getLogger()->addStatValue(
+            logging::runtime_counters::EXECUTION_PLAN_CACHE_HIT, 1.0);
+        return last->second;
+      }
+    }
     // outside lock guard, to minimize the time holding the lock on the fast
     // path ArgumentSpec even computes its hashCode here.
-    ArgumentSpec spec =
-        arg_spec_creator_.create(autograd::GradMode::is_enabled(), stack);
+    ArgumentSpec spec = arg_spec_creator_.create(with_grad, stack);
     {
       std::lock_guard<std::mutex> lock(compile_mutex);
       auto it = plan_cache.find(spec);
       if (it != plan_cache.end()) {
         logging::getLogger()->addStatValue(
             logging::runtime_counters::EXECUTION_PLAN_CACHE_HIT, 1.0);
-        return it->second;
+      } else {
+        auto plan = compileSpec(spec);
+        it = plan_cache.emplace(std::move(spec), std::move(plan)).first;
+        logging::getLogger()->addStatValue(
+            logging::runtime_counters::EXECUTION_PLAN_CACHE_MISS, 1.0);
       }
-      auto plan = compileSpec(spec);
-      auto r = plan_cache.emplace(std::move(spec), std::move(plan));
-      logging::getLogger()->addStatValue(
-          logging::runtime_counters::EXECUTION_PLAN_CACHE_MISS, 1.0);
-      return r.first->second;
+      last_plan.store(&*it, std::memory_order_release);
+      return it->second;
     }
   }
 
   ExecutionPlan compileSpec(const ArgumentSpec& spec) {
     auto opt_graph = graph->copy();
     arg_spec_creator_.specializeTypes(*opt_graph, spec);
+    return compileGraph(opt_graph, spec);
+  }
 
+  // Optimizes a copy of graph whose input types have been specialized
+  ExecutionPlan compileGraph(
+      std::shared_ptr<Graph>& opt_graph,
+      const ArgumentSpec& spec) {
+    C10_SDT(graph_executor_compile_start, this);
     // Phase 1. Specialize to input definedness (this is very important for
     //          gradient graphs), and run required passes to bring the graph
     //          to an executable form.
@@ -619,9 +701,114 @@ struct GraphExecutorImpl {
     }
     // Make sure there are no leftovers from any passes.
     EliminateDeadCode(opt_graph);
+    C10_SDT(graph_executor_compile_done, this);
     return ExecutionPlan(opt_graph);
   }
 
+  // Profiling mode (see getProfilingMode)
+  //
+  // Each ArgumentSpec first runs an instrumented copy of the graph that
+  // records the types of the values flowing through it. Once enough runs
+  // were seen, the inputs whose sizes and strides stayed the same are
+  // specialized to those complete types, so shape analysis can propagate
+  // exact shapes and the passes that depend on them apply. Runs whose inputs
+  // don't match the recorded types fall back to the plan for their
+  // ArgumentSpec.
+  struct ProfiledPlan {
+    std::unique_ptr<ProfilingRecord> record;
+    ExecutionPlan profiling;
+    // one entry per input, null for inputs that are not checked
+    std::vector<CompleteTensorTypePtr> guards;
+    ExecutionPlan optimized;
+  };
+
+  void runProfiled(Stack& stack) {
+    ArgumentSpec spec =
+        arg_spec_creator_.create(autograd::GradMode::is_enabled(), stack);
+    const ProfiledPlan* state = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(compile_mutex);
+      auto it = profiled_plans.find(spec);
+      if (it == profiled_plans.end()) {
+        it = profiled_plans.emplace(spec, startProfiling(spec)).first;
+      }
+      auto& plan = it->second;
+      if (!plan.optimized && !isProfiling(plan)) {
+        plan.optimized = compileProfiled(spec, plan);
+      }
+      state = &plan;
+    }
+    if (!state->optimized) {
+      return state->profiling.run(stack);
+    }
+    if (!checkGuards(state->guards, stack)) {
+      return getOrCompile(stack).run(stack);
+    }
+    return state->optimized.run(stack);
+  }
+
+  ProfiledPlan startProfiling(const ArgumentSpec& spec) {
+    auto profiled_graph = graph->copy();
+    arg_spec_creator_.specializeTypes(*profiled_graph, spec);
+    runRequiredPasses(profiled_graph);
+    ProfiledPlan plan;
+    plan.record = ProfilingRecord::instrumentGraph(profiled_graph);
+    plan.profiling = ExecutionPlan(plan.record->profiled_graph_);
+    return plan;
+  }
+
+  static bool isProfiling(const ProfiledPlan& plan) {
+    std::lock_guard<std::mutex> lock(plan.record->mutex_);
+    return plan.record->profiling_count_ > 0;
+  }
+
+  ExecutionPlan compileProfiled(const ArgumentSpec& spec, ProfiledPlan& plan) {
+    auto opt_graph = graph->copy();
+    arg_spec_creator_.specializeTypes(*opt_graph, spec);
+
+    const auto profiled_inputs = plan.record->profiled_graph_->inputs();
+    AT_ASSERT(profiled_inputs.size() == num_inputs);
+    plan.guards.assign(num_inputs, nullptr);
+    for (size_t i = 0; i < num_inputs; ++i) {
+      auto observed = profiled_inputs[i]->type()->cast<ProfiledTensorType>();
+      auto specialized =
+          opt_graph->inputs()[i]->type()->cast<DimensionedTensorType>();
+      if (!observed || !specialized) {
+        continue;
+      }
+      const auto sizes = observed->sizes().concrete_sizes();
+      const auto strides = observed->strides().concrete_sizes();
+      if (!sizes || !strides) {
+        continue;
+      }
+      plan.guards[i] = CompleteTensorType::create(
+          specialized->scalarType(),
+          specialized->device(),
+          at::IntArrayRef(*sizes),
+          at::IntArrayRef(*strides),
+          specialized->requires_grad());
+      opt_graph->inputs()[i]->setType(plan.guards[i]);
+    }
+    return compileGraph(opt_graph, spec);
+  }
+
+  static bool checkGuards(
+      const std::vector<CompleteTensorTypePtr>& guards,
+      const Stack& stack) {
+    const auto inputs = last(stack, guards.size());
+    for (size_t i = 0; i < guards.size(); ++i) {
+      if (!guards[i]) {
+        continue;
+      }
+      const auto& tensor = inputs[i].toTensor();
+      if (!tensor.sizes().equals(guards[i]->sizes()) ||
+          !tensor.strides().equals(guards[i]->strides())) {
+        return false;
+      }
+    }
+    return true;
+  }
+
   void runOptimization(
       std::shared_ptr<Graph>& graph,
       const ArgumentSpec& spec) {
@@ -633,6 +820,8 @@ struct GraphExecutorImpl {
     PeepholeOptimize(graph);
     ConstantPropagation(graph);
 
+    FuseBiasDropoutAdd(graph);
+
     // Unroll small loops, and eliminate expressions that are the same at every
     // iteration.
     UnrollLoops(graph);
@@ -729,7 +918,16 @@ struct GraphExecutorImpl {
 
   // Mapping from argument configurations to optimized versions of the graph
   // that are specialized to the spec.
-  std::unordered_map<ArgumentSpec, ExecutionPlan> plan_cache;
+  using PlanCache = std::unordered_map<ArgumentSpec, ExecutionPlan>;
+  PlanCache plan_cache;
+
+  // The plan_cache entry used by the last call: a monomorphic inline cache,
+  // since most executors only ever see one spec. Entries are never removed
+  // and unordered_map nodes don't move, so this stays valid.
+  std::atomic<const PlanCache::value_type*> last_plan{nullptr};
+
+  // Used instead of plan_cache in profiling mode
+  std::unordered_map<ArgumentSpec, ProfiledPlan> profiled_plans;
 
   // GraphExecutors can be accessed from multiple threads, so this thread needs
   // to be held every time we access the fallback or plan_cache.
@@ -743,6 +941,18 @@ void GraphExecutor::run(Stack& inputs) {
   return pImpl->run(inputs);
 }
 
+void GraphExecutor::warmup(const Stack& inputs) {
+  return pImpl->warmup(inputs);
+}
+
+std::vector<OptimizedPlan> GraphExecutor::optimizedPlans() {
+  return pImpl->optimizedPlans();
+}
+
+bool GraphExecutor::addOptimizedPlan(const OptimizedPlan& plan) {
+  return pImpl->addOptimizedPlan(plan);
+}
+
 std::shared_ptr<Graph> GraphExecutor::graph() const {
   return pImpl->graph;
 }
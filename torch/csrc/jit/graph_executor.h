@@ -4,6 +4,7 @@
 #include <torch/csrc/jit/interpreter.h>
 #include <torch/csrc/jit/ir.h>
 #include <torch/csrc/jit/variable_tensor_list.h>
+#include <atomic>
 #include <memory>
 
 namespace torch {
@@ -26,11 +27,32 @@ struct GraphExecutorState {
   std::unordered_map<ArgumentSpec, ExecutionPlanState> execution_plans;
 };
 
+// A plan optimized by a GraphExecutor, which an executor of the same graph,
+// possibly in another process, can run without optimizing it again: the spec
+// of the inputs it was compiled for (see ArgumentSpec::tensorAt and
+// isPresent) and its optimized graph.
+struct OptimizedPlan {
+  std::vector<ArgumentInfo> tensors;
+  std::vector<bool> optionals;
+  std::shared_ptr<Graph> graph;
+};
+
 struct GraphExecutorImpl;
 struct TORCH_API GraphExecutor {
   GraphExecutor() = default;
   GraphExecutor(std::shared_ptr<Graph> graph, bool optimize = true);
   void run(Stack& inputs);
+  // Compiles the plan that run() would pick for inputs like these under the
+  // current grad mode, without running it, so the first call with such
+  // inputs does not pay for optimization. Safe to call concurrently with
+  // run(), e.g. from a background thread.
+  void warmup(const Stack& inputs);
+  // The plans optimized so far, e.g. to save them with a model.
+  std::vector<OptimizedPlan> optimizedPlans();
+  // Installs a plan optimized by an executor of the same graph, so that inputs
+  // matching its spec run it instead of being optimized. Returns false if this
+  // executor does not optimize, or already has a plan for the spec.
+  bool addOptimizedPlan(const OptimizedPlan& plan);
   explicit operator bool() const {
     return pImpl != nullptr;
   }
@@ -46,6 +68,11 @@ struct TORCH_API GraphExecutor {
 TORCH_API void runRequiredPasses(const std::shared_ptr<Graph>& g);
 
 TORCH_API void debugSetAutodiffSubgraphInlining(bool state);
+
+// When set, optimizing GraphExecutors profile the first runs of each
+// ArgumentSpec and specialize the graph to the input shapes they observed,
+// guarded by a check of the inputs (see runProfiled in graph_executor.cpp).
+TORCH_API std::atomic<bool>& getProfilingMode();
 TORCH_API std::shared_ptr<Graph> lastExecutedOptimizedGraph();
 
 namespace detail {
@@ -0,0 +1,335 @@
+#include <torch/csrc/jit/graph_serialization.h>
+
+#include <ATen/core/functional.h>
+#include <c10/util/Exception.h>
+#include <c10/util/StringUtil.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+using c10::ivalue::Tuple;
+
+// A graph is encoded as its block, and
+//   block: (inputs: [value], nodes: [node], outputs: [int])
+//   value: (id: int, name: str, type)
+//   node:  (kind: str, inputs: [int], outputs: [value],
+//           attributes: [(name: str, kind: int, value)], blocks: [block])
+//   type:  (kind: str, ...contained types and tensor properties)
+// where values are referred to by the ids of their definitions, which are
+// unique within a graph, but not within the graphs of its attributes.
+
+IValue tuple(std::vector<IValue> elements) {
+  return Tuple::create(std::move(elements));
+}
+
+const std::vector<IValue>& tupleElements(const IValue& ivalue) {
+  return ivalue.toTuple()->elements();
+}
+
+IValue typeToIValue(const TypePtr& type) {
+  std::vector<IValue> elements;
+  elements.emplace_back(typeKindToString(type->kind()));
+  switch (type->kind()) {
+    case TypeKind::TensorType:
+    case TypeKind::AutogradZeroTensorType:
+    case TypeKind::NumberType:
+    case TypeKind::FloatType:
+    case TypeKind::IntType:
+    case TypeKind::NoneType:
+    case TypeKind::StringType:
+    case TypeKind::GeneratorType:
+    case TypeKind::BoolType:
+    case TypeKind::DeviceObjType:
+      break;
+    case TypeKind::DimensionedTensorType: {
+      auto tensor = type->expect<DimensionedTensorType>();
+      elements.emplace_back(static_cast<int64_t>(tensor->scalarType()));
+      elements.emplace_back(c10::str(tensor->device()));
+      elements.emplace_back(tensor->dim());
+      elements.emplace_back(tensor->requires_grad());
+    } break;
+    case TypeKind::CompleteTensorType: {
+      auto tensor = type->expect<CompleteTensorType>();
+      elements.emplace_back(static_cast<int64_t>(tensor->scalarType()));
+      elements.emplace_back(c10::str(tensor->device()));
+      elements.emplace_back(tensor->sizes());
+      elements.emplace_back(tensor->strides());
+      elements.emplace_back(tensor->requires_grad());
+    } break;
+    case TypeKind::TupleType: {
+      auto tuple_type = type->expect<TupleType>();
+      elements.emplace_back(fmap(tuple_type->elements(), typeToIValue));
+      if (tuple_type->hasNames()) {
+        elements.emplace_back(fmap<IValue>(tuple_type->names()));
+      } else {
+        elements.emplace_back(IValue());
+      }
+    } break;
+    case TypeKind::ListType:
+    case TypeKind::OptionalType:
+    case TypeKind::FutureType:
+    case TypeKind::DictType:
+      for (const TypePtr& contained : type->containedTypes()) {
+        elements.emplace_back(typeToIValue(contained));
+      }
+      break;
+    default:
+      AT_ERROR("cannot serialize a graph with values of type ", type->str());
+  }
+  return tuple(std::move(elements));
+}
+
+TypePtr typeFromIValue(const IValue& ivalue) {
+  static const std::unordered_map<std::string, TypeKind> kinds = {
+#define DEFINE_KIND(T) {#T, TypeKind::T},
+      C10_FORALL_TYPES(DEFINE_KIND)
+#undef DEFINE_KIND
+  };
+  const auto& elements = tupleElements(ivalue);
+  auto contained = [&](size_t i) { return typeFromIValue(elements.at(i)); };
+  switch (kinds.at(elements.at(0).toStringRef())) {
+    case TypeKind::TensorType:
+      return TensorType::get();
+    case TypeKind::AutogradZeroTensorType:
+      return AutogradZeroTensorType::get();
+    case TypeKind::NumberType:
+      return NumberType::get();
+    case TypeKind::FloatType:
+      return FloatType::get();
+    case TypeKind::IntType:
+      return IntType::get();
+    case TypeKind::NoneType:
+      return NoneType::get();
+    case TypeKind::StringType:
+      return StringType::get();
+    case TypeKind::GeneratorType:
+      return GeneratorType::get();
+    case TypeKind::BoolType:
+      return BoolType::get();
+    case TypeKind::DeviceObjType:
+      return DeviceObjType::get();
+    case TypeKind::DimensionedTensorType:
+      return DimensionedTensorType::create(
+          static_cast<at::ScalarType>(elements.at(1).toInt()),
+          at::Device(elements.at(2).toStringRef()),
+          elements.at(3).toInt(),
+          elements.at(4).toBool());
+    case TypeKind::CompleteTensorType:
+      return CompleteTensorType::create(
+          static_cast<at::ScalarType>(elements.at(1).toInt()),
+          at::Device(elements.at(2).toStringRef()),
+          at::IntArrayRef(elements.at(3).toIntListRef()),
+          at::IntArrayRef(elements.at(4).toIntListRef()),
+          elements.at(5).toBool());
+    case TypeKind::TupleType: {
+      OptNameList names;
+      if (!elements.at(2).isNone()) {
+        names = fmap(elements.at(2).toGenericListRef(), [](const IValue& name) {
+          return name.toStringRef();
+        });
+      }
+      return TupleType::create(
+          fmap(elements.at(1).toGenericListRef(), typeFromIValue),
+          std::move(names));
+    }
+    case TypeKind::ListType:
+      return ListType::create(contained(1));
+    case TypeKind::OptionalType:
+      return OptionalType::create(contained(1));
+    case TypeKind::FutureType:
+      return FutureType::create(contained(1));
+    case TypeKind::DictType:
+      return DictType::create(contained(1), contained(2));
+    default:
+      AT_ERROR(
+          "cannot deserialize a graph with values of type ",
+          elements.at(0).toStringRef());
+  }
+}
+
+IValue attributeToIValue(const Node* node, Symbol name) {
+  IValue value;
+  switch (node->kindOf(name)) {
+    case AttributeKind::f:
+      value = node->f(name);
+      break;
+    case AttributeKind::fs:
+      value = fmap<IValue>(node->fs(name));
+      break;
+    case AttributeKind::i:
+      value = node->i(name);
+      break;
+    case AttributeKind::is:
+      value = node->is(name);
+      break;
+    case AttributeKind::s:
+      value = node->s(name);
+      break;
+    case AttributeKind::ss:
+      value = fmap<IValue>(node->ss(name));
+      break;
+    case AttributeKind::t:
+      value = node->t(name);
+      break;
+    case AttributeKind::ts:
+      value = node->ts(name);
+      break;
+    case AttributeKind::g:
+      value = graphToIValue(*node->g(name));
+      break;
+    case AttributeKind::gs:
+      value = fmap(node->gs(name), [](const std::shared_ptr<Graph>& g) {
+        return graphToIValue(*g);
+      });
+      break;
+  }
+  return tuple({name.toQualString(),
+                static_cast<int64_t>(node->kindOf(name)),
+                std::move(value)});
+}
+
+void attributeFromIValue(Node* node, const IValue& ivalue) {
+  const auto& elements = tupleElements(ivalue);
+  Symbol name = Symbol::fromQualString(elements.at(0).toStringRef());
+  const IValue& value = elements.at(2);
+  switch (static_cast<AttributeKind>(elements.at(1).toInt())) {
+    case AttributeKind::f:
+      node->f_(name, value.toDouble());
+      break;
+    case AttributeKind::fs:
+      node->fs_(name, fmap(value.toGenericListRef(), [](const IValue& v) {
+                  return v.toDouble();
+                }));
+      break;
+    case AttributeKind::i:
+      node->i_(name, value.toInt());
+      break;
+    case AttributeKind::is:
+      node->is_(name, value.toIntListRef());
+      break;
+    case AttributeKind::s:
+      node->s_(name, value.toStringRef());
+      break;
+    case AttributeKind::ss:
+      node->ss_(name, fmap(value.toGenericListRef(), [](const IValue& v) {
+                  return v.toStringRef();
+                }));
+      break;
+    case AttributeKind::t:
+      node->t_(name, value.toTensor());
+      break;
+    case AttributeKind::ts:
+      node->ts_(name, value.toTensorListRef());
+      break;
+    case AttributeKind::g:
+      node->g_(name, graphFromIValue(value));
+      break;
+    case AttributeKind::gs:
+      node->gs_(name, fmap(value.toGenericListRef(), graphFromIValue));
+      break;
+  }
+}
+
+IValue valueToIValue(const Value* v) {
+  return tuple({static_cast<int64_t>(v->unique()),
+                v->hasUniqueName() ? v->uniqueName() : std::string(),
+                typeToIValue(v->type())});
+}
+
+std::vector<int64_t> valueIds(at::ArrayRef<const Value*> values) {
+  return fmap(values, [](const Value* v) {
+    return static_cast<int64_t>(v->unique());
+  });
+}
+
+IValue blockToIValue(const Block* block) {
+  std::vector<IValue> nodes;
+  for (const Node* node : block->nodes()) {
+    if (node->kind() == prim::PythonOp || node->kind() == prim::profile) {
+      AT_ERROR(
+          "cannot serialize a graph with ", node->kind().toQualString(),
+          " nodes");
+    }
+    std::vector<IValue> attributes = fmap(
+        node->attributeNames(),
+        [&](Symbol name) { return attributeToIValue(node, name); });
+    nodes.emplace_back(tuple(
+        {node->kind().toQualString(),
+         valueIds(node->inputs()),
+         fmap(node->outputs(), valueToIValue),
+         std::move(attributes),
+         fmap(node->blocks(), blockToIValue)}));
+  }
+  return tuple({fmap(block->inputs(), valueToIValue),
+                std::move(nodes),
+                valueIds(block->outputs())});
+}
+
+struct GraphDecoder {
+  void defineValue(Value* v, const IValue& ivalue) {
+    const auto& elements = tupleElements(ivalue);
+    if (!elements.at(1).toStringRef().empty()) {
+      v->setUniqueName(elements.at(1).toStringRef());
+    }
+    v->setType(typeFromIValue(elements.at(2)));
+    values[elements.at(0).toInt()] = v;
+  }
+
+  Value* findValue(int64_t id) const {
+    auto it = values.find(id);
+    AT_CHECK(it != values.end(), "serialized graph uses undefined value ", id);
+    return it->second;
+  }
+
+  void decodeBlock(Block* block, const IValue& ivalue) {
+    const auto& elements = tupleElements(ivalue);
+    for (const IValue& input : elements.at(0).toGenericListRef()) {
+      defineValue(block->addInput(), input);
+    }
+    for (const IValue& node_ivalue : elements.at(1).toGenericListRef()) {
+      const auto& node_elements = tupleElements(node_ivalue);
+      Node* node = block->owningGraph()->create(
+          Symbol::fromQualString(node_elements.at(0).toStringRef()),
+          /*num_outputs=*/0);
+      block->appendNode(node);
+      for (int64_t id : node_elements.at(1).toIntListRef()) {
+        node->addInput(findValue(id));
+      }
+      for (const IValue& output : node_elements.at(2).toGenericListRef()) {
+        defineValue(node->addOutput(), output);
+      }
+      for (const IValue& attribute : node_elements.at(3).toGenericListRef()) {
+        attributeFromIValue(node, attribute);
+      }
+      for (const IValue& sub_block : node_elements.at(4).toGenericListRef()) {
+        decodeBlock(node->addBlock(), sub_block);
+      }
+    }
+    for (int64_t id : elements.at(2).toIntListRef()) {
+      block->registerOutput(findValue(id));
+    }
+  }
+
+  std::unordered_map<int64_t, Value*> values;
+};
+
+} // namespace
+
+IValue graphToIValue(const Graph& graph) {
+  return blockToIValue(graph.block());
+}
+
+std::shared_ptr<Graph> graphFromIValue(const IValue& ivalue) {
+  auto graph = std::make_shared<Graph>();
+  GraphDecoder().decodeBlock(graph->block(), ivalue);
+  return graph;
+}
+
+} // namespace jit
+} // namespace torch
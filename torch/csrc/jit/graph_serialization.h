@@ -0,0 +1,26 @@
+#pragma once
+
+#include <ATen/core/ivalue.h>
+#include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/csrc/jit/ir.h>
+
+#include <memory>
+
+namespace torch {
+namespace jit {
+
+// Converts a graph to an IValue made of tuples, lists, strings, numbers and
+// tensors that the Pickler can write, and back. Unlike the graphs printed as
+// code, all of the graph is kept: the exact types of its values, and the
+// nodes that only exist in optimized graphs (fusion groups, differentiable
+// graphs), so an optimized graph can be saved and run again without
+// optimizing it (see GraphExecutor::optimizedPlans).
+//
+// Nodes that are not described by their kind, inputs and attributes alone,
+// like Python ops, and values of class types cannot be converted and raise an
+// error.
+TORCH_API IValue graphToIValue(const Graph& graph);
+TORCH_API std::shared_ptr<Graph> graphFromIValue(const IValue& ivalue);
+
+} // namespace jit
+} // namespace torch
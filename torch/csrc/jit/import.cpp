@@ -3,6 +3,8 @@
 
 #include <ATen/core/functional.h>
 #include <c10/util/Exception.h>
+#include <torch/csrc/jit/graph_executor.h>
+#include <torch/csrc/jit/graph_serialization.h>
 #include <torch/csrc/jit/import.h>
 #include <torch/csrc/jit/import_export_helpers.h>
 #include <torch/csrc/jit/import_source.h>
@@ -19,6 +21,8 @@
 #include "caffe2/serialize/istream_adapter.h"
 
 #include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/detail/CUDAHooksInterface.h>
 
 #include <fstream>
 #include <string>
@@ -51,14 +55,17 @@ class ScriptModuleDeserializer final {
       script::ExtraFilesMap& extra_files);
 
  private:
+  at::Device tensorDevice(const torch::TensorDef& tensor_proto) const;
+  at::Storage loadStorage(const torch::TensorDef& tensor_proto);
   at::Tensor loadTensor(
       const torch::TensorDef& tensor_proto,
-      std::unordered_map<std::string, at::Storage>& storageMap);
+      const at::Storage& storage);
 
   void convertModule(const torch::ModuleDef& module_def);
 
   void loadTensorTable(torch::ModelDef* model_def);
   void loadAttributeTable();
+  void loadOptimizedPlans(script::Module& module, const std::string& key);
   void importCallback(const std::string& qualifier);
 
   caffe2::serialize::PyTorchStreamReader reader_;
@@ -148,71 +155,139 @@ void ScriptModuleDeserializer::deserialize(
 }
 
 void ScriptModuleDeserializer::loadTensorTable(torch::ModelDef* model_def) {
-  std::unordered_map<std::string, at::Storage> storageMap;
+  // tensors may share storages. the distinct storages are read in parallel,
+  // then the tensors are created in order.
+  std::unordered_map<std::string, size_t> storage_ids;
+  std::vector<const torch::TensorDef*> storage_defs;
   for (const torch::TensorDef& tensor : model_def->tensors()) {
-    tensor_table_.emplace_back(loadTensor(tensor, storageMap));
+    if (storage_ids.emplace(tensor.data().key(), storage_defs.size()).second) {
+      storage_defs.push_back(&tensor);
+    }
+  }
+  std::vector<at::Storage> storages(storage_defs.size());
+  at::parallel_for(
+      0, storage_defs.size(), 1, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          storages[i] = loadStorage(*storage_defs[i]);
+        }
+      });
+  for (const torch::TensorDef& tensor : model_def->tensors()) {
+    tensor_table_.emplace_back(
+        loadTensor(tensor, storages[storage_ids.at(tensor.data().key())]));
   }
 }
 
 void ScriptModuleDeserializer::loadAttributeTable() {
-  at::DataPtr attributes_ptr;
-  size_t attributes_size;
-  std::tie(attributes_ptr, attributes_size) =
-      reader_.getRecord("attributes.pkl");
-  Unpickler unpickler(attributes_ptr.get(), attributes_size, &tensor_table_);
+  // the attributes are unpickled as they are read, large attributes are
+  // never held in memory in their pickled form as a whole
+  Unpickler unpickler(
+      reader_.getRecordReader("attributes.pkl"), &tensor_table_);
   attribute_table_ = unpickler.parse_ivalue_list();
 }
 
+// The plans are only a cache of the optimizations of the methods, so those
+// that cannot be loaded, e.g. because an operator they call changed, are
+// left out and the inputs they were for are optimized again.
+void ScriptModuleDeserializer::loadOptimizedPlans(
+    script::Module& module,
+    const std::string& key) {
+  // the plans are specialized to the devices of the tensors they were saved
+  // for
+  if (!module.is_optimized() || device_.has_value()) {
+    return;
+  }
+  Unpickler unpickler(reader_.getRecordReader(key), &tensor_table_);
+  for (const IValue& ivalue : unpickler.parse_ivalue_list()) {
+    const auto& elements = ivalue.toTuple()->elements();
+    script::Method* method = module.find_method(elements.at(0).toStringRef());
+    if (!method) {
+      continue;
+    }
+    OptimizedPlan plan;
+    for (int64_t data : elements.at(1).toIntListRef()) {
+      plan.tensors.push_back(ArgumentInfo::fromPlainData(
+          static_cast<ArgumentInfo::plain_data_type>(data)));
+    }
+    for (int64_t is_present : elements.at(2).toIntListRef()) {
+      plan.optionals.push_back(is_present != 0);
+    }
+    try {
+      plan.graph = graphFromIValue(elements.at(3));
+      method->get_executor().addOptimizedPlan(plan);
+    } catch (const c10::Error& e) {
+      AT_WARN(
+          "Not loading an optimized plan of ",
+          method->name(),
+          ": ",
+          e.what_without_backtrace());
+    }
+  }
+}
+
+at::Device ScriptModuleDeserializer::tensorDevice(
+    const torch::TensorDef& tensor_proto) const {
+  AT_ASSERT(tensor_proto.has_device() && !tensor_proto.device().empty());
+  if (device_.has_value()) {
+    // override the device, if user provides map_location
+    return device_.value();
+  }
+  return at::Device(tensor_proto.device());
+}
+
+// called from several threads at once
+at::Storage ScriptModuleDeserializer::loadStorage(
+    const torch::TensorDef& tensor_proto) {
+  auto type = at::typeMetaToScalarType(
+      caffe2::DataTypeToTypeMeta(tensor_proto.data_type()));
+  const std::string& record_key = tensor_proto.data().key();
+  at::Device device = tensorDevice(tensor_proto);
+
+  at::DataPtr storage_ptr;
+  uint64_t record_size;
+  if (device.type() == at::DeviceType::CPU) {
+    std::tie(storage_ptr, record_size) = reader_.getRecord(record_key);
+  } else if (device.type() == at::DeviceType::CUDA) {
+    // stream the record through pinned memory, so that it is copied to the
+    // device asynchronously and the staging buffer is recycled by the
+    // caching host allocator, instead of keeping the model on the CPU
+    std::tie(storage_ptr, record_size) = reader_.getRecord(
+        record_key, at::detail::getCUDAHooks().getPinnedMemoryAllocator());
+  } else {
+    AT_ERROR(
+        "supported devices include CPU and CUDA, however got ",
+        at::DeviceTypeName(device.type(), false));
+  }
+  auto cpu_storage = at::Storage(
+      at::CPU(type).typeMeta(),
+      record_size / at::CPU(type).typeMeta().itemsize(),
+      std::move(storage_ptr),
+      /*allocator=*/nullptr,
+      /*resizable=*/false); // NB: we didn't set any allocator for the tensor
+  if (device.type() == at::DeviceType::CPU) {
+    return cpu_storage;
+  }
+  at::Tensor cpu_tensor =
+      at::empty({0}, at::CPU(type).options()).set_(cpu_storage);
+  return cpu_tensor
+      .to(device, cpu_tensor.scalar_type(), /*non_blocking=*/true)
+      .storage();
+}
+
 at::Tensor ScriptModuleDeserializer::loadTensor(
     const torch::TensorDef& tensor_proto,
-    std::unordered_map<std::string, at::Storage>& storageMap) {
+    const at::Storage& storage) {
   std::vector<int64_t> dims(
       tensor_proto.dims().begin(), tensor_proto.dims().end());
   std::vector<int64_t> strides(
       tensor_proto.strides().begin(), tensor_proto.strides().end());
   auto type = at::typeMetaToScalarType(
       caffe2::DataTypeToTypeMeta(tensor_proto.data_type()));
-  const std::string& record_key = tensor_proto.data().key();
-  AT_ASSERT(tensor_proto.has_device() && !tensor_proto.device().empty());
-  at::Device device(tensor_proto.device());
-  if (device_.has_value()) {
-    // override the device, if user provides map_location
-    device = device_.value();
-  }
-
-  auto storage_it = storageMap.find(record_key);
-  if (storage_it == storageMap.end()) {
-    at::DataPtr storage_ptr;
-    uint64_t record_size;
-    std::tie(storage_ptr, record_size) = reader_.getRecord(record_key);
-    auto cpu_storage = at::Storage(
-        at::CPU(type).typeMeta(),
-        record_size / at::CPU(type).typeMeta().itemsize(),
-        std::move(storage_ptr),
-        /*allocator=*/nullptr,
-        /*resizable=*/false); // NB: we didn't set any allocator for the tensor
-    if (device.type() == at::DeviceType::CPU) {
-      storage_it =
-          storageMap.insert(std::make_pair(record_key, cpu_storage)).first;
-    } else if (device.type() == at::DeviceType::CUDA) {
-      at::Tensor cpu_tensor =
-          at::empty({0}, at::CPU(type).options()).set_(cpu_storage);
-      at::Storage cuda_storage =
-          cpu_tensor.to(device, cpu_tensor.scalar_type()).storage();
-      storage_it =
-          storageMap.insert(std::make_pair(record_key, cuda_storage)).first;
-    } else {
-      AT_ERROR(
-          "supported devices include CPU and CUDA, however got ",
-          at::DeviceTypeName(device.type(), false));
-    }
-  }
-  if (storage_it->second.device().type() != device.type() ||
-      (device.has_index() &&
-       storage_it->second.device().index() != device.index())) {
+  at::Device device = tensorDevice(tensor_proto);
+  if (storage.device().type() != device.type() ||
+      (device.has_index() && storage.device().index() != device.index())) {
     std::stringstream oss;
     oss << "storage previously was specified with device "
-        << storage_it->second.device() << "but now is specified with device "
+        << storage.device() << "but now is specified with device "
         << device << std::endl;
     AT_ERROR(oss.str());
   }
@@ -221,12 +296,12 @@ at::Tensor ScriptModuleDeserializer::loadTensor(
   if (device.type() == at::DeviceType::CPU) {
     result =
         at::empty({0}, at::CPU(type).options())
-            .set_(storage_it->second, tensor_proto.offset(), dims, strides);
+            .set_(storage, tensor_proto.offset(), dims, strides);
   } else if (device.type() == at::DeviceType::CUDA) {
     result =
         at::empty(
-            {0}, c10::TensorOptions(type).device(storage_it->second.device()))
-            .set_(storage_it->second, tensor_proto.offset(), dims, strides);
+            {0}, c10::TensorOptions(type).device(storage.device()))
+            .set_(storage, tensor_proto.offset(), dims, strides);
   }
   AT_ASSERT(result.defined());
 
@@ -303,6 +378,9 @@ void ScriptModuleDeserializer::convertModule(
         tensor_table_,
         import_callback);
   }
+  if (module_def.has_optimized_plans()) {
+    loadOptimizedPlans(*module, module_def.optimized_plans().key());
+  }
 }
 
 } // namespace
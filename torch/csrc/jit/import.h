@@ -58,6 +58,10 @@ TORCH_API std::shared_ptr<script::Module> load(
 /// The reader adapter, which is for customized input stream, must contain a
 /// serialized `script::Module`, exported either via `ScriptModule.save()` in
 /// Python or `torch::jit::ExportModule` in C++.
+///
+/// With a `caffe2::serialize::MmapFileAdapter`, the CPU tensors of the module
+/// point directly into the mapped file instead of being copied, so loading
+/// is fast and processes that load the same file share its memory.
 TORCH_API std::shared_ptr<script::Module> load(
     std::unique_ptr<caffe2::serialize::ReadAdapterInterface> rai,
     c10::optional<c10::Device> device = c10::nullopt,
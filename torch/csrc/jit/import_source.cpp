@@ -186,7 +186,7 @@ struct SourceImporter {
         v->setType(class_type);
         return std::make_shared<SimpleValue>(v);
       };
-      cu->define(definitions, resolvers, self);
+      cu->define(definitions, resolvers, self, /*parallel=*/true);
       owner.register_class(class_type);
     }
   }
@@ -201,7 +201,9 @@ struct SourceImporter {
       definitions.emplace_back(def);
       resolvers.emplace_back(resolver_);
     }
-    cu.define(definitions, resolvers, self);
+    // SourceResolver only reads tables built before this point, so the
+    // definitions can be compiled concurrently
+    cu.define(definitions, resolvers, self, /*parallel=*/true);
   }
 
   size_t parseVersionNumber() {
@@ -18,10 +18,13 @@
 #include <torch/csrc/jit/passes/create_autodiff_subgraphs.h>
 #include <torch/csrc/jit/passes/dead_code_elimination.h>
 #include <torch/csrc/jit/passes/erase_number_types.h>
+#include <torch/csrc/jit/passes/freeze_module.h>
 #include <torch/csrc/jit/passes/graph_fuser.h>
 #include <torch/csrc/jit/passes/inline_fork_wait.h>
 #include <torch/csrc/jit/passes/loop_unrolling.h>
 #include <torch/csrc/jit/passes/lower_tuples.h>
+#include <torch/csrc/jit/passes/memory_planning.h>
+#include <torch/csrc/jit/passes/mkldnn_layout.h>
 #include <torch/csrc/jit/passes/onnx.h>
 #include <torch/csrc/jit/passes/onnx/constant_fold.h>
 #include <torch/csrc/jit/passes/onnx/fixup_onnx_loop.h>
@@ -156,6 +159,20 @@ void initJITBindings(PyObject* module) {
             // We don't need this node anymore, don't forget to remove it.
             new_node->destroy();
           })
+      .def(
+          "_jit_pass_insert_histogram_observers",
+          [](std::shared_ptr<script::Module>& moduleObj,
+             const std::string& methodName) {
+            InsertHistogramObservers(moduleObj, methodName);
+          })
+      .def(
+          "_jit_compute_qparams_from_histograms",
+          [](const std::string& method, double percentile) {
+            return ComputeQParamsFromHistograms(method, percentile);
+          },
+          py::arg("method") = "min_max",
+          py::arg("percentile") = 99.99)
+      .def("_jit_reset_histograms", [] { ResetHistograms(); })
       .def(
           "_jit_pass_insert_quantdequant",
           [](std::shared_ptr<Graph>& g, py::dict& pyQParamDict) {
@@ -188,6 +205,12 @@ void initJITBindings(PyObject* module) {
                 pattern, fused_node_name, inputs, outputs);
             pattern_fuser.runOnModule(m);
           })
+      .def(
+          "_jit_pass_freeze_module",
+          [](std::shared_ptr<script::Module> m) { FreezeModule(*m); })
+      .def(
+          "_jit_pass_fold_frozen_weights",
+          [](std::shared_ptr<Graph>& g) { FoldFrozenWeights(g); })
       .def(
           "_jit_pass_fold_quant_inputs",
           [](std::shared_ptr<Graph>& g) {
@@ -197,6 +220,12 @@ void initJITBindings(PyObject* module) {
           "_jit_pass_remove_inplace_ops",
           [](std::shared_ptr<Graph> g) { return RemoveInplaceOps(g); })
       .def("_jit_pass_constant_pooling", ConstantPooling)
+      .def(
+          "_jit_pass_memory_planning",
+          [](std::shared_ptr<Graph>& g) { return MemoryPlanning(g); })
+      .def(
+          "_jit_pass_convert_to_mkldnn",
+          [](std::shared_ptr<Graph>& g) { return ConvertToMKLDNN(g); })
       .def(
           "_jit_pass_peephole",
           [](const std::shared_ptr<Graph>& g, bool addmm_fusion_enabled) {
@@ -270,6 +299,9 @@ void initJITBindings(PyObject* module) {
       .def("_jit_pass_canonicalize_ops", CanonicalizeOps)
       .def("_jit_pass_specialize_autogradzero", specializeAutogradZero)
       .def("_jit_override_can_fuse_on_cpu", &overrideCanFuseOnCPU)
+      .def(
+          "_jit_set_profiling_mode",
+          [](bool profiling_flag) { getProfilingMode() = profiling_flag; })
       .def(
           "_jit_differentiate",
           [](Graph& g) {
@@ -349,6 +381,7 @@ void initJITBindings(PyObject* module) {
              const std::string& name,
              const char* data,
              size_t size) { return self.writeRecord(name, data, size); })
+      .def("set_compression", &PyTorchStreamWriter::setCompression)
       .def("write_end_of_file", &PyTorchStreamWriter::writeEndOfFile);
 
   py::class_<PyTorchStreamReader>(m, "PyTorchFileReader")
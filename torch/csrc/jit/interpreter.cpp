@@ -12,6 +12,8 @@
 #include <torch/csrc/jit/operator.h>
 #include <torch/csrc/jit/script/jit_exception.h>
 
+#include <chrono>
+#include <condition_variable>
 #include <exception>
 #include <iostream>
 #include <memory>
@@ -331,6 +333,9 @@ struct Instruction {
   ListHandle<int> outputs;
   Symbol debug_name; // used in dump to understand the generated code
   std::shared_ptr<SourceLocation> debug_location; // for error reporting
+  // prim::Drop only clears registers, which the interpreter does directly
+  // instead of moving the values through the stack
+  bool is_drop;
 };
 
 int relativeJump(int from_inst, int to_inst) {
@@ -471,6 +476,11 @@ struct CodeImpl {
           createJumpFalse(cond_branch, instructions.size());
           createJumpTrue(cond_branch_end, entry);
         } break;
+        case prim::Constant: {
+          if (!insertConstant(node)) {
+            insertInstruction(node);
+          }
+        } break;
         default: {
           insertInstruction(node);
         } break;
@@ -478,6 +488,20 @@ struct CodeImpl {
     }
   }
 
+  // Constants are loaded into their registers once when an InterpreterState
+  // is created, rather than pushed by an instruction each time they are
+  // reached; their uses then read the register like any other input.
+  bool insertConstant(Node* node) {
+    auto value = toIValue(node->output());
+    if (!value) {
+      return false;
+    }
+    int reg = getOrAllocateRegister(node->output());
+    constant_registers.insert(reg);
+    constants.emplace_back(reg, std::move(*value));
+    return true;
+  }
+
   size_t insertInstruction(Node* n) {
     auto inst = insertInstruction(
         n->kind(),
@@ -486,6 +510,7 @@ struct CodeImpl {
         moveFlags(n),
         n->outputs());
     instructions[inst].callback = getOperation(n);
+    instructions[inst].is_drop = n->kind() == prim::Drop;
     return inst;
   }
   size_t insertInstruction(
@@ -503,8 +528,12 @@ struct CodeImpl {
       listInsert(inst.inputs.values, getOrAllocateRegister(input, true));
     }
     listBegin(inst.inputs.free_flags);
-    for (auto flag : move_flags) {
-      listInsert(inst.inputs.free_flags, flag);
+    for (size_t i = 0; i < move_flags.size(); ++i) {
+      // constant registers are reused by every execution of the use, e.g.
+      // in a loop body, so they are never moved from
+      bool is_constant =
+          constant_registers.count(get(inst.inputs.values, i)) > 0;
+      listInsert(inst.inputs.free_flags, move_flags[i] && !is_constant);
     }
     listBegin(inst.outputs);
     for (auto output : outputs) {
@@ -624,6 +653,9 @@ struct CodeImpl {
     writeUseList(inst.inputs);
   }
   void dump(std::ostream& out) const {
+    for (const auto& constant : constants) {
+      out << constant.first << " = constant " << constant.second << "\n";
+    }
     for (size_t i = 0; i < instructions.size(); ++i) {
       dumpInstruction(out, i);
       out << "\n";
@@ -646,6 +678,10 @@ struct CodeImpl {
   std::vector<Instruction> instructions;
   int register_size = 0;
 
+  // registers holding hoisted constants and their values
+  std::unordered_set<int> constant_registers;
+  std::vector<std::pair<int, IValue>> constants;
+
   // all memory ArrayRef<int> are slices of this, to make sure
   // the interpreter is mostly linearly scanning through memory
   std::vector<int> int_data;
@@ -658,7 +694,11 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
       : function(code.pImpl),
         int_data(function->int_data.data()),
         bool_data(function->bool_data),
-        registers(function->register_size) {}
+        registers(function->register_size) {
+    for (const auto& constant : function->constants) {
+      registers[constant.first] = constant.second;
+    }
+  }
 
  private:
   c10::intrusive_ptr<InterpreterStateImpl> intrusive_from_this() {
@@ -675,6 +715,15 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
       // function->dumpInstruction(std::cout, pc);
       // std::cout << "\n";
       auto& inst = instructions[pc];
+      if (inst.is_drop) {
+        for (int i = 0; i < inst.inputs.values.size; i++) {
+          if (get(inst.inputs.free_flags, i)) {
+            registers[get(inst.inputs.values, i)] = IValue();
+          }
+        }
+        ++pc;
+        continue;
+      }
       try {
         loadTensorsFromRegisters(inst.inputs, stack);
         size_t new_pc = pc + 1 + inst.callback(stack);
@@ -698,10 +747,15 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
         // Make sure adding callback is the last step.
         // Otherwise if e.future has completed,
         // the current thread will continue running before it suspends.
+        // The continuation is queued by whichever thread completes the
+        // future; on an inter-op worker it goes onto that worker's own deque,
+        // so a chain of forks and waits stays on one thread. The grad mode
+        // is the one of this thread, not of the completing one.
         InterpreterState state(intrusive_from_this());
-        e.future->addCallback([state]() {
-          c10::global_work_queue().run(InterpreterContinuation(
-              state, Stack(), autograd::GradMode::is_enabled()));
+        bool grad_mode_enabled = autograd::GradMode::is_enabled();
+        e.future->addCallback([state, grad_mode_enabled]() {
+          c10::global_work_queue().run(
+              InterpreterContinuation(state, Stack(), grad_mode_enabled));
         });
 
         return true;
@@ -748,6 +802,45 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
   }
 
  public:
+  // Blocks until future completes, running queued inter-op tasks meanwhile.
+  // On an inter-op worker this keeps helping until the future is done, since
+  // the work it waits on may be queued behind it and every other worker may
+  // be blocked the same way; other threads only help while there is a
+  // backlog.
+  static void waitHelping(Future& future) {
+    auto pool =
+        dynamic_cast<c10::WorkStealingThreadPool*>(&c10::global_work_queue());
+    if (!pool) {
+      return future.wait();
+    }
+    if (!pool->inThreadPool()) {
+      while (!future.completed() && pool->runPendingTask()) {
+      }
+      return future.wait();
+    }
+    struct Completion {
+      std::mutex mutex;
+      std::condition_variable cv;
+      bool done = false;
+    };
+    auto completion = std::make_shared<Completion>();
+    future.addCallback([completion]() {
+      std::lock_guard<std::mutex> lock(completion->mutex);
+      completion->done = true;
+      completion->cv.notify_all();
+    });
+    while (!future.completed()) {
+      if (pool->runPendingTask()) {
+        continue;
+      }
+      // new work may be queued without waking us up, so poll for it
+      std::unique_lock<std::mutex> lock(completion->mutex);
+      completion->cv.wait_for(lock, std::chrono::milliseconds(1), [&] {
+        return completion->done;
+      });
+    }
+  }
+
   c10::intrusive_ptr<Future> getOrCreateFuture() {
     if (!future) {
       future = c10::make_intrusive<Future>();
@@ -763,7 +856,7 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
 
   void run(Stack& stack) {
     if (runImpl(stack)) {
-      future->wait();
+      waitHelping(*future);
 
       auto num_outputs = function->preprocess.n_outputs;
       if (num_outputs == 1) {
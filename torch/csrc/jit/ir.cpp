@@ -852,6 +852,7 @@ bool Node::hasSideEffects() const {
     case aten::manual_seed:
     case prim::AddStatValue:
     case prim::TimePoint:
+    case prim::ObserveHistogram:
       return true;
   }
   // All other builtin ops are known to be safe.
@@ -20,29 +20,28 @@ struct OperatorRegistry {
  private:
   std::mutex lock;
   OperatorMap operators;
-  // list of operators whose schema have not yet been parsed, and must
-  // be registered before any call to lookup an opeator
+  // list of operators that have not yet been added to the operators map, and
+  // must be registered before any call to lookup an opeator
   std::vector<std::shared_ptr<Operator>> to_register;
-  // Those two maps are used to implement lookupByLiteral, which is needed for
-  // the n->match(...) calls. Basically, every function schema is assigned a
+  // This map is used to implement lookupByLiteral, which is needed for the
+  // n->match(...) calls. Basically, every function schema is assigned a
   // unique string you can use to match it. However, parsing those strings or
-  // comparing and hashing them character by character would be very slow, so we
-  // use a trick here! Every string literal in your program is guaranteed to
-  // have static storage duration and so its address won't change at runtime.
-  // This allows us to memoize answers for every pointer, which is done by the
-  // operators_by_sig_literal map. Still, this map is initially empty, and so we
-  // still need to do the complete string matching at the first time, which is
-  // implemented by performing a lookup in the operators_by_sig map.
-  std::unordered_map<std::string, std::shared_ptr<Operator>> operators_by_sig;
+  // comparing and hashing them character by character would be very slow, so
+  // we use a trick here! Every string literal in your program is guaranteed
+  // to have static storage duration and so its address won't change at
+  // runtime. This allows us to memoize answers for every pointer. Still, this
+  // map is initially empty, and so we still need to do the complete string
+  // matching at the first time, against the operators of the same name.
   std::unordered_map<const char*, std::shared_ptr<Operator>>
       operators_by_sig_literal;
 
   // XXX - caller must be holding lock
   void registerPendingOperators() {
-    for (const auto& op : to_register) {
-      Symbol sym = Symbol::fromQualString(op->schema().name());
-      operators[sym].push_back(op);
-      operators_by_sig[canonicalSchemaString(op->schema())] = op;
+    // Schemas given as strings are left unparsed until an operator is
+    // matched against them, so that starting up does not parse all of them.
+    for (auto& op : to_register) {
+      Symbol sym = Symbol::fromQualString(op->qualifiedName());
+      operators[sym].push_back(std::move(op));
     }
     to_register.clear();
   }
@@ -58,22 +57,34 @@ struct OperatorRegistry {
     registerPendingOperators();
     auto it = operators_by_sig_literal.find(name);
     if (it == operators_by_sig_literal.end()) {
-      auto op_ptr_it =
-          operators_by_sig.find(canonicalSchemaString(parseSchema(name)));
-      // Handy debugging code that dumps all operators we know about on mismatch
+      const FunctionSchema schema = parseSchema(name);
+      const std::string canonical = canonicalSchemaString(schema);
+      std::shared_ptr<Operator> match;
+      auto ops_it = operators.find(Symbol::fromQualString(schema.name()));
+      if (ops_it != operators.end()) {
+        // the last operator registered with a schema wins
+        for (auto op = ops_it->second.rbegin(); op != ops_it->second.rend();
+             ++op) {
+          if (canonicalSchemaString((*op)->schema()) == canonical) {
+            match = *op;
+            break;
+          }
+        }
+      }
+      // Handy debugging code that dumps the operators of this name on mismatch
 #if 0
-      if (op_ptr_it == operators_by_sig.end()) {
-        for (auto & entry : operators_by_sig) {
-          std::cout << entry.first << std::endl;
+      if (!match && ops_it != operators.end()) {
+        for (auto& op : ops_it->second) {
+          std::cout << canonicalSchemaString(op->schema()) << std::endl;
         }
       }
 #endif
       AT_CHECK(
-          op_ptr_it != operators_by_sig.end(),
+          match,
           "Couldn't find an operator for ",
           name,
           ". Do you have to update a set of hardcoded JIT ops?");
-      it = operators_by_sig_literal.emplace_hint(it, name, op_ptr_it->second);
+      it = operators_by_sig_literal.emplace_hint(it, name, std::move(match));
     }
     return it->second;
   }
@@ -123,7 +134,8 @@ OperatorRegistry& getRegistry() {
 } // anonymous namespace
 
 void registerOperator(Operator&& op) {
-  if (op.schema().is_varret()) {
+  // schema strings never parse to varret schemas, so they are left unparsed
+  if (op.isSchemaParsed() && op.schema().is_varret()) {
     Symbol s = Symbol::fromQualString(op.schema().name());
     if (!printerHasSpecialCaseFor(s)) {
       AT_ERROR(
@@ -189,6 +201,18 @@ std::string canonicalSchemaString(const FunctionSchema& schema) {
   return out.str();
 }
 
+std::string Operator::qualifiedName() const {
+  if (schema_) {
+    return schema_->name();
+  }
+  const std::string& schema = schema_string_.value();
+  const size_t begin = schema.find_first_not_of(" \t\n");
+  AT_CHECK(begin != std::string::npos, "empty operator schema");
+  // the name ends at the overload name or the arguments
+  const size_t end = schema.find_first_of(".( \t\n", begin);
+  return schema.substr(begin, end == std::string::npos ? end : end - begin);
+}
+
 bool Operator::matches(const Node* node) const {
   // wrong name
   if (node->kind().toQualString() != schema().name()) {
@@ -132,6 +132,14 @@ struct TORCH_API Operator {
     return *schema_;
   }
 
+  // The qualified name of the schema, e.g. aten::add, which is read off the
+  // schema string without parsing it.
+  std::string qualifiedName() const;
+
+  bool isSchemaParsed() const {
+    return schema_ != nullptr;
+  }
+
   const OperatorOptions& options() const {
     return options_;
   }
@@ -120,13 +120,7 @@ bool AliasDb::hasWriters(const Value* v) const {
     rebuildWriteCache();
   }
 
-  for (const auto loc : elementMap_.at(v)->getMemoryLocations()) {
-    if (writeCache_.count(loc)) {
-      return true;
-    }
-  }
-
-  return false;
+  return writeCache_.intersects(elementMap_.at(v)->getMemoryLocations());
 }
 
 bool AliasDb::hasWrites(Node* n) const {
@@ -412,6 +406,7 @@ void AliasDb::analyzeImpl(Node* node) {
     case prim::FusedConcat:
     case prim::MMTreeReduce:
     case prim::MMBatchSide:
+    case prim::BatchedLinear:
     case prim::BroadcastSizes:
     case prim::ChunkSizes:
     case prim::Function:
@@ -577,6 +572,7 @@ void AliasDb::registerWrite(const Value* v, Node* n) {
 
   AT_ASSERT(elementMap_.count(v));
   writeIndex_[n].insert(v);
+  isWriteCacheStale_ = true;
 }
 
 void AliasDb::analyzeIf(Node* node) {
@@ -814,6 +810,7 @@ void AliasDb::makePointerTo(const Value* from, const Value* to) {
   auto toEl = getOrCreateElement(to);
 
   memoryDAG_->makePointerTo(fromEl, toEl);
+  isWriteCacheStale_ = true;
 }
 
 void AliasDb::addToContainedElements(
@@ -1303,6 +1300,7 @@ bool aliasAnalysisHasSpecialCaseFor(Symbol symbol) {
       prim::GradOf,
       prim::MMTreeReduce,
       prim::MMBatchSide,
+      prim::BatchedLinear,
       prim::BroadcastSizes,
       prim::ChunkSizes,
       prim::Function,
@@ -1350,13 +1348,12 @@ void AliasDb::setWildcard(const Value* v) {
 }
 
 void AliasDb::rebuildWriteCache() const {
+  writeCache_.clear();
   for (const auto& pr : writeIndex_) {
     const auto& writtenValues = pr.second;
 
     for (const auto value : writtenValues) {
-      for (const auto loc : elementMap_.at(value)->getMemoryLocations()) {
-        writeCache_.insert(loc);
-      }
+      writeCache_ |= elementMap_.at(value)->getMemoryLocations();
     }
   }
   isWriteCacheStale_ = false;
@@ -1368,9 +1365,9 @@ ValueSet AliasDb::getMemoryLocations(const Value* v) const {
     return ret;
   }
 
-  for (const auto el : elementMap_.at(v)->getMemoryLocations()) {
-    ret.insert(el->value);
-  }
+  elementMap_.at(v)->getMemoryLocations().forEach([&](unsigned loc) {
+    ret.insert(memoryDAG_->fromIndex(loc)->value);
+  });
   return ret;
 }
 } // namespace jit
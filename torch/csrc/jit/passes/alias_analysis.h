@@ -86,21 +86,24 @@ class AliasDb {
       return true;
     }
 
-    T<Element*> aElements;
+    // Union the cached memory locations of `a`, then test each value of `b`
+    // against them, without building sets of elements.
+    MemoryLocations aLocations;
     for (const Value* v : a) {
-      if (elementMap_.count(v)) {
-        aElements.insert(elementMap_.at(v));
+      const auto it = elementMap_.find(v);
+      if (it != elementMap_.end()) {
+        aLocations |= it->second->getMemoryLocations();
       }
     }
 
-    U<Element*> bElements;
     for (const Value* v : b) {
-      if (elementMap_.count(v)) {
-        bElements.insert(elementMap_.at(v));
+      const auto it = elementMap_.find(v);
+      if (it != elementMap_.end() &&
+          aLocations.intersects(it->second->getMemoryLocations())) {
+        return true;
       }
     }
-
-    return memoryDAG_->mayAlias(aElements, bElements);
+    return false;
   }
 
   // Do any nodes write to an alias set inputed/outputed by `n`?
@@ -245,7 +248,8 @@ class AliasDb {
   // State for tracking write info
   size_t numWrites_ = 0;
   std::unordered_map<Node*, ValueSet> writeIndex_;
-  mutable std::unordered_set<const Element*> writeCache_;
+  // The memory locations written to by any node
+  mutable MemoryLocations writeCache_;
   mutable bool isWriteCacheStale_ = true;
   void rebuildWriteCache() const;
 };
@@ -3,6 +3,7 @@
 #include <ATen/core/functional.h>
 #include <ATen/core/interned_strings.h>
 #include <c10/util/Exception.h>
+#include <torch/csrc/autograd/variable.h>
 #include <torch/csrc/jit/constants.h>
 #include <torch/csrc/jit/custom_operator.h>
 #include <torch/csrc/jit/passes/alias_analysis.h>
@@ -11,7 +12,9 @@
 
 #include <ATen/ATen.h>
 #include <algorithm>
+#include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace torch {
 namespace jit {
@@ -356,31 +359,45 @@ RegisterOperators mm_batch_side_reg(
       };
     })});
 
+// Sorts mms topologically and drops those that depend on an earlier one.
+std::vector<Node*> filterIndependent(std::vector<Node*> mms, AliasDb& alias_db) {
+  if (mms.size() == 0) {
+    return mms;
+  }
+  std::sort(
+      mms.begin(), mms.end(), [](Node* n, Node* m) { return n->isBefore(m); });
+  // Filter out dependent MMs. This algorithm might do very badly if e.g. you
+  // have a lot of independent MMs, that depend on the first one, but I doubt
+  // this will be a common scenario.
+  for (size_t i = 0; i < mms.size(); ++i) {
+    if (mms[i] == nullptr)
+      continue;
+    for (size_t j = i + 1; j < mms.size(); ++j) {
+      if (mms[j] == nullptr)
+        continue;
+      if (!alias_db.couldMoveBeforeTopologically(mms[j], mms[i])) {
+        mms[j] = nullptr;
+      }
+    }
+  }
+  return c10::filter(mms, [](Node* n) { return n != nullptr; });
+}
+
+// Moves the (independent, sorted) nodes next to each other, right before
+// the last one.
+void moveTogether(std::vector<Node*>& nodes, AliasDb& alias_db) {
+  for (int64_t i = static_cast<int64_t>(nodes.size()) - 2; i >= 0; --i) {
+    bool move_ok =
+        alias_db.moveBeforeTopologicallyValid(nodes[i], nodes[i + 1]);
+    AT_ASSERT(move_ok);
+  }
+}
+
 std::pair<std::vector<Node*>, std::vector<Node*>> gatherIndependentMMUses(
     Value* value,
     AliasDb& alias_db) {
   const auto postprocess = [&](std::vector<Node*> mms) {
-    if (mms.size() == 0) {
-      return mms;
-    }
-    std::sort(mms.begin(), mms.end(), [](Node* n, Node* m) {
-      return n->isBefore(m);
-    });
-    // Filter out dependent MMs. This algorithm might do very badly if e.g. you
-    // have a lot of independent MMs, that depend on the first one, but I doubt
-    // this will be a common scenario.
-    for (size_t i = 0; i < mms.size(); ++i) {
-      if (mms[i] == nullptr)
-        continue;
-      for (size_t j = i + 1; j < mms.size(); ++j) {
-        if (mms[j] == nullptr)
-          continue;
-        if (!alias_db.couldMoveBeforeTopologically(mms[j], mms[i])) {
-          mms[j] = nullptr;
-        }
-      }
-    }
-    return c10::filter(mms, [](Node* n) { return n != nullptr; });
+    return filterIndependent(std::move(mms), alias_db);
   };
 
   Block* block = value->node()->owningBlock();
@@ -404,10 +421,7 @@ void BatchMMSide(Block* block, AliasDb& alias_db) {
   static constexpr size_t how_many_is_many = 8;
   const auto batch_side = [&](std::vector<Node*>& mms, Side side) {
     AT_ASSERT(!mms.empty());
-    for (int64_t i = static_cast<int64_t>(mms.size()) - 2; i >= 0; --i) {
-      bool move_ok = alias_db.moveBeforeTopologicallyValid(mms[i], mms[i + 1]);
-      AT_ASSERT(move_ok);
-    }
+    moveTogether(mms, alias_db);
     WithInsertPoint insert_guard{mms[0]};
     Graph* graph = mms[0]->owningGraph();
     Node* batch_mm = graph->create(
@@ -447,6 +461,234 @@ void BatchMMSide(Block* block, AliasDb& alias_db) {
   }
 }
 
+// Independent projections of the same input, e.g. the query, key and value
+// projections of attention or the towers of a multi-head MLP, are merged
+// into a single wider GEMM:
+//
+//   y1 = linear(x, W1, b1)        W = cat([W1, W2])   b = cat([b1, b2])
+//   y2 = linear(x, W2, b2)   =>   y1, y2 = split(linear(x, W, b))
+//
+// Besides aten::linear, the projections may be matmuls or mms with x on the
+// left (which is what F.linear becomes once CanonicalizeOps split up addmm),
+// and a right operand of the form t(W) is folded into the weight. Unlike
+// MMBatchSide this pays off for as few as two projections, since it only
+// concatenates the weights, and those are cached as long as the weights do
+// not change and don't require grad (which costs a copy of them).
+//
+// Whether the projections can be batched is only known at runtime (weights
+// must be matrices of the same dtype and device, and either all or none of
+// them have a bias); otherwise each one runs on its own.
+static constexpr size_t min_linear_batch_size = 2;
+
+enum class LinearKind { Linear, MatMul, MM };
+
+// The cached concatenation of the weights and biases of a BatchedLinear
+struct ConcatenatedWeights {
+  std::mutex mutex;
+  // what the concatenation was made from, and their versions at the time
+  std::vector<at::Tensor> sources;
+  std::vector<uint32_t> versions;
+  at::Tensor weight;
+  at::Tensor bias;
+};
+
+RegisterOperators batched_linear_reg({Operator(
+    prim::BatchedLinear,
+    [](const Node* node) {
+      const auto kinds = node->is(Symbol::attr("kinds"));
+      const auto peeled = node->is(Symbol::attr("peeled"));
+      const size_t n = kinds.size();
+      auto cache = std::make_shared<ConcatenatedWeights>();
+      return [kinds, peeled, n, cache](Stack& stack) {
+        // inputs: the shared input, n weights and n (optional) biases
+        at::Tensor input = peek(stack, 0, 2 * n + 1).toTensor();
+        std::vector<at::Tensor> values;
+        std::vector<at::Tensor> biases;
+        for (size_t i = 0; i < n; ++i) {
+          values.push_back(peek(stack, 1 + i, 2 * n + 1).toTensor());
+          const IValue& bias = peek(stack, 1 + n + i, 2 * n + 1);
+          biases.push_back(bias.isNone() ? at::Tensor() : bias.toTensor());
+        }
+        drop(stack, 2 * n + 1);
+
+        // each projection as y = linear(input, weight, bias)
+        bool batchable = input.dim() >= 1;
+        std::vector<at::Tensor> weights;
+        for (size_t i = 0; i < n && batchable; ++i) {
+          const auto kind = static_cast<LinearKind>(kinds[i]);
+          at::Tensor weight = values[i];
+          if (weight.dim() != 2) {
+            batchable = false;
+            break;
+          }
+          if (kind != LinearKind::Linear && !peeled[i]) {
+            weight = weight.t();
+          }
+          const auto& bias = biases[i];
+          batchable = (kind != LinearKind::MM || input.dim() == 2) &&
+              weight.size(1) == input.size(-1) &&
+              weight.scalar_type() == input.scalar_type() &&
+              weight.device() == input.device() &&
+              bias.defined() == biases[0].defined() &&
+              (!bias.defined() ||
+               (bias.dim() == 1 && bias.size(0) == weight.size(0) &&
+                bias.scalar_type() == input.scalar_type() &&
+                bias.device() == input.device()));
+          weights.push_back(std::move(weight));
+        }
+
+        if (!batchable) {
+          for (size_t i = 0; i < n; ++i) {
+            const auto kind = static_cast<LinearKind>(kinds[i]);
+            const at::Tensor rhs = peeled[i] ? values[i].t() : values[i];
+            if (kind == LinearKind::Linear) {
+              push(stack, at::linear(input, values[i], biases[i]));
+            } else if (kind == LinearKind::MatMul) {
+              push(stack, at::matmul(input, rhs));
+            } else {
+              push(stack, at::mm(input, rhs));
+            }
+          }
+          return 0;
+        }
+
+        std::vector<at::Tensor> sources = values;
+        if (biases[0].defined()) {
+          sources.insert(sources.end(), biases.begin(), biases.end());
+        }
+        const bool cacheable = std::none_of(
+            sources.begin(), sources.end(), [](const at::Tensor& t) {
+              return t.requires_grad();
+            });
+        const auto version = [](const at::Tensor& t) {
+          return autograd::as_variable_ref(t).current_version();
+        };
+        at::Tensor weight, bias;
+        {
+          std::lock_guard<std::mutex> guard(cache->mutex);
+          bool hit = cacheable && cache->sources.size() == sources.size();
+          for (size_t i = 0; hit && i < sources.size(); ++i) {
+            hit = cache->sources[i].is_same(sources[i]) &&
+                cache->versions[i] == version(sources[i]);
+          }
+          if (hit) {
+            weight = cache->weight;
+            bias = cache->bias;
+          } else {
+            weight = at::cat(weights, /*dim=*/0);
+            if (biases[0].defined()) {
+              bias = at::cat(biases, /*dim=*/0);
+            }
+            if (cacheable) {
+              cache->versions = fmap(sources, version);
+              cache->sources = std::move(sources);
+              cache->weight = weight;
+              cache->bias = bias;
+            }
+          }
+        }
+
+        std::vector<int64_t> split_sizes =
+            fmap(weights, [](const at::Tensor& w) { return w.size(0); });
+        auto outputs =
+            at::linear(input, weight, bias).split_with_sizes(split_sizes, -1);
+        stack.insert(
+            stack.end(),
+            std::make_move_iterator(outputs.begin()),
+            std::make_move_iterator(outputs.end()));
+        return 0;
+      };
+    })});
+
+// If `use` is the input of a projection that can go into a BatchedLinear,
+// returns its kind.
+c10::optional<LinearKind> linearKindOf(const Use& use) {
+  Node* n = use.user;
+  if (use.offset != 0 || !n->hasUses()) {
+    return c10::nullopt;
+  }
+  if (n->matches(
+          "aten::linear(Tensor input, Tensor weight, Tensor? bias) -> Tensor")) {
+    return LinearKind::Linear;
+  }
+  if (n->matches("aten::matmul(Tensor self, Tensor other) -> Tensor")) {
+    return LinearKind::MatMul;
+  }
+  if (n->matches("aten::mm(Tensor self, Tensor mat2) -> Tensor")) {
+    return LinearKind::MM;
+  }
+  return c10::nullopt;
+}
+
+void BatchLinearSide(Block* block, AliasDb& alias_db) {
+  const auto batch = [&](Value* input, std::vector<Node*>& projections) {
+    moveTogether(projections, alias_db);
+    WithInsertPoint insert_guard{projections[0]};
+    Graph* graph = input->owningGraph();
+    Value* none = graph->insertConstant(IValue());
+    std::vector<int64_t> kinds;
+    std::vector<int64_t> peeled;
+    std::vector<Value*> weights;
+    std::vector<Value*> biases;
+    for (Node* n : projections) {
+      const auto kind = *linearKindOf(Use(n, 0));
+      Value* weight = n->inputs()[1];
+      Node* producer = weight->node();
+      const bool peel = kind != LinearKind::Linear &&
+          producer->matches("aten::t(Tensor self) -> Tensor");
+      kinds.push_back(static_cast<int64_t>(kind));
+      peeled.push_back(peel);
+      weights.push_back(peel ? producer->input() : weight);
+      biases.push_back(kind == LinearKind::Linear ? n->inputs()[2] : none);
+    }
+    Node* batched = graph->create(
+        prim::BatchedLinear, /*inputs=*/{}, projections.size());
+    graph->insertNode(batched);
+    batched->is_(Symbol::attr("kinds"), kinds);
+    batched->is_(Symbol::attr("peeled"), peeled);
+    batched->addInput(input);
+    for (Value* weight : weights) {
+      batched->addInput(weight);
+    }
+    for (Value* bias : biases) {
+      batched->addInput(bias);
+    }
+    for (size_t i = 0; i < projections.size(); ++i) {
+      batched->outputs()[i]->copyMetadata(projections[i]->output());
+      projections[i]->output()->replaceAllUsesWith(batched->outputs()[i]);
+    }
+  };
+
+  // batching moves nodes around, so iterate over a snapshot
+  std::vector<Node*> nodes(block->nodes().begin(), block->nodes().end());
+  std::unordered_set<Value*> considered_values;
+  for (Node* node : nodes) {
+    for (Block* subblock : node->blocks()) {
+      BatchLinearSide(subblock, alias_db);
+    }
+    if (node->inputs().empty() ||
+        !linearKindOf(Use(node, 0)) ||
+        !considered_values.emplace(node->inputs()[0]).second) {
+      continue;
+    }
+    Value* input = node->inputs()[0];
+    std::vector<Node*> projections;
+    for (const Use& use : input->uses()) {
+      // the weight and bias of a projection must not be the input itself
+      if (use.user->owningBlock() == block && linearKindOf(use) &&
+          std::count(
+              use.user->inputs().begin(), use.user->inputs().end(), input) ==
+              1) {
+        projections.push_back(use.user);
+      }
+    }
+    projections = filterIndependent(std::move(projections), alias_db);
+    if (projections.size() >= min_linear_batch_size) {
+      batch(input, projections);
+    }
+  }
+}
+
 bool hasMutableOperators(Block* block) {
   for (auto n : block->nodes()) {
     if (n->kind().is_aten() && n->schema().is_mutable())
@@ -467,6 +709,7 @@ void BatchMM(std::shared_ptr<Graph>& graph) {
   AliasDb alias_db(graph);
   BatchMMTreeReduce(graph->block());
   BatchMMSide(graph->block(), alias_db);
+  BatchLinearSide(graph->block(), alias_db);
   EliminateDeadCode(graph);
   // It's possible that transpose rearrangements have created sequences of
   // consecutive transposes that didn't exist before.
@@ -0,0 +1,200 @@
+#include <torch/csrc/jit/passes/freeze_module.h>
+
+#include <ATen/ATen.h>
+#include <c10/util/Exception.h>
+#include <torch/csrc/jit/constants.h>
+#include <torch/csrc/jit/passes/constant_propagation.h>
+#include <torch/csrc/jit/passes/dead_code_elimination.h>
+
+#include <vector>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+// If `v` is a constant Tensor or a None, sets `tensor` to it (undefined for
+// None) and returns true.
+bool optionalTensorConstant(const Value* v, at::Tensor& tensor) {
+  auto ivalue = toIValue(v);
+  if (!ivalue) {
+    return false;
+  }
+  if (ivalue->isNone()) {
+    tensor = at::Tensor();
+    return true;
+  }
+  if (ivalue->isTensor()) {
+    tensor = ivalue->toTensor();
+    return true;
+  }
+  return false;
+}
+
+bool isScalarConstantOne(const Value* v) {
+  auto ivalue = toIValue(v);
+  return ivalue &&
+      ((ivalue->isInt() && ivalue->toInt() == 1) ||
+       (ivalue->isDouble() && ivalue->toDouble() == 1.));
+}
+
+// An eval mode batch_norm with constant statistics is the per-channel affine
+// map y = x * scale + shift.
+struct ChannelAffine {
+  at::Tensor scale;
+  at::Tensor shift;
+};
+
+c10::optional<ChannelAffine> evalBatchNormAffine(const Node* bn) {
+  // aten::batch_norm(input, weight, bias, running_mean, running_var,
+  //                  training, momentum, eps, cudnn_enabled)
+  auto training = constant_as<bool>(bn->inputs().at(5));
+  auto eps = constant_as<double>(bn->inputs().at(7));
+  at::Tensor weight, bias, mean, var;
+  if (!training || *training || !eps ||
+      !optionalTensorConstant(bn->inputs().at(1), weight) ||
+      !optionalTensorConstant(bn->inputs().at(2), bias) ||
+      !optionalTensorConstant(bn->inputs().at(3), mean) ||
+      !optionalTensorConstant(bn->inputs().at(4), var) || !mean.defined() ||
+      !var.defined()) {
+    return c10::nullopt;
+  }
+
+  at::Tensor scale = (var + *eps).rsqrt();
+  if (weight.defined()) {
+    scale = scale * weight;
+  }
+  at::Tensor shift = -mean * scale;
+  if (bias.defined()) {
+    shift = shift + bias;
+  }
+  return ChannelAffine{scale, shift};
+}
+
+// Folds `bn` into the weight and bias of the node that produces its input,
+// if that is a convolution or linear layer with constant weights whose output
+// only `bn` uses.
+bool foldBatchNorm(Node* bn) {
+  Value* input = bn->inputs().at(0);
+  Node* producer = input->node();
+  if (input->uses().size() != 1) {
+    return false;
+  }
+
+  // Positions of the weight and bias among the inputs of `producer`, and the
+  // dimension of the weight that is the output channel.
+  size_t weight_index = 1;
+  size_t bias_index = 2;
+  int64_t channel_dim = 0;
+  if (producer->matches(
+          "aten::_convolution(Tensor input, Tensor weight, Tensor? bias, int[] stride, int[] padding, int[] dilation, bool transposed, int[] output_padding, int groups, bool benchmark, bool deterministic, bool cudnn_enabled) -> Tensor")) {
+    // the weight of a transposed convolution is [in, out / groups, ...]
+    auto transposed = constant_as<bool>(producer->inputs().at(6));
+    if (!transposed || *transposed) {
+      return false;
+    }
+  } else if (producer->matches(
+                 "aten::linear(Tensor input, Tensor weight, Tensor? bias) -> Tensor")) {
+    // batch_norm normalizes dimension 1, which is the output feature only
+    // for a 2-d input
+    auto type = input->type()->cast<DimensionedTensorType>();
+    if (!type || type->dim() != 2) {
+      return false;
+    }
+  } else if (producer->matches(
+                 "aten::addmm(Tensor self, Tensor mat1, Tensor mat2, *, Scalar beta, Scalar alpha) -> Tensor")) {
+    // addmm(bias, input, weight.t()), as emitted by F.linear
+    if (!isScalarConstantOne(producer->inputs().at(3)) ||
+        !isScalarConstantOne(producer->inputs().at(4))) {
+      return false;
+    }
+    weight_index = 2;
+    bias_index = 0;
+    channel_dim = 1;
+  } else if (
+      !producer->matches(
+          "aten::conv1d(Tensor input, Tensor weight, Tensor? bias, int[] stride, int[] padding, int[] dilation, int groups) -> Tensor") &&
+      !producer->matches(
+          "aten::conv2d(Tensor input, Tensor weight, Tensor? bias, int[] stride, int[] padding, int[] dilation, int groups) -> Tensor") &&
+      !producer->matches(
+          "aten::conv3d(Tensor input, Tensor weight, Tensor? bias, int[] stride, int[] padding, int[] dilation, int groups) -> Tensor")) {
+    return false;
+  }
+
+  at::Tensor weight, bias;
+  if (!optionalTensorConstant(producer->inputs().at(weight_index), weight) ||
+      !weight.defined() ||
+      !optionalTensorConstant(producer->inputs().at(bias_index), bias) ||
+      weight.dim() <= channel_dim) {
+    return false;
+  }
+  const int64_t channels = weight.size(channel_dim);
+  if (bias.defined() && (bias.dim() != 1 || bias.size(0) != channels)) {
+    return false;
+  }
+  auto affine = evalBatchNormAffine(bn);
+  if (!affine || affine->scale.numel() != channels ||
+      affine->shift.numel() != channels) {
+    return false;
+  }
+
+  at::Tensor scale = affine->scale.to(weight.scalar_type());
+  at::Tensor shift = affine->shift.to(weight.scalar_type());
+  std::vector<int64_t> shape(weight.dim(), 1);
+  shape[channel_dim] = channels;
+  at::Tensor folded_weight = weight * scale.reshape(shape);
+  at::Tensor folded_bias = bias.defined() ? bias * scale + shift : shift;
+
+  auto graph = producer->owningGraph();
+  WithInsertPoint guard(producer);
+  producer->replaceInput(weight_index, graph->insertConstant(folded_weight));
+  producer->replaceInput(bias_index, graph->insertConstant(folded_bias));
+  bn->output()->replaceAllUsesWith(input);
+  bn->destroy();
+  return true;
+}
+
+bool foldBatchNorms(Block* block) {
+  bool changed = false;
+  for (auto it = block->nodes().begin(); it != block->nodes().end();) {
+    Node* n = *it;
+    it++; // advance iterator bc the current node may be destroyed
+    for (Block* sub : n->blocks()) {
+      changed |= foldBatchNorms(sub);
+    }
+    if (n->matches(
+            "aten::batch_norm(Tensor input, Tensor? weight, Tensor? bias, Tensor? running_mean, Tensor? running_var, bool training, float momentum, float eps, bool cudnn_enabled) -> Tensor")) {
+      changed |= foldBatchNorm(n);
+    }
+  }
+  return changed;
+}
+
+void freezeMethods(script::Module& module) {
+  for (auto& submodule : module.get_modules()) {
+    freezeMethods(*submodule);
+  }
+  for (auto& method : module.get_methods()) {
+    method->freeze();
+  }
+}
+
+} // namespace
+
+void FoldFrozenWeights(std::shared_ptr<Graph>& graph) {
+  ConstantPropagation(graph);
+  if (foldBatchNorms(graph->block())) {
+    // remove the statistics and the old weights
+    EliminateDeadCode(graph);
+  }
+}
+
+void FreezeModule(script::Module& module) {
+  AT_CHECK(
+      !module.is_training(),
+      "FreezeModule: expected a module in eval mode, call eval() first");
+  freezeMethods(module);
+}
+
+} // namespace jit
+} // namespace torch
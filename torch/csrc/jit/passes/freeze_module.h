@@ -0,0 +1,43 @@
+/** \brief This file defines passes that freeze modules for inference.
+ *
+ * A lowered method takes the parameters and attributes of its module as
+ * extra graph inputs, so generic constant propagation can't fold anything
+ * computed from them: transposes and casts of weights, batch_norm folding,
+ * weight quantization and so on all run again on every call. Freezing makes
+ * them constants of the graph.
+ */
+#pragma once
+
+#include <torch/csrc/jit/ir.h>
+#include <torch/csrc/jit/script/module.h>
+
+namespace torch {
+namespace jit {
+
+/** \brief Folds the computations on the constant weights of inference code.
+ *
+ * Runs constant propagation, which folds the computations that only depend on
+ * constants (e.g. transposes, casts and quantization of weights, and tests of
+ * `self.training`), then folds each eval mode `aten::batch_norm` with
+ * constant statistics into the constant weight and bias of the
+ * `aten::conv{1,2,3}d`, `aten::_convolution`, `aten::linear` or `aten::addmm`
+ * that produces its input, if nothing else uses that input.
+ */
+TORCH_API void FoldFrozenWeights(std::shared_ptr<Graph>& graph);
+
+/** \brief Freezes the methods of a module and its submodules for inference.
+ *
+ * The parameters and attributes each method reads become constants of their
+ * current values, and the computations on them are folded with
+ * FoldFrozenWeights. The module must be in eval mode.
+ *
+ * Freezing assumes the parameters don't change any more. The constants that
+ * weren't folded share storage with the parameters and the folded ones don't,
+ * so the frozen methods see a mix of old and new values after e.g. loading a
+ * state dict. The module's code and parameters are unchanged, and so is what
+ * `save` writes.
+ */
+TORCH_API void FreezeModule(script::Module& module);
+
+} // namespace jit
+} // namespace torch
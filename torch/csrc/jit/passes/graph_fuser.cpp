@@ -2,6 +2,7 @@
 
 #include <c10/util/Exception.h>
 #include <torch/csrc/jit/autodiff.h>
+#include <torch/csrc/jit/constants.h>
 #include <torch/csrc/jit/custom_operator.h>
 #include <torch/csrc/jit/fuser/interface.h>
 #include <torch/csrc/jit/operator.h>
@@ -223,6 +224,19 @@ struct GraphFuser {
     });
   }
 
+  bool containsReduction(Node* fusion_group) {
+    auto nodes = getSubgraph(fusion_group).nodes();
+    return std::any_of(nodes.begin(), nodes.end(), [](Node* n) {
+      return n->kind() == aten::sum;
+    });
+  }
+
+  // True if node is a reduction, or a fusion group ending in one
+  bool isReduction(Node* node) {
+    return node->kind() == aten::sum ||
+        (node->kind() == kind_ && containsReduction(node));
+  }
+
   bool isFusable(Node* node) {
     return callback_(node);
   }
@@ -250,7 +264,29 @@ struct GraphFuser {
         fusableDevice &= isFusableDevice(output);
       }
     }
-    return fusableDevice && (isFusableMap(node) || isFusableNorm(node));
+    return fusableDevice &&
+        (isFusableMap(node) || isFusableNorm(node) ||
+         isFusableReduction(node));
+  }
+
+  // A sum over constant dims can be fused after the elementwise ops that
+  // produce its input: the kernel accumulates each element of the map into
+  // the output (see ReductionInfo in the fuser). Note that the order of the
+  // additions is unspecified, so results may differ from aten::sum in the
+  // last bits.
+  bool isFusableReduction(Node* node) {
+    if (kind_ != prim::FusionGroup || node->owningBlock() != block_)
+      return false;
+    if (!node->matches(
+            "aten::sum(Tensor self, int[] dim, bool keepdim) -> Tensor",
+            /*const_inputs=*/{attr::dim, attr::keepdim})) {
+      return false;
+    }
+    if (node->get<std::vector<int64_t>>(attr::dim)->empty())
+      return false;
+    // Only float outputs, which can be accumulated atomically everywhere
+    auto type = node->input(0)->type()->cast<DimensionedTensorType>();
+    return type && type->scalarType() == at::ScalarType::Float;
   }
 
   bool isFusableMap(Node* node) {
@@ -592,6 +628,18 @@ struct GraphFuser {
       return at::nullopt;
     }
 
+    // Reductions must be the last op of their group, and can't be moved past
+    // a _grad_sum_to_size
+    if (isReduction(producer->node())) {
+      return at::nullopt;
+    }
+    if (isReduction(consumer) &&
+        (producer->node()->kind() == aten::_grad_sum_to_size ||
+         (producer->node()->kind() == kind_ &&
+          containsGradSumToSize(producer->node())))) {
+      return at::nullopt;
+    }
+
     if ((consumer->inputs().size() + consumer->outputs().size() +
          producer->node()->inputs().size() +
          producer->node()->outputs().size()) > fusion_kernel_args_limit) {
@@ -1123,6 +1171,10 @@ struct GraphFuser {
       if (n->kind() == prim::Constant) {
         continue;
       }
+      if (n->kind() == aten::sum) {
+        // Reduced outputs don't have the broadcast shape of their input
+        continue;
+      }
       if (n->kind() == prim::ConstantChunk) {
         Node* sizes_node = graph->insertNode(
             graph->create(prim::ChunkSizes, shape_of.at(n->input()), 2));
@@ -1183,7 +1235,7 @@ struct GraphFuser {
   }
 
   bool canFuseWithConcat(Value* producer, Node* before_check) {
-    if (!isFusable(producer->node())) {
+    if (!isFusable(producer->node()) || isReduction(producer->node())) {
       return false;
     }
     // NB: it is important that this check happens after isFusable, which checks
@@ -1387,6 +1439,104 @@ void PeepholeOptimizeShapeExpressions(Block* block) {
   }
 }
 
+bool isAddOfOne(Node* node) {
+  if (!node->matches(
+          "aten::add(Tensor self, Tensor other, *, Scalar alpha) -> Tensor")) {
+    return false;
+  }
+  auto alpha = toIValue(node->namedInput(attr::alpha));
+  return alpha &&
+      ((alpha->isInt() && alpha->toInt() == 1) ||
+       (alpha->isDouble() && alpha->toDouble() == 1));
+}
+
+// The input and bias of the add of a bias to the input of dropout: a
+// floating point tensor and a 1-D tensor of the size of its last dimension.
+c10::optional<std::pair<Value*, Value*>> biasAddInputs(Node* bias_add) {
+  for (size_t i = 0; i < 2; ++i) {
+    Value* input = bias_add->inputs()[i];
+    Value* bias = bias_add->inputs()[1 - i];
+    auto input_type = input->type()->cast<CompleteTensorType>();
+    auto bias_type = bias->type()->cast<CompleteTensorType>();
+    if (input_type && bias_type && input_type->dim() >= 1 &&
+        bias_type->sizes() ==
+            std::vector<int64_t>{input_type->sizes().back()} &&
+        bias_type->scalarType() == input_type->scalarType() &&
+        bias_type->device() == input_type->device() &&
+        at::isFloatingType(input_type->scalarType())) {
+      return std::make_pair(input, bias);
+    }
+  }
+  return c10::nullopt;
+}
+
+void FuseBiasDropoutAdd(Block* block, const AliasDb& aliasDb) {
+  std::vector<Node*> dropouts;
+  for (Node* node : block->nodes()) {
+    for (Block* sub_block : node->blocks()) {
+      FuseBiasDropoutAdd(sub_block, aliasDb);
+    }
+    if (node->matches(
+            "aten::dropout(Tensor input, float p, bool train) -> Tensor",
+            attr::train) &&
+        *node->get<bool>(attr::train)) {
+      dropouts.push_back(node);
+    }
+  }
+
+  for (Node* dropout : dropouts) {
+    Node* bias_add = dropout->inputs()[0]->node();
+    if (!isAddOfOne(bias_add) || bias_add->output()->uses().size() != 1 ||
+        dropout->output()->uses().size() != 1) {
+      continue;
+    }
+    Node* residual_add = dropout->output()->uses()[0].user;
+    if (!isAddOfOne(residual_add) ||
+        residual_add->owningBlock() != dropout->owningBlock()) {
+      continue;
+    }
+    Value* residual = residual_add->inputs()[0] == dropout->output()
+        ? residual_add->inputs()[1]
+        : residual_add->inputs()[0];
+    auto inputs = biasAddInputs(bias_add);
+    if (!inputs || residual == dropout->output()) {
+      continue;
+    }
+    Value* input = inputs->first;
+    Value* bias = inputs->second;
+    auto input_type = input->type()->expect<CompleteTensorType>();
+    auto residual_type = residual->type()->cast<CompleteTensorType>();
+    if (!residual_type || residual_type->sizes() != input_type->sizes() ||
+        residual_type->scalarType() != input_type->scalarType() ||
+        residual_type->device() != input_type->device()) {
+      continue;
+    }
+    // The fused node reads all of its inputs at the residual add, so none of
+    // them may be written to in between.
+    if (aliasDb.hasWriters(input) || aliasDb.hasWriters(bias) ||
+        aliasDb.hasWriters(residual)) {
+      continue;
+    }
+
+    Graph* graph = block->owningGraph();
+    WithInsertPoint guard(residual_add);
+    Value* generator = graph->insertConstant(IValue());
+    Node* fused = graph->insertNode(graph->create(
+        aten::_fused_bias_dropout_add,
+        {input, bias, residual, dropout->inputs()[1], generator},
+        2));
+    fused->output(0)->setType(residual_add->output()->type());
+    fused->output(1)->setType(CompleteTensorType::create(
+        at::kByte,
+        input_type->device(),
+        {static_cast<int64_t>(input_type->numel() + 63) / 64 * 8}));
+    residual_add->output()->replaceAllUsesWith(fused->output(0));
+    residual_add->destroy();
+    dropout->destroy();
+    bias_add->destroy();
+  }
+}
+
 } // anonymous namespace
 
 // This takes a _grad_sum_to_size output and tracks it to the return
@@ -1489,5 +1639,10 @@ void CustomFuseGraph(
       .run();
 }
 
+void FuseBiasDropoutAdd(std::shared_ptr<Graph>& graph) {
+  AliasDb aliasDb(graph);
+  FuseBiasDropoutAdd(graph->block(), aliasDb);
+}
+
 } // namespace jit
 } // namespace torch
@@ -24,6 +24,15 @@ TORCH_API void CustomFuseGraph(
     std::function<bool(Node*)> is_fusable,
     Symbol kind);
 
+// Replaces the bias add, dropout and residual add of
+//   %y = aten::add(%input, %bias, 1)
+//   %z = aten::dropout(%y, %p, True)
+//   %out = aten::add(%z, %residual, 1)
+// with aten::_fused_bias_dropout_add, which reads the activations once and
+// saves the dropout mask as one bit per element. It needs complete tensor
+// types, and keeps the graph differentiable.
+TORCH_API void FuseBiasDropoutAdd(std::shared_ptr<Graph>& graph);
+
 TORCH_API bool trackSingleGradSumToSizeToOutputs(
     Value* gradSumToSizeOutput,
     std::vector<int64_t>* outputGradSumToSizes);
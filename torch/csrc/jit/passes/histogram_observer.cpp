@@ -0,0 +1,270 @@
+#include <torch/csrc/jit/passes/histogram_observer.h>
+
+#include <torch/csrc/jit/constants.h>
+#include <torch/csrc/jit/custom_operator.h>
+#include <torch/csrc/jit/operator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+
+namespace torch {
+namespace jit {
+
+HistogramObserver::HistogramObserver(size_t num_bins) : bins_(num_bins) {
+  AT_CHECK(num_bins > 0, "A histogram needs at least one bin");
+}
+
+void HistogramObserver::observe(const at::Tensor& tensor) {
+  if (!tensor.defined() || !at::isFloatingType(tensor.scalar_type()) ||
+      tensor.numel() == 0) {
+    return;
+  }
+  const auto values = tensor.detach().to(at::kCPU, at::kFloat).contiguous();
+  const float* data = values.data<float>();
+  const int64_t numel = values.numel();
+  const auto min_max = std::minmax_element(data, data + numel);
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  growRange(*min_max.first, *min_max.second);
+  const int64_t num_bins = bins_.size();
+  const float width = (max_ - min_) / num_bins;
+  if (width == 0) {
+    bins_[0] += numel;
+  } else {
+    for (int64_t i = 0; i < numel; ++i) {
+      const auto bin = static_cast<int64_t>((data[i] - min_) / width);
+      bins_[std::max<int64_t>(0, std::min(bin, num_bins - 1))] += 1;
+    }
+  }
+  count_ += numel;
+}
+
+void HistogramObserver::growRange(float min, float max) {
+  min = std::min(min, 0.0f);
+  max = std::max(max, 0.0f);
+  if (count_ == 0) {
+    min_ = min;
+    max_ = max;
+    return;
+  }
+  if (min >= min_ && max <= max_) {
+    return;
+  }
+  // Moves the count of every bin to the bin of the wider range holding its
+  // center
+  const int64_t num_bins = bins_.size();
+  const float new_min = std::min(min, min_), new_max = std::max(max, max_);
+  const float width = (max_ - min_) / num_bins;
+  const float new_width = (new_max - new_min) / num_bins;
+  std::vector<double> bins(num_bins);
+  for (int64_t i = 0; i < num_bins; ++i) {
+    const float center = min_ + (i + 0.5f) * width;
+    const auto bin = static_cast<int64_t>((center - new_min) / new_width);
+    bins[std::max<int64_t>(0, std::min(bin, num_bins - 1))] += bins_[i];
+  }
+  bins_ = std::move(bins);
+  min_ = new_min;
+  max_ = new_max;
+}
+
+void HistogramObserver::reset() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  std::fill(bins_.begin(), bins_.end(), 0);
+  min_ = max_ = 0;
+  count_ = 0;
+}
+
+bool HistogramObserver::empty() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return count_ == 0;
+}
+
+std::pair<float, int> HistogramObserver::chooseQParams(
+    const std::string& method,
+    double percentile) const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto range = chooseRange(method, percentile);
+  const float min = std::min(range.first, 0.0f);
+  const float max = std::max(range.second, 0.0f);
+  float scale = (max - min) / 255;
+  if (scale == 0) {
+    scale = 1;
+  }
+  const int zero_point = std::max(
+      0, std::min(255, static_cast<int>(std::nearbyint(-min / scale))));
+  return {scale, zero_point};
+}
+
+std::pair<float, float> HistogramObserver::chooseRange(
+    const std::string& method,
+    double percentile) const {
+  if (method == "min_max") {
+    return {min_, max_};
+  }
+  if (method == "kl") {
+    return klRange();
+  }
+  AT_CHECK(
+      method == "percentile",
+      "Unknown calibration method ",
+      method,
+      ", expected min_max, percentile or kl");
+  AT_CHECK(
+      percentile > 0 && percentile <= 100,
+      "The percentile must be in (0, 100], got ",
+      percentile);
+  const int64_t num_bins = bins_.size();
+  const float width = (max_ - min_) / num_bins;
+  const double cut = count_ * (100 - percentile) / 200;
+  int64_t begin = 0, end = num_bins;
+  for (double sum = bins_[0]; begin + 1 < num_bins && sum <= cut;) {
+    sum += bins_[++begin];
+  }
+  for (double sum = bins_[num_bins - 1]; end - 1 > begin && sum <= cut;) {
+    sum += bins_[--end - 1];
+  }
+  return {min_ + begin * width, min_ + end * width};
+}
+
+// Like TensorRT's entropy calibration: for each candidate range of bins, the
+// bins outside of the range are clipped into its first and last bins, which
+// gives the reference distribution P, and the bins in the range are merged
+// into 256 quantized bins and spread back onto their non empty bins, which
+// gives Q. The range with the smallest KL(P || Q) wins. Candidate ranges hold
+// the zero bin, and their sizes and starts go by steps of 32 bins.
+std::pair<float, float> HistogramObserver::klRange() const {
+  constexpr int64_t kQuantizedBins = 256;
+  constexpr int64_t kStep = kQuantizedBins / 8;
+  const int64_t num_bins = bins_.size();
+  const float width = (max_ - min_) / num_bins;
+  const int64_t zero_bin = width == 0 ? 0 : std::lround(-min_ / width);
+
+  std::vector<double> p, q;
+  auto divergence = [&](int64_t start, int64_t selected) {
+    const int64_t end = start + selected;
+    p.assign(bins_.begin() + start, bins_.begin() + end);
+    for (int64_t i = 0; i < start; ++i) {
+      p.front() += bins_[i];
+    }
+    for (int64_t i = end; i < num_bins; ++i) {
+      p.back() += bins_[i];
+    }
+
+    q.assign(selected, 0);
+    const int64_t quantized_bins = std::min(kQuantizedBins, selected);
+    for (int64_t j = 0; j < quantized_bins; ++j) {
+      const int64_t begin = start + j * selected / quantized_bins;
+      const int64_t stop = start + (j + 1) * selected / quantized_bins;
+      double sum = 0;
+      int64_t non_empty = 0;
+      for (int64_t i = begin; i < stop; ++i) {
+        sum += bins_[i];
+        non_empty += bins_[i] != 0;
+      }
+      for (int64_t i = begin; i < stop; ++i) {
+        if (bins_[i] != 0) {
+          q[i - start] = sum / non_empty;
+        }
+      }
+    }
+
+    double p_sum = 0, q_sum = 0;
+    for (int64_t i = 0; i < selected; ++i) {
+      p_sum += p[i];
+      q_sum += q[i];
+    }
+    if (p_sum == 0 || q_sum == 0) {
+      return std::numeric_limits<double>::max();
+    }
+    double kl = 0;
+    for (int64_t i = 0; i < selected; ++i) {
+      if (p[i] != 0) {
+        // Clipped outliers may fall into bins the range has no values in
+        const double p_i = p[i] / p_sum;
+        const double q_i = std::max(q[i] / q_sum, 1e-10);
+        kl += p_i * std::log(p_i / q_i);
+      }
+    }
+    return kl;
+  };
+
+  std::pair<float, float> best{min_, max_};
+  double best_kl = std::numeric_limits<double>::max();
+  for (int64_t selected = std::min(kQuantizedBins, num_bins);;
+       selected = std::min(selected + kStep, num_bins)) {
+    const int64_t first_start = std::max<int64_t>(0, zero_bin - selected);
+    const int64_t last_start = std::min(zero_bin, num_bins - selected);
+    for (int64_t start = first_start; start <= last_start;
+         start = start == last_start ? last_start + 1
+                                     : std::min(start + kStep, last_start)) {
+      const double kl = divergence(start, selected);
+      if (kl < best_kl) {
+        best_kl = kl;
+        best = {min_ + start * width, min_ + (start + selected) * width};
+      }
+    }
+    if (selected == num_bins) {
+      break;
+    }
+  }
+  return best;
+}
+
+namespace {
+std::mutex& observersMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::unordered_map<std::string, std::unique_ptr<HistogramObserver>>&
+observers() {
+  static std::unordered_map<std::string, std::unique_ptr<HistogramObserver>>
+      observers;
+  return observers;
+}
+} // namespace
+
+HistogramObserver& getHistogramObserver(const std::string& name) {
+  std::lock_guard<std::mutex> guard(observersMutex());
+  auto& observer = observers()[name];
+  if (!observer) {
+    observer.reset(new HistogramObserver());
+  }
+  return *observer;
+}
+
+void forEachHistogramObserver(
+    const std::function<void(const std::string&, HistogramObserver&)>& fn) {
+  std::lock_guard<std::mutex> guard(observersMutex());
+  for (auto& entry : observers()) {
+    fn(entry.first, *entry.second);
+  }
+}
+
+namespace {
+RegisterOperators reg({
+    Operator(
+        "prim::ObserveHistogram(Tensor(a) self, str name) -> Tensor(a)",
+        [](const Node* node) {
+          // The name is a constant inserted by InsertHistogramObservers, so
+          // the observer is only looked up once
+          HistogramObserver* observer = nullptr;
+          if (auto name = toIValue(node->inputs().at(1))) {
+            observer = &getHistogramObserver(name->toStringRef());
+          }
+          return [observer](Stack& stack) {
+            auto name = pop(stack);
+            auto* o =
+                observer ? observer : &getHistogramObserver(name.toStringRef());
+            o->observe(peek(stack, 0, 1).toTensor());
+            return 0;
+          };
+        }),
+});
+} // namespace
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <torch/csrc/WindowsTorchApiMacro.h>
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace torch {
+namespace jit {
+
+/** \brief Histogram of the values taken by a tensor during calibration.
+ *
+ * The range of the histogram always includes 0 and grows with the observed
+ * values: when a value falls outside of it, the existing bins are merged into
+ * the bins of the wider range. observe() may be called concurrently.
+ */
+class TORCH_API HistogramObserver {
+ public:
+  explicit HistogramObserver(size_t num_bins = 2048);
+
+  void observe(const at::Tensor& tensor);
+
+  // Forgets all the observed values.
+  void reset();
+
+  bool empty() const;
+
+  /** \brief Chooses the scale and zero point of the uint8 quantization.
+   *
+   * \param method is `min_max` (the whole observed range), `percentile` (the
+   * range holding `percentile` percent of the values, cutting the same share
+   * at both ends) or `kl` (the range minimizing the KL divergence between the
+   * observed and the quantized distributions).
+   */
+  std::pair<float, int> chooseQParams(
+      const std::string& method,
+      double percentile = 99.99) const;
+
+ private:
+  std::pair<float, float> chooseRange(
+      const std::string& method,
+      double percentile) const;
+  std::pair<float, float> klRange() const;
+  void growRange(float min, float max);
+
+  mutable std::mutex mutex_;
+  std::vector<double> bins_;
+  float min_{0};
+  float max_{0};
+  double count_{0};
+};
+
+/** \brief Returns the observer of the values named `name`, creating it if
+ * needed. Observers live as long as the process.
+ */
+TORCH_API HistogramObserver& getHistogramObserver(const std::string& name);
+
+/** \brief Calls `fn(name, observer)` for every observer. */
+TORCH_API void forEachHistogramObserver(
+    const std::function<void(const std::string&, HistogramObserver&)>& fn);
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,272 @@
+#include <torch/csrc/jit/passes/memory_planning.h>
+
+#include <ATen/ATen.h>
+#include <torch/csrc/autograd/variable.h>
+#include <torch/csrc/jit/custom_operator.h>
+#include <torch/csrc/jit/operator.h>
+#include <torch/csrc/jit/passes/alias_analysis.h>
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+// keep every planned tensor aligned like the CPU allocator does
+constexpr size_t kArenaAlignment = 64;
+
+size_t alignUp(size_t size) {
+  return (size + kArenaAlignment - 1) / kArenaAlignment * kArenaAlignment;
+}
+
+// Arenas of one prim::MemoryArena node. An arena is handed out again once
+// the pool holds the only reference to it, i.e. every tensor placed in it
+// by a previous run has died.
+struct ArenaPool {
+  at::Tensor get(int64_t size) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (const auto& arena : arenas_) {
+      if (arena.use_count() == 1 && arena.numel() == size) {
+        return arena;
+      }
+    }
+    arenas_.push_back(at::empty({size}, at::dtype(at::kByte)));
+    return arenas_.back();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<at::Tensor> arenas_;
+};
+
+RegisterOperators reg({
+    Operator(
+        "prim::MemoryArena(int size) -> Tensor",
+        [](const Node* node) {
+          auto pool = std::make_shared<ArenaPool>();
+          return [pool](Stack& stack) {
+            auto size = pop(stack).toInt();
+            push(
+                stack,
+                autograd::make_variable(
+                    pool->get(size), /*requires_grad=*/false));
+            return 0;
+          };
+        }),
+    Operator(
+        "prim::ArenaTensor(Tensor(a) arena, int offset, int[] size, int dtype) -> Tensor(a)",
+        [](Stack& stack) {
+          auto dtype = static_cast<at::ScalarType>(pop(stack).toInt());
+          auto size = pop(stack).toIntList()->elements();
+          auto offset = pop(stack).toInt();
+          auto arena = pop(stack).toTensor();
+          auto data = static_cast<char*>(arena.data_ptr()) + offset;
+          // the deleter keeps the arena alive as long as the slice
+          auto slice = at::from_blob(
+              data, size, [arena](void*) {}, at::dtype(dtype));
+          push(stack, autograd::make_variable(slice, /*requires_grad=*/false));
+          return 0;
+        }),
+});
+
+// Finds the `aten::foo(..., *, Tensor(a!) out)` overload of `node`'s op
+std::shared_ptr<Operator> findOutVariant(const Node* node) {
+  const FunctionSchema* schema = node->maybeSchema();
+  if (!schema || schema->returns().size() != 1) {
+    return nullptr;
+  }
+  const auto& args = schema->arguments();
+  for (const auto& op : getAllOperatorsFor(node->kind())) {
+    const auto& out_args = op->schema().arguments();
+    if (out_args.size() != args.size() + 1) {
+      continue;
+    }
+    const auto& out = out_args.back();
+    if (out.name() != "out" || !out.alias_info() ||
+        !out.alias_info()->isWrite()) {
+      continue;
+    }
+    bool matches = true;
+    for (size_t i = 0; i < args.size(); ++i) {
+      if (args[i].name() != out_args[i].name() ||
+          *args[i].type() != *out_args[i].type()) {
+        matches = false;
+        break;
+      }
+    }
+    if (matches) {
+      return op;
+    }
+  }
+  return nullptr;
+}
+
+void collectValues(Block* block, std::vector<Value*>& values) {
+  for (auto input : block->inputs()) {
+    values.push_back(input);
+  }
+  for (auto node : block->nodes()) {
+    for (auto output : node->outputs()) {
+      values.push_back(output);
+    }
+    for (auto sub_block : node->blocks()) {
+      collectValues(sub_block, values);
+    }
+  }
+}
+
+struct Lifetime {
+  const Node* node;
+  size_t begin;
+  size_t end;
+  size_t size;
+};
+
+} // namespace
+
+MemoryPlan PlanMemory(const std::shared_ptr<Graph>& graph) {
+  AliasDb aliasDb(graph);
+
+  // Lifetimes are measured in positions of the top-level nodes; uses inside
+  // an If or Loop count as uses by that node.
+  std::unordered_map<const Node*, size_t> position;
+  for (auto node : graph->nodes()) {
+    position.emplace(node, position.size());
+  }
+  const size_t return_position = position.size();
+  auto topLevelPosition = [&](Node* n) {
+    while (n->owningBlock() != graph->block()) {
+      n = n->owningBlock()->owningNode();
+    }
+    return n == graph->return_node() ? return_position : position.at(n);
+  };
+  auto lastUse = [&](Value* v) {
+    size_t last = topLevelPosition(v->node());
+    for (const auto& use : v->uses()) {
+      last = std::max(last, topLevelPosition(use.user));
+    }
+    return last;
+  };
+
+  std::vector<Value*> values;
+  collectValues(graph->block(), values);
+
+  std::vector<Lifetime> lifetimes;
+  for (auto node : graph->nodes()) {
+    if (!node->kind().is_aten() || !node->blocks().empty() ||
+        node->outputs().size() != 1) {
+      continue;
+    }
+    auto type = node->output()->type()->cast<CompleteTensorType>();
+    if (!type || type->requires_grad() || !type->device().is_cpu() ||
+        type->numel() == 0 ||
+        type->strides() != type->contiguous()->strides()) {
+      continue;
+    }
+    if (aliasDb.mayContainAlias(node->inputs(), node->outputs()) ||
+        aliasDb.mayContainAlias(node->outputs(), graph->outputs())) {
+      continue;
+    }
+    if (!findOutVariant(node)) {
+      continue;
+    }
+    // views and containers of the output keep its memory alive
+    Value* output = node->output();
+    size_t end = lastUse(output);
+    for (Value* v : values) {
+      if (v != output && aliasDb.mayContainAlias(output, v)) {
+        end = std::max(end, lastUse(v));
+      }
+    }
+    size_t size = alignUp(type->numel() * at::elementSize(type->scalarType()));
+    lifetimes.push_back({node, position.at(node), end, size});
+  }
+
+  // Greedy by size: place each tensor at the lowest offset that does not
+  // overlap any larger tensor live at the same time.
+  std::stable_sort(
+      lifetimes.begin(),
+      lifetimes.end(),
+      [](const Lifetime& a, const Lifetime& b) { return a.size > b.size; });
+
+  MemoryPlan plan;
+  std::vector<const Lifetime*> placed;
+  for (const auto& lifetime : lifetimes) {
+    std::vector<MemoryPlan::Region> live;
+    for (const Lifetime* other : placed) {
+      if (other->begin <= lifetime.end && lifetime.begin <= other->end) {
+        live.push_back(plan.regions.at(other->node));
+      }
+    }
+    std::sort(
+        live.begin(),
+        live.end(),
+        [](const MemoryPlan::Region& a, const MemoryPlan::Region& b) {
+          return a.offset < b.offset;
+        });
+    size_t offset = 0;
+    for (const auto& region : live) {
+      if (region.offset >= offset + lifetime.size) {
+        break;
+      }
+      offset = std::max(offset, region.offset + region.size);
+    }
+    plan.regions[lifetime.node] = {offset, lifetime.size};
+    plan.total_size = std::max(plan.total_size, offset + lifetime.size);
+    placed.push_back(&lifetime);
+  }
+  return plan;
+}
+
+void MemoryPlanning(std::shared_ptr<Graph>& graph) {
+  auto plan = PlanMemory(graph);
+  if (plan.regions.empty()) {
+    return;
+  }
+
+  Value* arena;
+  {
+    WithInsertPoint guard(graph->nodes().front());
+    Value* total_size =
+        graph->insertConstant(static_cast<int64_t>(plan.total_size));
+    arena = graph->insertNode(graph->create(prim::MemoryArena, {total_size}))
+                ->output()
+                ->setType(TensorType::get());
+  }
+
+  std::vector<Node*> planned;
+  for (auto node : graph->nodes()) {
+    if (plan.regions.count(node)) {
+      planned.push_back(node);
+    }
+  }
+  for (Node* node : planned) {
+    const auto& region = plan.regions.at(node);
+    auto type = node->output()->type()->expect<CompleteTensorType>();
+    WithInsertPoint guard(node);
+    Value* offset = graph->insertConstant(static_cast<int64_t>(region.offset));
+    Value* sizes = graph->insertConstant(type->sizes());
+    Value* dtype =
+        graph->insertConstant(static_cast<int64_t>(type->scalarType()));
+    Value* out =
+        graph
+            ->insertNode(graph->create(
+                prim::ArenaTensor, {arena, offset, sizes, dtype}))
+            ->output()
+            ->setType(type);
+
+    auto inputs = node->inputs().vec();
+    inputs.push_back(out);
+    Node* out_node = graph->insertNode(graph->create(node->kind(), inputs));
+    out_node->setSourceLocation(node->getSourceLocation());
+    out_node->output()->copyMetadata(node->output());
+    node->output()->replaceAllUsesWith(out_node->output());
+    node->destroy();
+  }
+}
+
+} // namespace jit
+} // namespace torch
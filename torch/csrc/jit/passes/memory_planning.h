@@ -0,0 +1,38 @@
+#pragma once
+
+#include <torch/csrc/jit/ir.h>
+
+#include <unordered_map>
+
+namespace torch {
+namespace jit {
+
+// Static memory plan for the tensor intermediates of a graph.
+//
+// A node is planned if it is in the top-level block, produces a single
+// contiguous CPU tensor of complete type (see shape_analysis) that does not
+// require grad, does not alias its inputs or the graph outputs, and has an
+// out= variant. Planned outputs with disjoint lifetimes share memory.
+struct MemoryPlan {
+  struct Region {
+    size_t offset;
+    size_t size;
+  };
+  std::unordered_map<const Node*, Region> regions;
+  // bytes needed to hold every planned output
+  size_t total_size = 0;
+};
+
+TORCH_API MemoryPlan PlanMemory(const std::shared_ptr<Graph>& graph);
+
+// Rewrites the nodes planned by PlanMemory() into their out= variants,
+// writing into slices of one prim::MemoryArena allocation. Arenas are reused
+// across runs of the graph once all tensors of the previous run have died.
+//
+// The planned sizes come from the graph's complete tensor types, so the
+// rewritten graph must only be run on inputs of the shapes it was
+// specialized to.
+TORCH_API void MemoryPlanning(std::shared_ptr<Graph>& graph);
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,388 @@
+#include <torch/csrc/jit/passes/mkldnn_layout.h>
+
+#include <ATen/ATen.h>
+#include <torch/csrc/autograd/grad_mode.h>
+#include <torch/csrc/autograd/variable.h>
+#include <torch/csrc/jit/constants.h>
+#include <torch/csrc/jit/custom_operator.h>
+#include <torch/csrc/jit/operator.h>
+#include <torch/csrc/jit/passes/alias_analysis.h>
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+// The MKL-DNN copy of the last weight seen by one prim::MKLDNNWeight node.
+// It is made again when the node sees another weight, or the same weight
+// after it was modified in place (e.g. by an optimizer step).
+struct WeightCache {
+  template <typename Convert>
+  at::Tensor get(const at::Tensor& weight, const Convert& convert) {
+    const uint32_t version = weight.is_variable()
+        ? autograd::as_variable_ref(weight).current_version()
+        : 0;
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (!weight_.is_same(weight) || version_ != version) {
+      autograd::AutoGradMode grad_mode(/*enabled=*/false);
+      converted_ = convert(weight);
+      weight_ = weight;
+      version_ = version;
+    }
+    return converted_;
+  }
+
+ private:
+  std::mutex mutex_;
+  at::Tensor weight_;
+  uint32_t version_ = 0;
+  at::Tensor converted_;
+};
+
+RegisterOperators reg({
+    Operator(
+        "prim::MKLDNNWeight(Tensor weight) -> Tensor",
+        [](const Node* node) {
+          auto cache = std::make_shared<WeightCache>();
+          return [cache](Stack& stack) {
+            auto weight = pop(stack).toTensor();
+            push(stack, cache->get(weight, [](const at::Tensor& weight) {
+              return weight.to_mkldnn();
+            }));
+            return 0;
+          };
+        }),
+    Operator(
+        "prim::MKLDNNConvWeight(Tensor weight, int[] padding, int[] stride, int[] dilation, int groups) -> Tensor",
+        [](const Node* node) {
+          auto cache = std::make_shared<WeightCache>();
+          return [cache](Stack& stack) {
+            auto groups = pop(stack).toInt();
+            auto dilation = pop(stack).toIntList()->elements();
+            auto stride = pop(stack).toIntList()->elements();
+            auto padding = pop(stack).toIntList()->elements();
+            auto weight = pop(stack).toTensor();
+            push(stack, cache->get(weight, [&](const at::Tensor& weight) {
+              return at::mkldnn_reorder_conv2d_weight(
+                  weight.to_mkldnn(), padding, stride, dilation, groups);
+            }));
+            return 0;
+          };
+        }),
+});
+
+// Positions of the inputs of a convertible node that are converted by
+// prim::MKLDNNWeight(s), i.e. weights, biases and batch_norm statistics.
+struct WeightInputs {
+  // index of the convolution weight, if any
+  c10::optional<size_t> conv_weight;
+  std::vector<size_t> others;
+};
+
+bool isFloatCPUTensor(const Value* v, c10::optional<int64_t> dim = c10::nullopt) {
+  auto type = v->type()->cast<DimensionedTensorType>();
+  return type && type->scalarType() == at::kFloat &&
+      type->device().is_cpu() && !type->requires_grad() &&
+      (!dim || type->dim() == *dim);
+}
+
+bool isConstantFalse(const Value* v) {
+  auto value = constant_as<bool>(v);
+  return value && !*value;
+}
+
+// Returns the convolution's padding, stride, dilation and groups, the
+// arguments of mkldnn_reorder_conv2d_weight.
+std::vector<Value*> convParams(const Node* node) {
+  if (node->kind() == aten::conv2d) {
+    return {node->input(4), node->input(3), node->input(5), node->input(6)};
+  }
+  // aten::_convolution
+  return {node->input(4), node->input(3), node->input(5), node->input(8)};
+}
+
+// Returns the inputs of `node` converted by prim::MKLDNNWeight(s) if `node`
+// can run on MKL-DNN tensors, given that its activations (input 0, and
+// input 1 of adds) are in MKL-DNN layout.
+c10::optional<WeightInputs> convertibleWeights(const Node* node) {
+  if (node->outputs().size() != 1 || !isFloatCPUTensor(node->output()) ||
+      !isFloatCPUTensor(node->input(0))) {
+    return c10::nullopt;
+  }
+  const Value* input = node->input(0);
+  if (node->matches(
+          "aten::conv2d(Tensor input, Tensor weight, Tensor? bias, int[] stride, int[] padding, int[] dilation, int groups) -> Tensor") ||
+      (node->matches(
+           "aten::_convolution(Tensor input, Tensor weight, Tensor? bias, int[] stride, int[] padding, int[] dilation, bool transposed, int[] output_padding, int groups, bool benchmark, bool deterministic, bool cudnn_enabled) -> Tensor") &&
+       isConstantFalse(node->input(6)))) {
+    if (!isFloatCPUTensor(input, 4) || !isFloatCPUTensor(node->input(1), 4)) {
+      return c10::nullopt;
+    }
+    for (const Value* param : convParams(node)) {
+      if (!toIValue(param)) {
+        return c10::nullopt;
+      }
+    }
+    WeightInputs weights;
+    weights.conv_weight = 1;
+    if (!node->input(2)->mustBeNone()) {
+      weights.others.push_back(2);
+    }
+    return weights;
+  }
+  if (node->matches(
+          "aten::linear(Tensor input, Tensor weight, Tensor? bias) -> Tensor")) {
+    if (!isFloatCPUTensor(input, 2)) {
+      return c10::nullopt;
+    }
+    WeightInputs weights;
+    weights.others.push_back(1);
+    if (!node->input(2)->mustBeNone()) {
+      weights.others.push_back(2);
+    }
+    return weights;
+  }
+  if (node->matches(
+          "aten::batch_norm(Tensor input, Tensor? weight, Tensor? bias, Tensor? running_mean, Tensor? running_var, bool training, float momentum, float eps, bool cudnn_enabled) -> Tensor")) {
+    // the MKL-DNN kernel only does inference, with all parameters given
+    if (!isFloatCPUTensor(input, 4) || !isConstantFalse(node->input(5))) {
+      return c10::nullopt;
+    }
+    WeightInputs weights;
+    for (size_t i = 1; i <= 4; ++i) {
+      if (node->input(i)->mustBeNone()) {
+        return c10::nullopt;
+      }
+      weights.others.push_back(i);
+    }
+    return weights;
+  }
+  if (node->matches("aten::relu(Tensor self) -> Tensor")) {
+    return WeightInputs();
+  }
+  // the MKL-DNN kernels do not pool with ceil_mode
+  if (node->matches(
+          "aten::max_pool2d(Tensor self, int[] kernel_size, int[] stride, int[] padding, int[] dilation, bool ceil_mode) -> Tensor")) {
+    if (!isFloatCPUTensor(input, 4) || !isConstantFalse(node->input(5))) {
+      return c10::nullopt;
+    }
+    return WeightInputs();
+  }
+  if (node->matches(
+          "aten::avg_pool2d(Tensor self, int[] kernel_size, int[] stride, int[] padding, bool ceil_mode, bool count_include_pad) -> Tensor")) {
+    if (!isFloatCPUTensor(input, 4) || !isConstantFalse(node->input(4))) {
+      return c10::nullopt;
+    }
+    return WeightInputs();
+  }
+  if (node->matches(
+          "aten::adaptive_avg_pool2d(Tensor self, int[] output_size) -> Tensor")) {
+    // the MKL-DNN kernel only pools windows of one size
+    auto type = input->type()->cast<CompleteTensorType>();
+    auto output_size = constant_as<std::vector<int64_t>>(node->input(1));
+    if (!type || type->dim() != 4 || !output_size ||
+        output_size->size() != 2) {
+      return c10::nullopt;
+    }
+    for (size_t i = 0; i < 2; ++i) {
+      const int64_t size = (*output_size)[i];
+      if (size <= 0 || type->sizes()[i + 2] % size != 0) {
+        return c10::nullopt;
+      }
+    }
+    return WeightInputs();
+  }
+  if (node->matches(
+          "aten::add(Tensor self, Tensor other, *, Scalar alpha) -> Tensor")) {
+    // the MKL-DNN kernel does not broadcast
+    auto self_type = input->type()->cast<CompleteTensorType>();
+    auto other_type = node->input(1)->type()->cast<CompleteTensorType>();
+    if (!self_type || !other_type || !isFloatCPUTensor(node->input(1)) ||
+        self_type->sizes() != other_type->sizes()) {
+      return c10::nullopt;
+    }
+    return WeightInputs();
+  }
+  return c10::nullopt;
+}
+
+size_t numActivations(const Node* node) {
+  return node->kind() == aten::add ? 2 : 1;
+}
+
+// Nodes whose output is a fresh tensor and that only read their inputs.
+bool isFreshOutputReadOnly(const Node* node) {
+  return node->owningBlock() == node->owningGraph()->block() &&
+      convertibleWeights(node).has_value();
+}
+
+// Rewrites `%y = aten::relu_(%x)` and `%y = aten::add_(%x, %z, %alpha)` to
+// their out-of-place variants when no one can observe the write to %x: %x
+// is a fresh tensor that is only read, by convertible nodes, before this
+// node. This lets chains like conv -> batch_norm -> relu_ be converted.
+void RemoveUnobservedInplaceOps(Block* block) {
+  Graph* graph = block->owningGraph();
+  for (auto it = block->nodes().begin(); it != block->nodes().end();) {
+    Node* node = *it;
+    ++it;
+    Symbol out_of_place;
+    if (node->matches("aten::relu_(Tensor(a!) self) -> Tensor(a!)")) {
+      out_of_place = aten::relu;
+    } else if (node->matches(
+                   "aten::add_(Tensor(a!) self, Tensor other, *, Scalar alpha) -> Tensor(a!)")) {
+      out_of_place = aten::add;
+    } else {
+      continue;
+    }
+    Value* self = node->input(0);
+    if (self->node()->kind() == prim::Param ||
+        !isFreshOutputReadOnly(self->node())) {
+      continue;
+    }
+    bool observed = false;
+    for (const Use& use : self->uses()) {
+      if (use.user != node &&
+          (use.user->owningBlock() != block || !use.user->isBefore(node) ||
+           !isFreshOutputReadOnly(use.user))) {
+        observed = true;
+        break;
+      }
+    }
+    if (observed) {
+      continue;
+    }
+    Node* replacement = graph->create(out_of_place, node->inputs());
+    replacement->insertBefore(node);
+    replacement->output()->copyMetadata(node->output());
+    node->output()->replaceAllUsesWith(replacement->output());
+    node->destroy();
+  }
+}
+
+} // namespace
+
+void ConvertToMKLDNN(std::shared_ptr<Graph>& graph) {
+  if (!at::hasMKLDNN()) {
+    return;
+  }
+  RemoveUnobservedInplaceOps(graph->block());
+
+  // Conversions are copies, so values that are written to cannot cross the
+  // boundary of a converted chain.
+  AliasDb aliasDb(graph);
+  std::unordered_map<Node*, WeightInputs> converted;
+  for (Node* node : graph->nodes()) {
+    auto weights = convertibleWeights(node);
+    if (!weights || aliasDb.hasWriters(node)) {
+      continue;
+    }
+    // weights are converted once per value, so they must not be computed
+    // anew on every run
+    bool constant_weights = true;
+    auto check = [&](size_t i) {
+      auto kind = node->input(i)->node()->kind();
+      constant_weights &= kind == prim::Param || kind == prim::Constant;
+    };
+    if (weights->conv_weight) {
+      check(*weights->conv_weight);
+    }
+    for (size_t i : weights->others) {
+      check(i);
+    }
+    if (constant_weights) {
+      converted.emplace(node, std::move(*weights));
+    }
+  }
+
+  // A lone op pays for two reorders of its input and output, which only
+  // converting a convolution makes up for, through its cached weights.
+  auto isConverted = [&](const Node* node) {
+    return converted.count(const_cast<Node*>(node)) != 0;
+  };
+  std::vector<Node*> lone;
+  for (const auto& entry : converted) {
+    Node* node = entry.first;
+    bool connected = entry.second.conv_weight.has_value();
+    for (size_t i = 0; i < numActivations(node); ++i) {
+      connected |= isConverted(node->input(i)->node());
+    }
+    for (const Use& use : node->output()->uses()) {
+      connected |=
+          isConverted(use.user) && use.offset < numActivations(use.user);
+    }
+    if (!connected) {
+      lone.push_back(node);
+    }
+  }
+  for (Node* node : lone) {
+    converted.erase(node);
+  }
+  if (converted.empty()) {
+    return;
+  }
+
+  // Reorder values once, right after they are computed, where they cross
+  // the boundary of a converted chain.
+  auto convertUses = [&](Value* value, Symbol kind, Node* insert_before) {
+    const bool mkldnn = isConverted(value->node());
+    std::vector<Use> boundary_uses;
+    for (const Use& use : value->uses()) {
+      const bool converted_use =
+          isConverted(use.user) && use.offset < numActivations(use.user);
+      if (converted_use != mkldnn) {
+        boundary_uses.push_back(use);
+      }
+    }
+    if (boundary_uses.empty()) {
+      return;
+    }
+    WithInsertPoint guard(insert_before);
+    Value* reordered = graph->insert(kind, {value});
+    reordered->setType(value->type());
+    for (const Use& use : boundary_uses) {
+      use.user->replaceInput(use.offset, reordered);
+    }
+  };
+  std::vector<Node*> nodes(graph->nodes().begin(), graph->nodes().end());
+  for (Value* input : graph->inputs()) {
+    convertUses(input, Symbol::aten("to_mkldnn"), nodes.front());
+  }
+  for (Node* node : nodes) {
+    for (Value* output : node->outputs()) {
+      convertUses(
+          output,
+          isConverted(node) ? aten::to_dense : Symbol::aten("to_mkldnn"),
+          node->next());
+    }
+  }
+
+  // Weights are converted, and cached, right before their use.
+  for (const auto& entry : converted) {
+    Node* node = entry.first;
+    const WeightInputs& weights = entry.second;
+    WithInsertPoint guard(node);
+    if (weights.conv_weight) {
+      std::vector<NamedValue> args = {node->input(*weights.conv_weight)};
+      for (Value* param : convParams(node)) {
+        args.emplace_back(param);
+      }
+      Value* weight =
+          graph->insert(Symbol::prim("MKLDNNConvWeight"), args);
+      weight->setType(node->input(*weights.conv_weight)->type());
+      node->replaceInput(*weights.conv_weight, weight);
+    }
+    for (size_t i : weights.others) {
+      Value* weight =
+          graph->insert(Symbol::prim("MKLDNNWeight"), {node->input(i)});
+      weight->setType(node->input(i)->type());
+      node->replaceInput(i, weight);
+    }
+  }
+}
+
+} // namespace jit
+} // namespace torch
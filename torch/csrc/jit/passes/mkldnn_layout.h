@@ -0,0 +1,27 @@
+#pragma once
+
+#include <torch/csrc/jit/ir.h>
+
+namespace torch {
+namespace jit {
+
+// Runs the ops of the top-level block that have MKL-DNN kernels (2d
+// convolutions, linear, inference batch_norm, relu, 2d pooling and adds) on
+// tensors in the opaque MKL-DNN layout. Chains of such ops keep their
+// intermediates in that layout; aten::to_mkldnn and aten::to_dense are only
+// inserted where a value enters or leaves a chain.
+//
+// Convolution weights are reordered into the blocked layout of their
+// convolution, and the weights of every converted op are converted once and
+// cached by prim::MKLDNNWeight nodes until they are modified. In-place relu_
+// and add_ on values no one else sees are rewritten to their out-of-place
+// variants first.
+//
+// Only nodes whose tensors are known (see shape_analysis) to be float CPU
+// tensors that do not require grad are converted, so the pass is meant for
+// inference graphs specialized on their inputs. It does nothing if ATen was
+// built without MKL-DNN.
+TORCH_API void ConvertToMKLDNN(std::shared_ptr<Graph>& graph);
+
+} // namespace jit
+} // namespace torch
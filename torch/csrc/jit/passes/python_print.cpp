@@ -1205,6 +1205,7 @@ bool printerHasSpecialCaseFor(Symbol sym) {
       prim::Load, // used in interpreter only
       prim::MMTreeReduce, // used as an optimization
       prim::MMBatchSide, // used as an optimization
+      prim::BatchedLinear, // used as an optimization
       prim::Store, // used in interpreter only
 
   };
@@ -1,6 +1,7 @@
 #include <torch/csrc/jit/passes/quantization.h>
 
 #include <torch/csrc/jit/ir.h>
+#include <torch/csrc/jit/passes/histogram_observer.h>
 #include <torch/csrc/jit/node_hashing.h>
 #include <torch/csrc/jit/operator.h>
 
@@ -163,7 +164,8 @@ bool matchQParamDictKeytoObserver(
     const std::unordered_map<std::string, std::tuple<ArgT...>>& qparam_dict,
     std::tuple<ArgT...>& qparam_value) {
   // Observer nodes have two inputs
-  if (n->kind() != prim::PythonOp || n->inputs().size() != 2) {
+  if ((n->kind() != prim::PythonOp && n->kind() != prim::ObserveHistogram) ||
+      n->inputs().size() != 2) {
     return false;
   }
   // For observer node, qparam dict key matches the
@@ -304,6 +306,44 @@ void InsertObserverNodes(
       function_var->graph(), observer_node, function_var->num_inputs());
 }
 
+void InsertHistogramObservers(
+    std::shared_ptr<script::Module>& moduleObj,
+    const std::string& methodName) {
+  // All observer nodes are cloned from this one, like the python observer
+  // node created by the python bindings
+  Graph g;
+  Node* observer_node = g.create(prim::ObserveHistogram, /*num_outputs=*/0);
+  InsertObserverNodes(moduleObj, methodName, observer_node);
+  observer_node->destroy();
+}
+
+std::unordered_map<std::string, std::tuple<std::string, float, int>>
+ComputeQParamsFromHistograms(const std::string& method, double percentile) {
+  std::unordered_map<std::string, std::tuple<std::string, float, int>>
+      qparam_dict;
+  forEachHistogramObserver(
+      [&](const std::string& name, HistogramObserver& observer) {
+        if (observer.empty()) {
+          return;
+        }
+        auto qparams = observer.chooseQParams(method, percentile);
+        qparam_dict.emplace(
+            name,
+            std::make_tuple(
+                std::string("per_tensor_quant"),
+                qparams.first,
+                qparams.second));
+      });
+  return qparam_dict;
+}
+
+void ResetHistograms() {
+  forEachHistogramObserver(
+      [](const std::string& /* name */, HistogramObserver& observer) {
+        observer.reset();
+      });
+}
+
 void InsertQuantDequantNodes(
     std::shared_ptr<Graph>& graph,
     const std::unordered_map<std::string, std::tuple<std::string, float, int>>&
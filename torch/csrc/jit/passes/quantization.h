@@ -46,6 +46,35 @@ TORCH_API void InsertObserverNodes(
     std::shared_ptr<script::Function>& function_var,
     Node* observer_node);
 
+/** \brief Inserts observer nodes that build a histogram of the values taken
+ * by each tensor in C++, see HistogramObserver.
+ *
+ * Unlike python observers, this adds no python call per observed value. After
+ * calibration runs, ComputeQParamsFromHistograms gives the qparams to pass to
+ * InsertQuantDequantNodes.
+ * \param moduleObj is the module object whose containing methods are modified.
+ * \param methodName is module method whose containing graph is instrumented.
+ */
+TORCH_API void InsertHistogramObservers(
+    std::shared_ptr<script::Module>& moduleObj,
+    const std::string& methodName);
+
+/** \brief Computes the qparams of all the values observed by histogram
+ * observers.
+ *
+ * \param method is `min_max`, `percentile` or `kl`, see
+ * HistogramObserver::chooseQParams.
+ * \return a dictionary of tensor unique names to qparams, in the format of
+ * InsertQuantDequantNodes.
+ */
+TORCH_API std::unordered_map<std::string, std::tuple<std::string, float, int>>
+ComputeQParamsFromHistograms(
+    const std::string& method,
+    double percentile = 99.99);
+
+/** \brief Forgets the values observed by histogram observers. */
+TORCH_API void ResetHistograms();
+
 /** \brief Inserts quant-dequant nodes.
  *
  * This actually changes the numerical semantics of the original model and thus
@@ -1,5 +1,6 @@
 #include "memory_dag.h"
 
+#include <c10/util/Exception.h>
 #include <torch/csrc/utils/memory.h>
 #include <algorithm>
 #include <queue>
@@ -15,28 +16,8 @@ bool MemoryDAG::mayAlias(const Element* a, const Element* b) const {
   return mayAliasImpl(a, b);
 }
 
-bool MemoryDAG::memoryLocationOverlap(
-    const std::unordered_set<const Element*>& aMemLoc,
-    const std::unordered_set<const Element*>& bMemLoc) const {
-  // XXX: This could be more efficiently done as a bitwise AND on two bitfields
-  // that represent memory location membership. If these comparisons end up
-  // being a bottleneck, consider implementing it that way.
-  for (const auto aLoc : aMemLoc) {
-    for (const auto bLoc : bMemLoc) {
-      if (aLoc == bLoc) {
-        return true;
-      }
-    }
-  }
-
-  return false;
-}
-
 bool MemoryDAG::mayAliasImpl(const Element* a, const Element* b) const {
-  const auto aMemLoc = a->getMemoryLocations();
-  const auto bMemLoc = b->getMemoryLocations();
-
-  return memoryLocationOverlap(aMemLoc, bMemLoc);
+  return a->getMemoryLocations().intersects(b->getMemoryLocations());
 }
 
 bool MemoryDAG::mayContainAlias(const Element* a, const Element* b) const {
@@ -47,19 +28,19 @@ bool MemoryDAG::mayContainAlias(Element* a, Element* b) const {
   return mayContainAliasImpl(a, b);
 }
 
-void collectAllContainedMemoryLocations(
+void MemoryDAG::collectAllContainedMemoryLocations(
     const Element* elem,
-    std::unordered_set<const Element*>& cont) {
+    MemoryLocations& cont) const {
   // we have already recursed on this element
-  if (cont.count(elem)) {
+  if (cont.test(elem->index)) {
     return;
   }
 
-  cont.insert(elem);
+  cont.set(elem->index);
 
-  for (const auto& mem_loc : elem->getMemoryLocations()) {
-    collectAllContainedMemoryLocations(mem_loc, cont);
-  }
+  elem->getMemoryLocations().forEach([&](unsigned loc) {
+    collectAllContainedMemoryLocations(fromIndex(loc), cont);
+  });
 
   for (const auto& contained : elem->contained_elements) {
     collectAllContainedMemoryLocations(contained, cont);
@@ -67,13 +48,13 @@ void collectAllContainedMemoryLocations(
 }
 
 bool MemoryDAG::mayContainAliasImpl(const Element* a, const Element* b) const {
-  std::unordered_set<const Element*> all_a_mlocs;
-  std::unordered_set<const Element*> all_b_mlocs;
+  MemoryLocations all_a_mlocs;
+  MemoryLocations all_b_mlocs;
 
   collectAllContainedMemoryLocations(a, all_a_mlocs);
   collectAllContainedMemoryLocations(b, all_b_mlocs);
 
-  return memoryLocationOverlap(all_a_mlocs, all_b_mlocs);
+  return all_a_mlocs.intersects(all_b_mlocs);
 }
 
 bool MemoryDAG::mayContainAlias(
@@ -83,23 +64,31 @@ bool MemoryDAG::mayContainAlias(
     return false;
   }
 
-  std::unordered_set<const Element*> all_a_mlocs;
+  MemoryLocations all_a_mlocs;
   for (const auto& elem : a) {
     collectAllContainedMemoryLocations(elem, all_a_mlocs);
   }
 
-  std::unordered_set<const Element*> all_b_mlocs;
+  MemoryLocations all_b_mlocs;
   for (const auto& elem : b) {
     collectAllContainedMemoryLocations(elem, all_b_mlocs);
   }
 
-  return memoryLocationOverlap(all_a_mlocs, all_b_mlocs);
+  return all_a_mlocs.intersects(all_b_mlocs);
 }
 
 // Make `v` point at `to`.
 void MemoryDAG::makePointerTo(Element* from, Element* to) {
-  from->pointsTo.insert(to);
+  if (!from->pointsTo.insert(to).second) {
+    return;
+  }
   to->pointedFrom.insert(from);
+
+  // `from` and everything that points to it may now point to the memory
+  // locations of `to`, so their cached locations are stale.
+  from->bfs(
+      [](const Element* el) { el->cachedMemoryLocations_.clear(); },
+      BfsDirection::POINTED_FROM);
 }
 
 void MemoryDAG::addToContainedElements(Element* elem, Element* container) {
@@ -108,33 +97,135 @@ void MemoryDAG::addToContainedElements(Element* elem, Element* container) {
 
 // Give `v` a fresh alias (i.e. it does not point to any value)
 Element* MemoryDAG::makeFreshValue(const Value* v) {
-  auto el = torch::make_unique<Element>();
-  el->value = v;
+  elements_.push_back(torch::make_unique<Element>(v, elements_.size()));
+  return elements_.back().get();
+}
 
-  auto rawPtr = el.get();
-  elements_.emplace(rawPtr, std::move(el));
-  return rawPtr;
+const Element* MemoryDAG::fromIndex(unsigned index) const {
+  AT_ASSERT(index < elements_.size());
+  return elements_[index].get();
 }
 
-std::unordered_set<const Element*> Element::getMemoryLocations() const {
+const MemoryLocations& Element::getMemoryLocations() const {
   if (!cachedMemoryLocations_.empty()) {
     return cachedMemoryLocations_;
   }
 
-  // Do a BFS in the `points-to` direction, collecting all memory locations
-  std::unordered_set<const Element*> ret;
-  this->bfs(
-      [&](const Element* el) {
-        if (el->pointsTo.empty()) {
-          ret.insert(el);
-        }
-      },
-      BfsDirection::POINTS_TO);
+  // Do a BFS in the `points-to` direction, collecting all memory locations.
+  // The search doesn't go past elements whose locations are already cached.
+  MemoryLocations ret;
+  std::queue<const Element*> queue;
+  std::unordered_set<const Element*> seen;
+  queue.push(this);
+  seen.insert(this);
+  while (!queue.empty()) {
+    const auto el = queue.front();
+    queue.pop();
+
+    if (!el->cachedMemoryLocations_.empty()) {
+      ret |= el->cachedMemoryLocations_;
+      continue;
+    }
+    if (el->pointsTo.empty()) {
+      ret.set(el->index);
+    }
+    for (const auto ptr : el->pointsTo) {
+      if (seen.insert(ptr).second) {
+        queue.push(ptr);
+      }
+    }
+  }
+
+  cachedMemoryLocations_ = std::move(ret);
+  return cachedMemoryLocations_;
+}
 
-  cachedMemoryLocations_ = ret;
+bool MemoryLocations::test(unsigned index) const {
+  const unsigned wordIndex = index / kBitsPerWord;
+  const auto it = std::lower_bound(
+      words_.begin(), words_.end(), wordIndex, [](const Word& w, unsigned i) {
+        return w.index < i;
+      });
+  return it != words_.end() && it->index == wordIndex &&
+      ((it->bits >> (index % kBitsPerWord)) & 1);
+}
+
+void MemoryLocations::set(unsigned index) {
+  const unsigned wordIndex = index / kBitsPerWord;
+  const uint64_t bit = uint64_t(1) << (index % kBitsPerWord);
+  auto it = std::lower_bound(
+      words_.begin(), words_.end(), wordIndex, [](const Word& w, unsigned i) {
+        return w.index < i;
+      });
+  if (it != words_.end() && it->index == wordIndex) {
+    it->bits |= bit;
+  } else {
+    words_.insert(it, Word{wordIndex, bit});
+  }
+}
+
+size_t MemoryLocations::count() const {
+  size_t ret = 0;
+  forEach([&](unsigned) { ret++; });
   return ret;
 }
 
+MemoryLocations& MemoryLocations::operator|=(const MemoryLocations& other) {
+  if (other.words_.empty()) {
+    return *this;
+  }
+  std::vector<Word> merged;
+  merged.reserve(words_.size() + other.words_.size());
+  auto a = words_.cbegin();
+  auto b = other.words_.cbegin();
+  while (a != words_.cend() || b != other.words_.cend()) {
+    if (b == other.words_.cend() ||
+        (a != words_.cend() && a->index < b->index)) {
+      merged.push_back(*a++);
+    } else if (a == words_.cend() || b->index < a->index) {
+      merged.push_back(*b++);
+    } else {
+      merged.push_back(Word{a->index, a->bits | b->bits});
+      a++;
+      b++;
+    }
+  }
+  words_ = std::move(merged);
+  return *this;
+}
+
+bool MemoryLocations::intersects(const MemoryLocations& other) const {
+  auto a = words_.cbegin();
+  auto b = other.words_.cbegin();
+  while (a != words_.cend() && b != other.words_.cend()) {
+    if (a->index < b->index) {
+      a++;
+    } else if (b->index < a->index) {
+      b++;
+    } else {
+      if (a->bits & b->bits) {
+        return true;
+      }
+      a++;
+      b++;
+    }
+  }
+  return false;
+}
+
+bool MemoryLocations::operator==(const MemoryLocations& other) const {
+  if (words_.size() != other.words_.size()) {
+    return false;
+  }
+  return std::equal(
+      words_.cbegin(),
+      words_.cend(),
+      other.words_.cbegin(),
+      [](const Word& a, const Word& b) {
+        return a.index == b.index && a.bits == b.bits;
+      });
+}
+
 // Do a breadth-first search over the graph, starting at `this` and
 // traversing in the direction `dir`.`fn` will be run on each element.
 template <typename Fn>
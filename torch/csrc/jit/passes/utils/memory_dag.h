@@ -1,6 +1,7 @@
 #pragma once
 
 #include <c10/util/ArrayRef.h>
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
@@ -14,6 +15,51 @@ namespace jit {
 struct Element;
 struct Value;
 
+// class MemoryLocations
+//
+// A set of memory locations, stored as a bitset over the indices of their
+// elements in the MemoryDAG. The bitset is sparse: it keeps only the nonzero
+// 64-bit words, sorted by position. Most values may only point to one or two
+// locations, so a set is usually a word or two no matter how large the graph
+// is, and unions and intersection tests are a linear merge of the words.
+class TORCH_API MemoryLocations {
+ public:
+  bool empty() const {
+    return words_.empty();
+  }
+  void clear() {
+    words_.clear();
+  }
+  bool test(unsigned index) const;
+  void set(unsigned index);
+  size_t count() const;
+
+  MemoryLocations& operator|=(const MemoryLocations& other);
+  // Do `this` and `other` have a memory location in common?
+  bool intersects(const MemoryLocations& other) const;
+  bool operator==(const MemoryLocations& other) const;
+
+  // Run `fn` on the index of each memory location, in increasing order.
+  template <typename Fn>
+  void forEach(Fn fn) const {
+    for (const auto& word : words_) {
+      for (unsigned bit = 0; bit < kBitsPerWord; bit++) {
+        if ((word.bits >> bit) & 1) {
+          fn(word.index * kBitsPerWord + bit);
+        }
+      }
+    }
+  }
+
+ private:
+  static constexpr unsigned kBitsPerWord = 64;
+  struct Word {
+    unsigned index;
+    uint64_t bits;
+  };
+  std::vector<Word> words_;
+};
+
 // class MemoryDAG
 //
 // This class tracks the "A points to B" graph for all values. It is used by
@@ -29,6 +75,11 @@ struct Value;
 //
 // So, by traversing the "points-to" graph to the leaves, you can determine
 // which memory locations an element may point to.
+//
+// The memory locations of each element are cached the first time they are
+// asked for, and queries are then intersections of the cached bitsets. Adding
+// a pointer invalidates the caches of the elements that may now point to more
+// locations, i.e. of the source of the pointer and everything pointing to it.
 class MemoryDAG {
  public:
   // Make `from` point at `to`.
@@ -55,7 +106,7 @@ class MemoryDAG {
   // Do any values in group `a` potentially share a memory location with any
   // value in group `b`?
   //
-  // This is written so that either of the inputs could be a multiset
+  // Either of the inputs may be a multiset.
   template <typename T, typename U>
   bool mayAlias(const T& a, const U& b) const {
     if (a.empty() || b.empty()) {
@@ -63,45 +114,33 @@ class MemoryDAG {
     }
 
     // Record all memory locations from group `a`
-    std::unordered_set<const Element*> memoryLocations;
-    for (auto it = a.cbegin(); it != a.cend();) {
-      const auto element = *it;
-
-      for (const auto loc : element->getMemoryLocations()) {
-        memoryLocations.insert(loc);
-      }
-
-      const auto cnt = a.count(*it);
-      std::advance(it, cnt);
+    MemoryLocations memoryLocations;
+    for (const auto element : a) {
+      memoryLocations |= element->getMemoryLocations();
     }
 
     // If any of group `b`s memory locations overlap, return true.
-    for (auto it = b.cbegin(); it != b.cend();) {
-      const auto element = *it;
-
-      for (const auto loc : element->getMemoryLocations()) {
-        if (memoryLocations.count(loc)) {
-          return true;
-        }
+    for (const auto element : b) {
+      if (memoryLocations.intersects(element->getMemoryLocations())) {
+        return true;
       }
-
-      const auto cnt = b.count(*it);
-      std::advance(it, cnt);
     }
     // No overlap, so group `a` and `b` do not share a memory location
     return false;
   }
 
+  // The element with index `index`, i.e. the element of a memory location.
+  const Element* fromIndex(unsigned index) const;
+
  private:
-  bool memoryLocationOverlap(
-      const std::unordered_set<const Element*>& a,
-      const std::unordered_set<const Element*>& b) const;
   bool mayAliasImpl(const Element* a, const Element* b) const;
   bool mayContainAliasImpl(const Element* contained, const Element* container)
       const;
-  // Structure that owns all the element pointers. It's a map of
-  //  raw pointer -> unique_ptr to facilitate easy queries
-  std::unordered_map<Element*, std::unique_ptr<Element>> elements_;
+  void collectAllContainedMemoryLocations(
+      const Element* elem,
+      MemoryLocations& cont) const;
+  // Structure that owns all the elements, indexed by `Element::index`.
+  std::vector<std::unique_ptr<Element>> elements_;
 };
 
 enum class BfsDirection {
@@ -113,10 +152,17 @@ enum class BfsDirection {
 // anything that could have an aliasing relationship, mostly IR `Value`s, but
 // also the "inside of a list", or wildcards.
 struct Element {
+  Element(const Value* value_, unsigned index_)
+      : value(value_), index(index_) {}
+
   // The value that this element corresponds to. May be null if this element
   // doesn't represent a first-class value.
   const Value* value = nullptr;
 
+  // The position of this element in its MemoryDAG, which is its bit in
+  // MemoryLocations.
+  unsigned index;
+
   // All elements that this element *may* point to. It's possible to have
   // multiple elements that you might point to due to control flow/complex ops
   std::unordered_set<Element*> pointsTo;
@@ -126,11 +172,11 @@ struct Element {
   std::unordered_set<Element*> contained_elements;
 
   // Return the unique memory locations that `Element` might represent.
-  TORCH_API std::unordered_set<const Element*> getMemoryLocations() const;
+  TORCH_API const MemoryLocations& getMemoryLocations() const;
   // We do path compression to make repeated memory location queries faster.
   // An empty cache means it is invalidated (it can never be empty otherwise,
   // since every element must point to at least one memory location).
-  mutable std::unordered_set<const Element*> cachedMemoryLocations_;
+  mutable MemoryLocations cachedMemoryLocations_;
 
   // Do a breadth-first search over the graph, starting at `this` and
   // traversing in the direction `dir`.`fn` will be run on each element.
@@ -1,15 +1,22 @@
 #include <torch/csrc/jit/pickler.h>
 
+#include <algorithm>
+#include <cstring>
+
 namespace torch {
 namespace jit {
 
 using ::c10::IValue;
 
+constexpr size_t Unpickler::kBufferSize;
+
 PicklerClass getClass(const std::string& str) {
   if (str == "build_tensor_from_id") {
     return PicklerClass::TENSOR;
   } else if (str == "build_intlist") {
     return PicklerClass::INTLIST;
+  } else if (str == "build_tensorlist") {
+    return PicklerClass::TENSORLIST;
   }
 
   // TODO [unpickler refactor]
@@ -24,11 +31,14 @@ PicklerClass getClass(const std::string& str) {
 const std::string& getClassName(PicklerClass cls) {
   static const std::string tensor_class("build_tensor_from_id\n");
   static const std::string intlist_class("build_intlist\n");
+  static const std::string tensorlist_class("build_tensorlist\n");
   switch (cls) {
     case PicklerClass::TENSOR:
       return tensor_class;
     case PicklerClass::INTLIST:
       return intlist_class;
+    case PicklerClass::TENSORLIST:
+      return tensorlist_class;
     default:
       AT_ERROR("Unknown class for pickler");
   }
@@ -44,6 +54,7 @@ const std::vector<char>& Pickler::stack() {
 }
 
 void Pickler::start() {
+  stack_.reserve(kInitialStackSize);
   push<OpCode>(OpCode::PROTO);
   push<uint8_t>(2);
 
@@ -76,7 +87,7 @@ void Pickler::addIValue(const IValue& ivalue) {
   } else if (ivalue.isDouble()) {
     pushDouble(ivalue);
   } else if (ivalue.isInt()) {
-    pushInt(ivalue);
+    pushInt(ivalue.toInt());
   } else if (ivalue.isBool()) {
     if (ivalue.toBool()) {
       push<OpCode>(OpCode::NEWTRUE);
@@ -93,6 +104,8 @@ void Pickler::addIValue(const IValue& ivalue) {
     push<OpCode>(OpCode::NONE);
   } else if (ivalue.isIntList()) {
     pushIntList(ivalue);
+  } else if (ivalue.isTensorList()) {
+    pushTensorList(ivalue);
   } else {
     AT_ERROR("Unknown IValue type for pickling: ", ivalue.tagKind());
   }
@@ -111,13 +124,14 @@ const void* Pickler::getPointer(const IValue& ivalue) {
     return ivalue.toString().get();
   } else if (ivalue.isIntList()) {
     return ivalue.toIntList().get();
+  } else if (ivalue.isTensorList()) {
+    return ivalue.toTensorList().get();
   }
 
   return nullptr;
 }
 
-void Pickler::pushInt(const IValue& ivalue) {
-  auto n = ivalue.toInt();
+void Pickler::pushInt(int64_t n) {
   if (n >= std::numeric_limits<int8_t>::min() &&
       n <= std::numeric_limits<int8_t>::max()) {
     push<OpCode>(OpCode::BININT1);
@@ -156,7 +170,11 @@ void Pickler::pushMemoizedString(const IValue& ivalue) {
 }
 
 void Pickler::pushString(const std::string& string) {
-  stack_.insert(stack_.end(), string.begin(), string.end());
+  pushBytes(string.data(), string.size());
+}
+
+void Pickler::pushBytes(const char* data, size_t size) {
+  stack_.insert(stack_.end(), data, data + size);
 }
 
 void Pickler::pushClass(PicklerClass cls) {
@@ -176,17 +194,50 @@ void Pickler::pushClass(PicklerClass cls) {
 }
 
 void Pickler::pushTensor(const IValue& ivalue) {
+  pushTensor(ivalue.toTensor());
+}
+
+void Pickler::pushTensor(const at::Tensor& tensor) {
   pushClass(PicklerClass::TENSOR);
 
-  tensor_table_->push_back(ivalue.toTensor());
+  // The data is written out of band, only its index in the table is pickled
+  tensor_table_->push_back(tensor);
   int64_t tensor_id = tensor_table_->size() - 1;
   // Reduce arguments are spread (e.g. `*args`) before calling the global,
   // so wrap in a tuple
   push<OpCode>(OpCode::MARK);
-  addIValue(tensor_id);
+  pushInt(tensor_id);
+  push<OpCode>(OpCode::TUPLE);
+
+  push<OpCode>(OpCode::REDUCE);
+}
+
+void Pickler::pushTensorList(const IValue& ivalue) {
+  pushClass(PicklerClass::TENSORLIST);
+
+  // Reduce arguments are spread (e.g. `*args`) before calling the global,
+  // so wrap in a tuple
+  push<OpCode>(OpCode::MARK);
+
+  push<OpCode>(OpCode::EMPTY_LIST);
+  // Mark list
+  push<OpCode>(OpCode::MARK);
+
+  // Add items, without going through addIValue since tensors are never
+  // memoized
+  for (const auto& tensor : ivalue.toTensorListRef()) {
+    pushTensor(tensor);
+  }
+
+  // Finish list
+  push<OpCode>(OpCode::APPENDS);
+
+  // Finish tuple
   push<OpCode>(OpCode::TUPLE);
 
+  // Call reduce
   push<OpCode>(OpCode::REDUCE);
+  pushMemoization(ivalue);
 }
 
 void Pickler::pushIntList(const IValue& ivalue) {
@@ -202,8 +253,8 @@ void Pickler::pushIntList(const IValue& ivalue) {
   push<OpCode>(OpCode::MARK);
 
   // Add items
-  for (const auto& item : ivalue.toIntListRef()) {
-    addIValue(item);
+  for (int64_t item : ivalue.toIntListRef()) {
+    pushInt(item);
   }
 
   // Finish list
@@ -271,7 +322,7 @@ void Pickler::pushMemoization(const IValue& ivalue) {
 }
 
 void Pickler::pushList(const IValue& ivalue) {
-  auto list = ivalue.toGenericListRef();
+  const auto& list = ivalue.toGenericListRef();
   push<OpCode>(OpCode::EMPTY_LIST);
   pushMemoization(ivalue);
 
@@ -287,7 +338,7 @@ void Pickler::pushList(const IValue& ivalue) {
 void Pickler::pushTuple(const IValue& ivalue) {
   // TODO: Small tuple unrolling (e.g. TUPLE3)
   push<OpCode>(OpCode::MARK);
-  auto tuple = ivalue.toTuple()->elements();
+  const auto& tuple = ivalue.toTuple()->elements();
 
   for (const auto& item : tuple) {
     addIValue(item);
@@ -312,9 +363,38 @@ std::vector<IValue> Unpickler::parse_ivalue_list() {
   return value.toTuple()->elements();
 }
 
+// Moves the bytes that have not been read yet to the front of the buffer and
+// appends the next bytes from the reader, until at least `n` are available
+bool Unpickler::refill(size_t n) {
+  if (!reader_) {
+    return false;
+  }
+  size_t available = end_ptr_ - bytes_;
+  const size_t capacity = std::max(n, kBufferSize);
+  if (buffer_.size() < capacity) {
+    std::vector<uint8_t> buffer(capacity);
+    std::copy(bytes_, end_ptr_, buffer.begin());
+    buffer_.swap(buffer);
+  } else if (available > 0) {
+    std::memmove(buffer_.data(), bytes_, available);
+  }
+  bytes_ = buffer_.data();
+  while (available < n) {
+    size_t read = reader_(
+        reinterpret_cast<char*>(buffer_.data() + available),
+        buffer_.size() - available);
+    if (read == 0) {
+      break;
+    }
+    available += read;
+  }
+  end_ptr_ = bytes_ + available;
+  return available >= n;
+}
+
 double Unpickler::readFloat() {
   AT_ASSERT(sizeof(double) == 8);
-  AT_ASSERT(bytes_ + 8 < end_ptr_);
+  ensure(8, "Unpickler overran buffer while reading a float");
   double result;
 
   // Pickle floats are big endian, so reverse the bytes
@@ -339,7 +419,7 @@ void Unpickler::run() {
       "Only Pickle protocol 2 is supported, found protocol = ",
       protocol);
 
-  while (bytes_ < end_ptr_) {
+  while (bytes_ < end_ptr_ || refill(1)) {
     OpCode opcode = readInstruction();
     if (opcode == OpCode::STOP) {
       return;
@@ -375,6 +455,9 @@ OpCode Unpickler::readInstruction() {
         // specialization
         if (stack_.back().pickler_class() == PicklerClass::INTLIST) {
           stack_.emplace_back(std::vector<int64_t>());
+        } else if (
+            stack_.back().pickler_class() == PicklerClass::TENSORLIST) {
+          stack_.emplace_back(std::vector<at::Tensor>());
         } else {
           AT_ERROR("Unknown list specialization");
         }
@@ -430,8 +513,8 @@ OpCode Unpickler::readInstruction() {
     } break;
     case OpCode::BINUNICODE: {
       uint32_t length = read<uint32_t>();
+      ensure(length, "Unpickler overran buffer while reading a string");
       const char* characters = reinterpret_cast<const char*>(bytes_);
-      AT_ASSERT(bytes_ + length < end_ptr_);
       bytes_ += length;
       stack_.emplace_back(std::string(characters, /*n=*/length));
     } break;
@@ -526,6 +609,9 @@ OpCode Unpickler::readInstruction() {
         case PicklerClass::INTLIST:
           stack_.emplace_back(data->elements().at(0).toIntListRef());
           break;
+        case PicklerClass::TENSORLIST:
+          stack_.emplace_back(data->elements().at(0).toTensorListRef());
+          break;
         default:
           AT_ERROR("Unknown pickler class id");
       }
@@ -547,6 +633,12 @@ void Unpickler::readList() {
     for (auto it = stack_.begin() + start; it != stack_.end(); ++it) {
       list->elements().emplace_back(it->ivalue().toInt());
     }
+  } else if (list_ivalue.ivalue().isTensorList()) {
+    auto list = stack_.at(start - 1).ivalue().toTensorList();
+    list->elements().reserve(num_elements);
+    for (auto it = stack_.begin() + start; it != stack_.end(); ++it) {
+      list->elements().emplace_back(it->ivalue().toTensor());
+    }
   } else {
     auto list = stack_.at(start - 1).ivalue().toGenericList();
     list->elements().reserve(num_elements);
@@ -565,16 +657,17 @@ inline bool is_valid_python_id_char(char c) {
 
 // Read a newline terminated string
 std::string Unpickler::readString() {
-  const char* chars = reinterpret_cast<const char*>(bytes_);
-  const char* char_end_ptr = reinterpret_cast<const char*>(end_ptr_);
   size_t n = 0;
   while (true) {
-    char c = chars[n];
+    // Also checks that there is a terminating '\n'
+    ensure(
+        n + 1,
+        "Unpickler overran buffer while reading a string (expected a newline)");
+    char c = reinterpret_cast<const char*>(bytes_)[n];
     if (c == '\n') {
       break;
     }
 
-    // Simple check just in case there is no terminating '\n'
     AT_CHECK(
         is_valid_python_id_char(c),
         "Found character '",
@@ -584,14 +677,12 @@ std::string Unpickler::readString() {
 
     // Increment after to exclude newline from string
     ++n;
-    AT_CHECK(
-        chars + n < char_end_ptr,
-        "Unpickler overran buffer while reading a string (expected a newline)");
   }
 
+  std::string result(reinterpret_cast<const char*>(bytes_), n);
   // Increment by string length + newline char
   bytes_ += n + 1;
-  return std::string(chars, n);
+  return result;
 }
 
 OpCode Unpickler::readOpCode() {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -85,7 +86,7 @@ enum class OpCode : char {
   FRAME = '\x95'
 };
 
-enum PicklerClass : uint8_t { TENSOR = 0, INTLIST = 1 };
+enum PicklerClass : uint8_t { TENSOR = 0, INTLIST = 1, TENSORLIST = 2 };
 
 using ::c10::IValue;
 
@@ -105,7 +106,10 @@ class Pickler {
   void pushBinGet(uint32_t memo_id);
   void pushMemoizedString(const IValue& ivalue);
   void pushString(const std::string& string);
+  void pushBytes(const char* data, size_t size);
   void pushTensor(const IValue& ivalue);
+  void pushTensor(const at::Tensor& tensor);
+  void pushTensorList(const IValue& ivalue);
   void pushDouble(const IValue& ivalue);
   void pushMemoization(const void* item);
   void pushMemoization(const IValue& ivalue);
@@ -114,7 +118,7 @@ class Pickler {
   void pushTuple(const IValue& ivalue);
   void pushDict(const IValue& ivalue);
   void pushClass(PicklerClass cls);
-  void pushInt(const IValue& ivalue);
+  void pushInt(int64_t n);
   const void* getPointer(const IValue& ivalue);
 
   // These convert values to bytes and add them to the stack (NB: since T is to
@@ -123,10 +127,13 @@ class Pickler {
   // does not)
   template <typename T>
   void push(typename std::common_type<T>::type value) {
-    const char* begin = reinterpret_cast<const char*>(&value);
-    stack_.insert(stack_.end(), begin, begin + sizeof(T));
+    pushBytes(reinterpret_cast<const char*>(&value), sizeof(T));
   }
 
+  // Space reserved for the output up front, so that small pickles are never
+  // reallocated
+  static constexpr size_t kInitialStackSize = 1 << 16;
+
   // Stack of opcodes/data
   std::vector<char> stack_;
 
@@ -188,6 +195,19 @@ class Unpickler {
         tensor_table_(tensor_table),
         last_opcode_(OpCode::STOP) {}
 
+  // Reads the pickle incrementally from `reader`, which is called to fill a
+  // buffer with the next bytes of the pickle and returns how many it wrote
+  // (0 once there are none left), so the whole pickle never has to be in
+  // memory at once.
+  Unpickler(
+      std::function<size_t(char*, size_t)> reader,
+      const std::vector<at::Tensor>* tensor_table)
+      : bytes_(nullptr),
+        end_ptr_(nullptr),
+        reader_(std::move(reader)),
+        tensor_table_(tensor_table),
+        last_opcode_(OpCode::STOP) {}
+
   std::vector<IValue> parse_ivalue_list();
 
  private:
@@ -195,15 +215,22 @@ class Unpickler {
   // so that the number of bytes read / type read is explicit
   template <typename T>
   T read() {
-    AT_CHECK(
-        bytes_ + sizeof(T) <= end_ptr_,
-        "Unpickler overran buffer while reading a value");
+    ensure(sizeof(T), "Unpickler overran buffer while reading a value");
     T item;
     std::memcpy(&item, bytes_, sizeof(T));
     bytes_ += sizeof(T);
     return item;
   }
 
+  // Makes at least `n` bytes available at `bytes_`, reading them from
+  // `reader_` if necessary, or fails with `what`
+  void ensure(size_t n, const char* what) {
+    if (static_cast<size_t>(end_ptr_ - bytes_) < n) {
+      AT_CHECK(refill(n), what);
+    }
+  }
+  bool refill(size_t n);
+
   double readFloat();
   void run();
   OpCode readInstruction();
@@ -216,6 +243,10 @@ class Unpickler {
   std::vector<size_t> marks_;
   const uint8_t* bytes_;
   const uint8_t* end_ptr_;
+  // Only used when reading incrementally; bytes_ points into buffer_ then
+  std::function<size_t(char*, size_t)> reader_;
+  std::vector<uint8_t> buffer_;
+  static constexpr size_t kBufferSize = 1 << 16;
   const std::vector<at::Tensor>* tensor_table_;
 
   // [unpickler refactor]
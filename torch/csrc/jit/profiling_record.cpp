@@ -18,10 +18,7 @@ Node* ProfilingRecord::createProfileNode(
 }
 
 void ProfilingRecord::instrumentBlock(Block* block) {
-  // iterating backwards allows us to easily insert profile nodes
-  // without affecting an iterator
-  for (auto it = block->nodes().rend(); it != block->nodes().rbegin(); --it) {
-    auto n = *it;
+  auto profileOutputs = [this](Node* n) {
     for (auto o : n->outputs()) {
       if (!o->type()->isSubclass(TypeKind::TensorType)) {
         continue;
@@ -30,7 +27,7 @@ void ProfilingRecord::instrumentBlock(Block* block) {
       std::function<void(Stack&)> shape_profiler = [this, o](Stack& stack) {
         IValue t;
         pop(stack, t);
-        if (t.isTensor()) {
+        if (t.isTensor() && t.toTensor().defined()) {
           auto pttp = ProfiledTensorType::create(t.toTensor());
           std::lock_guard<std::mutex> lock(this->mutex_);
           if (o->type()->isSubclass(TypeKind::ProfiledTensorType)) {
@@ -45,7 +42,14 @@ void ProfilingRecord::instrumentBlock(Block* block) {
       auto pn = createProfileNode(shape_profiler, {o});
       pn->insertAfter(n);
     }
+  };
 
+  // the block inputs are profiled as the outputs of its param node; nodes
+  // are collected first so that the profile nodes aren't visited
+  std::vector<Node*> nodes(block->nodes().begin(), block->nodes().end());
+  profileOutputs(block->param_node());
+  for (auto n : nodes) {
+    profileOutputs(n);
     for (auto b : n->blocks()) {
       instrumentBlock(b);
     }
@@ -61,7 +65,9 @@ std::unique_ptr<ProfilingRecord> ProfilingRecord::instrumentGraph(
   pr->instrumentBlock(new_g->block());
   std::function<void(Stack&)> counter = [raw_pr](Stack&) {
     std::lock_guard<std::mutex> lock(raw_pr->mutex_);
-    raw_pr->profiling_count_--;
+    if (raw_pr->profiling_count_ > 0) {
+      raw_pr->profiling_count_--;
+    }
   };
 
   auto pop = pr->createProfileNode(counter, {});
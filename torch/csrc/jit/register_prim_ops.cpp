@@ -22,6 +22,7 @@
 #include <cmath>
 #include <exception>
 #include <iostream>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <mutex>
@@ -64,6 +65,31 @@ void checkImplicitTensorToNum(at::Tensor t, bool toInt) {
   }
 }
 
+// Pushes the elements of a list that was popped off the stack. If the stack
+// held the only reference to the list, the elements are moved to the stack
+// instead of copied, which saves a refcount bump for each of them.
+template <typename TList>
+void pushListElements(
+    Stack& stack,
+    c10::intrusive_ptr<TList> list,
+    size_t num_outputs) {
+  auto& elements = list->elements();
+  AT_CHECK(
+      elements.size() == num_outputs,
+      "Expected ",
+      num_outputs,
+      " elements in a list but found ",
+      elements.size());
+  if (list.use_count() == 1) {
+    stack.insert(
+        stack.end(),
+        std::make_move_iterator(elements.begin()),
+        std::make_move_iterator(elements.end()));
+  } else {
+    stack.insert(stack.end(), elements.begin(), elements.end());
+  }
+}
+
 template <typename dtype> // int64_t, bool, double
 Operation listConstruct(int64_t num_inputs) {
   return [=](Stack& stack) {
@@ -761,28 +787,13 @@ RegisterOperators reg(
              };
            } else if (lt->getElementType() == TensorType::get()) {
              return [=](Stack& stack) {
-               auto ilist = pop(stack);
-               const auto& list = ilist.toTensorList()->elements();
-               AT_CHECK(
-                   list.size() == num_outputs,
-                   "Expected ",
-                   num_outputs,
-                   " elements in a list but found ",
-                   list.size());
-               stack.insert(stack.end(), list.begin(), list.end());
+               pushListElements(stack, pop(stack).toTensorList(), num_outputs);
                return 0;
              };
            } else {
              return [=](Stack& stack) {
-               auto glist = pop(stack);
-               const auto& list = glist.toGenericList()->elements();
-               AT_CHECK(
-                   list.size() == num_outputs,
-                   "Expected ",
-                   num_outputs,
-                   " elements in a list but found ",
-                   list.size());
-               stack.insert(stack.end(), list.begin(), list.end());
+               pushListElements(
+                   stack, pop(stack).toGenericList(), num_outputs);
                return 0;
              };
            }
@@ -837,7 +848,7 @@ RegisterOperators reg(
              for (size_t i = 0; i < num_inputs; i += 2) {
                auto val = pop(stack);
                auto key = pop(stack);
-               vals[key] = val;
+               vals[std::move(key)] = std::move(val);
              }
              push(stack, std::move(vals));
              return 0;
@@ -1073,8 +1084,8 @@ int listAppend(Stack& stack) {
   TElement el;
   pop(stack, a, el);
 
-  a->elements().push_back(el);
-  push(stack, a);
+  a->elements().push_back(std::move(el));
+  push(stack, std::move(a));
 
   return 0;
 }
@@ -1152,12 +1163,12 @@ int listInsert(Stack& stack) {
 
   if (normalized_idx < 0 || normalized_idx >= list_size) {
     if (normalized_idx < 0) {
-      elements.insert(elements.begin(), elem);
+      elements.insert(elements.begin(), std::move(elem));
     } else {
-      elements.push_back(elem);
+      elements.push_back(std::move(elem));
     }
   } else {
-    elements.insert(elements.begin() + normalized_idx, elem);
+    elements.insert(elements.begin() + normalized_idx, std::move(elem));
   }
 
   return 0;
@@ -1189,7 +1200,7 @@ int listRemove<Shared<TensorList>, at::Tensor>(Stack& stack) {
 
   auto& elements = list->elements();
   auto pos = std::find_if(
-      elements.begin(), elements.end(), [elem](const at::Tensor& b) {
+      elements.begin(), elements.end(), [&elem](const at::Tensor& b) {
         const auto cmp_result = elem.eq(b);
         return cmp_result.is_nonzero();
       });
@@ -1229,7 +1240,7 @@ int listIndex<Shared<TensorList>, at::Tensor>(Stack& stack) {
 
   auto& elements = list->elements();
   auto pos = std::find_if(
-      elements.begin(), elements.end(), [elem](const at::Tensor& b) {
+      elements.begin(), elements.end(), [&elem](const at::Tensor& b) {
         const auto cmp_result = elem.eq(b);
         return cmp_result.is_nonzero();
       });
@@ -1264,7 +1275,7 @@ int listCount<Shared<TensorList>, at::Tensor>(Stack& stack) {
 
   auto& elements = list->elements();
   const int64_t count = std::count_if(
-      elements.begin(), elements.end(), [elem](const at::Tensor& b) {
+      elements.begin(), elements.end(), [&elem](const at::Tensor& b) {
         const auto cmp_result = elem.eq(b);
         return cmp_result.is_nonzero();
       });
@@ -1295,7 +1306,7 @@ Operation listCopy(const Node* node) {
 
     const auto& vec = list->elements();
     auto out = vec;
-    push(stack, out);
+    push(stack, std::move(out));
     return 0;
   };
 }
@@ -1415,7 +1426,7 @@ int listAdd(Stack& stack) {
     ret.push_back(b_element);
   }
 
-  push(stack, ret);
+  push(stack, std::move(ret));
   return 0;
 }
 
@@ -1435,7 +1446,7 @@ int listMulIntLeft(Stack& stack) {
     }
   }
 
-  push(stack, ret);
+  push(stack, std::move(ret));
   return 0;
 }
 
@@ -1455,7 +1466,7 @@ int listMulIntRight(Stack& stack) {
     }
   }
 
-  push(stack, ret);
+  push(stack, std::move(ret));
   return 0;
 }
 
@@ -1489,7 +1500,7 @@ int listSlice(Stack& stack) {
     i += step;
   }
 
-  push(stack, sliced_list);
+  push(stack, std::move(sliced_list));
   return 0;
 }
 
@@ -1523,9 +1534,9 @@ int listSetItem(Stack& stack) {
   TElement value;
 
   pop(stack, list, idx, value);
-  getItem(list, idx) = value;
+  getItem(list, idx) = std::move(value);
 
-  push(stack, list);
+  push(stack, std::move(list));
   return 0;
 }
 
@@ -1544,7 +1555,7 @@ int listSetItem<Shared<BoolList>, bool>(Stack& stack) {
   }
   list->elements()[normalized_idx] = value;
 
-  push(stack, list);
+  push(stack, std::move(list));
   return 0;
 }
 
@@ -1552,7 +1563,7 @@ int dictSetItem(Stack& stack) {
   auto value = pop(stack);
   auto idx = pop(stack);
   auto& dict = pop(stack).toGenericDict()->elements();
-  dict[idx] = value;
+  dict[std::move(idx)] = std::move(value);
   push(stack, dict);
   return 0;
 }
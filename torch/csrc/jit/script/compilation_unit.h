@@ -212,7 +212,11 @@ struct TORCH_API CompilationUnit {
           resolvers, /* determines how we handle free
                      variables in each definition*/
       // if non-null, the first argument to each def, is bound to this value
-      const Self& self);
+      const Self& self,
+      // compile definitions that do not refer to each other concurrently on
+      // the inter-op thread pool; resolvers and self must then be safe to
+      // call from any thread (so not Python resolvers, which need the GIL)
+      bool parallel = false);
 
   // same as above but parse the definitions from source
   void define(
@@ -13,11 +13,16 @@
 
 #include <torch/csrc/jit/constants.h>
 
+#include <c10/core/thread_pool.h>
 #include <c10/util/Optional.h>
 
 #include <atomic>
 #include <climits>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 #include <set>
+#include <unordered_set>
 
 namespace torch {
 namespace jit {
@@ -2975,10 +2980,78 @@ struct FunctionResolver : public Resolver {
       functionTable_;
 };
 
+// Whether the body of `def` refers to any of `names`. This is a syntactic
+// check on identifiers, so it may report references that are not calls.
+static bool mentionsAnyOf(
+    const Def& def,
+    const std::unordered_set<std::string>& names) {
+  std::vector<TreeRef> worklist = {def.decl().tree(),
+                                   def.statements().tree()};
+  while (!worklist.empty()) {
+    TreeRef tree = worklist.back();
+    worklist.pop_back();
+    if (tree->kind() == TK_IDENT && names.count(Ident(tree).name())) {
+      return true;
+    }
+    for (const TreeRef& sub : tree->trees()) {
+      worklist.push_back(sub);
+    }
+  }
+  return false;
+}
+
+// Runs fn(0) ... fn(n - 1) on the inter-op thread pool. The calling thread
+// takes items too, so this makes progress even when the pool is busy. If
+// any call throws, the exception of the lowest index is rethrown once all
+// calls have finished.
+static void parallelForEach(size_t n, const std::function<void(size_t)>& fn) {
+  struct State {
+    std::atomic<size_t> next{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t done = 0;
+    std::vector<std::exception_ptr> errors;
+  };
+  auto state = std::make_shared<State>();
+  state->errors.resize(n);
+  // Tasks that start after every item was taken return without touching fn,
+  // so they may outlive this call.
+  auto work = [state, n, fn]() {
+    for (size_t i = state->next++; i < n; i = state->next++) {
+      try {
+        fn(i);
+      } catch (...) {
+        state->errors[i] = std::current_exception();
+      }
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if (++state->done == n) {
+        state->finished.notify_all();
+      }
+    }
+  };
+
+  auto& pool = c10::global_work_queue();
+  const size_t num_tasks = std::min(n, pool.size() + 1);
+  for (size_t t = 1; t < num_tasks; ++t) {
+    pool.run(work);
+  }
+  work();
+  {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&] { return state->done == n; });
+  }
+  for (const auto& error : state->errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
 void CompilationUnit::define(
     const std::vector<Def>& definitions,
     const std::vector<ResolverPtr>& resolvers,
-    const Self& self) {
+    const Self& self,
+    bool parallel) {
   AT_ASSERT(definitions.size() == resolvers.size());
   auto resolver_it = resolvers.begin();
   std::vector<Function*> methods;
@@ -3016,7 +3089,35 @@ void CompilationUnit::define(
     methods.push_back(fn.get());
     register_function(std::move(fn));
   }
-  for (Function* method : methods) {
+  if (!parallel || methods.size() < 2) {
+    for (Function* method : methods) {
+      method->ensure_defined();
+    }
+    return;
+  }
+
+  // `__init__` goes first, as above. Definitions that refer to another one
+  // of this batch may define it on demand, so they are compiled after the
+  // others, serially; the rest never touch each other and run in parallel.
+  std::unordered_set<std::string> names;
+  for (const Def& def : ordered_defs) {
+    names.insert(def.name().name());
+  }
+  std::vector<Function*> independent;
+  std::vector<Function*> dependent;
+  for (size_t i = 0; i < methods.size(); ++i) {
+    if (ordered_defs[i].name().name() == "__init__") {
+      methods[i]->ensure_defined();
+    } else if (mentionsAnyOf(ordered_defs[i], names)) {
+      dependent.push_back(methods[i]);
+    } else {
+      independent.push_back(methods[i]);
+    }
+  }
+  parallelForEach(independent.size(), [&](size_t i) {
+    independent[i]->ensure_defined();
+  });
+  for (Function* method : dependent) {
     method->ensure_defined();
   }
 }
@@ -158,6 +158,8 @@ struct SchemaParser {
           return static_cast<int64_t>(at::kStrided);
         } else if ("Mean" == text) {
           return static_cast<int64_t>(Reduction::Mean);
+        } else if ("contiguous_format" == text) {
+          return static_cast<int64_t>(c10::MemoryFormat::Contiguous);
         } else {
           throw ErrorReport(L.cur().range) << "invalid numeric default value";
         }
@@ -20,12 +20,14 @@
 #include <torch/csrc/jit/script/logging.h>
 #include <torch/csrc/jit/script/parser.h>
 #include <torch/csrc/jit/tracer.h>
+#include <torch/csrc/utils/memory.h>
 
 #include <torch/csrc/api/include/torch/ordered_dict.h>
 
 #include <ATen/ATen.h>
 #include <ATen/core/function_schema.h>
 #include <ATen/core/qualified_name.h>
+#include <caffe2/serialize/mmap_file_adapter.h>
 
 #include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
@@ -249,20 +251,24 @@ void initJitScriptBindings(PyObject* module) {
           "save",
           [](std::shared_ptr<Module> m,
              const std::string& filename,
-             const ExtraFilesMap& _extra_files = ExtraFilesMap()) {
-            m->save(filename, _extra_files);
+             const ExtraFilesMap& _extra_files = ExtraFilesMap(),
+             bool _save_optimized_plans = false) {
+            m->save(filename, _extra_files, _save_optimized_plans);
           },
           py::arg("filename"),
-          py::arg("_extra_files") = ExtraFilesMap())
+          py::arg("_extra_files") = ExtraFilesMap(),
+          py::arg("_save_optimized_plans") = false)
       .def(
           "save_to_buffer",
           [](std::shared_ptr<Module> m,
-             const ExtraFilesMap& _extra_files = ExtraFilesMap()) {
+             const ExtraFilesMap& _extra_files = ExtraFilesMap(),
+             bool _save_optimized_plans = false) {
             std::ostringstream buf;
-            m->save(buf, _extra_files);
+            m->save(buf, _extra_files, _save_optimized_plans);
             return py::bytes(buf.str());
           },
-          py::arg("_extra_files") = ExtraFilesMap())
+          py::arg("_extra_files") = ExtraFilesMap(),
+          py::arg("_save_optimized_plans") = false)
       .def("_set_optimized", &Module::set_optimized)
       .def(
           "_define",
@@ -579,15 +585,30 @@ void initJitScriptBindings(PyObject* module) {
       [](ModuleLookup module_lookup,
          const std::string& filename,
          py::object map_location,
-         ExtraFilesMap& extra_files) {
+         ExtraFilesMap& extra_files,
+         bool mmap) {
         c10::optional<at::Device> optional_device;
         if (!map_location.is(py::none())) {
           AT_ASSERT(THPDevice_Check(map_location.ptr()));
           optional_device =
               reinterpret_cast<THPDevice*>(map_location.ptr())->device;
         }
-        import_ir_module(module_lookup, filename, optional_device, extra_files);
-      });
+        if (mmap) {
+          import_ir_module(
+              module_lookup,
+              torch::make_unique<caffe2::serialize::MmapFileAdapter>(filename),
+              optional_device,
+              extra_files);
+        } else {
+          import_ir_module(
+              module_lookup, filename, optional_device, extra_files);
+        }
+      },
+      py::arg("module_lookup"),
+      py::arg("filename"),
+      py::arg("map_location"),
+      py::arg("extra_files"),
+      py::arg("mmap") = false);
   m.def(
       "import_ir_module_from_buffer",
       [](ModuleLookup module_lookup,
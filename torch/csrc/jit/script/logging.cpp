@@ -1,5 +1,8 @@
 #include <torch/csrc/jit/script/logging.h>
 
+#include <c10/util/Metrics.h>
+
+#include <algorithm>
 #include <atomic>
 #include <mutex>
 #include <unordered_map>
@@ -42,6 +45,20 @@ void LockingLogger::setAggregationType(
   agg_types[stat_name] = type;
 }
 
+void MetricsLogger::addStatValue(const std::string& stat_name, int64_t val) {
+  // Looking a counter up in the registry takes its lock, so every thread
+  // keeps the counters it has used.
+  thread_local std::unordered_map<std::string, c10::metrics::Counter*>
+      counters;
+  auto& counter = counters[stat_name];
+  if (!counter) {
+    std::string name = stat_name;
+    std::replace(name.begin(), name.end(), '.', '_');
+    counter = c10::metrics::MetricsRegistry::get().counter(
+        name + "_total", "JIT statistic " + stat_name + ".");
+  }
+  counter->add(val);
+}
 
 std::atomic<LoggerBase*> global_logger{new NoopLogger()};
 
@@ -55,6 +55,16 @@ class TORCH_API LockingLogger : public LoggerBase {
   std::unordered_map<std::string, AggregationType> agg_types;
 };
 
+// Adds the statistics to counters of c10::metrics::MetricsRegistry, so they
+// are exported with the other metrics of the process. The counter of a stat
+// is named after it, with dots replaced by underscores and a `_total`
+// suffix, e.g. pytorch_runtime_graph_executor_invocations_total.
+class TORCH_API MetricsLogger : public LoggerBase {
+ public:
+  void addStatValue(const std::string& stat_name, int64_t val) override;
+  ~MetricsLogger() {}
+};
+
 // Make this struct so the timer internals are opaque to the user.
 struct JITTimePoint {
   std::chrono::time_point<std::chrono::high_resolution_clock> point;
@@ -1,8 +1,12 @@
 #include <torch/csrc/jit/script/module.h>
+#include <c10/core/thread_pool.h>
 #include <c10/util/Exception.h>
+#include <torch/csrc/autograd/grad_mode.h>
+#include <torch/csrc/jit/constants.h>
 #include <torch/csrc/jit/export.h>
 #include <torch/csrc/jit/operator.h>
 #include <torch/csrc/jit/passes/dead_code_elimination.h>
+#include <torch/csrc/jit/passes/freeze_module.h>
 #include <torch/csrc/jit/script/compiler.h>
 #include <torch/csrc/jit/script/error_report.h>
 #include <torch/csrc/jit/script/schema_matching.h>
@@ -91,14 +95,18 @@ void Module::to(at::Device device, bool non_blocking) {
   to_impl(device, /*dtype=*/c10::nullopt, non_blocking);
 }
 
-void Module::save(std::ostream& out, const ExtraFilesMap& extra_files) {
-  ExportModule(*this, out, extra_files);
+void Module::save(
+    std::ostream& out,
+    const ExtraFilesMap& extra_files,
+    bool save_optimized_plans) {
+  ExportModule(*this, out, extra_files, save_optimized_plans);
 }
 
 void Module::save(
     const std::string& filename,
-    const ExtraFilesMap& extra_files) {
-  ExportModule(*this, filename, extra_files);
+    const ExtraFilesMap& extra_files,
+    bool save_optimized_plans) {
+  ExportModule(*this, filename, extra_files, save_optimized_plans);
 }
 
 void module_state_to(
@@ -263,6 +271,74 @@ Method::Method(Module* owner, Function* first_class_function)
       owner->lower_first_class_method(first_class_function);
 }
 
+c10::intrusive_ptr<c10::ivalue::Future> Method::warmup_async(
+    std::vector<IValue> inputs,
+    const Kwargs& kwargs) {
+  getSchema().checkAndNormalizeInputs(inputs, kwargs);
+  for (auto input : initial_ivalues_) {
+    push(inputs, input.value());
+  }
+  auto future = c10::make_intrusive<c10::ivalue::Future>();
+  std::shared_ptr<Function> function = function_;
+  bool grad_enabled = autograd::GradMode::is_enabled();
+  c10::global_work_queue().run([future, function, inputs, grad_enabled]() {
+    try {
+      autograd::AutoGradMode grad_mode(grad_enabled);
+      function->get_executor().warmup(inputs);
+    } catch (const std::exception& e) {
+      future->markCompleted(
+          c10::ivalue::Future::FutureError(std::string(e.what())));
+      return;
+    }
+    future->markCompleted(IValue());
+  });
+  return future;
+}
+
+void Method::freeze() {
+  auto graph = function_->graph()->copy();
+  const auto& arguments = function_->getSchema().arguments();
+  const size_t offset = graph->inputs().size() - initial_ivalues_.size();
+  AT_ASSERT(arguments.size() == graph->inputs().size());
+
+  std::vector<Argument> frozen_arguments(
+      arguments.begin(), arguments.begin() + offset);
+  std::vector<Slot> remaining_ivalues;
+  std::vector<size_t> frozen_inputs;
+  WithInsertPoint guard(*graph->nodes().begin());
+  for (size_t i = 0; i < initial_ivalues_.size(); ++i) {
+    Value* input = graph->inputs().at(offset + i);
+    IValue value = initial_ivalues_[i].value();
+    c10::optional<Value*> constant;
+    if (value.isTensor() && value.toTensor().is_variable()) {
+      // parameters require grad, constants can't
+      constant = tryInsertConstant(
+          *graph, autograd::as_variable_ref(value.toTensor()).detach());
+    } else if (!value.isTensorList()) {
+      constant = tryInsertConstant(*graph, value, input->type());
+    }
+    if (constant) {
+      input->replaceAllUsesWith(*constant);
+      frozen_inputs.push_back(offset + i);
+    } else {
+      frozen_arguments.push_back(arguments.at(offset + i));
+      remaining_ivalues.push_back(initial_ivalues_[i]);
+    }
+  }
+  for (auto it = frozen_inputs.rbegin(); it != frozen_inputs.rend(); ++it) {
+    graph->eraseInput(*it);
+  }
+  FoldFrozenWeights(graph);
+
+  CompilationUnit cu;
+  cu.set_optimized(function_->is_optimized());
+  std::shared_ptr<Function> frozen = cu.create_function(name(), graph);
+  frozen->setSchema(
+      function_->getSchema().cloneWithArguments(std::move(frozen_arguments)));
+  function_ = std::move(frozen);
+  initial_ivalues_ = std::move(remaining_ivalues);
+}
+
 void Module::define(const std::string& src, const ResolverPtr& resolver) {
   class_compilation_unit().define(
       src,
@@ -86,10 +86,23 @@ struct TORCH_API Method {
     return stack.front();
   }
 
+  // Optimizes this method for inputs like `inputs` on the inter-op thread
+  // pool (see GraphExecutor::warmup), using the caller's grad mode. The
+  // returned future completes with None once the plan is ready, or with the
+  // error that stopped it.
+  c10::intrusive_ptr<c10::ivalue::Future> warmup_async(
+      std::vector<IValue> inputs,
+      const Kwargs& kwargs = Kwargs());
+
   const std::vector<Slot>& initial_ivalues() const {
     return initial_ivalues_;
   }
 
+  // Replaces the initial_ivalues() that can be constants with constants of
+  // their current values, and folds the computations on them (see
+  // FreezeModule).
+  void freeze();
+
   std::shared_ptr<Graph> graph() const {
     return function_->graph();
   }
@@ -392,13 +405,18 @@ struct TORCH_API Module {
     return get_method(method_name)({IValue(std::forward<Types>(args))...});
   }
 
+  // With save_optimized_plans, the plans the methods optimized so far (e.g.
+  // by warmup_async) are saved too, and they run after loading the module
+  // without being optimized again (see GraphExecutor::optimizedPlans).
   void save(
       std::ostream& out,
-      const ExtraFilesMap& extra_files = ExtraFilesMap());
+      const ExtraFilesMap& extra_files = ExtraFilesMap(),
+      bool save_optimized_plans = false);
 
   void save(
       const std::string& filename,
-      const ExtraFilesMap& extra_files = ExtraFilesMap());
+      const ExtraFilesMap& extra_files = ExtraFilesMap(),
+      bool save_optimized_plans = false);
 
   void copy_into(
       const ModuleLookup& module_lookup,
@@ -1,6 +1,7 @@
 #include <torch/csrc/jit/script/python_sugared_value.h>
 #include <torch/csrc/Dtype.h>
 #include <torch/csrc/Layout.h>
+#include <torch/csrc/MemoryFormat.h>
 #include <torch/csrc/jit/script/module_python.h>
 #include <torch/csrc/jit/script/schema_matching.h>
 #include <memory>
@@ -395,6 +396,10 @@ std::shared_ptr<SugaredValue> toSugaredValue(
       auto layout = reinterpret_cast<THPLayout*>(obj.ptr());
       const auto v = static_cast<int64_t>(layout->layout);
       return toSimple(g.insertConstant(v, nullptr, loc));
+    } else if (THPMemoryFormat_Check(obj.ptr())) {
+      auto memory_format = reinterpret_cast<THPMemoryFormat*>(obj.ptr());
+      const auto v = static_cast<int64_t>(memory_format->memory_format);
+      return toSimple(g.insertConstant(v, nullptr, loc));
     } else if (THPDtype_Check(obj.ptr())) {
       auto dtype = reinterpret_cast<THPDtype*>(obj.ptr());
       const auto v = static_cast<int64_t>(dtype->scalar_type);
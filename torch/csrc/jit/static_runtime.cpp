@@ -0,0 +1,199 @@
+#include <torch/csrc/jit/static_runtime.h>
+
+#include <torch/csrc/autograd/grad_mode.h>
+#include <torch/csrc/autograd/variable.h>
+#include <torch/csrc/jit/constants.h>
+#include <torch/csrc/jit/passes/constant_propagation.h>
+#include <torch/csrc/jit/passes/dead_code_elimination.h>
+#include <torch/csrc/jit/passes/memory_planning.h>
+#include <torch/csrc/jit/passes/shape_analysis.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+// Replaces the trailing inputs of `forward` that carry the module's
+// parameters and attributes with constants.
+std::shared_ptr<Graph> freezeForward(const script::Module& module) {
+  const auto& method = module.get_method("forward");
+  auto graph = method.graph()->copy();
+  const auto& slots = method.initial_ivalues();
+  const size_t num_inputs = graph->inputs().size() - slots.size();
+
+  WithInsertPoint guard(graph->nodes().front());
+  for (size_t i = 0; i < slots.size(); ++i) {
+    IValue value = slots[i].value();
+    if (value.isTensor() && value.toTensor().is_variable()) {
+      value = autograd::as_variable_ref(value.toTensor()).detach();
+    }
+    auto constant = tryInsertConstant(*graph, value);
+    AT_CHECK(
+        constant,
+        "StaticRuntime cannot freeze module attribute of kind ",
+        value.tagKind());
+    graph->inputs().at(num_inputs + i)->replaceAllUsesWith(*constant);
+  }
+  for (size_t i = slots.size(); i > 0; --i) {
+    graph->eraseInput(num_inputs + i - 1);
+  }
+  return graph;
+}
+
+} // namespace
+
+StaticRuntime::StaticRuntime(
+    const script::Module& module,
+    const std::vector<at::Tensor>& example_inputs)
+    : StaticRuntime(freezeForward(module), example_inputs) {}
+
+StaticRuntime::StaticRuntime(
+    std::shared_ptr<Graph> graph,
+    const std::vector<at::Tensor>& example_inputs)
+    : graph_(graph->copy()) {
+  if (!example_inputs.empty()) {
+    AT_CHECK(
+        example_inputs.size() == graph_->inputs().size(),
+        "StaticRuntime expected ",
+        graph_->inputs().size(),
+        " example inputs, got ",
+        example_inputs.size());
+    for (size_t i = 0; i < example_inputs.size(); ++i) {
+      graph_->inputs()[i]->setType(
+          CompleteTensorType::create(example_inputs[i]));
+    }
+    PropagateInputShapes(graph_);
+  }
+  ConstantPropagation(graph_);
+  EliminateDeadCode(graph_);
+  if (!example_inputs.empty()) {
+    MemoryPlanning(graph_);
+  }
+
+  std::unordered_map<const Value*, size_t> registers;
+  auto registerFor = [&](const Value* v) {
+    auto it = registers.find(v);
+    if (it == registers.end()) {
+      it = registers.emplace(v, registers.size()).first;
+    }
+    return it->second;
+  };
+  for (auto input : graph_->inputs()) {
+    registerFor(input);
+  }
+  num_inputs_ = graph_->inputs().size();
+
+  // position of the last node using each value; graph outputs are used by
+  // the return node, which comes after every node
+  std::unordered_map<const Value*, size_t> last_use;
+  size_t position = 0;
+  for (auto node : graph_->nodes()) {
+    for (auto input : node->inputs()) {
+      last_use[input] = position;
+    }
+    position++;
+  }
+  for (auto output : graph_->outputs()) {
+    last_use[output] = position;
+  }
+
+  position = 0;
+  for (auto node : graph_->nodes()) {
+    AT_CHECK(
+        node->blocks().empty(),
+        "StaticRuntime only supports graphs without control flow, found ",
+        node->kind().toQualString());
+    if (node->kind() == prim::Constant) {
+      if (auto value = toIValue(node->output())) {
+        constants_.emplace_back(registerFor(node->output()), std::move(*value));
+        position++;
+        continue;
+      }
+    }
+
+    ProcessedNode processed;
+    processed.op = getOperation(node);
+    const auto inputs = node->inputs();
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      Value* input = inputs[i];
+      processed.inputs.push_back(registerFor(input));
+      bool used_later_in_node = std::find(
+          inputs.begin() + i + 1, inputs.end(), input) != inputs.end();
+      bool is_constant = input->node()->kind() == prim::Constant;
+      processed.move_inputs.push_back(
+          last_use.at(input) == position && !used_later_in_node &&
+          !is_constant);
+    }
+    for (auto output : node->outputs()) {
+      processed.outputs.push_back(registerFor(output));
+      if (!last_use.count(output)) {
+        processed.unused_outputs.push_back(registerFor(output));
+      }
+    }
+    nodes_.push_back(std::move(processed));
+    position++;
+  }
+  for (auto output : graph_->outputs()) {
+    outputs_.push_back(registerFor(output));
+  }
+  num_registers_ = registers.size();
+}
+
+void StaticRuntime::run(Stack& stack) const {
+  AT_CHECK(
+      stack.size() == num_inputs_,
+      "StaticRuntime expected ",
+      num_inputs_,
+      " inputs, got ",
+      stack.size());
+  autograd::AutoGradMode no_grad(false);
+
+  std::vector<IValue> registers(num_registers_);
+  for (size_t i = 0; i < num_inputs_; ++i) {
+    registers[i] = std::move(stack[i]);
+  }
+  for (const auto& constant : constants_) {
+    registers[constant.first] = constant.second;
+  }
+  stack.clear();
+
+  for (const auto& node : nodes_) {
+    for (size_t i = 0; i < node.inputs.size(); ++i) {
+      auto& reg = registers[node.inputs[i]];
+      if (node.move_inputs[i]) {
+        stack.push_back(std::move(reg));
+      } else {
+        stack.push_back(reg);
+      }
+    }
+    node.op(stack);
+    for (size_t i = node.outputs.size(); i > 0; --i) {
+      registers[node.outputs[i - 1]] = pop(stack);
+    }
+    for (size_t reg : node.unused_outputs) {
+      registers[reg] = IValue();
+    }
+  }
+
+  for (size_t reg : outputs_) {
+    stack.push_back(registers[reg]);
+  }
+}
+
+std::vector<at::Tensor> StaticRuntime::run(
+    const std::vector<at::Tensor>& inputs) const {
+  Stack stack(inputs.begin(), inputs.end());
+  run(stack);
+  std::vector<at::Tensor> outputs;
+  outputs.reserve(stack.size());
+  for (auto& output : stack) {
+    outputs.push_back(std::move(output).toTensor());
+  }
+  return outputs;
+}
+
+} // namespace jit
+} // namespace torch
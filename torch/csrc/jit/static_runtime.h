@@ -0,0 +1,65 @@
+#pragma once
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/csrc/jit/ir.h>
+#include <torch/csrc/jit/operator.h>
+#include <torch/csrc/jit/script/module.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace torch {
+namespace jit {
+
+// Runs a straight-line graph for inference without the machinery of
+// GraphExecutor: no ArgumentSpec lookup, no autograd subgraphs, no profiling
+// and no re-specialization.
+//
+// Operators are resolved once at construction, values live in a flat
+// register file and are released after their last use. When example inputs
+// are given, the graph is specialized to their shapes and intermediates are
+// written through out= variants into a reused arena (see MemoryPlanning);
+// the runtime must then only be called with inputs of those shapes.
+//
+// For modules, the parameters and attributes of `forward` are frozen into
+// the graph as constants, so later updates to the module are not seen.
+class TORCH_API StaticRuntime {
+ public:
+  explicit StaticRuntime(
+      std::shared_ptr<Graph> graph,
+      const std::vector<at::Tensor>& example_inputs = {});
+  explicit StaticRuntime(
+      const script::Module& module,
+      const std::vector<at::Tensor>& example_inputs = {});
+
+  // Takes the inputs from the stack and leaves the outputs on it.
+  // Thread-safe; runs with grad mode disabled.
+  void run(Stack& stack) const;
+  std::vector<at::Tensor> run(const std::vector<at::Tensor>& inputs) const;
+
+  const std::shared_ptr<Graph>& graph() const {
+    return graph_;
+  }
+
+ private:
+  struct ProcessedNode {
+    Operation op;
+    std::vector<size_t> inputs;
+    // whether each input is the last use of its register
+    std::vector<bool> move_inputs;
+    std::vector<size_t> outputs;
+    // registers of outputs that are never used
+    std::vector<size_t> unused_outputs;
+  };
+
+  std::shared_ptr<Graph> graph_;
+  std::vector<ProcessedNode> nodes_;
+  std::vector<std::pair<size_t, IValue>> constants_;
+  std::vector<size_t> outputs_;
+  size_t num_inputs_;
+  size_t num_registers_;
+};
+
+} // namespace jit
+} // namespace torch
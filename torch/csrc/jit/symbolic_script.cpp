@@ -402,11 +402,13 @@ const std::vector<std::string> functions = {
 
             return torch._dim_arange(like, dim), backward
 
-        def contiguous(self):
+        def contiguous(self,
+                       *,
+                       memory_format: int=1):
             def backward(grad_output):
-                return grad_output
+                return grad_output, None
 
-            return self.contiguous(), backward
+            return self.contiguous(memory_format=memory_format), backward
 
         def dot(self, tensor):
             def backward(grad_output):
@@ -1055,53 +1057,36 @@ const std::vector<std::string> functions = {
 
             input_ndim = input.dim()
             normalized_ndim = len(normalized_shape)
-            n = 1
+            M = 1
             for i in range(input_ndim - normalized_ndim):
-                n *= input.size(i)
-
-            input_reshape = input.contiguous().view(1, n, -1)
-
-            bn_out, save1, save2, impl_idx = torch._batch_norm_impl_index(
-                input_reshape, None, None, None, None, True,
-                0.0, eps, cudnn_enable)
+                M *= input.size(i)
+            N = 1
+            for i in range(normalized_ndim):
+                N *= normalized_shape[i]
 
-            bn_out = bn_out.view(input.size())
-            if weight is not None and bias is not None:
-                output = bias.addcmul(bn_out, weight, value=1)
-            elif weight is not None:
-                output = bn_out.mul(weight)
-            elif bias is not None:
-                output = bn_out.add(bias)
+            has_weight = weight is not None
+            has_bias = bias is not None
+            if weight is not None:
+                weight_reshape = weight.reshape([N])
             else:
-                output = bn_out
-
-            def backward(grad_output):
-                if weight is not None and bias is not None:
-                    grad_bn_out = grad_output * weight
-                    grad_weight = (grad_output * bn_out)._grad_sum_to_size(weight.size())
-                    grad_bias = grad_output._grad_sum_to_size(bias.size())
-                elif weight is not None:
-                    grad_bn_out = grad_output * weight
-                    grad_weight = (grad_output * bn_out)._grad_sum_to_size(weight.size())
-                    grad_bias = None
-                elif bias is not None:
-                    grad_bn_out = grad_output
-                    grad_weight= None
-                    grad_bias = grad_output._grad_sum_to_size(bias.size())
-                else:
-                    grad_bn_out = grad_output
-                    grad_weight= None
-                    grad_bias = None
-
-
-                grad_bn_out = grad_bn_out.contiguous().view(1, n, -1)
+                weight_reshape = None
+            if bias is not None:
+                bias_reshape = bias.reshape([N])
+            else:
+                bias_reshape = None
 
-                grad_input, _, _ = torch._batch_norm_impl_index_backward(
-                    impl_idx, input_reshape, grad_bn_out, None, None, None,
-                    save1, save2, True, eps, [True, False, False])
+            output, mean, rstd = torch.native_layer_norm(
+                input, weight_reshape, bias_reshape, M, N, eps)
 
-                grad_input = grad_input.view(input.size())
-                return grad_input, None, grad_weight, grad_bias, None, None
+            def backward(grad_output):
+                dinput, dweight, dbias = torch.native_layer_norm_backward(
+                    grad_output, input, mean, rstd, weight_reshape, M, N,
+                    [True, has_weight, has_bias])
+                if weight is not None:
+                    dweight = dweight.reshape(weight.size())
+                if bias is not None:
+                    dbias = dbias.reshape(bias.size())
+                return dinput, None, dweight, dbias, None, None
 
             return output, backward
 
@@ -446,6 +446,21 @@ void addInputs(Node* n, const char* name, at::Device value) {
 void addInputs(Node* n, const char* name, at::Layout value) {
   detail::genericAddInput(n, static_cast<int64_t>(value));
 }
+void addInputs(Node* n, const char* name, at::MemoryFormat value) {
+  detail::genericAddInput(n, static_cast<int64_t>(value));
+}
+void addInputs(
+    Node* n,
+    const char* name,
+    const c10::optional<at::MemoryFormat>& value) {
+  if (value) {
+    detail::genericAddInput(n, static_cast<int64_t>(*value));
+  } else {
+    Graph* g = n->owningGraph();
+    Value* none = g->insertNode(g->createNone(IntType::get()))->output();
+    n->addInput(none);
+  }
+}
 void addInputs(Node* n, const char* name, at::ScalarType value) {
   detail::genericAddInput(n, static_cast<int64_t>(value));
 }
@@ -47,6 +47,7 @@
 #include <torch/csrc/DynamicTypes.h>
 #include <torch/csrc/Exceptions.h>
 #include <torch/csrc/Generator.h>
+#include <torch/csrc/MemoryFormat.h>
 #include <torch/csrc/autograd/python_variable.h>
 #include <torch/csrc/jit/tracer.h>
 #include <torch/csrc/tensor/python_tensor.h>
@@ -70,7 +71,7 @@ namespace torch {
 
 enum class ParameterType {
   TENSOR, SCALAR, INT64, DOUBLE, TENSOR_LIST, INT_LIST, GENERATOR,
-  BOOL, STORAGE, PYOBJECT, SCALARTYPE, LAYOUT, DEVICE, STRING
+  BOOL, STORAGE, PYOBJECT, SCALARTYPE, LAYOUT, MEMORY_FORMAT, DEVICE, STRING
 };
 
 struct FunctionParameter;
@@ -131,6 +132,8 @@ struct PythonArgs {
   inline c10::optional<bool> toBoolOptional(int i);
   inline const THPLayout& layout(int i);
   inline const THPLayout& layoutWithDefault(int i, const THPLayout& default_layout);
+  inline at::MemoryFormat memoryformat(int i);
+  inline c10::optional<at::MemoryFormat> memoryformatOptional(int i);
   inline at::Device device(int i);
   inline at::Device deviceWithDefault(int i, const at::Device& default_device);
   inline c10::optional<at::Device> deviceOptional(int i);
@@ -185,6 +188,7 @@ struct FunctionParameter {
     double default_double;
     at::ScalarType default_scalartype;
     THPLayout* default_layout;
+    at::MemoryFormat default_memoryformat;
   };
 };
 
@@ -353,6 +357,17 @@ inline const THPLayout& PythonArgs::layoutWithDefault(int i, const THPLayout& de
   return layout(i);
 }
 
+inline at::MemoryFormat PythonArgs::memoryformat(int i) {
+  if (!args[i]) return signature.params[i].default_memoryformat;
+  return reinterpret_cast<THPMemoryFormat*>(args[i])->memory_format;
+}
+
+inline c10::optional<at::MemoryFormat> PythonArgs::memoryformatOptional(int i) {
+  if (!args[i])
+    return c10::nullopt;
+  return memoryformat(i);
+}
+
 static std::string cuda_str = "cuda";
 static std::string cpu_str = "cpu";
 static std::string cuda_prefix = "cuda:";
@@ -43,6 +43,8 @@ static std::pair<std::string, std::string> getDtypeNames(
       return std::make_pair("bool", "");
     case at::ScalarType::QInt8:
       return std::make_pair("qint8", "");
+    case at::ScalarType::BFloat16:
+      return std::make_pair("bfloat16", "");
     default:
       throw std::runtime_error("Unimplemented scalar type");
   }
@@ -6,9 +6,10 @@ from datetime import timedelta
 # This module is wildcard imported from torch.distributed.
 # TODO: specify __all__
 
-from .rendezvous import rendezvous, register_rendezvous_handler  # noqa: F401
+from .rendezvous import rendezvous, register_rendezvous_handler, ElasticRendezvous  # noqa: F401
 from . import (
     AllreduceOptions,
+    AllToAllOptions,
     BroadcastOptions,
     GatherOptions,
     ReduceOptions,
@@ -17,6 +18,9 @@ from . import (
 )
 from . import ReduceOp
 from . import PrefixStore
+from . import _allreduce_coalesced
+from . import _broadcast_coalesced
+from . import _reduce_coalesced
 
 
 _MPI_AVAILABLE = True
@@ -352,7 +356,9 @@ def init_process_group(backend,
                                 Mutually exclusive with ``init_method``.
         timeout (timedelta, optional): Timeout for operations executed against
             the process group. Default value equals 30 minutes.
-            This is only applicable for the ``gloo`` backend.
+            This is applicable for the ``gloo`` backend, and for the ``nccl``
+            backend, whose operations fail and abort their communicators
+            when they run for longer.
         group_name (str, optional, deprecated): Group name.
 
     To enable ``backend == Backend.MPI``, PyTorch needs to built from source
@@ -492,7 +498,8 @@ def _new_process_group_helper(world_size,
                 prefix_store,
                 rank,
                 world_size,
-                group_name)
+                group_name,
+                timeout=timeout)
             _pg_map[pg] = (Backend.NCCL, store)
             _pg_names[pg] = group_name
         else:
@@ -814,6 +821,54 @@ def broadcast(tensor,
         work.wait()
 
 
+def broadcast_coalesced(tensors,
+                        src,
+                        group=group.WORLD,
+                        async_op=False,
+                        bucket_size=25 * 1024 * 1024):
+    """
+    Broadcasts each tensor in a list to the whole group, like calling
+    :func:`broadcast` on every tensor, but with one collective per bucket
+    of tensors instead of one per tensor.
+
+    Tensors are grouped by type and device into buckets of about
+    ``bucket_size`` bytes, and each bucket is flattened into a single
+    buffer and broadcast.
+
+    Arguments:
+        tensors (List[Tensor]): Data to be sent if ``src`` is the rank of
+            current process, and tensors to be used to save received data
+            otherwise.
+        src (int): Source rank.
+        group (ProcessGroup, optional): The process group to work on
+        async_op (bool, optional): Whether this op should be an async op
+        bucket_size (int, optional): Maximum size in bytes of a bucket
+
+    Returns:
+        Async work handle, if async_op is set to True.
+        None, if not async_op or if not part of the group
+
+    """
+    _check_tensor_list(tensors, "tensors")
+    if _rank_not_in_group(group):
+        return
+
+    opts = BroadcastOptions()
+    opts.rootRank = src
+    opts.rootTensor = 0
+
+    if group == GroupMember.WORLD:
+        _check_default_pg()
+        work = _broadcast_coalesced(_default_pg, tensors, bucket_size, opts)
+    else:
+        opts.rootRank = _get_group_rank(group, src)
+        work = _broadcast_coalesced(group, tensors, bucket_size, opts)
+    if async_op:
+        return work
+    else:
+        work.wait()
+
+
 def all_reduce_multigpu(tensor_list,
                         op=ReduceOp.SUM,
                         group=group.WORLD,
@@ -907,6 +962,53 @@ def all_reduce(tensor,
         work.wait()
 
 
+def all_reduce_coalesced(tensors,
+                         op=ReduceOp.SUM,
+                         group=group.WORLD,
+                         async_op=False,
+                         bucket_size=25 * 1024 * 1024):
+    """
+    Reduces each tensor in a list across all machines, like calling
+    :func:`all_reduce` on every tensor, but with one collective per bucket
+    of tensors instead of one per tensor.
+
+    Tensors are grouped by type and device into buckets of about
+    ``bucket_size`` bytes, each bucket is flattened into a single buffer and
+    reduced, and the results are copied back into ``tensors``.
+
+    Arguments:
+        tensors (List[Tensor]): Input and output of the collective. The
+            function operates in-place.
+        op (optional): One of the values from
+            ``torch.distributed.ReduceOp``
+            enum.  Specifies an operation used for element-wise reductions.
+        group (ProcessGroup, optional): The process group to work on
+        async_op (bool, optional): Whether this op should be an async op
+        bucket_size (int, optional): Maximum size in bytes of a bucket
+
+    Returns:
+        Async work handle, if async_op is set to True.
+        None, if not async_op or if not part of the group
+
+    """
+    _check_tensor_list(tensors, "tensors")
+    if _rank_not_in_group(group):
+        return
+
+    opts = AllreduceOptions()
+    opts.reduceOp = op
+    if group == GroupMember.WORLD:
+        _check_default_pg()
+        work = _allreduce_coalesced(_default_pg, tensors, bucket_size, opts)
+    else:
+        work = _allreduce_coalesced(group, tensors, bucket_size, opts)
+
+    if async_op:
+        return work
+    else:
+        work.wait()
+
+
 def reduce_multigpu(tensor_list,
                     dst,
                     op=ReduceOp.SUM,
@@ -1011,6 +1113,60 @@ def reduce(tensor,
         work.wait()
 
 
+def reduce_coalesced(tensors,
+                     dst,
+                     op=ReduceOp.SUM,
+                     group=group.WORLD,
+                     async_op=False,
+                     bucket_size=25 * 1024 * 1024):
+    """
+    Reduces each tensor in a list across all machines, like calling
+    :func:`reduce` on every tensor, but with one collective per bucket of
+    tensors instead of one per tensor.
+
+    Tensors are grouped by type and device into buckets of about
+    ``bucket_size`` bytes, each bucket is flattened into a single buffer and
+    reduced, and the results are copied back into ``tensors`` on process
+    ``dst``. The tensors of the other processes are unchanged.
+
+    Arguments:
+        tensors (List[Tensor]): Input and output of the collective. The
+            function operates in-place.
+        dst (int): Destination rank
+        op (optional): One of the values from
+            ``torch.distributed.ReduceOp``
+            enum.  Specifies an operation used for element-wise reductions.
+        group (ProcessGroup, optional): The process group to work on
+        async_op (bool, optional): Whether this op should be an async op
+        bucket_size (int, optional): Maximum size in bytes of a bucket
+
+    Returns:
+        Async work handle, if async_op is set to True.
+        None, if not async_op or if not part of the group
+
+    """
+    _check_tensor_list(tensors, "tensors")
+    if _rank_not_in_group(group):
+        return
+
+    opts = ReduceOptions()
+    opts.reduceOp = op
+    opts.rootRank = dst
+    opts.rootTensor = 0
+
+    if group == GroupMember.WORLD:
+        _check_default_pg()
+        work = _reduce_coalesced(_default_pg, tensors, bucket_size, opts)
+    else:
+        opts.rootRank = _get_group_rank(group, dst)
+        work = _reduce_coalesced(group, tensors, bucket_size, opts)
+
+    if async_op:
+        return work
+    else:
+        work.wait()
+
+
 def all_gather_multigpu(output_tensor_lists,
                         input_tensor_list,
                         group=group.WORLD,
@@ -1334,6 +1490,55 @@ def reduce_scatter(output,
         work.wait()
 
 
+def all_to_all_single(output,
+                      input,
+                      output_split_sizes=None,
+                      input_split_sizes=None,
+                      group=group.WORLD,
+                      async_op=False):
+    """
+    Splits input along its first dimension and scatters the splits to all
+    processes in a group, then gathers the splits received from all processes
+    into output.
+
+    Arguments:
+        output (Tensor): Gathered and concatenated output tensor.
+        input (Tensor): Input tensor to scatter.
+        output_split_sizes (list[int], optional): Number of rows of output
+            received from each process. ``None`` splits output equally.
+        input_split_sizes (list[int], optional): Number of rows of input
+            sent to each process. ``None`` splits input equally.
+        group (ProcessGroup, optional): The process group to work on.
+        async_op (bool, optional): Whether this op should be an async op.
+
+    Returns:
+        Async work handle, if async_op is set to True.
+        None, if not async_op or if not part of the group.
+
+    """
+    _check_single_tensor(output, "output")
+    _check_single_tensor(input, "input")
+    if _rank_not_in_group(group):
+        return
+
+    opts = AllToAllOptions()
+    output_split_sizes = [] if output_split_sizes is None else output_split_sizes
+    input_split_sizes = [] if input_split_sizes is None else input_split_sizes
+
+    if group == GroupMember.WORLD:
+        _check_default_pg()
+        work = _default_pg.alltoall(
+            output, input, output_split_sizes, input_split_sizes, opts)
+    else:
+        work = group.alltoall(
+            output, input, output_split_sizes, input_split_sizes, opts)
+
+    if async_op:
+        return work
+    else:
+        work.wait()
+
+
 def barrier(group=group.WORLD,
             async_op=False):
     """
@@ -1378,7 +1583,9 @@ def new_group(ranks=None, timeout=_default_pg_timeout, backend=None):
         ranks (list[int]): List of ranks of group members.
         timeout (timedelta, optional): Timeout for operations executed against
             the process group. Default value equals 30 minutes.
-            This is only applicable for the ``gloo`` backend.
+            This is applicable for the ``gloo`` backend, and for the ``nccl``
+            backend, whose operations fail and abort their communicators
+            when they run for longer.
         backend (str or Backend, optional): The backend to use. Depending on
             build-time configurations, valid values are ``gloo`` and ``nccl``.
             By default uses the same backend as the global group. This field
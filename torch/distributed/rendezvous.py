@@ -4,7 +4,13 @@ except ImportError:
     from urlparse import urlparse
 
 import os
-from . import FileStore, TCPStore
+import time
+from datetime import timedelta
+from . import FileStore, PrefixStore, TCPStore
+try:
+    from . import RedisStore
+except ImportError:
+    RedisStore = None
 
 
 _rendezvous_handlers = {}
@@ -147,6 +153,160 @@ def _env_rendezvous_handler(url):
     raise RuntimeError("Unable to perform rerendezvous using env:// method")
 
 
+def _redis_rendezvous_handler(url):
+    def _error(msg):
+        return _rendezvous_error("redis:// rendezvous: " + msg)
+
+    result = urlparse(url)
+    if not result.port:
+        raise _error("port number missing")
+    query = dict(pair.split("=") for pair in filter(None, result.query.split("&")))
+    if "rank" not in query:
+        raise _error("rank parameter missing")
+    if "world_size" not in query:
+        raise _error("world size parameter missing")
+
+    rank = int(query["rank"])
+    world_size = int(query["world_size"])
+    # The jobs sharing a server need a prefix of their own
+    store = RedisStore(result.hostname, result.port, query.get("prefix", ""))
+    yield (store, rank, world_size)
+
+    # If this configuration is invalidated, there is nothing we can do about it
+    raise RuntimeError("Unable to perform rerendezvous using redis:// method")
+
+
+class ElasticRendezvous(object):
+    """Rendezvous of a changing set of processes over a shared store.
+
+    Every call to :meth:`next_rendezvous` takes part in a round, which
+    closes once ``max_size`` processes joined it, or ``last_call_timeout``
+    after ``min_size`` did. The processes of a round get the ranks
+    ``0 .. world_size - 1`` in the order they joined, and a store of their
+    own, from which they can build new process groups, without the keys of
+    older rounds in the way.
+
+    When a process of the job fails, the others can call
+    :meth:`next_rendezvous` again to agree on the new membership and rebuild
+    their process groups in-process, keeping their state in memory instead
+    of restarting the job. The processes which join after a round closed
+    take part in the next one, so a job can admit them by re-rendezvousing
+    when :meth:`num_waiting` isn't 0.
+
+    The store must outlive all the processes, e.g. a :class:`TCPStore`
+    whose server isn't one of the processes that may fail, and a process
+    which fails while joining a round is a member of that round.
+
+    Arguments:
+        store (Store): Store shared by all the processes.
+        min_size (int): Number of processes needed to close a round.
+        max_size (int): Number of processes which close a round at once.
+        timeout (timedelta, optional): Time to wait for ``min_size``
+            processes before raising.
+        last_call_timeout (timedelta, optional): Time to wait for more
+            processes once ``min_size`` joined.
+        prefix (str, optional): Prefix of the keys of the rendezvous.
+
+    Example::
+
+        >>> rdzv = ElasticRendezvous(store, min_size=2, max_size=8)
+        >>> while True:
+        >>>     store, rank, world_size = rdzv.next_rendezvous()
+        >>>     dist.init_process_group("gloo", store=store, rank=rank,
+        >>>                             world_size=world_size)
+        >>>     try:
+        >>>         train(model)
+        >>>         break
+        >>>     except RuntimeError:
+        >>>         dist.destroy_process_group()
+    """
+
+    _poll_interval = 0.1
+
+    def __init__(self,
+                 store,
+                 min_size,
+                 max_size,
+                 timeout=timedelta(minutes=10),
+                 last_call_timeout=timedelta(seconds=30),
+                 prefix="elastic"):
+        if min_size < 1 or max_size < min_size:
+            raise ValueError(
+                "Expected 1 <= min_size <= max_size, got min_size={} and "
+                "max_size={}".format(min_size, max_size))
+        # The prefix stores only keep a reference to it
+        self._store = store
+        self.min_size = min_size
+        self.max_size = max_size
+        self.timeout = timeout
+        self.last_call_timeout = last_call_timeout
+        self._prefix = prefix
+        self.round = -1
+        self.rank = -1
+        self.world_size = -1
+
+    def _key(self, round, name):
+        return "{}/{}/{}".format(self._prefix, round, name)
+
+    def _open_round(self):
+        # The round which processes join, which only the process that
+        # closes it advances
+        return self._store.add(self._prefix + "/open", 0)
+
+    def num_waiting(self):
+        """Returns the number of processes waiting for the next round."""
+        return self._store.add(self._key(self._open_round(), "joined"), 0)
+
+    def next_rendezvous(self):
+        """Joins the next round and returns its store, the rank of this
+        process in it and its size."""
+        while True:
+            round = self._open_round()
+            rank = self._store.add(self._key(round, "joined"), 1) - 1
+            world_size = self._wait_closed(round)
+            if rank < world_size:
+                break
+            # The round closed before this process joined
+        self.round = round
+        self.rank = rank
+        self.world_size = world_size
+        store = PrefixStore(self._key(round, "store"), self._store)
+        return (store, rank, world_size)
+
+    def _wait_closed(self, round):
+        joined_key = self._key(round, "joined")
+        closing_key = self._key(round, "closing")
+        size_key = self._key(round, "size")
+        start = time.time()
+        last_call = None
+        while self._store.add(closing_key, 0) == 0:
+            joined = self._store.add(joined_key, 0)
+            now = time.time()
+            if joined >= self.min_size and last_call is None:
+                last_call = now + self.last_call_timeout.total_seconds()
+            if joined >= self.max_size or \
+                    (last_call is not None and now >= last_call):
+                # Only one process closes the round, with the processes
+                # that joined before, and makes the next one open
+                if self._store.add(closing_key, 1) == 1:
+                    world_size = min(self._store.add(joined_key, 0),
+                                     self.max_size)
+                    self._store.set(size_key, str(world_size))
+                    self._store.add(self._prefix + "/open", 1)
+                break
+            if last_call is None and \
+                    now - start >= self.timeout.total_seconds():
+                raise RuntimeError(
+                    "Elastic rendezvous timed out waiting for {} processes, "
+                    "{} joined the round {}".format(
+                        self.min_size, joined, round))
+            time.sleep(self._poll_interval)
+        self._store.wait([size_key])
+        return int(self._store.get(size_key))
+
+
 register_rendezvous_handler("file", _file_rendezvous_handler)
 register_rendezvous_handler("tcp", _tcp_rendezvous_handler)
 register_rendezvous_handler("env", _env_rendezvous_handler)
+if RedisStore is not None:
+    register_rendezvous_handler("redis", _redis_rendezvous_handler)
@@ -73,7 +73,7 @@ def scope(scope_name):
 DEFAULT_EXTRA_FILES_MAP = torch._C.ExtraFilesMap()
 
 
-def load(f, map_location=None, _extra_files=DEFAULT_EXTRA_FILES_MAP):
+def load(f, map_location=None, _extra_files=DEFAULT_EXTRA_FILES_MAP, mmap=False):
     r"""
         Load a ``ScriptModule`` previously saved with :func:`save <torch.jit.save>`
 
@@ -93,6 +93,10 @@ def load(f, map_location=None, _extra_files=DEFAULT_EXTRA_FILES_MAP):
             _extra_files: map from filename to content. The extra
                 filenames given in the map would be loaded and their content
                 would be stored in the provided map.
+            mmap: if ``True`` and ``f`` is a file name, the file is memory-mapped
+                and tensors loaded onto CPU point directly into it instead of
+                being copied. Loading is then nearly instant, and processes that
+                load the same file share its memory. Not supported on Windows.
 
 
         Returns:
@@ -144,14 +148,14 @@ def load(f, map_location=None, _extra_files=DEFAULT_EXTRA_FILES_MAP):
     if isinstance(f, str) or \
             (sys.version_info[0] == 2 and isinstance(f, unicode)) or \
             (sys.version_info[0] == 3 and isinstance(f, pathlib.Path)):
-        torch._C.import_ir_module(module_lookup, f, map_location, _extra_files)
+        torch._C.import_ir_module(module_lookup, f, map_location, _extra_files, mmap)
     else:
         torch._C.import_ir_module_from_buffer(module_lookup, f.read(), map_location, _extra_files)
 
     return m
 
 
-def save(m, f, _extra_files=DEFAULT_EXTRA_FILES_MAP):
+def save(m, f, _extra_files=DEFAULT_EXTRA_FILES_MAP, _save_optimized_plans=False):
     """
         Save an offline version of this module for use in a separate process. The saved
         module serializes all of the methods, submodules, parameters, and attributes of this
@@ -170,6 +174,10 @@ def save(m, f, _extra_files=DEFAULT_EXTRA_FILES_MAP):
             f: a file-like object (has to implement write and flush) or a string
                containing a file name
             _extra_files: Map from filename to contents which will be stored as part of 'f'
+            _save_optimized_plans: also store the graphs the methods of the module optimized
+               for the inputs they were called (or warmed up) with so far. When the module is
+               loaded, these inputs run without being optimized again. The graphs are
+               specialized to the devices, dtypes and number of dimensions of the inputs.
 
         .. warning::
             If you are using Python 2, ``torch.save`` does NOT support ``StringIO.StringIO``
@@ -197,12 +205,48 @@ def save(m, f, _extra_files=DEFAULT_EXTRA_FILES_MAP):
     if isinstance(f, str) or \
             (sys.version_info[0] == 2 and isinstance(f, unicode)) or \
             (sys.version_info[0] == 3 and isinstance(f, pathlib.Path)):
-        m.save(f, _extra_files=_extra_files)
+        m.save(f, _extra_files=_extra_files, _save_optimized_plans=_save_optimized_plans)
     else:
-        ret = m.save_to_buffer(_extra_files=_extra_files)
+        ret = m.save_to_buffer(_extra_files=_extra_files, _save_optimized_plans=_save_optimized_plans)
         f.write(ret)
 
 
+def export_opnames(m):
+    """
+        Returns the sorted names of the ops called by the methods of a ScriptModule and of
+        its submodules, leaving out the ``prim::`` nodes the interpreter always provides.
+
+        Writing the names of the ops of all the models an application runs to a yaml list
+        lets a selective build of libtorch compile the TorchScript kernels of only those
+        ops, which makes mobile binaries smaller and faster to start: pass the file as
+        ``-DSELECTED_OP_LIST=<path>`` to CMake.
+
+        Arguments:
+            m: a ScriptModule
+
+        Example: ::
+
+            m = torch.jit.load('scriptmodule.pt')
+            with open('ops.yaml', 'w') as f:
+                yaml.dump(torch.jit.export_opnames(m), f)
+    """
+    def block_opnames(block, names):
+        for node in block.nodes():
+            if not node.kind().startswith('prim::'):
+                names.add(node.kind())
+            for b in node.blocks():
+                block_opnames(b, names)
+
+    names = set()
+    modules = [m._c]
+    while modules:
+        module = modules.pop()
+        for name in module._method_names():
+            block_opnames(module._get_method(name).graph, names)
+        modules.extend(submodule for _, submodule in module._get_modules())
+    return sorted(names)
+
+
 def get_trace_graph(f, args=(), kwargs=None, _force_outplace=False, return_inputs=False):
     """
     Trace a function or model, returning a tuple consisting of the both the
@@ -6,3 +6,7 @@ def build_tensor_from_id(data):
     if isinstance(data, int):
         # just the id, can't really do anything
         return data
+
+
+def build_tensorlist(data):
+    return data
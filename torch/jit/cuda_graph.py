@@ -0,0 +1,72 @@
+import torch
+
+
+def _signature(inputs):
+    if not all(isinstance(t, torch.Tensor) for t in inputs):
+        return None
+    return tuple((tuple(t.size()), t.stride(), t.dtype, t.device) for t in inputs)
+
+
+class CUDAGraphModule(object):
+    r"""Runs the forward of a module by replaying the kernels it launched for
+    inputs of one fixed shape, with a single launch instead of one per kernel.
+
+    The forward is captured once for ``example_inputs``, after a few warm-up
+    calls, on a side stream whose tensors come from a private memory pool of
+    the caching allocator. Calls with inputs of the same sizes, strides, dtypes
+    and devices copy them into the captured inputs and replay the graph; other
+    calls run the module as usual.
+
+    The forward must only launch CUDA work on the current stream, without
+    synchronizing with the host, and must not depend on the values of its
+    inputs for control flow. Random ops replay the numbers drawn during the
+    capture. The captured outputs are returned by every replay and are
+    overwritten by the next one, so clone them if they need to survive it.
+
+    Example::
+
+        >>> model = torch.jit.load('model.pt').cuda()
+        >>> model = torch.jit.cuda_graph.CUDAGraphModule(model, (example,))
+        >>> out = model(x)
+    """
+
+    def __init__(self, module, example_inputs, warmup_iters=3):
+        if not hasattr(torch._C, '_CUDAGraph'):
+            raise RuntimeError("CUDAGraphModule requires PyTorch built with CUDA")
+        if isinstance(example_inputs, torch.Tensor):
+            example_inputs = (example_inputs,)
+        if not all(isinstance(t, torch.Tensor) and t.is_cuda for t in example_inputs):
+            raise ValueError("CUDAGraphModule expects example inputs that are CUDA tensors")
+        self.module = module
+        self._signature = _signature(example_inputs)
+        self._static_inputs = tuple(t.clone() for t in example_inputs)
+        self._graph = torch._C._CUDAGraph()
+
+        stream = torch.cuda.Stream(device=self._static_inputs[0].device)
+        stream.wait_stream(torch.cuda.current_stream())
+        with torch.no_grad(), torch.cuda.stream(stream):
+            # Lazily initialized state, like cuBLAS handles, has to be set
+            # up before the capture
+            for _ in range(warmup_iters):
+                module(*self._static_inputs)
+            self._graph.capture_begin()
+            try:
+                self._static_outputs = module(*self._static_inputs)
+            finally:
+                self._graph.capture_end()
+        torch.cuda.current_stream().wait_stream(stream)
+
+    def __call__(self, *inputs):
+        if self._signature is None or _signature(inputs) != self._signature:
+            return self.module(*inputs)
+        for static_input, input in zip(self._static_inputs, inputs):
+            static_input.copy_(input)
+        self._graph.replay()
+        return self._static_outputs
+
+    def reset(self):
+        r"""Releases the graph and its memory; later calls run the module."""
+        self._graph.reset()
+        self._signature = None
+        self._static_inputs = ()
+        self._static_outputs = None
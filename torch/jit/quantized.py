@@ -1,8 +1,11 @@
 import torch
-from typing import Tuple, Optional  # noqa: F401
+from typing import Tuple, Optional, List  # noqa: F401
 from torch import Tensor
 
 from torch.nn import _VF
+from torch._jit_internal import _parameter_list
+from torch.nn.modules.rnn import apply_permutation
+from torch.nn.utils.rnn import PackedSequence, get_packed_sequence
 
 
 class QuantizedLinear(torch.jit.ScriptModule):
@@ -48,6 +51,80 @@ class QuantizedLinear(torch.jit.ScriptModule):
         return repr
 
 
+# FP16 weights with fp32 activations and accumulation
+class QuantizedLinearFP16(torch.jit.ScriptModule):
+
+    def __init__(self, other):
+        super(QuantizedLinearFP16, self).__init__()
+        self.in_features = other.in_features
+        self.out_features = other.out_features
+        self.original_weight = torch.nn.Parameter(other.weight.clone().float(), requires_grad=False)
+        assert other.bias is not None, 'QuantizedLinearFP16 requires a bias'
+        self.bias = torch.nn.Parameter(other.bias.clone().float(), requires_grad=False)
+        self.register_buffer(
+            'packed_weight', torch.fbgemm_pack_gemm_matrix_fp16(self.original_weight))
+
+    @torch.jit.script_method
+    def _unpack(self):
+        self.packed_weight.set_(
+            torch.fbgemm_pack_gemm_matrix_fp16(self.original_weight))
+
+    @torch.jit.script_method
+    def _pack(self):
+        self.packed_weight.set_(
+            torch.zeros(torch.jit.annotate(List[int], []), dtype=torch.uint8).detach())
+
+    @torch.jit.script_method
+    def forward(self, input):
+        out = torch.fbgemm_linear_fp16_weight(
+            input.float(), self.packed_weight, self.bias)
+        return out.type_as(input)
+
+    def extra_repr(self):
+        repr = 'in_features={in_features}, out_features={out_features}, '.format(**self.__dict__)
+        return repr
+
+
+# FP32 weights packed by MKL for one batch size. Other batch sizes, and builds
+# without MKL, run the unpacked linear.
+class PackedLinear(torch.jit.ScriptModule):
+    __constants__ = ['batch_size']
+
+    def __init__(self, other, batch_size):
+        super(PackedLinear, self).__init__()
+        self.in_features = other.in_features
+        self.out_features = other.out_features
+        self.batch_size = batch_size
+        self.weight = torch.nn.Parameter(other.weight.clone().float(), requires_grad=False)
+        if other.bias is not None:
+            bias = other.bias.clone().float()
+        else:
+            bias = torch.zeros(self.out_features)
+        self.bias = torch.nn.Parameter(bias, requires_grad=False)
+        self.register_buffer(
+            'packed_weight', torch.mkl_linear_pack_weight(self.weight, batch_size))
+
+    @torch.jit.script_method
+    def _unpack(self):
+        self.packed_weight.set_(
+            torch.mkl_linear_pack_weight(self.weight, self.batch_size))
+
+    @torch.jit.script_method
+    def _pack(self):
+        self.packed_weight.set_(
+            torch.zeros([0], dtype=torch.float).detach())
+
+    @torch.jit.script_method
+    def forward(self, input):
+        return torch.mkl_linear(
+            input, self.packed_weight, self.weight, self.bias, self.batch_size)
+
+    def extra_repr(self):
+        repr = 'in_features={in_features}, out_features={out_features}, ' \
+               'batch_size={batch_size}'.format(**self.__dict__)
+        return repr
+
+
 # Quantized RNN cell implementations
 class QuantizedRNNCellBase(torch.jit.ScriptModule):
     __constants__ = ['input_size', 'hidden_size', 'bias', 'scale_hh', 'scale_ih',
@@ -205,6 +282,270 @@ class QuantizedGRUCell(QuantizedRNNCellBase):
         )
 
 
+# Quantized multi-layer RNN implementations. The weights are quantized to int8
+# once, and the activations dynamically on every matrix multiplication.
+class QuantizedRNNBase(torch.jit.ScriptModule):
+    __constants__ = ['mode', 'input_size', 'hidden_size', 'num_layers', 'bias',
+                     'batch_first', 'dropout', 'bidirectional']
+
+    def __init__(self, other):
+        super(QuantizedRNNBase, self).__init__()
+        self.mode = other.mode
+        self.input_size = other.input_size
+        self.hidden_size = other.hidden_size
+        self.num_layers = other.num_layers
+        self.bias = other.bias
+        self.batch_first = other.batch_first
+        self.dropout = float(other.dropout)
+        self.bidirectional = other.bidirectional
+        if not self.bias:
+            raise ValueError("Quantized RNNs require bias terms")
+        if self.mode not in ('LSTM', 'GRU'):
+            raise RuntimeError("Unsupported RNN mode: {}".format(self.mode))
+
+        num_directions = 2 if self.bidirectional else 1
+        self._all_weights = []
+        pack_lines = []
+        unpack_lines = []
+        for layer in range(self.num_layers):
+            for direction in range(num_directions):
+                suffix = '_l{}{}'.format(layer, '_reverse' if direction == 1 else '')
+                for gate in ['ih', 'hh']:
+                    weight, col_offsets, scale, zero_point = torch.fbgemm_linear_quantize_weight(
+                        getattr(other, 'weight_' + gate + suffix).clone().float())
+                    self.register_buffer('weight_' + gate + suffix, weight)
+                    self.register_buffer('bias_' + gate + suffix,
+                                         getattr(other, 'bias_' + gate + suffix).clone().float().detach())
+                    self.register_buffer('packed_' + gate + suffix, torch.fbgemm_pack_quantized_matrix(
+                        weight, weight.size(1), weight.size(0)))
+                    self.register_buffer('col_offsets_' + gate + suffix, col_offsets)
+                    self.register_buffer('scale_' + gate + suffix,
+                                         torch.tensor(scale, dtype=torch.double))
+                    self.register_buffer('zero_point_' + gate + suffix,
+                                         torch.tensor(zero_point, dtype=torch.long))
+                    pack_lines.append(
+                        '    self.packed_{0}.set_(torch.zeros(torch.jit.annotate(List[int], []), '
+                        'dtype=torch.uint8).detach())'.format(gate + suffix))
+                    unpack_lines.append(
+                        '    self.packed_{0}.set_(torch.fbgemm_pack_quantized_matrix(self.weight_{0}, '
+                        'self.weight_{0}.size(1), self.weight_{0}.size(0)))'.format(gate + suffix))
+                # The order quantized_lstm and quantized_gru expect
+                self._all_weights.append(
+                    [name + gate + suffix
+                     for name in ['weight_', 'bias_', 'packed_', 'col_offsets_',
+                                  'scale_', 'zero_point_']
+                     for gate in ['ih', 'hh']])
+
+        # One statement per layer and direction, so _pack and _unpack are
+        # generated rather than written out
+        self.define('def _pack(self):\n' + '\n'.join(pack_lines) + '\n'
+                    'def _unpack(self):\n' + '\n'.join(unpack_lines) + '\n')
+
+    def _get_flat_weights_names(self):
+        return [weight for weights in self._all_weights for weight in weights]
+
+    @_parameter_list(_get_flat_weights_names)
+    def _get_flat_weights(self):
+        return [getattr(self, name) for name in self._get_flat_weights_names()]
+
+    @torch.jit.script_method
+    def check_input(self, input, batch_sizes):
+        # type: (Tensor, Optional[Tensor]) -> None
+        expected_input_dim = 2 if batch_sizes is not None else 3
+        if input.dim() != expected_input_dim:
+            raise RuntimeError(
+                'input must have {} dimensions, got {}'.format(
+                    expected_input_dim, input.dim()))
+        if self.input_size != input.size(-1):
+            raise RuntimeError(
+                'input.size(-1) must be equal to input_size. Expected {}, got {}'.format(
+                    self.input_size, input.size(-1)))
+
+    @torch.jit.script_method
+    def get_expected_hidden_size(self, input, batch_sizes):
+        # type: (Tensor, Optional[Tensor]) -> Tuple[int, int, int]
+        if batch_sizes is not None:
+            mini_batch = batch_sizes[0]
+            mini_batch = int(mini_batch)
+        else:
+            mini_batch = input.size(0) if self.batch_first else input.size(1)
+        num_directions = 2 if self.bidirectional else 1
+        expected_hidden_size = (self.num_layers * num_directions,
+                                mini_batch, self.hidden_size)
+        return expected_hidden_size
+
+    @torch.jit.script_method
+    def check_hidden_size(self, hx, expected_hidden_size, msg='Expected hidden size {}, got {}'):
+        # type: (Tensor, Tuple[int, int, int], str) -> None
+        if hx.size() != expected_hidden_size:
+            raise RuntimeError(msg.format(expected_hidden_size, tuple(hx.size())))
+
+    def forward(self, input, hx=None):
+        if isinstance(input, PackedSequence):
+            return self.forward_packed(input, hx)
+        else:
+            return self.forward_tensor(input, hx)
+
+    def extra_repr(self):
+        s = '{input_size}, {hidden_size}'
+        if self.num_layers != 1:
+            s += ', num_layers={num_layers}'
+        if self.batch_first is not False:
+            s += ', batch_first={batch_first}'
+        if self.bidirectional is not False:
+            s += ', bidirectional={bidirectional}'
+        return s.format(**self.__dict__)
+
+
+class QuantizedLSTM(QuantizedRNNBase):
+    __overloads__ = {'forward': ['forward_packed', 'forward_tensor']}
+
+    def __init__(self, other):
+        super(QuantizedLSTM, self).__init__(other)
+
+    @torch.jit.script_method
+    def forward_impl(self, input, hx, batch_sizes, max_batch_size, sorted_indices):
+        # type: (Tensor, Optional[Tuple[Tensor, Tensor]], Optional[Tensor], int, Optional[Tensor]) -> Tuple[Tensor, Tuple[Tensor, Tensor]]  # noqa
+        if hx is None:
+            num_directions = 2 if self.bidirectional else 1
+            zeros = torch.zeros(self.num_layers * num_directions,
+                                max_batch_size, self.hidden_size,
+                                dtype=input.dtype, device=input.device)
+            hx = (zeros, zeros)
+        else:
+            # Each batch of the hidden state should match the input sequence that
+            # the user believes he/she is passing in.
+            hx = self.permute_hidden(hx, sorted_indices)
+
+        self.check_forward_args(input, hx, batch_sizes)
+        if batch_sizes is None:
+            result = _VF.quantized_lstm(input, hx, self._get_flat_weights(), self.bias, self.num_layers,
+                                        self.dropout, self.training, self.bidirectional,
+                                        self.batch_first)
+        else:
+            result = _VF.quantized_lstm(input, batch_sizes, hx, self._get_flat_weights(), self.bias,
+                                        self.num_layers, self.dropout, self.training,
+                                        self.bidirectional)
+        output = result[0]
+        hidden = result[1:]
+
+        return output, hidden
+
+    @torch.jit.script_method
+    def check_forward_args(self, input, hidden, batch_sizes):
+        # type: (Tensor, Tuple[Tensor, Tensor], Optional[Tensor]) -> None
+        self.check_input(input, batch_sizes)
+        expected_hidden_size = self.get_expected_hidden_size(input, batch_sizes)
+
+        self.check_hidden_size(hidden[0], expected_hidden_size,
+                               'Expected hidden[0] size {}, got {}')
+        self.check_hidden_size(hidden[1], expected_hidden_size,
+                               'Expected hidden[1] size {}, got {}')
+
+    @torch.jit.script_method
+    def permute_hidden(self, hx, permutation):
+        # type: (Tuple[Tensor, Tensor], Optional[Tensor]) -> Tuple[Tensor, Tensor]
+        if permutation is None:
+            return hx
+        return apply_permutation(hx[0], permutation), apply_permutation(hx[1], permutation)
+
+    @torch.jit.script_method
+    def forward_tensor(self, input, hx=None):
+        # type: (Tensor, Optional[Tuple[Tensor, Tensor]]) -> Tuple[Tensor, Tuple[Tensor, Tensor]]
+        batch_sizes = None
+        max_batch_size = input.size(0) if self.batch_first else input.size(1)
+        sorted_indices = None
+        unsorted_indices = None
+
+        output, hidden = self.forward_impl(input, hx, batch_sizes, max_batch_size, sorted_indices)
+
+        return output, self.permute_hidden(hidden, unsorted_indices)
+
+    @torch.jit.script_method
+    def forward_packed(self, input, hx=None):
+        # type: (Tuple[Tensor, Tensor, Optional[Tensor], Optional[Tensor]], Optional[Tuple[Tensor, Tensor]]) -> Tuple[Tuple[Tensor, Tensor, Optional[Tensor], Optional[Tensor]], Tuple[Tensor, Tensor]]  # noqa
+        input, batch_sizes, sorted_indices, unsorted_indices = input
+        max_batch_size = batch_sizes[0]
+        max_batch_size = int(max_batch_size)
+
+        output, hidden = self.forward_impl(input, hx, batch_sizes, max_batch_size, sorted_indices)
+
+        output = get_packed_sequence(output, batch_sizes, sorted_indices, unsorted_indices)
+        return output, self.permute_hidden(hidden, unsorted_indices)
+
+
+class QuantizedGRU(QuantizedRNNBase):
+    __overloads__ = {'forward': ['forward_packed', 'forward_tensor']}
+
+    def __init__(self, other):
+        super(QuantizedGRU, self).__init__(other)
+
+    @torch.jit.script_method
+    def forward_impl(self, input, hx, batch_sizes, max_batch_size, sorted_indices):
+        # type: (Tensor, Optional[Tensor], Optional[Tensor], int, Optional[Tensor]) -> Tuple[Tensor, Tensor]  # noqa
+        if hx is None:
+            num_directions = 2 if self.bidirectional else 1
+            hx = torch.zeros(self.num_layers * num_directions,
+                             max_batch_size, self.hidden_size,
+                             dtype=input.dtype, device=input.device)
+        else:
+            # Each batch of the hidden state should match the input sequence that
+            # the user believes he/she is passing in.
+            hx = self.permute_hidden(hx, sorted_indices)
+
+        self.check_forward_args(input, hx, batch_sizes)
+        if batch_sizes is None:
+            result = _VF.quantized_gru(input, hx, self._get_flat_weights(), self.bias, self.num_layers,
+                                       self.dropout, self.training, self.bidirectional,
+                                       self.batch_first)
+        else:
+            result = _VF.quantized_gru(input, batch_sizes, hx, self._get_flat_weights(), self.bias,
+                                       self.num_layers, self.dropout, self.training,
+                                       self.bidirectional)
+        output = result[0]
+        hidden = result[1]
+
+        return output, hidden
+
+    @torch.jit.script_method
+    def check_forward_args(self, input, hidden, batch_sizes):
+        # type: (Tensor, Tensor, Optional[Tensor]) -> None
+        self.check_input(input, batch_sizes)
+        expected_hidden_size = self.get_expected_hidden_size(input, batch_sizes)
+        self.check_hidden_size(hidden, expected_hidden_size)
+
+    @torch.jit.script_method
+    def permute_hidden(self, hx, permutation):
+        # type: (Tensor, Optional[Tensor]) -> Tensor
+        if permutation is None:
+            return hx
+        return apply_permutation(hx, permutation)
+
+    @torch.jit.script_method
+    def forward_tensor(self, input, hx=None):
+        # type: (Tensor, Optional[Tensor]) -> Tuple[Tensor, Tensor]
+        batch_sizes = None
+        max_batch_size = input.size(0) if self.batch_first else input.size(1)
+        sorted_indices = None
+        unsorted_indices = None
+
+        output, hidden = self.forward_impl(input, hx, batch_sizes, max_batch_size, sorted_indices)
+
+        return output, self.permute_hidden(hidden, unsorted_indices)
+
+    @torch.jit.script_method
+    def forward_packed(self, input, hx=None):
+        # type: (Tuple[Tensor, Tensor, Optional[Tensor], Optional[Tensor]], Optional[Tensor]) -> Tuple[Tuple[Tensor, Tensor, Optional[Tensor], Optional[Tensor]], Tensor]  # noqa
+        input, batch_sizes, sorted_indices, unsorted_indices = input
+        max_batch_size = batch_sizes[0]
+        max_batch_size = int(max_batch_size)
+
+        output, hidden = self.forward_impl(input, hx, batch_sizes, max_batch_size, sorted_indices)
+
+        output = get_packed_sequence(output, batch_sizes, sorted_indices, unsorted_indices)
+        return output, self.permute_hidden(hidden, unsorted_indices)
+
+
 def quantize_rnn_cell_modules(module):
     reassign = {}
     for name, mod in module.named_modules():
@@ -225,17 +566,62 @@ def quantize_rnn_cell_modules(module):
     return module
 
 
-def quantize_linear_modules(module):
+def quantize_linear_modules(module, dtype=torch.int8):
+    r"""Replaces the nn.Linear submodules of module with modules whose weights
+    are packed once, when they are created or loaded, instead of on every call:
+    int8 or float16 FBGEMM weights for dtype torch.int8 or torch.float16.
+    """
+    if dtype not in (torch.int8, torch.float16):
+        raise RuntimeError("Unsupported dtype: {}".format(dtype))
+    reassign = {}
+    for name, mod in module.named_modules():
+        if mod is module:
+            continue
+        new_mod = quantize_linear_modules(mod, dtype)
+        if new_mod is not mod:
+            reassign[name] = new_mod
+
+    for name, mod in reassign.items():
+        setattr(module, name, mod)
+    if isinstance(module, torch.nn.Linear):
+        if dtype == torch.int8:
+            return QuantizedLinear(module)
+        return QuantizedLinearFP16(module)
+    return module
+
+
+def prepack_linear_modules(module, batch_size):
+    r"""Replaces the nn.Linear submodules of module with fp32 modules whose
+    weights MKL packs once for inputs of batch_size rows.
+    """
+    reassign = {}
+    for name, mod in module.named_modules():
+        if mod is module:
+            continue
+        new_mod = prepack_linear_modules(mod, batch_size)
+        if new_mod is not mod:
+            reassign[name] = new_mod
+
+    for name, mod in reassign.items():
+        setattr(module, name, mod)
+    if isinstance(module, torch.nn.Linear):
+        return PackedLinear(module, batch_size)
+    return module
+
+
+def quantize_rnn_modules(module):
     reassign = {}
     for name, mod in module.named_modules():
         if mod is module:
             continue
-        new_mod = quantize_linear_modules(mod)
+        new_mod = quantize_rnn_modules(mod)
         if new_mod is not mod:
             reassign[name] = new_mod
 
     for name, mod in reassign.items():
         setattr(module, name, mod)
-    if isinstance(mod, torch.nn.Linear):
-        return QuantizedLinear(mod)
+    if isinstance(module, torch.nn.LSTM):
+        return QuantizedLSTM(module)
+    if isinstance(module, torch.nn.GRU):
+        return QuantizedGRU(module)
     return module
@@ -1,9 +1,16 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 
 #include <nccl.h>
 
+// ncclCommAbort and ncclCommGetAsyncError were added in NCCL 2.4
+#if defined(NCCL_MAJOR) && \
+    ((NCCL_MAJOR > 2) || (NCCL_MAJOR == 2 && NCCL_MINOR >= 4))
+#define ENABLE_NCCL_ERROR_CHECKING
+#endif
+
 #define C10D_NCCL_CHECK(cmd)                                              \
   do {                                                                    \
     ncclResult_t error = cmd;                                             \
@@ -20,12 +27,15 @@ namespace c10d {
 // RAII wrapper for NCCL communicator
 class NCCLComm {
  public:
-  explicit NCCLComm(ncclComm_t ncclComm) : ncclComm_(ncclComm) {}
+  explicit NCCLComm(ncclComm_t ncclComm)
+      : ncclComm_(ncclComm), aborted_(false), ncclAsyncErr_(ncclSuccess) {}
 
   NCCLComm() : NCCLComm(nullptr) {}
 
   ~NCCLComm() noexcept(false) {
-    if (ncclComm_) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Aborting already freed the resources of the communicator
+    if (ncclComm_ && !aborted_) {
       C10D_NCCL_CHECK(ncclCommDestroy(ncclComm_));
     }
   }
@@ -45,12 +55,16 @@ class NCCLComm {
   NCCLComm& operator=(const NCCLComm&) = delete;
 
   // Move constructable
-  NCCLComm(NCCLComm&& other) {
+  NCCLComm(NCCLComm&& other) : NCCLComm() {
     std::swap(ncclComm_, other.ncclComm_);
+    std::swap(aborted_, other.aborted_);
+    std::swap(ncclAsyncErr_, other.ncclAsyncErr_);
   }
   // Move assignable
   NCCLComm& operator=(NCCLComm&& other) {
     std::swap(ncclComm_, other.ncclComm_);
+    std::swap(aborted_, other.aborted_);
+    std::swap(ncclAsyncErr_, other.ncclAsyncErr_);
     return *this;
   }
 
@@ -58,8 +72,43 @@ class NCCLComm {
     return ncclComm_;
   }
 
+  // Makes the kernels of the communicator return, and frees it, e.g. when a
+  // peer is gone and they would hang forever. Can be called from another
+  // thread than the one that enqueues the operations. No-op before NCCL 2.4.
+  void ncclCommAbort() {
+    std::unique_lock<std::mutex> lock(mutex_);
+#ifdef ENABLE_NCCL_ERROR_CHECKING
+    if (aborted_ || !ncclComm_) {
+      return;
+    }
+    C10D_NCCL_CHECK(::ncclCommAbort(ncclComm_));
+    aborted_ = true;
+#endif
+  }
+
+  bool isAborted() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return aborted_;
+  }
+
+  // Returns the asynchronous error of the communicator, e.g. of the network,
+  // without blocking. Always ncclSuccess before NCCL 2.4.
+  ncclResult_t checkForNcclError() {
+    std::unique_lock<std::mutex> lock(mutex_);
+#ifdef ENABLE_NCCL_ERROR_CHECKING
+    if (ncclAsyncErr_ != ncclSuccess || aborted_ || !ncclComm_) {
+      return ncclAsyncErr_;
+    }
+    C10D_NCCL_CHECK(ncclCommGetAsyncError(ncclComm_, &ncclAsyncErr_));
+#endif
+    return ncclAsyncErr_;
+  }
+
  protected:
   ncclComm_t ncclComm_;
+  bool aborted_;
+  ncclResult_t ncclAsyncErr_;
+  mutable std::mutex mutex_;
 };
 
 } // namespace c10d
@@ -33,6 +33,17 @@ int64_t PrefixStore::add(const std::string& key, int64_t value) {
   return store_.add(joinKey(key), value);
 }
 
+void PrefixStore::multiSet(
+    const std::vector<std::string>& keys,
+    const std::vector<std::vector<uint8_t>>& values) {
+  store_.multiSet(joinKeys(keys), values);
+}
+
+std::vector<std::vector<uint8_t>> PrefixStore::multiGet(
+    const std::vector<std::string>& keys) {
+  return store_.multiGet(joinKeys(keys));
+}
+
 bool PrefixStore::check(const std::vector<std::string>& keys) {
   auto joinedKeys = joinKeys(keys);
   return store_.check(joinedKeys);
@@ -1,5 +1,7 @@
 #include <c10d/ProcessGroup.hpp>
 
+#include <c10/util/StaticTracepoint.h>
+
 namespace c10d {
 
 ProcessGroup::Work::~Work() {}
@@ -25,6 +27,10 @@ int ProcessGroup::Work::sourceRank() const {
       "that correspond to a recv or recv-from-any call.");
 }
 
+float ProcessGroup::Work::getDuration() const {
+  return -1;
+}
+
 void ProcessGroup::Work::synchronize() {}
 
 void ProcessGroup::Work::wait() {
@@ -37,6 +43,7 @@ void ProcessGroup::Work::wait() {
 }
 
 void ProcessGroup::Work::finish(std::exception_ptr exception) {
+  C10_SDT(c10d_collective_done, this, static_cast<int>(!exception));
   std::unique_lock<std::mutex> lock(mutex_);
   completed_ = true;
   exception_ = exception;
@@ -48,4 +55,13 @@ ProcessGroup::ProcessGroup(int rank, int size) : rank_(rank), size_(size) {}
 
 ProcessGroup::~ProcessGroup() {}
 
+std::shared_ptr<ProcessGroup::Work> ProcessGroup::alltoall(
+    at::Tensor& /* unused */,
+    at::Tensor& /* unused */,
+    std::vector<int64_t>& /* unused */,
+    std::vector<int64_t>& /* unused */,
+    const AllToAllOptions& /* unused */) {
+  throw std::runtime_error("ProcessGroup does not support alltoall");
+}
+
 } // namespace c10d
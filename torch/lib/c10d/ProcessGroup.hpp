@@ -52,6 +52,10 @@ class ProcessGroup {
     // Returns source rank if this objects represents a recv-from-any.
     virtual int sourceRank() const;
 
+    // Returns the time in milliseconds the work ran for on its devices, once
+    // completed, or a negative value if the backend doesn't time its work.
+    virtual float getDuration() const;
+
     // Ensures that operations on the output tensors that are invoked
     // after this function returns are correctly sequenced after the
     // asynchronous completion of this work.
@@ -132,6 +136,17 @@ class ProcessGroup {
       std::vector<std::vector<at::Tensor>>& inputTensors,
       const ReduceScatterOptions& opts = ReduceScatterOptions()) = 0;
 
+  // Splits `inputTensor` along its first dimension into `inputSplitSizes`
+  // rows per rank and sends the i-th split to rank i, while receiving into
+  // the i-th split of `outputTensor` (by `outputSplitSizes`) what rank i
+  // sent here. Empty split sizes mean equal splits.
+  virtual std::shared_ptr<ProcessGroup::Work> alltoall(
+      at::Tensor& outputTensor,
+      at::Tensor& inputTensor,
+      std::vector<int64_t>& outputSplitSizes,
+      std::vector<int64_t>& inputSplitSizes,
+      const AllToAllOptions& opts = AllToAllOptions());
+
   virtual std::shared_ptr<ProcessGroup::Work> send(
       std::vector<at::Tensor>& tensors,
       int dstRank,
@@ -1,5 +1,8 @@
 #include <c10d/ProcessGroupGloo.hpp>
 
+#include <algorithm>
+#include <cstring>
+
 #include <gloo/allgather.h>
 #include <gloo/allreduce.h>
 #include <gloo/barrier.h>
@@ -212,6 +215,23 @@ void initializeStreamsEvents(
 
 #endif
 
+// Splits the contiguous tensors of the same size `tensors` in `chunks` chunks
+// of their flattened elements. The chunks are views of the tensors.
+std::vector<std::vector<at::Tensor>> chunkTensors(
+    std::vector<at::Tensor>& tensors,
+    size_t chunks) {
+  const int64_t numel = tensors[0].numel();
+  std::vector<std::vector<at::Tensor>> result(chunks);
+  for (size_t i = 0; i < chunks; i++) {
+    const int64_t begin = numel * i / chunks;
+    const int64_t end = numel * (i + 1) / chunks;
+    for (auto& tensor : tensors) {
+      result[i].push_back(tensor.view({-1}).narrow(0, begin, end - begin));
+    }
+  }
+  return result;
+}
+
 } // namespace
 
 ProcessGroupGloo::SendWork::SendWork(
@@ -257,9 +277,54 @@ void ProcessGroupGloo::RecvWork::wait() {
   }
 }
 
+ProcessGroupGloo::ChunkedWork::ChunkedWork(
+    std::vector<std::shared_ptr<AsyncWork>> chunks)
+    : chunks_(std::move(chunks)) {}
+
+bool ProcessGroupGloo::ChunkedWork::isCompleted() {
+  for (auto& chunk : chunks_) {
+    if (!chunk->isCompleted()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ProcessGroupGloo::ChunkedWork::isSuccess() const {
+  return !exception();
+}
+
+std::exception_ptr ProcessGroupGloo::ChunkedWork::exception() const {
+  for (auto& chunk : chunks_) {
+    if (auto exception = chunk->exception()) {
+      return exception;
+    }
+  }
+  return nullptr;
+}
+
+void ProcessGroupGloo::ChunkedWork::wait() {
+  // Wait for all chunks before rethrowing, the other chunks are still
+  // writing to the tensors if one failed.
+  std::exception_ptr exception;
+  for (auto& chunk : chunks_) {
+    try {
+      chunk->wait();
+    } catch (...) {
+      if (!exception) {
+        exception = std::current_exception();
+      }
+    }
+  }
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
 ProcessGroupGloo::Options::Options()
     : timeout(std::chrono::milliseconds(10 * 1000)),
-      threads(2) {}
+      threads(2),
+      minChunkBytes(4 * 1024 * 1024) {}
 
 ProcessGroupGloo::ProcessGroupGloo(
     const std::shared_ptr<Store>& store,
@@ -269,7 +334,8 @@ ProcessGroupGloo::ProcessGroupGloo(
     : ProcessGroup(rank, size),
       store_(new GlooStore(store)),
       stop_(false),
-      collectiveCounter_(0) {
+      collectiveCounter_(0),
+      minChunkBytes_(options.minChunkBytes) {
   auto& devices = options.devices;
   if (devices.empty()) {
     throw std::runtime_error("No device(s) specified");
@@ -316,6 +382,25 @@ uint32_t ProcessGroupGloo::nextTag() {
   return collectiveCounter_++;
 }
 
+std::shared_ptr<::gloo::Context> ProcessGroupGloo::getContext(uint32_t tag) {
+  return contexts_[tag % contexts_.size()];
+}
+
+size_t ProcessGroupGloo::numChunks(
+    const std::vector<at::Tensor>& tensors) const {
+  if (minChunkBytes_ == 0 || threads_.size() < 2) {
+    return 1;
+  }
+  for (const auto& tensor : tensors) {
+    if (tensor.device().type() != at::kCPU || !tensor.is_contiguous()) {
+      return 1;
+    }
+  }
+  const size_t bytes = tensors[0].numel() * tensors[0].element_size();
+  return std::max<size_t>(
+      1, std::min<size_t>(threads_.size(), bytes / minChunkBytes_));
+}
+
 void ProcessGroupGloo::runLoop(int workerIndex) {
   std::unique_lock<std::mutex> lock(workMutex_);
 
@@ -478,15 +563,30 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::broadcast(
       invalidArgument("unsupported device type");
   }
 
+  const auto chunks = numChunks(inputs);
+  if (chunks > 1) {
+    // Every chunk is a collective of its own, with its own tag and context.
+    std::vector<std::shared_ptr<AsyncWork>> works;
+    for (auto& chunk : chunkTensors(inputs, chunks)) {
+      const auto tag = nextTag();
+      auto work = std::make_shared<AsyncBroadcastWork>(
+          getContext(tag), chunk, opts.rootRank, opts.rootTensor, tag);
+      enqueue(work);
+      works.push_back(std::move(work));
+    }
+    return std::make_shared<ChunkedWork>(std::move(works));
+  }
+
   std::shared_ptr<AsyncBroadcastWork> work;
-  auto& context = contexts_[0];
+  const auto tag = nextTag();
+  auto context = getContext(tag);
   if (device.type() == at::kCPU) {
     work = std::make_shared<AsyncBroadcastWork>(
-        context, inputs, opts.rootRank, opts.rootTensor, nextTag());
+        context, inputs, opts.rootRank, opts.rootTensor, tag);
 #ifdef USE_CUDA
   } else if (device.type() == at::kCUDA) {
     work = std::make_shared<AsyncBroadcastCUDAWork>(
-        context, inputs, opts.rootRank, opts.rootTensor, nextTag());
+        context, inputs, opts.rootRank, opts.rootTensor, tag);
 #endif
   } else {
     throw std::runtime_error("Invalid backend");
@@ -606,6 +706,105 @@ class AsyncAllreduceCUDAWork : public AsyncAllreduceWork {
   std::vector<at::cuda::CUDAEvent> events;
 };
 
+// Stages the allreduce of contiguous CUDA tensors through host memory in
+// chunks, so the copies overlap with the transfers. The copies of all chunks
+// to the host are queued upfront, the allreduce of a chunk starts as soon as
+// its copy completed, and its result is copied back while the next chunks
+// are reduced.
+class AsyncAllreducePipelinedCUDAWork : public AsyncAllreduceWork {
+ public:
+  AsyncAllreducePipelinedCUDAWork(
+      const std::shared_ptr<gloo::Context>& context,
+      std::vector<at::Tensor>& inputs,
+      ReduceOp reduceOp,
+      uint32_t tag,
+      size_t chunks)
+      : AsyncAllreduceWork(context, inputs, reduceOp, tag) {
+    initializeStreamsEvents(inputs, streams, events);
+
+    tmp.reserve(inputs.size());
+    for (auto& input : inputs) {
+      tmp.push_back(pinnedLike(input));
+    }
+    deviceChunks = chunkTensors(inputs, chunks);
+    hostChunks = chunkTensors(tmp, chunks);
+
+    // Kick off copy of every chunk from CUDA tensors to pinned CPU tensors.
+    copyEvents.resize(chunks);
+    at::cuda::OptionalCUDAStreamGuard guard;
+    for (size_t c = 0; c < chunks; c++) {
+      copyEvents[c].resize(inputs.size());
+      for (size_t i = 0; i < inputs.size(); i++) {
+        guard.reset_stream(streams[i]);
+        hostChunks[c][i].copy_(deviceChunks[c][i], /* non_blocking */ true);
+        copyEvents[c][i].record(streams[i]);
+      }
+    }
+  }
+
+  void run() override {
+    at::cuda::OptionalCUDAStreamGuard guard;
+    for (size_t c = 0; c < hostChunks.size(); c++) {
+      // Synchronize with the copy of this chunk only.
+      for (auto& event : copyEvents[c]) {
+        event.synchronize();
+      }
+
+      // The chunks are reduced one after the other, so they can share
+      // the tag of this work.
+      allreduce(hostChunks[c]);
+
+      // Kick off copy back of this chunk to the CUDA tensors. Only the first
+      // host tensor contains the results (see AsyncAllreduceWork::run).
+      for (size_t i = 0; i < inputs.size(); i++) {
+        guard.reset_stream(streams[i]);
+        deviceChunks[c][i].copy_(hostChunks[c][0], /* non_blocking */ true);
+      }
+    }
+
+    for (size_t i = 0; i < inputs.size(); i++) {
+      events[i].record(streams[i]);
+    }
+  }
+
+  void synchronize() override {
+    // Synchronize with the copy back to CUDA tensors.
+    at::cuda::OptionalCUDAGuard guard;
+    for (size_t i = 0; i < inputs.size(); i++) {
+      guard.set_index(inputs[i].device().index());
+      events[i].block(at::cuda::getCurrentCUDAStream());
+    }
+  }
+
+  std::vector<at::Tensor> tmp;
+  // Views of every chunk of the inputs and of tmp, indexed [chunk][input].
+  std::vector<std::vector<at::Tensor>> deviceChunks;
+  std::vector<std::vector<at::Tensor>> hostChunks;
+  std::vector<std::vector<at::cuda::CUDAEvent>> copyEvents;
+  std::vector<at::cuda::CUDAStream> streams;
+  std::vector<at::cuda::CUDAEvent> events;
+};
+
+// More chunks than this add latency without adding overlap.
+constexpr size_t kMaxPipelineChunks = 16;
+
+// Returns in how many chunks to stage an allreduce of CUDA tensors.
+size_t numPipelineChunks(
+    const std::vector<at::Tensor>& tensors,
+    size_t minChunkBytes) {
+  if (minChunkBytes == 0) {
+    return 1;
+  }
+  for (const auto& tensor : tensors) {
+    if (!tensor.is_contiguous()) {
+      return 1;
+    }
+  }
+  const size_t bytes = tensors[0].numel() * tensors[0].element_size();
+  return std::max<size_t>(
+      1, std::min<size_t>(kMaxPipelineChunks, bytes / minChunkBytes));
+}
+
 #endif
 
 } // namespace
@@ -632,15 +831,36 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::allreduce(
       invalidArgument("unsupported device type");
   }
 
+  const auto chunks = numChunks(inputs);
+  if (chunks > 1) {
+    // Every chunk is a collective of its own, with its own tag and context.
+    std::vector<std::shared_ptr<AsyncWork>> works;
+    for (auto& chunk : chunkTensors(inputs, chunks)) {
+      const auto tag = nextTag();
+      auto work = std::make_shared<AsyncAllreduceWork>(
+          getContext(tag), chunk, opts.reduceOp, tag);
+      enqueue(work);
+      works.push_back(std::move(work));
+    }
+    return std::make_shared<ChunkedWork>(std::move(works));
+  }
+
   std::shared_ptr<AsyncAllreduceWork> work;
-  auto& context = contexts_[0];
+  const auto tag = nextTag();
+  auto context = getContext(tag);
   if (device.type() == at::kCPU) {
     work = std::make_shared<AsyncAllreduceWork>(
-        context, inputs, opts.reduceOp, nextTag());
+        context, inputs, opts.reduceOp, tag);
 #ifdef USE_CUDA
   } else if (device.type() == at::kCUDA) {
-    work = std::make_shared<AsyncAllreduceCUDAWork>(
-        context, inputs, opts.reduceOp, nextTag());
+    const auto pipelineChunks = numPipelineChunks(inputs, minChunkBytes_);
+    if (pipelineChunks > 1) {
+      work = std::make_shared<AsyncAllreducePipelinedCUDAWork>(
+          context, inputs, opts.reduceOp, tag, pipelineChunks);
+    } else {
+      work = std::make_shared<AsyncAllreduceCUDAWork>(
+          context, inputs, opts.reduceOp, tag);
+    }
 #endif
   } else {
     throw std::runtime_error("Invalid backend");
@@ -789,7 +1009,8 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::reduce(
   }
 
   std::shared_ptr<AsyncReduceWork> work;
-  auto& context = contexts_[0];
+  const auto tag = nextTag();
+  auto context = getContext(tag);
   if (device.type() == at::kCPU) {
     work = std::make_shared<AsyncReduceWork>(
         context,
@@ -797,7 +1018,7 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::reduce(
         opts.rootRank,
         opts.rootTensor,
         opts.reduceOp,
-        nextTag());
+        tag);
 #ifdef USE_CUDA
   } else if (device.type() == at::kCUDA) {
     work = std::make_shared<AsyncReduceCUDAWork>(
@@ -806,7 +1027,7 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::reduce(
         opts.rootRank,
         opts.rootTensor,
         opts.reduceOp,
-        nextTag());
+        tag);
 #endif
   } else {
     throw std::runtime_error("Invalid backend");
@@ -995,14 +1216,15 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::allgather(
   }
 
   std::shared_ptr<AsyncAllgatherWork> work;
-  auto& context = contexts_[0];
+  const auto tag = nextTag();
+  auto context = getContext(tag);
   if (device.type() == at::kCPU) {
     work = std::make_shared<AsyncAllgatherWork>(
-        context, outputs, inputs, nextTag());
+        context, outputs, inputs, tag);
 #ifdef USE_CUDA
   } else if (device.type() == at::kCUDA) {
     work = std::make_shared<AsyncAllgatherCUDAWork>(
-        context, outputs, inputs, nextTag());
+        context, outputs, inputs, tag);
 #endif
   } else {
     throw std::runtime_error("Invalid backend");
@@ -1192,14 +1414,15 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::gather(
   }
 
   std::shared_ptr<AsyncGatherWork> work;
-  auto& context = contexts_[0];
+  const auto tag = nextTag();
+  auto context = getContext(tag);
   if (device.type() == at::kCPU) {
     work = std::make_shared<AsyncGatherWork>(
-        context, outputs, inputs, opts.rootRank, nextTag());
+        context, outputs, inputs, opts.rootRank, tag);
 #ifdef USE_CUDA
   } else if (device.type() == at::kCUDA) {
     work = std::make_shared<AsyncGatherCUDAWork>(
-        context, outputs, inputs, opts.rootRank, nextTag());
+        context, outputs, inputs, opts.rootRank, tag);
 #endif
   } else {
     throw std::runtime_error("Invalid backend");
@@ -1371,14 +1594,15 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::scatter(
   }
 
   std::shared_ptr<AsyncScatterWork> work;
-  auto& context = contexts_[0];
+  const auto tag = nextTag();
+  auto context = getContext(tag);
   if (device.type() == at::kCPU) {
     work = std::make_shared<AsyncScatterWork>(
-        context, outputs, inputs, opts.rootRank, nextTag());
+        context, outputs, inputs, opts.rootRank, tag);
 #ifdef USE_CUDA
   } else if (device.type() == at::kCUDA) {
     work = std::make_shared<AsyncScatterCUDAWork>(
-        context, outputs, inputs, opts.rootRank, nextTag());
+        context, outputs, inputs, opts.rootRank, tag);
 #endif
   } else {
     throw std::runtime_error("Invalid backend");
@@ -1387,11 +1611,228 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::scatter(
   return work;
 }
 
+namespace {
+
+// Unbound buffer slots used by exchange(). User tags for send/recv are 32
+// bits and the gloo collectives use small slot prefixes, so this prefix
+// collides with neither.
+constexpr uint64_t kExchangeSlotPrefix = 0x80;
+
+// Sends sends[i] to rank i and receives recvs[i] from rank i, as pairs of
+// pointer and size in bytes. Empty chunks are skipped; the local chunk is
+// copied.
+void exchange(
+    const std::shared_ptr<gloo::Context>& context,
+    uint32_t tag,
+    const std::vector<std::pair<void*, size_t>>& sends,
+    const std::vector<std::pair<void*, size_t>>& recvs) {
+  const uint64_t slot = (kExchangeSlotPrefix << 56) | tag;
+  std::vector<std::unique_ptr<gloo::transport::UnboundBuffer>> sendBuffers;
+  std::vector<std::unique_ptr<gloo::transport::UnboundBuffer>> recvBuffers;
+  for (int i = 0; i < context->size; i++) {
+    if (i == context->rank) {
+      if (recvs[i].second != sends[i].second) {
+        throw std::invalid_argument(
+            "the local split must have the same size in input and output");
+      }
+      if (sends[i].second > 0) {
+        memcpy(recvs[i].first, sends[i].first, sends[i].second);
+      }
+      continue;
+    }
+    if (recvs[i].second > 0) {
+      recvBuffers.push_back(
+          context->createUnboundBuffer(recvs[i].first, recvs[i].second));
+      recvBuffers.back()->recv(i, slot);
+    }
+    if (sends[i].second > 0) {
+      sendBuffers.push_back(
+          context->createUnboundBuffer(sends[i].first, sends[i].second));
+      sendBuffers.back()->send(i, slot);
+    }
+  }
+  for (auto& buffer : sendBuffers) {
+    buffer->waitSend();
+  }
+  for (auto& buffer : recvBuffers) {
+    buffer->waitRecv();
+  }
+}
+
+class AsyncReduceScatterWork : public ProcessGroupGloo::AsyncWork {
+ public:
+  AsyncReduceScatterWork(
+      const std::shared_ptr<gloo::Context>& context,
+      std::vector<at::Tensor>& outputs,
+      std::vector<std::vector<at::Tensor>>& inputs,
+      ReduceOp reduceOp,
+      uint32_t tag)
+      : context(context),
+        outputs(outputs),
+        inputs(inputs),
+        reduceOp(reduceOp),
+        tag(tag) {}
+
+  std::shared_ptr<gloo::Context> context;
+  std::vector<at::Tensor> outputs;
+  std::vector<std::vector<at::Tensor>> inputs;
+  const ReduceOp reduceOp;
+  const uint32_t tag;
+
+  void run() override {
+    // Every rank sends the i-th input to rank i and reduces the inputs it
+    // receives, which moves as many bytes as a ring reduce-scatter.
+    auto& output = outputs[0];
+    const auto nbytes = output.numel() * output.element_size();
+    std::vector<at::Tensor> received(context->size);
+    std::vector<std::pair<void*, size_t>> sends(context->size);
+    std::vector<std::pair<void*, size_t>> recvs(context->size);
+    for (int i = 0; i < context->size; i++) {
+      if (i == context->rank) {
+        continue;
+      }
+      received[i] = at::empty_like(output);
+      sends[i] = {inputs[0][i].data_ptr(), nbytes};
+      recvs[i] = {received[i].data_ptr(), nbytes};
+    }
+    exchange(context, tag, sends, recvs);
+
+    output.copy_(inputs[0][context->rank]);
+    for (int i = 0; i < context->size; i++) {
+      if (i != context->rank) {
+        combine(output, received[i]);
+      }
+    }
+  }
+
+  void combine(at::Tensor& output, const at::Tensor& input) {
+    switch (reduceOp) {
+      case ReduceOp::SUM:
+        output.add_(input);
+        return;
+      case ReduceOp::PRODUCT:
+        output.mul_(input);
+        return;
+      case ReduceOp::MIN:
+        at::min_out(output, output, input);
+        return;
+      case ReduceOp::MAX:
+        at::max_out(output, output, input);
+        return;
+      case ReduceOp::UNUSED:
+        break;
+    }
+    throw std::runtime_error("Unhandled ReduceOp");
+  }
+};
+
+class AsyncAlltoallWork : public ProcessGroupGloo::AsyncWork {
+ public:
+  AsyncAlltoallWork(
+      const std::shared_ptr<gloo::Context>& context,
+      at::Tensor& output,
+      at::Tensor& input,
+      std::vector<int64_t> outputCounts,
+      std::vector<int64_t> inputCounts,
+      uint32_t tag)
+      : context(context),
+        output(output),
+        input(input),
+        outputCounts(std::move(outputCounts)),
+        inputCounts(std::move(inputCounts)),
+        tag(tag) {}
+
+  std::shared_ptr<gloo::Context> context;
+  at::Tensor output;
+  at::Tensor input;
+  const std::vector<int64_t> outputCounts;
+  const std::vector<int64_t> inputCounts;
+  const uint32_t tag;
+
+  void run() override {
+    const size_t elementSize = input.element_size();
+    std::vector<std::pair<void*, size_t>> sends(context->size);
+    std::vector<std::pair<void*, size_t>> recvs(context->size);
+    auto sendPtr = static_cast<char*>(input.data_ptr());
+    auto recvPtr = static_cast<char*>(output.data_ptr());
+    for (int i = 0; i < context->size; i++) {
+      sends[i] = {sendPtr, inputCounts[i] * elementSize};
+      recvs[i] = {recvPtr, outputCounts[i] * elementSize};
+      sendPtr += sends[i].second;
+      recvPtr += recvs[i].second;
+    }
+    exchange(context, tag, sends, recvs);
+  }
+};
+
+} // namespace
+
 std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::reduce_scatter(
     std::vector<at::Tensor>& outputs,
     std::vector<std::vector<at::Tensor>>& inputs,
     const ReduceScatterOptions& opts) {
-  throw std::runtime_error("ProcessGroupGloo does not support reduce_scatter");
+  static auto invalidArgument = [](const std::string& msg) {
+    throw std::invalid_argument("ProcessGroupGloo::reduce_scatter: " + msg);
+  };
+
+  assertSingleElementOutput(invalidArgument, outputs);
+  assertDense(invalidArgument, outputs);
+  assertCPU(invalidArgument, outputs);
+  if (inputs.size() != 1 ||
+      inputs[0].size() != static_cast<size_t>(getSize())) {
+    invalidArgument(
+        "requires a single-element input list "
+        "containing a list with <size> tensors");
+  }
+  const auto& type = outputs[0].type();
+  const auto& sizes = outputs[0].sizes();
+  assertTypeAndSizesMatch(invalidArgument, inputs[0], type, sizes);
+  if (!outputs[0].is_contiguous()) {
+    invalidArgument("requires contiguous tensors");
+  }
+  for (const auto& input : inputs[0]) {
+    if (!input.is_contiguous()) {
+      invalidArgument("requires contiguous tensors");
+    }
+  }
+
+  const auto tag = nextTag();
+  auto work = std::make_shared<AsyncReduceScatterWork>(
+      getContext(tag), outputs, inputs, opts.reduceOp, tag);
+  enqueue(work);
+  return work;
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::alltoall(
+    at::Tensor& outputTensor,
+    at::Tensor& inputTensor,
+    std::vector<int64_t>& outputSplitSizes,
+    std::vector<int64_t>& inputSplitSizes,
+    const AllToAllOptions& /* unused */) {
+  static auto invalidArgument = [](const std::string& msg) {
+    throw std::invalid_argument("ProcessGroupGloo::alltoall: " + msg);
+  };
+
+  for (const auto& tensor : {outputTensor, inputTensor}) {
+    assertDense(invalidArgument, tensor);
+    assertCPU(invalidArgument, tensor);
+  }
+  if (outputTensor.type() != inputTensor.type()) {
+    invalidArgument("requires input and output of the same type");
+  }
+  auto outputCounts = alltoallCounts(outputTensor, outputSplitSizes, size_);
+  auto inputCounts = alltoallCounts(inputTensor, inputSplitSizes, size_);
+
+  const auto tag = nextTag();
+  auto work = std::make_shared<AsyncAlltoallWork>(
+      getContext(tag),
+      outputTensor,
+      inputTensor,
+      std::move(outputCounts),
+      std::move(inputCounts),
+      tag);
+  enqueue(work);
+  return work;
 }
 
 at::Tensor& checkSingleTensor(std::vector<at::Tensor>& tensors) {
@@ -1526,8 +1967,9 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::barrier(
     priorWork.insert(priorWork.end(), workQueue_.begin(), workQueue_.end());
   }
 
+  const auto tag = nextTag();
   auto work = std::make_shared<AsyncBarrierWork>(
-      contexts_[0], std::move(priorWork), nextTag());
+      getContext(tag), std::move(priorWork), tag);
   enqueue(work);
   return work;
 }
@@ -13,6 +13,7 @@
 #include <gloo/rendezvous/store.h>
 #include <gloo/transport/device.h>
 
+#include <c10/util/StaticTracepoint.h>
 #include <torch/csrc/utils/hash.h>
 
 #ifdef USE_CUDA
@@ -69,6 +70,7 @@ class ProcessGroupGloo : public ProcessGroup {
   class AsyncWork : public ProcessGroup::Work {
    public:
     static void execute(std::shared_ptr<AsyncWork> work) {
+      C10_SDT(c10d_collective_start, work.get(), "gloo");
       std::exception_ptr eptr;
       try {
         work->run();
@@ -119,12 +121,41 @@ class ProcessGroupGloo : public ProcessGroup {
     int srcRank_;
   };
 
+  // Large allreduce and broadcast operations are split in chunks that run
+  // as separate collectives, so they use all worker threads and devices.
+  // This work object completes when all of its chunks have completed, and
+  // holds the exception of the first chunk that failed.
+  class ChunkedWork : public ProcessGroup::Work {
+   public:
+    explicit ChunkedWork(std::vector<std::shared_ptr<AsyncWork>> chunks);
+
+    bool isCompleted() override;
+
+    bool isSuccess() const override;
+
+    std::exception_ptr exception() const override;
+
+    void wait() override;
+
+   protected:
+    std::vector<std::shared_ptr<AsyncWork>> chunks_;
+  };
+
   struct Options {
     explicit Options();
 
     std::vector<std::shared_ptr<::gloo::transport::Device>> devices;
     std::chrono::milliseconds timeout;
     int threads;
+
+    // Allreduce and broadcast operations on CPU tensors of at least twice
+    // this many bytes are split in up to `threads` chunks of at least this
+    // many bytes, which run concurrently over the worker threads and are
+    // spread round robin over the devices. Allreduce operations on CUDA
+    // tensors are staged through host memory in chunks of at least this
+    // many bytes, so the copies overlap with the transfers. Zero disables
+    // the splitting. Must be the same on all processes.
+    size_t minChunkBytes;
   };
 
   explicit ProcessGroupGloo(
@@ -167,6 +198,13 @@ class ProcessGroupGloo : public ProcessGroup {
       std::vector<std::vector<at::Tensor>>& inputs,
       const ReduceScatterOptions& opts = ReduceScatterOptions()) override;
 
+  std::shared_ptr<ProcessGroup::Work> alltoall(
+      at::Tensor& outputTensor,
+      at::Tensor& inputTensor,
+      std::vector<int64_t>& outputSplitSizes,
+      std::vector<int64_t>& inputSplitSizes,
+      const AllToAllOptions& opts = AllToAllOptions()) override;
+
   std::shared_ptr<ProcessGroup::Work> send(
       std::vector<at::Tensor>& tensors,
       int dstRank,
@@ -199,6 +237,17 @@ class ProcessGroupGloo : public ProcessGroup {
   // Returns next collective tag to use (uses collectiveCounter_).
   uint32_t nextTag();
 
+  // Returns the context to run the collective with the given tag on.
+  // Collectives are spread round robin over the contexts, which use one
+  // device each.
+  std::shared_ptr<::gloo::Context> getContext(uint32_t tag);
+
+  // Returns in how many chunks to split an allreduce or broadcast of
+  // `tensors` (see Options::minChunkBytes).
+  size_t numChunks(const std::vector<at::Tensor>& tensors) const;
+
+  const size_t minChunkBytes_;
+
   // Entrypoint for worker threads.
   void runLoop(int workerIndex);
 
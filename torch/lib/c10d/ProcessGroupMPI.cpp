@@ -1,9 +1,13 @@
 #include <c10d/ProcessGroupMPI.hpp>
 
+#include <chrono>
+#include <cstdlib>
 #include <map>
 
 #if defined(OPEN_MPI) && OPEN_MPI
 #include <mpi-ext.h> // Needed for CUDA-aware check
+
+#include <c10/util/StaticTracepoint.h>
 #endif
 
 namespace c10d {
@@ -21,6 +25,13 @@ namespace c10d {
 
 namespace {
 
+constexpr const char* C10D_MPI_NONBLOCKING = "C10D_MPI_NONBLOCKING";
+
+// How long the worker thread waits for new work between two polls of the
+// outstanding requests. Most MPI implementations only progress inside MPI
+// calls, so this is short.
+constexpr auto kProgressInterval = std::chrono::microseconds(10);
+
 // Op mapping
 std::map<ReduceOp, MPI_Op> mpiOp = {
     {ReduceOp::MIN, MPI_MIN},
@@ -236,11 +247,19 @@ std::shared_ptr<ProcessGroupMPI> ProcessGroupMPI::createProcessGroupMPI(
 }
 
 ProcessGroupMPI::ProcessGroupMPI(int rank, int size, MPI_Comm pgComm)
-    : ProcessGroup(rank, size), stop_(false), pgComm_(pgComm) {
+    : ProcessGroup(rank, size),
+      stop_(false),
+      nonblocking_(false),
+      pgComm_(pgComm) {
   if (pgComm_ == MPI_COMM_NULL) {
     throw std::runtime_error("pgComm_ must not be MPI_COMM_NULL");
   }
 
+  const char* nonblocking = std::getenv(C10D_MPI_NONBLOCKING);
+  if (nonblocking != nullptr && std::string(nonblocking) == "1") {
+    nonblocking_ = true;
+  }
+
   // Start the worker thread accepting MPI calls
   workerThread_ = std::thread(&ProcessGroupMPI::runLoop, this);
 }
@@ -272,9 +291,19 @@ void ProcessGroupMPI::abort() {
 void ProcessGroupMPI::runLoop() {
   std::unique_lock<std::mutex> lock(pgMutex_);
 
-  while (!stop_) {
+  // The outstanding work still completes after destroy() signals stop
+  while (!stop_ || !outstanding_.empty()) {
     if (queue_.empty()) {
-      queueProduceCV_.wait(lock);
+      if (outstanding_.empty()) {
+        queueProduceCV_.wait(lock);
+        continue;
+      }
+      lock.unlock();
+      const bool completed = progress();
+      lock.lock();
+      if (!completed && queue_.empty()) {
+        queueProduceCV_.wait_for(lock, kProgressInterval);
+      }
       continue;
     }
 
@@ -289,8 +318,14 @@ void ProcessGroupMPI::runLoop() {
     queueConsumeCV_.notify_one();
 
     try {
+      C10_SDT(c10d_collective_start, work.get(), "mpi");
       workEntry->run(workEntry);
-      work->finish();
+      if (workEntry->request != MPI_REQUEST_NULL) {
+        requests_.push_back(workEntry->request);
+        outstanding_.push_back(std::move(workTuple));
+      } else {
+        work->finish();
+      }
     } catch (...) {
       work->finish(std::current_exception());
     }
@@ -299,6 +334,76 @@ void ProcessGroupMPI::runLoop() {
   }
 }
 
+bool ProcessGroupMPI::progress() {
+  int count = 0;
+  std::vector<int> indices(requests_.size());
+  std::vector<MPI_Status> statuses(requests_.size());
+  std::vector<std::exception_ptr> errors(requests_.size());
+  {
+    std::unique_lock<std::mutex> globalLock(pgGlobalMutex_);
+    auto error = [](int code) {
+      std::array<char, MPI_MAX_ERROR_STRING> buf;
+      int len = buf.size();
+      MPI_CHECK(MPI_Error_string(code, buf.data(), &len));
+      return std::make_exception_ptr(
+          std::runtime_error(std::string(buf.data(), len)));
+    };
+    const int result = MPI_Testsome(
+        requests_.size(),
+        requests_.data(),
+        &count,
+        indices.data(),
+        statuses.data());
+    if (result != MPI_SUCCESS && result != MPI_ERR_IN_STATUS) {
+      // Nothing tells which requests failed, fail them all
+      count = requests_.size();
+      for (int i = 0; i < count; ++i) {
+        indices[i] = i;
+        errors[i] = error(result);
+      }
+    } else if (count == MPI_UNDEFINED) {
+      count = 0;
+    } else if (result == MPI_ERR_IN_STATUS) {
+      for (int i = 0; i < count; ++i) {
+        if (statuses[i].MPI_ERROR != MPI_SUCCESS) {
+          errors[i] = error(statuses[i].MPI_ERROR);
+        }
+      }
+    }
+  }
+
+  std::vector<bool> completed(requests_.size(), false);
+  for (int i = 0; i < count; ++i) {
+    completed[indices[i]] = true;
+    auto& workEntry = std::get<0>(outstanding_[indices[i]]);
+    auto& work = std::get<1>(outstanding_[indices[i]]);
+    try {
+      if (errors[i]) {
+        std::rethrow_exception(errors[i]);
+      }
+      if (workEntry->complete) {
+        workEntry->complete(workEntry);
+      }
+      work->finish();
+    } catch (...) {
+      work->finish(std::current_exception());
+    }
+  }
+
+  // Keep the remaining work in the order it was started
+  size_t remaining = 0;
+  for (size_t i = 0; i < requests_.size(); ++i) {
+    if (!completed[i]) {
+      requests_[remaining] = requests_[i];
+      outstanding_[remaining] = std::move(outstanding_[i]);
+      ++remaining;
+    }
+  }
+  requests_.resize(remaining);
+  outstanding_.resize(remaining);
+  return count > 0;
+}
+
 std::shared_ptr<ProcessGroup::Work> ProcessGroupMPI::enqueue(
     std::unique_ptr<WorkEntry> entry) {
   auto work = std::make_shared<WorkMPI>();
@@ -317,6 +422,16 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupMPI::broadcast(
       [opts, this](std::unique_ptr<WorkEntry>& entry) {
         auto data = (entry->src)[0];
         std::unique_lock<std::mutex> globalLock(pgGlobalMutex_);
+        if (nonblocking_) {
+          MPI_CHECK(MPI_Ibcast(
+              data.data_ptr(),
+              data.numel(),
+              mpiDatatype.at(data.scalar_type()),
+              opts.rootRank,
+              pgComm_,
+              &entry->request));
+          return;
+        }
         MPI_CHECK(MPI_Bcast(
             data.data_ptr(),
             data.numel(),
@@ -338,6 +453,17 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupMPI::allreduce(
       [opts, this](std::unique_ptr<WorkEntry>& entry) {
         auto data = (entry->src)[0];
         std::unique_lock<std::mutex> globalLock(pgGlobalMutex_);
+        if (nonblocking_) {
+          MPI_CHECK(MPI_Iallreduce(
+              MPI_IN_PLACE,
+              data.data_ptr(),
+              data.numel(),
+              mpiDatatype.at(data.scalar_type()),
+              mpiOp.at(opts.reduceOp),
+              pgComm_,
+              &entry->request));
+          return;
+        }
         MPI_CHECK(MPI_Allreduce(
             MPI_IN_PLACE,
             data.data_ptr(),
@@ -364,6 +490,18 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupMPI::reduce(
         void* recvbuf = (rank_ == opts.rootRank) ? dataPtr : nullptr;
 
         std::unique_lock<std::mutex> globalLock(pgGlobalMutex_);
+        if (nonblocking_) {
+          MPI_CHECK(MPI_Ireduce(
+              sendbuf,
+              recvbuf,
+              data.numel(),
+              mpiDatatype.at(data.scalar_type()),
+              mpiOp.at(opts.reduceOp),
+              opts.rootRank,
+              pgComm_,
+              &entry->request));
+          return;
+        }
         MPI_CHECK(MPI_Reduce(
             sendbuf,
             recvbuf,
@@ -403,6 +541,24 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupMPI::allgather(
         auto flatOutputTensor = newLikeFlat(outputDataVec);
 
         std::unique_lock<std::mutex> globalLock(pgGlobalMutex_);
+        if (nonblocking_) {
+          MPI_CHECK(MPI_Iallgather(
+              data.data_ptr(),
+              data.numel(),
+              mpiDatatype.at(data.scalar_type()),
+              flatOutputTensor.data_ptr(),
+              data.numel(),
+              mpiDatatype.at(data.scalar_type()),
+              pgComm_,
+              &entry->request));
+          entry->complete = [flatOutputTensor](
+                                std::unique_ptr<WorkEntry>& completed) {
+            for (size_t i = 0; i < completed->dst.size(); ++i) {
+              completed->dst[i].copy_(flatOutputTensor[i]);
+            }
+          };
+          return;
+        }
         MPI_CHECK(MPI_Allgather(
             data.data_ptr(),
             data.numel(),
@@ -556,7 +712,108 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupMPI::reduce_scatter(
     std::vector<at::Tensor>& outputTensors,
     std::vector<std::vector<at::Tensor>>& inputTensors,
     const ReduceScatterOptions& opts) {
-  throw std::runtime_error("ProcessGroupMPI does not support reduce_scatter");
+  checkSingleTensor(outputTensors);
+  if (inputTensors.size() != 1) {
+    throw std::runtime_error(
+        "Reduce_scatter: multi-GPU collective is not supported");
+  }
+  if (static_cast<size_t>(size_) != inputTensors[0].size()) {
+    throw std::runtime_error(
+        "Reduce_scatter: number of input tensors should equal "
+        "to the world size");
+  }
+  checkSameSizeAndType(outputTensors[0], inputTensors[0]);
+
+  std::function<void(std::unique_ptr<WorkEntry>&)> runFunc =
+      [opts, this](std::unique_ptr<WorkEntry>& entry) {
+        auto data = (entry->dst)[0];
+        std::vector<at::Tensor>& inputDataVec = entry->src;
+        auto flatInputTensor = newLikeFlat(inputDataVec);
+
+        // copy the input tensors to the flatten large send buffer
+        for (size_t i = 0; i < inputDataVec.size(); ++i) {
+          flatInputTensor[i].copy_(inputDataVec.at(i));
+        }
+
+        std::unique_lock<std::mutex> globalLock(pgGlobalMutex_);
+        MPI_CHECK(MPI_Reduce_scatter_block(
+            flatInputTensor.data_ptr(),
+            data.data_ptr(),
+            data.numel(),
+            mpiDatatype.at(data.scalar_type()),
+            mpiOp.at(opts.reduceOp),
+            pgComm_));
+      };
+
+  auto entry = std::unique_ptr<WorkEntry>(
+      new WorkEntry(&inputTensors[0], &outputTensors, std::move(runFunc)));
+  return enqueue(std::move(entry));
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupMPI::alltoall(
+    at::Tensor& outputTensor,
+    at::Tensor& inputTensor,
+    std::vector<int64_t>& outputSplitSizes,
+    std::vector<int64_t>& inputSplitSizes,
+    const AllToAllOptions& opts) {
+  checkSingleTensorHelper(outputTensor);
+  checkSingleTensorHelper(inputTensor);
+  if (outputTensor.type() != inputTensor.type()) {
+    throw std::runtime_error(
+        "Alltoall: input and output should have the same type");
+  }
+  auto outputCounts = alltoallCounts(outputTensor, outputSplitSizes, size_);
+  auto inputCounts = alltoallCounts(inputTensor, inputSplitSizes, size_);
+  const bool equalSplits = outputSplitSizes.empty() && inputSplitSizes.empty();
+
+  std::function<void(std::unique_ptr<WorkEntry>&)> runFunc =
+      [outputCounts, inputCounts, equalSplits, this](
+          std::unique_ptr<WorkEntry>& entry) {
+        auto input = (entry->src)[0];
+        auto output = (entry->dst)[0];
+        auto datatype = mpiDatatype.at(input.scalar_type());
+
+        std::unique_lock<std::mutex> globalLock(pgGlobalMutex_);
+        if (equalSplits) {
+          MPI_CHECK(MPI_Alltoall(
+              input.data_ptr(),
+              inputCounts[0],
+              datatype,
+              output.data_ptr(),
+              outputCounts[0],
+              datatype,
+              pgComm_));
+          return;
+        }
+
+        // MPI takes int counts and displacements, in elements
+        std::vector<int> sendCounts(size_), sendDispls(size_);
+        std::vector<int> recvCounts(size_), recvDispls(size_);
+        for (int i = 0; i < size_; ++i) {
+          sendCounts[i] = static_cast<int>(inputCounts[i]);
+          recvCounts[i] = static_cast<int>(outputCounts[i]);
+          if (i > 0) {
+            sendDispls[i] = sendDispls[i - 1] + sendCounts[i - 1];
+            recvDispls[i] = recvDispls[i - 1] + recvCounts[i - 1];
+          }
+        }
+        MPI_CHECK(MPI_Alltoallv(
+            input.data_ptr(),
+            sendCounts.data(),
+            sendDispls.data(),
+            datatype,
+            output.data_ptr(),
+            recvCounts.data(),
+            recvDispls.data(),
+            datatype,
+            pgComm_));
+      };
+
+  std::vector<at::Tensor> inputTensors = {inputTensor};
+  std::vector<at::Tensor> outputTensors = {outputTensor};
+  auto entry = std::unique_ptr<WorkEntry>(
+      new WorkEntry(&inputTensors, &outputTensors, std::move(runFunc)));
+  return enqueue(std::move(entry));
 }
 
 std::shared_ptr<ProcessGroup::Work> ProcessGroupMPI::send(
@@ -635,6 +892,10 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupMPI::barrier(
   std::function<void(std::unique_ptr<WorkEntry>&)> runFunc =
       [this](std::unique_ptr<WorkEntry>& entry) {
         std::unique_lock<std::mutex> globalLock(pgGlobalMutex_);
+        if (nonblocking_) {
+          MPI_CHECK(MPI_Ibarrier(pgComm_, &entry->request));
+          return;
+        }
         MPI_CHECK(MPI_Barrier(pgComm_));
       };
   auto entry = std::unique_ptr<WorkEntry>(
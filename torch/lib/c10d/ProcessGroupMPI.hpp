@@ -44,6 +44,11 @@ struct WorkEntry {
   // src rank returned, for recv only
   int* srcRank = nullptr;
   std::function<void(std::unique_ptr<WorkEntry>&)> run;
+
+  // Set by run when it only starts a non-blocking MPI operation: the work
+  // completes with the request, after calling complete (if any) on the entry
+  MPI_Request request = MPI_REQUEST_NULL;
+  std::function<void(std::unique_ptr<WorkEntry>&)> complete;
 };
 
 // ProcessGroupMPI implements MPI bindings for c10d.
@@ -70,6 +75,14 @@ struct WorkEntry {
 //
 // CUDA tensor can be supported if the MPI used is CUDA-aware MPI, and
 // ProcessGroupMPI will automatically detect this support.
+//
+// With C10D_MPI_NONBLOCKING=1 in the environment, the worker thread starts
+// broadcast, allreduce, reduce, allgather and barrier with the non-blocking
+// MPI-3 collectives (MPI_Ibcast etc.) instead of running them to completion,
+// and polls the outstanding requests with MPI_Testsome while its queue is
+// empty. Many collectives can then be in flight at the same time, and overlap
+// with the computation of the caller. They are still started in the order of
+// the calls, from the worker thread, so the same threading support is needed.
 class ProcessGroupMPI : public ProcessGroup {
  public:
   class WorkMPI : public ProcessGroup::Work {
@@ -138,6 +151,13 @@ class ProcessGroupMPI : public ProcessGroup {
       std::vector<std::vector<at::Tensor>>& inputTensors,
       const ReduceScatterOptions& opts = ReduceScatterOptions()) override;
 
+  std::shared_ptr<ProcessGroup::Work> alltoall(
+      at::Tensor& outputTensor,
+      at::Tensor& inputTensor,
+      std::vector<int64_t>& outputSplitSizes,
+      std::vector<int64_t>& inputSplitSizes,
+      const AllToAllOptions& opts = AllToAllOptions()) override;
+
   std::shared_ptr<ProcessGroup::Work> send(
       std::vector<at::Tensor>& tensors,
       int dstRank,
@@ -169,8 +189,17 @@ class ProcessGroupMPI : public ProcessGroup {
 
   std::shared_ptr<ProcessGroup::Work> enqueue(std::unique_ptr<WorkEntry> entry);
 
+  // Tests the requests of the outstanding work and finishes the completed
+  // ones, returns whether any did complete. Called by the worker thread
+  // without pgMutex_.
+  bool progress();
+
   bool stop_;
 
+  // Whether the collectives are started non-blocking, from
+  // C10D_MPI_NONBLOCKING
+  bool nonblocking_;
+
   std::mutex pgMutex_;
   std::thread workerThread_;
 
@@ -178,6 +207,11 @@ class ProcessGroupMPI : public ProcessGroup {
   std::condition_variable queueProduceCV_;
   std::condition_variable queueConsumeCV_;
 
+  // The work started non-blocking and not completed yet, and its requests,
+  // only used by the worker thread
+  std::vector<WorkType> outstanding_;
+  std::vector<MPI_Request> requests_;
+
   // Global states
   static void initMPIOnce();
   static void mpiExit();
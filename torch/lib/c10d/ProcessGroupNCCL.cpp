@@ -1,5 +1,7 @@
 #include <c10d/ProcessGroupNCCL.hpp>
 
+#include <cstdlib>
+#include <iterator>
 #include <map>
 #include <tuple>
 #include <unordered_set>
@@ -8,6 +10,7 @@
 
 #include <ATen/cuda/CUDAContext.h>
 #include <c10/cuda/CUDAGuard.h>
+#include <c10/util/StaticTracepoint.h>
 
 #include <c10d/Utils.hpp>
 
@@ -15,6 +18,17 @@ namespace c10d {
 
 namespace {
 
+// Environment variable which makes WorkNCCL::wait() block the host
+constexpr const char* NCCL_BLOCKING_WAIT = "NCCL_BLOCKING_WAIT";
+
+// Environment variable which makes the work record timing events
+constexpr const char* NCCL_ENABLE_TIMING = "NCCL_ENABLE_TIMING";
+
+// How often the watchdog polls the outstanding work, and the blocking waits
+// poll their work
+constexpr auto kWatchdogSleep = std::chrono::milliseconds(100);
+constexpr auto kSynchronizeBusyWait = std::chrono::milliseconds(10);
+
 // NCCL op mapping
 std::map<ReduceOp, ncclRedOp_t> ncclOp = {
     {ReduceOp::MIN, ncclMin},
@@ -93,29 +107,113 @@ void syncStreams(
 
 } // namespace
 
-ProcessGroupNCCL::WorkNCCL::WorkNCCL(const std::vector<at::Device>& devices)
-    : devices_(devices) {
+ProcessGroupNCCL::WorkNCCL::WorkNCCL(
+    const std::vector<at::Device>& devices,
+    bool enableTiming)
+    : devices_(devices),
+      enableTiming_(enableTiming),
+      workStartTime_(std::chrono::steady_clock::now()),
+      opTimeout_(Store::kNoTimeout),
+      blockingWait_(false) {
   // Creates the CUDA event wrappers
   // Note: The actual events are lazily created when first recorded to with
-  // DEFAULT_FLAGS = cudaEventDisableTiming.
-  cudaEvents_.resize(devices.size());
+  // DEFAULT_FLAGS = cudaEventDisableTiming, unless the work is timed.
+  const auto flags = enableTiming ? cudaEventDefault
+                                  : at::cuda::CUDAEvent::DEFAULT_FLAGS;
+  cudaEvents_.reserve(devices.size());
+  for (size_t i = 0; i < devices.size(); ++i) {
+    cudaEvents_.emplace_back(flags);
+    if (enableTiming) {
+      ncclStartEvents_.emplace_back(flags);
+    }
+  }
 }
 
 ProcessGroupNCCL::WorkNCCL::~WorkNCCL() {}
 
 bool ProcessGroupNCCL::WorkNCCL::isCompleted() {
-  return finishedGPUExecution();
+  checkAndSetException();
+  return exception() || finishedGPUExecution();
 }
 
 bool ProcessGroupNCCL::WorkNCCL::isSuccess() const {
-  return true;
+  return !exception();
 }
 
 std::exception_ptr ProcessGroupNCCL::WorkNCCL::exception() const {
-  throw std::runtime_error(
-      "exception() is not supported by NCCL process "
-      "group's work, since isSuccess() will always return true, and "
-      "isCompleted() and wait() will either succeed or throw");
+  std::lock_guard<std::mutex> lock(mutex_);
+  return exception_;
+}
+
+float ProcessGroupNCCL::WorkNCCL::getDuration() const {
+  if (!enableTiming_) {
+    return -1;
+  }
+  if (!cudaEvents_[0].query()) {
+    throw std::runtime_error(
+        "getDuration() must be called once the NCCL kernels have finished");
+  }
+  float duration = 0;
+  AT_CUDA_CHECK(
+      cudaEventElapsedTime(&duration, ncclStartEvents_[0], cudaEvents_[0]));
+  return duration;
+}
+
+void ProcessGroupNCCL::WorkNCCL::setException(std::exception_ptr exception) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Keep the first error, the later ones are often caused by it
+  if (!exception_) {
+    exception_ = exception;
+  }
+}
+
+void ProcessGroupNCCL::WorkNCCL::checkAndSetException() {
+  if (exception()) {
+    return;
+  }
+  try {
+    for (const auto& ncclComm : ncclComms_) {
+      if (ncclComm->isAborted()) {
+        throw std::runtime_error(
+            "NCCL communicator was aborted, after an error or a timeout of "
+            "one of its operations");
+      }
+      const auto error = ncclComm->checkForNcclError();
+      if (error != ncclSuccess) {
+        throw std::runtime_error(
+            "NCCL error: " + std::string(ncclGetErrorString(error)));
+      }
+    }
+  } catch (...) {
+    setException(std::current_exception());
+  }
+}
+
+bool ProcessGroupNCCL::WorkNCCL::timedOut() const {
+  return opTimeout_ != Store::kNoTimeout &&
+      std::chrono::steady_clock::now() - workStartTime_ > opTimeout_;
+}
+
+void ProcessGroupNCCL::WorkNCCL::abortNCCLComms() {
+  // The peers, or this process, can't complete the work, so make its
+  // kernels, and the later ones on the same communicators, return
+  for (auto& ncclComm : ncclComms_) {
+    try {
+      ncclComm->ncclCommAbort();
+    } catch (...) {
+      // The work already has an error to report
+    }
+  }
+}
+
+void ProcessGroupNCCL::WorkNCCL::setTimedOut() {
+  auto exception = std::make_exception_ptr(std::runtime_error(
+      "NCCL operation timed out after " + std::to_string(opTimeout_.count()) +
+      " ms"));
+  // Abort first, so that the operations enqueued after seeing the error
+  // throw instead of hanging
+  abortNCCLComms();
+  setException(exception);
 }
 
 // Helper that checks if the NCCL kernels are completed on the GPUs
@@ -139,17 +237,40 @@ void ProcessGroupNCCL::WorkNCCL::synchronize() {
     auto currentStream = at::cuda::getCurrentCUDAStream(devices_[i].index());
     // Block the current stream on the NCCL stream
     cudaEvents_[i].block(currentStream);
-    // If we use the work to do barrier, we should block here
-    if (!barrierTensors_.empty()) {
-      at::cuda::CUDAGuard gpuGuard(devices_[i]);
+  }
+
+  // Poll rather than synchronize the devices, so that an error or a timeout
+  // is reported instead of hanging
+  if (blockingWait_) {
+    while (!isCompleted()) {
+      if (timedOut()) {
+        setTimedOut();
+        break;
+      }
+      std::this_thread::sleep_for(kSynchronizeBusyWait);
+    }
+    if (exception()) {
+      std::rethrow_exception(exception());
+    }
+  }
+
+  // If we use the work to do barrier, we should block here
+  if (!barrierTensors_.empty()) {
+    at::cuda::OptionalCUDAGuard gpuGuard;
+    for (const auto& device : devices_) {
+      gpuGuard.set_index(device.index());
       AT_CUDA_CHECK(cudaDeviceSynchronize());
     }
   }
 }
 
-// Same as calling synchronize().
+// Same as calling synchronize(), then reports the errors detected so far
 void ProcessGroupNCCL::WorkNCCL::wait() {
   synchronize();
+  checkAndSetException();
+  if (exception()) {
+    std::rethrow_exception(exception());
+  }
 }
 
 std::unordered_map<std::string, ssize_t> ProcessGroupNCCL::pgUniqueNCCLIDCnt_;
@@ -162,8 +283,23 @@ ProcessGroupNCCL::ProcessGroupNCCL(
     const std::shared_ptr<Store>& store,
     int rank,
     int size,
-    const std::string& groupName)
-    : ProcessGroup(rank, size), store_(store), groupName_(groupName) {
+    const std::string& groupName,
+    int localSize,
+    const std::chrono::milliseconds& opTimeout)
+    : ProcessGroup(rank, size),
+      store_(store),
+      groupName_(groupName),
+      localSize_(localSize),
+      opTimeout_(opTimeout),
+      blockingWait_(false),
+      enableTiming_(false),
+      terminateWatchdog_(false) {
+  if (localSize_ < 0 || (localSize_ > 1 && size % localSize_ != 0)) {
+    throw std::runtime_error(
+        "Invalid local size for hierarchical allreduce, the process group "
+        "size must be a multiple of it");
+  }
+
   // Generate the Process Group ID for current PG, this needs to be identical
   // for all processes
   std::unique_lock<std::mutex> lock(pgTrackingLock_);
@@ -176,14 +312,79 @@ ProcessGroupNCCL::ProcessGroupNCCL(
   processGroupID_ = std::to_string(processGroupCounterMap_[groupKey]);
   groupPgID_ = groupName_ + "_" + processGroupID_;
   pgUniqueNCCLIDCnt_[groupPgID_] = -1;
+  lock.unlock();
+
+  const char* blockingWait = std::getenv(NCCL_BLOCKING_WAIT);
+  if (blockingWait != nullptr && std::string(blockingWait) == "1") {
+    blockingWait_ = true;
+  }
+  const char* enableTiming = std::getenv(NCCL_ENABLE_TIMING);
+  if (enableTiming != nullptr && std::string(enableTiming) == "1") {
+    enableTiming_ = true;
+  }
+
+  watchdogThread_ = std::thread(&ProcessGroupNCCL::ncclCommWatchdog, this);
 }
 
 ProcessGroupNCCL::~ProcessGroupNCCL() {
+  {
+    std::unique_lock<std::mutex> lock(workListMutex_);
+    terminateWatchdog_ = true;
+  }
+  watchdogCV_.notify_one();
+  watchdogThread_.join();
+
   std::unique_lock<std::mutex> lock(pgTrackingLock_);
   pgUniqueNCCLIDCnt_.erase(groupPgID_);
 }
 
+void ProcessGroupNCCL::ncclCommWatchdog() {
+  std::unique_lock<std::mutex> lock(workListMutex_);
+  while (!terminateWatchdog_) {
+    for (auto it = workList_.begin(); it != workList_.end();) {
+      auto& work = *it;
+      bool finished = false;
+      try {
+        work->checkAndSetException();
+        if (!work->exception() && work->timedOut()) {
+          work->setTimedOut();
+        }
+        finished = !work->exception() && work->finishedGPUExecution();
+      } catch (...) {
+        work->setException(std::current_exception());
+      }
+      if (work->exception()) {
+        work->abortNCCLComms();
+        finished = true;
+      }
+      it = finished ? workList_.erase(it) : std::next(it);
+    }
+    watchdogCV_.wait_for(lock, kWatchdogSleep, [this] {
+      return terminateWatchdog_;
+    });
+  }
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::workEnqueue(
+    std::shared_ptr<ProcessGroup::Work> work,
+    const std::chrono::milliseconds& timeout) {
+  auto ncclWork = std::static_pointer_cast<WorkNCCL>(work);
+  ncclWork->opTimeout_ = timeout == kUnsetTimeout ? opTimeout_ : timeout;
+  ncclWork->blockingWait_ = blockingWait_;
+  ncclWork->workStartTime_ = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(workListMutex_);
+  workList_.push_back(std::move(ncclWork));
+  return work;
+}
+
 void ProcessGroupNCCL::broadcastUniqueNCCLID(ncclUniqueId* ncclID) {
+  broadcastUniqueNCCLID(ncclID, rank_ == 0, "");
+}
+
+void ProcessGroupNCCL::broadcastUniqueNCCLID(
+    ncclUniqueId* ncclID,
+    bool isRoot,
+    const std::string& suffix) {
   // Every time when we create a new unique NCCL ID, we need to use a new
   // global key to access/update the store.
   // The key is a combination of processGroupID_ and the current count of
@@ -195,10 +396,10 @@ void ProcessGroupNCCL::broadcastUniqueNCCLID(ncclUniqueId* ncclID) {
   lock.unlock();
 
   std::string storeKey =
-      processGroupID_ + "_" + std::to_string(uniqueNCCLIDCnt);
+      processGroupID_ + "_" + std::to_string(uniqueNCCLIDCnt) + suffix;
 
-  // Rank 0 writes to the store as bcast
-  if (rank_ == 0) {
+  // The root writes to the store as bcast
+  if (isRoot) {
     auto ncclIDVal = std::vector<uint8_t>(
         reinterpret_cast<uint8_t*>(ncclID),
         reinterpret_cast<uint8_t*>(ncclID) + NCCL_UNIQUE_ID_BYTES);
@@ -287,6 +488,45 @@ std::vector<std::shared_ptr<NCCLComm>>& ProcessGroupNCCL::getNCCLComm(
   return devNCCLCommMap_[devicesKey];
 }
 
+std::pair<std::shared_ptr<NCCLComm>, std::shared_ptr<NCCLComm>>&
+ProcessGroupNCCL::getHierarchicalNCCLComms(
+    const std::string& devicesKey,
+    at::Device device) {
+  auto it = hierarchicalNCCLComms_.find(devicesKey);
+  if (it != hierarchicalNCCLComms_.end()) {
+    return it->second;
+  }
+
+  const auto node = rank_ / localSize_;
+  const auto localRank = rank_ % localSize_;
+  const auto numNodes = size_ / localSize_;
+
+  // Every rank takes part in both exchanges, in the same order, so that the
+  // unique ID counter stays in sync across the process group.
+  ncclUniqueId intraID;
+  if (localRank == 0) {
+    C10D_NCCL_CHECK(ncclGetUniqueId(&intraID));
+  }
+  broadcastUniqueNCCLID(
+      &intraID, localRank == 0, "_intra_" + std::to_string(node));
+
+  ncclUniqueId interID;
+  if (node == 0) {
+    C10D_NCCL_CHECK(ncclGetUniqueId(&interID));
+  }
+  broadcastUniqueNCCLID(
+      &interID, node == 0, "_inter_" + std::to_string(localRank));
+
+  at::cuda::CUDAGuard gpuGuard(device);
+  auto intraComm = NCCLComm::create(localSize_, localRank, intraID);
+  auto interComm = NCCLComm::create(numNodes, node, interID);
+
+  return hierarchicalNCCLComms_
+      .emplace(
+          devicesKey, std::make_pair(std::move(intraComm), std::move(interComm)))
+      .first->second;
+}
+
 namespace {
 
 // Check that all `tensors' have the same type and shape and are distributed
@@ -373,6 +613,17 @@ std::vector<at::Tensor> flatten_for_scatter_gather(
   return flattened;
 }
 
+// The communicators aborted by the watchdog can't run operations anymore
+void checkNotAborted(const std::vector<std::shared_ptr<NCCLComm>>& ncclComms) {
+  for (const auto& ncclComm : ncclComms) {
+    if (ncclComm->isAborted()) {
+      throw std::runtime_error(
+          "NCCL communicator was aborted, after an error or a timeout of one "
+          "of its operations, the process group must be recreated");
+    }
+  }
+}
+
 }
 
 template<typename Fn, typename PreProcess, typename PostProcess>
@@ -385,12 +636,21 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::collective(
   const auto devices = getDeviceList(inputs);
   const auto key = getKeyFromDevices(devices);
   auto& ncclComms = getNCCLComm(key, devices);
+  checkNotAborted(ncclComms);
 
   // First let NCCL streams wait for input tensors allocation streams
   syncStreams(devices, ncclEvents_[key], ncclStreams_[key]);
 
   // Work itself will create the CUDA events on all GPUs of tensors
-  auto work = std::make_shared<ProcessGroupNCCL::WorkNCCL>(devices);
+  auto work =
+      std::make_shared<ProcessGroupNCCL::WorkNCCL>(devices, enableTiming_);
+  work->ncclComms_ = ncclComms;
+  C10_SDT(c10d_collective_start, work.get(), "nccl");
+  if (enableTiming_) {
+    for (size_t i = 0; i < devices.size(); ++i) {
+      work->ncclStartEvents_[i].record(ncclStreams_[key][i]);
+    }
+  }
 
   at::cuda::OptionalCUDAGuard gpuGuard;
 
@@ -434,6 +694,7 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::collective(
     work->cudaEvents_[i].record(ncclStream);
   }
 
+  C10_SDT(c10d_collective_done, work.get(), 1);
   return work;
 }
 
@@ -454,7 +715,13 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::allreduce(
     const AllreduceOptions& opts) {
   check_gpu_tensors(tensors);
 
-  return collective(tensors, tensors,
+  // Hierarchical allreduce is only implemented for a single device per
+  // process, and doesn't pay off for a single node.
+  if (localSize_ > 1 && localSize_ < size_ && tensors.size() == 1) {
+    return workEnqueue(allreduceHierarchical(tensors, opts), opts.timeout);
+  }
+
+  auto work = collective(tensors, tensors,
     [&] (at::Tensor& input, at::Tensor& output,
          ncclComm_t comm, at::cuda::CUDAStream& stream) {
       return ncclAllReduce(
@@ -468,6 +735,83 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::allreduce(
       );
     }
   );
+  return workEnqueue(std::move(work), opts.timeout);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::allreduceHierarchical(
+    std::vector<at::Tensor>& tensors,
+    const AllreduceOptions& opts) {
+  const auto devices = getDeviceList(tensors);
+  const auto key = getKeyFromDevices(devices);
+  // Also sets up the NCCL streams and events for these devices.
+  getNCCLComm(key, devices);
+  auto& comms = getHierarchicalNCCLComms(key, devices[0]);
+  checkNotAborted({comms.first, comms.second});
+
+  syncStreams(devices, ncclEvents_[key], ncclStreams_[key]);
+
+  auto work =
+      std::make_shared<ProcessGroupNCCL::WorkNCCL>(devices, enableTiming_);
+  work->ncclComms_ = {comms.first, comms.second};
+  if (enableTiming_) {
+    work->ncclStartEvents_[0].record(ncclStreams_[key][0]);
+  }
+
+  at::cuda::CUDAGuard gpuGuard(devices[0]);
+  at::cuda::CUDAStream& ncclStream = ncclStreams_[key][0];
+  at::cuda::CUDAStreamGuard streamGuard(ncclStream);
+  auto& tensor = tensors[0];
+
+  // The node shards the tensor into localSize_ chunks. If the tensor doesn't
+  // divide evenly, work on a zero padded copy allocated on the NCCL stream.
+  const auto numel = tensor.numel();
+  const auto chunk = (numel + localSize_ - 1) / localSize_;
+  const auto localRank = rank_ % localSize_;
+  const auto dataType = getNcclDataType(tensor.scalar_type());
+  at::Tensor buffer = tensor.view({-1});
+  if (chunk * localSize_ != numel) {
+    buffer = at::zeros({chunk * localSize_}, tensor.options());
+    buffer.narrow(0, 0, numel).copy_(tensor.view({-1}), true);
+  }
+  auto shard = buffer.narrow(0, localRank * chunk, chunk);
+
+  std::unique_lock<std::mutex> cudaFreeMutexLock(
+      *(c10::cuda::CUDACachingAllocator::getFreeMutex()));
+
+  // See [Sync Streams].
+  c10::cuda::CUDACachingAllocator::recordStream(
+      tensor.storage().data(), ncclStream);
+
+  C10D_NCCL_CHECK(ncclReduceScatter(
+      buffer.data_ptr(),
+      shard.data_ptr(),
+      chunk,
+      dataType,
+      ncclOp[opts.reduceOp],
+      comms.first->getNcclComm(),
+      ncclStream.stream()));
+  C10D_NCCL_CHECK(ncclAllReduce(
+      shard.data_ptr(),
+      shard.data_ptr(),
+      chunk,
+      dataType,
+      ncclOp[opts.reduceOp],
+      comms.second->getNcclComm(),
+      ncclStream.stream()));
+  C10D_NCCL_CHECK(ncclAllGather(
+      shard.data_ptr(),
+      buffer.data_ptr(),
+      chunk,
+      dataType,
+      comms.first->getNcclComm(),
+      ncclStream.stream()));
+
+  if (chunk * localSize_ != numel) {
+    tensor.view({-1}).copy_(buffer.narrow(0, 0, numel), true);
+  }
+
+  work->cudaEvents_[0].record(ncclStream);
+  return work;
 }
 
 std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::broadcast(
@@ -475,7 +819,7 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::broadcast(
     const BroadcastOptions& opts) {
   check_gpu_tensors(tensors);
 
-  return collective(tensors, tensors,
+  auto work = collective(tensors, tensors,
     [&] (at::Tensor& input, at::Tensor& output,
          ncclComm_t comm, at::cuda::CUDAStream& stream) {
       const auto root = opts.rootRank * tensors.size() + opts.rootTensor;
@@ -489,6 +833,7 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::broadcast(
       );
     }
   );
+  return workEnqueue(std::move(work), opts.timeout);
 }
 
 std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::reduce(
@@ -496,7 +841,7 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::reduce(
     const ReduceOptions& opts) {
   check_gpu_tensors(tensors);
 
-  return collective(tensors, tensors,
+  auto work = collective(tensors, tensors,
     [&] (at::Tensor& input, at::Tensor& output,
          ncclComm_t comm, at::cuda::CUDAStream& stream) {
       const auto root = opts.rootRank * tensors.size() + opts.rootTensor;
@@ -512,6 +857,7 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::reduce(
       );
     }
   );
+  return workEnqueue(std::move(work), opts.timeout);
 }
 
 std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::allgather(
@@ -525,7 +871,7 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::allgather(
   );
   check_gpu_tensors(outputFlattened);
 
-  return collective(inputTensors, outputFlattened,
+  auto work = collective(inputTensors, outputFlattened,
     [&] (at::Tensor& input, at::Tensor& output,
          ncclComm_t comm, at::cuda::CUDAStream& stream) {
       c10::cuda::CUDACachingAllocator::recordStream(
@@ -555,6 +901,7 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::allgather(
       }
     }
   );
+  return workEnqueue(std::move(work), opts.timeout);
 }
 
 std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::reduce_scatter(
@@ -568,7 +915,7 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::reduce_scatter(
   );
   check_gpu_tensors(inputFlattened);
 
-  return collective(inputFlattened, outputTensors,
+  auto work = collective(inputFlattened, outputTensors,
     [&] (at::Tensor& input, at::Tensor& output,
          ncclComm_t comm, at::cuda::CUDAStream& stream) {
       c10::cuda::CUDACachingAllocator::recordStream(
@@ -599,6 +946,68 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::reduce_scatter(
     },
     [&] (std::vector<at::cuda::CUDAStream>& ncclStreams) {}
   );
+  return workEnqueue(std::move(work), opts.timeout);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::alltoall(
+    at::Tensor& outputTensor,
+    at::Tensor& inputTensor,
+    std::vector<int64_t>& outputSplitSizes,
+    std::vector<int64_t>& inputSplitSizes,
+    const AllToAllOptions& opts) {
+#if defined(NCCL_MAJOR) && \
+    ((NCCL_MAJOR > 2) || (NCCL_MAJOR == 2 && NCCL_MINOR >= 7))
+  std::vector<at::Tensor> inputTensors = {inputTensor};
+  std::vector<at::Tensor> outputTensors = {outputTensor};
+  check_gpu_tensors(inputTensors);
+  if (!outputTensor.is_cuda() ||
+      outputTensor.get_device() != inputTensor.get_device() ||
+      outputTensor.scalar_type() != inputTensor.scalar_type()) {
+    throw std::runtime_error(
+      "alltoall requires input and output of the same type on the same GPU");
+  }
+  const auto outputCounts =
+    alltoallCounts(outputTensor, outputSplitSizes, size_);
+  const auto inputCounts = alltoallCounts(inputTensor, inputSplitSizes, size_);
+
+  auto work = collective(inputTensors, outputTensors,
+    [&] (at::Tensor& input, at::Tensor& output,
+         ncclComm_t comm, at::cuda::CUDAStream& stream) {
+      c10::cuda::CUDACachingAllocator::recordStream(
+        output.storage().data(), stream
+      );
+      // Runs inside the group started by collective(), so the sends and
+      // receives to all peers are issued together.
+      const auto dataType = getNcclDataType(input.scalar_type());
+      const size_t elementSize = input.element_size();
+      auto sendPtr = static_cast<char*>(input.data_ptr());
+      auto recvPtr = static_cast<char*>(output.data_ptr());
+      for (int r = 0; r < size_; ++r) {
+        if (inputCounts[r] > 0) {
+          auto result = ncclSend(
+            sendPtr, inputCounts[r], dataType, r, comm, stream.stream());
+          if (result != ncclSuccess) {
+            return result;
+          }
+        }
+        if (outputCounts[r] > 0) {
+          auto result = ncclRecv(
+            recvPtr, outputCounts[r], dataType, r, comm, stream.stream());
+          if (result != ncclSuccess) {
+            return result;
+          }
+        }
+        sendPtr += inputCounts[r] * elementSize;
+        recvPtr += outputCounts[r] * elementSize;
+      }
+      return ncclSuccess;
+    }
+  );
+  return workEnqueue(std::move(work), opts.timeout);
+#else
+  throw std::runtime_error(
+    "ProcessGroupNCCL::alltoall requires NCCL 2.7 or later");
+#endif
 }
 
 std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::barrier(
@@ -631,7 +1040,9 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::barrier(
   }
 
   // All reduce to achieve the barrier
-  auto work = allreduce(barrierTensors);
+  AllreduceOptions allreduceOpts;
+  allreduceOpts.timeout = opts.timeout;
+  auto work = allreduce(barrierTensors, allreduceOpts);
 
   // Work will take over barrierTensors
   auto ncclWork = dynamic_cast<ProcessGroupNCCL::WorkNCCL*>(work.get());
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <list>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
 
 #include <c10d/NCCLUtils.hpp>
@@ -31,12 +35,27 @@ namespace c10d {
 // either WorkNCCL::wait() or WorkNCCL::synchronize(), both achieves the same
 // functionality and are synonyms.
 //
-// Note that WorkNCCL::isSuccess() and WorkNCCL::isCompleted() will always
-// return true since ProcessGroupNCCL is single threaded. Every single NCCL
-// or CUDA failure will simply raise std::runtime_error.
+// Errors while enqueueing an operation raise std::runtime_error. Errors of
+// an operation running on the GPU, like a NCCL network error or a peer that
+// doesn't take part in it, are detected by a watchdog thread, which polls the
+// CUDA events and the NCCL asynchronous errors of the outstanding work, so
+// that the hot path never blocks the host. When a work fails, or runs for
+// longer than its timeout, the watchdog aborts its NCCL communicators (which
+// makes their kernels return instead of hanging), and the error is reported
+// by WorkNCCL::isCompleted(), WorkNCCL::isSuccess(), WorkNCCL::exception()
+// and WorkNCCL::wait(). The later operations on the aborted communicators
+// throw, so the process group must be recreated, e.g. after a rendezvous.
 //
-// Therefore, WorkNCCL::exception() is not supported since isSuccess() always
-// returns true.
+// With NCCL_BLOCKING_WAIT=1 in the environment, WorkNCCL::wait() also blocks
+// the host until the work completes, fails or times out, and then throws its
+// error.
+//
+// With NCCL_ENABLE_TIMING=1 in the environment, the work also records an
+// event on the NCCL streams before its kernels, so that
+// WorkNCCL::getDuration() returns how long the kernels ran for. This tells
+// the time spent communicating from the time spent queued behind earlier
+// work on the streams, e.g. to profile the overlap of the gradient reduction
+// of DistributedDataParallel with the backward pass.
 //
 // Also note that WorkNCCL::finishedGPUExecution() is a helper function only
 // provided by ProcessGroupNCCL to check if the NCCL operation of WorkNCCL has
@@ -58,8 +77,9 @@ class ProcessGroupNCCL : public ProcessGroup {
  public:
   class WorkNCCL : public ProcessGroup::Work {
    public:
-    // Constructor takes a list of CUDA devices
-    WorkNCCL(const std::vector<at::Device>& devices);
+    // Constructor takes a list of CUDA devices, and whether to time the work
+    // on them
+    WorkNCCL(const std::vector<at::Device>& devices, bool enableTiming = false);
     virtual ~WorkNCCL();
 
     // Checks if request has completed. In this specific case of NCCL, it checks
@@ -67,33 +87,70 @@ class ProcessGroupNCCL : public ProcessGroup {
     // Non-blocking operation.
     bool isCompleted() override;
 
-    // Same as calling synchronize() for NCCL work.
+    // Same as calling synchronize() for NCCL work, then throws the error of
+    // the work if one was detected.
     void wait() override;
 
-    // Will always return true
+    // Returns false if the work failed or timed out so far.
     bool isSuccess() const override;
 
     // Let current stream wait on the completing of the NCCL work
-    // Throws on exceptions. Non-blocking operation.
+    // Throws on exceptions. Non-blocking operation, unless NCCL_BLOCKING_WAIT
+    // is set.
     void synchronize() override;
 
-    // Will always throw because it should not be called (isSuccess() -> true).
+    // The error of the work, or nullptr if none was detected so far.
     std::exception_ptr exception() const override;
 
+    // Time in milliseconds between the start and the end of the NCCL kernels
+    // on the first device, or -1 unless NCCL_ENABLE_TIMING is set. Throws if
+    // the kernels haven't finished.
+    float getDuration() const override;
+
     // Helper function that checks if the NCCL kernels have finished
     // execution on the GPUs
     bool finishedGPUExecution();
 
    protected:
+    // Sets the exception of the work if one of its communicators has an
+    // asynchronous error or was aborted.
+    void checkAndSetException();
+
+    void setException(std::exception_ptr exception);
+
+    bool timedOut() const;
+
+    // Aborts the communicators of the work, then fails it with a timeout.
+    void setTimedOut();
+
+    void abortNCCLComms();
+
     // The cached list of CUDA devices to operate on
     std::vector<at::Device> devices_;
 
     // The CUDA events tracking this work item on multiple CUDA devices
     std::vector<at::cuda::CUDAEvent> cudaEvents_;
 
+    // Recorded on the NCCL streams before the kernels, when timing the work
+    std::vector<at::cuda::CUDAEvent> ncclStartEvents_;
+    bool enableTiming_;
+
+    // The communicators the work runs on, which the watchdog aborts
+    std::vector<std::shared_ptr<NCCLComm>> ncclComms_;
+
     // Tensors used for barrier op
     std::vector<at::Tensor> barrierTensors_;
 
+    // When the work was enqueued, and for how long it can run (0 for ever)
+    std::chrono::steady_clock::time_point workStartTime_;
+    std::chrono::milliseconds opTimeout_;
+
+    bool blockingWait_;
+
+    // Set by the watchdog thread, or by the polling of the caller
+    mutable std::mutex mutex_;
+    std::exception_ptr exception_;
+
     friend class ProcessGroupNCCL;
   };
 
@@ -111,11 +168,29 @@ class ProcessGroupNCCL : public ProcessGroup {
   // will have a unique name to be passed into the ProcessGroupNCCL constructor.
   // If you would like to use ProcessGroupNCCL constructor directly, it is
   // your reponsibility to do so as well.
+  //
+  // Hierarchical allreduce:
+  //
+  // If localSize is larger than 1, ranks are grouped into nodes of localSize
+  // consecutive ranks, and allreduce of a single tensor per process
+  // reduce-scatters within the node, allreduces each shard across nodes
+  // among the ranks with the same local rank, and allgathers within the
+  // node. This keeps most of the traffic on the (fast) links within a node
+  // when the links between nodes are slow. The intra-node and inter-node
+  // communicators are created on first use.
+  //
+  // Timeout:
+  //
+  // opTimeout is how long an operation can run on the GPU before the watchdog
+  // fails it and aborts its communicators, unless the timeout of its options
+  // is set. Operations never time out if it is zero.
   ProcessGroupNCCL(
       const std::shared_ptr<Store>& store,
       int rank,
       int size,
-      const std::string& groupName = "");
+      const std::string& groupName = "",
+      int localSize = 0,
+      const std::chrono::milliseconds& opTimeout = Store::kNoTimeout);
 
   virtual ~ProcessGroupNCCL();
 
@@ -141,6 +216,14 @@ class ProcessGroupNCCL : public ProcessGroup {
       std::vector<std::vector<at::Tensor>>& inputTensors,
       const ReduceScatterOptions& opts = ReduceScatterOptions()) override;
 
+  // Requires NCCL 2.7 or later, for ncclSend and ncclRecv.
+  std::shared_ptr<ProcessGroup::Work> alltoall(
+      at::Tensor& outputTensor,
+      at::Tensor& inputTensor,
+      std::vector<int64_t>& outputSplitSizes,
+      std::vector<int64_t>& inputSplitSizes,
+      const AllToAllOptions& opts = AllToAllOptions()) override;
+
   std::shared_ptr<ProcessGroup::Work> barrier(
       const BarrierOptions& opts = BarrierOptions()) override;
 
@@ -173,12 +256,37 @@ class ProcessGroupNCCL : public ProcessGroup {
   // Helper that broadcasts nccl unique ID to all ranks through the store
   void broadcastUniqueNCCLID(ncclUniqueId* ncclID);
 
+  // Same as above, with the ID written by `isRoot' under a key suffixed by
+  // `suffix', so that disjoint subgroups of ranks can exchange their IDs
+  // concurrently. Every rank must call it the same number of times.
+  void broadcastUniqueNCCLID(
+      ncclUniqueId* ncclID,
+      bool isRoot,
+      const std::string& suffix);
+
+  // Helper that either looks up the cached intra-node and inter-node NCCL
+  // communicators used by hierarchical allreduce or creates them
+  std::pair<std::shared_ptr<NCCLComm>, std::shared_ptr<NCCLComm>>&
+  getHierarchicalNCCLComms(const std::string& devicesKey, at::Device device);
+
+  std::shared_ptr<ProcessGroup::Work> allreduceHierarchical(
+      std::vector<at::Tensor>& tensors,
+      const AllreduceOptions& opts);
+
   // Helper that either looks up the cached NCCL communicators or creates
   // a new set of NCCL communicators as a cache entry
   std::vector<std::shared_ptr<NCCLComm>>& getNCCLComm(
       const std::string& devicesKey,
       const std::vector<at::Device>& devices);
 
+  // Hands the work over to the watchdog, with the timeout of its options.
+  std::shared_ptr<ProcessGroup::Work> workEnqueue(
+      std::shared_ptr<ProcessGroup::Work> work,
+      const std::chrono::milliseconds& timeout);
+
+  // Body of the watchdog thread.
+  void ncclCommWatchdog();
+
  private:
   // Helper that encapsulates work shared across all collective communication
   // primitives.  The callbacks have the following signatures:
@@ -206,6 +314,16 @@ class ProcessGroupNCCL : public ProcessGroup {
   // The process group name
   std::string groupName_;
 
+  // Number of ranks per node for hierarchical allreduce, or 0 if disabled
+  int localSize_;
+
+  // The intra-node and inter-node communicators of hierarchical allreduce,
+  // by device key (see devNCCLCommMap_)
+  std::unordered_map<
+      std::string,
+      std::pair<std::shared_ptr<NCCLComm>, std::shared_ptr<NCCLComm>>>
+      hierarchicalNCCLComms_;
+
   // The NCCL communicator that the process group has cached.
   // The key is a list of GPU devices that an operation is operating on
   // The GPU devices are stored in a device sequence and the cache NCCL
@@ -244,6 +362,22 @@ class ProcessGroupNCCL : public ProcessGroup {
   // Device Indexes used for all collectives in this group
   std::set<int> usedDeviceIdxs_;
 
+  // Default timeout of the operations
+  std::chrono::milliseconds opTimeout_;
+
+  // Whether WorkNCCL::wait() blocks the host, from NCCL_BLOCKING_WAIT
+  bool blockingWait_;
+
+  // Whether the work records timing events, from NCCL_ENABLE_TIMING
+  bool enableTiming_;
+
+  // The work enqueued and not completed yet, which the watchdog polls
+  std::list<std::shared_ptr<WorkNCCL>> workList_;
+  std::mutex workListMutex_;
+  std::condition_variable watchdogCV_;
+  bool terminateWatchdog_;
+  std::thread watchdogThread_;
+
   // processGroupID tracking
   static std::mutex pgTrackingLock_;
 
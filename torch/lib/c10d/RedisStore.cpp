@@ -0,0 +1,281 @@
+#include <c10d/RedisStore.hpp>
+
+#include <sys/time.h>
+
+#include <cerrno>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace c10d {
+
+namespace {
+
+// The subscribers are notified on a channel per key, named after it
+const std::string kChannelPrefix = "__c10d_notify__/";
+
+struct timeval toTimeval(const std::chrono::milliseconds& duration) {
+  struct timeval tv;
+  tv.tv_sec = duration.count() / 1000;
+  tv.tv_usec = (duration.count() % 1000) * 1000;
+  return tv;
+}
+
+std::string toString(const std::vector<uint8_t>& value) {
+  return std::string(value.begin(), value.end());
+}
+
+std::vector<uint8_t> toVector(const redisReply* reply) {
+  if (reply->type != REDIS_REPLY_STRING) {
+    throw std::runtime_error("Redis: string reply expected");
+  }
+  return std::vector<uint8_t>(reply->str, reply->str + reply->len);
+}
+
+} // namespace
+
+RedisStore::RedisStore(
+    const std::string& host,
+    int port,
+    const std::string& prefix)
+    : host_(host), port_(port), prefix_(prefix), context_(connect_()) {}
+
+RedisStore::~RedisStore() {}
+
+RedisStore::Context RedisStore::connect_() const {
+  Context context(
+      timeout_ == kNoTimeout
+          ? redisConnect(host_.c_str(), port_)
+          : redisConnectWithTimeout(
+                host_.c_str(), port_, toTimeval(timeout_)));
+  if (!context) {
+    throw std::runtime_error("Redis: failed to allocate a context");
+  }
+  if (context->err) {
+    throw std::runtime_error(
+        "Redis: failed to connect to " + host_ + ":" + std::to_string(port_) +
+        ": " + context->errstr);
+  }
+  return context;
+}
+
+void RedisStore::appendCommand_(
+    redisContext* context,
+    const std::vector<std::string>& args) const {
+  std::vector<const char*> argv;
+  std::vector<size_t> argvlen;
+  argv.reserve(args.size());
+  argvlen.reserve(args.size());
+  for (const auto& arg : args) {
+    argv.push_back(arg.data());
+    argvlen.push_back(arg.size());
+  }
+  if (redisAppendCommandArgv(
+          context, argv.size(), argv.data(), argvlen.data()) != REDIS_OK) {
+    throw std::runtime_error(std::string("Redis: ") + context->errstr);
+  }
+}
+
+std::vector<RedisStore::Reply> RedisStore::getReplies_(
+    redisContext* context,
+    size_t count) const {
+  std::vector<Reply> replies;
+  replies.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    void* ptr = nullptr;
+    if (redisGetReply(context, &ptr) != REDIS_OK) {
+      throw std::runtime_error(std::string("Redis: ") + context->errstr);
+    }
+    replies.emplace_back(static_cast<redisReply*>(ptr));
+  }
+  // Only throw once all the replies of the pipeline are read, so that the
+  // next commands get their own
+  for (const auto& reply : replies) {
+    if (reply->type == REDIS_REPLY_ERROR) {
+      throw std::runtime_error(
+          "Redis: " + std::string(reply->str, reply->len));
+    }
+  }
+  return replies;
+}
+
+RedisStore::Reply RedisStore::command_(const std::vector<std::string>& args) {
+  appendCommand_(context_.get(), args);
+  return std::move(getReplies_(context_.get(), 1)[0]);
+}
+
+std::string RedisStore::key_(const std::string& key) const {
+  return prefix_ + key;
+}
+
+std::string RedisStore::channel_(const std::string& key) const {
+  return kChannelPrefix + prefix_ + key;
+}
+
+void RedisStore::set(
+    const std::string& key,
+    const std::vector<uint8_t>& value) {
+  multiSet({key}, {value});
+}
+
+std::vector<uint8_t> RedisStore::get(const std::string& key) {
+  wait({key});
+  return toVector(command_({"GET", key_(key)}).get());
+}
+
+int64_t RedisStore::add(const std::string& key, int64_t value) {
+  appendCommand_(
+      context_.get(), {"INCRBY", key_(key), std::to_string(value)});
+  appendCommand_(context_.get(), {"PUBLISH", channel_(key), ""});
+  const auto replies = getReplies_(context_.get(), 2);
+  const auto& reply = replies[0];
+  if (reply->type != REDIS_REPLY_INTEGER) {
+    throw std::runtime_error("Redis: integer reply expected");
+  }
+  return reply->integer;
+}
+
+void RedisStore::multiSet(
+    const std::vector<std::string>& keys,
+    const std::vector<std::vector<uint8_t>>& values) {
+  if (keys.size() != values.size()) {
+    throw std::invalid_argument("multiSet expects as many values as keys");
+  }
+  if (keys.empty()) {
+    return;
+  }
+  // One round trip: the values are written at once, then the waiters of
+  // every key are notified
+  std::vector<std::string> args = {"MSET"};
+  for (size_t i = 0; i < keys.size(); i++) {
+    args.push_back(key_(keys[i]));
+    args.push_back(toString(values[i]));
+  }
+  appendCommand_(context_.get(), args);
+  for (const auto& key : keys) {
+    appendCommand_(context_.get(), {"PUBLISH", channel_(key), ""});
+  }
+  getReplies_(context_.get(), keys.size() + 1);
+}
+
+std::vector<std::vector<uint8_t>> RedisStore::multiGet(
+    const std::vector<std::string>& keys) {
+  if (keys.empty()) {
+    return {};
+  }
+  wait(keys);
+  std::vector<std::string> args = {"MGET"};
+  for (const auto& key : keys) {
+    args.push_back(key_(key));
+  }
+  auto reply = command_(args);
+  if (reply->type != REDIS_REPLY_ARRAY || reply->elements != keys.size()) {
+    throw std::runtime_error("Redis: array reply expected");
+  }
+  std::vector<std::vector<uint8_t>> values;
+  values.reserve(keys.size());
+  for (size_t i = 0; i < reply->elements; i++) {
+    values.push_back(toVector(reply->element[i]));
+  }
+  return values;
+}
+
+bool RedisStore::check(const std::vector<std::string>& keys) {
+  if (keys.empty()) {
+    return true;
+  }
+  std::vector<std::string> args = {"EXISTS"};
+  for (const auto& key : keys) {
+    args.push_back(key_(key));
+  }
+  auto reply = command_(args);
+  if (reply->type != REDIS_REPLY_INTEGER) {
+    throw std::runtime_error("Redis: integer reply expected");
+  }
+  // EXISTS counts repeated keys as many times as they are given
+  return reply->integer == static_cast<long long>(keys.size());
+}
+
+void RedisStore::wait(const std::vector<std::string>& keys) {
+  wait(keys, timeout_);
+}
+
+void RedisStore::wait(
+    const std::vector<std::string>& keys,
+    const std::chrono::milliseconds& timeout) {
+  if (keys.empty()) {
+    return;
+  }
+  if (!subscriber_) {
+    subscriber_ = connect_();
+  }
+  auto subscriber = subscriber_.get();
+
+  // Subscribe before looking for missing keys, not to miss their
+  // notifications in between
+  std::unordered_set<std::string> pending;
+  std::vector<std::string> args = {"SUBSCRIBE"};
+  for (const auto& key : keys) {
+    args.push_back(channel_(key));
+    pending.insert(channel_(key));
+  }
+  appendCommand_(subscriber, args);
+  getReplies_(subscriber, keys.size());
+  for (const auto& key : keys) {
+    appendCommand_(context_.get(), {"EXISTS", key_(key)});
+  }
+  const auto exists = getReplies_(context_.get(), keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (exists[i]->type == REDIS_REPLY_INTEGER && exists[i]->integer == 1) {
+      pending.erase(channel_(keys[i]));
+    }
+  }
+
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!pending.empty()) {
+    if (timeout != kNoTimeout) {
+      const auto remaining =
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              deadline - std::chrono::steady_clock::now());
+      if (remaining.count() <= 0) {
+        // The connection is in subscribe mode, open a new one next time
+        subscriber_.reset();
+        throw std::runtime_error("Wait timeout");
+      }
+      redisSetTimeout(subscriber, toTimeval(remaining));
+    } else {
+      redisSetTimeout(subscriber, toTimeval(std::chrono::milliseconds(0)));
+    }
+    void* ptr = nullptr;
+    if (redisGetReply(subscriber, &ptr) != REDIS_OK) {
+      const bool timedOut = subscriber->err == REDIS_ERR_IO &&
+          (errno == EAGAIN || errno == EWOULDBLOCK);
+      const std::string what = subscriber->errstr;
+      subscriber_.reset();
+      throw std::runtime_error(timedOut ? "Wait timeout" : "Redis: " + what);
+    }
+    // ["message", channel, payload]
+    Reply message(static_cast<redisReply*>(ptr));
+    if (message->type == REDIS_REPLY_ARRAY && message->elements == 3 &&
+        message->element[1]->type == REDIS_REPLY_STRING) {
+      pending.erase(
+          std::string(message->element[1]->str, message->element[1]->len));
+    }
+  }
+
+  // Leave subscribe mode, skipping the notifications which came meanwhile,
+  // until the last channel is unsubscribed
+  appendCommand_(subscriber, {"UNSUBSCRIBE"});
+  while (true) {
+    const auto replies = getReplies_(subscriber, 1);
+    const auto& reply = replies[0];
+    if (reply->type == REDIS_REPLY_ARRAY && reply->elements == 3 &&
+        reply->element[0]->type == REDIS_REPLY_STRING &&
+        std::string(reply->element[0]->str, reply->element[0]->len) ==
+            "unsubscribe" &&
+        reply->element[2]->integer == 0) {
+      break;
+    }
+  }
+}
+
+} // namespace c10d
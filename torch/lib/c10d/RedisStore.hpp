@@ -0,0 +1,89 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <c10d/Store.hpp>
+
+extern "C" {
+#include <hiredis/hiredis.h>
+}
+
+namespace c10d {
+
+// A store backed by a Redis server, so that the rendezvous of large jobs is
+// served by a (replicated) service instead of the TCPStore of one of their
+// processes. The batched operations are pipelined in a single round trip.
+//
+// Instead of polling, waits subscribe to a channel per key, to which the
+// stores publish when they set or add to the key.
+class RedisStore : public Store {
+ public:
+  explicit RedisStore(
+      const std::string& host,
+      int port,
+      const std::string& prefix = "");
+
+  virtual ~RedisStore();
+
+  void set(const std::string& key, const std::vector<uint8_t>& value) override;
+
+  std::vector<uint8_t> get(const std::string& key) override;
+
+  int64_t add(const std::string& key, int64_t value) override;
+
+  void multiSet(
+      const std::vector<std::string>& keys,
+      const std::vector<std::vector<uint8_t>>& values) override;
+
+  std::vector<std::vector<uint8_t>> multiGet(
+      const std::vector<std::string>& keys) override;
+
+  bool check(const std::vector<std::string>& keys) override;
+
+  void wait(const std::vector<std::string>& keys) override;
+
+  void wait(
+      const std::vector<std::string>& keys,
+      const std::chrono::milliseconds& timeout) override;
+
+ protected:
+  struct ContextDeleter {
+    void operator()(redisContext* context) const {
+      redisFree(context);
+    }
+  };
+
+  struct ReplyDeleter {
+    void operator()(redisReply* reply) const {
+      freeReplyObject(reply);
+    }
+  };
+
+  using Context = std::unique_ptr<redisContext, ContextDeleter>;
+  using Reply = std::unique_ptr<redisReply, ReplyDeleter>;
+
+  Context connect_() const;
+
+  // Queues a command on the context, without waiting for its reply.
+  void appendCommand_(
+      redisContext* context,
+      const std::vector<std::string>& args) const;
+  // Reads the replies of the `count` queued commands.
+  std::vector<Reply> getReplies_(redisContext* context, size_t count) const;
+
+  Reply command_(const std::vector<std::string>& args);
+
+  std::string key_(const std::string& key) const;
+  std::string channel_(const std::string& key) const;
+
+  const std::string host_;
+  const int port_;
+  const std::string prefix_;
+
+  Context context_;
+  // Connection in subscribe mode, for the waits, opened on first use
+  Context subscriber_;
+};
+
+} // namespace c10d
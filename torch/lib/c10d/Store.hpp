@@ -27,6 +27,15 @@ class Store {
 
   virtual int64_t add(const std::string& key, int64_t value) = 0;
 
+  // Batched versions of set and get. The default implementations issue one
+  // call per key; stores that talk to a server should send a single request.
+  virtual void multiSet(
+      const std::vector<std::string>& keys,
+      const std::vector<std::vector<uint8_t>>& values);
+
+  virtual std::vector<std::vector<uint8_t>> multiGet(
+      const std::vector<std::string>& keys);
+
   virtual bool check(const std::vector<std::string>& keys) = 0;
 
   virtual void wait(const std::vector<std::string>& keys) = 0;
@@ -10,7 +10,15 @@ namespace c10d {
 
 namespace {
 
-enum class QueryType : uint8_t { SET, GET, ADD, CHECK, WAIT };
+enum class QueryType : uint8_t {
+  SET,
+  GET,
+  ADD,
+  CHECK,
+  WAIT,
+  MULTI_SET,
+  MULTI_GET
+};
 
 enum class CheckResponseType : uint8_t { READY, NOT_READY };
 
@@ -166,7 +174,7 @@ void TCPStoreDaemon::stop() {
 // query communicates with the worker. The format
 // of the query is as follows:
 // type of query | size of arg1 | arg1 | size of arg2 | arg2 | ...
-// or, in the case of wait
+// or, in the case of check, wait and the multi queries
 // type of query | number of args | size of arg1 | arg1 | ...
 void TCPStoreDaemon::query(int socket) {
   QueryType qt;
@@ -187,6 +195,12 @@ void TCPStoreDaemon::query(int socket) {
   } else if (qt == QueryType::WAIT) {
     waitHandler(socket);
 
+  } else if (qt == QueryType::MULTI_SET) {
+    multiSetHandler(socket);
+
+  } else if (qt == QueryType::MULTI_GET) {
+    multiGetHandler(socket);
+
   } else {
     throw std::runtime_error("Unexpected query type");
   }
@@ -268,6 +282,29 @@ void TCPStoreDaemon::waitHandler(int socket) {
   }
 }
 
+void TCPStoreDaemon::multiSetHandler(int socket) {
+  SizeType nargs;
+  tcputil::recvBytes<SizeType>(socket, &nargs, 1);
+  for (size_t i = 0; i < nargs; i++) {
+    std::string key = tcputil::recvString(socket);
+    tcpStore_[key] = tcputil::recvVector<uint8_t>(socket);
+    wakeupWaitingClients(key);
+  }
+}
+
+void TCPStoreDaemon::multiGetHandler(int socket) const {
+  SizeType nargs;
+  tcputil::recvBytes<SizeType>(socket, &nargs, 1);
+  std::vector<std::string> keys(nargs);
+  for (size_t i = 0; i < nargs; i++) {
+    keys[i] = tcputil::recvString(socket);
+  }
+  for (size_t i = 0; i < nargs; i++) {
+    tcputil::sendVector<uint8_t>(
+        socket, tcpStore_.at(keys[i]), (i != (nargs - 1)));
+  }
+}
+
 bool TCPStoreDaemon::checkKeys(const std::vector<std::string>& keys) const {
   return std::all_of(keys.begin(), keys.end(), [this](const std::string& s) {
     return tcpStore_.count(s) > 0;
@@ -279,66 +316,100 @@ TCPStore::TCPStore(
     const std::string& masterAddr,
     PortType masterPort,
     int numWorkers,
-    bool isServer)
+    bool isServer,
+    int numShards)
     : isServer_(isServer),
       tcpStoreAddr_(masterAddr),
       tcpStorePort_(masterPort),
       numWorkers_(numWorkers),
       initKey_("init/"),
       regularPrefix_("/") {
+  if (numShards < 1) {
+    throw std::invalid_argument("TCPStore needs at least one shard");
+  }
+  storeSockets_.resize(numShards, -1);
   if (isServer_) {
-    // Opening up the listening socket
-    std::tie(masterListenSocket_, std::ignore) = tcputil::listen(masterPort);
-    // Now start the daemon
-    tcpStoreDaemon_ = std::unique_ptr<TCPStoreDaemon>(
-        new TCPStoreDaemon(masterListenSocket_));
+    for (int shard = 0; shard < numShards; shard++) {
+      // Opening up the listening socket
+      int listenSocket;
+      std::tie(listenSocket, std::ignore) =
+          tcputil::listen(masterPort + shard);
+      masterListenSockets_.push_back(listenSocket);
+      // Now start the daemon
+      tcpStoreDaemons_.emplace_back(new TCPStoreDaemon(listenSocket));
+    }
   }
-  // Connect to the daemon
-  storeSocket_ = tcputil::connect(tcpStoreAddr_, tcpStorePort_);
 
   waitForWorkers_();
 }
 
 TCPStore::~TCPStore() {
-  ::close(storeSocket_);
+  for (auto socket : storeSockets_) {
+    if (socket != -1) {
+      ::close(socket);
+    }
+  }
   if (isServer_) {
-    // Store daemon should end because of closed connection.
+    // Store daemons should end because of closed connection.
     // daemon destructor should join the thread
-    tcpStoreDaemon_.reset(nullptr);
-    ::close(masterListenSocket_);
+    tcpStoreDaemons_.clear();
+    for (auto socket : masterListenSockets_) {
+      ::close(socket);
+    }
+  }
+}
+
+// FNV-1a, which unlike std::hash is guaranteed to be the same in every
+// process.
+size_t TCPStore::shardOf_(const std::string& key) const {
+  uint64_t hash = 14695981039346656037ULL;
+  for (auto c : key) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash % storeSockets_.size();
+}
+
+int TCPStore::shardSocket_(size_t shard) {
+  if (storeSockets_[shard] == -1) {
+    storeSockets_[shard] =
+        tcputil::connect(tcpStoreAddr_, tcpStorePort_ + shard);
   }
+  return storeSockets_[shard];
+}
+
+std::vector<std::vector<size_t>> TCPStore::groupByShard_(
+    const std::vector<std::string>& keys) const {
+  std::vector<std::vector<size_t>> groups(storeSockets_.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    groups[shardOf_(keys[i])].push_back(i);
+  }
+  return groups;
 }
 
 void TCPStore::waitForWorkers_() {
-  addHelper_(initKey_, 1);
+  // The worker that completes the count sets a key that the server waits on,
+  // so that the server doesn't have to poll the counter.
+  const auto doneKey = initKey_ + "done";
+  if (addHelper_(initKey_, 1) == numWorkers_) {
+    const int socket = shardSocket_(shardOf_(doneKey));
+    tcputil::sendValue<QueryType>(socket, QueryType::SET);
+    tcputil::sendString(socket, doneKey, true);
+    tcputil::sendVector<uint8_t>(socket, {1});
+  }
   // Let server block until all workers have completed, this ensures that
   // the server daemon thread is always running until the very end
-  if (isServer_) {
-    const auto start = std::chrono::steady_clock::now();
-    while (true) {
-      std::vector<uint8_t> value = getHelper_(initKey_);
-      auto buf = reinterpret_cast<const char*>(value.data());
-      auto len = value.size();
-      int numWorkersCompleted = std::stoi(std::string(buf, len));
-      if (numWorkersCompleted >= numWorkers_) {
-        break;
-      }
-      const auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-          std::chrono::steady_clock::now() - start);
-      if (timeout_ != kNoTimeout && elapsed > timeout_) {
-        break;
-      }
-      /* sleep override */
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    }
+  if (isServer_ && numWorkers_ > 0) {
+    waitHelper_({doneKey}, timeout_);
   }
 }
 
 void TCPStore::set(const std::string& key, const std::vector<uint8_t>& data) {
   std::string regKey = regularPrefix_ + key;
-  tcputil::sendValue<QueryType>(storeSocket_, QueryType::SET);
-  tcputil::sendString(storeSocket_, regKey, true);
-  tcputil::sendVector<uint8_t>(storeSocket_, data);
+  const int socket = shardSocket_(shardOf_(regKey));
+  tcputil::sendValue<QueryType>(socket, QueryType::SET);
+  tcputil::sendString(socket, regKey, true);
+  tcputil::sendVector<uint8_t>(socket, data);
 }
 
 std::vector<uint8_t> TCPStore::get(const std::string& key) {
@@ -348,9 +419,10 @@ std::vector<uint8_t> TCPStore::get(const std::string& key) {
 
 std::vector<uint8_t> TCPStore::getHelper_(const std::string& key) {
   waitHelper_({key}, timeout_);
-  tcputil::sendValue<QueryType>(storeSocket_, QueryType::GET);
-  tcputil::sendString(storeSocket_, key);
-  return tcputil::recvVector<uint8_t>(storeSocket_);
+  const int socket = shardSocket_(shardOf_(key));
+  tcputil::sendValue<QueryType>(socket, QueryType::GET);
+  tcputil::sendString(socket, key);
+  return tcputil::recvVector<uint8_t>(socket);
 }
 
 int64_t TCPStore::add(const std::string& key, int64_t value) {
@@ -359,28 +431,109 @@ int64_t TCPStore::add(const std::string& key, int64_t value) {
 }
 
 int64_t TCPStore::addHelper_(const std::string& key, int64_t value) {
-  tcputil::sendValue<QueryType>(storeSocket_, QueryType::ADD);
-  tcputil::sendString(storeSocket_, key, true);
-  tcputil::sendValue<int64_t>(storeSocket_, value);
-  return tcputil::recvValue<int64_t>(storeSocket_);
+  const int socket = shardSocket_(shardOf_(key));
+  tcputil::sendValue<QueryType>(socket, QueryType::ADD);
+  tcputil::sendString(socket, key, true);
+  tcputil::sendValue<int64_t>(socket, value);
+  return tcputil::recvValue<int64_t>(socket);
+}
+
+void TCPStore::multiSet(
+    const std::vector<std::string>& keys,
+    const std::vector<std::vector<uint8_t>>& values) {
+  if (keys.size() != values.size()) {
+    throw std::invalid_argument("multiSet expects as many values as keys");
+  }
+  std::vector<std::string> regKeys;
+  regKeys.reserve(keys.size());
+  for (const auto& key : keys) {
+    regKeys.push_back(regularPrefix_ + key);
+  }
+  const auto groups = groupByShard_(regKeys);
+  for (size_t shard = 0; shard < groups.size(); shard++) {
+    const auto& indices = groups[shard];
+    if (indices.empty()) {
+      continue;
+    }
+    const int socket = shardSocket_(shard);
+    tcputil::sendValue<QueryType>(socket, QueryType::MULTI_SET);
+    SizeType nkeys = indices.size();
+    tcputil::sendBytes<SizeType>(socket, &nkeys, 1, true);
+    for (size_t i = 0; i < nkeys; i++) {
+      tcputil::sendString(socket, regKeys[indices[i]], true);
+      tcputil::sendVector<uint8_t>(
+          socket, values[indices[i]], (i != (nkeys - 1)));
+    }
+  }
+}
+
+std::vector<std::vector<uint8_t>> TCPStore::multiGet(
+    const std::vector<std::string>& keys) {
+  std::vector<std::string> regKeys;
+  regKeys.reserve(keys.size());
+  for (const auto& key : keys) {
+    regKeys.push_back(regularPrefix_ + key);
+  }
+  waitHelper_(regKeys, timeout_);
+
+  // Send the requests to every shard before reading any of the responses.
+  const auto groups = groupByShard_(regKeys);
+  for (size_t shard = 0; shard < groups.size(); shard++) {
+    const auto& indices = groups[shard];
+    if (indices.empty()) {
+      continue;
+    }
+    const int socket = shardSocket_(shard);
+    tcputil::sendValue<QueryType>(socket, QueryType::MULTI_GET);
+    SizeType nkeys = indices.size();
+    tcputil::sendBytes<SizeType>(socket, &nkeys, 1, true);
+    for (size_t i = 0; i < nkeys; i++) {
+      tcputil::sendString(socket, regKeys[indices[i]], (i != (nkeys - 1)));
+    }
+  }
+  std::vector<std::vector<uint8_t>> values(keys.size());
+  for (size_t shard = 0; shard < groups.size(); shard++) {
+    for (const auto index : groups[shard]) {
+      values[index] = tcputil::recvVector<uint8_t>(storeSockets_[shard]);
+    }
+  }
+  return values;
 }
 
 bool TCPStore::check(const std::vector<std::string>& keys) {
-  tcputil::sendValue<QueryType>(storeSocket_, QueryType::CHECK);
-  SizeType nkeys = keys.size();
-  tcputil::sendBytes<SizeType>(storeSocket_, &nkeys, 1, (nkeys > 0));
-  for (size_t i = 0; i < nkeys; i++) {
-    std::string regKey = regularPrefix_ + keys[i];
-    tcputil::sendString(storeSocket_, regKey, (i != (nkeys - 1)));
-  }
-  auto checkResponse = tcputil::recvValue<CheckResponseType>(storeSocket_);
-  if (checkResponse == CheckResponseType::READY) {
-    return true;
-  } else if (checkResponse == CheckResponseType::NOT_READY) {
-    return false;
-  } else {
-    throw std::runtime_error("ready or not_ready response expected");
+  std::vector<std::string> regKeys;
+  regKeys.reserve(keys.size());
+  for (const auto& key : keys) {
+    regKeys.push_back(regularPrefix_ + key);
   }
+  const auto groups = groupByShard_(regKeys);
+  std::vector<size_t> queried;
+  for (size_t shard = 0; shard < groups.size(); shard++) {
+    const auto& indices = groups[shard];
+    // A check without keys is sent to the first shard, as before sharding.
+    if (indices.empty() && !(keys.empty() && shard == 0)) {
+      continue;
+    }
+    const int socket = shardSocket_(shard);
+    tcputil::sendValue<QueryType>(socket, QueryType::CHECK);
+    SizeType nkeys = indices.size();
+    tcputil::sendBytes<SizeType>(socket, &nkeys, 1, (nkeys > 0));
+    for (size_t i = 0; i < nkeys; i++) {
+      tcputil::sendString(socket, regKeys[indices[i]], (i != (nkeys - 1)));
+    }
+    queried.push_back(shard);
+  }
+  bool ready = true;
+  for (const auto shard : queried) {
+    auto checkResponse =
+        tcputil::recvValue<CheckResponseType>(storeSockets_[shard]);
+    if (checkResponse == CheckResponseType::NOT_READY) {
+      ready = false;
+    } else if (checkResponse != CheckResponseType::READY) {
+      throw std::runtime_error("ready or not_ready response expected");
+    }
+  }
+  return ready;
 }
 
 void TCPStore::wait(const std::vector<std::string>& keys) {
@@ -401,26 +554,41 @@ void TCPStore::wait(
 void TCPStore::waitHelper_(
     const std::vector<std::string>& keys,
     const std::chrono::milliseconds& timeout) {
-  // Set the socket timeout if there is a wait timeout
-  if (timeout != kNoTimeout) {
-    struct timeval timeoutTV = {.tv_sec = timeout.count() / 1000,
-                                .tv_usec = (timeout.count() % 1000) * 1000};
-    SYSCHECK_ERR_RETURN_NEG1(::setsockopt(
-        storeSocket_,
-        SOL_SOCKET,
-        SO_RCVTIMEO,
-        reinterpret_cast<char*>(&timeoutTV),
-        sizeof(timeoutTV)));
-  }
-  tcputil::sendValue<QueryType>(storeSocket_, QueryType::WAIT);
-  SizeType nkeys = keys.size();
-  tcputil::sendBytes<SizeType>(storeSocket_, &nkeys, 1, (nkeys > 0));
-  for (size_t i = 0; i < nkeys; i++) {
-    tcputil::sendString(storeSocket_, keys[i], (i != (nkeys - 1)));
-  }
-  auto waitResponse = tcputil::recvValue<WaitResponseType>(storeSocket_);
-  if (waitResponse != WaitResponseType::STOP_WAITING) {
-    throw std::runtime_error("Stop_waiting response is expected");
+  // The daemons respond once all keys are set, so waits on different shards
+  // run concurrently.
+  const auto groups = groupByShard_(keys);
+  std::vector<size_t> queried;
+  for (size_t shard = 0; shard < groups.size(); shard++) {
+    const auto& indices = groups[shard];
+    if (indices.empty()) {
+      continue;
+    }
+    const int socket = shardSocket_(shard);
+    // Set the socket timeout if there is a wait timeout
+    if (timeout != kNoTimeout) {
+      struct timeval timeoutTV = {.tv_sec = timeout.count() / 1000,
+                                  .tv_usec = (timeout.count() % 1000) * 1000};
+      SYSCHECK_ERR_RETURN_NEG1(::setsockopt(
+          socket,
+          SOL_SOCKET,
+          SO_RCVTIMEO,
+          reinterpret_cast<char*>(&timeoutTV),
+          sizeof(timeoutTV)));
+    }
+    tcputil::sendValue<QueryType>(socket, QueryType::WAIT);
+    SizeType nkeys = indices.size();
+    tcputil::sendBytes<SizeType>(socket, &nkeys, 1, (nkeys > 0));
+    for (size_t i = 0; i < nkeys; i++) {
+      tcputil::sendString(socket, keys[indices[i]], (i != (nkeys - 1)));
+    }
+    queried.push_back(shard);
+  }
+  for (const auto shard : queried) {
+    auto waitResponse =
+        tcputil::recvValue<WaitResponseType>(storeSockets_[shard]);
+    if (waitResponse != WaitResponseType::STOP_WAITING) {
+      throw std::runtime_error("Stop_waiting response is expected");
+    }
   }
 }
 
@@ -27,6 +27,8 @@ class TCPStoreDaemon {
   void getHandler(int socket) const;
   void checkHandler(int socket) const;
   void waitHandler(int socket);
+  void multiSetHandler(int socket);
+  void multiGetHandler(int socket) const;
 
   bool checkKeys(const std::vector<std::string>& keys) const;
   void wakeupWaitingClients(const std::string& key);
@@ -43,13 +45,19 @@ class TCPStoreDaemon {
   std::vector<int> controlPipeFd_{-1, -1};
 };
 
+// Keys can be sharded over several daemons, each with its own thread and
+// listening on its own port (masterPort + shard index), so that requests
+// from many clients are served in parallel. All stores connecting to the
+// same server must use the same number of shards. Clients connect to a
+// shard the first time they use one of its keys.
 class TCPStore : public Store {
  public:
   explicit TCPStore(
       const std::string& masterAddr,
       PortType masterPort,
       int numWorkers,
-      bool isServer = false);
+      bool isServer = false,
+      int numShards = 1);
 
   virtual ~TCPStore();
 
@@ -59,6 +67,13 @@ class TCPStore : public Store {
 
   int64_t add(const std::string& key, int64_t value) override;
 
+  void multiSet(
+      const std::vector<std::string>& keys,
+      const std::vector<std::vector<uint8_t>>& values) override;
+
+  std::vector<std::vector<uint8_t>> multiGet(
+      const std::vector<std::string>& keys) override;
+
   bool check(const std::vector<std::string>& keys) override;
 
   void wait(const std::vector<std::string>& keys) override;
@@ -75,9 +90,16 @@ class TCPStore : public Store {
       const std::chrono::milliseconds& timeout);
   void waitForWorkers_();
 
+  size_t shardOf_(const std::string& key) const;
+  int shardSocket_(size_t shard);
+  // Groups indices into `keys` by shard
+  std::vector<std::vector<size_t>> groupByShard_(
+      const std::vector<std::string>& keys) const;
+
   bool isServer_;
-  int storeSocket_ = -1;
-  int masterListenSocket_ = -1;
+  // One socket per shard, connected on first use
+  std::vector<int> storeSockets_;
+  std::vector<int> masterListenSockets_;
 
   std::string tcpStoreAddr_;
   PortType tcpStorePort_;
@@ -86,8 +108,8 @@ class TCPStore : public Store {
   const std::string initKey_;
   const std::string regularPrefix_;
 
-  // Only needs to be launched as the server
-  std::unique_ptr<TCPStoreDaemon> tcpStoreDaemon_ = nullptr;
+  // Only needs to be launched as the server, one per shard
+  std::vector<std::unique_ptr<TCPStoreDaemon>> tcpStoreDaemons_;
 };
 
 } // namespace c10d
@@ -3,11 +3,13 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <limits>
+#include <stdexcept>
 #include <string>
 #include <system_error>
 #include <tuple>
@@ -195,6 +197,51 @@ inline void assertTypeAndSizesMatch(
   assertTypeAndSizesMatch(fn, tensors.slice(1), type, sizes);
 }
 
+// Returns the number of elements of `tensor` that alltoall exchanges with
+// each rank, given the rows of its first dimension per rank (empty for equal
+// splits).
+inline std::vector<int64_t> alltoallCounts(
+    const at::Tensor& tensor,
+    const std::vector<int64_t>& splitSizes,
+    int groupSize) {
+  if (tensor.dim() == 0) {
+    throw std::invalid_argument(
+        "alltoall requires tensors with at least one dimension");
+  }
+  if (!tensor.is_contiguous()) {
+    throw std::invalid_argument("alltoall requires contiguous tensors");
+  }
+  const int64_t rows = tensor.size(0);
+  const int64_t rowNumel = rows == 0 ? 0 : tensor.numel() / rows;
+  std::vector<int64_t> counts(groupSize);
+  if (splitSizes.empty()) {
+    if (rows % groupSize != 0) {
+      throw std::invalid_argument(
+          "alltoall with equal splits requires the first dimension to be "
+          "divisible by the group size");
+    }
+    std::fill(counts.begin(), counts.end(), rows / groupSize * rowNumel);
+    return counts;
+  }
+  if (splitSizes.size() != static_cast<size_t>(groupSize)) {
+    throw std::invalid_argument(
+        "alltoall requires a split size for every rank");
+  }
+  int64_t total = 0;
+  for (int i = 0; i < groupSize; ++i) {
+    if (splitSizes[i] < 0) {
+      throw std::invalid_argument("alltoall split sizes must be non-negative");
+    }
+    counts[i] = splitSizes[i] * rowNumel;
+    total += splitSizes[i];
+  }
+  if (total != rows) {
+    throw std::invalid_argument(
+        "alltoall split sizes must add up to the first dimension");
+  }
+  return counts;
+}
+
 // Copied from ATen/core/functional.h.
 template <typename F, typename T>
 inline auto fmap(T& inputs, const F& fn)
@@ -246,6 +246,50 @@ void testBroadcast(const std::string& path, const at::DeviceType b) {
   }
 }
 
+void testAlltoall(const std::string& path) {
+  const auto size = 4;
+  auto tests = CollectiveTest::initialize(path, size);
+
+  // Rank i sends (j + 1) rows of value (i * size + j) to rank j
+  std::vector<at::Tensor> inputs(size);
+  std::vector<at::Tensor> outputs(size);
+  std::vector<std::vector<int64_t>> inputSplits(size);
+  std::vector<std::vector<int64_t>> outputSplits(size);
+  for (auto i = 0; i < size; i++) {
+    std::vector<at::Tensor> chunks;
+    for (auto j = 0; j < size; j++) {
+      chunks.push_back(at::ones({j + 1, 4}) * (i * size + j));
+      inputSplits[i].push_back(j + 1);
+      outputSplits[i].push_back(i + 1);
+    }
+    inputs[i] = at::cat(chunks);
+    outputs[i] = at::zeros({size * (i + 1), 4});
+  }
+
+  // Kick off work
+  std::vector<std::shared_ptr<::c10d::ProcessGroup::Work>> work(size);
+  for (auto i = 0; i < size; i++) {
+    work[i] = tests[i].getProcessGroup().alltoall(
+        outputs[i], inputs[i], outputSplits[i], inputSplits[i]);
+  }
+
+  // Wait for work to complete
+  for (auto i = 0; i < size; i++) {
+    work[i]->wait();
+  }
+
+  // Verify outputs
+  for (auto i = 0; i < size; i++) {
+    auto data = outputs[i].data<float>();
+    for (auto j = 0; j < outputs[i].numel(); j++) {
+      const auto source = j / ((i + 1) * 4);
+      if (data[j] != source * size + i) {
+        throw std::runtime_error("BOOM!");
+      }
+    }
+  }
+}
+
 void testBarrier(const std::string& path) {
   const auto size = 2;
   auto tests = CollectiveTest::initialize(path, size);
@@ -307,6 +351,11 @@ int main(int argc, char** argv) {
   }
 #endif
 
+  {
+    TemporaryFile file;
+    testAlltoall(file.path);
+  }
+
   {
     TemporaryFile file;
     testBarrier(file.path);
@@ -349,6 +349,14 @@ int main(int argc, char** argv) {
   testSendRecv(false);
   testSendRecv(true);
 
+  // The same collectives, started non-blocking
+  setenv("C10D_MPI_NONBLOCKING", "1", 1);
+  testAllreduce();
+  testBroadcast();
+  testReduce();
+  testAllgather();
+  unsetenv("C10D_MPI_NONBLOCKING");
+
   std::cout << "Test successful" << std::endl;
 #else
   std::cout << "MPI executable not found, skipping test" << std::endl;
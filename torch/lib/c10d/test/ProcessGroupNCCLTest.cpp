@@ -414,6 +414,32 @@ void testReduceScatter(const std::string& path, int rank, int size) {
   std::cout << "Reduce-scatter test successful" << std::endl;
 }
 
+void testAllreduceHierarchical(const std::string& path, int rank, int size) {
+  // Two ranks per node, a single tensor per rank whose size doesn't divide
+  // evenly across the node
+  const auto localSize = 2;
+  auto store = std::make_shared<::c10d::FileStore>(path, size);
+  ::c10d::ProcessGroupNCCL pg(store, rank, size, "", localSize);
+
+  at::cuda::CUDAGuard deviceGuard(rank % cudaNumDevices());
+  std::vector<at::Tensor> tensors = {
+      at::ones({7}, at::kCUDA) * rank,
+  };
+  auto work = pg.allreduce(tensors);
+  work->wait();
+
+  // Validation
+  const auto expected = (size * (size - 1)) / 2;
+  auto tensor = tensors[0].cpu();
+  auto data = tensor.data<float>();
+  for (auto k = 0; k < tensor.numel(); k++) {
+    if (data[k] != expected) {
+      throw std::runtime_error("BOOM!");
+    }
+  }
+  std::cout << "Hierarchical allreduce test successful" << std::endl;
+}
+
 int main(int argc, char** argv) {
   // Use WORLD_SIZE and RANK environmental variables to do multi-node
   // distributed testing
@@ -438,5 +464,10 @@ int main(int argc, char** argv) {
   testAllgather(file.path, rank, size);
   testReduceScatter(file.path, rank, size);
 
+  // Needs at least two nodes of two ranks
+  if (size >= 4 && size % 2 == 0) {
+    testAllreduceHierarchical(file.path, rank, size);
+  }
+
   return EXIT_SUCCESS;
 }
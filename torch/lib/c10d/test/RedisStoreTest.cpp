@@ -0,0 +1,93 @@
+#include <c10d/test/StoreTestCommon.hpp>
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include <c10d/PrefixStore.hpp>
+#include <c10d/RedisStore.hpp>
+
+// Needs a Redis server, at $REDIS_HOST:$REDIS_PORT or localhost:6379
+std::string host() {
+  const char* host = getenv("REDIS_HOST");
+  return host == nullptr ? "localhost" : host;
+}
+
+int port() {
+  const char* port = getenv("REDIS_PORT");
+  return port == nullptr ? 6379 : std::atoi(port);
+}
+
+void testHelper(const std::string& prefix) {
+  // Keys of earlier runs of the test don't collide with a prefix of its own
+  const auto runPrefix = prefix + std::to_string(getpid()) + "/";
+  c10d::RedisStore redisStore(host(), port(), runPrefix);
+  c10d::PrefixStore store(prefix, redisStore);
+
+  // Basic set/get
+  c10d::test::set(store, "key0", "value0");
+  c10d::test::set(store, "key1", "value1");
+  c10d::test::check(store, "key0", "value0");
+  c10d::test::check(store, "key1", "value1");
+
+  // Batched set/get
+  std::vector<std::string> keys;
+  std::vector<std::vector<uint8_t>> values;
+  for (auto i = 0; i < 8; i++) {
+    const auto value = "multi_value" + std::to_string(i);
+    keys.push_back("multi_key" + std::to_string(i));
+    values.emplace_back(value.begin(), value.end());
+  }
+  store.multiSet(keys, values);
+  if (store.multiGet(keys) != values) {
+    throw std::runtime_error("multiGet returned unexpected values");
+  }
+
+  // Waits time out on missing keys
+  bool timedOut = false;
+  try {
+    store.wait({"key0", "missing"}, std::chrono::milliseconds(100));
+  } catch (const std::runtime_error&) {
+    timedOut = true;
+  }
+  if (!timedOut) {
+    throw std::runtime_error("wait on a missing key didn't time out");
+  }
+
+  // Waits and adds of several stores
+  const auto numThreads = 8;
+  const auto numIterations = 100;
+  std::vector<std::thread> threads;
+  for (auto i = 0; i < numThreads; i++) {
+    threads.push_back(std::thread([&runPrefix, &prefix, i] {
+      c10d::RedisStore redisStore(host(), port(), runPrefix);
+      c10d::PrefixStore store(prefix, redisStore);
+      // Set by the next thread
+      const auto key = "thread_" + std::to_string((i + 1) % numThreads);
+      if (i % 2 == 0) {
+        store.wait({key});
+      }
+      c10d::test::set(
+          store, "thread_" + std::to_string(i), std::to_string(i));
+      c10d::test::check(
+          store, key, std::to_string((i + 1) % numThreads));
+      for (auto j = 0; j < numIterations; j++) {
+        store.add("counter", 1);
+      }
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  c10d::test::check(
+      store, "counter", std::to_string(numThreads * numIterations));
+}
+
+int main(int argc, char** argv) {
+  testHelper("");
+  testHelper("testPrefix");
+  std::cout << "Test succeeded" << std::endl;
+  return EXIT_SUCCESS;
+}
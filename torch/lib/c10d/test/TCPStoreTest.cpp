@@ -7,11 +7,12 @@
 #include <c10d/PrefixStore.hpp>
 #include <c10d/TCPStore.hpp>
 
-void testHelper(const std::string& prefix = "") {
+void testHelper(const std::string& prefix = "", int numShards = 1) {
   const auto numThreads = 16;
   const auto numWorkers = numThreads + 1;
   // server store
-  c10d::TCPStore serverTCPStore("127.0.0.1", 29500, numWorkers, true);
+  c10d::TCPStore serverTCPStore(
+      "127.0.0.1", 29500, numWorkers, true, numShards);
   c10d::PrefixStore serverStore(prefix, serverTCPStore);
 
   // Basic set/get on the server store
@@ -22,6 +23,19 @@ void testHelper(const std::string& prefix = "") {
   c10d::test::check(serverStore, "key1", "value1");
   c10d::test::check(serverStore, "key2", "value2");
 
+  // Batched set/get on the server store
+  std::vector<std::string> keys;
+  std::vector<std::vector<uint8_t>> values;
+  for (auto i = 0; i < 8; i++) {
+    const auto value = "multi_value" + std::to_string(i);
+    keys.push_back("multi_key" + std::to_string(i));
+    values.emplace_back(value.begin(), value.end());
+  }
+  serverStore.multiSet(keys, values);
+  if (serverStore.multiGet(keys) != values) {
+    throw std::runtime_error("multiGet returned unexpected values");
+  }
+
   // Hammer on TCPStore
   std::vector<std::thread> threads;
   const auto numIterations = 1000;
@@ -31,8 +45,9 @@ void testHelper(const std::string& prefix = "") {
   std::vector<std::unique_ptr<c10d::TCPStore>> clientTCPStores;
   std::vector<std::unique_ptr<c10d::PrefixStore>> clientStores;
   for (auto i = 0; i < numThreads; i++) {
-    clientTCPStores.push_back(std::unique_ptr<c10d::TCPStore>(
-        new c10d::TCPStore("127.0.0.1", 29500, numWorkers, false)));
+    clientTCPStores.push_back(
+        std::unique_ptr<c10d::TCPStore>(new c10d::TCPStore(
+            "127.0.0.1", 29500, numWorkers, false, numShards)));
     clientStores.push_back(std::unique_ptr<c10d::PrefixStore>(
         new c10d::PrefixStore(prefix, *clientTCPStores[i])));
   }
@@ -93,6 +108,7 @@ void testHelper(const std::string& prefix = "") {
 int main(int argc, char** argv) {
   testHelper();
   testHelper("testPrefix");
+  testHelper("", 4);
   std::cout << "Test succeeded" << std::endl;
   return EXIT_SUCCESS;
 }
@@ -871,16 +871,18 @@ class MultiheadAttention(Module):
             attn_output_weights += attn_mask
 
         if key_padding_mask is not None:
+            # the padding mask is applied by the softmax itself instead of
+            # writing a masked copy of the weights first
+            if attn_output_weights.dtype == torch.float16:
+                attn_output_weights = attn_output_weights.float()
             attn_output_weights = attn_output_weights.view(bsz, self.num_heads, tgt_len, src_len)
-            attn_output_weights = attn_output_weights.masked_fill(
-                key_padding_mask.unsqueeze(1).unsqueeze(2),
-                float('-inf'),
-            )
+            attn_output_weights = torch._masked_softmax(
+                attn_output_weights, key_padding_mask.unsqueeze(1).unsqueeze(2), -1)
             attn_output_weights = attn_output_weights.view(bsz * self.num_heads, tgt_len, src_len)
-
-        attn_output_weights = F.softmax(
-            attn_output_weights.float(), dim=-1,
-            dtype=torch.float32 if attn_output_weights.dtype == torch.float16 else attn_output_weights.dtype)
+        else:
+            attn_output_weights = F.softmax(
+                attn_output_weights.float(), dim=-1,
+                dtype=torch.float32 if attn_output_weights.dtype == torch.float16 else attn_output_weights.dtype)
         attn_output_weights = F.dropout(attn_output_weights, p=self.dropout, training=self.training)
 
         attn_output = torch.bmm(attn_output_weights, v)
@@ -1,3 +1,5 @@
+import collections
+
 import torch
 from torch.nn.parameter import Parameter
 
@@ -337,3 +339,241 @@ class EmbeddingBag(Module):
             sparse=sparse)
         embeddingbag.weight.requires_grad = not freeze
         return embeddingbag
+
+
+class CachedEmbeddingBag(Module):
+    r"""An :class:`~torch.nn.EmbeddingBag` whose table stays in host memory or
+    in a memory-mapped file, and whose most used rows are cached on the device
+    of the module.
+
+    The table, :attr:`weight`, never leaves its backing storage. Every
+    lookup first brings the rows of the batch that aren't cached into
+    :attr:`cache_weight`, a ``(cache_size, embedding_dim)`` parameter living on
+    the device of the module, evicting the least recently (``policy="lru"``)
+    or least frequently (``policy="lfu"``) used rows, and then reduces the bags
+    over the cache. :attr:`cache_weight` is the only parameter of the module:
+    the optimizer updates the cached rows in place, and the rows updated while
+    training are written back to :attr:`weight` when they are evicted or when
+    :meth:`flush` is called.
+
+    :meth:`prefetch` loads the rows of a future batch ahead of its
+    :meth:`forward`. On CUDA, the rows are copied on a side stream, so the
+    copies overlap with the computation of the current batch. Batches must be
+    prefetched in the order they are then passed to :meth:`forward`. The rows
+    of the prefetched batches and of the last batch passed to :meth:`forward`
+    (whose gradients may not have been applied yet) are never evicted, so
+    :attr:`cache_size` must hold the distinct rows of all of them and of the
+    batch being loaded.
+
+    Args:
+        num_embeddings (int): size of the dictionary of embeddings
+        embedding_dim (int): the size of each embedding vector
+        cache_size (int): the number of rows cached on the device
+        mode (string, optional): ``"sum"``, ``"mean"`` or ``"max"``. See
+                                 :class:`~torch.nn.EmbeddingBag`. Default: ``"mean"``
+        sparse (bool, optional): if ``True``, gradient w.r.t. :attr:`cache_weight` will be a
+                                 sparse tensor. Default: ``False``
+        policy (string, optional): ``"lru"`` or ``"lfu"``, the rows evicted from the cache.
+                                   Default: ``"lru"``
+        filename (string, optional): if given, :attr:`weight` is the memory-mapped
+                                     content of this file (created and zero-filled if it
+                                     doesn't exist), otherwise it is allocated in host
+                                     memory, pinned when the cache is on CUDA, and
+                                     initialized from :math:`\mathcal{N}(0, 1)`.
+        device (torch.device, optional): the device of the cache. Default: the CPU
+
+    Attributes:
+        weight (Tensor): the float table of shape `(num_embeddings, embedding_dim)`.
+                         Rows in the cache may be more recent than their
+                         value in :attr:`weight` until :meth:`flush` is called.
+        cache_weight (Tensor): the learnable cached rows of shape `(cache_size, embedding_dim)`
+
+    The inputs and the output are those of :class:`~torch.nn.EmbeddingBag`.
+    :attr:`input` may be on any device, while :attr:`offsets` and
+    :attr:`per_sample_weights` are moved to the device of the cache.
+
+    :meth:`~torch.nn.Module.state_dict` flushes the cache and saves :attr:`weight`
+    under the ``weight`` key, and loading a state dict replaces :attr:`weight` and
+    empties the cache.
+
+    Examples::
+
+        >>> embedding = nn.CachedEmbeddingBag(10000000, 64, cache_size=100000,
+        ...                                   mode='sum', sparse=True, device='cuda')
+        >>> optimizer = optim.SGD(embedding.parameters(), lr=0.1)
+        >>> batches = iter(loader)
+        >>> input, offsets = next(batches)
+        >>> embedding.prefetch(input)
+        >>> for next_input, next_offsets in batches:
+        ...     embedding.prefetch(next_input)
+        ...     loss = model(embedding(input, offsets)).sum()
+        ...     optimizer.zero_grad()
+        ...     loss.backward()
+        ...     optimizer.step()
+        ...     input, offsets = next_input, next_offsets
+    """
+
+    def __init__(self, num_embeddings, embedding_dim, cache_size, mode='mean',
+                 sparse=False, policy='lru', filename=None, device=None):
+        super(CachedEmbeddingBag, self).__init__()
+        if policy not in ('lru', 'lfu'):
+            raise ValueError("policy must be 'lru' or 'lfu', but got {}".format(policy))
+        self.num_embeddings = num_embeddings
+        self.embedding_dim = embedding_dim
+        self.cache_size = cache_size
+        self.mode = mode
+        self.sparse = sparse
+        self.policy = policy
+        self.filename = filename
+        device = torch.device('cpu' if device is None else device)
+        if filename is None:
+            self.weight = torch.Tensor(num_embeddings, embedding_dim)
+            init.normal_(self.weight)
+            if device.type == 'cuda':
+                self.weight = self.weight.pin_memory()
+        else:
+            storage = torch.FloatStorage.from_file(filename, True, num_embeddings * embedding_dim)
+            self.weight = torch.FloatTensor(storage).view(num_embeddings, embedding_dim)
+        self.cache_weight = Parameter(torch.zeros(cache_size, embedding_dim, device=device))
+        # The slot of every row (-1 if it isn't cached) and the row of every
+        # slot (-1 if it is free). int32 halves the map of huge tables.
+        self._slot_of = torch.full((num_embeddings,), -1, dtype=torch.int)
+        self._row_of_slot = torch.full((cache_size,), -1, dtype=torch.long)
+        # The clock of the last batch that used each slot, which is also the
+        # LRU score, and the number of batches that used it, the LFU score.
+        self._last_used = torch.full((cache_size,), -1, dtype=torch.long)
+        self._use_count = torch.zeros(cache_size, dtype=torch.long)
+        self._dirty = torch.zeros(cache_size, dtype=torch.uint8)
+        self._clock = 0
+        self._last_forward = None
+        self._pending = collections.deque()
+        self._stream = None
+        self._register_state_dict_hook(self._state_dict_hook)
+        self._register_load_state_dict_pre_hook(self._load_state_dict_pre_hook)
+
+    def prefetch(self, input):
+        r"""Starts loading the rows of :attr:`input` that aren't cached, for
+        the next call to :meth:`forward` that wasn't prefetched yet."""
+        self._pending.append(self._load(self._unique_rows(input)[0]))
+
+    def forward(self, input, offsets=None, per_sample_weights=None):
+        rows, inverse = self._unique_rows(input)
+        # The gradients of the last batch have been applied by now, so only
+        # this batch and the prefetched ones must stay cached.
+        self._last_forward = self._clock + 1
+        self._load(rows)
+        if self._pending:
+            self._pending.popleft()
+        slots = self._slot_of[rows].long()
+        if self.training and torch.is_grad_enabled() and self.cache_weight.requires_grad:
+            self._dirty[slots] = 1
+        device = self.cache_weight.device
+        if self._stream is not None:
+            torch.cuda.current_stream(device).wait_stream(self._stream)
+        if offsets is not None:
+            offsets = offsets.to(device)
+        if per_sample_weights is not None:
+            per_sample_weights = per_sample_weights.to(device)
+        return F.embedding_bag(slots[inverse].to(device), self.cache_weight, offsets,
+                               mode=self.mode, sparse=self.sparse,
+                               per_sample_weights=per_sample_weights)
+
+    def flush(self):
+        r"""Writes the cached rows updated since they were loaded back to
+        :attr:`weight`."""
+        dirty = self._dirty.nonzero().view(-1)
+        if dirty.numel() > 0:
+            self._write_back(dirty, self._row_of_slot[dirty])
+
+    def extra_repr(self):
+        s = '{num_embeddings}, {embedding_dim}, cache_size={cache_size}, mode={mode}, policy={policy}'
+        if self.filename is not None:
+            s += ', filename={filename}'
+        return s.format(**self.__dict__)
+
+    def _unique_rows(self, input):
+        rows, inverse = torch.unique(input.cpu().long(), sorted=True, return_inverse=True)
+        if rows.numel() > 0 and (rows[0] < 0 or rows[-1] >= self.num_embeddings):
+            raise RuntimeError("CachedEmbeddingBag: index out of range, the table has {} rows"
+                               .format(self.num_embeddings))
+        return rows, inverse
+
+    def _load(self, rows):
+        self._clock += 1
+        slots = self._slot_of[rows].long()
+        hit = slots >= 0
+        hits = slots[hit]
+        self._last_used[hits] = self._clock
+        self._use_count[hits] += 1
+        missing = rows[~hit]
+        if missing.numel() == 0:
+            return self._clock
+
+        # The rows of the prefetched batches and of the last forward have a
+        # clock at least this one.
+        oldest = self._pending[0] if self._pending else self._clock
+        if self._last_forward is not None:
+            oldest = min(oldest, self._last_forward)
+        evictable = (self._last_used < oldest).nonzero().view(-1)
+        if evictable.numel() < missing.numel():
+            raise RuntimeError("CachedEmbeddingBag: {} rows must be loaded but only {} of the {} "
+                               "cache slots can be evicted, increase cache_size"
+                               .format(missing.numel(), evictable.numel(), self.cache_size))
+        score = self._last_used if self.policy == 'lru' else self._use_count
+        victims = evictable[score[evictable].topk(missing.numel(), largest=False)[1]]
+
+        old_rows = self._row_of_slot[victims]
+        dirty = self._dirty[victims].nonzero().view(-1)
+        dirty_slots, dirty_rows = victims[dirty], old_rows[dirty]
+        self._slot_of[old_rows[old_rows >= 0]] = -1
+        self._slot_of[missing] = victims.int()
+        self._row_of_slot[victims] = missing
+        self._last_used[victims] = self._clock
+        self._use_count[victims] = 1
+
+        values = self.weight.index_select(0, missing)
+        if not self.cache_weight.is_cuda:
+            if dirty.numel() > 0:
+                self._write_back(dirty_slots, dirty_rows)
+            self.cache_weight.data.index_copy_(0, victims, values.to(self.cache_weight.dtype))
+            return self._clock
+
+        device = self.cache_weight.device
+        if self._stream is None or self._stream.device != device:
+            self._stream = torch.cuda.Stream(device)
+        # The victims may have been updated by the optimizer on the current
+        # stream, and nothing of this batch runs on it until forward waits
+        # for the copies. Only the write-back of updated rows waits for the
+        # device, the loads are asynchronous.
+        self._stream.wait_stream(torch.cuda.current_stream(device))
+        with torch.cuda.stream(self._stream):
+            if dirty.numel() > 0:
+                self._write_back(dirty_slots, dirty_rows)
+            values = values.pin_memory().to(device, dtype=self.cache_weight.dtype, non_blocking=True)
+            self.cache_weight.data.index_copy_(0, victims.to(device), values)
+        return self._clock
+
+    def _write_back(self, slots, rows):
+        values = self.cache_weight.data.index_select(0, slots.to(self.cache_weight.device))
+        self.weight.index_copy_(0, rows, values.cpu().to(self.weight.dtype))
+        self._dirty[slots] = 0
+
+    def _state_dict_hook(self, module, state_dict, prefix, local_metadata):
+        self.flush()
+        del state_dict[prefix + 'cache_weight']
+        state_dict[prefix + 'weight'] = self.weight
+
+    def _load_state_dict_pre_hook(self, state_dict, prefix, local_metadata, strict,
+                                  missing_keys, unexpected_keys, error_msgs):
+        weight = state_dict.pop(prefix + 'weight', None)
+        if weight is None:
+            return
+        self.weight.copy_(weight)
+        self._slot_of.fill_(-1)
+        self._row_of_slot.fill_(-1)
+        self._last_used.fill_(-1)
+        self._use_count.zero_()
+        self._dirty.zero_()
+        self._last_forward = None
+        self._pending.clear()
+        state_dict[prefix + 'cache_weight'] = self.cache_weight.data
@@ -208,6 +208,16 @@ class DistributedDataParallel(Module):
                          are getting different gradients, which should not
                          happen if DistributedDataParallel is correctly used.
                          (default: ``False``)
+        gradient_as_bucket_view (bool): when set to ``True``, the ``.grad``
+                         of every parameter shares the memory of the bucket
+                         its gradient is reduced in, so that gradients are
+                         accumulated and all-reduced in place, without
+                         copying them into the buckets and back. This saves
+                         the memory of one copy of the gradients. The
+                         ``.grad`` of the parameters are then defined (as
+                         zeros) from the start, and must be zeroed rather
+                         than replaced between iterations to benefit from
+                         this. (default: ``False``)
 
     Attributes:
         module (Module): the module to be parallelized
@@ -221,7 +231,8 @@ class DistributedDataParallel(Module):
                  output_device=None, dim=0, broadcast_buffers=True,
                  process_group=None, bucket_cap_mb=25,
                  find_unused_parameters=False,
-                 check_reduction=False):
+                 check_reduction=False,
+                 gradient_as_bucket_view=False):
 
         super(DistributedDataParallel, self).__init__()
 
@@ -264,6 +275,7 @@ class DistributedDataParallel(Module):
         self.module = module
         self.broadcast_buffers = broadcast_buffers
         self.find_unused_parameters = find_unused_parameters
+        self.gradient_as_bucket_view = gradient_as_bucket_view
 
         if check_reduction:
             # This argument is no longer used since the reducer
@@ -325,17 +337,22 @@ class DistributedDataParallel(Module):
         # that are defined first, such that their gradients don't spill into
         # a much larger bucket, adding unnecessary latency after gradient
         # computation finishes. Experiments showed 1MB is a reasonable value.
+        bucket_size_limits = [1024 * 1024, self.bucket_bytes_cap]
         bucket_indices = dist._compute_bucket_assignment_by_size(
             param_list[0],
-            [1024 * 1024, self.bucket_bytes_cap])
+            bucket_size_limits)
 
         # Note: reverse list of buckets because we want to approximate the
         # order in which their gradients are produced, and assume they
         # are used in the forward pass in the order they are defined.
+        # The reducer rebuilds the buckets in the order observed in the
+        # first iteration.
         self.reducer = dist.Reducer(
             param_list,
             list(reversed(bucket_indices)),
-            self.process_group)
+            self.process_group,
+            bucket_size_limits,
+            self.gradient_as_bucket_view)
 
         # passing a handle to torch.nn.SyncBatchNorm layer
         self._passing_sync_batchnorm_handle(self._module_copies)
@@ -406,8 +423,98 @@ class DistributedDataParallel(Module):
         for module in self._module_copies[1:]:
             module.train(mode)
 
+    def register_comm_hook(self, hook):
+        r"""Replaces the allreduce of gradient buckets with a communication hook,
+        for example to compress gradients before they are communicated.
+
+        Available hooks are ``torch.distributed.FP16CompressHook``,
+        ``torch.distributed.PowerSGDHook`` and ``torch.distributed.TopKHook``.
+        The last two only support a single device per process and carry the
+        compression error over to the next iteration, so the hook must be
+        registered before the first backward pass and kept for the rest of
+        training.
+
+        Arguments:
+            hook (torch.distributed.CommHook): hook to register
+        """
+        self.reducer.register_comm_hook(hook)
+
+    def register_bucket_completion_hook(self, hook):
+        r"""Registers a function that is called for every gradient bucket as
+        soon as its reduction has completed, while later buckets may still be
+        in flight. It is called as ``hook(bucket_index, params)`` with the
+        parameters of the first model replica in the bucket, whose gradients
+        have been averaged, and can be used to overlap the optimizer step with
+        communication. Parameters of the other replicas are synchronized before
+        the next forward pass.
+
+        Arguments:
+            hook (callable): function to call for every completed bucket
+        """
+        self.reducer.register_bucket_completion_hook(hook)
+
+    def enable_comm_profiling(self, enabled=True):
+        r"""Makes the backward pass wait for the reduction of every gradient
+        bucket to complete on its device, so that :meth:`export_comm_trace`
+        and the ``ddp_wait_reduction`` ranges of the autograd profiler show
+        the actual communication time of CUDA modules. With
+        ``NCCL_ENABLE_TIMING=1`` in the environment, the time the reductions
+        ran for on the devices is also recorded. This synchronizes with the
+        devices once per bucket, so it is only meant for profiling.
+
+        Arguments:
+            enabled (bool): whether to enable comm profiling
+        """
+        self.reducer.set_comm_profiling(enabled)
+
+    def export_comm_trace(self, path):
+        r"""Exports the timeline of the gradient buckets in the last backward
+        pass as a Chrome tracing tools file, which can be loaded under the
+        ``chrome://tracing`` URL, like the trace of the autograd profiler.
+        Times are relative to the start of the backward pass.
+
+        Every bucket shows when its gradients were being computed, when it
+        was ready but queued behind the buckets before it, and when it was
+        being reduced. The communication time that didn't overlap with the
+        backward pass is saved as ``exposed_comm_time_us``.
+
+        Arguments:
+            path (str): Path where the trace will be written.
+        """
+        import json
+        first_grad_ready, ready, launch, complete, device_duration = range(5)
+        chrome_events = []
+
+        def add_event(name, bucket_index, start, end):
+            if start < 0 or end < start:
+                return
+            chrome_events.append(dict(
+                name=name,
+                ph='X',
+                ts=start / 1000.0,
+                dur=(end - start) / 1000.0,
+                tid='bucket {}'.format(bucket_index),
+                pid='DDP buckets',
+                args={},
+            ))
+
+        for i, stats in enumerate(self.reducer.get_bucket_stats()):
+            add_event('gradients', i, stats[first_grad_ready], stats[ready])
+            add_event('queued', i, stats[ready], stats[launch])
+            add_event('reduction', i, stats[launch], stats[complete])
+            if stats[device_duration] >= 0:
+                add_event('device reduction', i,
+                          stats[complete] - stats[device_duration],
+                          stats[complete])
+        with open(path, 'w') as f:
+            json.dump(dict(
+                traceEvents=chrome_events,
+                otherData=dict(exposed_comm_time_us=(
+                    self.reducer.get_exposed_comm_time() / 1000.0)),
+            ), f)
+
     def _dist_broadcast_coalesced(self, tensors, buffer_size):
-        dist._dist_broadcast_coalesced(self.process_group, tensors, buffer_size, False)
+        dist._broadcast_coalesced(self.process_group, tensors, buffer_size).wait()
 
     def _sync_params(self):
         with torch.no_grad():
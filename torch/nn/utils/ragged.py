@@ -0,0 +1,271 @@
+from collections import OrderedDict, namedtuple
+
+import torch
+from .. import functional as F
+from .rnn import invert_permutation, pack_sequence, pad_packed_sequence, pad_sequence
+
+
+RaggedBatch_ = namedtuple('RaggedBatch', ['values', 'offsets'])
+
+
+class RaggedBatch(RaggedBatch_):
+    r"""Holds a batch of sequences of different lengths, concatenated without
+    padding.
+
+    Ops that treat each step of a sequence independently, like elementwise
+    ops, :func:`~torch.nn.functional.linear` or
+    :func:`~torch.nn.functional.layer_norm`, run on :attr:`values` directly
+    through :meth:`apply` or the arithmetic operators. Ops that mix the steps
+    of a sequence, like :func:`ragged_softmax` or :func:`ragged_attention`,
+    run through :func:`ragged_apply`, which batches the sequences of equal
+    lengths together, so that no time is spent on padding.
+
+    Instances are usually created by :func:`ragged_batch`,
+    :func:`ragged_from_padded` or :func:`ragged_from_packed`.
+
+    Attributes:
+        values (Tensor): the concatenated sequences, of shape ``(N, *)`` where
+            ``N`` is the sum of their lengths
+        offsets (Tensor): the bounds of the sequences in :attr:`values`, of
+            shape ``(B + 1,)``: sequence ``i`` is
+            ``values[offsets[i]:offsets[i + 1]]``
+
+    .. note::
+        :attr:`values` can be on arbitrary device and of arbitrary dtype, but
+        :attr:`offsets` is always a CPU ``torch.int64`` tensor, like the
+        :attr:`batch_sizes` of a :class:`~torch.nn.utils.rnn.PackedSequence`.
+    """
+
+    def lengths(self):
+        r"""Returns the lengths of the sequences."""
+        return self.offsets[1:] - self.offsets[:-1]
+
+    def unbind(self):
+        r"""Returns the list of the sequences."""
+        return list(self.values.split(self.lengths().tolist()))
+
+    def apply(self, fn, *args, **kwargs):
+        r"""Returns the batch of ``fn(values, *args, **kwargs)``, for
+        functions that treat each step of the sequences independently.
+
+        Example::
+
+            >>> hidden = batch.apply(linear).apply(F.relu)
+        """
+        return type(self)(fn(self.values, *args, **kwargs), self.offsets)
+
+    def to(self, *args, **kwargs):
+        r"""Returns the batch with :attr:`values` converted by
+        :meth:`torch.Tensor.to`."""
+        return self.apply(torch.Tensor.to, *args, **kwargs)
+
+    def cuda(self, *args, **kwargs):
+        return self.apply(torch.Tensor.cuda, *args, **kwargs)
+
+    def cpu(self):
+        return self.apply(torch.Tensor.cpu)
+
+    def _other_values(self, other):
+        if isinstance(other, RaggedBatch):
+            if other.offsets is not self.offsets and not torch.equal(other.offsets, self.offsets):
+                raise ValueError('the sequences of ragged batches must have the same lengths')
+            return other.values
+        return other
+
+    def __add__(self, other):
+        return self.apply(torch.add, self._other_values(other))
+
+    def __sub__(self, other):
+        return self.apply(torch.sub, self._other_values(other))
+
+    def __mul__(self, other):
+        return self.apply(torch.mul, self._other_values(other))
+
+    def __truediv__(self, other):
+        return self.apply(torch.div, self._other_values(other))
+
+    __div__ = __truediv__
+
+    def __radd__(self, other):
+        return self + other
+
+    def __rmul__(self, other):
+        return self * other
+
+    def __neg__(self):
+        return self.apply(torch.neg)
+
+
+def ragged_batch(sequences):
+    r"""Concatenates a list of sequences of different lengths into a
+    :class:`RaggedBatch`.
+
+    Arguments:
+        sequences (list[Tensor]): the sequences, of shapes ``L_i x *`` with
+            the same trailing dimensions
+
+    Example::
+
+        >>> batch = ragged_batch([torch.randn(3, 8), torch.randn(5, 8)])
+        >>> batch.values.size()
+        torch.Size([8, 8])
+        >>> batch.offsets
+        tensor([0, 3, 8])
+    """
+    lengths = torch.tensor([sequence.size(0) for sequence in sequences], dtype=torch.long)
+    offsets = torch.cat([lengths.new_zeros(1), lengths.cumsum(0)])
+    return RaggedBatch(torch.cat(sequences), offsets)
+
+
+def ragged_from_padded(padded, lengths, batch_first=False):
+    r"""Creates a :class:`RaggedBatch` from padded sequences.
+
+    Arguments:
+        padded (Tensor): the sequences, of shape ``T x B x *``, or
+            ``B x T x *`` if :attr:`batch_first` is ``True``
+        lengths (Tensor or list[int]): the lengths of the sequences
+        batch_first (bool, optional): see :attr:`padded`
+    """
+    if not batch_first:
+        padded = padded.transpose(0, 1)
+    if isinstance(lengths, torch.Tensor):
+        lengths = lengths.tolist()
+    return ragged_batch([padded[i, :length] for i, length in enumerate(lengths)])
+
+
+def pad_ragged(batch, batch_first=False, padding_value=0):
+    r"""Pads the sequences of a :class:`RaggedBatch`.
+
+    Returns:
+        Tuple of the padded sequences, of shape ``T x B x *`` (or
+        ``B x T x *`` if :attr:`batch_first` is ``True``) where ``T`` is the
+        length of the longest sequence, and of the lengths of the sequences.
+    """
+    return (pad_sequence(batch.unbind(), batch_first, padding_value), batch.lengths())
+
+
+def pack_ragged(batch):
+    r"""Packs the sequences of a :class:`RaggedBatch` into a
+    :class:`~torch.nn.utils.rnn.PackedSequence` for the RNN modules. The
+    sequences must not be empty."""
+    return pack_sequence(batch.unbind(), enforce_sorted=False)
+
+
+def ragged_from_packed(sequence):
+    r"""Creates a :class:`RaggedBatch` from a
+    :class:`~torch.nn.utils.rnn.PackedSequence`, e.g. the output of an RNN
+    module, keeping the original order of the sequences."""
+    padded, lengths = pad_packed_sequence(sequence)
+    return ragged_from_padded(padded, lengths)
+
+
+def ragged_apply(fn, *batches):
+    r"""Applies a function mixing the steps of sequences to ragged batches.
+
+    The sequences of the batches are grouped by their lengths: ``fn`` is
+    called once per group, with one tensor of shape ``G x L_j x *`` per batch
+    holding the ``G`` sequences of the group, whose lengths are ``L_j`` in
+    batch ``j``. ``fn`` returns the ``G x L_0 x *`` results of the group,
+    which form a batch with the offsets of the first batch. There are as many
+    calls as there are distinct lengths, and no padding.
+
+    Arguments:
+        fn (callable): the function
+        batches (RaggedBatch): batches of the same number of sequences
+
+    Example::
+
+        >>> # the mean of every sequence, for each of its steps
+        >>> means = ragged_apply(lambda x: x.mean(1, keepdim=True).expand_as(x), batch)
+    """
+    first = batches[0]
+    if first.offsets.numel() == 1:
+        # no sequence, fn still gives the shape of the results
+        out = fn(*[batch.values[:0].unsqueeze(0) for batch in batches])
+        return RaggedBatch(out.reshape((0,) + out.shape[2:]), first.offsets)
+    if any(batch.offsets.numel() != first.offsets.numel() for batch in batches):
+        raise ValueError('ragged batches must have the same number of sequences')
+
+    lengths = [batch.lengths().tolist() for batch in batches]
+    groups = OrderedDict()
+    for i, key in enumerate(zip(*lengths)):
+        groups.setdefault(key, []).append(i)
+
+    outputs = []
+    indices = []
+    for key, sequences in groups.items():
+        sequences = torch.tensor(sequences, dtype=torch.long)
+        inputs = []
+        for j, (batch, length) in enumerate(zip(batches, key)):
+            index = batch.offsets[sequences].unsqueeze(1) + torch.arange(length, dtype=torch.long)
+            index = index.view(-1).to(batch.values.device)
+            values = batch.values.index_select(0, index)
+            inputs.append(values.view((len(sequences), length) + values.shape[1:]))
+            if j == 0:
+                indices.append(index)
+        out = fn(*inputs)
+        if out.shape[:2] != (len(sequences), key[0]):
+            raise ValueError('ragged_apply: fn must return a tensor of shape {} x {} x *, but got {}'
+                             .format(len(sequences), key[0], tuple(out.shape)))
+        outputs.append(out.reshape((-1,) + out.shape[2:]))
+    # the results of the groups back in the order of the sequences
+    order = invert_permutation(torch.cat(indices))
+    return RaggedBatch(torch.cat(outputs).index_select(0, order), first.offsets)
+
+
+def ragged_softmax(batch, dim=0):
+    r"""Applies softmax over the steps of each sequence if :attr:`dim` is
+    0, or over dimension :attr:`dim` of :attr:`values` otherwise."""
+    if dim == 0:
+        return ragged_apply(lambda x: F.softmax(x, dim=1), batch)
+    return batch.apply(F.softmax, dim)
+
+
+def ragged_attention(query, key, value, num_heads=1, causal=False, dropout_p=0., training=True):
+    r"""Computes the scaled dot product attention of every sequence of
+    :attr:`query` over the corresponding sequences of :attr:`key` and
+    :attr:`value`, without padding.
+
+    Arguments:
+        query (RaggedBatch): the queries, with :attr:`values` of shape ``N x E``
+        key (RaggedBatch): the keys, with :attr:`values` of shape ``S x E``
+        value (RaggedBatch): the values, with :attr:`values` of shape
+            ``S x E_v`` and the offsets of :attr:`key`
+        num_heads (int, optional): the number of heads, between which the
+            embeddings are split. Default: 1
+        causal (bool, optional): if ``True``, step ``i`` of a query only
+            attends to the steps ``j <= i`` of its key. Default: ``False``
+        dropout_p (float, optional): the dropout probability of the attention
+            weights. Default: 0
+        training (bool, optional): apply dropout if is ``True``. Default: ``True``
+
+    Returns:
+        A :class:`RaggedBatch` with the offsets of :attr:`query` and
+        :attr:`values` of shape ``N x E_v``.
+
+    Example::
+
+        >>> q, k, v = (batch.apply(proj) for proj in (q_proj, k_proj, v_proj))
+        >>> out = ragged_attention(q, k, v, num_heads=8)
+    """
+    embed_dim = query.values.size(1)
+    if embed_dim % num_heads != 0 or value.values.size(1) % num_heads != 0:
+        raise ValueError('the embedding dimensions must be divisible by num_heads')
+    scaling = float(embed_dim // num_heads) ** -0.5
+
+    def attend(q, k, v):
+        # (G, L, E) -> (G, heads, L, E / heads)
+        groups, query_length = q.shape[:2]
+        key_length = k.size(1)
+        q = q.view(groups, query_length, num_heads, -1).transpose(1, 2)
+        k = k.view(groups, key_length, num_heads, -1).transpose(1, 2)
+        v = v.view(groups, key_length, num_heads, -1).transpose(1, 2)
+        weights = torch.matmul(q * scaling, k.transpose(2, 3))
+        if causal:
+            mask = torch.ones(query_length, key_length, dtype=torch.uint8, device=q.device).triu_(1)
+            weights = weights.masked_fill(mask, float('-inf'))
+        weights = F.dropout(F.softmax(weights, dim=-1), p=dropout_p, training=training)
+        out = torch.matmul(weights, v)
+        return out.transpose(1, 2).reshape(groups, query_length, -1)
+
+    return ragged_apply(attend, query, key, value)
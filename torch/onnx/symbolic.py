@@ -1658,7 +1658,8 @@ def detach(g, input):
     return input
 
 
-def contiguous(g, input):
+def contiguous(g, input, memory_format):
+    # NOTE: ONNX has no notion of memory layout, so memory_format is ignored
     return input
 
 